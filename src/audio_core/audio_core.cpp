@@ -14,12 +14,15 @@
 #include "common/common_types.h"
 #include "core/core_timing.h"
 #include "core/hle/service/dsp_dsp.h"
+#include "core/settings.h"
 
 namespace AudioCore {
 
 // Audio Ticks occur about every 5 miliseconds.
 static int tick_event;                               ///< CoreTiming event
+static int begin_tick_event;                         ///< CoreTiming event
 static constexpr u64 audio_frame_ticks = 1310252ull; ///< Units: ARM11 cycles
+static bool use_audio_thread;
 
 static void AudioTickCallback(u64 /*userdata*/, int cycles_late) {
     if (DSP::HLE::Tick()) {
@@ -31,12 +34,26 @@ static void AudioTickCallback(u64 /*userdata*/, int cycles_late) {
 
     // Reschedule recurrent event
     CoreTiming::ScheduleEvent(audio_frame_ticks - cycles_late, tick_event);
+    if (use_audio_thread) {
+        // Hand the next frame to the audio thread halfway through, once the application has had
+        // time to write its configuration
+        CoreTiming::ScheduleEvent(audio_frame_ticks / 2 - cycles_late, begin_tick_event);
+    }
+}
+
+static void AudioBeginTickCallback(u64 /*userdata*/, int /*cycles_late*/) {
+    DSP::HLE::BeginTick();
 }
 
 void Init() {
     DSP::HLE::Init();
 
+    use_audio_thread = Settings::values.use_audio_thread;
+    DSP::HLE::EnableAudioThread(use_audio_thread);
+
     tick_event = CoreTiming::RegisterEvent("AudioCore::tick_event", AudioTickCallback);
+    begin_tick_event =
+        CoreTiming::RegisterEvent("AudioCore::begin_tick_event", AudioBeginTickCallback);
     CoreTiming::ScheduleEvent(audio_frame_ticks, tick_event);
 }
 
@@ -53,8 +70,21 @@ void EnableStretching(bool enable) {
     DSP::HLE::EnableStretching(enable);
 }
 
+void SetOutputLatency(unsigned int milliseconds) {
+    DSP::HLE::SetOutputLatency(milliseconds);
+}
+
+void EnableTurbo(bool enable) {
+    DSP::HLE::EnableTurbo(enable);
+}
+
+bool IsOutputRealTime() {
+    return DSP::HLE::IsSinkRealTime();
+}
+
 void Shutdown() {
     CoreTiming::UnscheduleEvent(tick_event, 0);
+    CoreTiming::UnscheduleEvent(begin_tick_event, 0);
     DSP::HLE::Shutdown();
 }
 
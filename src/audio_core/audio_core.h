@@ -25,6 +25,15 @@ void SelectSink(std::string sink_id);
 /// Enable/Disable stretching.
 void EnableStretching(bool enable);
 
+/// Set the target output latency in milliseconds.
+void SetOutputLatency(unsigned int milliseconds);
+
+/// Enable/Disable turbo mode, in which audio that comes in faster than it plays back is dropped.
+void EnableTurbo(bool enable);
+
+/// Whether the selected sink plays audio back in real time, rather than e.g. writing it to a file.
+bool IsOutputRealTime();
+
 /// Shutdown Audio Core
 void Shutdown();
 
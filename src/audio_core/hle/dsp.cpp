@@ -2,14 +2,20 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstring>
 #include <memory>
+#include <thread>
 #include "audio_core/hle/dsp.h"
 #include "audio_core/hle/mixers.h"
 #include "audio_core/hle/pipe.h"
 #include "audio_core/hle/source.h"
 #include "audio_core/sink.h"
 #include "audio_core/time_stretch.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
 
 namespace DSP {
 namespace HLE {
@@ -54,10 +60,7 @@ static std::array<Source, num_sources> sources = {
 };
 static Mixers mixers;
 
-static StereoFrame16 GenerateCurrentFrame() {
-    SharedMemory& read = ReadRegion();
-    SharedMemory& write = WriteRegion();
-
+static StereoFrame16 GenerateCurrentFrame(SharedMemory& read, SharedMemory& write) {
     std::array<QuadFrame32, 3> intermediate_mixes = {};
 
     // Generate intermediate mixes
@@ -88,9 +91,22 @@ static StereoFrame16 GenerateCurrentFrame() {
 // Audio output
 
 static bool perform_time_stretching = true;
+static bool turbo_enabled = false;
+static unsigned int output_latency_ms = 50;
 static std::unique_ptr<AudioCore::Sink> sink;
+/// Cached sink->IsRealTime(), as the frame limiter queries it from the emulation thread
+static std::atomic<bool> sink_is_real_time{true};
 static AudioCore::TimeStretcher time_stretcher;
 
+/// Number of samples to keep queued in the sink for the target output latency
+static size_t TargetSampleDelay() {
+    const size_t latency = output_latency_ms * sink->GetNativeSampleRate() / 1000;
+    const size_t device_latency = sink->GetDeviceLatency();
+    // The device holds samples of its own, but it also takes that many from the queue at once
+    const size_t minimum_delay = std::max<size_t>(device_latency, 1);
+    return latency > device_latency + minimum_delay ? latency - device_latency : minimum_delay;
+}
+
 static void FlushResidualStretcherAudio() {
     time_stretcher.Flush();
     while (true) {
@@ -102,13 +118,15 @@ static void FlushResidualStretcherAudio() {
 }
 
 static void OutputCurrentFrame(const StereoFrame16& frame) {
-    if (perform_time_stretching) {
+    if (!sink_is_real_time) {
+        // Nothing is played back, so there's no queue to keep at the target latency
+        sink->EnqueueSamples(&frame[0][0], frame.size());
+    } else if (perform_time_stretching && !turbo_enabled) {
         time_stretcher.AddSamples(&frame[0][0], frame.size());
         std::vector<s16> stretched_samples = time_stretcher.Process(sink->SamplesInQueue());
         sink->EnqueueSamples(stretched_samples.data(), stretched_samples.size() / 2);
     } else {
-        constexpr size_t maximum_sample_latency = 2048; // about 64 miliseconds
-        if (sink->SamplesInQueue() > maximum_sample_latency) {
+        if (sink->SamplesInQueue() > TargetSampleDelay()) {
             // This can occur if we're running too fast and samples are starting to back up.
             // Just drop the samples.
             return;
@@ -118,19 +136,112 @@ static void OutputCurrentFrame(const StereoFrame16& frame) {
     }
 }
 
+// Audio thread
+
+/// Copies of the shared memory regions that the audio thread generates a frame from and into
+static SharedMemory thread_read_region;
+static SharedMemory thread_write_region;
+/// Index of the region thread_read_region was copied from
+static size_t thread_read_region_index;
+/// Dirty flags in thread_read_region before the frame consumed them
+static std::array<u32, num_sources> thread_source_dirty;
+static std::array<u16, num_sources> thread_buffers_dirty;
+static u32 thread_dsp_dirty;
+
+static std::thread audio_thread;
+static Common::Event frame_requested;
+static Common::Event frame_done;
+static bool stop_audio_thread = false;
+/// Whether the audio thread has a frame that has not been published yet
+static bool frame_in_flight = false;
+
+static void AudioThreadLoop() {
+    MicroProfileOnThreadCreate("AudioThread");
+
+    while (true) {
+        frame_requested.Wait();
+        if (stop_audio_thread)
+            break;
+
+        OutputCurrentFrame(GenerateCurrentFrame(thread_read_region, thread_write_region));
+        frame_done.Set();
+    }
+}
+
+/// Waits for the frame of the audio thread and writes its results to the shared memory regions
+static void PublishThreadFrame() {
+    frame_done.Wait();
+    frame_in_flight = false;
+
+    SharedMemory& read = thread_read_region_index == 0 ? g_dsp_memory.region_0
+                                                       : g_dsp_memory.region_1;
+    SharedMemory& write = thread_read_region_index != 0 ? g_dsp_memory.region_0
+                                                        : g_dsp_memory.region_1;
+
+    std::memcpy(&write.dsp_status, &thread_write_region.dsp_status, sizeof(write.dsp_status));
+    std::memcpy(&write.final_samples, &thread_write_region.final_samples,
+                sizeof(write.final_samples));
+    std::memcpy(&write.source_statuses, &thread_write_region.source_statuses,
+                sizeof(write.source_statuses));
+    std::memcpy(&write.intermediate_mix_samples, &thread_write_region.intermediate_mix_samples,
+                sizeof(write.intermediate_mix_samples));
+
+    // Only clear the dirty flags the frame consumed, in case the application has set more since
+    for (size_t i = 0; i < num_sources; i++) {
+        auto& config = read.source_configurations.config[i];
+        const auto& processed = thread_read_region.source_configurations.config[i];
+        config.dirty_raw = config.dirty_raw & ~(thread_source_dirty[i] & ~processed.dirty_raw);
+        config.buffers_dirty =
+            config.buffers_dirty & ~(thread_buffers_dirty[i] & ~processed.buffers_dirty);
+    }
+    read.dsp_configuration.dirty_raw =
+        read.dsp_configuration.dirty_raw &
+        ~(thread_dsp_dirty & ~thread_read_region.dsp_configuration.dirty_raw);
+}
+
+/// Makes sure the audio thread isn't using any state, before the emulation thread changes it
+static void SynchronizeAudioThread() {
+    if (frame_in_flight) {
+        PublishThreadFrame();
+    }
+}
+
 void EnableStretching(bool enable) {
     if (perform_time_stretching == enable)
         return;
 
+    SynchronizeAudioThread();
+
     if (!enable) {
         FlushResidualStretcherAudio();
     }
     perform_time_stretching = enable;
 }
 
+void EnableTurbo(bool enable) {
+    if (turbo_enabled == enable)
+        return;
+
+    SynchronizeAudioThread();
+
+    if (enable && perform_time_stretching) {
+        FlushResidualStretcherAudio();
+    }
+    turbo_enabled = enable;
+}
+
+void SetOutputLatency(unsigned int milliseconds) {
+    SynchronizeAudioThread();
+    output_latency_ms = milliseconds;
+    if (sink) {
+        time_stretcher.SetTargetDelay(TargetSampleDelay());
+    }
+}
+
 // Public Interface
 
 void Init() {
+    SynchronizeAudioThread();
     DSP::HLE::ResetPipes();
 
     for (auto& source : sources) {
@@ -142,30 +253,75 @@ void Init() {
     time_stretcher.Reset();
     if (sink) {
         time_stretcher.SetOutputSampleRate(sink->GetNativeSampleRate());
+        time_stretcher.SetTargetDelay(TargetSampleDelay());
     }
 }
 
 void Shutdown() {
-    if (perform_time_stretching) {
+    EnableAudioThread(false);
+    if (perform_time_stretching && !turbo_enabled) {
         FlushResidualStretcherAudio();
     }
 }
 
 bool Tick() {
-    StereoFrame16 current_frame = {};
+    if (frame_in_flight) {
+        PublishThreadFrame();
+        return true;
+    }
 
     // TODO: Check dsp::DSP semaphore (which indicates emulated application has finished writing to
     // shared memory region)
-    current_frame = GenerateCurrentFrame();
+    const StereoFrame16 current_frame = GenerateCurrentFrame(ReadRegion(), WriteRegion());
 
     OutputCurrentFrame(current_frame);
 
     return true;
 }
 
+void BeginTick() {
+    if (!audio_thread.joinable() || frame_in_flight)
+        return;
+
+    thread_read_region_index = CurrentRegionIndex();
+    std::memcpy(&thread_read_region, &ReadRegion(), sizeof(SharedMemory));
+    std::memcpy(&thread_write_region, &WriteRegion(), sizeof(SharedMemory));
+
+    for (size_t i = 0; i < num_sources; i++) {
+        thread_source_dirty[i] = thread_read_region.source_configurations.config[i].dirty_raw;
+        thread_buffers_dirty[i] = thread_read_region.source_configurations.config[i].buffers_dirty;
+    }
+    thread_dsp_dirty = thread_read_region.dsp_configuration.dirty_raw;
+
+    frame_in_flight = true;
+    frame_requested.Set();
+}
+
+void EnableAudioThread(bool enable) {
+    if (audio_thread.joinable() == enable)
+        return;
+
+    if (enable) {
+        stop_audio_thread = false;
+        audio_thread = std::thread(AudioThreadLoop);
+    } else {
+        SynchronizeAudioThread();
+        stop_audio_thread = true;
+        frame_requested.Set();
+        audio_thread.join();
+    }
+}
+
+bool IsSinkRealTime() {
+    return sink_is_real_time;
+}
+
 void SetSink(std::unique_ptr<AudioCore::Sink> sink_) {
+    SynchronizeAudioThread();
     sink = std::move(sink_);
+    sink_is_real_time = sink->IsRealTime();
     time_stretcher.SetOutputSampleRate(sink->GetNativeSampleRate());
+    time_stretcher.SetTargetDelay(TargetSampleDelay());
 }
 
 } // namespace HLE
@@ -577,6 +577,24 @@ void Shutdown();
  */
 bool Tick();
 
+/**
+ * Starts generating the current frame on the audio thread, from a copy of the shared memory
+ * regions taken now. The next Tick() waits for the frame and writes its results back to the
+ * shared memory. Does nothing unless the audio thread is enabled.
+ * This is called halfway between two ticks, once the application has written its configuration.
+ */
+void BeginTick();
+
+/**
+ * Enables/Disables the audio thread, which takes source decoding, mixing and audio output off the
+ * emulation thread.
+ * @param enable true to enable, false to disable.
+ */
+void EnableAudioThread(bool enable);
+
+/// Whether the current sink plays audio back in real time, see AudioCore::Sink::IsRealTime.
+bool IsSinkRealTime();
+
 /**
  * Set the output sink. This must be called before calling Tick().
  * @param sink The sink to which audio will be output to.
@@ -591,5 +609,19 @@ void SetSink(std::unique_ptr<AudioCore::Sink> sink);
  */
 void EnableStretching(bool enable);
 
+/**
+ * Sets the target output latency. Audio stretching adjusts the audio speed to keep the samples
+ * queued in the sink at this latency; without it, samples beyond it are dropped.
+ * @param milliseconds The latency, including the buffers of the output device.
+ */
+void SetOutputLatency(unsigned int milliseconds);
+
+/**
+ * Enables/Disables turbo mode. Emulation then runs faster than the audio plays back, so instead
+ * of stretching the audio beyond recognition, samples beyond the output latency are dropped.
+ * @param enable true to enable, false to disable.
+ */
+void EnableTurbo(bool enable);
+
 } // namespace HLE
 } // namespace DSP
@@ -39,12 +39,21 @@ void SourceFilters::ProcessFrame(StereoFrame16& frame) {
     if (!simple_filter_enabled && !biquad_filter_enabled)
         return;
 
+    // Games often enable the filters while leaving them configured as passthrough
     if (simple_filter_enabled) {
-        FilterFrame(frame, simple_filter);
+        if (simple_filter.IsPassthrough()) {
+            simple_filter.PassFrame(frame);
+        } else {
+            FilterFrame(frame, simple_filter);
+        }
     }
 
     if (biquad_filter_enabled) {
-        FilterFrame(frame, biquad_filter);
+        if (biquad_filter.IsPassthrough()) {
+            biquad_filter.PassFrame(frame);
+        } else {
+            FilterFrame(frame, biquad_filter);
+        }
     }
 }
 
@@ -76,6 +85,10 @@ std::array<s16, 2> SourceFilters::SimpleFilter::ProcessSample(const std::array<s
     return y0;
 }
 
+void SourceFilters::SimpleFilter::PassFrame(const StereoFrame16& frame) {
+    y1 = frame.back();
+}
+
 // BiquadFilter
 
 void SourceFilters::BiquadFilter::Reset() {
@@ -113,5 +126,11 @@ std::array<s16, 2> SourceFilters::BiquadFilter::ProcessSample(const std::array<s
     return y0;
 }
 
+void SourceFilters::BiquadFilter::PassFrame(const StereoFrame16& frame) {
+    static_assert(samples_per_frame >= 2, "The history spans two samples");
+    x1 = y1 = frame[samples_per_frame - 1];
+    x2 = y2 = frame[samples_per_frame - 2];
+}
+
 } // namespace HLE
 } // namespace DSP
@@ -74,6 +74,18 @@ private:
          */
         std::array<s16, 2> ProcessSample(const std::array<s16, 2>& x0);
 
+        /// Whether the filter outputs its input unchanged, as it is configured after a reset.
+        bool IsPassthrough() const {
+            return a1 == 0 && b0 == 1 << 15;
+        }
+
+        /**
+         * Updates the internal state as processing a frame does, without touching the samples.
+         * Only valid while IsPassthrough() is true.
+         * @param frame The frame that passes through
+         */
+        void PassFrame(const StereoFrame16& frame);
+
     private:
         // Configuration
         s32 a1, b0;
@@ -102,6 +114,18 @@ private:
          */
         std::array<s16, 2> ProcessSample(const std::array<s16, 2>& x0);
 
+        /// Whether the filter outputs its input unchanged, as it is configured after a reset.
+        bool IsPassthrough() const {
+            return a1 == 0 && a2 == 0 && b0 == 1 << 14 && b1 == 0 && b2 == 0;
+        }
+
+        /**
+         * Updates the internal state as processing a frame does, without touching the samples.
+         * Only valid while IsPassthrough() is true.
+         * @param frame The frame that passes through
+         */
+        void PassFrame(const StereoFrame16& frame);
+
     private:
         // Configuration
         s32 a1, a2, b0, b1, b2;
@@ -11,6 +11,10 @@
 #include "common/logging/log.h"
 #include "common/math_util.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace DSP {
 namespace HLE {
 
@@ -121,6 +125,28 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
     // fallthrough
 
     case OutputFormat::Stereo:
+#ifdef ARCHITECTURE_x86_64
+    {
+        static_assert(samples_per_frame % 4 == 0, "Four samples are mixed per iteration");
+        const __m128 gain_vector = _mm_set1_ps(gain);
+        for (size_t samplei = 0; samplei < samples_per_frame; samplei += 4) {
+            // Downmix to stereo: [s0 s1 s2 s3] * gain becomes [s0 + s2, s1 + s3]
+            __m128 stereo[4];
+            for (size_t i = 0; i < 4; i++) {
+                const __m128i* in = reinterpret_cast<const __m128i*>(samples[samplei + i].data());
+                const __m128 quad = _mm_mul_ps(gain_vector, _mm_cvtepi32_ps(_mm_loadu_si128(in)));
+                stereo[i] = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+            }
+            // Pack to s16 with saturation and mix into current frame, also saturating
+            const __m128i downmixed =
+                _mm_packs_epi32(_mm_cvttps_epi32(_mm_movelh_ps(stereo[0], stereo[1])),
+                                _mm_cvttps_epi32(_mm_movelh_ps(stereo[2], stereo[3])));
+            __m128i* out = reinterpret_cast<__m128i*>(current_frame[samplei].data());
+            _mm_storeu_si128(out, _mm_adds_epi16(_mm_loadu_si128(out), downmixed));
+        }
+        return;
+    }
+#else
         std::transform(
             current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
             [gain](const std::array<s16, 2>& accumulator,
@@ -132,6 +158,7 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
                 return AddAndClampToS16(accumulator, {left, right});
             });
         return;
+#endif
     }
 
     UNREACHABLE_MSG("Invalid output_format %zu", static_cast<size_t>(state.output_format));
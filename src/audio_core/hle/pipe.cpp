@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <cstring>
 #include <vector>
 #include "audio_core/hle/dsp.h"
 #include "audio_core/hle/pipe.h"
@@ -25,17 +26,17 @@ void ResetPipes() {
     dsp_state = DspState::Off;
 }
 
-std::vector<u8> PipeRead(DspPipe pipe_number, u32 length) {
+size_t PipeRead(DspPipe pipe_number, u8* dest, size_t length) {
     const size_t pipe_index = static_cast<size_t>(pipe_number);
 
     if (pipe_index >= NUM_DSP_PIPE) {
         LOG_ERROR(Audio_DSP, "pipe_number = %zu invalid", pipe_index);
-        return {};
+        return 0;
     }
 
     if (length > UINT16_MAX) { // Can only read at most UINT16_MAX from the pipe
-        LOG_ERROR(Audio_DSP, "length of %u greater than max of %u", length, UINT16_MAX);
-        return {};
+        LOG_ERROR(Audio_DSP, "length of %zu greater than max of %u", length, UINT16_MAX);
+        return 0;
     }
 
     std::vector<u8>& data = pipe_data[pipe_index];
@@ -43,17 +44,17 @@ std::vector<u8> PipeRead(DspPipe pipe_number, u32 length) {
     if (length > data.size()) {
         LOG_WARNING(
             Audio_DSP,
-            "pipe_number = %zu is out of data, application requested read of %u but %zu remain",
+            "pipe_number = %zu is out of data, application requested read of %zu but %zu remain",
             pipe_index, length, data.size());
-        length = static_cast<u32>(data.size());
+        length = data.size();
     }
 
     if (length == 0)
-        return {};
+        return 0;
 
-    std::vector<u8> ret(data.begin(), data.begin() + length);
+    std::memcpy(dest, data.data(), length);
     data.erase(data.begin(), data.begin() + length);
-    return ret;
+    return length;
 }
 
 size_t GetPipeReadableSize(DspPipe pipe_number) {
@@ -107,12 +108,12 @@ static void AudioPipeWriteStructAddresses() {
     Service::DSP_DSP::SignalPipeInterrupt(DspPipe::Audio);
 }
 
-void PipeWrite(DspPipe pipe_number, const std::vector<u8>& buffer) {
+void PipeWrite(DspPipe pipe_number, const u8* buffer, size_t length) {
     switch (pipe_number) {
     case DspPipe::Audio: {
-        if (buffer.size() != 4) {
+        if (length != 4) {
             LOG_ERROR(Audio_DSP, "DspPipe::Audio: Unexpected buffer length %zu was written",
-                      buffer.size());
+                      length);
             return;
         }
 
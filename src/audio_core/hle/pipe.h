@@ -5,7 +5,6 @@
 #pragma once
 
 #include <cstddef>
-#include <vector>
 #include "common/common_types.h"
 
 namespace DSP {
@@ -23,18 +22,18 @@ enum class DspPipe {
 constexpr size_t NUM_DSP_PIPE = 8;
 
 /**
- * Reads `length` bytes from the DSP pipe identified with `pipe_number`.
+ * Reads `length` bytes from the DSP pipe identified with `pipe_number` into `dest`.
  * @note Can read up to the maximum value of a u16 in bytes (65,535).
- * @note IF an error is encoutered with either an invalid `pipe_number` or `length` value, an empty
- * vector will be returned.
- * @note IF `length` is set to 0, an empty vector will be returned.
+ * @note IF an error is encoutered with either an invalid `pipe_number` or `length` value, nothing
+ * will be read.
  * @note IF `length` is greater than the amount of data available, this function will only read the
  * available amount.
  * @param pipe_number a `DspPipe`
+ * @param dest the buffer to read into, of at least `length` bytes.
  * @param length the number of bytes to read. The max is 65,535 (max of u16).
- * @returns a vector of bytes from the specified pipe. On error, will be empty.
+ * @returns the number of bytes read from the specified pipe. On error, will be 0.
  */
-std::vector<u8> PipeRead(DspPipe pipe_number, u32 length);
+size_t PipeRead(DspPipe pipe_number, u8* dest, size_t length);
 
 /**
  * How much data is left in pipe
@@ -47,8 +46,9 @@ size_t GetPipeReadableSize(DspPipe pipe_number);
  * Write to a DSP pipe.
  * @param pipe_number The Pipe ID
  * @param buffer The data to write to the pipe.
+ * @param length The number of bytes in `buffer`.
  */
-void PipeWrite(DspPipe pipe_number, const std::vector<u8>& buffer);
+void PipeWrite(DspPipe pipe_number, const u8* buffer, size_t length);
 
 enum class DspState {
     Off,
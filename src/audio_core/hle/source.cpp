@@ -9,9 +9,14 @@
 #include "audio_core/hle/source.h"
 #include "audio_core/interpolate.h"
 #include "common/assert.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "core/memory.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace DSP {
 namespace HLE {
 
@@ -31,6 +36,28 @@ void Source::MixInto(QuadFrame32& dest, size_t intermediate_mix_id) const {
         return;
 
     const std::array<float, 4>& gains = state.gain.at(intermediate_mix_id);
+    // Sources are usually only routed to some of the mixes; the others would only get zeroes
+    if (gains[0] == 0.0f && gains[1] == 0.0f && gains[2] == 0.0f && gains[3] == 0.0f)
+        return;
+
+#ifdef ARCHITECTURE_x86_64
+    static_assert(samples_per_frame % 2 == 0, "Two samples are mixed per iteration");
+    const __m128 gain = _mm_loadu_ps(gains.data());
+    for (size_t samplei = 0; samplei < samples_per_frame; samplei += 2) {
+        // Conversion from stereo (current_frame) to quadraphonic (dest) occurs here:
+        // [L0 R0 L1 R1] is spread to [L0 R0 L0 R0] and [L1 R1 L1 R1].
+        const __m128i stereo = _mm_loadl_epi64(
+            reinterpret_cast<const __m128i*>(current_frame[samplei].data()));
+        const __m128i spread = _mm_unpacklo_epi32(stereo, stereo);
+        const __m128i quad[2] = {_mm_srai_epi32(_mm_unpacklo_epi16(spread, spread), 16),
+                                 _mm_srai_epi32(_mm_unpackhi_epi16(spread, spread), 16)};
+        for (size_t i = 0; i < 2; i++) {
+            __m128i* out = reinterpret_cast<__m128i*>(dest[samplei + i].data());
+            const __m128i mixed = _mm_cvttps_epi32(_mm_mul_ps(gain, _mm_cvtepi32_ps(quad[i])));
+            _mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), mixed));
+        }
+    }
+#else
     for (size_t samplei = 0; samplei < samples_per_frame; samplei++) {
         // Conversion from stereo (current_frame) to quadraphonic (dest) occurs here.
         dest[samplei][0] += static_cast<s32>(gains[0] * current_frame[samplei][0]);
@@ -38,6 +65,7 @@ void Source::MixInto(QuadFrame32& dest, size_t intermediate_mix_id) const {
         dest[samplei][2] += static_cast<s32>(gains[2] * current_frame[samplei][0]);
         dest[samplei][3] += static_cast<s32>(gains[3] * current_frame[samplei][1]);
     }
+#endif
 }
 
 void Source::Reset() {
@@ -183,8 +211,8 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
             false,
         });
         LOG_TRACE(Audio_DSP, "enqueuing embedded addr=0x%08x len=%u id=%hu start=%u",
-                  config.physical_address, config.length, config.buffer_id,
-                  static_cast<u32>(config.play_position));
+                  static_cast<u32>(config.physical_address), static_cast<u32>(config.length),
+                  config.buffer_id, static_cast<u32>(config.play_position));
     }
 
     if (config.loop_related_dirty && config.loop_related != 0) {
@@ -213,7 +241,8 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
                     false,
                 });
                 LOG_TRACE(Audio_DSP, "enqueuing queued %zu addr=0x%08x len=%u id=%hu", i,
-                          b.physical_address, b.length, b.buffer_id);
+                          static_cast<u32>(b.physical_address), static_cast<u32>(b.length),
+                          b.buffer_id);
             }
         }
         config.buffers_dirty = 0;
@@ -290,8 +319,7 @@ bool Source::DequeueBuffer() {
             break;
         case Format::ADPCM:
             DEBUG_ASSERT(num_channels == 1);
-            state.current_buffer =
-                Codec::DecodeADPCM(memory, buf.length, state.adpcm_coeffs, state.adpcm_state);
+            state.current_buffer = DecodeADPCM(memory, buf);
             break;
         default:
             UNIMPLEMENTED();
@@ -315,9 +343,8 @@ bool Source::DequeueBuffer() {
             AudioInterp::Linear(state.interp_state, state.current_buffer, state.rate_multiplier);
         break;
     case InterpolationMode::Polyphase:
-        // TODO(merry): Implement polyphase interpolation
-        state.current_buffer =
-            AudioInterp::Linear(state.interp_state, state.current_buffer, state.rate_multiplier);
+        state.current_buffer = AudioInterp::Polyphase(state.interp_state, state.current_buffer,
+                                                      state.rate_multiplier);
         break;
     default:
         UNIMPLEMENTED();
@@ -338,6 +365,45 @@ bool Source::DequeueBuffer() {
     return true;
 }
 
+AudioInterp::StereoBuffer16 Source::DecodeADPCM(const u8* memory, const Buffer& buf) {
+    // Bounds how much decoded audio each source keeps around
+    constexpr size_t max_decoded_buffers = 2;
+    constexpr size_t max_decoded_samples = 1 << 20;
+
+    // Frames are 8 bytes long containing 14 samples each
+    const size_t data_size = (buf.length + 13) / 14 * 8;
+    const u64 data_hash = Common::ComputeHash64(memory, data_size);
+    const Codec::ADPCMState initial_state = state.adpcm_state;
+
+    // The CPU may have rewritten the buffer since it was decoded, hence the hash of the data
+    for (auto it = state.decoded_adpcm.begin(); it != state.decoded_adpcm.end(); ++it) {
+        if (it->physical_address == buf.physical_address && it->length == buf.length &&
+            it->data_hash == data_hash && it->coeffs == state.adpcm_coeffs &&
+            it->initial_state.yn1 == initial_state.yn1 &&
+            it->initial_state.yn2 == initial_state.yn2) {
+            state.adpcm_state = it->final_state;
+            DecodedADPCM decoded = std::move(*it);
+            state.decoded_adpcm.erase(it);
+            state.decoded_adpcm.push_front(std::move(decoded));
+            return state.decoded_adpcm.front().samples;
+        }
+    }
+
+    AudioInterp::StereoBuffer16 samples =
+        Codec::DecodeADPCM(memory, buf.length, state.adpcm_coeffs, state.adpcm_state);
+
+    // Only buffers that play again are worth keeping, which are looping ones
+    if (buf.is_looping && samples.size() <= max_decoded_samples) {
+        if (state.decoded_adpcm.size() == max_decoded_buffers)
+            state.decoded_adpcm.pop_back();
+        state.decoded_adpcm.push_front({buf.physical_address, buf.length, data_hash,
+                                        state.adpcm_coeffs, initial_state, state.adpcm_state,
+                                        samples});
+    }
+
+    return samples;
+}
+
 SourceStatus::Status Source::GetCurrentStatus() {
     SourceStatus::Status ret;
 
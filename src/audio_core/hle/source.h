@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <deque>
 #include <queue>
 #include <vector>
 #include "audio_core/codec.h"
@@ -80,6 +81,19 @@ private:
         bool has_played;       // = false;
     };
 
+    /// A decoded ADPCM buffer, kept so that looping buffers are only decoded once
+    struct DecodedADPCM {
+        // What the samples were decoded from
+        PAddr physical_address;
+        u32 length;
+        u64 data_hash;
+        std::array<s16, 16> coeffs;
+        Codec::ADPCMState initial_state;
+
+        Codec::ADPCMState final_state;
+        AudioInterp::StereoBuffer16 samples;
+    };
+
     struct BufferOrder {
         bool operator()(const Buffer& a, const Buffer& b) const {
             // Lower buffer_id comes first.
@@ -119,6 +133,8 @@ private:
 
         std::array<s16, 16> adpcm_coeffs = {};
         Codec::ADPCMState adpcm_state = {};
+        /// Recently decoded ADPCM buffers, most recently used first
+        std::deque<DecodedADPCM> decoded_adpcm;
 
         // Resampling state
 
@@ -141,6 +157,8 @@ private:
     /// INTERNAL: Dequeues a buffer and does preprocessing on it (decoding, resampling). Puts it
     /// into current_buffer.
     bool DequeueBuffer();
+    /// INTERNAL: Decodes an ADPCM buffer, or copies it from decoded_adpcm if it was decoded before.
+    AudioInterp::StereoBuffer16 DecodeADPCM(const u8* memory, const Buffer& buf);
     /// INTERNAL: Generates a SourceStatus::Status based on our internal state.
     SourceStatus::Status GetCurrentStatus();
 };
@@ -2,10 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cmath>
 #include "audio_core/interpolate.h"
 #include "common/assert.h"
 #include "common/math_util.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace AudioInterp {
 
 // Calculations are done in fixed point with 24 fractional bits.
@@ -83,4 +88,138 @@ StereoBuffer16 Linear(State& state, const StereoBuffer16& input, float rate_mult
                            });
 }
 
+// The polyphase filter has a table of taps for each of polyphase_phases fractional positions
+// between two input samples. The taps are fixed point with polyphase_coeff_bits fractional bits.
+constexpr size_t polyphase_phases = 128;
+constexpr int polyphase_coeff_bits = 14;
+constexpr u64 polyphase_phase_shift = 24 - 7; // log2(scale_factor / polyphase_phases)
+static_assert(scale_factor >> polyphase_phase_shift == polyphase_phases, "Mismatched phases");
+
+using PolyphaseTaps = std::array<s16, polyphase_taps>;
+using PolyphaseTable = std::array<PolyphaseTaps, polyphase_phases>;
+
+/// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double BesselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static PolyphaseTable MakePolyphaseTable() {
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double kaiser_beta = 6.0;
+    constexpr double half_width = polyphase_taps / 2;
+
+    PolyphaseTable table;
+    for (size_t phase = 0; phase < polyphase_phases; phase++) {
+        const double fraction = static_cast<double>(phase) / polyphase_phases;
+
+        std::array<double, polyphase_taps> taps;
+        double sum = 0.0;
+        for (size_t k = 0; k < polyphase_taps; k++) {
+            // The interpolated point lies `fraction` past the last tap of the first half
+            const double x = static_cast<double>(k) - (half_width - 1) - fraction;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+            const double r = x / half_width;
+            const double window = std::abs(r) < 1.0
+                                      ? BesselI0(kaiser_beta * std::sqrt(1.0 - r * r)) /
+                                            BesselI0(kaiser_beta)
+                                      : 0.0;
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+
+        // Normalize to unity gain at DC, putting the rounding error on the nearest tap
+        s32 total = 0;
+        for (size_t k = 0; k < polyphase_taps; k++) {
+            table[phase][k] =
+                static_cast<s16>(std::lround(taps[k] / sum * (1 << polyphase_coeff_bits)));
+            total += table[phase][k];
+        }
+        const size_t nearest = polyphase_taps / 2 - (fraction < 0.5 ? 1 : 0);
+        table[phase][nearest] += static_cast<s16>((1 << polyphase_coeff_bits) - total);
+    }
+    return table;
+}
+
+/// Computes one output sample from polyphase_taps consecutive samples of each channel
+static std::array<s16, 2> ApplyPolyphaseTaps(const s16* left, const s16* right,
+                                             const PolyphaseTaps& taps) {
+    constexpr s32 rounding = 1 << (polyphase_coeff_bits - 1);
+#ifdef ARCHITECTURE_x86_64
+    static_assert(polyphase_taps == 8, "The taps of a channel fill one register");
+    const __m128i coeffs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps.data()));
+    const __m128i l =
+        _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left)), coeffs);
+    const __m128i r =
+        _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(right)), coeffs);
+    // [l0+l2, r0+r2, l1+l3, r1+r3], then fold the upper half onto the lower one
+    __m128i sums = _mm_add_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r));
+    sums = _mm_add_epi32(sums, _mm_srli_si128(sums, 8));
+    sums = _mm_srai_epi32(_mm_add_epi32(sums, _mm_set1_epi32(rounding)), polyphase_coeff_bits);
+    const u32 packed = static_cast<u32>(_mm_cvtsi128_si32(_mm_packs_epi32(sums, sums)));
+    return {static_cast<s16>(packed & 0xFFFF), static_cast<s16>(packed >> 16)};
+#else
+    s32 sum_left = 0;
+    s32 sum_right = 0;
+    for (size_t k = 0; k < polyphase_taps; k++) {
+        sum_left += left[k] * taps[k];
+        sum_right += right[k] * taps[k];
+    }
+    return {
+        static_cast<s16>(MathUtil::Clamp((sum_left + rounding) >> polyphase_coeff_bits, -32768,
+                                         32767)),
+        static_cast<s16>(MathUtil::Clamp((sum_right + rounding) >> polyphase_coeff_bits, -32768,
+                                         32767)),
+    };
+#endif
+}
+
+StereoBuffer16 Polyphase(State& state, const StereoBuffer16& input, float rate_multiplier) {
+    ASSERT(rate_multiplier > 0);
+
+    if (input.empty())
+        return {};
+
+    static const PolyphaseTable table = MakePolyphaseTable();
+
+    // Deinterleave the history followed by the input, so that the taps of a channel are
+    // contiguous
+    const size_t history_size = state.polyphase_history.size();
+    const size_t total_size = history_size + input.size();
+    std::vector<s16> left(total_size);
+    std::vector<s16> right(total_size);
+    for (size_t i = 0; i < history_size; i++) {
+        left[i] = state.polyphase_history[i][0];
+        right[i] = state.polyphase_history[i][1];
+    }
+    for (size_t i = 0; i < input.size(); i++) {
+        left[history_size + i] = input[i][0];
+        right[history_size + i] = input[i][1];
+    }
+
+    StereoBuffer16 output;
+    output.reserve(static_cast<size_t>(input.size() / rate_multiplier) + 1);
+
+    const u64 step_size = static_cast<u64>(rate_multiplier * scale_factor);
+    const u64 max_fposition = input.size() * scale_factor;
+
+    // The last tap used for each output sample is the input sample at fposition
+    for (u64 fposition = 0; fposition < max_fposition; fposition += step_size) {
+        const size_t index = static_cast<size_t>(fposition / scale_factor);
+        const PolyphaseTaps& taps = table[(fposition & scale_mask) >> polyphase_phase_shift];
+        output.push_back(ApplyPolyphaseTaps(&left[index], &right[index], taps));
+    }
+
+    for (size_t i = 0; i < history_size; i++) {
+        state.polyphase_history[i] = {left[input.size() + i], right[input.size() + i]};
+    }
+
+    return output;
+}
+
 } // namespace AudioInterp
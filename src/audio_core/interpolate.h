@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <vector>
 #include "common/common_types.h"
 
@@ -13,10 +14,16 @@ namespace AudioInterp {
 /// A variable length buffer of signed PCM16 stereo samples.
 using StereoBuffer16 = std::vector<std::array<s16, 2>>;
 
+/// Number of input samples each output sample of the polyphase resampler is computed from.
+constexpr size_t polyphase_taps = 8;
+
 struct State {
     // Two historical samples.
     std::array<s16, 2> xn1 = {}; ///< x[n-1]
     std::array<s16, 2> xn2 = {}; ///< x[n-2]
+
+    /// Historical samples of the polyphase resampler, oldest first.
+    std::array<std::array<s16, 2>, polyphase_taps - 1> polyphase_history = {};
 };
 
 /**
@@ -41,4 +48,17 @@ StereoBuffer16 None(State& state, const StereoBuffer16& input, float rate_multip
  */
 StereoBuffer16 Linear(State& state, const StereoBuffer16& input, float rate_multiplier);
 
+/**
+ * Polyphase interpolation with a Kaiser-windowed sinc filter of polyphase_taps taps. This has far
+ * less aliasing than linear interpolation when upsampling. When decimating, content above the
+ * output Nyquist frequency is not filtered out. There is a four-sample predelay.
+ * @param state Interpolation state.
+ * @param input Input buffer.
+ * @param rate_multiplier Stretch factor. Must be a positive non-zero value.
+ *                        rate_multiplier > 1.0 performs decimation and rate_multipler < 1.0
+ *                        performs upsampling.
+ * @return The resampled audio buffer.
+ */
+StereoBuffer16 Polyphase(State& state, const StereoBuffer16& input, float rate_multiplier);
+
 } // namespace AudioInterp
@@ -24,6 +24,14 @@ public:
         return 0;
     }
 
+    size_t GetDeviceLatency() const override {
+        return 0;
+    }
+
+    bool IsRealTime() const override {
+        return true;
+    }
+
     void SetDevice(int device_id) override {}
 
     std::vector<std::string> GetDeviceList() const override {
@@ -2,23 +2,26 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <list>
-#include <numeric>
+#include <cstring>
 #include <SDL.h>
 #include "audio_core/audio_core.h"
 #include "audio_core/sdl2_sink.h"
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/ring_buffer.h"
 #include "core/settings.h"
 
 namespace AudioCore {
 
 struct SDL2Sink::Impl {
     unsigned int sample_rate = 0;
+    /// Samples the audio callback asks for at once
+    size_t device_buffer_samples = 0;
 
     SDL_AudioDeviceID audio_device_id = 0;
 
-    std::list<std::vector<s16>> queue;
+    /// Stereo samples from the emulation thread to the SDL audio thread, about one second worth
+    Common::RingBuffer<s16, 2, 0x8000> queue;
 
     static void Callback(void* impl_, u8* buffer, int buffer_size_in_bytes);
 };
@@ -64,6 +67,7 @@ SDL2Sink::SDL2Sink() : impl(std::make_unique<Impl>()) {
     }
 
     impl->sample_rate = obtained_audiospec.freq;
+    impl->device_buffer_samples = obtained_audiospec.samples;
 
     // SDL2 audio devices start out paused, unpause it:
     SDL_PauseAudioDevice(impl->audio_device_id, 0);
@@ -91,27 +95,28 @@ void SDL2Sink::EnqueueSamples(const s16* samples, size_t sample_count) {
     if (impl->audio_device_id <= 0)
         return;
 
-    SDL_LockAudioDevice(impl->audio_device_id);
-    impl->queue.emplace_back(samples, samples + sample_count * 2);
-    SDL_UnlockAudioDevice(impl->audio_device_id);
+    const size_t samples_pushed = impl->queue.Push(samples, sample_count);
+    if (samples_pushed < sample_count) {
+        LOG_TRACE(Audio_Sink, "Queue full, dropped %zu samples", sample_count - samples_pushed);
+    }
 }
 
 size_t SDL2Sink::SamplesInQueue() const {
     if (impl->audio_device_id <= 0)
         return 0;
 
-    SDL_LockAudioDevice(impl->audio_device_id);
+    return impl->queue.Size();
+}
 
-    size_t total_size = std::accumulate(impl->queue.begin(), impl->queue.end(),
-                                        static_cast<size_t>(0), [](size_t sum, const auto& buffer) {
-                                            // Division by two because each stereo sample is made of
-                                            // two s16.
-                                            return sum + buffer.size() / 2;
-                                        });
+bool SDL2Sink::IsRealTime() const {
+    return true;
+}
 
-    SDL_UnlockAudioDevice(impl->audio_device_id);
+size_t SDL2Sink::GetDeviceLatency() const {
+    if (impl->audio_device_id <= 0)
+        return 0;
 
-    return total_size;
+    return impl->device_buffer_samples;
 }
 
 void SDL2Sink::SetDevice(int device_id) {
@@ -121,26 +126,13 @@ void SDL2Sink::SetDevice(int device_id) {
 void SDL2Sink::Impl::Callback(void* impl_, u8* buffer, int buffer_size_in_bytes) {
     Impl* impl = reinterpret_cast<Impl*>(impl_);
 
-    size_t remaining_size = static_cast<size_t>(buffer_size_in_bytes) /
-                            sizeof(s16); // Keep track of size in 16-bit increments.
-
-    while (remaining_size > 0 && !impl->queue.empty()) {
-        if (impl->queue.front().size() <= remaining_size) {
-            memcpy(buffer, impl->queue.front().data(), impl->queue.front().size() * sizeof(s16));
-            buffer += impl->queue.front().size() * sizeof(s16);
-            remaining_size -= impl->queue.front().size();
-            impl->queue.pop_front();
-        } else {
-            memcpy(buffer, impl->queue.front().data(), remaining_size * sizeof(s16));
-            buffer += remaining_size * sizeof(s16);
-            impl->queue.front().erase(impl->queue.front().begin(),
-                                      impl->queue.front().begin() + remaining_size);
-            remaining_size = 0;
-        }
-    }
+    // Each stereo sample is made of two s16
+    const size_t sample_count = static_cast<size_t>(buffer_size_in_bytes) / (2 * sizeof(s16));
+    const size_t samples_read = impl->queue.Pop(buffer, sample_count);
 
-    if (remaining_size > 0) {
-        memset(buffer, 0, remaining_size * sizeof(s16));
+    if (samples_read < sample_count) {
+        std::memset(buffer + samples_read * 2 * sizeof(s16), 0,
+                    (sample_count - samples_read) * 2 * sizeof(s16));
     }
 }
 
@@ -21,6 +21,10 @@ public:
 
     size_t SamplesInQueue() const override;
 
+    size_t GetDeviceLatency() const override;
+
+    bool IsRealTime() const override;
+
     std::vector<std::string> GetDeviceList() const override;
     void SetDevice(int device_id) override;
 
@@ -32,6 +32,18 @@ public:
     /// Samples enqueued that have not been played yet.
     virtual std::size_t SamplesInQueue() const = 0;
 
+    /**
+     * Samples the output device holds on top of the queue, i.e. how many samples it takes from
+     * the queue at once. The queue needs to hold at least this many to avoid underruns.
+     */
+    virtual std::size_t GetDeviceLatency() const = 0;
+
+    /**
+     * Whether the sink plays samples back in real time. Sinks that don't, like file writers, take
+     * samples as fast as they come, so the time stretcher and the frame limiter are bypassed.
+     */
+    virtual bool IsRealTime() const = 0;
+
     /**
      * Sets the desired output device.
      * @param device_id ID of the desired device.
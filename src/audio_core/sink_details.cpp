@@ -7,10 +7,12 @@
 #include <vector>
 #include "audio_core/null_sink.h"
 #include "audio_core/sink_details.h"
+#include "audio_core/wav_sink.h"
 #ifdef HAVE_SDL2
 #include "audio_core/sdl2_sink.h"
 #endif
 #include "common/logging/log.h"
+#include "core/settings.h"
 
 namespace AudioCore {
 
@@ -20,6 +22,7 @@ const std::vector<SinkDetails> g_sink_details = {
     {"sdl2", []() { return std::make_unique<SDL2Sink>(); }},
 #endif
     {"null", []() { return std::make_unique<NullSink>(); }},
+    {"wav", []() { return std::make_unique<WavSink>(Settings::values.audio_dump_path); }},
 };
 
 const SinkDetails& GetSinkDetails(std::string sink_id) {
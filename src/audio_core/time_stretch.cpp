@@ -8,6 +8,7 @@
 #include <SoundTouch.h>
 #include "audio_core/audio_core.h"
 #include "audio_core/time_stretch.h"
+#include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
@@ -23,9 +24,9 @@ static double ClampRatio(double ratio) {
     return MathUtil::Clamp(ratio, MIN_RATIO, MAX_RATIO);
 }
 
-constexpr double MIN_DELAY_TIME = 0.05;            // Units: seconds
-constexpr double MAX_DELAY_TIME = 0.25;            // Units: seconds
-constexpr size_t DROP_FRAMES_SAMPLE_DELAY = 16000; // Units: samples
+constexpr double DEFAULT_DELAY_TIME = 0.05; // Units: seconds
+/// Past this many times the target delay, output is dropped instead of being queued
+constexpr size_t DROP_FRAMES_DELAY_FACTOR = 4;
 
 constexpr double SMOOTHING_FACTOR = 0.007;
 
@@ -38,6 +39,8 @@ struct TimeStretcher::Impl {
     double smoothed_ratio = 1.0;
 
     double sample_rate = static_cast<double>(native_sample_rate);
+
+    size_t target_delay = static_cast<size_t>(DEFAULT_DELAY_TIME * native_sample_rate);
 };
 
 std::vector<s16> TimeStretcher::Process(size_t samples_in_queue) {
@@ -53,7 +56,7 @@ std::vector<s16> TimeStretcher::Process(size_t samples_in_queue) {
     impl->soundtouch.setTempo(1.0 / impl->smoothed_ratio);
 
     std::vector<s16> samples = GetSamples();
-    if (samples_in_queue >= DROP_FRAMES_SAMPLE_DELAY) {
+    if (samples_in_queue >= DROP_FRAMES_DELAY_FACTOR * impl->target_delay) {
         samples.clear();
         LOG_DEBUG(Audio, "Dropping frames!");
     }
@@ -76,6 +79,11 @@ void TimeStretcher::SetOutputSampleRate(unsigned int sample_rate) {
     impl->soundtouch.setRate(static_cast<double>(native_sample_rate) / impl->sample_rate);
 }
 
+void TimeStretcher::SetTargetDelay(size_t sample_delay) {
+    ASSERT(sample_delay > 0);
+    impl->target_delay = sample_delay;
+}
+
 void TimeStretcher::AddSamples(const s16* buffer, size_t num_samples) {
     impl->soundtouch.putSamples(buffer, static_cast<uint>(num_samples));
     impl->samples_queued += num_samples;
@@ -116,18 +124,13 @@ double TimeStretcher::CalculateCurrentRatio() {
 }
 
 double TimeStretcher::CorrectForUnderAndOverflow(double ratio, size_t sample_delay) const {
-    const size_t min_sample_delay = static_cast<size_t>(MIN_DELAY_TIME * impl->sample_rate);
-    const size_t max_sample_delay = static_cast<size_t>(MAX_DELAY_TIME * impl->sample_rate);
-
-    if (sample_delay < min_sample_delay) {
-        // Make the ratio bigger.
-        ratio = ratio > 1.0 ? ratio * ratio : sqrt(ratio);
-    } else if (sample_delay > max_sample_delay) {
-        // Make the ratio smaller.
-        ratio = ratio > 1.0 ? sqrt(ratio) : ratio * ratio;
-    }
+    // Below the target the ratio is made bigger so that more samples come out, and above it
+    // smaller, by up to a factor of two when the queue is empty or twice the target.
+    const double target = static_cast<double>(impl->target_delay);
+    const double error =
+        MathUtil::Clamp((target - static_cast<double>(sample_delay)) / target, -1.0, 1.0);
 
-    return ClampRatio(ratio);
+    return ClampRatio(ratio * std::exp2(error));
 }
 
 std::vector<s16> TimeStretcher::GetSamples() {
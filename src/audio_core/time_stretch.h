@@ -22,6 +22,12 @@ public:
      */
     void SetOutputSampleRate(unsigned int sample_rate);
 
+    /**
+     * Set how many samples Process aims to keep buffered downstream.
+     * @param sample_delay The target, in samples at the output sample rate. Must be non-zero.
+     */
+    void SetTargetDelay(size_t sample_delay);
+
     /**
      * Add samples to be processed.
      * @param sample_buffer Buffer of samples in interleaved stereo PCM16 format.
@@ -50,8 +56,7 @@ private:
 
     /// INTERNAL: ratio = wallclock time / emulated time
     double CalculateCurrentRatio();
-    /// INTERNAL: If we have too many or too few samples downstream, nudge ratio in the appropriate
-    /// direction.
+    /// INTERNAL: Nudge ratio in proportion to how far the samples downstream are from the target.
     double CorrectForUnderAndOverflow(double ratio, size_t sample_delay) const;
     /// INTERNAL: Gets the time-stretched samples from SoundTouch.
     std::vector<s16> GetSamples();
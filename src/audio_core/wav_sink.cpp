@@ -0,0 +1,136 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstdio>
+#include <limits>
+#include "audio_core/audio_core.h"
+#include "audio_core/wav_sink.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+
+namespace AudioCore {
+
+namespace {
+struct WavHeader {
+    std::array<char, 4> riff_id;
+    u32_le riff_size;
+    std::array<char, 4> wave_id;
+
+    std::array<char, 4> fmt_id;
+    u32_le fmt_size;
+    u16_le format;
+    u16_le channel_count;
+    u32_le sample_rate;
+    u32_le byte_rate;
+    u16_le block_align;
+    u16_le bits_per_sample;
+
+    std::array<char, 4> data_id;
+    u32_le data_size;
+};
+static_assert(sizeof(WavHeader) == 44, "WavHeader has incorrect size");
+
+constexpr u16 WAVE_FORMAT_PCM = 1;
+constexpr u16 channel_count = 2;
+constexpr u16 bytes_per_sample = sizeof(s16) * channel_count;
+} // Anonymous namespace
+
+WavSink::WavSink(std::string path_) : path(std::move(path_)) {
+    if (path.empty()) {
+        path = FileUtil::GetUserPath(D_USER_IDX) + "audio_dump.wav";
+    }
+}
+
+WavSink::~WavSink() {
+    if (file.IsOpen()) {
+        WriteHeader();
+    }
+}
+
+unsigned int WavSink::GetNativeSampleRate() const {
+    return native_sample_rate;
+}
+
+void WavSink::EnqueueSamples(const s16* samples, size_t sample_count) {
+    if (!open_attempted) {
+        // Opened here rather than in the constructor, as sinks are also created just to list
+        // their devices
+        open_attempted = true;
+        if (!file.Open(path, "wb")) {
+            LOG_ERROR(Audio, "Could not open %s for writing, audio will not be dumped",
+                      path.c_str());
+            return;
+        }
+        WriteHeader();
+    }
+
+    if (!file.IsOpen() || sample_count == 0)
+        return;
+
+    // The sizes in the header are 32-bit, so stop before they overflow (about 9 hours of audio)
+    const size_t max_samples =
+        (std::numeric_limits<u32>::max() - sizeof(WavHeader) - data_size) / bytes_per_sample;
+    if (sample_count > max_samples) {
+        LOG_WARNING(Audio, "%s is full, dropping audio", path.c_str());
+        sample_count = max_samples;
+    }
+
+    file.WriteArray(samples, sample_count * channel_count);
+    const u32 previous_size = data_size;
+    data_size += static_cast<u32>(sample_count * bytes_per_sample);
+
+    // Keep the header up to date about once a second, so the file stays playable if the emulator
+    // doesn't shut down cleanly
+    const u32 header_interval = native_sample_rate * bytes_per_sample;
+    if (data_size / header_interval != previous_size / header_interval) {
+        WriteHeader();
+    }
+}
+
+size_t WavSink::SamplesInQueue() const {
+    return 0;
+}
+
+size_t WavSink::GetDeviceLatency() const {
+    return 0;
+}
+
+bool WavSink::IsRealTime() const {
+    return false;
+}
+
+void WavSink::SetDevice(int /*device_id*/) {}
+
+std::vector<std::string> WavSink::GetDeviceList() const {
+    return {};
+}
+
+void WavSink::WriteHeader() {
+    WavHeader header;
+    header.riff_id = {{'R', 'I', 'F', 'F'}};
+    header.riff_size = sizeof(WavHeader) - 8 + data_size;
+    header.wave_id = {{'W', 'A', 'V', 'E'}};
+    header.fmt_id = {{'f', 'm', 't', ' '}};
+    header.fmt_size = 16;
+    header.format = WAVE_FORMAT_PCM;
+    header.channel_count = channel_count;
+    header.sample_rate = native_sample_rate;
+    header.byte_rate = native_sample_rate * bytes_per_sample;
+    header.block_align = bytes_per_sample;
+    header.bits_per_sample = 16;
+    header.data_id = {{'d', 'a', 't', 'a'}};
+    header.data_size = data_size;
+
+    const u64 position = file.Tell();
+    file.Seek(0, SEEK_SET);
+    file.WriteObject(header);
+    if (position > sizeof(WavHeader)) {
+        file.Seek(position, SEEK_SET);
+    }
+    // Hand the header over to the OS, so it is not lost if the emulator crashes
+    file.Flush();
+}
+
+} // namespace AudioCore
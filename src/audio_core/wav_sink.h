@@ -0,0 +1,49 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "audio_core/sink.h"
+#include "common/file_util.h"
+
+namespace AudioCore {
+
+/**
+ * Sink that writes the final mix to a 16-bit stereo WAV file instead of playing it. It never waits
+ * on a device, so emulation may run faster than real time while dumping.
+ */
+class WavSink final : public Sink {
+public:
+    /// @param path File to write, or empty to write audio_dump.wav in the user directory
+    explicit WavSink(std::string path);
+    ~WavSink() override;
+
+    unsigned int GetNativeSampleRate() const override;
+
+    void EnqueueSamples(const s16* samples, size_t sample_count) override;
+
+    size_t SamplesInQueue() const override;
+
+    size_t GetDeviceLatency() const override;
+
+    bool IsRealTime() const override;
+
+    void SetDevice(int device_id) override;
+
+    std::vector<std::string> GetDeviceList() const override;
+
+private:
+    /// Rewrites the header with the sizes of the data written so far
+    void WriteHeader();
+
+    std::string path;
+    FileUtil::IOFile file;
+    /// Whether opening the file was attempted, which is delayed until the first samples arrive
+    bool open_attempted = false;
+    u32 data_size = 0; ///< Units: bytes
+};
+
+} // namespace AudioCore
@@ -2,10 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <iostream>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 // This needs to be included before getopt.h because the latter #defines symbols used by it
 #include "common/microprofile.h"
@@ -14,6 +15,7 @@
 #include <getopt.h>
 #else
 #include <getopt.h>
+#include <sys/resource.h>
 #include <unistd.h>
 #endif
 
@@ -21,11 +23,14 @@
 // windows.h needs to be included before shellapi.h
 #include <windows.h>
 
+#include <psapi.h>
 #include <shellapi.h>
 #endif
 
 #include "citra/config.h"
 #include "citra/emu_window/emu_window_sdl2.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
@@ -37,16 +42,104 @@
 #include "core/loader/loader.h"
 #include "core/settings.h"
 
+#ifdef ENABLE_WEB_SERVICE
+#include "web_service/web_backend.h"
+#endif
+
 static void PrintHelp(const char* argv0) {
-    std::cout << "Usage: " << argv0
-              << " [options] <filename>\n"
-                 "-g, --gdbport=NUMBER  Enable gdb stub on port NUMBER\n"
-                 "-h, --help            Display this help and exit\n"
-                 "-v, --version         Output version information and exit\n";
+    LOG_INFO(Frontend,
+             "Usage: %s [options] <filename>...\n"
+             "Several files are run one after the other in the same process, each for the\n"
+             "number of frames given by --frames.\n"
+             "-g, --gdbport=NUMBER       Enable gdb stub on port NUMBER\n"
+             "-H, --headless            Run in a hidden window, without presenting frames or\n"
+             "                          limiting the speed, and without audio output\n"
+             "-n, --frames=NUMBER       Exit after NUMBER frames\n"
+             "-d, --dump-frames=DIR     Write frames to DIR as PPM images, to a numbered\n"
+             "                          subdirectory for each file when running several\n"
+             "-i, --dump-interval=N     Only dump every Nth frame\n"
+             "-m, --movie=FILE          Play back the input recorded in the movie FILE\n"
+             "-b, --benchmark=FILE      Run headless for the frames given by --frames and\n"
+             "                          write a JSON performance report of each file to FILE\n"
+             "-h, --help                Display this help and exit\n"
+             "-v, --version             Output version information and exit",
+             argv0);
 }
 
 static void PrintVersion() {
-    std::cout << "Citra " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+    LOG_INFO(Frontend, "Citra %s %s", Common::g_scm_branch, Common::g_scm_desc);
+}
+
+/// Returns the peak resident set size of the process in bytes, or 0 if it's unknown
+static u64 GetPeakResidentSetSize() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return static_cast<u64>(usage.ru_maxrss);
+#else
+    // Linux reports kilobytes
+    return static_cast<u64>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/// Quotes a string for JSON
+static std::string QuoteJson(const std::string& str) {
+    std::string quoted = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            quoted += Common::StringFromFormat("\\u%04x", c);
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + '"';
+}
+
+/// Boots the file, logging why if it fails
+static bool BootFile(Core::System& system, EmuWindow_SDL2* emu_window,
+                     const std::string& filepath) {
+    const Core::System::ResultStatus load_result{system.Load(emu_window, filepath)};
+
+    switch (load_result) {
+    case Core::System::ResultStatus::ErrorGetLoader:
+        LOG_CRITICAL(Frontend, "Failed to obtain loader for %s!", filepath.c_str());
+        return false;
+    case Core::System::ResultStatus::ErrorLoader:
+        LOG_CRITICAL(Frontend, "Failed to load ROM!");
+        return false;
+    case Core::System::ResultStatus::ErrorLoader_ErrorEncrypted:
+        LOG_CRITICAL(Frontend, "The game that you are trying to load must be decrypted before "
+                               "being used with Citra. \n\n For more information on dumping and "
+                               "decrypting games, please refer to: "
+                               "https://citra-emu.org/wiki/dumping-game-cartridges/");
+        return false;
+    case Core::System::ResultStatus::ErrorLoader_ErrorInvalidFormat:
+        LOG_CRITICAL(Frontend, "Error while loading ROM: The ROM format is not supported.");
+        return false;
+    case Core::System::ResultStatus::ErrorNotInitialized:
+        LOG_CRITICAL(Frontend, "CPUCore not initialized");
+        return false;
+    case Core::System::ResultStatus::ErrorSystemMode:
+        LOG_CRITICAL(Frontend, "Failed to determine system mode!");
+        return false;
+    case Core::System::ResultStatus::ErrorVideoCore:
+        LOG_CRITICAL(Frontend, "VideoCore not initialized");
+        return false;
+    case Core::System::ResultStatus::Success:
+        break; // Expected case
+    }
+    return true;
 }
 
 /// Application entry point
@@ -55,6 +148,12 @@ int main(int argc, char** argv) {
     int option_index = 0;
     bool use_gdbstub = Settings::values.use_gdbstub;
     u32 gdb_port = static_cast<u32>(Settings::values.gdbstub_port);
+    bool headless = false;
+    u32 exit_after_frames = 0;
+    std::string frame_dump_directory;
+    u32 frame_dump_interval = 1;
+    std::string movie_path;
+    std::string benchmark_report_path;
     char* endarg;
 #ifdef _WIN32
     int argc_w;
@@ -65,17 +164,23 @@ int main(int argc, char** argv) {
         return -1;
     }
 #endif
-    std::string filepath;
+    std::vector<std::string> filepaths;
 
     static struct option long_options[] = {
         {"gdbport", required_argument, 0, 'g'},
+        {"headless", no_argument, 0, 'H'},
+        {"frames", required_argument, 0, 'n'},
+        {"dump-frames", required_argument, 0, 'd'},
+        {"dump-interval", required_argument, 0, 'i'},
+        {"movie", required_argument, 0, 'm'},
+        {"benchmark", required_argument, 0, 'b'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
         {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        char arg = getopt_long(argc, argv, "g:hv", long_options, &option_index);
+        char arg = getopt_long(argc, argv, "g:Hn:d:i:m:b:hv", long_options, &option_index);
         if (arg != -1) {
             switch (arg) {
             case 'g':
@@ -89,6 +194,35 @@ int main(int argc, char** argv) {
                     exit(1);
                 }
                 break;
+            case 'H':
+                headless = true;
+                break;
+            case 'n':
+            case 'i': {
+                errno = 0;
+                const u32 value = strtoul(optarg, &endarg, 0);
+                if (endarg == optarg || value == 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror(arg == 'n' ? "--frames" : "--dump-interval");
+                    exit(1);
+                }
+                if (arg == 'n')
+                    exit_after_frames = value;
+                else
+                    frame_dump_interval = value;
+                break;
+            }
+            case 'd':
+                frame_dump_directory = optarg;
+                break;
+            case 'm':
+                movie_path = optarg;
+                break;
+            case 'b':
+                benchmark_report_path = optarg;
+                headless = true;
+                break;
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
@@ -98,9 +232,9 @@ int main(int argc, char** argv) {
             }
         } else {
 #ifdef _WIN32
-            filepath = Common::UTF16ToUTF8(argv_w[optind]);
+            filepaths.push_back(Common::UTF16ToUTF8(argv_w[optind]));
 #else
-            filepath = argv[optind];
+            filepaths.push_back(argv[optind]);
 #endif
             optind++;
         }
@@ -112,62 +246,124 @@ int main(int argc, char** argv) {
 
     Log::Filter log_filter(Log::Level::Debug);
     Log::SetFilter(&log_filter);
+    Log::SetLogFile(FileUtil::GetUserPath(D_USER_IDX) + "citra_log.txt");
 
     MicroProfileOnThreadCreate("EmuThread");
     SCOPE_EXIT({ MicroProfileShutdown(); });
 
-    if (filepath.empty()) {
+#ifdef ENABLE_WEB_SERVICE
+    // Stopped after the emulated system, which posts its telemetry when it shuts down
+    WebService::Init();
+    SCOPE_EXIT({ WebService::Shutdown(); });
+#endif
+
+    if (filepaths.empty()) {
         LOG_CRITICAL(Frontend, "Failed to load ROM: No ROM specified");
         return -1;
     }
+    const bool batch = filepaths.size() > 1;
+    if (batch && exit_after_frames == 0) {
+        LOG_CRITICAL(Frontend, "Running several files needs --frames");
+        return -1;
+    }
+    const bool benchmark = !benchmark_report_path.empty();
+    if (benchmark && exit_after_frames == 0) {
+        LOG_CRITICAL(Frontend, "Benchmarking needs --frames");
+        return -1;
+    }
 
     log_filter.ParseFilterString(Settings::values.log_filter);
 
     // Apply the command line arguments
     Settings::values.gdbstub_port = gdb_port;
     Settings::values.use_gdbstub = use_gdbstub;
+    if (!movie_path.empty())
+        Settings::values.movie_play_path = movie_path;
+    if (headless) {
+        // Nobody is watching or listening, so run as fast as the host allows
+        Settings::values.use_vsync = false;
+        Settings::values.toggle_framelimit = false;
+        Settings::values.sink_id = "null";
+    }
+    if (headless || !frame_dump_directory.empty()) {
+        // Frames are only drawn into the window's dump framebuffer without the presentation
+        // thread
+        Settings::values.use_presentation_thread = false;
+    }
     Settings::Apply();
 
-    std::unique_ptr<EmuWindow_SDL2> emu_window{std::make_unique<EmuWindow_SDL2>()};
-
+    std::unique_ptr<EmuWindow_SDL2> emu_window{std::make_unique<EmuWindow_SDL2>(headless)};
     Core::System& system{Core::System::GetInstance()};
 
-    SCOPE_EXIT({ system.Shutdown(); });
+    // The window and its GL context are kept from one file to the next, only the emulated system
+    // is booted anew
+    int result = 0;
+    std::vector<std::string> benchmark_runs;
+    for (size_t i = 0; i < filepaths.size(); ++i) {
+        const std::string& filepath = filepaths[i];
+        if (batch && !frame_dump_directory.empty()) {
+            emu_window->SetFrameDump(frame_dump_directory + DIR_SEP + std::to_string(i),
+                                     frame_dump_interval);
+        } else {
+            emu_window->SetFrameDump(frame_dump_directory, frame_dump_interval);
+        }
+        emu_window->SetExitAfterFrames(exit_after_frames);
+        // Only closing the window stops the frame count from reopening it
+        if (!emu_window->IsOpen())
+            break;
 
-    const Core::System::ResultStatus load_result{system.Load(emu_window.get(), filepath)};
+        const auto start = std::chrono::steady_clock::now();
+        if (!BootFile(system, emu_window.get(), filepath)) {
+            result = -1;
+            if (batch)
+                LOG_ERROR(Frontend, "%s: failed to boot", filepath.c_str());
+            if (benchmark) {
+                benchmark_runs.push_back("{\"file\": " + QuoteJson(filepath) +
+                                         ", \"booted\": false}");
+            }
+            continue;
+        }
 
-    switch (load_result) {
-    case Core::System::ResultStatus::ErrorGetLoader:
-        LOG_CRITICAL(Frontend, "Failed to obtain loader for %s!", filepath.c_str());
-        return -1;
-    case Core::System::ResultStatus::ErrorLoader:
-        LOG_CRITICAL(Frontend, "Failed to load ROM!");
-        return -1;
-    case Core::System::ResultStatus::ErrorLoader_ErrorEncrypted:
-        LOG_CRITICAL(Frontend, "The game that you are trying to load must be decrypted before "
-                               "being used with Citra. \n\n For more information on dumping and "
-                               "decrypting games, please refer to: "
-                               "https://citra-emu.org/wiki/dumping-game-cartridges/");
-        return -1;
-    case Core::System::ResultStatus::ErrorLoader_ErrorInvalidFormat:
-        LOG_CRITICAL(Frontend, "Error while loading ROM: The ROM format is not supported.");
-        return -1;
-    case Core::System::ResultStatus::ErrorNotInitialized:
-        LOG_CRITICAL(Frontend, "CPUCore not initialized");
-        return -1;
-    case Core::System::ResultStatus::ErrorSystemMode:
-        LOG_CRITICAL(Frontend, "Failed to determine system mode!");
-        return -1;
-    case Core::System::ResultStatus::ErrorVideoCore:
-        LOG_CRITICAL(Frontend, "VideoCore not initialized");
-        return -1;
-    case Core::System::ResultStatus::Success:
-        break; // Expected case
+        while (emu_window->IsOpen()) {
+            system.RunLoop();
+        }
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (benchmark) {
+            // The stats were reset at boot, so they cover the whole run
+            const auto stats = system.GetAndResetPerfStats();
+            benchmark_runs.push_back(Common::StringFromFormat(
+                "{\"file\": %s, \"booted\": true, \"frames\": %u, \"seconds\": %f, "
+                "\"peak_rss_bytes\": %llu, \"stats\": %s}",
+                QuoteJson(filepath).c_str(), exit_after_frames, seconds,
+                static_cast<unsigned long long>(GetPeakResidentSetSize()),
+                Core::PerfStats::FormatJson(stats).c_str()));
+        }
+        system.Shutdown();
+
+        if (batch) {
+            LOG_INFO(Frontend, "%s: %u frames in %f s", filepath.c_str(), exit_after_frames,
+                     seconds);
+        }
     }
 
-    while (emu_window->IsOpen()) {
-        system.RunLoop();
+    if (benchmark) {
+        std::string report = "{\"build\": " + QuoteJson(Common::g_scm_desc) +
+                             ", \"branch\": " + QuoteJson(Common::g_scm_branch) + ", \"runs\": [";
+        for (size_t i = 0; i < benchmark_runs.size(); ++i) {
+            report += i == 0 ? "\n  " : ",\n  ";
+            report += benchmark_runs[i];
+        }
+        report += "\n]}\n";
+
+        FileUtil::IOFile report_file(benchmark_report_path, "w");
+        if (!report_file.IsOpen() ||
+            report_file.WriteBytes(report.data(), report.size()) != report.size()) {
+            LOG_CRITICAL(Frontend, "Could not write the benchmark report to %s",
+                         benchmark_report_path.c_str());
+            return -1;
+        }
     }
 
-    return 0;
+    return result;
 }
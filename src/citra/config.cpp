@@ -78,6 +78,11 @@ void Config::ReadValues() {
 
     // Core
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
+    Settings::values.cpu_max_slice_length =
+        sdl2_config->GetInteger("Core", "cpu_max_slice_length", 20000);
+    Settings::values.share_code_pages = sdl2_config->GetBoolean("Core", "share_code_pages", false);
+    Settings::values.use_disk_block_cache =
+        sdl2_config->GetBoolean("Core", "use_disk_block_cache", false);
 
     // Renderer
     Settings::values.use_hw_renderer = sdl2_config->GetBoolean("Renderer", "use_hw_renderer", true);
@@ -87,6 +92,38 @@ void Config::ReadValues() {
     Settings::values.use_vsync = sdl2_config->GetBoolean("Renderer", "use_vsync", false);
     Settings::values.toggle_framelimit =
         sdl2_config->GetBoolean("Renderer", "toggle_framelimit", true);
+    Settings::values.frame_limit_spin_us =
+        sdl2_config->GetInteger("Renderer", "frame_limit_spin_us", 0);
+    Settings::values.turbo_frame_skip = sdl2_config->GetInteger("Renderer", "turbo_frame_skip", 1);
+    Settings::values.frame_skip = sdl2_config->GetInteger("Renderer", "frame_skip", 0);
+    Settings::values.use_surface_page_index =
+        sdl2_config->GetBoolean("Renderer", "use_surface_page_index", true);
+    Settings::values.surface_texture_pool_size =
+        sdl2_config->GetInteger("Renderer", "surface_texture_pool_size", 64);
+    Settings::values.use_gpu_surface_untiling =
+        sdl2_config->GetBoolean("Renderer", "use_gpu_surface_untiling", true);
+    Settings::values.use_surface_preloading =
+        sdl2_config->GetBoolean("Renderer", "use_surface_preloading", false);
+    Settings::values.use_shared_surface_textures =
+        sdl2_config->GetBoolean("Renderer", "use_shared_surface_textures", false);
+    Settings::values.use_hw_shader = sdl2_config->GetBoolean("Renderer", "use_hw_shader", false);
+    Settings::values.use_disk_shader_cache =
+        sdl2_config->GetBoolean("Renderer", "use_disk_shader_cache", true);
+    Settings::values.use_async_shader_compile =
+        sdl2_config->GetBoolean("Renderer", "use_async_shader_compile", false);
+    Settings::values.use_ubershader = sdl2_config->GetBoolean("Renderer", "use_ubershader", false);
+    Settings::values.vertex_cache_size =
+        sdl2_config->GetInteger("Renderer", "vertex_cache_size", 16384);
+    Settings::values.use_multithreaded_vertex_shading =
+        sdl2_config->GetBoolean("Renderer", "use_multithreaded_vertex_shading", true);
+    Settings::values.use_vertex_loader_jit =
+        sdl2_config->GetBoolean("Renderer", "use_vertex_loader_jit", true);
+    Settings::values.use_multithreaded_sw_rasterizer =
+        sdl2_config->GetBoolean("Renderer", "use_multithreaded_sw_rasterizer", true);
+    Settings::values.use_gpu_thread = sdl2_config->GetBoolean("Renderer", "use_gpu_thread", false);
+    Settings::values.use_presentation_thread =
+        sdl2_config->GetBoolean("Renderer", "use_presentation_thread", false);
+    Settings::values.frame_dump_path = sdl2_config->Get("Renderer", "frame_dump_path", "");
 
     Settings::values.bg_red = (float)sdl2_config->GetReal("Renderer", "bg_red", 0.0);
     Settings::values.bg_green = (float)sdl2_config->GetReal("Renderer", "bg_green", 0.0);
@@ -118,11 +155,20 @@ void Config::ReadValues() {
     Settings::values.sink_id = sdl2_config->Get("Audio", "output_engine", "auto");
     Settings::values.enable_audio_stretching =
         sdl2_config->GetBoolean("Audio", "enable_audio_stretching", true);
+    Settings::values.audio_latency =
+        static_cast<u16>(sdl2_config->GetInteger("Audio", "audio_latency", 50));
+    Settings::values.use_audio_thread =
+        sdl2_config->GetBoolean("Audio", "use_audio_thread", false);
     Settings::values.audio_device_id = sdl2_config->Get("Audio", "output_device", "auto");
+    Settings::values.audio_dump_path = sdl2_config->Get("Audio", "audio_dump_path", "");
 
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.use_async_fs_reads =
+        sdl2_config->GetBoolean("Data Storage", "use_async_fs_reads", true);
+    Settings::values.deterministic_fs_reads =
+        sdl2_config->GetBoolean("Data Storage", "deterministic_fs_reads", false);
 
     // System
     Settings::values.is_new_3ds = sdl2_config->GetBoolean("System", "is_new_3ds", false);
@@ -151,6 +197,16 @@ void Config::ReadValues() {
     Settings::values.use_gdbstub = sdl2_config->GetBoolean("Debugging", "use_gdbstub", false);
     Settings::values.gdbstub_port =
         static_cast<u16>(sdl2_config->GetInteger("Debugging", "gdbstub_port", 24689));
+    Settings::values.perf_stats_csv_path =
+        sdl2_config->Get("Debugging", "perf_stats_csv_path", "");
+    Settings::values.use_gpu_timer_queries =
+        sdl2_config->GetBoolean("Debugging", "use_gpu_timer_queries", false);
+    Settings::values.trace_capture_frames =
+        static_cast<u32>(sdl2_config->GetInteger("Debugging", "trace_capture_frames", 0));
+    Settings::values.trace_capture_path = sdl2_config->Get("Debugging", "trace_capture_path", "");
+    Settings::values.guest_profile_path = sdl2_config->Get("Debugging", "guest_profile_path", "");
+    Settings::values.movie_record_path = sdl2_config->Get("Debugging", "movie_record_path", "");
+    Settings::values.movie_play_path = sdl2_config->Get("Debugging", "movie_play_path", "");
 
     // Web Service
     Settings::values.telemetry_endpoint_url = sdl2_config->Get(
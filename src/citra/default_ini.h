@@ -61,6 +61,21 @@ c_stick=
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Maximum number of cycles the CPU runs before returning to the emulation loop, when no event is
+# due sooner. Larger slices are faster, mostly with the JIT, but make the frontend less responsive.
+# (default: 20000)
+cpu_max_slice_length =
+
+# Whether to map the code of titles from a copy in the cache directory. Instances of the emulator
+# running the same title then share the memory holding its code.
+# 0 (default): No, 1: Yes
+share_code_pages =
+
+# Whether the interpreter records the code blocks it translates in the cache directory, and
+# translates them ahead of time while the title idles when it boots again. Unused by the JIT.
+# 0 (default): No, 1: Yes
+use_disk_block_cache =
+
 [Renderer]
 # Whether to use software or hardware rendering.
 # 0: Software, 1 (default): Hardware
@@ -75,6 +90,100 @@ use_shader_jit =
 # factor for the 3DS resolution
 resolution_factor =
 
+# Which data structure the hardware renderer uses to look up cached surfaces. Mainly useful for
+# comparing their cost in microprofile ("Surface Lookup").
+# 0: Interval map, 1 (default): Page-bucketed index
+use_surface_page_index =
+
+# How many textures of destroyed surfaces the hardware renderer keeps around for reuse
+# 0: Don't reuse textures, otherwise the maximum number of kept textures (default: 64)
+surface_texture_pool_size =
+
+# Whether the hardware renderer untiles color surfaces loaded from memory on the GPU
+# 0: Decode them on the CPU, 1 (default): Untile them with a shader when supported
+use_gpu_surface_untiling =
+
+# Whether the hardware renderer reloads textures in the background when a game flushes the data
+# cache over their memory, on a second context shared with the renderer's
+# 0 (default): Load them when they are next used, 1: Preload them on a worker thread
+use_surface_preloading =
+
+# Whether the hardware renderer decodes and uploads surfaces loaded from identical data only once,
+# sharing the texture between them until one of them is written to
+# 0 (default): Give every surface its own texture, 1: Share textures between identical surfaces
+use_shared_surface_textures =
+
+# Whether the hardware renderer runs vertex shaders on the GPU when it can translate them
+# 0 (default): Run them on the CPU, 1: Translate them to GLSL, falling back to the CPU otherwise
+use_hw_shader =
+
+# Whether the shader programs built for a game are stored on disk and loaded back on the next run.
+# Covers the programs of the hardware renderer, per driver, and the PICA programs of the shader JIT.
+# 0: Build all shaders at runtime, 1 (default): Keep a shader cache
+use_disk_shader_cache =
+
+# Whether the hardware renderer builds new shader programs on a background thread. Draws needing a
+# program that isn't ready yet use the slower ubershader in the meantime.
+# 0 (default): Build them when needed, 1: Build them in the background
+use_async_shader_compile =
+
+# Whether the hardware renderer emulates all fragment pipeline states with a single ubershader
+# instead of building a program for each of them. Avoids shader compilation stutter, but costs
+# fragment shading performance.
+# 0 (default): Build specialized programs, 1: Use the ubershader
+use_ubershader =
+
+# Number of shaded vertices kept around by the software vertex shader path for reuse within an
+# indexed draw. Draws whose index range fits don't shade any vertex twice.
+# 0: Don't reuse vertices, otherwise the maximum number of kept vertices (default: 16384)
+vertex_cache_size =
+
+# Whether the software vertex shader path splits large draws across all host CPU cores
+# 0: Shade on the emulation thread only, 1 (default): Use all cores
+use_multithreaded_vertex_shading =
+
+# Whether the software vertex shader path compiles the vertex attribute layouts of draws to x86_64
+# code, or converts the attributes through generic routines
+# 0: Generic routines, 1 (default): Compiled code
+use_vertex_loader_jit =
+
+# Whether the software renderer sorts the triangles of each draw into screen tiles and rasterizes
+# the tiles on all host CPU cores
+# 0: Rasterize on the emulation thread only, 1 (default): Use all cores
+use_multithreaded_sw_rasterizer =
+
+# Whether the work of the emulated GPU runs on a dedicated thread, overlapping it with the emulation
+# of the CPU. The hardware renderer then makes the GL calls of emulated draws from that thread too.
+# 0 (default): Emulation thread, 1: Dedicated thread
+use_gpu_thread =
+
+# Whether frames are presented from a thread of their own, so that waiting for V-Sync doesn't hold
+# up emulation
+# 0 (default): Emulation thread, 1: Dedicated thread
+use_presentation_thread =
+
+# File to write the frames to, as uncompressed YUV4MPEG2 video at 60 frames per second with both
+# screens at their native resolution. The audio can be dumped alongside with output_engine = wav,
+# which also keeps the frame limiter from dropping or repeating frames.
+# (default): Don't dump frames
+frame_dump_path =
+
+# How long before the end of a frame, in microseconds, the frame limiter stops sleeping and spins
+# instead, since sleeps may overshoot by a millisecond or more. Spinning keeps a CPU core busy.
+# 0 (default): Only sleep, 2000: Spin for the last 2 ms
+frame_limit_spin_us =
+
+# In turbo mode, which runs without the frame limiter, only present every Nth frame. Skipped frames
+# aren't read back from emulated memory either, which saves the time to flush them.
+# 1 (default): Present every frame, 4: Present one frame in four
+turbo_frame_skip =
+
+# Most frames in a row to skip while emulation is slower than the frame limiter allows. Draws of
+# skipped frames are dropped, except into surfaces the CPU has read back, and the frames aren't
+# presented. Only the OpenGL rasterizer supports this.
+# 0 (default): Never skip frames, 2: Skip up to two frames in a row
+frame_skip =
+
 # Whether to enable V-Sync (caps the framerate at 60FPS) or not.
 # 0 (default): Off, 1: On
 use_vsync =
@@ -116,7 +225,9 @@ swap_screen =
 
 [Audio]
 # Which audio output engine to use.
-# auto (default): Auto-select, null: No audio output, sdl2: SDL2 (if available)
+# auto (default): Auto-select, null: No audio output, sdl2: SDL2 (if available),
+# wav: Write the audio to the file set in audio_dump_path. Time stretching and the frame limiter are
+# bypassed, so emulation runs as fast as it can.
 output_engine =
 
 # Whether or not to enable the audio-stretching post-processing effect.
@@ -125,15 +236,37 @@ output_engine =
 # 0: No, 1 (default): Yes
 enable_audio_stretching =
 
+# Target audio output latency in milliseconds, including the output device's own buffering.
+# Lower values reduce audio lag but may cause crackling when the host is busy.
+# 50 (default)
+audio_latency =
+
+# Whether the HLE DSP decodes and mixes audio frames on a dedicated thread, overlapping it with the
+# emulation of the CPU. The DSP then reads its configuration half a frame before the frame ends.
+# 0 (default): Emulation thread, 1: Dedicated thread
+use_audio_thread =
+
 # Which audio device to use.
 # auto (default): Auto-select
 output_device =
 
+# File the wav output engine writes to. Empty (default) for audio_dump.wav in the user directory.
+audio_dump_path =
+
 [Data Storage]
 # Whether to create a virtual SD card.
 # 1 (default): Yes, 0: No
 use_virtual_sd =
 
+# Whether large file reads are done on background threads while the game thread waits
+# 1 (default): Yes, 0: No
+use_async_fs_reads =
+
+# Whether background file reads take an emulated time that only depends on their size, so that
+# the emulation doesn't depend on the speed of the host storage
+# 0 (default): No, 1: Yes
+deterministic_fs_reads =
+
 [System]
 # The system model that Citra will try to emulate
 # 0: Old 3DS (default), 1: New 3DS
@@ -162,12 +295,34 @@ camera_inner_config =
 [Miscellaneous]
 # A filter which removes logs below a certain logging level.
 # Examples: *:Debug Kernel.SVC:Trace Service.*:Critical
+# Trace and Debug messages are only compiled into debug builds, unless the build sets
+# CITRA_LOG_MIN_LEVEL lower.
 log_filter = *:Info
 
 [Debugging]
 # Port for listening to GDB connections.
 use_gdbstub=false
 gdbstub_port=24689
+# File the performance stats are appended to, as comma separated values, each time the frontend
+# collects them. Empty (default) to not write them anywhere.
+perf_stats_csv_path =
+# Whether to measure the GPU time of draws, surface transfers and presentation with timer queries,
+# for the performance stats. 0 (default): No, 1: Yes
+use_gpu_timer_queries = 0
+# Number of frames to record the profiler scopes of after booting, on all threads, then write to a
+# trace file that chrome://tracing can open. 0 (default) to not record any.
+trace_capture_frames = 0
+# File the trace is written to. Empty (default) for citra_trace.json in the user directory.
+trace_capture_path =
+# File to write a sampled profile of the emulated application to on shutdown, in the collapsed
+# stack format of flamegraph.pl. Empty (default) to not profile it.
+guest_profile_path =
+# File to record the input of the emulated application to, as a movie that can be played back to
+# repeat the run exactly. Empty (default) to not record one.
+movie_record_path =
+# Movie to play the input of back, instead of taking it from the input devices. Takes precedence
+# over recording. Empty (default) to not play one back.
+movie_play_path =
 
 [WebService]
 # Endpoint URL for submitting telemetry data
@@ -5,10 +5,13 @@
 #include <algorithm>
 #include <cstdlib>
 #include <string>
+#include <vector>
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 #include <glad/glad.h>
 #include "citra/emu_window/emu_window_sdl2.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/scm_rev.h"
 #include "common/string_util.h"
@@ -48,7 +51,7 @@ void EmuWindow_SDL2::OnKeyEvent(int key, u8 state) {
 }
 
 bool EmuWindow_SDL2::IsOpen() const {
-    return is_open;
+    return is_open && (exit_after_frames == 0 || frame_count < exit_after_frames);
 }
 
 void EmuWindow_SDL2::OnResize() {
@@ -57,7 +60,7 @@ void EmuWindow_SDL2::OnResize() {
     UpdateCurrentFramebufferLayout(width, height);
 }
 
-EmuWindow_SDL2::EmuWindow_SDL2() {
+EmuWindow_SDL2::EmuWindow_SDL2(bool headless) : headless(headless) {
     InputCommon::Init();
     Network::Init();
 
@@ -87,7 +90,8 @@ EmuWindow_SDL2::EmuWindow_SDL2() {
                          SDL_WINDOWPOS_UNDEFINED, // x position
                          SDL_WINDOWPOS_UNDEFINED, // y position
                          Core::kScreenTopWidth, Core::kScreenTopHeight + Core::kScreenBottomHeight,
-                         SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+                         SDL_WINDOW_OPENGL | SDL_WINDOW_ALLOW_HIGHDPI |
+                             (headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_RESIZABLE));
 
     if (render_window == nullptr) {
         LOG_CRITICAL(Frontend, "Failed to create SDL2 window! Exiting...");
@@ -109,12 +113,18 @@ EmuWindow_SDL2::EmuWindow_SDL2() {
     OnResize();
     OnMinimalClientAreaChangeRequest(GetActiveConfig().min_client_area_size);
     SDL_PumpEvents();
-    SDL_GL_SetSwapInterval(Settings::values.use_vsync);
+    SDL_GL_SetSwapInterval(headless ? 0 : Settings::values.use_vsync);
 
     DoneCurrent();
 }
 
 EmuWindow_SDL2::~EmuWindow_SDL2() {
+    if (dump_framebuffer != 0) {
+        MakeCurrent();
+        glDeleteFramebuffers(1, &dump_framebuffer);
+        glDeleteRenderbuffers(1, &dump_renderbuffer);
+        DoneCurrent();
+    }
     SDL_GL_DeleteContext(gl_context);
     SDL_Quit();
     motion_emu = nullptr;
@@ -123,8 +133,97 @@ EmuWindow_SDL2::~EmuWindow_SDL2() {
     InputCommon::Shutdown();
 }
 
+void EmuWindow_SDL2::SetExitAfterFrames(u32 frames) {
+    exit_after_frames = frames;
+    frame_count = 0;
+}
+
+void EmuWindow_SDL2::SetFrameDump(const std::string& directory, u32 interval) {
+    frame_dump_directory = directory;
+    frame_dump_interval = std::max(interval, 1u);
+    if (!frame_dump_directory.empty())
+        FileUtil::CreateFullPath(frame_dump_directory + DIR_SEP);
+}
+
+u32 EmuWindow_SDL2::GetDrawFramebuffer() {
+    if (frame_dump_directory.empty())
+        return 0;
+
+    const auto& layout = GetFramebufferLayout();
+    if (dump_framebuffer == 0) {
+        glGenFramebuffers(1, &dump_framebuffer);
+        glGenRenderbuffers(1, &dump_renderbuffer);
+    }
+    if (dump_width != layout.width || dump_height != layout.height) {
+        GLint renderbuffer, draw_framebuffer;
+        glGetIntegerv(GL_RENDERBUFFER_BINDING, &renderbuffer);
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &draw_framebuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, dump_renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB8, layout.width, layout.height);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dump_framebuffer);
+        glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                                  dump_renderbuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw_framebuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        dump_width = layout.width;
+        dump_height = layout.height;
+    }
+    return dump_framebuffer;
+}
+
+void EmuWindow_SDL2::DumpFrame() {
+    const size_t row_size = dump_width * 3;
+    std::vector<u8> pixels(row_size * dump_height);
+
+    GLint read_framebuffer, pack_buffer;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &pack_buffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, dump_framebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, dump_width, dump_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pack_buffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+
+    const std::string path =
+        Common::StringFromFormat("%s/frame_%06u.ppm", frame_dump_directory.c_str(), frame_count);
+    FileUtil::IOFile file(path, "wb");
+    const std::string header =
+        Common::StringFromFormat("P6\n%u %u\n255\n", dump_width, dump_height);
+    bool written = file.IsOpen() && file.WriteBytes(header.data(), header.size()) == header.size();
+    // GL reads the image bottom row first
+    for (size_t row = dump_height; written && row-- > 0;)
+        written = file.WriteBytes(pixels.data() + row * row_size, row_size) == row_size;
+    if (!written) {
+        LOG_ERROR(Frontend, "Could not write frame %u to %s", frame_count, path.c_str());
+        frame_dump_directory.clear();
+    }
+}
+
 void EmuWindow_SDL2::SwapBuffers() {
-    SDL_GL_SwapWindow(render_window);
+    // Frames are only drawn into the dump framebuffer once GetDrawFramebuffer has created it
+    const bool dumping = !frame_dump_directory.empty() && dump_framebuffer != 0;
+    if (dumping && frame_count % frame_dump_interval == 0)
+        DumpFrame();
+
+    if (!headless) {
+        if (dumping) {
+            GLint read_framebuffer, draw_framebuffer;
+            glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+            glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &draw_framebuffer);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, dump_framebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, dump_width, dump_height, 0, 0, dump_width, dump_height,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw_framebuffer);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+        }
+        SDL_GL_SwapWindow(render_window);
+    }
+
+    ++frame_count;
 }
 
 void EmuWindow_SDL2::PollEvents() {
@@ -173,6 +272,59 @@ void EmuWindow_SDL2::DoneCurrent() {
     SDL_GL_MakeCurrent(render_window, nullptr);
 }
 
+class SDLGLContext : public EmuWindow::GraphicsContext {
+public:
+    SDLGLContext(SDL_Window* window, SDL_GLContext context) : window(window), context(context) {}
+
+    ~SDLGLContext() override {
+        SDL_GL_DeleteContext(context);
+    }
+
+    void MakeCurrent() override {
+        SDL_GL_MakeCurrent(window, context);
+    }
+
+    void DoneCurrent() override {
+        SDL_GL_MakeCurrent(window, nullptr);
+    }
+
+private:
+    SDL_Window* window;
+    SDL_GLContext context;
+};
+
+std::unique_ptr<EmuWindow::GraphicsContext> EmuWindow_SDL2::CreateSharedContext() const {
+    // The caller may be a thread with a shared context of its own current, such as the GPU thread
+    SDL_GLContext current_context = SDL_GL_GetCurrentContext();
+
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    SDL_GLContext context = SDL_GL_CreateContext(render_window);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+
+    // SDL makes the new context current, so give the caller its context back
+    SDL_GL_MakeCurrent(render_window, current_context);
+
+    if (context == nullptr) {
+        LOG_ERROR(Frontend, "Failed to create shared SDL2 GL context: %s", SDL_GetError());
+        return nullptr;
+    }
+    return std::make_unique<SDLGLContext>(render_window, context);
+}
+
+std::unique_ptr<EmuWindow::GraphicsContext> EmuWindow_SDL2::CreatePresentationContext() const {
+    // Shared contexts are made current on the window, so they can present to it as well
+    auto context = CreateSharedContext();
+    if (context == nullptr) {
+        return nullptr;
+    }
+
+    // The swap interval belongs to the context that swaps
+    context->MakeCurrent();
+    SDL_GL_SetSwapInterval(headless ? 0 : Settings::values.use_vsync);
+    SDL_GL_MakeCurrent(render_window, gl_context);
+    return context;
+}
+
 void EmuWindow_SDL2::OnMinimalClientAreaChangeRequest(
     const std::pair<unsigned, unsigned>& minimal_size) {
 
@@ -4,8 +4,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <string>
 #include <utility>
+#include "common/common_types.h"
 #include "core/frontend/emu_window.h"
 #include "core/frontend/motion_emu.h"
 
@@ -13,7 +16,11 @@ struct SDL_Window;
 
 class EmuWindow_SDL2 : public EmuWindow {
 public:
-    EmuWindow_SDL2();
+    /**
+     * @param headless Keep the window hidden and never present to it, for running without a
+     * display to look at
+     */
+    explicit EmuWindow_SDL2(bool headless = false);
     ~EmuWindow_SDL2();
 
     /// Swap buffers to display the next frame
@@ -28,9 +35,31 @@ public:
     /// Releases the GL context from the caller thread
     void DoneCurrent() override;
 
+    /// Creates a GL context sharing objects with the window's one
+    std::unique_ptr<GraphicsContext> CreateSharedContext() const override;
+
+    /// Creates a shared GL context that presents to the window from another thread
+    std::unique_ptr<GraphicsContext> CreatePresentationContext() const override;
+
+    /// Returns the framebuffer frames are dumped from while dumping, or 0 for the window's one
+    u32 GetDrawFramebuffer() override;
+
     /// Whether the window is still open, and a close request hasn't yet been sent
     bool IsOpen() const;
 
+    /**
+     * Closes the window once `frames` frames have been swapped from now on, or never if it is 0.
+     * A window closed that way opens again when this is called anew.
+     */
+    void SetExitAfterFrames(u32 frames);
+
+    /**
+     * Writes every `interval`th frame to `directory` as a PPM image. While dumping, frames are
+     * drawn into a framebuffer object of the window's size and read back from there, then copied
+     * to the window unless it is headless. Needs the presentation thread to be disabled.
+     */
+    void SetFrameDump(const std::string& directory, u32 interval);
+
 private:
     /// Called by PollEvents when a key is pressed or released.
     void OnKeyEvent(int key, u8 state);
@@ -48,8 +77,28 @@ private:
     void OnMinimalClientAreaChangeRequest(
         const std::pair<unsigned, unsigned>& minimal_size) override;
 
-    /// Is the window still open?
-    bool is_open = true;
+    /// Reads the frame drawn into the dump framebuffer back and writes it to the dump directory
+    void DumpFrame();
+
+    /// Whether the window hasn't been closed by the user
+    std::atomic<bool> is_open{true};
+
+    /// Whether the window is hidden and swaps are skipped
+    bool headless;
+
+    /// Frames swapped so far, and the count after which the window closes (0 for never)
+    u32 frame_count = 0;
+    u32 exit_after_frames = 0;
+
+    /// Where frames are dumped to, if anywhere, and how many frames apart
+    std::string frame_dump_directory;
+    u32 frame_dump_interval = 1;
+
+    /// Framebuffer the frames are drawn into while dumping, and the size of its color buffer
+    u32 dump_framebuffer = 0;
+    u32 dump_renderbuffer = 0;
+    unsigned dump_width = 0;
+    unsigned dump_height = 0;
 
     /// Internal SDL2 render window
     SDL_Window* render_window;
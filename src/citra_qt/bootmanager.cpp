@@ -3,6 +3,7 @@
 #include <QKeyEvent>
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#include <QOpenGLContext>
 // Required for screen DPI information
 #include <QScreen>
 #include <QWindow>
@@ -153,6 +154,50 @@ void GRenderWindow::DoneCurrent() {
 
 void GRenderWindow::PollEvents() {}
 
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+class GGLContext : public EmuWindow::GraphicsContext {
+public:
+    GGLContext(QOpenGLContext* shared_context, QOffscreenSurface* surface)
+        : shared_context(shared_context), surface(surface) {}
+
+    void MakeCurrent() override {
+        // Qt contexts can only be made current on the thread they belong to, so the context is
+        // created by the thread that uses it
+        if (context == nullptr) {
+            context = std::make_unique<QOpenGLContext>();
+            context->setFormat(shared_context->format());
+            context->setShareContext(shared_context);
+            context->create();
+        }
+        context->makeCurrent(surface);
+    }
+
+    void DoneCurrent() override {
+        // The context is destroyed here rather than along with this object, as that usually
+        // happens on another thread once the one using the context has finished
+        if (context != nullptr) {
+            context->doneCurrent();
+            context.reset();
+        }
+    }
+
+private:
+    QOpenGLContext* shared_context;
+    QOffscreenSurface* surface;
+    std::unique_ptr<QOpenGLContext> context;
+};
+#endif
+
+std::unique_ptr<EmuWindow::GraphicsContext> GRenderWindow::CreateSharedContext() const {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    if (shared_context_surface != nullptr && shared_context_surface->isValid()) {
+        return std::make_unique<GGLContext>(child->context()->contextHandle(),
+                                            shared_context_surface.get());
+    }
+#endif
+    return nullptr;
+}
+
 // On Qt 5.0+, this correctly gets the size of the framebuffer (pixels).
 //
 // Older versions get the window size (density independent pixels),
@@ -271,6 +316,12 @@ void GRenderWindow::InitRenderTarget() {
     child = new GGLWidgetInternal(fmt, this);
     QBoxLayout* layout = new QHBoxLayout(this);
 
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    shared_context_surface = std::make_unique<QOffscreenSurface>();
+    shared_context_surface->setFormat(child->context()->contextHandle()->format());
+    shared_context_surface->create();
+#endif
+
     resize(Core::kScreenTopWidth, Core::kScreenTopHeight + Core::kScreenBottomHeight);
     layout->addWidget(child);
     layout->setMargin(0);
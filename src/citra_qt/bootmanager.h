@@ -9,6 +9,9 @@
 #include <mutex>
 #include <QGLWidget>
 #include <QThread>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#include <QOffscreenSurface>
+#endif
 #include "common/thread.h"
 #include "core/core.h"
 #include "core/frontend/emu_window.h"
@@ -114,6 +117,7 @@ public:
     void MakeCurrent() override;
     void DoneCurrent() override;
     void PollEvents() override;
+    std::unique_ptr<GraphicsContext> CreateSharedContext() const override;
 
     void BackupGeometry();
     void RestoreGeometry();
@@ -154,6 +158,12 @@ private:
 
     GGLWidgetInternal* child;
 
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    /// Surface for shared contexts to be made current on. It has to be created on the GUI thread,
+    /// unlike the contexts themselves.
+    std::unique_ptr<QOffscreenSurface> shared_context_surface;
+#endif
+
     QByteArray geometry;
 
     EmuThread* emu_thread;
@@ -61,6 +61,11 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Core");
     Settings::values.use_cpu_jit = qt_config->value("use_cpu_jit", true).toBool();
+    Settings::values.cpu_max_slice_length =
+        qt_config->value("cpu_max_slice_length", 20000).toInt();
+    Settings::values.share_code_pages = qt_config->value("share_code_pages", false).toBool();
+    Settings::values.use_disk_block_cache =
+        qt_config->value("use_disk_block_cache", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
@@ -69,6 +74,37 @@ void Config::ReadValues() {
     Settings::values.resolution_factor = qt_config->value("resolution_factor", 1.0).toFloat();
     Settings::values.use_vsync = qt_config->value("use_vsync", false).toBool();
     Settings::values.toggle_framelimit = qt_config->value("toggle_framelimit", true).toBool();
+    Settings::values.frame_limit_spin_us = qt_config->value("frame_limit_spin_us", 0).toInt();
+    Settings::values.turbo_frame_skip = qt_config->value("turbo_frame_skip", 1).toInt();
+    Settings::values.frame_skip = qt_config->value("frame_skip", 0).toInt();
+    Settings::values.use_surface_page_index =
+        qt_config->value("use_surface_page_index", true).toBool();
+    Settings::values.surface_texture_pool_size =
+        qt_config->value("surface_texture_pool_size", 64).toInt();
+    Settings::values.use_gpu_surface_untiling =
+        qt_config->value("use_gpu_surface_untiling", true).toBool();
+    Settings::values.use_surface_preloading =
+        qt_config->value("use_surface_preloading", false).toBool();
+    Settings::values.use_shared_surface_textures =
+        qt_config->value("use_shared_surface_textures", false).toBool();
+    Settings::values.use_hw_shader = qt_config->value("use_hw_shader", false).toBool();
+    Settings::values.use_disk_shader_cache =
+        qt_config->value("use_disk_shader_cache", true).toBool();
+    Settings::values.use_async_shader_compile =
+        qt_config->value("use_async_shader_compile", false).toBool();
+    Settings::values.use_ubershader = qt_config->value("use_ubershader", false).toBool();
+    Settings::values.vertex_cache_size = qt_config->value("vertex_cache_size", 16384).toInt();
+    Settings::values.use_multithreaded_vertex_shading =
+        qt_config->value("use_multithreaded_vertex_shading", true).toBool();
+    Settings::values.use_vertex_loader_jit =
+        qt_config->value("use_vertex_loader_jit", true).toBool();
+    Settings::values.use_multithreaded_sw_rasterizer =
+        qt_config->value("use_multithreaded_sw_rasterizer", true).toBool();
+    Settings::values.use_gpu_thread = qt_config->value("use_gpu_thread", false).toBool();
+    Settings::values.use_presentation_thread =
+        qt_config->value("use_presentation_thread", false).toBool();
+    Settings::values.frame_dump_path =
+        qt_config->value("frame_dump_path", "").toString().toStdString();
 
     Settings::values.bg_red = qt_config->value("bg_red", 0.0).toFloat();
     Settings::values.bg_green = qt_config->value("bg_green", 0.0).toFloat();
@@ -94,8 +130,13 @@ void Config::ReadValues() {
     Settings::values.sink_id = qt_config->value("output_engine", "auto").toString().toStdString();
     Settings::values.enable_audio_stretching =
         qt_config->value("enable_audio_stretching", true).toBool();
+    Settings::values.audio_latency =
+        static_cast<u16>(qt_config->value("audio_latency", 50).toInt());
+    Settings::values.use_audio_thread = qt_config->value("use_audio_thread", false).toBool();
     Settings::values.audio_device_id =
         qt_config->value("output_device", "auto").toString().toStdString();
+    Settings::values.audio_dump_path =
+        qt_config->value("audio_dump_path", "").toString().toStdString();
     qt_config->endGroup();
 
     using namespace Service::CAM;
@@ -116,6 +157,9 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Data Storage");
     Settings::values.use_virtual_sd = qt_config->value("use_virtual_sd", true).toBool();
+    Settings::values.use_async_fs_reads = qt_config->value("use_async_fs_reads", true).toBool();
+    Settings::values.deterministic_fs_reads =
+        qt_config->value("deterministic_fs_reads", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -131,6 +175,15 @@ void Config::ReadValues() {
     qt_config->beginGroup("Debugging");
     Settings::values.use_gdbstub = qt_config->value("use_gdbstub", false).toBool();
     Settings::values.gdbstub_port = qt_config->value("gdbstub_port", 24689).toInt();
+    Settings::values.perf_stats_csv_path =
+        qt_config->value("perf_stats_csv_path", "").toString().toStdString();
+    Settings::values.use_gpu_timer_queries =
+        qt_config->value("use_gpu_timer_queries", false).toBool();
+    Settings::values.trace_capture_frames = qt_config->value("trace_capture_frames", 0).toUInt();
+    Settings::values.trace_capture_path =
+        qt_config->value("trace_capture_path", "").toString().toStdString();
+    Settings::values.guest_profile_path =
+        qt_config->value("guest_profile_path", "").toString().toStdString();
     qt_config->endGroup();
 
     qt_config->beginGroup("WebService");
@@ -207,6 +260,9 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Core");
     qt_config->setValue("use_cpu_jit", Settings::values.use_cpu_jit);
+    qt_config->setValue("cpu_max_slice_length", Settings::values.cpu_max_slice_length);
+    qt_config->setValue("share_code_pages", Settings::values.share_code_pages);
+    qt_config->setValue("use_disk_block_cache", Settings::values.use_disk_block_cache);
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
@@ -215,6 +271,29 @@ void Config::SaveValues() {
     qt_config->setValue("resolution_factor", (double)Settings::values.resolution_factor);
     qt_config->setValue("use_vsync", Settings::values.use_vsync);
     qt_config->setValue("toggle_framelimit", Settings::values.toggle_framelimit);
+    qt_config->setValue("frame_limit_spin_us", Settings::values.frame_limit_spin_us);
+    qt_config->setValue("turbo_frame_skip", Settings::values.turbo_frame_skip);
+    qt_config->setValue("frame_skip", Settings::values.frame_skip);
+    qt_config->setValue("use_surface_page_index", Settings::values.use_surface_page_index);
+    qt_config->setValue("surface_texture_pool_size", Settings::values.surface_texture_pool_size);
+    qt_config->setValue("use_gpu_surface_untiling", Settings::values.use_gpu_surface_untiling);
+    qt_config->setValue("use_surface_preloading", Settings::values.use_surface_preloading);
+    qt_config->setValue("use_shared_surface_textures",
+                        Settings::values.use_shared_surface_textures);
+    qt_config->setValue("use_hw_shader", Settings::values.use_hw_shader);
+    qt_config->setValue("use_disk_shader_cache", Settings::values.use_disk_shader_cache);
+    qt_config->setValue("use_async_shader_compile", Settings::values.use_async_shader_compile);
+    qt_config->setValue("use_ubershader", Settings::values.use_ubershader);
+    qt_config->setValue("vertex_cache_size", Settings::values.vertex_cache_size);
+    qt_config->setValue("use_multithreaded_vertex_shading",
+                        Settings::values.use_multithreaded_vertex_shading);
+    qt_config->setValue("use_vertex_loader_jit", Settings::values.use_vertex_loader_jit);
+    qt_config->setValue("use_multithreaded_sw_rasterizer",
+                        Settings::values.use_multithreaded_sw_rasterizer);
+    qt_config->setValue("use_gpu_thread", Settings::values.use_gpu_thread);
+    qt_config->setValue("use_presentation_thread", Settings::values.use_presentation_thread);
+    qt_config->setValue("frame_dump_path",
+                        QString::fromStdString(Settings::values.frame_dump_path));
 
     // Cast to double because Qt's written float values are not human-readable
     qt_config->setValue("bg_red", (double)Settings::values.bg_red);
@@ -239,7 +318,11 @@ void Config::SaveValues() {
     qt_config->beginGroup("Audio");
     qt_config->setValue("output_engine", QString::fromStdString(Settings::values.sink_id));
     qt_config->setValue("enable_audio_stretching", Settings::values.enable_audio_stretching);
+    qt_config->setValue("audio_latency", Settings::values.audio_latency);
+    qt_config->setValue("use_audio_thread", Settings::values.use_audio_thread);
     qt_config->setValue("output_device", QString::fromStdString(Settings::values.audio_device_id));
+    qt_config->setValue("audio_dump_path",
+                        QString::fromStdString(Settings::values.audio_dump_path));
     qt_config->endGroup();
 
     using namespace Service::CAM;
@@ -260,6 +343,8 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Data Storage");
     qt_config->setValue("use_virtual_sd", Settings::values.use_virtual_sd);
+    qt_config->setValue("use_async_fs_reads", Settings::values.use_async_fs_reads);
+    qt_config->setValue("deterministic_fs_reads", Settings::values.deterministic_fs_reads);
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -274,6 +359,14 @@ void Config::SaveValues() {
     qt_config->beginGroup("Debugging");
     qt_config->setValue("use_gdbstub", Settings::values.use_gdbstub);
     qt_config->setValue("gdbstub_port", Settings::values.gdbstub_port);
+    qt_config->setValue("perf_stats_csv_path",
+                        QString::fromStdString(Settings::values.perf_stats_csv_path));
+    qt_config->setValue("use_gpu_timer_queries", Settings::values.use_gpu_timer_queries);
+    qt_config->setValue("trace_capture_frames", Settings::values.trace_capture_frames);
+    qt_config->setValue("trace_capture_path",
+                        QString::fromStdString(Settings::values.trace_capture_path));
+    qt_config->setValue("guest_profile_path",
+                        QString::fromStdString(Settings::values.guest_profile_path));
     qt_config->endGroup();
 
     qt_config->beginGroup("WebService");
@@ -16,12 +16,31 @@ BreakPointObserverDock::BreakPointObserverDock(std::shared_ptr<Pica::DebugContex
     //       care of delaying its handling to the GUI thread.
     connect(this, SIGNAL(BreakPointHit(Pica::DebugContext::Event, void*)), this,
             SLOT(OnBreakPointHit(Pica::DebugContext::Event, void*)), Qt::BlockingQueuedConnection);
+
+    connect(this, &QDockWidget::visibilityChanged, this,
+            &BreakPointObserverDock::OnVisibilityChanged);
 }
 
 void BreakPointObserverDock::OnPicaBreakPointHit(Pica::DebugContext::Event event, void* data) {
+    if (!visible) {
+        missed_breakpoint = true;
+        return;
+    }
     emit BreakPointHit(event, data);
 }
 
 void BreakPointObserverDock::OnPicaResume() {
+    missed_breakpoint = false;
     emit Resumed();
 }
+
+void BreakPointObserverDock::OnVisibilityChanged(bool visible) {
+    this->visible = visible;
+    if (!visible || !missed_breakpoint.exchange(false))
+        return;
+
+    // The data of the event is only valid during the call that was skipped
+    auto context = context_weak.lock();
+    if (context && context->at_breakpoint)
+        OnBreakPointHit(context->active_breakpoint, nullptr);
+}
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <QDockWidget>
 #include "video_core/debug_utils/debug_utils.h"
 
@@ -11,6 +12,9 @@
  * Utility class which forwards calls to OnPicaBreakPointHit and OnPicaResume to public slots.
  * This is because the Pica breakpoint callbacks are called from a non-GUI thread, while
  * the widget usually wants to perform reactions in the GUI thread.
+ *
+ * Breakpoints aren't forwarded while the dock is hidden, sparing the emulation thread the wait
+ * for the GUI. A dock shown while emulation is halted at a breakpoint catches up with it then.
  */
 class BreakPointObserverDock : public QDockWidget,
                                protected Pica::DebugContext::BreakPointObserver {
@@ -27,6 +31,13 @@ private slots:
     virtual void OnBreakPointHit(Pica::DebugContext::Event event, void* data) = 0;
     virtual void OnResumed() = 0;
 
+private:
+    void OnVisibilityChanged(bool visible);
+
+    std::atomic_bool visible{false};
+    /// Whether a breakpoint was hit while hidden, and emulation hasn't resumed since
+    std::atomic_bool missed_breakpoint{false};
+
 signals:
     void Resumed();
     void BreakPointHit(Pica::DebugContext::Event event, void* data);
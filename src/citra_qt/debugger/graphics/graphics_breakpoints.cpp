@@ -64,7 +64,7 @@ QVariant BreakPointModel::data(const QModelIndex& index, int role) const {
 
     case Role_IsEnabled: {
         auto context = context_weak.lock();
-        return context && context->breakpoints[(int)event].enabled;
+        return context && context->IsBreakpointEnabled(event);
     }
 
     default:
@@ -95,7 +95,7 @@ bool BreakPointModel::setData(const QModelIndex& index, const QVariant& value, i
         if (!context)
             return false;
 
-        context->breakpoints[(int)event].enabled = value == Qt::Checked;
+        context->SetBreakpointEnabled(event, value == Qt::Checked);
         QModelIndex changed_index = createIndex(index.row(), 0);
         emit dataChanged(changed_index, changed_index);
         return true;
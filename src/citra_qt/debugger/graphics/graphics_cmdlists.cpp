@@ -13,6 +13,7 @@
 #include <QSpinBox>
 #include <QTreeView>
 #include <QVBoxLayout>
+#include <vector>
 #include "citra_qt/debugger/graphics/graphics_cmdlists.h"
 #include "citra_qt/util/spinbox.h"
 #include "citra_qt/util/util.h"
@@ -25,10 +26,13 @@
 
 namespace {
 QImage LoadTexture(const u8* src, const Pica::Texture::TextureInfo& info) {
+    std::vector<Math::Vec4<u8>> texels(info.width * info.height);
+    Pica::Texture::DecodeTexture(src, info, texels.data(), info.width, true);
+
     QImage decoded_image(info.width, info.height, QImage::Format_ARGB32);
     for (int y = 0; y < info.height; ++y) {
         for (int x = 0; x < info.width; ++x) {
-            Math::Vec4<u8> color = Pica::Texture::LookupTexture(src, x, y, info, true);
+            const Math::Vec4<u8>& color = texels[y * info.width + x];
             decoded_image.setPixel(x, y, qRgba(color.r(), color.g(), color.b(), color.a()));
         }
     }
@@ -11,6 +11,8 @@
 #include <QPushButton>
 #include <QScrollArea>
 #include <QSpinBox>
+#include <QThreadPool>
+#include <vector>
 #include "citra_qt/debugger/graphics/graphics_surface.h"
 #include "citra_qt/util/spinbox.h"
 #include "common/color.h"
@@ -44,6 +46,10 @@ void SurfacePicture::mouseMoveEvent(QMouseEvent* event) {
     mousePressEvent(event);
 }
 
+void SurfaceDecodeWorker::run() {
+    emit Finished(generation, decode());
+}
+
 GraphicsSurfaceWidget::GraphicsSurfaceWidget(std::shared_ptr<Pica::DebugContext> debug_context,
                                              QWidget* parent)
     : BreakPointObserverDock(debug_context, tr("Pica Surface Viewer"), parent),
@@ -270,6 +276,9 @@ void GraphicsSurfaceWidget::OnSurfacePickerYChanged(int new_value) {
 }
 
 void GraphicsSurfaceWidget::Pick(int x, int y) {
+    // Set the coordinates first, so that the spin boxes don't pick again with half of them updated
+    surface_picker_x = x;
+    surface_picker_y = y;
     surface_picker_x_control->setValue(x);
     surface_picker_y_control->setValue(y);
 
@@ -279,8 +288,7 @@ void GraphicsSurfaceWidget::Pick(int x, int y) {
         return;
     }
 
-    u8* buffer = Memory::GetPhysicalPointer(surface_address);
-    if (buffer == nullptr) {
+    if (surface_data == nullptr) {
         surface_info_label->setText(tr("(unable to access pixel data)"));
         surface_info_label->setAlignment(Qt::AlignCenter);
         return;
@@ -300,9 +308,9 @@ void GraphicsSurfaceWidget::Pick(int x, int y) {
 
     const u32 coarse_y = y & ~7;
     u32 offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * stride;
-    const u8* pixel = buffer + (nibble_mode ? (offset / 2) : offset);
+    const u8* pixel = surface_data->data() + (nibble_mode ? (offset / 2) : offset);
 
-    auto GetText = [offset](Format format, const u8* pixel) {
+    auto GetText = [this, offset, x, y](Format format, const u8* pixel) {
         switch (format) {
         case Format::RGBA8: {
             auto value = Color::DecodeRGBA8(pixel) / 255.0f;
@@ -365,9 +373,16 @@ void GraphicsSurfaceWidget::Pick(int x, int y) {
             return QString("Alpha: %1").arg(QString::number(a / 15.0f, 'f', 2));
         }
         case Format::ETC1:
-        case Format::ETC1A4:
-            // TODO: Display block information or channel values?
-            return QString("Compressed data");
+        case Format::ETC1A4: {
+            // TODO: Display block information or the alpha channel?
+            if (decoded_surface.isNull())
+                return QString("Compressed data");
+            const QRgb value = decoded_surface.pixel(x, y);
+            return QString("Red: %1, Green: %2, Blue: %3")
+                .arg(QString::number(qRed(value) / 255.0f, 'f', 2))
+                .arg(QString::number(qGreen(value) / 255.0f, 'f', 2))
+                .arg(QString::number(qBlue(value) / 255.0f, 'f', 2));
+        }
         case Format::D16: {
             auto value = Color::DecodeD16(pixel);
             return QString("Depth: %1").arg(QString::number(value / (float)0xFFFF, 'f', 4));
@@ -408,7 +423,6 @@ void GraphicsSurfaceWidget::Pick(int x, int y) {
 }
 
 void GraphicsSurfaceWidget::OnUpdate() {
-    QPixmap pixmap;
 
     switch (surface_source) {
     case Source::ColorBuffer: {
@@ -544,7 +558,11 @@ void GraphicsSurfaceWidget::OnUpdate() {
 
     // TODO: Implement a good way to visualize alpha components!
 
-    QImage decoded_image(surface_width, surface_height, QImage::Format_ARGB32);
+    // Forget the previous surface, discarding its decode if that is still in progress
+    surface_data = nullptr;
+    decoded_surface = QImage();
+    const quint64 generation = ++decode_generation;
+
     u8* buffer = Memory::GetPhysicalPointer(surface_address);
 
     if (buffer == nullptr) {
@@ -569,85 +587,45 @@ void GraphicsSurfaceWidget::OnUpdate() {
 
     surface_picture_label->show();
 
-    if (surface_format <= Format::MaxTextureFormat) {
-        // Generate a virtual texture
-        Pica::Texture::TextureInfo info;
-        info.physical_address = surface_address;
-        info.width = surface_width;
-        info.height = surface_height;
-        info.format = static_cast<Pica::TexturingRegs::TextureFormat>(surface_format);
-        info.SetDefaultStride();
+    // The emulator may overwrite the surface once resumed, so decode a copy of it
+    const size_t size = surface_width * surface_height * NibblesPerPixel(surface_format) / 2;
+    surface_data = std::make_shared<const std::vector<u8>>(buffer, buffer + size);
+
+    auto data = surface_data;
+    const unsigned width = surface_width;
+    const unsigned height = surface_height;
+    const Format format = surface_format;
+    SurfaceDecodeWorker* worker =
+        new SurfaceDecodeWorker(generation, [data, width, height, format] {
+            return DecodeSurface(data->data(), width, height, format);
+        });
+    connect(worker, &SurfaceDecodeWorker::Finished, this,
+            &GraphicsSurfaceWidget::OnSurfaceDecoded, Qt::QueuedConnection);
+    QThreadPool::globalInstance()->start(worker);
+
+    // Update the info with pixel data, which doesn't need to wait for the decode
+    surface_picker_x_control->setEnabled(true);
+    surface_picker_y_control->setEnabled(true);
+    Pick(surface_picker_x, surface_picker_y);
 
-        for (unsigned int y = 0; y < surface_height; ++y) {
-            for (unsigned int x = 0; x < surface_width; ++x) {
-                Math::Vec4<u8> color = Pica::Texture::LookupTexture(buffer, x, y, info, true);
-                decoded_image.setPixel(x, y, qRgba(color.r(), color.g(), color.b(), color.a()));
-            }
-        }
-    } else {
-        // We handle depth formats here because DebugUtils only supports TextureFormats
-
-        // TODO(yuriks): Convert to newer tile-based addressing
-        unsigned nibbles_per_pixel = GraphicsSurfaceWidget::NibblesPerPixel(surface_format);
-        unsigned stride = nibbles_per_pixel * surface_width / 2;
-
-        ASSERT_MSG(nibbles_per_pixel >= 2,
-                   "Depth decoder only supports formats with at least one byte per pixel");
-        unsigned bytes_per_pixel = nibbles_per_pixel / 2;
-
-        for (unsigned int y = 0; y < surface_height; ++y) {
-            for (unsigned int x = 0; x < surface_width; ++x) {
-                const u32 coarse_y = y & ~7;
-                u32 offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * stride;
-                const u8* pixel = buffer + offset;
-                Math::Vec4<u8> color = {0, 0, 0, 0};
-
-                switch (surface_format) {
-                case Format::D16: {
-                    u32 data = Color::DecodeD16(pixel);
-                    color.r() = data & 0xFF;
-                    color.g() = (data >> 8) & 0xFF;
-                    break;
-                }
-                case Format::D24: {
-                    u32 data = Color::DecodeD24(pixel);
-                    color.r() = data & 0xFF;
-                    color.g() = (data >> 8) & 0xFF;
-                    color.b() = (data >> 16) & 0xFF;
-                    break;
-                }
-                case Format::D24X8: {
-                    Math::Vec2<u32> data = Color::DecodeD24S8(pixel);
-                    color.r() = data.x & 0xFF;
-                    color.g() = (data.x >> 8) & 0xFF;
-                    color.b() = (data.x >> 16) & 0xFF;
-                    break;
-                }
-                case Format::X24S8: {
-                    Math::Vec2<u32> data = Color::DecodeD24S8(pixel);
-                    color.r() = color.g() = color.b() = data.y;
-                    break;
-                }
-                default:
-                    qDebug() << "Unknown surface format " << static_cast<int>(surface_format);
-                    break;
-                }
-
-                decoded_image.setPixel(x, y, qRgba(color.r(), color.g(), color.b(), 255));
-            }
-        }
-    }
+    // Saving is enabled once there is a decoded image to save
+    save_surface->setEnabled(false);
+}
+
+void GraphicsSurfaceWidget::OnSurfaceDecoded(quint64 generation, QImage image) {
+    // Discard the results of decodes that a later update has superseded
+    if (generation != decode_generation)
+        return;
+
+    decoded_surface = std::move(image);
 
-    pixmap = QPixmap::fromImage(decoded_image);
+    QPixmap pixmap = QPixmap::fromImage(decoded_surface);
     surface_picture_label->setPixmap(pixmap);
     surface_picture_label->resize(pixmap.size());
 
-    // Update the info with pixel data
-    surface_picker_x_control->setEnabled(true);
-    surface_picker_y_control->setEnabled(true);
+    // Compressed formats show the decoded color of the picked pixel
     Pick(surface_picker_x, surface_picker_y);
 
-    // Enable saving the converted pixmap to file
     save_surface->setEnabled(true);
 }
 
@@ -667,27 +645,97 @@ void GraphicsSurfaceWidget::SaveSurface() {
     }
 
     if (selectedFilter == png_filter) {
-        const QPixmap* pixmap = surface_picture_label->pixmap();
-        ASSERT_MSG(pixmap != nullptr, "No pixmap set");
+        ASSERT_MSG(!decoded_surface.isNull(), "No decoded surface");
 
         QFile file(filename);
         file.open(QIODevice::WriteOnly);
-        if (pixmap)
-            pixmap->save(&file, "PNG");
+        decoded_surface.save(&file, "PNG");
     } else if (selectedFilter == bin_filter) {
-        const u8* buffer = Memory::GetPhysicalPointer(surface_address);
-        ASSERT_MSG(buffer != nullptr, "Memory not accessible");
+        ASSERT_MSG(surface_data != nullptr, "No surface data");
 
         QFile file(filename);
         file.open(QIODevice::WriteOnly);
-        int size = surface_width * surface_height * NibblesPerPixel(surface_format) / 2;
-        QByteArray data(reinterpret_cast<const char*>(buffer), size);
-        file.write(data);
+        file.write(reinterpret_cast<const char*>(surface_data->data()),
+                   static_cast<qint64>(surface_data->size()));
     } else {
         UNREACHABLE_MSG("Unhandled filter selected");
     }
 }
 
+QImage GraphicsSurfaceWidget::DecodeSurface(const u8* data, unsigned width, unsigned height,
+                                            Format format) {
+    // Texels are decoded straight into the image, which has the same layout as Math::Vec4<u8>
+    QImage image(width, height, QImage::Format_RGBA8888);
+
+    if (format <= Format::MaxTextureFormat) {
+        // Generate a virtual texture
+        Pica::Texture::TextureInfo info;
+        info.width = width;
+        info.height = height;
+        info.format = static_cast<Pica::TexturingRegs::TextureFormat>(format);
+        info.SetDefaultStride();
+
+        Pica::Texture::DecodeTexture(data, info, reinterpret_cast<Math::Vec4<u8>*>(image.bits()),
+                                     image.bytesPerLine() / sizeof(Math::Vec4<u8>), true);
+        return image;
+    }
+
+    // We handle depth formats here because the texture decoder only supports TextureFormats
+
+    // TODO(yuriks): Convert to newer tile-based addressing
+    unsigned nibbles_per_pixel = GraphicsSurfaceWidget::NibblesPerPixel(format);
+    unsigned stride = nibbles_per_pixel * width / 2;
+
+    ASSERT_MSG(nibbles_per_pixel >= 2,
+               "Depth decoder only supports formats with at least one byte per pixel");
+    unsigned bytes_per_pixel = nibbles_per_pixel / 2;
+
+    for (unsigned int y = 0; y < height; ++y) {
+        const u32 coarse_y = y & ~7;
+        auto line = reinterpret_cast<Math::Vec4<u8>*>(image.scanLine(y));
+
+        for (unsigned int x = 0; x < width; ++x) {
+            u32 offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * stride;
+            const u8* pixel = data + offset;
+            Math::Vec4<u8> color = {0, 0, 0, 255};
+
+            switch (format) {
+            case Format::D16: {
+                u32 value = Color::DecodeD16(pixel);
+                color.r() = value & 0xFF;
+                color.g() = (value >> 8) & 0xFF;
+                break;
+            }
+            case Format::D24: {
+                u32 value = Color::DecodeD24(pixel);
+                color.r() = value & 0xFF;
+                color.g() = (value >> 8) & 0xFF;
+                color.b() = (value >> 16) & 0xFF;
+                break;
+            }
+            case Format::D24X8: {
+                Math::Vec2<u32> value = Color::DecodeD24S8(pixel);
+                color.r() = value.x & 0xFF;
+                color.g() = (value.x >> 8) & 0xFF;
+                color.b() = (value.x >> 16) & 0xFF;
+                break;
+            }
+            case Format::X24S8: {
+                Math::Vec2<u32> value = Color::DecodeD24S8(pixel);
+                color.r() = color.g() = color.b() = value.y;
+                break;
+            }
+            default:
+                UNREACHABLE_MSG("Unknown surface format %d", static_cast<int>(format));
+                break;
+            }
+
+            line[x] = color;
+        }
+    }
+    return image;
+}
+
 unsigned int GraphicsSurfaceWidget::NibblesPerPixel(GraphicsSurfaceWidget::Format format) {
     if (format <= Format::MaxTextureFormat) {
         return Pica::TexturingRegs::NibblesPerPixel(
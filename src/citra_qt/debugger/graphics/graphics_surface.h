@@ -4,9 +4,15 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <vector>
+#include <QImage>
 #include <QLabel>
 #include <QPushButton>
+#include <QRunnable>
 #include "citra_qt/debugger/graphics/graphics_breakpoint_observer.h"
+#include "common/common_types.h"
 
 class QComboBox;
 class QSpinBox;
@@ -30,6 +36,32 @@ private:
     GraphicsSurfaceWidget* surface_widget;
 };
 
+/**
+ * Decodes a surface on the thread pool, so that large surfaces don't stall the GUI.
+ * Communicates the result through Qt's signal/slot system.
+ */
+class SurfaceDecodeWorker : public QObject, public QRunnable {
+    Q_OBJECT
+
+public:
+    SurfaceDecodeWorker(quint64 generation, std::function<QImage()> decode)
+        : QObject(), QRunnable(), generation(generation), decode(std::move(decode)) {}
+
+    void run() override;
+
+signals:
+    /**
+     * Emitted once the surface has been decoded.
+     * @param generation the generation of the update the decode was started by
+     * @param image the decoded surface
+     */
+    void Finished(quint64 generation, QImage image);
+
+private:
+    quint64 generation;
+    std::function<QImage()> decode;
+};
+
 class GraphicsSurfaceWidget : public BreakPointObserverDock {
     Q_OBJECT
 
@@ -71,6 +103,9 @@ class GraphicsSurfaceWidget : public BreakPointObserverDock {
 
     static unsigned int NibblesPerPixel(Format format);
 
+    /// Decodes a surface of a known format into an image of the same size
+    static QImage DecodeSurface(const u8* data, unsigned width, unsigned height, Format format);
+
 public:
     explicit GraphicsSurfaceWidget(std::shared_ptr<Pica::DebugContext> debug_context,
                                    QWidget* parent = nullptr);
@@ -85,6 +120,7 @@ public slots:
     void OnSurfacePickerXChanged(int new_value);
     void OnSurfacePickerYChanged(int new_value);
     void OnUpdate();
+    void OnSurfaceDecoded(quint64 generation, QImage image);
 
 private slots:
     void OnBreakPointHit(Pica::DebugContext::Event event, void* data) override;
@@ -115,4 +151,11 @@ private:
     Format surface_format;
     int surface_picker_x = 0;
     int surface_picker_y = 0;
+
+    /// Copy of the surface data taken by the last update, read by the decode, picker and saving
+    std::shared_ptr<const std::vector<u8>> surface_data;
+    /// Decode of surface_data, null while it is in progress
+    QImage decoded_surface;
+    /// Incremented by each update, so that the results of earlier decodes are discarded
+    quint64 decode_generation = 0;
 };
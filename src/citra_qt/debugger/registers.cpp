@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <QTreeWidgetItem>
+#include "citra_qt/bootmanager.h"
 #include "citra_qt/debugger/registers.h"
 #include "citra_qt/util/util.h"
 #include "core/arm/arm_interface.h"
@@ -18,6 +19,8 @@ RegistersWidget::RegistersWidget(QWidget* parent) : QDockWidget(parent) {
                               new QTreeWidgetItem(QStringList(tr("VFP System Registers"))));
     tree->addTopLevelItem(cpsr = new QTreeWidgetItem(QStringList("CPSR")));
 
+    connect(this, &QDockWidget::visibilityChanged, this, &RegistersWidget::OnVisibilityChanged);
+
     for (int i = 0; i < 16; ++i) {
         QTreeWidgetItem* child = new QTreeWidgetItem(QStringList(QString("R[%1]").arg(i)));
         core_registers->addChild(child);
@@ -76,10 +79,24 @@ void RegistersWidget::OnDebugModeEntered() {
 void RegistersWidget::OnDebugModeLeft() {}
 
 void RegistersWidget::OnEmulationStarting(EmuThread* emu_thread) {
+    this->emu_thread = emu_thread;
+    in_debug_mode = false;
+
+    // Keeping track of whether emulation is paused costs nothing, unlike refreshing the widget
+    connect(emu_thread, &EmuThread::DebugModeEntered, this, [this] { in_debug_mode = true; },
+            Qt::DirectConnection);
+    connect(emu_thread, &EmuThread::DebugModeLeft, this, [this] { in_debug_mode = false; },
+            Qt::DirectConnection);
+    UpdateSubscription(isVisible());
+
     setEnabled(true);
 }
 
 void RegistersWidget::OnEmulationStopping() {
+    disconnect(emu_thread, nullptr, this, nullptr);
+    emu_thread = nullptr;
+    subscribed = false;
+
     // Reset widget text
     for (int i = 0; i < core_registers->childCount(); ++i)
         core_registers->child(i)->setText(1, QString(""));
@@ -236,3 +253,34 @@ void RegistersWidget::UpdateVFPSystemRegisterValues() {
     vfp_system_registers->child(3)->setText(
         1, QString("0x%1").arg(fpinst2_val, 8, 16, QLatin1Char('0')));
 }
+
+void RegistersWidget::OnVisibilityChanged(bool visible) {
+    UpdateSubscription(visible);
+
+    // Catch up with what the emulation thread did while the widget was hidden
+    if (visible && emu_thread != nullptr) {
+        if (in_debug_mode) {
+            OnDebugModeEntered();
+        } else {
+            OnDebugModeLeft();
+        }
+    }
+}
+
+void RegistersWidget::UpdateSubscription(bool visible) {
+    if (emu_thread == nullptr || visible == subscribed)
+        return;
+    subscribed = visible;
+
+    if (visible) {
+        // BlockingQueuedConnection makes sure the view is refreshed before the CPU continues
+        connect(emu_thread, &EmuThread::DebugModeEntered, this,
+                &RegistersWidget::OnDebugModeEntered, Qt::BlockingQueuedConnection);
+        connect(emu_thread, &EmuThread::DebugModeLeft, this, &RegistersWidget::OnDebugModeLeft,
+                Qt::BlockingQueuedConnection);
+    } else {
+        disconnect(emu_thread, &EmuThread::DebugModeEntered, this,
+                   &RegistersWidget::OnDebugModeEntered);
+        disconnect(emu_thread, &EmuThread::DebugModeLeft, this, &RegistersWidget::OnDebugModeLeft);
+    }
+}
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <QDockWidget>
 #include "ui_registers.h"
 
@@ -25,6 +26,18 @@ public slots:
     void OnEmulationStopping();
 
 private:
+    void OnVisibilityChanged(bool visible);
+    /**
+     * Connects the refreshes to the emulation thread while the widget is visible, as they hold up
+     * the emulation thread until the GUI has processed them
+     */
+    void UpdateSubscription(bool visible);
+
+    EmuThread* emu_thread = nullptr;
+    bool subscribed = false;
+    /// Whether emulation is paused, tracked even while hidden to catch up once shown
+    std::atomic_bool in_debug_mode{false};
+
     void CreateCPSRChildren();
     void UpdateCPSRValues();
 
@@ -0,0 +1,111 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QStandardItemModel>
+#include <QTreeView>
+#include <QVBoxLayout>
+#include "citra_qt/debugger/service_calls.h"
+#include "citra_qt/util/util.h"
+#include "core/hle/service/call_stats.h"
+
+namespace {
+
+enum Column {
+    COLUMN_SERVICE,
+    COLUMN_FUNCTION,
+    COLUMN_HEADER,
+    COLUMN_CALLS,
+    COLUMN_TOTAL_TIME,
+    COLUMN_AVERAGE_TIME,
+    COLUMN_P99_TIME,
+    COLUMN_COUNT,
+};
+
+/// Creates an item showing a number, so that the column sorts numerically
+QStandardItem* CreateNumberItem(const QVariant& value) {
+    QStandardItem* item = new QStandardItem;
+    item->setData(value, Qt::DisplayRole);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+double ToMicroseconds(std::chrono::nanoseconds time) {
+    return std::chrono::duration<double, std::micro>(time).count();
+}
+
+} // Anonymous namespace
+
+ServiceCallsWidget::ServiceCallsWidget(QWidget* parent)
+    : QDockWidget(tr("Service Calls"), parent) {
+    setObjectName("ServiceCallsWidget");
+
+    model = new QStandardItemModel(0, COLUMN_COUNT, this);
+    model->setHorizontalHeaderLabels({tr("Service"), tr("Function"), tr("Header"), tr("Calls"),
+                                      tr("Total (ms)"), tr("Average (us)"), tr("p99 (us)")});
+
+    view = new QTreeView;
+    view->setModel(model);
+    view->setRootIsDecorated(false);
+    view->setSortingEnabled(true);
+    view->sortByColumn(COLUMN_TOTAL_TIME, Qt::DescendingOrder);
+    view->setSelectionMode(QAbstractItemView::NoSelection);
+
+    QPushButton* reset_button = new QPushButton(tr("Reset"));
+    connect(reset_button, &QPushButton::clicked, this, &ServiceCallsWidget::Reset);
+
+    QWidget* main_widget = new QWidget;
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(view);
+    layout->addWidget(reset_button);
+    main_widget->setLayout(layout);
+    setWidget(main_widget);
+
+    refresh_timer.setInterval(1000);
+    connect(&refresh_timer, &QTimer::timeout, this, &ServiceCallsWidget::Refresh);
+    connect(this, &QDockWidget::visibilityChanged, this,
+            &ServiceCallsWidget::OnVisibilityChanged);
+}
+
+void ServiceCallsWidget::OnVisibilityChanged(bool visible) {
+    Service::CallStats::SetEnabled(visible);
+    if (visible) {
+        Refresh();
+        refresh_timer.start();
+    } else {
+        refresh_timer.stop();
+    }
+}
+
+void ServiceCallsWidget::Refresh() {
+    model->removeRows(0, model->rowCount());
+
+    const QFont font = GetMonospaceFont();
+    for (const auto& summary : Service::CallStats::GetSummaries()) {
+        QStandardItem* header_item =
+            new QStandardItem(QString("0x%1").arg(summary.header, 8, 16, QLatin1Char('0')));
+        header_item->setFont(font);
+
+        const double total_us = ToMicroseconds(summary.total_time);
+        model->appendRow({
+            new QStandardItem(QString::fromStdString(summary.service_name)),
+            new QStandardItem(QString::fromStdString(summary.function_name)),
+            header_item,
+            CreateNumberItem(static_cast<qulonglong>(summary.call_count)),
+            CreateNumberItem(total_us / 1000.0),
+            CreateNumberItem(total_us / summary.call_count),
+            CreateNumberItem(ToMicroseconds(summary.p99_time)),
+        });
+    }
+
+    model->sort(view->header()->sortIndicatorSection(), view->header()->sortIndicatorOrder());
+}
+
+void ServiceCallsWidget::Reset() {
+    Service::CallStats::Reset();
+    Refresh();
+}
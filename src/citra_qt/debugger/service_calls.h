@@ -0,0 +1,33 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <QDockWidget>
+#include <QTimer>
+
+class QStandardItemModel;
+class QTreeView;
+
+/**
+ * Lists the HLE service commands called by the emulated application, with how often they are
+ * called and how long their handlers take. Statistics are only collected while it is visible.
+ */
+class ServiceCallsWidget : public QDockWidget {
+    Q_OBJECT
+
+public:
+    explicit ServiceCallsWidget(QWidget* parent = nullptr);
+
+private slots:
+    void OnVisibilityChanged(bool visible);
+    void Refresh();
+    void Reset();
+
+private:
+    QTreeView* view;
+    QStandardItemModel* model;
+    /// Refreshes the list once a second while the widget is visible
+    QTimer refresh_timer;
+};
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "citra_qt/bootmanager.h"
 #include "citra_qt/debugger/wait_tree.h"
 #include "citra_qt/util/util.h"
 
@@ -119,8 +120,7 @@ QString WaitTreeWaitObject::GetResetTypeQString(Kernel::ResetType reset_type) {
     }
 }
 
-WaitTreeObjectList::WaitTreeObjectList(
-    const std::vector<Kernel::SharedPtr<Kernel::WaitObject>>& list, bool w_all)
+WaitTreeObjectList::WaitTreeObjectList(const Kernel::WaitObjectList& list, bool w_all)
     : object_list(list), wait_all(w_all) {}
 
 QString WaitTreeObjectList::GetText() const {
@@ -392,6 +392,8 @@ WaitTreeWidget::WaitTreeWidget(QWidget* parent) : QDockWidget(tr("Wait Tree"), p
     view->setHeaderHidden(true);
     setWidget(view);
     setEnabled(false);
+
+    connect(this, &QDockWidget::visibilityChanged, this, &WaitTreeWidget::OnVisibilityChanged);
 }
 
 void WaitTreeWidget::OnDebugModeEntered() {
@@ -409,13 +411,58 @@ void WaitTreeWidget::OnDebugModeLeft() {
 }
 
 void WaitTreeWidget::OnEmulationStarting(EmuThread* emu_thread) {
+    this->emu_thread = emu_thread;
+    in_debug_mode = false;
+
+    // Keeping track of whether emulation is paused costs nothing, unlike rebuilding the tree
+    connect(emu_thread, &EmuThread::DebugModeEntered, this, [this] { in_debug_mode = true; },
+            Qt::DirectConnection);
+    connect(emu_thread, &EmuThread::DebugModeLeft, this, [this] { in_debug_mode = false; },
+            Qt::DirectConnection);
+    UpdateSubscription(isVisible());
+
     model = new WaitTreeModel(this);
     view->setModel(model);
     setEnabled(false);
 }
 
 void WaitTreeWidget::OnEmulationStopping() {
+    disconnect(emu_thread, nullptr, this, nullptr);
+    emu_thread = nullptr;
+    subscribed = false;
+
     view->setModel(nullptr);
     delete model;
     setEnabled(false);
 }
+
+void WaitTreeWidget::OnVisibilityChanged(bool visible) {
+    UpdateSubscription(visible);
+
+    // Catch up with what the emulation thread did while the widget was hidden
+    if (visible && emu_thread != nullptr) {
+        if (in_debug_mode) {
+            OnDebugModeEntered();
+        } else {
+            OnDebugModeLeft();
+        }
+    }
+}
+
+void WaitTreeWidget::UpdateSubscription(bool visible) {
+    if (emu_thread == nullptr || visible == subscribed)
+        return;
+    subscribed = visible;
+
+    if (visible) {
+        // BlockingQueuedConnection makes sure the tree is rebuilt before the CPU continues
+        connect(emu_thread, &EmuThread::DebugModeEntered, this,
+                &WaitTreeWidget::OnDebugModeEntered, Qt::BlockingQueuedConnection);
+        connect(emu_thread, &EmuThread::DebugModeLeft, this, &WaitTreeWidget::OnDebugModeLeft,
+                Qt::BlockingQueuedConnection);
+    } else {
+        disconnect(emu_thread, &EmuThread::DebugModeEntered, this,
+                   &WaitTreeWidget::OnDebugModeEntered);
+        disconnect(emu_thread, &EmuThread::DebugModeLeft, this, &WaitTreeWidget::OnDebugModeLeft);
+    }
+}
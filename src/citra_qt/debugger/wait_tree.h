@@ -4,12 +4,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <QAbstractItemModel>
 #include <QDockWidget>
 #include <QTreeView>
 #include <boost/container/flat_set.hpp>
 #include "core/core.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/wait_object.h"
 
 class EmuThread;
 
@@ -78,13 +80,12 @@ protected:
 class WaitTreeObjectList : public WaitTreeExpandableItem {
     Q_OBJECT
 public:
-    WaitTreeObjectList(const std::vector<Kernel::SharedPtr<Kernel::WaitObject>>& list,
-                       bool wait_all);
+    WaitTreeObjectList(const Kernel::WaitObjectList& list, bool wait_all);
     QString GetText() const override;
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
 
 private:
-    const std::vector<Kernel::SharedPtr<Kernel::WaitObject>>& object_list;
+    const Kernel::WaitObjectList& object_list;
     bool wait_all;
 };
 
@@ -182,6 +183,18 @@ public slots:
     void OnEmulationStopping();
 
 private:
+    void OnVisibilityChanged(bool visible);
+    /**
+     * Connects the refreshes to the emulation thread while the widget is visible, as they hold up
+     * the emulation thread until the GUI has processed them
+     */
+    void UpdateSubscription(bool visible);
+
+    EmuThread* emu_thread = nullptr;
+    bool subscribed = false;
+    /// Whether emulation is paused, tracked even while hidden to catch up once shown
+    std::atomic_bool in_debug_mode{false};
+
     QTreeView* view;
     WaitTreeModel* model;
 };
@@ -2,16 +2,28 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
 #include <QApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QHeaderView>
 #include <QKeyEvent>
 #include <QMenu>
+#include <QMessageBox>
 #include <QThreadPool>
+#include <cryptopp/sha.h>
 #include "common/common_paths.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
 #include "core/loader/loader.h"
+#include "core/loader/ncch.h"
 #include "game_list.h"
 #include "game_list_p.h"
 #include "ui_settings.h"
@@ -147,47 +159,42 @@ bool GameList::containsAllWords(QString haystack, QString userinput) {
                        [haystack](QString s) { return haystack.contains(s); });
 }
 
+bool GameList::MatchesFilter(int row) {
+    // If the searchfield is empty every item is visible
+    if (filter_text.isEmpty())
+        return true;
+
+    QStandardItem* child_file = item_model->item(row, 0);
+    QString file_path = child_file->data(GameListItemPath::FullPathRole).toString().toLower();
+    QString file_name = file_path.mid(file_path.lastIndexOf("/") + 1);
+    QString file_title = child_file->data(GameListItemPath::TitleRole).toString().toLower();
+    QString file_programmid =
+        child_file->data(GameListItemPath::ProgramIdRole).toString().toLower();
+
+    // Only items which filename in combination with its title contains all words
+    // that are in the searchfiel will be visible in the gamelist
+    // The search is case insensitive because of toLower()
+    // I decided not to use Qt::CaseInsensitive in containsAllWords to prevent
+    // multiple conversions of filter_text for each game in the gamelist
+    return containsAllWords(file_name.append(" ").append(file_title), filter_text) ||
+           (file_programmid.count() == 16 && filter_text.contains(file_programmid));
+}
+
 // Event in order to filter the gamelist after editing the searchfield
 void GameList::onTextChanged(const QString& newText) {
     int rowCount = tree_view->model()->rowCount();
-    QString edit_filter_text = newText.toLower();
+    filter_text = newText.toLower();
 
     QModelIndex root_index = item_model->invisibleRootItem()->index();
 
-    // If the searchfield is empty every item is visible
-    // Otherwise the filter gets applied
-    if (edit_filter_text.isEmpty()) {
-        for (int i = 0; i < rowCount; ++i) {
-            tree_view->setRowHidden(i, root_index, false);
-        }
-        search_field->setFilterResult(rowCount, rowCount);
-    } else {
-        QStandardItem* child_file;
-        QString file_path, file_name, file_title, file_programmid;
-        int result_count = 0;
-        for (int i = 0; i < rowCount; ++i) {
-            child_file = item_model->item(i, 0);
-            file_path = child_file->data(GameListItemPath::FullPathRole).toString().toLower();
-            file_name = file_path.mid(file_path.lastIndexOf("/") + 1);
-            file_title = child_file->data(GameListItemPath::TitleRole).toString().toLower();
-            file_programmid =
-                child_file->data(GameListItemPath::ProgramIdRole).toString().toLower();
-
-            // Only items which filename in combination with its title contains all words
-            // that are in the searchfiel will be visible in the gamelist
-            // The search is case insensitive because of toLower()
-            // I decided not to use Qt::CaseInsensitive in containsAllWords to prevent
-            // multiple conversions of edit_filter_text for each game in the gamelist
-            if (containsAllWords(file_name.append(" ").append(file_title), edit_filter_text) ||
-                (file_programmid.count() == 16 && edit_filter_text.contains(file_programmid))) {
-                tree_view->setRowHidden(i, root_index, false);
-                ++result_count;
-            } else {
-                tree_view->setRowHidden(i, root_index, true);
-            }
-            search_field->setFilterResult(result_count, rowCount);
-        }
+    visible_rows = 0;
+    for (int i = 0; i < rowCount; ++i) {
+        const bool visible = MatchesFilter(i);
+        tree_view->setRowHidden(i, root_index, !visible);
+        if (visible)
+            ++visible_rows;
     }
+    search_field->setFilterResult(visible_rows, rowCount);
 }
 
 void GameList::onFilterCloseClicked() {
@@ -226,6 +233,7 @@ GameList::GameList(GMainWindow* parent) : QWidget{parent} {
     // We must register all custom types with the Qt Automoc system so that we are able to use it
     // with signals/slots. In this case, QList falls under the umbrells of custom types.
     qRegisterMetaType<QList<QStandardItem*>>("QList<QStandardItem*>");
+    qRegisterMetaType<QList<QList<QStandardItem*>>>("QList<QList<QStandardItem*>>");
 
     layout->setContentsMargins(0, 0, 0, 0);
     layout->setSpacing(0);
@@ -235,6 +243,7 @@ GameList::GameList(GMainWindow* parent) : QWidget{parent} {
 }
 
 GameList::~GameList() {
+    emit ShouldCancelVerifier();
     emit ShouldCancelWorker();
 }
 
@@ -252,8 +261,25 @@ void GameList::clearFilter() {
     search_field->clear();
 }
 
-void GameList::AddEntry(const QList<QStandardItem*>& entry_items) {
-    item_model->invisibleRootItem()->appendRow(entry_items);
+void GameList::AddEntries(const QList<QList<QStandardItem*>>& entries) {
+    // Inserting the rows of a batch at once has the view lay itself out once rather than per row
+    const int first_row = item_model->rowCount();
+    item_model->insertRows(first_row, entries.size());
+
+    QModelIndex root_index = item_model->invisibleRootItem()->index();
+    for (int i = 0; i < entries.size(); ++i) {
+        const int row = first_row + i;
+        for (int column = 0; column < entries[i].size(); ++column)
+            item_model->setItem(row, column, entries[i][column]);
+
+        // The list can be searched while it's being populated
+        if (MatchesFilter(row)) {
+            ++visible_rows;
+        } else {
+            tree_view->setRowHidden(row, root_index, true);
+        }
+    }
+    search_field->setFilterResult(visible_rows, item_model->rowCount());
 }
 
 void GameList::ValidateEntry(const QModelIndex& item) {
@@ -288,9 +314,8 @@ void GameList::DonePopulating(QStringList watch_list) {
         watcher->addPaths(watch_list.mid(i, i + SLICE_SIZE));
         QCoreApplication::processEvents();
     }
-    tree_view->setEnabled(true);
     int rowCount = tree_view->model()->rowCount();
-    search_field->setFilterResult(rowCount, rowCount);
+    search_field->setFilterResult(visible_rows, rowCount);
     if (rowCount > 0) {
         search_field->setFocus();
     }
@@ -310,6 +335,24 @@ void GameList::PopupContextMenu(const QPoint& menu_location) {
     open_save_location->setEnabled(program_id != 0);
     connect(open_save_location, &QAction::triggered,
             [&]() { emit OpenSaveFolderRequested(program_id); });
+
+    context_menu.addSeparator();
+    QAction* verify = context_menu.addAction(tr("Verify Integrity"));
+    QAction* verify_all = context_menu.addAction(tr("Verify Integrity of All Games"));
+    verify->setEnabled(!verifying);
+    verify_all->setEnabled(!verifying);
+    connect(verify, &QAction::triggered, [&]() {
+        VerifyIntegrity({child_file->data(GameListItemPath::FullPathRole).toString()});
+    });
+    connect(verify_all, &QAction::triggered, [&]() {
+        QStringList paths;
+        for (int i = 0; i < item_model->rowCount(); ++i) {
+            paths.append(item_model->item(i, COLUMN_NAME)
+                             ->data(GameListItemPath::FullPathRole)
+                             .toString());
+        }
+        VerifyIntegrity(paths);
+    });
     context_menu.exec(tree_view->viewport()->mapToGlobal(menu_location));
 }
 
@@ -321,15 +364,18 @@ void GameList::PopulateAsync(const QString& dir_path, bool deep_scan) {
         return;
     }
 
-    tree_view->setEnabled(false);
-    // Delete any rows that might already exist if we're repopulating
+    // Delete any rows that might already exist if we're repopulating. The list stays enabled, and
+    // shows the entries as they are found.
     item_model->removeRows(0, item_model->rowCount());
+    visible_rows = 0;
+    search_field->setFilterResult(0, 0);
 
     emit ShouldCancelWorker();
 
     GameListWorker* worker = new GameListWorker(dir_path, deep_scan);
 
-    connect(worker, &GameListWorker::EntryReady, this, &GameList::AddEntry, Qt::QueuedConnection);
+    connect(worker, &GameListWorker::EntriesReady, this, &GameList::AddEntries,
+            Qt::QueuedConnection);
     connect(worker, &GameListWorker::Finished, this, &GameList::DonePopulating,
             Qt::QueuedConnection);
     // Use DirectConnection here because worker->Cancel() is thread-safe and we want it to cancel
@@ -341,6 +387,26 @@ void GameList::PopulateAsync(const QString& dir_path, bool deep_scan) {
     current_worker = std::move(worker);
 }
 
+void GameList::VerifyIntegrity(const QStringList& paths) {
+    verifying = true;
+
+    GameListVerifier* verifier = new GameListVerifier(paths);
+    connect(verifier, &GameListVerifier::Finished, this, &GameList::DoneVerifying,
+            Qt::QueuedConnection);
+    connect(this, &GameList::ShouldCancelVerifier, verifier, &GameListVerifier::Cancel,
+            Qt::DirectConnection);
+    QThreadPool::globalInstance()->start(verifier);
+}
+
+void GameList::DoneVerifying(QString summary, QString details) {
+    verifying = false;
+
+    QMessageBox message_box(QMessageBox::Information, tr("Verify Integrity"), summary,
+                            QMessageBox::Ok, this);
+    message_box.setDetailedText(details);
+    message_box.exec();
+}
+
 void GameList::SaveInterfaceLayout() {
     UISettings::values.gamelist_header_state = tree_view->header()->saveState();
 }
@@ -372,6 +438,165 @@ void GameList::RefreshGameDirectory() {
     }
 }
 
+namespace {
+/// Runs a function on a thread pool
+class FunctionRunnable : public QRunnable {
+public:
+    explicit FunctionRunnable(std::function<void()> function) : function(std::move(function)) {}
+
+    void run() override {
+        function();
+    }
+
+private:
+    std::function<void()> function;
+};
+
+bool ReadMetadataWithLoader(const QString& path, GameListMetadata& metadata) {
+    std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(path.toStdString());
+    if (!loader)
+        return false;
+
+    loader->ReadIcon(metadata.smdh);
+    loader->ReadProgramId(metadata.program_id);
+    metadata.file_type = QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()));
+    return true;
+}
+
+/// Number of entries the worker hands to the GUI at a time
+constexpr int ENTRY_BATCH_SIZE = 32;
+
+constexpr u64 MEDIA_UNIT_SIZE = 0x200;
+/// Amount hashed between checks for cancellation, which is also how far ahead reads are hinted
+constexpr u64 HASH_CHUNK_SIZE = 4 * 1024 * 1024;
+/// Set in the last byte of the NCCH flags when the contents are stored decrypted
+constexpr u8 NCCH_NO_CRYPTO_FLAG = 0x4;
+
+using SHA256Digest = std::array<u8, CryptoPP::SHA256::DIGESTSIZE>;
+
+struct Partition {
+    u64 offset;
+    u64 size;
+};
+
+/**
+ * Finds the NCCH partitions of a CCI or CXI file
+ * @return The partitions, or the whole file as a single partition if it isn't made of NCCHs
+ */
+std::vector<Partition> FindPartitions(const FileUtil::MappedFile& file, bool& is_ncch) {
+    // The NCSD header of a CCI starts like an NCCH header, with a signature then the magic
+    NCCH_Header header;
+    is_ncch = file.ReadBytes(0, sizeof(header), &header) == sizeof(header);
+    if (is_ncch && header.magic == Loader::MakeMagic('N', 'C', 'S', 'D')) {
+        constexpr size_t NCSD_PARTITION_TABLE_OFFSET = 0x120;
+        std::array<u32_le, 16> table;
+        std::memcpy(table.data(),
+                    reinterpret_cast<const u8*>(&header) + NCSD_PARTITION_TABLE_OFFSET,
+                    sizeof(table));
+
+        std::vector<Partition> partitions;
+        for (size_t i = 0; i < table.size(); i += 2) {
+            if (table[i + 1] != 0)
+                partitions.push_back({table[i] * MEDIA_UNIT_SIZE, table[i + 1] * MEDIA_UNIT_SIZE});
+        }
+        return partitions;
+    }
+    if (is_ncch && header.magic == Loader::MakeMagic('N', 'C', 'C', 'H'))
+        return {{0, header.content_size * MEDIA_UNIT_SIZE}};
+
+    is_ncch = false;
+    return {{0, file.GetSize()}};
+}
+
+/**
+ * Hashes a region of a mapped file, asking the system to read ahead of the hashing
+ * @return Whether the region was hashed, as it may be past the end of a truncated file
+ */
+bool HashRegion(const FileUtil::MappedFile& file, u64 offset, u64 size,
+                const std::atomic_bool& stop_processing, SHA256Digest& digest) {
+    if (offset > file.GetSize() || size > file.GetSize() - offset)
+        return false;
+
+    CryptoPP::SHA256 sha;
+    for (u64 done = 0; done < size; done += HASH_CHUNK_SIZE) {
+        if (stop_processing)
+            return false;
+        const u64 chunk = std::min(HASH_CHUNK_SIZE, size - done);
+        file.Prefetch(offset + done + chunk, HASH_CHUNK_SIZE);
+        sha.Update(file.GetData() + offset + done, static_cast<size_t>(chunk));
+    }
+    sha.Final(digest.data());
+    return true;
+}
+
+/// Checks the hashes an NCCH stores of its extended header, ExeFS and RomFS
+GameListIntegrity CheckNCCHHashes(const FileUtil::MappedFile& file, u64 offset,
+                                  const std::atomic_bool& stop_processing) {
+    NCCH_Header header;
+    if (file.ReadBytes(offset, sizeof(header), &header) != sizeof(header) ||
+        header.magic != Loader::MakeMagic('N', 'C', 'C', 'H')) {
+        return GameListIntegrity::Corrupted;
+    }
+
+    bool matches = true;
+    const auto check = [&](u64 region_offset, u64 region_size, const u8* expected) {
+        SHA256Digest digest;
+        if (!HashRegion(file, offset + region_offset, region_size, stop_processing, digest) ||
+            std::memcmp(digest.data(), expected, digest.size()) != 0) {
+            matches = false;
+            return false;
+        }
+        return true;
+    };
+
+    if (header.extended_header_size != 0)
+        check(sizeof(header), header.extended_header_size, header.extended_header_hash);
+
+    // The super block hash covers the ExeFS header, which holds the hashes of the sections
+    const u64 exefs_offset = header.exefs_offset * MEDIA_UNIT_SIZE;
+    if (header.exefs_size != 0 &&
+        check(exefs_offset, header.exefs_hash_region_size * MEDIA_UNIT_SIZE,
+              header.exefs_super_block_hash)) {
+        ExeFs_Header exefs_header;
+        file.ReadBytes(offset + exefs_offset, sizeof(exefs_header), &exefs_header);
+        for (size_t i = 0; i < 8; ++i) {
+            // The hashes are stored in the reverse order of the sections
+            const ExeFs_SectionHeader& section = exefs_header.section[i];
+            if (section.size != 0) {
+                check(exefs_offset + sizeof(exefs_header) + section.offset, section.size,
+                      exefs_header.hashes[7 - i]);
+            }
+        }
+    }
+
+    if (header.romfs_size != 0) {
+        check(header.romfs_offset * MEDIA_UNIT_SIZE,
+              header.romfs_hash_region_size * MEDIA_UNIT_SIZE, header.romfs_super_block_hash);
+    }
+
+    if (matches)
+        return GameListIntegrity::Verified;
+    // The hashes are of the decrypted contents, so they can only be checked on decrypted dumps
+    return (header.flags[7] & NCCH_NO_CRYPTO_FLAG) != 0 ? GameListIntegrity::Corrupted
+                                                        : GameListIntegrity::Encrypted;
+}
+
+QString GetIntegrityString(GameListIntegrity integrity) {
+    switch (integrity) {
+    case GameListIntegrity::Verified:
+        return QObject::tr("Intact");
+    case GameListIntegrity::NoHashes:
+        return QObject::tr("No hashes to check");
+    case GameListIntegrity::Encrypted:
+        return QObject::tr("Encrypted, could not be checked");
+    case GameListIntegrity::Corrupted:
+        return QObject::tr("Corrupted or truncated");
+    default:
+        return QObject::tr("Not verified");
+    }
+}
+} // Anonymous namespace
+
 void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion) {
     const auto callback = [this, recursion](unsigned* num_entries_out, const std::string& directory,
                                             const std::string& virtual_name) -> bool {
@@ -382,22 +607,19 @@ void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsign
 
         bool is_dir = FileUtil::IsDirectory(physical_name);
         if (!is_dir && HasSupportedFileExtension(physical_name)) {
-            std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(physical_name);
-            if (!loader)
-                return true;
-
-            std::vector<u8> smdh;
-            loader->ReadIcon(smdh);
-
-            u64 program_id = 0;
-            loader->ReadProgramId(program_id);
-
-            emit EntryReady({
-                new GameListItemPath(QString::fromStdString(physical_name), smdh, program_id),
-                new GameListItem(
-                    QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()))),
-                new GameListItemSize(FileUtil::GetSize(physical_name)),
-            });
+            const QString path = QString::fromStdString(physical_name);
+            const QFileInfo file_info(path);
+            const qint64 size = file_info.size();
+            const qint64 modified_time = file_info.lastModified().toMSecsSinceEpoch();
+
+            GameListMetadata metadata;
+            if (cache.Find(path, size, modified_time, metadata)) {
+                EmitEntry(path, metadata, size);
+            } else {
+                read_pool.start(new FunctionRunnable([this, path, size, modified_time] {
+                    ReadMetadata(path, size, modified_time);
+                }));
+            }
         } else if (is_dir && recursion > 0) {
             watch_list.append(QString::fromStdString(physical_name));
             AddFstEntriesToGameList(physical_name, recursion - 1);
@@ -409,10 +631,57 @@ void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsign
     FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
 }
 
+void GameListWorker::ReadMetadata(const QString& path, qint64 size, qint64 modified_time) {
+    if (stop_processing)
+        return;
+
+    GameListMetadata metadata;
+    if (!ReadMetadataWithLoader(path, metadata))
+        return;
+
+    cache.Insert(path, size, modified_time, metadata);
+    EmitEntry(path, metadata, size);
+}
+
+void GameListWorker::EmitEntry(const QString& path, const GameListMetadata& metadata,
+                               qint64 size) {
+    // The items are made here, on the thread that read the metadata, decoding the icon with it
+    QList<QStandardItem*> entry_items{
+        new GameListItemPath(path, metadata.smdh, metadata.program_id),
+        new GameListItem(metadata.file_type),
+        new GameListItemSize(static_cast<qulonglong>(size)),
+    };
+
+    bool batch_full;
+    {
+        std::lock_guard<std::mutex> lock(pending_entries_mutex);
+        pending_entries.append(std::move(entry_items));
+        batch_full = pending_entries.size() >= ENTRY_BATCH_SIZE;
+    }
+    if (batch_full)
+        EmitPendingEntries();
+}
+
+void GameListWorker::EmitPendingEntries() {
+    QList<QList<QStandardItem*>> entries;
+    {
+        std::lock_guard<std::mutex> lock(pending_entries_mutex);
+        entries.swap(pending_entries);
+    }
+    if (!entries.isEmpty())
+        emit EntriesReady(entries);
+}
+
 void GameListWorker::run() {
     stop_processing = false;
     watch_list.append(dir_path);
+    cache.Load();
     AddFstEntriesToGameList(dir_path.toStdString(), deep_scan ? 256 : 0);
+    read_pool.waitForDone();
+    EmitPendingEntries();
+    // A cancelled scan hasn't seen every file, and would drop the ones it missed from the cache
+    if (!stop_processing)
+        cache.Save();
     emit Finished(watch_list);
 }
 
@@ -420,3 +689,127 @@ void GameListWorker::Cancel() {
     this->disconnect();
     stop_processing = true;
 }
+
+void GameListVerifier::run() {
+    struct File {
+        QString path;
+        qint64 size;
+        qint64 modified_time;
+        GameListMetadata metadata;
+        bool in_cache;
+        bool is_ncch;
+        FileUtil::MappedFile mapping;
+        std::vector<GameListIntegrity> partition_integrity;
+        std::vector<SHA256Digest> partition_digests;
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    cache.Load();
+
+    // The partitions of every file are queued up front, so that small files are read alongside
+    // the large ones instead of waiting behind them
+    std::vector<File> files(paths.size());
+    u64 bytes_hashed = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        File& file = files[i];
+        const QFileInfo file_info(paths[i]);
+        file.path = paths[i];
+        file.size = file_info.size();
+        file.modified_time = file_info.lastModified().toMSecsSinceEpoch();
+        file.in_cache = cache.Find(file.path, file.size, file.modified_time, file.metadata);
+        if (file.in_cache && file.metadata.integrity != GameListIntegrity::NotVerified)
+            continue;
+
+        if (!file.mapping.Open(file.path.toStdString())) {
+            file.partition_integrity.push_back(GameListIntegrity::Corrupted);
+            continue;
+        }
+
+        const std::vector<Partition> partitions = FindPartitions(file.mapping, file.is_ncch);
+        if (partitions.empty()) {
+            file.partition_integrity.push_back(GameListIntegrity::Corrupted);
+            continue;
+        }
+        file.partition_integrity.resize(partitions.size());
+        file.partition_digests.resize(partitions.size());
+        for (size_t j = 0; j < partitions.size(); ++j) {
+            const Partition partition = partitions[j];
+            bytes_hashed += partition.size;
+            hash_pool.start(new FunctionRunnable([this, &file, j, partition] {
+                GameListIntegrity& integrity = file.partition_integrity[j];
+                integrity = file.is_ncch
+                                ? CheckNCCHHashes(file.mapping, partition.offset, stop_processing)
+                                : GameListIntegrity::NoHashes;
+                if (!HashRegion(file.mapping, partition.offset, partition.size, stop_processing,
+                                file.partition_digests[j])) {
+                    integrity = GameListIntegrity::Corrupted;
+                }
+            }));
+        }
+    }
+    hash_pool.waitForDone();
+    if (stop_processing)
+        return;
+    const double seconds = timer.elapsed() / 1000.0;
+
+    std::array<int, 5> counts{};
+    int cached_count = 0;
+    QString details;
+    for (File& file : files) {
+        if (file.in_cache && file.metadata.integrity != GameListIntegrity::NotVerified) {
+            ++cached_count;
+        } else {
+            // A file is as good as its worst partition
+            file.metadata.integrity =
+                *std::max_element(file.partition_integrity.begin(), file.partition_integrity.end());
+            file.metadata.partition_hashes.clear();
+            for (const SHA256Digest& digest : file.partition_digests) {
+                file.metadata.partition_hashes.append(QByteArray(
+                    reinterpret_cast<const char*>(digest.data()), static_cast<int>(digest.size())));
+            }
+            if (file.in_cache || ReadMetadataWithLoader(file.path, file.metadata))
+                cache.Insert(file.path, file.size, file.modified_time, file.metadata);
+        }
+        ++counts[static_cast<size_t>(file.metadata.integrity)];
+
+        details += QStringLiteral("%1: %2\n")
+                       .arg(QFileInfo(file.path).fileName(),
+                            GetIntegrityString(file.metadata.integrity));
+        for (int i = 0; i < file.metadata.partition_hashes.size(); ++i) {
+            details += tr("    SHA-256 of partition %1: %2\n")
+                           .arg(i)
+                           .arg(QString(file.metadata.partition_hashes[i].toHex()));
+        }
+    }
+    // Only the files looked at are in use, but the others are still in the game directory
+    cache.Save(false);
+
+    const double mib_hashed = bytes_hashed / (1024.0 * 1024.0);
+    const double throughput = seconds > 0.0 ? mib_hashed / seconds : 0.0;
+    LOG_INFO(Frontend, "Verified %zu files, hashing %.1f MiB in %.2f s (%.1f MiB/s)",
+             files.size(), mib_hashed, seconds, throughput);
+
+    QString summary = tr("%1 intact, %2 corrupted or truncated, %3 encrypted and %4 without "
+                         "hashes out of %5 files.")
+                          .arg(counts[static_cast<size_t>(GameListIntegrity::Verified)])
+                          .arg(counts[static_cast<size_t>(GameListIntegrity::Corrupted)])
+                          .arg(counts[static_cast<size_t>(GameListIntegrity::Encrypted)])
+                          .arg(counts[static_cast<size_t>(GameListIntegrity::NoHashes)])
+                          .arg(files.size());
+    summary += QStringLiteral("\n") + tr("Read %1 MiB in %2 s (%3 MiB/s).")
+                                          .arg(mib_hashed, 0, 'f', 1)
+                                          .arg(seconds, 0, 'f', 2)
+                                          .arg(throughput, 0, 'f', 1);
+    if (cached_count != 0) {
+        summary += QStringLiteral("\n") +
+                   tr("%1 unchanged files were verified before, and not read again.")
+                       .arg(cached_count);
+    }
+    emit Finished(summary, details);
+}
+
+void GameListVerifier::Cancel() {
+    this->disconnect();
+    stop_processing = true;
+}
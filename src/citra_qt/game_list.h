@@ -77,17 +77,23 @@ signals:
     void GameChosen(QString game_path);
     void ShouldCancelWorker();
     void OpenSaveFolderRequested(u64 program_id);
+    void ShouldCancelVerifier();
 
 private slots:
     void onTextChanged(const QString& newText);
     void onFilterCloseClicked();
 
 private:
-    void AddEntry(const QList<QStandardItem*>& entry_items);
+    void AddEntries(const QList<QList<QStandardItem*>>& entries);
+    /// Whether the row matches the text of the search field
+    bool MatchesFilter(int row);
     void ValidateEntry(const QModelIndex& item);
     void DonePopulating(QStringList watch_list);
 
     void PopupContextMenu(const QPoint& menu_location);
+    /// Verifies the files in the background, then shows the results
+    void VerifyIntegrity(const QStringList& paths);
+    void DoneVerifying(QString summary, QString details);
     void RefreshGameDirectory();
     bool containsAllWords(QString haystack, QString userinput);
 
@@ -97,5 +103,10 @@ private:
     QTreeView* tree_view = nullptr;
     QStandardItemModel* item_model = nullptr;
     GameListWorker* current_worker = nullptr;
+    /// Lowercase text of the search field, and the number of rows matching it
+    QString filter_text;
+    int visible_rows = 0;
     QFileSystemWatcher* watcher = nullptr;
+    /// Only one verification runs at a time, as they would slow each other down
+    bool verifying = false;
 };
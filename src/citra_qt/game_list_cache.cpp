@@ -0,0 +1,155 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <list>
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include "citra_qt/game_list_cache.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+
+/// Identifies the cache file, and changes whenever its layout does
+constexpr quint32 CACHE_MAGIC = 0x43474C02;
+
+/// Number of decoded icons kept around
+constexpr size_t MAX_CACHED_ICONS = 1024;
+
+struct CachedIcon {
+    u64 program_id;
+    /// Hash of the SMDH the icon was decoded from, as homebrew shares a program ID of 0
+    u64 smdh_hash;
+    QImage icon;
+};
+
+static std::mutex icon_mutex;
+/// Decoded icons, most recently used first
+static std::list<CachedIcon> icons;
+static QHash<u64, std::list<CachedIcon>::iterator> icon_lookup;
+
+static QString GetCacheFilePath() {
+    return QString::fromStdString(FileUtil::GetUserPath(D_CACHE_IDX) + "game_list.bin");
+}
+
+void GameListCache::Load() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+
+    QFile file(GetCacheFilePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+    quint32 magic;
+    quint32 count;
+    stream >> magic >> count;
+    if (magic != CACHE_MAGIC) {
+        LOG_WARNING(Frontend, "Ignoring game list cache with an unknown format");
+        return;
+    }
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Entry entry{};
+        quint64 program_id;
+        QByteArray smdh;
+        quint8 integrity;
+        stream >> path >> entry.size >> entry.modified_time >> entry.metadata.file_type >>
+            program_id >> smdh >> integrity >> entry.metadata.partition_hashes;
+
+        // The SMDH is mostly made of the icons, which compress well
+        smdh = qUncompress(smdh);
+        entry.metadata.program_id = program_id;
+        entry.metadata.smdh.assign(smdh.begin(), smdh.end());
+        entry.metadata.integrity = static_cast<GameListIntegrity>(integrity);
+        entry.used = false;
+        if (stream.status() == QDataStream::Ok)
+            entries.insert(path, std::move(entry));
+    }
+}
+
+void GameListCache::Save(bool drop_unused) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    FileUtil::CreateFullPath(FileUtil::GetUserPath(D_CACHE_IDX));
+    QSaveFile file(GetCacheFilePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_ERROR(Frontend, "Could not write the game list cache");
+        return;
+    }
+
+    quint32 count = 0;
+    for (const Entry& entry : entries) {
+        if (entry.used || !drop_unused)
+            ++count;
+    }
+
+    QDataStream stream(&file);
+    stream << CACHE_MAGIC << count;
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        const Entry& entry = it.value();
+        if (!entry.used && drop_unused)
+            continue;
+
+        const QByteArray smdh(reinterpret_cast<const char*>(entry.metadata.smdh.data()),
+                              static_cast<int>(entry.metadata.smdh.size()));
+        stream << it.key() << entry.size << entry.modified_time << entry.metadata.file_type
+               << static_cast<quint64>(entry.metadata.program_id) << qCompress(smdh)
+               << static_cast<quint8>(entry.metadata.integrity) << entry.metadata.partition_hashes;
+    }
+    file.commit();
+}
+
+bool GameListCache::Find(const QString& path, qint64 size, qint64 modified_time,
+                         GameListMetadata& metadata) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(path);
+    if (it == entries.end() || it->size != size || it->modified_time != modified_time)
+        return false;
+
+    it->used = true;
+    metadata = it->metadata;
+    return true;
+}
+
+void GameListCache::Insert(const QString& path, qint64 size, qint64 modified_time,
+                           const GameListMetadata& metadata) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.insert(path, {size, modified_time, metadata, true});
+}
+
+QImage GameListCache::GetIcon(u64 program_id, const Loader::SMDH& smdh) {
+    const u64 smdh_hash = Common::ComputeHash64(&smdh, sizeof(smdh));
+    {
+        std::lock_guard<std::mutex> lock(icon_mutex);
+        auto it = icon_lookup.find(program_id);
+        if (it != icon_lookup.end() && it.value()->smdh_hash == smdh_hash) {
+            icons.splice(icons.begin(), icons, it.value());
+            return icons.front().icon;
+        }
+    }
+
+    // Decode outside of the lock, so that the workers of a scan decode in parallel
+    const std::vector<u16> icon_data = smdh.GetIcon(true);
+    const QImage icon = QImage(reinterpret_cast<const uchar*>(icon_data.data()), 48, 48,
+                               QImage::Format::Format_RGB16)
+                            .copy();
+
+    std::lock_guard<std::mutex> lock(icon_mutex);
+    auto it = icon_lookup.find(program_id);
+    if (it != icon_lookup.end()) {
+        icons.erase(it.value());
+        icon_lookup.erase(it);
+    }
+    icons.push_front({program_id, smdh_hash, icon});
+    icon_lookup.insert(program_id, icons.begin());
+
+    if (icons.size() > MAX_CACHED_ICONS) {
+        icon_lookup.remove(icons.back().program_id);
+        icons.pop_back();
+    }
+    return icon;
+}
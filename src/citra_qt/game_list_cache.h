@@ -0,0 +1,80 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QString>
+#include "common/common_types.h"
+#include "core/loader/smdh.h"
+
+/// Outcome of checking a game file against the hashes stored in it, from best to worst
+enum class GameListIntegrity : quint8 {
+    NotVerified,
+    Verified,  ///< Every stored hash matched
+    NoHashes,  ///< The file stores no hashes, so only its digest was computed
+    Encrypted, ///< The stored hashes are of the decrypted contents, so they couldn't be checked
+    Corrupted, ///< A stored hash didn't match, or the file is truncated
+};
+
+/// Metadata of a game file, read by its loader, that the game list shows
+struct GameListMetadata {
+    QString file_type;
+    u64 program_id = 0;
+    std::vector<u8> smdh;
+
+    /// Set by verifying the file, and reset whenever the file changes
+    GameListIntegrity integrity = GameListIntegrity::NotVerified;
+    /// SHA-256 digest of each NCCH partition, or of the whole file if it has none
+    QList<QByteArray> partition_hashes;
+};
+
+/**
+ * Persistent cache of the metadata of the files found in the game directory, so that rescans only
+ * open the files that changed since they were last read. Files are identified by their path, and
+ * considered unchanged while their size and modification time stay the same. Thread-safe.
+ */
+class GameListCache {
+public:
+    /// Loads the cache saved by the last scan, if any
+    void Load();
+
+    /**
+     * Saves the cache
+     * @param drop_unused Whether to drop the entries that weren't looked up or inserted since the
+     *                    cache was loaded, which only a scan of the whole game directory knows
+     */
+    void Save(bool drop_unused = true);
+
+    /**
+     * Looks up the metadata of a file
+     * @return Whether the file was cached and is unchanged since
+     */
+    bool Find(const QString& path, qint64 size, qint64 modified_time, GameListMetadata& metadata);
+
+    void Insert(const QString& path, qint64 size, qint64 modified_time,
+                const GameListMetadata& metadata);
+
+    /**
+     * Returns the large icon of an SMDH. The most recently used icons are kept decoded by program
+     * ID for the rest of the session, so that rescans don't decode them again.
+     */
+    static QImage GetIcon(u64 program_id, const Loader::SMDH& smdh);
+
+private:
+    struct Entry {
+        qint64 size;
+        qint64 modified_time;
+        GameListMetadata metadata;
+        bool used;
+    };
+
+    std::mutex mutex;
+    QHash<QString, Entry> entries;
+};
@@ -5,28 +5,18 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>
 #include <QImage>
+#include <QPixmap>
 #include <QRunnable>
 #include <QStandardItem>
 #include <QString>
+#include <QThreadPool>
+#include "citra_qt/game_list_cache.h"
 #include "citra_qt/util/util.h"
 #include "common/string_util.h"
 #include "core/loader/smdh.h"
 
-/**
- * Gets the game icon from SMDH data.
- * @param smdh SMDH data
- * @param large If true, returns large icon (48x48), otherwise returns small icon (24x24)
- * @return QPixmap game icon
- */
-static QPixmap GetQPixmapFromSMDH(const Loader::SMDH& smdh, bool large) {
-    std::vector<u16> icon_data = smdh.GetIcon(large);
-    const uchar* data = reinterpret_cast<const uchar*>(icon_data.data());
-    int size = large ? 48 : 24;
-    QImage icon(data, size, size, QImage::Format::Format_RGB16);
-    return QPixmap::fromImage(icon);
-}
-
 /**
  * Gets the default icon (for games without valid SMDH)
  * @param large If true, returns large icon (48x48), otherwise returns small icon (24x24)
@@ -70,6 +60,8 @@ public:
     static const int FullPathRole = Qt::UserRole + 1;
     static const int TitleRole = Qt::UserRole + 2;
     static const int ProgramIdRole = Qt::UserRole + 3;
+    /// Decoded icon, which is turned into a pixmap the first time the row is shown
+    static const int IconRole = Qt::UserRole + 4;
 
     GameListItemPath() : GameListItem() {}
     GameListItemPath(const QString& game_path, const std::vector<u8>& smdh_data, u64 program_id)
@@ -78,16 +70,15 @@ public:
         setData(qulonglong(program_id), ProgramIdRole);
 
         if (!Loader::IsValidSMDH(smdh_data)) {
-            // SMDH is not valid, set a default icon
-            setData(GetDefaultIcon(true), Qt::DecorationRole);
+            // SMDH is not valid, a default icon is shown
             return;
         }
 
         Loader::SMDH smdh;
         memcpy(&smdh, smdh_data.data(), sizeof(Loader::SMDH));
 
-        // Get icon from SMDH
-        setData(GetQPixmapFromSMDH(smdh, true), Qt::DecorationRole);
+        // Items are made on worker threads, which may decode images but not make pixmaps
+        setData(GameListCache::GetIcon(program_id, smdh), IconRole);
 
         // Get title form SMDH
         setData(GetQStringShortTitleFromSMDH(smdh, Loader::SMDH::TitleLanguage::English),
@@ -101,10 +92,22 @@ public:
                               nullptr);
             QString title = data(TitleRole).toString();
             return QString::fromStdString(filename) + (title.isEmpty() ? "" : "\n    " + title);
+        } else if (role == Qt::DecorationRole) {
+            // Only the GUI thread asks for the decoration, for the rows it shows
+            if (!icon.isValid()) {
+                const QImage image = data(IconRole).value<QImage>();
+                icon = image.isNull() ? GetDefaultIcon(true) : QPixmap::fromImage(image);
+            }
+            return icon;
         } else {
             return GameListItem::data(role);
         }
     }
+
+private:
+    /// Pixmap of the icon once it was shown, held in a variant as pixmaps can't be constructed
+    /// outside of the GUI thread
+    mutable QVariant icon;
 };
 
 /**
@@ -163,11 +166,12 @@ public slots:
 
 signals:
     /**
-     * The `EntryReady` signal is emitted once an entry has been prepared and is ready
+     * The `EntriesReady` signal is emitted once a batch of entries has been prepared and is ready
      * to be added to the game list.
-     * @param entry_items a list with `QStandardItem`s that make up the columns of the new entry.
+     * @param entries a list of entries, each a list with the `QStandardItem`s that make up the
+     *                columns of the entry.
      */
-    void EntryReady(QList<QStandardItem*> entry_items);
+    void EntriesReady(QList<QList<QStandardItem*>> entries);
 
     /**
      * After the worker has traversed the game directory looking for entries, this signal is emmited
@@ -181,5 +185,52 @@ private:
     bool deep_scan;
     std::atomic_bool stop_processing;
 
+    GameListCache cache;
+    /// Reads the files missing from the cache, as opening them one after the other is slow
+    QThreadPool read_pool;
+
     void AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion = 0);
+    /// Reads the metadata of a file with its loader, on a thread of read_pool
+    void ReadMetadata(const QString& path, qint64 size, qint64 modified_time);
+    /// Queues an entry, emitting the queued entries once there are enough of them
+    void EmitEntry(const QString& path, const GameListMetadata& metadata, qint64 size);
+    void EmitPendingEntries();
+
+    /// Entries are handed to the GUI in batches, so that it lays out the list once per batch
+    std::mutex pending_entries_mutex;
+    QList<QList<QStandardItem*>> pending_entries;
+};
+
+/**
+ * Checks game files against the hashes stored in their NCCH partitions, and computes the SHA-256
+ * digest of each partition to compare with lists of known good dumps. The partitions of all files
+ * are read in parallel, and the results are kept in the game list cache, so that unchanged files
+ * are not read again.
+ */
+class GameListVerifier : public QObject, public QRunnable {
+    Q_OBJECT
+
+public:
+    explicit GameListVerifier(QStringList paths) : QObject(), QRunnable(), paths(paths) {}
+
+public slots:
+    void run() override;
+    /// Tells the verifier to stop reading files, without reporting a result. Thread-safe.
+    void Cancel();
+
+signals:
+    /**
+     * Emitted once every file has been verified
+     * @param summary How many files were found intact, and the throughput of reading them
+     * @param details The outcome and the digests of each file
+     */
+    void Finished(QString summary, QString details);
+
+private:
+    QStringList paths;
+    std::atomic_bool stop_processing{false};
+
+    GameListCache cache;
+    /// Hashes the partitions, whose reads go on in parallel
+    QThreadPool hash_pool;
 };
@@ -24,11 +24,13 @@
 #include "citra_qt/debugger/graphics/graphics_vertex_shader.h"
 #include "citra_qt/debugger/profiler.h"
 #include "citra_qt/debugger/registers.h"
+#include "citra_qt/debugger/service_calls.h"
 #include "citra_qt/debugger/wait_tree.h"
 #include "citra_qt/game_list.h"
 #include "citra_qt/hotkeys.h"
 #include "citra_qt/main.h"
 #include "citra_qt/ui_settings.h"
+#include "common/file_util.h"
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
@@ -43,6 +45,11 @@
 #include "core/gdbstub/gdbstub.h"
 #include "core/loader/loader.h"
 #include "core/settings.h"
+#include "video_core/video_core.h"
+
+#ifdef ENABLE_WEB_SERVICE
+#include "web_service/web_backend.h"
+#endif
 
 #ifdef QT_STATICPLUGIN
 Q_IMPORT_PLUGIN(QWindowsIntegrationPlugin);
@@ -113,8 +120,13 @@ void GMainWindow::InitializeWidgets() {
     emu_frametime_label->setToolTip(
         tr("Time taken to emulate a 3DS frame, not counting framelimiting or v-sync. For "
            "full-speed emulation this should be at most 16.67 ms."));
+    shader_compile_label = new QLabel();
+    shader_compile_label->setToolTip(
+        tr("Shader programs being built in the background. Draws needing them use a slower "
+           "generic shader until they are ready."));
 
-    for (auto& label : {emu_speed_label, game_fps_label, emu_frametime_label}) {
+    for (auto& label :
+         {emu_speed_label, game_fps_label, emu_frametime_label, shader_compile_label}) {
         label->setVisible(false);
         label->setFrameStyle(QFrame::NoFrame);
         label->setContentsMargins(4, 0, 4, 0);
@@ -182,6 +194,11 @@ void GMainWindow::InitializeDebugWidgets() {
             &WaitTreeWidget::OnEmulationStarting);
     connect(this, &GMainWindow::EmulationStopping, waitTreeWidget,
             &WaitTreeWidget::OnEmulationStopping);
+
+    serviceCallsWidget = new ServiceCallsWidget(this);
+    addDockWidget(Qt::LeftDockWidgetArea, serviceCallsWidget);
+    serviceCallsWidget->hide();
+    debug_menu->addAction(serviceCallsWidget->toggleViewAction());
 }
 
 void GMainWindow::InitializeRecentFileMenuActions() {
@@ -200,6 +217,7 @@ void GMainWindow::InitializeHotkeys() {
     RegisterHotkey("Main Window", "Load File", QKeySequence::Open);
     RegisterHotkey("Main Window", "Swap Screens", QKeySequence::NextChild);
     RegisterHotkey("Main Window", "Start Emulation");
+    RegisterHotkey("Main Window", "Toggle Turbo", QKeySequence(Qt::CTRL + Qt::Key_T));
     LoadHotkeys();
 
     connect(GetHotkey("Main Window", "Load File", this), SIGNAL(activated()), this,
@@ -208,6 +226,8 @@ void GMainWindow::InitializeHotkeys() {
             SLOT(OnStartGame()));
     connect(GetHotkey("Main Window", "Swap Screens", render_window), SIGNAL(activated()), this,
             SLOT(OnSwapScreens()));
+    connect(GetHotkey("Main Window", "Toggle Turbo", render_window), SIGNAL(activated()), this,
+            SLOT(OnToggleTurbo()));
 }
 
 void GMainWindow::SetDefaultUIGeometry() {
@@ -392,16 +412,8 @@ void GMainWindow::BootGame(const QString& filename) {
     emu_thread->start();
 
     connect(render_window, SIGNAL(Closed()), this, SLOT(OnStopGame()));
-    // BlockingQueuedConnection is important here, it makes sure we've finished refreshing our views
-    // before the CPU continues
-    connect(emu_thread.get(), SIGNAL(DebugModeEntered()), registersWidget,
-            SLOT(OnDebugModeEntered()), Qt::BlockingQueuedConnection);
-    connect(emu_thread.get(), SIGNAL(DebugModeEntered()), waitTreeWidget,
-            SLOT(OnDebugModeEntered()), Qt::BlockingQueuedConnection);
-    connect(emu_thread.get(), SIGNAL(DebugModeLeft()), registersWidget, SLOT(OnDebugModeLeft()),
-            Qt::BlockingQueuedConnection);
-    connect(emu_thread.get(), SIGNAL(DebugModeLeft()), waitTreeWidget, SLOT(OnDebugModeLeft()),
-            Qt::BlockingQueuedConnection);
+    // The debugger widgets connect to DebugModeEntered and DebugModeLeft themselves, while they're
+    // visible
 
     // Update the GUI
     registersWidget->OnDebugModeEntered();
@@ -451,6 +463,7 @@ void GMainWindow::ShutdownGame() {
     emu_speed_label->setVisible(false);
     game_fps_label->setVisible(false);
     emu_frametime_label->setVisible(false);
+    shader_compile_label->setVisible(false);
 
     emulation_running = false;
 }
@@ -627,6 +640,11 @@ void GMainWindow::OnSwapScreens() {
     Settings::Apply();
 }
 
+void GMainWindow::OnToggleTurbo() {
+    Settings::values.turbo = !Settings::values.turbo;
+    Settings::Apply();
+}
+
 void GMainWindow::OnCreateGraphicsSurfaceViewer() {
     auto graphicsSurfaceViewerWidget = new GraphicsSurfaceWidget(Pica::g_debug_context, this);
     addDockWidget(Qt::RightDockWidgetArea, graphicsSurfaceViewerWidget);
@@ -642,13 +660,18 @@ void GMainWindow::UpdateStatusBar() {
 
     auto results = Core::System::GetInstance().GetAndResetPerfStats();
 
-    emu_speed_label->setText(tr("Speed: %1%").arg(results.emulation_speed * 100.0, 0, 'f', 0));
+    const QString speed = tr("Speed: %1%").arg(results.emulation_speed * 100.0, 0, 'f', 0);
+    emu_speed_label->setText(Settings::values.turbo ? tr("%1 (Turbo)").arg(speed) : speed);
     game_fps_label->setText(tr("Game: %1 FPS").arg(results.game_fps, 0, 'f', 0));
     emu_frametime_label->setText(tr("Frame: %1 ms").arg(results.frametime * 1000.0, 0, 'f', 2));
 
     emu_speed_label->setVisible(true);
     game_fps_label->setVisible(true);
     emu_frametime_label->setVisible(true);
+
+    const u32 pending_shaders = VideoCore::g_pending_shader_compiles;
+    shader_compile_label->setText(tr("Building %1 shaders").arg(pending_shaders));
+    shader_compile_label->setVisible(pending_shaders != 0);
 }
 
 void GMainWindow::OnCoreError(Core::System::ResultStatus result, std::string details) {
@@ -819,10 +842,17 @@ void GMainWindow::UpdateUITheme() {
 int main(int argc, char* argv[]) {
     Log::Filter log_filter(Log::Level::Info);
     Log::SetFilter(&log_filter);
+    Log::SetLogFile(FileUtil::GetUserPath(D_USER_IDX) + "citra_log.txt");
 
     MicroProfileOnThreadCreate("Frontend");
     SCOPE_EXIT({ MicroProfileShutdown(); });
 
+#ifdef ENABLE_WEB_SERVICE
+    // Stopped after the emulated system, which posts its telemetry when it shuts down
+    WebService::Init();
+    SCOPE_EXIT({ WebService::Shutdown(); });
+#endif
+
     // Init settings params
     QCoreApplication::setOrganizationName("Citra team");
     QCoreApplication::setApplicationName("Citra");
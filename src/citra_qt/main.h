@@ -24,6 +24,7 @@ class GRenderWindow;
 class MicroProfileDialog;
 class ProfilerWidget;
 class RegistersWidget;
+class ServiceCallsWidget;
 class WaitTreeWidget;
 
 class GMainWindow : public QMainWindow {
@@ -122,6 +123,7 @@ private slots:
     void OnMenuSelectGameListRoot();
     void OnMenuRecentFile();
     void OnSwapScreens();
+    void OnToggleTurbo();
     void OnConfigure();
     void OnToggleFilterBar();
     void OnDisplayTitleBars(bool);
@@ -142,6 +144,7 @@ private:
     QLabel* emu_speed_label = nullptr;
     QLabel* game_fps_label = nullptr;
     QLabel* emu_frametime_label = nullptr;
+    QLabel* shader_compile_label = nullptr;
     QTimer status_bar_update_timer;
 
     std::unique_ptr<Config> config;
@@ -160,6 +163,7 @@ private:
     GraphicsVertexShaderWidget* graphicsVertexShaderWidget;
     GraphicsTracingWidget* graphicsTracingWidget;
     WaitTreeWidget* waitTreeWidget;
+    ServiceCallsWidget* serviceCallsWidget;
 
     QAction* actions_recent_files[max_recent_files_item];
 
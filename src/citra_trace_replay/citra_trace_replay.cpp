@@ -0,0 +1,209 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// Replays the GPU commands of a CiTrace recording, without the application that made it, and
+// reports how long each frame takes on the CPU and on the GPU. Gives reproducible measurements of
+// the video core on a fixed workload.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include <glad/glad.h>
+#include "citra_trace_replay/emu_window_offscreen.h"
+#include "common/common_types.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scope_exit.h"
+#include "core/core.h"
+#include "core/settings.h"
+#include "core/tracer/player.h"
+#include "video_core/video_core.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct FrameTimes {
+    double cpu_ms = 0.0;
+    double gpu_ms = 0.0;
+};
+
+void PrintHelp(const char* argv0) {
+    std::printf("Usage: %s [options] <trace.ctf>\n"
+                "-b, --backend=NAME     Rasterizer to replay with: gl (default) or software\n"
+                "-n, --iterations=N     Replay the trace N times, the first one warming up\n"
+                "-r, --resolution=N     Internal resolution factor of the gl backend\n"
+                "-s, --hw-shader        Run the shaders on the GPU with the gl backend\n"
+                "-h, --help             Display this help and exit\n",
+                argv0);
+}
+
+/**
+ * Replays every frame of the trace once, timing each of them
+ * @param queries One GL_TIME_ELAPSED query per frame, which this waits for the results of
+ */
+std::vector<FrameTimes> ReplayTrace(CiTrace::Player& player, const std::vector<GLuint>& queries) {
+    std::vector<FrameTimes> times(player.GetFrameCount());
+
+    player.RestoreInitialState();
+    for (size_t frame = 0; frame < times.size(); ++frame) {
+        glBeginQuery(GL_TIME_ELAPSED, queries[frame]);
+        const auto start = Clock::now();
+        player.ReplayFrame(frame);
+        times[frame].cpu_ms =
+            std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+
+    for (size_t frame = 0; frame < times.size(); ++frame) {
+        GLuint64 elapsed_ns;
+        glGetQueryObjectui64v(queries[frame], GL_QUERY_RESULT, &elapsed_ns);
+        times[frame].gpu_ms = elapsed_ns / 1e6;
+    }
+    return times;
+}
+
+} // Anonymous namespace
+
+int main(int argc, char** argv) {
+    Log::Filter log_filter(Log::Level::Warning);
+    Log::SetFilter(&log_filter);
+
+    bool use_hw_renderer = true;
+    bool use_hw_shader = false;
+    unsigned iterations = 1;
+    float resolution_factor = 1.0f;
+
+    static struct option long_options[] = {
+        {"backend", required_argument, 0, 'b'},
+        {"iterations", required_argument, 0, 'n'},
+        {"resolution", required_argument, 0, 'r'},
+        {"hw-shader", no_argument, 0, 's'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0},
+    };
+
+    int option_index = 0;
+    int arg;
+    while ((arg = getopt_long(argc, argv, "b:n:r:sh", long_options, &option_index)) != -1) {
+        switch (arg) {
+        case 'b':
+            if (std::strcmp(optarg, "gl") == 0) {
+                use_hw_renderer = true;
+            } else if (std::strcmp(optarg, "software") == 0) {
+                use_hw_renderer = false;
+            } else {
+                std::fprintf(stderr, "Unknown backend %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            iterations = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'r':
+            resolution_factor = static_cast<float>(std::strtod(optarg, nullptr));
+            break;
+        case 's':
+            use_hw_shader = true;
+            break;
+        case 'h':
+            PrintHelp(argv[0]);
+            return 0;
+        default:
+            PrintHelp(argv[0]);
+            return 1;
+        }
+    }
+    if (optind + 1 != argc || iterations == 0 || resolution_factor <= 0.0f) {
+        PrintHelp(argv[0]);
+        return 1;
+    }
+    const std::string filename = argv[optind];
+
+    // Nothing here reads a configuration file, so only what the replay needs is set up. Work is
+    // kept on this thread and unthrottled, so that it can be timed.
+    Settings::values.use_hw_renderer = use_hw_renderer;
+    Settings::values.use_hw_shader = use_hw_shader;
+    Settings::values.use_shader_jit = true;
+    Settings::values.resolution_factor = resolution_factor;
+    Settings::values.toggle_framelimit = false;
+    Settings::values.use_vsync = false;
+    Settings::values.use_disk_shader_cache = false;
+    Settings::values.use_gpu_thread = false;
+    Settings::values.use_presentation_thread = false;
+    VideoCore::g_hw_renderer_enabled = use_hw_renderer;
+    VideoCore::g_hw_shader_enabled = use_hw_shader;
+    VideoCore::g_shader_jit_enabled = true;
+    VideoCore::g_toggle_framelimit_enabled = false;
+
+    EmuWindow_Offscreen emu_window;
+    if (!emu_window.IsValid()) {
+        return 1;
+    }
+
+    Core::System& system = Core::System::GetInstance();
+    if (system.InitTraceReplay(&emu_window) != Core::System::ResultStatus::Success) {
+        LOG_CRITICAL(Frontend, "Failed to initialize the video core");
+        return 1;
+    }
+
+    // The renderer still writes back to the player's memory while shutting down
+    auto player = std::make_unique<CiTrace::Player>();
+    SCOPE_EXIT({
+        system.ShutdownTraceReplay();
+        player = nullptr;
+    });
+
+    if (!player->Load(filename)) {
+        return 1;
+    }
+    const size_t frame_count = player->GetFrameCount();
+
+    std::vector<GLuint> queries(frame_count);
+    glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+    SCOPE_EXIT({ glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data()); });
+
+    std::printf("%s: %zu frames, %s backend, %u iteration%s\n", filename.c_str(), frame_count,
+                use_hw_renderer ? "gl" : "software", iterations, iterations == 1 ? "" : "s");
+
+    // The first replay compiles shaders and fills caches, so it is reported on its own
+    const std::vector<FrameTimes> first = ReplayTrace(*player, queries);
+    std::vector<FrameTimes> average(frame_count);
+    for (unsigned i = 1; i < iterations; ++i) {
+        const std::vector<FrameTimes> times = ReplayTrace(*player, queries);
+        for (size_t frame = 0; frame < frame_count; ++frame) {
+            average[frame].cpu_ms += times[frame].cpu_ms / (iterations - 1);
+            average[frame].gpu_ms += times[frame].gpu_ms / (iterations - 1);
+        }
+    }
+
+    std::printf("%6s %12s %12s %12s %12s\n", "frame", "first cpu", "first gpu", "avg cpu",
+                "avg gpu");
+    FrameTimes first_total, average_total;
+    for (size_t frame = 0; frame < frame_count; ++frame) {
+        std::printf("%6zu %9.3f ms %9.3f ms", frame, first[frame].cpu_ms, first[frame].gpu_ms);
+        if (iterations > 1) {
+            std::printf(" %9.3f ms %9.3f ms", average[frame].cpu_ms, average[frame].gpu_ms);
+        }
+        std::printf("\n");
+
+        first_total.cpu_ms += first[frame].cpu_ms;
+        first_total.gpu_ms += first[frame].gpu_ms;
+        average_total.cpu_ms += average[frame].cpu_ms;
+        average_total.gpu_ms += average[frame].gpu_ms;
+    }
+    std::printf("%6s %9.3f ms %9.3f ms", "total", first_total.cpu_ms, first_total.gpu_ms);
+    if (iterations > 1) {
+        std::printf(" %9.3f ms %9.3f ms", average_total.cpu_ms, average_total.gpu_ms);
+    }
+    std::printf("\n");
+
+    return 0;
+}
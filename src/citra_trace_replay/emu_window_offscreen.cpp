@@ -0,0 +1,83 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <glad/glad.h>
+#include "citra_trace_replay/emu_window_offscreen.h"
+#include "common/logging/log.h"
+#include "core/3ds.h"
+
+EmuWindow_Offscreen::EmuWindow_Offscreen() {
+    SDL_SetMainReady();
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        LOG_CRITICAL(Frontend, "Failed to initialize SDL2: %s", SDL_GetError());
+        return;
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+
+    const unsigned width = Core::kScreenTopWidth;
+    const unsigned height = Core::kScreenTopHeight + Core::kScreenBottomHeight;
+    render_window = SDL_CreateWindow("citra-trace-replay", SDL_WINDOWPOS_UNDEFINED,
+                                     SDL_WINDOWPOS_UNDEFINED, width, height,
+                                     SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (render_window == nullptr) {
+        LOG_CRITICAL(Frontend, "Failed to create SDL2 window: %s", SDL_GetError());
+        return;
+    }
+
+    gl_context = SDL_GL_CreateContext(render_window);
+    if (gl_context == nullptr) {
+        LOG_CRITICAL(Frontend, "Failed to create SDL2 GL context: %s", SDL_GetError());
+        return;
+    }
+
+    if (!gladLoadGLLoader(static_cast<GLADloadproc>(SDL_GL_GetProcAddress))) {
+        LOG_CRITICAL(Frontend, "Failed to initialize GL functions");
+        SDL_GL_DeleteContext(gl_context);
+        gl_context = nullptr;
+        return;
+    }
+
+    // Frames are timed, so don't wait for vsync when presenting them
+    SDL_GL_SetSwapInterval(0);
+    UpdateCurrentFramebufferLayout(width, height);
+
+    DoneCurrent();
+}
+
+EmuWindow_Offscreen::~EmuWindow_Offscreen() {
+    if (gl_context != nullptr) {
+        SDL_GL_DeleteContext(gl_context);
+    }
+    if (render_window != nullptr) {
+        SDL_DestroyWindow(render_window);
+    }
+    SDL_Quit();
+}
+
+bool EmuWindow_Offscreen::IsValid() const {
+    return gl_context != nullptr;
+}
+
+void EmuWindow_Offscreen::SwapBuffers() {
+    SDL_GL_SwapWindow(render_window);
+}
+
+void EmuWindow_Offscreen::PollEvents() {
+    SDL_PumpEvents();
+}
+
+void EmuWindow_Offscreen::MakeCurrent() {
+    SDL_GL_MakeCurrent(render_window, gl_context);
+}
+
+void EmuWindow_Offscreen::DoneCurrent() {
+    SDL_GL_MakeCurrent(render_window, nullptr);
+}
@@ -0,0 +1,43 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <utility>
+#include "core/frontend/emu_window.h"
+
+struct SDL_Window;
+
+/// Hidden SDL2 window, giving the renderer a GL context without showing anything on screen
+class EmuWindow_Offscreen : public EmuWindow {
+public:
+    EmuWindow_Offscreen();
+    ~EmuWindow_Offscreen();
+
+    /// Whether the window and its GL context could be created
+    bool IsValid() const;
+
+    /// Swap buffers to display the next frame
+    void SwapBuffers() override;
+
+    /// Polls window events
+    void PollEvents() override;
+
+    /// Makes the graphics context current for the caller thread
+    void MakeCurrent() override;
+
+    /// Releases the GL context from the caller thread
+    void DoneCurrent() override;
+
+private:
+    void OnMinimalClientAreaChangeRequest(
+        const std::pair<unsigned, unsigned>& minimal_size) override {}
+
+    /// Internal SDL2 render window
+    SDL_Window* render_window = nullptr;
+
+    using SDL_GLContext = void*;
+    /// The OpenGL context associated with the window
+    SDL_GLContext gl_context = nullptr;
+};
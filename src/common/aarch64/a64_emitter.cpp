@@ -0,0 +1,421 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "common/aarch64/a64_emitter.h"
+#include "common/assert.h"
+#include "common/memory_util.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace Common {
+namespace A64 {
+
+CodeGenerator::CodeGenerator(size_t max_size) : max_size(max_size) {
+    code = static_cast<u32*>(AllocateExecutableMemory(max_size));
+    ASSERT_MSG(code != nullptr, "Failed to allocate the code buffer");
+}
+
+CodeGenerator::~CodeGenerator() {
+    FreeMemoryPages(code, max_size);
+}
+
+void CodeGenerator::Ready() {
+#ifdef _WIN32
+    FlushInstructionCache(GetCurrentProcess(), code, GetSize());
+#else
+    __builtin___clear_cache(reinterpret_cast<char*>(code), reinterpret_cast<char*>(code + size));
+#endif
+}
+
+void CodeGenerator::Emit(u32 instruction) {
+    ASSERT_MSG(GetSize() + sizeof(u32) <= max_size, "Code buffer overflow");
+    code[size++] = instruction;
+}
+
+u32 CodeGenerator::Patch(u32 instruction, ptrdiff_t displacement, Label::FixupType type) {
+    switch (type) {
+    case Label::FixupType::Branch26: {
+        const ptrdiff_t imm = displacement / 4;
+        ASSERT(imm >= -(1 << 25) && imm < (1 << 25));
+        return (instruction & ~0x03FFFFFFu) | (static_cast<u32>(imm) & 0x03FFFFFF);
+    }
+    case Label::FixupType::Branch19: {
+        const ptrdiff_t imm = displacement / 4;
+        ASSERT(imm >= -(1 << 18) && imm < (1 << 18));
+        return (instruction & ~(0x7FFFFu << 5)) | ((static_cast<u32>(imm) & 0x7FFFF) << 5);
+    }
+    case Label::FixupType::Address21: {
+        ASSERT(displacement >= -(1 << 20) && displacement < (1 << 20));
+        const u32 imm = static_cast<u32>(displacement);
+        return (instruction & ~((0x3u << 29) | (0x7FFFFu << 5))) | ((imm & 0x3) << 29) |
+               (((imm >> 2) & 0x7FFFF) << 5);
+    }
+    }
+    UNREACHABLE();
+    return instruction;
+}
+
+void CodeGenerator::EmitBranch(u32 instruction, Label& label, Label::FixupType type) {
+    const ptrdiff_t position = static_cast<ptrdiff_t>(GetSize());
+    if (label.IsBound()) {
+        Emit(Patch(instruction, label.position - position, type));
+    } else {
+        label.fixups.push_back({static_cast<size_t>(position), type});
+        Emit(instruction);
+    }
+}
+
+void CodeGenerator::L(Label& label) {
+    ASSERT_MSG(!label.IsBound(), "Label bound twice");
+    label.position = static_cast<ptrdiff_t>(GetSize());
+    for (const Label::Fixup& fixup : label.fixups) {
+        u32& instruction = code[fixup.position / sizeof(u32)];
+        instruction = Patch(instruction, label.position - static_cast<ptrdiff_t>(fixup.position),
+                            fixup.type);
+    }
+    label.fixups.clear();
+}
+
+// Moves and arithmetic
+
+void CodeGenerator::MOV(XReg rd, XReg rm) {
+    if (rd.index == 31 || rm.index == 31) {
+        // Register 31 means SP in ADD (immediate), which is how moves from and to SP are encoded
+        ADD(rd, rm, 0);
+    } else {
+        Emit(0xAA0003E0 | (rm.index << 16) | rd.index);
+    }
+}
+
+void CodeGenerator::MOV(WReg rd, WReg rm) {
+    Emit(0x2A0003E0 | (rm.index << 16) | rd.index);
+}
+
+void CodeGenerator::MOVI64(XReg rd, u64 imm) {
+    MOVZ(rd, static_cast<u16>(imm), 0);
+    for (unsigned shift = 16; shift < 64; shift += 16) {
+        const u16 part = static_cast<u16>(imm >> shift);
+        if (part != 0) {
+            MOVK(rd, part, shift);
+        }
+    }
+}
+
+void CodeGenerator::MOVZ(WReg rd, u16 imm, unsigned shift) {
+    ASSERT(shift == 0 || shift == 16);
+    Emit(0x52800000 | ((shift / 16) << 21) | (u32(imm) << 5) | rd.index);
+}
+
+void CodeGenerator::MOVZ(XReg rd, u16 imm, unsigned shift) {
+    ASSERT(shift % 16 == 0 && shift < 64);
+    Emit(0xD2800000 | ((shift / 16) << 21) | (u32(imm) << 5) | rd.index);
+}
+
+void CodeGenerator::MOVK(XReg rd, u16 imm, unsigned shift) {
+    ASSERT(shift % 16 == 0 && shift < 64);
+    Emit(0xF2800000 | ((shift / 16) << 21) | (u32(imm) << 5) | rd.index);
+}
+
+/// Encodes the 12-bit immediate of ADD and SUB, which may be shifted left by 12 bits
+static u32 EncodeArithImm(u32 imm) {
+    if (imm < 0x1000) {
+        return imm << 10;
+    }
+    ASSERT_MSG((imm & 0xFFF) == 0 && imm < 0x1000000, "Immediate not encodable");
+    return (1 << 22) | ((imm >> 12) << 10);
+}
+
+void CodeGenerator::ADD(XReg rd, XReg rn, u32 imm) {
+    Emit(0x91000000 | EncodeArithImm(imm) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::ADD(WReg rd, WReg rn, u32 imm) {
+    Emit(0x11000000 | EncodeArithImm(imm) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::ADD(XReg rd, XReg rn, XReg rm) {
+    Emit(0x8B000000 | (rm.index << 16) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::ADD(WReg rd, WReg rn, WReg rm) {
+    Emit(0x0B000000 | (rm.index << 16) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::SUB(XReg rd, XReg rn, u32 imm) {
+    Emit(0xD1000000 | EncodeArithImm(imm) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::SUBS(WReg rd, WReg rn, u32 imm) {
+    Emit(0x71000000 | EncodeArithImm(imm) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::CMP(WReg rn, u32 imm) {
+    SUBS(WZR, rn, imm);
+}
+
+void CodeGenerator::AND(WReg rd, WReg rn, WReg rm) {
+    Emit(0x0A000000 | (rm.index << 16) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::ORR(WReg rd, WReg rn, WReg rm) {
+    Emit(0x2A000000 | (rm.index << 16) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::EOR(WReg rd, WReg rn, WReg rm) {
+    Emit(0x4A000000 | (rm.index << 16) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::ANDLowBits(WReg rd, WReg rn, unsigned width) {
+    // A run of `width` ones without rotation in a 32-bit element
+    ASSERT(width >= 1 && width < 32);
+    Emit(0x12000000 | ((width - 1) << 10) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::EORLowBits(WReg rd, WReg rn, unsigned width) {
+    ASSERT(width >= 1 && width < 32);
+    Emit(0x52000000 | ((width - 1) << 10) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::UBFX(WReg rd, WReg rn, unsigned lsb, unsigned width) {
+    ASSERT(width >= 1 && lsb + width <= 32);
+    Emit(0x53000000 | (lsb << 16) | ((lsb + width - 1) << 10) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::LSL(WReg rd, WReg rn, unsigned shift) {
+    ASSERT(shift < 32);
+    Emit(0x53000000 | (((32 - shift) % 32) << 16) | ((31 - shift) << 10) | (rn.index << 5) |
+         rd.index);
+}
+
+void CodeGenerator::LSR(WReg rd, WReg rn, unsigned shift) {
+    ASSERT(shift < 32);
+    Emit(0x53000000 | (shift << 16) | (31 << 10) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::SBFIZ(XReg rd, XReg rn, unsigned lsb, unsigned width) {
+    ASSERT(width >= 1 && lsb + width <= 64);
+    Emit(0x93400000 | (((64 - lsb) % 64) << 16) | ((width - 1) << 10) | (rn.index << 5) |
+         rd.index);
+}
+
+// Loads and stores
+
+/// Encodes the unsigned 12-bit offset of a load or store accessing `size` bytes
+static u32 EncodeLoadStoreOffset(u32 offset, u32 size) {
+    ASSERT_MSG(offset % size == 0 && offset / size < 0x1000, "Offset not encodable");
+    return (offset / size) << 10;
+}
+
+void CodeGenerator::LDRB(WReg rt, XReg rn, u32 offset) {
+    Emit(0x39400000 | EncodeLoadStoreOffset(offset, 1) | (rn.index << 5) | rt.index);
+}
+
+void CodeGenerator::STRB(WReg rt, XReg rn, u32 offset) {
+    Emit(0x39000000 | EncodeLoadStoreOffset(offset, 1) | (rn.index << 5) | rt.index);
+}
+
+void CodeGenerator::LDR(WReg rt, XReg rn, u32 offset) {
+    Emit(0xB9400000 | EncodeLoadStoreOffset(offset, 4) | (rn.index << 5) | rt.index);
+}
+
+void CodeGenerator::LDR(XReg rt, XReg rn, u32 offset) {
+    Emit(0xF9400000 | EncodeLoadStoreOffset(offset, 8) | (rn.index << 5) | rt.index);
+}
+
+void CodeGenerator::STR(XReg rt, XReg rn, u32 offset) {
+    Emit(0xF9000000 | EncodeLoadStoreOffset(offset, 8) | (rn.index << 5) | rt.index);
+}
+
+void CodeGenerator::LDRQ(VReg rt, XReg rn, u32 offset) {
+    Emit(0x3DC00000 | EncodeLoadStoreOffset(offset, 16) | (rn.index << 5) | rt.index);
+}
+
+void CodeGenerator::STRQ(VReg rt, XReg rn, u32 offset) {
+    Emit(0x3D800000 | EncodeLoadStoreOffset(offset, 16) | (rn.index << 5) | rt.index);
+}
+
+/// Encodes the registers and signed 7-bit offset of a load or store pair of X registers
+static u32 EncodePair(XReg rt1, XReg rt2, XReg rn, s32 offset) {
+    ASSERT_MSG(offset % 8 == 0 && offset >= -512 && offset < 512, "Offset not encodable");
+    return ((static_cast<u32>(offset / 8) & 0x7F) << 15) | (rt2.index << 10) | (rn.index << 5) |
+           rt1.index;
+}
+
+void CodeGenerator::STP(XReg rt1, XReg rt2, XReg rn, s32 offset) {
+    Emit(0xA9000000 | EncodePair(rt1, rt2, rn, offset));
+}
+
+void CodeGenerator::LDP(XReg rt1, XReg rt2, XReg rn, s32 offset) {
+    Emit(0xA9400000 | EncodePair(rt1, rt2, rn, offset));
+}
+
+void CodeGenerator::STPPre(XReg rt1, XReg rt2, XReg rn, s32 offset) {
+    Emit(0xA9800000 | EncodePair(rt1, rt2, rn, offset));
+}
+
+void CodeGenerator::LDPPost(XReg rt1, XReg rt2, XReg rn, s32 offset) {
+    Emit(0xA8C00000 | EncodePair(rt1, rt2, rn, offset));
+}
+
+// Branches
+
+void CodeGenerator::B(Label& label) {
+    EmitBranch(0x14000000, label, Label::FixupType::Branch26);
+}
+
+void CodeGenerator::B(Cond cond, Label& label) {
+    EmitBranch(0x54000000 | static_cast<u32>(cond), label, Label::FixupType::Branch19);
+}
+
+void CodeGenerator::BL(Label& label) {
+    EmitBranch(0x94000000, label, Label::FixupType::Branch26);
+}
+
+void CodeGenerator::CBZ(WReg rt, Label& label) {
+    EmitBranch(0x34000000 | rt.index, label, Label::FixupType::Branch19);
+}
+
+void CodeGenerator::CBNZ(WReg rt, Label& label) {
+    EmitBranch(0x35000000 | rt.index, label, Label::FixupType::Branch19);
+}
+
+void CodeGenerator::CBZ(XReg rt, Label& label) {
+    EmitBranch(0xB4000000 | rt.index, label, Label::FixupType::Branch19);
+}
+
+void CodeGenerator::CBNZ(XReg rt, Label& label) {
+    EmitBranch(0xB5000000 | rt.index, label, Label::FixupType::Branch19);
+}
+
+void CodeGenerator::BR(XReg rn) {
+    Emit(0xD61F0000 | (rn.index << 5));
+}
+
+void CodeGenerator::BLR(XReg rn) {
+    Emit(0xD63F0000 | (rn.index << 5));
+}
+
+void CodeGenerator::RET(XReg rn) {
+    Emit(0xD65F0000 | (rn.index << 5));
+}
+
+void CodeGenerator::ADR(XReg rd, Label& label) {
+    EmitBranch(0x10000000 | rd.index, label, Label::FixupType::Address21);
+}
+
+// SIMD&FP
+
+/// Encodes a three-register SIMD instruction
+static u32 EncodeThreeSame(u32 opcode, VReg rd, VReg rn, VReg rm) {
+    return opcode | (rm.index << 16) | (rn.index << 5) | rd.index;
+}
+
+void CodeGenerator::FADD(VReg rd, VReg rn, VReg rm) {
+    Emit(EncodeThreeSame(0x4E20D400, rd, rn, rm));
+}
+
+void CodeGenerator::FADDP(VReg rd, VReg rn, VReg rm) {
+    Emit(EncodeThreeSame(0x6E20D400, rd, rn, rm));
+}
+
+void CodeGenerator::FMUL(VReg rd, VReg rn, VReg rm) {
+    Emit(EncodeThreeSame(0x6E20DC00, rd, rn, rm));
+}
+
+void CodeGenerator::FCMEQ(VReg rd, VReg rn, VReg rm) {
+    Emit(EncodeThreeSame(0x4E20E400, rd, rn, rm));
+}
+
+void CodeGenerator::FCMGE(VReg rd, VReg rn, VReg rm) {
+    Emit(EncodeThreeSame(0x6E20E400, rd, rn, rm));
+}
+
+void CodeGenerator::FCMGT(VReg rd, VReg rn, VReg rm) {
+    Emit(EncodeThreeSame(0x6EA0E400, rd, rn, rm));
+}
+
+void CodeGenerator::FRINTM(VReg rd, VReg rn) {
+    Emit(0x4E219800 | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::FCVTZS(VReg rd, VReg rn) {
+    Emit(0x4EA1B800 | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::FNEG(VReg rd, VReg rn) {
+    Emit(0x6EA0F800 | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::FMOV(VReg rd, float imm) {
+    // The 8-bit immediate holds the sign, the three lowest exponent bits (the highest one being
+    // the inverse of the next) and the four highest mantissa bits of the value
+    u32 bits;
+    std::memcpy(&bits, &imm, sizeof(bits));
+    const u32 exponent = (bits >> 23) & 0xFF;
+    ASSERT_MSG((bits & 0x7FFFF) == 0 && (exponent >= 0x7C && exponent <= 0x83),
+               "Value not encodable");
+    const u32 imm8 = ((bits >> 24) & 0x80) | ((bits >> 19) & 0x7F);
+    Emit(0x4F00F400 | ((imm8 >> 5) << 16) | ((imm8 & 0x1F) << 5) | rd.index);
+}
+
+void CodeGenerator::AND(VReg rd, VReg rn, VReg rm) {
+    Emit(EncodeThreeSame(0x4E201C00, rd, rn, rm));
+}
+
+void CodeGenerator::ORR(VReg rd, VReg rn, VReg rm) {
+    Emit(EncodeThreeSame(0x4EA01C00, rd, rn, rm));
+}
+
+void CodeGenerator::ORN(VReg rd, VReg rn, VReg rm) {
+    Emit(EncodeThreeSame(0x4EE01C00, rd, rn, rm));
+}
+
+void CodeGenerator::BSL(VReg rd, VReg rn, VReg rm) {
+    Emit(EncodeThreeSame(0x6E601C00, rd, rn, rm));
+}
+
+void CodeGenerator::NOT(VReg rd, VReg rn) {
+    Emit(0x6E205800 | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::MOV(VReg rd, VReg rn) {
+    ORR(rd, rn, rn);
+}
+
+/// Encodes the imm5 field selecting a single precision lane
+static u32 EncodeLane(unsigned lane) {
+    ASSERT(lane < 4);
+    return ((lane << 3) | 0b100) << 16;
+}
+
+void CodeGenerator::DUP(VReg rd, VReg rn, unsigned lane) {
+    Emit(0x4E000400 | EncodeLane(lane) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::INS(VReg rd, unsigned dst_lane, VReg rn, unsigned src_lane) {
+    ASSERT(src_lane < 4);
+    Emit(0x6E000400 | EncodeLane(dst_lane) | (src_lane << 13) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::INS(VReg rd, unsigned dst_lane, WReg rn) {
+    Emit(0x4E001C00 | EncodeLane(dst_lane) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::UMOV(WReg rd, VReg rn, unsigned lane) {
+    Emit(0x0E003C00 | EncodeLane(lane) | (rn.index << 5) | rd.index);
+}
+
+void CodeGenerator::FDIV_S(VReg rd, VReg rn, VReg rm) {
+    Emit(EncodeThreeSame(0x1E201800, rd, rn, rm));
+}
+
+void CodeGenerator::FSQRT_S(VReg rd, VReg rn) {
+    Emit(0x1E21C000 | (rn.index << 5) | rd.index);
+}
+
+} // namespace A64
+} // namespace Common
@@ -0,0 +1,242 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+
+namespace Common {
+namespace A64 {
+
+/// 64-bit view of a general purpose register. Index 31 stands for SP or XZR, depending on the
+/// instruction.
+struct XReg {
+    constexpr explicit XReg(u32 index) : index(index) {}
+    u32 index;
+};
+
+/// 32-bit view of a general purpose register. Index 31 stands for WSP or WZR, depending on the
+/// instruction.
+struct WReg {
+    constexpr explicit WReg(u32 index) : index(index) {}
+    u32 index;
+};
+
+/// SIMD&FP register, operated on as four single precision lanes or as a single precision scalar
+struct VReg {
+    constexpr explicit VReg(u32 index) : index(index) {}
+    u32 index;
+};
+
+constexpr XReg SP{31};
+constexpr XReg XZR{31};
+constexpr WReg WZR{31};
+
+/// Link register, holding the return address of BL and BLR
+constexpr XReg LR{30};
+
+/// Intra-procedure-call scratch registers, free to be clobbered by any code
+constexpr XReg IP0{16};
+constexpr XReg IP1{17};
+
+/// Parameter registers of the AAPCS64 calling convention
+constexpr XReg ABI_PARAM1{0};
+constexpr XReg ABI_PARAM2{1};
+constexpr XReg ABI_PARAM3{2};
+
+enum class Cond : u32 {
+    EQ = 0,
+    NE = 1,
+    HS = 2,
+    LO = 3,
+    MI = 4,
+    PL = 5,
+    VS = 6,
+    VC = 7,
+    HI = 8,
+    LS = 9,
+    GE = 10,
+    LT = 11,
+    GT = 12,
+    LE = 13,
+    AL = 14,
+};
+
+inline WReg ToW(XReg reg) {
+    return WReg(reg.index);
+}
+
+inline XReg ToX(WReg reg) {
+    return XReg(reg.index);
+}
+
+/// Branch target that can be referred to both before and after it is bound to a code location
+class Label {
+public:
+    bool IsBound() const {
+        return position >= 0;
+    }
+
+private:
+    friend class CodeGenerator;
+
+    enum class FixupType {
+        Branch26, ///< B and BL
+        Branch19, ///< B.cond, CBZ and CBNZ
+        Address21 ///< ADR
+    };
+
+    struct Fixup {
+        size_t position;
+        FixupType type;
+    };
+
+    /// Offset of the location in the code buffer in bytes, or -1 if not bound yet
+    ptrdiff_t position = -1;
+    /// Instructions referring to the label before it was bound
+    std::vector<Fixup> fixups;
+};
+
+/**
+ * Minimal AArch64 assembler emitting into a buffer of executable memory. It only covers the
+ * instructions the JITs need; each method encodes the instruction of the same name, operand order
+ * follows the assembly syntax (destination first).
+ */
+class CodeGenerator : NonCopyable {
+public:
+    explicit CodeGenerator(size_t max_size);
+    ~CodeGenerator();
+
+    /// Returns a pointer to the start of the code buffer
+    const u8* GetCode() const {
+        return reinterpret_cast<const u8*>(code);
+    }
+
+    /// Returns a pointer to where the next instruction is emitted
+    const u8* GetCurrent() const {
+        return reinterpret_cast<const u8*>(code + size);
+    }
+
+    /// Returns the number of bytes emitted so far
+    size_t GetSize() const {
+        return size * sizeof(u32);
+    }
+
+    /// Makes the emitted code visible to instruction fetches, must be called before running it
+    void Ready();
+
+    /// Binds the label to the location of the next instruction
+    void L(Label& label);
+
+    /// Returns the address of the location the label is bound to
+    const u8* GetAddress(const Label& label) const {
+        return GetCode() + label.position;
+    }
+
+    // Moves and arithmetic
+    void MOV(XReg rd, XReg rm);
+    void MOV(WReg rd, WReg rm);
+    /// Materializes an arbitrary constant using MOVZ and MOVK
+    void MOVI64(XReg rd, u64 imm);
+    void MOVZ(WReg rd, u16 imm, unsigned shift = 0);
+    void MOVZ(XReg rd, u16 imm, unsigned shift = 0);
+    void MOVK(XReg rd, u16 imm, unsigned shift = 0);
+    void ADD(XReg rd, XReg rn, u32 imm);
+    void ADD(WReg rd, WReg rn, u32 imm);
+    void ADD(XReg rd, XReg rn, XReg rm);
+    void ADD(WReg rd, WReg rn, WReg rm);
+    void SUB(XReg rd, XReg rn, u32 imm);
+    void SUBS(WReg rd, WReg rn, u32 imm);
+    void CMP(WReg rn, u32 imm);
+    void AND(WReg rd, WReg rn, WReg rm);
+    void ORR(WReg rd, WReg rn, WReg rm);
+    void EOR(WReg rd, WReg rn, WReg rm);
+    /// Bitwise AND with a mask of the `width` lowest bits
+    void ANDLowBits(WReg rd, WReg rn, unsigned width);
+    /// Bitwise exclusive OR with a mask of the `width` lowest bits
+    void EORLowBits(WReg rd, WReg rn, unsigned width);
+    void UBFX(WReg rd, WReg rn, unsigned lsb, unsigned width);
+    void LSL(WReg rd, WReg rn, unsigned shift);
+    void LSR(WReg rd, WReg rn, unsigned shift);
+    void SBFIZ(XReg rd, XReg rn, unsigned lsb, unsigned width);
+
+    // Loads and stores, with unsigned offsets scaled by the access size
+    void LDRB(WReg rt, XReg rn, u32 offset);
+    void STRB(WReg rt, XReg rn, u32 offset);
+    void LDR(WReg rt, XReg rn, u32 offset);
+    void LDR(XReg rt, XReg rn, u32 offset);
+    void STR(XReg rt, XReg rn, u32 offset);
+    void LDRQ(VReg rt, XReg rn, u32 offset);
+    void STRQ(VReg rt, XReg rn, u32 offset);
+    void STP(XReg rt1, XReg rt2, XReg rn, s32 offset);
+    void LDP(XReg rt1, XReg rt2, XReg rn, s32 offset);
+    /// STP with pre-indexed addressing, i.e. `stp rt1, rt2, [rn, #offset]!`
+    void STPPre(XReg rt1, XReg rt2, XReg rn, s32 offset);
+    /// LDP with post-indexed addressing, i.e. `ldp rt1, rt2, [rn], #offset`
+    void LDPPost(XReg rt1, XReg rt2, XReg rn, s32 offset);
+
+    // Branches
+    void B(Label& label);
+    void B(Cond cond, Label& label);
+    void BL(Label& label);
+    void CBZ(WReg rt, Label& label);
+    void CBNZ(WReg rt, Label& label);
+    void CBZ(XReg rt, Label& label);
+    void CBNZ(XReg rt, Label& label);
+    void BR(XReg rn);
+    void BLR(XReg rn);
+    void RET(XReg rn = LR);
+    void ADR(XReg rd, Label& label);
+    /// Calls a function anywhere in the address space, clobbering IP0
+    template <typename FunctionPtr>
+    void CallFunction(FunctionPtr function) {
+        MOVI64(IP0, reinterpret_cast<u64>(function));
+        BLR(IP0);
+    }
+
+    // SIMD&FP, operating on all four single precision lanes unless noted otherwise
+    void FADD(VReg rd, VReg rn, VReg rm);
+    void FADDP(VReg rd, VReg rn, VReg rm);
+    void FMUL(VReg rd, VReg rn, VReg rm);
+    void FCMEQ(VReg rd, VReg rn, VReg rm);
+    void FCMGE(VReg rd, VReg rn, VReg rm);
+    void FCMGT(VReg rd, VReg rn, VReg rm);
+    void FRINTM(VReg rd, VReg rn);
+    void FCVTZS(VReg rd, VReg rn);
+    void FNEG(VReg rd, VReg rn);
+    /// Sets all lanes to the given value, which must be encodable in 8 bits (such as 1.0)
+    void FMOV(VReg rd, float imm);
+    void AND(VReg rd, VReg rn, VReg rm);
+    void ORR(VReg rd, VReg rn, VReg rm);
+    void ORN(VReg rd, VReg rn, VReg rm);
+    void BSL(VReg rd, VReg rn, VReg rm);
+    void NOT(VReg rd, VReg rn);
+    void MOV(VReg rd, VReg rn);
+    void DUP(VReg rd, VReg rn, unsigned lane);
+    /// Copies lane `src_lane` of `rn` to lane `dst_lane` of `rd`
+    void INS(VReg rd, unsigned dst_lane, VReg rn, unsigned src_lane);
+    /// Copies a general purpose register to lane `dst_lane` of `rd`
+    void INS(VReg rd, unsigned dst_lane, WReg rn);
+    void UMOV(WReg rd, VReg rn, unsigned lane);
+
+    // Scalar single precision operations on lane 0
+    void FDIV_S(VReg rd, VReg rn, VReg rm);
+    void FSQRT_S(VReg rd, VReg rn);
+
+private:
+    void Emit(u32 instruction);
+    void EmitBranch(u32 instruction, Label& label, Label::FixupType type);
+    static u32 Patch(u32 instruction, ptrdiff_t displacement, Label::FixupType type);
+
+    u32* code;
+    size_t max_size;
+    /// Number of instructions emitted so far
+    size_t size = 0;
+};
+
+} // namespace A64
+} // namespace Common
@@ -35,8 +35,10 @@
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <pwd.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 #if defined(__APPLE__)
@@ -57,6 +59,8 @@
 #endif
 
 #include <algorithm>
+#include <cstring>
+#include <limits>
 #include <sys/stat.h>
 
 #ifndef S_ISDIR
@@ -889,4 +893,222 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+size_t IOFile::ReadAt(u64 offset, void* data, size_t length) {
+    if (!IsOpen()) {
+        m_good = false;
+        return 0;
+    }
+    // Bytes written through the stream may still be in its buffer
+    std::fflush(m_file);
+
+    u8* buffer = static_cast<u8*>(data);
+    size_t bytes_read = 0;
+    while (bytes_read < length) {
+#ifdef _WIN32
+        // Windows has no pread, but reads at the offset given with an OVERLAPPED structure
+        const u64 position = offset + bytes_read;
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        const DWORD chunk = static_cast<DWORD>(std::min<size_t>(length - bytes_read, 0x80000000));
+        DWORD chunk_read = 0;
+        if (!ReadFile(reinterpret_cast<HANDLE>(_get_osfhandle(fileno(m_file))),
+                      buffer + bytes_read, chunk, &chunk_read, &overlapped) &&
+            GetLastError() != ERROR_HANDLE_EOF) {
+            break;
+        }
+        const s64 result = chunk_read;
+#else
+        const s64 result = pread(fileno(m_file), buffer + bytes_read, length - bytes_read,
+                                 static_cast<off_t>(offset + bytes_read));
+        if (result < 0 && errno == EINTR)
+            continue;
+#endif
+        if (result <= 0)
+            break;
+        bytes_read += static_cast<size_t>(result);
+    }
+
+    if (bytes_read != length)
+        m_good = false;
+    return bytes_read;
+}
+
+size_t IOFile::WriteAt(u64 offset, const void* data, size_t length) {
+    if (!IsOpen()) {
+        m_good = false;
+        return 0;
+    }
+    // Bytes written through the stream must reach the file before the ones written here
+    std::fflush(m_file);
+
+    const u8* buffer = static_cast<const u8*>(data);
+    size_t bytes_written = 0;
+    while (bytes_written < length) {
+#ifdef _WIN32
+        const u64 position = offset + bytes_written;
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        const DWORD chunk =
+            static_cast<DWORD>(std::min<size_t>(length - bytes_written, 0x80000000));
+        DWORD chunk_written = 0;
+        if (!WriteFile(reinterpret_cast<HANDLE>(_get_osfhandle(fileno(m_file))),
+                       buffer + bytes_written, chunk, &chunk_written, &overlapped)) {
+            break;
+        }
+        const s64 result = chunk_written;
+#else
+        const s64 result = pwrite(fileno(m_file), buffer + bytes_written, length - bytes_written,
+                                  static_cast<off_t>(offset + bytes_written));
+        if (result < 0 && errno == EINTR)
+            continue;
+#endif
+        if (result <= 0)
+            break;
+        bytes_written += static_cast<size_t>(result);
+    }
+
+    if (bytes_written != length)
+        m_good = false;
+    return bytes_written;
+}
+
+MappedFile::MappedFile() {}
+
+MappedFile::MappedFile(const std::string& filename) {
+    Open(filename);
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) {
+    Swap(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+    Swap(other);
+    return *this;
+}
+
+void MappedFile::Swap(MappedFile& other) {
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    std::swap(m_open, other.m_open);
+    std::swap(m_copy_on_write, other.m_copy_on_write);
+#ifdef _WIN32
+    std::swap(m_mapping_handle, other.m_mapping_handle);
+#endif
+}
+
+bool MappedFile::Open(const std::string& filename, bool copy_on_write) {
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(Common::UTF8ToUTF16W(filename).c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    m_size = static_cast<u64>(size.QuadPart);
+
+    // Empty files can't be mapped, but are still valid files to read nothing from
+    if (m_size != 0) {
+        // The mapping keeps its own reference to the file
+        HANDLE mapping = CreateFileMappingW(file, nullptr,
+                                            copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0,
+                                            nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr)
+            return false;
+
+        void* view = MapViewOfFile(mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) {
+            CloseHandle(mapping);
+            return false;
+        }
+        m_mapping_handle = mapping;
+        m_data = static_cast<const u8*>(view);
+    } else {
+        CloseHandle(file);
+    }
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat file_info;
+    if (fstat(fd, &file_info) != 0 ||
+        static_cast<u64>(file_info.st_size) > std::numeric_limits<size_t>::max()) {
+        close(fd);
+        return false;
+    }
+    m_size = static_cast<u64>(file_info.st_size);
+
+    // Empty files can't be mapped, but are still valid files to read nothing from
+    if (m_size != 0) {
+        const int protection = copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+        const int flags = copy_on_write ? MAP_PRIVATE : MAP_SHARED;
+        void* view = mmap(nullptr, static_cast<size_t>(m_size), protection, flags, fd, 0);
+        if (view == MAP_FAILED) {
+            LOG_ERROR(Common_Filesystem, "Failed to map %s: %s", filename.c_str(),
+                      GetLastErrorMsg());
+            close(fd);
+            return false;
+        }
+        m_data = static_cast<const u8*>(view);
+    }
+    // The mapping stays valid after the file descriptor is closed
+    close(fd);
+#endif
+
+    m_open = true;
+    m_copy_on_write = copy_on_write;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_data != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping_handle);
+        m_mapping_handle = nullptr;
+#else
+        munmap(const_cast<u8*>(m_data), static_cast<size_t>(m_size));
+#endif
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+    m_copy_on_write = false;
+}
+
+size_t MappedFile::ReadBytes(u64 offset, size_t length, void* data) const {
+    if (offset >= m_size)
+        return 0;
+
+    const size_t read_length = static_cast<size_t>(std::min<u64>(length, m_size - offset));
+    std::memcpy(data, m_data + offset, read_length);
+    return read_length;
+}
+
+void MappedFile::Prefetch(u64 offset, u64 length) const {
+    if (offset >= m_size)
+        return;
+    length = std::min(length, m_size - offset);
+#ifndef _WIN32
+    // madvise wants a page aligned start
+    static const u64 page_size = static_cast<u64>(sysconf(_SC_PAGESIZE));
+    const u64 aligned_offset = offset & ~(page_size - 1);
+    madvise(const_cast<u8*>(m_data) + aligned_offset,
+            static_cast<size_t>(length + offset - aligned_offset), MADV_WILLNEED);
+#endif
+}
+
 } // namespace
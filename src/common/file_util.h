@@ -224,6 +224,23 @@ public:
         return WriteArray(&object, 1);
     }
 
+    /**
+     * Reads bytes at a given offset of the file, without using or moving the position used by the
+     * other functions. Reads at different offsets may be made from several threads at once.
+     * Seek before going back to ReadBytes/WriteBytes, as the position may be moved on Windows.
+     * @param offset Offset in the file of the first byte to read
+     * @param data Buffer to read the bytes into
+     * @param length Number of bytes to read
+     * @return Number of bytes read, less than length if the end of the file was reached
+     */
+    size_t ReadAt(u64 offset, void* data, size_t length);
+
+    /**
+     * Writes bytes at a given offset of the file, the same way ReadAt reads them
+     * @return Number of bytes written
+     */
+    size_t WriteAt(u64 offset, const void* data, size_t length);
+
     bool IsOpen() const {
         return nullptr != m_file;
     }
@@ -253,6 +270,74 @@ private:
     bool m_good = true;
 };
 
+/**
+ * Read-only view of a whole file mapped into memory. Reads are plain copies out of the mapping, so
+ * unlike with IOFile any number of users can read from the same view without sharing a position.
+ */
+class MappedFile : public NonCopyable {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& filename);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+
+    void Swap(MappedFile& other);
+
+    /**
+     * Maps a file into memory
+     * @param copy_on_write Whether to map the file writable, with writes going to private copies
+     *     of the pages instead of the file. The pages that aren't written stay shared with all
+     *     other mappings of the file, including those of other processes.
+     */
+    bool Open(const std::string& filename, bool copy_on_write = false);
+    void Close();
+
+    bool IsOpen() const {
+        return m_open;
+    }
+
+    u64 GetSize() const {
+        return m_size;
+    }
+
+    /// Returns the start of the mapping, or nullptr if the file is not open or empty
+    const u8* GetData() const {
+        return m_data;
+    }
+
+    /// Returns the start of a copy-on-write mapping, or nullptr if the file isn't mapped that way
+    u8* GetWritableData() const {
+        return m_copy_on_write ? const_cast<u8*>(m_data) : nullptr;
+    }
+
+    /**
+     * Copies bytes of the file into a buffer, stopping at the end of the file
+     * @param offset Offset in the file of the first byte to copy
+     * @param length Number of bytes to copy
+     * @param data Buffer to copy the bytes to
+     * @return Number of bytes copied
+     */
+    size_t ReadBytes(u64 offset, size_t length, void* data) const;
+
+    /**
+     * Hints that a range of the file will be read soon, so that the system starts loading it
+     * from disk in the background. Does nothing where the hint isn't supported.
+     */
+    void Prefetch(u64 offset, u64 length) const;
+
+private:
+    const u8* m_data = nullptr;
+    u64 m_size = 0;
+    bool m_open = false;
+    bool m_copy_on_write = false;
+#ifdef _WIN32
+    void* m_mapping_handle = nullptr;
+#endif
+};
+
 } // namespace
 
 // To deal with Windows being dumb at unicode:
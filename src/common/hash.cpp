@@ -2,12 +2,17 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
 #if defined(_MSC_VER)
 #include <stdlib.h>
 #endif
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/hash.h"
+#ifdef ARCHITECTURE_x86_64
+#include <nmmintrin.h>
+#include "common/x64/cpu_detect.h"
+#endif
 
 namespace Common {
 
@@ -138,4 +143,194 @@ void MurmurHash3_128(const void* key, size_t len, u32 seed, void* out) {
     ((u64*)out)[1] = h2;
 }
 
+// xxHash was written by Yann Collet, and is available under the 2-clause BSD license. This is
+// XXH64 as described in https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+
+namespace {
+
+constexpr u64 PRIME64_1 = 0x9E3779B185EBCA87llu;
+constexpr u64 PRIME64_2 = 0xC2B2AE3D27D4EB4Fllu;
+constexpr u64 PRIME64_3 = 0x165667B19E3779F9llu;
+constexpr u64 PRIME64_4 = 0x85EBCA77C2B2AE63llu;
+constexpr u64 PRIME64_5 = 0x27D4EB2F165667C5llu;
+
+// Reads may be unaligned, and are little endian like all hosts we run on
+FORCE_INLINE u64 Read64(const u8* p) {
+    u64 value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+FORCE_INLINE u32 Read32(const u8* p) {
+    u32 value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+FORCE_INLINE u64 XXH64Round(u64 acc, u64 input) {
+    acc += input * PRIME64_2;
+    acc = _rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+FORCE_INLINE u64 XXH64MergeRound(u64 acc, u64 value) {
+    acc ^= XXH64Round(0, value);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+std::array<u64, 4> XXH64Init(u64 seed) {
+    return {{seed + PRIME64_1 + PRIME64_2, seed + PRIME64_2, seed, seed - PRIME64_1}};
+}
+
+/// Processes the whole 32-byte stripes of a block, returns the number of bytes processed
+size_t XXH64Stripes(std::array<u64, 4>& acc, const u8* data, size_t len) {
+    size_t i = 0;
+    for (; len - i >= 32; i += 32) {
+        acc[0] = XXH64Round(acc[0], Read64(data + i));
+        acc[1] = XXH64Round(acc[1], Read64(data + i + 8));
+        acc[2] = XXH64Round(acc[2], Read64(data + i + 16));
+        acc[3] = XXH64Round(acc[3], Read64(data + i + 24));
+    }
+    return i;
+}
+
+u64 XXH64Converge(const std::array<u64, 4>& acc) {
+    u64 h = _rotl64(acc[0], 1) + _rotl64(acc[1], 7) + _rotl64(acc[2], 12) + _rotl64(acc[3], 18);
+    for (u64 value : acc) {
+        h = XXH64MergeRound(h, value);
+    }
+    return h;
+}
+
+/// Mixes in the bytes left after the last whole stripe, then makes all bits avalanche
+u64 XXH64Finalize(u64 h, const u8* data, size_t len) {
+    for (; len >= 8; data += 8, len -= 8) {
+        h ^= XXH64Round(0, Read64(data));
+        h = _rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (len >= 4) {
+        h ^= Read32(data) * PRIME64_1;
+        h = _rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        data += 4;
+        len -= 4;
+    }
+    for (; len > 0; ++data, --len) {
+        h ^= *data * PRIME64_5;
+        h = _rotl64(h, 11) * PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+} // Anonymous namespace
+
+u64 XXHash64(const void* data, size_t len, u64 seed) {
+    const u8* bytes = static_cast<const u8*>(data);
+
+    u64 h;
+    size_t processed = 0;
+    if (len >= 32) {
+        std::array<u64, 4> acc = XXH64Init(seed);
+        processed = XXH64Stripes(acc, bytes, len);
+        h = XXH64Converge(acc);
+    } else {
+        h = seed + PRIME64_5;
+    }
+    h += len;
+
+    return XXH64Finalize(h, bytes + processed, len - processed);
+}
+
+HashState64::HashState64(u64 seed) : seed(seed), accumulators(XXH64Init(seed)) {}
+
+void HashState64::Update(const void* data, size_t len) {
+    const u8* bytes = static_cast<const u8*>(data);
+    total_len += len;
+
+    if (buffer_size + len < buffer.size()) {
+        std::memcpy(buffer.data() + buffer_size, bytes, len);
+        buffer_size += len;
+        return;
+    }
+
+    // Complete the stripe started by the previous pieces
+    if (buffer_size != 0) {
+        const size_t fill = buffer.size() - buffer_size;
+        std::memcpy(buffer.data() + buffer_size, bytes, fill);
+        XXH64Stripes(accumulators, buffer.data(), buffer.size());
+        bytes += fill;
+        len -= fill;
+    }
+
+    const size_t processed = XXH64Stripes(accumulators, bytes, len);
+    buffer_size = len - processed;
+    std::memcpy(buffer.data(), bytes + processed, buffer_size);
+}
+
+u64 HashState64::Digest() const {
+    u64 h = total_len >= 32 ? XXH64Converge(accumulators) : seed + PRIME64_5;
+    h += total_len;
+    return XXH64Finalize(h, buffer.data(), buffer_size);
+}
+
+namespace {
+
+/// CRC-32C polynomial, bit-reversed
+constexpr u32 CRC32C_POLYNOMIAL = 0x82F63B78;
+
+std::array<u32, 256> MakeCRC32CTable() {
+    std::array<u32, 256> table;
+    for (u32 i = 0; i < 256; ++i) {
+        u32 crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLYNOMIAL : 0);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+u32 CRC32CSoftware(u32 crc, const u8* data, size_t len) {
+    static const std::array<u32, 256> table = MakeCRC32CTable();
+    for (; len > 0; ++data, --len) {
+        crc = table[(crc ^ *data) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef ARCHITECTURE_x86_64
+#ifndef _MSC_VER
+__attribute__((target("sse4.2")))
+#endif
+u32 CRC32CHardware(u32 crc, const u8* data, size_t len) {
+    u64 crc64 = crc;
+    for (; len >= 8; data += 8, len -= 8) {
+        crc64 = _mm_crc32_u64(crc64, Read64(data));
+    }
+    crc = static_cast<u32>(crc64);
+    for (; len > 0; ++data, --len) {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+#endif
+
+} // Anonymous namespace
+
+u32 ComputeCRC32C(const void* data, size_t len, u32 crc) {
+    const u8* bytes = static_cast<const u8*>(data);
+#ifdef ARCHITECTURE_x86_64
+    static const bool has_crc32_instruction = GetCPUCaps().sse4_2;
+    if (has_crc32_instruction) {
+        return ~CRC32CHardware(~crc, bytes, len);
+    }
+#endif
+    return ~CRC32CSoftware(~crc, bytes, len);
+}
+
 } // namespace Common
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include "common/common_types.h"
 
@@ -11,6 +12,49 @@ namespace Common {
 
 void MurmurHash3_128(const void* key, size_t len, u32 seed, void* out);
 
+/**
+ * Computes the 64-bit xxHash (XXH64) of a block of data. It is about twice as fast as
+ * MurmurHash3_128 on large blocks such as shader programs, with the same hash quality.
+ * @param data Block of data to compute hash over
+ * @param len Length of data (in bytes) to compute hash over
+ * @param seed Seed the hash starts from
+ * @returns 64-bit hash value that was computed over the data block
+ */
+u64 XXHash64(const void* data, size_t len, u64 seed = 0);
+
+/**
+ * Computes the CRC-32C (Castagnoli) of a block of data, with the SSE4.2 CRC32 instruction where
+ * the CPU has it. Meant for checksums; 32 bits are too few for keys of large caches.
+ * @param data Block of data to compute the CRC over
+ * @param len Length of data (in bytes) to compute the CRC over
+ * @param crc CRC of the data preceding this block, to continue it
+ * @returns CRC-32C of the data so far
+ */
+u32 ComputeCRC32C(const void* data, size_t len, u32 crc = 0);
+
+/**
+ * Computes the same hash as XXHash64 over data given in several pieces, as if they were one
+ * contiguous block. Saves copying separate buffers together, or combining their separate hashes.
+ */
+class HashState64 {
+public:
+    explicit HashState64(u64 seed = 0);
+
+    /// Adds a piece of data to the hash
+    void Update(const void* data, size_t len);
+
+    /// Returns the hash of the data added so far
+    u64 Digest() const;
+
+private:
+    u64 seed;
+    std::array<u64, 4> accumulators;
+    /// Data that doesn't fill a whole stripe yet
+    std::array<u8, 32> buffer;
+    size_t buffer_size = 0;
+    u64 total_len = 0;
+};
+
 /**
  * Computes a 64-bit hash over the specified block of data
  * @param data Block of data to compute hash over
@@ -18,9 +62,7 @@ void MurmurHash3_128(const void* key, size_t len, u32 seed, void* out);
  * @returns 64-bit hash value that was computed over the data block
  */
 static inline u64 ComputeHash64(const void* data, size_t len) {
-    u64 res[2];
-    MurmurHash3_128(data, len, 0, res);
-    return res[0];
+    return XXHash64(data, len);
 }
 
 } // namespace Common
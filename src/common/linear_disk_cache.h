@@ -4,24 +4,28 @@
 
 #pragma once
 
+#include <cstring>
 #include <fstream>
+#include <vector>
 #include "common/common_types.h"
-
-// defined in Version.cpp
-extern const char* scm_rev_git_str;
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/scm_rev.h"
 
 // On disk format:
 // header{
-// u32 'DCAC';
-// u32 version;  // svn_rev
+// u32 'DCA2';
 // u16 sizeof(key_type);
 // u16 sizeof(value_type);
+// char version[40];  // git revision
 //}
 
 // key_value_pair{
 // u32 value_size;
 // key_type   key;
 // value_type[value_size]   value;
+// u32 entry_number;  // starting at 1
+// u32 checksum;  // CRC-32C of key and value
 //}
 
 template <typename K, typename V>
@@ -35,7 +39,8 @@ public:
 // Keys and values can contain any characters, including \0.
 //
 // Suitable for caching generated shader bytecode between executions.
-// Not tuned for extreme performance but should be reasonably fast.
+// The file is read through a memory mapping, so opening stays fast for large caches.
+// Entries are checksummed, reading stops at the first damaged or partly written one.
 // Does not support keys or values larger than 2GB, which should be reasonable.
 // Keys must have non-zero length; values can have zero length.
 
@@ -53,56 +58,20 @@ public:
         Close();
         m_num_entries = 0;
 
-        // try opening for reading/writing
-        OpenFStream(m_file, filename, ios_base::in | ios_base::out | ios_base::binary);
-
-        m_file.seekg(0, std::ios::end);
-        std::fstream::pos_type end_pos = m_file.tellg();
-        m_file.seekg(0, std::ios::beg);
-        std::fstream::pos_type start_pos = m_file.tellg();
-        std::streamoff file_size = end_pos - start_pos;
-
-        if (m_file.is_open() && ValidateHeader()) {
-            // good header, read some key/value pairs
-            K key;
-
-            V* value = nullptr;
-            u32 value_size;
-            u32 entry_number;
-
-            std::fstream::pos_type last_pos = m_file.tellg();
-
-            while (Read(&value_size)) {
-                std::streamoff next_extent =
-                    (last_pos - start_pos) + sizeof(value_size) + value_size;
-                if (next_extent > file_size)
-                    break;
-
-                delete[] value;
-                value = new V[value_size];
-
-                // read key/value and pass to reader
-                if (Read(&key) && Read(value, value_size) && Read(&entry_number) &&
-                    entry_number == m_num_entries + 1) {
-                    reader.Read(key, value, value_size);
-                } else {
-                    break;
-                }
-
-                m_num_entries++;
-                last_pos = m_file.tellg();
-            }
-            m_file.seekp(last_pos);
-            m_file.clear();
-
-            delete[] value;
-            return m_num_entries;
+        const u64 valid_size = ReadEntries(filename, reader);
+        if (valid_size != 0) {
+            // good header, append after the last valid entry
+            OpenFStream(m_file, filename, ios_base::in | ios_base::out | ios_base::binary);
+            m_file.seekp(valid_size);
+            if (m_file.good())
+                return m_num_entries;
         }
 
         // failed to open file for reading or bad header
         // close and recreate file
         Close();
-        m_file.open(filename, ios_base::out | ios_base::trunc | ios_base::binary);
+        m_num_entries = 0;
+        OpenFStream(m_file, filename, ios_base::out | ios_base::trunc | ios_base::binary);
         WriteHeader();
         return 0;
     }
@@ -122,11 +91,21 @@ public:
     void Append(const K& key, const V* value, u32 value_size) {
         // TODO: Should do a check that we don't already have "key"? (I think each caller does that
         // already.)
-        Write(&value_size);
-        Write(&key);
-        Write(value, value_size);
+        const size_t value_bytes = value_size * sizeof(V);
+
+        // Written in one go, so that a failed write leaves at most one partial entry behind
+        m_entry.resize(sizeof(u32) + sizeof(K) + value_bytes + 2 * sizeof(u32));
+        u8* data = m_entry.data() + sizeof(u32);
+        std::memcpy(m_entry.data(), &value_size, sizeof(u32));
+        std::memcpy(data, &key, sizeof(K));
+        std::memcpy(data + sizeof(K), value, value_bytes);
+
         m_num_entries++;
-        Write(&m_num_entries);
+        const u32 checksum = ComputeChecksum(data, sizeof(K) + value_bytes);
+        std::memcpy(data + sizeof(K) + value_bytes, &m_num_entries, sizeof(u32));
+        std::memcpy(data + sizeof(K) + value_bytes + sizeof(u32), &checksum, sizeof(u32));
+
+        Write(m_entry.data(), static_cast<u32>(m_entry.size()));
     }
 
 private:
@@ -134,26 +113,67 @@ private:
         Write(&m_header);
     }
 
-    bool ValidateHeader() {
-        char file_header[sizeof(Header)];
+    // Passes the valid entries of a file to the reader.
+    // Returns the size of the part of the file they take, or 0 if the header doesn't match.
+    u64 ReadEntries(const char* filename, LinearDiskCacheReader<K, V>& reader) {
+        FileUtil::MappedFile file;
+        if (!file.Open(filename) || file.GetSize() < sizeof(Header) ||
+            memcmp(&m_header, file.GetData(), sizeof(Header)) != 0) {
+            return 0;
+        }
+
+        const u8* const file_data = file.GetData();
+        const u64 file_size = file.GetSize();
+        file.Prefetch(0, file_size);
+
+        K key;
+        // Values are copied out of the mapping, where they aren't necessarily aligned
+        std::vector<V> value;
+
+        u64 offset = sizeof(Header);
+        u32 value_size;
+        while (file_size - offset >= sizeof(value_size)) {
+            memcpy(&value_size, file_data + offset, sizeof(value_size));
+            const u64 value_bytes = static_cast<u64>(value_size) * sizeof(V);
+            const u64 entry_size = sizeof(value_size) + sizeof(K) + value_bytes + 2 * sizeof(u32);
+            if (file_size - offset < entry_size)
+                break;
+
+            const u8* data = file_data + offset + sizeof(value_size);
+            u32 entry_number;
+            u32 checksum;
+            memcpy(&entry_number, data + sizeof(K) + value_bytes, sizeof(u32));
+            memcpy(&checksum, data + sizeof(K) + value_bytes + sizeof(u32), sizeof(u32));
+            if (entry_number != m_num_entries + 1 ||
+                checksum != ComputeChecksum(data, static_cast<size_t>(sizeof(K) + value_bytes))) {
+                break;
+            }
 
-        return (Read(file_header, sizeof(Header)) &&
-                !memcmp((const char*)&m_header, file_header, sizeof(Header)));
+            // read key/value and pass to reader
+            memcpy(&key, data, sizeof(K));
+            value.resize(value_size);
+            memcpy(value.data(), data + sizeof(K), static_cast<size_t>(value_bytes));
+            reader.Read(key, value.data(), value_size);
+
+            m_num_entries++;
+            offset += entry_size;
+        }
+        return offset;
     }
 
-    template <typename D>
-    bool Write(const D* data, u32 count = 1) {
-        return m_file.write((const char*)data, count * sizeof(D)).good();
+    static u32 ComputeChecksum(const u8* data, size_t size) {
+        return Common::ComputeCRC32C(data, size);
     }
 
     template <typename D>
-    bool Read(const D* data, u32 count = 1) {
-        return m_file.read((char*)data, count * sizeof(D)).good();
+    bool Write(const D* data, u32 count = 1) {
+        return m_file.write((const char*)data, count * sizeof(D)).good();
     }
 
     struct Header {
-        Header() : id(*(u32*)"DCAC"), key_t_size(sizeof(K)), value_t_size(sizeof(V)) {
-            memcpy(ver, scm_rev_git_str, 40);
+        Header() : id(*(u32*)"DCA2"), key_t_size(sizeof(K)), value_t_size(sizeof(V)) {
+            // The revision string may be shorter than a full hash, e.g. for builds outside git
+            std::strncpy(ver, Common::g_scm_rev, sizeof(ver));
         }
 
         const u32 id;
@@ -164,4 +184,6 @@ private:
 
     std::fstream m_file;
     u32 m_num_entries;
+    // Scratch buffer an entry is assembled in before being written
+    std::vector<u8> m_entry;
 };
@@ -4,9 +4,18 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include "common/assert.h"
 #include "common/common_funcs.h" // snprintf compatibility define
+#include "common/file_util.h"
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
@@ -110,17 +119,20 @@ const char* GetLevelName(Level log_level) {
 #undef LVL
 }
 
-Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
-                  const char* function, const char* format, va_list args) {
+static std::chrono::microseconds GetTimestamp() {
     using std::chrono::steady_clock;
     using std::chrono::duration_cast;
 
     static steady_clock::time_point time_origin = steady_clock::now();
+    return duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
+}
 
+Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
+                  const char* function, const char* format, va_list args) {
     std::array<char, 4 * 1024> formatting_buffer;
 
     Entry entry;
-    entry.timestamp = duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
+    entry.timestamp = GetTimestamp();
     entry.log_class = log_class;
     entry.log_level = log_level;
 
@@ -134,22 +146,255 @@ Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsign
     return entry;
 }
 
+namespace {
+
+/// Set once the writer is destroyed at exit, after which messages are printed synchronously
+std::atomic<bool> writer_destroyed{false};
+
+/**
+ * Writes log entries to the sinks from a thread of its own, so that logging threads only pay for
+ * formatting the message. Entries are formatted straight into the slots of a fixed-size queue that
+ * any thread can push to without locking. When the queue is full, entries are dropped and counted,
+ * and the writer reports how many were lost.
+ */
+class AsyncWriter {
+public:
+    AsyncWriter() : slots(std::make_unique<Slot[]>(NUM_SLOTS)) {
+        for (size_t i = 0; i < NUM_SLOTS; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        writer = std::thread(&AsyncWriter::WriterLoop, this);
+    }
+
+    ~AsyncWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        entry_ready.notify_one();
+        writer.join();
+        writer_destroyed = true;
+    }
+
+    /**
+     * Formats an entry into the queue.
+     * @returns The position of the entry in the queue, or -1 if it was dropped
+     */
+    s64 Push(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
+             const char* function, const char* format, va_list args) {
+        // Bounded multi-producer queue: each slot's sequence tells which lap of the ring it is
+        // ready to be written (sequence == position) or read (sequence == position + 1) for.
+        size_t position = push_position.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots[position % NUM_SLOTS];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const s64 difference = static_cast<s64>(sequence) - static_cast<s64>(position);
+            if (difference == 0) {
+                if (push_position.compare_exchange_weak(position, position + 1,
+                                                        std::memory_order_relaxed))
+                    break;
+            } else if (difference < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return -1;
+            } else {
+                position = push_position.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->timestamp = GetTimestamp();
+        slot->log_class = log_class;
+        slot->log_level = log_level;
+        snprintf(slot->location.data(), slot->location.size(), "%s:%s:%u", filename, function,
+                 line_nr);
+        vsnprintf(slot->message.data(), slot->message.size(), format, args);
+        slot->sequence.store(position + 1, std::memory_order_release);
+
+        // Pairs with the fence in WriterLoop: either the writer sees the entry before sleeping, or
+        // this sees that it sleeps and wakes it up
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writer_waiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            entry_ready.notify_one();
+        }
+        return static_cast<s64>(position);
+    }
+
+    /// Waits until the writer has written the entry at the given position
+    void WaitForWrite(s64 position) {
+        if (std::this_thread::get_id() == writer.get_id())
+            return; // Logged by a sink, waiting would never end
+        std::unique_lock<std::mutex> lock(mutex);
+        entry_written.wait(lock, [&] { return static_cast<s64>(written_position) > position; });
+    }
+
+    void SetLogFile(const std::string& filename) {
+        std::lock_guard<std::mutex> lock(file_mutex);
+        log_file = std::make_unique<FileUtil::IOFile>(filename, "w");
+        if (!log_file->IsOpen())
+            log_file.reset();
+    }
+
+private:
+    static constexpr size_t NUM_SLOTS = 1024;
+    /// Longer messages are truncated, like CreateEntry does at 4 KiB
+    static constexpr size_t MAX_MESSAGE_SIZE = 2 * 1024;
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        std::chrono::microseconds timestamp;
+        Class log_class;
+        Level log_level;
+        std::array<char, 256> location;
+        std::array<char, MAX_MESSAGE_SIZE> message;
+    };
+
+    void WriterLoop() {
+        size_t position = 0;
+        std::array<char, MAX_MESSAGE_SIZE + 512> format_buffer;
+        while (true) {
+            Slot& slot = slots[position % NUM_SLOTS];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+                // Nothing to write, report the drops and sleep until an entry is pushed
+                ReportDropped();
+                FlushFile();
+                std::unique_lock<std::mutex> lock(mutex);
+                writer_waiting.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                entry_ready.wait(lock, [&] {
+                    return stop ||
+                           slot.sequence.load(std::memory_order_acquire) == position + 1;
+                });
+                writer_waiting.store(false, std::memory_order_relaxed);
+                if (stop && slot.sequence.load(std::memory_order_acquire) != position + 1)
+                    return;
+                continue;
+            }
+
+            Entry entry;
+            entry.timestamp = slot.timestamp;
+            entry.log_class = slot.log_class;
+            entry.log_level = slot.log_level;
+            entry.location = slot.location.data();
+            entry.message = slot.message.data();
+            // Hand the slot back to the producers for the next lap of the ring
+            slot.sequence.store(position + NUM_SLOTS, std::memory_order_release);
+            ++position;
+
+            Write(entry, format_buffer.data(), format_buffer.size());
+
+            std::lock_guard<std::mutex> lock(mutex);
+            written_position = position;
+            entry_written.notify_all();
+        }
+    }
+
+    void Write(const Entry& entry, char* format_buffer, size_t buffer_size) {
+        PrintColoredMessage(entry);
+
+        std::lock_guard<std::mutex> lock(file_mutex);
+        if (log_file) {
+            FormatLogMessage(entry, format_buffer, buffer_size);
+            log_file->WriteBytes(format_buffer, std::strlen(format_buffer));
+            log_file->WriteBytes("\n", 1);
+        }
+    }
+
+    void ReportDropped() {
+        const size_t count = dropped.exchange(0, std::memory_order_relaxed);
+        if (count == 0)
+            return;
+
+        std::array<char, MAX_MESSAGE_SIZE + 512> format_buffer;
+        Entry entry;
+        entry.timestamp = GetTimestamp();
+        entry.log_class = Class::Log;
+        entry.log_level = Level::Warning;
+        entry.message = std::to_string(count) + " log messages dropped, the log queue was full";
+        Write(entry, format_buffer.data(), format_buffer.size());
+    }
+
+    void FlushFile() {
+        std::lock_guard<std::mutex> lock(file_mutex);
+        if (log_file)
+            log_file->Flush();
+    }
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<size_t> push_position{0};
+    std::atomic<size_t> dropped{0};
+
+    std::mutex mutex;
+    std::condition_variable entry_ready;
+    std::condition_variable entry_written;
+    std::atomic<bool> writer_waiting{false};
+    size_t written_position = 0; ///< Guarded by mutex
+    bool stop = false;           ///< Guarded by mutex
+
+    std::mutex file_mutex;
+    std::unique_ptr<FileUtil::IOFile> log_file; ///< Guarded by file_mutex
+
+    std::thread writer;
+};
+
+AsyncWriter& GetWriter() {
+    static AsyncWriter writer;
+    return writer;
+}
+
+} // Anonymous namespace
+
+namespace Detail {
+std::array<std::atomic<u8>, static_cast<size_t>(Class::Count)> class_min_levels{};
+} // namespace Detail
+
 static Filter* filter = nullptr;
 
+/// Copies the levels of the active filter to where the LOG_* macros check them
+static void LoadFilterLevels() {
+    for (size_t i = 0; i < Detail::class_min_levels.size(); ++i) {
+        const Level level =
+            filter != nullptr ? filter->GetClassLevel(static_cast<Class>(i)) : Level::Trace;
+        Detail::class_min_levels[i].store(static_cast<u8>(level), std::memory_order_relaxed);
+    }
+}
+
 void SetFilter(Filter* new_filter) {
     filter = new_filter;
+    LoadFilterLevels();
+}
+
+void RefreshFilter(const Filter* changed_filter) {
+    if (changed_filter == filter)
+        LoadFilterLevels();
+}
+
+void SetLogFile(const std::string& filename) {
+    GetWriter().SetLogFile(filename);
 }
 
 void LogMessage(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
                 const char* function, const char* format, ...) {
-    if (filter != nullptr && !filter->CheckMessage(log_class, log_level))
-        return;
-
     va_list args;
+    if (!writer_destroyed) {
+        AsyncWriter& writer = GetWriter();
+        va_start(args, format);
+        const s64 position =
+            writer.Push(log_class, log_level, filename, line_nr, function, format, args);
+        va_end(args);
+
+        if (log_level != Level::Critical)
+            return;
+        // Critical messages usually precede a crash, make sure they are out before returning
+        if (position >= 0) {
+            writer.WaitForWrite(position);
+            return;
+        }
+    }
+
+    // The writer is gone, or it has no room for a critical message: print it right away
     va_start(args, format);
     Entry entry = CreateEntry(log_class, log_level, filename, line_nr, function, format, args);
     va_end(args);
-
     PrintColoredMessage(entry);
 }
 }
@@ -46,5 +46,11 @@ const char* GetLevelName(Level log_level);
 Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
                   const char* function, const char* format, va_list args);
 
+/// Sets the filter checked by the LOG_* macros. Passing nullptr lets every message through.
 void SetFilter(Filter* filter);
+/// Reloads the levels of `filter` if it is the active one. Called by Filter when it changes.
+void RefreshFilter(const Filter* filter);
+
+/// Also writes the log to the given file, replacing its contents. The console output is kept.
+void SetLogFile(const std::string& filename);
 }
@@ -15,10 +15,16 @@ Filter::Filter(Level default_level) {
 
 void Filter::ResetAll(Level level) {
     class_levels.fill(level);
+    RefreshFilter(this);
 }
 
 void Filter::SetClassLevel(Class log_class, Level level) {
     class_levels[static_cast<size_t>(log_class)] = level;
+    RefreshFilter(this);
+}
+
+Level Filter::GetClassLevel(Class log_class) const {
+    return class_levels[static_cast<size_t>(log_class)];
 }
 
 void Filter::ParseFilterString(const std::string& filter_str) {
@@ -25,6 +25,8 @@ public:
     void ResetAll(Level level);
     /// Sets the minimum level of `log_class` (and not of its subclasses) to `level`.
     void SetClassLevel(Class log_class, Level level);
+    /// Returns the minimum level of `log_class`.
+    Level GetClassLevel(Class log_class) const;
 
     /**
      * Parses a filter string and applies it to this filter.
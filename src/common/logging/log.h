@@ -4,8 +4,24 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include "common/common_types.h"
 
+/**
+ * Lowest log level whose LOG_* macros are compiled in, as the numeric value of a Log::Level.
+ * Messages below it cost nothing, not even the evaluation of their arguments. The build can
+ * override it; by default, debug builds keep every level and other builds start at Info.
+ */
+#ifndef CITRA_LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define CITRA_LOG_MIN_LEVEL 0
+#else
+#define CITRA_LOG_MIN_LEVEL 2
+#endif
+#endif
+
 namespace Log {
 
 /// Specifies the severity or level of detail of the log message.
@@ -95,7 +111,20 @@ enum class Class : ClassType {
     Count              ///< Total number of logging classes
 };
 
-/// Logs a message to the global logger.
+namespace Detail {
+/// Minimum level of each class in the active filter, indexed by Class. Updated by SetFilter.
+extern std::array<std::atomic<u8>, static_cast<size_t>(Class::Count)> class_min_levels;
+} // namespace Detail
+
+/// Returns whether a message of this class and level would pass the active filter.
+inline bool IsLogEnabled(Class log_class, Level log_level) {
+    return static_cast<u8>(log_level) >= CITRA_LOG_MIN_LEVEL &&
+           static_cast<u8>(log_level) >=
+               Detail::class_min_levels[static_cast<size_t>(log_class)].load(
+                   std::memory_order_relaxed);
+}
+
+/// Logs a message to the global logger. Callers are expected to check IsLogEnabled first.
 void LogMessage(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
                 const char* function,
 #ifdef _MSC_VER
@@ -110,18 +139,33 @@ void LogMessage(Class log_class, Level log_level, const char* filename, unsigned
 
 } // namespace Log
 
+// The arguments are only evaluated when the message passes the filter
 #define LOG_GENERIC(log_class, log_level, ...)                                                     \
-    ::Log::LogMessage(log_class, log_level, __FILE__, __LINE__, __func__, __VA_ARGS__)
+    (::Log::IsLogEnabled(log_class, log_level)                                                     \
+         ? ::Log::LogMessage(log_class, log_level, __FILE__, __LINE__, __func__, __VA_ARGS__)      \
+         : void(0))
 
-#ifdef _DEBUG
+// Compiled out, but still type-checked so that variables only used in messages stay used
+#define LOG_DISABLED(log_class, log_level, ...)                                                    \
+    (true ? void(0)                                                                                \
+          : ::Log::LogMessage(log_class, log_level, __FILE__, __LINE__, __func__, __VA_ARGS__))
+
+#if CITRA_LOG_MIN_LEVEL <= 0
 #define LOG_TRACE(log_class, ...)                                                                  \
     LOG_GENERIC(::Log::Class::log_class, ::Log::Level::Trace, __VA_ARGS__)
 #else
-#define LOG_TRACE(log_class, ...) (void(0))
+#define LOG_TRACE(log_class, ...)                                                                  \
+    LOG_DISABLED(::Log::Class::log_class, ::Log::Level::Trace, __VA_ARGS__)
 #endif
 
+#if CITRA_LOG_MIN_LEVEL <= 1
 #define LOG_DEBUG(log_class, ...)                                                                  \
     LOG_GENERIC(::Log::Class::log_class, ::Log::Level::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(log_class, ...)                                                                  \
+    LOG_DISABLED(::Log::Class::log_class, ::Log::Level::Debug, __VA_ARGS__)
+#endif
+
 #define LOG_INFO(log_class, ...)                                                                   \
     LOG_GENERIC(::Log::Class::log_class, ::Log::Level::Info, __VA_ARGS__)
 #define LOG_WARNING(log_class, ...)                                                                \
@@ -89,6 +89,65 @@ void* AllocateMemoryPages(size_t size) {
     return ptr;
 }
 
+/// Size of the large pages tried by AllocateLargeMemoryPages, and the alignment of its allocations
+static constexpr size_t LARGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+static size_t RoundUpToLargePage(size_t size) {
+    return (size + LARGE_PAGE_SIZE - 1) & ~(LARGE_PAGE_SIZE - 1);
+}
+
+void* AllocateLargeMemoryPages(size_t size) {
+#ifdef _WIN32
+    // Large pages need the SeLockMemoryPrivilege, which most users don't have
+    const size_t large_page_minimum = GetLargePageMinimum();
+    if (large_page_minimum != 0) {
+        const size_t rounded_size = (size + large_page_minimum - 1) & ~(large_page_minimum - 1);
+        void* ptr = VirtualAlloc(nullptr, rounded_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                 PAGE_READWRITE);
+        if (ptr != nullptr)
+            return ptr;
+    }
+    return AllocateMemoryPages(size);
+#else
+    const size_t rounded_size = RoundUpToLargePage(size);
+
+#ifdef MAP_HUGETLB
+    // Only succeeds when the administrator has reserved huge pages
+    void* ptr = mmap(nullptr, rounded_size, PROT_READ | PROT_WRITE,
+                     MAP_ANON | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED)
+        return ptr;
+#endif
+
+    // Map a bit more to align the allocation to a large page, so transparent huge pages can back
+    // all of it, then give back the excess on either side
+    u8* base = static_cast<u8*>(mmap(nullptr, rounded_size + LARGE_PAGE_SIZE,
+                                     PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0));
+    if (base == MAP_FAILED) {
+        LOG_ERROR(Common_Memory, "Failed to allocate raw memory");
+        return nullptr;
+    }
+
+    u8* aligned = reinterpret_cast<u8*>(RoundUpToLargePage(reinterpret_cast<uintptr_t>(base)));
+    if (aligned != base)
+        munmap(base, aligned - base);
+    munmap(aligned + rounded_size, base + LARGE_PAGE_SIZE - aligned);
+
+    HintLargeMemoryPages(aligned, rounded_size);
+    return aligned;
+#endif
+}
+
+void HintLargeMemoryPages(void* ptr, size_t size) {
+#if !defined(_WIN32) && defined(MADV_HUGEPAGE)
+    // madvise needs a page aligned range; only whole large pages inside it can be used anyway
+    const uintptr_t begin = RoundUpToLargePage(reinterpret_cast<uintptr_t>(ptr));
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + size) & ~(LARGE_PAGE_SIZE - 1);
+    if (begin < end)
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+#endif
+}
+
 void* AllocateAlignedMemory(size_t size, size_t alignment) {
 #ifdef _WIN32
     void* ptr = _aligned_malloc(size, alignment);
@@ -10,6 +10,15 @@
 void* AllocateExecutableMemory(size_t size, bool low = true);
 void* AllocateMemoryPages(size_t size);
 void FreeMemoryPages(void* ptr, size_t size);
+/**
+ * Allocates zeroed memory backed by large pages (2 MiB on x86) where the host allows it, which
+ * takes far fewer host TLB entries for big, randomly accessed buffers such as emulated RAM. Falls
+ * back to transparent huge pages, then to regular pages. Only meant for memory that stays
+ * allocated until the process exits, as there is no way to free it.
+ */
+void* AllocateLargeMemoryPages(size_t size);
+/// Asks the host to back an existing allocation with large pages where it can. Only a hint.
+void HintLargeMemoryPages(void* ptr, size_t size);
 void* AllocateAlignedMemory(size_t size, size_t alignment);
 void FreeAlignedMemory(void* ptr);
 void WriteProtectMemory(void* ptr, size_t size, bool executable = false);
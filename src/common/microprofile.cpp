@@ -5,3 +5,160 @@
 // Includes the MicroProfile implementation in this file for compilation
 #define MICROPROFILE_IMPL 1
 #include "common/microprofile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+
+namespace Common {
+
+#if MICROPROFILE_ENABLED
+
+namespace {
+
+/// Frames recorded by a trace capture in progress
+std::string trace_capture_path;
+u32 trace_capture_frames = 0;
+u32 trace_capture_frames_seen = 0;
+
+/// Appends a string to a JSON document, quoted and escaped
+void AppendJsonString(std::string& out, const char* str) {
+    out += '"';
+    for (; *str != '\0'; ++str) {
+        const char c = *str;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+void AppendEvent(std::string& out, char phase, u32 timer_index, double timestamp_us,
+                 u32 thread) {
+    const MicroProfileTimerInfo& timer = g_MicroProfile.TimerInfo[timer_index];
+    out += "{\"name\":";
+    AppendJsonString(out, timer.pName);
+    out += ",\"cat\":";
+    AppendJsonString(out, g_MicroProfile.GroupInfo[timer.nGroupIndex].pName);
+    char fields[96];
+    std::snprintf(fields, sizeof(fields), ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u},\n",
+                  phase, timestamp_us, thread);
+    out += fields;
+}
+
+} // Anonymous namespace
+
+bool WriteChromeTrace(const std::string& path, u32 frames) {
+    std::lock_guard<std::recursive_mutex> lock(MicroProfileMutex());
+
+    // The last few frames of the history are still being written to
+    const u32 max_frames = MICROPROFILE_MAX_FRAME_HISTORY - MICROPROFILE_GPU_FRAME_DELAY - 3;
+    frames = std::min(std::min(frames, max_frames), g_MicroProfile.nFrameCurrentIndex);
+    const u32 first_frame =
+        (g_MicroProfile.nFrameCurrent + MICROPROFILE_MAX_FRAME_HISTORY - frames) %
+        MICROPROFILE_MAX_FRAME_HISTORY;
+    const int64_t start_tick = g_MicroProfile.Frames[first_frame].nFrameStartCpu;
+    const double us_per_tick = 1e6 / MicroProfileTicksPerSecondCpu();
+
+    std::string out = "{\"traceEvents\":[\n";
+    for (u32 thread = 0; thread < g_MicroProfile.nNumLogs; ++thread) {
+        const MicroProfileThreadLog* log = g_MicroProfile.Pool[thread];
+        if (log == nullptr || log->nGpu)
+            continue;
+
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+        out += std::to_string(thread);
+        out += ",\"args\":{\"name\":";
+        AppendJsonString(out, log->ThreadName);
+        out += "}},\n";
+
+        for (u32 i = 0; i < frames; ++i) {
+            const u32 frame = (first_frame + i) % MICROPROFILE_MAX_FRAME_HISTORY;
+            const u32 next_frame = (frame + 1) % MICROPROFILE_MAX_FRAME_HISTORY;
+            const u32 log_end = g_MicroProfile.Frames[next_frame].nLogStart[thread];
+            for (u32 k = g_MicroProfile.Frames[frame].nLogStart[thread]; k != log_end;
+                 k = (k + 1) % MICROPROFILE_BUFFER_SIZE) {
+                const MicroProfileLogEntry entry = log->Log[k];
+                const int type = MicroProfileLogType(entry);
+                if (type != MP_LOG_ENTER && type != MP_LOG_LEAVE)
+                    continue;
+
+                const double timestamp_us =
+                    MicroProfileLogTickDifference(start_tick, entry) * us_per_tick;
+                AppendEvent(out, type == MP_LOG_ENTER ? 'B' : 'E',
+                            static_cast<u32>(MicroProfileLogTimerIndex(entry)), timestamp_us,
+                            thread);
+            }
+        }
+    }
+
+    // Frame boundaries, as instant events across all threads
+    for (u32 i = 0; i <= frames; ++i) {
+        const u32 frame = (first_frame + i) % MICROPROFILE_MAX_FRAME_HISTORY;
+        char event[128];
+        std::snprintf(event, sizeof(event),
+                      "{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,"
+                      "\"tid\":0}%s\n",
+                      (g_MicroProfile.Frames[frame].nFrameStartCpu - start_tick) * us_per_tick,
+                      i == frames ? "" : ",");
+        out += event;
+    }
+    out += "],\"displayTimeUnit\":\"ms\"}\n";
+
+    FileUtil::IOFile file(path, "w");
+    if (!file.IsOpen() || file.WriteBytes(out.data(), out.size()) != out.size()) {
+        LOG_ERROR(Common, "Could not write the trace to %s", path.c_str());
+        return false;
+    }
+    LOG_INFO(Common, "Wrote a trace of %u frames to %s", frames, path.c_str());
+    return true;
+}
+
+void StartTraceCapture(const std::string& path, u32 frames) {
+    trace_capture_path = path;
+    trace_capture_frames = frames;
+    trace_capture_frames_seen = 0;
+
+    // Recording normally only runs for the groups enabled in the profiler window
+    MicroProfileSetForceEnable(true);
+    MicroProfileSetEnableAllGroups(true);
+}
+
+void OnTraceCaptureFrame() {
+    if (trace_capture_frames == 0)
+        return;
+
+    // Recording starts with the first flip after StartTraceCapture, and MicroProfile only hands
+    // out frames a few flips after they end
+    if (++trace_capture_frames_seen < trace_capture_frames + MICROPROFILE_GPU_FRAME_DELAY + 2)
+        return;
+
+    WriteChromeTrace(trace_capture_path, trace_capture_frames);
+    trace_capture_frames = 0;
+    MicroProfileSetForceEnable(false);
+    MicroProfileSetEnableAllGroups(false);
+}
+
+#else
+
+bool WriteChromeTrace(const std::string& path, u32 frames) {
+    return false;
+}
+
+void StartTraceCapture(const std::string& path, u32 frames) {
+    LOG_WARNING(Common, "Trace capture is not available, MicroProfile is disabled");
+}
+
+void OnTraceCaptureFrame() {}
+
+#endif
+
+} // namespace Common
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <string>
+#include "common/common_types.h"
+
 // Uncomment this to disable microprofile. This will get you cleaner profiles when using
 // external sampling profilers like "Very Sleepy", and will improve performance somewhat.
 // #define MICROPROFILE_ENABLED 0
@@ -32,3 +35,28 @@ typedef void* HANDLE;
 #ifdef PAGE_MASK
 #undef PAGE_MASK
 #endif
+
+namespace Common {
+
+/**
+ * Writes the scopes MicroProfile recorded over the last complete frames to a file in the Chrome
+ * trace event format, which chrome://tracing and other trace viewers open. Scopes are only
+ * recorded for the enabled groups, see StartTraceCapture.
+ * @param path File to write the trace to
+ * @param frames Number of frames to write, at most about the 500 frames MicroProfile keeps
+ * @returns Whether the file could be written
+ */
+bool WriteChromeTrace(const std::string& path, u32 frames);
+
+/**
+ * Records every scope of every group over the next frames, then writes them to a Chrome trace
+ * file. Works without the profiler window, for example in headless runs.
+ * @param path File to write the trace to
+ * @param frames Number of frames to record
+ */
+void StartTraceCapture(const std::string& path, u32 frames);
+
+/// Counts a frame towards the trace capture in progress. Call right after MicroProfileFlip().
+void OnTraceCaptureFrame();
+
+} // namespace Common
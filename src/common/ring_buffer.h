@@ -0,0 +1,120 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Fixed-capacity ring buffer that one thread pushes to and another pops from without locking.
+ * Items are moved in slots of `granularity` elements of T (e.g. 2 for interleaved stereo samples).
+ * Push and Pop never allocate; when the buffer is full, Push keeps what fits and drops the rest.
+ * @tparam T Element type, must be trivially copyable
+ * @tparam granularity Number of elements in a slot
+ * @tparam capacity Number of slots the buffer holds, must be a power of two
+ */
+template <typename T, size_t granularity, size_t capacity>
+class RingBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+    static_assert(granularity > 0, "granularity must be at least one element");
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0,
+                  "capacity must be a power of two");
+    static_assert(capacity < std::numeric_limits<size_t>::max() / 2 / granularity,
+                  "capacity is too large");
+
+    static constexpr size_t slot_size = granularity * sizeof(T);
+
+public:
+    /**
+     * Pushes slots to the back of the buffer. May only be called from the producer thread.
+     * @param new_slots Pointer to slot_count slots
+     * @param slot_count Number of slots to push
+     * @returns The number of slots actually pushed, less than slot_count if the buffer filled up
+     */
+    size_t Push(const void* new_slots, size_t slot_count) {
+        const size_t write_index = this->write_index.load(std::memory_order_relaxed);
+        const size_t slots_free = capacity + read_index.load(std::memory_order_acquire) -
+                                  write_index;
+        const size_t push_count = std::min(slot_count, slots_free);
+
+        const size_t pos = write_index % capacity;
+        const size_t first_copy = std::min(capacity - pos, push_count);
+        const size_t second_copy = push_count - first_copy;
+
+        const u8* in = static_cast<const u8*>(new_slots);
+        std::memcpy(&data[pos * granularity], in, first_copy * slot_size);
+        in += first_copy * slot_size;
+        std::memcpy(&data[0], in, second_copy * slot_size);
+
+        this->write_index.store(write_index + push_count, std::memory_order_release);
+        return push_count;
+    }
+
+    size_t Push(const std::vector<T>& input) {
+        return Push(input.data(), input.size() / granularity);
+    }
+
+    /**
+     * Pops slots from the front of the buffer. May only be called from the consumer thread.
+     * @param output Where to write the slots, with room for max_slots slots
+     * @param max_slots Maximum number of slots to pop
+     * @returns The number of slots actually popped
+     */
+    size_t Pop(void* output, size_t max_slots) {
+        const size_t read_index = this->read_index.load(std::memory_order_relaxed);
+        const size_t slots_filled = write_index.load(std::memory_order_acquire) - read_index;
+        const size_t pop_count = std::min(slots_filled, max_slots);
+
+        const size_t pos = read_index % capacity;
+        const size_t first_copy = std::min(capacity - pos, pop_count);
+        const size_t second_copy = pop_count - first_copy;
+
+        u8* out = static_cast<u8*>(output);
+        std::memcpy(out, &data[pos * granularity], first_copy * slot_size);
+        out += first_copy * slot_size;
+        std::memcpy(out, &data[0], second_copy * slot_size);
+
+        this->read_index.store(read_index + pop_count, std::memory_order_release);
+        return pop_count;
+    }
+
+    std::vector<T> Pop(size_t max_slots = std::numeric_limits<size_t>::max()) {
+        std::vector<T> out(std::min(max_slots, capacity) * granularity);
+        const size_t count = Pop(out.data(), out.size() / granularity);
+        out.resize(count * granularity);
+        return out;
+    }
+
+    /// Returns the number of slots in the buffer
+    size_t Size() const {
+        // Load the read index first so the write index can never be seen behind it
+        const size_t read_index = this->read_index.load(std::memory_order_acquire);
+        return write_index.load(std::memory_order_acquire) - read_index;
+    }
+
+    /// Returns the maximum number of slots the buffer can hold
+    static constexpr size_t Capacity() {
+        return capacity;
+    }
+
+private:
+    // The indices only ever increase and wrap around with size_t; since capacity is a power of
+    // two, index % capacity stays continuous across the wrap.
+    std::atomic<size_t> read_index{0};
+    std::atomic<size_t> write_index{0};
+
+    std::array<T, granularity * capacity> data;
+};
+
+} // namespace Common
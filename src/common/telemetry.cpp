@@ -9,12 +9,44 @@ namespace Telemetry {
 
 void FieldCollection::Accept(VisitorInterface& visitor) const {
     for (const auto& field : fields) {
-        field.second->Accept(visitor);
+        field->Accept(visitor);
     }
 }
 
 void FieldCollection::AddField(std::unique_ptr<FieldInterface> field) {
-    fields[field->GetName()] = std::move(field);
+    StoreField(std::move(field));
+}
+
+size_t FieldCollection::StoreField(std::unique_ptr<FieldInterface> field) {
+    auto inserted = index_by_name.emplace(field->GetName(), fields.size());
+    const size_t index = inserted.first->second;
+    if (inserted.second) {
+        fields.push_back(std::move(field));
+    } else {
+        fields[index] = std::move(field);
+    }
+    return index;
+}
+
+size_t FieldCollection::FindField(const char* name) {
+    auto cached = index_by_address.find(name);
+    if (cached != index_by_address.end() && fields[cached->second]->GetName() == name) {
+        return cached->second;
+    }
+
+    auto found = index_by_name.find(name);
+    if (found == index_by_name.end()) {
+        return fields.size();
+    }
+    CacheIndex(name, found->second);
+    return found->second;
+}
+
+void FieldCollection::CacheIndex(const char* name, size_t index) {
+    if (index_by_address.size() >= 2 * fields.size()) {
+        index_by_address.clear();
+    }
+    index_by_address[name] = index;
 }
 
 template <class T>
@@ -5,9 +5,10 @@
 #pragma once
 
 #include <chrono>
-#include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "common/common_types.h"
 
 namespace Telemetry {
@@ -94,6 +95,14 @@ public:
         return value;
     }
 
+    /**
+     * Replaces the type and value of the field, keeping its name.
+     */
+    void SetValue(FieldType new_type, T new_value) {
+        type = new_type;
+        value = std::move(new_value);
+    }
+
     inline bool operator==(const Field<T>& other) {
         return (type == other.type) && (name == other.name) && (value == other.value);
     }
@@ -110,36 +119,63 @@ private:
 
 /**
  * Collection of data fields that have been logged.
+ * Fields are stored once per name and updated in place when the same name is added again, so that
+ * metrics recorded repeatedly don't allocate after the first time. Names are looked up by the
+ * address of the string passed to AddField first, which is the same on every call for a literal.
  */
 class FieldCollection final : NonCopyable {
 public:
     FieldCollection() = default;
 
     /**
-     * Accept method for the visitor pattern, visits each field in the collection.
+     * Accept method for the visitor pattern, visits each field in the collection, in the order
+     * they were first added.
      * @param visitor Reference to the visitor that will visit each field.
      */
     void Accept(VisitorInterface& visitor) const;
 
     /**
-     * Creates a new field and adds it to the field collection.
+     * Creates a new field and adds it to the field collection, or updates the field of the same
+     * name if there is one.
      * @param type Type of the field to add.
      * @param name Name of the field to add.
      * @param value Value for the field to add.
      */
     template <typename T>
     void AddField(FieldType type, const char* name, T value) {
-        return AddField(std::make_unique<Field<T>>(type, name, std::move(value)));
+        const size_t index = FindField(name);
+        if (index != fields.size()) {
+            if (auto field = dynamic_cast<Field<T>*>(fields[index].get())) {
+                field->SetValue(type, std::move(value));
+                return;
+            }
+        }
+        auto new_field = std::make_unique<Field<T>>(type, name, std::move(value));
+        CacheIndex(name, StoreField(std::move(new_field)));
     }
 
     /**
-     * Adds a new field to the field collection.
+     * Adds a new field to the field collection, replacing the field of the same name if there is
+     * one.
      * @param field Field to add to the field collection.
      */
     void AddField(std::unique_ptr<FieldInterface> field);
 
 private:
-    std::map<std::string, std::unique_ptr<FieldInterface>> fields;
+    /// Returns the index of the field with the given name, or the number of fields if there is none
+    size_t FindField(const char* name);
+
+    /// Adds or replaces a field, returns its index
+    size_t StoreField(std::unique_ptr<FieldInterface> field);
+
+    /// Remembers the index of the field named by the string at the given address
+    void CacheIndex(const char* name, size_t index);
+
+    std::vector<std::unique_ptr<FieldInterface>> fields;
+    std::unordered_map<std::string, size_t> index_by_name;
+    /// Index of the field last found for each name address, checked against the name before use.
+    /// Cleared when it outgrows the fields, as names not stored in string literals never repeat.
+    std::unordered_map<const char*, size_t> index_by_address;
 };
 
 /**
@@ -0,0 +1,172 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+namespace {
+
+/// Pool and index of the worker running on the current thread, if it is one
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+/// State of one ParallelFor call, shared with the tasks that help run it
+struct LoopState {
+    const ThreadPool::RangeFunction* func;
+    size_t count;
+    size_t chunk_size;
+    size_t num_chunks;
+
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> finished_chunks{0};
+    std::mutex mutex;
+    std::condition_variable done;
+
+    /// Runs chunks of the loop until none are left
+    void RunChunks() {
+        // `func` may only be touched after claiming a chunk: once all chunks have finished, the
+        // caller returns and it is gone
+        for (size_t chunk = next_chunk++; chunk < num_chunks; chunk = next_chunk++) {
+            const size_t begin = chunk * chunk_size;
+            (*func)(begin, std::min(begin + chunk_size, count));
+
+            if (++finished_chunks == num_chunks) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_one();
+            }
+        }
+    }
+};
+
+} // Anonymous namespace
+
+ThreadPool::ThreadPool(size_t num_workers, u32 affinity_mask) {
+    workers.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    // Started once all queues exist, as workers steal from each other's
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers[i]->thread = std::thread(&ThreadPool::WorkerLoop, this, i, affinity_mask);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stop = true;
+    }
+    work_available.notify_all();
+
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+void ThreadPool::Submit(Task task) {
+    if (workers.empty()) {
+        task();
+        return;
+    }
+
+    const size_t index = current_pool == this ? current_worker : next_worker++ % workers.size();
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        ++queued_tasks;
+    }
+    work_available.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t chunk_size, const RangeFunction& func) {
+    if (count == 0) {
+        return;
+    }
+
+    if (workers.empty() || count <= chunk_size) {
+        func(0, count);
+        return;
+    }
+
+    auto loop = std::make_shared<LoopState>();
+    loop->func = &func;
+    loop->count = count;
+    loop->chunk_size = chunk_size;
+    loop->num_chunks = (count + chunk_size - 1) / chunk_size;
+
+    // Helpers that only get to run after the loop is done find no chunks left and return
+    const size_t num_helpers = std::min(workers.size(), loop->num_chunks - 1);
+    for (size_t i = 0; i < num_helpers; ++i) {
+        Submit([loop] { loop->RunChunks(); });
+    }
+
+    loop->RunChunks();
+
+    // The loop must not return while another thread might still call into `func`
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->done.wait(lock, [&] { return loop->finished_chunks == loop->num_chunks; });
+}
+
+bool ThreadPool::TakeTask(size_t index, Task& task) {
+    {
+        Worker& own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < workers.size(); ++i) {
+        Worker& victim = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(size_t index, u32 affinity_mask) {
+    SetCurrentThreadName("ThreadPoolWorker");
+    if (affinity_mask != 0) {
+        SetCurrentThreadAffinity(affinity_mask);
+    }
+    current_pool = this;
+    current_worker = index;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            work_available.wait(lock, [this] { return stop || queued_tasks != 0; });
+            if (stop) {
+                return;
+            }
+            --queued_tasks;
+        }
+
+        // Every queued task is counted once, so one is there to take, here or on another worker
+        Task task;
+        while (!TakeTask(index, task)) {
+            YieldCPU();
+        }
+        task();
+    }
+}
+
+ThreadPool& GetSharedThreadPool() {
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+} // namespace Common
@@ -0,0 +1,87 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Fixed set of worker threads running submitted tasks and splitting loops. Each worker has its own
+ * task queue: it takes the most recently queued tasks from its own queue first, and steals the
+ * oldest tasks of the other workers when that runs dry.
+ *
+ * Any thread, including the workers themselves, can submit tasks and run loops at the same time.
+ * The thread calling ParallelFor works on the loop as well, and returns once the whole loop is
+ * done, so loops never wait on the workers being free.
+ */
+class ThreadPool : NonCopyable {
+public:
+    using Task = std::function<void()>;
+    /// Function called for the half-open element range [begin, end) of a loop
+    using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+    /**
+     * @param num_workers Number of worker threads to start
+     * @param affinity_mask Host CPUs the workers may run on, all of them if 0
+     */
+    explicit ThreadPool(size_t num_workers, u32 affinity_mask = 0);
+    ~ThreadPool();
+
+    /// Returns the number of threads loops are split across, including the calling thread
+    size_t NumThreads() const {
+        return workers.size() + 1;
+    }
+
+    /**
+     * Queues a task to run on one of the workers. Tasks submitted by a worker go to its own queue.
+     * Without workers, the task runs right away on the calling thread.
+     */
+    void Submit(Task task);
+
+    /**
+     * Calls `func` for consecutive ranges of at most `chunk_size` elements covering [0, count),
+     * distributing the ranges across the threads of the pool
+     */
+    void ParallelFor(size_t count, size_t chunk_size, const RangeFunction& func);
+
+private:
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void WorkerLoop(size_t index, u32 affinity_mask);
+
+    /// Takes a task from the given worker's own queue, or steals one from the others
+    bool TakeTask(size_t index, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    /// Number of queued tasks, which sleeping workers wait on
+    std::mutex sleep_mutex;
+    std::condition_variable work_available;
+    size_t queued_tasks = 0;
+    bool stop = false;
+
+    /// Worker that the next task submitted from outside the pool goes to
+    std::atomic<size_t> next_worker{0};
+};
+
+/// Returns a pool shared across the emulator, with a worker for each host CPU but one
+ThreadPool& GetSharedThreadPool();
+
+} // namespace Common
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include "common/common_types.h"
 #include "core/arm/skyeye_common/arm_regformat.h"
 #include "core/arm/skyeye_common/vfp/asm_vfp.h"
@@ -41,6 +42,13 @@ public:
     /// Clear all instruction cache
     virtual void ClearInstructionCache() = 0;
 
+    /**
+     * Invalidate the code cache for a range of guest memory, after the code in it has changed
+     * @param start_address Start of the range
+     * @param length Length of the range in bytes
+     */
+    virtual void InvalidateCacheRange(VAddr start_address, size_t length) = 0;
+
     /**
      * Set the Program Counter to an address
      * @param addr Address to set PC to
@@ -147,9 +155,6 @@ public:
         return num_instructions;
     }
 
-    s64 down_count = 0; ///< A decreasing counter of remaining cycles before the next event,
-                        /// decreased by the cpu run loop
-
 protected:
     /**
      * Executes the given number of instructions
@@ -9,6 +9,7 @@
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/arm/dynarmic/arm_dynarmic_cp15.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
+#include "core/arm/idle_loop.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/svc.h"
@@ -56,6 +57,8 @@ static Dynarmic::UserCallbacks GetUserCallbacks(
     user_callbacks.memory.Write16 = &Memory::Write16;
     user_callbacks.memory.Write32 = &Memory::Write32;
     user_callbacks.memory.Write64 = &Memory::Write64;
+    // The JIT reads and writes pages with a host pointer directly, only unmapped, MMIO and
+    // rasterizer-cached pages (whose pointer is null) go through the callbacks above
     user_callbacks.page_table = Memory::GetCurrentPageTablePointers();
     user_callbacks.coprocessors[15] = std::make_shared<DynarmicCP15>(interpeter_state);
     return user_callbacks;
@@ -125,10 +128,7 @@ void ARM_Dynarmic::SetCP15Register(CP15Register reg, u32 value) {
 }
 
 void ARM_Dynarmic::AddTicks(u64 ticks) {
-    down_count -= ticks;
-    if (down_count < 0) {
-        CoreTiming::Advance();
-    }
+    CoreTiming::AddTicks(ticks);
 }
 
 MICROPROFILE_DEFINE(ARM_Jit, "ARM JIT", "ARM JIT", MP_RGB(255, 64, 64));
@@ -138,7 +138,17 @@ void ARM_Dynarmic::ExecuteInstructions(int num_instructions) {
 
     unsigned ticks_executed = jit->Run(static_cast<unsigned>(num_instructions));
 
+    const bool skip_to_next_event =
+        IdleLoop::CanSkipToNextEvent(CoreTiming::GetDowncount(), ticks_executed,
+                                     Core::System::GetInstance().IsReschedulePending()) &&
+        IdleLoop::IsSpinning(jit->Regs(), jit->Cpsr());
+
     AddTicks(ticks_executed);
+
+    if (skip_to_next_event) {
+        CoreTiming::Idle();
+        CoreTiming::Advance();
+    }
 }
 
 void ARM_Dynarmic::SaveContext(ARM_Interface::ThreadContext& ctx) {
@@ -176,3 +186,7 @@ void ARM_Dynarmic::PrepareReschedule() {
 void ARM_Dynarmic::ClearInstructionCache() {
     jit->ClearCache();
 }
+
+void ARM_Dynarmic::InvalidateCacheRange(VAddr start_address, size_t length) {
+    jit->InvalidateCacheRange(start_address, length);
+}
@@ -4,27 +4,56 @@
 
 #include <cstring>
 #include <memory>
+#include <vector>
 #include "core/arm/dyncom/arm_dyncom.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
 #include "core/arm/dyncom/arm_dyncom_run.h"
 #include "core/arm/dyncom/arm_dyncom_trans.h"
+#include "core/arm/idle_loop.h"
 #include "core/arm/skyeye_common/armstate.h"
 #include "core/arm/skyeye_common/armsupp.h"
 #include "core/arm/skyeye_common/vfp/vfp.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/loader/loader.h"
+#include "core/settings.h"
+
+/// Pages whose recorded blocks are checked each time the guest idles, bounding the host time
+/// spent in one go
+constexpr size_t PAGES_PER_IDLE = 16;
 
 ARM_DynCom::ARM_DynCom(PrivilegeMode initial_mode) {
     state = std::make_unique<ARMul_State>(initial_mode);
+
+    if (Settings::values.use_disk_block_cache) {
+        u64 program_id;
+        if (Core::System::GetInstance().GetAppLoader().ReadProgramId(program_id) ==
+            Loader::ResultStatus::Success) {
+            block_disk_cache = std::make_unique<BlockDiskCache>();
+            block_disk_cache->Open(program_id);
+            state->block_disk_cache = block_disk_cache.get();
+            translating_ahead = true;
+        }
+    }
 }
 
 ARM_DynCom::~ARM_DynCom() {}
 
 void ARM_DynCom::ClearInstructionCache() {
-    state->instruction_cache.clear();
+    state->ClearInstructionCache();
     trans_cache_buf_top = 0;
 }
 
+void ARM_DynCom::InvalidateCacheRange(VAddr start_address, size_t length) {
+    // Dropped blocks keep their space in the translation buffer until it is reset, so start over
+    // once it fills up
+    if (trans_cache_buf_top > TRANS_CACHE_SIZE / 2) {
+        ClearInstructionCache();
+        return;
+    }
+    state->InvalidateInstructionCacheRange(start_address, length);
+}
+
 void ARM_DynCom::SetPC(u32 pc) {
     state->Reg[15] = pc;
 }
@@ -74,9 +103,7 @@ void ARM_DynCom::SetCP15Register(CP15Register reg, u32 value) {
 }
 
 void ARM_DynCom::AddTicks(u64 ticks) {
-    down_count -= ticks;
-    if (down_count < 0)
-        CoreTiming::Advance();
+    CoreTiming::AddTicks(ticks);
 }
 
 void ARM_DynCom::ExecuteInstructions(int num_instructions) {
@@ -86,7 +113,36 @@ void ARM_DynCom::ExecuteInstructions(int num_instructions) {
     // executing one instruction at a time. Otherwise, if a block is being executed, more
     // instructions may actually be executed than specified.
     unsigned ticks_executed = InterpreterMainLoop(state.get());
+
+    const bool skip_to_next_event =
+        state->in_idle_loop &&
+        IdleLoop::CanSkipToNextEvent(CoreTiming::GetDowncount(), ticks_executed,
+                                     Core::System::GetInstance().IsReschedulePending());
+    state->in_idle_loop = false;
+
     AddTicks(ticks_executed);
+
+    if (skip_to_next_event) {
+        if (translating_ahead)
+            TranslateRecordedBlocks();
+
+        CoreTiming::Idle();
+        CoreTiming::Advance();
+    }
+}
+
+void ARM_DynCom::TranslateRecordedBlocks() {
+    // Leave most of the translation buffer to the blocks that are actually executed, it is only
+    // reset once half of it is used
+    if (trans_cache_buf_top > TRANS_CACHE_SIZE / 4) {
+        translating_ahead = false;
+        return;
+    }
+
+    std::vector<BlockDiskCache::BlockKey> blocks;
+    translating_ahead = block_disk_cache->GetMatchingBlocks(PAGES_PER_IDLE, blocks);
+    for (BlockDiskCache::BlockKey block : blocks)
+        InterpreterTranslateAhead(state.get(), block & ~1u, (block & 1) != 0);
 }
 
 void ARM_DynCom::SaveContext(ThreadContext& ctx) {
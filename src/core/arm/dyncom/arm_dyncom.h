@@ -7,6 +7,7 @@
 #include <memory>
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
 #include "core/arm/skyeye_common/arm_regformat.h"
 #include "core/arm/skyeye_common/armstate.h"
 
@@ -16,6 +17,7 @@ public:
     ~ARM_DynCom();
 
     void ClearInstructionCache() override;
+    void InvalidateCacheRange(VAddr start_address, size_t length) override;
 
     void SetPC(u32 pc) override;
     u32 GetPC() const override;
@@ -39,5 +41,11 @@ public:
     void ExecuteInstructions(int num_instructions) override;
 
 private:
+    /// Translates blocks recorded in earlier boots ahead of time, while the guest is idle
+    void TranslateRecordedBlocks();
+
     std::unique_ptr<ARMul_State> state;
+    std::unique_ptr<BlockDiskCache> block_disk_cache;
+    /// Whether the block disk cache has recorded blocks left to translate ahead of time
+    bool translating_ahead = false;
 };
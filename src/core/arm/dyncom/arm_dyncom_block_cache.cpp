@@ -0,0 +1,143 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cinttypes>
+#include <map>
+#include <string>
+#include <utility>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
+#include "core/memory.h"
+
+namespace {
+
+/// Number of times the page of recorded blocks is checked for the code they were recorded from,
+/// before they are given up on. Pages of code loaded later than the first checks, such as CROs,
+/// match on one of the later ones.
+constexpr unsigned MAX_PAGE_CHECKS = 64;
+
+/// Collects the recorded blocks by page as the cache file is being read
+class BlockCollector : public LinearDiskCacheReader<BlockDiskCache::BlockKey, u32> {
+public:
+    void Read(const BlockDiskCache::BlockKey& key, const u32* value, u32 value_size) override {
+        if (value_size != 2)
+            return;
+
+        const u64 hash = value[0] | static_cast<u64>(value[1]) << 32;
+        blocks[key] = hash;
+
+        // A page recorded again with other code replaces its earlier blocks
+        Page& page = pages[key >> Memory::PAGE_BITS];
+        if (page.hash != hash) {
+            page.hash = hash;
+            page.blocks.clear();
+        }
+        page.blocks.push_back(key);
+    }
+
+    struct Page {
+        u64 hash = 0;
+        std::vector<BlockDiskCache::BlockKey> blocks;
+    };
+
+    std::unordered_map<BlockDiskCache::BlockKey, u64> blocks;
+    /// Ordered by address, so that the blocks of a title's main code are translated first
+    std::map<u32, Page> pages;
+};
+
+} // Anonymous namespace
+
+/// Returns the hash of the page's contents, or false if it can't be read directly
+static bool HashPage(u32 page, u64& hash) {
+    const VAddr address = page << Memory::PAGE_BITS;
+    if (!Memory::IsValidVirtualAddress(address))
+        return false;
+
+    const u8* data = Memory::GetPointer(address);
+    if (data == nullptr)
+        return false;
+
+    hash = Common::ComputeHash64(data, Memory::PAGE_SIZE);
+    return true;
+}
+
+BlockDiskCache::~BlockDiskCache() {
+    disk_cache.Close();
+}
+
+void BlockDiskCache::Open(u64 program_id) {
+    const std::string dir = FileUtil::GetUserPath(D_CACHE_IDX) + "cpu" DIR_SEP;
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(Core_ARM11, "Failed to create CPU cache directory %s", dir.c_str());
+        return;
+    }
+
+    const std::string filename =
+        dir + Common::StringFromFormat("%016" PRIX64 "_dyncom.bin", program_id);
+
+    BlockCollector collector;
+    disk_cache.OpenAndRead(filename.c_str(), collector);
+    open = true;
+
+    recorded_blocks = std::move(collector.blocks);
+    for (auto& page : collector.pages) {
+        pending_pages.push_back(
+            {page.first, page.second.hash, std::move(page.second.blocks), MAX_PAGE_CHECKS});
+    }
+
+    LOG_INFO(Core_ARM11, "Loaded %zu code blocks in %zu pages from %s", recorded_blocks.size(),
+             pending_pages.size(), filename.c_str());
+}
+
+void BlockDiskCache::Record(u32 address, bool thumb) {
+    if (!open)
+        return;
+
+    const u32 page = address >> Memory::PAGE_BITS;
+    auto page_itr = page_hashes.find(page);
+    if (page_itr == page_hashes.end()) {
+        u64 hash;
+        if (!HashPage(page, hash))
+            return;
+        page_itr = page_hashes.emplace(page, hash).first;
+    }
+
+    const BlockKey key = address | (thumb ? 1 : 0);
+    auto block_itr = recorded_blocks.find(key);
+    if (block_itr != recorded_blocks.end() && block_itr->second == page_itr->second)
+        return;
+    recorded_blocks[key] = page_itr->second;
+
+    const u32 value[2] = {static_cast<u32>(page_itr->second),
+                          static_cast<u32>(page_itr->second >> 32)};
+    disk_cache.Append(key, value, 2);
+}
+
+void BlockDiskCache::Invalidate(VAddr start_address, size_t length) {
+    if (length == 0)
+        return;
+
+    const u32 last_page = static_cast<u32>((start_address + length - 1) >> Memory::PAGE_BITS);
+    for (u32 page = start_address >> Memory::PAGE_BITS; page <= last_page; ++page)
+        page_hashes.erase(page);
+}
+
+bool BlockDiskCache::GetMatchingBlocks(size_t max_pages, std::vector<BlockKey>& blocks) {
+    for (size_t i = 0; i < max_pages && !pending_pages.empty(); ++i) {
+        PendingPage page = std::move(pending_pages.front());
+        pending_pages.pop_front();
+
+        u64 hash;
+        if (HashPage(page.page, hash) && hash == page.hash) {
+            blocks.insert(blocks.end(), page.blocks.begin(), page.blocks.end());
+        } else if (--page.checks_left != 0) {
+            pending_pages.push_back(std::move(page));
+        }
+    }
+    return !pending_pages.empty();
+}
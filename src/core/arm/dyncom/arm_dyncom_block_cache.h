@@ -0,0 +1,64 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "common/linear_disk_cache.h"
+
+/**
+ * Per-title file of the guest code blocks the interpreter translated, so that the blocks can be
+ * translated ahead of time when the title boots again. Each block is stored with a hash of the
+ * page it starts in, as the page was when the block was translated, and is only translated ahead
+ * of time once the page holds the same code again.
+ *
+ * The file holds guest addresses rather than translated code, which is cheap to produce again.
+ */
+class BlockDiskCache : NonCopyable {
+public:
+    /// Start address of a block, with bit 0 set for Thumb code
+    using BlockKey = u32;
+
+    ~BlockDiskCache();
+
+    /// Reads the blocks recorded for the title, and opens its file to record more in
+    void Open(u64 program_id);
+
+    /// Records a block translated from the guest code at the given address
+    void Record(u32 address, bool thumb);
+
+    /// Forgets the hashes of the pages in the range, whose code may have changed
+    void Invalidate(VAddr start_address, size_t length);
+
+    /**
+     * Checks up to max_pages pages with blocks that are still to be translated ahead of time,
+     * adding the blocks of the pages that hold the code they were recorded from to blocks. Pages
+     * that don't hold it yet are checked again later, a limited number of times.
+     * @returns Whether pages are left to check
+     */
+    bool GetMatchingBlocks(size_t max_pages, std::vector<BlockKey>& blocks);
+
+private:
+    struct PendingPage {
+        u32 page;
+        u64 hash;
+        std::vector<BlockKey> blocks;
+        unsigned checks_left;
+    };
+
+    LinearDiskCache<BlockKey, u32> disk_cache;
+    bool open = false;
+
+    /// Hash of each page as it was when the first block in it was recorded in this session
+    std::unordered_map<u32, u64> page_hashes;
+    /// Page hash each block in the file was last recorded with
+    std::unordered_map<BlockKey, u64> recorded_blocks;
+    /// Pages of earlier sessions whose blocks haven't been translated ahead of time yet
+    std::deque<PendingPage> pending_pages;
+};
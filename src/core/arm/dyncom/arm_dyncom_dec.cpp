@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <cstddef>
+#include <vector>
 #include "core/arm/dyncom/arm_dyncom_dec.h"
 #include "core/arm/skyeye_common/armsupp.h"
 
@@ -415,64 +418,88 @@ const InstructionSetEncodingItem arm_exclusion_code[] = {
 };
 // clang-format on
 
-ARMDecodeStatus DecodeARMInstruction(u32 instr, int* idx) {
-    int n = 0;
-    int base = 0;
-    int instr_slots = sizeof(arm_instruction) / sizeof(InstructionSetEncodingItem);
-    ARMDecodeStatus ret = ARMDecodeStatus::FAILURE;
+namespace {
 
-    for (int i = 0; i < instr_slots; i++) {
-        n = arm_instruction[i].attribute_value;
-        base = 0;
+/// Instructions are bucketed by their bits 20-27 and 4-7, which tell most kinds of them apart
+constexpr size_t NUM_DECODE_BUCKETS = 1 << 12;
 
-        // 3DS has no VFP3 support
-        if (arm_instruction[i].version == ARMVFP3)
-            continue;
+size_t GetDecodeBucket(u32 instr) {
+    return (BITS(instr, 20, 27) << 4) | BITS(instr, 4, 7);
+}
 
-        while (n) {
-            if (arm_instruction[i].content[base + 1] == 31 &&
-                arm_instruction[i].content[base] == 0) {
-                // clrex
-                if (instr != arm_instruction[i].content[base + 2]) {
-                    break;
-                }
-            } else if (BITS(instr, arm_instruction[i].content[base],
-                            arm_instruction[i].content[base + 1]) !=
-                       arm_instruction[i].content[base + 2]) {
-                break;
-            }
-            base += 3;
-            n--;
+/// Whether the instruction satisfies all conditions of the encoding
+bool MatchesEncoding(const InstructionSetEncodingItem& item, u32 instr) {
+    for (int n = 0, base = 0; n < item.attribute_value; n++, base += 3) {
+        if (item.content[base + 1] == 31 && item.content[base] == 0) {
+            // clrex
+            if (instr != item.content[base + 2])
+                return false;
+        } else if (BITS(instr, item.content[base], item.content[base + 1]) !=
+                   item.content[base + 2]) {
+            return false;
         }
+    }
+    return true;
+}
+
+/// Whether instructions of the bucket can satisfy the conditions of the encoding
+bool BucketMayMatchEncoding(const InstructionSetEncodingItem& item, size_t bucket) {
+    for (int n = 0, base = 0; n < item.attribute_value; n++, base += 3) {
+        const u32 low = item.content[base];
+        const u32 high = item.content[base + 1];
+        for (u32 bit = low; bit <= high; bit++) {
+            int bucket_bit;
+            if (bit >= 20 && bit <= 27)
+                bucket_bit = bit - 20 + 4;
+            else if (bit >= 4 && bit <= 7)
+                bucket_bit = bit - 4;
+            else
+                continue;
 
-        // All conditions are satisfied.
-        if (n == 0)
-            ret = ARMDecodeStatus::SUCCESS;
+            if (((bucket >> bucket_bit) & 1) != ((item.content[base + 2] >> (bit - low)) & 1))
+                return false;
+        }
+    }
+    return true;
+}
 
-        if (ret == ARMDecodeStatus::SUCCESS) {
-            n = arm_exclusion_code[i].attribute_value;
-            if (n != 0) {
-                base = 0;
-                while (n) {
-                    if (BITS(instr, arm_exclusion_code[i].content[base],
-                             arm_exclusion_code[i].content[base + 1]) !=
-                        arm_exclusion_code[i].content[base + 2]) {
-                        break;
-                    }
-                    base += 3;
-                    n--;
-                }
+using DecodeBuckets = std::array<std::vector<u16>, NUM_DECODE_BUCKETS>;
 
-                // All conditions are satisfied.
-                if (n == 0)
-                    ret = ARMDecodeStatus::FAILURE;
+/// Indices into arm_instruction of the encodings instructions of each bucket can have, in the
+/// order of the table, so that the first match is the same as in a search of the whole table
+const DecodeBuckets& GetDecodeBuckets() {
+    static const DecodeBuckets buckets = [] {
+        DecodeBuckets buckets;
+        const size_t instr_slots = sizeof(arm_instruction) / sizeof(InstructionSetEncodingItem);
+        for (size_t bucket = 0; bucket < NUM_DECODE_BUCKETS; bucket++) {
+            for (size_t i = 0; i < instr_slots; i++) {
+                // 3DS has no VFP3 support
+                if (arm_instruction[i].version == ARMVFP3)
+                    continue;
+
+                if (BucketMayMatchEncoding(arm_instruction[i], bucket))
+                    buckets[bucket].push_back(static_cast<u16>(i));
             }
         }
+        return buckets;
+    }();
+    return buckets;
+}
 
-        if (ret == ARMDecodeStatus::SUCCESS) {
-            *idx = i;
-            return ret;
-        }
+} // Anonymous namespace
+
+ARMDecodeStatus DecodeARMInstruction(u32 instr, int* idx) {
+    for (u16 i : GetDecodeBuckets()[GetDecodeBucket(instr)]) {
+        if (!MatchesEncoding(arm_instruction[i], instr))
+            continue;
+
+        // Encodings with exclusions don't match instructions that satisfy all of those
+        const InstructionSetEncodingItem& exclusion = arm_exclusion_code[i];
+        if (exclusion.attribute_value != 0 && MatchesEncoding(exclusion, instr))
+            continue;
+
+        *idx = i;
+        return ARMDecodeStatus::SUCCESS;
     }
-    return ret;
+    return ARMDecodeStatus::FAILURE;
 }
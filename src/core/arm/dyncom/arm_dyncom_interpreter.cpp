@@ -5,6 +5,7 @@
 #define CITRA_IGNORE_EXIT(x)
 
 #include <algorithm>
+#include <array>
 #include <cinttypes>
 #include <cstdio>
 #include "common/common_types.h"
@@ -15,6 +16,7 @@
 #include "core/arm/dyncom/arm_dyncom_run.h"
 #include "core/arm/dyncom/arm_dyncom_thumb.h"
 #include "core/arm/dyncom/arm_dyncom_trans.h"
+#include "core/arm/idle_loop.h"
 #include "core/arm/skyeye_common/armstate.h"
 #include "core/arm/skyeye_common/armsupp.h"
 #include "core/arm/skyeye_common/vfp/vfp.h"
@@ -804,6 +806,18 @@ static ThumbDecodeStatus DecodeThumbInstruction(u32 inst, u32 addr, u32* arm_ins
 
 enum { KEEP_GOING, FETCH_EXCEPTION };
 
+/// A Thumb instruction, other than a branch, translated to ARM and decoded
+struct ThumbDecodeCacheEntry {
+    u32 arm_inst;
+    /// Index of the ARM instruction in arm_instruction_trans
+    u16 idx;
+    bool cached;
+};
+
+/// Both the translation and the decoding of a Thumb instruction only depend on its 16 bits, so
+/// they are done once per instruction, and looked up here when it's translated again.
+static std::array<ThumbDecodeCacheEntry, 0x10000> thumb_decode_cache;
+
 MICROPROFILE_DEFINE(DynCom_Decode, "DynCom", "Decode", MP_RGB(255, 64, 64));
 
 static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, const u32 phys_addr,
@@ -813,7 +827,15 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
 
     // If we are in Thumb mode, we'll translate one Thumb instruction to the corresponding ARM
     // instruction
+    ThumbDecodeCacheEntry* thumb_entry = nullptr;
     if (cpu->TFlag) {
+        thumb_entry = &thumb_decode_cache[GetThumbInstruction(inst, phys_addr)];
+        if (thumb_entry->cached) {
+            inst_base = arm_instruction_trans[thumb_entry->idx](thumb_entry->arm_inst,
+                                                                thumb_entry->idx);
+            return 2;
+        }
+
         u32 arm_inst;
         ThumbDecodeStatus state =
             DecodeThumbInstruction(inst, phys_addr, &arm_inst, &inst_size, &inst_base);
@@ -835,9 +857,25 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
     }
     inst_base = arm_instruction_trans[idx](inst, idx);
 
+    if (thumb_entry != nullptr)
+        *thumb_entry = {inst, static_cast<u16>(idx), true};
+
     return inst_size;
 }
 
+/// Returns the links of a direct branch, or nullptr if the instruction isn't one
+static BlockLinks* GetDirectBranchLinks(arm_inst* inst_base) {
+    // The Thumb branches are at the end of the translation table, right after BBL
+    const size_t b_2_thumb_index = arm_instruction_trans_len - 5;
+    if (inst_base->idx == b_2_thumb_index - 1)
+        return &reinterpret_cast<bbl_inst*>(inst_base->component)->links;
+    if (inst_base->idx == b_2_thumb_index)
+        return &reinterpret_cast<b_2_thumb*>(inst_base->component)->links;
+    if (inst_base->idx == b_2_thumb_index + 1)
+        return &reinterpret_cast<b_cond_thumb*>(inst_base->component)->links;
+    return nullptr;
+}
+
 static int InterpreterTranslateBlock(ARMul_State* cpu, int& bb_start, u32 addr) {
     MICROPROFILE_SCOPE(DynCom_Decode);
 
@@ -866,7 +904,13 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, int& bb_start, u32 addr)
         ret = inst_base->br;
     };
 
+    // Blocks that loop back to themselves may be idle loops, which skip ahead to the next event
+    BlockLinks* links = GetDirectBranchLinks(inst_base);
+    if (links != nullptr)
+        links->idle_loop = IdleLoop::IsIdleLoop(pc_start, cpu->TFlag != 0);
+
     cpu->instruction_cache[pc_start] = bb_start;
+    cpu->RegisterBlock(pc_start, phys_addr);
 
     return KEEP_GOING;
 }
@@ -880,17 +924,45 @@ static int InterpreterTranslateSingle(ARMul_State* cpu, int& bb_start, u32 addr)
     u32 phys_addr = addr;
     u32 pc_start = cpu->Reg[15];
 
-    InterpreterTranslateInstruction(cpu, phys_addr, inst_base);
+    unsigned int inst_size = InterpreterTranslateInstruction(cpu, phys_addr, inst_base);
 
     if (inst_base->br == TransExtData::NON_BRANCH) {
         inst_base->br = TransExtData::SINGLE_STEP;
     }
 
     cpu->instruction_cache[pc_start] = bb_start;
+    cpu->RegisterBlock(pc_start, phys_addr + inst_size);
 
     return KEEP_GOING;
 }
 
+void InterpreterTranslateAhead(ARMul_State* cpu, u32 address, bool thumb) {
+    if (cpu->instruction_cache.count(address) != 0)
+        return;
+
+    // The translation takes the address and instruction set of the block from the CPU state
+    const u32 pc = cpu->Reg[15];
+    const u32 t_flag = cpu->TFlag;
+    cpu->Reg[15] = address;
+    cpu->TFlag = thumb ? 1 : 0;
+
+    int bb_start;
+    InterpreterTranslateBlock(cpu, bb_start, address);
+
+    cpu->Reg[15] = pc;
+    cpu->TFlag = t_flag;
+}
+
+/// Returns the successor slot of a direct branch, dropping links made before an invalidation
+static int* GetBlockLink(ARMul_State* cpu, BlockLinks& links, bool taken) {
+    if (links.generation != cpu->block_link_generation) {
+        links.generation = cpu->block_link_generation;
+        links.taken = -1;
+        links.next = -1;
+    }
+    return taken ? &links.taken : &links.next;
+}
+
 static int clz(unsigned int x) {
     int n;
     if (x == 0)
@@ -1621,6 +1693,9 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
     unsigned int num_instrs = 0;
 
     int ptr;
+    // Successor slot of the direct branch that ended the previous block, or nullptr. Branches with
+    // a static target remember the block they lead to, so that it isn't looked up again.
+    int* block_link = nullptr;
 
     LOAD_NZCVT;
 DISPATCH : {
@@ -1635,16 +1710,31 @@ DISPATCH : {
     else
         cpu->Reg[15] &= 0xfffffffc;
 
-    // Find the cached instruction cream, otherwise translate it...
-    auto itr = cpu->instruction_cache.find(cpu->Reg[15]);
-    if (itr != cpu->instruction_cache.end()) {
-        ptr = itr->second;
-    } else if (cpu->NumInstrsToExecute != 1) {
-        if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
+    // Follow the link of the branch that ended the previous block, otherwise find the cached
+    // instruction cream, otherwise translate it...
+    int* const link = block_link;
+    block_link = nullptr;
+    if (link != nullptr && *link >= 0) {
+        ptr = *link;
     } else {
-        if (InterpreterTranslateSingle(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
+        auto& entry = cpu->fetch_cache[(cpu->Reg[15] >> 1) % ARMul_State::FETCH_CACHE_SIZE];
+        if (entry.offset >= 0 && entry.pc == cpu->Reg[15]) {
+            ptr = entry.offset;
+        } else {
+            auto itr = cpu->instruction_cache.find(cpu->Reg[15]);
+            if (itr != cpu->instruction_cache.end()) {
+                ptr = itr->second;
+            } else if (cpu->NumInstrsToExecute != 1) {
+                if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
+                    goto END;
+            } else {
+                if (InterpreterTranslateSingle(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
+                    goto END;
+            }
+            entry = {cpu->Reg[15], ptr};
+        }
+        if (link != nullptr)
+            *link = ptr;
     }
 
     // Find breakpoint if one exists within the block
@@ -1756,16 +1846,22 @@ AND_INST : {
     GOTO_NEXT_INST;
 }
 BBL_INST : {
+    bbl_inst* inst_cream = (bbl_inst*)inst_base->component;
     if ((inst_base->cond == ConditionCode::AL) || CondPassed(cpu, inst_base->cond)) {
-        bbl_inst* inst_cream = (bbl_inst*)inst_base->component;
         if (inst_cream->L) {
             LINK_RTN_ADDR;
         }
         SET_PC;
+        if (inst_cream->links.idle_loop) {
+            cpu->in_idle_loop = true;
+            goto END;
+        }
+        block_link = GetBlockLink(cpu, inst_cream->links, true);
         INC_PC(sizeof(bbl_inst));
         goto DISPATCH;
     }
     cpu->Reg[15] += cpu->GetInstructionSize();
+    block_link = GetBlockLink(cpu, inst_cream->links, false);
     INC_PC(sizeof(bbl_inst));
     goto DISPATCH;
 }
@@ -4310,16 +4406,28 @@ UMULL_INST : {
 B_2_THUMB : {
     b_2_thumb* inst_cream = (b_2_thumb*)inst_base->component;
     cpu->Reg[15] = cpu->Reg[15] + 4 + inst_cream->imm;
+    if (inst_cream->links.idle_loop) {
+        cpu->in_idle_loop = true;
+        goto END;
+    }
+    block_link = GetBlockLink(cpu, inst_cream->links, true);
     INC_PC(sizeof(b_2_thumb));
     goto DISPATCH;
 }
 B_COND_THUMB : {
     b_cond_thumb* inst_cream = (b_cond_thumb*)inst_base->component;
 
-    if (CondPassed(cpu, inst_cream->cond))
+    if (CondPassed(cpu, inst_cream->cond)) {
         cpu->Reg[15] = cpu->Reg[15] + 4 + inst_cream->imm;
-    else
+        if (inst_cream->links.idle_loop) {
+            cpu->in_idle_loop = true;
+            goto END;
+        }
+        block_link = GetBlockLink(cpu, inst_cream->links, true);
+    } else {
         cpu->Reg[15] += 2;
+        block_link = GetBlockLink(cpu, inst_cream->links, false);
+    }
 
     INC_PC(sizeof(b_cond_thumb));
     goto DISPATCH;
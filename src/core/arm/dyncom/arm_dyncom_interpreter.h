@@ -4,6 +4,11 @@
 
 #pragma once
 
+#include "common/common_types.h"
+
 struct ARMul_State;
 
 unsigned InterpreterMainLoop(ARMul_State* state);
+
+/// Translates the block at the given address ahead of it being executed, unless it already is
+void InterpreterTranslateAhead(ARMul_State* state, u32 address, bool thumb);
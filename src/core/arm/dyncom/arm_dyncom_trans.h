@@ -18,6 +18,16 @@ enum class TransExtData {
     SINGLE_STEP = (1 << 8)
 };
 
+/// Offsets of the blocks a direct branch leads to when taken and when not, or -1 until known
+struct BlockLinks {
+    /// Value of ARMul_State::block_link_generation the offsets were recorded in
+    u32 generation;
+    int taken;
+    int next;
+    /// Whether the branch closes an idle loop, which can only exit once memory changes
+    bool idle_loop;
+};
+
 struct arm_inst {
     unsigned int idx;
     unsigned int cond;
@@ -82,8 +92,7 @@ struct eor_inst {
 struct bbl_inst {
     unsigned int L;
     int signed_immed_24;
-    unsigned int next_addr;
-    unsigned int jmp_addr;
+    BlockLinks links;
 };
 
 struct bx_inst {
@@ -447,10 +456,12 @@ struct setend_inst {
 
 struct b_2_thumb {
     unsigned int imm;
+    BlockLinks links;
 };
 struct b_cond_thumb {
     unsigned int imm;
     unsigned int cond;
+    BlockLinks links;
 };
 
 struct bl_1_thumb {
@@ -0,0 +1,381 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/arm/idle_loop.h"
+#include "core/memory.h"
+
+namespace IdleLoop {
+
+namespace {
+
+/// Longest loop that is recognized, in instructions
+constexpr unsigned MAX_LOOP_LENGTH = 8;
+
+// Condition flags, tracked as pseudo-registers 16 to 18 in register masks
+constexpr u32 FLAGS_NZ = 1 << 16;
+constexpr u32 FLAG_C = 1 << 17;
+constexpr u32 FLAG_V = 1 << 18;
+constexpr u32 ALL_FLAGS = FLAGS_NZ | FLAG_C | FLAG_V;
+
+constexpr unsigned PC = 15;
+constexpr u32 COND_AL = 0xE;
+
+enum class CompareOp { TST, TEQ, CMP, CMN };
+
+/// The few instructions an idle loop may consist of
+struct Instruction {
+    enum class Type { Unsupported, Load, Compare, Branch };
+
+    Type type = Type::Unsupported;
+    u32 size;
+
+    unsigned rn;
+
+    // Loads, with an immediate offset and no writeback
+    unsigned rd;
+    unsigned access_size;
+    u32 offset;
+    bool subtract;
+
+    // Compares, against an immediate or an unshifted register
+    CompareOp op;
+    bool immediate;
+    u32 imm;
+    unsigned rm;
+    /// Whether the shifter produces a carry, which TST and TEQ then write to the C flag
+    bool shifter_carry_valid;
+    bool shifter_carry;
+
+    // Branches, to a fixed target
+    u32 cond;
+    VAddr target;
+};
+
+u32 SignExtend(u32 value, unsigned bits) {
+    const u32 sign = 1u << (bits - 1);
+    return (value ^ sign) - sign;
+}
+
+Instruction DecodeARM(VAddr addr) {
+    const u32 inst = Memory::Read32(addr);
+    const u32 cond = inst >> 28;
+
+    Instruction result;
+    result.size = 4;
+
+    if ((inst & 0x0F000000) == 0x0A000000 && cond != 0xF) {
+        // B
+        result.type = Instruction::Type::Branch;
+        result.cond = cond;
+        result.target = addr + 8 + (SignExtend(inst & 0xFFFFFF, 24) << 2);
+        return result;
+    }
+
+    // Conditionally executed instructions would make iterations differ
+    if (cond != COND_AL)
+        return result;
+
+    result.rn = (inst >> 16) & 0xF;
+    result.rd = (inst >> 12) & 0xF;
+    result.subtract = (inst & (1 << 23)) == 0;
+
+    if ((inst & 0x0F300000) == 0x05100000) {
+        // LDR and LDRB with an immediate offset
+        result.type = Instruction::Type::Load;
+        result.access_size = (inst & (1 << 22)) ? 1 : 4;
+        result.offset = inst & 0xFFF;
+    } else if ((inst & 0x0F7000F0) == 0x015000B0) {
+        // LDRH with an immediate offset
+        result.type = Instruction::Type::Load;
+        result.access_size = 2;
+        result.offset = ((inst >> 4) & 0xF0) | (inst & 0xF);
+    } else if ((inst & 0x0F900000) == 0x03100000) {
+        // TST, TEQ, CMP and CMN with an immediate
+        const unsigned rotate = ((inst >> 8) & 0xF) * 2;
+        const u32 imm8 = inst & 0xFF;
+        result.type = Instruction::Type::Compare;
+        result.op = static_cast<CompareOp>((inst >> 21) & 3);
+        result.immediate = true;
+        result.imm = rotate == 0 ? imm8 : (imm8 >> rotate) | (imm8 << (32 - rotate));
+        result.shifter_carry_valid = rotate != 0;
+        result.shifter_carry = (result.imm >> 31) != 0;
+    } else if ((inst & 0x0F900FF0) == 0x01100000) {
+        // TST, TEQ, CMP and CMN with an unshifted register
+        result.type = Instruction::Type::Compare;
+        result.op = static_cast<CompareOp>((inst >> 21) & 3);
+        result.immediate = false;
+        result.rm = inst & 0xF;
+        result.shifter_carry_valid = false;
+    }
+
+    // Loads into PC are branches
+    if (result.type == Instruction::Type::Load && result.rd == PC)
+        result.type = Instruction::Type::Unsupported;
+
+    return result;
+}
+
+Instruction DecodeThumb(VAddr addr) {
+    const u16 inst = Memory::Read16(addr);
+
+    Instruction result;
+    result.size = 2;
+    result.subtract = false;
+    result.shifter_carry_valid = false;
+
+    if ((inst & 0xF000) == 0xD000 && ((inst >> 8) & 0xF) < COND_AL) {
+        // B<cond>
+        result.type = Instruction::Type::Branch;
+        result.cond = (inst >> 8) & 0xF;
+        result.target = addr + 4 + (SignExtend(inst & 0xFF, 8) << 1);
+    } else if ((inst & 0xF800) == 0xE000) {
+        // B
+        result.type = Instruction::Type::Branch;
+        result.cond = COND_AL;
+        result.target = addr + 4 + (SignExtend(inst & 0x7FF, 11) << 1);
+    } else if ((inst & 0xE800) == 0x6800 || (inst & 0xF800) == 0x8800) {
+        // LDR, LDRB and LDRH with an immediate offset
+        result.type = Instruction::Type::Load;
+        result.rd = inst & 7;
+        result.rn = (inst >> 3) & 7;
+        result.access_size = (inst & 0xF800) == 0x6800 ? 4 : (inst & 0xF800) == 0x7800 ? 1 : 2;
+        result.offset = ((inst >> 6) & 0x1F) * result.access_size;
+    } else if ((inst & 0xF800) == 0x9800 || (inst & 0xF800) == 0x4800) {
+        // LDR relative to SP or PC
+        result.type = Instruction::Type::Load;
+        result.rd = (inst >> 8) & 7;
+        result.rn = (inst & 0xF800) == 0x9800 ? 13 : PC;
+        result.access_size = 4;
+        result.offset = (inst & 0xFF) * 4;
+    } else if ((inst & 0xF800) == 0x2800) {
+        // CMP with an immediate
+        result.type = Instruction::Type::Compare;
+        result.op = CompareOp::CMP;
+        result.rn = (inst >> 8) & 7;
+        result.immediate = true;
+        result.imm = inst & 0xFF;
+    } else if ((inst & 0xFFC0) == 0x4200 || (inst & 0xFF80) == 0x4280) {
+        // TST, CMP and CMN with a register
+        result.type = Instruction::Type::Compare;
+        result.op = (inst & 0xFFC0) == 0x4200
+                        ? CompareOp::TST
+                        : (inst & 0xFFC0) == 0x4280 ? CompareOp::CMP : CompareOp::CMN;
+        result.rn = inst & 7;
+        result.immediate = false;
+        result.rm = (inst >> 3) & 7;
+    }
+
+    return result;
+}
+
+Instruction Decode(VAddr addr, bool thumb) {
+    return thumb ? DecodeThumb(addr) : DecodeARM(addr);
+}
+
+u32 RegisterBit(unsigned reg) {
+    // PC reads as a constant
+    return reg == PC ? 0 : 1u << reg;
+}
+
+u32 ReadMask(const Instruction& inst) {
+    switch (inst.type) {
+    case Instruction::Type::Load:
+        return RegisterBit(inst.rn);
+    case Instruction::Type::Compare:
+        return RegisterBit(inst.rn) | (inst.immediate ? 0 : RegisterBit(inst.rm));
+    case Instruction::Type::Branch:
+        return inst.cond == COND_AL ? 0 : ALL_FLAGS;
+    default:
+        return 0;
+    }
+}
+
+u32 WriteMask(const Instruction& inst) {
+    switch (inst.type) {
+    case Instruction::Type::Load:
+        return RegisterBit(inst.rd);
+    case Instruction::Type::Compare:
+        if (inst.op == CompareOp::TST || inst.op == CompareOp::TEQ)
+            return FLAGS_NZ | (inst.shifter_carry_valid ? FLAG_C : 0);
+        return ALL_FLAGS;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Finds the idle loop starting at `start`
+ * @returns Address of the branch closing the loop, or 0 if there is no idle loop at `start`
+ */
+VAddr FindLoop(VAddr start, bool thumb) {
+    // A register that is read before it is written in an iteration must not be written at all
+    u32 written = 0;
+    u32 live_in = 0;
+
+    VAddr addr = start;
+    for (unsigned i = 0; i < MAX_LOOP_LENGTH; ++i) {
+        const Instruction inst = Decode(addr, thumb);
+        if (inst.type == Instruction::Type::Unsupported)
+            return 0;
+
+        live_in |= ReadMask(inst) & ~written;
+        written |= WriteMask(inst);
+
+        if (inst.type == Instruction::Type::Branch) {
+            if (inst.target != start || (live_in & written) != 0)
+                return 0;
+            return addr;
+        }
+        addr += inst.size;
+    }
+    return 0;
+}
+
+u32 ReadRegister(const std::array<u32, 16>& regs, unsigned reg, VAddr addr, bool thumb) {
+    if (reg != PC)
+        return regs[reg];
+    return thumb ? (addr + 4) & ~3u : addr + 8;
+}
+
+bool ConditionPassed(u32 cond, bool n, bool z, bool c, bool v) {
+    switch (cond) {
+    case 0x0:
+        return z;
+    case 0x1:
+        return !z;
+    case 0x2:
+        return c;
+    case 0x3:
+        return !c;
+    case 0x4:
+        return n;
+    case 0x5:
+        return !n;
+    case 0x6:
+        return v;
+    case 0x7:
+        return !v;
+    case 0x8:
+        return c && !z;
+    case 0x9:
+        return !c || z;
+    case 0xA:
+        return n == v;
+    case 0xB:
+        return n != v;
+    case 0xC:
+        return !z && n == v;
+    case 0xD:
+        return z || n != v;
+    default:
+        return true;
+    }
+}
+
+struct CPUState {
+    std::array<u32, 16> regs;
+    bool n;
+    bool z;
+    bool c;
+    bool v;
+};
+
+/**
+ * Runs the loop's instructions from `addr` up to and including the branch closing the loop
+ * @returns Whether the branch is taken, false if a load is out of bounds
+ */
+bool RunToBranch(CPUState& state, VAddr addr, VAddr branch_addr, bool thumb) {
+    auto& r = state.regs;
+    while (addr != branch_addr) {
+        const Instruction inst = Decode(addr, thumb);
+        const u32 base = ReadRegister(r, inst.rn, addr, thumb);
+
+        if (inst.type == Instruction::Type::Load) {
+            const VAddr address = inst.subtract ? base - inst.offset : base + inst.offset;
+            if (!Memory::IsValidVirtualAddress(address))
+                return false;
+            switch (inst.access_size) {
+            case 1:
+                r[inst.rd] = Memory::Read8(address);
+                break;
+            case 2:
+                r[inst.rd] = Memory::Read16(address);
+                break;
+            default:
+                r[inst.rd] = Memory::Read32(address);
+                break;
+            }
+        } else {
+            const u32 operand = inst.immediate ? inst.imm : ReadRegister(r, inst.rm, addr, thumb);
+            u32 result;
+            switch (inst.op) {
+            case CompareOp::TST:
+            case CompareOp::TEQ:
+                result = inst.op == CompareOp::TST ? base & operand : base ^ operand;
+                if (inst.shifter_carry_valid)
+                    state.c = inst.shifter_carry;
+                break;
+            case CompareOp::CMP:
+                result = base - operand;
+                state.c = base >= operand;
+                state.v = (((base ^ operand) & (base ^ result)) >> 31) != 0;
+                break;
+            case CompareOp::CMN:
+            default:
+                result = base + operand;
+                state.c = result < base;
+                state.v = ((~(base ^ operand) & (base ^ result)) >> 31) != 0;
+                break;
+            }
+            state.n = (result >> 31) != 0;
+            state.z = result == 0;
+        }
+        addr += inst.size;
+    }
+
+    const Instruction branch = Decode(branch_addr, thumb);
+    return ConditionPassed(branch.cond, state.n, state.z, state.c, state.v);
+}
+
+} // Anonymous namespace
+
+bool IsIdleLoop(VAddr start, bool thumb) {
+    return FindLoop(start, thumb) != 0;
+}
+
+bool CanSkipToNextEvent(s64 downcount, u64 ticks_executed, bool reschedule_pending) {
+    // Nothing can break the CPU out of an idle loop before the next event, unless the slice ends
+    // and runs events first, or another thread gets to run
+    return !reschedule_pending && downcount > static_cast<s64>(ticks_executed);
+}
+
+bool IsSpinning(const std::array<u32, 16>& regs, u32 cpsr) {
+    const bool thumb = (cpsr & (1 << 5)) != 0;
+    const VAddr pc = regs[PC];
+
+    // Walk forward to the branch closing the loop, whose target is where the loop starts
+    VAddr branch_addr = pc;
+    Instruction branch;
+    for (unsigned i = 0;; ++i) {
+        if (i == MAX_LOOP_LENGTH)
+            return false;
+        branch = Decode(branch_addr, thumb);
+        if (branch.type == Instruction::Type::Unsupported)
+            return false;
+        if (branch.type == Instruction::Type::Branch)
+            break;
+        branch_addr += branch.size;
+    }
+    if (branch.target > pc || FindLoop(branch.target, thumb) != branch_addr)
+        return false;
+
+    // Finish the current iteration, which may have started before memory last changed, then run
+    // a whole one. If that branches back too, so does every iteration after it.
+    CPUState state{regs, (cpsr & (1u << 31)) != 0, (cpsr & (1 << 30)) != 0,
+                   (cpsr & (1 << 29)) != 0, (cpsr & (1 << 28)) != 0};
+    return RunToBranch(state, pc, branch_addr, thumb) &&
+           RunToBranch(state, branch.target, branch_addr, thumb);
+}
+
+} // namespace IdleLoop
@@ -0,0 +1,43 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "common/common_types.h"
+
+/**
+ * Detection of idle loops: short loops that only load from memory, compare and branch back to
+ * their start, as games use to poll for a flag set by an interrupt or another thread. Registers
+ * read by such a loop are either never written in it or reloaded from memory first, so every
+ * iteration repeats the previous one until memory changes. In HLE nothing but a CoreTiming event
+ * changes memory while the CPU spins, so the CPU can skip ahead to the next event instead.
+ */
+namespace IdleLoop {
+
+/**
+ * Checks whether the code at an address is the start of an idle loop
+ * @param start Address of the first instruction of the loop
+ * @param thumb Whether the code is Thumb code
+ * @returns Whether straight-line code from `start` is an idle loop branching back to `start`
+ */
+bool IsIdleLoop(VAddr start, bool thumb);
+
+/**
+ * Checks whether the CPU is spinning in an idle loop, and will keep doing so until memory changes
+ * @param regs General purpose registers, with regs[15] the address of the next instruction to run
+ * @param cpsr Current program status register, for the condition flags and Thumb state
+ */
+bool IsSpinning(const std::array<u32, 16>& regs, u32 cpsr);
+
+/**
+ * Checks whether a CPU that stopped in an idle loop may skip ahead to the next event
+ * @param downcount Cycles left in the slice before the CPU ran
+ * @param ticks_executed Cycles the CPU ran for
+ * @param reschedule_pending Whether the CPU stopped early for a reschedule, after which another
+ *                           thread runs and may release the loop
+ */
+bool CanSkipToNextEvent(s64 downcount, u64 ticks_executed, bool reschedule_pending);
+
+} // namespace IdleLoop
@@ -5,16 +5,63 @@
 #include <algorithm>
 #include "common/logging/log.h"
 #include "common/swap.h"
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
 #include "core/arm/skyeye_common/armstate.h"
 #include "core/arm/skyeye_common/vfp/vfp.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/memory.h"
 
 ARMul_State::ARMul_State(PrivilegeMode initial_mode) {
+    ClearInstructionCache();
     Reset();
     ChangePrivilegeMode(initial_mode);
 }
 
+void ARMul_State::ClearInstructionCache() {
+    instruction_cache.clear();
+    fetch_cache.fill({0, -1});
+    page_blocks.clear();
+    ++block_link_generation;
+}
+
+void ARMul_State::RegisterBlock(u32 start_address, u32 end_address) {
+    const u32 last_page = (end_address - 1) >> Memory::PAGE_BITS;
+    for (u32 page = start_address >> Memory::PAGE_BITS; page <= last_page; ++page)
+        page_blocks[page].push_back(start_address);
+
+    if (block_disk_cache != nullptr)
+        block_disk_cache->Record(start_address, TFlag != 0);
+}
+
+void ARMul_State::InvalidateInstructionCacheRange(VAddr start_address, size_t length) {
+    if (length == 0)
+        return;
+
+    if (block_disk_cache != nullptr)
+        block_disk_cache->Invalidate(start_address, length);
+
+    bool dropped = false;
+    const u32 last_page = static_cast<u32>((start_address + length - 1) >> Memory::PAGE_BITS);
+    for (u32 page = start_address >> Memory::PAGE_BITS; page <= last_page; ++page) {
+        auto itr = page_blocks.find(page);
+        if (itr == page_blocks.end())
+            continue;
+
+        // Blocks spanning two pages are listed in both, erasing them twice is harmless
+        for (u32 block_address : itr->second) {
+            instruction_cache.erase(block_address);
+            auto& entry = fetch_cache[(block_address >> 1) % FETCH_CACHE_SIZE];
+            if (entry.pc == block_address)
+                entry.offset = -1;
+        }
+        page_blocks.erase(itr);
+        dropped = true;
+    }
+
+    if (dropped)
+        ++block_link_generation;
+}
+
 void ARMul_State::ChangePrivilegeMode(u32 new_mode) {
     if (Mode == new_mode)
         return;
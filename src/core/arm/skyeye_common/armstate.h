@@ -19,9 +19,12 @@
 
 #include <array>
 #include <unordered_map>
+#include <vector>
 #include "common/common_types.h"
 #include "core/arm/skyeye_common/arm_regformat.h"
 
+class BlockDiskCache;
+
 // Signal levels
 enum { LOW = 0, HIGH = 1, LOWHIGH = 1, HIGHLOW = 2 };
 
@@ -232,6 +235,30 @@ public:
     // process for our purposes), not per ARMul_State (which tracks CPU core state).
     std::unordered_map<u32, int> instruction_cache;
 
+    /// Direct-mapped cache of instruction_cache entries, tried before the hash map
+    struct FetchCacheEntry {
+        u32 pc;
+        int offset; ///< Block offset in the translation cache, or -1 if the entry is unused
+    };
+    static constexpr size_t FETCH_CACHE_SIZE = 1024;
+    std::array<FetchCacheEntry, FETCH_CACHE_SIZE> fetch_cache;
+
+    /// Start addresses of the translated blocks overlapping each guest page
+    std::unordered_map<u32, std::vector<u32>> page_blocks;
+    /// Incremented whenever blocks are dropped, invalidating the links between blocks
+    u32 block_link_generation = 0;
+    /// Set by the interpreter when it stops because the CPU branched back into an idle loop
+    bool in_idle_loop = false;
+    /// Records the translated blocks for later boots of the title, if enabled
+    BlockDiskCache* block_disk_cache = nullptr;
+
+    /// Forgets all translated blocks, to be called whenever the translation cache is reset
+    void ClearInstructionCache();
+    /// Records a block translated from the guest code in [start_address, end_address)
+    void RegisterBlock(u32 start_address, u32 end_address);
+    /// Forgets the translated blocks overlapping the pages of the given guest memory range
+    void InvalidateInstructionCacheRange(VAddr start_address, size_t length);
+
 private:
     void ResetMPCoreCP15Registers();
 
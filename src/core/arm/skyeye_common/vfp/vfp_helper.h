@@ -427,6 +427,15 @@ inline u32 fls(u32 x) {
     return r;
 }
 
+// Operations of the host FPU fast path. With round-to-nearest, and operands and result that are
+// all normal numbers or zeroes, the host's IEEE arithmetic gives the same result as the emulation,
+// and inexact is the only exception, which the fast path detects exactly. Everything else (NaNs,
+// infinities, denormals, overflow, underflow, division by zero) is left to the emulation.
+enum class VFPHostOp { Add, Mul, Div };
+
+// Whether the host FPU fast path is used. Only turned off to test it against the emulation.
+extern bool vfp_host_arithmetic_enabled;
+
 u32 vfp_double_multiply(vfp_double* vdd, vfp_double* vdn, vfp_double* vdm, u32 fpscr);
 u32 vfp_double_add(vfp_double* vdd, vfp_double* vdn, vfp_double* vdm, u32 fpscr);
 u32 vfp_double_normaliseround(ARMul_State* state, int dd, vfp_double* vd, u32 fpscr, u32 exceptions,
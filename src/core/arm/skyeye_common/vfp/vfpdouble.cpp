@@ -52,6 +52,9 @@
  */
 
 #include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
 #include "common/logging/log.h"
 #include "core/arm/skyeye_common/vfp/asm_vfp.h"
 #include "core/arm/skyeye_common/vfp/vfp.h"
@@ -62,7 +65,7 @@ static struct vfp_double vfp_double_default_qnan = {
 };
 
 static void vfp_double_dump(const char* str, struct vfp_double* d) {
-    LOG_TRACE(Core_ARM11, "VFP: %s: sign=%d exponent=%d significand=%016llx", str, d->sign != 0,
+    LOG_TRACE(Core_ARM11, "VFP: %s: sign=%d exponent=%d significand=%016" PRIx64, str, d->sign != 0,
               d->exponent, d->significand);
 }
 
@@ -164,7 +167,7 @@ u32 vfp_double_normaliseround(ARMul_State* state, int dd, struct vfp_double* vd,
     } else if ((rmode == FPSCR_ROUND_PLUSINF) ^ (vd->sign != 0))
         incr = (1ULL << (VFP_DOUBLE_LOW_BITS + 1)) - 1;
 
-    LOG_TRACE(Core_ARM11, "VFP: rounding increment = 0x%08llx", incr);
+    LOG_TRACE(Core_ARM11, "VFP: rounding increment = 0x%08" PRIx64, incr);
 
     /*
      * Is our rounding going to overflow?
@@ -219,7 +222,8 @@ pack:
     vfp_double_dump("pack: final", vd);
     {
         s64 d = vfp_double_pack(vd);
-        LOG_TRACE(Core_ARM11, "VFP: %s: d(d%d)=%016llx exceptions=%08x", func, dd, d, exceptions);
+        LOG_TRACE(Core_ARM11, "VFP: %s: d(d%d)=%016" PRIx64 " exceptions=%08x", func, dd,
+                  static_cast<u64>(d), exceptions);
         vfp_put_double(state, d, dd);
     }
     return exceptions;
@@ -960,6 +964,64 @@ static u32 vfp_double_fnmsc(ARMul_State* state, int dd, int dn, int dm, u32 fpsc
                                           "fnmsc");
 }
 
+/*
+ * Whether a value is a zero, or a normal number of at most 2^480 and at least 2^-480 in magnitude.
+ * Results of operations on these neither overflow nor come near the denormals, and the rounding
+ * errors of products and quotients of them are representable.
+ */
+static bool vfp_double_host_safe(u64 value) {
+    const u32 exponent = (value >> 52) & 0x7ff;
+    return (exponent >= 1023 - 480 && exponent <= 1023 + 480) ||
+           (value & 0x7fffffffffffffffULL) == 0;
+}
+
+/*
+ * Computes dd = n op m on the host FPU, if that gives the same result as the emulation, see
+ * VFPHostOp. Whether rounding was needed is told by the error of the result, which is exactly
+ * computable for these operations.
+ * Returns false if the emulation has to handle the operation instead.
+ */
+static bool vfp_double_host_op(ARMul_State* state, int dd, u64 n, u64 m, VFPHostOp op,
+                               bool negate, u32 fpscr, u32* exceptions) {
+    if (!vfp_host_arithmetic_enabled || (fpscr & FPSCR_RMODE_MASK) != FPSCR_ROUND_NEAREST ||
+        !vfp_double_host_safe(n) || !vfp_double_host_safe(m))
+        return false;
+
+    double a, b;
+    std::memcpy(&a, &n, sizeof(a));
+    std::memcpy(&b, &m, sizeof(b));
+
+    double result;
+    bool inexact;
+    switch (op) {
+    case VFPHostOp::Add: {
+        result = a + b;
+        const double b_virtual = result - a;
+        const double error = (a - (result - b_virtual)) + (b - b_virtual);
+        inexact = error != 0.0;
+        break;
+    }
+    case VFPHostOp::Mul:
+        result = a * b;
+        inexact = std::fma(a, b, -result) != 0.0;
+        break;
+    case VFPHostOp::Div:
+        if (b == 0.0)
+            return false;
+        result = a / b;
+        inexact = std::fma(-result, b, a) != 0.0;
+        break;
+    }
+
+    u64 d;
+    std::memcpy(&d, &result, sizeof(d));
+    if (negate)
+        d = vfp_double_packed_negate(d);
+    vfp_put_double(state, d, dd);
+    *exceptions = inexact ? FPSCR_IXC : 0;
+    return true;
+}
+
 /*
  * sd = sn * sm
  */
@@ -967,6 +1029,10 @@ static u32 vfp_double_fmul(ARMul_State* state, int dd, int dn, int dm, u32 fpscr
     struct vfp_double vdd, vdn, vdm;
     u32 exceptions = 0;
 
+    if (vfp_double_host_op(state, dd, vfp_get_double(state, dn), vfp_get_double(state, dm),
+                           VFPHostOp::Mul, false, fpscr, &exceptions))
+        return exceptions;
+
     LOG_TRACE(Core_ARM11, "In %s", __FUNCTION__);
     exceptions |= vfp_double_unpack(&vdn, vfp_get_double(state, dn), fpscr);
     if (vdn.exponent == 0 && vdn.significand)
@@ -987,6 +1053,10 @@ static u32 vfp_double_fnmul(ARMul_State* state, int dd, int dn, int dm, u32 fpsc
     struct vfp_double vdd, vdn, vdm;
     u32 exceptions = 0;
 
+    if (vfp_double_host_op(state, dd, vfp_get_double(state, dn), vfp_get_double(state, dm),
+                           VFPHostOp::Mul, true, fpscr, &exceptions))
+        return exceptions;
+
     LOG_TRACE(Core_ARM11, "In %s", __FUNCTION__);
     exceptions |= vfp_double_unpack(&vdn, vfp_get_double(state, dn), fpscr);
     if (vdn.exponent == 0 && vdn.significand)
@@ -1009,6 +1079,10 @@ static u32 vfp_double_fadd(ARMul_State* state, int dd, int dn, int dm, u32 fpscr
     struct vfp_double vdd, vdn, vdm;
     u32 exceptions = 0;
 
+    if (vfp_double_host_op(state, dd, vfp_get_double(state, dn), vfp_get_double(state, dm),
+                           VFPHostOp::Add, false, fpscr, &exceptions))
+        return exceptions;
+
     LOG_TRACE(Core_ARM11, "In %s", __FUNCTION__);
     exceptions |= vfp_double_unpack(&vdn, vfp_get_double(state, dn), fpscr);
     if (vdn.exponent == 0 && vdn.significand)
@@ -1030,6 +1104,12 @@ static u32 vfp_double_fsub(ARMul_State* state, int dd, int dn, int dm, u32 fpscr
     struct vfp_double vdd, vdn, vdm;
     u32 exceptions = 0;
 
+    // Subtraction is like addition, but with a negated operand
+    const u64 negated_m = vfp_double_packed_negate(vfp_get_double(state, dm));
+    if (vfp_double_host_op(state, dd, vfp_get_double(state, dn), negated_m, VFPHostOp::Add, false,
+                           fpscr, &exceptions))
+        return exceptions;
+
     LOG_TRACE(Core_ARM11, "In %s", __FUNCTION__);
     exceptions |= vfp_double_unpack(&vdn, vfp_get_double(state, dn), fpscr);
     if (vdn.exponent == 0 && vdn.significand)
@@ -1057,6 +1137,10 @@ static u32 vfp_double_fdiv(ARMul_State* state, int dd, int dn, int dm, u32 fpscr
     u32 exceptions = 0;
     int tm, tn;
 
+    if (vfp_double_host_op(state, dd, vfp_get_double(state, dn), vfp_get_double(state, dm),
+                           VFPHostOp::Div, false, fpscr, &exceptions))
+        return exceptions;
+
     LOG_TRACE(Core_ARM11, "In %s", __FUNCTION__);
     exceptions |= vfp_double_unpack(&vdn, vfp_get_double(state, dn), fpscr);
     exceptions |= vfp_double_unpack(&vdm, vfp_get_double(state, dm), fpscr);
@@ -53,6 +53,7 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <cstring>
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
@@ -985,6 +986,73 @@ static u32 vfp_single_fnmsc(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr
                                           "fnmsc");
 }
 
+// Whether a value is a normal number or a zero, which the host FPU handles like the emulation
+static bool vfp_single_host_safe(u32 value) {
+    const u32 exponent = (value >> 23) & 0xff;
+    return (exponent != 0 && exponent != 0xff) || (value & 0x7fffffff) == 0;
+}
+
+/*
+ * Computes sd = n op m on the host FPU, if that gives the same result as the emulation, see
+ * VFPHostOp. Single precision operations are done in double precision and rounded once more,
+ * which is known to give the correctly rounded result for these, while the double precision
+ * result tells whether rounding was needed.
+ * Returns false if the emulation has to handle the operation instead.
+ */
+static bool vfp_single_host_op(ARMul_State* state, int sd, s32 n, s32 m, VFPHostOp op,
+                               bool negate, u32 fpscr, u32* exceptions) {
+    if (!vfp_host_arithmetic_enabled || (fpscr & FPSCR_RMODE_MASK) != FPSCR_ROUND_NEAREST ||
+        !vfp_single_host_safe(n) || !vfp_single_host_safe(m))
+        return false;
+
+    float fn, fm;
+    std::memcpy(&fn, &n, sizeof(fn));
+    std::memcpy(&fm, &m, sizeof(fm));
+    const double a = fn;
+    const double b = fm;
+
+    float result;
+    bool inexact;
+    switch (op) {
+    case VFPHostOp::Add: {
+        // The sum of two floats isn't always exact in double precision, its error is
+        const double sum = a + b;
+        const double b_virtual = sum - a;
+        const double error = (a - (sum - b_virtual)) + (b - b_virtual);
+        result = static_cast<float>(sum);
+        inexact = error != 0.0 || static_cast<double>(result) != sum;
+        break;
+    }
+    case VFPHostOp::Mul: {
+        // The product of two floats is exact in double precision
+        const double product = a * b;
+        result = static_cast<float>(product);
+        inexact = static_cast<double>(result) != product;
+        break;
+    }
+    case VFPHostOp::Div: {
+        if (fm == 0.0f)
+            return false;
+        result = static_cast<float>(a / b);
+        // The product of the result and the divisor is exact in double precision
+        inexact = static_cast<double>(result) * b != a;
+        break;
+    }
+    }
+
+    u32 d;
+    std::memcpy(&d, &result, sizeof(d));
+    // Rounded results that are zero or barely normal may have underflowed before rounding
+    if (!vfp_single_host_safe(d) || (inexact && ((d >> 23) & 0xff) <= 1))
+        return false;
+
+    if (negate)
+        d = vfp_single_packed_negate(d);
+    vfp_put_float(state, d, sd);
+    *exceptions = inexact ? FPSCR_IXC : 0;
+    return true;
+}
+
 /*
  * sd = sn * sm
  */
@@ -993,6 +1061,9 @@ static u32 vfp_single_fmul(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr)
     u32 exceptions = 0;
     s32 n = vfp_get_float(state, sn);
 
+    if (vfp_single_host_op(state, sd, n, m, VFPHostOp::Mul, false, fpscr, &exceptions))
+        return exceptions;
+
     LOG_TRACE(Core_ARM11, "s%u = %08x", sn, n);
 
     exceptions |= vfp_single_unpack(&vsn, n, fpscr);
@@ -1015,6 +1086,9 @@ static u32 vfp_single_fnmul(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr
     u32 exceptions = 0;
     s32 n = vfp_get_float(state, sn);
 
+    if (vfp_single_host_op(state, sd, n, m, VFPHostOp::Mul, true, fpscr, &exceptions))
+        return exceptions;
+
     LOG_TRACE(Core_ARM11, "s%u = %08x", sn, n);
 
     exceptions |= vfp_single_unpack(&vsn, n, fpscr);
@@ -1038,6 +1112,9 @@ static u32 vfp_single_fadd(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr)
     u32 exceptions = 0;
     s32 n = vfp_get_float(state, sn);
 
+    if (vfp_single_host_op(state, sd, n, m, VFPHostOp::Add, false, fpscr, &exceptions))
+        return exceptions;
+
     LOG_TRACE(Core_ARM11, "s%u = %08x", sn, n);
 
     /*
@@ -1087,6 +1164,10 @@ static u32 vfp_single_fdiv(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr)
     struct vfp_single vsd, vsn, vsm;
     u32 exceptions = 0;
     s32 n = vfp_get_float(state, sn);
+
+    if (vfp_single_host_op(state, sd, n, m, VFPHostOp::Div, false, fpscr, &exceptions))
+        return exceptions;
+
     int tm, tn;
 
     LOG_TRACE(Core_ARM11, "s%u = %08x", sn, n);
@@ -2,22 +2,29 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <utility>
 #include "audio_core/audio_core.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/math_util.h"
+#include "common/microprofile.h"
 #include "core/arm/arm_interface.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/arm/dyncom/arm_dyncom.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/gdbstub/gdbstub.h"
+#include "core/guest_profiler.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/service/service.h"
 #include "core/hw/hw.h"
 #include "core/loader/loader.h"
 #include "core/memory_setup.h"
+#include "core/movie.h"
 #include "core/settings.h"
 #include "video_core/video_core.h"
 
@@ -25,7 +32,7 @@ namespace Core {
 
 /*static*/ System System::s_instance;
 
-System::ResultStatus System::RunLoop(int tight_loop) {
+System::ResultStatus System::RunLoop(bool tight_loop) {
     status = ResultStatus::Success;
     if (!cpu_core) {
         return ResultStatus::ErrorNotInitialized;
@@ -39,7 +46,7 @@ System::ResultStatus System::RunLoop(int tight_loop) {
         if (GDBStub::GetCpuHaltFlag()) {
             if (GDBStub::GetCpuStepFlag()) {
                 GDBStub::SetCpuStepFlag(false);
-                tight_loop = 1;
+                tight_loop = false;
             } else {
                 return ResultStatus::Success;
             }
@@ -50,11 +57,20 @@ System::ResultStatus System::RunLoop(int tight_loop) {
     // instead advance to the next event and try to yield to the next thread
     if (Kernel::GetCurrentThread() == nullptr) {
         LOG_TRACE(Core_ARM11, "Idling");
-        CoreTiming::Idle();
+        IdleUntilNextEvent();
         CoreTiming::Advance();
         PrepareReschedule();
     } else {
-        cpu_core->Run(tight_loop);
+        ScopedPerfTimer perf_timer(PerfStats::Category::CPUEmulation);
+        if (tight_loop) {
+            // Run up to the next event, so that it fires on time without leaving the CPU more often
+            // than needed
+            const s64 slice = std::min<s64>(CoreTiming::GetDowncount(),
+                                            Settings::values.cpu_max_slice_length);
+            cpu_core->Run(static_cast<int>(std::max<s64>(slice, 1)));
+        } else {
+            cpu_core->Step();
+        }
     }
 
     HW::Update();
@@ -64,10 +80,17 @@ System::ResultStatus System::RunLoop(int tight_loop) {
 }
 
 System::ResultStatus System::SingleStep() {
-    return RunLoop(1);
+    return RunLoop(false);
 }
 
 System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& filepath) {
+    using Clock = std::chrono::steady_clock;
+    const auto MillisecondsSince = [](Clock::time_point start) {
+        return static_cast<long long>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count());
+    };
+    const Clock::time_point boot_start = Clock::now();
+
     app_loader = Loader::GetLoader(filepath);
 
     if (!app_loader) {
@@ -99,6 +122,7 @@ System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& file
         return init_result;
     }
 
+    const Clock::time_point app_load_start = Clock::now();
     const Loader::ResultStatus load_result{app_loader->Load()};
     if (Loader::ResultStatus::Success != load_result) {
         LOG_CRITICAL(Core, "Failed to load ROM (Error %i)!", load_result);
@@ -113,10 +137,39 @@ System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& file
             return ResultStatus::ErrorLoader;
         }
     }
+
+    u64 program_id = 0;
+    app_loader->ReadProgramId(program_id);
+    Movie::Init(program_id);
+
+    LOG_INFO(Core, "Booted in %lld ms, of which %lld ms loading the application",
+             MillisecondsSince(boot_start), MillisecondsSince(app_load_start));
     status = ResultStatus::Success;
     return status;
 }
 
+void System::IdleUntilNextEvent() {
+    const s64 cycles_to_event = std::max<s64>(CoreTiming::GetDowncount(), 0);
+    const std::chrono::microseconds wait_time = frame_limiter.GetWaitTimeUntil(
+        CoreTiming::GetGlobalTimeUs() + cyclesToUs(cycles_to_event));
+    if (wait_time == std::chrono::microseconds::zero()) {
+        CoreTiming::Idle();
+        return;
+    }
+
+    const auto wait_start = FrameLimiter::Clock::now();
+    if (!CoreTiming::WaitForThreadsafeEvent(wait_time)) {
+        CoreTiming::Idle();
+        return;
+    }
+
+    // Woken early, so only as much emulated time passes as walltime did
+    const auto waited = std::chrono::duration_cast<std::chrono::microseconds>(
+        FrameLimiter::Clock::now() - wait_start);
+    const s64 waited_cycles = usToCycles(static_cast<s64>(waited.count()));
+    CoreTiming::Idle(static_cast<int>(MathUtil::Clamp<s64>(waited_cycles, 1, cycles_to_event)));
+}
+
 void System::PrepareReschedule() {
     cpu_core->PrepareReschedule();
     reschedule_pending = true;
@@ -153,6 +206,7 @@ System::ResultStatus System::Init(EmuWindow* emu_window, u32 system_mode) {
     Service::Init();
     AudioCore::Init();
     GDBStub::Init();
+    GuestProfiler::Init();
 
     if (!VideoCore::Init(emu_window)) {
         return ResultStatus::ErrorVideoCore;
@@ -164,9 +218,41 @@ System::ResultStatus System::Init(EmuWindow* emu_window, u32 system_mode) {
     GetAndResetPerfStats();
     perf_stats.BeginSystemFrame();
 
+    if (Settings::values.trace_capture_frames != 0) {
+        std::string trace_path = Settings::values.trace_capture_path;
+        if (trace_path.empty())
+            trace_path = FileUtil::GetUserPath(D_USER_IDX) + "citra_trace.json";
+        Common::StartTraceCapture(trace_path, Settings::values.trace_capture_frames);
+    }
+
+    return ResultStatus::Success;
+}
+
+System::ResultStatus System::InitTraceReplay(EmuWindow* emu_window) {
+    Memory::InitMemoryMap();
+
+    telemetry_session = std::make_unique<Core::TelemetrySession>();
+
+    CoreTiming::Init();
+    HW::Init();
+
+    if (!VideoCore::Init(emu_window)) {
+        return ResultStatus::ErrorVideoCore;
+    }
+
+    GetAndResetPerfStats();
+    perf_stats.BeginSystemFrame();
+
     return ResultStatus::Success;
 }
 
+void System::ShutdownTraceReplay() {
+    VideoCore::Shutdown();
+    HW::Shutdown();
+    CoreTiming::Shutdown();
+    telemetry_session = nullptr;
+}
+
 void System::Shutdown() {
     // Log last frame performance stats
     auto perf_results = GetAndResetPerfStats();
@@ -178,6 +264,8 @@ void System::Shutdown() {
                          perf_results.frametime * 1000.0);
 
     // Shutdown emulation session
+    Movie::Shutdown();
+    GuestProfiler::Shutdown();
     GDBStub::Shutdown();
     AudioCore::Shutdown();
     VideoCore::Shutdown();
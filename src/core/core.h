@@ -45,15 +45,15 @@ public:
 
     /**
      * Run the core CPU loop
-     * This function runs the core for the specified number of CPU instructions before trying to
-     * update hardware. This is much faster than SingleStep (and should be equivalent), as the CPU
-     * is not required to do a full dispatch with each instruction. NOTE: the number of instructions
-     * requested is not guaranteed to run, as this will be interrupted preemptively if a hardware
-     * update is requested (e.g. on a thread switch).
-     * @param tight_loop Number of instructions to execute.
+     * This function runs the core until the next CoreTiming event is due, for at most the
+     * configured maximum slice length, before trying to update hardware. This is much faster than
+     * SingleStep (and should be equivalent), as the CPU is not required to do a full dispatch with
+     * each instruction. NOTE: the whole slice is not guaranteed to run, as this will be
+     * interrupted preemptively if a hardware update is requested (e.g. on a thread switch).
+     * @param tight_loop If false, the CPU only executes a single instruction.
      * @return Result status, indicating whethor or not the operation succeeded.
      */
-    ResultStatus RunLoop(int tight_loop = 1000);
+    ResultStatus RunLoop(bool tight_loop = true);
 
     /**
      * Step the CPU one instruction
@@ -64,6 +64,17 @@ public:
     /// Shutdown the emulated system.
     void Shutdown();
 
+    /**
+     * Initializes only the hardware registers and the video core, which is all that replaying
+     * the GPU commands of a CiTrace recording needs. There is no CPU, kernel or application.
+     * @param emu_window Pointer to the host-system window used for video output.
+     * @returns ResultStatus code, indicating if the operation succeeded.
+     */
+    ResultStatus InitTraceReplay(EmuWindow* emu_window);
+
+    /// Shuts down what InitTraceReplay initialized.
+    void ShutdownTraceReplay();
+
     /**
      * Load an executable application.
      * @param emu_window Pointer to the host-system window used for video output and keyboard input.
@@ -92,6 +103,11 @@ public:
     /// Prepare the core emulation for a reschedule
     void PrepareReschedule();
 
+    /// Whether a reschedule was prepared since the last one
+    bool IsReschedulePending() const {
+        return reschedule_pending;
+    }
+
     PerfStats::Results GetAndResetPerfStats();
 
     /**
@@ -120,6 +136,11 @@ public:
         return *app_loader;
     }
 
+    /// Whether an application is loaded, which isn't the case when replaying traces
+    bool IsAppLoaded() const {
+        return app_loader != nullptr;
+    }
+
 private:
     /**
      * Initialize the emulated system.
@@ -132,6 +153,14 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /**
+     * Lets emulated time pass up to the next event while no guest thread can run. While the frame
+     * limiter holds emulation to the wall clock, the host thread sleeps until the event is due,
+     * rather than running ahead and waiting at the end of the frame, and events scheduled from
+     * other threads in the meantime are handled as soon as they arrive.
+     */
+    void IdleUntilNextEvent();
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
@@ -2,15 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <atomic>
 #include <cinttypes>
+#include <condition_variable>
 #include <mutex>
+#include <tuple>
 #include <vector>
-#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
-#include "core/arm/arm_interface.h"
-#include "core/core.h"
 #include "core/core_timing.h"
 
 int g_clock_rate_arm11 = BASE_CLOCK_RATE_ARM11;
@@ -31,34 +31,50 @@ struct EventType {
 
 static std::vector<EventType> event_types;
 
-struct BaseEvent {
+struct Event {
     s64 time;
+    /// Breaks ties between events scheduled for the same time, which fire in scheduling order
+    u64 fifo_order;
     u64 userdata;
     int type;
+    /// Incremented each time the slot is freed, so that handles to earlier events go stale
+    u32 generation;
+    /// Position of the event in event_queue
+    u32 queue_index;
 };
 
-typedef LinkedListItem<BaseEvent> Event;
+/// Storage for scheduled events, indexed by EventHandle::slot
+static std::vector<Event> event_slots;
+static std::vector<u32> free_slots;
+/// Binary min-heap of the slots of all scheduled events, ordered by time and then fifo_order
+static std::vector<u32> event_queue;
+static u64 event_fifo_id;
 
-static Event* first;
-static Event* ts_first;
-static Event* ts_last;
+/// Event scheduled from another thread, waiting to be moved into event_queue
+struct ThreadsafeEvent {
+    s64 time;
+    u64 userdata;
+    int type;
+    ThreadsafeEvent* next;
+};
+
+/// Lock-free stack of thread-safe events, newest first, emptied as a whole by MoveEvents
+static std::atomic<ThreadsafeEvent*> ts_events{nullptr};
 
-// event pools
-static Event* event_pool = nullptr;
-static Event* event_ts_pool = nullptr;
-static int allocated_ts_events = 0;
-// Optimization to skip MoveEvents when possible.
-static std::atomic<bool> has_ts_events(false);
+/// Wakes the emulation thread from WaitForThreadsafeEvent. Threads scheduling events only take the
+/// mutex while it is waiting.
+static std::mutex ts_wait_mutex;
+static std::condition_variable ts_wait_cv;
+static std::atomic<bool> ts_waiting{false};
 
 int g_slice_length;
 
+static s64 downcount;
 static s64 global_timer;
 static s64 idled_cycles;
 static s64 last_global_time_ticks;
 static s64 last_global_time_us;
 
-static std::recursive_mutex external_event_section;
-
 // Warning: not included in save state.
 using AdvanceCallback = void(int cycles_executed);
 static AdvanceCallback* advance_callback = nullptr;
@@ -92,35 +108,110 @@ u64 GetGlobalTimeUs() {
     return last_global_time_us + us_since_last;
 }
 
-static Event* GetNewEvent() {
-    if (!event_pool)
-        return new Event;
-
-    Event* event = event_pool;
-    event_pool = event->next;
-    return event;
+static bool EventBefore(u32 left_slot, u32 right_slot) {
+    const Event& left = event_slots[left_slot];
+    const Event& right = event_slots[right_slot];
+    return std::tie(left.time, left.fifo_order) < std::tie(right.time, right.fifo_order);
 }
 
-static Event* GetNewTsEvent() {
-    allocated_ts_events++;
+static void PlaceInQueue(u32 index, u32 slot) {
+    event_queue[index] = slot;
+    event_slots[slot].queue_index = index;
+}
 
-    if (!event_ts_pool)
-        return new Event;
+static void SiftUp(u32 index) {
+    const u32 slot = event_queue[index];
+    while (index > 0) {
+        const u32 parent = (index - 1) / 2;
+        if (!EventBefore(slot, event_queue[parent]))
+            break;
+        PlaceInQueue(index, event_queue[parent]);
+        index = parent;
+    }
+    PlaceInQueue(index, slot);
+}
 
-    Event* event = event_ts_pool;
-    event_ts_pool = event->next;
-    return event;
+static void SiftDown(u32 index) {
+    const u32 slot = event_queue[index];
+    const u32 size = static_cast<u32>(event_queue.size());
+    while (true) {
+        u32 child = 2 * index + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && EventBefore(event_queue[child + 1], event_queue[child]))
+            ++child;
+        if (!EventBefore(event_queue[child], slot))
+            break;
+        PlaceInQueue(index, event_queue[child]);
+        index = child;
+    }
+    PlaceInQueue(index, slot);
 }
 
-static void FreeEvent(Event* event) {
-    event->next = event_pool;
-    event_pool = event;
+static EventHandle AddEventToQueue(s64 time, int event_type, u64 userdata) {
+    u32 slot;
+    if (free_slots.empty()) {
+        slot = static_cast<u32>(event_slots.size());
+        event_slots.push_back({});
+        event_slots[slot].generation = 1;
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+
+    Event& event = event_slots[slot];
+    event.time = time;
+    event.fifo_order = event_fifo_id++;
+    event.userdata = userdata;
+    event.type = event_type;
+
+    event_queue.push_back(slot);
+    SiftUp(static_cast<u32>(event_queue.size() - 1));
+    return {slot, event.generation};
+}
+
+/// Removes the event at the given position of event_queue and frees its slot
+static void RemoveEventAt(u32 index) {
+    const u32 slot = event_queue[index];
+    const u32 last = event_queue.back();
+    event_queue.pop_back();
+    if (index < event_queue.size()) {
+        PlaceInQueue(index, last);
+        if (index > 0 && EventBefore(last, event_queue[(index - 1) / 2]))
+            SiftUp(index);
+        else
+            SiftDown(index);
+    }
+
+    Event& event = event_slots[slot];
+    if (++event.generation == 0)
+        event.generation = 1;
+    free_slots.push_back(slot);
+}
+
+/// Removes all events matching the predicate, returning the time until the last one removed
+template <typename Predicate>
+static s64 RemoveEventsIf(Predicate pred) {
+    // Removing an event moves another one into its place, possibly above positions already
+    // checked, so the matching events are collected before any is removed
+    static std::vector<u32> matching_slots;
+    matching_slots.clear();
+    for (u32 slot : event_queue) {
+        if (pred(event_slots[slot]))
+            matching_slots.push_back(slot);
+    }
+
+    s64 result = 0;
+    for (u32 slot : matching_slots) {
+        const Event& event = event_slots[slot];
+        result = event.time - GetTicks();
+        RemoveEventAt(event.queue_index);
+    }
+    return result;
 }
 
-static void FreeTsEvent(Event* event) {
-    event->next = event_ts_pool;
-    event_ts_pool = event;
-    allocated_ts_events--;
+static const Event* GetFirstEvent() {
+    return event_queue.empty() ? nullptr : &event_slots[event_queue[0]];
 }
 
 int RegisterEvent(const char* name, TimedCallback callback) {
@@ -140,28 +231,24 @@ void RestoreRegisterEvent(int event_type, const char* name, TimedCallback callba
 }
 
 void UnregisterAllEvents() {
-    if (first)
+    if (!event_queue.empty())
         LOG_ERROR(Core_Timing, "Cannot unregister events with events pending");
     event_types.clear();
 }
 
 void Init() {
-    Core::CPU().down_count = INITIAL_SLICE_LENGTH;
+    downcount = INITIAL_SLICE_LENGTH;
     g_slice_length = INITIAL_SLICE_LENGTH;
     global_timer = 0;
     idled_cycles = 0;
     last_global_time_ticks = 0;
     last_global_time_us = 0;
-    has_ts_events = 0;
     mhz_change_callbacks.clear();
 
-    first = nullptr;
-    ts_first = nullptr;
-    ts_last = nullptr;
-
-    event_pool = nullptr;
-    event_ts_pool = nullptr;
-    allocated_ts_events = 0;
+    event_slots.clear();
+    free_slots.clear();
+    event_queue.clear();
+    event_fifo_id = 0;
 
     advance_callback = nullptr;
 }
@@ -170,167 +257,88 @@ void Shutdown() {
     MoveEvents();
     ClearPendingEvents();
     UnregisterAllEvents();
-
-    while (event_pool) {
-        Event* event = event_pool;
-        event_pool = event->next;
-        delete event;
-    }
-
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    while (event_ts_pool) {
-        Event* event = event_ts_pool;
-        event_ts_pool = event->next;
-        delete event;
-    }
 }
 
 u64 GetTicks() {
-    return (u64)global_timer + g_slice_length - Core::CPU().down_count;
+    return (u64)global_timer + g_slice_length - downcount;
 }
 
 u64 GetIdleTicks() {
     return (u64)idled_cycles;
 }
 
+void AddTicks(u64 ticks) {
+    downcount -= ticks;
+    if (downcount < 0)
+        Advance();
+}
+
+s64 GetDowncount() {
+    return downcount;
+}
+
 // This is to be called when outside threads, such as the graphics thread, wants to
 // schedule things to be executed on the main thread.
 void ScheduleEvent_Threadsafe(s64 cycles_into_future, int event_type, u64 userdata) {
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    Event* new_event = GetNewTsEvent();
+    ThreadsafeEvent* new_event = new ThreadsafeEvent;
     new_event->time = GetTicks() + cycles_into_future;
     new_event->type = event_type;
-    new_event->next = nullptr;
     new_event->userdata = userdata;
-    if (!ts_first)
-        ts_first = new_event;
-    if (ts_last)
-        ts_last->next = new_event;
-    ts_last = new_event;
+    new_event->next = ts_events.load(std::memory_order_relaxed);
+    // Sequentially consistent, so that either this thread sees the emulation thread waiting or
+    // the emulation thread sees the event before it starts to wait
+    while (!ts_events.compare_exchange_weak(new_event->next, new_event, std::memory_order_seq_cst,
+                                            std::memory_order_relaxed)) {
+    }
 
-    has_ts_events = true;
+    if (ts_waiting.load()) {
+        std::lock_guard<std::mutex> lock(ts_wait_mutex);
+        ts_wait_cv.notify_one();
+    }
 }
 
-// Same as ScheduleEvent_Threadsafe(0, ...) EXCEPT if we are already on the CPU thread
-// in which case the event will get handled immediately, before returning.
 void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata) {
-    if (false) // Core::IsCPUThread())
-    {
-        std::lock_guard<std::recursive_mutex> lock(external_event_section);
-        event_types[event_type].callback(userdata, 0);
-    } else
-        ScheduleEvent_Threadsafe(0, event_type, userdata);
+    ScheduleEvent_Threadsafe(0, event_type, userdata);
 }
 
 void ClearPendingEvents() {
-    while (first) {
-        Event* event = first->next;
-        FreeEvent(first);
-        first = event;
+    while (!event_queue.empty())
+        RemoveEventAt(static_cast<u32>(event_queue.size() - 1));
+}
+
+EventHandle ScheduleEvent(s64 cycles_into_future, int event_type, u64 userdata) {
+    // End the current slice early if the event is due before it, so that it isn't run late. Both
+    // counters are shortened by the same amount, which leaves GetTicks unchanged.
+    const s64 cycles_until_event = std::max<s64>(cycles_into_future, 0);
+    if (cycles_until_event < downcount) {
+        const s64 shortening = downcount - cycles_until_event;
+        g_slice_length -= static_cast<int>(shortening);
+        downcount -= shortening;
     }
+    return AddEventToQueue(GetTicks() + cycles_into_future, event_type, userdata);
 }
 
-static void AddEventToQueue(Event* new_event) {
-    Event* prev_event = nullptr;
-    Event** next_event = &first;
-    for (;;) {
-        Event*& next = *next_event;
-        if (!next || new_event->time < next->time) {
-            new_event->next = next;
-            next = new_event;
-            break;
-        }
-        prev_event = next;
-        next_event = &prev_event->next;
-    }
+s64 UnscheduleEvent(int event_type, u64 userdata) {
+    return RemoveEventsIf([event_type, userdata](const Event& event) {
+        return event.type == event_type && event.userdata == userdata;
+    });
 }
 
-void ScheduleEvent(s64 cycles_into_future, int event_type, u64 userdata) {
-    Event* new_event = GetNewEvent();
-    new_event->userdata = userdata;
-    new_event->type = event_type;
-    new_event->time = GetTicks() + cycles_into_future;
-    AddEventToQueue(new_event);
-}
-
-s64 UnscheduleEvent(int event_type, u64 userdata) {
-    s64 result = 0;
-    if (!first)
-        return result;
-    while (first) {
-        if (first->type == event_type && first->userdata == userdata) {
-            result = first->time - GetTicks();
-
-            Event* next = first->next;
-            FreeEvent(first);
-            first = next;
-        } else {
-            break;
-        }
-    }
-    if (!first)
-        return result;
-
-    Event* prev_event = first;
-    Event* ptr = prev_event->next;
-
-    while (ptr) {
-        if (ptr->type == event_type && ptr->userdata == userdata) {
-            result = ptr->time - GetTicks();
-
-            prev_event->next = ptr->next;
-            FreeEvent(ptr);
-            ptr = prev_event->next;
-        } else {
-            prev_event = ptr;
-            ptr = ptr->next;
-        }
-    }
+s64 UnscheduleEvent(EventHandle handle) {
+    if (handle.slot >= event_slots.size())
+        return 0;
+    const Event& event = event_slots[handle.slot];
+    if (event.generation != handle.generation)
+        return 0;
 
+    const s64 result = event.time - GetTicks();
+    RemoveEventAt(event.queue_index);
     return result;
 }
 
 s64 UnscheduleThreadsafeEvent(int event_type, u64 userdata) {
-    s64 result = 0;
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    if (!ts_first)
-        return result;
-
-    while (ts_first) {
-        if (ts_first->type == event_type && ts_first->userdata == userdata) {
-            result = ts_first->time - GetTicks();
-
-            Event* next = ts_first->next;
-            FreeTsEvent(ts_first);
-            ts_first = next;
-        } else {
-            break;
-        }
-    }
-
-    if (!ts_first) {
-        ts_last = nullptr;
-        return result;
-    }
-
-    Event* prev_event = ts_first;
-    Event* next = prev_event->next;
-    while (next) {
-        if (next->type == event_type && next->userdata == userdata) {
-            result = next->time - GetTicks();
-
-            prev_event->next = next->next;
-            if (next == ts_last)
-                ts_last = prev_event;
-            FreeTsEvent(next);
-            next = prev_event->next;
-        } else {
-            prev_event = next;
-            next = next->next;
-        }
-    }
-
-    return result;
+    MoveEvents();
+    return UnscheduleEvent(event_type, userdata);
 }
 
 // Warning: not included in save state.
@@ -343,144 +351,80 @@ void RegisterMHzChangeCallback(MHzChangeCallback callback) {
 }
 
 bool IsScheduled(int event_type) {
-    if (!first)
-        return false;
-    Event* event = first;
-    while (event) {
-        if (event->type == event_type)
-            return true;
-        event = event->next;
-    }
-    return false;
+    return std::any_of(event_queue.begin(), event_queue.end(), [event_type](u32 slot) {
+        return event_slots[slot].type == event_type;
+    });
 }
 
 void RemoveEvent(int event_type) {
-    if (!first)
-        return;
-    while (first) {
-        if (first->type == event_type) {
-            Event* next = first->next;
-            FreeEvent(first);
-            first = next;
-        } else {
-            break;
-        }
-    }
-    if (!first)
-        return;
-    Event* prev = first;
-    Event* next = prev->next;
-    while (next) {
-        if (next->type == event_type) {
-            prev->next = next->next;
-            FreeEvent(next);
-            next = prev->next;
-        } else {
-            prev = next;
-            next = next->next;
-        }
-    }
+    RemoveEventsIf([event_type](const Event& event) { return event.type == event_type; });
 }
 
 void RemoveThreadsafeEvent(int event_type) {
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    if (!ts_first)
-        return;
-
-    while (ts_first) {
-        if (ts_first->type == event_type) {
-            Event* next = ts_first->next;
-            FreeTsEvent(ts_first);
-            ts_first = next;
-        } else {
-            break;
-        }
-    }
-
-    if (!ts_first) {
-        ts_last = nullptr;
-        return;
-    }
-
-    Event* prev = ts_first;
-    Event* next = prev->next;
-    while (next) {
-        if (next->type == event_type) {
-            prev->next = next->next;
-            if (next == ts_last)
-                ts_last = prev;
-            FreeTsEvent(next);
-            next = prev->next;
-        } else {
-            prev = next;
-            next = next->next;
-        }
-    }
+    MoveEvents();
+    RemoveEvent(event_type);
 }
 
 void RemoveAllEvents(int event_type) {
     RemoveThreadsafeEvent(event_type);
-    RemoveEvent(event_type);
 }
 
 // This raise only the events required while the fifo is processing data
 void ProcessFifoWaitEvents() {
-    while (first) {
-        if (first->time <= (s64)GetTicks()) {
-            Event* evt = first;
-            first = first->next;
-            event_types[evt->type].callback(evt->userdata, (int)(GetTicks() - evt->time));
-            FreeEvent(evt);
-        } else {
+    while (const Event* first = GetFirstEvent()) {
+        if (first->time > (s64)GetTicks())
             break;
-        }
+
+        // The callback may schedule events, so the event is out of the queue before it runs
+        const Event event = *first;
+        RemoveEventAt(0);
+        event_types[event.type].callback(event.userdata, (int)(GetTicks() - event.time));
     }
 }
 
 void MoveEvents() {
-    has_ts_events = false;
-
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    // Move events from async queue into main queue
-    while (ts_first) {
-        Event* next = ts_first->next;
-        AddEventToQueue(ts_first);
-        ts_first = next;
+    ThreadsafeEvent* event = ts_events.exchange(nullptr, std::memory_order_acquire);
+
+    // Reverse the stack so that events keep the order they were scheduled in
+    ThreadsafeEvent* oldest = nullptr;
+    while (event) {
+        ThreadsafeEvent* next = event->next;
+        event->next = oldest;
+        oldest = event;
+        event = next;
     }
-    ts_last = nullptr;
-
-    // Move free events to threadsafe pool
-    while (allocated_ts_events > 0 && event_pool) {
-        Event* event = event_pool;
-        event_pool = event->next;
-        event->next = event_ts_pool;
-        event_ts_pool = event;
-        allocated_ts_events--;
+
+    while (oldest) {
+        AddEventToQueue(oldest->time, oldest->type, oldest->userdata);
+        ThreadsafeEvent* next = oldest->next;
+        delete oldest;
+        oldest = next;
     }
 }
 
 void ForceCheck() {
-    s64 cycles_executed = g_slice_length - Core::CPU().down_count;
+    s64 cycles_executed = g_slice_length - downcount;
     global_timer += cycles_executed;
     // This will cause us to check for new events immediately.
-    Core::CPU().down_count = 0;
+    downcount = 0;
     // But let's not eat a bunch more time in Advance() because of this.
     g_slice_length = 0;
 }
 
 void Advance() {
-    s64 cycles_executed = g_slice_length - Core::CPU().down_count;
+    s64 cycles_executed = g_slice_length - downcount;
     global_timer += cycles_executed;
-    Core::CPU().down_count = g_slice_length;
+    downcount = g_slice_length;
 
-    if (has_ts_events)
+    if (ts_events.load(std::memory_order_relaxed) != nullptr)
         MoveEvents();
     ProcessFifoWaitEvents();
 
+    const Event* first = GetFirstEvent();
     if (!first) {
         if (g_slice_length < 10000) {
             g_slice_length += 10000;
-            Core::CPU().down_count += g_slice_length;
+            downcount += g_slice_length;
         }
     } else {
         // Note that events can eat cycles as well.
@@ -490,28 +434,28 @@ void Advance() {
 
         const int diff = target - g_slice_length;
         g_slice_length += diff;
-        Core::CPU().down_count += diff;
+        downcount += diff;
     }
     if (advance_callback)
         advance_callback(static_cast<int>(cycles_executed));
 }
 
 void LogPendingEvents() {
-    Event* event = first;
-    while (event) {
-        // LOG_TRACE(Core_Timing, "PENDING: Now: %lld Pending: %lld Type: %d", globalTimer,
-        // next->time, next->type);
-        event = event->next;
+    for (size_t i = 0; i < event_queue.size(); ++i) {
+        LOG_TRACE(Core_Timing, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d",
+                  global_timer, event_slots[event_queue[i]].time,
+                  event_slots[event_queue[i]].type);
     }
 }
 
 void Idle(int max_idle) {
-    s64 cycles_down = Core::CPU().down_count;
+    s64 cycles_down = downcount;
     if (max_idle != 0 && cycles_down > max_idle)
         cycles_down = max_idle;
 
+    const Event* first = GetFirstEvent();
     if (first && cycles_down > 0) {
-        s64 cycles_executed = g_slice_length - Core::CPU().down_count;
+        s64 cycles_executed = g_slice_length - downcount;
         s64 cycles_next_event = first->time - global_timer;
 
         if (cycles_next_event < cycles_executed + cycles_down) {
@@ -526,25 +470,36 @@ void Idle(int max_idle) {
               cycles_down / (float)(g_clock_rate_arm11 * 0.001f));
 
     idled_cycles += cycles_down;
-    Core::CPU().down_count -= cycles_down;
-    if (Core::CPU().down_count == 0)
-        Core::CPU().down_count = -1;
+    downcount -= cycles_down;
+    if (downcount == 0)
+        downcount = -1;
+}
+
+bool WaitForThreadsafeEvent(std::chrono::microseconds timeout) {
+    std::unique_lock<std::mutex> lock(ts_wait_mutex);
+    ts_waiting.store(true);
+    const bool woken =
+        ts_wait_cv.wait_for(lock, timeout, [] { return ts_events.load() != nullptr; });
+    ts_waiting.store(false);
+    return woken;
 }
 
 std::string GetScheduledEventsSummary() {
-    Event* event = first;
+    std::vector<u32> slots = event_queue;
+    std::sort(slots.begin(), slots.end(), EventBefore);
+
     std::string text = "Scheduled events\n";
     text.reserve(1000);
-    while (event) {
-        unsigned int t = event->type;
+    for (u32 slot : slots) {
+        const Event& event = event_slots[slot];
+        unsigned int t = event.type;
         if (t >= event_types.size())
             LOG_ERROR(Core_Timing, "Invalid event type"); // %i", t);
-        const char* name = event_types[event->type].name;
+        const char* name = event_types[event.type].name;
         if (!name)
             name = "[unknown]";
-        text += Common::StringFromFormat("%s : %i %08x%08x\n", name, (int)event->time,
-                                         (u32)(event->userdata >> 32), (u32)(event->userdata));
-        event = event->next;
+        text += Common::StringFromFormat("%s : %i %08x%08x\n", name, (int)event.time,
+                                         (u32)(event.userdata >> 32), (u32)(event.userdata));
     }
     return text;
 }
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <string>
 #include "common/common_types.h"
@@ -71,6 +72,21 @@ u64 GetTicks();
 u64 GetIdleTicks();
 u64 GetGlobalTimeUs();
 
+/**
+ * Accounts for cycles run by the CPU, running any events that became due
+ * @param ticks Number of cycles executed since the last call
+ */
+void AddTicks(u64 ticks);
+/// Returns the number of cycles the CPU can run before the next call to Advance
+s64 GetDowncount();
+
+/// Identifies one scheduled event, so that it can be unscheduled without searching for it
+struct EventHandle {
+    u32 slot = 0;
+    /// Generation of the slot when the event was scheduled, never 0 for a valid handle
+    u32 generation = 0;
+};
+
 /**
  * Registers an event type with the specified name and callback
  * @param name Name of the event type
@@ -91,8 +107,9 @@ void UnregisterAllEvents();
  * @param cycles_into_future The number of cycles after which this event will be fired
  * @param event_type The event type to fire, as returned from RegisterEvent
  * @param userdata Optional parameter to pass to the callback when fired
+ * @returns A handle to the scheduled event, which goes stale once the event fires or is removed
  */
-void ScheduleEvent(s64 cycles_into_future, int event_type, u64 userdata = 0);
+EventHandle ScheduleEvent(s64 cycles_into_future, int event_type, u64 userdata = 0);
 
 void ScheduleEvent_Threadsafe(s64 cycles_into_future, int event_type, u64 userdata = 0);
 void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata = 0);
@@ -105,6 +122,13 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata = 0);
  */
 s64 UnscheduleEvent(int event_type, u64 userdata);
 
+/**
+ * Unschedules the event a handle refers to. Does nothing if the handle is stale.
+ * @param handle Handle returned when the event was scheduled
+ * @returns The remaining ticks until the event would have fired, or 0 if it wasn't scheduled
+ */
+s64 UnscheduleEvent(EventHandle handle);
+
 s64 UnscheduleThreadsafeEvent(int event_type, u64 userdata);
 
 void RemoveEvent(int event_type);
@@ -120,6 +144,13 @@ void ForceCheck();
 /// Pretend that the main CPU has executed enough cycles to reach the next event.
 void Idle(int maxIdle = 0);
 
+/**
+ * Blocks the calling thread for up to `timeout`, returning early when another thread schedules an
+ * event. Meant for the emulation thread while no guest thread can run.
+ * @returns Whether an event was scheduled from another thread
+ */
+bool WaitForThreadsafeEvent(std::chrono::microseconds timeout);
+
 /// Clear all pending events. This should ONLY be done on exit or state load.
 void ClearPendingEvents();
 
@@ -12,6 +12,7 @@
 #include "core/file_sys/archive_extsavedata.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/path_parser.h"
 #include "core/file_sys/savedata_archive.h"
 #include "core/hle/service/fs/archive.h"
@@ -92,7 +93,7 @@ public:
 
         const auto full_path = path_parser.BuildHostPath(mount_point);
 
-        switch (path_parser.GetHostStatus(mount_point)) {
+        switch (metadata_cache->GetHostStatus(path_parser)) {
         case PathParser::InvalidMountPoint:
             LOG_CRITICAL(Service_FS, "(unreachable) Invalid mount point %s", mount_point.c_str());
             return ERROR_FILE_NOT_FOUND;
@@ -217,6 +218,7 @@ ResultCode ArchiveFactory_ExtSaveData::Format(const Path& path,
     }
 
     file.WriteBytes(&format_info, sizeof(format_info));
+    HostMetadataCache::InvalidateDirectory(GetExtSaveDataPath(mount_point, path));
     return RESULT_SUCCESS;
 }
 
@@ -38,7 +38,7 @@ ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveFactory_NCCH::Open(const Path&
     u32 high = data[1];
     u32 low = data[0];
     std::string file_path = GetNCCHPath(mount_point, high, low);
-    auto file = std::make_shared<FileUtil::IOFile>(file_path, "rb");
+    auto file = std::make_shared<FileUtil::MappedFile>(file_path);
 
     if (!file->IsOpen()) {
         // High Title ID of the archive: The category (https://3dbrew.org/wiki/Title_list).
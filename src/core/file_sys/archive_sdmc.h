@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -17,7 +18,8 @@ namespace FileSys {
 /// Archive backend for SDMC archive
 class SDMCArchive : public ArchiveBackend {
 public:
-    explicit SDMCArchive(const std::string& mount_point_) : mount_point(mount_point_) {}
+    explicit SDMCArchive(const std::string& mount_point_)
+        : mount_point(mount_point_), metadata_cache(HostMetadataCache::Get(mount_point)) {}
 
     std::string GetName() const override {
         return "SDMCArchive: " + mount_point;
@@ -38,6 +40,7 @@ public:
 protected:
     ResultVal<std::unique_ptr<FileBackend>> OpenFileBase(const Path& path, const Mode& mode) const;
     std::string mount_point;
+    std::shared_ptr<HostMetadataCache> metadata_cache;
 };
 
 /// File system interface to the SDMC archive
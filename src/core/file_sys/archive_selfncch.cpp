@@ -181,9 +181,9 @@ private:
 
     ResultVal<std::unique_ptr<FileBackend>> OpenExeFS(const std::string& filename) const {
         if (filename == "icon") {
-            if (ncch_data.icon) {
+            if (auto icon = ncch_data.icon->Get()) {
                 return MakeResult<std::unique_ptr<FileBackend>>(
-                    std::make_unique<ExeFSSectionFile>(ncch_data.icon));
+                    std::make_unique<ExeFSSectionFile>(std::move(icon)));
             }
 
             LOG_WARNING(Service_FS, "Unable to read icon");
@@ -191,9 +191,9 @@ private:
         }
 
         if (filename == "logo") {
-            if (ncch_data.logo) {
+            if (auto logo = ncch_data.logo->Get()) {
                 return MakeResult<std::unique_ptr<FileBackend>>(
-                    std::make_unique<ExeFSSectionFile>(ncch_data.logo));
+                    std::make_unique<ExeFSSectionFile>(std::move(logo)));
             }
 
             LOG_WARNING(Service_FS, "Unable to read logo");
@@ -201,9 +201,9 @@ private:
         }
 
         if (filename == "banner") {
-            if (ncch_data.banner) {
+            if (auto banner = ncch_data.banner->Get()) {
                 return MakeResult<std::unique_ptr<FileBackend>>(
-                    std::make_unique<ExeFSSectionFile>(ncch_data.banner));
+                    std::make_unique<ExeFSSectionFile>(std::move(banner)));
             }
 
             LOG_WARNING(Service_FS, "Unable to read banner");
@@ -218,25 +218,21 @@ private:
 };
 
 ArchiveFactory_SelfNCCH::ArchiveFactory_SelfNCCH(Loader::AppLoader& app_loader) {
-    std::shared_ptr<FileUtil::IOFile> romfs_file_;
+    std::shared_ptr<FileUtil::MappedFile> romfs_file_;
     if (Loader::ResultStatus::Success ==
         app_loader.ReadRomFS(romfs_file_, ncch_data.romfs_offset, ncch_data.romfs_size)) {
 
         ncch_data.romfs_file = std::move(romfs_file_);
     }
 
-    std::vector<u8> buffer;
-
-    if (Loader::ResultStatus::Success == app_loader.ReadIcon(buffer))
-        ncch_data.icon = std::make_shared<std::vector<u8>>(std::move(buffer));
-
-    buffer.clear();
-    if (Loader::ResultStatus::Success == app_loader.ReadLogo(buffer))
-        ncch_data.logo = std::make_shared<std::vector<u8>>(std::move(buffer));
-
-    buffer.clear();
-    if (Loader::ResultStatus::Success == app_loader.ReadBanner(buffer))
-        ncch_data.banner = std::make_shared<std::vector<u8>>(std::move(buffer));
+    // The sections are only read if the application opens them, as the banner is large and
+    // rarely used. The loader outlives the services, so it can be referenced until then.
+    ncch_data.icon = std::make_shared<LazyExeFSSection>(
+        [&app_loader](std::vector<u8>& buffer) { return app_loader.ReadIcon(buffer); });
+    ncch_data.logo = std::make_shared<LazyExeFSSection>(
+        [&app_loader](std::vector<u8>& buffer) { return app_loader.ReadLogo(buffer); });
+    ncch_data.banner = std::make_shared<LazyExeFSSection>(
+        [&app_loader](std::vector<u8>& buffer) { return app_loader.ReadBanner(buffer); });
 }
 
 ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveFactory_SelfNCCH::Open(const Path& path) {
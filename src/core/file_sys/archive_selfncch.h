@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -17,11 +18,34 @@
 
 namespace FileSys {
 
+/// An ExeFS section, read from the application the first time it is asked for
+class LazyExeFSSection {
+public:
+    using ReadFunction = std::function<Loader::ResultStatus(std::vector<u8>&)>;
+
+    explicit LazyExeFSSection(ReadFunction read) : read(std::move(read)) {}
+
+    /// Returns the data of the section, or nullptr if the application doesn't have it
+    std::shared_ptr<std::vector<u8>> Get() {
+        if (read) {
+            std::vector<u8> buffer;
+            if (read(buffer) == Loader::ResultStatus::Success)
+                data = std::make_shared<std::vector<u8>>(std::move(buffer));
+            read = nullptr;
+        }
+        return data;
+    }
+
+private:
+    ReadFunction read;
+    std::shared_ptr<std::vector<u8>> data;
+};
+
 struct NCCHData {
-    std::shared_ptr<std::vector<u8>> icon;
-    std::shared_ptr<std::vector<u8>> logo;
-    std::shared_ptr<std::vector<u8>> banner;
-    std::shared_ptr<FileUtil::IOFile> romfs_file;
+    std::shared_ptr<LazyExeFSSection> icon;
+    std::shared_ptr<LazyExeFSSection> logo;
+    std::shared_ptr<LazyExeFSSection> banner;
+    std::shared_ptr<FileUtil::MappedFile> romfs_file;
     u64 romfs_offset = 0;
     u64 romfs_size = 0;
 };
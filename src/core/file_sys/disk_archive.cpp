@@ -3,7 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cinttypes>
 #include <cstdio>
+#include <iterator>
 #include <memory>
 #include "common/common_types.h"
 #include "common/file_util.h"
@@ -16,12 +18,94 @@
 
 namespace FileSys {
 
+/// Buffered writes are written back once they reach this size
+constexpr size_t MAX_DIRTY_BYTES = 1024 * 1024;
+/// Buffered writes are written back on the first write after they have waited this long
+constexpr std::chrono::seconds MAX_DIRTY_AGE{1};
+
+DiskFile::~DiskFile() {
+    WriteBack();
+}
+
+void DiskFile::BufferWrite(u64 offset, size_t length, const u8* buffer) const {
+    u64 start = offset;
+    u64 end = offset + length;
+
+    // Find the first extent ending at or after the start of the write
+    auto it = dirty_extents.upper_bound(start);
+    if (it != dirty_extents.begin()) {
+        auto previous = std::prev(it);
+        if (previous->first + previous->second.size() >= start)
+            it = previous;
+    }
+
+    // Gather the extents the write overlaps or touches into a single one
+    auto first_merged = it;
+    for (; it != dirty_extents.end() && it->first <= end; ++it) {
+        start = std::min(start, it->first);
+        end = std::max(end, it->first + it->second.size());
+    }
+    if (first_merged == it) {
+        dirty_extents.emplace(offset, std::vector<u8>(buffer, buffer + length));
+    } else {
+        std::vector<u8> merged(end - start);
+        for (auto extent = first_merged; extent != it; ++extent) {
+            std::copy(extent->second.begin(), extent->second.end(),
+                      merged.begin() + (extent->first - start));
+            dirty_bytes -= extent->second.size();
+        }
+        std::copy(buffer, buffer + length, merged.begin() + (offset - start));
+        dirty_extents.erase(first_merged, it);
+        dirty_extents.emplace(start, std::move(merged));
+    }
+    dirty_bytes += end - start;
+}
+
+void DiskFile::WriteBack() const {
+    std::lock_guard<std::mutex> lock(write_buffer_mutex);
+    for (const auto& extent : dirty_extents) {
+        if (file->WriteAt(extent.first, extent.second.data(), extent.second.size()) !=
+            extent.second.size()) {
+            LOG_ERROR(Service_FS, "Failed to write back 0x%zX bytes at offset 0x%llX",
+                      extent.second.size(), extent.first);
+        }
+    }
+    dirty_extents.clear();
+    dirty_bytes = 0;
+}
+
 ResultVal<size_t> DiskFile::Read(const u64 offset, const size_t length, u8* buffer) const {
     if (!mode.read_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    return MakeResult<size_t>(file->ReadBytes(buffer, length));
+    std::lock_guard<std::mutex> lock(write_buffer_mutex);
+    if (dirty_extents.empty())
+        return MakeResult<size_t>(file->ReadAt(offset, buffer, length));
+
+    // Buffered writes may extend the file, with the gap up to them reading as zeros
+    const u64 size = std::max(file->GetSize(), dirty_extents.rbegin()->first +
+                                                   dirty_extents.rbegin()->second.size());
+    if (offset >= size)
+        return MakeResult<size_t>(0);
+    const size_t read_length = static_cast<size_t>(std::min<u64>(length, size - offset));
+    const size_t bytes_read = file->ReadAt(offset, buffer, read_length);
+    std::fill(buffer + bytes_read, buffer + read_length, 0);
+
+    // Apply the buffered writes over the data of the host file
+    const u64 end = offset + read_length;
+    auto it = dirty_extents.upper_bound(offset);
+    if (it != dirty_extents.begin())
+        --it;
+    for (; it != dirty_extents.end() && it->first < end; ++it) {
+        const u64 extent_end = it->first + it->second.size();
+        const u64 copy_start = std::max(offset, it->first);
+        const u64 copy_end = std::min(end, extent_end);
+        if (copy_start < copy_end) {
+            std::copy(it->second.begin() + (copy_start - it->first),
+                      it->second.begin() + (copy_end - it->first), buffer + (copy_start - offset));
+        }
+    }
+    return MakeResult<size_t>(read_length);
 }
 
 ResultVal<size_t> DiskFile::Write(const u64 offset, const size_t length, const bool flush,
@@ -29,45 +113,73 @@ ResultVal<size_t> DiskFile::Write(const u64 offset, const size_t length, const b
     if (!mode.write_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    size_t written = file->WriteBytes(buffer, length);
-    if (flush)
-        file->Flush();
-    return MakeResult<size_t>(written);
+    // The listings of the directory hold the size of the file
+    if (metadata_cache != nullptr)
+        metadata_cache->InvalidateFile(host_path);
+
+    bool write_back;
+    {
+        std::lock_guard<std::mutex> lock(write_buffer_mutex);
+        const Clock::time_point now = Clock::now();
+        if (dirty_extents.empty())
+            dirty_since = now;
+        BufferWrite(offset, length, buffer);
+        write_back = dirty_bytes >= MAX_DIRTY_BYTES || now - dirty_since >= MAX_DIRTY_AGE;
+    }
+
+    if (flush) {
+        Flush();
+    } else if (write_back) {
+        WriteBack();
+    }
+    return MakeResult<size_t>(length);
 }
 
 u64 DiskFile::GetSize() const {
-    return file->GetSize();
+    std::lock_guard<std::mutex> lock(write_buffer_mutex);
+    u64 size = file->GetSize();
+    if (!dirty_extents.empty()) {
+        const auto& last_extent = *dirty_extents.rbegin();
+        size = std::max<u64>(size, last_extent.first + last_extent.second.size());
+    }
+    return size;
 }
 
 bool DiskFile::SetSize(const u64 size) const {
+    if (metadata_cache != nullptr)
+        metadata_cache->InvalidateFile(host_path);
+    WriteBack();
     file->Resize(size);
     file->Flush();
     return true;
 }
 
 bool DiskFile::Close() const {
+    WriteBack();
     return file->Close();
 }
 
+void DiskFile::Flush() const {
+    WriteBack();
+    file->Flush();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-DiskDirectory::DiskDirectory(const std::string& path) : directory() {
-    unsigned size = FileUtil::ScanDirectoryTree(path, directory);
-    directory.size = size;
-    directory.isDirectory = true;
-    children_iterator = directory.children.begin();
+DiskDirectory::DiskDirectory(std::shared_ptr<const FileUtil::FSTEntry> directory_)
+    : directory(std::move(directory_)) {
+    children_iterator = directory->children.begin();
 }
 
 u32 DiskDirectory::Read(const u32 count, Entry* entries) {
     u32 entries_read = 0;
 
-    while (entries_read < count && children_iterator != directory.children.cend()) {
+    while (entries_read < count && children_iterator != directory->children.cend()) {
         const FileUtil::FSTEntry& file = *children_iterator;
         const std::string& filename = file.virtualName;
         Entry& entry = entries[entries_read];
 
-        LOG_TRACE(Service_FS, "File %s: size=%llu dir=%d", filename.c_str(), file.size,
+        LOG_TRACE(Service_FS, "File %s: size=%" PRIu64 " dir=%d", filename.c_str(), file.size,
                   file.isDirectory);
 
         // TODO(Link Mauve): use a proper conversion to UTF-16.
@@ -4,8 +4,11 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstddef>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "common/common_types.h"
@@ -13,6 +16,7 @@
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/directory_backend.h"
 #include "core/file_sys/file_backend.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -20,31 +24,65 @@
 
 namespace FileSys {
 
+/**
+ * File of an archive stored on the host file system. Writes are buffered in memory and coalesced
+ * into contiguous extents, which are written to the host file on Flush, Close, SetSize, when too
+ * much data is buffered, or on the first write after the buffered data has waited for too long.
+ * Games tend to write their saves in many small chunks, each of which would otherwise be a
+ * separate write to the host file.
+ */
 class DiskFile : public FileBackend {
 public:
-    DiskFile(FileUtil::IOFile&& file_, const Mode& mode_)
-        : file(new FileUtil::IOFile(std::move(file_))) {
+    /**
+     * @param metadata_cache Cache of the archive the file is in, whose entries for the file are
+     *                       invalidated when its size may change. Can be null for files whose
+     *                       size is fixed.
+     * @param host_path Path of the file on the host, as the metadata cache knows it
+     */
+    DiskFile(FileUtil::IOFile&& file_, const Mode& mode_,
+             std::shared_ptr<HostMetadataCache> metadata_cache_ = nullptr,
+             std::string host_path_ = "")
+        : file(new FileUtil::IOFile(std::move(file_))), metadata_cache(std::move(metadata_cache_)),
+          host_path(std::move(host_path_)) {
         mode.hex = mode_.hex;
     }
 
+    ~DiskFile() override;
+
     ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override;
     ResultVal<size_t> Write(u64 offset, size_t length, bool flush, const u8* buffer) const override;
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override;
-
-    void Flush() const override {
-        file->Flush();
-    }
+    void Flush() const override;
 
 protected:
     Mode mode;
     std::unique_ptr<FileUtil::IOFile> file;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Adds written data to the extents, merging it with the extents it overlaps or touches
+    void BufferWrite(u64 offset, size_t length, const u8* buffer) const;
+    /// Writes the buffered extents to the host file
+    void WriteBack() const;
+
+    std::shared_ptr<HostMetadataCache> metadata_cache;
+    std::string host_path;
+
+    // Guards the buffered writes, as reads may come from the FS I/O worker threads
+    mutable std::mutex write_buffer_mutex;
+    /// Buffered writes not in the host file yet, by offset. They never overlap or touch.
+    mutable std::map<u64, std::vector<u8>> dirty_extents;
+    mutable size_t dirty_bytes = 0;
+    /// Time of the oldest buffered write
+    mutable Clock::time_point dirty_since;
 };
 
 class DiskDirectory : public DirectoryBackend {
 public:
-    DiskDirectory(const std::string& path);
+    explicit DiskDirectory(std::shared_ptr<const FileUtil::FSTEntry> directory);
 
     ~DiskDirectory() override {
         Close();
@@ -58,11 +96,12 @@ public:
 
 protected:
     u32 total_entries_in_directory;
-    FileUtil::FSTEntry directory;
+    /// Listing of the directory, shared with the metadata cache of the archive
+    std::shared_ptr<const FileUtil::FSTEntry> directory;
 
     // We need to remember the last entry we returned, so a subsequent call to Read will continue
     // from the next one.  This iterator will always point to the next unread entry.
-    std::vector<FileUtil::FSTEntry>::iterator children_iterator;
+    std::vector<FileUtil::FSTEntry>::const_iterator children_iterator;
 };
 
 } // namespace FileSys
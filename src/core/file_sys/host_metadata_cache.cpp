@@ -0,0 +1,84 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/file_sys/host_metadata_cache.h"
+
+namespace FileSys {
+
+// The caches live as long as an archive or file of the mount point holds them
+static std::mutex caches_mutex;
+static std::unordered_map<std::string, std::weak_ptr<HostMetadataCache>> caches;
+
+std::shared_ptr<HostMetadataCache> HostMetadataCache::Get(const std::string& mount_point) {
+    std::lock_guard<std::mutex> lock(caches_mutex);
+    std::weak_ptr<HostMetadataCache>& cache = caches[mount_point];
+    std::shared_ptr<HostMetadataCache> shared_cache = cache.lock();
+    if (shared_cache == nullptr) {
+        shared_cache = std::make_shared<HostMetadataCache>(mount_point);
+        cache = shared_cache;
+    }
+    return shared_cache;
+}
+
+void HostMetadataCache::InvalidateDirectory(const std::string& host_path) {
+    std::lock_guard<std::mutex> lock(caches_mutex);
+    for (auto it = caches.begin(); it != caches.end();) {
+        std::shared_ptr<HostMetadataCache> cache = it->second.lock();
+        if (cache == nullptr) {
+            it = caches.erase(it);
+            continue;
+        }
+        const std::string& mount_point = it->first;
+        if (mount_point.compare(0, host_path.size(), host_path) == 0 ||
+            host_path.compare(0, mount_point.size(), mount_point) == 0) {
+            cache->Invalidate();
+        }
+        ++it;
+    }
+}
+
+PathParser::HostStatus HostMetadataCache::GetHostStatus(const PathParser& path_parser) {
+    const std::string host_path = path_parser.BuildHostPath(mount_point);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = host_statuses.find(host_path);
+    if (it == host_statuses.end())
+        it = host_statuses.emplace(host_path, path_parser.GetHostStatus(mount_point)).first;
+    return it->second;
+}
+
+std::shared_ptr<const FileUtil::FSTEntry> HostMetadataCache::GetDirectory(
+    const std::string& host_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = directories.find(host_path);
+    if (it == directories.end()) {
+        auto directory = std::make_shared<FileUtil::FSTEntry>();
+        directory->size = FileUtil::ScanDirectoryTree(host_path, *directory);
+        directory->isDirectory = true;
+        it = directories.emplace(host_path, std::move(directory)).first;
+    }
+    return it->second;
+}
+
+void HostMetadataCache::Invalidate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    host_statuses.clear();
+    directories.clear();
+}
+
+void HostMetadataCache::InvalidateFile(const std::string& host_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    host_statuses.erase(host_path);
+    // Directories are scanned recursively, so the listings of all the directories above the file
+    // hold its size
+    for (auto it = directories.begin(); it != directories.end();) {
+        if (host_path.compare(0, it->first.size(), it->first) == 0) {
+            it = directories.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace FileSys
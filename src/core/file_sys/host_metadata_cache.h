@@ -0,0 +1,57 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "common/file_util.h"
+#include "core/file_sys/path_parser.h"
+
+namespace FileSys {
+
+/**
+ * Cache of what the host file system holds under the mount point of disk backed archives: the
+ * status of the paths looked up and the listings of the directories opened. Games checking for
+ * the same files and folders over and over (e.g. for DLC) then only reach the host file system
+ * once. The archives invalidate the whole cache whenever they change the directory structure
+ * under the mount point, and only the entries a file appears in when they write to it; changes
+ * made by other programs while the emulator runs are not noticed.
+ */
+class HostMetadataCache {
+public:
+    /// Returns the cache shared by every archive with the given mount point
+    static std::shared_ptr<HostMetadataCache> Get(const std::string& mount_point);
+
+    /**
+     * Invalidates the caches of every mount point inside or above a host directory, to be called
+     * after changing the directory other than through an archive, e.g. when formatting it
+     */
+    static void InvalidateDirectory(const std::string& host_path);
+
+    explicit HostMetadataCache(std::string mount_point) : mount_point(std::move(mount_point)) {}
+
+    /// Returns PathParser::GetHostStatus for the mount point, asking the host only once
+    PathParser::HostStatus GetHostStatus(const PathParser& path_parser);
+
+    /// Returns the entries of a host directory, as FileUtil::ScanDirectoryTree fills them
+    std::shared_ptr<const FileUtil::FSTEntry> GetDirectory(const std::string& host_path);
+
+    /// Forgets everything cached, to be called before changing anything under the mount point
+    void Invalidate();
+
+    /// Forgets the status of a file and the listings holding it, to be called when it is written
+    void InvalidateFile(const std::string& host_path);
+
+private:
+    const std::string mount_point;
+
+    std::mutex mutex;
+    std::unordered_map<std::string, PathParser::HostStatus> host_statuses;
+    std::unordered_map<std::string, std::shared_ptr<const FileUtil::FSTEntry>> directories;
+};
+
+} // namespace FileSys
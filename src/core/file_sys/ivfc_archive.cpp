@@ -2,10 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cinttypes>
 #include <cstring>
 #include <memory>
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "core/file_sys/ivfc_archive.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -86,11 +89,48 @@ u64 IVFCArchive::GetFreeBytes() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 ResultVal<size_t> IVFCFile::Read(const u64 offset, const size_t length, u8* buffer) const {
-    LOG_TRACE(Service_FS, "called offset=%llu, length=%zu", offset, length);
-    romfs_file->Seek(data_offset + offset, SEEK_SET);
+    LOG_TRACE(Service_FS, "called offset=%" PRIu64 ", length=%zu", offset, length);
+    if (offset >= data_size)
+        return MakeResult<size_t>(0);
     size_t read_length = (size_t)std::min((u64)length, data_size - offset);
+    ReadAhead(offset, read_length);
 
-    return MakeResult<size_t>(romfs_file->ReadBytes(buffer, read_length));
+    return MakeResult<size_t>(romfs_file->ReadBytes(data_offset + offset, read_length, buffer));
+}
+
+void IVFCFile::ReadAhead(u64 offset, size_t length) const {
+    // The window starts small and doubles each time it is used up while reading sequentially
+    constexpr u64 MIN_READAHEAD_WINDOW = 64 * 1024;
+    constexpr u64 MAX_READAHEAD_WINDOW = 1024 * 1024;
+
+    std::lock_guard<std::mutex> lock(readahead_mutex);
+    const u64 end = offset + length;
+    const bool sequential = offset == next_sequential_offset;
+    next_sequential_offset = end;
+
+    if (!sequential) {
+        readahead_window = MIN_READAHEAD_WINDOW;
+        readahead_end = end;
+        return;
+    }
+
+    if (end <= readahead_end) {
+        MICROPROFILE_META_CPU("RomFS Read-ahead Hit", 1);
+    } else {
+        MICROPROFILE_META_CPU("RomFS Read-ahead Miss", 1);
+        readahead_end = end;
+    }
+
+    // Keep a window's worth of data ahead of the reads in flight
+    readahead_window = std::max(readahead_window, MIN_READAHEAD_WINDOW);
+    if (readahead_end - end < readahead_window / 2) {
+        const u64 prefetch_end = std::min(end + readahead_window, data_size);
+        if (prefetch_end > readahead_end) {
+            romfs_file->Prefetch(data_offset + readahead_end, prefetch_end - readahead_end);
+            readahead_end = prefetch_end;
+        }
+        readahead_window = std::min(readahead_window * 2, MAX_READAHEAD_WINDOW);
+    }
 }
 
 ResultVal<size_t> IVFCFile::Write(const u64 offset, const size_t length, const bool flush,
@@ -6,6 +6,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "common/common_types.h"
@@ -27,7 +28,7 @@ namespace FileSys {
  */
 class IVFCArchive : public ArchiveBackend {
 public:
-    IVFCArchive(std::shared_ptr<FileUtil::IOFile> file, u64 offset, u64 size)
+    IVFCArchive(std::shared_ptr<FileUtil::MappedFile> file, u64 offset, u64 size)
         : romfs_file(file), data_offset(offset), data_size(size) {}
 
     std::string GetName() const override;
@@ -45,14 +46,14 @@ public:
     u64 GetFreeBytes() const override;
 
 protected:
-    std::shared_ptr<FileUtil::IOFile> romfs_file;
+    std::shared_ptr<FileUtil::MappedFile> romfs_file;
     u64 data_offset;
     u64 data_size;
 };
 
 class IVFCFile : public FileBackend {
 public:
-    IVFCFile(std::shared_ptr<FileUtil::IOFile> file, u64 offset, u64 size)
+    IVFCFile(std::shared_ptr<FileUtil::MappedFile> file, u64 offset, u64 size)
         : romfs_file(file), data_offset(offset), data_size(size) {}
 
     ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override;
@@ -65,9 +66,20 @@ public:
     void Flush() const override {}
 
 private:
-    std::shared_ptr<FileUtil::IOFile> romfs_file;
+    /// Starts loading the data following a read from disk if the file is being read sequentially
+    void ReadAhead(u64 offset, size_t length) const;
+
+    std::shared_ptr<FileUtil::MappedFile> romfs_file;
     u64 data_offset;
     u64 data_size;
+
+    // Read-ahead state, guarded by readahead_mutex as reads may come from several threads
+    mutable std::mutex readahead_mutex;
+    /// Offset the next read starts at if the file is being read sequentially
+    mutable u64 next_sequential_offset = 0;
+    /// End of the data already requested from disk
+    mutable u64 readahead_end = 0;
+    mutable u64 readahead_window = 0;
 };
 
 class IVFCDirectory : public DirectoryBackend {
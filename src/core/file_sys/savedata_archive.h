@@ -4,10 +4,12 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/directory_backend.h"
 #include "core/file_sys/file_backend.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -18,7 +20,8 @@ namespace FileSys {
 /// Archive backend for general save data archive type (SaveData and SystemSaveData)
 class SaveDataArchive : public ArchiveBackend {
 public:
-    explicit SaveDataArchive(const std::string& mount_point_) : mount_point(mount_point_) {}
+    explicit SaveDataArchive(const std::string& mount_point_)
+        : mount_point(mount_point_), metadata_cache(HostMetadataCache::Get(mount_point)) {}
 
     std::string GetName() const override {
         return "SaveDataArchive: " + mount_point;
@@ -38,6 +41,7 @@ public:
 
 protected:
     std::string mount_point;
+    std::shared_ptr<HostMetadataCache> metadata_cache;
 };
 
 } // namespace FileSys
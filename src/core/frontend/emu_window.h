@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include <mutex>
 #include <tuple>
 #include <utility>
@@ -51,6 +52,47 @@ public:
     /// Releases (dunno if this is the "right" word) the GLFW context from the caller thread
     virtual void DoneCurrent() = 0;
 
+    /// Graphics context sharing its objects with the window's one, for use on another thread
+    class GraphicsContext {
+    public:
+        virtual ~GraphicsContext() {}
+
+        /// Makes the context current for the caller thread
+        virtual void MakeCurrent() = 0;
+
+        /// Releases the context from the caller thread
+        virtual void DoneCurrent() = 0;
+    };
+
+    /**
+     * Creates a context sharing objects with the window's one. Must be called from the thread the
+     * window's context, or another context sharing its objects, is current on.
+     * @returns The new context, or nullptr if the frontend doesn't support shared contexts
+     */
+    virtual std::unique_ptr<GraphicsContext> CreateSharedContext() const {
+        return nullptr;
+    }
+
+    /**
+     * Creates a context sharing objects with the window's one that draws to the window, so that
+     * frames can be presented with SwapBuffers from the thread it is current on. Must be called
+     * from the thread the window's context is current on.
+     * @returns The new context, or nullptr if the frontend can't present from another thread
+     */
+    virtual std::unique_ptr<GraphicsContext> CreatePresentationContext() const {
+        return nullptr;
+    }
+
+    /**
+     * Returns the framebuffer object the renderer draws the next frame into before calling
+     * SwapBuffers, or 0 for the window's default framebuffer. Frontends that read frames back use
+     * one of their own, as the default framebuffer of a hidden or covered window has undefined
+     * contents. Called from the thread the window's context is current on.
+     */
+    virtual u32 GetDrawFramebuffer() {
+        return 0;
+    }
+
     /**
      * Signal that a touch pressed event has occurred (e.g. mouse click pressed)
      * @param framebuffer_x Framebuffer x-coordinate that was pressed
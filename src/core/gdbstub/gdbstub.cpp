@@ -6,13 +6,17 @@
 
 #include <algorithm>
 #include <atomic>
+#include <bitset>
 #include <climits>
+#include <condition_variable>
 #include <csignal>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
 #include <map>
+#include <mutex>
 #include <numeric>
+#include <thread>
 #include <fcntl.h>
 
 #ifdef _WIN32
@@ -136,6 +140,15 @@ static bool step_loop = false;
 // gdbstub-related functions will be executed.
 static std::atomic<bool> server_enabled(false);
 
+// The socket is watched by a thread of its own, so that the emulation thread only has to check a
+// flag instead of polling the socket on every run of the CPU. Once the thread finds data to read,
+// it sets the flag and waits for the emulation thread to read it before watching again.
+static std::thread poll_thread;
+static std::mutex poll_mutex;
+static std::condition_variable poll_cv;
+static std::atomic<bool> data_pending(false);
+static bool stop_polling = false;
+
 #ifdef _WIN32
 WSADATA InitData;
 #endif
@@ -150,6 +163,13 @@ static std::map<u32, Breakpoint> breakpoints_execute;
 static std::map<u32, Breakpoint> breakpoints_read;
 static std::map<u32, Breakpoint> breakpoints_write;
 
+// Pages with at least one breakpoint of the type. The interpreter checks every memory access, and
+// almost all of them can be ruled out by a single bit without looking up the map.
+using BreakpointPages = std::bitset<Memory::PAGE_TABLE_NUM_ENTRIES>;
+static BreakpointPages pages_execute;
+static BreakpointPages pages_read;
+static BreakpointPages pages_write;
+
 /**
  * Turns hex string character into the equivalent byte.
  *
@@ -290,6 +310,20 @@ static std::map<u32, Breakpoint>& GetBreakpointList(BreakpointType type) {
     }
 }
 
+/// Get the pages with breakpoints of a given breakpoint type.
+static BreakpointPages& GetBreakpointPages(BreakpointType type) {
+    switch (type) {
+    case BreakpointType::Execute:
+        return pages_execute;
+    case BreakpointType::Read:
+        return pages_read;
+    case BreakpointType::Write:
+        return pages_write;
+    default:
+        return pages_read;
+    }
+}
+
 /**
  * Remove the breakpoint from the given address of the specified type.
  *
@@ -302,14 +336,21 @@ static void RemoveBreakpoint(BreakpointType type, PAddr addr) {
     auto bp = p.find(addr);
     if (bp != p.end()) {
         LOG_DEBUG(Debug_GDBStub, "gdb: removed a breakpoint: %08x bytes at %08x of type %d\n",
-                  bp->second.len, bp->second.addr, type);
+                  bp->second.len, bp->second.addr, static_cast<int>(type));
         p.erase(addr);
+
+        // Clear the bit of the page unless another breakpoint is left in it
+        const u32 page_start = addr & ~Memory::PAGE_MASK;
+        auto next = p.lower_bound(page_start);
+        if (next == p.end() || next->first - page_start >= Memory::PAGE_SIZE) {
+            GetBreakpointPages(type).reset(addr >> Memory::PAGE_BITS);
+        }
     }
 }
 
 BreakpointAddress GetNextBreakpointFromAddress(PAddr addr, BreakpointType type) {
     std::map<u32, Breakpoint>& p = GetBreakpointList(type);
-    auto next_breakpoint = p.lower_bound(addr);
+    auto next_breakpoint = p.empty() ? p.end() : p.lower_bound(addr);
     BreakpointAddress breakpoint;
 
     if (next_breakpoint != p.end()) {
@@ -324,7 +365,7 @@ BreakpointAddress GetNextBreakpointFromAddress(PAddr addr, BreakpointType type)
 }
 
 bool CheckBreakpoint(PAddr addr, BreakpointType type) {
-    if (!IsConnected()) {
+    if (!GetBreakpointPages(type).test(addr >> Memory::PAGE_BITS) || !IsConnected()) {
         return false;
     }
 
@@ -348,8 +389,8 @@ bool CheckBreakpoint(PAddr addr, BreakpointType type) {
 
         if (bp->second.active && (addr >= bp->second.addr && addr < bp->second.addr + len)) {
             LOG_DEBUG(Debug_GDBStub,
-                      "Found breakpoint type %d @ %08x, range: %08x - %08x (%d bytes)\n", type,
-                      addr, bp->second.addr, bp->second.addr + len, len);
+                      "Found breakpoint type %d @ %08x, range: %08x - %08x (%d bytes)\n",
+                      static_cast<int>(type), addr, bp->second.addr, bp->second.addr + len, len);
             return true;
         }
     }
@@ -504,27 +545,70 @@ static void ReadCommand() {
     SendPacket(GDB_STUB_ACK);
 }
 
-/// Check if there is data to be read from the gdb client.
-static bool IsDataAvailable() {
-    if (!IsConnected()) {
-        return false;
-    }
-
+/**
+ * Wait for data to be read from the gdb client.
+ *
+ * @param socket Socket of the client.
+ * @param timeout_us Time to wait at most, in microseconds.
+ */
+static bool WaitForData(int socket, long timeout_us) {
     fd_set fd_socket;
 
     FD_ZERO(&fd_socket);
-    FD_SET(gdbserver_socket, &fd_socket);
+    FD_SET(socket, &fd_socket);
 
     struct timeval t;
     t.tv_sec = 0;
-    t.tv_usec = 0;
+    t.tv_usec = timeout_us;
 
-    if (select(gdbserver_socket + 1, &fd_socket, nullptr, nullptr, &t) < 0) {
+    if (select(socket + 1, &fd_socket, nullptr, nullptr, &t) < 0) {
         LOG_ERROR(Debug_GDBStub, "select failed");
         return false;
     }
 
-    return FD_ISSET(gdbserver_socket, &fd_socket) != 0;
+    return FD_ISSET(socket, &fd_socket) != 0;
+}
+
+/**
+ * Watch the socket for data from the gdb client until stopped, telling the emulation thread about
+ * it through data_pending.
+ *
+ * @param socket Socket of the client.
+ */
+static void PollLoop(int socket) {
+    // Wakes up regularly to notice when it's stopped
+    constexpr long POLL_TIMEOUT_US = 100000;
+
+    std::unique_lock<std::mutex> lock(poll_mutex);
+    while (!stop_polling) {
+        lock.unlock();
+        const bool available = WaitForData(socket, POLL_TIMEOUT_US);
+        lock.lock();
+
+        if (available) {
+            data_pending = true;
+            poll_cv.wait(lock, [] { return stop_polling || !data_pending; });
+        }
+    }
+}
+
+static void StartPolling() {
+    stop_polling = false;
+    data_pending = false;
+    poll_thread = std::thread(PollLoop, gdbserver_socket);
+}
+
+static void StopPolling() {
+    if (!poll_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(poll_mutex);
+        stop_polling = true;
+    }
+    poll_cv.notify_one();
+    poll_thread.join();
 }
 
 /// Send requested register to gdb client.
@@ -733,9 +817,10 @@ static bool CommitBreakpoint(BreakpointType type, PAddr addr, u32 len) {
     breakpoint.addr = addr;
     breakpoint.len = len;
     p.insert({addr, breakpoint});
+    GetBreakpointPages(type).set(addr >> Memory::PAGE_BITS);
 
-    LOG_DEBUG(Debug_GDBStub, "gdb: added %d breakpoint: %08x bytes at %08x\n", type, breakpoint.len,
-              breakpoint.addr);
+    LOG_DEBUG(Debug_GDBStub, "gdb: added %d breakpoint: %08x bytes at %08x\n",
+              static_cast<int>(type), breakpoint.len, breakpoint.addr);
 
     return true;
 }
@@ -833,11 +918,19 @@ void HandlePacket() {
         return;
     }
 
-    if (!IsDataAvailable()) {
+    if (!data_pending) {
         return;
     }
 
     ReadCommand();
+
+    // Let the poll thread look for the next packet, which may already be there
+    {
+        std::lock_guard<std::mutex> lock(poll_mutex);
+        data_pending = false;
+    }
+    poll_cv.notify_one();
+
     if (command_length == 0) {
         return;
     }
@@ -933,6 +1026,9 @@ static void Init(u16 port) {
     breakpoints_execute.clear();
     breakpoints_read.clear();
     breakpoints_write.clear();
+    pages_execute.reset();
+    pages_read.reset();
+    pages_write.reset();
 
     // Start gdb server
     LOG_INFO(Debug_GDBStub, "Starting GDB server on port %d...", port);
@@ -984,6 +1080,7 @@ static void Init(u16 port) {
     } else {
         LOG_INFO(Debug_GDBStub, "Client connected.\n");
         saddr_client.sin_addr.s_addr = ntohl(saddr_client.sin_addr.s_addr);
+        StartPolling();
     }
 
     // Clean up temporary socket if it's still alive at this point.
@@ -1002,6 +1099,7 @@ void Shutdown() {
     }
 
     LOG_INFO(Debug_GDBStub, "Stopping GDB ...");
+    StopPolling();
     if (gdbserver_socket != -1) {
         shutdown(gdbserver_socket, SHUT_RDWR);
         gdbserver_socket = -1;
@@ -0,0 +1,120 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/guest_profiler.h"
+#include "core/hle/kernel/thread.h"
+#include "core/settings.h"
+
+namespace GuestProfiler {
+
+/// Emulated time between two samples. Each one costs a hash table update, next to the 26800
+/// emulated cycles in between.
+constexpr u64 SAMPLE_INTERVAL_US = 100;
+
+struct Symbol {
+    u32 size;
+    std::string name;
+};
+
+static int sample_event = -1;
+static bool enabled = false;
+
+// Only touched on the emulation thread, so nothing needs guarding. Keyed by LR << 32 | PC.
+static std::unordered_map<u64, u32> hits;
+/// Samples taken while no thread was running
+static u64 idle_hits = 0;
+
+static std::map<VAddr, Symbol> symbols;
+
+static void Sample(u64 /*userdata*/, int cycles_late) {
+    if (Kernel::GetCurrentThread() == nullptr) {
+        ++idle_hits;
+    } else {
+        const ARM_Interface& cpu = Core::CPU();
+        ++hits[static_cast<u64>(cpu.GetReg(14)) << 32 | cpu.GetPC()];
+    }
+
+    CoreTiming::ScheduleEvent(usToCycles(SAMPLE_INTERVAL_US) - cycles_late, sample_event);
+}
+
+/// Returns the name of the symbol an address is in, or the address itself if it isn't in any
+static std::string Symbolize(VAddr address) {
+    auto next = symbols.upper_bound(address);
+    if (next != symbols.begin()) {
+        const auto& symbol = *std::prev(next);
+        if (symbol.second.size == 0 || address - symbol.first < symbol.second.size)
+            return symbol.second.name;
+    }
+    return Common::StringFromFormat("0x%08X", address);
+}
+
+static void WriteProfile(const std::string& path) {
+    // Thumb code is sampled with the low bit of the LR set, while symbols are looked up without it
+    std::map<std::string, u64> stacks;
+    for (const auto& hit : hits) {
+        const VAddr lr = static_cast<VAddr>(hit.first >> 32) & ~1u;
+        const VAddr pc = static_cast<VAddr>(hit.first);
+        stacks[Symbolize(lr) + ';' + Symbolize(pc)] += hit.second;
+    }
+    if (idle_hits != 0)
+        stacks["[idle]"] += idle_hits;
+
+    std::vector<std::pair<std::string, u64>> sorted(stacks.begin(), stacks.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    FileUtil::IOFile file(path, "w");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Core, "Could not open %s to write the guest profile to", path.c_str());
+        return;
+    }
+    for (const auto& stack : sorted) {
+        const std::string line =
+            Common::StringFromFormat("%s %llu\n", stack.first.c_str(),
+                                     static_cast<unsigned long long>(stack.second));
+        file.WriteBytes(line.data(), line.size());
+    }
+    LOG_INFO(Core, "Wrote %zu stacks of guest profile to %s", sorted.size(), path.c_str());
+}
+
+void Init() {
+    enabled = !Settings::values.guest_profile_path.empty();
+    if (!enabled)
+        return;
+
+    sample_event = CoreTiming::RegisterEvent("GuestProfiler::Sample", Sample);
+    CoreTiming::ScheduleEvent(usToCycles(SAMPLE_INTERVAL_US), sample_event);
+}
+
+void Shutdown() {
+    if (enabled)
+        WriteProfile(Settings::values.guest_profile_path);
+
+    enabled = false;
+    hits.clear();
+    idle_hits = 0;
+    symbols.clear();
+}
+
+bool IsEnabled() {
+    return enabled;
+}
+
+void AddSymbol(VAddr address, u32 size, std::string name) {
+    symbols[address] = {size, std::move(name)};
+}
+
+} // namespace GuestProfiler
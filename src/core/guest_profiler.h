@@ -0,0 +1,36 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include "common/common_types.h"
+
+/**
+ * Sampling profiler of the emulated application. At a fixed interval of emulated time, a CoreTiming
+ * event records the PC and LR of the emulated CPU, and the hits of each pair are counted. On
+ * shutdown, they are written in the collapsed stack format of flamegraph.pl, symbolized with the
+ * symbols of the loaded executable when it has any.
+ *
+ * The LR is only the caller while the sampled function hasn't made a call of its own, so the
+ * stacks are two frames deep at best. That's enough to tell which functions the time goes to.
+ */
+namespace GuestProfiler {
+
+/// Starts sampling if a profile path is configured. To be called after CoreTiming::Init.
+void Init();
+
+/// Writes the profile, if sampling, and forgets the samples and symbols
+void Shutdown();
+
+bool IsEnabled();
+
+/**
+ * Names the code from address to address + size for the report. Symbols must not overlap.
+ * @param size Size of the symbol in bytes, 0 if unknown, in which case it extends up to the
+ *             next symbol
+ */
+void AddSymbol(VAddr address, u32 size, std::string name);
+
+} // namespace GuestProfiler
@@ -36,8 +36,7 @@ ResultCode AddressArbiter::ArbitrateAddress(ArbitrationType type, VAddr address,
             ArbitrateAllThreads(address);
         } else {
             // Resume first N threads
-            for (int i = 0; i < value; i++)
-                ArbitrateHighestPriorityThread(address);
+            ArbitrateThreads(address, static_cast<size_t>(value));
         }
         break;
 
@@ -25,6 +25,11 @@ ResultVal<SharedPtr<ClientSession>> ClientPort::Connect() {
     }
     active_sessions++;
 
+    if (server_port->hle_handler == nullptr && server_port->hle_handler_factory) {
+        server_port->hle_handler = server_port->hle_handler_factory();
+        server_port->hle_handler_factory = nullptr;
+    }
+
     // Create a new session pair, let the created sessions inherit the parent port's HLE handler.
     auto sessions = ServerSession::CreateSessionPair(server_port->GetName(), this);
 
@@ -8,6 +8,7 @@
 #include <string>
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/slab_allocator.h"
 #include "core/hle/result.h"
 
 namespace Kernel {
@@ -16,7 +17,7 @@ class ServerSession;
 class Session;
 class Thread;
 
-class ClientSession final : public Object {
+class ClientSession final : public Object, public SlabAllocated<ClientSession> {
 public:
     friend class ServerSession;
 
@@ -6,11 +6,12 @@
 
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/slab_allocator.h"
 #include "core/hle/kernel/wait_object.h"
 
 namespace Kernel {
 
-class Event final : public WaitObject {
+class Event final : public WaitObject, public SlabAllocated<Event> {
 public:
     /**
      * Creates an event
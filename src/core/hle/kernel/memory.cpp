@@ -12,6 +12,7 @@
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/memory_util.h"
 #include "core/hle/config_mem.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/vm_manager.h"
@@ -58,6 +59,8 @@ void MemoryInit(u32 mem_type) {
         // Reserve enough space for this region of FCRAM.
         // We do not want this block of memory to be relocated when allocating from it.
         memory_regions[i].linear_heap_memory->reserve(memory_regions[i].size);
+        HintLargeMemoryPages(memory_regions[i].linear_heap_memory->data(),
+                             memory_regions[i].size);
 
         base += memory_regions[i].size;
     }
@@ -96,8 +99,22 @@ MemoryRegionInfo* GetMemoryRegion(MemoryRegion region) {
     }
 }
 
-std::array<u8, Memory::VRAM_SIZE> vram;
-std::array<u8, Memory::N3DS_EXTRA_RAM_SIZE> n3ds_extra_ram;
+/// Allocates memory that stays mapped for the lifetime of the emulator, on large pages if possible
+static u8* AllocatePersistentMemory(size_t size) {
+    u8* memory = static_cast<u8*>(AllocateLargeMemoryPages(size));
+    ASSERT_MSG(memory != nullptr, "Failed to allocate %zu bytes of emulated memory", size);
+    return memory;
+}
+
+static u8* GetVRAM() {
+    static u8* const vram = AllocatePersistentMemory(Memory::VRAM_SIZE);
+    return vram;
+}
+
+static u8* GetN3DSExtraRAM() {
+    static u8* const n3ds_extra_ram = AllocatePersistentMemory(Memory::N3DS_EXTRA_RAM_SIZE);
+    return n3ds_extra_ram;
+}
 
 void HandleSpecialMapping(VMManager& address_space, const AddressMapping& mapping) {
     using namespace Memory;
@@ -148,13 +165,13 @@ void HandleSpecialMapping(VMManager& address_space, const AddressMapping& mappin
     u8* target_pointer = nullptr;
     switch (area->paddr_base) {
     case VRAM_PADDR:
-        target_pointer = vram.data();
+        target_pointer = GetVRAM();
         break;
     case DSP_RAM_PADDR:
         target_pointer = AudioCore::GetDspMemory().data();
         break;
     case N3DS_EXTRA_RAM_PADDR:
-        target_pointer = n3ds_extra_ram.data();
+        target_pointer = GetN3DSExtraRAM();
         break;
     default:
         UNREACHABLE();
@@ -7,13 +7,14 @@
 #include <string>
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/slab_allocator.h"
 #include "core/hle/kernel/wait_object.h"
 
 namespace Kernel {
 
 class Thread;
 
-class Mutex final : public WaitObject {
+class Mutex final : public WaitObject, public SlabAllocated<Mutex> {
 public:
     /**
      * Creates a mutex.
@@ -5,6 +5,7 @@
 #include <memory>
 #include "common/assert.h"
 #include "common/common_funcs.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/hle/kernel/errors.h"
 #include "core/hle/kernel/memory.h"
@@ -117,10 +118,17 @@ void Process::Run(s32 main_thread_priority, u32 stack_size) {
 
     auto MapSegment = [&](CodeSet::Segment& segment, VMAPermission permissions,
                           MemoryState memory_state) {
-        auto vma = vm_manager
-                       .MapMemoryBlock(segment.addr, codeset->memory, segment.offset, segment.size,
-                                       memory_state)
-                       .Unwrap();
+        VMManager::VMAHandle vma;
+        if (codeset->shared_memory != nullptr) {
+            u8* memory = codeset->shared_memory->GetWritableData() + segment.offset;
+            vma = vm_manager.MapBackingMemory(segment.addr, memory, segment.size, memory_state)
+                      .Unwrap();
+        } else {
+            vma = vm_manager
+                      .MapMemoryBlock(segment.addr, codeset->memory, segment.offset, segment.size,
+                                      memory_state)
+                      .Unwrap();
+        }
         vm_manager.Reprotect(vma, permissions);
         misc_memory_used += segment.size;
         memory_region->used += segment.size;
@@ -183,9 +191,12 @@ ResultVal<VAddr> Process::HeapAllocate(VAddr target, u32 size, VMAPermission per
         vm_manager.RefreshMemoryBlockMappings(heap_memory.get());
     }
     if (target + size > heap_end) {
+        const u8* old_data = heap_memory->data();
         heap_memory->insert(end(*heap_memory), (target + size) - heap_end, 0);
         heap_end = target + size;
-        vm_manager.RefreshMemoryBlockMappings(heap_memory.get());
+        // Growing at the end only moves the mapped memory when the vector reallocates
+        if (heap_memory->data() != old_data)
+            vm_manager.RefreshMemoryBlockMappings(heap_memory.get());
     }
     ASSERT(heap_end - heap_start == heap_memory->size());
 
@@ -239,8 +250,10 @@ ResultVal<VAddr> Process::LinearAllocate(VAddr target, u32 size, VMAPermission p
     // end. It's possible to free gaps in the middle of the heap and then reallocate them later,
     // but expansions are only allowed at the end.
     if (target == heap_end) {
+        const u8* old_data = linheap_memory->data();
         linheap_memory->insert(linheap_memory->end(), size, 0);
-        vm_manager.RefreshMemoryBlockMappings(linheap_memory.get());
+        if (linheap_memory->data() != old_data)
+            vm_manager.RefreshMemoryBlockMappings(linheap_memory.get());
     }
 
     // TODO(yuriks): As is, this lets processes map memory allocated by other processes from the
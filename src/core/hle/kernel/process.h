@@ -14,6 +14,10 @@
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/vm_manager.h"
 
+namespace FileUtil {
+class MappedFile;
+}
+
 namespace Kernel {
 
 struct AddressMapping {
@@ -72,6 +76,9 @@ struct CodeSet final : public Object {
     u64 program_id;
 
     std::shared_ptr<std::vector<u8>> memory;
+    /// Copy-on-write mapping of a file holding the memory, used instead of `memory` if set. The
+    /// host shares the pages that aren't written between all the processes mapping the file.
+    std::shared_ptr<FileUtil::MappedFile> shared_memory;
 
     struct Segment {
         size_t offset = 0;
@@ -8,12 +8,13 @@
 #include <string>
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/slab_allocator.h"
 #include "core/hle/kernel/wait_object.h"
 #include "core/hle/result.h"
 
 namespace Kernel {
 
-class Semaphore final : public WaitObject {
+class Semaphore final : public WaitObject, public SlabAllocated<Semaphore> {
 public:
     /**
      * Creates a semaphore.
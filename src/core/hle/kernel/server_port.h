@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -55,6 +56,14 @@ public:
         hle_handler = std::move(hle_handler_);
     }
 
+    /**
+     * Sets a factory creating the HLE handler of the port when the first client connects to it,
+     * for handlers that are only worth setting up if an application uses them.
+     */
+    void SetHleHandlerFactory(std::function<std::shared_ptr<SessionRequestHandler>()> factory) {
+        hle_handler_factory = std::move(factory);
+    }
+
     std::string name; ///< Name of port (optional)
 
     /// ServerSessions waiting to be accepted by the port
@@ -63,6 +72,8 @@ public:
     /// This session's HLE request handler template (optional)
     /// ServerSessions created from this port inherit a reference to this handler.
     std::shared_ptr<SessionRequestHandler> hle_handler;
+    /// Creates hle_handler on the first connection, if set
+    std::function<std::shared_ptr<SessionRequestHandler>()> hle_handler_factory;
 
     bool ShouldWait(Thread* thread) const override;
     void Acquire(Thread* thread) override;
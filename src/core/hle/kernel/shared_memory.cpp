@@ -38,6 +38,7 @@ SharedPtr<SharedMemory> SharedMemory::Create(SharedPtr<Process> owner_process, u
         shared_memory->backing_block = linheap_memory;
         shared_memory->backing_block_offset = linheap_memory->size();
         // Allocate some memory from the end of the linear heap for this region.
+        const u8* old_data = linheap_memory->data();
         linheap_memory->insert(linheap_memory->end(), size, 0);
         memory_region->used += size;
 
@@ -49,8 +50,8 @@ SharedPtr<SharedMemory> SharedMemory::Create(SharedPtr<Process> owner_process, u
             shared_memory->owner_process->linear_heap_used += size;
         }
 
-        // Refresh the address mappings for the current process.
-        if (Kernel::g_current_process != nullptr) {
+        // Refresh the address mappings for the current process, if the heap had to move.
+        if (Kernel::g_current_process != nullptr && linheap_memory->data() != old_data) {
             Kernel::g_current_process->vm_manager.RefreshMemoryBlockMappings(linheap_memory.get());
         }
     } else {
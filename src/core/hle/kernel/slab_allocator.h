@@ -0,0 +1,76 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace Kernel {
+
+/**
+ * Base for kernel object types that games create and destroy often, such as events and sessions.
+ * Objects of the type are carved out of slabs holding several of them, and freed objects are kept
+ * on a free list for the next allocation instead of going back to the heap. Slabs are never
+ * released, so the memory used is bounded by the peak number of live objects.
+ *
+ * Usage: class Event final : public WaitObject, public SlabAllocated<Event> { ... };
+ */
+template <typename T>
+class SlabAllocated {
+public:
+    static void* operator new(size_t size) {
+        // Types deriving from T have a size of their own and can't share its slabs
+        if (size != sizeof(T))
+            return ::operator new(size);
+
+        Pool& pool = GetPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (pool.free_objects.empty())
+            pool.AllocateSlab();
+        void* ptr = pool.free_objects.back();
+        pool.free_objects.pop_back();
+        return ptr;
+    }
+
+    static void operator delete(void* ptr, size_t size) {
+        if (ptr == nullptr)
+            return;
+        if (size != sizeof(T)) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        Pool& pool = GetPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.free_objects.push_back(ptr);
+    }
+
+private:
+    /// Number of objects allocated at once in each slab
+    static constexpr size_t OBJECTS_PER_SLAB = 64;
+
+    struct Pool {
+        void AllocateSlab() {
+            char* slab = static_cast<char*>(::operator new(sizeof(T) * OBJECTS_PER_SLAB));
+            // Hand out the slab from its start, so that consecutive allocations are adjacent
+            for (size_t i = OBJECTS_PER_SLAB; i-- > 0;)
+                free_objects.push_back(slab + i * sizeof(T));
+        }
+
+        std::mutex mutex;
+        std::vector<void*> free_objects;
+    };
+
+    static Pool& GetPool() {
+        // Never destroyed, as kernel objects held by other static objects may be freed after it
+        // would be during exit
+        static Pool* pool = new Pool;
+        return *pool;
+    }
+};
+
+} // namespace
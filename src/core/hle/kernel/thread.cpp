@@ -4,7 +4,9 @@
 
 #include <algorithm>
 #include <list>
+#include <unordered_map>
 #include <vector>
+#include <boost/range/algorithm_ext/erase.hpp>
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
@@ -47,6 +49,9 @@ static std::vector<SharedPtr<Thread>> thread_list;
 // Lists only ready thread ids.
 static Common::ThreadQueueList<Thread*, THREADPRIO_LOWEST + 1> ready_queue;
 
+// Threads in THREADSTATUS_WAIT_ARB, by the address they wait to be arbitrated on.
+static std::unordered_map<VAddr, std::vector<Thread*>> arbitration_waiters;
+
 static SharedPtr<Thread> current_thread;
 
 // The first available thread id at startup
@@ -68,18 +73,22 @@ Thread* GetCurrentThread() {
 }
 
 /**
- * Check if the specified thread is waiting on the specified address to be arbitrated
- * @param thread The thread to test
- * @param wait_address The address to test against
- * @return True if the thread is waiting, false otherwise
+ * Removes a thread that is leaving THREADSTATUS_WAIT_ARB from the waiters of its address
+ * @param thread The thread to remove
  */
-static bool CheckWait_AddressArbiter(const Thread* thread, VAddr wait_address) {
-    return thread->status == THREADSTATUS_WAIT_ARB && wait_address == thread->wait_address;
+static void RemoveArbitrationWaiter(Thread* thread) {
+    auto bucket = arbitration_waiters.find(thread->wait_address);
+    if (bucket == arbitration_waiters.end())
+        return;
+
+    boost::remove_erase(bucket->second, thread);
+    if (bucket->second.empty())
+        arbitration_waiters.erase(bucket);
 }
 
 void Thread::Stop() {
     // Cancel any outstanding wakeup events for this thread
-    CoreTiming::UnscheduleEvent(ThreadWakeupEventType, callback_handle);
+    CoreTiming::UnscheduleEvent(wakeup_event);
     wakeup_callback_handle_table.Close(callback_handle);
     callback_handle = 0;
 
@@ -87,6 +96,8 @@ void Thread::Stop() {
     // This is only needed when the thread is termintated forcefully (SVC TerminateProcess)
     if (status == THREADSTATUS_READY) {
         ready_queue.remove(current_priority, this);
+    } else if (status == THREADSTATUS_WAIT_ARB) {
+        RemoveArbitrationWaiter(this);
     }
 
     status = THREADSTATUS_DEAD;
@@ -109,38 +120,42 @@ void Thread::Stop() {
     Kernel::g_current_process->tls_slots[tls_page].reset(tls_slot);
 }
 
-Thread* ArbitrateHighestPriorityThread(u32 address) {
-    Thread* highest_priority_thread = nullptr;
-    s32 priority = THREADPRIO_LOWEST;
-
-    // Iterate through threads, find highest priority thread that is waiting to be arbitrated...
-    for (auto& thread : thread_list) {
-        if (!CheckWait_AddressArbiter(thread.get(), address))
-            continue;
-
-        if (thread == nullptr)
-            continue;
-
-        if (thread->current_priority <= priority) {
-            highest_priority_thread = thread.get();
-            priority = thread->current_priority;
-        }
-    }
+/**
+ * Orders threads waiting on the same address by the order they get arbitrated in: highest
+ * priority first and, among equals, the most recently created thread first.
+ */
+static bool ArbitratedBefore(const Thread* a, const Thread* b) {
+    if (a->current_priority != b->current_priority)
+        return a->current_priority < b->current_priority;
+    return a->thread_id > b->thread_id;
+}
 
-    // If a thread was arbitrated, resume it
-    if (nullptr != highest_priority_thread) {
-        highest_priority_thread->ResumeFromWait();
-    }
+void ArbitrateThreads(u32 address, size_t count) {
+    auto bucket = arbitration_waiters.find(address);
+    if (bucket == arbitration_waiters.end())
+        return;
 
-    return highest_priority_thread;
+    // Resuming a thread removes it from the bucket, so work on a copy
+    std::vector<Thread*> waiters = bucket->second;
+    count = std::min(count, waiters.size());
+    std::partial_sort(waiters.begin(), waiters.begin() + count, waiters.end(), ArbitratedBefore);
+    for (size_t i = 0; i < count; ++i)
+        waiters[i]->ResumeFromWait();
 }
 
 void ArbitrateAllThreads(u32 address) {
-    // Resume all threads found to be waiting on the address
-    for (auto& thread : thread_list) {
-        if (CheckWait_AddressArbiter(thread.get(), address))
-            thread->ResumeFromWait();
-    }
+    auto bucket = arbitration_waiters.find(address);
+    if (bucket == arbitration_waiters.end())
+        return;
+
+    std::vector<Thread*> waiters = std::move(bucket->second);
+    arbitration_waiters.erase(bucket);
+
+    // Resume all threads waiting on the address, in the order they were created
+    std::sort(waiters.begin(), waiters.end(),
+              [](const Thread* a, const Thread* b) { return a->thread_id < b->thread_id; });
+    for (Thread* thread : waiters)
+        thread->ResumeFromWait();
 }
 
 /**
@@ -169,7 +184,7 @@ static void SwitchContext(Thread* new_thread) {
                    "Thread must be ready to become running.");
 
         // Cancel any outstanding wakeup events for this thread
-        CoreTiming::UnscheduleEvent(ThreadWakeupEventType, new_thread->callback_handle);
+        CoreTiming::UnscheduleEvent(new_thread->wakeup_event);
 
         current_thread = new_thread;
 
@@ -215,6 +230,7 @@ void WaitCurrentThread_ArbitrateAddress(VAddr wait_address) {
     Thread* thread = GetCurrentThread();
     thread->wait_address = wait_address;
     thread->status = THREADSTATUS_WAIT_ARB;
+    arbitration_waiters[wait_address].push_back(thread);
 }
 
 void ExitCurrentThread() {
@@ -254,17 +270,35 @@ void Thread::WakeAfterDelay(s64 nanoseconds) {
     if (nanoseconds == -1)
         return;
 
+    // Replace any wakeup that is still pending, so the thread only ever has one
+    CoreTiming::UnscheduleEvent(wakeup_event);
+
     u64 microseconds = nanoseconds / 1000;
-    CoreTiming::ScheduleEvent(usToCycles(microseconds), ThreadWakeupEventType, callback_handle);
+    wakeup_event =
+        CoreTiming::ScheduleEvent(usToCycles(microseconds), ThreadWakeupEventType, callback_handle);
+}
+
+void Thread::WaitOnObjects(WaitObjectList objects, ThreadStatus new_status) {
+    status = new_status;
+
+    // Share one reference to the thread between all the objects
+    const SharedPtr<Thread> waiter(this);
+    for (auto& object : objects)
+        object->AddWaitingThread(waiter);
+
+    wait_objects = std::move(objects);
 }
 
 void Thread::ResumeFromWait() {
     ASSERT_MSG(wait_objects.empty(), "Thread is waking up while waiting for objects");
 
     switch (status) {
+    case THREADSTATUS_WAIT_ARB:
+        RemoveArbitrationWaiter(this);
+        break;
+
     case THREADSTATUS_WAIT_SYNCH_ALL:
     case THREADSTATUS_WAIT_SYNCH_ANY:
-    case THREADSTATUS_WAIT_ARB:
     case THREADSTATUS_WAIT_SLEEP:
         break;
 
@@ -376,7 +410,6 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
     SharedPtr<Thread> thread(new Thread);
 
     thread_list.push_back(thread);
-    ready_queue.prepare(priority);
 
     thread->thread_id = NewThreadId();
     thread->status = THREADSTATUS_DORMANT;
@@ -415,6 +448,7 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
         u32 offset = linheap_memory->size();
 
         // Allocate some memory from the end of the linear heap for this region.
+        const u8* old_data = linheap_memory->data();
         linheap_memory->insert(linheap_memory->end(), Memory::PAGE_SIZE, 0);
         memory_region->used += Memory::PAGE_SIZE;
         Kernel::g_current_process->linear_heap_used += Memory::PAGE_SIZE;
@@ -424,7 +458,8 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
         available_slot = 0; // Use the first slot in the new page
 
         auto& vm_manager = Kernel::g_current_process->vm_manager;
-        vm_manager.RefreshMemoryBlockMappings(linheap_memory.get());
+        if (linheap_memory->data() != old_data)
+            vm_manager.RefreshMemoryBlockMappings(linheap_memory.get());
 
         // Map the page to the current process' address space.
         // TODO(Subv): Find the correct MemoryState for this region.
@@ -453,8 +488,6 @@ void Thread::SetPriority(s32 priority) {
     // If thread was ready, adjust queues
     if (status == THREADSTATUS_READY)
         ready_queue.move(this, current_priority, priority);
-    else
-        ready_queue.prepare(priority);
 
     nominal_priority = current_priority = priority;
 }
@@ -472,8 +505,6 @@ void Thread::BoostPriority(s32 priority) {
     // If thread was ready, adjust queues
     if (status == THREADSTATUS_READY)
         ready_queue.move(this, current_priority, priority);
-    else
-        ready_queue.prepare(priority);
     current_priority = priority;
 }
 
@@ -528,6 +559,35 @@ s32 Thread::GetWaitObjectIndex(WaitObject* object) const {
     return std::distance(match, wait_objects.rend()) - 1;
 }
 
+ResultCode LookUpWaitObjects(WaitObjectList& objects, const Handle* handles, s32 handle_count,
+                             Thread* thread, bool wait_all, bool& ready, s32& ready_index) {
+    objects.clear();
+    objects.reserve(handle_count);
+
+    // Waiting for all of no objects is satisfied right away, waiting for any of them is not
+    ready = wait_all;
+    ready_index = -1;
+    bool decided = false;
+
+    for (s32 i = 0; i < handle_count; ++i) {
+        auto object = g_handle_table.Get<WaitObject>(handles[i]);
+        if (object == nullptr)
+            return ERR_INVALID_HANDLE;
+
+        // The first object that isn't ready decides a wait for all of them, and the first one
+        // that is ready a wait for any of them. The rest only have to be valid handles.
+        if (!decided && object->ShouldWait(thread) == wait_all) {
+            decided = true;
+            ready = !wait_all;
+            if (!wait_all)
+                ready_index = i;
+        }
+
+        objects.push_back(std::move(object));
+    }
+    return RESULT_SUCCESS;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void ThreadingInit() {
@@ -545,6 +605,7 @@ void ThreadingShutdown() {
     }
     thread_list.clear();
     ready_queue.clear();
+    arbitration_waiters.clear();
 }
 
 const std::vector<SharedPtr<Thread>>& GetThreadList() {
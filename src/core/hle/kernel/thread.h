@@ -11,7 +11,9 @@
 #include <boost/container/flat_set.hpp>
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
+#include "core/core_timing.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/slab_allocator.h"
 #include "core/hle/kernel/wait_object.h"
 #include "core/hle/result.h"
 
@@ -46,7 +48,7 @@ namespace Kernel {
 class Mutex;
 class Process;
 
-class Thread final : public WaitObject {
+class Thread final : public WaitObject, public SlabAllocated<Thread> {
 public:
     /**
      * Creates and returns a new thread. The new thread is immediately scheduled
@@ -121,6 +123,14 @@ public:
     */
     void WakeAfterDelay(s64 nanoseconds);
 
+    /**
+     * Puts the thread to sleep on the objects, registering it as a waiter of each of them. The
+     * thread keeps the list to unregister itself from the objects once it wakes up.
+     * @param objects Objects in the order they were passed to WaitSynchronization1/N
+     * @param new_status THREADSTATUS_WAIT_SYNCH_ANY or THREADSTATUS_WAIT_SYNCH_ALL
+     */
+    void WaitOnObjects(WaitObjectList objects, ThreadStatus new_status);
+
     /**
      * Sets the result after the thread awakens (from either WaitSynchronization SVC)
      * @param result Value to set to the returned result
@@ -193,7 +203,7 @@ public:
 
     /// Objects that the thread is waiting on, in the same order as they were
     // passed to WaitSynchronization1/N.
-    std::vector<SharedPtr<WaitObject>> wait_objects;
+    WaitObjectList wait_objects;
 
     VAddr wait_address; ///< If waiting on an AddressArbiter, this is the arbitration address
 
@@ -204,6 +214,8 @@ public:
 
     /// Handle used as userdata to reference this object when inserting into the CoreTiming queue.
     Handle callback_handle;
+    /// Pending wakeup event scheduled by WakeAfterDelay, stale once it fired or was cancelled
+    CoreTiming::EventHandle wakeup_event;
 
 private:
     Thread();
@@ -229,10 +241,11 @@ bool HaveReadyThreads();
 void Reschedule();
 
 /**
- * Arbitrate the highest priority thread that is waiting
+ * Arbitrate the highest priority threads that are waiting, in priority order
  * @param address The address for which waiting threads should be arbitrated
+ * @param count The maximum number of threads to arbitrate
  */
-Thread* ArbitrateHighestPriorityThread(u32 address);
+void ArbitrateThreads(u32 address, size_t count);
 
 /**
  * Arbitrate all threads currently waiting.
@@ -245,6 +258,20 @@ void ArbitrateAllThreads(u32 address);
  */
 Thread* GetCurrentThread();
 
+/**
+ * Looks up the objects behind the handles of a wait, checking in the same pass whether the wait
+ * is already satisfied. ShouldWait is only called on the objects up to the one that decides it.
+ * @param objects Filled with the objects, in the order of the handles
+ * @param thread Thread that is going to wait
+ * @param wait_all Whether the wait needs all of the objects to be ready, or any of them
+ * @param ready Set to whether the thread can acquire the objects without waiting
+ * @param ready_index Set to the index of the first ready object when waiting for any of them,
+ *     otherwise to -1
+ * @return ERR_INVALID_HANDLE if any of the handles isn't one of an object that can be waited on
+ */
+ResultCode LookUpWaitObjects(WaitObjectList& objects, const Handle* handles, s32 handle_count,
+                             Thread* thread, bool wait_all, bool& ready, s32& ready_index);
+
 /**
  * Waits the current thread on a sleep
  */
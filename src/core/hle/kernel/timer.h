@@ -6,11 +6,12 @@
 
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/slab_allocator.h"
 #include "core/hle/kernel/wait_object.h"
 
 namespace Kernel {
 
-class Timer final : public WaitObject {
+class Timer final : public WaitObject, public SlabAllocated<Timer> {
 public:
     /**
      * Creates a timer
@@ -50,6 +50,7 @@ VMManager::~VMManager() {
 
 void VMManager::Reset() {
     vma_map.clear();
+    last_found_vma = vma_map.end();
 
     // Initialize the map with a single free region covering the entire managed space.
     VirtualMemoryArea initial_vma;
@@ -62,9 +63,14 @@ void VMManager::Reset() {
 VMManager::VMAHandle VMManager::FindVMA(VAddr target) const {
     if (target >= MAX_ADDRESS) {
         return vma_map.end();
-    } else {
-        return std::prev(vma_map.upper_bound(target));
     }
+
+    // Targets below the cached VMA wrap around to a large offset, missing as well
+    if (last_found_vma == vma_map.end() ||
+        target - last_found_vma->second.base >= last_found_vma->second.size) {
+        last_found_vma = std::prev(vma_map.upper_bound(target));
+    }
+    return last_found_vma;
 }
 
 ResultVal<VMManager::VMAHandle> VMManager::MapMemoryBlock(VAddr target,
@@ -311,6 +317,7 @@ VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
     if (next_vma != vma_map.end() && iter->second.CanBeMergedWith(next_vma->second)) {
         iter->second.size += next_vma->second.size;
         vma_map.erase(next_vma);
+        last_found_vma = vma_map.end();
     }
 
     if (iter != vma_map.begin()) {
@@ -318,6 +325,7 @@ VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
         if (prev_vma->second.CanBeMergedWith(iter->second)) {
             prev_vma->second.size += iter->second.size;
             vma_map.erase(iter);
+            last_found_vma = vma_map.end();
             iter = prev_vma;
         }
     }
@@ -127,7 +127,10 @@ public:
     /// Clears the address space map, re-initializing with a single free area.
     void Reset();
 
-    /// Finds the VMA in which the given address is included in, or `vma_map.end()`.
+    /**
+     * Finds the VMA in which the given address is included in, or `vma_map.end()`. The VMA found
+     * last is checked first, as lookups of nearby addresses tend to follow each other.
+     */
     VMAHandle FindVMA(VAddr target) const;
 
     // TODO(yuriks): Should these functions actually return the handle?
@@ -219,5 +222,8 @@ private:
 
     /// Updates the pages corresponding to this VMA so they match the VMA's attributes.
     void UpdatePageTableForVMA(const VirtualMemoryArea& vma);
+
+    /// VMA returned by the last FindVMA, or `vma_map.end()` after VMAs have been erased.
+    mutable VMAHandle last_found_vma;
 };
 }
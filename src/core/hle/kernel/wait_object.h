@@ -5,6 +5,7 @@
 #pragma once
 
 #include <vector>
+#include <boost/container/small_vector.hpp>
 #include <boost/smart_ptr/intrusive_ptr.hpp>
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
@@ -55,6 +56,9 @@ private:
     std::vector<SharedPtr<Thread>> waiting_threads;
 };
 
+/// Objects a thread waits on. Waits on more objects than fit inline are rare.
+using WaitObjectList = boost::container::small_vector<SharedPtr<WaitObject>, 8>;
+
 // Specialization of DynamicObjectCast for WaitObjects
 template <>
 inline SharedPtr<WaitObject> DynamicObjectCast<WaitObject>(SharedPtr<Object> object) {
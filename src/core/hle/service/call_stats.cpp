@@ -0,0 +1,124 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include "core/hle/service/call_stats.h"
+
+namespace Service {
+namespace CallStats {
+
+/// Each octave of call durations in nanoseconds is split in this many histogram buckets
+constexpr unsigned BUCKETS_PER_OCTAVE = 4;
+constexpr unsigned NUM_BUCKETS = 64 * BUCKETS_PER_OCTAVE;
+
+struct Entry {
+    std::string service_name;
+    std::string function_name;
+    u32 header;
+
+    u64 call_count = 0;
+    u64 total_ns = 0;
+    std::array<u32, NUM_BUCKETS> histogram{};
+};
+
+static std::atomic<bool> enabled{false};
+// Guards the entries, which are recorded by the emulation thread and read by the frontend.
+static std::mutex entries_mutex;
+// A list, as entries must stay where they are once created.
+static std::list<Entry> entries;
+
+/// Returns the histogram bucket of a duration: its octave, refined by the two bits following the
+/// most significant one
+static unsigned GetBucket(u64 ns) {
+    if (ns < BUCKETS_PER_OCTAVE)
+        return static_cast<unsigned>(ns);
+    unsigned octave = 63;
+    while ((ns >> octave) == 0)
+        --octave;
+    const unsigned fraction = static_cast<unsigned>(ns >> (octave - 2)) & (BUCKETS_PER_OCTAVE - 1);
+    return octave * BUCKETS_PER_OCTAVE + fraction;
+}
+
+/// Returns the first duration past the durations that fall in a bucket
+static u64 GetBucketEnd(unsigned bucket) {
+    if (bucket < BUCKETS_PER_OCTAVE)
+        return bucket + 1;
+    const unsigned octave = bucket / BUCKETS_PER_OCTAVE;
+    const u64 fraction = bucket % BUCKETS_PER_OCTAVE;
+    return (BUCKETS_PER_OCTAVE + fraction + 1) << (octave - 2);
+}
+
+bool IsEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void SetEnabled(bool enable) {
+    enabled = enable;
+}
+
+Entry* GetEntry(const std::string& service_name, u32 header, const char* function_name) {
+    std::lock_guard<std::mutex> lock(entries_mutex);
+    for (Entry& entry : entries) {
+        if (entry.header == header && entry.service_name == service_name)
+            return &entry;
+    }
+
+    entries.emplace_back();
+    Entry& entry = entries.back();
+    entry.service_name = service_name;
+    entry.function_name = function_name;
+    entry.header = header;
+    return &entry;
+}
+
+void Record(Entry* entry, Clock::duration duration) {
+    const u64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+
+    std::lock_guard<std::mutex> lock(entries_mutex);
+    ++entry->call_count;
+    entry->total_ns += ns;
+    ++entry->histogram[GetBucket(ns)];
+}
+
+std::vector<Summary> GetSummaries() {
+    std::vector<Summary> summaries;
+
+    std::lock_guard<std::mutex> lock(entries_mutex);
+    for (const Entry& entry : entries) {
+        if (entry.call_count == 0)
+            continue;
+
+        // The bucket holding the call at the 99th percentile of the sorted durations
+        const u64 p99_index = (entry.call_count * 99 + 99) / 100 - 1;
+        u64 calls_seen = 0;
+        unsigned p99_bucket = 0;
+        for (unsigned bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+            calls_seen += entry.histogram[bucket];
+            if (calls_seen > p99_index) {
+                p99_bucket = bucket;
+                break;
+            }
+        }
+
+        summaries.push_back({entry.service_name, entry.function_name, entry.header,
+                             entry.call_count, std::chrono::nanoseconds(entry.total_ns),
+                             std::chrono::nanoseconds(GetBucketEnd(p99_bucket))});
+    }
+    return summaries;
+}
+
+void Reset() {
+    std::lock_guard<std::mutex> lock(entries_mutex);
+    for (Entry& entry : entries) {
+        entry.call_count = 0;
+        entry.total_ns = 0;
+        entry.histogram.fill(0);
+    }
+}
+
+} // namespace CallStats
+} // namespace Service
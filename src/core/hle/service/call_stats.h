@@ -0,0 +1,73 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * Statistics of the HLE service calls made by the emulated application: how often each command
+ * of each service is called and how much host time its handler takes. Only collected while
+ * enabled, as timing every call has a cost of its own.
+ */
+namespace Service {
+namespace CallStats {
+
+using Clock = std::chrono::steady_clock;
+
+/// Statistics of one command of one service, opaque outside of call_stats.cpp
+struct Entry;
+
+/// Snapshot of the statistics of one command
+struct Summary {
+    std::string service_name;
+    std::string function_name;
+    u32 header;
+    u64 call_count;
+    std::chrono::nanoseconds total_time;
+    /// Upper bound of the time taken by 99% of the calls, precise to a quarter octave
+    std::chrono::nanoseconds p99_time;
+};
+
+bool IsEnabled();
+void SetEnabled(bool enabled);
+
+/**
+ * Returns the statistics of a command, creating them the first time they are asked for.
+ * Entries are never freed, so the returned pointer can be cached by the caller.
+ */
+Entry* GetEntry(const std::string& service_name, u32 header, const char* function_name);
+
+/// Records a call of the given duration to the command of the entry
+void Record(Entry* entry, Clock::duration duration);
+
+/// Returns the statistics of every command called since the last reset
+std::vector<Summary> GetSummaries();
+
+/// Clears the statistics of every command
+void Reset();
+
+/// Records the duration of a call from its construction to its destruction, unless entry is null
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Entry* entry) : entry(entry) {
+        if (entry != nullptr)
+            start = Clock::now();
+    }
+
+    ~ScopedTimer() {
+        if (entry != nullptr)
+            Record(entry, Clock::now() - start);
+    }
+
+private:
+    Entry* entry;
+    Clock::time_point start;
+};
+
+} // namespace CallStats
+} // namespace Service
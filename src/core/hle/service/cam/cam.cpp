@@ -4,8 +4,11 @@
 
 #include <algorithm>
 #include <array>
-#include <future>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
 #include <vector>
 #include "common/bit_set.h"
 #include "common/logging/log.h"
@@ -43,6 +46,155 @@ struct CameraConfig {
     FrameRate frame_rate;
 };
 
+/// Parameters that decide which part of a received frame is written to the destination
+struct TransferParams {
+    bool is_trimming;
+    u16 x0, y0, x1, y1;
+    int original_width;
+    int original_height;
+    u32 dest_size;
+
+    bool operator==(const TransferParams& other) const {
+        return std::tie(is_trimming, x0, y0, x1, y1, original_width, original_height, dest_size) ==
+               std::tie(other.is_trimming, other.x0, other.y0, other.x1, other.y1,
+                        other.original_width, other.original_height, other.dest_size);
+    }
+    bool operator!=(const TransferParams& other) const {
+        return !(*this == other);
+    }
+};
+
+/// Copies the trimmed area of `frame` into `output`, laid out as it is written to the destination.
+void TrimFrame(const std::vector<u16>& frame, const TransferParams& params,
+               std::vector<u8>& output) {
+    output.clear();
+
+    u32 trim_width;
+    u32 trim_height;
+    if (params.x1 <= params.x0 || params.y1 <= params.y0 || params.x1 > params.original_width ||
+        params.y1 > params.original_height) {
+        LOG_ERROR(Service_CAM, "Invalid trimming coordinates x0=%u, y0=%u, x1=%u, y1=%u",
+                  params.x0, params.y0, params.x1, params.y1);
+        trim_width = 0;
+        trim_height = 0;
+    } else {
+        trim_width = params.x1 - params.x0;
+        trim_height = params.y1 - params.y0;
+    }
+
+    u32 trim_size = (params.x1 - params.x0) * (params.y1 - params.y0) * 2;
+    if (params.dest_size != trim_size) {
+        LOG_ERROR(Service_CAM, "The destination size (%u) doesn't match the source (%u)!",
+                  params.dest_size, trim_size);
+    }
+
+    const u32 src_offset = params.y0 * params.original_width + params.x0;
+    const u8* src_ptr = reinterpret_cast<const u8*>(frame.data() + src_offset);
+    // Note: src_size_left is int because it can be negative if the buffer size doesn't match.
+    int src_size_left = static_cast<int>((frame.size() - src_offset) * sizeof(u16));
+    // Note: dest_size_left and line_bytes are int to match the type of src_size_left.
+    int dest_size_left = static_cast<int>(params.dest_size);
+    const int line_bytes = static_cast<int>(trim_width * sizeof(u16));
+
+    for (u32 y = 0; y < trim_height; ++y) {
+        int copy_length = std::min({line_bytes, dest_size_left, src_size_left});
+        if (copy_length <= 0) {
+            break;
+        }
+        output.insert(output.end(), src_ptr, src_ptr + copy_length);
+        dest_size_left -= copy_length;
+        src_ptr += params.original_width * sizeof(u16);
+        src_size_left -= params.original_width * sizeof(u16);
+    }
+}
+
+/// A frame received by a CaptureThread, along with the parameters it was prepared for
+struct CapturedFrame {
+    TransferParams params;
+    std::vector<u16> frame;
+    /// The trimmed frame, if params.is_trimming is set
+    std::vector<u8> trimmed;
+};
+
+/**
+ * Receives and trims frames of a port on a thread of its own, so that completing a receiving
+ * process only copies the ready frame to guest memory. The frames are double buffered: the thread
+ * fills one while the emulation thread copies from the other.
+ */
+class CaptureThread {
+public:
+    CaptureThread() : thread(&CaptureThread::ThreadLoop, this) {}
+
+    ~CaptureThread() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        request_ready.notify_one();
+        thread.join();
+    }
+
+    /// Starts receiving a frame from `camera`. Any frame requested before must have been waited on.
+    void Request(const Camera::CameraInterface* camera, const TransferParams& params) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requested_camera = camera;
+            frames[back].params = params;
+            is_pending = true;
+        }
+        request_ready.notify_one();
+    }
+
+    /// Waits for the requested frame. It stays valid until the next frame is waited on.
+    const CapturedFrame& Wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        frame_ready.wait(lock, [this] { return !is_pending; });
+        return frames[front];
+    }
+
+private:
+    void ThreadLoop() {
+        while (true) {
+            const Camera::CameraInterface* camera;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                request_ready.wait(lock, [this] { return stop || requested_camera != nullptr; });
+                if (stop)
+                    return;
+                camera = requested_camera;
+                requested_camera = nullptr;
+            }
+
+            // The back frame belongs to this thread until it is marked ready
+            CapturedFrame& frame = frames[back];
+            frame.frame = camera->ReceiveFrame();
+            if (frame.params.is_trimming) {
+                TrimFrame(frame.frame, frame.params, frame.trimmed);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                std::swap(front, back);
+                is_pending = false;
+            }
+            frame_ready.notify_one();
+        }
+    }
+
+    std::array<CapturedFrame, 2> frames;
+    size_t front = 0;
+    size_t back = 1;
+
+    std::mutex mutex;
+    std::condition_variable request_ready;
+    std::condition_variable frame_ready;
+    const Camera::CameraInterface* requested_camera = nullptr;
+    bool is_pending = false;
+    bool stop = false;
+
+    std::thread thread;
+};
+
 struct PortConfig {
     int camera_id;
 
@@ -65,9 +217,9 @@ struct PortConfig {
     Kernel::SharedPtr<Kernel::Event> buffer_error_interrupt_event;
     Kernel::SharedPtr<Kernel::Event> vsync_interrupt_event;
 
-    std::future<std::vector<u16>> capture_result; // will hold the received frame.
-    VAddr dest;                                   // the destination address of a receiving process
-    u32 dest_size;                                // the destination size of a receiving process
+    std::unique_ptr<CaptureThread> capture_thread; // receives the frames.
+    VAddr dest;                                    // the destination address of a receiving process
+    u32 dest_size;                                 // the destination size of a receiving process
 
     void Clear() {
         completion_event->Clear();
@@ -124,54 +276,37 @@ const ResultCode ERROR_INVALID_ENUM_VALUE(ErrorDescription::InvalidEnumValue, Er
 const ResultCode ERROR_OUT_OF_RANGE(ErrorDescription::OutOfRange, ErrorModule::CAM,
                                     ErrorSummary::InvalidArgument, ErrorLevel::Usage);
 
-void CompletionEventCallBack(u64 port_id, int) {
-    PortConfig& port = ports[port_id];
+TransferParams GetTransferParams(const PortConfig& port) {
     const CameraConfig& camera = cameras[port.camera_id];
-    const auto buffer = port.capture_result.get();
-
-    if (port.is_trimming) {
-        u32 trim_width;
-        u32 trim_height;
-        const int original_width = camera.contexts[camera.current_context].resolution.width;
-        const int original_height = camera.contexts[camera.current_context].resolution.height;
-        if (port.x1 <= port.x0 || port.y1 <= port.y0 || port.x1 > original_width ||
-            port.y1 > original_height) {
-            LOG_ERROR(Service_CAM, "Invalid trimming coordinates x0=%u, y0=%u, x1=%u, y1=%u",
-                      port.x0, port.y0, port.x1, port.y1);
-            trim_width = 0;
-            trim_height = 0;
-        } else {
-            trim_width = port.x1 - port.x0;
-            trim_height = port.y1 - port.y0;
-        }
+    const Resolution& resolution = camera.contexts[camera.current_context].resolution;
+    TransferParams params;
+    params.is_trimming = port.is_trimming;
+    params.x0 = port.x0;
+    params.y0 = port.y0;
+    params.x1 = port.x1;
+    params.y1 = port.y1;
+    params.original_width = resolution.width;
+    params.original_height = resolution.height;
+    params.dest_size = port.dest_size;
+    return params;
+}
 
-        u32 trim_size = (port.x1 - port.x0) * (port.y1 - port.y0) * 2;
-        if (port.dest_size != trim_size) {
-            LOG_ERROR(Service_CAM, "The destination size (%u) doesn't match the source (%u)!",
-                      port.dest_size, trim_size);
-        }
+void CompletionEventCallBack(u64 port_id, int) {
+    PortConfig& port = ports[port_id];
+    const CapturedFrame& captured = port.capture_thread->Wait();
+    const TransferParams params = GetTransferParams(port);
 
-        const u32 src_offset = port.y0 * original_width + port.x0;
-        const u16* src_ptr = buffer.data() + src_offset;
-        // Note: src_size_left is int because it can be negative if the buffer size doesn't match.
-        int src_size_left = static_cast<int>((buffer.size() - src_offset) * sizeof(u16));
-        VAddr dest_ptr = port.dest;
-        // Note: dest_size_left and line_bytes are int to match the type of src_size_left.
-        int dest_size_left = static_cast<int>(port.dest_size);
-        const int line_bytes = static_cast<int>(trim_width * sizeof(u16));
-
-        for (u32 y = 0; y < trim_height; ++y) {
-            int copy_length = std::min({line_bytes, dest_size_left, src_size_left});
-            if (copy_length <= 0) {
-                break;
-            }
-            Memory::WriteBlock(dest_ptr, src_ptr, copy_length);
-            dest_ptr += copy_length;
-            dest_size_left -= copy_length;
-            src_ptr += original_width;
-            src_size_left -= original_width * sizeof(u16);
+    if (params.is_trimming) {
+        if (captured.params == params) {
+            Memory::WriteBlock(port.dest, captured.trimmed.data(), captured.trimmed.size());
+        } else {
+            // The trimming changed while the frame was being received
+            std::vector<u8> trimmed;
+            TrimFrame(captured.frame, params, trimmed);
+            Memory::WriteBlock(port.dest, trimmed.data(), trimmed.size());
         }
     } else {
+        const std::vector<u16>& buffer = captured.frame;
         std::size_t buffer_size = buffer.size() * sizeof(u16);
         if (port.dest_size != buffer_size) {
             LOG_ERROR(Service_CAM, "The destination size (%u) doesn't match the source (%zu)!",
@@ -190,10 +325,9 @@ void StartReceiving(int port_id) {
     PortConfig& port = ports[port_id];
     port.is_receiving = true;
 
-    // launches a capture task asynchronously
+    // launches a capture task on the capture thread of the port
     const CameraConfig& camera = cameras[port.camera_id];
-    port.capture_result =
-        std::async(std::launch::async, &Camera::CameraInterface::ReceiveFrame, camera.impl.get());
+    port.capture_thread->Request(camera.impl.get(), GetTransferParams(port));
 
     // schedules a completion event according to the frame rate. The event will block on the
     // capture task if it is not finished within the expected time
@@ -211,7 +345,7 @@ void CancelReceiving(int port_id) {
         return;
     LOG_WARNING(Service_CAM, "tries to cancel an ongoing receiving process.");
     CoreTiming::UnscheduleEvent(completion_event_callback, port_id);
-    ports[port_id].capture_result.wait();
+    ports[port_id].capture_thread->Wait();
     ports[port_id].is_receiving = false;
 }
 
@@ -1083,6 +1217,7 @@ void Init() {
             Event::Create(ResetType::OneShot, "CAM_U::buffer_error_interrupt_event");
         port.vsync_interrupt_event =
             Event::Create(ResetType::OneShot, "CAM_U::vsync_interrupt_event");
+        port.capture_thread = std::make_unique<CaptureThread>();
     }
     completion_event_callback =
         CoreTiming::RegisterEvent("CAM_U::CompletionEventCallBack", CompletionEventCallBack);
@@ -1095,6 +1230,7 @@ void Shutdown() {
         port.completion_event = nullptr;
         port.buffer_error_interrupt_event = nullptr;
         port.vsync_interrupt_event = nullptr;
+        port.capture_thread = nullptr;
     }
     for (CameraConfig& camera : cameras) {
         camera.impl = nullptr;
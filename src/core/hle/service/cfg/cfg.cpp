@@ -4,12 +4,14 @@
 
 #include <algorithm>
 #include <array>
+#include <unordered_map>
 #include <cryptopp/osrng.h>
 #include <cryptopp/sha.h>
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
 #include "common/swap.h"
+#include "core/core_timing.h"
 #include "core/file_sys/archive_systemsavedata.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/file_backend.h"
@@ -115,6 +117,13 @@ static_assert(sizeof(STEREO_CAMERA_SETTINGS) == 0x20,
 
 static const u32 CONFIG_SAVEFILE_SIZE = 0x8000;
 static std::array<u8, CONFIG_SAVEFILE_SIZE> cfg_config_file_buffer;
+/// Index of the entry of each block in the config savefile, by block ID
+static std::unordered_map<u32, u16> cfg_block_index;
+
+/// Delay before a save requested by an application is written, which further requests join
+static const u64 CONFIG_SAVE_DELAY_US = 500000;
+static int config_save_event_type;
+static bool config_save_pending = false;
 
 static Service::FS::ArchiveHandle cfg_system_save_data_archive;
 static const std::vector<u8> cfg_system_savedata_id = {
@@ -294,9 +303,19 @@ void SetConfigInfoBlk4(Service::Interface* self) {
     cmd_buff[1] = Service::CFG::SetConfigInfoBlock(block_id, size, 0x4, data.data()).raw;
 }
 
+static void ConfigSaveCallback(u64 userdata, int cycles_late) {
+    config_save_pending = false;
+    Service::CFG::UpdateConfigNANDSavegame();
+}
+
 void UpdateConfigNANDSavegame(Service::Interface* self) {
     u32* cmd_buff = Kernel::GetCommandBuffer();
-    cmd_buff[1] = Service::CFG::UpdateConfigNANDSavegame().raw;
+    // Some applications save after every change, so the file is only written once they are done
+    if (!config_save_pending) {
+        CoreTiming::ScheduleEvent(usToCycles(CONFIG_SAVE_DELAY_US), config_save_event_type);
+        config_save_pending = true;
+    }
+    cmd_buff[1] = RESULT_SUCCESS.raw;
 }
 
 void FormatConfig(Service::Interface* self) {
@@ -304,29 +323,40 @@ void FormatConfig(Service::Interface* self) {
     cmd_buff[1] = Service::CFG::FormatConfig().raw;
 }
 
+/// Indexes the entries of the config savefile after it was loaded or formatted
+static void RebuildBlockIndex() {
+    const SaveFileConfig* config =
+        reinterpret_cast<const SaveFileConfig*>(cfg_config_file_buffer.data());
+    const u16 total_entries = std::min<u16>(config->total_entries, CONFIG_FILE_MAX_BLOCK_ENTRIES);
+
+    cfg_block_index.clear();
+    for (u16 i = 0; i < total_entries; ++i) {
+        // Like a search from the start, the first entry of a block wins
+        cfg_block_index.emplace(config->block_entries[i].block_id, i);
+    }
+}
+
 static ResultVal<void*> GetConfigInfoBlockPointer(u32 block_id, u32 size, u32 flag) {
     // Read the header
     SaveFileConfig* config = reinterpret_cast<SaveFileConfig*>(cfg_config_file_buffer.data());
 
-    auto itr =
-        std::find_if(std::begin(config->block_entries), std::end(config->block_entries),
-                     [&](const SaveConfigBlockEntry& entry) { return entry.block_id == block_id; });
-
-    if (itr == std::end(config->block_entries)) {
+    const auto index = cfg_block_index.find(block_id);
+    if (index == cfg_block_index.end()) {
         LOG_ERROR(Service_CFG, "Config block 0x%X with flags %u and size %u was not found",
                   block_id, flag, size);
         return ResultCode(ErrorDescription::NotFound, ErrorModule::Config,
                           ErrorSummary::WrongArgument, ErrorLevel::Permanent);
     }
+    SaveConfigBlockEntry* entry = &config->block_entries[index->second];
 
-    if ((itr->flags & flag) == 0) {
+    if ((entry->flags & flag) == 0) {
         LOG_ERROR(Service_CFG, "Invalid flag %u for config block 0x%X with size %u", flag, block_id,
                   size);
         return ResultCode(ErrorDescription::NotAuthorized, ErrorModule::Config,
                           ErrorSummary::WrongArgument, ErrorLevel::Permanent);
     }
 
-    if (itr->size != size) {
+    if (entry->size != size) {
         LOG_ERROR(Service_CFG, "Invalid size %u for config block 0x%X with flags %u", size,
                   block_id, flag);
         return ResultCode(ErrorDescription::InvalidSize, ErrorModule::Config,
@@ -336,10 +366,10 @@ static ResultVal<void*> GetConfigInfoBlockPointer(u32 block_id, u32 size, u32 fl
     void* pointer;
 
     // The data is located in the block header itself if the size is less than 4 bytes
-    if (itr->size <= 4)
-        pointer = &itr->offset_or_data;
+    if (entry->size <= 4)
+        pointer = &entry->offset_or_data;
     else
-        pointer = &cfg_config_file_buffer[itr->offset_or_data];
+        pointer = &cfg_config_file_buffer[entry->offset_or_data];
 
     return MakeResult<void*>(pointer);
 }
@@ -387,6 +417,7 @@ ResultCode CreateConfigInfoBlk(u32 block_id, u16 size, u16 flags, const void* da
         memcpy(&config->block_entries[config->total_entries].offset_or_data, data, size);
     }
 
+    cfg_block_index.emplace(block_id, config->total_entries);
     ++config->total_entries;
     return RESULT_SUCCESS;
 }
@@ -420,6 +451,7 @@ ResultCode FormatConfig() {
     }
     // Delete the old data
     cfg_config_file_buffer.fill(0);
+    cfg_block_index.clear();
     // Create the header
     SaveFileConfig* config = reinterpret_cast<SaveFileConfig*>(cfg_config_file_buffer.data());
     // This value is hardcoded, taken from 3dbrew, verified by hardware, it's always the same value
@@ -562,6 +594,7 @@ ResultCode LoadConfigNANDSaveFile() {
     if (config_result.Succeeded()) {
         auto config = std::move(config_result).Unwrap();
         config->backend->Read(0, CONFIG_SAVEFILE_SIZE, cfg_config_file_buffer.data());
+        RebuildBlockIndex();
         return RESULT_SUCCESS;
     }
 
@@ -577,9 +610,19 @@ void Init() {
     LoadConfigNANDSaveFile();
 
     preferred_region_code = 0;
+
+    config_save_event_type = CoreTiming::RegisterEvent("CFG::ConfigSave", ConfigSaveCallback);
+    config_save_pending = false;
 }
 
-void Shutdown() {}
+void Shutdown() {
+    // Write a save that is still waiting
+    if (config_save_pending) {
+        CoreTiming::UnscheduleEvent(config_save_event_type, 0);
+        config_save_pending = false;
+        UpdateConfigNANDSavegame();
+    }
+}
 
 /// Checks if the language is available in the chosen region, and returns a proper one
 static SystemLanguage AdjustLanguageInfoBlock(u32 region, SystemLanguage language) {
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <array>
 #include <cinttypes>
+#include <vector>
 #include "audio_core/hle/pipe.h"
 #include "common/assert.h"
 #include "common/hash.h"
@@ -302,30 +303,31 @@ static void WriteProcessPipe(Service::Interface* self) {
     ASSERT_MSG(Memory::IsValidVirtualAddress(buffer),
                "Invalid Buffer: pipe=%u, size=0x%X, buffer=0x%08X", pipe, size, buffer);
 
-    std::vector<u8> message(size);
-    for (u32 i = 0; i < size; i++) {
-        message[i] = Memory::Read8(buffer + i);
+    // The message is parsed where it is in guest memory, unless it straddles pages that aren't
+    // contiguous on the host
+    const u8* message = Memory::GetContiguousPointer(buffer, size);
+    std::vector<u8> message_copy;
+    if (message == nullptr) {
+        message_copy.resize(size);
+        Memory::ReadBlock(buffer, message_copy.data(), size);
+        message = message_copy.data();
     }
 
-    // This behaviour was confirmed by RE.
-    // The likely reason for this is that games tend to pass in garbage at these bytes
-    // because they read random bytes off the stack.
+    // The DSP module overwrites some bytes of these messages, which was confirmed by RE: bytes 2
+    // and 3 of audio messages with 0, and bytes 4 to 7 of binary messages with 1. The likely
+    // reason for this is that games tend to pass in garbage at these bytes because they read
+    // random bytes off the stack. The pipes don't read those bytes, so the guest's copy is left
+    // as it is.
     switch (pipe) {
     case DSP::HLE::DspPipe::Audio:
-        ASSERT(message.size() >= 4);
-        message[2] = 0;
-        message[3] = 0;
+        ASSERT(size >= 4);
         break;
     case DSP::HLE::DspPipe::Binary:
-        ASSERT(message.size() >= 8);
-        message[4] = 1;
-        message[5] = 0;
-        message[6] = 0;
-        message[7] = 0;
+        ASSERT(size >= 8);
         break;
     }
 
-    DSP::HLE::PipeWrite(pipe, message);
+    DSP::HLE::PipeWrite(pipe, message, size);
 
     cmd_buff[0] = IPC::MakeHeader(0xD, 1, 0);
     cmd_buff[1] = RESULT_SUCCESS.raw; // No error
@@ -333,6 +335,18 @@ static void WriteProcessPipe(Service::Interface* self) {
     LOG_DEBUG(Service_DSP, "pipe=%u, size=0x%X, buffer=0x%08X", pipe_index, size, buffer);
 }
 
+/// Reads from the pipe into guest memory, directly unless the buffer straddles pages that aren't
+/// contiguous on the host. Returns the number of bytes read.
+static size_t ReadPipeToMemory(DSP::HLE::DspPipe pipe, VAddr addr, u32 size) {
+    if (u8* dest = Memory::GetContiguousPointer(addr, size))
+        return DSP::HLE::PipeRead(pipe, dest, size);
+
+    std::vector<u8> response(size);
+    const size_t read_size = DSP::HLE::PipeRead(pipe, response.data(), size);
+    Memory::WriteBlock(addr, response.data(), read_size);
+    return read_size;
+}
+
 /**
  * DSP_DSP::ReadPipeIfPossible service function
  *      A pipe is a means of communication between the ARM11 and DSP that occurs on
@@ -364,11 +378,7 @@ static void ReadPipeIfPossible(Service::Interface* self) {
     cmd_buff[0] = IPC::MakeHeader(0x10, 1, 2);
     cmd_buff[1] = RESULT_SUCCESS.raw; // No error
     if (DSP::HLE::GetPipeReadableSize(pipe) >= size) {
-        std::vector<u8> response = DSP::HLE::PipeRead(pipe, size);
-
-        Memory::WriteBlock(addr, response.data(), response.size());
-
-        cmd_buff[2] = static_cast<u32>(response.size());
+        cmd_buff[2] = static_cast<u32>(ReadPipeToMemory(pipe, addr, size));
     } else {
         cmd_buff[2] = 0; // Return no data
     }
@@ -406,13 +416,11 @@ static void ReadPipe(Service::Interface* self) {
                size, addr);
 
     if (DSP::HLE::GetPipeReadableSize(pipe) >= size) {
-        std::vector<u8> response = DSP::HLE::PipeRead(pipe, size);
-
-        Memory::WriteBlock(addr, response.data(), response.size());
+        const size_t read_size = ReadPipeToMemory(pipe, addr, size);
 
         cmd_buff[0] = IPC::MakeHeader(0xE, 2, 2);
         cmd_buff[1] = RESULT_SUCCESS.raw; // No error
-        cmd_buff[2] = static_cast<u32>(response.size());
+        cmd_buff[2] = static_cast<u32>(read_size);
         cmd_buff[3] = IPC::StaticBufferDesc(size, 0);
         cmd_buff[4] = addr;
     } else {
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cinttypes>
 #include <cstddef>
 #include <memory>
 #include <system_error>
@@ -31,6 +32,7 @@
 #include "core/hle/kernel/server_session.h"
 #include "core/hle/result.h"
 #include "core/hle/service/fs/archive.h"
+#include "core/hle/service/fs/async_read.h"
 #include "core/hle/service/fs/fs_user.h"
 #include "core/hle/service/service.h"
 #include "core/memory.h"
@@ -100,8 +102,8 @@ void File::HandleSyncRequest(Kernel::SharedPtr<Kernel::ServerSession> server_ses
         u64 offset = cmd_buff[1] | ((u64)cmd_buff[2]) << 32;
         u32 length = cmd_buff[3];
         u32 address = cmd_buff[5];
-        LOG_TRACE(Service_FS, "Read %s: offset=0x%llx length=%d address=0x%x", GetName().c_str(),
-                  offset, length, address);
+        LOG_TRACE(Service_FS, "Read %s: offset=0x%" PRIx64 " length=%d address=0x%x",
+                  GetName().c_str(), offset, length, address);
 
         if (offset + length > backend->GetSize()) {
             LOG_ERROR(Service_FS,
@@ -109,6 +111,12 @@ void File::HandleSyncRequest(Kernel::SharedPtr<Kernel::ServerSession> server_ses
                       offset, length, backend->GetSize());
         }
 
+        if (ShouldReadAsync(length)) {
+            // The reply is written once the read is done
+            ReadAsync(std::static_pointer_cast<File>(shared_from_this()), offset, length, address);
+            return;
+        }
+
         std::vector<u8> data(length);
         ResultVal<size_t> read = backend->Read(offset, data.size(), data.data());
         if (read.Failed()) {
@@ -126,7 +134,7 @@ void File::HandleSyncRequest(Kernel::SharedPtr<Kernel::ServerSession> server_ses
         u32 length = cmd_buff[3];
         u32 flush = cmd_buff[4];
         u32 address = cmd_buff[6];
-        LOG_TRACE(Service_FS, "Write %s: offset=0x%llx length=%d address=0x%x, flush=0x%x",
+        LOG_TRACE(Service_FS, "Write %s: offset=0x%" PRIx64 " length=%d address=0x%x, flush=0x%x",
                   GetName().c_str(), offset, length, address, flush);
 
         std::vector<u8> data(length);
@@ -150,13 +158,14 @@ void File::HandleSyncRequest(Kernel::SharedPtr<Kernel::ServerSession> server_ses
 
     case FileCommand::SetSize: {
         u64 size = cmd_buff[1] | ((u64)cmd_buff[2] << 32);
-        LOG_TRACE(Service_FS, "SetSize %s size=%llu", GetName().c_str(), size);
+        LOG_TRACE(Service_FS, "SetSize %s size=%" PRIu64, GetName().c_str(), size);
         backend->SetSize(size);
         break;
     }
 
     case FileCommand::Close: {
         LOG_TRACE(Service_FS, "Close %s", GetName().c_str());
+        WaitForAsyncReads(this);
         backend->Close();
         break;
     }
@@ -261,7 +270,8 @@ static ArchiveBackend* GetArchive(ArchiveHandle handle) {
 }
 
 ResultVal<ArchiveHandle> OpenArchive(ArchiveIdCode id_code, FileSys::Path& archive_path) {
-    LOG_TRACE(Service_FS, "Opening archive with id code 0x%08X", id_code);
+    LOG_TRACE(Service_FS, "Opening archive with id code 0x%08X",
+              static_cast<u32>(id_code));
 
     auto itr = id_code_map.find(id_code);
     if (itr == id_code_map.end()) {
@@ -296,7 +306,7 @@ ResultCode RegisterArchiveType(std::unique_ptr<FileSys::ArchiveFactory>&& factor
 
     auto& archive = result.first->second;
     LOG_DEBUG(Service_FS, "Registered archive %s with id code 0x%08X", archive->GetName().c_str(),
-              id_code);
+              static_cast<u32>(id_code));
     return RESULT_SUCCESS;
 }
 
@@ -577,10 +587,12 @@ void ArchiveInit() {
     AddService(new FS::Interface);
 
     RegisterArchiveTypes();
+    AsyncReadInit();
 }
 
 /// Shutdown archives
 void ArchiveShutdown() {
+    AsyncReadShutdown();
     handle_map.clear();
     UnregisterArchiveTypes();
 }
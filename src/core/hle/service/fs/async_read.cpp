@@ -0,0 +1,190 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common/logging/log.h"
+#include "core/core_timing.h"
+#include "core/file_sys/file_backend.h"
+#include "core/hle/ipc.h"
+#include "core/hle/kernel/thread.h"
+#include "core/hle/result.h"
+#include "core/hle/service/fs/archive.h"
+#include "core/hle/service/fs/async_read.h"
+#include "core/memory.h"
+#include "core/settings.h"
+
+namespace Service {
+namespace FS {
+
+/// Number of host threads the reads are done on
+constexpr size_t NUM_IO_WORKERS = 2;
+
+struct ReadRequest {
+    u64 id;
+    std::shared_ptr<File> file;
+    /// Guest thread sleeping until the read is done
+    Kernel::SharedPtr<Kernel::Thread> thread;
+    u64 offset;
+    VAddr address;
+    /// Whether the completion event was scheduled with a fixed latency, rather than by the worker
+    bool deterministic;
+
+    std::vector<u8> data;
+    ResultCode result = RESULT_SUCCESS;
+    size_t bytes_read = 0;
+    /// Set by the worker once the read is done, guarded by queue_mutex
+    bool done = false;
+};
+
+static std::mutex queue_mutex;
+static std::condition_variable work_available;
+static std::condition_variable request_done;
+static std::deque<std::shared_ptr<ReadRequest>> request_queue;
+static std::vector<std::thread> workers;
+static bool stop_workers = false;
+
+// Requests submitted and not completed yet, by id. Only used on the emulation thread.
+static std::unordered_map<u64, std::shared_ptr<ReadRequest>> pending_requests;
+static u64 next_request_id = 0;
+static int completion_event_type = -1;
+
+/**
+ * Emulated time taken by a read with deterministic FS reads enabled: a fixed access time, plus
+ * the transfer at roughly the speed of a game card
+ */
+static s64 GetReadLatency(size_t length) {
+    constexpr s64 ACCESS_TIME_US = 100;
+    constexpr s64 BYTES_PER_SECOND = 16 * 1024 * 1024;
+    return usToCycles(ACCESS_TIME_US) +
+           static_cast<s64>(length) * BASE_CLOCK_RATE_ARM11 / BYTES_PER_SECOND;
+}
+
+static void WorkerLoop() {
+    while (true) {
+        std::shared_ptr<ReadRequest> request;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            work_available.wait(lock, [] { return stop_workers || !request_queue.empty(); });
+            if (request_queue.empty())
+                return;
+            request = std::move(request_queue.front());
+            request_queue.pop_front();
+        }
+
+        ResultVal<size_t> read =
+            request->file->backend->Read(request->offset, request->data.size(),
+                                         request->data.data());
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (read.Failed())
+                request->result = read.Code();
+            else
+                request->bytes_read = *read;
+            request->done = true;
+        }
+        request_done.notify_all();
+
+        if (!request->deterministic)
+            CoreTiming::ScheduleEvent_Threadsafe(0, completion_event_type, request->id);
+    }
+}
+
+/// Hands the result of a read to the guest thread that requested it, and wakes it up
+static void CompleteRead(u64 request_id, int cycles_late) {
+    auto it = pending_requests.find(request_id);
+    if (it == pending_requests.end())
+        return;
+    std::shared_ptr<ReadRequest> request = std::move(it->second);
+    pending_requests.erase(it);
+
+    {
+        // The emulated latency may be over before the host is done with the read
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        request_done.wait(lock, [&] { return request->done; });
+    }
+
+    Kernel::Thread* thread = request->thread.get();
+    if (thread->status != THREADSTATUS_WAIT_SLEEP) {
+        LOG_ERROR(Service_FS, "Thread %u stopped during an asynchronous read", thread->thread_id);
+        return;
+    }
+
+    u32* cmd_buff = reinterpret_cast<u32*>(
+        Memory::GetPointer(thread->GetTLSAddress() + Kernel::kCommandHeaderOffset));
+    if (request->result.IsError()) {
+        cmd_buff[1] = request->result.raw;
+    } else {
+        Memory::WriteBlock(request->address, request->data.data(), request->bytes_read);
+        cmd_buff[1] = RESULT_SUCCESS.raw;
+        cmd_buff[2] = static_cast<u32>(request->bytes_read);
+    }
+    thread->ResumeFromWait();
+}
+
+bool ShouldReadAsync(size_t length) {
+    return Settings::values.use_async_fs_reads && length >= ASYNC_READ_MIN_LENGTH;
+}
+
+void ReadAsync(std::shared_ptr<File> file, u64 offset, u32 length, VAddr address) {
+    auto request = std::make_shared<ReadRequest>();
+    request->id = next_request_id++;
+    request->file = std::move(file);
+    request->thread = Kernel::GetCurrentThread();
+    request->offset = offset;
+    request->address = address;
+    request->deterministic = Settings::values.deterministic_fs_reads;
+    request->data.resize(length);
+
+    Kernel::WaitCurrentThread_Sleep();
+    pending_requests.emplace(request->id, request);
+    if (request->deterministic)
+        CoreTiming::ScheduleEvent(GetReadLatency(length), completion_event_type, request->id);
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        request_queue.push_back(std::move(request));
+    }
+    work_available.notify_one();
+}
+
+void WaitForAsyncReads(const File* file) {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    for (const auto& pending : pending_requests) {
+        const ReadRequest& request = *pending.second;
+        if (request.file.get() == file)
+            request_done.wait(lock, [&] { return request.done; });
+    }
+}
+
+void AsyncReadInit() {
+    completion_event_type = CoreTiming::RegisterEvent("FS::CompleteRead", CompleteRead);
+
+    stop_workers = false;
+    for (size_t i = 0; i < NUM_IO_WORKERS; ++i)
+        workers.emplace_back(WorkerLoop);
+}
+
+void AsyncReadShutdown() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stop_workers = true;
+    }
+    // The workers finish the reads already queued before exiting
+    work_available.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+    workers.clear();
+
+    pending_requests.clear();
+    next_request_id = 0;
+}
+
+} // namespace FS
+} // namespace Service
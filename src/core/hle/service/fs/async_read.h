@@ -0,0 +1,37 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "common/common_types.h"
+
+namespace Service {
+namespace FS {
+
+class File;
+
+/// File::Read requests of at least this many bytes are handed to the I/O worker threads
+constexpr size_t ASYNC_READ_MIN_LENGTH = 64 * 1024;
+
+/// Returns whether a File::Read request of the given length should be done asynchronously
+bool ShouldReadAsync(size_t length);
+
+/**
+ * Reads from a file on an I/O worker thread while the current guest thread sleeps. Once the read
+ * is done, a CoreTiming event writes the data to guest memory, writes the reply to the thread's
+ * command buffer and wakes the thread up. With deterministic FS reads enabled, that event fires
+ * after an emulated latency that only depends on the length, waiting for the host if needed.
+ */
+void ReadAsync(std::shared_ptr<File> file, u64 offset, u32 length, VAddr address);
+
+/// Blocks until the reads of a file that are still in progress on the worker threads are done
+void WaitForAsyncReads(const File* file);
+
+void AsyncReadInit();
+void AsyncReadShutdown();
+
+} // namespace FS
+} // namespace Service
@@ -15,8 +15,12 @@
 #include "core/hw/hw.h"
 #include "core/hw/lcd.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/gpu_debugger.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
 
 // Main graphics debugger object - TODO: Here is probably not the best place for this
 GraphicsDebugger g_debugger;
@@ -294,6 +298,7 @@ ResultCode SetBufferSwap(u32 screen_id, const FrameBufferInfo& info) {
 
     if (screen_id == 0) {
         MicroProfileFlip();
+        Common::OnTraceCaptureFrame();
         Core::System::GetInstance().perf_stats.EndGameFrame();
     }
 
@@ -322,7 +327,8 @@ static void SetBufferSwap(Interface* self) {
 /**
  * GSP_GPU::FlushDataCache service function
  *
- * This Function is a no-op, We aren't emulating the CPU cache any time soon.
+ * We aren't emulating the CPU cache, but games flush it right after writing data for the GPU, so
+ * the rasterizer is told about the region to get a head start on loading it.
  *
  *  Inputs:
  *      1 : Address
@@ -338,12 +344,32 @@ static void FlushDataCache(Interface* self) {
     u32 size = cmd_buff[2];
     u32 process = cmd_buff[4];
 
+    if (Settings::values.use_surface_preloading && VideoCore::g_renderer != nullptr && size != 0) {
+        // The region is only passed on if it's physically contiguous, which the linear heap and
+        // VRAM are
+        const auto paddr = Memory::TryVirtualToPhysicalAddress(address);
+        const auto last_paddr = Memory::TryVirtualToPhysicalAddress(address + size - 1);
+        if (paddr && last_paddr && *last_paddr - *paddr == size - 1) {
+            const PAddr start = *paddr;
+            auto preload = [start, size] {
+                VideoCore::g_renderer->Rasterizer()->PreloadRegion(start, size);
+            };
+            if (VideoCore::g_gpu_thread != nullptr && VideoCore::g_gpu_thread->HasContext() &&
+                !VideoCore::g_gpu_thread->IsGPUThread()) {
+                // Preloading is only a hint, so the guest doesn't have to wait for it
+                VideoCore::g_gpu_thread->Push(std::move(preload));
+            } else {
+                VideoCore::RunOnRasterizerThread(preload);
+            }
+        }
+    }
+
     // TODO(purpasmart96): Verify return header on HW
 
     cmd_buff[1] = RESULT_SUCCESS.raw; // No error
 
-    LOG_DEBUG(Service_GSP, "(STUBBED) called address=0x%08X, size=0x%08X, process=0x%08X", address,
-              size, process);
+    LOG_DEBUG(Service_GSP, "called address=0x%08X, size=0x%08X, process=0x%08X", address, size,
+              process);
 }
 
 /**
@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include "common/alignment.h"
 #include "common/logging/log.h"
 #include "common/scope_exit.h"
@@ -37,6 +40,33 @@ const std::array<CROHelper::HeaderField, 4> CROHelper::FIX_BARRIERS{{
     Fix0Barrier, Fix1Barrier, Fix2Barrier, Fix3Barrier,
 }};
 
+std::unordered_map<VAddr, CROHelper::ModuleIndex> CROHelper::module_indices;
+
+namespace {
+
+/// A string table of a module, read from guest memory at once
+class StringTable {
+public:
+    StringTable(VAddr address, u32 size) : address(address), data(size) {
+        Memory::ReadBlock(address, data.data(), data.size());
+    }
+
+    /// Gets the string at an address, as Memory::ReadCString would with the size of the table
+    std::string Get(VAddr string_address) const {
+        if (string_address < address || string_address - address >= data.size())
+            return Memory::ReadCString(string_address, data.size());
+
+        const char* string = data.data() + (string_address - address);
+        return std::string(string, strnlen(string, data.size() - (string_address - address)));
+    }
+
+private:
+    VAddr address;
+    std::vector<char> data;
+};
+
+} // Anonymous namespace
+
 VAddr CROHelper::SegmentTagToAddress(SegmentTag segment_tag) const {
     u32 segment_num = GetField(SegmentNum);
 
@@ -52,6 +82,18 @@ VAddr CROHelper::SegmentTagToAddress(SegmentTag segment_tag) const {
     return entry.offset + segment_tag.offset_into_segment;
 }
 
+VAddr CROHelper::SegmentTagToAddress(SegmentTag segment_tag,
+                                     const std::vector<SegmentEntry>& segments) {
+    if (segment_tag.segment_index >= segments.size())
+        return 0;
+
+    const SegmentEntry& entry = segments[segment_tag.segment_index];
+    if (segment_tag.offset_into_segment >= entry.size)
+        return 0;
+
+    return entry.offset + segment_tag.offset_into_segment;
+}
+
 ResultCode CROHelper::ApplyRelocation(VAddr target_address, RelocationType relocation_type,
                                       u32 addend, u32 symbol_address, u32 target_future_address) {
 
@@ -104,80 +146,79 @@ ResultCode CROHelper::ApplyRelocationBatch(VAddr batch, u32 symbol_address, bool
     if (symbol_address == 0 && !reset)
         return CROFormatError(0x10);
 
+    // Rather than reading them an entry at a time, the segment table is read once, and the
+    // relocations in blocks
+    const std::vector<SegmentEntry> segments = GetEntries<SegmentEntry>();
+    std::array<RelocationEntry, 32> relocations;
     VAddr relocation_address = batch;
-    while (true) {
-        RelocationEntry relocation;
-        Memory::ReadBlock(relocation_address, &relocation, sizeof(RelocationEntry));
+    bool batch_end = false;
+    while (!batch_end) {
+        // The end of the batch isn't known, so don't read past the page of the next relocation,
+        // which may be the last one mapped
+        const VAddr page_end = Common::AlignUp(relocation_address + 1, Memory::PAGE_SIZE);
+        const size_t count = std::max<size_t>(
+            1, std::min<size_t>(relocations.size(),
+                                (page_end - relocation_address) / sizeof(RelocationEntry)));
+        Memory::ReadBlock(relocation_address, relocations.data(), count * sizeof(RelocationEntry));
+
+        for (size_t i = 0; i < count && !batch_end; ++i) {
+            const RelocationEntry& relocation = relocations[i];
+            VAddr relocation_target = SegmentTagToAddress(relocation.target_position, segments);
+            if (relocation_target == 0) {
+                return CROFormatError(0x12);
+            }
 
-        VAddr relocation_target = SegmentTagToAddress(relocation.target_position);
-        if (relocation_target == 0) {
-            return CROFormatError(0x12);
-        }
+            ResultCode result =
+                ApplyRelocation(relocation_target, relocation.type, relocation.addend,
+                                symbol_address, relocation_target);
+            if (result.IsError()) {
+                LOG_ERROR(Service_LDR, "Error applying relocation %08X", result.raw);
+                return result;
+            }
 
-        ResultCode result = ApplyRelocation(relocation_target, relocation.type, relocation.addend,
-                                            symbol_address, relocation_target);
-        if (result.IsError()) {
-            LOG_ERROR(Service_LDR, "Error applying relocation %08X", result.raw);
-            return result;
+            batch_end = relocation.is_batch_end != 0;
         }
 
-        if (relocation.is_batch_end)
-            break;
-
-        relocation_address += sizeof(RelocationEntry);
+        relocation_address += count * sizeof(RelocationEntry);
     }
 
-    RelocationEntry relocation;
-    Memory::ReadBlock(batch, &relocation, sizeof(RelocationEntry));
-    relocation.is_batch_resolved = reset ? 0 : 1;
-    Memory::WriteBlock(batch, &relocation, sizeof(RelocationEntry));
+    Memory::Write8(batch + offsetof(RelocationEntry, is_batch_resolved), reset ? 0 : 1);
     return RESULT_SUCCESS;
 }
 
 VAddr CROHelper::FindExportNamedSymbol(const std::string& name) const {
-    if (!GetField(ExportTreeNum))
+    const auto& named_symbols = GetModuleIndex().named_symbols;
+    auto it = named_symbols.find(name);
+    if (it == named_symbols.end())
         return 0;
 
-    std::size_t len = name.size();
-    ExportTreeEntry entry;
-    GetEntry(0, entry);
-    ExportTreeEntry::Child next;
-    next.raw = entry.left.raw;
-    u32 found_id;
-
-    while (true) {
-        GetEntry(next.next_index, entry);
-
-        if (next.is_end) {
-            found_id = entry.export_table_index;
-            break;
-        }
-
-        u16 test_byte = entry.test_bit >> 3;
-        u16 test_bit_in_byte = entry.test_bit & 7;
+    return it->second;
+}
 
-        if (test_byte >= len) {
-            next.raw = entry.left.raw;
-        } else if ((name[test_byte] >> test_bit_in_byte) & 1) {
-            next.raw = entry.right.raw;
-        } else {
-            next.raw = entry.left.raw;
+const CROHelper::ModuleIndex& CROHelper::GetModuleIndex() const {
+    auto it = module_indices.find(module_address);
+    if (it != module_indices.end())
+        return it->second;
+
+    ModuleIndex index;
+    index.name = ModuleName();
+
+    // Named symbols are looked up with the export tree, so there are none without it
+    if (GetField(ExportTreeNum)) {
+        const StringTable export_strings(GetField(ExportStringsOffset),
+                                         GetField(ExportStringsSize));
+        const std::vector<SegmentEntry> segments = GetEntries<SegmentEntry>();
+        const std::vector<ExportNamedSymbolEntry> symbols = GetEntries<ExportNamedSymbolEntry>();
+        index.named_symbols.reserve(symbols.size());
+        for (const ExportNamedSymbolEntry& symbol : symbols) {
+            if (symbol.name_offset == 0)
+                continue;
+            index.named_symbols.emplace(export_strings.Get(symbol.name_offset),
+                                        SegmentTagToAddress(symbol.symbol_position, segments));
         }
     }
 
-    u32 export_named_symbol_num = GetField(ExportNamedSymbolNum);
-
-    if (found_id >= export_named_symbol_num)
-        return 0;
-
-    u32 export_strings_size = GetField(ExportStringsSize);
-    ExportNamedSymbolEntry symbol_entry;
-    GetEntry(found_id, symbol_entry);
-
-    if (Memory::ReadCString(symbol_entry.name_offset, export_strings_size) != name)
-        return 0;
-
-    return SegmentTagToAddress(symbol_entry.symbol_position);
+    return module_indices.emplace(module_address, std::move(index)).first->second;
 }
 
 ResultCode CROHelper::RebaseHeader(u32 cro_size) {
@@ -721,26 +762,22 @@ void CROHelper::UnrebaseHeader() {
 }
 
 ResultCode CROHelper::ApplyImportNamedSymbol(VAddr crs_address) {
-    u32 import_strings_size = GetField(ImportStringsSize);
-    u32 symbol_import_num = GetField(ImportNamedSymbolNum);
-    for (u32 i = 0; i < symbol_import_num; ++i) {
-        ImportNamedSymbolEntry entry;
-        GetEntry(i, entry);
+    const StringTable import_strings(GetField(ImportStringsOffset), GetField(ImportStringsSize));
+    for (const ImportNamedSymbolEntry& entry : GetEntries<ImportNamedSymbolEntry>()) {
         VAddr relocation_addr = entry.relocation_batch_offset;
         ExternalRelocationEntry relocation_entry;
         Memory::ReadBlock(relocation_addr, &relocation_entry, sizeof(ExternalRelocationEntry));
 
         if (!relocation_entry.is_batch_resolved) {
+            const std::string symbol_name = import_strings.Get(entry.name_offset);
             ResultCode result =
                 ForEachAutoLinkCRO(crs_address, [&](CROHelper source) -> ResultVal<bool> {
-                    std::string symbol_name =
-                        Memory::ReadCString(entry.name_offset, import_strings_size);
                     u32 symbol_address = source.FindExportNamedSymbol(symbol_name);
 
                     if (symbol_address != 0) {
                         LOG_TRACE(Service_LDR, "CRO \"%s\" imports \"%s\" from \"%s\"",
                                   ModuleName().data(), symbol_name.data(),
-                                  source.ModuleName().data());
+                                  source.GetModuleIndex().name.data());
 
                         ResultCode result = ApplyRelocationBatch(relocation_addr, symbol_address);
                         if (result.IsError()) {
@@ -823,17 +860,13 @@ ResultCode CROHelper::ResetImportAnonymousSymbol() {
 }
 
 ResultCode CROHelper::ApplyModuleImport(VAddr crs_address) {
-    u32 import_strings_size = GetField(ImportStringsSize);
-
-    u32 import_module_num = GetField(ImportModuleNum);
-    for (u32 i = 0; i < import_module_num; ++i) {
-        ImportModuleEntry entry;
-        GetEntry(i, entry);
-        std::string want_cro_name = Memory::ReadCString(entry.name_offset, import_strings_size);
+    const StringTable import_strings(GetField(ImportStringsOffset), GetField(ImportStringsSize));
+    for (ImportModuleEntry& entry : GetEntries<ImportModuleEntry>()) {
+        std::string want_cro_name = import_strings.Get(entry.name_offset);
 
         ResultCode result =
             ForEachAutoLinkCRO(crs_address, [&](CROHelper source) -> ResultVal<bool> {
-                if (want_cro_name == source.ModuleName()) {
+                if (want_cro_name == source.GetModuleIndex().name) {
                     LOG_INFO(Service_LDR, "CRO \"%s\" imports %d indexed symbols from \"%s\"",
                              ModuleName().data(), entry.import_indexed_symbol_num,
                              source.ModuleName().data());
@@ -882,18 +915,15 @@ ResultCode CROHelper::ApplyModuleImport(VAddr crs_address) {
 ResultCode CROHelper::ApplyExportNamedSymbol(CROHelper target) {
     LOG_DEBUG(Service_LDR, "CRO \"%s\" exports named symbols to \"%s\"", ModuleName().data(),
               target.ModuleName().data());
-    u32 target_import_strings_size = target.GetField(ImportStringsSize);
-    u32 target_symbol_import_num = target.GetField(ImportNamedSymbolNum);
-    for (u32 i = 0; i < target_symbol_import_num; ++i) {
-        ImportNamedSymbolEntry entry;
-        target.GetEntry(i, entry);
+    const StringTable target_import_strings(target.GetField(ImportStringsOffset),
+                                            target.GetField(ImportStringsSize));
+    for (const ImportNamedSymbolEntry& entry : target.GetEntries<ImportNamedSymbolEntry>()) {
         VAddr relocation_addr = entry.relocation_batch_offset;
         ExternalRelocationEntry relocation_entry;
         Memory::ReadBlock(relocation_addr, &relocation_entry, sizeof(ExternalRelocationEntry));
 
         if (!relocation_entry.is_batch_resolved) {
-            std::string symbol_name =
-                Memory::ReadCString(entry.name_offset, target_import_strings_size);
+            std::string symbol_name = target_import_strings.Get(entry.name_offset);
             u32 symbol_address = FindExportNamedSymbol(symbol_name);
             if (symbol_address != 0) {
                 LOG_TRACE(Service_LDR, "    exports symbol \"%s\"", symbol_name.data());
@@ -912,18 +942,15 @@ ResultCode CROHelper::ResetExportNamedSymbol(CROHelper target) {
     LOG_DEBUG(Service_LDR, "CRO \"%s\" unexports named symbols to \"%s\"", ModuleName().data(),
               target.ModuleName().data());
     u32 unresolved_symbol = target.GetOnUnresolvedAddress();
-    u32 target_import_strings_size = target.GetField(ImportStringsSize);
-    u32 target_symbol_import_num = target.GetField(ImportNamedSymbolNum);
-    for (u32 i = 0; i < target_symbol_import_num; ++i) {
-        ImportNamedSymbolEntry entry;
-        target.GetEntry(i, entry);
+    const StringTable target_import_strings(target.GetField(ImportStringsOffset),
+                                            target.GetField(ImportStringsSize));
+    for (const ImportNamedSymbolEntry& entry : target.GetEntries<ImportNamedSymbolEntry>()) {
         VAddr relocation_addr = entry.relocation_batch_offset;
         ExternalRelocationEntry relocation_entry;
         Memory::ReadBlock(relocation_addr, &relocation_entry, sizeof(ExternalRelocationEntry));
 
         if (relocation_entry.is_batch_resolved) {
-            std::string symbol_name =
-                Memory::ReadCString(entry.name_offset, target_import_strings_size);
+            std::string symbol_name = target_import_strings.Get(entry.name_offset);
             u32 symbol_address = FindExportNamedSymbol(symbol_name);
             if (symbol_address != 0) {
                 LOG_TRACE(Service_LDR, "    unexports symbol \"%s\"", symbol_name.data());
@@ -940,14 +967,11 @@ ResultCode CROHelper::ResetExportNamedSymbol(CROHelper target) {
 }
 
 ResultCode CROHelper::ApplyModuleExport(CROHelper target) {
-    std::string module_name = ModuleName();
-    u32 target_import_string_size = target.GetField(ImportStringsSize);
-    u32 target_import_module_num = target.GetField(ImportModuleNum);
-    for (u32 i = 0; i < target_import_module_num; ++i) {
-        ImportModuleEntry entry;
-        target.GetEntry(i, entry);
-
-        if (Memory::ReadCString(entry.name_offset, target_import_string_size) != module_name)
+    const std::string& module_name = GetModuleIndex().name;
+    const StringTable target_import_strings(target.GetField(ImportStringsOffset),
+                                            target.GetField(ImportStringsSize));
+    for (ImportModuleEntry& entry : target.GetEntries<ImportModuleEntry>()) {
+        if (target_import_strings.Get(entry.name_offset) != module_name)
             continue;
 
         LOG_INFO(Service_LDR, "CRO \"%s\" exports %d indexed symbols to \"%s\"", module_name.data(),
@@ -989,14 +1013,11 @@ ResultCode CROHelper::ApplyModuleExport(CROHelper target) {
 ResultCode CROHelper::ResetModuleExport(CROHelper target) {
     u32 unresolved_symbol = target.GetOnUnresolvedAddress();
 
-    std::string module_name = ModuleName();
-    u32 target_import_string_size = target.GetField(ImportStringsSize);
-    u32 target_import_module_num = target.GetField(ImportModuleNum);
-    for (u32 i = 0; i < target_import_module_num; ++i) {
-        ImportModuleEntry entry;
-        target.GetEntry(i, entry);
-
-        if (Memory::ReadCString(entry.name_offset, target_import_string_size) != module_name)
+    const std::string& module_name = GetModuleIndex().name;
+    const StringTable target_import_strings(target.GetField(ImportStringsOffset),
+                                            target.GetField(ImportStringsSize));
+    for (ImportModuleEntry& entry : target.GetEntries<ImportModuleEntry>()) {
+        if (target_import_strings.Get(entry.name_offset) != module_name)
             continue;
 
         LOG_DEBUG(Service_LDR, "CRO \"%s\" unexports indexed symbols to \"%s\"", module_name.data(),
@@ -1193,6 +1214,8 @@ ResultCode CROHelper::Rebase(VAddr crs_address, u32 cro_size, VAddr data_segment
 }
 
 void CROHelper::Unrebase(bool is_crs) {
+    DropModuleIndex();
+
     UnrebaseImportAnonymousSymbolTable();
     UnrebaseImportIndexedSymbolTable();
     UnrebaseImportNamedSymbolTable();
@@ -1239,6 +1262,8 @@ ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix) {
                 data_segment_address = entry.offset;
                 entry.offset = GetField(DataOffset);
                 SetEntry(2, entry);
+                // The addresses of exported symbols in .data change with it
+                DropModuleIndex();
             }
         }
         SCOPE_EXIT({
@@ -1249,6 +1274,7 @@ ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix) {
                     GetEntry(2, entry);
                     entry.offset = data_segment_address;
                     SetEntry(2, entry);
+                    DropModuleIndex();
                 }
             }
         });
@@ -1348,6 +1374,7 @@ ResultCode CROHelper::ClearRelocations() {
 }
 
 void CROHelper::InitCRS() {
+    module_indices.clear();
     SetNextModule(0);
     SetPreviousModule(0);
 }
@@ -1452,6 +1479,9 @@ u32 CROHelper::Fix(u32 fix_level) {
     u32 fix_end = GetFixEnd(fix_level);
 
     if (fix_level != 0) {
+        // Fixing may crop the export tables
+        DropModuleIndex();
+
         SetField(Magic, MAGIC_FIXD);
 
         for (int field = FIX_BARRIERS[fix_level]; field < Fix0Barrier; field += 2) {
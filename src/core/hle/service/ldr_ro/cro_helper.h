@@ -5,7 +5,10 @@
 #pragma once
 
 #include <array>
+#include <string>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/hle/result.h"
@@ -96,7 +99,10 @@ public:
      */
     ResultCode ClearRelocations();
 
-    /// Initialize this module as the static module (CRS)
+    /**
+     * Initialize this module as the static module (CRS). The modules of the previous static module
+     * are forgotten.
+     */
     void InitCRS();
 
     /**
@@ -428,6 +434,39 @@ private:
         Memory::WriteBlock(GetField(T::TABLE_OFFSET_FIELD) + index * sizeof(T), &data, sizeof(T));
     }
 
+    /**
+     * Reads a whole module table at once.
+     * @note the entry type must have the static member TABLE_OFFSET_FIELD
+     *       indicating which table the entry is in, followed by the field of the entry count.
+     */
+    template <typename T>
+    std::vector<T> GetEntries() const {
+        std::vector<T> entries(GetField(static_cast<HeaderField>(T::TABLE_OFFSET_FIELD + 1)));
+        Memory::ReadBlock(GetField(T::TABLE_OFFSET_FIELD), entries.data(),
+                          entries.size() * sizeof(T));
+        return entries;
+    }
+
+    /**
+     * What other modules look up in a module while linking, read from the module once, so that
+     * linking doesn't go through the export tree in guest memory for each imported symbol.
+     */
+    struct ModuleIndex {
+        std::string name;
+        std::unordered_map<std::string, VAddr> named_symbols;
+    };
+
+    /// Indices of the modules looked up since they were rebased, by module address
+    static std::unordered_map<VAddr, ModuleIndex> module_indices;
+
+    /// Gets the index of this module, building it if this module wasn't looked up yet
+    const ModuleIndex& GetModuleIndex() const;
+
+    /// Drops the index of this module, to be called whenever its exports change
+    void DropModuleIndex() const {
+        module_indices.erase(module_address);
+    }
+
     /**
      * Converts a segment tag to virtual address in this module.
      * @param segment_tag the segment tag to convert
@@ -435,6 +474,15 @@ private:
      */
     VAddr SegmentTagToAddress(SegmentTag segment_tag) const;
 
+    /**
+     * Converts a segment tag to virtual address with a segment table already read.
+     * @param segment_tag the segment tag to convert
+     * @param segments the segment table of the module
+     * @returns VAddr the virtual address the segment tag points to; 0 if invalid.
+     */
+    static VAddr SegmentTagToAddress(SegmentTag segment_tag,
+                                     const std::vector<SegmentEntry>& segments);
+
     VAddr NextModule() const {
         return GetField(NextCRO);
     }
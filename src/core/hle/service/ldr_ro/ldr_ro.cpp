@@ -439,7 +439,8 @@ static void LoadCRO(Interface* self, bool link_on_load_bug_fix) {
         }
     }
 
-    Core::CPU().ClearInstructionCache();
+    // Only the new module's code changed, relocations patched into other modules are data
+    Core::CPU().InvalidateCacheRange(cro_address, cro_size);
 
     LOG_INFO(Service_LDR, "CRO \"%s\" loaded at 0x%08X, fixed_end=0x%08X", cro.ModuleName().data(),
              cro_address, cro_address + fix_size);
@@ -535,7 +536,7 @@ static void UnloadCRO(Interface* self) {
         memory_synchronizer.RemoveMemoryBlock(cro_address, cro_buffer_ptr);
     }
 
-    Core::CPU().ClearInstructionCache();
+    Core::CPU().InvalidateCacheRange(cro_address, fixed_size);
 
     rb.Push(result);
 }
@@ -588,7 +589,7 @@ static void LinkCRO(Interface* self) {
     }
 
     memory_synchronizer.SynchronizeOriginalMemory();
-    Core::CPU().ClearInstructionCache();
+    Core::CPU().InvalidateCacheRange(cro_address, cro.GetFixedSize());
 
     rb.Push(result);
 }
@@ -641,7 +642,7 @@ static void UnlinkCRO(Interface* self) {
     }
 
     memory_synchronizer.SynchronizeOriginalMemory();
-    Core::CPU().ClearInstructionCache();
+    Core::CPU().InvalidateCacheRange(cro_address, cro.GetFixedSize());
 
     rb.Push(result);
 }
@@ -6,6 +6,7 @@
 #include <fmt/format.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "common/string_util.h"
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/client_port.h"
@@ -76,20 +77,37 @@ static std::string MakeFunctionString(const char* name, const char* port_name,
     return function_string;
 }
 
+/// Upper bound on the MicroProfile timers created for HLE functions, to stay clear of its limit
+constexpr unsigned MAX_FUNCTION_PROFILE_TOKENS = 512;
+/// Command ids past this are rare and always looked up in Interface::m_functions
+constexpr u32 MAX_FUNCTION_TABLE_SIZE = 0x1000;
+
 Interface::Interface(u32 max_sessions) : max_sessions(max_sessions) {}
 Interface::~Interface() = default;
 
+Interface::RegisteredFunction* Interface::FindFunction(u32 header) {
+    const u32 command_id = header >> 16;
+    if (command_id < function_table.size()) {
+        RegisteredFunction* function = function_table[command_id];
+        if (function != nullptr && function->info.id == header)
+            return function;
+    }
+
+    auto itr = m_functions.find(header);
+    return itr == m_functions.end() ? nullptr : &itr->second;
+}
+
 void Interface::HandleSyncRequest(SharedPtr<ServerSession> server_session) {
     // TODO(Subv): Make use of the server_session in the HLE service handlers to distinguish which
     // session triggered each command.
 
     u32* cmd_buff = Kernel::GetCommandBuffer();
-    auto itr = m_functions.find(cmd_buff[0]);
+    RegisteredFunction* function = FindFunction(cmd_buff[0]);
 
-    if (itr == m_functions.end() || itr->second.func == nullptr) {
-        std::string function_name = (itr == m_functions.end())
+    if (function == nullptr || function->info.func == nullptr) {
+        std::string function_name = (function == nullptr)
                                         ? Common::StringFromFormat("0x%08X", cmd_buff[0])
-                                        : itr->second.name;
+                                        : function->info.name;
         LOG_ERROR(
             Service, "unknown / unimplemented %s",
             MakeFunctionString(function_name.c_str(), GetPortName().c_str(), cmd_buff).c_str());
@@ -99,16 +117,58 @@ void Interface::HandleSyncRequest(SharedPtr<ServerSession> server_session) {
         return;
     }
     LOG_TRACE(Service, "%s",
-              MakeFunctionString(itr->second.name, GetPortName().c_str(), cmd_buff).c_str());
+              MakeFunctionString(function->info.name, GetPortName().c_str(), cmd_buff).c_str());
 
-    itr->second.func(this);
+    if (CallStats::IsEnabled() && function->call_stats == nullptr) {
+        function->call_stats =
+            CallStats::GetEntry(GetPortName(), function->info.id, function->info.name);
+    }
+    CallStats::ScopedTimer call_timer(CallStats::IsEnabled() ? function->call_stats : nullptr);
+
+#if MICROPROFILE_ENABLED
+    static unsigned num_profile_tokens = 0;
+    if (function->profile_token == 0 && num_profile_tokens < MAX_FUNCTION_PROFILE_TOKENS) {
+        ++num_profile_tokens;
+        const std::string name = GetPortName() + " " + function->info.name;
+        function->profile_token =
+            MicroProfileGetToken("HLE Services", name.c_str(), MP_RGB(128, 192, 255));
+    }
+    if (function->profile_token != 0) {
+        MICROPROFILE_SCOPE_TOKEN(function->profile_token);
+        function->info.func(this);
+        return;
+    }
+#endif
+
+    function->info.func(this);
 }
 
 void Interface::Register(const FunctionInfo* functions, size_t n) {
-    m_functions.reserve(n);
+    m_functions.reserve(m_functions.size() + n);
     for (size_t i = 0; i < n; ++i) {
         // Usually this array is sorted by id already, so hint to instead at the end
-        m_functions.emplace_hint(m_functions.cend(), functions[i].id, functions[i]);
+        m_functions.emplace_hint(m_functions.cend(), functions[i].id,
+                                 RegisteredFunction{functions[i]});
+    }
+
+    // Inserting may have moved the functions around, so the table is rebuilt from scratch
+    function_table.clear();
+    std::vector<bool> shared_command_ids;
+    for (auto& entry : m_functions) {
+        const u32 command_id = entry.first >> 16;
+        if (command_id >= MAX_FUNCTION_TABLE_SIZE)
+            continue;
+        if (command_id >= function_table.size()) {
+            function_table.resize(command_id + 1, nullptr);
+            shared_command_ids.resize(command_id + 1, false);
+        }
+        if (function_table[command_id] != nullptr)
+            shared_command_ids[command_id] = true;
+        function_table[command_id] = &entry.second;
+    }
+    for (size_t i = 0; i < function_table.size(); ++i) {
+        if (shared_command_ids[i])
+            function_table[i] = nullptr;
     }
 }
 
@@ -179,7 +239,17 @@ void ServiceFrameworkBase::HandleSyncRequest(SharedPtr<ServerSession> server_ses
 
     LOG_TRACE(Service, "%s",
               MakeFunctionString(info->name, GetServiceName().c_str(), cmd_buf).c_str());
-    handler_invoker(this, info->handler_callback, context);
+    {
+        CallStats::Entry* stats = nullptr;
+        if (CallStats::IsEnabled()) {
+            auto& entry = call_stats[header_code];
+            if (entry == nullptr)
+                entry = CallStats::GetEntry(service_name, header_code, info->name);
+            stats = entry;
+        }
+        CallStats::ScopedTimer call_timer(stats);
+        handler_invoker(this, info->handler_callback, context);
+    }
     context.WriteToOutgoingCommandBuffer(cmd_buf, *Kernel::g_current_process,
                                          Kernel::g_handle_table);
 }
@@ -210,6 +280,17 @@ void AddService(Interface* interface_) {
     server_port->SetHleHandler(std::shared_ptr<Interface>(interface_));
 }
 
+void AddLazyService(std::string name, std::function<std::shared_ptr<Interface>()> factory) {
+    auto server_port = SM::g_service_manager->RegisterService(name, DefaultMaxSessions).Unwrap();
+    server_port->SetHleHandlerFactory([name, factory] {
+        std::shared_ptr<Interface> interface_ = factory();
+        ASSERT_MSG(interface_->GetPortName() == name, "%s registered as %s",
+                   interface_->GetPortName().c_str(), name.c_str());
+        LOG_DEBUG(Service, "Created %s on its first connection", name.c_str());
+        return interface_;
+    });
+}
+
 /// Initialize ServiceManager
 void Init() {
     SM::g_service_manager = std::make_shared<SM::ServiceManager>();
@@ -239,18 +320,20 @@ void Init() {
     PTM::Init();
     QTM::Init();
 
-    AddService(new CSND::CSND_SND);
     AddService(new DSP_DSP::Interface);
     AddService(new GSP::GSP_GPU);
     AddService(new GSP::GSP_LCD);
-    AddService(new HTTP::HTTP_C);
-    AddService(new LDR::LDR_RO);
-    AddService(new MIC::MIC_U);
-    AddService(new NS::NS_S);
-    AddService(new PM::PM_APP);
-    AddService(new SOC::SOC_U);
-    AddService(new SSL::SSL_C);
-    AddService(new Y2R::Y2R_U);
+
+    // Services that keep their state to themselves are only created once an application uses them
+    AddLazyService<CSND::CSND_SND>("csnd:SND");
+    AddLazyService<HTTP::HTTP_C>("http:C");
+    AddLazyService<LDR::LDR_RO>("ldr:ro");
+    AddLazyService<MIC::MIC_U>("mic:u");
+    AddLazyService<NS::NS_S>("ns:s");
+    AddLazyService<PM::PM_APP>("pm:app");
+    AddLazyService<SOC::SOC_U>("soc:U");
+    AddLazyService<SSL::SSL_C>("ssl:C");
+    AddLazyService<Y2R::Y2R_U>("y2r:u");
 
     LOG_DEBUG(Service, "initialized OK");
 }
@@ -5,13 +5,17 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <boost/container/flat_map.hpp>
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/service/call_stats.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Namespace Service
@@ -105,8 +109,25 @@ protected:
     } version = {};
 
 private:
+    struct RegisteredFunction {
+        FunctionInfo info;
+        /// MicroProfile timer measuring calls to the function, created on its first call
+        u64 profile_token = 0;
+        /// Call statistics of the function, looked up on its first call with statistics enabled
+        CallStats::Entry* call_stats = nullptr;
+    };
+
+    /// Returns the function registered for a command header, or nullptr
+    RegisteredFunction* FindFunction(u32 header);
+
     u32 max_sessions; ///< Maximum number of concurrent sessions that this service can handle.
-    boost::container::flat_map<u32, FunctionInfo> m_functions;
+    boost::container::flat_map<u32, RegisteredFunction> m_functions;
+    /**
+     * Functions indexed by the command id in bits 16-31 of their header, so that most requests are
+     * dispatched with a single load. Command ids registered with several headers are left out and
+     * found in m_functions instead.
+     */
+    std::vector<RegisteredFunction*> function_table;
 };
 
 /**
@@ -175,6 +196,8 @@ private:
     /// Function used to safely up-cast pointers to the derived class before invoking a handler.
     InvokerFn* handler_invoker;
     boost::container::flat_map<u32, FunctionInfoBase> handlers;
+    /// Call statistics of the handlers called with statistics enabled
+    boost::container::flat_map<u32, CallStats::Entry*> call_stats;
 };
 
 /**
@@ -263,4 +286,17 @@ void AddNamedPort(std::string name, Kernel::SharedPtr<Kernel::ClientPort> port);
 /// Adds a service to the services table
 void AddService(Interface* interface_);
 
+/**
+ * Adds a service to the services table, only creating its interface once the first client
+ * connects. Nothing but the service itself may depend on the state that the interface sets up.
+ * @param name Port name of the service, the one the interface returns from GetPortName
+ * @param factory Creates the interface
+ */
+void AddLazyService(std::string name, std::function<std::shared_ptr<Interface>()> factory);
+
+template <typename T>
+void AddLazyService(std::string name) {
+    AddLazyService(std::move(name), [] { return std::make_shared<T>(); });
+}
+
 } // namespace
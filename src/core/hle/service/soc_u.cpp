@@ -3,16 +3,23 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <condition_variable>
 #include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/scope_exit.h"
+#include "core/core_timing.h"
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/server_session.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/result.h"
 #include "core/hle/service/soc_u.h"
 #include "core/memory.h"
@@ -187,7 +194,9 @@ static int TranslateSockOpt(int console_opt_name) {
 /// Holds information about a particular socket
 struct SocketHolder {
     u32 socket_fd; ///< The socket descriptor
-    bool blocking; ///< Whether the socket is blocking or not, it is only read on Windows.
+    /// Whether the guest sees the socket as blocking. The host socket is always non-blocking, and
+    /// blocking calls are emulated by putting the calling guest thread to sleep.
+    bool blocking;
 };
 
 /// Structure to represent the 3ds' pollfd structure, which is different than most implementations
@@ -331,8 +340,284 @@ union CTRSockAddr {
 /// Holds info about the currently open sockets
 static std::unordered_map<u32, SocketHolder> open_sockets;
 
+/**
+ * Returns whether the guest has the socket open. Calls on other handles must not reach the host,
+ * as the descriptor of a closed socket may have been reused by another host thread since.
+ */
+static bool IsOpen(u32 socket_handle) {
+    return open_sockets.count(socket_handle) != 0;
+}
+
+/// Returns whether the guest sees the socket as blocking
+static bool IsGuestBlocking(u32 socket_handle) {
+    auto iter = open_sockets.find(socket_handle);
+    return iter == open_sockets.end() || iter->second.blocking;
+}
+
+static void SetHostNonBlocking(u32 socket_handle) {
+#ifdef _WIN32
+    unsigned long nonblocking = 1;
+    ioctlsocket(socket_handle, FIONBIO, &nonblocking);
+#else
+    int flags = ::fcntl(socket_handle, F_GETFL, 0);
+    if (flags != SOCKET_ERROR_VALUE)
+        ::fcntl(socket_handle, F_SETFL, flags | O_NONBLOCK);
+#endif
+}
+
+static bool WouldBlock(int error) {
+    return error == ERRNO(EAGAIN) || error == ERRNO(EWOULDBLOCK);
+}
+
+static pollfd MakePollFD(u32 socket_handle, short events) {
+    pollfd fd{};
+    fd.fd = socket_handle;
+    fd.events = events;
+    return fd;
+}
+
+/**
+ * A socket call that may have to wait for the host socket. It writes its reply to the command
+ * buffer and returns true, or, if can_wait is set and the host socket isn't ready, returns false
+ * without writing anything so that it is retried once the socket is ready.
+ */
+using SocketOperation = std::function<bool(u32* cmd_buffer, bool can_wait)>;
+
+/// A socket call whose guest thread sleeps until the host sockets it waits for are ready
+struct BlockingOperation {
+    Kernel::SharedPtr<Kernel::Thread> thread;
+    std::vector<pollfd> fds;
+    SocketOperation operation;
+    bool has_timeout;
+};
+
+// Operations waiting for their sockets, by id. Only used on the emulation thread.
+static std::unordered_map<u64, BlockingOperation> blocking_operations;
+static u64 next_operation_id = 0;
+static int operation_ready_event = -1;
+static int operation_timeout_event = -1;
+
+// The poller thread waits for the sockets of all blocking operations at once, and schedules
+// operation_ready_event for each operation with a ready socket. Its waits are guarded by
+// poller_mutex; a datagram sent to its loopback wakeup socket makes it pick up new ones.
+static std::mutex poller_mutex;
+static std::unordered_map<u64, std::vector<pollfd>> poller_waits;
+/// Incremented each time the poller takes the current waits, signaling poller_waits_taken
+static u64 poller_generation = 0;
+static std::condition_variable poller_waits_taken;
+static std::thread poller_thread;
+static bool stop_poller = false;
+static u32 wakeup_socket = static_cast<u32>(SOCKET_ERROR_VALUE);
+static sockaddr_in wakeup_address;
+
+static void WakePoller() {
+    const char byte = 0;
+    ::sendto(wakeup_socket, &byte, 1, 0, reinterpret_cast<const sockaddr*>(&wakeup_address),
+             sizeof(wakeup_address));
+}
+
+static void PollerLoop() {
+    std::vector<pollfd> fds;
+    std::vector<u64> fd_owners; ///< Operation id of each entry of fds after the wakeup socket
+    while (true) {
+        fds.clear();
+        fd_owners.clear();
+        fds.push_back(MakePollFD(wakeup_socket, POLLIN));
+        {
+            std::lock_guard<std::mutex> lock(poller_mutex);
+            if (stop_poller)
+                return;
+            for (const auto& wait : poller_waits) {
+                for (const pollfd& fd : wait.second) {
+                    fds.push_back(fd);
+                    fd_owners.push_back(wait.first);
+                }
+            }
+            ++poller_generation;
+        }
+        poller_waits_taken.notify_all();
+
+        poll(fds.data(), static_cast<u32>(fds.size()), -1);
+
+        char byte;
+        while (::recv(wakeup_socket, &byte, 1, 0) > 0) {
+        }
+
+        std::lock_guard<std::mutex> lock(poller_mutex);
+        for (size_t i = 1; i < fds.size(); ++i) {
+            // The wait may have been cancelled, or already found ready through another socket
+            if (fds[i].revents != 0 && poller_waits.erase(fd_owners[i - 1]) != 0)
+                CoreTiming::ScheduleEvent_Threadsafe(0, operation_ready_event, fd_owners[i - 1]);
+        }
+    }
+}
+
+/// Starts the poller thread if it isn't running yet, returns false if it couldn't be started
+static bool StartPoller() {
+    if (poller_thread.joinable())
+        return true;
+
+    wakeup_socket = static_cast<u32>(::socket(AF_INET, SOCK_DGRAM, 0));
+    if (static_cast<s32>(wakeup_socket) == SOCKET_ERROR_VALUE) {
+        LOG_ERROR(Service_SOC, "Could not create the poller wakeup socket");
+        return false;
+    }
+
+    wakeup_address = {};
+    wakeup_address.sin_family = AF_INET;
+    wakeup_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_len = sizeof(wakeup_address);
+    if (::bind(wakeup_socket, reinterpret_cast<sockaddr*>(&wakeup_address),
+               sizeof(wakeup_address)) != 0 ||
+        ::getsockname(wakeup_socket, reinterpret_cast<sockaddr*>(&wakeup_address),
+                      &address_len) != 0) {
+        LOG_ERROR(Service_SOC, "Could not bind the poller wakeup socket");
+        closesocket(wakeup_socket);
+        wakeup_socket = static_cast<u32>(SOCKET_ERROR_VALUE);
+        return false;
+    }
+    SetHostNonBlocking(wakeup_socket);
+
+    stop_poller = false;
+    poller_thread = std::thread(PollerLoop);
+    return true;
+}
+
+static void StopPoller() {
+    if (!poller_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(poller_mutex);
+        stop_poller = true;
+        poller_waits.clear();
+    }
+    WakePoller();
+    poller_thread.join();
+    closesocket(wakeup_socket);
+    wakeup_socket = static_cast<u32>(SOCKET_ERROR_VALUE);
+}
+
+static void AddPollerWait(u64 id, const std::vector<pollfd>& fds) {
+    {
+        std::lock_guard<std::mutex> lock(poller_mutex);
+        poller_waits[id] = fds;
+    }
+    WakePoller();
+}
+
+static void RemovePollerWait(u64 id) {
+    std::lock_guard<std::mutex> lock(poller_mutex);
+    poller_waits.erase(id);
+}
+
+/// Removes the waits of the given operations, returning once the poller no longer polls them
+static void RemovePollerWaitsAndSync(const std::vector<u64>& ids) {
+    if (ids.empty() || !poller_thread.joinable())
+        return;
+
+    std::unique_lock<std::mutex> lock(poller_mutex);
+    for (u64 id : ids)
+        poller_waits.erase(id);
+    const u64 generation = poller_generation;
+    lock.unlock();
+    WakePoller();
+    lock.lock();
+    poller_waits_taken.wait(
+        lock, [generation] { return poller_generation != generation || stop_poller; });
+}
+
+/**
+ * Runs a socket call for the current guest thread. If the guest socket is blocking and the host
+ * socket isn't ready, the thread sleeps and the call is retried once the poller finds one of the
+ * sockets in fds ready, or completed without waiting once timeout_ms of emulated time passed.
+ * @param timeout_ms Longest time to wait, negative to wait for as long as it takes
+ */
+static void RunOperation(std::vector<pollfd> fds, bool guest_blocking, int timeout_ms,
+                         SocketOperation operation) {
+    u32* cmd_buffer = Kernel::GetCommandBuffer();
+    const bool can_wait = guest_blocking && timeout_ms != 0 && StartPoller();
+    if (operation(cmd_buffer, can_wait))
+        return;
+
+    const u64 id = next_operation_id++;
+    BlockingOperation blocking{Kernel::GetCurrentThread(), std::move(fds), std::move(operation),
+                               timeout_ms > 0};
+    Kernel::WaitCurrentThread_Sleep();
+    if (blocking.has_timeout)
+        CoreTiming::ScheduleEvent(msToCycles(timeout_ms), operation_timeout_event, id);
+    AddPollerWait(id, blocking.fds);
+    blocking_operations.emplace(id, std::move(blocking));
+}
+
+/// Retries a blocking operation, completing it if it no longer needs to wait or can_wait is unset
+static void RetryOperation(u64 id, bool can_wait) {
+    auto it = blocking_operations.find(id);
+    if (it == blocking_operations.end())
+        return;
+    BlockingOperation& blocking = it->second;
+
+    Kernel::Thread* thread = blocking.thread.get();
+    if (thread->status != THREADSTATUS_WAIT_SLEEP) {
+        LOG_ERROR(Service_SOC, "Thread %u stopped during a blocking socket call",
+                  thread->thread_id);
+        RemovePollerWait(id);
+        if (blocking.has_timeout)
+            CoreTiming::UnscheduleEvent(operation_timeout_event, id);
+        blocking_operations.erase(it);
+        return;
+    }
+
+    u32* cmd_buffer = reinterpret_cast<u32*>(
+        Memory::GetPointer(thread->GetTLSAddress() + Kernel::kCommandHeaderOffset));
+    if (!blocking.operation(cmd_buffer, can_wait)) {
+        // Someone else got to the socket first, wait for it again
+        AddPollerWait(id, blocking.fds);
+        return;
+    }
+
+    RemovePollerWait(id);
+    if (blocking.has_timeout)
+        CoreTiming::UnscheduleEvent(operation_timeout_event, id);
+    Kernel::SharedPtr<Kernel::Thread> resumed = std::move(blocking.thread);
+    blocking_operations.erase(it);
+    resumed->ResumeFromWait();
+}
+
+static void OperationReady(u64 id, int cycles_late) {
+    RetryOperation(id, true);
+}
+
+static void OperationTimedOut(u64 id, int cycles_late) {
+    RetryOperation(id, false);
+}
+
+/// Returns the ids of the blocking operations waiting for a socket
+static std::vector<u64> GetOperationsUsing(u32 socket_handle) {
+    std::vector<u64> ids;
+    for (const auto& blocking : blocking_operations) {
+        const auto& fds = blocking.second.fds;
+        auto uses_socket = [&](const pollfd& fd) {
+            return static_cast<u32>(fd.fd) == socket_handle;
+        };
+        if (std::any_of(fds.begin(), fds.end(), uses_socket))
+            ids.push_back(blocking.first);
+    }
+    return ids;
+}
+
+/// Completes all blocking operations with the result they get without waiting
+static void CancelAllOperations() {
+    std::vector<u64> cancelled;
+    for (const auto& blocking : blocking_operations)
+        cancelled.push_back(blocking.first);
+    for (u64 id : cancelled)
+        RetryOperation(id, false);
+}
+
 /// Close all open sockets
 static void CleanupSockets() {
+    StopPoller();
+    blocking_operations.clear();
     for (auto sock : open_sockets)
         closesocket(sock.second.socket_fd);
     open_sockets.clear();
@@ -365,8 +650,10 @@ static void Socket(Interface* self) {
 
     u32 ret = static_cast<u32>(::socket(domain, type, protocol));
 
-    if ((s32)ret != SOCKET_ERROR_VALUE)
+    if ((s32)ret != SOCKET_ERROR_VALUE) {
+        SetHostNonBlocking(ret);
         open_sockets[ret] = {ret, true};
+    }
 
     int result = 0;
     if ((s32)ret == SOCKET_ERROR_VALUE)
@@ -418,50 +705,22 @@ static void Fcntl(Interface* self) {
         cmd_buffer[2] = posix_ret;
     });
 
+    // Host sockets are always non-blocking, only the flag the guest sees changes
+    auto iter = open_sockets.find(socket_handle);
     if (ctr_cmd == 3) { // F_GETFL
-#ifdef _WIN32
-        posix_ret = 0;
-        auto iter = open_sockets.find(socket_handle);
-        if (iter != open_sockets.end() && iter->second.blocking == false)
-            posix_ret |= 4; // O_NONBLOCK
-#else
-        int ret = ::fcntl(socket_handle, F_GETFL, 0);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
+        if (iter == open_sockets.end()) {
+            posix_ret = TranslateError(ERRNO(EBADF));
             return;
         }
         posix_ret = 0;
-        if (ret & O_NONBLOCK)
+        if (!iter->second.blocking)
             posix_ret |= 4; // O_NONBLOCK
-#endif
     } else if (ctr_cmd == 4) { // F_SETFL
-#ifdef _WIN32
-        unsigned long tmp = (ctr_arg & 4 /* O_NONBLOCK */) ? 1 : 0;
-        int ret = ioctlsocket(socket_handle, FIONBIO, &tmp);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
+        if (iter == open_sockets.end()) {
+            posix_ret = TranslateError(ERRNO(EBADF));
             return;
         }
-        auto iter = open_sockets.find(socket_handle);
-        if (iter != open_sockets.end())
-            iter->second.blocking = (tmp == 0);
-#else
-        int flags = ::fcntl(socket_handle, F_GETFL, 0);
-        if (flags == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-
-        flags &= ~O_NONBLOCK;
-        if (ctr_arg & 4) // O_NONBLOCK
-            flags |= O_NONBLOCK;
-
-        int ret = ::fcntl(socket_handle, F_SETFL, flags);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-#endif
+        iter->second.blocking = (ctr_arg & 4 /* O_NONBLOCK */) == 0;
     } else {
         LOG_ERROR(Service_SOC, "Unsupported command (%d) in fcntl call", ctr_cmd);
         posix_ret = TranslateError(EINVAL); // TODO: Find the correct error
@@ -484,23 +743,32 @@ static void Listen(Interface* self) {
     cmd_buffer[2] = ret;
 }
 
-static void Accept(Interface* self) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
-    u32* cmd_buffer = Kernel::GetCommandBuffer();
+static bool TryAccept(u32* cmd_buffer, bool can_wait) {
     u32 socket_handle = cmd_buffer[1];
     socklen_t max_addr_len = static_cast<socklen_t>(cmd_buffer[2]);
     sockaddr addr;
     socklen_t addr_len = sizeof(addr);
+    if (!IsOpen(socket_handle)) {
+        cmd_buffer[0] = IPC::MakeHeader(4, 2, 2);
+        cmd_buffer[1] = 0;
+        cmd_buffer[2] = TranslateError(ERRNO(EBADF));
+        cmd_buffer[3] = IPC::StaticBufferDesc(static_cast<u32>(max_addr_len), 0);
+        return true;
+    }
+
     u32 ret = static_cast<u32>(::accept(socket_handle, &addr, &addr_len));
 
-    if ((s32)ret != SOCKET_ERROR_VALUE)
+    if ((s32)ret != SOCKET_ERROR_VALUE) {
+        SetHostNonBlocking(ret);
         open_sockets[ret] = {ret, true};
+    }
 
     int result = 0;
     if ((s32)ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
+        int error = GET_ERRNO;
+        if (can_wait && WouldBlock(error))
+            return false;
+        ret = TranslateError(error);
     } else {
         CTRSockAddr ctr_addr = CTRSockAddr::FromPlatform(addr);
         Memory::WriteBlock(cmd_buffer[0x104 >> 2], &ctr_addr, sizeof(ctr_addr));
@@ -510,6 +778,13 @@ static void Accept(Interface* self) {
     cmd_buffer[1] = result;
     cmd_buffer[2] = ret;
     cmd_buffer[3] = IPC::StaticBufferDesc(static_cast<u32>(max_addr_len), 0);
+    return true;
+}
+
+static void Accept(Interface* self) {
+    u32 socket_handle = Kernel::GetCommandBuffer()[1];
+    RunOperation({MakePollFD(socket_handle, POLLIN)}, IsGuestBlocking(socket_handle), -1,
+                 TryAccept);
 }
 
 static void GetHostId(Interface* self) {
@@ -534,37 +809,50 @@ static void Close(Interface* self) {
     u32* cmd_buffer = Kernel::GetCommandBuffer();
     u32 socket_handle = cmd_buffer[1];
 
-    int ret = 0;
     open_sockets.erase(socket_handle);
 
-    ret = closesocket(socket_handle);
+    // The poller must be done with the socket before it is closed, as its descriptor may be reused
+    const std::vector<u64> cancelled = GetOperationsUsing(socket_handle);
+    RemovePollerWaitsAndSync(cancelled);
 
-    int result = 0;
+    int ret = closesocket(socket_handle);
     if (ret != 0)
         ret = TranslateError(GET_ERRNO);
 
+    // Complete the blocking operations on the socket. It is no longer open, so they fail with
+    // EBADF without touching its descriptor again.
+    for (u64 id : cancelled)
+        RetryOperation(id, false);
+
+    int result = 0;
+
     cmd_buffer[2] = ret;
     cmd_buffer[1] = result;
 }
 
-static void SendTo(Interface* self) {
-    u32* cmd_buffer = Kernel::GetCommandBuffer();
+static bool TrySendTo(u32* cmd_buffer, bool can_wait) {
     u32 socket_handle = cmd_buffer[1];
     u32 len = cmd_buffer[2];
     u32 flags = cmd_buffer[3];
     u32 addr_len = cmd_buffer[4];
 
+    if (!IsOpen(socket_handle)) {
+        cmd_buffer[1] = 0;
+        cmd_buffer[2] = TranslateError(ERRNO(EBADF));
+        return true;
+    }
+
     VAddr input_buff_address = cmd_buffer[8];
     if (!Memory::IsValidVirtualAddress(input_buff_address)) {
         cmd_buffer[1] = -1; // TODO(Subv): Find the right error code
-        return;
+        return true;
     }
 
     // Memory address of the dest_addr structure
     VAddr dest_addr_addr = cmd_buffer[10];
     if (!Memory::IsValidVirtualAddress(dest_addr_addr)) {
         cmd_buffer[1] = -1; // TODO(Subv): Find the right error code
-        return;
+        return true;
     }
 
     std::vector<u8> input_buff(len);
@@ -584,22 +872,36 @@ static void SendTo(Interface* self) {
     }
 
     int result = 0;
-    if (ret == SOCKET_ERROR_VALUE)
-        ret = TranslateError(GET_ERRNO);
+    if (ret == SOCKET_ERROR_VALUE) {
+        int error = GET_ERRNO;
+        if (can_wait && WouldBlock(error))
+            return false;
+        ret = TranslateError(error);
+    }
 
     cmd_buffer[2] = ret;
     cmd_buffer[1] = result;
+    return true;
 }
 
-static void RecvFrom(Interface* self) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
-    u32* cmd_buffer = Kernel::GetCommandBuffer();
+static void SendTo(Interface* self) {
+    u32 socket_handle = Kernel::GetCommandBuffer()[1];
+    RunOperation({MakePollFD(socket_handle, POLLOUT)}, IsGuestBlocking(socket_handle), -1,
+                 TrySendTo);
+}
+
+static bool TryRecvFrom(u32* cmd_buffer, bool can_wait) {
     u32 socket_handle = cmd_buffer[1];
     u32 len = cmd_buffer[2];
     u32 flags = cmd_buffer[3];
 
+    if (!IsOpen(socket_handle)) {
+        cmd_buffer[1] = 0;
+        cmd_buffer[2] = TranslateError(ERRNO(EBADF));
+        cmd_buffer[3] = 0;
+        return true;
+    }
+
     struct {
         u32 output_buffer_descriptor;
         u32 output_buffer_addr;
@@ -611,12 +913,12 @@ static void RecvFrom(Interface* self) {
 
     if (!Memory::IsValidVirtualAddress(buffer_parameters.output_buffer_addr)) {
         cmd_buffer[1] = -1; // TODO(Subv): Find the right error code
-        return;
+        return true;
     }
 
     if (!Memory::IsValidVirtualAddress(buffer_parameters.output_src_address_buffer)) {
         cmd_buffer[1] = -1; // TODO(Subv): Find the right error code
-        return;
+        return true;
     }
 
     std::vector<u8> output_buff(len);
@@ -624,6 +926,8 @@ static void RecvFrom(Interface* self) {
     socklen_t src_addr_len = sizeof(src_addr);
     int ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
                          &src_addr, &src_addr_len);
+    if (ret == SOCKET_ERROR_VALUE && can_wait && WouldBlock(GET_ERRNO))
+        return false;
 
     if (ret >= 0 && buffer_parameters.output_src_address_buffer != 0 && src_addr_len > 0) {
         CTRSockAddr ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
@@ -645,23 +949,38 @@ static void RecvFrom(Interface* self) {
     cmd_buffer[1] = result;
     cmd_buffer[2] = ret;
     cmd_buffer[3] = total_received;
+    return true;
 }
 
-static void Poll(Interface* self) {
-    u32* cmd_buffer = Kernel::GetCommandBuffer();
-    u32 nfds = cmd_buffer[1];
-    int timeout = cmd_buffer[2];
+static void RecvFrom(Interface* self) {
+    u32 socket_handle = Kernel::GetCommandBuffer()[1];
+    RunOperation({MakePollFD(socket_handle, POLLIN)}, IsGuestBlocking(socket_handle), -1,
+                 TryRecvFrom);
+}
 
+/// Reads the pollfd structures of a Poll call, returns false if their address is invalid
+static bool ReadPollFDs(const u32* cmd_buffer, std::vector<CTRPollFD>& ctr_fds) {
+    u32 nfds = cmd_buffer[1];
     VAddr input_fds_addr = cmd_buffer[6];
     VAddr output_fds_addr = cmd_buffer[0x104 >> 2];
     if (!Memory::IsValidVirtualAddress(input_fds_addr) ||
         !Memory::IsValidVirtualAddress(output_fds_addr)) {
-        cmd_buffer[1] = -1; // TODO(Subv): Find correct error code.
-        return;
+        return false;
     }
 
-    std::vector<CTRPollFD> ctr_fds(nfds);
+    ctr_fds.resize(nfds);
     Memory::ReadBlock(input_fds_addr, ctr_fds.data(), nfds * sizeof(CTRPollFD));
+    return true;
+}
+
+static bool TryPoll(u32* cmd_buffer, bool can_wait) {
+    std::vector<CTRPollFD> ctr_fds;
+    if (!ReadPollFDs(cmd_buffer, ctr_fds)) {
+        cmd_buffer[1] = -1; // TODO(Subv): Find correct error code.
+        return true;
+    }
+    u32 nfds = static_cast<u32>(ctr_fds.size());
+    VAddr output_fds_addr = cmd_buffer[0x104 >> 2];
 
     // The 3ds_pollfd and the pollfd structures may be different (Windows/Linux have different
     // sizes)
@@ -669,11 +988,30 @@ static void Poll(Interface* self) {
     std::vector<pollfd> platform_pollfd(nfds);
     std::transform(ctr_fds.begin(), ctr_fds.end(), platform_pollfd.begin(), CTRPollFD::ToPlatform);
 
-    int ret = ::poll(platform_pollfd.data(), nfds, timeout);
+    // Sockets the guest doesn't have open are left out, and reported as invalid
+    int num_closed = 0;
+    for (pollfd& fd : platform_pollfd) {
+        if (!IsOpen(static_cast<u32>(fd.fd))) {
+            fd.fd = -1;
+            ++num_closed;
+        }
+    }
+
+    // The guest's timeout is emulated by RunOperation, the host is only asked for ready sockets
+    int ret = ::poll(platform_pollfd.data(), nfds, 0);
+    if (ret != SOCKET_ERROR_VALUE)
+        ret += num_closed;
+    if (ret == 0 && can_wait)
+        return false;
 
     // Now update the output pollfd structure
-    std::transform(platform_pollfd.begin(), platform_pollfd.end(), ctr_fds.begin(),
-                   CTRPollFD::FromPlatform);
+    for (u32 i = 0; i < nfds; ++i) {
+        const u32 socket_handle = ctr_fds[i].fd;
+        ctr_fds[i] = CTRPollFD::FromPlatform(platform_pollfd[i]);
+        ctr_fds[i].fd = socket_handle;
+        if (platform_pollfd[i].fd == -1)
+            ctr_fds[i].revents.pollnval.Assign(1);
+    }
 
     Memory::WriteBlock(output_fds_addr, ctr_fds.data(), nfds * sizeof(CTRPollFD));
 
@@ -683,6 +1021,20 @@ static void Poll(Interface* self) {
 
     cmd_buffer[1] = result;
     cmd_buffer[2] = ret;
+    return true;
+}
+
+static void Poll(Interface* self) {
+    u32* cmd_buffer = Kernel::GetCommandBuffer();
+    int timeout = cmd_buffer[2];
+
+    std::vector<CTRPollFD> ctr_fds;
+    std::vector<pollfd> wait_fds;
+    if (ReadPollFDs(cmd_buffer, ctr_fds)) {
+        wait_fds.resize(ctr_fds.size());
+        std::transform(ctr_fds.begin(), ctr_fds.end(), wait_fds.begin(), CTRPollFD::ToPlatform);
+    }
+    RunOperation(std::move(wait_fds), true, timeout, TryPoll);
 }
 
 static void GetSockName(Interface* self) {
@@ -752,32 +1104,62 @@ static void GetPeerName(Interface* self) {
     cmd_buffer[1] = result;
 }
 
-static void Connect(Interface* self) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
-    u32* cmd_buffer = Kernel::GetCommandBuffer();
+/**
+ * Connects a socket. When it has to wait, the connection is started and in_progress is set, and
+ * the retry only collects its outcome.
+ */
+static bool TryConnect(u32* cmd_buffer, bool can_wait, bool& in_progress) {
     u32 socket_handle = cmd_buffer[1];
 
-    // Memory address of the ctr_input_addr structure
-    VAddr ctr_input_addr_addr = cmd_buffer[6];
-    if (!Memory::IsValidVirtualAddress(ctr_input_addr_addr)) {
-        cmd_buffer[1] = -1; // TODO(Subv): Verify error
-        return;
-    }
-
-    CTRSockAddr ctr_input_addr;
-    Memory::ReadBlock(ctr_input_addr_addr, &ctr_input_addr, sizeof(ctr_input_addr));
+    int ret;
+    if (!IsOpen(socket_handle)) {
+        ret = TranslateError(ERRNO(EBADF));
+    } else if (!in_progress) {
+        // Memory address of the ctr_input_addr structure
+        VAddr ctr_input_addr_addr = cmd_buffer[6];
+        if (!Memory::IsValidVirtualAddress(ctr_input_addr_addr)) {
+            cmd_buffer[1] = -1; // TODO(Subv): Verify error
+            return true;
+        }
 
-    sockaddr input_addr = CTRSockAddr::ToPlatform(ctr_input_addr);
-    int ret = ::connect(socket_handle, &input_addr, sizeof(input_addr));
+        CTRSockAddr ctr_input_addr;
+        Memory::ReadBlock(ctr_input_addr_addr, &ctr_input_addr, sizeof(ctr_input_addr));
+
+        sockaddr input_addr = CTRSockAddr::ToPlatform(ctr_input_addr);
+        ret = ::connect(socket_handle, &input_addr, sizeof(input_addr));
+        if (ret != 0) {
+            int error = GET_ERRNO;
+            if (can_wait && (error == ERRNO(EINPROGRESS) || WouldBlock(error))) {
+                in_progress = true;
+                return false;
+            }
+            ret = TranslateError(error);
+        }
+    } else {
+        // The socket became writable, so the connection is done, and its error tells how it went
+        int error = 0;
+        socklen_t error_len = sizeof(error);
+        if (::getsockopt(socket_handle, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error),
+                         &error_len) != 0) {
+            error = GET_ERRNO;
+        }
+        ret = error == 0 ? 0 : TranslateError(error);
+    }
     int result = 0;
-    if (ret != 0)
-        ret = TranslateError(GET_ERRNO);
 
     cmd_buffer[0] = IPC::MakeHeader(6, 2, 0);
     cmd_buffer[1] = result;
     cmd_buffer[2] = ret;
+    return true;
+}
+
+static void Connect(Interface* self) {
+    u32 socket_handle = Kernel::GetCommandBuffer()[1];
+    bool in_progress = false;
+    RunOperation({MakePollFD(socket_handle, POLLOUT)}, IsGuestBlocking(socket_handle), -1,
+                 [in_progress](u32* cmd_buffer, bool can_wait) mutable {
+                     return TryConnect(cmd_buffer, can_wait, in_progress);
+                 });
 }
 
 static void InitializeSockets(Interface* self) {
@@ -794,6 +1176,7 @@ static void InitializeSockets(Interface* self) {
 
 static void ShutdownSockets(Interface* self) {
     // TODO(Subv): Implement
+    CancelAllOperations();
     CleanupSockets();
 
 #ifdef _WIN32
@@ -906,6 +1289,10 @@ const Interface::FunctionInfo FunctionTable[] = {
 
 SOC_U::SOC_U() {
     Register(FunctionTable);
+
+    operation_ready_event = CoreTiming::RegisterEvent("SOC_U::OperationReady", OperationReady);
+    operation_timeout_event =
+        CoreTiming::RegisterEvent("SOC_U::OperationTimedOut", OperationTimedOut);
 }
 
 SOC_U::~SOC_U() {
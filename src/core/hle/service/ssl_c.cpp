@@ -7,6 +7,7 @@
 #include "core/hle/ipc.h"
 #include "core/hle/service/ssl_c.h"
 #include "core/memory.h"
+#include "core/movie.h"
 
 namespace Service {
 namespace SSL {
@@ -17,9 +18,10 @@ static std::mt19937 rand_gen;
 static void Initialize(Interface* self) {
     u32* cmd_buff = Kernel::GetCommandBuffer();
 
-    // Seed random number generator when the SSL service is initialized
+    // Seed random number generator when the SSL service is initialized, with the seed of the
+    // movie if one is active so that its runs generate the same data
     std::random_device rand_device;
-    rand_gen.seed(rand_device());
+    rand_gen.seed(Movie::IsActive() ? Movie::GetRandomSeed() : rand_device());
 
     // Stub, return success
     cmd_buff[1] = RESULT_SUCCESS.raw;
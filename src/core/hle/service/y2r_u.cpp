@@ -6,6 +6,7 @@
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "core/core_timing.h"
 #include "core/hle/ipc.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
@@ -36,6 +37,28 @@ static u32 temporal_dithering_enabled = 0;
 static u32 transfer_end_interrupt_enabled = 0;
 static u32 spacial_dithering_enabled = 0;
 
+/// Whether a conversion has been done but its completion not signalled yet
+static bool conversion_pending = false;
+static int conversion_done_event;
+
+/// Rough estimate of the time the hardware takes to convert a pixel, in ARM11 cycles
+static constexpr u64 CONVERSION_CYCLES_PER_PIXEL = 4;
+
+/// Drops the completion of the pending conversion, which is never signalled then
+static void CancelPendingConversion() {
+    if (!conversion_pending)
+        return;
+
+    CoreTiming::UnscheduleEvent(conversion_done_event, 0);
+    conversion_pending = false;
+}
+
+/// Signals the completion of the pending conversion, once its modeled duration has passed
+static void ConversionDone(u64 userdata, int cycles_late) {
+    conversion_pending = false;
+    completion_event->Signal();
+}
+
 static const CoefficientSet standard_coefficients[4] = {
     {{0x100, 0x166, 0xB6, 0x58, 0x1C5, -0x166F, 0x10EE, -0x1C5B}}, // ITU_Rec601
     {{0x100, 0x193, 0x77, 0x2F, 0x1DB, -0x1933, 0xA7C, -0x1D51}},  // ITU_Rec709
@@ -91,7 +114,7 @@ static void SetInputFormat(Interface* self) {
     cmd_buff[0] = IPC::MakeHeader(0x1, 1, 0);
     cmd_buff[1] = RESULT_SUCCESS.raw;
 
-    LOG_DEBUG(Service_Y2R, "called input_format=%hhu", conversion.input_format);
+    LOG_DEBUG(Service_Y2R, "called input_format=%hhu", static_cast<u8>(conversion.input_format));
 }
 
 static void GetInputFormat(Interface* self) {
@@ -101,7 +124,7 @@ static void GetInputFormat(Interface* self) {
     cmd_buff[1] = RESULT_SUCCESS.raw;
     cmd_buff[2] = static_cast<u32>(conversion.input_format);
 
-    LOG_DEBUG(Service_Y2R, "called input_format=%hhu", conversion.input_format);
+    LOG_DEBUG(Service_Y2R, "called input_format=%hhu", static_cast<u8>(conversion.input_format));
 }
 
 static void SetOutputFormat(Interface* self) {
@@ -112,7 +135,7 @@ static void SetOutputFormat(Interface* self) {
     cmd_buff[0] = IPC::MakeHeader(0x3, 1, 0);
     cmd_buff[1] = RESULT_SUCCESS.raw;
 
-    LOG_DEBUG(Service_Y2R, "called output_format=%hhu", conversion.output_format);
+    LOG_DEBUG(Service_Y2R, "called output_format=%hhu", static_cast<u8>(conversion.output_format));
 }
 
 static void GetOutputFormat(Interface* self) {
@@ -122,7 +145,7 @@ static void GetOutputFormat(Interface* self) {
     cmd_buff[1] = RESULT_SUCCESS.raw;
     cmd_buff[2] = static_cast<u32>(conversion.output_format);
 
-    LOG_DEBUG(Service_Y2R, "called output_format=%hhu", conversion.output_format);
+    LOG_DEBUG(Service_Y2R, "called output_format=%hhu", static_cast<u8>(conversion.output_format));
 }
 
 static void SetRotation(Interface* self) {
@@ -133,7 +156,7 @@ static void SetRotation(Interface* self) {
     cmd_buff[0] = IPC::MakeHeader(0x5, 1, 0);
     cmd_buff[1] = RESULT_SUCCESS.raw;
 
-    LOG_DEBUG(Service_Y2R, "called rotation=%hhu", conversion.rotation);
+    LOG_DEBUG(Service_Y2R, "called rotation=%hhu", static_cast<u8>(conversion.rotation));
 }
 
 static void GetRotation(Interface* self) {
@@ -143,7 +166,7 @@ static void GetRotation(Interface* self) {
     cmd_buff[1] = RESULT_SUCCESS.raw;
     cmd_buff[2] = static_cast<u32>(conversion.rotation);
 
-    LOG_DEBUG(Service_Y2R, "called rotation=%hhu", conversion.rotation);
+    LOG_DEBUG(Service_Y2R, "called rotation=%hhu", static_cast<u8>(conversion.rotation));
 }
 
 static void SetBlockAlignment(Interface* self) {
@@ -154,7 +177,8 @@ static void SetBlockAlignment(Interface* self) {
     cmd_buff[0] = IPC::MakeHeader(0x7, 1, 0);
     cmd_buff[1] = RESULT_SUCCESS.raw;
 
-    LOG_DEBUG(Service_Y2R, "called block_alignment=%hhu", conversion.block_alignment);
+    LOG_DEBUG(Service_Y2R, "called block_alignment=%hhu",
+              static_cast<u8>(conversion.block_alignment));
 }
 
 static void GetBlockAlignment(Interface* self) {
@@ -164,7 +188,8 @@ static void GetBlockAlignment(Interface* self) {
     cmd_buff[1] = RESULT_SUCCESS.raw;
     cmd_buff[2] = static_cast<u32>(conversion.block_alignment);
 
-    LOG_DEBUG(Service_Y2R, "called block_alignment=%hhu", conversion.block_alignment);
+    LOG_DEBUG(Service_Y2R, "called block_alignment=%hhu",
+              static_cast<u8>(conversion.block_alignment));
 }
 
 /**
@@ -590,9 +615,14 @@ static void StartConversion(Interface* self) {
     Memory::RasterizerFlushVirtualRegion(conversion.dst.address, total_output_size,
                                          Memory::FlushMode::FlushAndInvalidate);
 
+    // The conversion is done right away, while the guest memory it uses is known to be mapped,
+    // but the guest keeps running for the time the hardware takes before it's told it's done
+    CancelPendingConversion();
     HW::Y2R::PerformConversion(conversion);
 
-    completion_event->Signal();
+    conversion_pending = true;
+    const u64 num_pixels = static_cast<u64>(conversion.input_line_width) * conversion.input_lines;
+    CoreTiming::ScheduleEvent(num_pixels * CONVERSION_CYCLES_PER_PIXEL, conversion_done_event);
 
     cmd_buff[0] = IPC::MakeHeader(0x26, 1, 0);
     cmd_buff[1] = RESULT_SUCCESS.raw;
@@ -603,6 +633,9 @@ static void StartConversion(Interface* self) {
 static void StopConversion(Interface* self) {
     u32* cmd_buff = Kernel::GetCommandBuffer();
 
+    // The conversion can't be interrupted halfway, but its completion is no longer signalled
+    CancelPendingConversion();
+
     cmd_buff[0] = IPC::MakeHeader(0x27, 1, 0);
     cmd_buff[1] = RESULT_SUCCESS.raw;
 
@@ -620,7 +653,7 @@ static void IsBusyConversion(Interface* self) {
 
     cmd_buff[0] = IPC::MakeHeader(0x28, 2, 0);
     cmd_buff[1] = RESULT_SUCCESS.raw;
-    cmd_buff[2] = 0; // StartConversion always finishes immediately
+    cmd_buff[2] = conversion_pending ? 1 : 0;
 
     LOG_DEBUG(Service_Y2R, "called");
 }
@@ -664,9 +697,10 @@ cleanup:
         Service_Y2R,
         "called input_format=%hhu output_format=%hhu rotation=%hhu block_alignment=%hhu "
         "input_line_width=%hu input_lines=%hu standard_coefficient=%hhu reserved=%hhu alpha=%hX",
-        params->input_format, params->output_format, params->rotation, params->block_alignment,
-        params->input_line_width, params->input_lines, params->standard_coefficient,
-        params->padding, params->alpha);
+        static_cast<u8>(params->input_format), static_cast<u8>(params->output_format),
+        static_cast<u8>(params->rotation), static_cast<u8>(params->block_alignment),
+        params->input_line_width, params->input_lines,
+        static_cast<u8>(params->standard_coefficient), params->padding, params->alpha);
 }
 
 static void PingProcess(Interface* self) {
@@ -708,6 +742,8 @@ static void DriverInitialize(Interface* self) {
 static void DriverFinalize(Interface* self) {
     u32* cmd_buff = Kernel::GetCommandBuffer();
 
+    CancelPendingConversion();
+
     cmd_buff[0] = IPC::MakeHeader(0x2C, 1, 0);
     cmd_buff[1] = RESULT_SUCCESS.raw;
 
@@ -775,11 +811,13 @@ const Interface::FunctionInfo FunctionTable[] = {
 Y2R_U::Y2R_U() {
     completion_event = Kernel::Event::Create(Kernel::ResetType::OneShot, "Y2R:Completed");
     std::memset(&conversion, 0, sizeof(conversion));
+    conversion_done_event = CoreTiming::RegisterEvent("Y2R:ConversionDone", ConversionDone);
 
     Register(FunctionTable);
 }
 
 Y2R_U::~Y2R_U() {
+    CancelPendingConversion();
     completion_event = nullptr;
 }
 
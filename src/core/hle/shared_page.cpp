@@ -8,6 +8,7 @@
 #include "core/core_timing.h"
 #include "core/hle/service/ptm/ptm.h"
 #include "core/hle/shared_page.h"
+#include "core/movie.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -17,8 +18,7 @@ SharedPageDef shared_page;
 
 static int update_time_event;
 
-/// Gets system time in 3DS format. The epoch is Jan 1900, and the unit is millisecond.
-static u64 GetSystemTime() {
+u64 GetSystemTime() {
     auto now = std::chrono::system_clock::now();
 
     // 3DS system does't allow user to set a time before Jan 1 2000,
@@ -55,7 +55,10 @@ static void UpdateTimeCallback(u64 userdata, int cycles_late) {
     DateTime& date_time =
         shared_page.date_time_counter % 2 ? shared_page.date_time_0 : shared_page.date_time_1;
 
-    date_time.date_time = GetSystemTime();
+    // Movies pin the time to when they were recorded, advancing it with emulated time only
+    date_time.date_time = Movie::IsActive()
+                              ? Movie::GetInitTime() + cyclesToMs(CoreTiming::GetTicks())
+                              : GetSystemTime();
     date_time.update_tick = CoreTiming::GetTicks();
     date_time.tick_to_second_coefficient = g_clock_rate_arm11;
     date_time.tick_offset = 0;
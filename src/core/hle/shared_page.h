@@ -66,4 +66,7 @@ extern SharedPageDef shared_page;
 
 void Init();
 
+/// Gets the host's system time in 3DS format. The epoch is Jan 1900, and the unit is millisecond.
+u64 GetSystemTime();
+
 } // namespace
@@ -106,6 +106,8 @@ static ResultCode ControlMemory(u32* out_addr, u32 operation, u32 addr0, u32 add
         } else {
             return ERR_INVALID_ADDRESS;
         }
+        // Code may have run from the freed memory, and whatever gets mapped there next differs
+        Core::CPU().InvalidateCacheRange(addr0, size);
         *out_addr = addr0;
         break;
     }
@@ -132,6 +134,7 @@ static ResultCode ControlMemory(u32* out_addr, u32 operation, u32 addr0, u32 add
             ResultCode result = process.HeapFree(addr0, size);
             if (result.IsError())
                 return result;
+            Core::CPU().InvalidateCacheRange(addr0, size);
             break;
         }
 
@@ -255,7 +258,7 @@ static ResultCode WaitSynchronization1(Kernel::Handle handle, s64 nano_seconds)
     if (object == nullptr)
         return ERR_INVALID_HANDLE;
 
-    LOG_TRACE(Kernel_SVC, "called handle=0x%08X(%s:%s), nanoseconds=%lld", handle,
+    LOG_TRACE(Kernel_SVC, "called handle=0x%08X(%s:%s), nanoseconds=%" PRId64, handle,
               object->GetTypeName().c_str(), object->GetName().c_str(), nano_seconds);
 
     if (object->ShouldWait(thread)) {
@@ -263,9 +266,7 @@ static ResultCode WaitSynchronization1(Kernel::Handle handle, s64 nano_seconds)
         if (nano_seconds == 0)
             return Kernel::RESULT_TIMEOUT;
 
-        thread->wait_objects = {object};
-        object->AddWaitingThread(thread);
-        thread->status = THREADSTATUS_WAIT_SYNCH_ANY;
+        thread->WaitOnObjects({object}, THREADSTATUS_WAIT_SYNCH_ANY);
 
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
@@ -300,21 +301,16 @@ static ResultCode WaitSynchronizationN(s32* out, Kernel::Handle* handles, s32 ha
     if (handle_count < 0)
         return Kernel::ERR_OUT_OF_RANGE;
 
-    using ObjectPtr = Kernel::SharedPtr<Kernel::WaitObject>;
-    std::vector<ObjectPtr> objects(handle_count);
-
-    for (int i = 0; i < handle_count; ++i) {
-        auto object = Kernel::g_handle_table.Get<Kernel::WaitObject>(handles[i]);
-        if (object == nullptr)
-            return ERR_INVALID_HANDLE;
-        objects[i] = object;
-    }
+    Kernel::WaitObjectList objects;
+    bool ready;
+    s32 ready_index;
+    ResultCode result = Kernel::LookUpWaitObjects(objects, handles, handle_count, thread, wait_all,
+                                                  ready, ready_index);
+    if (result.IsError())
+        return result;
 
     if (wait_all) {
-        bool all_available =
-            std::all_of(objects.begin(), objects.end(),
-                        [thread](const ObjectPtr& object) { return !object->ShouldWait(thread); });
-        if (all_available) {
+        if (ready) {
             // We can acquire all objects right now, do so.
             for (auto& object : objects)
                 object->Acquire(thread);
@@ -330,15 +326,8 @@ static ResultCode WaitSynchronizationN(s32* out, Kernel::Handle* handles, s32 ha
         if (nano_seconds == 0)
             return Kernel::RESULT_TIMEOUT;
 
-        // Put the thread to sleep
-        thread->status = THREADSTATUS_WAIT_SYNCH_ALL;
-
-        // Add the thread to each of the objects' waiting threads.
-        for (auto& object : objects) {
-            object->AddWaitingThread(thread);
-        }
-
-        thread->wait_objects = std::move(objects);
+        // Put the thread to sleep on all of the objects
+        thread->WaitOnObjects(std::move(objects), THREADSTATUS_WAIT_SYNCH_ALL);
 
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
@@ -351,16 +340,10 @@ static ResultCode WaitSynchronizationN(s32* out, Kernel::Handle* handles, s32 ha
         // a signal in one of its wait objects.
         return Kernel::RESULT_TIMEOUT;
     } else {
-        // Find the first object that is acquirable in the provided list of objects
-        auto itr = std::find_if(objects.begin(), objects.end(), [thread](const ObjectPtr& object) {
-            return !object->ShouldWait(thread);
-        });
-
-        if (itr != objects.end()) {
+        if (ready) {
             // We found a ready object, acquire it and set the result value
-            Kernel::WaitObject* object = itr->get();
-            object->Acquire(thread);
-            *out = std::distance(objects.begin(), itr);
+            objects[ready_index]->Acquire(thread);
+            *out = ready_index;
             return RESULT_SUCCESS;
         }
 
@@ -371,16 +354,8 @@ static ResultCode WaitSynchronizationN(s32* out, Kernel::Handle* handles, s32 ha
         if (nano_seconds == 0)
             return Kernel::RESULT_TIMEOUT;
 
-        // Put the thread to sleep
-        thread->status = THREADSTATUS_WAIT_SYNCH_ANY;
-
-        // Add the thread to each of the objects' waiting threads.
-        for (size_t i = 0; i < objects.size(); ++i) {
-            Kernel::WaitObject* object = objects[i].get();
-            object->AddWaitingThread(thread);
-        }
-
-        thread->wait_objects = std::move(objects);
+        // Put the thread to sleep on any of the objects
+        thread->WaitOnObjects(std::move(objects), THREADSTATUS_WAIT_SYNCH_ANY);
 
         // Note: If no handles and no timeout were given, then the thread will deadlock, this is
         // consistent with hardware behavior.
@@ -411,13 +386,14 @@ static ResultCode ReplyAndReceive(s32* index, Kernel::Handle* handles, s32 handl
         return Kernel::ERR_OUT_OF_RANGE;
 
     using ObjectPtr = SharedPtr<Kernel::WaitObject>;
-    std::vector<ObjectPtr> objects(handle_count);
+    Kernel::WaitObjectList objects;
+    objects.reserve(handle_count);
 
     for (int i = 0; i < handle_count; ++i) {
         auto object = Kernel::g_handle_table.Get<Kernel::WaitObject>(handles[i]);
         if (object == nullptr)
             return ERR_INVALID_HANDLE;
-        objects[i] = object;
+        objects.push_back(std::move(object));
     }
 
     // We are also sending a command reply.
@@ -484,16 +460,8 @@ static ResultCode ReplyAndReceive(s32* index, Kernel::Handle* handles, s32 handl
 
     // TODO(Subv): Perform IPC translation upon wakeup.
 
-    // Put the thread to sleep
-    thread->status = THREADSTATUS_WAIT_SYNCH_ANY;
-
-    // Add the thread to each of the objects' waiting threads.
-    for (size_t i = 0; i < objects.size(); ++i) {
-        Kernel::WaitObject* object = objects[i].get();
-        object->AddWaitingThread(thread);
-    }
-
-    thread->wait_objects = std::move(objects);
+    // Put the thread to sleep on any of the objects
+    thread->WaitOnObjects(std::move(objects), THREADSTATUS_WAIT_SYNCH_ANY);
 
     Core::System::GetInstance().PrepareReschedule();
 
@@ -956,7 +924,7 @@ static ResultCode CancelTimer(Kernel::Handle handle) {
 
 /// Sleep the current thread
 static void SleepThread(s64 nanoseconds) {
-    LOG_TRACE(Kernel_SVC, "called nanoseconds=%lld", nanoseconds);
+    LOG_TRACE(Kernel_SVC, "called nanoseconds=%" PRId64, nanoseconds);
 
     // Don't attempt to yield execution if there are no available threads to run,
     // this way we avoid a useless reschedule to the idle thread.
@@ -2,28 +2,40 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
+#include <functional>
+#include <limits>
+#include <mutex>
 #include <numeric>
 #include <type_traits>
+#include <vector>
 #include "common/alignment.h"
 #include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/core_timing.h"
 #include "core/hle/service/gsp_gpu.h"
 #include "core/hw/gpu.h"
 #include "core/hw/hw.h"
 #include "core/memory.h"
+#include "core/perf_stats.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/utils.h"
 #include "video_core/video_core.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace GPU {
 
 Regs g_regs;
@@ -33,6 +45,90 @@ const u64 frame_ticks = BASE_CLOCK_RATE_ARM11 / SCREEN_REFRESH_RATE;
 /// Event id for CoreTiming
 static int vblank_event;
 
+/// Emulated time after which the work queued on the GPU thread is considered done
+const u64 gpu_work_ticks = BASE_CLOCK_RATE_ARM11 / 1000;
+/// Event id for CoreTiming
+static int gpu_work_done_event;
+
+/// An interrupt raised by work on the GPU thread, held back until the emulation thread catches up
+struct DeferredInterrupt {
+    u64 fence;
+    Service::GSP::InterruptId id;
+};
+
+static std::mutex deferred_interrupts_mutex;
+static std::vector<DeferredInterrupt> deferred_interrupts;
+
+void SignalInterrupt(Service::GSP::InterruptId id) {
+    const auto& gpu_thread = VideoCore::g_gpu_thread;
+    if (gpu_thread == nullptr || !gpu_thread->IsGPUThread()) {
+        Service::GSP::SignalInterrupt(id);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(deferred_interrupts_mutex);
+    deferred_interrupts.push_back({gpu_thread->CurrentFence(), id});
+}
+
+/// Signals the deferred interrupts of the work up to the given fence, in the order they were raised
+static void SignalDeferredInterrupts(u64 fence) {
+    std::vector<DeferredInterrupt> ready;
+    {
+        std::lock_guard<std::mutex> lock(deferred_interrupts_mutex);
+        auto not_ready = std::stable_partition(
+            deferred_interrupts.begin(), deferred_interrupts.end(),
+            [fence](const DeferredInterrupt& interrupt) { return interrupt.fence <= fence; });
+        ready.assign(deferred_interrupts.begin(), not_ready);
+        deferred_interrupts.erase(deferred_interrupts.begin(), not_ready);
+    }
+
+    for (const auto& interrupt : ready)
+        Service::GSP::SignalInterrupt(interrupt.id);
+}
+
+static void GPUWorkDoneCallback(u64 fence, int cycles_late) {
+    if (VideoCore::g_gpu_thread == nullptr)
+        return;
+
+    VideoCore::g_gpu_thread->WaitForFence(fence);
+    // The application may access the memory of surfaces the work created once it's signaled
+    Memory::RasterizerApplyQueuedMarks();
+    SignalDeferredInterrupts(fence);
+}
+
+/// Waits for the GPU thread to catch up, signaling the interrupts its work raised
+static void SynchronizeGPUThread() {
+    if (VideoCore::g_gpu_thread == nullptr)
+        return;
+
+    VideoCore::SynchronizeGPUThread();
+    SignalDeferredInterrupts(std::numeric_limits<u64>::max());
+}
+
+/**
+ * Whether GPU work goes to the GPU thread. The OpenGL rasterizer is bound to the thread owning its
+ * GL context, which is the GPU thread only if that has a context of its own, and CiTrace recording
+ * needs to see memory as the GPU reads it. Otherwise, both keep all work on the emulation thread.
+ */
+static bool UseGPUThread() {
+    return VideoCore::g_gpu_thread != nullptr &&
+           (VideoCore::g_gpu_thread->HasContext() ||
+            !VideoCore::g_renderer->IsOpenGLRasterizerActive()) &&
+           !(Pica::g_debug_context && Pica::g_debug_context->recorder);
+}
+
+/// Runs GPU work, either queued on the GPU thread or right away once the GPU thread is idle
+static void RunGPUWork(std::function<void()> work) {
+    if (UseGPUThread()) {
+        const u64 fence = VideoCore::g_gpu_thread->Push(std::move(work));
+        CoreTiming::ScheduleEvent(gpu_work_ticks, gpu_work_done_event, fence);
+        return;
+    }
+
+    SynchronizeGPUThread();
+    work();
+}
+
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
     u32 addr = raw_addr - HW::VADDR_GPU;
@@ -47,8 +143,9 @@ inline void Read(T& var, const u32 raw_addr) {
     var = g_regs[addr / 4];
 }
 
-static Math::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
-    switch (input_format) {
+template <Regs::PixelFormat format>
+static Math::Vec4<u8> DecodePixel(const u8* src_pixel) {
+    switch (format) {
     case Regs::PixelFormat::RGBA8:
         return Color::DecodeRGBA8(src_pixel);
 
@@ -62,14 +159,173 @@ static Math::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_
         return Color::DecodeRGB5A1(src_pixel);
 
     case Regs::PixelFormat::RGBA4:
+    default:
         return Color::DecodeRGBA4(src_pixel);
+    }
+}
+
+template <Regs::PixelFormat format>
+static void EncodePixel(const Math::Vec4<u8>& color, u8* dst_pixel) {
+    switch (format) {
+    case Regs::PixelFormat::RGBA8:
+        Color::EncodeRGBA8(color, dst_pixel);
+        break;
 
+    case Regs::PixelFormat::RGB8:
+        Color::EncodeRGB8(color, dst_pixel);
+        break;
+
+    case Regs::PixelFormat::RGB565:
+        Color::EncodeRGB565(color, dst_pixel);
+        break;
+
+    case Regs::PixelFormat::RGB5A1:
+        Color::EncodeRGB5A1(color, dst_pixel);
+        break;
+
+    case Regs::PixelFormat::RGBA4:
+    default:
+        Color::EncodeRGBA4(color, dst_pixel);
+        break;
+    }
+}
+
+/// Offset of a pixel from the start of its row, for a row of a linear or tiled image
+static u32 GetPixelOffset(bool tiled, u32 x, u32 bytes_per_pixel) {
+    return tiled ? VideoCore::GetMortonOffset(x, 0, bytes_per_pixel) : x * bytes_per_pixel;
+}
+
+/// Offset of what GetPixelOffset considers the start of a row of a linear or tiled image
+static u32 GetRowOffset(bool tiled, u32 y, u32 width, u32 bytes_per_pixel) {
+    if (!tiled)
+        return y * width * bytes_per_pixel;
+    return VideoCore::GetMortonOffset(0, y, bytes_per_pixel) + (y & ~7) * width * bytes_per_pixel;
+}
+
+using ScalingMode = Regs::DisplayTransferConfig::ScalingMode;
+
+/**
+ * Converts one row of a display transfer.
+ * @param src_offsets Offsets of the source pixel of each output pixel, relative to src_row. With
+ *                    scaling, the pixels averaged with it follow it in memory.
+ * @param dst_offsets Offsets of each output pixel, relative to dst_row
+ */
+using TransferRowFunction = void (*)(const u8* src_row, u8* dst_row, const u32* src_offsets,
+                                     const u32* dst_offsets, u32 width);
+
+template <Regs::PixelFormat input_format, Regs::PixelFormat output_format, ScalingMode scaling>
+static void TransferRow(const u8* src_row, u8* dst_row, const u32* src_offsets,
+                        const u32* dst_offsets, u32 width) {
+    const u32 src_bytes_per_pixel = Regs::BytesPerPixel(input_format);
+
+    for (u32 x = 0; x < width; ++x) {
+        const u8* src_pixel = src_row + src_offsets[x];
+        Math::Vec4<u8> src_color = DecodePixel<input_format>(src_pixel);
+        if (scaling == Regs::DisplayTransferConfig::ScaleX) {
+            Math::Vec4<u8> pixel = DecodePixel<input_format>(src_pixel + src_bytes_per_pixel);
+            src_color = ((src_color + pixel) / 2).Cast<u8>();
+        } else if (scaling == Regs::DisplayTransferConfig::ScaleXY) {
+            Math::Vec4<u8> pixel1 = DecodePixel<input_format>(src_pixel + 1 * src_bytes_per_pixel);
+            Math::Vec4<u8> pixel2 = DecodePixel<input_format>(src_pixel + 2 * src_bytes_per_pixel);
+            Math::Vec4<u8> pixel3 = DecodePixel<input_format>(src_pixel + 3 * src_bytes_per_pixel);
+            src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+        }
+        EncodePixel<output_format>(src_color, dst_row + dst_offsets[x]);
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+/// Stores four RGBA8 pixels as RGB8, writing two bytes past the twelve taken by the pixels
+static void StoreRGB8(u8* dst, __m128i pixels) {
+    // Drop the alpha byte of each pixel, then close the gap between the two pixels of each half
+    const __m128i low_pixel_mask = _mm_set_epi32(0, -1, 0, -1);
+    pixels = _mm_srli_epi32(pixels, 8);
+    pixels = _mm_or_si128(_mm_and_si128(pixels, low_pixel_mask),
+                          _mm_srli_epi64(_mm_andnot_si128(low_pixel_mask, pixels), 8));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), pixels);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 6), _mm_unpackhi_epi64(pixels, pixels));
+}
+
+/// Loads two horizontally adjacent pixels, which both linear and tiled images store next to each
+/// other, from a row of RGBA8 pixels
+static __m128i LoadRGBA8Pair(const u8* src_row, const u32* src_offsets, u32 x) {
+    return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src_row + src_offsets[x]));
+}
+
+/// TransferRow for unscaled RGBA8 to RGB8 transfers with linear output, by far the most common
+/// kind as it presents the rendered top screen
+static void TransferRowRGBA8ToLinearRGB8(const u8* src_row, u8* dst_row, const u32* src_offsets,
+                                         const u32* dst_offsets, u32 width) {
+    // The stores of each group of eight pixels spill into the next pixel, so the last group of the
+    // row is left to the generic function
+    u32 x = 0;
+    for (; x + 8 < width; x += 8) {
+        StoreRGB8(dst_row + x * 3, _mm_unpacklo_epi64(LoadRGBA8Pair(src_row, src_offsets, x),
+                                                      LoadRGBA8Pair(src_row, src_offsets, x + 2)));
+        StoreRGB8(dst_row + x * 3 + 12,
+                  _mm_unpacklo_epi64(LoadRGBA8Pair(src_row, src_offsets, x + 4),
+                                     LoadRGBA8Pair(src_row, src_offsets, x + 6)));
+    }
+    TransferRow<Regs::PixelFormat::RGBA8, Regs::PixelFormat::RGB8, ScalingMode::NoScale>(
+        src_row, dst_row, src_offsets + x, dst_offsets + x, width - x);
+}
+#endif
+
+template <Regs::PixelFormat input_format, Regs::PixelFormat output_format>
+static TransferRowFunction GetTransferRowFunction(ScalingMode scaling) {
+    switch (scaling) {
+    case ScalingMode::ScaleX:
+        return &TransferRow<input_format, output_format, ScalingMode::ScaleX>;
+    case ScalingMode::ScaleXY:
+        return &TransferRow<input_format, output_format, ScalingMode::ScaleXY>;
     default:
-        LOG_ERROR(HW_GPU, "Unknown source framebuffer format %x", input_format);
-        return {0, 0, 0, 0};
+        return &TransferRow<input_format, output_format, ScalingMode::NoScale>;
     }
 }
 
+template <Regs::PixelFormat input_format>
+static TransferRowFunction GetTransferRowFunction(Regs::PixelFormat output_format,
+                                                  ScalingMode scaling) {
+    switch (output_format) {
+    case Regs::PixelFormat::RGBA8:
+        return GetTransferRowFunction<input_format, Regs::PixelFormat::RGBA8>(scaling);
+    case Regs::PixelFormat::RGB8:
+        return GetTransferRowFunction<input_format, Regs::PixelFormat::RGB8>(scaling);
+    case Regs::PixelFormat::RGB565:
+        return GetTransferRowFunction<input_format, Regs::PixelFormat::RGB565>(scaling);
+    case Regs::PixelFormat::RGB5A1:
+        return GetTransferRowFunction<input_format, Regs::PixelFormat::RGB5A1>(scaling);
+    case Regs::PixelFormat::RGBA4:
+        return GetTransferRowFunction<input_format, Regs::PixelFormat::RGBA4>(scaling);
+    default:
+        LOG_ERROR(HW_GPU, "Unknown destination framebuffer format %x", output_format);
+        return nullptr;
+    }
+}
+
+/// Returns the row conversion specialized for the formats and scaling mode of a transfer
+static TransferRowFunction GetTransferRowFunction(const Regs::DisplayTransferConfig& config) {
+    const ScalingMode scaling = config.scaling;
+    switch (config.input_format) {
+    case Regs::PixelFormat::RGBA8:
+        return GetTransferRowFunction<Regs::PixelFormat::RGBA8>(config.output_format, scaling);
+    case Regs::PixelFormat::RGB8:
+        return GetTransferRowFunction<Regs::PixelFormat::RGB8>(config.output_format, scaling);
+    case Regs::PixelFormat::RGB565:
+        return GetTransferRowFunction<Regs::PixelFormat::RGB565>(config.output_format, scaling);
+    case Regs::PixelFormat::RGB5A1:
+        return GetTransferRowFunction<Regs::PixelFormat::RGB5A1>(config.output_format, scaling);
+    case Regs::PixelFormat::RGBA4:
+        return GetTransferRowFunction<Regs::PixelFormat::RGBA4>(config.output_format, scaling);
+    default:
+        LOG_ERROR(HW_GPU, "Unknown source framebuffer format %x", config.input_format.Value());
+        return nullptr;
+    }
+}
+
+/// Display transfers producing at least this many pixels are split across multiple threads
+constexpr u32 PARALLEL_TRANSFER_PIXELS = 128 * 128;
+
 MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
 MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
 
@@ -201,112 +457,54 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerFlushAndInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
 
-    for (u32 y = 0; y < output_height; ++y) {
-        for (u32 x = 0; x < output_width; ++x) {
-            Math::Vec4<u8> src_color;
-
-            // Calculate the [x,y] position of the input image
-            // based on the current output position and the scale
-            u32 input_x = x << horizontal_scale;
-            u32 input_y = y << vertical_scale;
-
-            u32 output_y;
-            if (config.flip_vertically) {
-                // Flip the y value of the output data,
-                // we do this after calculating the [x,y] position of the input image
-                // to account for the scaling options.
-                output_y = output_height - y - 1;
-            } else {
-                output_y = y;
-            }
-
-            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
-            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
-            u32 src_offset;
-            u32 dst_offset;
-
-            if (config.input_linear) {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as linear and the output as tiled
-                    u32 coarse_y = output_y & ~7;
-                    u32 stride = output_width * dst_bytes_per_pixel;
-
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 coarse_y * stride;
-                } else {
-                    // Both input and output are linear
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                }
-            } else {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as tiled and the output as linear
-                    u32 coarse_y = input_y & ~7;
-                    u32 stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 coarse_y * stride;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                } else {
-                    // Both input and output are tiled
-                    u32 out_coarse_y = output_y & ~7;
-                    u32 out_stride = output_width * dst_bytes_per_pixel;
-
-                    u32 in_coarse_y = input_y & ~7;
-                    u32 in_stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 in_coarse_y * in_stride;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 out_coarse_y * out_stride;
-                }
-            }
-
-            const u8* src_pixel = src_pointer + src_offset;
-            src_color = DecodePixel(config.input_format, src_pixel);
-            if (config.scaling == config.ScaleX) {
-                Math::Vec4<u8> pixel =
-                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
-                src_color = ((src_color + pixel) / 2).Cast<u8>();
-            } else if (config.scaling == config.ScaleXY) {
-                Math::Vec4<u8> pixel1 =
-                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
-                Math::Vec4<u8> pixel2 =
-                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
-                Math::Vec4<u8> pixel3 =
-                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
-                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
-            }
-
-            u8* dst_pixel = dst_pointer + dst_offset;
-            switch (config.output_format) {
-            case Regs::PixelFormat::RGBA8:
-                Color::EncodeRGBA8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB8:
-                Color::EncodeRGB8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB565:
-                Color::EncodeRGB565(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB5A1:
-                Color::EncodeRGB5A1(src_color, dst_pixel);
-                break;
+    TransferRowFunction transfer_row = GetTransferRowFunction(config);
+    if (transfer_row == nullptr)
+        return;
 
-            case Regs::PixelFormat::RGBA4:
-                Color::EncodeRGBA4(src_color, dst_pixel);
-                break;
+    // Linear input is written tiled and tiled input linear, unless swizzling is disabled
+    const bool input_tiled = !config.input_linear;
+    const bool output_tiled = config.input_linear != config.dont_swizzle;
+    const u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
+    const u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
+
+    // The layout of each row only differs by the offset of its first pixel
+    std::vector<u32> src_offsets(output_width);
+    std::vector<u32> dst_offsets(output_width);
+    for (u32 x = 0; x < output_width; ++x) {
+        src_offsets[x] = GetPixelOffset(input_tiled, x << horizontal_scale, src_bytes_per_pixel);
+        dst_offsets[x] = GetPixelOffset(output_tiled, x, dst_bytes_per_pixel);
+    }
 
-            default:
-                LOG_ERROR(HW_GPU, "Unknown destination framebuffer format %x",
-                          config.output_format.Value());
-                break;
-            }
+#ifdef ARCHITECTURE_x86_64
+    if (config.input_format == Regs::PixelFormat::RGBA8 &&
+        config.output_format == Regs::PixelFormat::RGB8 && config.scaling == config.NoScale &&
+        !output_tiled) {
+        transfer_row = &TransferRowRGBA8ToLinearRGB8;
+    }
+#endif
+
+    auto TransferRows = [&](size_t begin, size_t end) {
+        for (u32 y = static_cast<u32>(begin); y < end; ++y) {
+            // Flip the y value of the output data after calculating the position of the input
+            // image, to account for the scaling options
+            const u32 input_y = y << vertical_scale;
+            const u32 output_y = config.flip_vertically ? output_height - y - 1 : y;
+
+            const u32 src_row =
+                GetRowOffset(input_tiled, input_y, config.input_width, src_bytes_per_pixel);
+            const u32 dst_row =
+                GetRowOffset(output_tiled, output_y, output_width, dst_bytes_per_pixel);
+            transfer_row(src_pointer + src_row, dst_pointer + dst_row, src_offsets.data(),
+                         dst_offsets.data(), output_width);
         }
+    };
+
+    // Rows are handed out a tile row at a time, which keeps threads from sharing cache lines
+    Common::ThreadPool& pool = Common::GetSharedThreadPool();
+    if (output_width * output_height >= PARALLEL_TRANSFER_PIXELS && pool.NumThreads() > 1) {
+        pool.ParallelFor(output_height, 8, TransferRows);
+    } else {
+        TransferRows(0, output_height);
     }
 }
 
@@ -390,106 +588,149 @@ static void TextureCopy(const Regs::DisplayTransferConfig& config) {
     }
 }
 
-template <typename T>
-inline void Write(u32 addr, const T data) {
-    addr -= HW::VADDR_GPU;
-    u32 index = addr / 4;
-
-    // Writes other than u32 are untested, so I'd rather have them abort than silently fail
-    if (index >= Regs::NumIds() || !std::is_same<T, u32>::value) {
-        LOG_ERROR(HW_GPU, "unknown Write%lu 0x%08X @ 0x%08X", sizeof(data) * 8, (u32)data, addr);
-        return;
-    }
-
-    g_regs[index] = static_cast<u32>(data);
-
-    switch (index) {
+// Memory fills are triggered once the fill value is written.
+static void WriteMemoryFillTrigger(u32 index) {
+    const bool is_second_filler = (index != GPU_REG_INDEX(memory_fill_config[0].trigger));
+    auto& config = g_regs.memory_fill_config[is_second_filler];
 
-    // Memory fills are triggered once the fill value is written.
-    case GPU_REG_INDEX_WORKAROUND(memory_fill_config[0].trigger, 0x00004 + 0x3):
-    case GPU_REG_INDEX_WORKAROUND(memory_fill_config[1].trigger, 0x00008 + 0x3): {
-        const bool is_second_filler = (index != GPU_REG_INDEX(memory_fill_config[0].trigger));
-        auto& config = g_regs.memory_fill_config[is_second_filler];
+    if (config.trigger) {
+        LOG_TRACE(HW_GPU, "MemoryFill from 0x%08x to 0x%08x", config.GetStartAddress(),
+                  config.GetEndAddress());
 
-        if (config.trigger) {
-            MemoryFill(config);
-            LOG_TRACE(HW_GPU, "MemoryFill from 0x%08x to 0x%08x", config.GetStartAddress(),
-                      config.GetEndAddress());
+        const Regs::MemoryFillConfig fill_config = config;
+        RunGPUWork([fill_config, is_second_filler] {
+            MemoryFill(fill_config);
 
             // It seems that it won't signal interrupt if "address_start" is zero.
             // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
+            if (fill_config.GetStartAddress() != 0) {
                 if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
+                    GPU::SignalInterrupt(Service::GSP::InterruptId::PSC0);
                 } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+                    GPU::SignalInterrupt(Service::GSP::InterruptId::PSC1);
                 }
             }
+        });
 
-            // Reset "trigger" flag and set the "finish" flag
-            // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
-            config.trigger.Assign(0);
-            config.finished.Assign(1);
-        }
-        break;
+        // Reset "trigger" flag and set the "finish" flag
+        // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
+        config.trigger.Assign(0);
+        config.finished.Assign(1);
     }
+}
 
-    case GPU_REG_INDEX(display_transfer_config.trigger): {
-        MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+static void WriteDisplayTransferTrigger(u32 index) {
+    const auto& config = g_regs.display_transfer_config;
+    if (config.trigger & 1) {
+        if (config.is_texture_copy) {
+            LOG_TRACE(HW_GPU, "TextureCopy: 0x%X bytes from 0x%08X(%u+%u)-> "
+                              "0x%08X(%u+%u), flags 0x%08X",
+                      config.texture_copy.size, config.GetPhysicalInputAddress(),
+                      config.texture_copy.input_width * 16, config.texture_copy.input_gap * 16,
+                      config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
+                      config.texture_copy.output_gap * 16, config.flags);
+        } else {
+            LOG_TRACE(HW_GPU, "DisplayTransfer: 0x%08x(%ux%u)-> "
+                              "0x%08x(%ux%u), dst format %x, flags 0x%08X",
+                      config.GetPhysicalInputAddress(), config.input_width.Value(),
+                      config.input_height.Value(), config.GetPhysicalOutputAddress(),
+                      config.output_width.Value(), config.output_height.Value(),
+                      static_cast<u32>(config.output_format.Value()), config.flags);
+        }
 
-        const auto& config = g_regs.display_transfer_config;
-        if (config.trigger & 1) {
+        const Regs::DisplayTransferConfig transfer_config = config;
+        RunGPUWork([transfer_config] {
+            MICROPROFILE_SCOPE(GPU_DisplayTransfer);
 
             if (Pica::g_debug_context)
                 Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
                                                nullptr);
 
-            if (config.is_texture_copy) {
-                TextureCopy(config);
-                LOG_TRACE(HW_GPU, "TextureCopy: 0x%X bytes from 0x%08X(%u+%u)-> "
-                                  "0x%08X(%u+%u), flags 0x%08X",
-                          config.texture_copy.size, config.GetPhysicalInputAddress(),
-                          config.texture_copy.input_width * 16, config.texture_copy.input_gap * 16,
-                          config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
-                          config.texture_copy.output_gap * 16, config.flags);
+            if (transfer_config.is_texture_copy) {
+                TextureCopy(transfer_config);
             } else {
-                DisplayTransfer(config);
-                LOG_TRACE(HW_GPU, "DisplayTransfer: 0x%08x(%ux%u)-> "
-                                  "0x%08x(%ux%u), dst format %x, flags 0x%08X",
-                          config.GetPhysicalInputAddress(), config.input_width.Value(),
-                          config.input_height.Value(), config.GetPhysicalOutputAddress(),
-                          config.output_width.Value(), config.output_height.Value(),
-                          config.output_format.Value(), config.flags);
+                DisplayTransfer(transfer_config);
             }
 
-            g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
-        }
-        break;
+            GPU::SignalInterrupt(Service::GSP::InterruptId::PPF);
+        });
+
+        g_regs.display_transfer_config.trigger = 0;
     }
+}
 
-    // Seems like writing to this register triggers processing
-    case GPU_REG_INDEX(command_processor_config.trigger): {
-        const auto& config = g_regs.command_processor_config;
-        if (config.trigger & 1) {
+// Seems like writing to this register triggers processing
+static void WriteCommandListTrigger(u32 index) {
+    const auto& config = g_regs.command_processor_config;
+    if (config.trigger & 1) {
+        const PAddr address = config.GetPhysicalAddress();
+        const u32 size = config.size;
+        RunGPUWork([address, size] {
             MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+            Core::ScopedPerfTimer perf_timer(Core::PerfStats::Category::CommandProcessing);
 
-            u32* buffer = (u32*)Memory::GetPhysicalPointer(config.GetPhysicalAddress());
+            u32* buffer = (u32*)Memory::GetPhysicalPointer(address);
 
             if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
-                Pica::g_debug_context->recorder->MemoryAccessed((u8*)buffer, config.size,
-                                                                config.GetPhysicalAddress());
+                Pica::g_debug_context->recorder->MemoryAccessed((u8*)buffer, size, address);
             }
 
-            Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
+            Pica::CommandProcessor::ProcessCommandList(buffer, size);
+        });
 
-            g_regs.command_processor_config.trigger = 0;
-        }
-        break;
+        g_regs.command_processor_config.trigger = 0;
     }
+}
 
-    default:
-        break;
+namespace {
+
+/// Handler run after a write to a register with side effects, given the register's index
+using RegisterWriteHandler = void (*)(u32 index);
+
+/// Handlers of the registers with side effects, referred to by the entries of the table below.
+/// Entry 0 stands for a plain store.
+constexpr RegisterWriteHandler register_write_handlers[] = {
+    nullptr,
+    WriteMemoryFillTrigger,
+    WriteDisplayTransferTrigger,
+    WriteCommandListTrigger,
+};
+
+/// Index into register_write_handlers for every register. Bytes are used rather than the handler
+/// pointers themselves to keep the table small enough to stay in the cache.
+struct RegisterWriteTable {
+    u8 handler[Regs::NumIds()];
+};
+
+constexpr RegisterWriteTable MakeRegisterWriteTable() {
+    RegisterWriteTable table{};
+    table.handler[GPU_REG_INDEX_WORKAROUND(memory_fill_config[0].trigger, 0x00004 + 0x3)] = 1;
+    table.handler[GPU_REG_INDEX_WORKAROUND(memory_fill_config[1].trigger, 0x00008 + 0x3)] = 1;
+    table.handler[GPU_REG_INDEX(display_transfer_config.trigger)] = 2;
+    table.handler[GPU_REG_INDEX(command_processor_config.trigger)] = 3;
+    return table;
+}
+
+constexpr RegisterWriteTable register_write_table = MakeRegisterWriteTable();
+
+} // Anonymous namespace
+
+template <typename T>
+inline void Write(u32 addr, const T data) {
+    addr -= HW::VADDR_GPU;
+    u32 index = addr / 4;
+
+    // Writes other than u32 are untested, so I'd rather have them abort than silently fail
+    if (index >= Regs::NumIds() || !std::is_same<T, u32>::value) {
+        LOG_ERROR(HW_GPU, "unknown Write%lu 0x%08X @ 0x%08X", sizeof(data) * 8, (u32)data, addr);
+        return;
+    }
+
+    g_regs[index] = static_cast<u32>(data);
+
+    const u8 handler = register_write_table.handler[index];
+    if (handler != 0) {
+        register_write_handlers[handler](index);
     }
 
     // Notify tracer about the register write
@@ -515,6 +756,8 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(u64 userdata, int cycles_late) {
+    // Presenting reads the framebuffers, and may switch to a rasterizer bound to this thread
+    SynchronizeGPUThread();
     VideoCore::g_renderer->SwapBuffers();
 
     // Signal to GSP that GPU interrupt has occurred
@@ -561,12 +804,19 @@ void Init() {
 
     vblank_event = CoreTiming::RegisterEvent("GPU::VBlankCallback", VBlankCallback);
     CoreTiming::ScheduleEvent(frame_ticks, vblank_event);
+    gpu_work_done_event =
+        CoreTiming::RegisterEvent("GPU::GPUWorkDoneCallback", GPUWorkDoneCallback);
 
     LOG_DEBUG(HW_GPU, "initialized OK");
 }
 
 /// Shutdown hardware
 void Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(deferred_interrupts_mutex);
+        deferred_interrupts.clear();
+    }
+
     LOG_DEBUG(HW_GPU, "shutdown OK");
 }
 
@@ -11,6 +11,12 @@
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 
+namespace Service {
+namespace GSP {
+enum class InterruptId : u8;
+}
+}
+
 namespace GPU {
 
 constexpr float SCREEN_REFRESH_RATE = 60;
@@ -325,6 +331,12 @@ void Read(T& var, const u32 addr);
 template <typename T>
 void Write(u32 addr, const T data);
 
+/**
+ * Signals a GSP interrupt raised by the emulated GPU. Interrupts raised by work on the GPU thread
+ * are held back until the emulation thread has waited for that work.
+ */
+void SignalInterrupt(Service::GSP::InterruptId id);
+
 /// Initialize hardware
 void Init();
 
@@ -11,27 +11,18 @@
 
 namespace HW {
 
+/// Size of the GPU register range starting at VADDR_GPU
+constexpr u32 GPU_REGS_SIZE = 0x10000;
+
 template <typename T>
 inline void Read(T& var, const u32 addr) {
-    switch (addr & 0xFFFFF000) {
-    case VADDR_GPU:
-    case VADDR_GPU + 0x1000:
-    case VADDR_GPU + 0x2000:
-    case VADDR_GPU + 0x3000:
-    case VADDR_GPU + 0x4000:
-    case VADDR_GPU + 0x5000:
-    case VADDR_GPU + 0x6000:
-    case VADDR_GPU + 0x7000:
-    case VADDR_GPU + 0x8000:
-    case VADDR_GPU + 0x9000:
-    case VADDR_GPU + 0xA000:
-    case VADDR_GPU + 0xB000:
-    case VADDR_GPU + 0xC000:
-    case VADDR_GPU + 0xD000:
-    case VADDR_GPU + 0xE000:
-    case VADDR_GPU + 0xF000:
+    // The GPU registers take nearly all accesses, so their range is checked first
+    if (addr - VADDR_GPU < GPU_REGS_SIZE) {
         GPU::Read(var, addr);
-        break;
+        return;
+    }
+
+    switch (addr & 0xFFFFF000) {
     case VADDR_LCD:
         LCD::Read(var, addr);
         break;
@@ -42,25 +33,13 @@ inline void Read(T& var, const u32 addr) {
 
 template <typename T>
 inline void Write(u32 addr, const T data) {
-    switch (addr & 0xFFFFF000) {
-    case VADDR_GPU:
-    case VADDR_GPU + 0x1000:
-    case VADDR_GPU + 0x2000:
-    case VADDR_GPU + 0x3000:
-    case VADDR_GPU + 0x4000:
-    case VADDR_GPU + 0x5000:
-    case VADDR_GPU + 0x6000:
-    case VADDR_GPU + 0x7000:
-    case VADDR_GPU + 0x8000:
-    case VADDR_GPU + 0x9000:
-    case VADDR_GPU + 0xA000:
-    case VADDR_GPU + 0xB000:
-    case VADDR_GPU + 0xC000:
-    case VADDR_GPU + 0xD000:
-    case VADDR_GPU + 0xE000:
-    case VADDR_GPU + 0xF000:
+    // The GPU registers take nearly all accesses, so their range is checked first
+    if (addr - VADDR_GPU < GPU_REGS_SIZE) {
         GPU::Write(addr, data);
-        break;
+        return;
+    }
+
+    switch (addr & 0xFFFFF000) {
     case VADDR_LCD:
         LCD::Write(addr, data);
         break;
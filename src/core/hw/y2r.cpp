@@ -5,16 +5,23 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
 #include "common/math_util.h"
+#include "common/swap.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hle/service/y2r_u.h"
 #include "core/hw/y2r.h"
 #include "core/memory.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace HW {
 namespace Y2R {
 
@@ -24,45 +31,161 @@ static const size_t MAX_TILES = 1024 / 8;
 static const size_t TILE_SIZE = 8 * 8;
 using ImageTile = std::array<u32, TILE_SIZE>;
 
+/// Reads the Y, U and V values of the pixel at (x, y) of the input strip.
+template <InputFormat input_format>
+static void ReadYUV(const u8* input_Y, const u8* input_U, const u8* input_V, unsigned int width,
+                    unsigned int x, unsigned int y, s32& Y, s32& U, s32& V) {
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+        Y = input_Y[y * width + x];
+        U = input_U[(y * width + x) / 2];
+        V = input_V[(y * width + x) / 2];
+        break;
+    case InputFormat::YUV420_Indiv8:
+    case InputFormat::YUV420_Indiv16:
+        Y = input_Y[y * width + x];
+        U = input_U[((y / 2) * width + x) / 2];
+        V = input_V[((y / 2) * width + x) / 2];
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        Y = input_Y[(y * width + x) * 2];
+        U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
+        V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
+        break;
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+/// Returns the 32-bit products of the 16-bit lanes of a and b, for lanes 0-3 and 4-7.
+static void Multiply32(__m128i a, __m128i b, __m128i& lo, __m128i& hi) {
+    const __m128i low_halves = _mm_mullo_epi16(a, b);
+    const __m128i high_halves = _mm_mulhi_epi16(a, b);
+    lo = _mm_unpacklo_epi16(low_halves, high_halves);
+    hi = _mm_unpackhi_epi16(low_halves, high_halves);
+}
+
+/**
+ * Reads the Y, U and V values of the 8 pixels starting at (x, y) of the input strip, as 16-bit
+ * lanes. x must be a multiple of 8.
+ */
+template <InputFormat input_format>
+static void ReadYUV8(const u8* input_Y, const u8* input_U, const u8* input_V, unsigned int width,
+                     unsigned int x, unsigned int y, __m128i& Y, __m128i& U, __m128i& V) {
+    const __m128i zero = _mm_setzero_si128();
+
+    if (input_format == InputFormat::YUYV422_Interleaved) {
+        // Y0 U0 Y1 V0 Y2 U1 Y3 V1 ...
+        const __m128i yuyv =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(input_Y + (y * width + x) * 2));
+        Y = _mm_and_si128(yuyv, _mm_set1_epi16(0xFF));
+        const __m128i uv = _mm_srli_epi16(yuyv, 8);
+        U = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)),
+                                _MM_SHUFFLE(2, 2, 0, 0));
+        V = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)),
+                                _MM_SHUFFLE(3, 3, 1, 1));
+        return;
+    }
+
+    size_t uv_offset = 0;
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+        uv_offset = (y * width + x) / 2;
+        break;
+    default:
+        uv_offset = ((y / 2) * width + x) / 2;
+        break;
+    }
+
+    u32 u_bytes, v_bytes;
+    std::memcpy(&u_bytes, input_U + uv_offset, sizeof(u32));
+    std::memcpy(&v_bytes, input_V + uv_offset, sizeof(u32));
+
+    Y = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(input_Y + y * width + x)), zero);
+    // Each chroma sample covers two horizontally adjacent pixels
+    const __m128i u = _mm_cvtsi32_si128(static_cast<int>(u_bytes));
+    const __m128i v = _mm_cvtsi32_si128(static_cast<int>(v_bytes));
+    U = _mm_unpacklo_epi8(_mm_unpacklo_epi8(u, u), zero);
+    V = _mm_unpacklo_epi8(_mm_unpacklo_epi8(v, v), zero);
+}
+#endif
+
 /// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
-static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
-                            const u8* input_V, ImageTile output[], unsigned int width,
-                            unsigned int height, const CoefficientSet& coefficients) {
+template <InputFormat input_format>
+static void ConvertYUVToRGB(const u8* input_Y, const u8* input_U, const u8* input_V,
+                            ImageTile output[], unsigned int width, unsigned int height,
+                            const CoefficientSet& coefficients) {
+    // This conversion process is bit-exact with hardware, as far as could be tested.
+    auto& c = coefficients;
+    const s32 rounding_offset = 0x18;
+
+#ifdef ARCHITECTURE_x86_64
+    const __m128i c0 = _mm_set1_epi16(c[0]);
+    const __m128i c1 = _mm_set1_epi16(c[1]);
+    const __m128i c2 = _mm_set1_epi16(c[2]);
+    const __m128i c3 = _mm_set1_epi16(c[3]);
+    const __m128i c4 = _mm_set1_epi16(c[4]);
+    const __m128i offset_r = _mm_set1_epi32(c[5] + rounding_offset);
+    const __m128i offset_g = _mm_set1_epi32(c[6] + rounding_offset);
+    const __m128i offset_b = _mm_set1_epi32(c[7] + rounding_offset);
+    const __m128i zero = _mm_setzero_si128();
+
+    // Computes (((sum >> 3) + offset) >> 5) and saturates it to 16 bits, which keeps its clamped
+    // 8-bit value
+    const auto scale = [](__m128i lo, __m128i hi, __m128i offset) {
+        lo = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(lo, 3), offset), 5);
+        hi = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(hi, 3), offset), 5);
+        return _mm_packs_epi32(lo, hi);
+    };
 
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; x += 8) {
+            __m128i Y, U, V;
+            ReadYUV8<input_format>(input_Y, input_U, input_V, width, x, y, Y, U, V);
+
+            __m128i cY_lo, cY_hi, c1V_lo, c1V_hi, c2V_lo, c2V_hi, c3U_lo, c3U_hi, c4U_lo, c4U_hi;
+            Multiply32(c0, Y, cY_lo, cY_hi);
+            Multiply32(c1, V, c1V_lo, c1V_hi);
+            Multiply32(c2, V, c2V_lo, c2V_hi);
+            Multiply32(c3, U, c3U_lo, c3U_hi);
+            Multiply32(c4, U, c4U_lo, c4U_hi);
+
+            const __m128i r = scale(_mm_add_epi32(cY_lo, c1V_lo), _mm_add_epi32(cY_hi, c1V_hi),
+                                    offset_r);
+            const __m128i g = scale(_mm_sub_epi32(_mm_sub_epi32(cY_lo, c2V_lo), c3U_lo),
+                                    _mm_sub_epi32(_mm_sub_epi32(cY_hi, c2V_hi), c3U_hi), offset_g);
+            const __m128i b = scale(_mm_add_epi32(cY_lo, c4U_lo), _mm_add_epi32(cY_hi, c4U_hi),
+                                    offset_b);
+
+            // Clamp to 8 bits and assemble the RGB32 words, with r in the top byte
+            const __m128i r8 = _mm_packus_epi16(r, r);
+            const __m128i g8 = _mm_packus_epi16(g, g);
+            const __m128i b8 = _mm_packus_epi16(b, b);
+            const __m128i zero_b = _mm_unpacklo_epi8(zero, b8);
+            const __m128i g_r = _mm_unpacklo_epi8(g8, r8);
+
+            // 8 pixels are exactly one row of a tile
+            u32* out = &output[x / 8][y * 8];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(zero_b, g_r));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(zero_b, g_r));
+        }
+    }
+#else
     for (unsigned int y = 0; y < height; ++y) {
         for (unsigned int x = 0; x < width; ++x) {
             s32 Y = 0;
             s32 U = 0;
             s32 V = 0;
-            switch (input_format) {
-            case InputFormat::YUV422_Indiv8:
-            case InputFormat::YUV422_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[(y * width + x) / 2];
-                V = input_V[(y * width + x) / 2];
-                break;
-            case InputFormat::YUV420_Indiv8:
-            case InputFormat::YUV420_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[((y / 2) * width + x) / 2];
-                V = input_V[((y / 2) * width + x) / 2];
-                break;
-            case InputFormat::YUYV422_Interleaved:
-                Y = input_Y[(y * width + x) * 2];
-                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
-                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
-                break;
-            }
+            ReadYUV<input_format>(input_Y, input_U, input_V, width, x, y, Y, U, V);
 
-            // This conversion process is bit-exact with hardware, as far as could be tested.
-            auto& c = coefficients;
             s32 cY = c[0] * Y;
 
             s32 r = cY + c[1] * V;
             s32 g = cY - c[2] * V - c[3] * U;
             s32 b = cY + c[4] * U;
 
-            const s32 rounding_offset = 0x18;
             r = (r >> 3) + c[5] + rounding_offset;
             g = (g >> 3) + c[6] + rounding_offset;
             b = (b >> 3) + c[7] + rounding_offset;
@@ -76,6 +199,28 @@ static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u
                    ((u32)Clamp(b >> 5, 0, 0xFF) << 8);
         }
     }
+#endif
+}
+
+static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
+                            const u8* input_V, ImageTile output[], unsigned int width,
+                            unsigned int height, const CoefficientSet& coefficients) {
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+        ConvertYUVToRGB<InputFormat::YUV422_Indiv8>(input_Y, input_U, input_V, output, width,
+                                                    height, coefficients);
+        break;
+    case InputFormat::YUV420_Indiv8:
+    case InputFormat::YUV420_Indiv16:
+        ConvertYUVToRGB<InputFormat::YUV420_Indiv8>(input_Y, input_U, input_V, output, width,
+                                                    height, coefficients);
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        ConvertYUVToRGB<InputFormat::YUYV422_Interleaved>(input_Y, input_U, input_V, output,
+                                                          width, height, coefficients);
+        break;
+    }
 }
 
 /// Simulates an incoming CDMA transfer. The N parameter is used to automatically convert 16-bit
@@ -101,38 +246,42 @@ static void ReceiveData(u8* output, ConversionBuffer& buf, size_t amount_of_data
     }
 }
 
+/// Encodes a RGB32 color from the intermediate format and returns the number of bytes written.
+template <OutputFormat output_format>
+static size_t EncodeColor(u32 color, u8 alpha, u8* output) {
+    if (output_format == OutputFormat::RGBA8) {
+        // The intermediate format already has the RGBA8 layout, only missing the alpha
+        const u32_le rgba = color | alpha;
+        std::memcpy(output, &rgba, sizeof(rgba));
+        return 4;
+    }
+
+    Math::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8), alpha};
+    switch (output_format) {
+    case OutputFormat::RGB8:
+        Color::EncodeRGB8(col_vec, output);
+        return 3;
+    case OutputFormat::RGB5A1:
+        Color::EncodeRGB5A1(col_vec, output);
+        return 2;
+    case OutputFormat::RGB565:
+        Color::EncodeRGB565(col_vec, output);
+        return 2;
+    default:
+        UNREACHABLE();
+    }
+}
+
 /// Convert intermediate RGB32 format to the final output format while simulating an outgoing CDMA
 /// transfer.
-static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data,
-                     OutputFormat output_format, u8 alpha) {
-
+template <OutputFormat output_format>
+static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data, u8 alpha) {
     u8* output = Memory::GetPointer(buf.address);
 
     while (amount_of_data > 0) {
         u8* unit_end = output + buf.transfer_unit;
         while (output < unit_end) {
-            u32 color = *input++;
-            Math::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8), alpha};
-
-            switch (output_format) {
-            case OutputFormat::RGBA8:
-                Color::EncodeRGBA8(col_vec, output);
-                output += 4;
-                break;
-            case OutputFormat::RGB8:
-                Color::EncodeRGB8(col_vec, output);
-                output += 3;
-                break;
-            case OutputFormat::RGB5A1:
-                Color::EncodeRGB5A1(col_vec, output);
-                output += 2;
-                break;
-            case OutputFormat::RGB565:
-                Color::EncodeRGB565(col_vec, output);
-                output += 2;
-                break;
-            }
-
+            output += EncodeColor<output_format>(*input++, alpha, output);
             amount_of_data -= 1;
         }
 
@@ -142,6 +291,24 @@ static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data
     }
 }
 
+static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data,
+                     OutputFormat output_format, u8 alpha) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        SendData<OutputFormat::RGBA8>(input, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB8:
+        SendData<OutputFormat::RGB8>(input, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB5A1:
+        SendData<OutputFormat::RGB5A1>(input, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB565:
+        SendData<OutputFormat::RGB565>(input, buf, amount_of_data, alpha);
+        break;
+    }
+}
+
 static const u8 linear_lut[TILE_SIZE] = {
     // clang-format off
      0,  1,  2,  3,  4,  5,  6,  7,
@@ -211,6 +378,157 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
     }
 }
 
+/// Conversions with at least this many strips are split across threads
+static constexpr size_t MIN_PARALLEL_STRIPS = 4;
+
+/// Returns an address past the end of the memory a CDMA transfer of `size` bytes may touch.
+static u64 TransferEnd(const ConversionBuffer& buf, u64 size) {
+    // Sends may overshoot the last transfer unit by a pixel
+    return buf.address + (size / buf.transfer_unit + 1) * (buf.transfer_unit + buf.gap) + 4;
+}
+
+/// Whether the output of a conversion might overwrite input that hasn't been read yet.
+static bool OutputOverlapsInput(const ConversionConfiguration& cvt) {
+    const ConversionBuffer* buffers[] = {&cvt.src_Y, &cvt.src_U, &cvt.src_V, &cvt.src_YUYV,
+                                         &cvt.dst};
+    for (const ConversionBuffer* buf : buffers) {
+        if (buf->transfer_unit == 0)
+            return true;
+    }
+
+    const u64 pixels = u64(cvt.input_line_width) * cvt.input_lines;
+    const u64 output_end = TransferEnd(cvt.dst, pixels * 4);
+    const auto overlaps = [&](const ConversionBuffer& src, u64 size) {
+        return src.address < output_end && cvt.dst.address < TransferEnd(src, size);
+    };
+
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+        return overlaps(cvt.src_Y, pixels) || overlaps(cvt.src_U, pixels / 2) ||
+               overlaps(cvt.src_V, pixels / 2);
+    case InputFormat::YUV420_Indiv8:
+        return overlaps(cvt.src_Y, pixels) || overlaps(cvt.src_U, pixels / 4) ||
+               overlaps(cvt.src_V, pixels / 4);
+    case InputFormat::YUV422_Indiv16:
+        return overlaps(cvt.src_Y, pixels * 2) || overlaps(cvt.src_U, pixels) ||
+               overlaps(cvt.src_V, pixels);
+    case InputFormat::YUV420_Indiv16:
+        return overlaps(cvt.src_Y, pixels * 2) || overlaps(cvt.src_U, pixels / 2) ||
+               overlaps(cvt.src_V, pixels / 2);
+    case InputFormat::YUYV422_Interleaved:
+        return overlaps(cvt.src_YUYV, pixels * 2);
+    }
+    return true;
+}
+
+/// Receives the input data of the next strip into `buffer`.
+static void ReceiveStrip(ConversionConfiguration& cvt, u8* buffer, unsigned int row_height) {
+    // Total size in pixels of incoming data required for this strip.
+    const size_t row_data_size = row_height * cvt.input_line_width;
+
+    u8* input_Y = buffer;
+    u8* input_U = input_Y + 8 * cvt.input_line_width;
+    u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+        ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<1>(input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv8:
+        ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<1>(input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUV422_Indiv16:
+        ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<2>(input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv16:
+        ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<2>(input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        ReceiveData<1>(input_Y, cvt.src_YUYV, row_data_size * 2);
+        break;
+    }
+}
+
+/**
+ * Converts a strip received into `buffer` to RGB32, overwriting it with the rotated pixels in the
+ * order they are sent out. Only reads `cvt`, so strips can be converted concurrently.
+ */
+static void ConvertStrip(const ConversionConfiguration& cvt, u8* buffer, unsigned int row_height,
+                         ImageTile tiles[]) {
+    const size_t num_tiles = cvt.input_line_width / 8;
+
+    const u8* input_Y = buffer;
+    const u8* input_U = input_Y + 8 * cvt.input_line_width;
+    const u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+
+    ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles, cvt.input_line_width,
+                    row_height, cvt.coefficients);
+
+    // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
+    // requiring two different code paths.
+    const u8* tile_remap = nullptr;
+    switch (cvt.block_alignment) {
+    case BlockAlignment::Linear:
+        tile_remap = linear_lut;
+        break;
+    case BlockAlignment::Block8x8:
+        tile_remap = morton_lut;
+        break;
+    }
+
+    u32* output_buffer = reinterpret_cast<u32*>(buffer);
+    ImageTile tmp_tile;
+
+    for (size_t i = 0; i < num_tiles; ++i) {
+        int image_strip_width = 0;
+        int output_stride = 0;
+
+        switch (cvt.rotation) {
+        case Rotation::None:
+            RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
+            image_strip_width = cvt.input_line_width;
+            output_stride = 8;
+            break;
+        case Rotation::Clockwise_90:
+            RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
+            image_strip_width = 8;
+            output_stride = 8 * row_height;
+            break;
+        case Rotation::Clockwise_180:
+            // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
+            // since the rotates are done individually on each tile.
+            RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
+            image_strip_width = cvt.input_line_width;
+            output_stride = 8;
+            break;
+        case Rotation::Clockwise_270:
+            RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
+            image_strip_width = 8;
+            output_stride = 8 * row_height;
+            break;
+        }
+
+        switch (cvt.block_alignment) {
+        case BlockAlignment::Linear:
+            WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
+            output_buffer += output_stride;
+            break;
+        case BlockAlignment::Block8x8:
+            WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
+            output_buffer += TILE_SIZE;
+            break;
+        }
+    }
+}
+
 /**
  * Performs a Y2R colorspace conversion.
  *
@@ -268,114 +586,67 @@ void PerformConversion(ConversionConfiguration& cvt) {
     size_t num_tiles = cvt.input_line_width / 8;
     ASSERT(num_tiles <= MAX_TILES);
 
-    // Buffer used as a CDMA source/target.
-    std::unique_ptr<u8[]> data_buffer(new u8[cvt.input_line_width * 8 * 4]);
-    // Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
-    std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
-    ImageTile tmp_tile;
-
-    // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
-    // requiring two different code paths.
-    const u8* tile_remap = nullptr;
-    switch (cvt.block_alignment) {
-    case BlockAlignment::Linear:
-        tile_remap = linear_lut;
-        break;
-    case BlockAlignment::Block8x8:
-        tile_remap = morton_lut;
-        break;
-    }
-
-    for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
-        unsigned int row_height = std::min(cvt.input_lines - y, 8u);
-
-        // Total size in pixels of incoming data required for this strip.
-        const size_t row_data_size = row_height * cvt.input_line_width;
-
-        u8* input_Y = data_buffer.get();
-        u8* input_U = input_Y + 8 * cvt.input_line_width;
-        u8* input_V = input_U + 8 * cvt.input_line_width / 2;
-
-        switch (cvt.input_format) {
-        case InputFormat::YUV422_Indiv8:
-            ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<1>(input_V, cvt.src_V, row_data_size / 2);
-            break;
-        case InputFormat::YUV420_Indiv8:
-            ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<1>(input_V, cvt.src_V, row_data_size / 4);
-            break;
-        case InputFormat::YUV422_Indiv16:
-            ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<2>(input_V, cvt.src_V, row_data_size / 2);
-            break;
-        case InputFormat::YUV420_Indiv16:
-            ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<2>(input_V, cvt.src_V, row_data_size / 4);
-            break;
-        case InputFormat::YUYV422_Interleaved:
-            input_U = nullptr;
-            input_V = nullptr;
-            ReceiveData<1>(input_Y, cvt.src_YUYV, row_data_size * 2);
-            break;
+    const size_t num_strips = (cvt.input_lines + 7) / 8;
+    // Size of the buffer used as a CDMA source/target for each strip.
+    const size_t strip_buffer_size = cvt.input_line_width * 8 * 4;
+
+    const auto strip_height = [&cvt](size_t strip) {
+        return std::min(cvt.input_lines - static_cast<unsigned int>(strip * 8), 8u);
+    };
+
+    Common::ThreadPool& pool = Common::GetSharedThreadPool();
+    if (num_strips >= MIN_PARALLEL_STRIPS && pool.NumThreads() > 1 && !OutputOverlapsInput(cvt)) {
+        // Receive the whole image first, so that the strips can be converted in parallel. The
+        // hardware reads each strip after sending the previous one, which only makes a difference
+        // when the output overwrites the input.
+        std::unique_ptr<u8[]> data_buffer(new u8[num_strips * strip_buffer_size]);
+        const auto strip_buffer = [&](size_t strip) {
+            return &data_buffer[strip * strip_buffer_size];
+        };
+
+        // A partial last strip reads leftovers of the previous strip from the buffer, so it is
+        // converted after the others to keep those leftovers the same as with a single buffer.
+        const bool partial_last_strip = cvt.input_lines % 8 != 0;
+        const size_t parallel_strips = partial_last_strip ? num_strips - 1 : num_strips;
+
+        for (size_t strip = 0; strip < parallel_strips; ++strip) {
+            ReceiveStrip(cvt, strip_buffer(strip), strip_height(strip));
         }
 
-        // Note(yuriks): If additional optimization is required, input_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles.get(),
-                        cvt.input_line_width, row_height, cvt.coefficients);
-
-        u32* output_buffer = reinterpret_cast<u32*>(data_buffer.get());
-
-        for (size_t i = 0; i < num_tiles; ++i) {
-            int image_strip_width = 0;
-            int output_stride = 0;
-
-            switch (cvt.rotation) {
-            case Rotation::None:
-                RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_90:
-                RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
-            case Rotation::Clockwise_180:
-                // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
-                // since the rotates are done individually on each tile.
-                RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_270:
-                RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
+        pool.ParallelFor(parallel_strips, 1, [&](size_t begin, size_t end) {
+            std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
+            for (size_t strip = begin; strip < end; ++strip) {
+                ConvertStrip(cvt, strip_buffer(strip), strip_height(strip), tiles.get());
             }
+        });
+
+        if (partial_last_strip) {
+            const size_t last = num_strips - 1;
+            std::memcpy(strip_buffer(last), strip_buffer(last - 1), strip_buffer_size);
+            std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
+            ReceiveStrip(cvt, strip_buffer(last), strip_height(last));
+            ConvertStrip(cvt, strip_buffer(last), strip_height(last), tiles.get());
+        }
 
-            switch (cvt.block_alignment) {
-            case BlockAlignment::Linear:
-                WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
-                output_buffer += output_stride;
-                break;
-            case BlockAlignment::Block8x8:
-                WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
-                output_buffer += TILE_SIZE;
-                break;
-            }
+        for (size_t strip = 0; strip < num_strips; ++strip) {
+            SendData(reinterpret_cast<u32*>(strip_buffer(strip)), cvt.dst,
+                     (int)(strip_height(strip) * cvt.input_line_width), cvt.output_format,
+                     (u8)cvt.alpha);
         }
+        return;
+    }
+
+    std::unique_ptr<u8[]> data_buffer(new u8[strip_buffer_size]);
+    // Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
+    std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
+
+    for (size_t strip = 0; strip < num_strips; ++strip) {
+        const unsigned int row_height = strip_height(strip);
 
-        // Note(yuriks): If additional optimization is required, output_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        SendData(reinterpret_cast<u32*>(data_buffer.get()), cvt.dst, (int)row_data_size,
-                 cvt.output_format, (u8)cvt.alpha);
+        ReceiveStrip(cvt, data_buffer.get(), row_height);
+        ConvertStrip(cvt, data_buffer.get(), row_height, tiles.get());
+        SendData(reinterpret_cast<u32*>(data_buffer.get()), cvt.dst,
+                 (int)(row_height * cvt.input_line_width), cvt.output_format, (u8)cvt.alpha);
     }
 }
 }
@@ -284,7 +284,7 @@ ResultStatus AppLoader_THREEDSX::Load() {
     return ResultStatus::Success;
 }
 
-ResultStatus AppLoader_THREEDSX::ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file,
+ResultStatus AppLoader_THREEDSX::ReadRomFS(std::shared_ptr<FileUtil::MappedFile>& romfs_file,
                                            u64& offset, u64& size) {
     if (!file.IsOpen())
         return ResultStatus::Error;
@@ -307,8 +307,8 @@ ResultStatus AppLoader_THREEDSX::ReadRomFS(std::shared_ptr<FileUtil::IOFile>& ro
         LOG_DEBUG(Loader, "RomFS offset:           0x%08X", romfs_offset);
         LOG_DEBUG(Loader, "RomFS size:             0x%08X", romfs_size);
 
-        // We reopen the file, to allow its position to be independent from file's
-        romfs_file = std::make_shared<FileUtil::IOFile>(filepath, "rb");
+        // Map the file, so that reads from the RomFS don't go through file's position
+        romfs_file = std::make_shared<FileUtil::MappedFile>(filepath);
         if (!romfs_file->IsOpen())
             return ResultStatus::Error;
 
@@ -35,7 +35,7 @@ public:
 
     ResultStatus ReadIcon(std::vector<u8>& buffer) override;
 
-    ResultStatus ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file, u64& offset,
+    ResultStatus ReadRomFS(std::shared_ptr<FileUtil::MappedFile>& romfs_file, u64& offset,
                            u64& size) override;
 
 private:
@@ -8,6 +8,7 @@
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "core/guest_profiler.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/resource_limit.h"
 #include "core/loader/elf.h"
@@ -102,6 +103,10 @@ enum ElfSectionFlags {
 #define PF_R 0x4
 #define PF_MASKPROC 0xF0000000
 
+// Symbol types
+#define STT_FUNC 2
+#define ELF32_ST_TYPE(info) ((info)&0xF)
+
 typedef unsigned int Elf32_Addr;
 typedef unsigned short Elf32_Half;
 typedef unsigned int Elf32_Off;
@@ -209,6 +214,9 @@ public:
         return (u32)(header->e_flags);
     }
     SharedPtr<CodeSet> LoadInto(u32 vaddr);
+    /// Names the functions of the symbol table, if there is one, for the guest profiler. To be
+    /// called after LoadInto with the same address.
+    void LoadSymbols(u32 vaddr) const;
 
     int GetNumSegments() const {
         return (int)(header->e_phnum);
@@ -348,6 +356,35 @@ SharedPtr<CodeSet> ElfReader::LoadInto(u32 vaddr) {
     return codeset;
 }
 
+void ElfReader::LoadSymbols(u32 vaddr) const {
+    const SectionID symtab = GetSectionByName(".symtab");
+    if (symtab == -1)
+        return;
+    const Elf32_Word strtab = sections[symtab].sh_link;
+    if (strtab >= header->e_shnum)
+        return;
+
+    const auto* syms = reinterpret_cast<const Elf32_Sym*>(GetSectionDataPtr(symtab));
+    const char* names = reinterpret_cast<const char*>(GetSectionDataPtr(strtab));
+    if (syms == nullptr || names == nullptr)
+        return;
+
+    const u32 base_addr = relocate ? vaddr : 0;
+    const size_t count = sections[symtab].sh_size / sizeof(Elf32_Sym);
+    size_t added = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const Elf32_Sym& sym = syms[i];
+        if (ELF32_ST_TYPE(sym.st_info) != STT_FUNC || sym.st_value == 0 ||
+            sym.st_name >= sections[strtab].sh_size)
+            continue;
+        // The low bit of the address of Thumb functions is set
+        GuestProfiler::AddSymbol((base_addr + sym.st_value) & ~1u, sym.st_size,
+                                 names + sym.st_name);
+        ++added;
+    }
+    LOG_DEBUG(Loader, "%zu function symbols", added);
+}
+
 SectionID ElfReader::GetSectionByName(const char* name, int firstSection) const {
     for (int i = firstSection; i < header->e_shnum; i++) {
         const char* secname = GetSectionName(i);
@@ -393,6 +430,8 @@ ResultStatus AppLoader_ELF::Load() {
     ElfReader elf_reader(&buffer[0]);
     SharedPtr<CodeSet> codeset = elf_reader.LoadInto(Memory::PROCESS_IMAGE_VADDR);
     codeset->name = filename;
+    if (GuestProfiler::IsEnabled())
+        elf_reader.LoadSymbols(Memory::PROCESS_IMAGE_VADDR);
 
     Kernel::g_current_process = Kernel::Process::Create(std::move(codeset));
     Kernel::g_current_process->svc_access_mask.set();
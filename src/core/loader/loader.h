@@ -155,13 +155,13 @@ public:
 
     /**
      * Get the RomFS of the application
-     * Since the RomFS can be huge, we return a file reference instead of copying to a buffer
-     * @param romfs_file The file containing the RomFS
+     * Since the RomFS can be huge, we return a mapping of the file instead of copying to a buffer
+     * @param romfs_file The mapped file containing the RomFS
      * @param offset The offset the romfs begins on
      * @param size The size of the romfs
      * @return ResultStatus result of function
      */
-    virtual ResultStatus ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file, u64& offset,
+    virtual ResultStatus ReadRomFS(std::shared_ptr<FileUtil::MappedFile>& romfs_file, u64& offset,
                                    u64& size) {
         return ResultStatus::ErrorNotImplemented;
     }
@@ -8,6 +8,10 @@
 #include <cstring>
 #include <locale>
 #include <memory>
+#include <random>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
 #include "common/swap.h"
@@ -17,9 +21,11 @@
 #include "core/hle/kernel/resource_limit.h"
 #include "core/hle/service/cfg/cfg.h"
 #include "core/hle/service/fs/archive.h"
+#include "core/loader/lzss.h"
 #include "core/loader/ncch.h"
 #include "core/loader/smdh.h"
 #include "core/memory.h"
+#include "core/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Loader namespace
@@ -30,79 +36,81 @@ static const int kMaxSections = 8;   ///< Maximum number of sections (files) in
 static const int kBlockSize = 0x200; ///< Size of ExeFS blocks (in bytes)
 
 /**
- * Get the decompressed size of an LZSS compressed ExeFS file
- * @param buffer Buffer of compressed file
- * @param size Size of compressed buffer
- * @return Size of decompressed buffer
+ * Writes the code image to the cache. Other instances may be writing the same file, so each
+ * writes a file of its own and moves it in place once complete.
  */
-static u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
-    u32 offset_size = *(u32*)(buffer + size - 4);
-    return offset_size + size;
+static bool WriteSharedCode(const std::string& filename, const std::vector<u8>& image) {
+    const std::string temp_filename =
+        filename + Common::StringFromFormat(".%08X.tmp", std::random_device()());
+    {
+        FileUtil::IOFile file(temp_filename, "wb");
+        if (!file.IsOpen() || file.WriteBytes(image.data(), image.size()) != image.size()) {
+            LOG_ERROR(Loader, "Failed to write code cache %s", temp_filename.c_str());
+            file.Close();
+            FileUtil::Delete(temp_filename);
+            return false;
+        }
+    }
+    if (!FileUtil::Rename(temp_filename, filename)) {
+        FileUtil::Delete(temp_filename);
+        return false;
+    }
+    return true;
 }
 
 /**
- * Decompress ExeFS file (compressed with LZSS)
- * @param compressed Compressed buffer
- * @param compressed_size Size of compressed buffer
- * @param decompressed Decompressed buffer
- * @param decompressed_size Size of decompressed buffer
- * @return True on success, otherwise false
+ * Maps the cached copy of the code image, if its contents are those of the image. The name of
+ * the file only holds a hash of them, and the file may have been truncated, corrupted or replaced
+ * since it was written, so the contents are compared before the mapping is used.
  */
-static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
-                            u32 decompressed_size) {
-    const u8* footer = compressed + compressed_size - 8;
-    u32 buffer_top_and_bottom = *reinterpret_cast<const u32*>(footer);
-    u32 out = decompressed_size;
-    u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
-    u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
-
-    memset(decompressed, 0, decompressed_size);
-    memcpy(decompressed, compressed, compressed_size);
-
-    while (index > stop_index) {
-        u8 control = compressed[--index];
-
-        for (unsigned i = 0; i < 8; i++) {
-            if (index <= stop_index)
-                break;
-            if (index <= 0)
-                break;
-            if (out <= 0)
-                break;
-
-            if (control & 0x80) {
-                // Check if compression is out of bounds
-                if (index < 2)
-                    return false;
-                index -= 2;
-
-                u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
-                u32 segment_size = ((segment_offset >> 12) & 15) + 3;
-                segment_offset &= 0x0FFF;
-                segment_offset += 2;
-
-                // Check if compression is out of bounds
-                if (out < segment_size)
-                    return false;
+static std::shared_ptr<FileUtil::MappedFile> MapMatchingSharedCode(const std::string& filename,
+                                                                   const std::vector<u8>& image) {
+    auto mapping = std::make_shared<FileUtil::MappedFile>();
+    if (!mapping->Open(filename, true) || mapping->GetSize() != image.size())
+        return nullptr;
+    if (!image.empty() && std::memcmp(mapping->GetData(), image.data(), image.size()) != 0)
+        return nullptr;
+    return mapping;
+}
 
-                for (unsigned j = 0; j < segment_size; j++) {
-                    // Check if compression is out of bounds
-                    if (out + segment_offset >= decompressed_size)
-                        return false;
+/**
+ * Maps a copy of the loaded code image from the cache directory, so that the host shares its pages
+ * between all the emulator instances running the same title. The cached copy is written first if
+ * it doesn't exist yet, or doesn't match the image.
+ * @return The copy-on-write mapping of the image, or nullptr if the cache couldn't be used
+ */
+static std::shared_ptr<FileUtil::MappedFile> MapSharedCode(u64 program_id,
+                                                           const std::vector<u8>& image) {
+    const std::string dir = FileUtil::GetUserPath(D_CACHE_IDX) + "code" DIR_SEP;
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(Loader, "Failed to create code cache directory %s", dir.c_str());
+        return nullptr;
+    }
 
-                    u8 data = decompressed[out + segment_offset];
-                    decompressed[--out] = data;
-                }
-            } else {
-                // Check if compression is out of bounds
-                if (out < 1)
-                    return false;
-                decompressed[--out] = compressed[--index];
-            }
-            control <<= 1;
+    // Keyed by the contents, which differ between updates of a title
+    const std::string filename =
+        dir + Common::StringFromFormat("%016" PRIX64 "_%016" PRIX64 ".bin", program_id,
+                                       Common::ComputeHash64(image.data(), image.size()));
+
+    std::shared_ptr<FileUtil::MappedFile> mapping;
+    if (FileUtil::GetSize(filename) == image.size()) {
+        mapping = MapMatchingSharedCode(filename, image);
+        if (mapping == nullptr) {
+            LOG_WARNING(Loader, "Code cache %s doesn't match the code, replacing it",
+                        filename.c_str());
         }
     }
-    return true;
+    if (mapping == nullptr) {
+        if (!WriteSharedCode(filename, image))
+            return nullptr;
+        mapping = MapMatchingSharedCode(filename, image);
+        if (mapping == nullptr) {
+            LOG_ERROR(Loader, "Failed to map code cache %s", filename.c_str());
+            return nullptr;
+        }
+    }
+    LOG_INFO(Loader, "Mapped code from cache %s", filename.c_str());
+    return mapping;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -168,7 +176,10 @@ ResultStatus AppLoader_NCCH::LoadExec() {
             exheader_header.codeset_info.data.num_max_pages * Memory::PAGE_SIZE + bss_page_size;
 
         codeset->entrypoint = codeset->code.addr;
-        codeset->memory = std::make_shared<std::vector<u8>>(std::move(code));
+        if (Settings::values.share_code_pages)
+            codeset->shared_memory = MapSharedCode(ncch_header.program_id, code);
+        if (codeset->shared_memory == nullptr)
+            codeset->memory = std::make_shared<std::vector<u8>>(std::move(code));
 
         Kernel::g_current_process = Kernel::Process::Create(std::move(codeset));
 
@@ -392,8 +403,8 @@ ResultStatus AppLoader_NCCH::ReadProgramId(u64& out_program_id) {
     return ResultStatus::Success;
 }
 
-ResultStatus AppLoader_NCCH::ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file, u64& offset,
-                                       u64& size) {
+ResultStatus AppLoader_NCCH::ReadRomFS(std::shared_ptr<FileUtil::MappedFile>& romfs_file,
+                                       u64& offset, u64& size) {
     if (!file.IsOpen())
         return ResultStatus::Error;
 
@@ -408,8 +419,8 @@ ResultStatus AppLoader_NCCH::ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_
         if (file.GetSize() < romfs_offset + romfs_size)
             return ResultStatus::Error;
 
-        // We reopen the file, to allow its position to be independent from file's
-        romfs_file = std::make_shared<FileUtil::IOFile>(filepath, "rb");
+        // Map the file, so that reads from the RomFS don't go through file's position
+        romfs_file = std::make_shared<FileUtil::MappedFile>(filepath);
         if (!romfs_file->IsOpen())
             return ResultStatus::Error;
 
@@ -193,7 +193,7 @@ public:
 
     ResultStatus ReadProgramId(u64& out_program_id) override;
 
-    ResultStatus ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file, u64& offset,
+    ResultStatus ReadRomFS(std::shared_ptr<FileUtil::MappedFile>& romfs_file, u64& offset,
                            u64& size) override;
 
     ResultStatus ReadTitle(std::string& title) override;
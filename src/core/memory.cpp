@@ -2,8 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
@@ -12,6 +16,7 @@
 #include "core/memory.h"
 #include "core/memory_setup.h"
 #include "core/mmio.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -32,12 +37,6 @@ enum class PageType {
     RasterizerCachedSpecial,
 };
 
-struct SpecialRegion {
-    VAddr base;
-    u32 size;
-    MMIORegionPointer handler;
-};
-
 /**
  * A (reasonably) fast way of allowing switchable and remappable process address spaces. It loosely
  * mimics the way a real CPU page table works, but instead is optimized for minimal decoding and
@@ -52,22 +51,20 @@ struct PageTable {
     std::array<u8*, PAGE_TABLE_NUM_ENTRIES> pointers;
 
     /**
-     * Contains MMIO handlers that back memory regions whose entries in the `attribute` array is of
-     * type `Special`.
+     * Array of the MMIO handlers backing each page. An entry is non-null exactly when the
+     * corresponding entry in the `attributes` array is of type `Special` or
+     * `RasterizerCachedSpecial`.
      */
-    std::vector<SpecialRegion> special_regions;
+    std::array<MMIORegion*, PAGE_TABLE_NUM_ENTRIES> special_handlers;
+
+    /// Keeps the MMIO handlers that have been mapped alive, as `special_handlers` doesn't own them
+    std::vector<MMIORegionPointer> special_regions;
 
     /**
      * Array of fine grained page attributes. If it is set to any value other than `Memory`, then
      * the corresponding entry in `pointers` MUST be set to null.
      */
     std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
-
-    /**
-     * Indicates the number of externally cached resources touching a page that should be
-     * flushed before the memory is accessed
-     */
-    std::array<u8, PAGE_TABLE_NUM_ENTRIES> cached_res_count;
 };
 
 /// Singular page table used for the singleton process
@@ -75,16 +72,66 @@ static PageTable main_page_table;
 /// Currently active page table
 static PageTable* current_page_table = &main_page_table;
 
+static std::array<TLBEntry, TLB_SIZE> MakeEmptyTLB() {
+    std::array<TLBEntry, TLB_SIZE> empty_tlb;
+    empty_tlb.fill({TLB_INVALID_PAGE, nullptr});
+    return empty_tlb;
+}
+
+std::array<TLBEntry, TLB_SIZE> tlb = MakeEmptyTLB();
+
+static void FlushTLB() {
+    tlb = MakeEmptyTLB();
+}
+
+static void InvalidateTLBPage(u32 page) {
+    TLBEntry& entry = tlb[page % TLB_SIZE];
+    if (entry.page == page)
+        entry = {TLB_INVALID_PAGE, nullptr};
+}
+
+/**
+ * Number of externally cached rasterizer resources touching each page of the physical memory the
+ * GPU renders to and samples from. The counts are kept per physical page rather than in the page
+ * table, so that every virtual alias of a page can be switched to the checked path and back.
+ */
+static std::array<u8, VRAM_SIZE / PAGE_SIZE> vram_cached_pages;
+static std::array<u8, FCRAM_N3DS_SIZE / PAGE_SIZE> fcram_cached_pages;
+static std::array<u8, N3DS_EXTRA_RAM_SIZE / PAGE_SIZE> n3ds_extra_ram_cached_pages;
+
+/// Returns the cached resource count of the physical page, or nullptr if the GPU can't cache it
+static u8* GetCachedPageCount(PAddr paddr) {
+    if (paddr >= VRAM_PADDR && paddr < VRAM_PADDR_END) {
+        return &vram_cached_pages[(paddr - VRAM_PADDR) >> PAGE_BITS];
+    } else if (paddr >= FCRAM_PADDR && paddr < FCRAM_N3DS_PADDR_END) {
+        return &fcram_cached_pages[(paddr - FCRAM_PADDR) >> PAGE_BITS];
+    } else if (paddr >= N3DS_EXTRA_RAM_PADDR && paddr < N3DS_EXTRA_RAM_PADDR_END) {
+        return &n3ds_extra_ram_cached_pages[(paddr - N3DS_EXTRA_RAM_PADDR) >> PAGE_BITS];
+    }
+    return nullptr;
+}
+
+/// Returns whether the GPU has cached resources touching the memory behind a virtual page
+static bool IsVirtualPageCached(VAddr vaddr) {
+    const boost::optional<PAddr> paddr = TryVirtualToPhysicalAddress(vaddr);
+    if (!paddr)
+        return false;
+    const u8* res_count = GetCachedPageCount(*paddr);
+    return res_count != nullptr && *res_count != 0;
+}
+
 std::array<u8*, PAGE_TABLE_NUM_ENTRIES>* GetCurrentPageTablePointers() {
     return &current_page_table->pointers;
 }
 
-static void MapPages(u32 base, u32 size, u8* memory, PageType type) {
+static void MapPages(u32 base, u32 size, u8* memory, PageType type,
+                     MMIORegion* mmio_handler = nullptr) {
     LOG_DEBUG(HW_Memory, "Mapping %p onto %08X-%08X", memory, base * PAGE_SIZE,
               (base + size) * PAGE_SIZE);
 
     RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
                                  FlushMode::FlushAndInvalidate);
+    FlushTLB();
 
     u32 end = base + size;
     while (base != end) {
@@ -92,7 +139,13 @@ static void MapPages(u32 base, u32 size, u8* memory, PageType type) {
 
         current_page_table->attributes[base] = type;
         current_page_table->pointers[base] = memory;
-        current_page_table->cached_res_count[base] = 0;
+        current_page_table->special_handlers[base] = mmio_handler;
+
+        // Memory the GPU still caches through another alias keeps going through the checked path
+        if (type == PageType::Memory && IsVirtualPageCached(base << PAGE_BITS)) {
+            current_page_table->attributes[base] = PageType::RasterizerCachedMemory;
+            current_page_table->pointers[base] = nullptr;
+        }
 
         base += 1;
         if (memory != nullptr)
@@ -103,7 +156,11 @@ static void MapPages(u32 base, u32 size, u8* memory, PageType type) {
 void InitMemoryMap() {
     main_page_table.pointers.fill(nullptr);
     main_page_table.attributes.fill(PageType::Unmapped);
-    main_page_table.cached_res_count.fill(0);
+    main_page_table.special_handlers.fill(nullptr);
+    FlushTLB();
+    vram_cached_pages.fill(0);
+    fcram_cached_pages.fill(0);
+    n3ds_extra_ram_cached_pages.fill(0);
 }
 
 void MapMemoryRegion(VAddr base, u32 size, u8* target) {
@@ -115,9 +172,13 @@ void MapMemoryRegion(VAddr base, u32 size, u8* target) {
 void MapIoRegion(VAddr base, u32 size, MMIORegionPointer mmio_handler) {
     ASSERT_MSG((size & PAGE_MASK) == 0, "non-page aligned size: %08X", size);
     ASSERT_MSG((base & PAGE_MASK) == 0, "non-page aligned base: %08X", base);
-    MapPages(base / PAGE_SIZE, size / PAGE_SIZE, nullptr, PageType::Special);
+    ASSERT(mmio_handler != nullptr);
+    MapPages(base / PAGE_SIZE, size / PAGE_SIZE, nullptr, PageType::Special, mmio_handler.get());
 
-    current_page_table->special_regions.emplace_back(SpecialRegion{base, size, mmio_handler});
+    // Processes map the same handlers again whenever they are switched to
+    auto& regions = current_page_table->special_regions;
+    if (std::find(regions.begin(), regions.end(), mmio_handler) == regions.end())
+        regions.push_back(std::move(mmio_handler));
 }
 
 void UnmapRegion(VAddr base, u32 size) {
@@ -158,24 +219,20 @@ static u8* GetPointerFromVMA(VAddr vaddr) {
 /**
  * This function should only be called for virtual addreses with attribute `PageType::Special`.
  */
-static MMIORegionPointer GetMMIOHandler(VAddr vaddr) {
-    for (const auto& region : current_page_table->special_regions) {
-        if (vaddr >= region.base && vaddr < (region.base + region.size)) {
-            return region.handler;
-        }
-    }
-    ASSERT_MSG(false, "Mapped IO page without a handler @ %08X", vaddr);
-    return nullptr; // Should never happen
+static MMIORegion* GetMMIOHandler(VAddr vaddr) {
+    MMIORegion* mmio_handler = current_page_table->special_handlers[vaddr >> PAGE_BITS];
+    ASSERT_MSG(mmio_handler != nullptr, "Mapped IO page without a handler @ %08X", vaddr);
+    return mmio_handler;
 }
 
 template <typename T>
-T ReadMMIO(MMIORegionPointer mmio_handler, VAddr addr);
+T ReadMMIO(MMIORegion* mmio_handler, VAddr addr);
 
 template <typename T>
-T Read(const VAddr vaddr) {
-    const u8* page_pointer = current_page_table->pointers[vaddr >> PAGE_BITS];
+T ReadPageTable(const VAddr vaddr) {
+    u8* page_pointer = current_page_table->pointers[vaddr >> PAGE_BITS];
     if (page_pointer) {
-        // NOTE: Avoid adding any extra logic to this fast-path block
+        tlb[(vaddr >> PAGE_BITS) % TLB_SIZE] = {vaddr >> PAGE_BITS, page_pointer};
         T value;
         std::memcpy(&value, &page_pointer[vaddr & PAGE_MASK], sizeof(T));
         return value;
@@ -208,13 +265,13 @@ T Read(const VAddr vaddr) {
 }
 
 template <typename T>
-void WriteMMIO(MMIORegionPointer mmio_handler, VAddr addr, const T data);
+void WriteMMIO(MMIORegion* mmio_handler, VAddr addr, const T data);
 
 template <typename T>
-void Write(const VAddr vaddr, const T data) {
+void WritePageTable(const VAddr vaddr, const T data) {
     u8* page_pointer = current_page_table->pointers[vaddr >> PAGE_BITS];
     if (page_pointer) {
-        // NOTE: Avoid adding any extra logic to this fast-path block
+        tlb[(vaddr >> PAGE_BITS) % TLB_SIZE] = {vaddr >> PAGE_BITS, page_pointer};
         std::memcpy(&page_pointer[vaddr & PAGE_MASK], &data, sizeof(T));
         return;
     }
@@ -229,7 +286,9 @@ void Write(const VAddr vaddr, const T data) {
         ASSERT_MSG(false, "Mapped memory page without a pointer @ %08X", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
-        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::FlushAndInvalidate);
+        // Drop everything cached on the page at once. The page then takes the fast path until the
+        // GPU caches it again, instead of each of the following writes paying for a flush.
+        RasterizerFlushVirtualRegion(vaddr & ~PAGE_MASK, PAGE_SIZE, FlushMode::FlushAndInvalidate);
         std::memcpy(GetPointerFromVMA(vaddr), &data, sizeof(T));
         break;
     }
@@ -257,12 +316,7 @@ bool IsValidVirtualAddress(const VAddr vaddr) {
     if (current_page_table->attributes[vaddr >> PAGE_BITS] != PageType::Special)
         return false;
 
-    MMIORegionPointer mmio_region = GetMMIOHandler(vaddr);
-    if (mmio_region) {
-        return mmio_region->IsValidAddress(vaddr);
-    }
-
-    return false;
+    return GetMMIOHandler(vaddr)->IsValidAddress(vaddr);
 }
 
 bool IsValidPhysicalAddress(const PAddr paddr) {
@@ -304,73 +358,125 @@ u8* GetPhysicalPointer(PAddr address) {
     return vaddr ? GetPointer(*vaddr) : nullptr;
 }
 
-void RasterizerMarkRegionCached(PAddr start, u32 size, int count_delta) {
-    if (start == 0) {
+/// Switches a virtual page between the fast path and the rasterizer cache checks
+static void SetVirtualPageCached(VAddr vaddr, bool cached) {
+    PageType& page_type = current_page_table->attributes[vaddr >> PAGE_BITS];
+    u8*& pointer = current_page_table->pointers[vaddr >> PAGE_BITS];
+
+    if (cached) {
+        switch (page_type) {
+        case PageType::Memory:
+            page_type = PageType::RasterizerCachedMemory;
+            pointer = nullptr;
+            InvalidateTLBPage(vaddr >> PAGE_BITS);
+            break;
+        case PageType::Special:
+            page_type = PageType::RasterizerCachedSpecial;
+            break;
+        default:
+            // Not every alias of a physical page is mapped
+            break;
+        }
         return;
     }
 
+    switch (page_type) {
+    case PageType::RasterizerCachedMemory:
+        pointer = GetPointerFromVMA(vaddr & ~PAGE_MASK);
+        // It's possible that this function has been called while updating the pagetable after
+        // unmapping a VMA. In that case the underlying VMA will no longer exist, and we should
+        // just leave the pagetable entry blank.
+        page_type = pointer != nullptr ? PageType::Memory : PageType::Unmapped;
+        break;
+    case PageType::RasterizerCachedSpecial:
+        page_type = PageType::Special;
+        break;
+    default:
+        break;
+    }
+}
+
+/// Updates the page table entries of every virtual address the physical page is mapped at
+static void SetPhysicalPageCached(PAddr paddr, bool cached) {
+    if (paddr >= VRAM_PADDR && paddr < VRAM_PADDR_END) {
+        SetVirtualPageCached(paddr - VRAM_PADDR + VRAM_VADDR, cached);
+    } else if (paddr >= FCRAM_PADDR && paddr < FCRAM_N3DS_PADDR_END) {
+        // FCRAM is visible through both the old and the new linear heap
+        const u32 offset = paddr - FCRAM_PADDR;
+        if (offset < LINEAR_HEAP_SIZE)
+            SetVirtualPageCached(LINEAR_HEAP_VADDR + offset, cached);
+        if (offset < NEW_LINEAR_HEAP_SIZE)
+            SetVirtualPageCached(NEW_LINEAR_HEAP_VADDR + offset, cached);
+    } else if (paddr >= N3DS_EXTRA_RAM_PADDR && paddr < N3DS_EXTRA_RAM_PADDR_END) {
+        SetVirtualPageCached(paddr - N3DS_EXTRA_RAM_PADDR + N3DS_EXTRA_RAM_VADDR, cached);
+    }
+}
+
+/// Change of the cached count of a region, made on the GPU thread and not yet applied
+struct QueuedCachedMark {
+    PAddr start;
+    u32 size;
+    int count_delta;
+};
+
+static std::mutex queued_cached_marks_mutex;
+static std::vector<QueuedCachedMark> queued_cached_marks;
+
+static void MarkRegionCached(PAddr start, u32 size, int count_delta) {
+
     u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
-    PAddr paddr = start;
+    PAddr paddr = start & ~PAGE_MASK;
 
     for (unsigned i = 0; i < num_pages; ++i, paddr += PAGE_SIZE) {
-        boost::optional<VAddr> maybe_vaddr = PhysicalToVirtualAddress(paddr);
-        if (!maybe_vaddr)
+        u8* res_count = GetCachedPageCount(paddr);
+        if (res_count == nullptr)
             continue;
-        VAddr vaddr = *maybe_vaddr;
 
-        u8& res_count = current_page_table->cached_res_count[vaddr >> PAGE_BITS];
-        ASSERT_MSG(count_delta <= UINT8_MAX - res_count,
+        ASSERT_MSG(count_delta <= UINT8_MAX - *res_count,
                    "Rasterizer resource cache counter overflow!");
-        ASSERT_MSG(count_delta >= -res_count, "Rasterizer resource cache counter underflow!");
-
-        // Switch page type to cached if now cached
-        if (res_count == 0) {
-            PageType& page_type = current_page_table->attributes[vaddr >> PAGE_BITS];
-            switch (page_type) {
-            case PageType::Memory:
-                page_type = PageType::RasterizerCachedMemory;
-                current_page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
-                break;
-            case PageType::Special:
-                page_type = PageType::RasterizerCachedSpecial;
-                break;
-            default:
-                UNREACHABLE();
-            }
-        }
+        ASSERT_MSG(count_delta >= -*res_count, "Rasterizer resource cache counter underflow!");
 
-        res_count += count_delta;
-
-        // Switch page type to uncached if now uncached
-        if (res_count == 0) {
-            PageType& page_type = current_page_table->attributes[vaddr >> PAGE_BITS];
-            switch (page_type) {
-            case PageType::RasterizerCachedMemory: {
-                u8* pointer = GetPointerFromVMA(vaddr & ~PAGE_MASK);
-                if (pointer == nullptr) {
-                    // It's possible that this function has called been while updating the pagetable
-                    // after unmapping a VMA. In that case the underlying VMA will no longer exist,
-                    // and we should just leave the pagetable entry blank.
-                    page_type = PageType::Unmapped;
-                } else {
-                    page_type = PageType::Memory;
-                    current_page_table->pointers[vaddr >> PAGE_BITS] = pointer;
-                }
-                break;
-            }
-            case PageType::RasterizerCachedSpecial:
-                page_type = PageType::Special;
-                break;
-            default:
-                UNREACHABLE();
-            }
-        }
+        const bool was_cached = *res_count != 0;
+        *res_count += count_delta;
+        const bool is_cached = *res_count != 0;
+
+        // Only the first resource and the last one to go touch the page tables
+        if (was_cached != is_cached)
+            SetPhysicalPageCached(paddr, is_cached);
     }
 }
 
+void RasterizerMarkRegionCached(PAddr start, u32 size, int count_delta) {
+    if (start == 0) {
+        return;
+    }
+
+    // The page tables, cached counts and TLB belong to the emulation thread, which applies the
+    // changes of the GPU thread at its next synchronization with it
+    if (VideoCore::g_gpu_thread != nullptr && VideoCore::g_gpu_thread->IsGPUThread()) {
+        std::lock_guard<std::mutex> lock(queued_cached_marks_mutex);
+        queued_cached_marks.push_back({start, size, count_delta});
+        return;
+    }
+
+    MarkRegionCached(start, size, count_delta);
+}
+
+void RasterizerApplyQueuedMarks() {
+    std::vector<QueuedCachedMark> marks;
+    {
+        std::lock_guard<std::mutex> lock(queued_cached_marks_mutex);
+        marks.swap(queued_cached_marks);
+    }
+
+    for (const auto& mark : marks)
+        MarkRegionCached(mark.start, mark.size, mark.count_delta);
+}
+
 void RasterizerFlushRegion(PAddr start, u32 size) {
     if (VideoCore::g_renderer != nullptr) {
-        VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
+        VideoCore::RunOnRasterizerThread(
+            [start, size] { VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size); });
     }
 }
 
@@ -378,7 +484,9 @@ void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
     // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
     // null here
     if (VideoCore::g_renderer != nullptr) {
-        VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+        VideoCore::RunOnRasterizerThread([start, size] {
+            VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+        });
     }
 }
 
@@ -400,15 +508,18 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
             PAddr physical_start = TryVirtualToPhysicalAddress(overlap_start).value();
             u32 overlap_size = overlap_end - overlap_start;
 
-            auto* rasterizer = VideoCore::g_renderer->Rasterizer();
-            switch (mode) {
-            case FlushMode::Flush:
-                rasterizer->FlushRegion(physical_start, overlap_size);
-                break;
-            case FlushMode::FlushAndInvalidate:
-                rasterizer->FlushAndInvalidateRegion(physical_start, overlap_size);
-                break;
-            }
+            // The GPU thread may still be using memory the CPU is about to access
+            VideoCore::RunOnRasterizerThread([&] {
+                auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+                switch (mode) {
+                case FlushMode::Flush:
+                    rasterizer->FlushRegion(physical_start, overlap_size);
+                    break;
+                case FlushMode::FlushAndInvalidate:
+                    rasterizer->FlushAndInvalidateRegion(physical_start, overlap_size);
+                    break;
+                }
+            });
         };
 
         CheckRegion(LINEAR_HEAP_VADDR, LINEAR_HEAP_VADDR_END);
@@ -417,20 +528,34 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
     }
 }
 
-u8 Read8(const VAddr addr) {
-    return Read<u8>(addr);
-}
+template u8 ReadPageTable<u8>(VAddr vaddr);
+template u16_le ReadPageTable<u16_le>(VAddr vaddr);
+template u32_le ReadPageTable<u32_le>(VAddr vaddr);
+template u64_le ReadPageTable<u64_le>(VAddr vaddr);
 
-u16 Read16(const VAddr addr) {
-    return Read<u16_le>(addr);
-}
-
-u32 Read32(const VAddr addr) {
-    return Read<u32_le>(addr);
+/**
+ * Returns how many bytes, up to max_size, are backed by one contiguous run of host memory starting
+ * at page_offset into a `Memory` page. The run follows the next pages while their pointers line
+ * up, which they do across a whole VMA, so block operations can copy a VMA at once.
+ */
+static size_t GetContiguousRunSize(size_t page_index, size_t page_offset, size_t max_size) {
+    const u8* next_pointer = current_page_table->pointers[page_index] + PAGE_SIZE;
+    size_t run_size = PAGE_SIZE - page_offset;
+    while (run_size < max_size && ++page_index < PAGE_TABLE_NUM_ENTRIES &&
+           current_page_table->pointers[page_index] == next_pointer) {
+        run_size += PAGE_SIZE;
+        next_pointer += PAGE_SIZE;
+    }
+    return std::min(run_size, max_size);
 }
 
-u64 Read64(const VAddr addr) {
-    return Read<u64_le>(addr);
+u8* GetContiguousPointer(VAddr vaddr, size_t size) {
+    const size_t page_index = vaddr >> PAGE_BITS;
+    const size_t page_offset = vaddr & PAGE_MASK;
+    u8* page_pointer = current_page_table->pointers[page_index];
+    if (page_pointer == nullptr || GetContiguousRunSize(page_index, page_offset, size) < size)
+        return nullptr;
+    return page_pointer + page_offset;
 }
 
 void ReadBlock(const VAddr src_addr, void* dest_buffer, const size_t size) {
@@ -439,7 +564,7 @@ void ReadBlock(const VAddr src_addr, void* dest_buffer, const size_t size) {
     size_t page_offset = src_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = (page_index << PAGE_BITS) + page_offset;
 
         switch (current_page_table->attributes[page_index]) {
@@ -452,6 +577,7 @@ void ReadBlock(const VAddr src_addr, void* dest_buffer, const size_t size) {
         case PageType::Memory: {
             DEBUG_ASSERT(current_page_table->pointers[page_index]);
 
+            copy_amount = GetContiguousRunSize(page_index, page_offset, remaining_size);
             const u8* src_ptr = current_page_table->pointers[page_index] + page_offset;
             std::memcpy(dest_buffer, src_ptr, copy_amount);
             break;
@@ -477,28 +603,18 @@ void ReadBlock(const VAddr src_addr, void* dest_buffer, const size_t size) {
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_offset += copy_amount;
+        page_index += page_offset >> PAGE_BITS;
+        page_offset &= PAGE_MASK;
         dest_buffer = static_cast<u8*>(dest_buffer) + copy_amount;
         remaining_size -= copy_amount;
     }
 }
 
-void Write8(const VAddr addr, const u8 data) {
-    Write<u8>(addr, data);
-}
-
-void Write16(const VAddr addr, const u16 data) {
-    Write<u16_le>(addr, data);
-}
-
-void Write32(const VAddr addr, const u32 data) {
-    Write<u32_le>(addr, data);
-}
-
-void Write64(const VAddr addr, const u64 data) {
-    Write<u64_le>(addr, data);
-}
+template void WritePageTable<u8>(VAddr vaddr, u8 data);
+template void WritePageTable<u16_le>(VAddr vaddr, u16_le data);
+template void WritePageTable<u32_le>(VAddr vaddr, u32_le data);
+template void WritePageTable<u64_le>(VAddr vaddr, u64_le data);
 
 void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size) {
     size_t remaining_size = size;
@@ -506,7 +622,7 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
     size_t page_offset = dest_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = (page_index << PAGE_BITS) + page_offset;
 
         switch (current_page_table->attributes[page_index]) {
@@ -519,6 +635,7 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
         case PageType::Memory: {
             DEBUG_ASSERT(current_page_table->pointers[page_index]);
 
+            copy_amount = GetContiguousRunSize(page_index, page_offset, remaining_size);
             u8* dest_ptr = current_page_table->pointers[page_index] + page_offset;
             std::memcpy(dest_ptr, src_buffer, copy_amount);
             break;
@@ -530,7 +647,9 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, copy_amount, FlushMode::FlushAndInvalidate);
+            // As in Write, drop the whole page so the next writes to it take the fast path
+            RasterizerFlushVirtualRegion(static_cast<VAddr>(page_index << PAGE_BITS), PAGE_SIZE,
+                                         FlushMode::FlushAndInvalidate);
             std::memcpy(GetPointerFromVMA(current_vaddr), src_buffer, copy_amount);
             break;
         }
@@ -544,8 +663,9 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_offset += copy_amount;
+        page_index += page_offset >> PAGE_BITS;
+        page_offset &= PAGE_MASK;
         src_buffer = static_cast<const u8*>(src_buffer) + copy_amount;
         remaining_size -= copy_amount;
     }
@@ -559,7 +679,7 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
     static const std::array<u8, PAGE_SIZE> zeros = {};
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = (page_index << PAGE_BITS) + page_offset;
 
         switch (current_page_table->attributes[page_index]) {
@@ -571,6 +691,7 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
         case PageType::Memory: {
             DEBUG_ASSERT(current_page_table->pointers[page_index]);
 
+            copy_amount = GetContiguousRunSize(page_index, page_offset, remaining_size);
             u8* dest_ptr = current_page_table->pointers[page_index] + page_offset;
             std::memset(dest_ptr, 0, copy_amount);
             break;
@@ -582,7 +703,9 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, copy_amount, FlushMode::FlushAndInvalidate);
+            // As in Write, drop the whole page so the next writes to it take the fast path
+            RasterizerFlushVirtualRegion(static_cast<VAddr>(page_index << PAGE_BITS), PAGE_SIZE,
+                                         FlushMode::FlushAndInvalidate);
             std::memset(GetPointerFromVMA(current_vaddr), 0, copy_amount);
             break;
         }
@@ -596,19 +719,34 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_offset += copy_amount;
+        page_index += page_offset >> PAGE_BITS;
+        page_offset &= PAGE_MASK;
         remaining_size -= copy_amount;
     }
 }
 
+/// Copies at most a page of MMIO registers to dest_addr, reading them straight into the destination
+/// when it is plain memory
+static void CopyFromMMIO(VAddr dest_addr, VAddr src_addr, size_t size) {
+    MMIORegion* mmio_handler = GetMMIOHandler(src_addr);
+    if (u8* dest_ptr = GetContiguousPointer(dest_addr, size)) {
+        mmio_handler->ReadBlock(src_addr, dest_ptr, size);
+        return;
+    }
+
+    std::array<u8, PAGE_SIZE> buffer;
+    mmio_handler->ReadBlock(src_addr, buffer.data(), size);
+    WriteBlock(dest_addr, buffer.data(), size);
+}
+
 void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
     size_t remaining_size = size;
     size_t page_index = src_addr >> PAGE_BITS;
     size_t page_offset = src_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = (page_index << PAGE_BITS) + page_offset;
 
         switch (current_page_table->attributes[page_index]) {
@@ -620,16 +758,14 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
         }
         case PageType::Memory: {
             DEBUG_ASSERT(current_page_table->pointers[page_index]);
+            copy_amount = GetContiguousRunSize(page_index, page_offset, remaining_size);
             const u8* src_ptr = current_page_table->pointers[page_index] + page_offset;
             WriteBlock(dest_addr, src_ptr, copy_amount);
             break;
         }
         case PageType::Special: {
             DEBUG_ASSERT(GetMMIOHandler(current_vaddr));
-
-            std::vector<u8> buffer(copy_amount);
-            GetMMIOHandler(current_vaddr)->ReadBlock(current_vaddr, buffer.data(), buffer.size());
-            WriteBlock(dest_addr, buffer.data(), buffer.size());
+            CopyFromMMIO(dest_addr, current_vaddr, copy_amount);
             break;
         }
         case PageType::RasterizerCachedMemory: {
@@ -640,18 +776,16 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
         case PageType::RasterizerCachedSpecial: {
             DEBUG_ASSERT(GetMMIOHandler(current_vaddr));
             RasterizerFlushVirtualRegion(current_vaddr, copy_amount, FlushMode::Flush);
-
-            std::vector<u8> buffer(copy_amount);
-            GetMMIOHandler(current_vaddr)->ReadBlock(current_vaddr, buffer.data(), buffer.size());
-            WriteBlock(dest_addr, buffer.data(), buffer.size());
+            CopyFromMMIO(dest_addr, current_vaddr, copy_amount);
             break;
         }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_offset += copy_amount;
+        page_index += page_offset >> PAGE_BITS;
+        page_offset &= PAGE_MASK;
         dest_addr += copy_amount;
         src_addr += copy_amount;
         remaining_size -= copy_amount;
@@ -659,42 +793,42 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
 }
 
 template <>
-u8 ReadMMIO<u8>(MMIORegionPointer mmio_handler, VAddr addr) {
+u8 ReadMMIO<u8>(MMIORegion* mmio_handler, VAddr addr) {
     return mmio_handler->Read8(addr);
 }
 
 template <>
-u16 ReadMMIO<u16>(MMIORegionPointer mmio_handler, VAddr addr) {
+u16 ReadMMIO<u16>(MMIORegion* mmio_handler, VAddr addr) {
     return mmio_handler->Read16(addr);
 }
 
 template <>
-u32 ReadMMIO<u32>(MMIORegionPointer mmio_handler, VAddr addr) {
+u32 ReadMMIO<u32>(MMIORegion* mmio_handler, VAddr addr) {
     return mmio_handler->Read32(addr);
 }
 
 template <>
-u64 ReadMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr) {
+u64 ReadMMIO<u64>(MMIORegion* mmio_handler, VAddr addr) {
     return mmio_handler->Read64(addr);
 }
 
 template <>
-void WriteMMIO<u8>(MMIORegionPointer mmio_handler, VAddr addr, const u8 data) {
+void WriteMMIO<u8>(MMIORegion* mmio_handler, VAddr addr, const u8 data) {
     mmio_handler->Write8(addr, data);
 }
 
 template <>
-void WriteMMIO<u16>(MMIORegionPointer mmio_handler, VAddr addr, const u16 data) {
+void WriteMMIO<u16>(MMIORegion* mmio_handler, VAddr addr, const u16 data) {
     mmio_handler->Write16(addr, data);
 }
 
 template <>
-void WriteMMIO<u32>(MMIORegionPointer mmio_handler, VAddr addr, const u32 data) {
+void WriteMMIO<u32>(MMIORegion* mmio_handler, VAddr addr, const u32 data) {
     mmio_handler->Write32(addr, data);
 }
 
 template <>
-void WriteMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr, const u64 data) {
+void WriteMMIO<u64>(MMIORegion* mmio_handler, VAddr addr, const u64 data) {
     mmio_handler->Write64(addr, data);
 }
 
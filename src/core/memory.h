@@ -6,9 +6,11 @@
 
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <string>
 #include <boost/optional.hpp>
 #include "common/common_types.h"
+#include "common/swap.h"
 
 namespace Memory {
 
@@ -129,15 +131,87 @@ enum : VAddr {
 bool IsValidVirtualAddress(const VAddr addr);
 bool IsValidPhysicalAddress(const PAddr addr);
 
-u8 Read8(VAddr addr);
-u16 Read16(VAddr addr);
-u32 Read32(VAddr addr);
-u64 Read64(VAddr addr);
+/// An entry of the software TLB
+struct TLBEntry {
+    /// Virtual page number held by the entry, or TLB_INVALID_PAGE
+    u32 page;
+    /// Host pointer to the start of the page
+    u8* pointer;
+};
+
+constexpr size_t TLB_SIZE = 256;
+constexpr u32 TLB_INVALID_PAGE = 0xFFFFFFFF;
+
+/**
+ * Direct-mapped cache of the page table entries that have a host pointer, checked by Read8-64 and
+ * Write8-64 before the page table. A hit costs a tag compare and a load from a table that stays in
+ * the host's L1 cache, unlike the page table's pointer array. Entries are dropped whenever their
+ * page is remapped or cached by the rasterizer. Only used from the emulation thread: the GPU
+ * thread reaches guest memory through physical pointers, and its changes to the cached pages are
+ * applied by the emulation thread (see RasterizerApplyQueuedMarks), so the TLB needs no locking.
+ */
+extern std::array<TLBEntry, TLB_SIZE> tlb;
+
+/// Accesses memory through the page table on a TLB miss, refilling the entry of the page
+template <typename T>
+T ReadPageTable(VAddr vaddr);
+template <typename T>
+void WritePageTable(VAddr vaddr, T data);
+
+template <typename T>
+inline T ReadTLB(VAddr vaddr) {
+    const u32 page = vaddr >> PAGE_BITS;
+    const TLBEntry& entry = tlb[page % TLB_SIZE];
+    if (entry.page == page) {
+        T value;
+        std::memcpy(&value, entry.pointer + (vaddr & PAGE_MASK), sizeof(T));
+        return value;
+    }
+    return ReadPageTable<T>(vaddr);
+}
+
+template <typename T>
+inline void WriteTLB(VAddr vaddr, const T data) {
+    const u32 page = vaddr >> PAGE_BITS;
+    const TLBEntry& entry = tlb[page % TLB_SIZE];
+    if (entry.page == page) {
+        std::memcpy(entry.pointer + (vaddr & PAGE_MASK), &data, sizeof(T));
+        return;
+    }
+    WritePageTable<T>(vaddr, data);
+}
 
-void Write8(VAddr addr, u8 data);
-void Write16(VAddr addr, u16 data);
-void Write32(VAddr addr, u32 data);
-void Write64(VAddr addr, u64 data);
+inline u8 Read8(VAddr addr) {
+    return ReadTLB<u8>(addr);
+}
+
+inline u16 Read16(VAddr addr) {
+    return ReadTLB<u16_le>(addr);
+}
+
+inline u32 Read32(VAddr addr) {
+    return ReadTLB<u32_le>(addr);
+}
+
+inline u64 Read64(VAddr addr) {
+    return ReadTLB<u64_le>(addr);
+}
+
+inline void Write8(VAddr addr, u8 data) {
+    WriteTLB<u8>(addr, data);
+}
+
+inline void Write16(VAddr addr, u16 data) {
+    WriteTLB<u16_le>(addr, data);
+}
+
+inline void Write32(VAddr addr, u32 data) {
+    WriteTLB<u32_le>(addr, data);
+}
+
+inline void Write64(VAddr addr, u64 data) {
+    WriteTLB<u64_le>(addr, data);
+}
 
 void ReadBlock(const VAddr src_addr, void* dest_buffer, size_t size);
 void WriteBlock(const VAddr dest_addr, const void* src_buffer, size_t size);
@@ -146,6 +220,13 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, size_t size);
 
 u8* GetPointer(VAddr virtual_address);
 
+/**
+ * Returns a pointer to the region if it is all in one run of fast path memory, otherwise nullptr.
+ * Regions the rasterizer caches, or that span pages which aren't contiguous in host memory, have
+ * to be accessed with the block operations instead.
+ */
+u8* GetContiguousPointer(VAddr vaddr, size_t size);
+
 std::string ReadCString(VAddr virtual_address, std::size_t max_length);
 
 /**
@@ -180,6 +261,13 @@ u8* GetPhysicalPointer(PAddr address);
  */
 void RasterizerMarkRegionCached(PAddr start, u32 size, int count_delta);
 
+/**
+ * Applies the cached counter changes the GPU thread made since the last call. Changes made on the
+ * GPU thread are only queued, as the page tables may only be touched by the emulation thread, so
+ * this must be called from there whenever it has waited for GPU work.
+ */
+void RasterizerApplyQueuedMarks();
+
 /**
  * Flushes any externally cached rasterizer resources touching the given region.
  */
@@ -0,0 +1,239 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cinttypes>
+#include <cstring>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "common/common_funcs.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/hle/service/hid/hid.h"
+#include "core/hle/shared_page.h"
+#include "core/movie.h"
+#include "core/settings.h"
+
+namespace Movie {
+
+constexpr std::array<u8, 4> MOVIE_MAGIC = {'C', 'T', 'M', 0x1B};
+constexpr u32 MOVIE_VERSION = 1;
+
+struct MovieHeader {
+    std::array<u8, 4> magic;
+    u32 version;
+    u64 program_id;
+    u64 init_time;
+    u32 random_seed;
+    u32 reserved;
+};
+static_assert(sizeof(MovieHeader) == 32, "MovieHeader has incorrect size");
+
+enum class InputType : u8 {
+    PadAndCircle,
+    Touch,
+    Accelerometer,
+    Gyroscope,
+};
+
+/// Input of one HID update event, as stored in the movie after the header
+struct InputRecord {
+    InputType type;
+    INSERT_PADDING_BYTES(3);
+    union {
+        struct {
+            u32 hex;
+            s16 circle_pad_x;
+            s16 circle_pad_y;
+        } pad;
+        struct {
+            u16 x;
+            u16 y;
+            u8 valid;
+        } touch;
+        struct {
+            s16 x;
+            s16 y;
+            s16 z;
+        } motion;
+    };
+};
+static_assert(sizeof(InputRecord) == 12, "InputRecord has incorrect size");
+static_assert(std::is_trivially_copyable<InputRecord>::value,
+              "InputRecord must be trivially copyable");
+
+enum class PlayMode { None, Recording, Playing };
+
+static PlayMode play_mode = PlayMode::None;
+static MovieHeader header;
+static FileUtil::IOFile record_file;
+static std::vector<InputRecord> playback_records;
+static size_t playback_position = 0;
+
+static void StartRecording(const std::string& path, u64 program_id) {
+    record_file = FileUtil::IOFile(path, "wb");
+    if (!record_file.IsOpen()) {
+        LOG_ERROR(Core, "Could not open %s to record the movie to", path.c_str());
+        return;
+    }
+
+    header = {};
+    header.magic = MOVIE_MAGIC;
+    header.version = MOVIE_VERSION;
+    header.program_id = program_id;
+    header.init_time = SharedPage::GetSystemTime();
+    header.random_seed = std::random_device()();
+    record_file.WriteObject(header);
+
+    play_mode = PlayMode::Recording;
+    LOG_INFO(Core, "Recording movie to %s", path.c_str());
+}
+
+static void StartPlayback(const std::string& path, u64 program_id) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen() || file.GetSize() < sizeof(MovieHeader) ||
+        file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
+        LOG_ERROR(Core, "Could not read the movie from %s", path.c_str());
+        return;
+    }
+
+    if (header.magic != MOVIE_MAGIC || header.version != MOVIE_VERSION) {
+        LOG_ERROR(Core, "%s is not a movie of a supported version", path.c_str());
+        return;
+    }
+    if (header.program_id != program_id) {
+        LOG_WARNING(Core, "Movie was recorded with program %016" PRIX64 ", not %016" PRIX64,
+                    header.program_id, program_id);
+    }
+
+    playback_records.resize((file.GetSize() - sizeof(MovieHeader)) / sizeof(InputRecord));
+    file.ReadArray(playback_records.data(), playback_records.size());
+    playback_position = 0;
+
+    play_mode = PlayMode::Playing;
+    LOG_INFO(Core, "Playing back %zu inputs of movie %s", playback_records.size(), path.c_str());
+}
+
+/// Returns the next recorded input, which has to be of the given type, or nullptr once playback
+/// has stopped
+static const InputRecord* PlayNext(InputType type) {
+    if (playback_position == playback_records.size()) {
+        LOG_INFO(Core, "Movie playback finished");
+        play_mode = PlayMode::None;
+        return nullptr;
+    }
+
+    const InputRecord& record = playback_records[playback_position++];
+    if (record.type != type) {
+        LOG_WARNING(Core, "Movie desynced at input %zu, stopping playback", playback_position - 1);
+        play_mode = PlayMode::None;
+        return nullptr;
+    }
+    return &record;
+}
+
+static void Record(const InputRecord& record) {
+    record_file.WriteObject(record);
+}
+
+void Init(u64 program_id) {
+    if (!Settings::values.movie_play_path.empty()) {
+        StartPlayback(Settings::values.movie_play_path, program_id);
+    } else if (!Settings::values.movie_record_path.empty()) {
+        StartRecording(Settings::values.movie_record_path, program_id);
+    }
+}
+
+void Shutdown() {
+    if (play_mode == PlayMode::Recording)
+        LOG_INFO(Core, "Finished recording movie");
+
+    play_mode = PlayMode::None;
+    record_file.Close();
+    playback_records.clear();
+    playback_records.shrink_to_fit();
+    playback_position = 0;
+}
+
+bool IsPlayingInput() {
+    return play_mode == PlayMode::Playing;
+}
+
+bool IsRecordingInput() {
+    return play_mode == PlayMode::Recording;
+}
+
+u64 GetInitTime() {
+    return header.init_time;
+}
+
+u32 GetRandomSeed() {
+    return header.random_seed;
+}
+
+void HandlePadAndCircle(Service::HID::PadState& pad_state, s16& circle_pad_x, s16& circle_pad_y) {
+    if (play_mode == PlayMode::Playing) {
+        if (const InputRecord* record = PlayNext(InputType::PadAndCircle)) {
+            pad_state.hex = record->pad.hex;
+            circle_pad_x = record->pad.circle_pad_x;
+            circle_pad_y = record->pad.circle_pad_y;
+        }
+    } else if (play_mode == PlayMode::Recording) {
+        InputRecord record{};
+        record.type = InputType::PadAndCircle;
+        record.pad.hex = pad_state.hex;
+        record.pad.circle_pad_x = circle_pad_x;
+        record.pad.circle_pad_y = circle_pad_y;
+        Record(record);
+    }
+}
+
+void HandleTouch(Service::HID::TouchDataEntry& touch) {
+    if (play_mode == PlayMode::Playing) {
+        if (const InputRecord* record = PlayNext(InputType::Touch)) {
+            touch.x = record->touch.x;
+            touch.y = record->touch.y;
+            touch.valid.Assign(record->touch.valid);
+        }
+    } else if (play_mode == PlayMode::Recording) {
+        InputRecord record{};
+        record.type = InputType::Touch;
+        record.touch.x = touch.x;
+        record.touch.y = touch.y;
+        record.touch.valid = static_cast<u8>(touch.valid);
+        Record(record);
+    }
+}
+
+/// Plays back or records the state of a motion sensor, which the accelerometer and gyroscope
+/// entries share the layout of
+template <typename Entry>
+static void HandleMotion(InputType type, Entry& entry) {
+    if (play_mode == PlayMode::Playing) {
+        if (const InputRecord* record = PlayNext(type)) {
+            entry.x = record->motion.x;
+            entry.y = record->motion.y;
+            entry.z = record->motion.z;
+        }
+    } else if (play_mode == PlayMode::Recording) {
+        InputRecord record{};
+        record.type = type;
+        record.motion.x = entry.x;
+        record.motion.y = entry.y;
+        record.motion.z = entry.z;
+        Record(record);
+    }
+}
+
+void HandleAccelerometer(Service::HID::AccelerometerDataEntry& accelerometer) {
+    HandleMotion(InputType::Accelerometer, accelerometer);
+}
+
+void HandleGyroscope(Service::HID::GyroscopeDataEntry& gyroscope) {
+    HandleMotion(InputType::Gyroscope, gyroscope);
+}
+
+} // namespace Movie
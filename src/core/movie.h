@@ -0,0 +1,56 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+namespace Service {
+namespace HID {
+struct AccelerometerDataEntry;
+struct GyroscopeDataEntry;
+struct PadState;
+struct TouchDataEntry;
+} // namespace HID
+} // namespace Service
+
+/**
+ * Recorder and player of the input an emulated application receives, to make runs reproducible.
+ * Each HID update event records the state it hands to the application, or replaces it with the
+ * recorded one on playback. The console time of the shared page and the seed of the random
+ * number generators are pinned to values stored with the movie, and the time only advances with
+ * emulated time, so a played back run does the same guest work as the recorded one.
+ *
+ * Playback stops with a warning once the movie runs out or the recorded input doesn't match the
+ * update event asking for it, after which the live input devices take over again.
+ */
+namespace Movie {
+
+/// Starts recording or playing back if a movie path is configured. To be called once the
+/// application is loaded, before emulation starts.
+void Init(u64 program_id);
+
+/// Finishes the movie file when recording, and stops recording or playing back
+void Shutdown();
+
+bool IsPlayingInput();
+bool IsRecordingInput();
+
+/// Returns whether a movie is being recorded or played back, which pins the time and seeds
+inline bool IsActive() {
+    return IsPlayingInput() || IsRecordingInput();
+}
+
+/// Console time, in milliseconds since Jan 1 1900, the movie starts at
+u64 GetInitTime();
+
+/// Seed for the random number generators of the emulated services
+u32 GetRandomSeed();
+
+void HandlePadAndCircle(Service::HID::PadState& pad_state, s16& circle_pad_x, s16& circle_pad_y);
+void HandleTouch(Service::HID::TouchDataEntry& touch);
+void HandleAccelerometer(Service::HID::AccelerometerDataEntry& accelerometer);
+void HandleGyroscope(Service::HID::GyroscopeDataEntry& gyroscope);
+
+} // namespace Movie
@@ -2,10 +2,17 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
 #include <mutex>
 #include <thread>
+#include "audio_core/audio_core.h"
+#include "common/logging/log.h"
 #include "common/math_util.h"
+#include "core/core.h"
 #include "core/hw/gpu.h"
 #include "core/perf_stats.h"
 #include "core/settings.h"
@@ -17,6 +24,19 @@ using std::chrono::microseconds;
 
 namespace Core {
 
+/// Number of system frames since the last reset that the frame length percentiles consider
+constexpr size_t MAX_FRAME_LENGTH_SAMPLES = 4096;
+
+/// Returns the given percentile (0 to 1) of the durations in seconds, reordering them
+static double GetPercentile(std::vector<PerfStats::Clock::duration>& durations, double percentile) {
+    if (durations.empty())
+        return 0.0;
+
+    const auto nth = durations.begin() + static_cast<size_t>(percentile * (durations.size() - 1));
+    std::nth_element(durations.begin(), nth, durations.end());
+    return duration_cast<DoubleSecs>(*nth).count();
+}
+
 void PerfStats::BeginSystemFrame() {
     std::lock_guard<std::mutex> lock(object_mutex);
 
@@ -32,6 +52,13 @@ void PerfStats::EndSystemFrame() {
 
     previous_frame_length = frame_end - previous_frame_end;
     previous_frame_end = frame_end;
+    // Bounds the memory use when nobody collects the stats
+    if (frame_lengths.size() < MAX_FRAME_LENGTH_SAMPLES)
+        frame_lengths.push_back(previous_frame_length);
+
+    const auto bin = static_cast<size_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(previous_frame_length).count());
+    frame_length_histogram[std::min(bin, NUM_HISTOGRAM_BINS - 1)] += 1;
 }
 
 void PerfStats::EndGameFrame() {
@@ -56,6 +83,22 @@ PerfStats::Results PerfStats::GetAndResetStats(u64 current_system_time_us) {
     results.frametime = duration_cast<DoubleSecs>(accumulated_frametime).count() /
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second / 1'000'000.0;
+    results.frame_length_p50 = GetPercentile(frame_lengths, 0.50);
+    results.frame_length_p99 = GetPercentile(frame_lengths, 0.99);
+    results.frame_length_histogram = frame_length_histogram;
+    for (size_t i = 0; i < NUM_CATEGORIES; ++i) {
+        const u64 time_ns = category_ns[i].exchange(0);
+        results.category_time[i] =
+            system_frames == 0 ? 0.0 : time_ns / 1e9 / static_cast<double>(system_frames);
+    }
+    for (size_t i = 0; i < NUM_GPU_CATEGORIES; ++i) {
+        const u64 time_ns = gpu_category_ns[i].exchange(0);
+        results.gpu_category_time[i] =
+            system_frames == 0 ? 0.0 : time_ns / 1e9 / static_cast<double>(system_frames);
+    }
+    for (size_t i = 0; i < NUM_COUNTERS; ++i) {
+        results.counts[i] = counter_values[i].exchange(0);
+    }
 
     // Reset counters
     reset_point = now;
@@ -63,10 +106,165 @@ PerfStats::Results PerfStats::GetAndResetStats(u64 current_system_time_us) {
     accumulated_frametime = Clock::duration::zero();
     system_frames = 0;
     game_frames = 0;
+    frame_lengths.clear();
+    frame_length_histogram.fill(0);
+
+    const std::string& csv_path = Settings::values.perf_stats_csv_path;
+    if (!csv_path.empty()) {
+        if (!csv_file.IsOpen()) {
+            if (csv_file.Open(csv_path, "w")) {
+                const std::string header = GetCsvHeader();
+                csv_file.WriteBytes(header.data(), header.size());
+            } else {
+                LOG_ERROR(Core, "Could not open %s to write the performance stats to",
+                          csv_path.c_str());
+            }
+        }
+        if (csv_file.IsOpen()) {
+            const std::string row = FormatCsvRow(results);
+            csv_file.WriteBytes(row.data(), row.size());
+            csv_file.Flush();
+        }
+    }
 
     return results;
 }
 
+static const char* GetCategoryName(PerfStats::Category category) {
+    switch (category) {
+    case PerfStats::Category::CPUEmulation:
+        return "cpu_emulation";
+    case PerfStats::Category::CommandProcessing:
+        return "command_processing";
+    case PerfStats::Category::Drawing:
+        return "drawing";
+    case PerfStats::Category::ShaderCompile:
+        return "shader_compile";
+    case PerfStats::Category::SurfaceFlush:
+        return "surface_flush";
+    case PerfStats::Category::Present:
+        return "present";
+    default:
+        return "unknown";
+    }
+}
+
+static const char* GetGPUCategoryName(PerfStats::GPUCategory category) {
+    switch (category) {
+    case PerfStats::GPUCategory::Drawing:
+        return "gpu_drawing";
+    case PerfStats::GPUCategory::SurfaceBlit:
+        return "gpu_surface_blit";
+    case PerfStats::GPUCategory::SurfaceUpload:
+        return "gpu_surface_upload";
+    case PerfStats::GPUCategory::SurfaceDownload:
+        return "gpu_surface_download";
+    case PerfStats::GPUCategory::Present:
+        return "gpu_present";
+    default:
+        return "gpu_unknown";
+    }
+}
+
+static const char* GetCounterName(PerfStats::Counter counter) {
+    switch (counter) {
+    case PerfStats::Counter::ShaderCompiles:
+        return "shader_compiles";
+    case PerfStats::Counter::SurfaceCacheHits:
+        return "surface_cache_hits";
+    case PerfStats::Counter::SurfaceCacheMisses:
+        return "surface_cache_misses";
+    default:
+        return "unknown_counter";
+    }
+}
+
+std::string PerfStats::GetCsvHeader() {
+    std::string header =
+        "system_fps,game_fps,frametime,frame_length_p50,frame_length_p99,emulation_speed";
+    for (size_t i = 0; i < NUM_CATEGORIES; ++i) {
+        header += ',';
+        header += GetCategoryName(static_cast<Category>(i));
+    }
+    for (size_t i = 0; i < NUM_GPU_CATEGORIES; ++i) {
+        header += ',';
+        header += GetGPUCategoryName(static_cast<GPUCategory>(i));
+    }
+    for (size_t i = 0; i < NUM_COUNTERS; ++i) {
+        header += ',';
+        header += GetCounterName(static_cast<Counter>(i));
+    }
+    for (size_t i = 0; i < NUM_HISTOGRAM_BINS; ++i) {
+        header += ",frames_" + std::to_string(i) + "ms";
+    }
+    return header + '\n';
+}
+
+std::string PerfStats::FormatCsvRow(const Results& results) {
+    char buffer[64];
+    std::string row;
+    const auto append = [&](const char* format, auto value) {
+        std::snprintf(buffer, sizeof(buffer), format, value);
+        if (!row.empty())
+            row += ',';
+        row += buffer;
+    };
+
+    append("%f", results.system_fps);
+    append("%f", results.game_fps);
+    append("%f", results.frametime);
+    append("%f", results.frame_length_p50);
+    append("%f", results.frame_length_p99);
+    append("%f", results.emulation_speed);
+    for (double time : results.category_time)
+        append("%f", time);
+    for (double time : results.gpu_category_time)
+        append("%f", time);
+    for (u64 count : results.counts)
+        append("%" PRIu64, count);
+    for (u32 count : results.frame_length_histogram)
+        append("%" PRIu32, count);
+    return row + '\n';
+}
+
+std::string PerfStats::FormatJson(const Results& results) {
+    char buffer[64];
+    std::string json;
+    const auto append = [&](const char* name, const char* format, auto value) {
+        // JSON has no representation for the NaN of stats over an interval without frames
+        if (std::isfinite(static_cast<double>(value)))
+            std::snprintf(buffer, sizeof(buffer), format, value);
+        else
+            std::snprintf(buffer, sizeof(buffer), "null");
+        json += json.empty() ? "{" : ", ";
+        json += '"';
+        json += name;
+        json += "\": ";
+        json += buffer;
+    };
+
+    append("system_fps", "%f", results.system_fps);
+    append("game_fps", "%f", results.game_fps);
+    append("frametime", "%f", results.frametime);
+    append("frame_length_p50", "%f", results.frame_length_p50);
+    append("frame_length_p99", "%f", results.frame_length_p99);
+    append("emulation_speed", "%f", results.emulation_speed);
+    for (size_t i = 0; i < NUM_CATEGORIES; ++i)
+        append(GetCategoryName(static_cast<Category>(i)), "%f", results.category_time[i]);
+    for (size_t i = 0; i < NUM_GPU_CATEGORIES; ++i)
+        append(GetGPUCategoryName(static_cast<GPUCategory>(i)), "%f", results.gpu_category_time[i]);
+    for (size_t i = 0; i < NUM_COUNTERS; ++i)
+        append(GetCounterName(static_cast<Counter>(i)), "%" PRIu64, results.counts[i]);
+
+    json += ", \"frame_length_histogram\": [";
+    for (size_t i = 0; i < NUM_HISTOGRAM_BINS; ++i) {
+        if (i != 0)
+            json += ", ";
+        json += std::to_string(results.frame_length_histogram[i]);
+    }
+    return json + "]}";
+}
+
 double PerfStats::GetLastFrameTimeScale() {
     std::lock_guard<std::mutex> lock(object_mutex);
 
@@ -79,7 +277,18 @@ void FrameLimiter::DoFrameLimiting(u64 current_system_time_us) {
     // values increase the time needed to recover and limit framerate again after spikes.
     constexpr microseconds MAX_LAG_TIME_US = 25ms;
 
-    if (!Settings::values.toggle_framelimit) {
+    // Audio written to a file doesn't need to keep up with the wall clock either
+    if (!Settings::values.toggle_framelimit || !AudioCore::IsOutputRealTime()) {
+        behind = false;
+        return;
+    }
+
+    if (Settings::values.turbo) {
+        // Start limiting afresh once turbo mode ends, rather than from a stale point in time
+        previous_system_time_us = current_system_time_us;
+        previous_walltime = Clock::now();
+        frame_limiting_delta_err = microseconds::zero();
+        behind = false;
         return;
     }
 
@@ -89,9 +298,11 @@ void FrameLimiter::DoFrameLimiting(u64 current_system_time_us) {
     frame_limiting_delta_err -= duration_cast<microseconds>(now - previous_walltime);
     frame_limiting_delta_err =
         MathUtil::Clamp(frame_limiting_delta_err, -MAX_LAG_TIME_US, MAX_LAG_TIME_US);
+    behind = frame_limiting_delta_err < microseconds::zero();
 
     if (frame_limiting_delta_err > microseconds::zero()) {
-        std::this_thread::sleep_for(frame_limiting_delta_err);
+        WaitUntil(now + frame_limiting_delta_err,
+                  microseconds(std::max(Settings::values.frame_limit_spin_us, 0)));
 
         auto now_after_sleep = Clock::now();
         frame_limiting_delta_err -= duration_cast<microseconds>(now_after_sleep - now);
@@ -102,4 +313,41 @@ void FrameLimiter::DoFrameLimiting(u64 current_system_time_us) {
     previous_walltime = now;
 }
 
+microseconds FrameLimiter::GetWaitTimeUntil(u64 system_time_us) const {
+    if (!Settings::values.toggle_framelimit || !AudioCore::IsOutputRealTime() ||
+        Settings::values.turbo) {
+        return microseconds::zero();
+    }
+
+    // The same balance of emulated time and walltime DoFrameLimiting waits on
+    const microseconds wait_time =
+        frame_limiting_delta_err +
+        microseconds(static_cast<s64>(system_time_us - previous_system_time_us)) -
+        duration_cast<microseconds>(Clock::now() - previous_walltime);
+    return std::max(wait_time, microseconds::zero());
+}
+
+void AddPerfCount(PerfStats::Counter counter, u64 count) {
+    System::GetInstance().perf_stats.AddCount(counter, count);
+}
+
+ScopedPerfTimer::ScopedPerfTimer(PerfStats::Category category)
+    : category(category), start(PerfStats::Clock::now()) {}
+
+ScopedPerfTimer::~ScopedPerfTimer() {
+    System::GetInstance().perf_stats.AddCategoryTime(category, PerfStats::Clock::now() - start);
+}
+
+void FrameLimiter::WaitUntil(Clock::time_point deadline, microseconds spin_time) {
+    // Sleeps tend to overshoot, so only sleep until shortly before the deadline and spin on the
+    // clock for the rest
+    const auto sleep_time = deadline - spin_time - Clock::now();
+    if (sleep_time > Clock::duration::zero()) {
+        std::this_thread::sleep_for(sleep_time);
+    }
+
+    while (Clock::now() < deadline) {
+    }
+}
+
 } // namespace Core
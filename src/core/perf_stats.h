@@ -4,9 +4,15 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <mutex>
+#include <string>
+#include <vector>
+#include "common/common_funcs.h"
 #include "common/common_types.h"
+#include "common/file_util.h"
 
 namespace Core {
 
@@ -18,6 +24,50 @@ class PerfStats {
 public:
     using Clock = std::chrono::high_resolution_clock;
 
+    /**
+     * Subsystems whose walltime is broken down per system frame. The times of the categories nest
+     * and overlap (command processing usually runs within CPU emulation, for example), so they
+     * don't add up to the frame time.
+     */
+    enum class Category {
+        CPUEmulation,
+        CommandProcessing,
+        Drawing,
+        ShaderCompile,
+        SurfaceFlush,
+        Present,
+        NumCategories,
+    };
+    static constexpr size_t NUM_CATEGORIES = static_cast<size_t>(Category::NumCategories);
+
+    /// Work of the host GPU whose time is measured per system frame, when the renderer supports
+    /// it and Settings enable it. The times nest like those of the categories.
+    enum class GPUCategory {
+        Drawing,
+        SurfaceBlit,
+        SurfaceUpload,
+        SurfaceDownload,
+        Present,
+        NumCategories,
+    };
+    static constexpr size_t NUM_GPU_CATEGORIES = static_cast<size_t>(GPUCategory::NumCategories);
+
+    /// Events counted over the stats interval
+    enum class Counter {
+        /// Shader programs compiled from source by the renderer
+        ShaderCompiles,
+        /// Surface lookups of the renderer served by a cached surface
+        SurfaceCacheHits,
+        /// Surface lookups of the renderer that had to create a surface and load it from memory
+        SurfaceCacheMisses,
+        NumCounters,
+    };
+    static constexpr size_t NUM_COUNTERS = static_cast<size_t>(Counter::NumCounters);
+
+    /// Number of frame length histogram bins, each one millisecond wide. The last bin also counts
+    /// all longer frames.
+    static constexpr size_t NUM_HISTOGRAM_BINS = 64;
+
     struct Results {
         /// System FPS (LCD VBlanks) in Hz
         double system_fps;
@@ -25,10 +75,51 @@ public:
         double game_fps;
         /// Walltime per system frame, in seconds, excluding any waits
         double frametime;
+        /// Median walltime between the ends of consecutive system frames, in seconds, including
+        /// waits
+        double frame_length_p50;
+        /// 99th percentile walltime between the ends of consecutive system frames, in seconds,
+        /// including waits
+        double frame_length_p99;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Walltime per system frame spent in each category, in seconds
+        std::array<double, NUM_CATEGORIES> category_time;
+        /// GPU time per system frame spent in each GPU category, in seconds. Measured a few
+        /// frames after the work was submitted, and zero while not measured.
+        std::array<double, NUM_GPU_CATEGORIES> gpu_category_time;
+        /// Number of system frames by their length including waits, in one millisecond bins
+        std::array<u32, NUM_HISTOGRAM_BINS> frame_length_histogram;
+        /// Number of times each counted event happened over the interval
+        std::array<u64, NUM_COUNTERS> counts;
     };
 
+    /// Adds walltime spent in a category to the current stats. Safe to call from any thread.
+    void AddCategoryTime(Category category, Clock::duration time) {
+        category_ns[static_cast<size_t>(category)] +=
+            std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+    }
+
+    /// Adds GPU time spent in a category to the current stats. Safe to call from any thread.
+    void AddGPUCategoryTime(GPUCategory category, u64 time_ns) {
+        gpu_category_ns[static_cast<size_t>(category)] += time_ns;
+    }
+
+    /// Counts an event towards the current stats. Safe to call from any thread.
+    void AddCount(Counter counter, u64 count = 1) {
+        counter_values[static_cast<size_t>(counter)] += count;
+    }
+
+    /// Returns the names of the columns of the rows produced by FormatCsvRow
+    static std::string GetCsvHeader();
+
+    /// Formats results as a row of comma separated values, ending with a line break
+    static std::string FormatCsvRow(const Results& results);
+
+    /// Formats results as a JSON object, with the values named like the CSV columns. Times are
+    /// in seconds, like in Results.
+    static std::string FormatJson(const Results& results);
+
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
@@ -62,6 +153,33 @@ private:
     Clock::time_point frame_begin = reset_point;
     /// Total visible duration (including frame-limiting, etc.) of the previous system frame
     Clock::duration previous_frame_length = Clock::duration::zero();
+    /// Visible durations of the system frames since last reset
+    std::vector<Clock::duration> frame_lengths;
+    /// Histogram of the visible durations of the system frames since last reset
+    std::array<u32, NUM_HISTOGRAM_BINS> frame_length_histogram{};
+    /// Cumulative walltime of each category since last reset, in nanoseconds
+    std::array<std::atomic<u64>, NUM_CATEGORIES> category_ns{};
+    /// Cumulative GPU time of each GPU category since last reset, in nanoseconds
+    std::array<std::atomic<u64>, NUM_GPU_CATEGORIES> gpu_category_ns{};
+    /// Number of times each counted event happened since last reset
+    std::array<std::atomic<u64>, NUM_COUNTERS> counter_values{};
+
+    /// File the results are appended to as they are collected, if Settings request it
+    FileUtil::IOFile csv_file;
+};
+
+/// Counts an event towards the system's PerfStats
+void AddPerfCount(PerfStats::Counter counter, u64 count = 1);
+
+/// Adds the walltime of its scope to a category of the system's PerfStats
+class ScopedPerfTimer : NonCopyable {
+public:
+    explicit ScopedPerfTimer(PerfStats::Category category);
+    ~ScopedPerfTimer();
+
+private:
+    PerfStats::Category category;
+    PerfStats::Clock::time_point start;
 };
 
 class FrameLimiter {
@@ -70,6 +188,18 @@ public:
 
     void DoFrameLimiting(u64 current_system_time_us);
 
+    /**
+     * Returns the walltime left until emulation should reach the given emulated system time, to
+     * stay in step with the wall clock. Zero if it's already late, or the limiter is disabled.
+     */
+    std::chrono::microseconds GetWaitTimeUntil(u64 system_time_us) const;
+
+    /// Whether emulation was behind the wall clock at the last limiter invocation, so that it
+    /// didn't wait. Always false while the limiter is disabled.
+    bool IsBehind() const {
+        return behind;
+    }
+
 private:
     /// Emulated system time (in microseconds) at the last limiter invocation
     u64 previous_system_time_us = 0;
@@ -78,6 +208,11 @@ private:
 
     /// Accumulated difference between walltime and emulated time
     std::chrono::microseconds frame_limiting_delta_err{0};
+    /// Whether the accumulated difference was negative at the last limiter invocation
+    bool behind = false;
+
+    /// Waits until the given point in walltime, spinning for the last `spin_time` of it
+    static void WaitUntil(Clock::time_point deadline, std::chrono::microseconds spin_time);
 };
 
 } // namespace Core
@@ -22,6 +22,7 @@ void Apply() {
 
     VideoCore::g_hw_renderer_enabled = values.use_hw_renderer;
     VideoCore::g_shader_jit_enabled = values.use_shader_jit;
+    VideoCore::g_hw_shader_enabled = values.use_hw_shader;
     VideoCore::g_toggle_framelimit_enabled = values.toggle_framelimit;
 
     if (VideoCore::g_emu_window) {
@@ -31,6 +32,8 @@ void Apply() {
 
     AudioCore::SelectSink(values.sink_id);
     AudioCore::EnableStretching(values.enable_audio_stretching);
+    AudioCore::SetOutputLatency(values.audio_latency);
+    AudioCore::EnableTurbo(values.turbo);
 
     Service::HID::ReloadInputDevices();
     Service::IR::ReloadInputDevices();
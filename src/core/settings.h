@@ -82,9 +82,17 @@ struct Values {
 
     // Core
     bool use_cpu_jit;
+    int cpu_max_slice_length;
+    /// Maps the code of titles from a cache shared by all emulator instances running them
+    bool share_code_pages;
+    /// Records the code blocks the interpreter translates, to translate them ahead of time on
+    /// later boots of the title
+    bool use_disk_block_cache;
 
     // Data Storage
     bool use_virtual_sd;
+    bool use_async_fs_reads;
+    bool deterministic_fs_reads;
 
     // System Region
     int region_value;
@@ -95,6 +103,30 @@ struct Values {
     float resolution_factor;
     bool use_vsync;
     bool toggle_framelimit;
+    int frame_limit_spin_us;
+    /// Runs unthrottled while set. Toggled at runtime by the frontends, never saved.
+    bool turbo;
+    /// While in turbo mode, only every turbo_frame_skip-th frame is presented
+    int turbo_frame_skip;
+    /// Most frames in a row that are skipped when emulation falls behind, 0 to never skip
+    int frame_skip;
+    bool use_surface_page_index;
+    int surface_texture_pool_size;
+    bool use_gpu_surface_untiling;
+    bool use_surface_preloading;
+    bool use_shared_surface_textures;
+    bool use_hw_shader;
+    bool use_disk_shader_cache;
+    bool use_async_shader_compile;
+    bool use_ubershader;
+    int vertex_cache_size;
+    bool use_multithreaded_vertex_shading;
+    bool use_vertex_loader_jit;
+    bool use_multithreaded_sw_rasterizer;
+    bool use_gpu_thread;
+    bool use_presentation_thread;
+    /// YUV4MPEG2 file the frames are written to, if not empty
+    std::string frame_dump_path;
 
     LayoutOption layout_option;
     bool swap_screen;
@@ -117,7 +149,10 @@ struct Values {
     // Audio
     std::string sink_id;
     bool enable_audio_stretching;
+    u16 audio_latency; ///< Units: milliseconds
+    bool use_audio_thread;
     std::string audio_device_id;
+    std::string audio_dump_path;
 
     // Camera
     std::array<std::string, Service::CAM::NumCameras> camera_name;
@@ -126,6 +161,13 @@ struct Values {
     // Debugging
     bool use_gdbstub;
     u16 gdbstub_port;
+    std::string perf_stats_csv_path;
+    bool use_gpu_timer_queries;
+    u32 trace_capture_frames;
+    std::string trace_capture_path;
+    std::string guest_profile_path;
+    std::string movie_record_path;
+    std::string movie_play_path;
 
     // WebService
     std::string telemetry_endpoint_url;
@@ -41,8 +41,9 @@ TelemetrySession::TelemetrySession() {
                             .count()};
     AddField(Telemetry::FieldType::Session, "Init_Time", init_time);
     std::string program_name;
-    const Loader::ResultStatus res{System::GetInstance().GetAppLoader().ReadTitle(program_name)};
-    if (res == Loader::ResultStatus::Success) {
+    if (System::GetInstance().IsAppLoaded() &&
+        System::GetInstance().GetAppLoader().ReadTitle(program_name) ==
+            Loader::ResultStatus::Success) {
         AddField(Telemetry::FieldType::Session, "ProgramName", program_name);
     }
 
@@ -0,0 +1,247 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/hle/kernel/process.h"
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/tracer/player.h"
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace CiTrace {
+
+namespace {
+
+/// Copies up to `size` bytes of `count` words at `offset` of the trace, as much as both hold
+void CopyWords(const std::vector<u8>& file_data, u32 offset, u32 count, void* out, size_t size) {
+    std::memcpy(out, file_data.data() + offset, std::min<size_t>(count * sizeof(u32), size));
+}
+
+/// Loads shader uniforms stored as four raw float24 words each
+void LoadFloat24(const std::vector<u8>& file_data, u32 offset, u32 count,
+                 Math::Vec4<Pica::float24>* out, size_t out_count) {
+    count = std::min<u32>(count, static_cast<u32>(out_count * 4));
+    for (u32 i = 0; i < count; ++i) {
+        u32 word;
+        std::memcpy(&word, file_data.data() + offset + i * sizeof(u32), sizeof(u32));
+        out[i / 4][i % 4] = Pica::float24::FromRaw(word & 0xFFFFFF);
+    }
+}
+
+void LoadUniformRegs(Pica::Shader::ShaderSetup& setup, const Pica::ShaderRegs& config) {
+    for (unsigned i = 0; i < setup.uniforms.b.size(); ++i)
+        setup.uniforms.b[i] = (config.bool_uniforms & (1 << i)) != 0;
+    for (unsigned i = 0; i < setup.uniforms.i.size(); ++i) {
+        const auto& values = config.int_uniforms[i];
+        setup.uniforms.i[i] = Math::Vec4<u8>(values.x, values.y, values.z, values.w);
+    }
+}
+
+} // Anonymous namespace
+
+Player::Player()
+    : fcram(std::make_shared<std::vector<u8>>(Memory::FCRAM_SIZE)),
+      vram(std::make_shared<std::vector<u8>>(Memory::VRAM_SIZE)) {
+    Kernel::g_current_process = Kernel::Process::Create(Kernel::CodeSet::Create("CiTrace", 0));
+    auto& vm_manager = Kernel::g_current_process->vm_manager;
+    vm_manager.MapMemoryBlock(Memory::LINEAR_HEAP_VADDR, fcram, 0, Memory::FCRAM_SIZE,
+                              Kernel::MemoryState::Continuous);
+    vm_manager.MapMemoryBlock(Memory::VRAM_VADDR, vram, 0, Memory::VRAM_SIZE,
+                              Kernel::MemoryState::IO);
+}
+
+Player::~Player() {
+    Kernel::g_current_process = nullptr;
+}
+
+bool Player::Load(const std::string& filename) {
+    FileUtil::IOFile file(filename, "rb");
+    file_data.resize(file.GetSize());
+    if (!file.IsOpen() || file.ReadBytes(file_data.data(), file_data.size()) != file_data.size()) {
+        LOG_ERROR(HW_GPU, "Could not read %s", filename.c_str());
+        return false;
+    }
+
+    if (file_data.size() < sizeof(header)) {
+        LOG_ERROR(HW_GPU, "%s is too small to be a CiTrace file", filename.c_str());
+        return false;
+    }
+    std::memcpy(&header, file_data.data(), sizeof(header));
+    if (std::memcmp(header.magic, CTHeader::ExpectedMagicWord(), 4) != 0 ||
+        header.version != CTHeader::ExpectedVersion()) {
+        LOG_ERROR(HW_GPU, "%s is not a CiTrace file of a supported version", filename.c_str());
+        return false;
+    }
+
+    auto in_file = [this](u64 offset, u64 size) {
+        return offset <= file_data.size() && size <= file_data.size() - offset;
+    };
+
+    const auto& initial = header.initial_state_offsets;
+    const std::pair<u32, u32> initial_ranges[] = {
+        {initial.gpu_registers, initial.gpu_registers_size},
+        {initial.lcd_registers, initial.lcd_registers_size},
+        {initial.pica_registers, initial.pica_registers_size},
+        {initial.default_attributes, initial.default_attributes_size},
+        {initial.vs_program_binary, initial.vs_program_binary_size},
+        {initial.vs_swizzle_data, initial.vs_swizzle_data_size},
+        {initial.vs_float_uniforms, initial.vs_float_uniforms_size},
+        {initial.gs_program_binary, initial.gs_program_binary_size},
+        {initial.gs_swizzle_data, initial.gs_swizzle_data_size},
+        {initial.gs_float_uniforms, initial.gs_float_uniforms_size},
+    };
+    for (const auto& range : initial_ranges) {
+        if (!in_file(range.first, static_cast<u64>(range.second) * sizeof(u32))) {
+            LOG_ERROR(HW_GPU, "%s: initial state out of bounds", filename.c_str());
+            return false;
+        }
+    }
+
+    if (!in_file(header.stream_offset,
+                 static_cast<u64>(header.stream_size) * sizeof(CTStreamElement))) {
+        LOG_ERROR(HW_GPU, "%s: stream out of bounds", filename.c_str());
+        return false;
+    }
+    stream.resize(header.stream_size);
+    std::memcpy(stream.data(), file_data.data() + header.stream_offset,
+                stream.size() * sizeof(CTStreamElement));
+
+    frame_starts.assign(1, 0);
+    for (size_t i = 0; i < stream.size(); ++i) {
+        const CTStreamElement& element = stream[i];
+        switch (element.type) {
+        case FrameMarker:
+            frame_starts.push_back(i + 1);
+            break;
+        case MemoryLoad:
+            if (!in_file(element.memory_load.file_offset, element.memory_load.size)) {
+                LOG_ERROR(HW_GPU, "%s: memory load %zu out of bounds", filename.c_str(), i);
+                return false;
+            }
+            break;
+        case RegisterWrite:
+            break;
+        default:
+            LOG_ERROR(HW_GPU, "%s: unknown stream element type 0x%x", filename.c_str(),
+                      static_cast<u32>(element.type));
+            return false;
+        }
+    }
+    if (frame_starts.back() != stream.size())
+        frame_starts.push_back(stream.size());
+
+    return true;
+}
+
+size_t Player::GetFrameCount() const {
+    return frame_starts.empty() ? 0 : frame_starts.size() - 1;
+}
+
+void Player::RestoreInitialState() {
+    const auto& initial = header.initial_state_offsets;
+
+    CopyWords(file_data, initial.gpu_registers, initial.gpu_registers_size, &GPU::g_regs,
+              sizeof(GPU::g_regs));
+    CopyWords(file_data, initial.lcd_registers, initial.lcd_registers_size, &LCD::g_regs,
+              sizeof(LCD::g_regs));
+
+    auto& state = Pica::g_state;
+    CopyWords(file_data, initial.pica_registers, initial.pica_registers_size,
+              state.regs.reg_array.data(), sizeof(state.regs.reg_array));
+    LoadFloat24(file_data, initial.default_attributes, initial.default_attributes_size,
+                state.input_default_attributes.attr, 16);
+
+    CopyWords(file_data, initial.vs_program_binary, initial.vs_program_binary_size,
+              state.vs.program_code.data(), sizeof(state.vs.program_code));
+    CopyWords(file_data, initial.vs_swizzle_data, initial.vs_swizzle_data_size,
+              state.vs.swizzle_data.data(), sizeof(state.vs.swizzle_data));
+    LoadFloat24(file_data, initial.vs_float_uniforms, initial.vs_float_uniforms_size,
+                state.vs.uniforms.f, 96);
+    LoadUniformRegs(state.vs, state.regs.vs);
+
+    // Recordings don't have the geometry shader yet, which shares the vertex shader's program
+    // unless it is configured separately
+    if (initial.gs_program_binary_size == 0 &&
+        !state.regs.pipeline.gs_unit_exclusive_configuration) {
+        state.gs.program_code = state.vs.program_code;
+        state.gs.swizzle_data = state.vs.swizzle_data;
+    } else {
+        CopyWords(file_data, initial.gs_program_binary, initial.gs_program_binary_size,
+                  state.gs.program_code.data(), sizeof(state.gs.program_code));
+        CopyWords(file_data, initial.gs_swizzle_data, initial.gs_swizzle_data_size,
+                  state.gs.swizzle_data.data(), sizeof(state.gs.swizzle_data));
+    }
+    LoadFloat24(file_data, initial.gs_float_uniforms, initial.gs_float_uniforms_size,
+                state.gs.uniforms.f, 96);
+    LoadUniformRegs(state.gs, state.regs.gs);
+
+    // Start every replay from the memory contents, not what the renderer has left over
+    Memory::RasterizerFlushAndInvalidateRegion(Memory::FCRAM_PADDR, Memory::FCRAM_SIZE);
+    Memory::RasterizerFlushAndInvalidateRegion(Memory::VRAM_PADDR, Memory::VRAM_SIZE);
+
+    auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+    for (u32 id = 0; id < Pica::Regs::NUM_REGS; ++id)
+        rasterizer->NotifyPicaRegisterChanged(id);
+}
+
+void Player::ReplayFrame(size_t frame) {
+    for (size_t i = frame_starts[frame]; i < frame_starts[frame + 1]; ++i) {
+        const CTStreamElement& element = stream[i];
+        switch (element.type) {
+        case MemoryLoad: {
+            const CTMemoryLoad& load = element.memory_load;
+            if (load.size == 0)
+                break;
+
+            const PAddr end = load.physical_address + load.size - 1;
+            u8* dest = Memory::GetPhysicalPointer(load.physical_address);
+            if (dest == nullptr || Memory::GetPhysicalPointer(end) != dest + load.size - 1) {
+                LOG_WARNING(HW_GPU, "Skipping memory load to unmapped 0x%08x-0x%08x",
+                            load.physical_address, end);
+                break;
+            }
+            Memory::RasterizerFlushAndInvalidateRegion(load.physical_address, load.size);
+            std::memcpy(dest, file_data.data() + load.file_offset, load.size);
+            break;
+        }
+
+        case RegisterWrite: {
+            const CTRegisterWrite& write = element.register_write;
+            const VAddr vaddr = write.physical_address - Memory::IO_AREA_PADDR +
+                                Memory::IO_AREA_VADDR;
+            switch (write.size) {
+            case CTRegisterWrite::SIZE_8:
+                HW::Write<u8>(vaddr, static_cast<u8>(write.value));
+                break;
+            case CTRegisterWrite::SIZE_16:
+                HW::Write<u16>(vaddr, static_cast<u16>(write.value));
+                break;
+            case CTRegisterWrite::SIZE_32:
+                HW::Write<u32>(vaddr, static_cast<u32>(write.value));
+                break;
+            case CTRegisterWrite::SIZE_64:
+                HW::Write<u64>(vaddr, write.value);
+                break;
+            }
+            break;
+        }
+
+        case FrameMarker:
+            // Frame markers are recorded once the frame has been presented
+            VideoCore::g_renderer->SwapBuffers();
+            break;
+        }
+    }
+}
+
+} // namespace CiTrace
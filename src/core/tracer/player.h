@@ -0,0 +1,56 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "core/tracer/citrace.h"
+
+namespace CiTrace {
+
+/**
+ * Replays the GPU commands of a CiTrace recording through the hardware registers, the command
+ * processor and the active renderer, without running an application. Meant to be used with a
+ * system set up by Core::System::InitTraceReplay.
+ */
+class Player {
+public:
+    /// Sets up an address space with FCRAM and VRAM for the memory loads of the trace to go to
+    Player();
+    ~Player();
+
+    /**
+     * Loads a CiTrace file, checking that everything it refers to is within the file.
+     * @returns false, logging why, if the file can't be replayed
+     */
+    bool Load(const std::string& filename);
+
+    /// Returns the number of frames in the trace. Commands after the last frame marker count as
+    /// one more frame.
+    size_t GetFrameCount() const;
+
+    /**
+     * Restores the GPU, LCD and Pica registers and the shader setup stored in the trace, and
+     * drops whatever the renderer cached of emulated memory. Use before replaying the first frame.
+     */
+    void RestoreInitialState();
+
+    /// Replays the memory loads and register writes of a frame, then presents it
+    void ReplayFrame(size_t frame);
+
+private:
+    std::vector<u8> file_data;
+    CTHeader header;
+    std::vector<CTStreamElement> stream;
+    /// Index in the stream of the first element of each frame, followed by the end of the stream
+    std::vector<size_t> frame_starts;
+
+    std::shared_ptr<std::vector<u8>> fcram;
+    std::shared_ptr<std::vector<u8>> vram;
+};
+
+} // namespace CiTrace
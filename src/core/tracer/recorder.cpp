@@ -2,15 +2,36 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
+#include <random>
 #include "common/assert.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/string_util.h"
 #include "core/tracer/recorder.h"
 
 namespace CiTrace {
 
-Recorder::Recorder(const InitialState& initial_state) : initial_state(initial_state) {}
+Recorder::Recorder(const InitialState& initial_state) : initial_state(initial_state) {
+    const std::string& cache_dir = FileUtil::GetUserPath(D_CACHE_IDX);
+    FileUtil::CreateFullPath(cache_dir);
+    // Other instances may be recording at the same time, so each uses files of its own
+    const std::string suffix = Common::StringFromFormat(".%08X.tmp", std::random_device()());
+    data_path = cache_dir + "citrace_data" + suffix;
+    stream_path = cache_dir + "citrace_stream" + suffix;
+
+    if (!data_file.Open(data_path, "wb") || !stream_file.Open(stream_path, "wb"))
+        LOG_ERROR(HW_GPU, "Failed to create the CiTrace recording files in %s", cache_dir.c_str());
+}
+
+Recorder::~Recorder() {
+    data_file.Close();
+    stream_file.Close();
+    FileUtil::Delete(data_path);
+    FileUtil::Delete(stream_path);
+}
 
 void Recorder::Finish(const std::string& filename) {
     // Setup CiTrace header
@@ -32,7 +53,7 @@ void Recorder::Finish(const std::string& filename) {
     initial.gs_program_binary_size = static_cast<u32>(initial_state.gs_program_binary.size());
     initial.gs_swizzle_data_size = static_cast<u32>(initial_state.gs_swizzle_data.size());
     initial.gs_float_uniforms_size = static_cast<u32>(initial_state.gs_float_uniforms.size());
-    header.stream_size = static_cast<u32>(stream.size());
+    header.stream_size = stream_size;
 
     initial.gpu_registers = sizeof(header);
     initial.lcd_registers = initial.gpu_registers + initial.gpu_registers_size * sizeof(u32);
@@ -51,29 +72,16 @@ void Recorder::Finish(const std::string& filename) {
         initial.gs_program_binary + initial.gs_program_binary_size * sizeof(u32);
     initial.gs_float_uniforms =
         initial.gs_swizzle_data + initial.gs_swizzle_data_size * sizeof(u32);
-    header.stream_offset = initial.gs_float_uniforms + initial.gs_float_uniforms_size * sizeof(u32);
-
-    // Iterate through stream elements, update relevant stream element data
-    for (auto& stream_element : stream) {
-        switch (stream_element.data.type) {
-        case MemoryLoad: {
-            auto& file_offset = memory_regions[stream_element.hash];
-            if (!stream_element.uses_existing_data) {
-                file_offset = header.stream_offset;
-            }
-            stream_element.data.memory_load.file_offset = file_offset;
-            break;
-        }
-
-        default:
-            // Other commands don't use any extra data
-            DEBUG_ASSERT(stream_element.extra_data.size() == 0);
-            break;
-        }
-        header.stream_offset += static_cast<u32>(stream_element.extra_data.size());
-    }
+    const u32 data_offset =
+        initial.gs_float_uniforms + initial.gs_float_uniforms_size * sizeof(u32);
+    header.stream_offset = data_offset + data_size;
 
     try {
+        // Reopen the recording for reading
+        if (!data_file || !stream_file || !data_file.Close() || !stream_file.Close() ||
+            !data_file.Open(data_path, "rb") || !stream_file.Open(stream_path, "rb"))
+            throw "Failed to record to the temporary files";
+
         // Open file and write header
         FileUtil::IOFile file(filename, "wb");
         size_t written = file.WriteObject(header);
@@ -139,66 +147,79 @@ void Recorder::Finish(const std::string& filename) {
             file.Tell() != initial.gs_float_uniforms + sizeof(u32) * initial.gs_float_uniforms_size)
             throw "Failed to write geometry shader float uniforms";
 
-        // Iterate through stream elements, write "extra data"
-        for (const auto& stream_element : stream) {
-            if (stream_element.extra_data.size() == 0)
-                continue;
-
-            written =
-                file.WriteBytes(stream_element.extra_data.data(), stream_element.extra_data.size());
-            if (written != stream_element.extra_data.size())
+        // Copy the contents of memory loads, a chunk at a time
+        std::vector<u8> buffer(1024 * 1024);
+        for (u32 offset = 0; offset < data_size;) {
+            const size_t chunk_size = std::min<size_t>(buffer.size(), data_size - offset);
+            if (data_file.ReadBytes(buffer.data(), chunk_size) != chunk_size ||
+                file.WriteBytes(buffer.data(), chunk_size) != chunk_size)
                 throw "Failed to write extra data";
+            offset += static_cast<u32>(chunk_size);
         }
 
         if (file.Tell() != header.stream_offset)
             throw "Unexpected end of extra data";
 
-        // Write actual stream elements
-        for (const auto& stream_element : stream) {
-            if (1 != file.WriteObject(stream_element.data))
+        // Copy the stream elements, pointing memory loads at their place in the output file
+        std::vector<CTStreamElement> elements(buffer.size() / sizeof(CTStreamElement));
+        for (u32 index = 0; index < stream_size;) {
+            const size_t count = std::min<size_t>(elements.size(), stream_size - index);
+            if (stream_file.ReadArray(elements.data(), count) != count)
+                throw "Failed to read stream elements";
+
+            for (size_t i = 0; i < count; ++i) {
+                if (elements[i].type == MemoryLoad)
+                    elements[i].memory_load.file_offset += data_offset;
+            }
+
+            if (file.WriteArray(elements.data(), count) != count)
                 throw "Failed to write stream element";
+            index += static_cast<u32>(count);
         }
     } catch (const char* str) {
         LOG_ERROR(HW_GPU, "Writing CiTrace file failed: %s", str);
     }
 }
 
+void Recorder::WriteElement(const CTStreamElement& element) {
+    stream_file.WriteObject(element);
+    ++stream_size;
+}
+
 void Recorder::FrameFinished() {
-    stream.push_back({{FrameMarker}});
+    WriteElement({FrameMarker});
 }
 
 void Recorder::MemoryAccessed(const u8* data, u32 size, u32 physical_address) {
-    StreamElement element = {{MemoryLoad}};
-    element.data.memory_load.size = size;
-    element.data.memory_load.physical_address = physical_address;
-
-    // Compute hash over given memory region to check if the contents are already stored internally
-    boost::crc_32_type result;
-    result.process_bytes(data, size);
-    element.hash = result.checksum();
-
-    element.uses_existing_data = (memory_regions.find(element.hash) != memory_regions.end());
-    if (!element.uses_existing_data) {
-        element.extra_data.resize(size);
-        memcpy(element.extra_data.data(), data, size);
-        memory_regions.insert({element.hash, 0}); // file offset will be initialized in Finish()
+    CTStreamElement element = {MemoryLoad};
+    element.memory_load.size = size;
+    element.memory_load.physical_address = physical_address;
+
+    // Compute hash over given memory region to check if the contents are already stored
+    const u64 hash = Common::XXHash64(data, size);
+
+    auto inserted = memory_regions.emplace(hash, data_size);
+    if (inserted.second) {
+        data_file.WriteBytes(data, size);
+        data_size += size;
     }
+    element.memory_load.file_offset = inserted.first->second;
 
-    stream.push_back(element);
+    WriteElement(element);
 }
 
 template <typename T>
 void Recorder::RegisterWritten(u32 physical_address, T value) {
-    StreamElement element = {{RegisterWrite}};
-    element.data.register_write.size =
+    CTStreamElement element = {RegisterWrite};
+    element.register_write.size =
         (sizeof(T) == 1) ? CTRegisterWrite::SIZE_8
                          : (sizeof(T) == 2) ? CTRegisterWrite::SIZE_16
                                             : (sizeof(T) == 4) ? CTRegisterWrite::SIZE_32
                                                                : CTRegisterWrite::SIZE_64;
-    element.data.register_write.physical_address = physical_address;
-    element.data.register_write.value = value;
+    element.register_write.physical_address = physical_address;
+    element.register_write.value = value;
 
-    stream.push_back(element);
+    WriteElement(element);
 }
 
 template void Recorder::RegisterWritten(u32, u8);
@@ -7,8 +7,8 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
-#include <boost/crc.hpp>
 #include "common/common_types.h"
+#include "common/file_util.h"
 #include "core/tracer/citrace.h"
 
 namespace CiTrace {
@@ -34,6 +34,9 @@ public:
      */
     Recorder(const InitialState& initial_state);
 
+    /// Removes the temporary files of the recording
+    ~Recorder();
+
     /// Finish recording of this Citrace and save it using the given filename.
     void Finish(const std::string& filename);
 
@@ -55,33 +58,28 @@ public:
     void RegisterWritten(u32 physical_address, T value);
 
 private:
+    void WriteElement(const CTStreamElement& element);
+
     // Initial state of recording start
     InitialState initial_state;
 
-    // Command stream
-    struct StreamElement {
-        CTStreamElement data;
-
-        /**
-          * Extra data to store along "core" data.
-          * This is e.g. used for data used in MemoryUpdates.
-          */
-        std::vector<u8> extra_data;
-
-        /// Optional CRC hash (e.g. for hashing memory regions)
-        boost::crc_32_type::value_type hash;
-
-        /// If true, refer to data already written to the output file instead of extra_data
-        bool uses_existing_data;
-    };
-
-    std::vector<StreamElement> stream;
+    /**
+     * The recording is streamed to two temporary files as it goes, so that long recordings don't
+     * have to fit in memory: the contents of memory loads, and the stream elements. Memory loads
+     * refer to their contents by offset in the data file until Finish puts the data in place.
+     */
+    std::string data_path;
+    std::string stream_path;
+    FileUtil::IOFile data_file;
+    FileUtil::IOFile stream_file;
+    u32 data_size = 0;
+    u32 stream_size = 0;
 
     /**
-     * Internal cache which maps hashes of memory contents to file offsets at which those memory
-     * contents are stored.
+     * Internal cache which maps hashes of memory contents to offsets in the data file at which
+     * those memory contents are stored.
      */
-    std::unordered_map<boost::crc_32_type::value_type /*hash*/, u32 /*file_offset*/> memory_regions;
+    std::unordered_map<u64 /*hash*/, u32 /*data_offset*/> memory_regions;
 };
 
 } // namespace
@@ -2,11 +2,17 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 #include <SDL.h>
 #include "common/logging/log.h"
 #include "common/math_util.h"
@@ -23,29 +29,70 @@ static std::unordered_map<int, std::weak_ptr<SDLJoystick>> joystick_list;
 static std::shared_ptr<SDLButtonFactory> button_factory;
 static std::shared_ptr<SDLAnalogFactory> analog_factory;
 
+/// Guards joystick_list and the SDL joystick functions, which the polling thread calls too
+static std::mutex joystick_mutex;
+/// Wakes the polling thread once there is a joystick to poll, or when it has to stop
+static std::condition_variable poll_wakeup;
+static std::thread poll_thread;
+static std::atomic<bool> polling{false};
+
+/// How often the polling thread reads the joysticks, well within a HID pad update period
+constexpr std::chrono::milliseconds POLL_INTERVAL{1};
+
 static bool initialized = false;
 
+static void CloseJoystick(SDL_Joystick* joystick) {
+    std::lock_guard<std::mutex> lock(joystick_mutex);
+    SDL_JoystickClose(joystick);
+}
+
+/**
+ * A joystick, whose state is read by the polling thread as it changes. The devices read the latest
+ * state from atomics, so HID gets it without waiting for SDL or taking a lock.
+ */
 class SDLJoystick {
 public:
+    /// Opens the joystick. joystick_mutex must be held.
     explicit SDLJoystick(int joystick_index)
-        : joystick{SDL_JoystickOpen(joystick_index), SDL_JoystickClose} {
+        : joystick{SDL_JoystickOpen(joystick_index), CloseJoystick} {
         if (!joystick) {
             LOG_ERROR(Input, "failed to open joystick %d", joystick_index);
+            return;
         }
+        buttons = std::vector<std::atomic<bool>>(SDL_JoystickNumButtons(joystick.get()));
+        axes = std::vector<std::atomic<Sint16>>(SDL_JoystickNumAxes(joystick.get()));
+        hats = std::vector<std::atomic<Uint8>>(SDL_JoystickNumHats(joystick.get()));
+        Update();
     }
 
-    bool GetButton(int button) const {
+    /// Stores the state SDL last read from the joystick. joystick_mutex must be held.
+    void Update() {
         if (!joystick)
+            return;
+        for (size_t i = 0; i < buttons.size(); ++i) {
+            buttons[i].store(SDL_JoystickGetButton(joystick.get(), static_cast<int>(i)) == 1,
+                             std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < axes.size(); ++i) {
+            axes[i].store(SDL_JoystickGetAxis(joystick.get(), static_cast<int>(i)),
+                          std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < hats.size(); ++i) {
+            hats[i].store(SDL_JoystickGetHat(joystick.get(), static_cast<int>(i)),
+                          std::memory_order_relaxed);
+        }
+    }
+
+    bool GetButton(int button) const {
+        if (button < 0 || static_cast<size_t>(button) >= buttons.size())
             return {};
-        SDL_JoystickUpdate();
-        return SDL_JoystickGetButton(joystick.get(), button) == 1;
+        return buttons[button].load(std::memory_order_relaxed);
     }
 
     float GetAxis(int axis) const {
-        if (!joystick)
+        if (axis < 0 || static_cast<size_t>(axis) >= axes.size())
             return {};
-        SDL_JoystickUpdate();
-        return SDL_JoystickGetAxis(joystick.get(), axis) / 32767.0f;
+        return axes[axis].load(std::memory_order_relaxed) / 32767.0f;
     }
 
     std::tuple<float, float> GetAnalog(int axis_x, int axis_y) const {
@@ -66,11 +113,16 @@ public:
     }
 
     bool GetHatDirection(int hat, Uint8 direction) const {
-        return (SDL_JoystickGetHat(joystick.get(), hat) & direction) != 0;
+        if (hat < 0 || static_cast<size_t>(hat) >= hats.size())
+            return {};
+        return (hats[hat].load(std::memory_order_relaxed) & direction) != 0;
     }
 
 private:
-    std::unique_ptr<SDL_Joystick, decltype(&SDL_JoystickClose)> joystick;
+    std::unique_ptr<SDL_Joystick, decltype(&CloseJoystick)> joystick;
+    std::vector<std::atomic<bool>> buttons;
+    std::vector<std::atomic<Sint16>> axes;
+    std::vector<std::atomic<Uint8>> hats;
 };
 
 class SDLButton final : public Input::ButtonDevice {
@@ -139,10 +191,12 @@ private:
 };
 
 static std::shared_ptr<SDLJoystick> GetJoystick(int joystick_index) {
+    std::lock_guard<std::mutex> lock(joystick_mutex);
     std::shared_ptr<SDLJoystick> joystick = joystick_list[joystick_index].lock();
     if (!joystick) {
         joystick = std::make_shared<SDLJoystick>(joystick_index);
         joystick_list[joystick_index] = joystick;
+        poll_wakeup.notify_one();
     }
     return joystick;
 }
@@ -227,10 +281,49 @@ public:
     }
 };
 
+/// Whether any joystick is bound to a device. joystick_mutex must be held.
+static bool HasOpenJoysticks() {
+    for (auto it = joystick_list.begin(); it != joystick_list.end();) {
+        if (!it->second.expired())
+            return true;
+        it = joystick_list.erase(it);
+    }
+    return false;
+}
+
+static void PollLoop() {
+    while (polling) {
+        // Joysticks are closed under the lock, so the last reference to one is dropped after it
+        std::vector<std::shared_ptr<SDLJoystick>> joysticks;
+        {
+            // Without any joystick bound, there is nothing to ask the devices for
+            std::unique_lock<std::mutex> lock(joystick_mutex);
+            poll_wakeup.wait(lock, [] { return !polling || HasOpenJoysticks(); });
+            if (!polling)
+                break;
+
+            SDL_JoystickUpdate();
+            for (const auto& entry : joystick_list) {
+                if (std::shared_ptr<SDLJoystick> joystick = entry.second.lock()) {
+                    joystick->Update();
+                    joysticks.push_back(std::move(joystick));
+                }
+            }
+        }
+        std::this_thread::sleep_for(POLL_INTERVAL);
+    }
+}
+
 void Init() {
     if (SDL_Init(SDL_INIT_JOYSTICK) < 0) {
         LOG_CRITICAL(Input, "SDL_Init(SDL_INIT_JOYSTICK) failed with: %s", SDL_GetError());
     } else {
+        // The polling thread updates the joysticks, rather than whichever thread pumps the SDL
+        // events of the frontend, which would only do so once a frame
+        SDL_JoystickEventState(SDL_IGNORE);
+        polling = true;
+        poll_thread = std::thread(PollLoop);
+
         using namespace Input;
         RegisterFactory<ButtonDevice>("sdl", std::make_shared<SDLButtonFactory>());
         RegisterFactory<AnalogDevice>("sdl", std::make_shared<SDLAnalogFactory>());
@@ -243,6 +336,12 @@ void Shutdown() {
         using namespace Input;
         UnregisterFactory<ButtonDevice>("sdl");
         UnregisterFactory<AnalogDevice>("sdl");
+        {
+            std::lock_guard<std::mutex> lock(joystick_mutex);
+            polling = false;
+        }
+        poll_wakeup.notify_one();
+        poll_thread.join();
         SDL_QuitSubSystem(SDL_INIT_JOYSTICK);
     }
 }
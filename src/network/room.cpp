@@ -4,18 +4,54 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
 #include <random>
 #include <thread>
+#include <unordered_map>
 #include <vector>
+#include "common/hash.h"
+#include "common/logging/log.h"
 #include "enet/enet.h"
 #include "network/packet.h"
 #include "network/room.h"
+#include "network/room_member.h"
+#include "network/wakeup_signal.h"
 
 namespace Network {
 
 /// Maximum number of concurrent connections allowed to this room.
 static constexpr u32 MaxConcurrentConnections = 10;
 
+/// Longest time the room's own thread waits without servicing its host, which ENet needs for its
+/// pings and retransmissions. Received packets and Destroy wake it sooner.
+static constexpr u32 ServiceIntervalMs = 100;
+
+/// Offset of the destination address in a IdWifiPacket message: after the message type, the
+/// WifiPacket type, the channel and the transmitter address.
+static constexpr size_t WifiPacketDestinationOffset = 3 * sizeof(u8) + sizeof(MacAddress);
+/// Offset of the WifiPacket type in a IdWifiPacket message
+static constexpr size_t WifiPacketTypeOffset = sizeof(u8);
+/// Offset of the frame data in a IdWifiPacket message, after both addresses
+static constexpr size_t WifiPacketDataOffset = WifiPacketDestinationOffset + sizeof(MacAddress);
+
+/// Beacons arriving sooner than this after the last one forwarded from the same member are dropped.
+/// Hosts send one every 102.4 ms, so this only throttles members sending them too often.
+static constexpr std::chrono::milliseconds MinBeaconInterval{50};
+/// Beacons identical to the last one forwarded from the same member are only forwarded this often.
+/// Scanning members keep the last beacon of each network, so resending it unchanged every 100 ms
+/// only adds traffic.
+static constexpr std::chrono::milliseconds DuplicateBeaconInterval{500};
+
+struct MacAddressHash {
+    size_t operator()(const MacAddress& address) const {
+        u64 value = 0;
+        std::memcpy(&value, address.data(), address.size());
+        return std::hash<u64>()(value);
+    }
+};
+
 class Room::RoomImpl {
 public:
     // This MAC address is used to generate a 'Nintendo' like Mac address.
@@ -35,17 +71,49 @@ public:
     };
     using MemberList = std::vector<Member>;
     MemberList members; ///< Information about the members of this room.
+    /// The peer of each member, by MAC address. Lets packets be routed without scanning `members`.
+    std::unordered_map<MacAddress, ENetPeer*, MacAddressHash> peers_by_mac;
+
+    struct ForwardedBeacon {
+        u64 hash; ///< Hash of the beacon frame
+        std::chrono::steady_clock::time_point time;
+    };
+    /// The last beacon forwarded from each member that sends them
+    std::unordered_map<ENetPeer*, ForwardedBeacon> last_beacons;
 
     RoomImpl()
         : random_gen(std::random_device()()), NintendoOUI{0x00, 0x1F, 0x32, 0x00, 0x00, 0x00} {}
 
     /// Thread that receives and dispatches network packets
     std::unique_ptr<std::thread> room_thread;
+    /// Wakes room_thread when the room is destroyed. Only created along with room_thread, as rooms
+    /// serviced by a RoomServer don't need a socket for it.
+    std::unique_ptr<WakeupSignal> wakeup;
+
+    /// Traffic received since the statistics were last updated
+    u64 packets_received = 0;
+    u64 bytes_received = 0;
+    std::chrono::steady_clock::time_point statistics_start = std::chrono::steady_clock::now();
+
+    mutable std::mutex statistics_mutex;
+    RoomStatistics statistics; ///< Guarded by statistics_mutex
 
     /// Thread function that will receive and dispatch messages until the room is destroyed.
     void ServerLoop();
     void StartLoop();
 
+    /**
+     * Handles the network events of the room, waiting up to timeout_ms for the first one.
+     * @returns The number of events handled
+     */
+    size_t ServiceEvents(u32 timeout_ms);
+
+    /// Dispatches a single network event
+    void HandleEvent(ENetEvent& event);
+
+    /// Publishes the statistics once a second has passed since the last update
+    void UpdateStatistics();
+
     /**
      * Parses and answers a room join request from a client.
      * Validates the uniqueness of the username and assigns the MAC address
@@ -112,10 +180,16 @@ public:
     MacAddress GenerateMacAddress();
 
     /**
-     * Broadcasts this packet to all members except the sender.
+     * Forwards this packet as is to its destination, or to all members except the sender.
      * @param event The ENet event containing the data
+     * @returns Whether the packet was queued to any member, in which case ENet frees it once it
+     *     has been sent and the caller must not destroy it.
      */
-    void HandleWifiPacket(const ENetEvent* event);
+    bool HandleWifiPacket(const ENetEvent* event);
+
+    /// Returns whether a beacon received from the peer should be forwarded, throttling members
+    /// that send beacons too often and repeats of an unchanged beacon.
+    bool ShouldForwardBeacon(ENetPeer* peer, const u8* frame, size_t frame_size);
 
     /**
      * Extracts a chat entry from a received ENet packet and adds it to the chat queue.
@@ -139,37 +213,85 @@ public:
 // RoomImpl
 void Room::RoomImpl::ServerLoop() {
     while (state != State::Closed) {
-        ENetEvent event;
-        if (enet_host_service(server, &event, 100) > 0) {
-            switch (event.type) {
-            case ENET_EVENT_TYPE_RECEIVE:
-                switch (event.packet->data[0]) {
-                case IdJoinRequest:
-                    HandleJoinRequest(&event);
-                    break;
-                case IdSetGameName:
-                    HandleGameNamePacket(&event);
-                    break;
-                case IdWifiPacket:
-                    HandleWifiPacket(&event);
-                    break;
-                case IdChatMessage:
-                    HandleChatPacket(&event);
-                    break;
-                }
-                enet_packet_destroy(event.packet);
-                break;
-            case ENET_EVENT_TYPE_DISCONNECT:
-                HandleClientDisconnection(event.peer);
-                break;
-            }
-        }
+        wakeup->Wait(server->socket, ServiceIntervalMs);
+        ServiceEvents(0);
     }
     // Close the connection to all members:
     SendCloseMessage();
 }
 
+size_t Room::RoomImpl::ServiceEvents(u32 timeout_ms) {
+    size_t count = 0;
+    ENetEvent event;
+    if (enet_host_service(server, &event, timeout_ms) > 0) {
+        do {
+            HandleEvent(event);
+            ++count;
+        } while (enet_host_check_events(server, &event) > 0);
+        // Everything queued while handling the events goes out together, so that ENet can pack
+        // the messages for each member into as few datagrams as possible.
+        enet_host_flush(server);
+    }
+    UpdateStatistics();
+    return count;
+}
+
+void Room::RoomImpl::HandleEvent(ENetEvent& event) {
+    switch (event.type) {
+    case ENET_EVENT_TYPE_RECEIVE: {
+        ++packets_received;
+        bytes_received += event.packet->dataLength;
+
+        bool forwarded = false;
+        switch (event.packet->data[0]) {
+        case IdJoinRequest:
+            HandleJoinRequest(&event);
+            break;
+        case IdSetGameName:
+            HandleGameNamePacket(&event);
+            break;
+        case IdWifiPacket:
+            forwarded = HandleWifiPacket(&event);
+            break;
+        case IdChatMessage:
+            HandleChatPacket(&event);
+            break;
+        }
+        if (!forwarded) {
+            enet_packet_destroy(event.packet);
+        }
+        break;
+    }
+    case ENET_EVENT_TYPE_DISCONNECT:
+        HandleClientDisconnection(event.peer);
+        break;
+    }
+}
+
+void Room::RoomImpl::UpdateStatistics() {
+    const auto now = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(now - statistics_start).count();
+    if (seconds < 1.0)
+        return;
+
+    RoomStatistics new_statistics;
+    new_statistics.packets_per_second = packets_received / seconds;
+    new_statistics.bytes_per_second = bytes_received / seconds;
+    new_statistics.members.reserve(members.size());
+    for (const auto& member : members) {
+        new_statistics.members.push_back({member.nickname, member.peer->roundTripTime});
+    }
+
+    packets_received = 0;
+    bytes_received = 0;
+    statistics_start = now;
+
+    std::lock_guard<std::mutex> lock(statistics_mutex);
+    statistics = std::move(new_statistics);
+}
+
 void Room::RoomImpl::StartLoop() {
+    wakeup = std::make_unique<WakeupSignal>();
     room_thread = std::make_unique<std::thread>(&Room::RoomImpl::ServerLoop, this);
 }
 
@@ -213,6 +335,7 @@ void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
     member.nickname = nickname;
     member.peer = event->peer;
 
+    peers_by_mac[member.mac_address] = member.peer;
     members.push_back(std::move(member));
 
     // Notify everyone that the room information has changed.
@@ -229,8 +352,7 @@ bool Room::RoomImpl::IsValidNickname(const std::string& nickname) const {
 
 bool Room::RoomImpl::IsValidMacAddress(const MacAddress& address) const {
     // A MAC address is valid if it is not already taken by anybody else in the room.
-    return std::all_of(members.begin(), members.end(),
-                       [&address](const auto& member) { return member.mac_address != address; });
+    return peers_by_mac.count(address) == 0;
 }
 
 void Room::RoomImpl::SendNameCollision(ENetPeer* client) {
@@ -240,7 +362,6 @@ void Room::RoomImpl::SendNameCollision(ENetPeer* client) {
     ENetPacket* enet_packet =
         enet_packet_create(packet.GetData(), packet.GetDataSize(), ENET_PACKET_FLAG_RELIABLE);
     enet_peer_send(client, 0, enet_packet);
-    enet_host_flush(server);
 }
 
 void Room::RoomImpl::SendMacCollision(ENetPeer* client) {
@@ -250,7 +371,6 @@ void Room::RoomImpl::SendMacCollision(ENetPeer* client) {
     ENetPacket* enet_packet =
         enet_packet_create(packet.GetData(), packet.GetDataSize(), ENET_PACKET_FLAG_RELIABLE);
     enet_peer_send(client, 0, enet_packet);
-    enet_host_flush(server);
 }
 
 void Room::RoomImpl::SendVersionMismatch(ENetPeer* client) {
@@ -261,7 +381,6 @@ void Room::RoomImpl::SendVersionMismatch(ENetPeer* client) {
     ENetPacket* enet_packet =
         enet_packet_create(packet.GetData(), packet.GetDataSize(), ENET_PACKET_FLAG_RELIABLE);
     enet_peer_send(client, 0, enet_packet);
-    enet_host_flush(server);
 }
 
 void Room::RoomImpl::SendJoinSuccess(ENetPeer* client, MacAddress mac_address) {
@@ -271,7 +390,6 @@ void Room::RoomImpl::SendJoinSuccess(ENetPeer* client, MacAddress mac_address) {
     ENetPacket* enet_packet =
         enet_packet_create(packet.GetData(), packet.GetDataSize(), ENET_PACKET_FLAG_RELIABLE);
     enet_peer_send(client, 0, enet_packet);
-    enet_host_flush(server);
 }
 
 void Room::RoomImpl::SendCloseMessage() {
@@ -304,7 +422,6 @@ void Room::RoomImpl::BroadcastRoomInformation() {
     ENetPacket* enet_packet =
         enet_packet_create(packet.GetData(), packet.GetDataSize(), ENET_PACKET_FLAG_RELIABLE);
     enet_host_broadcast(server, 0, enet_packet);
-    enet_host_flush(server);
 }
 
 MacAddress Room::RoomImpl::GenerateMacAddress() {
@@ -319,36 +436,57 @@ MacAddress Room::RoomImpl::GenerateMacAddress() {
     return result_mac;
 }
 
-void Room::RoomImpl::HandleWifiPacket(const ENetEvent* event) {
-    Packet in_packet;
-    in_packet.Append(event->packet->data, event->packet->dataLength);
-    in_packet.IgnoreBytes(sizeof(u8));         // Message type
-    in_packet.IgnoreBytes(sizeof(u8));         // WifiPacket Type
-    in_packet.IgnoreBytes(sizeof(u8));         // WifiPacket Channel
-    in_packet.IgnoreBytes(sizeof(MacAddress)); // WifiPacket Transmitter Address
+bool Room::RoomImpl::HandleWifiPacket(const ENetEvent* event) {
+    ENetPacket* enet_packet = event->packet;
+    if (enet_packet->dataLength < WifiPacketDestinationOffset + sizeof(MacAddress)) {
+        return false; // Too short to hold the WifiPacket header
+    }
+
+    const auto type = static_cast<WifiPacket::PacketType>(enet_packet->data[WifiPacketTypeOffset]);
+    if (type == WifiPacket::PacketType::Beacon &&
+        !ShouldForwardBeacon(event->peer, enet_packet->data + WifiPacketDataOffset,
+                             enet_packet->dataLength - WifiPacketDataOffset)) {
+        return false;
+    }
+
+    // Only the destination address is needed, so read it in place rather than parsing the packet
     MacAddress destination_address;
-    in_packet >> destination_address;
+    std::memcpy(destination_address.data(), enet_packet->data + WifiPacketDestinationOffset,
+                destination_address.size());
 
-    Packet out_packet;
-    out_packet.Append(event->packet->data, event->packet->dataLength);
-    ENetPacket* enet_packet = enet_packet_create(out_packet.GetData(), out_packet.GetDataSize(),
-                                                 ENET_PACKET_FLAG_RELIABLE);
+    // The received packet is forwarded itself, ENet counts its references across the recipients
+    enet_packet->flags |= ENET_PACKET_FLAG_RELIABLE;
+    bool forwarded = false;
 
     if (destination_address == BroadcastMac) { // Send the data to everyone except the sender
         for (const auto& member : members) {
-            if (member.peer != event->peer)
-                enet_peer_send(member.peer, 0, enet_packet);
+            if (member.peer != event->peer) {
+                forwarded |= enet_peer_send(member.peer, 0, enet_packet) == 0;
+            }
         }
     } else { // Send the data only to the destination client
-        auto member = std::find_if(members.begin(), members.end(),
-                                   [destination_address](const Member& member) -> bool {
-                                       return member.mac_address == destination_address;
-                                   });
-        if (member != members.end()) {
-            enet_peer_send(member->peer, 0, enet_packet);
+        auto peer = peers_by_mac.find(destination_address);
+        if (peer != peers_by_mac.end()) {
+            forwarded = enet_peer_send(peer->second, 0, enet_packet) == 0;
         }
     }
-    enet_host_flush(server);
+    return forwarded;
+}
+
+bool Room::RoomImpl::ShouldForwardBeacon(ENetPeer* peer, const u8* frame, size_t frame_size) {
+    const u64 hash = Common::ComputeHash64(frame, frame_size);
+    const auto now = std::chrono::steady_clock::now();
+
+    auto last = last_beacons.find(peer);
+    if (last != last_beacons.end()) {
+        const auto elapsed = now - last->second.time;
+        if (elapsed < MinBeaconInterval ||
+            (hash == last->second.hash && elapsed < DuplicateBeaconInterval)) {
+            return false;
+        }
+    }
+    last_beacons[peer] = {hash, now};
+    return true;
 }
 
 void Room::RoomImpl::HandleChatPacket(const ENetEvent* event) {
@@ -377,7 +515,6 @@ void Room::RoomImpl::HandleChatPacket(const ENetEvent* event) {
         if (member.peer != event->peer)
             enet_peer_send(member.peer, 0, enet_packet);
     }
-    enet_host_flush(server);
 }
 
 void Room::RoomImpl::HandleGameNamePacket(const ENetEvent* event) {
@@ -398,9 +535,15 @@ void Room::RoomImpl::HandleGameNamePacket(const ENetEvent* event) {
 
 void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
     // Remove the client from the members list.
+    for (const auto& member : members) {
+        if (member.peer == client) {
+            peers_by_mac.erase(member.mac_address);
+        }
+    }
     members.erase(std::remove_if(members.begin(), members.end(),
                                  [client](const Member& member) { return member.peer == client; }),
                   members.end());
+    last_beacons.erase(client);
 
     // Announce the change to all clients.
     enet_peer_disconnect(client, 0);
@@ -412,7 +555,8 @@ Room::Room() : room_impl{std::make_unique<RoomImpl>()} {}
 
 Room::~Room() = default;
 
-void Room::Create(const std::string& name, const std::string& server_address, u16 server_port) {
+void Room::Create(const std::string& name, const std::string& server_address, u16 server_port,
+                  bool use_own_thread) {
     ENetAddress address;
     address.host = ENET_HOST_ANY;
     if (!server_address.empty()) {
@@ -421,12 +565,19 @@ void Room::Create(const std::string& name, const std::string& server_address, u1
     address.port = server_port;
 
     room_impl->server = enet_host_create(&address, MaxConcurrentConnections, NumChannels, 0, 0);
+    if (!room_impl->server) {
+        LOG_ERROR(Network, "Could not create the room's network host on port %u", server_port);
+        return;
+    }
     // TODO(B3N30): Allow specifying the maximum number of concurrent connections.
     room_impl->state = State::Open;
 
     room_impl->room_information.name = name;
     room_impl->room_information.member_slots = MaxConcurrentConnections;
-    room_impl->StartLoop();
+    room_impl->statistics_start = std::chrono::steady_clock::now();
+    if (use_own_thread) {
+        room_impl->StartLoop();
+    }
 }
 
 Room::State Room::GetState() const {
@@ -437,10 +588,21 @@ const RoomInformation& Room::GetRoomInformation() const {
     return room_impl->room_information;
 }
 
+RoomStatistics Room::GetStatistics() const {
+    std::lock_guard<std::mutex> lock(room_impl->statistics_mutex);
+    return room_impl->statistics;
+}
+
 void Room::Destroy() {
     room_impl->state = State::Closed;
-    room_impl->room_thread->join();
-    room_impl->room_thread.reset();
+    if (room_impl->room_thread) {
+        room_impl->wakeup->Signal();
+        room_impl->room_thread->join();
+        room_impl->room_thread.reset();
+        room_impl->wakeup.reset();
+    } else if (room_impl->server) {
+        room_impl->SendCloseMessage();
+    }
 
     if (room_impl->server) {
         enet_host_destroy(room_impl->server);
@@ -448,8 +610,30 @@ void Room::Destroy() {
     room_impl->room_information = {};
     room_impl->server = nullptr;
     room_impl->members.clear();
+    room_impl->peers_by_mac.clear();
+    room_impl->last_beacons.clear();
     room_impl->room_information.member_slots = 0;
     room_impl->room_information.name.clear();
+
+    std::lock_guard<std::mutex> lock(room_impl->statistics_mutex);
+    room_impl->statistics = {};
+}
+
+size_t Room::Service() {
+    if (!room_impl->server)
+        return 0;
+    return room_impl->ServiceEvents(0);
+}
+
+void Room::WaitForTraffic(const std::vector<Room*>& rooms, u32 timeout_ms) {
+    thread_local std::vector<ENetSocket> sockets;
+    sockets.clear();
+    for (const Room* room : rooms) {
+        if (room->room_impl->server) {
+            sockets.push_back(room->room_impl->server->socket);
+        }
+    }
+    WaitForReadable(sockets.data(), sockets.size(), timeout_ms);
 }
 
 } // namespace Network
@@ -7,6 +7,7 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <vector>
 #include "common/common_types.h"
 
 namespace Network {
@@ -21,6 +22,18 @@ struct RoomInformation {
     u32 member_slots; ///< Maximum number of members in this room
 };
 
+/// Traffic of a room, measured over the last second it was serviced
+struct RoomStatistics {
+    struct MemberStatistics {
+        std::string nickname;   ///< Nickname of the member
+        u32 round_trip_time_ms; ///< Mean round trip time of the connection to the member
+    };
+
+    double packets_per_second = 0; ///< Packets received from the members
+    double bytes_per_second = 0;   ///< Bytes received from the members
+    std::vector<MemberStatistics> members;
+};
+
 using MacAddress = std::array<u8, 6>;
 /// A special MAC address that tells the room we're joining to assign us a MAC address
 /// automatically.
@@ -64,18 +77,37 @@ public:
      */
     const RoomInformation& GetRoomInformation() const;
 
+    /**
+     * Gets the traffic statistics of the room. Can be called from any thread.
+     */
+    RoomStatistics GetStatistics() const;
+
     /**
      * Creates the socket for this room. Will bind to default address if
      * server is empty string.
+     * @param use_own_thread Whether the room handles its traffic on a thread of its own. If not,
+     *     Service has to be called to handle it, as RoomServer does.
      */
     void Create(const std::string& name, const std::string& server = "",
-                u16 server_port = DefaultRoomPort);
+                u16 server_port = DefaultRoomPort, bool use_own_thread = true);
 
     /**
      * Destroys the socket
      */
     void Destroy();
 
+    /**
+     * Handles the pending network events of a room created without a thread of its own.
+     * @returns The number of events handled
+     */
+    size_t Service();
+
+    /**
+     * Waits until any of the rooms has network traffic to handle, or the timeout expires. Takes
+     * any number of rooms.
+     */
+    static void WaitForTraffic(const std::vector<Room*>& rooms, u32 timeout_ms);
+
 private:
     class RoomImpl;
     std::unique_ptr<RoomImpl> room_impl;
@@ -3,17 +3,20 @@
 // Refer to the license.txt file included.
 
 #include <atomic>
-#include <list>
 #include <mutex>
 #include <thread>
 #include "common/assert.h"
 #include "enet/enet.h"
 #include "network/packet.h"
 #include "network/room_member.h"
+#include "network/wakeup_signal.h"
 
 namespace Network {
 
 constexpr u32 ConnectionTimeoutMs = 5000;
+/// Longest time the loop waits without servicing the connection, which ENet needs for its pings
+/// and retransmissions. Received and queued packets wake it sooner.
+constexpr u32 ServiceIntervalMs = 100;
 
 class RoomMember::RoomMemberImpl {
 public:
@@ -35,14 +38,24 @@ public:
     std::mutex network_mutex; ///< Mutex that controls access to the `client` variable.
     /// Thread that receives and dispatches network packets
     std::unique_ptr<std::thread> loop_thread;
-    std::mutex send_list_mutex;  ///< Mutex that controls access to the `send_list` variable.
-    std::list<Packet> send_list; ///< A list that stores all packets to send the async
+    /// Packets waiting to be sent, newest first. A lock-free stack linked through the userData of
+    /// the packets: any thread pushes to it, and the loop thread takes all of them at once.
+    std::atomic<ENetPacket*> send_queue{nullptr};
+    /// Wakes the loop thread when a packet is queued or the connection should be closed
+    WakeupSignal wakeup;
     void MemberLoop();
 
+    /// Dispatches a single network event
+    void HandleEvent(const ENetEvent& event);
+
+    /// Sends all queued packets to the room, flushing them together
+    void FlushSendQueue();
+
     void StartLoop();
 
     /**
      * Sends data to the room. It will be send on channel 0 with flag RELIABLE
+     * The packet is queued without waiting on the network thread.
      * @param packet The data to send
      */
     void Send(Packet&& packet);
@@ -100,69 +113,102 @@ void RoomMember::RoomMemberImpl::MemberLoop() {
     // Receive packets while the connection is open
     while (IsConnected()) {
         std::lock_guard<std::mutex> lock(network_mutex);
+        wakeup.Wait(client->socket, ServiceIntervalMs);
+        FlushSendQueue();
+
         ENetEvent event;
-        if (enet_host_service(client, &event, 100) > 0) {
-            switch (event.type) {
-            case ENET_EVENT_TYPE_RECEIVE:
-                switch (event.packet->data[0]) {
-                case IdWifiPacket:
-                    HandleWifiPackets(&event);
-                    break;
-                case IdChatMessage:
-                    HandleChatPacket(&event);
-                    break;
-                case IdRoomInformation:
-                    HandleRoomInformationPacket(&event);
-                    break;
-                case IdJoinSuccess:
-                    // The join request was successful, we are now in the room.
-                    // If we joined successfully, there must be at least one client in the room: us.
-                    ASSERT_MSG(member_information.size() > 0,
-                               "We have not yet received member information.");
-                    HandleJoinPacket(&event); // Get the MAC Address for the client
-                    SetState(State::Joined);
-                    break;
-                case IdNameCollision:
-                    SetState(State::NameCollision);
-                    break;
-                case IdMacCollision:
-                    SetState(State::MacCollision);
-                    break;
-                case IdVersionMismatch:
-                    SetState(State::WrongVersion);
-                    break;
-                case IdCloseRoom:
-                    SetState(State::LostConnection);
-                    break;
-                }
-                enet_packet_destroy(event.packet);
-                break;
-            case ENET_EVENT_TYPE_DISCONNECT:
-                SetState(State::LostConnection);
-                break;
-            }
-        }
-        {
-            std::lock_guard<std::mutex> lock(send_list_mutex);
-            for (const auto& packet : send_list) {
-                ENetPacket* enetPacket = enet_packet_create(packet.GetData(), packet.GetDataSize(),
-                                                            ENET_PACKET_FLAG_RELIABLE);
-                enet_peer_send(server, 0, enetPacket);
-            }
-            enet_host_flush(client);
-            send_list.clear();
+        if (enet_host_service(client, &event, 0) > 0) {
+            do {
+                HandleEvent(event);
+            } while (IsConnected() && enet_host_check_events(client, &event) > 0);
         }
     }
     Disconnect();
 };
 
+void RoomMember::RoomMemberImpl::HandleEvent(const ENetEvent& event) {
+    switch (event.type) {
+    case ENET_EVENT_TYPE_RECEIVE:
+        switch (event.packet->data[0]) {
+        case IdWifiPacket:
+            HandleWifiPackets(&event);
+            break;
+        case IdChatMessage:
+            HandleChatPacket(&event);
+            break;
+        case IdRoomInformation:
+            HandleRoomInformationPacket(&event);
+            break;
+        case IdJoinSuccess:
+            // The join request was successful, we are now in the room.
+            // If we joined successfully, there must be at least one client in the room: us.
+            ASSERT_MSG(member_information.size() > 0,
+                       "We have not yet received member information.");
+            HandleJoinPacket(&event); // Get the MAC Address for the client
+            SetState(State::Joined);
+            break;
+        case IdNameCollision:
+            SetState(State::NameCollision);
+            break;
+        case IdMacCollision:
+            SetState(State::MacCollision);
+            break;
+        case IdVersionMismatch:
+            SetState(State::WrongVersion);
+            break;
+        case IdCloseRoom:
+            SetState(State::LostConnection);
+            break;
+        }
+        enet_packet_destroy(event.packet);
+        break;
+    case ENET_EVENT_TYPE_DISCONNECT:
+        SetState(State::LostConnection);
+        break;
+    }
+}
+
+void RoomMember::RoomMemberImpl::FlushSendQueue() {
+    ENetPacket* packet = send_queue.exchange(nullptr, std::memory_order_acquire);
+    if (!packet)
+        return;
+
+    // Reverse the stack, so the packets are sent in the order they were queued
+    ENetPacket* oldest = nullptr;
+    while (packet) {
+        ENetPacket* next = static_cast<ENetPacket*>(packet->userData);
+        packet->userData = oldest;
+        oldest = packet;
+        packet = next;
+    }
+
+    for (packet = oldest; packet;) {
+        ENetPacket* next = static_cast<ENetPacket*>(packet->userData);
+        packet->userData = nullptr;
+        // Without a connection the packet is dropped, as ENet only owns it once it's sent
+        if (!server || enet_peer_send(server, 0, packet) != 0) {
+            enet_packet_destroy(packet);
+        }
+        packet = next;
+    }
+    enet_host_flush(client);
+}
+
 void RoomMember::RoomMemberImpl::StartLoop() {
     loop_thread = std::make_unique<std::thread>(&RoomMember::RoomMemberImpl::MemberLoop, this);
 }
 
 void RoomMember::RoomMemberImpl::Send(Packet&& packet) {
-    std::lock_guard<std::mutex> lock(send_list_mutex);
-    send_list.push_back(std::move(packet));
+    // Serialized here, so the loop thread only has to hand the packet to ENet
+    ENetPacket* enet_packet =
+        enet_packet_create(packet.GetData(), packet.GetDataSize(), ENET_PACKET_FLAG_RELIABLE);
+
+    ENetPacket* head = send_queue.load(std::memory_order_relaxed);
+    do {
+        enet_packet->userData = head;
+    } while (!send_queue.compare_exchange_weak(head, enet_packet, std::memory_order_release,
+                                               std::memory_order_relaxed));
+    wakeup.Signal();
 }
 
 void RoomMember::RoomMemberImpl::SendJoinRequest(const std::string& nickname,
@@ -252,6 +298,9 @@ void RoomMember::RoomMemberImpl::HandleChatPacket(const ENetEvent* event) {
 }
 
 void RoomMember::RoomMemberImpl::Disconnect() {
+    // Send what was queued before leaving, the rest is dropped by the next flush
+    FlushSendQueue();
+
     member_information.clear();
     room_information.member_slots = 0;
     room_information.name.clear();
@@ -284,6 +333,7 @@ RoomMember::RoomMember() : room_member_impl{std::make_unique<RoomMemberImpl>()}
 
 RoomMember::~RoomMember() {
     ASSERT_MSG(!IsConnected(), "RoomMember is being destroyed while connected");
+    room_member_impl->FlushSendQueue(); // Frees packets queued after the last disconnect
     enet_host_destroy(room_member_impl->client);
 }
 
@@ -313,6 +363,7 @@ void RoomMember::Join(const std::string& nick, const char* server_addr, u16 serv
     // If the member is connected, kill the connection first
     if (room_member_impl->loop_thread && room_member_impl->loop_thread->joinable()) {
         room_member_impl->SetState(State::Error);
+        room_member_impl->wakeup.Signal();
         room_member_impl->loop_thread->join();
         room_member_impl->loop_thread.reset();
     }
@@ -375,6 +426,7 @@ void RoomMember::SendGameName(const std::string& game_name) {
 
 void RoomMember::Leave() {
     room_member_impl->SetState(State::Idle);
+    room_member_impl->wakeup.Signal();
     room_member_impl->loop_thread->join();
     room_member_impl->loop_thread.reset();
 }
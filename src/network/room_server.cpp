@@ -0,0 +1,136 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "common/logging/log.h"
+#include "common/thread.h"
+#include "network/room_server.h"
+
+namespace Network {
+
+/// Longest a worker waits for traffic before servicing its rooms anyway, for ENet's timers
+static constexpr u32 WorkerWaitTimeoutMs = 100;
+
+struct RoomServer::Worker {
+    /// Guards `rooms`
+    mutable std::mutex rooms_mutex;
+    std::vector<std::shared_ptr<Room>> rooms;
+    std::atomic<size_t> num_rooms{0};
+
+    /// Held while the worker services its rooms, so that a room isn't destroyed meanwhile
+    std::mutex service_mutex;
+
+    std::atomic<bool> stop{false};
+    std::thread thread;
+
+    Worker() : thread(&Worker::Loop, this) {}
+
+    ~Worker() {
+        stop = true;
+        thread.join();
+    }
+
+    void Loop() {
+        Common::SetCurrentThreadName("RoomServerWorker");
+
+        std::vector<std::shared_ptr<Room>> serviced_rooms;
+        std::vector<Room*> waiting_rooms;
+        while (!stop) {
+            {
+                std::lock_guard<std::mutex> lock(rooms_mutex);
+                serviced_rooms = rooms;
+            }
+            if (serviced_rooms.empty()) {
+                // Nothing to service, check back for new rooms later
+                std::this_thread::sleep_for(std::chrono::milliseconds(WorkerWaitTimeoutMs));
+                continue;
+            }
+
+            waiting_rooms.clear();
+            for (const auto& room : serviced_rooms) {
+                waiting_rooms.push_back(room.get());
+            }
+
+            // Rooms destroyed since the copy have no socket anymore and are skipped
+            std::lock_guard<std::mutex> lock(service_mutex);
+            Room::WaitForTraffic(waiting_rooms, WorkerWaitTimeoutMs);
+            for (Room* room : waiting_rooms) {
+                room->Service();
+            }
+        }
+    }
+};
+
+RoomServer::RoomServer(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+}
+
+RoomServer::~RoomServer() {
+    for (const auto& room : GetRooms()) {
+        DestroyRoom(room);
+    }
+}
+
+std::shared_ptr<Room> RoomServer::CreateRoom(const std::string& name,
+                                             const std::string& server_address,
+                                             u16 server_port) {
+    auto room = std::make_shared<Room>();
+    room->Create(name, server_address, server_port, false);
+    if (room->GetState() != Room::State::Open) {
+        LOG_ERROR(Network, "Could not create room %s on port %u", name.c_str(), server_port);
+        return nullptr;
+    }
+
+    Worker& worker = **std::min_element(
+        workers.begin(), workers.end(),
+        [](const auto& a, const auto& b) { return a->num_rooms < b->num_rooms; });
+
+    std::lock_guard<std::mutex> lock(worker.rooms_mutex);
+    worker.rooms.push_back(room);
+    ++worker.num_rooms;
+    return room;
+}
+
+void RoomServer::DestroyRoom(const std::shared_ptr<Room>& room) {
+    for (const auto& worker : workers) {
+        {
+            std::lock_guard<std::mutex> lock(worker->rooms_mutex);
+            auto it = std::find(worker->rooms.begin(), worker->rooms.end(), room);
+            if (it == worker->rooms.end())
+                continue;
+            worker->rooms.erase(it);
+            --worker->num_rooms;
+        }
+
+        // Wait for the worker to finish servicing the room
+        std::lock_guard<std::mutex> lock(worker->service_mutex);
+        room->Destroy();
+        return;
+    }
+}
+
+std::vector<std::shared_ptr<Room>> RoomServer::GetRooms() const {
+    std::vector<std::shared_ptr<Room>> result;
+    for (const auto& worker : workers) {
+        std::lock_guard<std::mutex> lock(worker->rooms_mutex);
+        result.insert(result.end(), worker->rooms.begin(), worker->rooms.end());
+    }
+    return result;
+}
+
+size_t RoomServer::NumThreads() const {
+    return workers.size();
+}
+
+} // namespace Network
@@ -0,0 +1,49 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "network/room.h"
+
+namespace Network {
+
+/**
+ * Hosts many rooms in one process. Instead of a thread per room, the rooms are spread across a
+ * fixed set of worker threads, each handling the traffic of its rooms in turn.
+ * ENet must have been initialized, see Network::Init.
+ */
+class RoomServer final : NonCopyable {
+public:
+    /// @param num_threads Number of worker threads, 0 to use one per host CPU core
+    explicit RoomServer(size_t num_threads = 0);
+    ~RoomServer();
+
+    /**
+     * Creates a room listening on the given address and port, and hands it to the worker thread
+     * with the fewest rooms.
+     * @returns The room, or nullptr if its socket couldn't be created
+     */
+    std::shared_ptr<Room> CreateRoom(const std::string& name, const std::string& server_address,
+                                     u16 server_port);
+
+    /// Closes a room created by this server, notifying its members.
+    void DestroyRoom(const std::shared_ptr<Room>& room);
+
+    /// Returns all the rooms currently hosted.
+    std::vector<std::shared_ptr<Room>> GetRooms() const;
+
+    /// Returns the number of worker threads.
+    size_t NumThreads() const;
+
+private:
+    struct Worker;
+    std::vector<std::unique_ptr<Worker>> workers;
+};
+
+} // namespace Network
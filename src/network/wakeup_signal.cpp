@@ -0,0 +1,95 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "common/logging/log.h"
+#include "network/wakeup_signal.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+
+namespace Network {
+
+void WaitForReadable(const ENetSocket* sockets, size_t num_sockets, u32 timeout_ms) {
+    if (num_sockets == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+        return;
+    }
+
+    // Kept from one wait to the next, as the network threads wait all the time
+    thread_local std::vector<pollfd> fds;
+    fds.resize(num_sockets);
+    for (size_t i = 0; i < num_sockets; ++i) {
+        fds[i].fd = sockets[i];
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+    }
+#ifdef _WIN32
+    WSAPoll(fds.data(), static_cast<ULONG>(num_sockets), static_cast<INT>(timeout_ms));
+#else
+    poll(fds.data(), static_cast<nfds_t>(num_sockets), static_cast<int>(timeout_ms));
+#endif
+}
+
+WakeupSignal::WakeupSignal() {
+    wakeup_socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+    if (wakeup_socket == ENET_SOCKET_NULL) {
+        LOG_ERROR(Network, "Could not create the wakeup socket, falling back to polling");
+        return;
+    }
+
+    enet_address_set_host(&wakeup_address, "127.0.0.1");
+    wakeup_address.port = 0; // Any free port
+    if (enet_socket_bind(wakeup_socket, &wakeup_address) != 0 ||
+        enet_socket_get_address(wakeup_socket, &wakeup_address) != 0) {
+        LOG_ERROR(Network, "Could not bind the wakeup socket, falling back to polling");
+        enet_socket_destroy(wakeup_socket);
+        wakeup_socket = ENET_SOCKET_NULL;
+        return;
+    }
+    enet_socket_set_option(wakeup_socket, ENET_SOCKOPT_NONBLOCK, 1);
+}
+
+WakeupSignal::~WakeupSignal() {
+    if (wakeup_socket != ENET_SOCKET_NULL) {
+        enet_socket_destroy(wakeup_socket);
+    }
+}
+
+void WakeupSignal::Signal() {
+    if (wakeup_socket == ENET_SOCKET_NULL || pending.exchange(true, std::memory_order_acq_rel))
+        return;
+
+    u8 byte = 0;
+    ENetBuffer buffer;
+    buffer.data = &byte;
+    buffer.dataLength = sizeof(byte);
+    enet_socket_send(wakeup_socket, &wakeup_address, &buffer, 1);
+}
+
+void WakeupSignal::Wait(ENetSocket socket, u32 timeout_ms) {
+    const ENetSocket sockets[] = {socket, wakeup_socket};
+    WaitForReadable(sockets, wakeup_socket != ENET_SOCKET_NULL ? 2 : 1, timeout_ms);
+
+    if (wakeup_socket == ENET_SOCKET_NULL)
+        return;
+
+    // Clear the flag before draining: a signal racing with this either has its datagram drained
+    // here, in which case the caller handles its work now, or sends a new one for the next Wait.
+    pending.store(false, std::memory_order_release);
+    u8 byte;
+    ENetBuffer buffer;
+    buffer.data = &byte;
+    buffer.dataLength = sizeof(byte);
+    ENetAddress sender;
+    while (enet_socket_receive(wakeup_socket, &sender, &buffer, 1) > 0) {
+    }
+}
+
+} // namespace Network
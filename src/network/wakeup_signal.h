@@ -0,0 +1,47 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "enet/enet.h"
+
+namespace Network {
+
+/**
+ * Waits until any of the sockets has data to read, or the timeout expires. Unlike ENet's socket
+ * sets, which are select's fd_set, this works with any number of sockets and any socket value.
+ */
+void WaitForReadable(const ENetSocket* sockets, size_t num_sockets, u32 timeout_ms);
+
+/**
+ * Lets other threads wake a network thread that is waiting for traffic on an ENet host. The signal
+ * is a datagram sent to a loopback socket, so that it can be waited on together with the socket of
+ * the host, with the socket API ENet provides on every platform.
+ */
+class WakeupSignal final : NonCopyable {
+public:
+    WakeupSignal();
+    ~WakeupSignal();
+
+    /// Wakes the thread in Wait, or makes its next Wait return immediately. May be called from
+    /// any thread.
+    void Signal();
+
+    /**
+     * Waits until the socket has data to read, Signal is called or the timeout passes, and then
+     * clears the signal. Must only be called from one thread.
+     */
+    void Wait(ENetSocket socket, u32 timeout_ms);
+
+private:
+    ENetSocket wakeup_socket = ENET_SOCKET_NULL;
+    ENetAddress wakeup_address{};
+    /// Whether a datagram was sent since the last Wait, so that repeated signals send only one
+    std::atomic<bool> pending{false};
+};
+
+} // namespace Network
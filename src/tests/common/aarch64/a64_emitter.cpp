@@ -0,0 +1,100 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifdef ARCHITECTURE_ARM64
+
+#include <cstring>
+#include <vector>
+#include <catch.hpp>
+#include "common/aarch64/a64_emitter.h"
+
+namespace Common {
+namespace A64 {
+
+/// Returns the instructions emitted so far
+static std::vector<u32> Emitted(const CodeGenerator& code) {
+    std::vector<u32> words(code.GetSize() / sizeof(u32));
+    std::memcpy(words.data(), code.GetCode(), code.GetSize());
+    return words;
+}
+
+// The expected encodings are the output of an independent assembler for the instructions in the
+// comments.
+
+TEST_CASE("A64 CodeGenerator: encodes moves and integer arithmetic", "[common][aarch64]") {
+    CodeGenerator code(4096);
+    code.MOV(XReg(0), XReg(1));              // mov x0, x1
+    code.MOV(XReg(0), SP);                   // mov x0, sp
+    code.ADD(XReg(1), XReg(2), 16);          // add x1, x2, #16
+    code.ADD(WReg(3), WReg(4), 0x1000);      // add w3, w4, #1, lsl #12
+    code.SUB(SP, SP, 32);                    // sub sp, sp, #32
+    code.MOVZ(XReg(0), 0x1234, 16);          // movz x0, #0x1234, lsl #16
+    code.MOVK(XReg(0), 0xBEEF, 48);          // movk x0, #0xbeef, lsl #48
+    code.ANDLowBits(WReg(0), WReg(1), 8);    // and w0, w1, #0xff
+    code.UBFX(WReg(0), WReg(1), 4, 8);       // ubfx w0, w1, #4, #8
+    code.LSL(WReg(0), WReg(1), 3);           // lsl w0, w1, #3
+    code.LSR(WReg(0), WReg(1), 3);           // lsr w0, w1, #3
+    code.SBFIZ(XReg(0), XReg(1), 4, 32);     // sbfiz x0, x1, #4, #32
+
+    REQUIRE(Emitted(code) == std::vector<u32>{0xAA0103E0, 0x910003E0, 0x91004041, 0x11400483,
+                                              0xD10083FF, 0xD2A24680, 0xF2F7DDE0, 0x12001C20,
+                                              0x53042C20, 0x531D7020, 0x53037C20, 0x937C7C20});
+}
+
+TEST_CASE("A64 CodeGenerator: encodes loads, stores and returns", "[common][aarch64]") {
+    CodeGenerator code(4096);
+    code.LDR(WReg(0), XReg(1), 8);           // ldr w0, [x1, #8]
+    code.LDRQ(VReg(0), XReg(0), 32);         // ldr q0, [x0, #32]
+    code.STRQ(VReg(3), XReg(19), 48);        // str q3, [x19, #48]
+    code.STPPre(XReg(29), LR, SP, -16);      // stp x29, x30, [sp, #-16]!
+    code.LDPPost(XReg(29), LR, SP, 16);      // ldp x29, x30, [sp], #16
+    code.BLR(IP0);                           // blr x16
+    code.RET();                              // ret
+
+    REQUIRE(Emitted(code) == std::vector<u32>{0xB9400820, 0x3DC00800, 0x3D800E63, 0xA9BF7BFD,
+                                              0xA8C17BFD, 0xD63F0200, 0xD65F03C0});
+}
+
+TEST_CASE("A64 CodeGenerator: encodes SIMD&FP instructions", "[common][aarch64]") {
+    CodeGenerator code(4096);
+    code.FADD(VReg(0), VReg(1), VReg(2));    // fadd v0.4s, v1.4s, v2.4s
+    code.FADDP(VReg(0), VReg(1), VReg(2));   // faddp v0.4s, v1.4s, v2.4s
+    code.FMUL(VReg(0), VReg(1), VReg(2));    // fmul v0.4s, v1.4s, v2.4s
+    code.FCMGE(VReg(3), VReg(4), VReg(5));   // fcmge v3.4s, v4.4s, v5.4s
+    code.FRINTM(VReg(0), VReg(1));           // frintm v0.4s, v1.4s
+    code.FMOV(VReg(0), 1.0f);                // fmov v0.4s, #1.0
+    code.FMOV(VReg(7), -0.5f);               // fmov v7.4s, #-0.5
+    code.DUP(VReg(1), VReg(2), 3);           // dup v1.4s, v2.s[3]
+    code.INS(VReg(1), 2, VReg(2), 1);        // mov v1.s[2], v2.s[1]
+    code.INS(VReg(1), 1, WReg(3));           // mov v1.s[1], w3
+    code.UMOV(WReg(0), VReg(1), 3);          // mov w0, v1.s[3]
+    code.FDIV_S(VReg(0), VReg(1), VReg(2));  // fdiv s0, s1, s2
+    code.FSQRT_S(VReg(0), VReg(1));          // fsqrt s0, s1
+
+    REQUIRE(Emitted(code) == std::vector<u32>{0x4E22D420, 0x6E22D420, 0x6E22DC20, 0x6E25E483,
+                                              0x4E219820, 0x4F03F600, 0x4F07F407, 0x4E1C0441,
+                                              0x6E142441, 0x4E0C1C61, 0x0E1C3C20, 0x1E221820,
+                                              0x1E21C020});
+}
+
+TEST_CASE("A64 CodeGenerator: resolves labels bound before and after use", "[common][aarch64]") {
+    CodeGenerator code(4096);
+    Label label;
+    code.B(label);                           // b 1f
+    code.CBZ(WReg(3), label);                // cbz w3, 1f
+    code.ADR(XReg(0), label);                // adr x0, 1f
+    code.L(label);                           // 1:
+    code.B(Cond::NE, label);                 // b.ne 1b
+    code.BL(label);                          // bl 1b
+    code.CBNZ(XReg(5), label);               // cbnz x5, 1b
+
+    REQUIRE(code.GetAddress(label) == code.GetCode() + 12);
+    REQUIRE(Emitted(code) == std::vector<u32>{0x14000003, 0x34000043, 0x10000020, 0x54000001,
+                                              0x97FFFFFF, 0xB5FFFFC5});
+}
+
+} // namespace A64
+} // namespace Common
+
+#endif // ARCHITECTURE_ARM64
@@ -0,0 +1,104 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// Compares the hash functions of common/hash.h on the key sizes the emulator hashes: vertex
+// layouts, shader configurations, memory pages and whole shader programs.
+//
+// Usage: bench_hash [-i <iterations>]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "common/common_types.h"
+#include "common/hash.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct KeySize {
+    const char* name;
+    size_t size;
+};
+
+constexpr KeySize KEY_SIZES[] = {
+    {"vertex layout", 16},
+    {"shader config", 128},
+    {"memory page", 4096},
+    // Program code and swizzle data are both 4096 words
+    {"shader program", 16384},
+};
+
+/// Keeps the results alive so that the hashing isn't optimized out
+u64 sink;
+
+double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void PrintResult(const char* name, size_t size, size_t iterations, double seconds) {
+    const double ns = seconds * 1e9 / iterations;
+    std::printf("    %-12s %10.1f ns/op %8.2f GB/s\n", name, ns, size / ns);
+}
+
+void BenchmarkSize(const std::vector<u8>& data, size_t size, size_t iterations) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        u64 hash[2];
+        Common::MurmurHash3_128(data.data(), size, 0, hash);
+        sink += hash[0];
+    }
+    PrintResult("MurmurHash3", size, iterations, SecondsSince(start));
+
+    start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        sink += Common::XXHash64(data.data(), size);
+    }
+    PrintResult("XXHash64", size, iterations, SecondsSince(start));
+
+    start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        sink += Common::ComputeCRC32C(data.data(), size);
+    }
+    PrintResult("CRC32C", size, iterations, SecondsSince(start));
+}
+
+void PrintUsage(const char* argv0) {
+    std::fprintf(stderr, "Usage: %s [-i <iterations>]\n", argv0);
+}
+
+} // Anonymous namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = 100000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            iterations = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (iterations == 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<u8> data(16384);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<u8>(i * 131 + 7);
+    }
+
+    std::printf("%zu iterations\n", iterations);
+    for (const KeySize& key : KEY_SIZES) {
+        std::printf("  %s (%zu bytes)\n", key.name, key.size);
+        BenchmarkSize(data, key.size, iterations);
+    }
+
+    // Printed so that the compiler has to compute the hashes
+    std::printf("checksum %016llx\n", static_cast<unsigned long long>(sink));
+    return 0;
+}
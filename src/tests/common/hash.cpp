@@ -0,0 +1,46 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch.hpp>
+#include "common/hash.h"
+
+namespace Common {
+
+TEST_CASE("XXHash64: matches the reference implementation", "[common]") {
+    REQUIRE(XXHash64("", 0) == 0xEF46DB3751D8E999);
+    REQUIRE(XXHash64("a", 1) == 0xD24EC4F1A98C6E5B);
+    REQUIRE(XXHash64("abc", 3) == 0x44BC2CF5AD770999);
+}
+
+TEST_CASE("HashState64: hashes pieces like one block", "[common]") {
+    std::vector<u8> data(300);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<u8>(i * 7 + 3);
+    }
+
+    for (size_t first : {0, 1, 31, 32, 33, 100}) {
+        for (size_t second : {0, 7, 64, 150}) {
+            HashState64 state(42);
+            state.Update(data.data(), first);
+            state.Update(data.data() + first, second);
+            state.Update(data.data() + first + second, data.size() - first - second);
+            REQUIRE(state.Digest() == XXHash64(data.data(), data.size(), 42));
+        }
+    }
+
+    REQUIRE(HashState64().Digest() == XXHash64(nullptr, 0));
+}
+
+TEST_CASE("ComputeCRC32C: matches the check value and can be continued", "[common]") {
+    const char* check = "123456789";
+    REQUIRE(ComputeCRC32C(check, 9) == 0xE3069283);
+    REQUIRE(ComputeCRC32C(check + 4, 5, ComputeCRC32C(check, 4)) == 0xE3069283);
+
+    std::vector<u8> data(100, 0x5A);
+    REQUIRE(ComputeCRC32C(data.data() + 13, 87, ComputeCRC32C(data.data(), 13)) ==
+            ComputeCRC32C(data.data(), data.size()));
+}
+
+} // namespace Common
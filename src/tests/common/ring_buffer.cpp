@@ -0,0 +1,123 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "common/ring_buffer.h"
+
+namespace Common {
+
+TEST_CASE("RingBuffer: Basic Tests", "[common]") {
+    RingBuffer<char, 1, 4> buf;
+
+    // Pushing values into a ring buffer with space should succeed.
+    for (size_t i = 0; i < 4; i++) {
+        const char elem = static_cast<char>(i);
+        const size_t count = buf.Push(&elem, 1);
+        REQUIRE(count == 1);
+    }
+
+    REQUIRE(buf.Size() == 4);
+
+    // Pushing values into a full ring buffer should fail.
+    {
+        const char elem = static_cast<char>(42);
+        const size_t count = buf.Push(&elem, 1);
+        REQUIRE(count == 0);
+    }
+
+    REQUIRE(buf.Size() == 4);
+
+    // Popping multiple values from a ring buffer with values should succeed.
+    {
+        const std::vector<char> popped = buf.Pop(2);
+        REQUIRE(popped.size() == 2);
+        REQUIRE(popped[0] == 0);
+        REQUIRE(popped[1] == 1);
+    }
+
+    REQUIRE(buf.Size() == 2);
+
+    // Popping a single value from a ring buffer with values should succeed.
+    {
+        const std::vector<char> popped = buf.Pop(1);
+        REQUIRE(popped.size() == 1);
+        REQUIRE(popped[0] == 2);
+    }
+
+    REQUIRE(buf.Size() == 1);
+
+    // Pushing more values than space available should partially succeed.
+    {
+        std::vector<char> to_push(6);
+        std::iota(to_push.begin(), to_push.end(), 88);
+        const size_t count = buf.Push(to_push);
+        REQUIRE(count == 3);
+    }
+
+    REQUIRE(buf.Size() == 4);
+
+    // Doing an unlimited pop should pop all values, across the end of the storage.
+    {
+        const std::vector<char> popped = buf.Pop();
+        REQUIRE(popped.size() == 4);
+        REQUIRE(popped[0] == 3);
+        REQUIRE(popped[1] == 88);
+        REQUIRE(popped[2] == 89);
+        REQUIRE(popped[3] == 90);
+    }
+
+    REQUIRE(buf.Size() == 0);
+}
+
+TEST_CASE("RingBuffer: Threaded Test", "[common]") {
+    // Kept on the heap, as the test threads share it
+    auto buf = std::make_unique<RingBuffer<char, 2, 1024>>();
+    const char seed = 42;
+    const size_t count = 1000000;
+
+    // Catch's assertions are not thread-safe, so the threads only record mismatches
+    bool producer_ok = true;
+    bool consumer_ok = true;
+
+    std::thread producer{[&] {
+        std::array<char, 2> value = {seed, seed};
+        size_t i = 0;
+        while (i < count) {
+            if (const size_t c = buf->Push(value.data(), 1)) {
+                producer_ok &= c == 1;
+                value[0]++;
+                value[1] -= 3;
+                i++;
+            }
+        }
+    }};
+
+    std::thread consumer{[&] {
+        std::array<char, 2> value = {seed, seed};
+        size_t i = 0;
+        while (i < count) {
+            std::array<char, 2> popped;
+            if (const size_t c = buf->Pop(popped.data(), 1)) {
+                consumer_ok &= c == 1 && popped == value;
+                value[0]++;
+                value[1] -= 3;
+                i++;
+            }
+        }
+    }};
+
+    producer.join();
+    consumer.join();
+
+    REQUIRE(producer_ok);
+    REQUIRE(consumer_ok);
+    REQUIRE(buf->Size() == 0);
+}
+
+} // namespace Common
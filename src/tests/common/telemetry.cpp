@@ -0,0 +1,62 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/telemetry.h"
+
+namespace Telemetry {
+
+/// Records the fields it visits as "name=value"
+struct RecordingVisitor : public NullVisitor {
+    void Visit(const Field<u32>& field) override {
+        visited.push_back(field.GetName() + "=" + std::to_string(field.GetValue()));
+    }
+    void Visit(const Field<std::string>& field) override {
+        visited.push_back(field.GetName() + "=" + field.GetValue());
+    }
+
+    std::vector<std::string> visited;
+};
+
+TEST_CASE("FieldCollection: Fields are updated in place", "[common]") {
+    FieldCollection fields;
+    fields.AddField(FieldType::Performance, "Frames", 1u);
+    fields.AddField(FieldType::Session, "Title", std::string("a"));
+    for (u32 i = 2; i <= 10; ++i)
+        fields.AddField(FieldType::Performance, "Frames", i);
+
+    // The same name from another address refers to the same field
+    const std::string title_name = "Title";
+    fields.AddField(FieldType::Session, title_name.c_str(), std::string("b"));
+
+    RecordingVisitor visitor;
+    fields.Accept(visitor);
+    REQUIRE(visitor.visited == std::vector<std::string>{"Frames=10", "Title=b"});
+}
+
+TEST_CASE("FieldCollection: Fields can change type", "[common]") {
+    FieldCollection fields;
+    fields.AddField(FieldType::Session, "Value", 5u);
+    fields.AddField(FieldType::Session, "Value", std::string("five"));
+
+    RecordingVisitor visitor;
+    fields.Accept(visitor);
+    REQUIRE(visitor.visited == std::vector<std::string>{"Value=five"});
+}
+
+TEST_CASE("FieldCollection: Names from many addresses refer to the same field", "[common]") {
+    FieldCollection fields;
+    fields.AddField(FieldType::Performance, "Frames", 0u);
+    const std::vector<std::string> names(100, "Frames");
+    for (u32 i = 0; i < names.size(); ++i)
+        fields.AddField(FieldType::Performance, names[i].c_str(), i + 1);
+
+    RecordingVisitor visitor;
+    fields.Accept(visitor);
+    REQUIRE(visitor.visited == std::vector<std::string>{"Frames=100"});
+}
+
+} // namespace Telemetry
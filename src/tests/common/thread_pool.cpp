@@ -0,0 +1,77 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+TEST_CASE("ThreadPool: ParallelFor covers every element once", "[common]") {
+    for (size_t num_workers : {0, 1, 3}) {
+        ThreadPool pool(num_workers);
+        std::vector<std::atomic<int>> visits(1000);
+        for (auto& visit : visits) {
+            visit = 0;
+        }
+
+        pool.ParallelFor(visits.size(), 7, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                ++visits[i];
+            }
+        });
+
+        for (const auto& visit : visits) {
+            REQUIRE(visit == 1);
+        }
+    }
+}
+
+TEST_CASE("ThreadPool: loops run concurrently and nested", "[common]") {
+    ThreadPool pool(2);
+    std::atomic<size_t> total{0};
+
+    auto RunLoop = [&] {
+        pool.ParallelFor(64, 1, [&](size_t begin, size_t end) {
+            // Loops started from workers must not wait on the busy workers
+            pool.ParallelFor(16, 4, [&](size_t inner_begin, size_t inner_end) {
+                total += inner_end - inner_begin;
+            });
+        });
+    };
+
+    std::thread other(RunLoop);
+    RunLoop();
+    other.join();
+
+    REQUIRE(total == 2 * 64 * 16);
+}
+
+TEST_CASE("ThreadPool: submitted tasks all run", "[common]") {
+    std::atomic<int> done{0};
+    Event all_done;
+    {
+        ThreadPool pool(3);
+        for (int i = 0; i < 100; ++i) {
+            pool.Submit([&] {
+                // Tasks submitted by tasks go to the worker's own queue, others steal them
+                pool.Submit([&] {
+                    if (++done == 200) {
+                        all_done.Set();
+                    }
+                });
+                if (++done == 200) {
+                    all_done.Set();
+                }
+            });
+        }
+        all_done.Wait();
+    }
+    REQUIRE(done == 200);
+}
+
+} // namespace Common
@@ -0,0 +1,238 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// Measures the speed of the CPU backends on small guest workloads, in millions of guest
+// instructions per second once translated, and the cost of translating a block of code.
+//
+// Usage: bench_cpu [-c dyncom|dynarmic] [-s <scale>]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "core/arm/arm_interface.h"
+#include "core/arm/dynarmic/arm_dynarmic.h"
+#include "core/arm/dyncom/arm_dyncom.h"
+#include "core/arm/skyeye_common/armstate.h"
+#include "core/core_timing.h"
+#include "core/memory.h"
+#include "core/memory_setup.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// User mode CPSR, in ARM state with no flags set
+constexpr u32 USER_CPSR = 0x10;
+
+/// Guest memory of the benchmark: code, followed by the source and destination of the data
+constexpr VAddr MEMORY_BASE = 0x00100000;
+constexpr u32 MEMORY_SIZE = 0x40000;
+constexpr VAddr CODE_BASE = MEMORY_BASE;
+constexpr VAddr SOURCE_BASE = MEMORY_BASE + 0x20000;
+constexpr VAddr DEST_BASE = MEMORY_BASE + 0x30000;
+
+/// Instructions the CPU is run for at a time, before checking whether the workload has finished
+constexpr int SLICE_INSTRUCTIONS = 10000;
+
+/// Blocks of the translation benchmark, each of an add and a branch to the next one
+constexpr u32 NUM_TRANSLATED_BLOCKS = 8192;
+
+/**
+ * A loop run for a number of iterations given in r0, which ends up in an infinite loop at
+ * end_index. r10 points to 4 KiB of data, r11 to 4 KiB of space to write to, s4-s6 hold 0.5.
+ */
+struct Workload {
+    const char* name;
+    std::vector<u32> code;
+    size_t end_index;
+    u64 instructions_per_iteration;
+    u32 iterations;
+};
+
+// clang-format off
+const std::vector<Workload> workloads = {
+    {"integer loop", {
+        0xE0811002, // loop: add r1, r1, r2
+        0xE0222081, //       eor r2, r2, r1, lsl #1
+        0xE2500001, //       subs r0, r0, #1
+        0x1AFFFFFB, //       bne loop
+        0xEAFFFFFE, // end:  b end
+    }, 4, 4, 10000000},
+    {"memcpy 4 KiB", {
+        0xE1A0100A, // outer: mov r1, r10
+        0xE1A0200B, //        mov r2, r11
+        0xE3A03080, //        mov r3, #128
+        0xE8B153F0, // inner: ldmia r1!, {r4-r9, r12, lr}
+        0xE8A253F0, //        stmia r2!, {r4-r9, r12, lr}
+        0xE2533001, //        subs r3, r3, #1
+        0x1AFFFFFB, //        bne inner
+        0xE2500001, //        subs r0, r0, #1
+        0x1AFFFFF6, //        bne outer
+        0xEAFFFFFE, // end:   b end
+    }, 9, 3 + 128 * 4 + 2, 20000},
+    {"vfp multiply-add", {
+        0xE1A0100A, // outer: mov r1, r10
+        0xE3A03C01, //        mov r3, #256
+        0xECB10A04, // inner: vldmia r1!, {s0-s3}
+        0xEE004A02, //        vmla.f32 s8, s0, s4
+        0xEE404AA2, //        vmla.f32 s9, s1, s5
+        0xEE215A03, //        vmul.f32 s10, s2, s6
+        0xEE755A85, //        vadd.f32 s11, s11, s10
+        0xE2533001, //        subs r3, r3, #1
+        0x1AFFFFF8, //        bne inner
+        0xE2500001, //        subs r0, r0, #1
+        0x1AFFFFF4, //        bne outer
+        0xEAFFFFFE, // end:   b end
+    }, 11, 2 + 256 * 7 + 2, 5000},
+    {"branches and calls", {
+        0xE3100001, // loop: tst r0, #1
+        0x0A000001, //       beq even
+        0xE2811001, //       add r1, r1, #1
+        0xEA000001, //       b join
+        0xE2411001, // even: sub r1, r1, #1
+        0xE1A00000, //       mov r0, r0
+        0xEB000002, // join: bl func
+        0xE2500001, //       subs r0, r0, #1
+        0x1AFFFFF6, //       bne loop
+        0xEAFFFFFE, // end:  b end
+        0xE0822000, // func: add r2, r2, r0
+        0xE12FFF1E, //       bx lr
+    }, 9, 9, 5000000},
+};
+// clang-format on
+
+std::unique_ptr<ARM_Interface> CreateCPU(const char* name) {
+    if (std::strcmp(name, "dyncom") == 0)
+        return std::make_unique<ARM_DynCom>(USER32MODE);
+    if (std::strcmp(name, "dynarmic") == 0)
+        return std::make_unique<ARM_Dynarmic>(USER32MODE);
+    return nullptr;
+}
+
+double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void LoadCode(ARM_Interface& cpu, const std::vector<u32>& code) {
+    for (size_t i = 0; i < code.size(); ++i)
+        Memory::Write32(CODE_BASE + static_cast<VAddr>(i * 4), code[i]);
+    cpu.ClearInstructionCache();
+}
+
+/// Runs the code at CODE_BASE until it reaches the given address, returning the time it took
+double RunUntil(ARM_Interface& cpu, VAddr end_address) {
+    cpu.SetCPSR(USER_CPSR);
+    cpu.SetPC(CODE_BASE);
+
+    const auto start = Clock::now();
+    while (cpu.GetPC() != end_address)
+        cpu.Run(SLICE_INSTRUCTIONS);
+    return SecondsSince(start);
+}
+
+double RunWorkload(ARM_Interface& cpu, const Workload& workload, u32 iterations) {
+    float half = 0.5f;
+    u32 half_bits;
+    std::memcpy(&half_bits, &half, sizeof(half_bits));
+
+    for (int i = 0; i < 16; ++i)
+        cpu.SetReg(i, 0);
+    cpu.SetReg(0, iterations);
+    cpu.SetReg(10, SOURCE_BASE);
+    cpu.SetReg(11, DEST_BASE);
+    for (int i = 0; i < 16; ++i)
+        cpu.SetVFPReg(i, i >= 4 && i <= 6 ? half_bits : 0);
+    cpu.SetVFPSystemReg(VFP_FPSCR, 0);
+
+    return RunUntil(cpu, CODE_BASE + static_cast<VAddr>(workload.end_index * 4));
+}
+
+void BenchmarkWorkload(ARM_Interface& cpu, const Workload& workload, u32 scale) {
+    LoadCode(cpu, workload.code);
+
+    // Translate the code before measuring
+    RunWorkload(cpu, workload, 1);
+
+    const u32 iterations = workload.iterations * scale;
+    const double seconds = RunWorkload(cpu, workload, iterations);
+    const double instructions =
+        static_cast<double>(workload.instructions_per_iteration) * iterations;
+    std::printf("  %-24s %10.1f MIPS\n", workload.name, instructions / seconds / 1e6);
+}
+
+void BenchmarkTranslation(ARM_Interface& cpu) {
+    std::vector<u32> code;
+    for (u32 i = 0; i < NUM_TRANSLATED_BLOCKS; ++i) {
+        code.push_back(0xE2811001); // add r1, r1, #1
+        code.push_back(0xEAFFFFFF); // b next
+    }
+    code.push_back(0xEAFFFFFE); // end: b end
+    LoadCode(cpu, code);
+
+    // The first run translates every block, the second one only runs them
+    const VAddr end_address = CODE_BASE + NUM_TRANSLATED_BLOCKS * 8;
+    const double cold_seconds = RunUntil(cpu, end_address);
+    const double warm_seconds = RunUntil(cpu, end_address);
+    std::printf("  %-24s %10.2f us/block\n", "block translation",
+                (cold_seconds - warm_seconds) * 1e6 / NUM_TRANSLATED_BLOCKS);
+}
+
+void PrintUsage(const char* argv0) {
+    std::fprintf(stderr, "Usage: %s [-c dyncom|dynarmic] [-s <scale>]\n", argv0);
+}
+
+} // Anonymous namespace
+
+int main(int argc, char** argv) {
+    Log::Filter log_filter(Log::Level::Warning);
+    Log::SetFilter(&log_filter);
+
+    std::vector<const char*> cpu_names{"dyncom", "dynarmic"};
+    u32 scale = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cpu_names = {argv[++i]};
+        } else if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            scale = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (scale == 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<u8> memory(MEMORY_SIZE);
+    Memory::MapMemoryRegion(MEMORY_BASE, MEMORY_SIZE, memory.data());
+    const float quarter = 0.25f;
+    for (VAddr offset = 0; offset < 0x1000; offset += sizeof(quarter))
+        std::memcpy(&memory[SOURCE_BASE - MEMORY_BASE + offset], &quarter, sizeof(quarter));
+
+    CoreTiming::Init();
+
+    for (const char* cpu_name : cpu_names) {
+        std::unique_ptr<ARM_Interface> cpu = CreateCPU(cpu_name);
+        if (cpu == nullptr) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+
+        std::printf("%s\n", cpu_name);
+        for (const Workload& workload : workloads)
+            BenchmarkWorkload(*cpu, workload, scale);
+        BenchmarkTranslation(*cpu);
+    }
+
+    CoreTiming::Shutdown();
+    Memory::UnmapRegion(MEMORY_BASE, MEMORY_SIZE);
+    return 0;
+}
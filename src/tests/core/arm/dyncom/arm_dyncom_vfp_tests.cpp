@@ -2,9 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <random>
+#include <vector>
 #include <catch.hpp>
 
 #include "core/arm/dyncom/arm_dyncom.h"
+#include "core/arm/skyeye_common/vfp/vfp_helper.h"
+#include "core/core_timing.h"
 #include "tests/core/arm/arm_test_common.h"
 
 namespace ArmTests {
@@ -23,13 +28,13 @@ TEST_CASE("ARM_DynCom (vfp): vadd", "[arm_dyncom]") {
     test_env.SetMemory32(4, 0xEAFFFFFE); // b +#0
 
     ARM_DynCom dyncom(USER32MODE);
+    CoreTiming::Init(); // No events are scheduled, so reaching the end of a slice does nothing
 
     std::vector<VfpTestCase> test_cases{{
 #include "vfp_vadd_f32.inc"
     }};
 
     for (const auto& test_case : test_cases) {
-        dyncom.down_count = 1000; // Ensure that CoreTimeing will not be called.
         dyncom.SetPC(0);
         dyncom.SetVFPSystemReg(VFP_FPSCR, test_case.initial_fpscr);
         dyncom.SetVFPReg(4, test_case.a);
@@ -47,4 +52,164 @@ TEST_CASE("ARM_DynCom (vfp): vadd", "[arm_dyncom]") {
     }
 }
 
-} // namespace ArmTests
\ No newline at end of file
+namespace {
+
+struct VfpOperation {
+    const char* name;
+    u32 instruction;
+    bool is_double;
+};
+
+// Operands in s4/d2 and s6/d3, result in s2/d1
+constexpr std::array<VfpOperation, 10> host_operations{{
+    {"vadd.f32", 0xEE321A03, false},
+    {"vsub.f32", 0xEE321A43, false},
+    {"vmul.f32", 0xEE221A03, false},
+    {"vnmul.f32", 0xEE221A43, false},
+    {"vdiv.f32", 0xEE821A03, false},
+    {"vadd.f64", 0xEE321B03, true},
+    {"vsub.f64", 0xEE321B43, true},
+    {"vmul.f64", 0xEE221B03, true},
+    {"vnmul.f64", 0xEE221B43, true},
+    {"vdiv.f64", 0xEE821B03, true},
+}};
+
+struct VfpResult {
+    u64 value;
+    u32 fpscr;
+
+    bool operator==(const VfpResult& other) const {
+        return value == other.value && fpscr == other.fpscr;
+    }
+};
+
+/// Runs host operations, with the host FPU fast path turned on or off
+class HostArithmeticTester {
+public:
+    HostArithmeticTester() : dyncom(USER32MODE) {
+        // Each operation gets its own address, as the translated code is cached by address
+        for (size_t i = 0; i < host_operations.size(); ++i) {
+            test_env.SetMemory32(static_cast<VAddr>(8 * i), host_operations[i].instruction);
+            test_env.SetMemory32(static_cast<VAddr>(8 * i + 4), 0xEAFFFFFE); // b +#0
+        }
+        CoreTiming::Init();
+    }
+
+    ~HostArithmeticTester() {
+        vfp_host_arithmetic_enabled = true;
+    }
+
+    VfpResult Run(size_t operation, bool host_arithmetic, u32 fpscr, u64 a, u64 b) {
+        vfp_host_arithmetic_enabled = host_arithmetic;
+        dyncom.SetPC(static_cast<u32>(8 * operation));
+        dyncom.SetVFPSystemReg(VFP_FPSCR, fpscr);
+        SetOperand(4, a);
+        SetOperand(6, b);
+        dyncom.ExecuteInstructions(1);
+
+        VfpResult result;
+        result.value = dyncom.GetVFPReg(2);
+        if (host_operations[operation].is_double)
+            result.value |= static_cast<u64>(dyncom.GetVFPReg(3)) << 32;
+        result.fpscr = dyncom.GetVFPSystemReg(VFP_FPSCR);
+        return result;
+    }
+
+    /// Checks that the fast path gives the same result and flags as the emulation
+    void Compare(size_t operation, u32 fpscr, u64 a, u64 b) {
+        const VfpResult emulated = Run(operation, false, fpscr, a, b);
+        const VfpResult host = Run(operation, true, fpscr, a, b);
+        INFO(host_operations[operation].name << " fpscr " << std::hex << fpscr << " a " << a
+                                              << " b " << b);
+        REQUIRE(host.value == emulated.value);
+        REQUIRE(host.fpscr == emulated.fpscr);
+    }
+
+private:
+    void SetOperand(int reg, u64 value) {
+        dyncom.SetVFPReg(reg, static_cast<u32>(value));
+        dyncom.SetVFPReg(reg + 1, static_cast<u32>(value >> 32));
+    }
+
+    TestEnvironment test_env{false};
+    ARM_DynCom dyncom;
+};
+
+constexpr u32 FPSCR_FZ = 1 << 24;
+constexpr u32 FPSCR_DN = 1 << 25;
+
+} // Anonymous namespace
+
+TEST_CASE("ARM_DynCom (vfp): host arithmetic matches the emulation on special values",
+          "[arm_dyncom]") {
+    HostArithmeticTester tester;
+
+    const std::vector<u64> singles{
+        0x00000000, 0x80000000, // zeroes
+        0x3F800000, 0xBFC00000, 0x3F800001, 0x40490FDB, // normal numbers
+        0x7F7FFFFF, 0xFF7FFFFF, // largest normal numbers
+        0x00800000, 0x80800001, 0x00FFFFFF, // smallest normal numbers
+        0x00000001, 0x007FFFFF, 0x80400000, // denormals
+        0x7F800000, 0xFF800000, // infinities
+        0x7FC00000, 0xFFC00001, 0x7F800001, // quiet and signaling NaNs
+        0x1F800000, 0x5F800000, // 2^-64 and 2^64, which underflow and overflow when multiplied
+    };
+    const std::vector<u64> doubles{
+        0x0000000000000000, 0x8000000000000000, // zeroes
+        0x3FF0000000000000, 0xBFF8000000000000, 0x3FF0000000000001, 0x3CA0000000000000,
+        0x7FEFFFFFFFFFFFFF, 0x0010000000000000, 0x8010000000000001, // extreme normal numbers
+        0x0000000000000001, 0x800FFFFFFFFFFFFF, // denormals
+        0x7FF0000000000000, 0xFFF0000000000000, // infinities
+        0x7FF8000000000000, 0x7FF0000000000001, // quiet and signaling NaNs
+        0x5DF0000000000000, 0x5E00000000000000, // 2^480, the largest operand of the fast path
+        0x21F0000000000000, 0x21E0000000000000, // 2^-480, the smallest operand of the fast path
+    };
+
+    for (u32 rmode = 0; rmode < 4; ++rmode) {
+        for (u32 mode_bits : {0u, FPSCR_FZ, FPSCR_DN, FPSCR_FZ | FPSCR_DN}) {
+            const u32 fpscr = rmode << 22 | mode_bits;
+            for (size_t operation = 0; operation < host_operations.size(); ++operation) {
+                const auto& values = host_operations[operation].is_double ? doubles : singles;
+                for (u64 a : values) {
+                    for (u64 b : values)
+                        tester.Compare(operation, fpscr, a, b);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("ARM_DynCom (vfp): host arithmetic matches the emulation on random numbers",
+          "[arm_dyncom]") {
+    HostArithmeticTester tester;
+    std::mt19937_64 rng(0x132);
+
+    // Normal numbers of any magnitude, where the fast path applies unless the result is out of
+    // its range
+    auto random_single = [&rng] {
+        const u64 bits = rng();
+        const u64 exponent = 1 + bits % 254;
+        return (bits & 0x80000000) | exponent << 23 | (bits >> 32 & 0x7FFFFF);
+    };
+    auto random_double = [&rng] {
+        const u64 bits = rng();
+        // Half of them within the range of operands of the fast path
+        const u64 exponent = bits % 2 == 0 ? 1 + rng() % 2046 : 1023 - 480 + rng() % 961;
+        return (bits & 0x8000000000000000) | exponent << 52 | (bits & 0xFFFFFFFFFFFFF);
+    };
+
+    for (int i = 0; i < 20000; ++i) {
+        for (size_t operation = 0; operation < host_operations.size(); ++operation) {
+            const bool is_double = host_operations[operation].is_double;
+            const u64 a = is_double ? random_double() : random_single();
+            u64 b = is_double ? random_double() : random_single();
+            // Operands close to each other, whose differences cancel out
+            if (i % 4 == 0)
+                b = a ^ (rng() & 0xFF);
+            // The fast path only applies in the default mode, flushing to zero or not
+            tester.Compare(operation, i % 2 == 0 ? 0 : FPSCR_FZ, a, b);
+        }
+    }
+}
+
+} // namespace ArmTests
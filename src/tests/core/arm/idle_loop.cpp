@@ -0,0 +1,77 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch.hpp>
+
+#include "core/arm/idle_loop.h"
+#include "tests/core/arm/arm_test_common.h"
+
+namespace ArmTests {
+
+/// User mode CPSR, in ARM state with no flags set
+constexpr u32 USER_CPSR = 0x10;
+
+TEST_CASE("IdleLoop: ARM polling loop", "[arm]") {
+    TestEnvironment test_env(false);
+    test_env.SetMemory32(0, 0xE5910000); // ldr r0, [r1]
+    test_env.SetMemory32(4, 0xE3500000); // cmp r0, #0
+    test_env.SetMemory32(8, 0x0AFFFFFC); // beq #0
+    test_env.SetMemory32(0x1000, 0);
+
+    REQUIRE(IdleLoop::IsIdleLoop(0, false));
+    REQUIRE(!IdleLoop::IsIdleLoop(4, false));
+
+    std::array<u32, 16> regs{};
+    regs[1] = 0x1000;
+    regs[15] = 4;
+    REQUIRE(IdleLoop::IsSpinning(regs, USER_CPSR));
+
+    // The flag has been set, so the loop exits once the load is run again
+    test_env.SetMemory32(0x1000, 1);
+    REQUIRE(!IdleLoop::IsSpinning(regs, USER_CPSR));
+}
+
+TEST_CASE("IdleLoop: Thumb polling loop", "[arm]") {
+    TestEnvironment test_env(false);
+    test_env.SetMemory16(0x100, 0x6808); // ldr r0, [r1, #0]
+    test_env.SetMemory16(0x102, 0x2800); // cmp r0, #0
+    test_env.SetMemory16(0x104, 0xD0FC); // beq #0x100
+    test_env.SetMemory32(0x1000, 0);
+
+    REQUIRE(IdleLoop::IsIdleLoop(0x100, true));
+
+    std::array<u32, 16> regs{};
+    regs[1] = 0x1000;
+    regs[15] = 0x100;
+    REQUIRE(IdleLoop::IsSpinning(regs, USER_CPSR | (1 << 5)));
+}
+
+TEST_CASE("IdleLoop: loops that make progress", "[arm]") {
+    TestEnvironment test_env(false);
+
+    // Chasing a pointer reads a different address every iteration
+    test_env.SetMemory32(0, 0xE5900000); // ldr r0, [r0]
+    test_env.SetMemory32(4, 0xE3500000); // cmp r0, #0
+    test_env.SetMemory32(8, 0x1AFFFFFC); // bne #0
+    REQUIRE(!IdleLoop::IsIdleLoop(0, false));
+
+    // Counting down changes a register every iteration
+    test_env.SetMemory32(0x10, 0xE2511001); // subs r1, r1, #1
+    test_env.SetMemory32(0x14, 0x1AFFFFFD); // bne #0x10
+    REQUIRE(!IdleLoop::IsIdleLoop(0x10, false));
+}
+
+TEST_CASE("IdleLoop: skipping ahead to the next event", "[arm]") {
+    // The slice ended early for a reschedule, as after an SVC signaling an event, so the thread
+    // that runs next may release the loop
+    REQUIRE(!IdleLoop::CanSkipToNextEvent(1000, 100, true));
+
+    // Time is left in the slice and nothing else is about to run
+    REQUIRE(IdleLoop::CanSkipToNextEvent(1000, 100, false));
+
+    // The slice ran out, so its events run first
+    REQUIRE(!IdleLoop::CanSkipToNextEvent(100, 100, false));
+}
+
+} // namespace ArmTests
@@ -0,0 +1,144 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// Measures the cost of scheduling, cancelling and firing CoreTiming events with a given number of
+// events already pending, as with many threads sleeping on timeouts.
+//
+// Usage: bench_core_timing [-n <pending events>] [-i <iterations>]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "common/common_types.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "core/core_timing.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Period of the self-rescheduling events fired by the last benchmark, in cycles
+constexpr s64 PERIODIC_EVENT_CYCLES = 4000;
+/// Cycles the CPU is pretended to run between calls to CoreTiming
+constexpr u64 TICKS_PER_STEP = 500;
+
+int idle_event_type;
+int periodic_event_type;
+u64 events_fired;
+
+double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void IdleCallback(u64 userdata, int cycles_late) {
+    ++events_fired;
+}
+
+void PeriodicCallback(u64 userdata, int cycles_late) {
+    ++events_fired;
+    CoreTiming::ScheduleEvent(PERIODIC_EVENT_CYCLES - cycles_late, periodic_event_type, userdata);
+}
+
+/// Schedules events far enough in the future that they stay pending during the benchmark
+void SchedulePendingEvents(size_t num_pending) {
+    for (size_t i = 0; i < num_pending; ++i) {
+        const s64 cycles = msToCycles(10000) + static_cast<s64>(i * 7919 % num_pending) * 100;
+        CoreTiming::ScheduleEvent(cycles, idle_event_type, i);
+    }
+}
+
+void PrintResult(const char* name, size_t iterations, double seconds) {
+    std::printf("  %-28s %10.1f ns/op\n", name, seconds * 1e9 / iterations);
+}
+
+void BenchmarkCancelByHandle(size_t iterations) {
+    const auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        const auto handle = CoreTiming::ScheduleEvent(static_cast<s64>(i % 1000) * 1000,
+                                                      idle_event_type, ~static_cast<u64>(0));
+        CoreTiming::UnscheduleEvent(handle);
+    }
+    PrintResult("schedule + cancel by handle", iterations, SecondsSince(start));
+}
+
+void BenchmarkCancelByType(size_t iterations) {
+    const auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        CoreTiming::ScheduleEvent(static_cast<s64>(i % 1000) * 1000, idle_event_type,
+                                  ~static_cast<u64>(0));
+        CoreTiming::UnscheduleEvent(idle_event_type, ~static_cast<u64>(0));
+    }
+    PrintResult("schedule + cancel by type", iterations, SecondsSince(start));
+}
+
+void BenchmarkThreadsafe(size_t iterations) {
+    const auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        CoreTiming::ScheduleEvent_Threadsafe(msToCycles(2000), idle_event_type,
+                                             ~static_cast<u64>(0));
+        CoreTiming::MoveEvents();
+    }
+    PrintResult("threadsafe schedule + move", iterations, SecondsSince(start));
+    CoreTiming::UnscheduleEvent(idle_event_type, ~static_cast<u64>(0));
+}
+
+void BenchmarkFiring(size_t iterations) {
+    constexpr u64 NUM_PERIODIC_EVENTS = 16;
+    for (u64 i = 0; i < NUM_PERIODIC_EVENTS; ++i) {
+        const s64 cycles = static_cast<s64>(i) * PERIODIC_EVENT_CYCLES / NUM_PERIODIC_EVENTS;
+        CoreTiming::ScheduleEvent(cycles, periodic_event_type, i);
+    }
+
+    events_fired = 0;
+    const auto start = Clock::now();
+    while (events_fired < iterations)
+        CoreTiming::AddTicks(TICKS_PER_STEP);
+    PrintResult("fire periodic event", static_cast<size_t>(events_fired), SecondsSince(start));
+    CoreTiming::RemoveEvent(periodic_event_type);
+}
+
+void PrintUsage(const char* argv0) {
+    std::fprintf(stderr, "Usage: %s [-n <pending events>] [-i <iterations>]\n", argv0);
+}
+
+} // Anonymous namespace
+
+int main(int argc, char** argv) {
+    Log::Filter log_filter(Log::Level::Warning);
+    Log::SetFilter(&log_filter);
+
+    size_t num_pending = 256;
+    size_t iterations = 1000000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            num_pending = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            iterations = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (iterations == 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    CoreTiming::Init();
+    idle_event_type = CoreTiming::RegisterEvent("Idle", IdleCallback);
+    periodic_event_type = CoreTiming::RegisterEvent("Periodic", PeriodicCallback);
+    SchedulePendingEvents(num_pending);
+
+    std::printf("%zu pending events, %zu iterations\n", num_pending, iterations);
+    BenchmarkCancelByHandle(iterations);
+    BenchmarkCancelByType(iterations);
+    BenchmarkThreadsafe(iterations);
+    BenchmarkFiring(iterations);
+
+    CoreTiming::Shutdown();
+    return 0;
+}
@@ -0,0 +1,360 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// Measures the memory block operations, on plain pages and on pages the rasterizer caches, reads
+// of mapped I/O registers, and the bookkeeping of cached surfaces: marking their pages cached,
+// and indexing them for the lookups that flushes do, both with the interval map and with the
+// page index. There is no renderer, so flushes of cached pages cost nothing but the checks
+// leading up to them.
+//
+// Surfaces and lookups are generated from a fixed seed, and each measurement is the fastest of a
+// few repetitions, so results are comparable between runs.
+//
+// Usage: bench_memory [-n <surfaces>] [-r <repetitions>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+#include <boost/icl/interval_map.hpp>
+#include "common/common_types.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "core/hle/kernel/process.h"
+#include "core/memory.h"
+#include "core/memory_setup.h"
+#include "core/mmio.h"
+#include "video_core/renderer_opengl/gl_rasterizer_cache.h"
+#include "video_core/renderer_opengl/gl_surface_index.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Start of the linear heap that is mapped for the block operations, and its physical address
+constexpr VAddr BLOCK_VADDR = Memory::LINEAR_HEAP_VADDR;
+constexpr PAddr BLOCK_PADDR = Memory::FCRAM_PADDR;
+constexpr u32 BLOCK_REGION_SIZE = 0x01000000;
+
+/// Bytes moved by each measurement of a block operation
+constexpr size_t BYTES_PER_MEASUREMENT = 64 * 1024 * 1024;
+
+/// Lookups done by each measurement of a surface index
+constexpr size_t LOOKUPS_PER_MEASUREMENT = 1000000;
+
+/// I/O regions mapped for the register reads, one page each, and the reads of each measurement
+constexpr VAddr MMIO_VADDR = 0x1EC00000;
+constexpr u32 NUM_MMIO_REGIONS = 32;
+constexpr size_t MMIO_READS_PER_MEASUREMENT = 10000000;
+
+constexpr u32 SEED = 0x3D5;
+
+using Surfaces = std::vector<std::shared_ptr<CachedSurface>>;
+
+struct Region {
+    PAddr addr;
+    u32 size;
+};
+
+size_t repetitions = 5;
+
+/// Runs the measured function a few times, returning the shortest time it took in seconds
+template <typename Function>
+double Measure(Function&& function) {
+    double best = 0.0;
+    for (size_t i = 0; i < repetitions; ++i) {
+        const auto start = Clock::now();
+        function();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (i == 0 || seconds < best)
+            best = seconds;
+    }
+    return best;
+}
+
+/// Device whose registers read back their address, standing in for the hardware registers
+class RegisterDevice final : public Memory::MMIORegion {
+public:
+    bool IsValidAddress(VAddr addr) override {
+        return true;
+    }
+
+    u8 Read8(VAddr addr) override {
+        return static_cast<u8>(addr);
+    }
+    u16 Read16(VAddr addr) override {
+        return static_cast<u16>(addr);
+    }
+    u32 Read32(VAddr addr) override {
+        return addr;
+    }
+    u64 Read64(VAddr addr) override {
+        return addr;
+    }
+
+    bool ReadBlock(VAddr src_addr, void* dest_buffer, size_t size) override {
+        std::memset(dest_buffer, 0, size);
+        return true;
+    }
+
+    void Write8(VAddr addr, u8 data) override {}
+    void Write16(VAddr addr, u16 data) override {}
+    void Write32(VAddr addr, u32 data) override {}
+    void Write64(VAddr addr, u64 data) override {}
+
+    bool WriteBlock(VAddr dest_addr, const void* src_buffer, size_t size) override {
+        return true;
+    }
+};
+
+void PrintTime(const char* name, size_t operations, double seconds) {
+    std::printf("  %-36s %10.1f ns/op\n", name, seconds * 1e9 / operations);
+}
+
+void PrintThroughput(const char* name, size_t bytes, double seconds) {
+    std::printf("  %-36s %10.2f GB/s\n", name, bytes / seconds / 1e9);
+}
+
+/// Surfaces of the sizes of textures and framebuffers, scattered over FCRAM
+Surfaces GenerateSurfaces(size_t count) {
+    std::mt19937 rng(SEED);
+    const u32 bpp_choices[] = {4, 8, 16, 24, 32};
+
+    Surfaces surfaces;
+    for (size_t i = 0; i < count; ++i) {
+        u32 width, height, bpp;
+        if (rng() % 10 == 0) {
+            // Framebuffer of one of the screens
+            width = 240;
+            height = 400;
+            bpp = 32;
+        } else {
+            width = 8u << (rng() % 6);
+            height = 8u << (rng() % 6);
+            bpp = bpp_choices[rng() % 5];
+        }
+
+        auto surface = std::make_shared<CachedSurface>();
+        surface->width = width;
+        surface->height = height;
+        surface->size = width * height * bpp / 8;
+        surface->addr = Memory::FCRAM_PADDR +
+                        (rng() % ((Memory::FCRAM_SIZE - surface->size) / 0x80)) * 0x80;
+        surfaces.push_back(std::move(surface));
+    }
+    return surfaces;
+}
+
+/// Regions flushed by single CPU accesses, by block operations of a page, and by display
+/// transfers, in FCRAM
+std::vector<Region> GenerateLookups(size_t count) {
+    std::mt19937 rng(SEED + 1);
+
+    std::vector<Region> lookups;
+    for (size_t i = 0; i < count; ++i) {
+        const u32 kind = rng() % 10;
+        const u32 size = kind < 5 ? 4 : kind < 9 ? 0x1000 : 240 * 400 * 4;
+        const PAddr addr = Memory::FCRAM_PADDR + (rng() % (Memory::FCRAM_SIZE - size)) / 4 * 4;
+        lookups.push_back({addr, size});
+    }
+    return lookups;
+}
+
+void BenchmarkBlockOperations(const char* page_kind) {
+    for (size_t size : {size_t{256}, size_t{0x1000}, size_t{0x40000}}) {
+        const size_t count = BYTES_PER_MEASUREMENT / size;
+        const u32 half = BLOCK_REGION_SIZE / 2;
+        std::vector<u8> buffer(size);
+        char name[64];
+
+        const double read_seconds = Measure([&] {
+            for (size_t i = 0; i < count; ++i)
+                Memory::ReadBlock(BLOCK_VADDR + static_cast<VAddr>(i * size % half),
+                                  buffer.data(), size);
+        });
+        std::snprintf(name, sizeof(name), "ReadBlock %zu B, %s", size, page_kind);
+        PrintThroughput(name, count * size, read_seconds);
+
+        const double write_seconds = Measure([&] {
+            for (size_t i = 0; i < count; ++i)
+                Memory::WriteBlock(BLOCK_VADDR + static_cast<VAddr>(i * size % half),
+                                   buffer.data(), size);
+        });
+        std::snprintf(name, sizeof(name), "WriteBlock %zu B, %s", size, page_kind);
+        PrintThroughput(name, count * size, write_seconds);
+
+        const double copy_seconds = Measure([&] {
+            for (size_t i = 0; i < count; ++i)
+                Memory::CopyBlock(BLOCK_VADDR + half + static_cast<VAddr>(i * size % half),
+                                  BLOCK_VADDR + static_cast<VAddr>(i * size % half), size);
+        });
+        std::snprintf(name, sizeof(name), "CopyBlock %zu B, %s", size, page_kind);
+        PrintThroughput(name, count * size, copy_seconds);
+    }
+}
+
+/// Reads registers of the last mapped region, the worst case for a search of the regions
+void BenchmarkMMIORead() {
+    for (u32 i = 0; i < NUM_MMIO_REGIONS; ++i) {
+        Memory::MapIoRegion(MMIO_VADDR + i * Memory::PAGE_SIZE, Memory::PAGE_SIZE,
+                            std::make_shared<RegisterDevice>());
+    }
+
+    const VAddr last_region = MMIO_VADDR + (NUM_MMIO_REGIONS - 1) * Memory::PAGE_SIZE;
+    u32 sum = 0;
+    const double seconds = Measure([&] {
+        for (size_t i = 0; i < MMIO_READS_PER_MEASUREMENT; ++i)
+            sum += Memory::Read32(last_region + static_cast<VAddr>(i % 1024 * 4));
+    });
+    PrintTime("Read32 of a register", MMIO_READS_PER_MEASUREMENT, seconds);
+    std::printf("  (checksum %08X)\n", sum);
+
+    Memory::UnmapRegion(MMIO_VADDR, NUM_MMIO_REGIONS * Memory::PAGE_SIZE);
+}
+
+void BenchmarkMarkRegionCached(const Surfaces& surfaces) {
+    const double seconds = Measure([&] {
+        for (const auto& surface : surfaces)
+            Memory::RasterizerMarkRegionCached(surface->addr, surface->size, 1);
+        for (const auto& surface : surfaces)
+            Memory::RasterizerMarkRegionCached(surface->addr, surface->size, -1);
+    });
+    PrintTime("mark + unmark surface pages", surfaces.size(), seconds);
+}
+
+/// Benchmarks the interval map of surfaces, used the way RasterizerCacheOpenGL uses it
+void BenchmarkIntervalMap(const Surfaces& surfaces, const std::vector<Region>& lookups) {
+    SurfaceCache surface_cache;
+    // Like the rasterizer cache, deduplicate the results with the generation of a page index
+    SurfacePageIndex generations;
+    std::vector<CachedSurface*> results;
+    size_t found = 0;
+
+    const auto Add = [&] {
+        for (const auto& surface : surfaces) {
+            auto interval = boost::icl::interval<PAddr>::right_open(
+                surface->addr, surface->addr + surface->size);
+            surface_cache.add(
+                std::make_pair(interval, std::set<std::shared_ptr<CachedSurface>>({surface})));
+        }
+    };
+    const auto Remove = [&] {
+        for (const auto& surface : surfaces) {
+            auto interval = boost::icl::interval<PAddr>::right_open(
+                surface->addr, surface->addr + surface->size);
+            surface_cache.subtract(
+                std::make_pair(interval, std::set<std::shared_ptr<CachedSurface>>({surface})));
+        }
+    };
+
+    const double add_remove_seconds = Measure([&] {
+        Add();
+        Remove();
+    });
+    PrintTime("interval map add + remove", surfaces.size(), add_remove_seconds);
+
+    Add();
+    const double lookup_seconds = Measure([&] {
+        for (const Region& region : lookups) {
+            results.clear();
+            const u64 lookup_generation = generations.NextGeneration();
+            auto range = surface_cache.equal_range(
+                boost::icl::interval<PAddr>::right_open(region.addr, region.addr + region.size));
+            for (auto it = range.first; it != range.second; ++it) {
+                for (const auto& surface : it->second) {
+                    if (surface->index_generation != lookup_generation) {
+                        surface->index_generation = lookup_generation;
+                        results.push_back(surface.get());
+                    }
+                }
+            }
+            found += results.size();
+        }
+    });
+    PrintTime("interval map lookup", lookups.size(), lookup_seconds);
+    std::printf("  (%.2f surfaces per lookup)\n",
+                static_cast<double>(found) / (lookups.size() * repetitions));
+    Remove();
+}
+
+void BenchmarkPageIndex(const Surfaces& surfaces, const std::vector<Region>& lookups) {
+    SurfacePageIndex page_index;
+    std::vector<CachedSurface*> results;
+
+    const double add_remove_seconds = Measure([&] {
+        for (const auto& surface : surfaces)
+            page_index.Add(surface.get());
+        for (const auto& surface : surfaces)
+            page_index.Remove(surface.get());
+    });
+    PrintTime("page index add + remove", surfaces.size(), add_remove_seconds);
+
+    for (const auto& surface : surfaces)
+        page_index.Add(surface.get());
+    const double lookup_seconds = Measure([&] {
+        for (const Region& region : lookups) {
+            results.clear();
+            page_index.GetOverlapping(region.addr, region.size, results);
+        }
+    });
+    PrintTime("page index lookup", lookups.size(), lookup_seconds);
+}
+
+void PrintUsage(const char* argv0) {
+    std::fprintf(stderr, "Usage: %s [-n <surfaces>] [-r <repetitions>]\n", argv0);
+}
+
+} // Anonymous namespace
+
+int main(int argc, char** argv) {
+    Log::Filter log_filter(Log::Level::Warning);
+    Log::SetFilter(&log_filter);
+
+    size_t num_surfaces = 4096;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            num_surfaces = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repetitions = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (num_surfaces == 0 || repetitions == 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    // Cached pages are accessed through the VMAs of the current process
+    std::vector<u8> memory(BLOCK_REGION_SIZE);
+    Kernel::g_current_process = Kernel::Process::Create(Kernel::CodeSet::Create("", 0));
+    Kernel::g_current_process->vm_manager.MapBackingMemory(
+        BLOCK_VADDR, memory.data(), BLOCK_REGION_SIZE, Kernel::MemoryState::Continuous);
+
+    std::printf("Block operations\n");
+    BenchmarkBlockOperations("plain pages");
+    Memory::RasterizerMarkRegionCached(BLOCK_PADDR, BLOCK_REGION_SIZE, 1);
+    BenchmarkBlockOperations("cached pages");
+    Memory::RasterizerMarkRegionCached(BLOCK_PADDR, BLOCK_REGION_SIZE, -1);
+
+    std::printf("Mapped I/O\n");
+    BenchmarkMMIORead();
+
+    const Surfaces surfaces = GenerateSurfaces(num_surfaces);
+    const std::vector<Region> lookups = GenerateLookups(LOOKUPS_PER_MEASUREMENT);
+
+    std::printf("%zu surfaces, %zu lookups\n", num_surfaces, LOOKUPS_PER_MEASUREMENT);
+    BenchmarkMarkRegionCached(surfaces);
+    BenchmarkIntervalMap(surfaces, lookups);
+    BenchmarkPageIndex(surfaces, lookups);
+
+    Kernel::g_current_process = nullptr;
+    return 0;
+}
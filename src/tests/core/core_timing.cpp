@@ -0,0 +1,59 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <catch.hpp>
+#include "core/core_timing.h"
+
+namespace {
+
+unsigned kept_events_fired;
+
+void RemovedCallback(u64 userdata, int cycles_late) {
+    FAIL("Removed event " << userdata << " fired");
+}
+
+void KeptCallback(u64 userdata, int cycles_late) {
+    ++kept_events_fired;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("CoreTiming: Removes every matching event from the queue", "[core]") {
+    CoreTiming::Init();
+    const int removed_type = CoreTiming::RegisterEvent("removed", RemovedCallback);
+    const int kept_type = CoreTiming::RegisterEvent("kept", KeptCallback);
+
+    // Interleave the events at random times, so that the ones to remove are scattered through the
+    // heap and removing one moves others above positions already checked
+    std::mt19937 rng(0x051);
+    std::uniform_int_distribution<s64> time_dist(1000, 100000);
+    unsigned kept_events = 0;
+    for (u64 i = 0; i < 200; ++i) {
+        if (i % 3 == 0) {
+            CoreTiming::ScheduleEvent(time_dist(rng), kept_type, i);
+            ++kept_events;
+        } else {
+            CoreTiming::ScheduleEvent(time_dist(rng), removed_type, i % 2);
+        }
+    }
+
+    SECTION("RemoveEvent") {
+        CoreTiming::RemoveEvent(removed_type);
+    }
+    SECTION("UnscheduleEvent") {
+        CoreTiming::UnscheduleEvent(removed_type, 0);
+        CoreTiming::UnscheduleEvent(removed_type, 1);
+    }
+
+    REQUIRE(!CoreTiming::IsScheduled(removed_type));
+    REQUIRE(CoreTiming::IsScheduled(kept_type));
+
+    kept_events_fired = 0;
+    CoreTiming::AddTicks(200000);
+    CoreTiming::Advance();
+    REQUIRE(kept_events_fired == kept_events);
+
+    CoreTiming::Shutdown();
+}
@@ -0,0 +1,112 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// Measures how long WaitSynchronizationN takes to look up its handles and decide whether the wait
+// is already satisfied, for a given number of handles and position of the ready object.
+//
+// Usage: bench_wait_synchronization [-n <handles>] [-i <iterations>]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "common/common_types.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/thread.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<Kernel::SharedPtr<Kernel::Event>> events;
+std::vector<Kernel::Handle> handles;
+
+double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void PrintResult(const char* name, size_t iterations, double seconds) {
+    std::printf("  %-28s %10.1f ns/op\n", name, seconds * 1e9 / iterations);
+}
+
+/// Signals only the event at `ready`, or all of them if it is negative
+void SetReady(int ready) {
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (ready < 0 || static_cast<size_t>(ready) == i) {
+            events[i]->Signal();
+        } else {
+            events[i]->Clear();
+        }
+    }
+}
+
+void BenchmarkLookUp(const char* name, bool wait_all, size_t iterations) {
+    size_t ready_count = 0;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        // A new list every time, as every call of the SVC starts with one
+        Kernel::WaitObjectList objects;
+        bool ready;
+        s32 ready_index;
+        Kernel::LookUpWaitObjects(objects, handles.data(), static_cast<s32>(handles.size()),
+                                  nullptr, wait_all, ready, ready_index);
+        ready_count += ready;
+    }
+    PrintResult(name, iterations, SecondsSince(start));
+
+    // Keeps the loop from being optimized out
+    if (ready_count > iterations)
+        std::abort();
+}
+
+void PrintUsage(const char* argv0) {
+    std::fprintf(stderr, "Usage: %s [-n <handles>] [-i <iterations>]\n", argv0);
+}
+
+} // Anonymous namespace
+
+int main(int argc, char** argv) {
+    Log::Filter log_filter(Log::Level::Warning);
+    Log::SetFilter(&log_filter);
+
+    size_t num_handles = 8;
+    size_t iterations = 1000000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            num_handles = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            iterations = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (num_handles == 0 || iterations == 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    // Sticky events stay signaled, so that nothing changes between iterations
+    for (size_t i = 0; i < num_handles; ++i) {
+        events.push_back(Kernel::Event::Create(Kernel::ResetType::Sticky));
+        handles.push_back(Kernel::g_handle_table.Create(events.back()).Unwrap());
+    }
+
+    std::printf("%zu handles, %zu iterations\n", num_handles, iterations);
+    SetReady(0);
+    BenchmarkLookUp("wait any, first ready", false, iterations);
+    SetReady(static_cast<int>(num_handles - 1));
+    BenchmarkLookUp("wait any, last ready", false, iterations);
+    BenchmarkLookUp("wait all, last ready", true, iterations);
+    SetReady(-1);
+    BenchmarkLookUp("wait all, all ready", true, iterations);
+
+    Kernel::g_handle_table.Clear();
+    events.clear();
+    return 0;
+}
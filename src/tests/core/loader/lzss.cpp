@@ -0,0 +1,108 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "core/loader/lzss.h"
+
+namespace Loader {
+
+/// The decompressor copying back-references one byte at a time, with a bounds check for each
+static bool ReferenceDecompress(const u8* compressed, u32 compressed_size, u8* decompressed,
+                                u32 decompressed_size) {
+    const u8* footer = compressed + compressed_size - 8;
+    u32 buffer_top_and_bottom;
+    std::memcpy(&buffer_top_and_bottom, footer, sizeof(u32));
+    u32 out = decompressed_size;
+    u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
+    u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
+
+    std::memset(decompressed, 0, decompressed_size);
+    std::memcpy(decompressed, compressed, compressed_size);
+
+    while (index > stop_index) {
+        u8 control = compressed[--index];
+
+        for (unsigned i = 0; i < 8; i++) {
+            if (index <= stop_index || index <= 0 || out <= 0)
+                break;
+
+            if (control & 0x80) {
+                if (index < 2)
+                    return false;
+                index -= 2;
+
+                u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
+                u32 segment_size = ((segment_offset >> 12) & 15) + 3;
+                segment_offset &= 0x0FFF;
+                segment_offset += 2;
+
+                if (out < segment_size)
+                    return false;
+
+                for (unsigned j = 0; j < segment_size; j++) {
+                    if (out + segment_offset >= decompressed_size)
+                        return false;
+
+                    u8 data = decompressed[out + segment_offset];
+                    decompressed[--out] = data;
+                }
+            } else {
+                if (out < 1)
+                    return false;
+                decompressed[--out] = compressed[--index];
+            }
+            control <<= 1;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("LZSS_Decompress: matches the byte-wise decompressor", "[core][loader]") {
+    std::mt19937 rng(0x066);
+    std::uniform_int_distribution<u32> compressed_size_dist(8, 256);
+    std::uniform_int_distribution<u32> additional_size_dist(0, 512);
+    std::uniform_int_distribution<u32> header_size_dist(8, 11);
+    std::uniform_int_distribution<int> byte_dist(0, 255);
+
+    unsigned succeeded = 0;
+    for (int stream = 0; stream < 200000; ++stream) {
+        const u32 compressed_size = compressed_size_dist(rng);
+        std::vector<u8> compressed(compressed_size);
+        for (u8& byte : compressed)
+            byte = static_cast<u8>(byte_dist(rng));
+
+        // Footer: the size of the footer and the size of the compressed data, then the number of
+        // bytes the data grows by
+        const u32 header_size = std::min(header_size_dist(rng), compressed_size);
+        const u32 data_size =
+            std::uniform_int_distribution<u32>(header_size, compressed_size)(rng);
+        const u32 buffer_top_and_bottom = header_size << 24 | data_size;
+        const u32 additional_size = additional_size_dist(rng);
+        std::memcpy(&compressed[compressed_size - 8], &buffer_top_and_bottom, sizeof(u32));
+        std::memcpy(&compressed[compressed_size - 4], &additional_size, sizeof(u32));
+
+        const u32 decompressed_size = LZSS_GetDecompressedSize(compressed.data(), compressed_size);
+        REQUIRE(decompressed_size == compressed_size + additional_size);
+        std::vector<u8> expected(decompressed_size);
+        std::vector<u8> actual(decompressed_size);
+        const bool expected_result = ReferenceDecompress(compressed.data(), compressed_size,
+                                                         expected.data(), decompressed_size);
+        const bool actual_result =
+            LZSS_Decompress(compressed.data(), compressed_size, actual.data(), decompressed_size);
+
+        INFO("stream " << stream);
+        REQUIRE(actual_result == expected_result);
+        REQUIRE(actual == expected);
+        succeeded += expected_result ? 1 : 0;
+    }
+    // Make sure both outcomes are covered
+    REQUIRE(succeeded > 0);
+    REQUIRE(succeeded < 200000);
+}
+
+} // namespace Loader
@@ -0,0 +1,128 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <catch.hpp>
+#include "enet/enet.h"
+#include "network/room.h"
+
+#ifndef _WIN32
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#endif
+
+namespace Network {
+
+namespace {
+
+/// Ports the rooms of the tests listen on, well away from DefaultRoomPort
+constexpr u16 FirstTestPort = 25872;
+
+/// Longest the tests wait for traffic, which they expect to arrive right away
+constexpr u32 TrafficTimeoutMs = 10000;
+
+/**
+ * Creates rooms without threads of their own, sends a datagram to the last one and checks that
+ * WaitForTraffic returns for it long before the timeout.
+ */
+void CheckWaitForTrafficWakes(size_t num_rooms) {
+    REQUIRE(enet_initialize() == 0);
+
+    std::vector<std::unique_ptr<Room>> rooms;
+    std::vector<Room*> waiting_rooms;
+    u16 last_port = 0;
+    for (u16 port = FirstTestPort; rooms.size() < num_rooms && port < FirstTestPort + 2 * num_rooms;
+         ++port) {
+        auto room = std::make_unique<Room>();
+        room->Create("Test room", "127.0.0.1", port, false);
+        // Skip the ports other programs are using
+        if (room->GetState() != Room::State::Open)
+            continue;
+        waiting_rooms.push_back(room.get());
+        rooms.push_back(std::move(room));
+        last_port = port;
+    }
+    REQUIRE(rooms.size() == num_rooms);
+
+    ENetSocket sender = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+    REQUIRE(sender != ENET_SOCKET_NULL);
+    ENetAddress address;
+    enet_address_set_host(&address, "127.0.0.1");
+    address.port = last_port;
+    u8 byte = 0;
+    ENetBuffer buffer;
+    buffer.data = &byte;
+    buffer.dataLength = sizeof(byte);
+    REQUIRE(enet_socket_send(sender, &address, &buffer, 1) == 1);
+
+    const auto start = std::chrono::steady_clock::now();
+    Room::WaitForTraffic(waiting_rooms, TrafficTimeoutMs);
+    const auto waited = std::chrono::steady_clock::now() - start;
+    REQUIRE(waited < std::chrono::milliseconds(TrafficTimeoutMs / 2));
+
+    enet_socket_destroy(sender);
+    for (const auto& room : rooms) {
+        room->Destroy();
+    }
+    enet_deinitialize();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Room::WaitForTraffic: returns after the timeout without traffic", "[network]") {
+    REQUIRE(enet_initialize() == 0);
+    Room room;
+    room.Create("Test room", "127.0.0.1", FirstTestPort, false);
+    REQUIRE(room.GetState() == Room::State::Open);
+
+    const auto start = std::chrono::steady_clock::now();
+    Room::WaitForTraffic({&room}, 50);
+    REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(40));
+
+    room.Destroy();
+    enet_deinitialize();
+}
+
+TEST_CASE("Room::WaitForTraffic: wakes for traffic on any of many rooms", "[network]") {
+    // More than the 64 sockets a Windows fd_set holds
+    CheckWaitForTrafficWakes(128);
+}
+
+#ifndef _WIN32
+TEST_CASE("Room::WaitForTraffic: wakes for sockets past FD_SETSIZE", "[network]") {
+    // Take up the descriptors below FD_SETSIZE, which select can't wait on past
+    const rlim_t needed_descriptors = FD_SETSIZE + 64;
+    rlimit limit;
+    REQUIRE(getrlimit(RLIMIT_NOFILE, &limit) == 0);
+    if (limit.rlim_cur < needed_descriptors) {
+        limit.rlim_cur = std::min(needed_descriptors, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    if (limit.rlim_cur < needed_descriptors) {
+        WARN("Skipped, as the process can't open enough files");
+        return;
+    }
+
+    std::vector<int> placeholders;
+    while (placeholders.empty() || placeholders.back() < FD_SETSIZE) {
+        const int fd = open("/dev/null", O_RDONLY);
+        REQUIRE(fd >= 0);
+        placeholders.push_back(fd);
+    }
+
+    CheckWaitForTrafficWakes(16);
+
+    for (int fd : placeholders) {
+        close(fd);
+    }
+}
+#endif
+
+} // namespace Network
@@ -0,0 +1,246 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// Measures the throughput of the shader engines on vertex shader programs recorded in CiTrace
+// files. Each trace contributes the program, swizzle data, uniforms and shader configuration that
+// were current when its recording started.
+//
+// Usage: bench_shader [-n <vertices>] <trace.ctf>...
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "core/tracer/citrace.h"
+#include "video_core/pica_types.h"
+#include "video_core/regs.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter.h"
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/shader/shader_jit_x64.h"
+#elif defined(ARCHITECTURE_ARM64)
+#include "video_core/shader/shader_jit_a64.h"
+#endif
+
+using Pica::float24;
+using Pica::Shader::AttributeBuffer;
+using Pica::Shader::ShaderEngine;
+using Pica::Shader::ShaderSetup;
+using Pica::Shader::UnitState;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Number of distinct input vertices, reused round-robin until the requested count is shaded
+constexpr size_t VERTEX_POOL_SIZE = 1024;
+
+struct TraceProgram {
+    std::string name;
+    Pica::Regs regs;
+    ShaderSetup setup;
+};
+
+struct EngineFactory {
+    const char* name;
+    std::unique_ptr<ShaderEngine> (*create)();
+};
+
+template <typename Engine>
+std::unique_ptr<ShaderEngine> CreateEngine() {
+    return std::make_unique<Engine>();
+}
+
+const EngineFactory engine_factories[] = {
+    {"interpreter", &CreateEngine<Pica::Shader::InterpreterEngine>},
+#ifdef ARCHITECTURE_x86_64
+    {"jit_x64", &CreateEngine<Pica::Shader::JitX64Engine>},
+#elif defined(ARCHITECTURE_ARM64)
+    {"jit_a64", &CreateEngine<Pica::Shader::JitA64Engine>},
+#endif
+};
+
+double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/// Copies `count` words starting at byte `offset` of the trace, failing if they are out of bounds
+bool ReadWords(const std::vector<u8>& file, u32 offset, u32 count, u32* out) {
+    if (offset > file.size() || count > (file.size() - offset) / sizeof(u32))
+        return false;
+    std::memcpy(out, file.data() + offset, count * sizeof(u32));
+    return true;
+}
+
+std::unique_ptr<TraceProgram> LoadTrace(const std::string& filename) {
+    FileUtil::IOFile file(filename, "rb");
+    if (!file.IsOpen()) {
+        std::fprintf(stderr, "%s: could not open file\n", filename.c_str());
+        return nullptr;
+    }
+    std::vector<u8> data(file.GetSize());
+    if (file.ReadBytes(data.data(), data.size()) != data.size()) {
+        std::fprintf(stderr, "%s: could not read file\n", filename.c_str());
+        return nullptr;
+    }
+
+    CiTrace::CTHeader header;
+    if (data.size() < sizeof(header)) {
+        std::fprintf(stderr, "%s: file too small\n", filename.c_str());
+        return nullptr;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, CiTrace::CTHeader::ExpectedMagicWord(), 4) != 0 ||
+        header.version != CiTrace::CTHeader::ExpectedVersion()) {
+        std::fprintf(stderr, "%s: not a CiTrace file of a supported version\n", filename.c_str());
+        return nullptr;
+    }
+    const auto& offsets = header.initial_state_offsets;
+
+    auto program = std::make_unique<TraceProgram>();
+    program->name = filename;
+    program->regs.reg_array.fill(0);
+    program->setup.program_code.fill(0);
+    program->setup.swizzle_data.fill(0);
+
+    const u32 num_regs = std::min<u32>(offsets.pica_registers_size, Pica::Regs::NUM_REGS);
+    const u32 program_size = std::min<u32>(offsets.vs_program_binary_size,
+                                           Pica::Shader::MAX_PROGRAM_CODE_LENGTH);
+    const u32 swizzle_size =
+        std::min<u32>(offsets.vs_swizzle_data_size, Pica::Shader::MAX_SWIZZLE_DATA_LENGTH);
+    std::vector<u32> float_uniforms(std::min<u32>(offsets.vs_float_uniforms_size, 4 * 96));
+
+    if (!ReadWords(data, offsets.pica_registers, num_regs, program->regs.reg_array.data()) ||
+        !ReadWords(data, offsets.vs_program_binary, program_size,
+                   program->setup.program_code.data()) ||
+        !ReadWords(data, offsets.vs_swizzle_data, swizzle_size,
+                   program->setup.swizzle_data.data()) ||
+        !ReadWords(data, offsets.vs_float_uniforms, static_cast<u32>(float_uniforms.size()),
+                   float_uniforms.data())) {
+        std::fprintf(stderr, "%s: initial state out of bounds\n", filename.c_str());
+        return nullptr;
+    }
+
+    // Float uniforms are stored as four raw float24 words each
+    auto& uniforms = program->setup.uniforms;
+    for (auto& uniform : uniforms.f)
+        uniform = Math::Vec4<float24>::AssignToAll(float24::Zero());
+    for (size_t i = 0; i < float_uniforms.size(); ++i)
+        uniforms.f[i / 4][i % 4] = float24::FromRaw(float_uniforms[i] & 0xFFFFFF);
+
+    const auto& config = program->regs.vs;
+    for (unsigned i = 0; i < uniforms.b.size(); ++i)
+        uniforms.b[i] = (config.bool_uniforms & (1 << i)) != 0;
+    for (unsigned i = 0; i < uniforms.i.size(); ++i) {
+        const auto& values = config.int_uniforms[i];
+        uniforms.i[i] = Math::Vec4<u8>(values.x, values.y, values.z, values.w);
+    }
+
+    return program;
+}
+
+/// Fills the input vertices with reproducible values in [-1, 1]
+void GenerateInputs(std::vector<AttributeBuffer>& inputs) {
+    u32 seed = 0x12345678;
+    for (auto& input : inputs) {
+        for (auto& attr : input.attr) {
+            for (unsigned comp = 0; comp < 4; ++comp) {
+                seed = seed * 1664525 + 1013904223;
+                attr[comp] = float24::FromFloat32((seed >> 8) / float(1 << 23) - 1.0f);
+            }
+        }
+    }
+}
+
+void BenchmarkEngine(const EngineFactory& factory, const TraceProgram& program,
+                     const std::vector<AttributeBuffer>& inputs, size_t num_vertices) {
+    const auto& config = program.regs.vs;
+    auto setup = std::make_unique<ShaderSetup>(program.setup);
+    auto engine = factory.create();
+
+    // The first SetupBatch of an engine translates or compiles the program
+    auto start = Clock::now();
+    engine->SetupBatch(*setup, config.main_offset, config.output_mask);
+    const double compile_time = SecondsSince(start);
+
+    std::vector<AttributeBuffer> outputs(inputs.size());
+
+    UnitState state;
+    start = Clock::now();
+    for (size_t i = 0; i < num_vertices; ++i) {
+        const size_t index = i % inputs.size();
+        state.LoadInput(config, inputs[index]);
+        engine->Run(*setup, state);
+        state.WriteOutput(config, outputs[index]);
+    }
+    const double run_time = SecondsSince(start);
+
+    start = Clock::now();
+    for (size_t done = 0; done < num_vertices; done += inputs.size()) {
+        const size_t count = std::min(inputs.size(), num_vertices - done);
+        engine->RunBatch(*setup, config, inputs.data(), outputs.data(), count);
+    }
+    const double batch_time = SecondsSince(start);
+
+    std::printf("  %-12s compile %9.3f ms  run %12.0f vtx/s  batch %12.0f vtx/s\n", factory.name,
+                compile_time * 1000.0, num_vertices / run_time, num_vertices / batch_time);
+}
+
+void PrintUsage(const char* argv0) {
+    std::fprintf(stderr, "Usage: %s [-n <vertices>] <trace.ctf>...\n", argv0);
+}
+
+} // Anonymous namespace
+
+int main(int argc, char** argv) {
+    Log::Filter log_filter(Log::Level::Warning);
+    Log::SetFilter(&log_filter);
+
+    size_t num_vertices = 1000000;
+    std::vector<std::string> filenames;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            num_vertices = std::strtoul(argv[++i], nullptr, 10);
+        } else if (argv[i][0] == '-') {
+            PrintUsage(argv[0]);
+            return 1;
+        } else {
+            filenames.push_back(argv[i]);
+        }
+    }
+    if (filenames.empty() || num_vertices == 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<AttributeBuffer> inputs(std::min(VERTEX_POOL_SIZE, num_vertices));
+    GenerateInputs(inputs);
+
+    int result = 0;
+    for (const auto& filename : filenames) {
+        const auto program = LoadTrace(filename);
+        if (program == nullptr) {
+            result = 1;
+            continue;
+        }
+
+        const u64 hash = Common::ComputeHash64(&program->setup.program_code,
+                                               sizeof(program->setup.program_code));
+        std::printf("%s (program %016llx, entry point %u, %zu vertices)\n", filename.c_str(),
+                    static_cast<unsigned long long>(hash),
+                    static_cast<unsigned>(program->regs.vs.main_offset), num_vertices);
+        for (const auto& factory : engine_factories)
+            BenchmarkEngine(factory, *program, inputs, num_vertices);
+    }
+    return result;
+}
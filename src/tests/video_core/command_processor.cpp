@@ -0,0 +1,114 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <vector>
+#include <catch.hpp>
+#include "tests/video_core/shader/shader_test_common.h"
+#include "video_core/command_processor.h"
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/regs.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace Pica {
+namespace CommandProcessor {
+
+namespace {
+
+/// Counts the triangles queued and the batches drawn
+class CountingRasterizer : public VideoCore::RasterizerInterface {
+public:
+    void AddTriangle(const Shader::OutputVertex&, const Shader::OutputVertex&,
+                     const Shader::OutputVertex&) override {
+        ++triangles;
+    }
+    void DrawTriangles() override {
+        ++draws;
+    }
+    void NotifyPicaRegisterChanged(u32 id) override {}
+    void FlushAll() override {}
+    void FlushRegion(PAddr addr, u32 size) override {}
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
+
+    unsigned triangles = 0;
+    unsigned draws = 0;
+};
+
+class CountingRenderer : public RendererBase {
+public:
+    CountingRenderer() {
+        rasterizer = std::make_unique<CountingRasterizer>();
+    }
+
+    void SwapBuffers() override {}
+    void SetWindow(EmuWindow* window) override {}
+    bool Init() override {
+        return true;
+    }
+    void ShutDown() override {}
+
+    CountingRasterizer& GetRasterizer() const {
+        return static_cast<CountingRasterizer&>(*rasterizer);
+    }
+};
+
+/// Builds a command list writing one register per command
+class CommandListBuilder {
+public:
+    void Write(u32 id, u32 value) {
+        CommandHeader header{};
+        header.cmd_id.Assign(id);
+        header.parameter_mask.Assign(0xF);
+        words.push_back(value);
+        words.push_back(header.hex);
+    }
+
+    /// Submits a vertex through the immediate mode default attribute port
+    void ImmediateVertex() {
+        for (u32 i = 0; i < 3; ++i)
+            Write(PICA_REG_INDEX_WORKAROUND(pipeline.vs_default_attributes_setup.set_value[0],
+                                            0x233),
+                  0);
+    }
+
+    const std::vector<u32>& GetWords() const {
+        return words;
+    }
+
+private:
+    std::vector<u32> words;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("ProcessCommandList: Draws the triangles queued by the end of the list",
+          "[video_core]") {
+    Pica::Init();
+    auto renderer = std::make_unique<CountingRenderer>();
+    CountingRasterizer& rasterizer = renderer->GetRasterizer();
+    VideoCore::g_renderer = std::move(renderer);
+
+    ShaderTests::ProgramBuilder builder(g_state.vs);
+    builder.Simple(ShaderTests::OpCode::Id::END);
+
+    // Two triangles in immediate mode, which share their state and go out as one batch
+    CommandListBuilder list;
+    list.Write(PICA_REG_INDEX(pipeline.vs_default_attributes_setup.index), 0xF);
+    for (int vertex = 0; vertex < 6; ++vertex)
+        list.ImmediateVertex();
+
+    ProcessCommandList(list.GetWords().data(),
+                       static_cast<u32>(list.GetWords().size() * sizeof(u32)));
+    REQUIRE(rasterizer.triangles == 2);
+    REQUIRE(rasterizer.draws == 1);
+
+    VideoCore::g_renderer.reset();
+    Pica::Shutdown();
+}
+
+} // namespace CommandProcessor
+} // namespace Pica
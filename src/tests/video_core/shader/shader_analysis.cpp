@@ -0,0 +1,190 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <catch.hpp>
+#include "tests/video_core/shader/shader_test_common.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_analysis.h"
+
+using Pica::Shader::ProgramAnalysis;
+using Pica::Shader::ShaderSetup;
+using Pica::Shader::ShaderSpecialization;
+using namespace ShaderTests;
+
+namespace {
+
+ShaderSpecialization MakeSpecialization(u32 output_mask) {
+    ShaderSpecialization specialization{};
+    specialization.entry_point = 0;
+    specialization.output_mask = output_mask;
+    return specialization;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ProgramAnalysis: removes dead writes", "[video_core][shader]") {
+    auto setup = std::make_unique<ShaderSetup>();
+    ProgramBuilder builder(*setup);
+    // 0: overwritten before it is read
+    builder.Arithmetic(OpCode::Id::MOV, DestTemporary(0), "xyzw", Input(0), "xyzw");
+    // 1: read by the ADD
+    builder.Arithmetic(OpCode::Id::MOV, DestTemporary(0), "xyzw", Input(1), "xyzw");
+    // 2: never read
+    builder.Arithmetic(OpCode::Id::MOV, DestTemporary(1), "xy", Input(0), "xyzw");
+    // 3: written to the output vertex
+    builder.Arithmetic(OpCode::Id::ADD, Output(0), "xyzw", FloatUniform(0), "xyzw", Temporary(0),
+                       "xyzw");
+    // 4: writes an output register that isn't part of the output vertex
+    builder.Arithmetic(OpCode::Id::MOV, Output(1), "xyzw", Input(2), "xyzw");
+    // 5, 6: a chain of writes only read by dead instructions
+    builder.Arithmetic(OpCode::Id::MUL, DestTemporary(2), "xyzw", Input(0), "xyzw", Input(1),
+                       "xyzw");
+    builder.Arithmetic(OpCode::Id::ADD, DestTemporary(3), "xyzw", FloatUniform(1), "xyzw",
+                       Temporary(2), "xyzw");
+    // 7: only the components the DP4 doesn't read are overwritten later on
+    builder.Arithmetic(OpCode::Id::MOV, DestTemporary(4), "xyzw", Input(2), "xyzw");
+    builder.Arithmetic(OpCode::Id::MOV, DestTemporary(4), "zw", Input(1), "xyzw");
+    builder.Arithmetic(OpCode::Id::DP4, Output(0), "w", Temporary(4), "xyzw", Input(0), "xyzw");
+    // 10: only the components the MUL doesn't read are read
+    builder.Arithmetic(OpCode::Id::MOV, DestTemporary(5), "xy", Input(2), "xyzw");
+    builder.Arithmetic(OpCode::Id::MUL, Output(0), "z", Temporary(5), "zzzz", Input(0), "xyzw");
+    builder.Simple(OpCode::Id::END);
+    // 13: after the END
+    builder.Arithmetic(OpCode::Id::MOV, Output(0), "xyzw", Input(0), "xyzw");
+    builder.Simple(OpCode::Id::END);
+
+    const ProgramAnalysis analysis(setup->program_code, setup->swizzle_data,
+                                   MakeSpecialization(0x1));
+
+    REQUIRE(analysis.IsDead(0));
+    REQUIRE(!analysis.IsDead(1));
+    REQUIRE(analysis.IsDead(2));
+    REQUIRE(!analysis.IsDead(3));
+    REQUIRE(analysis.IsDead(4));
+    REQUIRE(analysis.IsDead(5));
+    REQUIRE(analysis.IsDead(6));
+    REQUIRE(!analysis.IsDead(7));
+    REQUIRE(!analysis.IsDead(8));
+    REQUIRE(!analysis.IsDead(9));
+    REQUIRE(analysis.IsDead(10));
+    REQUIRE(!analysis.IsDead(11));
+
+    REQUIRE(analysis.IsReachable(12));
+    REQUIRE(!analysis.IsReachable(13));
+    REQUIRE(!analysis.IsReachable(14));
+    REQUIRE(analysis.NumReachable() == 13);
+}
+
+TEST_CASE("ProgramAnalysis: drops code behind resolved uniform branches", "[video_core][shader]") {
+    auto setup = std::make_unique<ShaderSetup>();
+    ProgramBuilder builder(*setup);
+    // 0: IF b2 runs 1-2, ELSE runs 3-4
+    builder.UniformFlowControl(OpCode::Id::IFU, 2, 3, 2);
+    builder.Arithmetic(OpCode::Id::MOV, Output(0), "xyzw", Input(0), "xyzw");
+    builder.Simple(OpCode::Id::NOP);
+    builder.Arithmetic(OpCode::Id::MOV, Output(0), "xyzw", Input(1), "xyzw");
+    builder.Simple(OpCode::Id::NOP);
+    // 5: skips 6 if b3 is set
+    builder.UniformFlowControl(OpCode::Id::JMPU, 3, 7, 0);
+    builder.Arithmetic(OpCode::Id::MOV, Output(1), "xyzw", Input(1), "xyzw");
+    builder.Simple(OpCode::Id::END);
+
+    SECTION("unknown uniforms") {
+        const ProgramAnalysis analysis(setup->program_code, setup->swizzle_data,
+                                       MakeSpecialization(0x3));
+        REQUIRE(analysis.NumReachable() == 8);
+    }
+
+    SECTION("known uniforms") {
+        auto specialization = MakeSpecialization(0x3);
+        specialization.bool_uniform_mask = (1 << 2) | (1 << 3);
+        specialization.bool_uniforms = (1 << 2) | (1 << 3);
+        const ProgramAnalysis analysis(setup->program_code, setup->swizzle_data, specialization);
+
+        REQUIRE(analysis.IsReachable(1));
+        REQUIRE(analysis.IsReachable(2));
+        REQUIRE(!analysis.IsReachable(3));
+        REQUIRE(!analysis.IsReachable(4));
+        REQUIRE(analysis.IsReachable(5));
+        REQUIRE(!analysis.IsReachable(6));
+        REQUIRE(analysis.IsReachable(7));
+        REQUIRE(analysis.NumReachable() == 5);
+    }
+}
+
+TEST_CASE("ProgramAnalysis: keeps writes live across branches and calls", "[video_core][shader]") {
+    auto setup = std::make_unique<ShaderSetup>();
+    ProgramBuilder builder(*setup);
+    // 0: read by the subroutine
+    builder.Arithmetic(OpCode::Id::MOV, DestTemporary(0), "xyzw", Input(0), "xyzw");
+    // 1: read at 8 unless the IF at 4 overwrites it
+    builder.Arithmetic(OpCode::Id::MOV, DestTemporary(1), "xyzw", Input(1), "xyzw");
+    // 2: accumulated by the loop
+    builder.Arithmetic(OpCode::Id::MOV, DestTemporary(4), "xyzw", FloatUniform(3), "xyzw");
+    // 3: subroutine at 12-13
+    builder.UniformFlowControl(OpCode::Id::CALL, 0, 12, 2);
+    // 4: IF b1 runs 5
+    builder.UniformFlowControl(OpCode::Id::IFU, 1, 6, 0);
+    builder.Arithmetic(OpCode::Id::MOV, DestTemporary(1), "xyzw", Input(2), "xyzw");
+    // 6: LOOP i0 runs 7
+    builder.UniformFlowControl(OpCode::Id::LOOP, 0, 7, 0);
+    builder.Arithmetic(OpCode::Id::ADD, DestTemporary(4), "xyzw", FloatUniform(2), "xyzw",
+                       Temporary(4), "xyzw");
+    // 8: reads r1 and the r2 written by the subroutine
+    builder.Arithmetic(OpCode::Id::ADD, Output(1), "xyzw", Temporary(1), "xyzw", Temporary(2),
+                       "xyzw");
+    builder.Arithmetic(OpCode::Id::MOV, Output(2), "xyzw", Temporary(4), "xyzw");
+    builder.Simple(OpCode::Id::END);
+    // 11: never reached, the CALL jumps past it
+    builder.Simple(OpCode::Id::NOP);
+    // 12: the subroutine
+    builder.Arithmetic(OpCode::Id::MUL, DestTemporary(2), "xyzw", FloatUniform(0), "xyzw",
+                       Temporary(0), "xyzw");
+    builder.Arithmetic(OpCode::Id::MOV, Output(0), "xyzw", Temporary(0), "xyzw");
+    // 14: reached when the subroutine is run without CALL
+    builder.Simple(OpCode::Id::END);
+
+    SECTION("unknown uniforms") {
+        const ProgramAnalysis analysis(setup->program_code, setup->swizzle_data,
+                                       MakeSpecialization(0x7));
+        for (unsigned offset : {0, 1, 2, 5, 7, 8, 9, 12, 13}) {
+            INFO("offset " << offset);
+            REQUIRE(analysis.IsReachable(offset));
+            REQUIRE(!analysis.IsDead(offset));
+        }
+        REQUIRE(!analysis.IsReachable(11));
+        REQUIRE(analysis.NumReachable() == 14);
+    }
+
+    SECTION("IF known to be taken") {
+        auto specialization = MakeSpecialization(0x7);
+        specialization.bool_uniform_mask = 1 << 1;
+        specialization.bool_uniforms = 1 << 1;
+        const ProgramAnalysis analysis(setup->program_code, setup->swizzle_data, specialization);
+        // The IF always overwrites r1 before it's read
+        REQUIRE(analysis.IsDead(1));
+        REQUIRE(!analysis.IsDead(5));
+    }
+
+    SECTION("IF known not to be taken") {
+        auto specialization = MakeSpecialization(0x7);
+        specialization.bool_uniform_mask = 1 << 1;
+        const ProgramAnalysis analysis(setup->program_code, setup->swizzle_data, specialization);
+        REQUIRE(!analysis.IsDead(1));
+        REQUIRE(!analysis.IsReachable(5));
+    }
+
+    SECTION("outputs outside of the output vertex") {
+        const ProgramAnalysis analysis(setup->program_code, setup->swizzle_data,
+                                       MakeSpecialization(0x2));
+        // Without o0 and o2, the subroutine and loop only keep the writes o1 depends on
+        REQUIRE(!analysis.IsDead(0));
+        REQUIRE(analysis.IsDead(2));
+        REQUIRE(analysis.IsDead(7));
+        REQUIRE(analysis.IsDead(9));
+        REQUIRE(!analysis.IsDead(12));
+        REQUIRE(analysis.IsDead(13));
+    }
+}
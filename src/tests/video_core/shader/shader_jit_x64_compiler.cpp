@@ -0,0 +1,169 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifdef ARCHITECTURE_x86_64
+
+#include <memory>
+#include <vector>
+#include <catch.hpp>
+#include "tests/video_core/shader/shader_test_common.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter.h"
+#include "video_core/shader/shader_jit_x64.h"
+
+using Pica::float24;
+using Pica::Shader::AttributeBuffer;
+using Pica::Shader::GSUnitState;
+using Pica::Shader::InterpreterEngine;
+using Pica::Shader::JitX64Engine;
+using Pica::Shader::ShaderEngine;
+using Pica::Shader::ShaderSetup;
+using Pica::Shader::UnitState;
+using namespace ShaderTests;
+
+namespace {
+
+/// Runs `inputs` through the scalar JIT one vertex at a time
+std::vector<AttributeBuffer> RunScalar(const JitX64Engine& engine, const ShaderSetup& setup,
+                                       const Pica::ShaderRegs& config,
+                                       const std::vector<AttributeBuffer>& inputs) {
+    std::vector<AttributeBuffer> outputs(inputs.size());
+    UnitState state;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        state.LoadInput(config, inputs[i]);
+        engine.Run(setup, state);
+        state.WriteOutput(config, outputs[i]);
+    }
+    return outputs;
+}
+
+/// Runs `inputs` through the batch JIT, which has to support the program
+std::vector<AttributeBuffer> RunBatch(const JitX64Engine& engine, const ShaderSetup& setup,
+                                      const Pica::ShaderRegs& config,
+                                      const std::vector<AttributeBuffer>& inputs) {
+    REQUIRE(setup.engine_data.cached_batch_shader != nullptr);
+    std::vector<AttributeBuffer> outputs(inputs.size());
+    engine.RunBatch(setup, config, inputs.data(), outputs.data(), inputs.size());
+    return outputs;
+}
+
+/// Primitives emitted by a geometry shader
+struct EmittedPrimitives {
+    std::vector<AttributeBuffer> vertices;
+    /// Number of vertices emitted before each call of the winding setter
+    std::vector<size_t> windings;
+};
+
+EmittedPrimitives RunGeometryShader(ShaderEngine& engine, ShaderSetup& setup,
+                                    const Pica::ShaderRegs& config, const AttributeBuffer& input) {
+    EmittedPrimitives emitted;
+    engine.SetupBatch(setup, 0, config.output_mask);
+
+    GSUnitState state;
+    state.SetVertexHandler(
+        [&emitted](const AttributeBuffer& vertex) { emitted.vertices.push_back(vertex); },
+        [&emitted] { emitted.windings.push_back(emitted.vertices.size()); });
+    state.ConfigOutput(config);
+    state.LoadInput(config, input);
+    engine.Run(setup, state);
+    return emitted;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("JitX64Engine: batch dot products match the scalar JIT",
+          "[video_core][shader][shader_jit]") {
+    auto setup = std::make_unique<ShaderSetup>();
+    ProgramBuilder builder(*setup);
+    builder.Arithmetic(OpCode::Id::DP4, Output(0), "xyzw", Input(0), "xyzw", Input(1), "xyzw");
+    builder.Arithmetic(OpCode::Id::DP3, Output(1), "xyzw", FloatUniform(3), "xyzw", Input(1),
+                       "wzyx");
+    builder.Arithmetic(OpCode::Id::DPH, Output(2), "xyzw", FloatUniform(5), "yxwz", Input(2),
+                       "xyzw");
+    builder.Arithmetic(OpCode::Id::MUL, DestTemporary(0), "xyzw", Input(0), "zwxy", Input(2),
+                       "xyzw");
+    builder.Arithmetic(OpCode::Id::ADD, DestTemporary(0), "yw", FloatUniform(7), "xxyy",
+                       Temporary(0), "xyzw");
+    builder.Arithmetic(OpCode::Id::DP4, Output(3), "xyzw", Temporary(0), "xyzw", Input(1),
+                       "wxzy");
+    builder.Simple(OpCode::Id::END);
+    GenerateUniforms(*setup, 0x5EED0021);
+
+    const auto config = MakeConfig(3, 0xF);
+    JitX64Engine engine;
+    engine.SetupBatch(*setup, 0, config.output_mask);
+
+    SECTION("random inputs") {
+        const auto inputs = GenerateInputs(1024, 0x021);
+        const auto scalar = RunScalar(engine, *setup, config, inputs);
+        const auto batch = RunBatch(engine, *setup, config, inputs);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            INFO("vertex " << i);
+            REQUIRE(SameAttributes(scalar[i], batch[i], 4));
+        }
+    }
+
+    SECTION("sums rounding differently depending on their order") {
+        // (x + y) + (z + w) is 1, while (x + z) + (y + w) would be 2
+        std::vector<AttributeBuffer> inputs = GenerateInputs(4, 0x021);
+        for (auto& input : inputs) {
+            input.attr[0] = {float24::FromFloat32(16777216.0f), float24::FromFloat32(1.0f),
+                             float24::FromFloat32(-16777216.0f), float24::FromFloat32(1.0f)};
+            input.attr[1] = Math::Vec4<float24>::AssignToAll(float24::FromFloat32(1.0f));
+        }
+        const auto scalar = RunScalar(engine, *setup, config, inputs);
+        const auto batch = RunBatch(engine, *setup, config, inputs);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            REQUIRE(scalar[i].attr[0].x.ToFloat32() == 1.0f);
+            REQUIRE(SameAttributes(scalar[i], batch[i], 4));
+        }
+    }
+}
+
+TEST_CASE("JitX64Engine: geometry shaders emit the same primitives as the interpreter",
+          "[video_core][shader][shader_jit]") {
+    auto setup = std::make_unique<ShaderSetup>();
+    ProgramBuilder builder(*setup);
+    builder.SetEmit(0, false, false);
+    builder.Arithmetic(OpCode::Id::MOV, Output(0), "xyzw", Input(0), "xyzw");
+    builder.Arithmetic(OpCode::Id::MOV, Output(1), "xyzw", FloatUniform(0), "xyzw");
+    builder.Simple(OpCode::Id::EMIT);
+    builder.SetEmit(1, false, false);
+    builder.Arithmetic(OpCode::Id::ADD, Output(0), "xyzw", FloatUniform(1), "xyzw", Input(0),
+                       "xyzw");
+    builder.Simple(OpCode::Id::EMIT);
+    // Completes a primitive, and leaves o1 of the previous vertex in place
+    builder.SetEmit(2, true, false);
+    builder.Arithmetic(OpCode::Id::MUL, Output(0), "xyzw", FloatUniform(2), "xyzw", Input(1),
+                       "xyzw");
+    builder.Simple(OpCode::Id::EMIT);
+    // Replaces the first vertex, completing a primitive with the inverted vertex order
+    builder.SetEmit(0, true, true);
+    builder.Arithmetic(OpCode::Id::DP4, Output(0), "xyzw", FloatUniform(3), "xyzw", Input(2),
+                       "xyzw");
+    builder.Arithmetic(OpCode::Id::MOV, Output(1), "xyzw", Input(2), "wzyx");
+    builder.Simple(OpCode::Id::EMIT);
+    builder.Simple(OpCode::Id::END);
+    GenerateUniforms(*setup, 0x5EED0024);
+
+    const auto config = MakeConfig(3, 0x3);
+    const auto input = GenerateInputs(1, 0x024)[0];
+
+    InterpreterEngine interpreter;
+    JitX64Engine jit;
+    auto jit_setup = std::make_unique<ShaderSetup>(*setup);
+    const auto expected = RunGeometryShader(interpreter, *setup, config, input);
+    const auto actual = RunGeometryShader(jit, *jit_setup, config, input);
+
+    REQUIRE(expected.vertices.size() == 6);
+    REQUIRE(expected.windings == std::vector<size_t>{3});
+    REQUIRE(actual.vertices.size() == expected.vertices.size());
+    REQUIRE(actual.windings == expected.windings);
+    for (size_t i = 0; i < expected.vertices.size(); ++i) {
+        INFO("vertex " << i);
+        REQUIRE(SameAttributes(expected.vertices[i], actual.vertices[i], 2));
+    }
+}
+
+#endif // ARCHITECTURE_x86_64
@@ -0,0 +1,153 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "common/assert.h"
+#include "tests/video_core/shader/shader_test_common.h"
+
+namespace ShaderTests {
+
+using Pica::float24;
+using Pica::Shader::AttributeBuffer;
+using Pica::Shader::ShaderSetup;
+
+/// Returns the bits of a destination component mask, where x is the highest one
+static u32 EncodeDestMask(const char* mask) {
+    u32 bits = 0;
+    for (; *mask != '\0'; ++mask) {
+        ASSERT(*mask >= 'w' && *mask <= 'z');
+        bits |= 0x8 >> (*mask == 'w' ? 3 : *mask - 'x');
+    }
+    return bits;
+}
+
+/// Returns the bits of a source swizzle, where the selector of x is the highest one
+static u32 EncodeSwizzle(const char* swizzle) {
+    ASSERT(std::strlen(swizzle) == 4);
+    u32 bits = 0;
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        const char c = swizzle[comp];
+        ASSERT(c >= 'w' && c <= 'z');
+        bits |= (c == 'w' ? 3 : c - 'x') << (2 * (3 - comp));
+    }
+    return bits;
+}
+
+static u32 EncodeOpCode(OpCode::Id op) {
+    return static_cast<u32>(op) << 26;
+}
+
+ProgramBuilder::ProgramBuilder(ShaderSetup& setup) : setup(setup) {
+    setup.program_code.fill(0);
+    setup.swizzle_data.fill(0);
+    for (auto& uniform : setup.uniforms.f)
+        uniform = Math::Vec4<float24>::AssignToAll(float24::Zero());
+    setup.uniforms.b.fill(false);
+    setup.uniforms.i.fill(Math::Vec4<u8>(0, 0, 0, 0));
+}
+
+void ProgramBuilder::Arithmetic(OpCode::Id op, u32 dest, const char* dest_mask, u32 src1,
+                                const char* src1_swizzle, u32 src2, const char* src2_swizzle) {
+    // Only the first source operand can address the uniforms
+    ASSERT(src1 < 0x80 && src2 < 0x20);
+    const u32 descriptor = EncodeDestMask(dest_mask) | EncodeSwizzle(src1_swizzle) << 5 |
+                           EncodeSwizzle(src2_swizzle) << 14;
+    Append(EncodeOpCode(op) | dest << 21 | src1 << 12 | src2 << 7 |
+           AddOperandDescriptor(descriptor));
+}
+
+void ProgramBuilder::Simple(OpCode::Id op) {
+    Append(EncodeOpCode(op));
+}
+
+void ProgramBuilder::UniformFlowControl(OpCode::Id op, unsigned uniform, unsigned dest_offset,
+                                        unsigned num_instructions) {
+    ASSERT(dest_offset < 0x1000 && num_instructions < 0x100);
+    Append(EncodeOpCode(op) | uniform << 22 | dest_offset << 10 | num_instructions);
+}
+
+void ProgramBuilder::SetEmit(unsigned vertex_id, bool prim_emit, bool winding) {
+    Pica::Shader::SetEmitInstruction instr;
+    instr.hex = EncodeOpCode(OpCode::Id::SETEMIT);
+    instr.vertex_id.Assign(vertex_id);
+    instr.prim_emit.Assign(prim_emit);
+    instr.winding.Assign(winding);
+    Append(instr.hex);
+}
+
+void ProgramBuilder::PatchDestOffset(unsigned at, unsigned dest_offset) {
+    ASSERT(at < offset && dest_offset < 0x1000);
+    u32& instruction = setup.program_code[at];
+    instruction = (instruction & ~(0xFFFu << 10)) | dest_offset << 10;
+}
+
+void ProgramBuilder::Append(u32 instruction) {
+    ASSERT(offset < setup.program_code.size());
+    setup.program_code[offset++] = instruction;
+}
+
+u32 ProgramBuilder::AddOperandDescriptor(u32 descriptor) {
+    auto iter = std::find(operand_descriptors.begin(), operand_descriptors.end(), descriptor);
+    if (iter != operand_descriptors.end())
+        return static_cast<u32>(iter - operand_descriptors.begin());
+
+    // Format 1 instructions address the first 128 descriptors
+    ASSERT(operand_descriptors.size() < 0x80);
+    setup.swizzle_data[operand_descriptors.size()] = descriptor;
+    operand_descriptors.push_back(descriptor);
+    return static_cast<u32>(operand_descriptors.size() - 1);
+}
+
+Pica::ShaderRegs MakeConfig(unsigned num_inputs, u32 output_mask) {
+    ASSERT(num_inputs >= 1 && num_inputs <= 16);
+    Pica::ShaderRegs config;
+    std::memset(&config, 0, sizeof(config));
+    config.max_input_attribute_index.Assign(num_inputs - 1);
+    config.input_attribute_to_register_map_low = 0x76543210;
+    config.input_attribute_to_register_map_high = 0xFEDCBA98;
+    config.output_mask.Assign(output_mask);
+    return config;
+}
+
+/// Returns the next value in [-2, 2] of a linear congruential generator
+static float NextValue(u32& seed) {
+    seed = seed * 1664525 + 1013904223;
+    return (seed >> 8) / float(1 << 22) - 2.0f;
+}
+
+std::vector<AttributeBuffer> GenerateInputs(size_t count, u32 seed) {
+    std::vector<AttributeBuffer> inputs(count);
+    for (auto& input : inputs) {
+        for (auto& attr : input.attr) {
+            for (unsigned comp = 0; comp < 4; ++comp)
+                attr[comp] = float24::FromFloat32(NextValue(seed));
+        }
+    }
+    return inputs;
+}
+
+void GenerateUniforms(ShaderSetup& setup, u32 seed) {
+    for (auto& uniform : setup.uniforms.f) {
+        for (unsigned comp = 0; comp < 4; ++comp)
+            uniform[comp] = float24::FromFloat32(NextValue(seed));
+    }
+}
+
+bool SameAttributes(const AttributeBuffer& a, const AttributeBuffer& b, unsigned num_attributes) {
+    for (unsigned attr = 0; attr < num_attributes; ++attr) {
+        for (unsigned comp = 0; comp < 4; ++comp) {
+            const float x = a.attr[attr][comp].ToFloat32();
+            const float y = b.attr[attr][comp].ToFloat32();
+            if (std::isnan(x) && std::isnan(y))
+                continue;
+            if (std::memcmp(&x, &y, sizeof(float)) != 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace ShaderTests
@@ -0,0 +1,93 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include <nihstro/shader_bytecode.h>
+#include "common/common_types.h"
+#include "video_core/regs_shader.h"
+#include "video_core/shader/shader.h"
+
+namespace ShaderTests {
+
+using nihstro::OpCode;
+
+/// Source register operands, in the encoding of the source fields of an instruction
+constexpr u32 Input(u32 index) {
+    return index;
+}
+constexpr u32 Temporary(u32 index) {
+    return 0x10 + index;
+}
+constexpr u32 FloatUniform(u32 index) {
+    return 0x20 + index;
+}
+
+/// Destination register operands, in the encoding of the destination field of an instruction
+constexpr u32 Output(u32 index) {
+    return index;
+}
+constexpr u32 DestTemporary(u32 index) {
+    return 0x10 + index;
+}
+
+/**
+ * Writes a program in the binary encoding of the shader unit to a ShaderSetup, one instruction at
+ * a time. Masks and swizzles are given as strings like "xz" and "wzyx", operand descriptors are
+ * shared between the instructions using the same ones.
+ */
+class ProgramBuilder final {
+public:
+    /// Clears the program, swizzle data and uniforms of `setup`
+    explicit ProgramBuilder(Pica::Shader::ShaderSetup& setup);
+
+    /// Returns the offset the next instruction is written to
+    unsigned Offset() const {
+        return offset;
+    }
+
+    /// Appends an instruction of format 1, such as ADD or DP4. Only `src1` may be a uniform.
+    void Arithmetic(OpCode::Id op, u32 dest, const char* dest_mask, u32 src1,
+                    const char* src1_swizzle, u32 src2 = 0, const char* src2_swizzle = "xyzw");
+
+    /// Appends an instruction without operands, such as NOP, END or EMIT
+    void Simple(OpCode::Id op);
+
+    /**
+     * Appends an instruction of format 3 (CALL, CALLU, IFU, JMPU or LOOP)
+     * @param uniform Index of the boolean or integer uniform tested, ignored by CALL
+     */
+    void UniformFlowControl(OpCode::Id op, unsigned uniform, unsigned dest_offset,
+                            unsigned num_instructions);
+
+    /// Appends a SETEMIT instruction
+    void SetEmit(unsigned vertex_id, bool prim_emit, bool winding);
+
+    /// Changes the destination offset of the flow control instruction at `at`
+    void PatchDestOffset(unsigned at, unsigned dest_offset);
+
+private:
+    void Append(u32 instruction);
+    u32 AddOperandDescriptor(u32 descriptor);
+
+    Pica::Shader::ShaderSetup& setup;
+    unsigned offset = 0;
+    std::vector<u32> operand_descriptors;
+};
+
+/// Returns shader configuration registers mapping input attribute i to input register i
+Pica::ShaderRegs MakeConfig(unsigned num_inputs, u32 output_mask);
+
+/// Returns input vertices with reproducible values in [-2, 2] for the given seed
+std::vector<Pica::Shader::AttributeBuffer> GenerateInputs(size_t count, u32 seed);
+
+/// Fills the float uniforms with reproducible values in [-2, 2] for the given seed
+void GenerateUniforms(Pica::Shader::ShaderSetup& setup, u32 seed);
+
+/// Returns whether two attribute buffers hold the same bits in their first `num_attributes`
+bool SameAttributes(const Pica::Shader::AttributeBuffer& a, const Pica::Shader::AttributeBuffer& b,
+                    unsigned num_attributes);
+
+} // namespace ShaderTests
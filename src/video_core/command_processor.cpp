@@ -2,17 +2,25 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
+#include <cinttypes>
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#include <thread>
 #include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hle/service/gsp_gpu.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
+#include "core/perf_stats.h"
+#include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
@@ -47,6 +55,30 @@ static const u32 expand_bits_to_bytes[] = {
     0xff000000, 0xff0000ff, 0xff00ff00, 0xff00ffff, 0xffff0000, 0xffff00ff, 0xffffff00, 0xffffffff,
 };
 
+static RegisterWriteStats write_stats;
+
+/// Identifies the vertex a post-transform vertex cache entry holds
+struct VertexCacheTag {
+    u32 draw;
+    u32 vertex;
+};
+
+// Post-transform vertex cache of indexed draws, direct-mapped by the vertex index relative to the
+// smallest index of the draw. Entries are only valid for the draw they were written in, so the
+// cache never needs to be cleared.
+static std::vector<Shader::OutputVertex> vertex_cache;
+static std::vector<VertexCacheTag> vertex_cache_tags;
+static u32 vertex_cache_draw = 0;
+
+/// Minimum number of vertices a draw needs for splitting its vertex shading across threads
+constexpr u32 PARALLEL_SHADING_MIN_VERTICES = 512;
+/// Number of vertices a thread shades at a time
+constexpr size_t PARALLEL_SHADING_CHUNK_SIZE = 128;
+/// Number of shaded vertices a draw hands to the primitive assembler at a time
+constexpr size_t ASSEMBLY_BATCH_SIZE = 64;
+
+static std::unique_ptr<Common::ThreadPool> shading_pool;
+
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
 static const char* GetShaderSetupTypeName(Shader::ShaderSetup& setup) {
@@ -119,6 +151,96 @@ static void WriteUniformFloatReg(ShaderRegs& config, Shader::ShaderSetup& setup,
     }
 }
 
+/**
+ * Returns whether the register triggers an action or feeds data into a table when written, in which
+ * case the write matters to the rasterizer even if it leaves the register value unchanged
+ */
+static bool IsDataPortRegister(u32 id) {
+    const auto& regs = g_state.regs;
+    const auto in_array = [id](size_t first, size_t size) {
+        return id >= first && id < first + size / sizeof(u32);
+    };
+
+    return id == PICA_REG_INDEX(trigger_irq) || id == PICA_REG_INDEX(pipeline.trigger_draw) ||
+           id == PICA_REG_INDEX(pipeline.trigger_draw_indexed) ||
+           id == PICA_REG_INDEX(pipeline.restart_primitive) ||
+           in_array(PICA_REG_INDEX(pipeline.command_buffer.trigger),
+                    sizeof(regs.pipeline.command_buffer.trigger)) ||
+           in_array(PICA_REG_INDEX(pipeline.vs_default_attributes_setup.set_value),
+                    sizeof(regs.pipeline.vs_default_attributes_setup.set_value)) ||
+           in_array(PICA_REG_INDEX(texturing.fog_lut_data), sizeof(regs.texturing.fog_lut_data)) ||
+           in_array(PICA_REG_INDEX(texturing.proctex_lut_data),
+                    sizeof(regs.texturing.proctex_lut_data)) ||
+           in_array(PICA_REG_INDEX(lighting.lut_data), sizeof(regs.lighting.lut_data)) ||
+           in_array(PICA_REG_INDEX(gs.uniform_setup.set_value),
+                    sizeof(regs.gs.uniform_setup.set_value)) ||
+           in_array(PICA_REG_INDEX(gs.program.set_word), sizeof(regs.gs.program.set_word)) ||
+           in_array(PICA_REG_INDEX(gs.swizzle_patterns.set_word),
+                    sizeof(regs.gs.swizzle_patterns.set_word)) ||
+           in_array(PICA_REG_INDEX(vs.uniform_setup.set_value),
+                    sizeof(regs.vs.uniform_setup.set_value)) ||
+           in_array(PICA_REG_INDEX(vs.program.set_word), sizeof(regs.vs.program.set_word)) ||
+           in_array(PICA_REG_INDEX(vs.swizzle_patterns.set_word),
+                    sizeof(regs.vs.swizzle_patterns.set_word));
+}
+
+/// Returns the smallest and largest of the given vertex indices
+template <typename T>
+static std::pair<u32, u32> GetIndexRange(const T* indices, u32 count) {
+    const auto range = std::minmax_element(indices, indices + count);
+    return {*range.first, *range.second};
+}
+
+/**
+ * Returns whether the vertex shading of a draw with `num_vertices` vertices may be split across
+ * threads. Shading runs serially whenever the debugger needs to observe individual invocations.
+ */
+static bool CanShadeInParallel(u32 num_vertices) {
+    if (!Settings::values.use_multithreaded_vertex_shading ||
+        num_vertices < PARALLEL_SHADING_MIN_VERTICES) {
+        return false;
+    }
+
+    if (g_debug_context &&
+        (g_debug_context->recorder ||
+         g_debug_context->IsBreakpointEnabled(DebugContext::Event::VertexShaderInvocation))) {
+        return false;
+    }
+
+    if (!shading_pool) {
+        const unsigned num_cores = std::thread::hardware_concurrency();
+        shading_pool = std::make_unique<Common::ThreadPool>(num_cores > 1 ? num_cores - 1 : 0);
+    }
+    return shading_pool->NumThreads() > 1;
+}
+
+/**
+ * Whether a change of the register may change how the rasterizer draws the triangles queued so
+ * far. The vertex pipeline and shader registers only matter until vertices are shaded.
+ */
+static bool AffectsQueuedTriangles(u32 id) {
+    return id < PICA_REG_INDEX(pipeline);
+}
+
+/// Whether the software vertex pipeline may have queued triangles since DrawQueuedTriangles
+static bool triangles_queued = false;
+
+/**
+ * Draws the triangles the software vertex pipeline queued. PICA draws don't end their batch, so
+ * that consecutive draws with the same state go out as one, until a register they depend on
+ * changes or the command list ends. Batches never outlive their command list, as the guest may
+ * change the memory they sample or read back the framebuffer once it has been processed.
+ */
+static void DrawQueuedTriangles() {
+    if (!triangles_queued)
+        return;
+    triangles_queued = false;
+
+    MICROPROFILE_SCOPE(GPU_Drawing);
+    Core::ScopedPerfTimer perf_timer(Core::PerfStats::Category::Drawing);
+    VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+}
+
 static void WritePicaReg(u32 id, u32 value, u32 mask) {
     auto& regs = g_state.regs;
 
@@ -134,7 +256,20 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
     const u32 write_mask = expand_bits_to_bytes[mask];
 
-    regs.reg_array[id] = (old_value & ~write_mask) | (value & write_mask);
+    const u32 new_value = (old_value & ~write_mask) | (value & write_mask);
+
+    // Games commonly rewrite the same state before every draw. Such writes can't change anything
+    // the rasterizer derives from the registers, so don't make it sync that state again.
+    const bool redundant = new_value == old_value && !IsDataPortRegister(id);
+    if (!redundant && AffectsQueuedTriangles(id)) {
+        DrawQueuedTriangles();
+    }
+
+    regs.reg_array[id] = new_value;
+    ++write_stats.writes[id];
+    if (redundant) {
+        ++write_stats.redundant_writes[id];
+    }
 
     // Double check for is_pica_tracing to avoid call overhead
     if (DebugUtils::IsPicaTracing()) {
@@ -148,7 +283,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     switch (id) {
     // Trigger IRQ
     case PICA_REG_INDEX(trigger_irq):
-        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::P3D);
+        GPU::SignalInterrupt(Service::GSP::InterruptId::P3D);
         break;
 
     case PICA_REG_INDEX(pipeline.triangle_topology):
@@ -218,10 +353,12 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     immediate_attribute_id += 1;
                 } else {
                     MICROPROFILE_SCOPE(GPU_Drawing);
+                    Core::ScopedPerfTimer perf_timer(Core::PerfStats::Category::Drawing);
                     immediate_attribute_id = 0;
 
                     auto* shader_engine = Shader::GetEngine();
-                    shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
+                    shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset,
+                                              regs.vs.output_mask);
 
                     // Send to vertex shader
                     if (g_debug_context)
@@ -244,6 +381,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     g_state.primitive_assembler.SubmitVertex(
                         Shader::OutputVertex::FromAttributeBuffer(regs.rasterizer, output),
                         AddTriangle);
+                    triangles_queued = true;
                 }
             }
         }
@@ -252,12 +390,10 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
     case PICA_REG_INDEX(pipeline.gpu_mode):
         if (regs.pipeline.gpu_mode == PipelineRegs::GPUMode::Configuring) {
-            MICROPROFILE_SCOPE(GPU_Drawing);
-
-            // Draw immediate mode triangles when GPU Mode is set to GPUMode::Configuring
-            VideoCore::g_renderer->Rasterizer()->DrawTriangles();
-
+            // The triangles stay queued for the next draw in the command list to add to, see
+            // DrawQueuedTriangles, except for the debugger, which shows the result of each draw
             if (g_debug_context) {
+                DrawQueuedTriangles();
                 g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
             }
         }
@@ -278,6 +414,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(pipeline.trigger_draw):
     case PICA_REG_INDEX(pipeline.trigger_draw_indexed): {
         MICROPROFILE_SCOPE(GPU_Drawing);
+        Core::ScopedPerfTimer perf_timer(Core::PerfStats::Category::Drawing);
 
 #if PICA_LOG_TEV
         DebugUtils::DumpTevStageConfig(regs.GetTevStages());
@@ -294,6 +431,13 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         // Load vertices
         bool is_indexed = (id == PICA_REG_INDEX(pipeline.trigger_draw_indexed));
 
+        // Let the rasterizer run the vertex shader on the GPU if it can. The debugger's recorder
+        // needs the memory accesses of the software path, so it always takes that one.
+        if (VideoCore::g_hw_shader_enabled && !(g_debug_context && g_debug_context->recorder) &&
+            VideoCore::g_renderer->Rasterizer()->AccelerateDrawBatch(is_indexed)) {
+            break;
+        }
+
         const auto& index_info = regs.pipeline.index_array;
         const u8* index_address_8 = Memory::GetPhysicalPointer(base_address + index_info.offset);
         const u16* index_address_16 = reinterpret_cast<const u16*>(index_address_8);
@@ -317,81 +461,151 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         DebugUtils::MemoryAccessTracker memory_accesses;
 
-        // Simple circular-replacement vertex cache
-        // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-        const size_t VERTEX_CACHE_SIZE = 32;
-        std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-        std::array<Shader::OutputVertex, VERTEX_CACHE_SIZE> vertex_cache;
-        Shader::OutputVertex output_vertex;
+        // Size the vertex cache to the index range of the draw, so that it only evicts vertices
+        // if the range exceeds the configured size. Draws shaded in parallel shade every vertex
+        // into the cache up front, which requires the cache to hold all of them.
+        u32 min_index = 0;
+        u32 vertex_cache_size = 0;
+        bool shade_in_parallel = CanShadeInParallel(regs.pipeline.num_vertices);
+        if (is_indexed && regs.pipeline.num_vertices != 0 &&
+            Settings::values.vertex_cache_size > 0) {
+            const auto index_range =
+                index_u16 ? GetIndexRange(index_address_16, regs.pipeline.num_vertices)
+                          : GetIndexRange(index_address_8, regs.pipeline.num_vertices);
+            const u32 index_range_size = index_range.second - index_range.first + 1;
+            min_index = index_range.first;
+            vertex_cache_size = std::min<u32>(
+                index_range_size, static_cast<u32>(Settings::values.vertex_cache_size));
+            shade_in_parallel = shade_in_parallel && vertex_cache_size == index_range_size;
+        } else if (!is_indexed && shade_in_parallel) {
+            min_index = regs.pipeline.vertex_offset;
+            vertex_cache_size = regs.pipeline.num_vertices;
+        } else {
+            shade_in_parallel = false;
+        }
 
-        unsigned int vertex_cache_pos = 0;
-        vertex_cache_ids.fill(-1);
+        if (vertex_cache_size != 0) {
+            if (vertex_cache.size() < vertex_cache_size) {
+                vertex_cache.resize(vertex_cache_size);
+                vertex_cache_tags.resize(vertex_cache_size, {0, 0});
+            }
+            if (++vertex_cache_draw == 0) {
+                // Entries written 2^32 draws ago would look valid again
+                std::fill(vertex_cache_tags.begin(), vertex_cache_tags.end(), VertexCacheTag{0, 0});
+                vertex_cache_draw = 1;
+            }
+        }
+        // Shaded vertices are gathered here and handed to the primitive assembler a batch at a time
+        std::array<Shader::OutputVertex, ASSEMBLY_BATCH_SIZE> assembly_batch;
+        size_t assembly_batch_size = 0;
+        using Pica::Shader::OutputVertex;
+        auto AddTriangle = [rasterizer = VideoCore::g_renderer->Rasterizer()](
+            const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
+            rasterizer->AddTriangle(v0, v1, v2);
+        };
 
         auto* shader_engine = Shader::GetEngine();
         Shader::UnitState shader_unit;
 
-        shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
+        shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset, regs.vs.output_mask);
 
-        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+        auto get_vertex = [&](u32 index) -> u32 {
             // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
+            return is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
+                              : (index + regs.pipeline.vertex_offset);
+        };
+
+        auto shade_vertex = [&](Shader::UnitState& unit, Shader::AttributeBuffer& input) {
+            Shader::AttributeBuffer output{};
+
+            // Send to vertex shader
+            if (g_debug_context)
+                g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                         (void*)&input);
+            unit.LoadInput(regs.vs, input);
+            shader_engine->Run(g_state.vs, unit);
+            unit.WriteOutput(regs.vs, output);
+
+            // Retrieve vertex from register data
+            return Shader::OutputVertex::FromAttributeBuffer(regs.rasterizer, output);
+        };
+
+        if (shade_in_parallel) {
+            // Claim the cache slot of each vertex once, then shade the claimed vertices across
+            // the pool. The loop below finds all of them in the cache.
+            std::vector<u32> unique_vertices;
+            unique_vertices.reserve(regs.pipeline.num_vertices);
+            for (u32 index = 0; index < regs.pipeline.num_vertices; ++index) {
+                const u32 vertex = get_vertex(index);
+                VertexCacheTag& tag = vertex_cache_tags[vertex - min_index];
+                if (tag.draw != vertex_cache_draw) {
+                    tag = {vertex_cache_draw, vertex};
+                    unique_vertices.push_back(vertex);
+                }
+            }
+
+            shading_pool->ParallelFor(
+                unique_vertices.size(), PARALLEL_SHADING_CHUNK_SIZE, [&](size_t begin, size_t end) {
+                    std::array<Shader::AttributeBuffer, PARALLEL_SHADING_CHUNK_SIZE> inputs;
+                    std::array<Shader::AttributeBuffer, PARALLEL_SHADING_CHUNK_SIZE> outputs;
+                    loader.LoadVertices(base_address, &unique_vertices[begin], end - begin,
+                                        inputs.data());
+                    shader_engine->RunBatch(g_state.vs, regs.vs, inputs.data(), outputs.data(),
+                                            end - begin);
+                    for (size_t i = begin; i < end; ++i) {
+                        vertex_cache[unique_vertices[i] - min_index] =
+                            Shader::OutputVertex::FromAttributeBuffer(regs.rasterizer,
+                                                                      outputs[i - begin]);
+                    }
+                });
+        }
+
+        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+            unsigned int vertex = get_vertex(index);
 
             // -1 is a common special value used for primitive restart. Since it's unknown if
             // the PICA supports it, and it would mess up the caching, guard against it here.
             ASSERT(vertex != -1);
 
-            bool vertex_cache_hit = false;
-
-            if (is_indexed) {
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
-                }
+            if (is_indexed && g_debug_context && Pica::g_debug_context->recorder) {
+                int size = index_u16 ? 2 : 1;
+                memory_accesses.AddAccess(base_address + index_info.offset + size * index, size);
+            }
 
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex == vertex_cache_ids[i]) {
-                        output_vertex = vertex_cache[i];
-                        vertex_cache_hit = true;
-                        break;
-                    }
+            Shader::OutputVertex& output_vertex = assembly_batch[assembly_batch_size++];
+            bool vertex_cache_hit = false;
+            const u32 vertex_cache_slot =
+                vertex_cache_size != 0 ? (vertex - min_index) % vertex_cache_size : 0;
+
+            if (vertex_cache_size != 0) {
+                const VertexCacheTag& tag = vertex_cache_tags[vertex_cache_slot];
+                if (tag.draw == vertex_cache_draw && tag.vertex == vertex) {
+                    output_vertex = vertex_cache[vertex_cache_slot];
+                    vertex_cache_hit = true;
                 }
             }
 
             if (!vertex_cache_hit) {
                 // Initialize data for the current vertex
-                Shader::AttributeBuffer input, output{};
+                Shader::AttributeBuffer input;
                 loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+                output_vertex = shade_vertex(shader_unit, input);
 
-                // Send to vertex shader
-                if (g_debug_context)
-                    g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
-                                             (void*)&input);
-                shader_unit.LoadInput(regs.vs, input);
-                shader_engine->Run(g_state.vs, shader_unit);
-                shader_unit.WriteOutput(regs.vs, output);
-
-                // Retrieve vertex from register data
-                output_vertex = Shader::OutputVertex::FromAttributeBuffer(regs.rasterizer, output);
-
-                if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = output_vertex;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                if (vertex_cache_size != 0) {
+                    vertex_cache[vertex_cache_slot] = output_vertex;
+                    vertex_cache_tags[vertex_cache_slot] = {vertex_cache_draw, vertex};
                 }
             }
 
             // Send to renderer
-            using Pica::Shader::OutputVertex;
-            auto AddTriangle = [](const OutputVertex& v0, const OutputVertex& v1,
-                                  const OutputVertex& v2) {
-                VideoCore::g_renderer->Rasterizer()->AddTriangle(v0, v1, v2);
-            };
-
-            primitive_assembler.SubmitVertex(output_vertex, AddTriangle);
+            if (assembly_batch_size == assembly_batch.size()) {
+                primitive_assembler.SubmitVertices(assembly_batch.data(), assembly_batch_size,
+                                                   AddTriangle);
+                assembly_batch_size = 0;
+            }
         }
+        primitive_assembler.SubmitVertices(assembly_batch.data(), assembly_batch_size, AddTriangle);
+        triangles_queued = true;
 
         for (auto& range : memory_accesses.ranges) {
             g_debug_context->recorder->MemoryAccessed(Memory::GetPhysicalPointer(range.first),
@@ -551,6 +765,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         ASSERT_MSG(lut_config.index < 256, "lut_config.index exceeded maximum value of 255!");
 
         g_state.lighting.luts[lut_config.type][lut_config.index].raw = value;
+        g_state.lighting.luts_dirty[lut_config.type].Mark(lut_config.index);
         lut_config.index.Assign(lut_config.index + 1);
         break;
     }
@@ -564,6 +779,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX_WORKAROUND(texturing.fog_lut_data[6], 0xee):
     case PICA_REG_INDEX_WORKAROUND(texturing.fog_lut_data[7], 0xef): {
         g_state.fog.lut[regs.texturing.fog_lut_offset % 128].raw = value;
+        g_state.fog.lut_dirty.Mark(regs.texturing.fog_lut_offset % 128);
         regs.texturing.fog_lut_offset.Assign(regs.texturing.fog_lut_offset + 1);
         break;
     }
@@ -582,18 +798,23 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         switch (regs.texturing.proctex_lut_config.ref_table.Value()) {
         case TexturingRegs::ProcTexLutTable::Noise:
             pt.noise_table[index % pt.noise_table.size()].raw = value;
+            pt.noise_table_dirty.Mark(index % pt.noise_table.size());
             break;
         case TexturingRegs::ProcTexLutTable::ColorMap:
             pt.color_map_table[index % pt.color_map_table.size()].raw = value;
+            pt.color_map_table_dirty.Mark(index % pt.color_map_table.size());
             break;
         case TexturingRegs::ProcTexLutTable::AlphaMap:
             pt.alpha_map_table[index % pt.alpha_map_table.size()].raw = value;
+            pt.alpha_map_table_dirty.Mark(index % pt.alpha_map_table.size());
             break;
         case TexturingRegs::ProcTexLutTable::Color:
             pt.color_table[index % pt.color_table.size()].raw = value;
+            pt.color_table_dirty.Mark(index % pt.color_table.size());
             break;
         case TexturingRegs::ProcTexLutTable::ColorDiff:
             pt.color_diff_table[index % pt.color_diff_table.size()].raw = value;
+            pt.color_diff_table_dirty.Mark(index % pt.color_diff_table.size());
             break;
         }
         index.Assign(index + 1);
@@ -603,13 +824,224 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         break;
     }
 
-    VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    if (!redundant) {
+        VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    }
 
     if (g_debug_context)
         g_debug_context->OnEvent(DebugContext::Event::PicaCommandProcessed,
                                  reinterpret_cast<void*>(&id));
 }
 
+/// Data port registers whose consecutive writes ProcessCommandList handles in bulk
+enum class DataPort {
+    None,
+    VSFloatUniform,
+    GSFloatUniform,
+    VSProgram,
+    GSProgram,
+    VSSwizzle,
+    GSSwizzle,
+    LightingLut,
+    FogLut,
+    ProcTexLut,
+};
+
+/// Returns the data port `id` belongs to, along with the range of registers aliasing that port
+static DataPort GetDataPort(u32 id, u32& first_id, u32& num_ids) {
+    const auto& regs = g_state.regs;
+    const auto in_array = [id, &first_id, &num_ids](size_t first, size_t size) {
+        if (id < first || id >= first + size / sizeof(u32))
+            return false;
+        first_id = static_cast<u32>(first);
+        num_ids = static_cast<u32>(size / sizeof(u32));
+        return true;
+    };
+
+    if (in_array(PICA_REG_INDEX(vs.uniform_setup.set_value),
+                 sizeof(regs.vs.uniform_setup.set_value)))
+        return DataPort::VSFloatUniform;
+    if (in_array(PICA_REG_INDEX(gs.uniform_setup.set_value),
+                 sizeof(regs.gs.uniform_setup.set_value)))
+        return DataPort::GSFloatUniform;
+    if (in_array(PICA_REG_INDEX(vs.program.set_word), sizeof(regs.vs.program.set_word)))
+        return DataPort::VSProgram;
+    if (in_array(PICA_REG_INDEX(gs.program.set_word), sizeof(regs.gs.program.set_word)))
+        return DataPort::GSProgram;
+    if (in_array(PICA_REG_INDEX(vs.swizzle_patterns.set_word),
+                 sizeof(regs.vs.swizzle_patterns.set_word)))
+        return DataPort::VSSwizzle;
+    if (in_array(PICA_REG_INDEX(gs.swizzle_patterns.set_word),
+                 sizeof(regs.gs.swizzle_patterns.set_word)))
+        return DataPort::GSSwizzle;
+    if (in_array(PICA_REG_INDEX(lighting.lut_data), sizeof(regs.lighting.lut_data)))
+        return DataPort::LightingLut;
+    if (in_array(PICA_REG_INDEX(texturing.fog_lut_data), sizeof(regs.texturing.fog_lut_data)))
+        return DataPort::FogLut;
+    if (in_array(PICA_REG_INDEX(texturing.proctex_lut_data),
+                 sizeof(regs.texturing.proctex_lut_data)))
+        return DataPort::ProcTexLut;
+    return DataPort::None;
+}
+
+/**
+ * Copies a run of words written to a shader program or swizzle data port, with the same offset
+ * handling as writing them one at a time
+ */
+static void WriteShaderWords(u32& offset, u32* dest, u32* mirror, u32 limit, const u32* values,
+                             u32 count, const char* name) {
+    const u32 num_valid = offset < limit ? std::min(count, limit - offset) : 0;
+    std::copy(values, values + num_valid, dest + offset);
+    if (mirror)
+        std::copy(values, values + num_valid, mirror + offset);
+    offset += num_valid;
+
+    if (num_valid < count)
+        LOG_ERROR(HW_GPU, "Invalid %s offset %u, dropped %u words", name, offset,
+                  count - num_valid);
+}
+
+/**
+ * Applies the extra data words of a command writing them all to the same data port, bypassing the
+ * per-word bookkeeping of WritePicaReg. Consecutive uniform, shader and LUT uploads are by far the
+ * largest share of the words in a command list.
+ * @return false if the run has to go through WritePicaReg one word at a time
+ */
+static bool WriteDataPortRun(const CommandHeader& header, const u32* values) {
+    const u32 count = header.extra_data_length;
+    const u32 first_cmd = header.cmd_id + (header.group_commands ? 1 : 0);
+    const u32 last_cmd = header.cmd_id + (header.group_commands ? count : 0);
+
+    // Partial writes and debugging tools observing individual writes take the slow path
+    if (header.parameter_mask != 0xF || DebugUtils::IsPicaTracing())
+        return false;
+    if (g_debug_context &&
+        (g_debug_context->IsBreakpointEnabled(DebugContext::Event::PicaCommandLoaded) ||
+         g_debug_context->IsBreakpointEnabled(DebugContext::Event::PicaCommandProcessed)))
+        return false;
+
+    u32 first_id;
+    u32 num_ids;
+    const DataPort port = GetDataPort(first_cmd, first_id, num_ids);
+    if (port == DataPort::None || last_cmd >= first_id + num_ids)
+        return false;
+
+    auto& regs = g_state.regs;
+    const bool mirror_to_gs = !regs.pipeline.gs_unit_exclusive_configuration;
+
+    if (AffectsQueuedTriangles(first_cmd)) {
+        DrawQueuedTriangles();
+    }
+
+    switch (port) {
+    case DataPort::VSFloatUniform:
+        for (u32 i = 0; i < count; ++i)
+            WriteUniformFloatReg(regs.vs, g_state.vs, vs_float_regs_counter,
+                                 vs_uniform_write_buffer, values[i]);
+        break;
+
+    case DataPort::GSFloatUniform:
+        for (u32 i = 0; i < count; ++i)
+            WriteUniformFloatReg(regs.gs, g_state.gs, gs_float_regs_counter,
+                                 gs_uniform_write_buffer, values[i]);
+        break;
+
+    case DataPort::VSProgram:
+        WriteShaderWords(regs.vs.program.offset, g_state.vs.program_code.data(),
+                         mirror_to_gs ? g_state.gs.program_code.data() : nullptr, 512, values,
+                         count, "VS program");
+        break;
+
+    case DataPort::GSProgram:
+        WriteShaderWords(regs.gs.program.offset, g_state.gs.program_code.data(), nullptr, 4096,
+                         values, count, "GS program");
+        break;
+
+    case DataPort::VSSwizzle:
+        WriteShaderWords(regs.vs.swizzle_patterns.offset, g_state.vs.swizzle_data.data(),
+                         mirror_to_gs ? g_state.gs.swizzle_data.data() : nullptr,
+                         static_cast<u32>(g_state.vs.swizzle_data.size()), values, count,
+                         "VS swizzle pattern");
+        break;
+
+    case DataPort::GSSwizzle:
+        WriteShaderWords(regs.gs.swizzle_patterns.offset, g_state.gs.swizzle_data.data(), nullptr,
+                         static_cast<u32>(g_state.gs.swizzle_data.size()), values, count,
+                         "GS swizzle pattern");
+        break;
+
+    case DataPort::LightingLut: {
+        auto& lut_config = regs.lighting.lut_config;
+        auto& lut = g_state.lighting.luts[lut_config.type];
+        auto& lut_dirty = g_state.lighting.luts_dirty[lut_config.type];
+        for (u32 i = 0; i < count; ++i) {
+            ASSERT_MSG(lut_config.index < 256, "lut_config.index exceeded maximum value of 255!");
+
+            lut[lut_config.index].raw = values[i];
+            lut_dirty.Mark(lut_config.index);
+            lut_config.index.Assign(lut_config.index + 1);
+        }
+        break;
+    }
+
+    case DataPort::FogLut:
+        for (u32 i = 0; i < count; ++i) {
+            g_state.fog.lut[regs.texturing.fog_lut_offset % 128].raw = values[i];
+            g_state.fog.lut_dirty.Mark(regs.texturing.fog_lut_offset % 128);
+            regs.texturing.fog_lut_offset.Assign(regs.texturing.fog_lut_offset + 1);
+        }
+        break;
+
+    case DataPort::ProcTexLut: {
+        const auto write_table = [count, values](auto& table, LutDirtyRange& dirty) {
+            auto& index = g_state.regs.texturing.proctex_lut_config.index;
+            for (u32 i = 0; i < count; ++i) {
+                table[index % table.size()].raw = values[i];
+                dirty.Mark(index % table.size());
+                index.Assign(index + 1);
+            }
+        };
+
+        auto& pt = g_state.proctex;
+        switch (regs.texturing.proctex_lut_config.ref_table.Value()) {
+        case TexturingRegs::ProcTexLutTable::Noise:
+            write_table(pt.noise_table, pt.noise_table_dirty);
+            break;
+        case TexturingRegs::ProcTexLutTable::ColorMap:
+            write_table(pt.color_map_table, pt.color_map_table_dirty);
+            break;
+        case TexturingRegs::ProcTexLutTable::AlphaMap:
+            write_table(pt.alpha_map_table, pt.alpha_map_table_dirty);
+            break;
+        case TexturingRegs::ProcTexLutTable::Color:
+            write_table(pt.color_table, pt.color_table_dirty);
+            break;
+        case TexturingRegs::ProcTexLutTable::ColorDiff:
+            write_table(pt.color_diff_table, pt.color_diff_table_dirty);
+            break;
+        default:
+            // Unknown tables drop the data but still advance the index
+            auto& index = regs.texturing.proctex_lut_config.index;
+            index.Assign(index + count);
+            break;
+        }
+        break;
+    }
+
+    default:
+        UNREACHABLE();
+    }
+
+    // Leave the registers and statistics as if the words had been written one at a time. Writes
+    // to data ports are never redundant, and the rasterizer only marks state dirty in response.
+    for (u32 cmd = first_cmd; cmd <= last_cmd; ++cmd) {
+        regs.reg_array[cmd] = values[header.group_commands ? cmd - first_cmd : count - 1];
+        write_stats.writes[cmd] += header.group_commands ? 1 : count;
+        VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(cmd);
+    }
+    return true;
+}
+
 void ProcessCommandList(const u32* list, u32 size) {
     g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = list;
     g_state.cmd_list.length = size / sizeof(u32);
@@ -625,11 +1057,52 @@ void ProcessCommandList(const u32* list, u32 size) {
 
         WritePicaReg(header.cmd_id, value, header.parameter_mask);
 
+        if (header.extra_data_length != 0 &&
+            WriteDataPortRun(header, g_state.cmd_list.current_ptr)) {
+            g_state.cmd_list.current_ptr += header.extra_data_length;
+            continue;
+        }
+
         for (unsigned i = 0; i < header.extra_data_length; ++i) {
             u32 cmd = header.cmd_id + (header.group_commands ? i + 1 : 0);
             WritePicaReg(cmd, *g_state.cmd_list.current_ptr++, header.parameter_mask);
         }
     }
+
+    DrawQueuedTriangles();
+}
+
+const RegisterWriteStats& GetRegisterWriteStats() {
+    return write_stats;
+}
+
+void ShutdownShadingThreads() {
+    shading_pool.reset();
+}
+
+void ResetRegisterWriteStats() {
+    std::memset(&write_stats, 0, sizeof(write_stats));
+}
+
+void LogRegisterWriteStats(size_t count) {
+    std::vector<u32> ids;
+    for (u32 id = 0; id < Regs::NUM_REGS; ++id) {
+        if (write_stats.redundant_writes[id] != 0) {
+            ids.push_back(id);
+        }
+    }
+
+    count = std::min(count, ids.size());
+    std::partial_sort(ids.begin(), ids.begin() + count, ids.end(), [](u32 a, u32 b) {
+        return write_stats.redundant_writes[a] > write_stats.redundant_writes[b];
+    });
+
+    for (size_t i = 0; i < count; ++i) {
+        const u32 id = ids[i];
+        LOG_DEBUG(HW_GPU, "Register 0x%03X %s: %" PRIu64 " of %" PRIu64 " writes redundant", id,
+                  Regs::GetRegisterName(static_cast<u16>(id)), write_stats.redundant_writes[id],
+                  write_stats.writes[id]);
+    }
 }
 
 } // namespace
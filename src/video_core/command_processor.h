@@ -4,9 +4,12 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <type_traits>
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "video_core/regs.h"
 
 namespace Pica {
 
@@ -34,8 +37,29 @@ static_assert(std::is_standard_layout<CommandHeader>::value == true,
               "CommandHeader does not use standard layout");
 static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect size!");
 
+/// Per-register write counters, used to find the registers games keep rewriting
+struct RegisterWriteStats {
+    /// Number of writes to each register
+    std::array<u64, Regs::NUM_REGS> writes;
+    /// Number of writes that left the register value unchanged and weren't forwarded to the
+    /// rasterizer
+    std::array<u64, Regs::NUM_REGS> redundant_writes;
+};
+
 void ProcessCommandList(const u32* list, u32 size);
 
+/// Stops the threads the vertex shading of large draws is split across
+void ShutdownShadingThreads();
+
+/// Returns the register write counters accumulated since the last reset
+const RegisterWriteStats& GetRegisterWriteStats();
+
+/// Clears the register write counters
+void ResetRegisterWriteStats();
+
+/// Logs the `count` registers with the most redundant writes since the last reset
+void LogRegisterWriteStats(size_t count);
+
 } // namespace
 
 } // namespace
@@ -11,6 +11,7 @@
 #include <mutex>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #ifdef HAVE_PNG
 #include <png.h>
@@ -391,15 +392,18 @@ void DumpTexture(const TexturingRegs::TextureConfig& texture_config, u8* data) {
 
     png_write_info(png_ptr, info_ptr);
 
+    Pica::Texture::TextureInfo info;
+    info.width = texture_config.width;
+    info.height = texture_config.height;
+    info.stride = row_stride;
+    info.format = g_state.regs.texturing.texture0_format;
+    std::vector<Math::Vec4<u8>> texels(info.width * info.height);
+    Pica::Texture::DecodeTexture(data, info, texels.data(), info.width);
+
     buf = new u8[row_stride * texture_config.height];
     for (unsigned y = 0; y < texture_config.height; ++y) {
         for (unsigned x = 0; x < texture_config.width; ++x) {
-            Pica::Texture::TextureInfo info;
-            info.width = texture_config.width;
-            info.height = texture_config.height;
-            info.stride = row_stride;
-            info.format = g_state.regs.texturing.texture0_format;
-            Math::Vec4<u8> texture_color = Pica::Texture::LookupTexture(data, x, y, info);
+            const Math::Vec4<u8>& texture_color = texels[y * info.width + x];
             buf[3 * x + y * row_stride] = texture_color.r();
             buf[3 * x + y * row_stride + 1] = texture_color.g();
             buf[3 * x + y * row_stride + 2] = texture_color.b();
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <condition_variable>
 #include <iterator>
 #include <list>
@@ -103,13 +104,6 @@ public:
         std::weak_ptr<DebugContext> context_weak;
     };
 
-    /**
-     * Simple structure defining a breakpoint state
-     */
-    struct BreakPoint {
-        bool enabled = false;
-    };
-
     /**
      * Static constructor used to create a shared_ptr of a DebugContext.
      */
@@ -127,8 +121,9 @@ public:
      * Resume() is called.
      */
     void OnEvent(Event event, void* data) {
-        // This check is left in the header to allow the compiler to inline it.
-        if (!breakpoints[(int)event].enabled)
+        // This check is left in the header to allow the compiler to inline it. While no breakpoint
+        // is enabled, it's all that events cost.
+        if (!IsBreakpointEnabled(event))
             return;
         // For the rest of event handling, call a separate function.
         DoOnEvent(event, data);
@@ -147,14 +142,25 @@ public:
      * Delete all set breakpoints and resume emulation.
      */
     void ClearBreakpoints() {
-        for (auto& bp : breakpoints) {
-            bp.enabled = false;
-        }
+        enabled_breakpoints = 0;
         Resume();
     }
 
+    /// Whether the breakpoint of an event is enabled. Safe to call from any thread.
+    bool IsBreakpointEnabled(Event event) const {
+        return (enabled_breakpoints.load(std::memory_order_relaxed) & (1u << (int)event)) != 0;
+    }
+
+    /// Enables or disables the breakpoint of an event. Safe to call from any thread.
+    void SetBreakpointEnabled(Event event, bool enabled) {
+        if (enabled) {
+            enabled_breakpoints |= 1u << (int)event;
+        } else {
+            enabled_breakpoints &= ~(1u << (int)event);
+        }
+    }
+
     // TODO: Evaluate if access to these members should be hidden behind a public interface.
-    std::array<BreakPoint, (int)Event::NumEvents> breakpoints;
     Event active_breakpoint;
     bool at_breakpoint = false;
 
@@ -167,6 +173,10 @@ private:
      */
     DebugContext() = default;
 
+    static_assert((int)Event::NumEvents <= 32, "Breakpoints don't fit in the mask");
+    /// Bit mask of the events whose breakpoints are enabled, checked by every event
+    std::atomic<u32> enabled_breakpoints{0};
+
     /// Mutex protecting current breakpoint state and the observer list.
     std::mutex breakpoint_mutex;
 
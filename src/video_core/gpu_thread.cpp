@@ -0,0 +1,101 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/microprofile.h"
+#include "core/memory.h"
+#include "video_core/gpu_thread.h"
+
+namespace VideoCore {
+
+std::unique_ptr<GPUThread> g_gpu_thread;
+
+GPUThread::GPUThread(std::unique_ptr<EmuWindow::GraphicsContext> context)
+    : context(std::move(context)) {
+    thread = std::thread(&GPUThread::WorkerLoop, this);
+}
+
+GPUThread::~GPUThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    work_available.notify_one();
+    thread.join();
+}
+
+u64 GPUThread::Push(std::function<void()> work) {
+    u64 fence;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fence = ++last_fence;
+        queue.emplace_back(fence, std::move(work));
+    }
+    work_available.notify_one();
+    return fence;
+}
+
+void GPUThread::WaitForFence(u64 fence) {
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [this, fence] { return completed_fence >= fence; });
+}
+
+void GPUThread::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [this] { return completed_fence >= last_fence; });
+}
+
+void GPUThread::WorkerLoop() {
+    MicroProfileOnThreadCreate("GPUThread");
+
+    if (context != nullptr) {
+        context->MakeCurrent();
+    }
+
+    while (true) {
+        std::function<void()> work;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_available.wait(lock, [this] { return stop || !queue.empty(); });
+            if (queue.empty()) {
+                break;
+            }
+            current_fence = queue.front().first;
+            work = std::move(queue.front().second);
+            queue.pop_front();
+        }
+
+        work();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            completed_fence = current_fence;
+        }
+        work_done.notify_all();
+    }
+
+    if (context != nullptr) {
+        context->DoneCurrent();
+    }
+}
+
+void SynchronizeGPUThread() {
+    if (g_gpu_thread != nullptr && !g_gpu_thread->IsGPUThread()) {
+        g_gpu_thread->WaitIdle();
+        Memory::RasterizerApplyQueuedMarks();
+    }
+}
+
+void RunOnRasterizerThread(const std::function<void()>& work) {
+    if (g_gpu_thread == nullptr || g_gpu_thread->IsGPUThread()) {
+        work();
+    } else if (g_gpu_thread->HasContext()) {
+        g_gpu_thread->WaitForFence(g_gpu_thread->Push(work));
+        Memory::RasterizerApplyQueuedMarks();
+    } else {
+        g_gpu_thread->WaitIdle();
+        work();
+    }
+}
+
+} // namespace VideoCore
@@ -0,0 +1,96 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "core/frontend/emu_window.h"
+
+namespace VideoCore {
+
+/**
+ * Runs the work of the emulated GPU (command lists, memory fills and display transfers) on a
+ * dedicated thread, so that it overlaps with the emulation of the CPU. Work runs in the order it
+ * was queued, and is identified by a fence the emulation thread can wait for.
+ *
+ * Given a context sharing objects with the window's one, the thread keeps it current and the
+ * OpenGL rasterizer lives on it, so the GL calls of emulated draws are made there as well. Objects
+ * that aren't shared between contexts (vertex arrays, framebuffers) then only exist on this thread.
+ */
+class GPUThread : NonCopyable {
+public:
+    /// @param context Context for the thread to make current, or nullptr for none
+    explicit GPUThread(std::unique_ptr<EmuWindow::GraphicsContext> context = nullptr);
+
+    /// Runs the remaining queued work before stopping the thread
+    ~GPUThread();
+
+    /// Queues work for the thread, returning its fence
+    u64 Push(std::function<void()> work);
+
+    /// Waits until the work with the given fence and all work queued before it is done
+    void WaitForFence(u64 fence);
+
+    /// Waits until all queued work is done
+    void WaitIdle();
+
+    /// Whether the calling thread is the GPU thread
+    bool IsGPUThread() const {
+        return std::this_thread::get_id() == thread.get_id();
+    }
+
+    /// Fence of the work currently running, only meaningful on the GPU thread
+    u64 CurrentFence() const {
+        return current_fence;
+    }
+
+    /// Whether the thread has a context, and so runs the OpenGL rasterizer
+    bool HasContext() const {
+        return context != nullptr;
+    }
+
+private:
+    void WorkerLoop();
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+    std::deque<std::pair<u64, std::function<void()>>> queue;
+    /// Fence of the last queued work
+    u64 last_fence = 0;
+    /// Fence of the last finished work
+    u64 completed_fence = 0;
+    u64 current_fence = 0;
+    bool stop = false;
+
+    std::unique_ptr<EmuWindow::GraphicsContext> context;
+    std::thread thread;
+};
+
+/// GPU thread, or nullptr if GPU work runs on the emulation thread
+extern std::unique_ptr<GPUThread> g_gpu_thread;
+
+/**
+ * Waits for the GPU thread to finish all queued work, unless there is no GPU thread or it's the
+ * caller. Needed before the emulation thread touches anything the GPU work uses. Applies the page
+ * table changes the GPU work queued, see Memory::RasterizerApplyQueuedMarks.
+ */
+void SynchronizeGPUThread();
+
+/**
+ * Runs work that uses the rasterizer once all queued GPU work is done, and waits for it. The work
+ * runs on the GPU thread if it has a context, as the OpenGL rasterizer lives there then, and on
+ * the caller otherwise.
+ */
+void RunOnRasterizerThread(const std::function<void()>& work);
+
+} // namespace VideoCore
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include "video_core/command_processor.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs_pipeline.h"
@@ -13,9 +14,13 @@ State g_state;
 
 void Init() {
     g_state.Reset();
+    CommandProcessor::ResetRegisterWriteStats();
+    Shader::Init();
 }
 
 void Shutdown() {
+    CommandProcessor::LogRegisterWriteStats(16);
+    CommandProcessor::ShutdownShadingThreads();
     Shader::Shutdown();
 }
 
@@ -32,4 +37,21 @@ void State::Reset() {
     Zero(immediate);
     primitive_assembler.Reconfigure(PipelineRegs::TriangleTopology::List);
 }
+
+template <typename Table>
+static void MarkDirty(const Table& table, LutDirtyRange& range) {
+    range.begin = 0;
+    range.end = static_cast<u32>(table.size());
+}
+
+void State::MarkLutsDirty() {
+    for (size_t i = 0; i < lighting.luts.size(); ++i)
+        MarkDirty(lighting.luts[i], lighting.luts_dirty[i]);
+    MarkDirty(fog.lut, fog.lut_dirty);
+    MarkDirty(proctex.noise_table, proctex.noise_table_dirty);
+    MarkDirty(proctex.color_map_table, proctex.color_map_table_dirty);
+    MarkDirty(proctex.alpha_map_table, proctex.alpha_map_table_dirty);
+    MarkDirty(proctex.color_table, proctex.color_table_dirty);
+    MarkDirty(proctex.color_diff_table, proctex.color_diff_table_dirty);
+}
 }
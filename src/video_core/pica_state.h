@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include "common/bit_field.h"
 #include "common/common_types.h"
@@ -14,10 +15,31 @@
 
 namespace Pica {
 
+/**
+ * Entries of a lookup table written since the renderer last took them, as the smallest range
+ * covering all of them. Lets the hardware renderer convert only what a command list changed.
+ */
+struct LutDirtyRange {
+    u32 begin = 0;
+    u32 end = 0;
+
+    void Mark(u32 index) {
+        begin = IsEmpty() ? index : std::min(begin, index);
+        end = std::max(end, index + 1);
+    }
+
+    bool IsEmpty() const {
+        return begin >= end;
+    }
+};
+
 /// Struct used to describe current Pica state
 struct State {
     void Reset();
 
+    /// Marks every entry of the lookup tables as written, for renderers that have yet to take any
+    void MarkLutsDirty();
+
     /// Pica registers
     Regs regs;
 
@@ -77,6 +99,12 @@ struct State {
         std::array<ValueEntry, 128> alpha_map_table;
         std::array<ColorEntry, 256> color_table;
         std::array<ColorDifferenceEntry, 256> color_diff_table;
+
+        LutDirtyRange noise_table_dirty;
+        LutDirtyRange color_map_table_dirty;
+        LutDirtyRange alpha_map_table_dirty;
+        LutDirtyRange color_table_dirty;
+        LutDirtyRange color_diff_table_dirty;
     } proctex;
 
     struct Lighting {
@@ -102,9 +130,10 @@ struct State {
         };
 
         std::array<std::array<LutEntry, 256>, 24> luts;
+        std::array<LutDirtyRange, 24> luts_dirty;
     } lighting;
 
-    struct {
+    struct Fog {
         union LutEntry {
             // Used for raw access
             u32 raw;
@@ -122,6 +151,7 @@ struct State {
         };
 
         std::array<LutEntry, 128> lut;
+        LutDirtyRange lut_dirty;
     } fog;
 
     /// Current Pica command list
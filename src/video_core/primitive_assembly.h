@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <functional>
+#include <cstddef>
 #include "video_core/regs_pipeline.h"
 
 namespace Pica {
@@ -12,12 +12,13 @@ namespace Pica {
 /*
  * Utility class to build triangles from a series of vertices,
  * according to a given triangle topology.
+ *
+ * Triangles are passed to a handler of any type callable as
+ * handler(const VertexType& v0, const VertexType& v1, const VertexType& v2), which is a template
+ * parameter rather than a std::function, so that it can be inlined into the assembly loops.
  */
 template <typename VertexType>
 struct PrimitiveAssembler {
-    using TriangleHandler =
-        std::function<void(const VertexType& v0, const VertexType& v1, const VertexType& v2)>;
-
     PrimitiveAssembler(
         PipelineRegs::TriangleTopology topology = PipelineRegs::TriangleTopology::List);
 
@@ -27,7 +28,17 @@ struct PrimitiveAssembler {
      * NOTE: We could specify the triangle handler in the constructor, but this way we can
      * keep event and handler code next to each other.
      */
-    void SubmitVertex(const VertexType& vtx, TriangleHandler triangle_handler);
+    template <typename TriangleHandler>
+    void SubmitVertex(const VertexType& vtx, TriangleHandler&& triangle_handler);
+
+    /**
+     * Does the same as calling SubmitVertex on each of the vertices in turn, but passes the
+     * triangles made of vertices of the array straight to the handler, without going through the
+     * vertex queue. Continues from, and leaves, the same state as SubmitVertex would.
+     */
+    template <typename TriangleHandler>
+    void SubmitVertices(const VertexType* vertices, size_t count,
+                        TriangleHandler&& triangle_handler);
 
     /**
      * Resets the internal state of the PrimitiveAssembler.
@@ -47,4 +58,95 @@ private:
     bool strip_ready = false;
 };
 
+template <typename VertexType>
+template <typename TriangleHandler>
+void PrimitiveAssembler<VertexType>::SubmitVertex(const VertexType& vtx,
+                                                  TriangleHandler&& triangle_handler) {
+    switch (topology) {
+    // TODO: Figure out what's different with TriangleTopology::Shader.
+    case PipelineRegs::TriangleTopology::List:
+    case PipelineRegs::TriangleTopology::Shader:
+        if (buffer_index < 2) {
+            buffer[buffer_index++] = vtx;
+        } else {
+            buffer_index = 0;
+
+            triangle_handler(buffer[0], buffer[1], vtx);
+        }
+        break;
+
+    case PipelineRegs::TriangleTopology::Strip:
+    case PipelineRegs::TriangleTopology::Fan:
+        if (strip_ready)
+            triangle_handler(buffer[0], buffer[1], vtx);
+
+        buffer[buffer_index] = vtx;
+
+        strip_ready |= (buffer_index == 1);
+
+        if (topology == PipelineRegs::TriangleTopology::Strip)
+            buffer_index = !buffer_index;
+        else if (topology == PipelineRegs::TriangleTopology::Fan)
+            buffer_index = 1;
+        break;
+    }
+}
+
+template <typename VertexType>
+template <typename TriangleHandler>
+void PrimitiveAssembler<VertexType>::SubmitVertices(const VertexType* vertices, size_t count,
+                                                    TriangleHandler&& triangle_handler) {
+    size_t i = 0;
+
+    switch (topology) {
+    case PipelineRegs::TriangleTopology::List:
+    case PipelineRegs::TriangleTopology::Shader:
+        // Complete the triangle started by earlier vertices, then take whole triangles from the
+        // array, queueing the vertices of the last one if it is incomplete
+        for (; buffer_index != 0 && i < count; ++i)
+            SubmitVertex(vertices[i], triangle_handler);
+        for (; i + 3 <= count; i += 3)
+            triangle_handler(vertices[i], vertices[i + 1], vertices[i + 2]);
+        for (; i < count; ++i)
+            SubmitVertex(vertices[i], triangle_handler);
+        break;
+
+    case PipelineRegs::TriangleTopology::Strip: {
+        // Once two vertices are queued, each vertex makes a triangle with the two before it. Their
+        // order alternates with the slot of the queue they would have gone to.
+        for (; i < count && (i < 2 || !strip_ready); ++i)
+            SubmitVertex(vertices[i], triangle_handler);
+        if (i == count)
+            break;
+
+        // Slot the vertex at index 0 of the array would have gone to
+        const size_t slot_base = buffer_index + (i & 1);
+        for (; i < count; ++i) {
+            if (((slot_base + i) & 1) == 0) {
+                triangle_handler(vertices[i - 2], vertices[i - 1], vertices[i]);
+            } else {
+                triangle_handler(vertices[i - 1], vertices[i - 2], vertices[i]);
+            }
+        }
+        buffer_index = static_cast<int>((slot_base + count) & 1);
+        buffer[buffer_index] = vertices[count - 2];
+        buffer[!buffer_index] = vertices[count - 1];
+        break;
+    }
+
+    case PipelineRegs::TriangleTopology::Fan: {
+        // Once the center is queued, each vertex makes a triangle with it and the vertex before
+        for (; i < count && (i < 1 || !strip_ready); ++i)
+            SubmitVertex(vertices[i], triangle_handler);
+        if (i == count)
+            break;
+
+        for (; i < count; ++i)
+            triangle_handler(buffer[0], vertices[i - 1], vertices[i]);
+        buffer[1] = vertices[count - 1];
+        break;
+    }
+    }
+}
+
 } // namespace
@@ -42,6 +42,22 @@ public:
     /// and invalidated
     virtual void FlushAndInvalidateRegion(PAddr addr, u32 size) = 0;
 
+    /// Notify rasterizer that the CPU finished writing the specified region, which the GPU may
+    /// soon read from
+    virtual void PreloadRegion(PAddr addr, u32 size) {}
+
+    /**
+     * Marks whether the current frame is skipped. Rasterizers that support it drop the draws of
+     * skipped frames, except those whose results may still be read back from emulated memory.
+     */
+    virtual void SetFrameSkipped(bool skipped) {}
+
+    /// Attempt to draw the current vertex batch with the vertex shader running on the GPU, instead
+    /// of queueing software-processed triangles through AddTriangle
+    virtual bool AccelerateDrawBatch(bool is_indexed) {
+        return false;
+    }
+
     /// Attempt to use a faster method to perform a display transfer with is_texture_copy = 0
     virtual bool AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) {
         return false;
@@ -84,6 +84,8 @@ ASSERT_REG_POSITION(rasterizer, 0x40);
 ASSERT_REG_POSITION(rasterizer.cull_mode, 0x40);
 ASSERT_REG_POSITION(rasterizer.viewport_size_x, 0x41);
 ASSERT_REG_POSITION(rasterizer.viewport_size_y, 0x43);
+ASSERT_REG_POSITION(rasterizer.clip_enable, 0x47);
+ASSERT_REG_POSITION(rasterizer.clip_coef[0], 0x48);
 ASSERT_REG_POSITION(rasterizer.viewport_depth_range, 0x4d);
 ASSERT_REG_POSITION(rasterizer.viewport_depth_near_plane, 0x4e);
 ASSERT_REG_POSITION(rasterizer.vs_output_attributes[0], 0x50);
@@ -4,6 +4,7 @@
 
 #include <atomic>
 #include <memory>
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/gl_rasterizer.h"
 #include "video_core/swrasterizer/swrasterizer.h"
@@ -14,10 +15,17 @@ void RendererBase::RefreshRasterizerSetting() {
     if (rasterizer == nullptr || opengl_rasterizer_active != hw_renderer_enabled) {
         opengl_rasterizer_active = hw_renderer_enabled;
 
-        if (hw_renderer_enabled) {
-            rasterizer = std::make_unique<RasterizerOpenGL>();
-        } else {
-            rasterizer = std::make_unique<VideoCore::SWRasterizer>();
-        }
+        // The previous rasterizer is destroyed on the thread it lives on as well
+        VideoCore::RunOnRasterizerThread([this, hw_renderer_enabled] {
+            if (hw_renderer_enabled) {
+                rasterizer = std::make_unique<RasterizerOpenGL>();
+            } else {
+                rasterizer = std::make_unique<VideoCore::SWRasterizer>();
+            }
+        });
     }
 }
+
+void RendererBase::DestroyRasterizer() {
+    VideoCore::RunOnRasterizerThread([this] { rasterizer.reset(); });
+}
@@ -47,8 +47,18 @@ public:
         return rasterizer.get();
     }
 
+    /// Creates the rasterizer the settings ask for, if it isn't the current one, on the thread it
+    /// lives on
     void RefreshRasterizerSetting();
 
+    /// Destroys the rasterizer on the thread it lives on, to be done before the GPU thread stops
+    void DestroyRasterizer();
+
+    /// Whether the current rasterizer is the OpenGL one, which only works on the GL context thread
+    bool IsOpenGLRasterizerActive() const {
+        return opengl_rasterizer_active;
+    }
+
 protected:
     std::unique_ptr<VideoCore::RasterizerInterface> rasterizer;
     f32 m_current_fps = 0.0f; ///< Current framerate, should be set by the renderer
@@ -0,0 +1,92 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include "common/microprofile.h"
+#include "video_core/renderer_opengl/gl_async_shader_compiler.h"
+#include "video_core/renderer_opengl/gl_shader_util.h"
+
+namespace GLShader {
+
+AsyncShaderCompiler::AsyncShaderCompiler(std::unique_ptr<EmuWindow::GraphicsContext> context)
+    : context(std::move(context)) {
+    worker = std::thread(&AsyncShaderCompiler::WorkerLoop, this);
+}
+
+AsyncShaderCompiler::~AsyncShaderCompiler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    job_available.notify_one();
+    worker.join();
+
+    // The contexts share their objects, so programs nobody collected can be freed from here
+    for (const Result& result : results) {
+        glDeleteProgram(result.program);
+    }
+}
+
+void AsyncShaderCompiler::Queue(const PicaShaderConfig& config, std::string vertex_shader,
+                                std::string fragment_shader) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!pending.insert(config).second) {
+            return;
+        }
+        jobs.push_back({config, std::move(vertex_shader), std::move(fragment_shader)});
+    }
+    job_available.notify_one();
+}
+
+bool AsyncShaderCompiler::IsPending(const PicaShaderConfig& config) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.count(config) != 0;
+}
+
+size_t AsyncShaderCompiler::NumPending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+}
+
+std::vector<AsyncShaderCompiler::Result> AsyncShaderCompiler::Collect() {
+    std::vector<Result> finished;
+    std::lock_guard<std::mutex> lock(mutex);
+    finished.swap(results);
+    for (const Result& result : finished) {
+        pending.erase(result.config);
+    }
+    return finished;
+}
+
+void AsyncShaderCompiler::WorkerLoop() {
+    MicroProfileOnThreadCreate("ShaderCompiler");
+    context->MakeCurrent();
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_available.wait(lock, [this] { return stop || !jobs.empty(); });
+            if (stop) {
+                break;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        const GLuint program =
+            LoadProgram(job.vertex_shader.c_str(), job.fragment_shader.c_str());
+
+        // Objects only become visible to the other contexts once their commands completed
+        glFinish();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back({job.config, program});
+    }
+
+    context->DoneCurrent();
+}
+
+} // namespace GLShader
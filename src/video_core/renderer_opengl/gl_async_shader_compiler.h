@@ -0,0 +1,72 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_funcs.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+
+namespace GLShader {
+
+/**
+ * Compiles and links shader programs on a worker thread, using a context that shares its objects
+ * with the rasterizer's. Draws needing a program that is still being built can then be skipped or
+ * drawn with a generic program instead of stalling on the compiler.
+ */
+class AsyncShaderCompiler : NonCopyable {
+public:
+    /// Program handed back by the worker, already linked and ready for use on any shared context
+    struct Result {
+        PicaShaderConfig config;
+        GLuint program;
+    };
+
+    explicit AsyncShaderCompiler(std::unique_ptr<EmuWindow::GraphicsContext> context);
+    ~AsyncShaderCompiler();
+
+    /// Queues the program of the given configuration for compilation
+    void Queue(const PicaShaderConfig& config, std::string vertex_shader,
+               std::string fragment_shader);
+
+    /// Returns whether the program of the given configuration was queued and not yet collected
+    bool IsPending(const PicaShaderConfig& config) const;
+
+    /// Returns the number of programs that were queued and not yet collected
+    size_t NumPending() const;
+
+    /// Takes the programs finished since the last call
+    std::vector<Result> Collect();
+
+private:
+    struct Job {
+        PicaShaderConfig config;
+        std::string vertex_shader;
+        std::string fragment_shader;
+    };
+
+    void WorkerLoop();
+
+    std::unique_ptr<EmuWindow::GraphicsContext> context;
+
+    mutable std::mutex mutex;
+    std::condition_variable job_available;
+    std::deque<Job> jobs;
+    std::vector<Result> results;
+    std::unordered_set<PicaShaderConfig> pending;
+    bool stop = false;
+
+    std::thread worker;
+};
+
+} // namespace GLShader
@@ -0,0 +1,209 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/string_util.h"
+#include "core/hw/gpu.h"
+#include "video_core/renderer_opengl/gl_frame_dumper.h"
+#include "video_core/renderer_opengl/gl_state.h"
+
+FrameDumperOpenGL::FrameDumperOpenGL(const std::string& path, GLsizei width, GLsizei height)
+    : file(path, "wb"), width(width), height(height) {
+    ASSERT(width % 2 == 0 && height % 2 == 0);
+
+    if (!file.IsOpen()) {
+        LOG_ERROR(Render_OpenGL, "Could not open %s to dump frames to", path.c_str());
+        return;
+    }
+
+    // Full range BT.601, like JPEG, as the frames come from RGB
+    const std::string header =
+        Common::StringFromFormat("YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height,
+                                 static_cast<int>(GPU::SCREEN_REFRESH_RATE));
+    file.WriteBytes(header.data(), header.size());
+
+    OpenGLState cur_state = OpenGLState::GetCurState();
+    const GLuint old_tex = cur_state.texture_units[0].texture_2d;
+    const GLuint old_fb = cur_state.draw.draw_framebuffer;
+
+    color.Create();
+    framebuffer.Create();
+    cur_state.texture_units[0].texture_2d = color.handle;
+    cur_state.draw.draw_framebuffer = framebuffer.handle;
+    cur_state.Apply();
+    glActiveTexture(GL_TEXTURE0);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color.handle,
+                           0);
+
+    cur_state.texture_units[0].texture_2d = old_tex;
+    cur_state.draw.draw_framebuffer = old_fb;
+    cur_state.Apply();
+
+    for (Readback& readback : readbacks) {
+        readback.buffer.Create();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.handle);
+        glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    thread = std::thread(&FrameDumperOpenGL::WriteLoop, this);
+}
+
+FrameDumperOpenGL::~FrameDumperOpenGL() {
+    if (!IsOpen())
+        return;
+
+    // Write out the frames still being read back, oldest first
+    for (size_t i = 0; i < NUM_READBACKS; ++i) {
+        CompleteReadback(readbacks[(next_readback + i) % NUM_READBACKS]);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    frame_queued.notify_one();
+    thread.join();
+}
+
+void FrameDumperOpenGL::DumpFrame() {
+    if (!IsOpen())
+        return;
+
+    Readback& readback = readbacks[next_readback];
+    next_readback = (next_readback + 1) % NUM_READBACKS;
+    CompleteReadback(readback);
+
+    OpenGLState cur_state = OpenGLState::GetCurState();
+    const GLuint old_read_fb = cur_state.draw.read_framebuffer;
+    cur_state.draw.read_framebuffer = framebuffer.handle;
+    cur_state.Apply();
+
+    // With a pack buffer bound, this only queues a copy to the buffer instead of stalling
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.handle);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    cur_state.draw.read_framebuffer = old_read_fb;
+    cur_state.Apply();
+}
+
+void FrameDumperOpenGL::CompleteReadback(Readback& readback) {
+    if (readback.fence == nullptr)
+        return;
+
+    // The first wait flushes the command stream so that the fence is guaranteed to signal
+    GLenum result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(readback.fence, 0, 1000000);
+    }
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    std::vector<u8> pixels;
+    {
+        // Rather than dropping frames, which would throw the video out of sync with the audio,
+        // wait for the writer thread if it falls behind
+        std::unique_lock<std::mutex> lock(mutex);
+        frame_dequeued.wait(lock, [this] { return queued_frames.size() < MAX_QUEUED_FRAMES; });
+        if (!free_buffers.empty()) {
+            pixels = std::move(free_buffers.back());
+            free_buffers.pop_back();
+        }
+    }
+
+    const size_t size = static_cast<size_t>(width * height * 4);
+    pixels.resize(size);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.handle);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (mapped != nullptr) {
+        std::memcpy(pixels.data(), mapped, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        LOG_ERROR(Render_OpenGL, "Failed to map a frame dump readback buffer");
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued_frames.push_back(std::move(pixels));
+    }
+    frame_queued.notify_one();
+}
+
+void FrameDumperOpenGL::WriteLoop() {
+    MicroProfileOnThreadCreate("FrameDumper");
+
+    while (true) {
+        std::vector<u8> pixels;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frame_queued.wait(lock, [this] { return stop || !queued_frames.empty(); });
+            // Frames queued before stopping are still written
+            if (queued_frames.empty())
+                break;
+            pixels = std::move(queued_frames.front());
+            queued_frames.pop_front();
+        }
+        frame_dequeued.notify_one();
+
+        WriteFrame(pixels);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        free_buffers.push_back(std::move(pixels));
+    }
+}
+
+void FrameDumperOpenGL::WriteFrame(const std::vector<u8>& pixels) {
+    const size_t luma_size = static_cast<size_t>(width * height);
+    const size_t chroma_size = luma_size / 4;
+    yuv_frame.resize(luma_size + 2 * chroma_size);
+    u8* const y_plane = yuv_frame.data();
+    u8* const cb_plane = y_plane + luma_size;
+    u8* const cr_plane = cb_plane + chroma_size;
+
+    // Fixed point BT.601 coefficients scaled by 256. The chroma offsets keep the sums positive.
+    const auto pixel = [&](int x, int y) { return &pixels[((height - 1 - y) * width + x) * 4]; };
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const u8* p = pixel(x, y);
+            y_plane[y * width + x] =
+                static_cast<u8>((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+        }
+    }
+    for (int y = 0; y < height / 2; ++y) {
+        for (int x = 0; x < width / 2; ++x) {
+            int r = 0, g = 0, b = 0;
+            for (int i = 0; i < 4; ++i) {
+                const u8* p = pixel(x * 2 + i % 2, y * 2 + i / 2);
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+            r = (r + 2) / 4;
+            g = (g + 2) / 4;
+            b = (b + 2) / 4;
+            const size_t index = y * (width / 2) + x;
+            cb_plane[index] =
+                static_cast<u8>(std::min((-43 * r - 85 * g + 128 * b + 32896) >> 8, 255));
+            cr_plane[index] =
+                static_cast<u8>(std::min((128 * r - 107 * g - 21 * b + 32896) >> 8, 255));
+        }
+    }
+
+    static const char frame_header[] = "FRAME\n";
+    file.WriteBytes(frame_header, sizeof(frame_header) - 1);
+    file.WriteBytes(yuv_frame.data(), yuv_frame.size());
+}
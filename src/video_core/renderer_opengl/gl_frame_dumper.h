@@ -0,0 +1,101 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+/**
+ * Writes frames to a YUV4MPEG2 video file. The renderer draws each frame a second time into a
+ * framebuffer of a fixed size, which is read back into a ring of pixel buffer objects without
+ * waiting for the GPU. A thread of its own converts the pixels and writes them, so dumping costs
+ * the emulation thread little more than the extra draw and a copy.
+ */
+class FrameDumperOpenGL : NonCopyable {
+public:
+    /**
+     * Opens the file and creates the framebuffer to draw the dumped frames into
+     * @param width, height Size of the video, which 4:2:0 chroma subsampling needs to be even
+     */
+    FrameDumperOpenGL(const std::string& path, GLsizei width, GLsizei height);
+    ~FrameDumperOpenGL();
+
+    /// Whether the file could be opened. Nothing is dumped otherwise.
+    bool IsOpen() const {
+        return file.IsOpen();
+    }
+
+    /// Framebuffer to draw each frame into before calling DumpFrame
+    GLuint GetFramebuffer() const {
+        return framebuffer.handle;
+    }
+
+    GLsizei GetWidth() const {
+        return width;
+    }
+
+    GLsizei GetHeight() const {
+        return height;
+    }
+
+    /**
+     * Starts reading back the current contents of the framebuffer, and hands the readbacks that
+     * have completed to the writer thread. Only to be called from the thread owning the context.
+     */
+    void DumpFrame();
+
+private:
+    /// Number of readbacks in flight, enough for the GPU to finish one before it is needed again
+    static constexpr size_t NUM_READBACKS = 3;
+    /// Frames waiting to be written before the emulation thread waits for the writer thread
+    static constexpr size_t MAX_QUEUED_FRAMES = 16;
+
+    struct Readback {
+        OGLBuffer buffer;
+        /// Signaled once the pixels have arrived in the buffer, nullptr if no readback is pending
+        GLsync fence = nullptr;
+    };
+
+    /// Waits for a pending readback if needed and queues its pixels for writing
+    void CompleteReadback(Readback& readback);
+
+    void WriteLoop();
+
+    /// Converts a frame of bottom-up RGBA pixels to 4:2:0 YCbCr and appends it to the file
+    void WriteFrame(const std::vector<u8>& pixels);
+
+    FileUtil::IOFile file;
+    GLsizei width;
+    GLsizei height;
+
+    OGLTexture color;
+    OGLFramebuffer framebuffer;
+
+    std::array<Readback, NUM_READBACKS> readbacks;
+    size_t next_readback = 0;
+
+    std::mutex mutex;
+    std::condition_variable frame_queued;
+    std::condition_variable frame_dequeued;
+    std::deque<std::vector<u8>> queued_frames;
+    /// Pixel buffers already written, kept for reuse
+    std::vector<std::vector<u8>> free_buffers;
+    bool stop = false;
+
+    /// Conversion buffer of the writer thread
+    std::vector<u8> yuv_frame;
+
+    std::thread thread;
+};
@@ -0,0 +1,160 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "video_core/renderer_opengl/gl_frame_presenter.h"
+#include "video_core/renderer_opengl/gl_state.h"
+
+FramePresenterOpenGL::FramePresenterOpenGL(std::unique_ptr<EmuWindow::GraphicsContext> context,
+                                           EmuWindow& window)
+    : context(std::move(context)), window(window) {
+    thread = std::thread(&FramePresenterOpenGL::PresentLoop, this);
+}
+
+FramePresenterOpenGL::~FramePresenterOpenGL() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    frame_posted.notify_one();
+    thread.join();
+
+    for (Frame& frame : frames) {
+        if (frame.render_fence != nullptr)
+            glDeleteSync(frame.render_fence);
+        if (frame.present_fence != nullptr)
+            glDeleteSync(frame.present_fence);
+    }
+}
+
+FramePresenterOpenGL::Frame& FramePresenterOpenGL::GetRenderFrame(GLsizei width, GLsizei height) {
+    Frame* frame = nullptr;
+    GLsync present_fence;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Frame& candidate : frames) {
+            if (&candidate != mailbox && &candidate != presenting) {
+                frame = &candidate;
+                break;
+            }
+        }
+        ASSERT(frame != nullptr);
+        present_fence = frame->present_fence;
+        frame->present_fence = nullptr;
+    }
+
+    // Let the GPU finish copying the frame to the window before drawing over it, without waiting
+    // on the CPU
+    if (present_fence != nullptr) {
+        glWaitSync(present_fence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(present_fence);
+    }
+
+    if (frame->color.handle != 0 && frame->width == width && frame->height == height)
+        return *frame;
+
+    OpenGLState cur_state = OpenGLState::GetCurState();
+    const GLuint old_tex = cur_state.texture_units[0].texture_2d;
+    const GLuint old_fb = cur_state.draw.draw_framebuffer;
+
+    frame->color.Create();
+    frame->render_framebuffer.Create();
+    frame->width = width;
+    frame->height = height;
+
+    cur_state.texture_units[0].texture_2d = frame->color.handle;
+    cur_state.draw.draw_framebuffer = frame->render_framebuffer.handle;
+    cur_state.Apply();
+    glActiveTexture(GL_TEXTURE0);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           frame->color.handle, 0);
+
+    cur_state.texture_units[0].texture_2d = old_tex;
+    cur_state.draw.draw_framebuffer = old_fb;
+    cur_state.Apply();
+
+    return *frame;
+}
+
+void FramePresenterOpenGL::PostFrame(Frame& frame) {
+    // Fences only reach other contexts once the commands before them are flushed
+    frame.render_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (mailbox != nullptr && mailbox->render_fence != nullptr) {
+            // The replaced frame is never presented
+            glDeleteSync(mailbox->render_fence);
+            mailbox->render_fence = nullptr;
+        }
+        mailbox = &frame;
+    }
+    frame_posted.notify_one();
+}
+
+void FramePresenterOpenGL::PresentLoop() {
+    MicroProfileOnThreadCreate("FramePresenter");
+    context->MakeCurrent();
+
+    while (true) {
+        Frame* frame;
+        GLsync render_fence;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frame_posted.wait(lock, [this] { return stop || mailbox != nullptr; });
+            if (stop)
+                break;
+            frame = presenting = mailbox;
+            mailbox = nullptr;
+            render_fence = frame->render_fence;
+            frame->render_fence = nullptr;
+        }
+
+        glWaitSync(render_fence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(render_fence);
+        Present(*frame);
+
+        // Blocks until the host displays the frame when vsync is enabled
+        window.SwapBuffers();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        presenting = nullptr;
+    }
+
+    for (Frame& frame : frames) {
+        if (frame.present_framebuffer != 0)
+            glDeleteFramebuffers(1, &frame.present_framebuffer);
+    }
+    context->DoneCurrent();
+}
+
+void FramePresenterOpenGL::Present(Frame& frame) {
+    // Framebuffer objects aren't shared between contexts, so this context reads the frame through
+    // its own. The tracked OpenGLState belongs to the emulation thread and isn't used here.
+    if (frame.present_framebuffer == 0)
+        glGenFramebuffers(1, &frame.present_framebuffer);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, frame.present_framebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           frame.color.handle, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, frame.width, frame.height, 0, 0, frame.width, frame.height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    const GLsync present_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (frame.present_fence != nullptr)
+        glDeleteSync(frame.present_fence);
+    frame.present_fence = present_fence;
+}
@@ -0,0 +1,78 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <glad/glad.h>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+/**
+ * Presents frames on a thread of its own, so that waiting for the host's vsync doesn't hold up
+ * emulation. The emulation thread renders each frame into an offscreen frame and posts it to a
+ * single-slot mailbox, replacing any frame that wasn't presented yet. The presentation thread
+ * displays the latest posted frame whenever the window is ready for one.
+ */
+class FramePresenterOpenGL : NonCopyable {
+public:
+    /// Offscreen frame, owned by whichever side of the mailbox is using it
+    struct Frame {
+        OGLTexture color;
+        /// Framebuffer of the emulation thread's context rendering into `color`
+        OGLFramebuffer render_framebuffer;
+        /// Framebuffer of the presentation context reading from `color`, as they aren't shared
+        GLuint present_framebuffer = 0;
+        GLsizei width = 0;
+        GLsizei height = 0;
+        /// Signaled once rendering into the frame has finished
+        GLsync render_fence = nullptr;
+        /// Signaled once the frame has been copied to the window
+        GLsync present_fence = nullptr;
+    };
+
+    /**
+     * @param context Context shared with the emulation thread's that draws to the window
+     * @param window  Window the frames are presented to
+     */
+    FramePresenterOpenGL(std::unique_ptr<EmuWindow::GraphicsContext> context, EmuWindow& window);
+    ~FramePresenterOpenGL();
+
+    /**
+     * Returns a frame to render the next frame into, with its framebuffer allocated for the given
+     * size. Only to be called from the emulation thread.
+     */
+    Frame& GetRenderFrame(GLsizei width, GLsizei height);
+
+    /// Hands the frame returned by GetRenderFrame, drawn by now, to the presentation thread
+    void PostFrame(Frame& frame);
+
+private:
+    /// Number of frames, enough for one each to render, wait in the mailbox and be presented
+    static constexpr size_t NUM_FRAMES = 3;
+
+    void PresentLoop();
+    void Present(Frame& frame);
+
+    std::unique_ptr<EmuWindow::GraphicsContext> context;
+    EmuWindow& window;
+
+    std::array<Frame, NUM_FRAMES> frames;
+
+    std::mutex mutex;
+    std::condition_variable frame_posted;
+    /// Frame waiting to be presented, or nullptr
+    Frame* mailbox = nullptr;
+    /// Frame the presentation thread is displaying, or nullptr
+    Frame* presenting = nullptr;
+    bool stop = false;
+
+    std::thread thread;
+};
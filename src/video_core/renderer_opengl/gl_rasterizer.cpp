@@ -2,50 +2,61 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cinttypes>
 #include <memory>
 #include <string>
 #include <tuple>
 #include <utility>
 #include <glad/glad.h>
+#include "common/alignment.h"
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/microprofile.h"
 #include "common/vector_math.h"
+#include "core/core.h"
 #include "core/hw/gpu.h"
+#include "core/loader/loader.h"
+#include "core/memory.h"
+#include "core/settings.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs_framebuffer.h"
+#include "video_core/regs_pipeline.h"
 #include "video_core/regs_rasterizer.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/renderer_opengl/gl_rasterizer.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
+#include "video_core/renderer_opengl/gl_timer_queries.h"
 #include "video_core/renderer_opengl/pica_to_gl.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
+#include "video_core/video_core.h"
 
+MICROPROFILE_DEFINE(OpenGL_VAO, "OpenGL", "Vertex Array Setup", MP_RGB(255, 128, 0));
 MICROPROFILE_DEFINE(OpenGL_Drawing, "OpenGL", "Drawing", MP_RGB(128, 128, 192));
 MICROPROFILE_DEFINE(OpenGL_Blits, "OpenGL", "Blits", MP_RGB(100, 100, 255));
 MICROPROFILE_DEFINE(OpenGL_CacheManagement, "OpenGL", "Cache Mgmt", MP_RGB(100, 255, 100));
 
-RasterizerOpenGL::RasterizerOpenGL() : shader_dirty(true) {
-    // Create sampler objects
-    for (size_t i = 0; i < texture_samplers.size(); ++i) {
-        texture_samplers[i].Create();
-        state.texture_units[i].sampler = texture_samplers[i].sampler.handle;
-    }
-
+RasterizerOpenGL::RasterizerOpenGL()
+    : shader_dirty(true), ubershader_config_buffer(GL_UNIFORM_BUFFER),
+      vertex_buffer(GL_ARRAY_BUFFER), index_buffer(GL_ELEMENT_ARRAY_BUFFER),
+      hw_vertex_buffer(GL_ARRAY_BUFFER), hw_index_buffer(GL_ELEMENT_ARRAY_BUFFER),
+      vs_uniform_buffer(GL_UNIFORM_BUFFER), clip_uniform_buffer(GL_UNIFORM_BUFFER),
+      uniform_buffer(GL_UNIFORM_BUFFER), texel_buffer(GL_TEXTURE_BUFFER) {
     // Generate VBO, VAO and UBO
-    vertex_buffer.Create();
+    vertex_buffer.Create(VERTEX_BUFFER_SIZE);
     vertex_array.Create();
-    uniform_buffer.Create();
+    uniform_buffer.Create(UNIFORM_BUFFER_SIZE);
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_buffer_alignment);
 
     state.draw.vertex_array = vertex_array.handle;
-    state.draw.vertex_buffer = vertex_buffer.handle;
-    state.draw.uniform_buffer = uniform_buffer.handle;
+    state.draw.vertex_buffer = vertex_buffer.GetHandle();
+    state.draw.uniform_buffer = uniform_buffer.GetHandle();
     state.Apply();
-
-    // Bind the UBO to binding point 0
-    glBindBufferBase(GL_UNIFORM_BUFFER, 0, uniform_buffer.handle);
+    // Like for the hardware vertex shader path, the index buffer is created while the vertex
+    // array that refers to it is bound
+    index_buffer.Create(INDEX_BUFFER_SIZE);
 
     uniform_block_data.dirty = true;
 
@@ -58,14 +69,16 @@ RasterizerOpenGL::RasterizerOpenGL() : shader_dirty(true) {
     uniform_block_data.proctex_alpha_map_dirty = true;
     uniform_block_data.proctex_lut_dirty = true;
     uniform_block_data.proctex_diff_lut_dirty = true;
+    // Only entries written since the last sync get converted, so have the first one take them all
+    Pica::g_state.MarkLutsDirty();
 
     // Set vertex attributes
     glVertexAttribPointer(GLShader::ATTRIBUTE_POSITION, 4, GL_FLOAT, GL_FALSE,
                           sizeof(HardwareVertex), (GLvoid*)offsetof(HardwareVertex, position));
     glEnableVertexAttribArray(GLShader::ATTRIBUTE_POSITION);
 
-    glVertexAttribPointer(GLShader::ATTRIBUTE_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(HardwareVertex),
-                          (GLvoid*)offsetof(HardwareVertex, color));
+    glVertexAttribPointer(GLShader::ATTRIBUTE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                          sizeof(HardwareVertex), (GLvoid*)offsetof(HardwareVertex, color));
     glEnableVertexAttribArray(GLShader::ATTRIBUTE_COLOR);
 
     glVertexAttribPointer(GLShader::ATTRIBUTE_TEXCOORD0, 2, GL_FLOAT, GL_FALSE,
@@ -82,88 +95,100 @@ RasterizerOpenGL::RasterizerOpenGL() : shader_dirty(true) {
                           sizeof(HardwareVertex), (GLvoid*)offsetof(HardwareVertex, tex_coord0_w));
     glEnableVertexAttribArray(GLShader::ATTRIBUTE_TEXCOORD0_W);
 
-    glVertexAttribPointer(GLShader::ATTRIBUTE_NORMQUAT, 4, GL_FLOAT, GL_FALSE,
+    glVertexAttribPointer(GLShader::ATTRIBUTE_NORMQUAT, 4, GL_HALF_FLOAT, GL_FALSE,
                           sizeof(HardwareVertex), (GLvoid*)offsetof(HardwareVertex, normquat));
     glEnableVertexAttribArray(GLShader::ATTRIBUTE_NORMQUAT);
 
-    glVertexAttribPointer(GLShader::ATTRIBUTE_VIEW, 3, GL_FLOAT, GL_FALSE, sizeof(HardwareVertex),
-                          (GLvoid*)offsetof(HardwareVertex, view));
+    glVertexAttribPointer(GLShader::ATTRIBUTE_VIEW, 3, GL_HALF_FLOAT, GL_FALSE,
+                          sizeof(HardwareVertex), (GLvoid*)offsetof(HardwareVertex, view));
     glEnableVertexAttribArray(GLShader::ATTRIBUTE_VIEW);
 
+    // Create the vertex array and buffers of the hardware vertex shader path. The element array
+    // binding is part of the vertex array state, so the index buffer is created while it's bound.
+    hw_vertex_array.Create();
+    hw_vertex_buffer.Create(HW_VERTEX_BUFFER_SIZE);
+    state.draw.vertex_array = hw_vertex_array.handle;
+    state.draw.vertex_buffer = hw_vertex_buffer.GetHandle();
+    state.Apply();
+    hw_index_buffer.Create(HW_INDEX_BUFFER_SIZE);
+    vs_uniform_buffer.Create(VS_UNIFORM_BUFFER_SIZE);
+    clip_uniform_buffer.Create(CLIP_UNIFORM_BUFFER_SIZE);
+
+    // The vertex stages of all programs of the rasterizer write both clip distances: the PICA's
+    // z <= 0 plane, which the GL frustum doesn't cover, and the user clipping plane
+    state.clip_distance[0] = true;
+    state.clip_distance[1] = true;
+
+    state.draw.vertex_array = vertex_array.handle;
+    state.draw.vertex_buffer = vertex_buffer.GetHandle();
+    state.draw.uniform_buffer = uniform_buffer.GetHandle();
+    state.Apply();
+
     // Create render framebuffer
     framebuffer.Create();
 
+    // All lookup tables share one texel buffer, each through a texture of the matching format.
+    // Its size in the smallest of those formats must not exceed the texture buffer size limit,
+    // which may be as low as 65536 texels.
+    GLint max_texture_buffer_size;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texture_buffer_size);
+    GLsizeiptr texel_buffer_size = TEXEL_BUFFER_SIZE;
+    if (static_cast<GLsizeiptr>(max_texture_buffer_size) * sizeof(GLvec2) < texel_buffer_size) {
+        texel_buffer_size = static_cast<GLsizeiptr>(max_texture_buffer_size) * sizeof(GLvec2);
+        LOG_INFO(Render_OpenGL, "Texture buffers are limited to %d texels, shrinking the lookup "
+                                "table buffer to %d KiB",
+                 max_texture_buffer_size, static_cast<int>(texel_buffer_size / 1024));
+    }
+    texel_buffer.Create(texel_buffer_size);
+
     // Allocate and bind lighting lut textures
     lighting_lut.Create();
     state.lighting_lut.texture_buffer = lighting_lut.handle;
     state.Apply();
-    lighting_lut_buffer.Create();
-    glBindBuffer(GL_TEXTURE_BUFFER, lighting_lut_buffer.handle);
-    glBufferData(GL_TEXTURE_BUFFER,
-                 sizeof(GLfloat) * 2 * 256 * Pica::LightingRegs::NumLightingSampler, nullptr,
-                 GL_DYNAMIC_DRAW);
     glActiveTexture(TextureUnits::LightingLUT.Enum());
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, lighting_lut_buffer.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, texel_buffer.GetHandle());
 
     // Setup the LUT for the fog
     fog_lut.Create();
     state.fog_lut.texture_buffer = fog_lut.handle;
     state.Apply();
-    fog_lut_buffer.Create();
-    glBindBuffer(GL_TEXTURE_BUFFER, fog_lut_buffer.handle);
-    glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * 2 * 128, nullptr, GL_DYNAMIC_DRAW);
     glActiveTexture(TextureUnits::FogLUT.Enum());
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, fog_lut_buffer.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, texel_buffer.GetHandle());
 
     // Setup the noise LUT for proctex
     proctex_noise_lut.Create();
     state.proctex_noise_lut.texture_buffer = proctex_noise_lut.handle;
     state.Apply();
-    proctex_noise_lut_buffer.Create();
-    glBindBuffer(GL_TEXTURE_BUFFER, proctex_noise_lut_buffer.handle);
-    glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * 2 * 128, nullptr, GL_DYNAMIC_DRAW);
     glActiveTexture(TextureUnits::ProcTexNoiseLUT.Enum());
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, proctex_noise_lut_buffer.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, texel_buffer.GetHandle());
 
     // Setup the color map for proctex
     proctex_color_map.Create();
     state.proctex_color_map.texture_buffer = proctex_color_map.handle;
     state.Apply();
-    proctex_color_map_buffer.Create();
-    glBindBuffer(GL_TEXTURE_BUFFER, proctex_color_map_buffer.handle);
-    glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * 2 * 128, nullptr, GL_DYNAMIC_DRAW);
     glActiveTexture(TextureUnits::ProcTexColorMap.Enum());
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, proctex_color_map_buffer.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, texel_buffer.GetHandle());
 
     // Setup the alpha map for proctex
     proctex_alpha_map.Create();
     state.proctex_alpha_map.texture_buffer = proctex_alpha_map.handle;
     state.Apply();
-    proctex_alpha_map_buffer.Create();
-    glBindBuffer(GL_TEXTURE_BUFFER, proctex_alpha_map_buffer.handle);
-    glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * 2 * 128, nullptr, GL_DYNAMIC_DRAW);
     glActiveTexture(TextureUnits::ProcTexAlphaMap.Enum());
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, proctex_alpha_map_buffer.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, texel_buffer.GetHandle());
 
     // Setup the LUT for proctex
     proctex_lut.Create();
     state.proctex_lut.texture_buffer = proctex_lut.handle;
     state.Apply();
-    proctex_lut_buffer.Create();
-    glBindBuffer(GL_TEXTURE_BUFFER, proctex_lut_buffer.handle);
-    glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * 4 * 256, nullptr, GL_DYNAMIC_DRAW);
     glActiveTexture(TextureUnits::ProcTexLUT.Enum());
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, proctex_lut_buffer.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, texel_buffer.GetHandle());
 
     // Setup the difference LUT for proctex
     proctex_diff_lut.Create();
     state.proctex_diff_lut.texture_buffer = proctex_diff_lut.handle;
     state.Apply();
-    proctex_diff_lut_buffer.Create();
-    glBindBuffer(GL_TEXTURE_BUFFER, proctex_diff_lut_buffer.handle);
-    glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * 4 * 256, nullptr, GL_DYNAMIC_DRAW);
     glActiveTexture(TextureUnits::ProcTexDiffLUT.Enum());
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, proctex_diff_lut_buffer.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, texel_buffer.GetHandle());
 
     // Sync fixed function OpenGL state
     SyncCullMode();
@@ -176,9 +201,105 @@ RasterizerOpenGL::RasterizerOpenGL() : shader_dirty(true) {
     SyncColorWriteMask();
     SyncStencilWriteMask();
     SyncDepthWriteMask();
+
+    if (Settings::values.use_disk_shader_cache) {
+        LoadDiskShaderCache();
+    }
+
+    if (Settings::values.use_async_shader_compile) {
+        auto context = VideoCore::g_emu_window->CreateSharedContext();
+        if (context != nullptr) {
+            shader_compiler = std::make_unique<GLShader::AsyncShaderCompiler>(std::move(context));
+        } else {
+            LOG_WARNING(Render_OpenGL,
+                        "Frontend can't create a shared context, compiling shaders synchronously");
+        }
+    }
 }
 
-RasterizerOpenGL::~RasterizerOpenGL() {}
+RasterizerOpenGL::~RasterizerOpenGL() {
+    VideoCore::g_pending_shader_compiles = 0;
+}
+
+void RasterizerOpenGL::LoadDiskShaderCache() {
+    if (!GLShader::ShaderDiskCache::IsSupported()) {
+        LOG_INFO(Render_OpenGL, "Driver can't retrieve program binaries, shader cache disabled");
+        return;
+    }
+
+    u64 program_id;
+    if (Core::System::GetInstance().GetAppLoader().ReadProgramId(program_id) !=
+        Loader::ResultStatus::Success) {
+        return;
+    }
+
+    for (const auto& entry : shader_disk_cache.Open(program_id)) {
+        // Binaries the driver rejects are simply compiled again, and stored anew, when needed
+        const GLuint program = GLShader::ShaderDiskCache::LoadProgram(entry.second);
+        if (program == 0) {
+            continue;
+        }
+
+        std::unique_ptr<PicaShader> shader = std::make_unique<PicaShader>();
+        shader->shader.handle = program;
+        if (shader_cache.emplace(entry.first, std::move(shader)).second) {
+            SetupShaderProgram(program);
+        }
+    }
+}
+
+/// Converts a float to a half float, rounding to nearest even. Values out of the half float range
+/// are clamped to its largest finite value and denormals are flushed to zero.
+static GLhalf FloatToHalf(float value) {
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const u32 sign = (bits >> 16) & 0x8000;
+    const u32 magnitude = bits & 0x7FFFFFFF;
+
+    if (magnitude > 0x7F800000) {
+        // NaN
+        return static_cast<GLhalf>(sign | 0x7E00);
+    }
+    if (magnitude >= 0x477FF000) {
+        // Rounds to infinity or above
+        return static_cast<GLhalf>(sign | 0x7BFF);
+    }
+    if (magnitude < 0x38800000) {
+        // Below the smallest normal half float
+        return static_cast<GLhalf>(sign);
+    }
+
+    // Rebias the exponent from 127 to 15 and round the 13 dropped mantissa bits
+    const u32 rounded = magnitude - 0x38000000 + 0xFFF + ((magnitude >> 13) & 1);
+    return static_cast<GLhalf>(sign | (rounded >> 13));
+}
+
+RasterizerOpenGL::HardwareVertex::HardwareVertex(const Pica::Shader::OutputVertex& v,
+                                                 bool flip_quaternion) {
+    position[0] = v.pos.x.ToFloat32();
+    position[1] = v.pos.y.ToFloat32();
+    position[2] = v.pos.z.ToFloat32();
+    position[3] = v.pos.w.ToFloat32();
+    // The color is already saturated to [0, 1]
+    for (int i = 0; i < 4; ++i) {
+        color[i] = static_cast<GLubyte>(v.color[i].ToFloat32() * 255.0f + 0.5f);
+    }
+    tex_coord0[0] = v.tc0.x.ToFloat32();
+    tex_coord0[1] = v.tc0.y.ToFloat32();
+    tex_coord1[0] = v.tc1.x.ToFloat32();
+    tex_coord1[1] = v.tc1.y.ToFloat32();
+    tex_coord2[0] = v.tc2.x.ToFloat32();
+    tex_coord2[1] = v.tc2.y.ToFloat32();
+    tex_coord0_w = v.tc0_w.ToFloat32();
+    const float quat_sign = flip_quaternion ? -1.0f : 1.0f;
+    for (int i = 0; i < 4; ++i) {
+        normquat[i] = FloatToHalf(v.quat[i].ToFloat32() * quat_sign);
+    }
+    for (int i = 0; i < 3; ++i) {
+        view[i] = FloatToHalf(v.view[i].ToFloat32());
+    }
+    view[3] = 0;
+}
 
 /**
  * This is a helper function to resolve an issue when interpolating opposite quaternions. See below
@@ -208,16 +329,435 @@ static bool AreQuaternionsOpposite(Math::Vec4<Pica::float24> qa, Math::Vec4<Pica
 void RasterizerOpenGL::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                    const Pica::Shader::OutputVertex& v1,
                                    const Pica::Shader::OutputVertex& v2) {
-    vertex_batch.emplace_back(v0, false);
-    vertex_batch.emplace_back(v1, AreQuaternionsOpposite(v0.quat, v1.quat));
-    vertex_batch.emplace_back(v2, AreQuaternionsOpposite(v0.quat, v2.quat));
+    if (index_batch_size + 3 > MAX_BATCH_VERTICES) {
+        // The mapped range is full, draw what has been batched so far and start over
+        DrawTriangles();
+    }
+
+    if (vertex_batch == nullptr && !MapTriangleBatch()) {
+        return;
+    }
+
+    GLushort* indices = index_batch + index_batch_size;
+    indices[0] = AddBatchVertex(HardwareVertex(v0, false));
+    indices[1] = AddBatchVertex(HardwareVertex(v1, AreQuaternionsOpposite(v0.quat, v1.quat)));
+    indices[2] = AddBatchVertex(HardwareVertex(v2, AreQuaternionsOpposite(v0.quat, v2.quat)));
+    index_batch_size += 3;
+}
+
+bool RasterizerOpenGL::MapTriangleBatch() {
+    // Mapping binds the index buffer to the element array binding of the bound vertex array
+    state.draw.vertex_array = vertex_array.handle;
+    state.draw.vertex_buffer = vertex_buffer.GetHandle();
+    state.Apply();
+
+    u8* pointer;
+    std::tie(pointer, vertex_batch_offset, std::ignore) =
+        vertex_buffer.Map(MAX_BATCH_VERTICES * sizeof(HardwareVertex), sizeof(HardwareVertex));
+    if (pointer == nullptr) {
+        LOG_ERROR(Render_OpenGL, "Failed to map the vertex buffer");
+        return false;
+    }
+    vertex_batch = reinterpret_cast<HardwareVertex*>(pointer);
+
+    std::tie(pointer, index_batch_offset, std::ignore) =
+        index_buffer.Map(MAX_BATCH_VERTICES * sizeof(GLushort), sizeof(GLushort));
+    if (pointer == nullptr) {
+        LOG_ERROR(Render_OpenGL, "Failed to map the index buffer");
+        vertex_buffer.Unmap(0);
+        vertex_batch = nullptr;
+        return false;
+    }
+    index_batch = reinterpret_cast<GLushort*>(pointer);
+
+    // No index refers to a vertex of the new batch yet
+    recent_vertex_indices.fill(0xFFFF);
+    return true;
+}
+
+GLushort RasterizerOpenGL::AddBatchVertex(const HardwareVertex& vertex) {
+    u32 position[4];
+    std::memcpy(position, vertex.position, sizeof(position));
+    u32 hash = position[0] ^ position[1] * 31 ^ position[2] * 961 ^ position[3] * 29791;
+    hash ^= hash >> 16;
+    hash ^= hash >> 8;
+    const size_t slot = hash % RECENT_VERTEX_COUNT;
+
+    // The copy is compared rather than the batch itself, which is slow to read back from
+    if (recent_vertex_indices[slot] != 0xFFFF &&
+        std::memcmp(&recent_vertices[slot], &vertex, sizeof(HardwareVertex)) == 0) {
+        return recent_vertex_indices[slot];
+    }
+
+    const GLushort index = static_cast<GLushort>(vertex_batch_size++);
+    vertex_batch[index] = vertex;
+    recent_vertices[slot] = vertex;
+    recent_vertex_indices[slot] = index;
+    return index;
 }
 
 void RasterizerOpenGL::DrawTriangles() {
-    if (vertex_batch.empty())
+    if (index_batch_size == 0)
+        return;
+
+    if (IsDrawElided()) {
+        vertex_buffer.Unmap(0);
+        index_buffer.Unmap(0);
+        vertex_batch = nullptr;
+        vertex_batch_size = 0;
+        index_batch = nullptr;
+        index_batch_size = 0;
+        return;
+    }
+
+    Draw(false);
+}
+
+void RasterizerOpenGL::SetFrameSkipped(bool skipped) {
+    frame_skipped = skipped;
+}
+
+bool RasterizerOpenGL::IsDrawElided() {
+    if (!frame_skipped)
+        return false;
+
+    // Only the memory of the framebuffers is checked, so that dropped draws don't create or load
+    // surfaces. Framebuffers the CPU has read back before are still drawn to, since the
+    // application may depend on their contents.
+    const auto& config = Pica::g_state.regs.framebuffer.framebuffer;
+    const u32 area = config.GetWidth() * config.GetHeight();
+    const PAddr color_addr = config.GetColorBufferPhysicalAddress();
+    const u32 color_size =
+        area * GPU::Regs::BytesPerPixel(GPU::Regs::PixelFormat(config.color_format.Value()));
+    const PAddr depth_addr = config.GetDepthBufferPhysicalAddress();
+    const u32 depth_size = area * Pica::FramebufferRegs::BytesPerDepthPixel(config.depth_format);
+    return (color_addr == 0 || !res_cache.IsRegionReadBack(color_addr, color_size)) &&
+           (depth_addr == 0 || !res_cache.IsRegionReadBack(depth_addr, depth_size));
+}
+
+bool RasterizerOpenGL::AccelerateDrawBatch(bool is_indexed) {
+    if (!SetupVertexShader()) {
+        return false;
+    }
+
+    // Triangles the software path queued before this batch have to be drawn first
+    DrawTriangles();
+
+    if (IsDrawElided()) {
+        return true;
+    }
+
+    state.draw.vertex_array = hw_vertex_array.handle;
+    state.draw.vertex_buffer = hw_vertex_buffer.GetHandle();
+    state.Apply();
+
+    if (!SetupVertexArray(is_indexed)) {
+        return false;
+    }
+
+    if (hw_draw.count != 0) {
+        SyncVSUniforms();
+        Draw(true);
+    }
+    return true;
+}
+
+bool RasterizerOpenGL::SetupVertexShader() {
+    if (vs_config_dirty) {
+        const auto config = GLShader::PicaVSConfig::BuildFromRegs(Pica::g_state.regs,
+                                                                  Pica::g_state.vs);
+        auto cached_vs = hw_vs_cache.find(config);
+        if (cached_vs == hw_vs_cache.end()) {
+            cached_vs = hw_vs_cache.emplace(config, HWVertexShader{}).first;
+            cached_vs->second.source = GLShader::GenerateVertexShader(Pica::g_state.vs, config);
+            if (!cached_vs->second.source) {
+                LOG_INFO(Render_OpenGL,
+                         "Vertex shader %016" PRIx64 " can't run on the GPU, using the software "
+                         "vertex path for it",
+                         config.state.program_hash);
+            }
+        }
+
+        current_hw_vs = &cached_vs->second;
+        vs_config_dirty = false;
+    }
+
+    return current_hw_vs->source.is_initialized();
+}
+
+bool RasterizerOpenGL::SetupVertexArray(bool is_indexed) {
+    MICROPROFILE_SCOPE(OpenGL_VAO);
+    using Pica::PipelineRegs;
+
+    const auto& regs = Pica::g_state.regs;
+    const auto& vertex_attributes = regs.pipeline.vertex_attributes;
+    const PAddr base_address = vertex_attributes.GetPhysicalBaseAddress();
+    const u32 num_vertices = regs.pipeline.num_vertices;
+
+    switch (regs.pipeline.triangle_topology) {
+    case PipelineRegs::TriangleTopology::Strip:
+        hw_draw.mode = GL_TRIANGLE_STRIP;
+        break;
+    case PipelineRegs::TriangleTopology::Fan:
+        hw_draw.mode = GL_TRIANGLE_FAN;
+        break;
+    default:
+        // Like the primitive assembler, geometry shader topologies are drawn as plain lists
+        hw_draw.mode = GL_TRIANGLES;
+        break;
+    }
+    hw_draw.count = static_cast<GLsizei>(num_vertices);
+    hw_draw.is_indexed = is_indexed;
+    hw_draw.base_vertex = 0;
+
+    if (num_vertices == 0) {
+        return true;
+    }
+
+    // Indexed rendering doesn't use the start offset
+    u32 vertex_min = regs.pipeline.vertex_offset;
+    u32 vertex_max = vertex_min + num_vertices - 1;
+
+    if (is_indexed) {
+        const auto& index_info = regs.pipeline.index_array;
+        const bool index_u16 = index_info.format != 0;
+        const u8* index_data = Memory::GetPhysicalPointer(base_address + index_info.offset);
+        if (index_data == nullptr) {
+            return false;
+        }
+
+        vertex_min = 0xFFFF;
+        vertex_max = 0;
+        for (u32 index = 0; index < num_vertices; ++index) {
+            u32 vertex;
+            if (index_u16) {
+                u16 vertex16;
+                std::memcpy(&vertex16, index_data + index * sizeof(u16), sizeof(u16));
+                vertex = vertex16;
+            } else {
+                vertex = index_data[index];
+            }
+            vertex_min = std::min(vertex_min, vertex);
+            vertex_max = std::max(vertex_max, vertex);
+        }
+
+        const GLsizeiptr index_size = num_vertices * (index_u16 ? sizeof(u16) : sizeof(u8));
+        u8* index_pointer;
+        GLintptr index_offset;
+        std::tie(index_pointer, index_offset, std::ignore) = hw_index_buffer.Map(index_size, 4);
+        if (index_pointer == nullptr) {
+            return false;
+        }
+        std::memcpy(index_pointer, index_data, index_size);
+        hw_index_buffer.Unmap(index_size);
+
+        hw_draw.index_type = index_u16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+        hw_draw.index_offset = index_offset;
+        hw_draw.base_vertex = -static_cast<GLint>(vertex_min);
+    }
+
+    const u32 vertex_count = vertex_max - vertex_min + 1;
+
+    // Resolve which loader feeds each attribute, with the same layout rules as the VertexLoader
+    std::array<int, 12> attribute_loader;
+    std::array<u32, 12> attribute_offset{};
+    attribute_loader.fill(-1);
+    GLsizeiptr upload_size = 0;
+    for (int loader = 0; loader < 12; ++loader) {
+        const auto& loader_config = vertex_attributes.attribute_loaders[loader];
+        if (loader_config.component_count == 0) {
+            continue;
+        }
+
+        // A zero stride repeats the same data for every vertex, which GL can't express
+        if (loader_config.byte_count == 0) {
+            return false;
+        }
+
+        u32 offset = 0;
+        const u32 num_components = std::min<u32>(loader_config.component_count, 12);
+        for (u32 component = 0; component < num_components; ++component) {
+            const u32 attribute_index = loader_config.GetComponent(component);
+            if (attribute_index < 12) {
+                offset = Common::AlignUp(offset,
+                                         vertex_attributes.GetElementSizeInBytes(attribute_index));
+                attribute_loader[attribute_index] = loader;
+                attribute_offset[attribute_index] = offset;
+                offset += vertex_attributes.GetStride(attribute_index);
+            } else {
+                // Attribute ids 12 to 15 are 4 to 16-byte paddings
+                offset = Common::AlignUp(offset, 4);
+                offset += (attribute_index - 11) * 4;
+            }
+        }
+
+        upload_size += Common::AlignUp(loader_config.byte_count * vertex_count, 4);
+    }
+
+    // Copy the vertex range the draw touches out of each loader's array
+    std::array<GLintptr, 12> loader_offset{};
+    if (upload_size != 0) {
+        u8* vertex_pointer;
+        GLintptr vertex_offset;
+        std::tie(vertex_pointer, vertex_offset, std::ignore) =
+            hw_vertex_buffer.Map(upload_size, 4);
+        if (vertex_pointer == nullptr) {
+            return false;
+        }
+
+        GLsizeiptr used_size = 0;
+        for (int loader = 0; loader < 12; ++loader) {
+            const auto& loader_config = vertex_attributes.attribute_loaders[loader];
+            if (loader_config.component_count == 0) {
+                continue;
+            }
+
+            const u32 stride = loader_config.byte_count;
+            const u8* data = Memory::GetPhysicalPointer(base_address + loader_config.data_offset +
+                                                        vertex_min * stride);
+            if (data == nullptr) {
+                hw_vertex_buffer.Unmap(0);
+                return false;
+            }
+
+            const u32 size = stride * vertex_count;
+            std::memcpy(vertex_pointer + used_size, data, size);
+            loader_offset[loader] = vertex_offset + used_size;
+            used_size += Common::AlignUp(size, 4);
+        }
+        hw_vertex_buffer.Unmap(used_size);
+    }
+
+    // Point every input register at its attribute. The attributes are applied in order, so that
+    // like in the shader unit, the last one mapped to a register wins.
+    for (GLuint location = 0; location < 16; ++location) {
+        glDisableVertexAttribArray(location);
+    }
+
+    const int num_attributes = vertex_attributes.GetNumTotalAttributes();
+    for (int attribute = 0; attribute < num_attributes; ++attribute) {
+        const GLuint location = regs.vs.GetRegisterForAttribute(attribute);
+
+        const int loader = attribute_loader[attribute];
+        if (loader != -1) {
+            GLenum type;
+            switch (vertex_attributes.GetFormat(attribute)) {
+            case PipelineRegs::VertexAttributeFormat::BYTE:
+                type = GL_BYTE;
+                break;
+            case PipelineRegs::VertexAttributeFormat::UBYTE:
+                type = GL_UNSIGNED_BYTE;
+                break;
+            case PipelineRegs::VertexAttributeFormat::SHORT:
+                type = GL_SHORT;
+                break;
+            default:
+                type = GL_FLOAT;
+                break;
+            }
+
+            const GLintptr offset = loader_offset[loader] + attribute_offset[attribute];
+            glVertexAttribPointer(location, vertex_attributes.GetNumElements(attribute), type,
+                                  GL_FALSE, vertex_attributes.attribute_loaders[loader].byte_count,
+                                  reinterpret_cast<const GLvoid*>(offset));
+            glEnableVertexAttribArray(location);
+        } else if (vertex_attributes.IsDefaultAttribute(attribute)) {
+            const auto& value = Pica::g_state.input_default_attributes.attr[attribute];
+            glVertexAttrib4f(location, value.x.ToFloat32(), value.y.ToFloat32(),
+                             value.z.ToFloat32(), value.w.ToFloat32());
+        }
+    }
+
+    return true;
+}
+
+void RasterizerOpenGL::SyncVSUniforms() {
+    if (!vs_uniforms_dirty) {
         return;
+    }
+
+    const auto& uniforms = Pica::g_state.vs.uniforms;
 
+    u8* pointer;
+    GLintptr offset;
+    std::tie(pointer, offset, std::ignore) =
+        vs_uniform_buffer.Map(sizeof(VSUniformData), uniform_buffer_alignment);
+    if (pointer == nullptr) {
+        LOG_ERROR(Render_OpenGL, "Failed to map the vertex shader uniform buffer");
+        return;
+    }
+
+    VSUniformData* data = reinterpret_cast<VSUniformData*>(pointer);
+    for (size_t index = 0; index < ARRAY_SIZE(uniforms.f); ++index) {
+        const auto& value = uniforms.f[index];
+        data->f[index] = {value.x.ToFloat32(), value.y.ToFloat32(), value.z.ToFloat32(),
+                          value.w.ToFloat32()};
+    }
+    for (size_t index = 0; index < uniforms.i.size(); ++index) {
+        const auto& value = uniforms.i[index];
+        data->i[index] = {value.x, value.y, value.z, value.w};
+    }
+    data->b = 0;
+    for (size_t index = 0; index < uniforms.b.size(); ++index) {
+        data->b |= uniforms.b[index] ? (1u << index) : 0;
+    }
+
+    vs_uniform_buffer.Unmap(sizeof(VSUniformData));
+    glBindBufferRange(GL_UNIFORM_BUFFER, 1, vs_uniform_buffer.GetHandle(), offset,
+                      sizeof(VSUniformData));
+    vs_uniforms_dirty = false;
+}
+
+void RasterizerOpenGL::SyncClipPlane() {
+    if (!clip_dirty) {
+        return;
+    }
+
+    const auto& regs = Pica::g_state.regs.rasterizer;
+
+    u8* pointer;
+    GLintptr offset;
+    std::tie(pointer, offset, std::ignore) =
+        clip_uniform_buffer.Map(sizeof(ClipUniformData), uniform_buffer_alignment);
+    if (pointer == nullptr) {
+        LOG_ERROR(Render_OpenGL, "Failed to map the clipping uniform buffer");
+        return;
+    }
+
+    // Zero coefficients make every point pass the plane, which disables it without a branch in
+    // the shader
+    ClipUniformData* data = reinterpret_cast<ClipUniformData*>(pointer);
+    for (size_t i = 0; i < data->clip_coef.size(); ++i) {
+        data->clip_coef[i] =
+            regs.clip_enable ? Pica::float24::FromRaw(regs.clip_coef[i]).ToFloat32() : 0.0f;
+    }
+
+    clip_uniform_buffer.Unmap(sizeof(ClipUniformData));
+    glBindBufferRange(GL_UNIFORM_BUFFER, 3, clip_uniform_buffer.GetHandle(), offset,
+                      sizeof(ClipUniformData));
+    clip_dirty = false;
+}
+
+void RasterizerOpenGL::Draw(bool accelerate) {
     MICROPROFILE_SCOPE(OpenGL_Drawing);
+
+    GLint first_vertex = 0;
+    GLuint vertex_count = 0;
+    GLintptr index_offset = 0;
+    GLsizei index_count = 0;
+    if (!accelerate) {
+        // Commit the batched vertices and indices, the buffers can't be drawn from while mapped
+        vertex_buffer.Unmap(vertex_batch_size * sizeof(HardwareVertex));
+        index_buffer.Unmap(index_batch_size * sizeof(GLushort));
+        first_vertex = static_cast<GLint>(vertex_batch_offset / sizeof(HardwareVertex));
+        vertex_count = static_cast<GLuint>(vertex_batch_size);
+        index_offset = index_batch_offset;
+        index_count = static_cast<GLsizei>(index_batch_size);
+        vertex_batch = nullptr;
+        vertex_batch_size = 0;
+        index_batch = nullptr;
+        index_batch_size = 0;
+    }
     const auto& regs = Pica::g_state.regs;
 
     // Sync and bind the framebuffer surfaces
@@ -247,11 +787,17 @@ void RasterizerOpenGL::DrawTriangles() {
     GLsizei viewport_height =
         (GLsizei)Pica::float24::FromRaw(regs.rasterizer.viewport_size_y).ToFloat32() * 2;
 
-    glViewport(
-        (GLint)(rect.left + regs.rasterizer.viewport_corner.x * color_surface->res_scale_width),
-        (GLint)(rect.bottom + regs.rasterizer.viewport_corner.y * color_surface->res_scale_height),
-        (GLsizei)(viewport_width * color_surface->res_scale_width),
-        (GLsizei)(viewport_height * color_surface->res_scale_height));
+    GLint viewport_x =
+        (GLint)(rect.left + regs.rasterizer.viewport_corner.x * color_surface->res_scale_width);
+    GLint viewport_y =
+        (GLint)(rect.bottom + regs.rasterizer.viewport_corner.y * color_surface->res_scale_height);
+    GLsizei scaled_viewport_width = (GLsizei)(viewport_width * color_surface->res_scale_width);
+    GLsizei scaled_viewport_height = (GLsizei)(viewport_height * color_surface->res_scale_height);
+
+    glViewport(viewport_x, viewport_y, scaled_viewport_width, scaled_viewport_height);
+
+    const MathUtil::Rectangle<int> viewport_rect(viewport_x, viewport_y + scaled_viewport_height,
+                                                 viewport_x + scaled_viewport_width, viewport_y);
 
     if (uniform_block_data.data.framebuffer_scale[0] != color_surface->res_scale_width ||
         uniform_block_data.data.framebuffer_scale[1] != color_surface->res_scale_height) {
@@ -292,7 +838,7 @@ void RasterizerOpenGL::DrawTriangles() {
         const auto& texture = pica_textures[texture_index];
 
         if (texture.enabled) {
-            texture_samplers[texture_index].SyncWithConfig(texture.config);
+            state.texture_units[texture_index].sampler = GetSampler(texture.config);
             CachedSurface* surface = res_cache.GetTextureSurface(texture);
             if (surface != nullptr) {
                 state.texture_units[texture_index].texture_2d = surface->texture.handle;
@@ -305,83 +851,79 @@ void RasterizerOpenGL::DrawTriangles() {
         }
     }
 
-    // Sync and bind the shader
-    if (shader_dirty) {
-        SetShader();
-        shader_dirty = false;
-    }
-
-    // Sync the lighting luts
-    for (unsigned index = 0; index < uniform_block_data.lut_dirty.size(); index++) {
-        if (uniform_block_data.lut_dirty[index]) {
-            SyncLightingLUT(index);
-            uniform_block_data.lut_dirty[index] = false;
+    // Sync and bind the shader. Switching between the software and the hardware vertex path
+    // needs a different program even if the PICA state didn't change.
+    const HWVertexShader* vertex_shader = accelerate ? current_hw_vs : nullptr;
+    if (shader_dirty || vertex_shader != current_shader_vs) {
+        if (accelerate) {
+            SetHWShader();
+        } else {
+            SetShader();
         }
+        current_shader_vs = vertex_shader;
+        // Keep polling until the asynchronously built program of this state is available
+        shader_dirty = shader_pending;
     }
 
-    // Sync the fog lut
-    if (uniform_block_data.fog_lut_dirty) {
-        SyncFogLUT();
-        uniform_block_data.fog_lut_dirty = false;
-    }
-
-    // Sync the proctex noise lut
-    if (uniform_block_data.proctex_noise_lut_dirty) {
-        SyncProcTexNoiseLUT();
-        uniform_block_data.proctex_noise_lut_dirty = false;
-    }
-
-    // Sync the proctex color map
-    if (uniform_block_data.proctex_color_map_dirty) {
-        SyncProcTexColorMap();
-        uniform_block_data.proctex_color_map_dirty = false;
-    }
-
-    // Sync the proctex alpha map
-    if (uniform_block_data.proctex_alpha_map_dirty) {
-        SyncProcTexAlphaMap();
-        uniform_block_data.proctex_alpha_map_dirty = false;
-    }
+    // Sync the lookup tables
+    UploadLookupTables();
 
-    // Sync the proctex lut
-    if (uniform_block_data.proctex_lut_dirty) {
-        SyncProcTexLUT();
-        uniform_block_data.proctex_lut_dirty = false;
-    }
-
-    // Sync the proctex difference lut
-    if (uniform_block_data.proctex_diff_lut_dirty) {
-        SyncProcTexDiffLUT();
-        uniform_block_data.proctex_diff_lut_dirty = false;
-    }
+    SyncClipPlane();
 
     // Sync the uniform data
     if (uniform_block_data.dirty) {
-        glBufferData(GL_UNIFORM_BUFFER, sizeof(UniformData), &uniform_block_data.data,
-                     GL_STATIC_DRAW);
-        uniform_block_data.dirty = false;
+        u8* uniforms;
+        GLintptr uniforms_offset;
+        std::tie(uniforms, uniforms_offset, std::ignore) =
+            uniform_buffer.Map(sizeof(UniformData), uniform_buffer_alignment);
+        if (uniforms == nullptr) {
+            LOG_ERROR(Render_OpenGL, "Failed to map the uniform buffer");
+        } else {
+            std::memcpy(uniforms, &uniform_block_data.data, sizeof(UniformData));
+            uniform_buffer.Unmap(sizeof(UniformData));
+            glBindBufferRange(GL_UNIFORM_BUFFER, 0, uniform_buffer.GetHandle(), uniforms_offset,
+                              sizeof(UniformData));
+            uniform_block_data.dirty = false;
+        }
     }
 
+    state.draw.vertex_array = accelerate ? hw_vertex_array.handle : vertex_array.handle;
+    state.draw.vertex_buffer =
+        accelerate ? hw_vertex_buffer.GetHandle() : vertex_buffer.GetHandle();
     state.Apply();
 
-    // Draw the vertex batch
-    glBufferData(GL_ARRAY_BUFFER, vertex_batch.size() * sizeof(HardwareVertex), vertex_batch.data(),
-                 GL_STREAM_DRAW);
-    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertex_batch.size());
+    {
+        GLTimerQueries::ScopedTimer gpu_timer(Core::PerfStats::GPUCategory::Drawing,
+                                              current_shader_hash);
+        if (!accelerate) {
+            // Draw the vertex batch. Other vertex arrays may have been bound while the index
+            // buffer was unmapped, so its binding is restored first.
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer.GetHandle());
+            glDrawRangeElementsBaseVertex(GL_TRIANGLES, 0, vertex_count - 1, index_count,
+                                          GL_UNSIGNED_SHORT,
+                                          reinterpret_cast<const GLvoid*>(index_offset),
+                                          first_vertex);
+        } else if (hw_draw.is_indexed) {
+            glDrawElementsBaseVertex(hw_draw.mode, hw_draw.count, hw_draw.index_type,
+                                     reinterpret_cast<const GLvoid*>(hw_draw.index_offset),
+                                     hw_draw.base_vertex);
+        } else {
+            glDrawArrays(hw_draw.mode, 0, hw_draw.count);
+        }
+    }
 
-    // Mark framebuffer surfaces as dirty
+    // Mark framebuffer surfaces as dirty. Only the rows covered by the viewport can have changed,
+    // so limit later write-backs to those.
     // TODO: Restrict invalidation area to the viewport
     if (color_surface != nullptr) {
-        color_surface->dirty = true;
+        res_cache.MarkSurfaceDirty(color_surface, viewport_rect);
         res_cache.FlushRegion(color_surface->addr, color_surface->size, color_surface, true);
     }
     if (depth_surface != nullptr) {
-        depth_surface->dirty = true;
+        res_cache.MarkSurfaceDirty(depth_surface, viewport_rect);
         res_cache.FlushRegion(depth_surface->addr, depth_surface->size, depth_surface, true);
     }
 
-    vertex_batch.clear();
-
     // Unbind textures for potential future use as framebuffer attachments
     for (unsigned texture_index = 0; texture_index < pica_textures.size(); ++texture_index) {
         state.texture_units[texture_index].texture_2d = 0;
@@ -398,6 +940,15 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
         SyncCullMode();
         break;
 
+    // User clipping plane
+    case PICA_REG_INDEX(rasterizer.clip_enable):
+    case PICA_REG_INDEX_WORKAROUND(rasterizer.clip_coef[0], 0x48):
+    case PICA_REG_INDEX_WORKAROUND(rasterizer.clip_coef[1], 0x49):
+    case PICA_REG_INDEX_WORKAROUND(rasterizer.clip_coef[2], 0x4a):
+    case PICA_REG_INDEX_WORKAROUND(rasterizer.clip_coef[3], 0x4b):
+        clip_dirty = true;
+        break;
+
     // Depth modifiers
     case PICA_REG_INDEX(rasterizer.viewport_depth_range):
         SyncDepthScale();
@@ -406,6 +957,53 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
         SyncDepthOffset();
         break;
 
+    // Vertex shader program and output mapping
+    case PICA_REG_INDEX(vs.main_offset):
+    case PICA_REG_INDEX(vs.output_mask):
+    case PICA_REG_INDEX(rasterizer.vs_output_total):
+    case PICA_REG_INDEX_WORKAROUND(rasterizer.vs_output_attributes[0], 0x50):
+    case PICA_REG_INDEX_WORKAROUND(rasterizer.vs_output_attributes[1], 0x51):
+    case PICA_REG_INDEX_WORKAROUND(rasterizer.vs_output_attributes[2], 0x52):
+    case PICA_REG_INDEX_WORKAROUND(rasterizer.vs_output_attributes[3], 0x53):
+    case PICA_REG_INDEX_WORKAROUND(rasterizer.vs_output_attributes[4], 0x54):
+    case PICA_REG_INDEX_WORKAROUND(rasterizer.vs_output_attributes[5], 0x55):
+    case PICA_REG_INDEX_WORKAROUND(rasterizer.vs_output_attributes[6], 0x56):
+    case PICA_REG_INDEX_WORKAROUND(vs.program.set_word[0], 0x2cc):
+    case PICA_REG_INDEX_WORKAROUND(vs.program.set_word[1], 0x2cd):
+    case PICA_REG_INDEX_WORKAROUND(vs.program.set_word[2], 0x2ce):
+    case PICA_REG_INDEX_WORKAROUND(vs.program.set_word[3], 0x2cf):
+    case PICA_REG_INDEX_WORKAROUND(vs.program.set_word[4], 0x2d0):
+    case PICA_REG_INDEX_WORKAROUND(vs.program.set_word[5], 0x2d1):
+    case PICA_REG_INDEX_WORKAROUND(vs.program.set_word[6], 0x2d2):
+    case PICA_REG_INDEX_WORKAROUND(vs.program.set_word[7], 0x2d3):
+    case PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[0], 0x2d6):
+    case PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[1], 0x2d7):
+    case PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[2], 0x2d8):
+    case PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[3], 0x2d9):
+    case PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[4], 0x2da):
+    case PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[5], 0x2db):
+    case PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[6], 0x2dc):
+    case PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[7], 0x2dd):
+        vs_config_dirty = true;
+        break;
+
+    // Vertex shader uniforms
+    case PICA_REG_INDEX(vs.bool_uniforms):
+    case PICA_REG_INDEX_WORKAROUND(vs.int_uniforms[0], 0x2b1):
+    case PICA_REG_INDEX_WORKAROUND(vs.int_uniforms[1], 0x2b2):
+    case PICA_REG_INDEX_WORKAROUND(vs.int_uniforms[2], 0x2b3):
+    case PICA_REG_INDEX_WORKAROUND(vs.int_uniforms[3], 0x2b4):
+    case PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[0], 0x2c1):
+    case PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[1], 0x2c2):
+    case PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[2], 0x2c3):
+    case PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[3], 0x2c4):
+    case PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[4], 0x2c5):
+    case PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[5], 0x2c6):
+    case PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[6], 0x2c7):
+    case PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[7], 0x2c8):
+        vs_uniforms_dirty = true;
+        break;
+
     // Depth buffering
     case PICA_REG_INDEX(rasterizer.depthmap_enable):
         shader_dirty = true;
@@ -857,21 +1455,41 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
 }
 
 void RasterizerOpenGL::FlushAll() {
+    // Queued triangles may draw to, or read from, any surface
+    DrawTriangles();
+
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
     res_cache.FlushAll();
 }
 
 void RasterizerOpenGL::FlushRegion(PAddr addr, u32 size) {
+    DrawTriangles();
+
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    if (Settings::values.frame_skip > 0) {
+        res_cache.RecordReadBack(addr, size);
+    }
     res_cache.FlushRegion(addr, size, nullptr, false);
 }
 
 void RasterizerOpenGL::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    DrawTriangles();
+
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    if (Settings::values.frame_skip > 0) {
+        res_cache.RecordReadBack(addr, size);
+    }
     res_cache.FlushRegion(addr, size, nullptr, true);
 }
 
+void RasterizerOpenGL::PreloadRegion(PAddr addr, u32 size) {
+    MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    res_cache.PreloadRegion(addr, size);
+}
+
 bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) {
+    DrawTriangles();
+
     MICROPROFILE_SCOPE(OpenGL_Blits);
 
     CachedSurface src_params;
@@ -933,17 +1551,92 @@ bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransfe
 
     u32 dst_size = dst_params.width * dst_params.height *
                    CachedSurface::GetFormatBpp(dst_params.pixel_format) / 8;
-    dst_surface->dirty = true;
+    res_cache.MarkSurfaceDirty(dst_surface, dst_rect);
     res_cache.FlushRegion(config.GetPhysicalOutputAddress(), dst_size, dst_surface, true);
     return true;
 }
 
 bool RasterizerOpenGL::AccelerateTextureCopy(const GPU::Regs::DisplayTransferConfig& config) {
-    // TODO(tfarley): Try to hardware accelerate this
-    return false;
+    DrawTriangles();
+
+    MICROPROFILE_SCOPE(OpenGL_Blits);
+
+    const u32 copy_size = Common::AlignDown(config.texture_copy.size, 16);
+    if (copy_size == 0) {
+        return false;
+    }
+
+    // A zero gap means the data is contiguous, whatever the line width
+    u32 input_gap = config.texture_copy.input_gap * 16;
+    u32 input_width = config.texture_copy.input_width * 16;
+    if (input_gap == 0 || input_width >= copy_size) {
+        input_width = copy_size;
+        input_gap = 0;
+    }
+    u32 output_gap = config.texture_copy.output_gap * 16;
+    u32 output_width = config.texture_copy.output_width * 16;
+    if (output_gap == 0 || output_width >= copy_size) {
+        output_width = copy_size;
+        output_gap = 0;
+    }
+    if (input_width == 0 || output_width == 0 || copy_size % input_width != 0 ||
+        copy_size % output_width != 0) {
+        return false;
+    }
+
+    // Only copies of data the GPU already holds are worth doing there
+    MathUtil::Rectangle<int> src_rect;
+    CachedSurface* src_surface =
+        res_cache.TryGetTextureCopySurface(config.GetPhysicalInputAddress(), input_width,
+                                           input_width + input_gap, copy_size, nullptr, src_rect);
+    if (src_surface == nullptr) {
+        return false;
+    }
+
+    MathUtil::Rectangle<int> dst_rect;
+    CachedSurface* dst_surface = res_cache.TryGetTextureCopySurface(
+        config.GetPhysicalOutputAddress(), output_width, output_width + output_gap, copy_size,
+        src_surface, dst_rect);
+    if (dst_surface == nullptr && output_gap == 0) {
+        // The output is contiguous, so it can become a surface of its own
+        CachedSurface dst_params;
+        dst_params.addr = config.GetPhysicalOutputAddress();
+        dst_params.width = static_cast<u32>(src_rect.GetWidth() / src_surface->res_scale_width);
+        dst_params.height = static_cast<u32>(src_rect.GetHeight() / src_surface->res_scale_height);
+        dst_params.res_scale_width = src_surface->res_scale_width;
+        dst_params.res_scale_height = src_surface->res_scale_height;
+        dst_params.is_tiled = src_surface->is_tiled;
+        dst_params.pixel_format = src_surface->pixel_format;
+        dst_surface = res_cache.GetSurface(dst_params, true, false);
+        dst_rect = MathUtil::Rectangle<int>(0, 0, src_rect.GetWidth(), src_rect.GetHeight());
+        if (dst_params.is_tiled) {
+            // Tiled surfaces are flipped vertically in the rasterizer vs. 3DS memory.
+            std::swap(dst_rect.top, dst_rect.bottom);
+        }
+    }
+
+    // The copy preserves the bytes, so both sides need to lay out the pixels the same way
+    if (dst_surface == nullptr || dst_surface == src_surface ||
+        dst_surface->pixel_format != src_surface->pixel_format ||
+        dst_surface->is_tiled != src_surface->is_tiled ||
+        dst_rect.GetWidth() != src_rect.GetWidth() ||
+        dst_rect.GetHeight() != src_rect.GetHeight()) {
+        return false;
+    }
+
+    if (!res_cache.TryBlitSurfaces(src_surface, src_rect, dst_surface, dst_rect)) {
+        return false;
+    }
+
+    const u32 output_size = copy_size / output_width * (output_width + output_gap);
+    res_cache.MarkSurfaceDirty(dst_surface, dst_rect);
+    res_cache.FlushRegion(config.GetPhysicalOutputAddress(), output_size, dst_surface, true);
+    return true;
 }
 
 bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config) {
+    DrawTriangles();
+
     MICROPROFILE_SCOPE(OpenGL_Blits);
     using PixelFormat = CachedSurface::PixelFormat;
     using SurfaceType = CachedSurface::SurfaceType;
@@ -1082,7 +1775,7 @@ bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config)
     // TODO: Return scissor test to previous value when scissor test is implemented
     cur_state.Apply();
 
-    dst_surface->dirty = true;
+    res_cache.MarkSurfaceDirty(dst_surface);
     res_cache.FlushRegion(dst_surface->addr, dst_surface->size, dst_surface, true);
     return true;
 }
@@ -1122,158 +1815,273 @@ bool RasterizerOpenGL::AccelerateDisplay(const GPU::Regs::FramebufferConfig& con
     return true;
 }
 
-void RasterizerOpenGL::SamplerInfo::Create() {
-    sampler.Create();
-    mag_filter = min_filter = TextureConfig::Linear;
-    wrap_s = wrap_t = TextureConfig::Repeat;
-    border_color = 0;
+GLuint RasterizerOpenGL::GetSampler(const Pica::TexturingRegs::TextureConfig& config) {
+    using TextureConfig = Pica::TexturingRegs::TextureConfig;
+
+    // The border color only matters, and only tells samplers apart, when a coordinate clamps to it.
+    // Likewise for the level of detail state of textures without mipmap levels.
+    const bool uses_border = config.wrap_s == TextureConfig::ClampToBorder ||
+                             config.wrap_t == TextureConfig::ClampToBorder;
+    const u32 border_color = uses_border ? config.border_color.raw : 0;
+    const bool mipmapped = config.lod.max_level > 0;
+    const u32 lod = mipmapped ? static_cast<u32>(config.lod.bias & 0x1FFF) << 9 |
+                                    config.lod.max_level << 5 | config.lod.min_level << 1 |
+                                    static_cast<u32>(config.mip_filter.Value())
+                              : 0;
+    const u64 key = static_cast<u64>(border_color) << 32 | static_cast<u64>(lod) << 10 |
+                    static_cast<u32>(config.wrap_s.Value()) << 6 |
+                    static_cast<u32>(config.wrap_t.Value()) << 3 |
+                    static_cast<u32>(config.min_filter.Value()) << 1 |
+                    static_cast<u32>(config.mag_filter.Value());
+
+    auto cached = sampler_cache.find(key);
+    if (cached != sampler_cache.end()) {
+        return cached->second.handle;
+    }
 
-    glSamplerParameteri(sampler.handle, GL_TEXTURE_MIN_FILTER,
-                        GL_LINEAR); // default is GL_LINEAR_MIPMAP_LINEAR
-    // Other attributes have correct defaults
+    OGLSampler& sampler = sampler_cache[key];
+    sampler.Create();
+    const GLuint s = sampler.handle;
+    glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER, PicaToGL::TextureFilterMode(config.mag_filter));
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_S, PicaToGL::WrapMode(config.wrap_s));
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_T, PicaToGL::WrapMode(config.wrap_t));
+    if (uses_border) {
+        auto gl_color = PicaToGL::ColorRGBA8(border_color);
+        glSamplerParameterfv(s, GL_TEXTURE_BORDER_COLOR, gl_color.data());
+    }
+    if (mipmapped) {
+        glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER,
+                            PicaToGL::TextureMipFilterMode(config.min_filter, config.mip_filter));
+        glSamplerParameterf(s, GL_TEXTURE_MIN_LOD, static_cast<float>(config.lod.min_level));
+        glSamplerParameterf(s, GL_TEXTURE_MAX_LOD, static_cast<float>(config.lod.max_level));
+        glSamplerParameterf(s, GL_TEXTURE_LOD_BIAS, config.lod.bias / 256.0f);
+    } else {
+        glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER,
+                            PicaToGL::TextureFilterMode(config.min_filter));
+    }
+    return s;
 }
 
-void RasterizerOpenGL::SamplerInfo::SyncWithConfig(
-    const Pica::TexturingRegs::TextureConfig& config) {
+void RasterizerOpenGL::SetShader() {
+    auto config = GLShader::PicaShaderConfig::BuildFromRegs(Pica::g_state.regs);
+    current_shader_hash = std::hash<GLShader::PicaShaderConfig>{}(config);
+    shader_pending = false;
+
+    if (Settings::values.use_ubershader) {
+        SetUbershader(config);
+        return;
+    }
+
+    std::unique_ptr<PicaShader> shader = std::make_unique<PicaShader>();
+
+    if (shader_compiler != nullptr) {
+        CollectCompiledShaders();
+    }
+
+    // Find (or generate) the GLSL shader for the current TEV state
+    auto cached_shader = shader_cache.find(config);
+    if (cached_shader != shader_cache.end()) {
+        current_shader = cached_shader->second.get();
+
+        state.draw.shader_program = current_shader->shader.handle;
+        state.Apply();
+    } else if (shader_compiler != nullptr) {
+        if (!shader_compiler->IsPending(config)) {
+            LOG_DEBUG(Render_OpenGL, "Queueing new shader");
 
-    GLuint s = sampler.handle;
+            shader_compiler->Queue(config, GLShader::GenerateVertexShader(),
+                                   GLShader::GenerateFragmentShader(config));
+            VideoCore::g_pending_shader_compiles = static_cast<u32>(shader_compiler->NumPending());
+        }
+        SetUbershader(config);
+        shader_pending = true;
+    } else {
+        LOG_DEBUG(Render_OpenGL, "Creating new shader");
+
+        shader->shader.Create(GLShader::GenerateVertexShader().c_str(),
+                              GLShader::GenerateFragmentShader(config).c_str());
 
-    if (mag_filter != config.mag_filter) {
-        mag_filter = config.mag_filter;
-        glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER, PicaToGL::TextureFilterMode(mag_filter));
+        current_shader = shader_cache.emplace(config, std::move(shader)).first->second.get();
+        SetupShaderProgram(current_shader->shader.handle);
+        shader_disk_cache.Save(config, current_shader->shader.handle);
     }
-    if (min_filter != config.min_filter) {
-        min_filter = config.min_filter;
-        glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER, PicaToGL::TextureFilterMode(min_filter));
+}
+
+void RasterizerOpenGL::SetUbershader(const GLShader::PicaShaderConfig& config) {
+    if (ubershader.shader.handle == 0) {
+        LOG_DEBUG(Render_OpenGL, "Creating fragment ubershader");
+
+        ubershader.shader.Create(GLShader::GenerateVertexShader().c_str(),
+                                 GLShader::GenerateFragmentUbershader().c_str());
+        ubershader_config_buffer.Create(UBERSHADER_CONFIG_BUFFER_SIZE);
+        SetupShaderProgram(ubershader.shader.handle);
     }
 
-    if (wrap_s != config.wrap_s) {
-        wrap_s = config.wrap_s;
-        glSamplerParameteri(s, GL_TEXTURE_WRAP_S, PicaToGL::WrapMode(wrap_s));
+    current_shader = &ubershader;
+    state.draw.shader_program = ubershader.shader.handle;
+    state.Apply();
+
+    // The block only changes along with the shader configuration, so re-uploads are rare even
+    // while standing in for pending programs
+    if (ubershader_config_valid && ubershader_config == config) {
+        return;
     }
-    if (wrap_t != config.wrap_t) {
-        wrap_t = config.wrap_t;
-        glSamplerParameteri(s, GL_TEXTURE_WRAP_T, PicaToGL::WrapMode(wrap_t));
+
+    u8* pointer;
+    GLintptr offset;
+    std::tie(pointer, offset, std::ignore) = ubershader_config_buffer.Map(
+        sizeof(GLShader::UbershaderConfig), uniform_buffer_alignment);
+    if (pointer == nullptr) {
+        LOG_ERROR(Render_OpenGL, "Failed to map the ubershader configuration buffer");
+        return;
     }
+    const GLShader::UbershaderConfig data = GLShader::UbershaderConfig::BuildFromConfig(config);
+    std::memcpy(pointer, &data, sizeof(GLShader::UbershaderConfig));
+    ubershader_config_buffer.Unmap(sizeof(GLShader::UbershaderConfig));
+    glBindBufferRange(GL_UNIFORM_BUFFER, 2, ubershader_config_buffer.GetHandle(), offset,
+                      sizeof(GLShader::UbershaderConfig));
+
+    ubershader_config = config;
+    ubershader_config_valid = true;
+}
 
-    if (wrap_s == TextureConfig::ClampToBorder || wrap_t == TextureConfig::ClampToBorder) {
-        if (border_color != config.border_color.raw) {
-            border_color = config.border_color.raw;
-            auto gl_color = PicaToGL::ColorRGBA8(border_color);
-            glSamplerParameterfv(s, GL_TEXTURE_BORDER_COLOR, gl_color.data());
+void RasterizerOpenGL::CollectCompiledShaders() {
+    for (const auto& result : shader_compiler->Collect()) {
+        std::unique_ptr<PicaShader> shader = std::make_unique<PicaShader>();
+        shader->shader.handle = result.program;
+        if (shader_cache.emplace(result.config, std::move(shader)).second) {
+            SetupShaderProgram(result.program);
+            shader_disk_cache.Save(result.config, result.program);
         }
     }
+    VideoCore::g_pending_shader_compiles = static_cast<u32>(shader_compiler->NumPending());
 }
 
-void RasterizerOpenGL::SetShader() {
+void RasterizerOpenGL::SetHWShader() {
     auto config = GLShader::PicaShaderConfig::BuildFromRegs(Pica::g_state.regs);
-    std::unique_ptr<PicaShader> shader = std::make_unique<PicaShader>();
+    current_shader_hash = std::hash<GLShader::PicaShaderConfig>{}(config);
+    shader_pending = false;
+    auto& programs = current_hw_vs->programs;
 
-    // Find (or generate) the GLSL shader for the current TEV state
-    auto cached_shader = shader_cache.find(config);
-    if (cached_shader != shader_cache.end()) {
+    auto cached_shader = programs.find(config);
+    if (cached_shader != programs.end()) {
         current_shader = cached_shader->second.get();
 
         state.draw.shader_program = current_shader->shader.handle;
         state.Apply();
     } else {
-        LOG_DEBUG(Render_OpenGL, "Creating new shader");
+        LOG_DEBUG(Render_OpenGL, "Creating new hardware vertex shader program");
 
-        shader->shader.Create(GLShader::GenerateVertexShader().c_str(),
+        std::unique_ptr<PicaShader> shader = std::make_unique<PicaShader>();
+        shader->shader.Create(current_hw_vs->source->c_str(),
+                              GLShader::GenerateFixedGeometryShader().c_str(),
                               GLShader::GenerateFragmentShader(config).c_str());
 
-        state.draw.shader_program = shader->shader.handle;
-        state.Apply();
+        current_shader = programs.emplace(config, std::move(shader)).first->second.get();
+        SetupShaderProgram(current_shader->shader.handle);
+    }
+}
 
-        // Set the texture samplers to correspond to different texture units
-        GLint uniform_tex = glGetUniformLocation(shader->shader.handle, "tex[0]");
-        if (uniform_tex != -1) {
-            glUniform1i(uniform_tex, TextureUnits::PicaTexture(0).id);
-        }
-        uniform_tex = glGetUniformLocation(shader->shader.handle, "tex[1]");
-        if (uniform_tex != -1) {
-            glUniform1i(uniform_tex, TextureUnits::PicaTexture(1).id);
-        }
-        uniform_tex = glGetUniformLocation(shader->shader.handle, "tex[2]");
-        if (uniform_tex != -1) {
-            glUniform1i(uniform_tex, TextureUnits::PicaTexture(2).id);
-        }
+void RasterizerOpenGL::SetupShaderProgram(GLuint program) {
+    state.draw.shader_program = program;
+    state.Apply();
 
-        // Set the texture samplers to correspond to different lookup table texture units
-        GLint uniform_lut = glGetUniformLocation(shader->shader.handle, "lighting_lut");
-        if (uniform_lut != -1) {
-            glUniform1i(uniform_lut, TextureUnits::LightingLUT.id);
-        }
+    // Set the texture samplers to correspond to different texture units
+    GLint uniform_tex = glGetUniformLocation(program, "tex[0]");
+    if (uniform_tex != -1) {
+        glUniform1i(uniform_tex, TextureUnits::PicaTexture(0).id);
+    }
+    uniform_tex = glGetUniformLocation(program, "tex[1]");
+    if (uniform_tex != -1) {
+        glUniform1i(uniform_tex, TextureUnits::PicaTexture(1).id);
+    }
+    uniform_tex = glGetUniformLocation(program, "tex[2]");
+    if (uniform_tex != -1) {
+        glUniform1i(uniform_tex, TextureUnits::PicaTexture(2).id);
+    }
 
-        GLint uniform_fog_lut = glGetUniformLocation(shader->shader.handle, "fog_lut");
-        if (uniform_fog_lut != -1) {
-            glUniform1i(uniform_fog_lut, TextureUnits::FogLUT.id);
-        }
+    // Set the texture samplers to correspond to different lookup table texture units
+    GLint uniform_lut = glGetUniformLocation(program, "lighting_lut");
+    if (uniform_lut != -1) {
+        glUniform1i(uniform_lut, TextureUnits::LightingLUT.id);
+    }
 
-        GLint uniform_proctex_noise_lut =
-            glGetUniformLocation(shader->shader.handle, "proctex_noise_lut");
-        if (uniform_proctex_noise_lut != -1) {
-            glUniform1i(uniform_proctex_noise_lut, TextureUnits::ProcTexNoiseLUT.id);
-        }
+    GLint uniform_fog_lut = glGetUniformLocation(program, "fog_lut");
+    if (uniform_fog_lut != -1) {
+        glUniform1i(uniform_fog_lut, TextureUnits::FogLUT.id);
+    }
 
-        GLint uniform_proctex_color_map =
-            glGetUniformLocation(shader->shader.handle, "proctex_color_map");
-        if (uniform_proctex_color_map != -1) {
-            glUniform1i(uniform_proctex_color_map, TextureUnits::ProcTexColorMap.id);
-        }
+    GLint uniform_proctex_noise_lut = glGetUniformLocation(program, "proctex_noise_lut");
+    if (uniform_proctex_noise_lut != -1) {
+        glUniform1i(uniform_proctex_noise_lut, TextureUnits::ProcTexNoiseLUT.id);
+    }
 
-        GLint uniform_proctex_alpha_map =
-            glGetUniformLocation(shader->shader.handle, "proctex_alpha_map");
-        if (uniform_proctex_alpha_map != -1) {
-            glUniform1i(uniform_proctex_alpha_map, TextureUnits::ProcTexAlphaMap.id);
-        }
+    GLint uniform_proctex_color_map = glGetUniformLocation(program, "proctex_color_map");
+    if (uniform_proctex_color_map != -1) {
+        glUniform1i(uniform_proctex_color_map, TextureUnits::ProcTexColorMap.id);
+    }
 
-        GLint uniform_proctex_lut = glGetUniformLocation(shader->shader.handle, "proctex_lut");
-        if (uniform_proctex_lut != -1) {
-            glUniform1i(uniform_proctex_lut, TextureUnits::ProcTexLUT.id);
-        }
+    GLint uniform_proctex_alpha_map = glGetUniformLocation(program, "proctex_alpha_map");
+    if (uniform_proctex_alpha_map != -1) {
+        glUniform1i(uniform_proctex_alpha_map, TextureUnits::ProcTexAlphaMap.id);
+    }
 
-        GLint uniform_proctex_diff_lut =
-            glGetUniformLocation(shader->shader.handle, "proctex_diff_lut");
-        if (uniform_proctex_diff_lut != -1) {
-            glUniform1i(uniform_proctex_diff_lut, TextureUnits::ProcTexDiffLUT.id);
-        }
+    GLint uniform_proctex_lut = glGetUniformLocation(program, "proctex_lut");
+    if (uniform_proctex_lut != -1) {
+        glUniform1i(uniform_proctex_lut, TextureUnits::ProcTexLUT.id);
+    }
 
-        current_shader = shader_cache.emplace(config, std::move(shader)).first->second.get();
+    GLint uniform_proctex_diff_lut = glGetUniformLocation(program, "proctex_diff_lut");
+    if (uniform_proctex_diff_lut != -1) {
+        glUniform1i(uniform_proctex_diff_lut, TextureUnits::ProcTexDiffLUT.id);
+    }
 
-        GLuint block_index = glGetUniformBlockIndex(current_shader->shader.handle, "shader_data");
-        if (block_index != GL_INVALID_INDEX) {
-            GLint block_size;
-            glGetActiveUniformBlockiv(current_shader->shader.handle, block_index,
-                                      GL_UNIFORM_BLOCK_DATA_SIZE, &block_size);
-            ASSERT_MSG(block_size == sizeof(UniformData),
-                       "Uniform block size did not match! Got %d, expected %zu",
-                       static_cast<int>(block_size), sizeof(UniformData));
-            glUniformBlockBinding(current_shader->shader.handle, block_index, 0);
-
-            // Update uniforms
-            SyncDepthScale();
-            SyncDepthOffset();
-            SyncAlphaTest();
-            SyncCombinerColor();
-            auto& tev_stages = Pica::g_state.regs.texturing.GetTevStages();
-            for (int index = 0; index < tev_stages.size(); ++index)
-                SyncTevConstColor(index, tev_stages[index]);
-
-            SyncGlobalAmbient();
-            for (int light_index = 0; light_index < 8; light_index++) {
-                SyncLightSpecular0(light_index);
-                SyncLightSpecular1(light_index);
-                SyncLightDiffuse(light_index);
-                SyncLightAmbient(light_index);
-                SyncLightPosition(light_index);
-                SyncLightDistanceAttenuationBias(light_index);
-                SyncLightDistanceAttenuationScale(light_index);
-            }
+    GLuint block_index = glGetUniformBlockIndex(program, "shader_data");
+    if (block_index != GL_INVALID_INDEX) {
+        GLint block_size;
+        glGetActiveUniformBlockiv(program, block_index, GL_UNIFORM_BLOCK_DATA_SIZE, &block_size);
+        ASSERT_MSG(block_size == sizeof(UniformData),
+                   "Uniform block size did not match! Got %d, expected %zu",
+                   static_cast<int>(block_size), sizeof(UniformData));
+        glUniformBlockBinding(program, block_index, 0);
+
+        // Update uniforms
+        SyncDepthScale();
+        SyncDepthOffset();
+        SyncAlphaTest();
+        SyncCombinerColor();
+        auto& tev_stages = Pica::g_state.regs.texturing.GetTevStages();
+        for (int index = 0; index < tev_stages.size(); ++index)
+            SyncTevConstColor(index, tev_stages[index]);
 
-            SyncFogColor();
-            SyncProcTexNoise();
+        SyncGlobalAmbient();
+        for (int light_index = 0; light_index < 8; light_index++) {
+            SyncLightSpecular0(light_index);
+            SyncLightSpecular1(light_index);
+            SyncLightDiffuse(light_index);
+            SyncLightAmbient(light_index);
+            SyncLightPosition(light_index);
+            SyncLightDistanceAttenuationBias(light_index);
+            SyncLightDistanceAttenuationScale(light_index);
         }
+
+        SyncFogColor();
+        SyncProcTexNoise();
+    }
+
+    GLuint vs_block_index = glGetUniformBlockIndex(program, "vs_config");
+    if (vs_block_index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, vs_block_index, 1);
+    }
+
+    GLuint ubershader_block_index = glGetUniformBlockIndex(program, "ubershader_config");
+    if (ubershader_block_index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, ubershader_block_index, 2);
+    }
+
+    GLuint clip_block_index = glGetUniformBlockIndex(program, "clip_data");
+    if (clip_block_index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, clip_block_index, 3);
     }
 }
 
@@ -1358,19 +2166,42 @@ void RasterizerOpenGL::SyncFogColor() {
     uniform_block_data.dirty = true;
 }
 
-void RasterizerOpenGL::SyncFogLUT() {
-    std::array<GLvec2, 128> new_data;
+/**
+ * Converts the entries of a lookup table written since the last sync into lut_data, and takes
+ * them from the dirty range
+ * @return true if any converted entry differs from the one it replaces
+ */
+template <typename Entry, size_t size, typename Texel, typename Convert>
+static bool SyncLUTRange(const std::array<Entry, size>& lut, Pica::LutDirtyRange& dirty,
+                         std::array<Texel, size>& lut_data, Convert convert) {
+    bool changed = false;
+    const u32 end = std::min(dirty.end, static_cast<u32>(size));
+    for (u32 i = dirty.begin; i < end; ++i) {
+        const Texel texel = convert(lut[i]);
+        if (texel != lut_data[i]) {
+            lut_data[i] = texel;
+            changed = true;
+        }
+    }
+    dirty = {};
+    return changed;
+}
 
-    std::transform(Pica::g_state.fog.lut.begin(), Pica::g_state.fog.lut.end(), new_data.begin(),
-                   [](const auto& entry) {
-                       return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-                   });
+template <typename Entry>
+static GLvec2 ValueEntryToGL(const Entry& entry) {
+    return {entry.ToFloat(), entry.DiffToFloat()};
+}
 
-    if (new_data != fog_lut_data) {
-        fog_lut_data = new_data;
-        glBindBuffer(GL_TEXTURE_BUFFER, fog_lut_buffer.handle);
-        glBufferSubData(GL_TEXTURE_BUFFER, 0, new_data.size() * sizeof(GLvec2), new_data.data());
-    }
+template <typename Entry>
+static GLvec4 ColorEntryToGL(const Entry& entry) {
+    const auto rgba = entry.ToVector() / 255.0f;
+    return {rgba.r(), rgba.g(), rgba.b(), rgba.a()};
+}
+
+bool RasterizerOpenGL::SyncFogLUT() {
+    auto& fog = Pica::g_state.fog;
+    return SyncLUTRange(fog.lut, fog.lut_dirty, fog_lut_data,
+                        ValueEntryToGL<Pica::State::Fog::LutEntry>);
 }
 
 void RasterizerOpenGL::SyncProcTexNoise() {
@@ -1390,68 +2221,122 @@ void RasterizerOpenGL::SyncProcTexNoise() {
     uniform_block_data.dirty = true;
 }
 
-// helper function for SyncProcTexNoiseLUT/ColorMap/AlphaMap
-static void SyncProcTexValueLUT(const std::array<Pica::State::ProcTex::ValueEntry, 128>& lut,
-                                std::array<GLvec2, 128>& lut_data, GLuint buffer) {
-    std::array<GLvec2, 128> new_data;
-    std::transform(lut.begin(), lut.end(), new_data.begin(), [](const auto& entry) {
-        return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-    });
+using ProcTexValueEntry = Pica::State::ProcTex::ValueEntry;
 
-    if (new_data != lut_data) {
-        lut_data = new_data;
-        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
-        glBufferSubData(GL_TEXTURE_BUFFER, 0, new_data.size() * sizeof(GLvec2), new_data.data());
-    }
+bool RasterizerOpenGL::SyncProcTexNoiseLUT() {
+    auto& pt = Pica::g_state.proctex;
+    return SyncLUTRange(pt.noise_table, pt.noise_table_dirty, proctex_noise_lut_data,
+                        ValueEntryToGL<ProcTexValueEntry>);
 }
 
-void RasterizerOpenGL::SyncProcTexNoiseLUT() {
-    SyncProcTexValueLUT(Pica::g_state.proctex.noise_table, proctex_noise_lut_data,
-                        proctex_noise_lut_buffer.handle);
+bool RasterizerOpenGL::SyncProcTexColorMap() {
+    auto& pt = Pica::g_state.proctex;
+    return SyncLUTRange(pt.color_map_table, pt.color_map_table_dirty, proctex_color_map_data,
+                        ValueEntryToGL<ProcTexValueEntry>);
 }
 
-void RasterizerOpenGL::SyncProcTexColorMap() {
-    SyncProcTexValueLUT(Pica::g_state.proctex.color_map_table, proctex_color_map_data,
-                        proctex_color_map_buffer.handle);
+bool RasterizerOpenGL::SyncProcTexAlphaMap() {
+    auto& pt = Pica::g_state.proctex;
+    return SyncLUTRange(pt.alpha_map_table, pt.alpha_map_table_dirty, proctex_alpha_map_data,
+                        ValueEntryToGL<ProcTexValueEntry>);
 }
 
-void RasterizerOpenGL::SyncProcTexAlphaMap() {
-    SyncProcTexValueLUT(Pica::g_state.proctex.alpha_map_table, proctex_alpha_map_data,
-                        proctex_alpha_map_buffer.handle);
+bool RasterizerOpenGL::SyncProcTexLUT() {
+    auto& pt = Pica::g_state.proctex;
+    return SyncLUTRange(pt.color_table, pt.color_table_dirty, proctex_lut_data,
+                        ColorEntryToGL<Pica::State::ProcTex::ColorEntry>);
 }
 
-void RasterizerOpenGL::SyncProcTexLUT() {
-    std::array<GLvec4, 256> new_data;
+bool RasterizerOpenGL::SyncProcTexDiffLUT() {
+    auto& pt = Pica::g_state.proctex;
+    return SyncLUTRange(pt.color_diff_table, pt.color_diff_table_dirty, proctex_diff_lut_data,
+                        ColorEntryToGL<Pica::State::ProcTex::ColorDifferenceEntry>);
+}
 
-    std::transform(Pica::g_state.proctex.color_table.begin(),
-                   Pica::g_state.proctex.color_table.end(), new_data.begin(),
-                   [](const auto& entry) {
-                       auto rgba = entry.ToVector() / 255.0f;
-                       return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
-                   });
+MICROPROFILE_DEFINE(OpenGL_LUTUpload, "OpenGL", "LUT Upload", MP_RGB(160, 160, 255));
+void RasterizerOpenGL::UploadLookupTables() {
+    auto& data = uniform_block_data;
+    const bool any_dirty =
+        std::find(data.lut_dirty.begin(), data.lut_dirty.end(), true) != data.lut_dirty.end() ||
+        data.fog_lut_dirty || data.proctex_noise_lut_dirty || data.proctex_color_map_dirty ||
+        data.proctex_alpha_map_dirty || data.proctex_lut_dirty || data.proctex_diff_lut_dirty;
+    if (!any_dirty && !upload_all_lookup_tables) {
+        return;
+    }
 
-    if (new_data != proctex_lut_data) {
-        proctex_lut_data = new_data;
-        glBindBuffer(GL_TEXTURE_BUFFER, proctex_lut_buffer.handle);
-        glBufferSubData(GL_TEXTURE_BUFFER, 0, new_data.size() * sizeof(GLvec4), new_data.data());
+    MICROPROFILE_SCOPE(OpenGL_LUTUpload);
+
+    // Reserve room for every table, since they all have to be written again if the buffer gets
+    // orphaned. Tables are placed at multiples of 16 bytes, the size of the largest texel format.
+    constexpr GLsizeiptr max_upload_size =
+        sizeof(lighting_lut_data) + sizeof(fog_lut_data) + sizeof(proctex_noise_lut_data) +
+        sizeof(proctex_color_map_data) + sizeof(proctex_alpha_map_data) +
+        sizeof(proctex_lut_data) + sizeof(proctex_diff_lut_data);
+    static_assert(max_upload_size + 16 <= 65536 * sizeof(GLvec2),
+                  "Lookup tables do not fit in the smallest texel buffer");
+
+    u8* buffer;
+    GLintptr buffer_offset;
+    bool orphaned;
+    std::tie(buffer, buffer_offset, orphaned) = texel_buffer.Map(max_upload_size, 16);
+    if (buffer == nullptr) {
+        LOG_ERROR(Render_OpenGL, "Failed to map the lookup table buffer");
+        return;
+    }
+
+    const bool upload_all = upload_all_lookup_tables || orphaned;
+    GLsizeiptr used = 0;
+
+    // Copies a table into the mapping, returning its offset within the buffer in texels
+    auto upload = [&](const auto& table, GLsizeiptr texel_size) {
+        std::memcpy(buffer + used, table.data(), sizeof(table));
+        const GLint texel_offset = static_cast<GLint>((buffer_offset + used) / texel_size);
+        used += sizeof(table);
+        data.dirty = true;
+        return texel_offset;
+    };
+
+    for (unsigned index = 0; index < data.lut_dirty.size(); index++) {
+        const bool changed = data.lut_dirty[index] && SyncLightingLUT(index);
+        if (changed || upload_all) {
+            data.data.lighting_lut_offset[index / 4][index % 4] =
+                upload(lighting_lut_data[index], sizeof(GLvec2));
+        }
+        data.lut_dirty[index] = false;
     }
-}
 
-void RasterizerOpenGL::SyncProcTexDiffLUT() {
-    std::array<GLvec4, 256> new_data;
+    if ((data.fog_lut_dirty && SyncFogLUT()) || upload_all) {
+        data.data.fog_lut_offset = upload(fog_lut_data, sizeof(GLvec2));
+    }
+    data.fog_lut_dirty = false;
+
+    if ((data.proctex_noise_lut_dirty && SyncProcTexNoiseLUT()) || upload_all) {
+        data.data.proctex_noise_lut_offset = upload(proctex_noise_lut_data, sizeof(GLvec2));
+    }
+    data.proctex_noise_lut_dirty = false;
 
-    std::transform(Pica::g_state.proctex.color_diff_table.begin(),
-                   Pica::g_state.proctex.color_diff_table.end(), new_data.begin(),
-                   [](const auto& entry) {
-                       auto rgba = entry.ToVector() / 255.0f;
-                       return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
-                   });
+    if ((data.proctex_color_map_dirty && SyncProcTexColorMap()) || upload_all) {
+        data.data.proctex_color_map_offset = upload(proctex_color_map_data, sizeof(GLvec2));
+    }
+    data.proctex_color_map_dirty = false;
+
+    if ((data.proctex_alpha_map_dirty && SyncProcTexAlphaMap()) || upload_all) {
+        data.data.proctex_alpha_map_offset = upload(proctex_alpha_map_data, sizeof(GLvec2));
+    }
+    data.proctex_alpha_map_dirty = false;
 
-    if (new_data != proctex_diff_lut_data) {
-        proctex_diff_lut_data = new_data;
-        glBindBuffer(GL_TEXTURE_BUFFER, proctex_diff_lut_buffer.handle);
-        glBufferSubData(GL_TEXTURE_BUFFER, 0, new_data.size() * sizeof(GLvec4), new_data.data());
+    if ((data.proctex_lut_dirty && SyncProcTexLUT()) || upload_all) {
+        data.data.proctex_lut_offset = upload(proctex_lut_data, sizeof(GLvec4));
     }
+    data.proctex_lut_dirty = false;
+
+    if ((data.proctex_diff_lut_dirty && SyncProcTexDiffLUT()) || upload_all) {
+        data.data.proctex_diff_lut_offset = upload(proctex_diff_lut_data, sizeof(GLvec4));
+    }
+    data.proctex_diff_lut_dirty = false;
+
+    texel_buffer.Unmap(used);
+    upload_all_lookup_tables = false;
 }
 
 void RasterizerOpenGL::SyncAlphaTest() {
@@ -1551,19 +2436,11 @@ void RasterizerOpenGL::SyncGlobalAmbient() {
     }
 }
 
-void RasterizerOpenGL::SyncLightingLUT(unsigned lut_index) {
-    std::array<GLvec2, 256> new_data;
-    const auto& source_lut = Pica::g_state.lighting.luts[lut_index];
-    std::transform(source_lut.begin(), source_lut.end(), new_data.begin(), [](const auto& entry) {
-        return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-    });
-
-    if (new_data != lighting_lut_data[lut_index]) {
-        lighting_lut_data[lut_index] = new_data;
-        glBindBuffer(GL_TEXTURE_BUFFER, lighting_lut_buffer.handle);
-        glBufferSubData(GL_TEXTURE_BUFFER, lut_index * new_data.size() * sizeof(GLvec2),
-                        new_data.size() * sizeof(GLvec2), new_data.data());
-    }
+bool RasterizerOpenGL::SyncLightingLUT(unsigned lut_index) {
+    auto& lighting = Pica::g_state.lighting;
+    return SyncLUTRange(lighting.luts[lut_index], lighting.luts_dirty[lut_index],
+                        lighting_lut_data[lut_index],
+                        ValueEntryToGL<Pica::State::Lighting::LutEntry>);
 }
 
 void RasterizerOpenGL::SyncLightSpecular0(int light_index) {
@@ -9,9 +9,12 @@
 #include <cstring>
 #include <memory>
 #include <unordered_map>
+#include <string>
 #include <vector>
+#include <boost/optional.hpp>
 #include <glad/glad.h>
 #include "common/bit_field.h"
+#include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/hash.h"
 #include "common/vector_math.h"
@@ -23,10 +26,13 @@
 #include "video_core/regs_lighting.h"
 #include "video_core/regs_rasterizer.h"
 #include "video_core/regs_texturing.h"
+#include "video_core/renderer_opengl/gl_async_shader_compiler.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
 #include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
 #include "video_core/renderer_opengl/pica_to_gl.h"
 #include "video_core/shader/shader.h"
 
@@ -40,10 +46,13 @@ public:
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
     void DrawTriangles() override;
+    void SetFrameSkipped(bool skipped) override;
+    bool AccelerateDrawBatch(bool is_indexed) override;
     void NotifyPicaRegisterChanged(u32 id) override;
     void FlushAll() override;
     void FlushRegion(PAddr addr, u32 size) override;
     void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+    void PreloadRegion(PAddr addr, u32 size) override;
     bool AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) override;
     bool AccelerateTextureCopy(const GPU::Regs::DisplayTransferConfig& config) override;
     bool AccelerateFill(const GPU::Regs::MemoryFillConfig& config) override;
@@ -57,67 +66,26 @@ public:
     };
 
 private:
-    struct SamplerInfo {
-        using TextureConfig = Pica::TexturingRegs::TextureConfig;
-
-        OGLSampler sampler;
-
-        /// Creates the sampler object, initializing its state so that it's in sync with the
-        /// SamplerInfo struct.
-        void Create();
-        /// Syncs the sampler object with the config, updating any necessary state.
-        void SyncWithConfig(const TextureConfig& config);
-
-    private:
-        TextureConfig::TextureFilter mag_filter;
-        TextureConfig::TextureFilter min_filter;
-        TextureConfig::WrapMode wrap_s;
-        TextureConfig::WrapMode wrap_t;
-        u32 border_color;
-    };
-
-    /// Structure that the hardware rendered vertices are composed of
+    /**
+     * Structure that the hardware rendered vertices are composed of. Attributes are packed where
+     * the precision allows: the color is saturated by the PICA and only ever used with 8 bits per
+     * channel, and the quaternion and view vector are only used as directions for lighting.
+     */
     struct HardwareVertex {
-        HardwareVertex(const Pica::Shader::OutputVertex& v, bool flip_quaternion) {
-            position[0] = v.pos.x.ToFloat32();
-            position[1] = v.pos.y.ToFloat32();
-            position[2] = v.pos.z.ToFloat32();
-            position[3] = v.pos.w.ToFloat32();
-            color[0] = v.color.x.ToFloat32();
-            color[1] = v.color.y.ToFloat32();
-            color[2] = v.color.z.ToFloat32();
-            color[3] = v.color.w.ToFloat32();
-            tex_coord0[0] = v.tc0.x.ToFloat32();
-            tex_coord0[1] = v.tc0.y.ToFloat32();
-            tex_coord1[0] = v.tc1.x.ToFloat32();
-            tex_coord1[1] = v.tc1.y.ToFloat32();
-            tex_coord2[0] = v.tc2.x.ToFloat32();
-            tex_coord2[1] = v.tc2.y.ToFloat32();
-            tex_coord0_w = v.tc0_w.ToFloat32();
-            normquat[0] = v.quat.x.ToFloat32();
-            normquat[1] = v.quat.y.ToFloat32();
-            normquat[2] = v.quat.z.ToFloat32();
-            normquat[3] = v.quat.w.ToFloat32();
-            view[0] = v.view.x.ToFloat32();
-            view[1] = v.view.y.ToFloat32();
-            view[2] = v.view.z.ToFloat32();
-
-            if (flip_quaternion) {
-                for (float& x : normquat) {
-                    x = -x;
-                }
-            }
-        }
+        HardwareVertex() = default;
+        HardwareVertex(const Pica::Shader::OutputVertex& v, bool flip_quaternion);
 
         GLfloat position[4];
-        GLfloat color[4];
+        GLubyte color[4];
         GLfloat tex_coord0[2];
         GLfloat tex_coord1[2];
         GLfloat tex_coord2[2];
         GLfloat tex_coord0_w;
-        GLfloat normquat[4];
-        GLfloat view[3];
+        GLhalf normquat[4];
+        /// The fourth component is padding, zeroed so that vertices can be compared bytewise
+        GLhalf view[4];
     };
+    static_assert(sizeof(HardwareVertex) == 64, "HardwareVertex has unexpected padding");
 
     struct LightSrc {
         alignas(16) GLvec3 specular_0;
@@ -151,17 +119,114 @@ private:
         LightSrc light_src[8];
         alignas(16) GLvec4 const_color[6]; // A vec4 color for each of the six tev stages
         alignas(16) GLvec4 tev_combiner_buffer_color;
+        // Offsets of the lookup tables within their texel buffers, in texels
+        GLint fog_lut_offset;
+        GLint proctex_noise_lut_offset;
+        GLint proctex_color_map_offset;
+        GLint proctex_alpha_map_offset;
+        GLint proctex_lut_offset;
+        GLint proctex_diff_lut_offset;
+        alignas(16) std::array<GLint, 4>
+            lighting_lut_offset[Pica::LightingRegs::NumLightingSampler / 4];
     };
 
     static_assert(
-        sizeof(UniformData) == 0x460,
+        sizeof(UniformData) == 0x4E0,
         "The size of the UniformData structure has changed, update the structure in the shader");
     static_assert(sizeof(UniformData) < 16384,
                   "UniformData structure must be less than 16kb as per the OpenGL spec");
 
-    /// Sets the OpenGL shader in accordance with the current PICA register state
+    /// Uniform structure for the vertex shader block of hardware vertex shaders
+    struct VSUniformData {
+        GLvec4 f[96];
+        std::array<GLuint, 4> i[4];
+        GLuint b;
+        INSERT_PADDING_WORDS(3);
+    };
+
+    static_assert(
+        sizeof(VSUniformData) == 1616,
+        "The size of the VSUniformData structure has changed, update the structure in the shader");
+
+    /// Uniform structure for the clipping block of the vertex stages
+    struct ClipUniformData {
+        GLvec4 clip_coef;
+    };
+
+    static_assert(sizeof(ClipUniformData) == 16,
+                  "The size of the ClipUniformData structure has changed, update the shaders");
+
+    /// Hardware vertex shader translated from a PICA vertex shader program
+    struct HWVertexShader {
+        /// GLSL source of the vertex shader, or none if the program couldn't be translated
+        boost::optional<std::string> source;
+        /// Programs linking this vertex shader with the fragment shaders it was used with
+        std::unordered_map<GLShader::PicaShaderConfig, std::unique_ptr<PicaShader>> programs;
+    };
+
+    /// Inputs of the draw call set up by AccelerateDrawBatch
+    struct HWDrawParams {
+        GLenum mode;
+        GLsizei count;
+        bool is_indexed;
+        GLenum index_type;
+        GLintptr index_offset;
+        GLint base_vertex;
+    };
+
+    /// Creates the programs stored in the shader disk cache of the running title
+    void LoadDiskShaderCache();
+
+    /// Sets the OpenGL shader in accordance with the current PICA register state. With
+    /// asynchronous compilation, the ubershader stands in while the program is being built.
     void SetShader();
 
+    /// Sets the fragment ubershader, configured for the given shader configuration
+    void SetUbershader(const GLShader::PicaShaderConfig& config);
+
+    /// Adds the programs the asynchronous shader compiler finished to the shader cache
+    void CollectCompiledShaders();
+
+    /// Sets the OpenGL shader combining the current hardware vertex shader with the fragment
+    /// shader for the current PICA register state
+    void SetHWShader();
+
+    /// Prepares a newly created shader program, binding its samplers and uniform blocks
+    void SetupShaderProgram(GLuint program);
+
+    /// Looks up the hardware vertex shader for the current PICA vertex shader, translating it if
+    /// needed. Returns false if the program can't run on the GPU.
+    bool SetupVertexShader();
+
+    /// Uploads the vertex and index arrays of the current draw into the hardware vertex path
+    /// buffers and points the vertex attributes at them. Returns false if the draw can't be done
+    /// on the GPU.
+    bool SetupVertexArray(bool is_indexed);
+
+    /// Streams the vertex shader uniforms if they changed since the last hardware draw
+    void SyncVSUniforms();
+
+    /// Streams the coefficients of the user clipping plane if they changed since the last draw
+    void SyncClipPlane();
+
+    /// Returns the sampler object for the filtering and wrapping of a texture, creating it the
+    /// first time that state is used
+    GLuint GetSampler(const Pica::TexturingRegs::TextureConfig& config);
+
+    /// Maps the ranges of the vertex and index buffers a new triangle batch is written into
+    bool MapTriangleBatch();
+
+    /// Adds a vertex to the triangle batch unless it was added recently, returning its index
+    GLushort AddBatchVertex(const HardwareVertex& vertex);
+
+    /// Issues a draw, either of the software-processed triangle batch or of the vertex arrays
+    /// set up for the hardware vertex shader
+    void Draw(bool accelerate);
+
+    /// Whether the current draw can be dropped because the frame is skipped and nothing reads its
+    /// framebuffer surfaces back from emulated memory
+    bool IsDrawElided();
+
     /// Syncs the cull mode to match the PICA register
     void SyncCullMode();
 
@@ -182,17 +247,20 @@ private:
 
     /// Syncs the fog states to match the PICA register
     void SyncFogColor();
-    void SyncFogLUT();
+    bool SyncFogLUT();
 
     /// Sync the procedural texture noise configuration to match the PICA register
     void SyncProcTexNoise();
 
     /// Sync the procedural texture lookup tables
-    void SyncProcTexNoiseLUT();
-    void SyncProcTexColorMap();
-    void SyncProcTexAlphaMap();
-    void SyncProcTexLUT();
-    void SyncProcTexDiffLUT();
+    bool SyncProcTexNoiseLUT();
+    bool SyncProcTexColorMap();
+    bool SyncProcTexAlphaMap();
+    bool SyncProcTexLUT();
+    bool SyncProcTexDiffLUT();
+
+    /// Streams the lookup tables that changed since the last draw to the texel buffer
+    void UploadLookupTables();
 
     /// Syncs the alpha test states to match the PICA register
     void SyncAlphaTest();
@@ -225,7 +293,7 @@ private:
     void SyncGlobalAmbient();
 
     /// Syncs the lighting lookup tables
-    void SyncLightingLUT(unsigned index);
+    bool SyncLightingLUT(unsigned index);
 
     /// Syncs the specified light's specular 0 color to match the PICA register
     void SyncLightSpecular0(int light_index);
@@ -255,11 +323,26 @@ private:
 
     RasterizerCacheOpenGL res_cache;
 
-    std::vector<HardwareVertex> vertex_batch;
-
     std::unordered_map<GLShader::PicaShaderConfig, std::unique_ptr<PicaShader>> shader_cache;
+    GLShader::ShaderDiskCache shader_disk_cache;
+    std::unique_ptr<GLShader::AsyncShaderCompiler> shader_compiler;
     const PicaShader* current_shader = nullptr;
+    /// Hash of the configuration of the current fragment shader, which GPU draw times are
+    /// attributed to
+    u64 current_shader_hash = 0;
     bool shader_dirty;
+    /// Whether the current frame is skipped, see SetFrameSkipped
+    bool frame_skipped = false;
+    /// Whether the ubershader is standing in for a program that is still being compiled
+    bool shader_pending = false;
+
+    /// Fragment ubershader, created on first use, and the configuration its block was last
+    /// uploaded with
+    static constexpr GLsizeiptr UBERSHADER_CONFIG_BUFFER_SIZE = 256 * 1024;
+    PicaShader ubershader;
+    OGLStreamBuffer ubershader_config_buffer;
+    GLShader::PicaShaderConfig ubershader_config;
+    bool ubershader_config_valid = false;
 
     struct {
         UniformData data;
@@ -273,37 +356,91 @@ private:
         bool dirty;
     } uniform_block_data = {};
 
-    std::array<SamplerInfo, 3> texture_samplers;
+    /// Sampler objects by their packed filter, wrap and border color state. They aren't modified
+    /// once created, so a change of sampler state between draws only costs a bind.
+    std::unordered_map<u64, OGLSampler> sampler_cache;
     OGLVertexArray vertex_array;
-    OGLBuffer vertex_buffer;
-    OGLBuffer uniform_buffer;
+
+    /// Ring buffers AddTriangle writes vertices and indices into. A range of each is mapped from
+    /// the first triangle of a batch until the batch gets drawn. A batch never holds more vertices
+    /// than indices, so MAX_BATCH_VERTICES bounds both.
+    static constexpr GLsizeiptr VERTEX_BUFFER_SIZE = 16 * 1024 * 1024;
+    static constexpr GLsizeiptr INDEX_BUFFER_SIZE = 1 * 1024 * 1024;
+    static constexpr size_t MAX_BATCH_VERTICES = 3 * 4096;
+    OGLStreamBuffer vertex_buffer;
+    OGLStreamBuffer index_buffer;
+    HardwareVertex* vertex_batch = nullptr;
+    GLintptr vertex_batch_offset = 0;
+    size_t vertex_batch_size = 0;
+    GLushort* index_batch = nullptr;
+    GLintptr index_batch_offset = 0;
+    size_t index_batch_size = 0;
+
+    /// Direct-mapped cache of the vertices recently added to the batch, keyed by their position.
+    /// Triangles of strips, fans and clipped polygons share corners, which are then stored once.
+    static constexpr size_t RECENT_VERTEX_COUNT = 32;
+    std::array<HardwareVertex, RECENT_VERTEX_COUNT> recent_vertices;
+    std::array<GLushort, RECENT_VERTEX_COUNT> recent_vertex_indices;
     OGLFramebuffer framebuffer;
 
-    OGLBuffer lighting_lut_buffer;
+    /// Hardware vertex shaders keyed by the PICA vertex shader state they were translated from.
+    /// Programs that can't be translated are cached as well, so they aren't attempted again.
+    std::unordered_map<GLShader::PicaVSConfig, HWVertexShader> hw_vs_cache;
+    HWVertexShader* current_hw_vs = nullptr;
+    /// Hardware vertex shader the current program was built with, nullptr for the software path
+    const HWVertexShader* current_shader_vs = nullptr;
+    bool vs_config_dirty = true;
+    bool vs_uniforms_dirty = true;
+
+    /// Vertex array and ring buffers the vertex and index arrays of hardware vertex shader draws
+    /// are copied into
+    static constexpr GLsizeiptr HW_VERTEX_BUFFER_SIZE = 16 * 1024 * 1024;
+    static constexpr GLsizeiptr HW_INDEX_BUFFER_SIZE = 1 * 1024 * 1024;
+    static constexpr GLsizeiptr VS_UNIFORM_BUFFER_SIZE = 1 * 1024 * 1024;
+    OGLVertexArray hw_vertex_array;
+    OGLStreamBuffer hw_vertex_buffer;
+    OGLStreamBuffer hw_index_buffer;
+    /// Kept apart from uniform_buffer so that orphaning either never discards the range bound by
+    /// the other
+    OGLStreamBuffer vs_uniform_buffer;
+    HWDrawParams hw_draw{};
+
+    /// Ring buffer the clipping block is streamed through, which both vertex paths use
+    static constexpr GLsizeiptr CLIP_UNIFORM_BUFFER_SIZE = 64 * 1024;
+    OGLStreamBuffer clip_uniform_buffer;
+    bool clip_dirty = true;
+
+    /// Ring buffer the uniform block is streamed through, with one range bound per draw
+    static constexpr GLsizeiptr UNIFORM_BUFFER_SIZE = 2 * 1024 * 1024;
+    OGLStreamBuffer uniform_buffer;
+    GLint uniform_buffer_alignment;
+
+    /// Ring buffer all lookup tables are streamed through. Each table is a texel buffer view of
+    /// the whole buffer, indexed from an offset passed in the uniform block.
+    static constexpr GLsizeiptr TEXEL_BUFFER_SIZE = 4 * 1024 * 1024;
+    OGLStreamBuffer texel_buffer;
+    /// Whether the tables need to be uploaded again even if unchanged, as their previous copies
+    /// are no longer available
+    bool upload_all_lookup_tables = true;
+
     OGLTexture lighting_lut;
     std::array<std::array<GLvec2, 256>, Pica::LightingRegs::NumLightingSampler> lighting_lut_data{};
 
-    OGLBuffer fog_lut_buffer;
     OGLTexture fog_lut;
     std::array<GLvec2, 128> fog_lut_data{};
 
-    OGLBuffer proctex_noise_lut_buffer;
     OGLTexture proctex_noise_lut;
     std::array<GLvec2, 128> proctex_noise_lut_data{};
 
-    OGLBuffer proctex_color_map_buffer;
     OGLTexture proctex_color_map;
     std::array<GLvec2, 128> proctex_color_map_data{};
 
-    OGLBuffer proctex_alpha_map_buffer;
     OGLTexture proctex_alpha_map;
     std::array<GLvec2, 128> proctex_alpha_map_data{};
 
-    OGLBuffer proctex_lut_buffer;
     OGLTexture proctex_lut;
     std::array<GLvec4, 256> proctex_lut_data{};
 
-    OGLBuffer proctex_diff_lut_buffer;
     OGLTexture proctex_diff_lut;
     std::array<GLvec4, 256> proctex_diff_lut_data{};
 };
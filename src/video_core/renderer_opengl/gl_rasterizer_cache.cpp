@@ -4,23 +4,26 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <cstring>
-#include <iterator>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 #include <glad/glad.h>
 #include "common/bit_field.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/microprofile.h"
 #include "common/vector_math.h"
 #include "core/frontend/emu_window.h"
 #include "core/memory.h"
+#include "core/perf_stats.h"
 #include "core/settings.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_surface_preloader.h"
+#include "video_core/renderer_opengl/gl_timer_queries.h"
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
 #include "video_core/video_core.h"
@@ -46,18 +49,345 @@ static const std::array<FormatTuple, 4> depth_format_tuples = {{
     {GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8}, // D24S8
 }};
 
-RasterizerCacheOpenGL::RasterizerCacheOpenGL() {
+static const char fullscreen_vertex_shader[] = R"(
+#version 330 core
+
+void main() {
+    // Single triangle covering the whole viewport
+    vec2 position = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+static const char untile_fragment_shader[] = R"(
+#version 330 core
+
+out vec4 color;
+
+uniform usamplerBuffer tiled_data;
+// Offset of the surface data within tiled_data, in 32-bit words
+uniform int word_offset;
+uniform int width;
+uniform int height;
+uniform int pixel_format;
+
+uint FetchByte(int index) {
+    uint word = texelFetch(tiled_data, word_offset + (index >> 2)).r;
+    return (word >> uint((index & 3) * 8)) & 0xFFu;
+}
+
+void main() {
+    // GL textures are stored bottom-up, while emulated memory is top-down
+    int x = int(gl_FragCoord.x);
+    int y = height - 1 - int(gl_FragCoord.y);
+
+    // Same addressing as VideoCore::GetMortonOffset, see utils.h
+    int interleaved = (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) |
+                      ((x & 4) << 2) | ((y & 4) << 3);
+    int pixel_index = interleaved + (x & ~7) * 8 + (y & ~7) * width;
+
+    if (pixel_format == 0) { // RGBA8
+        int offset = pixel_index * 4;
+        color = vec4(FetchByte(offset + 3), FetchByte(offset + 2), FetchByte(offset + 1),
+                     FetchByte(offset)) / 255.0;
+    } else if (pixel_format == 1) { // RGB8
+        int offset = pixel_index * 3;
+        color = vec4(vec3(FetchByte(offset + 2), FetchByte(offset + 1), FetchByte(offset)) / 255.0,
+                     1.0);
+    } else {
+        int offset = pixel_index * 2;
+        uint pixel = FetchByte(offset) | (FetchByte(offset + 1) << 8);
+        if (pixel_format == 2) { // RGB5A1
+            color = vec4(vec3((pixel >> 11) & 0x1Fu, (pixel >> 6) & 0x1Fu, (pixel >> 1) & 0x1Fu) /
+                             31.0,
+                         pixel & 0x1u);
+        } else if (pixel_format == 3) { // RGB565
+            color = vec4(float((pixel >> 11) & 0x1Fu) / 31.0, float((pixel >> 5) & 0x3Fu) / 63.0,
+                         float(pixel & 0x1Fu) / 31.0, 1.0);
+        } else { // RGBA4
+            color = vec4((pixel >> 12) & 0xFu, (pixel >> 8) & 0xFu, (pixel >> 4) & 0xFu,
+                         pixel & 0xFu) / 15.0;
+        }
+    }
+}
+)";
+
+static const char d24s8_to_rgba8_fragment_shader[] = R"(
+#version 330 core
+
+out vec4 color;
+
+// Depth/stencil values as packed by OpenGL, i.e. depth << 8 | stencil
+uniform usamplerBuffer src_data;
+uniform int width;
+
+void main() {
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+    uint value = texelFetch(src_data, coord.y * width + coord.x).r;
+
+    // The 3DS keeps stencil in the most significant byte instead, which RGBA8 sees as red
+    color = vec4(value & 0xFFu, value >> 24, (value >> 16) & 0xFFu, (value >> 8) & 0xFFu) / 255.0;
+}
+)";
+
+static const char rgba8_to_d24s8_fragment_shader[] = R"(
+#version 330 core
+
+out uint value;
+
+// RGBA8 values as read back with GL_UNSIGNED_INT_8_8_8_8, i.e. in 3DS memory layout
+uniform usamplerBuffer src_data;
+uniform int width;
+
+void main() {
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+    uint color = texelFetch(src_data, coord.y * width + coord.x).r;
+
+    // Move stencil from the most significant byte down to where OpenGL expects it
+    value = (color << 8) | (color >> 24);
+}
+)";
+
+/// Builds a program drawing a fullscreen triangle with the given fragment shader
+static void BuildFullscreenProgram(OGLShader& program, const char* fragment_shader,
+                                   const char* description) {
+    program.Create(fullscreen_vertex_shader, fragment_shader);
+
+    GLint link_status = GL_FALSE;
+    glGetProgramiv(program.handle, GL_LINK_STATUS, &link_status);
+    if (link_status != GL_TRUE) {
+        LOG_ERROR(Render_OpenGL, "Failed to build %s shader", description);
+        program.Release();
+    }
+}
+
+/// Binds the texel buffer sampler of a program built with BuildFullscreenProgram to a unit
+static void SetProgramBufferUnit(const OGLShader& program, const char* name,
+                                 TextureUnits::TextureUnit unit) {
+    OpenGLState cur_state = OpenGLState::GetCurState();
+    GLuint old_program = cur_state.draw.shader_program;
+    cur_state.draw.shader_program = program.handle;
+    cur_state.Apply();
+    glUniform1i(glGetUniformLocation(program.handle, name), unit.id);
+    cur_state.draw.shader_program = old_program;
+    cur_state.Apply();
+}
+
+/// Disables everything in `state` that would interfere with a plain fullscreen draw
+static void SetFullscreenPassState(OpenGLState& state) {
+    state.cull.enabled = false;
+    state.depth.test_enabled = false;
+    state.depth.write_mask = GL_FALSE;
+    state.stencil.test_enabled = false;
+    state.blend.enabled = false;
+    state.logic_op = GL_COPY;
+    state.clip_distance[0] = false;
+    state.clip_distance[1] = false;
+    state.color_mask.red_enabled = GL_TRUE;
+    state.color_mask.green_enabled = GL_TRUE;
+    state.color_mask.blue_enabled = GL_TRUE;
+    state.color_mask.alpha_enabled = GL_TRUE;
+}
+
+/// ETC2 textures are core since GL 4.3, which the generated bindings don't check for
+static bool IsETC2Supported() {
+    GLint major_version = 0;
+    GLint minor_version = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+    glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+    if (major_version > 4 || (major_version == 4 && minor_version >= 3)) {
+        return true;
+    }
+
+    GLint num_extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+    for (GLint i = 0; i < num_extensions; ++i) {
+        const char* extension =
+            reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (std::strcmp(extension, "GL_ARB_ES3_compatibility") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RasterizerCacheOpenGL::RasterizerCacheOpenGL() : upload_buffer(GL_PIXEL_UNPACK_BUFFER) {
+    use_page_index = Settings::values.use_surface_page_index;
+    share_identical_textures = Settings::values.use_shared_surface_textures;
+    texture_pool_size =
+        static_cast<size_t>(std::max(Settings::values.surface_texture_pool_size, 0));
+
+    upload_buffer.Create(UPLOAD_BUFFER_SIZE);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    fullscreen_vertex_array.Create();
+
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texture_buffer_size);
+    etc2_supported = IsETC2Supported();
+
+    // The untiling shader addresses the whole upload buffer as 32-bit texels, which GL 3.3 only
+    // guarantees to be possible for 64Ki of them, so check the actual limit first
+    if (Settings::values.use_gpu_surface_untiling &&
+        max_texture_buffer_size >= UPLOAD_BUFFER_SIZE / 4) {
+        BuildFullscreenProgram(untile_program, untile_fragment_shader, "surface untiling");
+    }
+
+    if (untile_program.handle != 0) {
+        untile_buffer_texture.Create();
+        glActiveTexture(TextureUnits::SurfaceUntileBuffer.Enum());
+        glBindTexture(GL_TEXTURE_BUFFER, untile_buffer_texture.handle);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, upload_buffer.GetHandle());
+
+        uniform_untile_word_offset = glGetUniformLocation(untile_program.handle, "word_offset");
+        uniform_untile_width = glGetUniformLocation(untile_program.handle, "width");
+        uniform_untile_height = glGetUniformLocation(untile_program.handle, "height");
+        uniform_untile_pixel_format = glGetUniformLocation(untile_program.handle, "pixel_format");
+        SetProgramBufferUnit(untile_program, "tiled_data", TextureUnits::SurfaceUntileBuffer);
+    }
+
+    BuildFullscreenProgram(d24s8_to_rgba8_program, d24s8_to_rgba8_fragment_shader,
+                           "D24S8 to RGBA8 reinterpretation");
+    BuildFullscreenProgram(rgba8_to_d24s8_program, rgba8_to_d24s8_fragment_shader,
+                           "RGBA8 to D24S8 reinterpretation");
+
+    reinterpret_buffers[0].Create();
+    reinterpret_buffers[1].Create();
+
+    if (d24s8_to_rgba8_program.handle != 0 && rgba8_to_d24s8_program.handle != 0) {
+        // glTexBuffer needs the buffer to have been bound once so that it exists
+        glBindBuffer(GL_TEXTURE_BUFFER, reinterpret_buffers[0].handle);
+        reinterpret_buffer_texture.Create();
+        glActiveTexture(TextureUnits::SurfaceReinterpretBuffer.Enum());
+        glBindTexture(GL_TEXTURE_BUFFER, reinterpret_buffer_texture.handle);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, reinterpret_buffers[0].handle);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        uniform_d24s8_to_rgba8_width = glGetUniformLocation(d24s8_to_rgba8_program.handle, "width");
+        uniform_rgba8_to_d24s8_width = glGetUniformLocation(rgba8_to_d24s8_program.handle, "width");
+        SetProgramBufferUnit(d24s8_to_rgba8_program, "src_data",
+                             TextureUnits::SurfaceReinterpretBuffer);
+        SetProgramBufferUnit(rgba8_to_d24s8_program, "src_data",
+                             TextureUnits::SurfaceReinterpretBuffer);
+    }
+
     transfer_framebuffers[0].Create();
     transfer_framebuffers[1].Create();
+
+    if (Settings::values.use_surface_preloading) {
+        auto context = VideoCore::g_emu_window->CreateSharedContext();
+        if (context != nullptr) {
+            surface_preloader = std::make_unique<SurfacePreloader>(std::move(context));
+        } else {
+            LOG_WARNING(Render_OpenGL,
+                        "Frontend can't create a shared context, not preloading surfaces");
+        }
+    }
 }
 
 RasterizerCacheOpenGL::~RasterizerCacheOpenGL() {
     FlushAll();
+
+    for (auto& download : downloads) {
+        CancelSurfaceDownload(download);
+    }
+
+    surface_preloader.reset();
+    preloaded_surfaces.clear();
+
+    // Destroying surfaces returns their textures to the pool, so tear down the surfaces first
+    invalidated_surface_lookup.clear();
+    invalidated_surfaces.clear();
+    page_indexed_surfaces.clear();
+    surface_cache.clear();
+    texture_pool.clear();
+}
+
+MICROPROFILE_DEFINE(OpenGL_SurfaceLookup, "OpenGL", "Surface Lookup", MP_RGB(192, 128, 64));
+void RasterizerCacheOpenGL::GetSurfacesInRegion(PAddr addr, u32 size,
+                                                std::vector<CachedSurface*>& out) {
+    MICROPROFILE_SCOPE(OpenGL_SurfaceLookup);
+
+    if (use_page_index) {
+        page_index.GetOverlapping(addr, size, out);
+        return;
+    }
+
+    // The same surface generally appears in several intervals of the map, so deduplicate using a
+    // lookup generation just like the page index does.
+    const u64 lookup_generation = page_index.NextGeneration();
+    auto surface_interval = boost::icl::interval<PAddr>::right_open(addr, addr + size);
+    auto range = surface_cache.equal_range(surface_interval);
+    for (auto it = range.first; it != range.second; ++it) {
+        for (const auto& surface : it->second) {
+            if (surface->index_generation != lookup_generation) {
+                surface->index_generation = lookup_generation;
+                out.push_back(surface.get());
+            }
+        }
+    }
+}
+
+void RasterizerCacheOpenGL::RegisterSurface(std::shared_ptr<CachedSurface> surface) {
+    if (use_page_index) {
+        page_index.Add(surface.get());
+        page_indexed_surfaces.emplace(surface.get(), std::move(surface));
+        return;
+    }
+
+    auto surface_interval =
+        boost::icl::interval<PAddr>::right_open(surface->addr, surface->addr + surface->size);
+    surface_cache.add(
+        std::make_pair(surface_interval, std::set<std::shared_ptr<CachedSurface>>({surface})));
+}
+
+void RasterizerCacheOpenGL::UnregisterSurface(CachedSurface* surface) {
+    SurfaceDownload* download = FindSurfaceDownload(surface);
+    if (download != nullptr) {
+        CancelSurfaceDownload(*download);
+    }
+    if (last_color_surface == surface) {
+        last_color_surface = nullptr;
+    }
+    if (last_depth_surface == surface) {
+        last_depth_surface = nullptr;
+    }
+    // Forget the read backs of the surface's memory, RecordReadBack marks it again if a new
+    // surface there is read back while dirty
+    read_back_regions -=
+        boost::icl::interval<PAddr>::right_open(surface->addr, surface->addr + surface->size);
+
+    if (use_page_index) {
+        page_index.Remove(surface);
+        page_indexed_surfaces.erase(surface);
+        return;
+    }
+
+    auto surface_interval =
+        boost::icl::interval<PAddr>::right_open(surface->addr, surface->addr + surface->size);
+    auto range = surface_cache.equal_range(surface_interval);
+    for (auto it = range.first; it != range.second; ++it) {
+        auto owner = std::find_if(it->second.begin(), it->second.end(),
+                                  [surface](const std::shared_ptr<CachedSurface>& candidate) {
+                                      return candidate.get() == surface;
+                                  });
+        if (owner != it->second.end()) {
+            // Keep a reference alive while the map erases its own copies
+            std::shared_ptr<CachedSurface> surface_ref = *owner;
+            surface_cache.subtract(std::make_pair(
+                surface_interval, std::set<std::shared_ptr<CachedSurface>>({surface_ref})));
+            return;
+        }
+    }
 }
 
-static void MortonCopyPixels(CachedSurface::PixelFormat pixel_format, u32 width, u32 height,
-                             u32 bytes_per_pixel, u32 gl_bytes_per_pixel, u8* morton_data,
-                             u8* gl_data, bool morton_to_gl) {
+/**
+ * Copies rows [start_y, end_y) of a tiled surface between emulated memory and OpenGL pixel data.
+ * @param morton_data Start of the whole surface in emulated memory
+ * @param gl_data OpenGL pixel data, starting at the bottom-most row of the copied range
+ */
+static void MortonCopyPixels(CachedSurface::PixelFormat pixel_format, u32 width, u32 start_y,
+                             u32 end_y, u32 bytes_per_pixel, u32 gl_bytes_per_pixel,
+                             u8* morton_data, u8* gl_data, bool morton_to_gl) {
     using PixelFormat = CachedSurface::PixelFormat;
 
     u8* data_ptrs[2];
@@ -68,12 +398,12 @@ static void MortonCopyPixels(CachedSurface::PixelFormat pixel_format, u32 width,
     }
 
     if (pixel_format == PixelFormat::D24S8) {
-        for (unsigned y = 0; y < height; ++y) {
+        for (unsigned y = start_y; y < end_y; ++y) {
             for (unsigned x = 0; x < width; ++x) {
                 const u32 coarse_y = y & ~7;
                 u32 morton_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) +
                                     coarse_y * width * bytes_per_pixel;
-                u32 gl_pixel_index = (x + (height - 1 - y) * width) * gl_bytes_per_pixel;
+                u32 gl_pixel_index = (x + (end_y - 1 - y) * width) * gl_bytes_per_pixel;
 
                 data_ptrs[morton_to_gl] = morton_data + morton_offset;
                 data_ptrs[!morton_to_gl] = &gl_data[gl_pixel_index];
@@ -88,12 +418,12 @@ static void MortonCopyPixels(CachedSurface::PixelFormat pixel_format, u32 width,
             }
         }
     } else {
-        for (unsigned y = 0; y < height; ++y) {
+        for (unsigned y = start_y; y < end_y; ++y) {
             for (unsigned x = 0; x < width; ++x) {
                 const u32 coarse_y = y & ~7;
                 u32 morton_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) +
                                     coarse_y * width * bytes_per_pixel;
-                u32 gl_pixel_index = (x + (height - 1 - y) * width) * gl_bytes_per_pixel;
+                u32 gl_pixel_index = (x + (end_y - 1 - y) * width) * gl_bytes_per_pixel;
 
                 data_ptrs[morton_to_gl] = morton_data + morton_offset;
                 data_ptrs[!morton_to_gl] = &gl_data[gl_pixel_index];
@@ -107,9 +437,12 @@ static void MortonCopyPixels(CachedSurface::PixelFormat pixel_format, u32 width,
 void RasterizerCacheOpenGL::BlitTextures(GLuint src_tex, GLuint dst_tex,
                                          CachedSurface::SurfaceType type,
                                          const MathUtil::Rectangle<int>& src_rect,
-                                         const MathUtil::Rectangle<int>& dst_rect) {
+                                         const MathUtil::Rectangle<int>& dst_rect,
+                                         GLint dst_level) {
     using SurfaceType = CachedSurface::SurfaceType;
 
+    GLTimerQueries::ScopedTimer gpu_timer(Core::PerfStats::GPUCategory::SurfaceBlit);
+
     OpenGLState cur_state = OpenGLState::GetCurState();
 
     // Make sure textures aren't bound to texture units, since going to bind them to framebuffer
@@ -132,7 +465,7 @@ void RasterizerCacheOpenGL::BlitTextures(GLuint src_tex, GLuint dst_tex,
                                0);
 
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dst_tex,
-                               0);
+                               dst_level);
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0,
                                0);
 
@@ -143,7 +476,8 @@ void RasterizerCacheOpenGL::BlitTextures(GLuint src_tex, GLuint dst_tex,
         glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
 
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
-        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, dst_tex, 0);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, dst_tex,
+                               dst_level);
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
 
         buffers = GL_DEPTH_BUFFER_BIT;
@@ -154,7 +488,7 @@ void RasterizerCacheOpenGL::BlitTextures(GLuint src_tex, GLuint dst_tex,
 
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
-                               dst_tex, 0);
+                               dst_tex, dst_level);
 
         buffers = GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
     }
@@ -174,43 +508,47 @@ bool RasterizerCacheOpenGL::TryBlitSurfaces(CachedSurface* src_surface,
                                             CachedSurface* dst_surface,
                                             const MathUtil::Rectangle<int>& dst_rect) {
 
-    if (!CachedSurface::CheckFormatsBlittable(src_surface->pixel_format,
+    if (src_surface->is_compressed || dst_surface->is_compressed ||
+        !CachedSurface::CheckFormatsBlittable(src_surface->pixel_format,
                                               dst_surface->pixel_format)) {
         return false;
     }
 
+    UnshareSurfaceTexture(dst_surface);
     BlitTextures(src_surface->texture.handle, dst_surface->texture.handle,
                  CachedSurface::GetFormatType(src_surface->pixel_format), src_rect, dst_rect);
     return true;
 }
 
-static void AllocateSurfaceTexture(GLuint texture, CachedSurface::PixelFormat pixel_format,
-                                   u32 width, u32 height) {
-    // Allocate an uninitialized texture of appropriate size and format for the surface
+/// Returns the format the texture of a surface is allocated in
+static FormatTuple GetAllocationFormat(CachedSurface::PixelFormat pixel_format) {
     using SurfaceType = CachedSurface::SurfaceType;
 
-    OpenGLState cur_state = OpenGLState::GetCurState();
-
-    // Keep track of previous texture bindings
-    GLuint old_tex = cur_state.texture_units[0].texture_2d;
-    cur_state.texture_units[0].texture_2d = texture;
-    cur_state.Apply();
-    glActiveTexture(GL_TEXTURE0);
-
     SurfaceType type = CachedSurface::GetFormatType(pixel_format);
 
-    FormatTuple tuple;
     if (type == SurfaceType::Color) {
         ASSERT((size_t)pixel_format < fb_format_tuples.size());
-        tuple = fb_format_tuples[(unsigned int)pixel_format];
+        return fb_format_tuples[(unsigned int)pixel_format];
     } else if (type == SurfaceType::Depth || type == SurfaceType::DepthStencil) {
         size_t tuple_idx = (size_t)pixel_format - 14;
         ASSERT(tuple_idx < depth_format_tuples.size());
-        tuple = depth_format_tuples[tuple_idx];
-    } else {
-        tuple = {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE};
+        return depth_format_tuples[tuple_idx];
     }
+    return {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE};
+}
+
+static void AllocateSurfaceTexture(GLuint texture, CachedSurface::PixelFormat pixel_format,
+                                   u32 width, u32 height) {
+    // Allocate an uninitialized texture of appropriate size and format for the surface
+    OpenGLState cur_state = OpenGLState::GetCurState();
+
+    // Keep track of previous texture bindings
+    GLuint old_tex = cur_state.texture_units[0].texture_2d;
+    cur_state.texture_units[0].texture_2d = texture;
+    cur_state.Apply();
+    glActiveTexture(GL_TEXTURE0);
 
+    const FormatTuple tuple = GetAllocationFormat(pixel_format);
     glTexImage2D(GL_TEXTURE_2D, 0, tuple.internal_format, width, height, 0, tuple.format,
                  tuple.type, nullptr);
 
@@ -224,240 +562,912 @@ static void AllocateSurfaceTexture(GLuint texture, CachedSurface::PixelFormat pi
     cur_state.Apply();
 }
 
-MICROPROFILE_DEFINE(OpenGL_SurfaceUpload, "OpenGL", "Surface Upload", MP_RGB(128, 64, 192));
-CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bool match_res_scale,
-                                                 bool load_if_create) {
+/// Allocates uninitialized mipmap levels [first_level, max_level] of a surface's texture
+static void AllocateSurfaceTextureLevels(GLuint texture, CachedSurface::PixelFormat pixel_format,
+                                         u32 width, u32 height, u32 first_level, u32 max_level) {
+    OpenGLState cur_state = OpenGLState::GetCurState();
+
+    GLuint old_tex = cur_state.texture_units[0].texture_2d;
+    cur_state.texture_units[0].texture_2d = texture;
+    cur_state.Apply();
+    glActiveTexture(GL_TEXTURE0);
+
+    const FormatTuple tuple = GetAllocationFormat(pixel_format);
+    for (u32 level = first_level; level <= max_level; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, tuple.internal_format, std::max(width >> level, 1u),
+                     std::max(height >> level, 1u), 0, tuple.format, tuple.type, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_level);
+
+    cur_state.texture_units[0].texture_2d = old_tex;
+    cur_state.Apply();
+}
+
+/**
+ * Returns the format in which a surface's data is passed to OpenGL when uploading it.
+ * @param gl_bytes_per_pixel Set to the size of each pixel in the data passed to OpenGL
+ */
+static FormatTuple GetUploadFormat(const CachedSurface& params, u32& gl_bytes_per_pixel) {
     using PixelFormat = CachedSurface::PixelFormat;
     using SurfaceType = CachedSurface::SurfaceType;
 
-    if (params.addr == 0) {
-        return nullptr;
+    if (!params.is_tiled) {
+        // TODO: Ensure this will always be a color format, not a depth or other format
+        ASSERT((size_t)params.pixel_format < fb_format_tuples.size());
+        gl_bytes_per_pixel = CachedSurface::GetFormatBpp(params.pixel_format) / 8;
+        return fb_format_tuples[(unsigned int)params.pixel_format];
     }
 
-    u32 params_size =
-        params.width * params.height * CachedSurface::GetFormatBpp(params.pixel_format) / 8;
+    SurfaceType type = CachedSurface::GetFormatType(params.pixel_format);
+    if (type != SurfaceType::Depth && type != SurfaceType::DepthStencil) {
+        // Tiled color and texture data is decoded to RGBA8 using DecodeTexture
+        gl_bytes_per_pixel = 4;
+        return {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE};
+    }
 
-    // Check for an exact match in existing surfaces
-    CachedSurface* best_exact_surface = nullptr;
-    float exact_surface_goodness = -1.f;
+    // Depth/Stencil formats need special treatment since they aren't sampleable using
+    // LookupTexture and can't use RGBA format
+    size_t tuple_idx = (size_t)params.pixel_format - 14;
+    ASSERT(tuple_idx < depth_format_tuples.size());
 
-    auto surface_interval =
-        boost::icl::interval<PAddr>::right_open(params.addr, params.addr + params_size);
-    auto range = surface_cache.equal_range(surface_interval);
-    for (auto it = range.first; it != range.second; ++it) {
-        for (auto it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
-            CachedSurface* surface = it2->get();
-
-            // Check if the request matches the surface exactly
-            if (params.addr == surface->addr && params.width == surface->width &&
-                params.height == surface->height && params.pixel_format == surface->pixel_format) {
-                // Make sure optional param-matching criteria are fulfilled
-                bool tiling_match = (params.is_tiled == surface->is_tiled);
-                bool res_scale_match = (params.res_scale_width == surface->res_scale_width &&
-                                        params.res_scale_height == surface->res_scale_height);
-                if (!match_res_scale || res_scale_match) {
-                    // Prioritize same-tiling and highest resolution surfaces
-                    float match_goodness =
-                        (float)tiling_match + surface->res_scale_width * surface->res_scale_height;
-                    if (match_goodness > exact_surface_goodness || surface->dirty) {
-                        exact_surface_goodness = match_goodness;
-                        best_exact_surface = surface;
-                    }
-                }
-            }
+    // OpenGL needs 4 bpp alignment for D24 since using GL_UNSIGNED_INT as type
+    gl_bytes_per_pixel = (params.pixel_format == PixelFormat::D24)
+                             ? 4
+                             : CachedSurface::GetFormatBpp(params.pixel_format) / 8;
+    return depth_format_tuples[tuple_idx];
+}
+
+/// Converts a surface's data in emulated memory to the layout described by GetUploadFormat
+static void DecodeSurface(const CachedSurface& params, u8* texture_src_data, u8* gl_data) {
+    using PixelFormat = CachedSurface::PixelFormat;
+    using SurfaceType = CachedSurface::SurfaceType;
+
+    u32 bytes_per_pixel = CachedSurface::GetFormatBpp(params.pixel_format) / 8;
+
+    if (!params.is_tiled) {
+        u32 line_size = params.width * bytes_per_pixel;
+        u32 src_stride =
+            (params.pixel_stride != 0 ? params.pixel_stride : params.width) * bytes_per_pixel;
+        for (u32 y = 0; y < params.height; ++y) {
+            std::memcpy(gl_data + y * line_size, texture_src_data + y * src_stride, line_size);
         }
+        return;
     }
 
-    // Return the best exact surface if found
-    if (best_exact_surface != nullptr) {
-        return best_exact_surface;
+    SurfaceType type = CachedSurface::GetFormatType(params.pixel_format);
+    if (type != SurfaceType::Depth && type != SurfaceType::DepthStencil) {
+        Pica::Texture::TextureInfo tex_info;
+        tex_info.width = params.width;
+        tex_info.height = params.height;
+        tex_info.format = (Pica::TexturingRegs::TextureFormat)params.pixel_format;
+        tex_info.SetDefaultStride();
+        tex_info.physical_address = params.addr;
+
+        // Pica textures start at the bottom row, OpenGL ones at the top row
+        auto tex_buffer = reinterpret_cast<Math::Vec4<u8>*>(gl_data);
+        Pica::Texture::DecodeTexture(texture_src_data, tex_info,
+                                     tex_buffer + params.width * (params.height - 1),
+                                     -static_cast<ptrdiff_t>(params.width));
+        return;
     }
 
-    // No matching surfaces found, so create a new one
-    u8* texture_src_data = Memory::GetPhysicalPointer(params.addr);
-    if (texture_src_data == nullptr) {
-        return nullptr;
+    bool use_4bpp = (params.pixel_format == PixelFormat::D24);
+    u32 gl_bytes_per_pixel = use_4bpp ? 4 : bytes_per_pixel;
+
+    if (use_4bpp) {
+        // The padding byte of each pixel isn't written below, so clear it
+        std::memset(gl_data, 0, params.width * params.height * gl_bytes_per_pixel);
     }
 
-    MICROPROFILE_SCOPE(OpenGL_SurfaceUpload);
+    MortonCopyPixels(params.pixel_format, params.width, 0, params.height, bytes_per_pixel,
+                     gl_bytes_per_pixel, texture_src_data, use_4bpp ? gl_data + 1 : gl_data, true);
+}
 
-    // Stride only applies to linear images.
-    ASSERT(params.pixel_stride == 0 || !params.is_tiled);
+/**
+ * Loads a tiled color surface into the texture bound to unit 0, on the surface preloader's thread.
+ * @param data Snapshot of the surface's memory, which is also decoded from
+ */
+static void PreloadSurfaceTexture(const CachedSurface& params, GLuint texture, u8* data) {
+    AllocateSurfaceTexture(texture, params.pixel_format, params.width, params.height);
 
-    std::shared_ptr<CachedSurface> new_surface = std::make_shared<CachedSurface>();
+    u32 gl_bytes_per_pixel;
+    const FormatTuple tuple = GetUploadFormat(params, gl_bytes_per_pixel);
+    std::vector<u8> gl_data(params.width * params.height * gl_bytes_per_pixel);
+    DecodeSurface(params, data, gl_data.data());
 
-    new_surface->addr = params.addr;
-    new_surface->size = params_size;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, params.width, params.height, tuple.format, tuple.type,
+                    gl_data.data());
+}
 
-    new_surface->texture.Create();
-    new_surface->width = params.width;
-    new_surface->height = params.height;
-    new_surface->pixel_stride = params.pixel_stride;
-    new_surface->res_scale_width = params.res_scale_width;
-    new_surface->res_scale_height = params.res_scale_height;
+MICROPROFILE_DEFINE(OpenGL_TexturePool, "OpenGL", "Texture Pool", MP_RGB(192, 160, 64));
+OGLTexture RasterizerCacheOpenGL::AcquireSurfaceTexture(CachedSurface::PixelFormat pixel_format,
+                                                        u32 width, u32 height) {
+    MICROPROFILE_SCOPE(OpenGL_TexturePool);
+
+    // Prefer the most recently released texture, since it's the most likely to still be resident
+    auto it = std::find_if(texture_pool.rbegin(), texture_pool.rend(),
+                           [&](const PooledTexture& pooled) {
+                               return pooled.pixel_format == pixel_format &&
+                                      pooled.width == width && pooled.height == height;
+                           });
+    if (it != texture_pool.rend()) {
+        MICROPROFILE_META_CPU("Texture Pool Hit", 1);
+        OGLTexture texture = std::move(it->texture);
+        texture_pool.erase(std::next(it).base());
+        return texture;
+    }
 
-    new_surface->is_tiled = params.is_tiled;
-    new_surface->pixel_format = params.pixel_format;
-    new_surface->dirty = false;
+    MICROPROFILE_META_CPU("Texture Pool Miss", 1);
+    OGLTexture texture;
+    texture.Create();
+    AllocateSurfaceTexture(texture.handle, pixel_format, width, height);
+    return texture;
+}
 
-    if (!load_if_create) {
-        // Don't load any data; just allocate the surface's texture
-        AllocateSurfaceTexture(new_surface->texture.handle, new_surface->pixel_format,
-                               new_surface->GetScaledWidth(), new_surface->GetScaledHeight());
-    } else {
-        // TODO: Consider attempting subrect match in existing surfaces and direct blit here instead
-        // of memory upload below if that's a common scenario in some game
+void RasterizerCacheOpenGL::ReleaseSurfaceTexture(CachedSurface::PixelFormat pixel_format,
+                                                  u32 width, u32 height, OGLTexture&& texture) {
+    if (texture.handle == 0) {
+        return;
+    }
 
-        Memory::RasterizerFlushRegion(params.addr, params_size);
+    // Drop any lingering references from the current state, as deleting the texture would
+    OpenGLState::ResetTexture(texture.handle);
 
-        // Load data from memory to the new surface
-        OpenGLState cur_state = OpenGLState::GetCurState();
+    if (texture_pool_size == 0) {
+        texture.Release();
+        return;
+    }
 
-        GLuint old_tex = cur_state.texture_units[0].texture_2d;
-        cur_state.texture_units[0].texture_2d = new_surface->texture.handle;
-        cur_state.Apply();
-        glActiveTexture(GL_TEXTURE0);
+    PooledTexture pooled;
+    pooled.pixel_format = pixel_format;
+    pooled.width = width;
+    pooled.height = height;
+    pooled.texture = std::move(texture);
+    texture_pool.push_back(std::move(pooled));
 
-        if (!new_surface->is_tiled) {
-            // TODO: Ensure this will always be a color format, not a depth or other format
-            ASSERT((size_t)new_surface->pixel_format < fb_format_tuples.size());
-            const FormatTuple& tuple = fb_format_tuples[(unsigned int)params.pixel_format];
+    while (texture_pool.size() > texture_pool_size) {
+        texture_pool.pop_front();
+    }
+}
 
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)new_surface->pixel_stride);
-            glTexImage2D(GL_TEXTURE_2D, 0, tuple.internal_format, params.width, params.height, 0,
-                         tuple.format, tuple.type, texture_src_data);
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        } else {
-            SurfaceType type = CachedSurface::GetFormatType(new_surface->pixel_format);
-            if (type != SurfaceType::Depth && type != SurfaceType::DepthStencil) {
-                FormatTuple tuple;
-                if ((size_t)params.pixel_format < fb_format_tuples.size()) {
-                    tuple = fb_format_tuples[(unsigned int)params.pixel_format];
-                } else {
-                    // Texture
-                    tuple = {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE};
-                }
+MICROPROFILE_DEFINE(OpenGL_SurfaceCompress, "OpenGL", "Surface Compress", MP_RGB(160, 96, 192));
+bool RasterizerCacheOpenGL::LoadCompressedSurface(CachedSurface& surface,
+                                                  const u8* texture_src_data) {
+    if (!etc2_supported || surface.pixel_format != CachedSurface::PixelFormat::ETC1 ||
+        !surface.is_tiled || surface.res_scale_width != 1.f || surface.res_scale_height != 1.f ||
+        surface.width % 8 != 0 || surface.height % 8 != 0) {
+        return false;
+    }
 
-                std::vector<Math::Vec4<u8>> tex_buffer(params.width * params.height);
+    Memory::RasterizerFlushRegion(surface.addr, surface.size);
 
-                Pica::Texture::TextureInfo tex_info;
-                tex_info.width = params.width;
-                tex_info.height = params.height;
-                tex_info.format = (Pica::TexturingRegs::TextureFormat)params.pixel_format;
-                tex_info.SetDefaultStride();
-                tex_info.physical_address = params.addr;
+    MICROPROFILE_SCOPE(OpenGL_SurfaceCompress);
 
-                for (unsigned y = 0; y < params.height; ++y) {
-                    for (unsigned x = 0; x < params.width; ++x) {
-                        tex_buffer[x + params.width * y] = Pica::Texture::LookupTexture(
-                            texture_src_data, x, params.height - 1 - y, tex_info);
-                    }
-                }
+    Pica::Texture::TextureInfo tex_info;
+    tex_info.width = surface.width;
+    tex_info.height = surface.height;
+    tex_info.format = Pica::TexturingRegs::TextureFormat::ETC1;
+    tex_info.SetDefaultStride();
+    tex_info.physical_address = surface.addr;
 
-                glTexImage2D(GL_TEXTURE_2D, 0, tuple.internal_format, params.width, params.height,
-                             0, GL_RGBA, GL_UNSIGNED_BYTE, tex_buffer.data());
-            } else {
-                // Depth/Stencil formats need special treatment since they aren't sampleable using
-                // LookupTexture and can't use RGBA format
-                size_t tuple_idx = (size_t)params.pixel_format - 14;
-                ASSERT(tuple_idx < depth_format_tuples.size());
-                const FormatTuple& tuple = depth_format_tuples[tuple_idx];
+    // ETC1 blocks are half a byte per pixel
+    const u32 size = surface.width * surface.height / 2;
 
-                u32 bytes_per_pixel = CachedSurface::GetFormatBpp(params.pixel_format) / 8;
+    u8* upload_data;
+    GLintptr upload_offset;
+    std::tie(upload_data, upload_offset, std::ignore) = upload_buffer.Map(size, 4);
+    if (upload_data == nullptr) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    if (!Pica::Texture::ConvertETC1TextureToETC2(texture_src_data, tex_info, upload_data)) {
+        upload_buffer.Unmap(0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    upload_buffer.Unmap(size);
 
-                // OpenGL needs 4 bpp alignment for D24 since using GL_UNSIGNED_INT as type
-                bool use_4bpp = (params.pixel_format == PixelFormat::D24);
+    OpenGLState cur_state = OpenGLState::GetCurState();
 
-                u32 gl_bytes_per_pixel = use_4bpp ? 4 : bytes_per_pixel;
+    GLuint old_tex = cur_state.texture_units[0].texture_2d;
+    surface.texture.Create();
+    cur_state.texture_units[0].texture_2d = surface.texture.handle;
+    cur_state.Apply();
+    glActiveTexture(GL_TEXTURE0);
 
-                std::vector<u8> temp_fb_depth_buffer(params.width * params.height *
-                                                     gl_bytes_per_pixel);
+    glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGB8_ETC2, surface.width,
+                           surface.height, 0, size, reinterpret_cast<const GLvoid*>(upload_offset));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
-                u8* temp_fb_depth_buffer_ptr =
-                    use_4bpp ? temp_fb_depth_buffer.data() + 1 : temp_fb_depth_buffer.data();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-                MortonCopyPixels(params.pixel_format, params.width, params.height, bytes_per_pixel,
-                                 gl_bytes_per_pixel, texture_src_data, temp_fb_depth_buffer_ptr,
-                                 true);
+    cur_state.texture_units[0].texture_2d = old_tex;
+    cur_state.Apply();
 
-                glTexImage2D(GL_TEXTURE_2D, 0, tuple.internal_format, params.width, params.height,
-                             0, tuple.format, tuple.type, temp_fb_depth_buffer.data());
-            }
-        }
+    surface.is_compressed = true;
+    return true;
+}
 
-        // If not 1x scale, blit 1x texture to a new scaled texture and replace texture in surface
-        if (new_surface->res_scale_width != 1.f || new_surface->res_scale_height != 1.f) {
-            OGLTexture scaled_texture;
-            scaled_texture.Create();
+MICROPROFILE_DEFINE(OpenGL_SurfaceUntile, "OpenGL", "Surface Untile", MP_RGB(160, 64, 192));
+bool RasterizerCacheOpenGL::UntileSurfaceOnGPU(const CachedSurface& params,
+                                               const u8* texture_src_data, GLuint texture) {
+    if (untile_program.handle == 0 || !params.is_tiled ||
+        CachedSurface::GetFormatType(params.pixel_format) != CachedSurface::SurfaceType::Color) {
+        return false;
+    }
 
-            AllocateSurfaceTexture(scaled_texture.handle, new_surface->pixel_format,
-                                   new_surface->GetScaledWidth(), new_surface->GetScaledHeight());
-            BlitTextures(new_surface->texture.handle, scaled_texture.handle,
-                         CachedSurface::GetFormatType(new_surface->pixel_format),
-                         MathUtil::Rectangle<int>(0, 0, new_surface->width, new_surface->height),
-                         MathUtil::Rectangle<int>(0, 0, new_surface->GetScaledWidth(),
-                                                  new_surface->GetScaledHeight()));
+    const u32 size =
+        params.width * params.height * CachedSurface::GetFormatBpp(params.pixel_format) / 8;
 
-            new_surface->texture.Release();
-            new_surface->texture.handle = scaled_texture.handle;
-            scaled_texture.handle = 0;
-            cur_state.texture_units[0].texture_2d = new_surface->texture.handle;
-            cur_state.Apply();
-        }
+    // The raw tiled data is copied as-is, leaving all per-pixel work to the shader
+    u8* upload_data;
+    GLintptr upload_offset;
+    std::tie(upload_data, upload_offset, std::ignore) = upload_buffer.Map(size, 4);
+    if (upload_data == nullptr) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    MICROPROFILE_SCOPE(OpenGL_SurfaceUntile);
 
-        cur_state.texture_units[0].texture_2d = old_tex;
-        cur_state.Apply();
-    }
+    std::memcpy(upload_data, texture_src_data, size);
+    upload_buffer.Unmap(size);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
-    Memory::RasterizerMarkRegionCached(new_surface->addr, new_surface->size, 1);
-    surface_cache.add(std::make_pair(boost::icl::interval<PAddr>::right_open(
-                                         new_surface->addr, new_surface->addr + new_surface->size),
-                                     std::set<std::shared_ptr<CachedSurface>>({new_surface})));
-    return new_surface.get();
-}
+    const OpenGLState prev_state = OpenGLState::GetCurState();
+    OpenGLState state = prev_state;
 
-CachedSurface* RasterizerCacheOpenGL::GetSurfaceRect(const CachedSurface& params,
-                                                     bool match_res_scale, bool load_if_create,
-                                                     MathUtil::Rectangle<int>& out_rect) {
-    if (params.addr == 0) {
-        return nullptr;
-    }
+    SetFullscreenPassState(state);
+    state.draw.draw_framebuffer = transfer_framebuffers[1].handle;
+    state.draw.vertex_array = fullscreen_vertex_array.handle;
+    state.draw.shader_program = untile_program.handle;
+    state.Apply();
 
-    u32 total_pixels = params.width * params.height;
-    u32 params_size = total_pixels * CachedSurface::GetFormatBpp(params.pixel_format) / 8;
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
 
-    // Attempt to find encompassing surfaces
-    CachedSurface* best_subrect_surface = nullptr;
-    float subrect_surface_goodness = -1.f;
+    glActiveTexture(TextureUnits::SurfaceUntileBuffer.Enum());
+    glBindTexture(GL_TEXTURE_BUFFER, untile_buffer_texture.handle);
 
-    auto surface_interval =
-        boost::icl::interval<PAddr>::right_open(params.addr, params.addr + params_size);
-    auto cache_upper_bound = surface_cache.upper_bound(surface_interval);
-    for (auto it = surface_cache.lower_bound(surface_interval); it != cache_upper_bound; ++it) {
-        for (auto it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
-            CachedSurface* surface = it2->get();
-
-            // Check if the request is contained in the surface
-            if (params.addr >= surface->addr &&
-                params.addr + params_size - 1 <= surface->addr + surface->size - 1 &&
-                params.pixel_format == surface->pixel_format) {
-                // Make sure optional param-matching criteria are fulfilled
-                bool tiling_match = (params.is_tiled == surface->is_tiled);
-                bool res_scale_match = (params.res_scale_width == surface->res_scale_width &&
-                                        params.res_scale_height == surface->res_scale_height);
-                if (!match_res_scale || res_scale_match) {
-                    // Prioritize same-tiling and highest resolution surfaces
-                    float match_goodness =
-                        (float)tiling_match + surface->res_scale_width * surface->res_scale_height;
-                    if (match_goodness > subrect_surface_goodness || surface->dirty) {
-                        subrect_surface_goodness = match_goodness;
-                        best_subrect_surface = surface;
-                    }
+    glUniform1i(uniform_untile_word_offset, static_cast<GLint>(upload_offset / 4));
+    glUniform1i(uniform_untile_width, params.width);
+    glUniform1i(uniform_untile_height, params.height);
+    glUniform1i(uniform_untile_pixel_format, static_cast<GLint>(params.pixel_format));
+
+    GLint old_viewport[4];
+    glGetIntegerv(GL_VIEWPORT, old_viewport);
+    glViewport(0, 0, params.width, params.height);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glViewport(old_viewport[0], old_viewport[1], old_viewport[2], old_viewport[3]);
+
+    prev_state.Apply();
+    return true;
+}
+
+/**
+ * Returns the format used to read a surface's texture back from OpenGL.
+ * @param gl_bytes_per_pixel Set to the size of each pixel in the data returned by OpenGL
+ */
+static FormatTuple GetReadbackFormat(CachedSurface::PixelFormat pixel_format,
+                                     u32& gl_bytes_per_pixel) {
+    using PixelFormat = CachedSurface::PixelFormat;
+    using SurfaceType = CachedSurface::SurfaceType;
+
+    gl_bytes_per_pixel = CachedSurface::GetFormatBpp(pixel_format) / 8;
+
+    SurfaceType type = CachedSurface::GetFormatType(pixel_format);
+    if (type != SurfaceType::Depth && type != SurfaceType::DepthStencil) {
+        // TODO: Ensure this will always be a color format, not a depth or other format
+        ASSERT((size_t)pixel_format < fb_format_tuples.size());
+        return fb_format_tuples[(unsigned int)pixel_format];
+    }
+
+    // Depth/Stencil formats need special treatment since they aren't sampleable using
+    // LookupTexture and can't use RGBA format
+    size_t tuple_idx = (size_t)pixel_format - 14;
+    ASSERT(tuple_idx < depth_format_tuples.size());
+
+    // OpenGL needs 4 bpp alignment for D24 since using GL_UNSIGNED_INT as type
+    if (pixel_format == PixelFormat::D24) {
+        gl_bytes_per_pixel = 4;
+    }
+
+    return depth_format_tuples[tuple_idx];
+}
+
+/// Returns whether the data of a surface in format `src` can be reinterpreted as format `dst`
+static bool CanReinterpretFormats(CachedSurface::PixelFormat src, CachedSurface::PixelFormat dst) {
+    using PixelFormat = CachedSurface::PixelFormat;
+
+    return (src == PixelFormat::D24S8 && dst == PixelFormat::RGBA8) ||
+           (src == PixelFormat::RGBA8 && dst == PixelFormat::D24S8) ||
+           (src == PixelFormat::D16 && dst == PixelFormat::RGB565) ||
+           (src == PixelFormat::RGB565 && dst == PixelFormat::D16);
+}
+
+CachedSurface* RasterizerCacheOpenGL::FindReinterpretSource(const CachedSurface& params,
+                                                            bool match_res_scale) {
+    using PixelFormat = CachedSurface::PixelFormat;
+
+    const u32 params_size =
+        params.width * params.height * CachedSurface::GetFormatBpp(params.pixel_format) / 8;
+
+    CachedSurface* source = nullptr;
+    lookup_results.clear();
+    GetSurfacesInRegion(params.addr, params_size, lookup_results);
+    for (CachedSurface* surface : lookup_results) {
+        const bool is_candidate =
+            surface->addr == params.addr && surface->width == params.width &&
+            surface->height == params.height && surface->is_tiled == params.is_tiled &&
+            CanReinterpretFormats(surface->pixel_format, params.pixel_format) &&
+            (!match_res_scale || (surface->res_scale_width == params.res_scale_width &&
+                                  surface->res_scale_height == params.res_scale_height));
+
+        if (!is_candidate) {
+            // Any other modified surface here would have to be merged through memory
+            if (surface->dirty) {
+                return nullptr;
+            }
+            continue;
+        }
+
+        // Prefer the surface holding data that isn't in memory yet
+        if (source == nullptr || (surface->dirty && !source->dirty)) {
+            source = surface;
+        } else if (surface->dirty && source->dirty) {
+            return nullptr;
+        }
+    }
+
+    if (source == nullptr) {
+        return nullptr;
+    }
+
+    // The D24S8 <-> RGBA8 conversions go through a texel buffer holding the whole surface
+    if (source->pixel_format == PixelFormat::D24S8 || source->pixel_format == PixelFormat::RGBA8) {
+        const u64 texels = static_cast<u64>(source->GetScaledWidth()) * source->GetScaledHeight();
+        if (reinterpret_buffer_texture.handle == 0 ||
+            texels > static_cast<u64>(max_texture_buffer_size)) {
+            return nullptr;
+        }
+    }
+
+    return source;
+}
+
+CachedSurface* RasterizerCacheOpenGL::FindRescaleSource(const CachedSurface& params) {
+    const u32 params_size =
+        params.width * params.height * CachedSurface::GetFormatBpp(params.pixel_format) / 8;
+
+    CachedSurface* source = nullptr;
+    lookup_results.clear();
+    GetSurfacesInRegion(params.addr, params_size, lookup_results);
+    for (CachedSurface* surface : lookup_results) {
+        const bool is_candidate =
+            surface->addr == params.addr && surface->width == params.width &&
+            surface->height == params.height && surface->pixel_format == params.pixel_format &&
+            surface->is_tiled == params.is_tiled && surface->pixel_stride == params.pixel_stride &&
+            !surface->is_compressed;
+
+        if (!is_candidate) {
+            // Any other modified surface here would have to be merged through memory
+            if (surface->dirty) {
+                return nullptr;
+            }
+            continue;
+        }
+
+        // Prefer the surface holding data that isn't in memory yet, then the sharpest one
+        if (source == nullptr || (surface->dirty && !source->dirty) ||
+            (surface->dirty == source->dirty &&
+             surface->res_scale_width * surface->res_scale_height >
+                 source->res_scale_width * source->res_scale_height)) {
+            source = surface;
+        }
+    }
+
+    return source;
+}
+
+CachedSurface* RasterizerCacheOpenGL::FindGrowSource(const CachedSurface& params,
+                                                     bool match_res_scale) {
+    if (CachedSurface::GetFormatType(params.pixel_format) == CachedSurface::SurfaceType::Texture) {
+        return nullptr;
+    }
+
+    const u32 params_size =
+        params.width * params.height * CachedSurface::GetFormatBpp(params.pixel_format) / 8;
+
+    CachedSurface* source = nullptr;
+    lookup_results.clear();
+    GetSurfacesInRegion(params.addr, params_size, lookup_results);
+    for (CachedSurface* surface : lookup_results) {
+        const bool is_candidate =
+            surface->addr == params.addr && surface->width == params.width &&
+            surface->height < params.height && surface->pixel_format == params.pixel_format &&
+            surface->is_tiled == params.is_tiled && surface->pixel_stride == params.pixel_stride &&
+            (!match_res_scale || (surface->res_scale_width == params.res_scale_width &&
+                                  surface->res_scale_height == params.res_scale_height));
+
+        // Any other modified surface here would have to be merged through memory, and so would a
+        // modified candidate that isn't picked
+        if (!is_candidate) {
+            if (surface->dirty) {
+                return nullptr;
+            }
+            continue;
+        }
+        if (source != nullptr && (source->dirty || surface->dirty)) {
+            return nullptr;
+        }
+        if (source == nullptr || surface->height > source->height) {
+            source = surface;
+        }
+    }
+
+    return source;
+}
+
+MICROPROFILE_DEFINE(OpenGL_SurfaceReinterpret, "OpenGL", "Surface Reinterpret",
+                    MP_RGB(192, 64, 160));
+void RasterizerCacheOpenGL::ReinterpretSurface(CachedSurface* src, CachedSurface* dst) {
+    using PixelFormat = CachedSurface::PixelFormat;
+    using SurfaceType = CachedSurface::SurfaceType;
+
+    MICROPROFILE_SCOPE(OpenGL_SurfaceReinterpret);
+
+    const u32 width = src->GetScaledWidth();
+    const u32 height = src->GetScaledHeight();
+
+    // Both formats of each pair have the same size and are read back in their memory layout,
+    // except for D24S8 which OpenGL packs with the stencil byte at the other end
+    u32 gl_bytes_per_pixel;
+    const FormatTuple src_tuple = GetReadbackFormat(src->pixel_format, gl_bytes_per_pixel);
+    const FormatTuple dst_tuple = GetReadbackFormat(dst->pixel_format, gl_bytes_per_pixel);
+    const GLsizeiptr size = width * height * gl_bytes_per_pixel;
+
+    auto bind_staging_buffer = [this, size](size_t index) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, reinterpret_buffers[index].handle);
+        if (reinterpret_buffer_sizes[index] < size) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_COPY);
+            reinterpret_buffer_sizes[index] = size;
+        }
+    };
+
+    bind_staging_buffer(0);
+    ReadTexturePixels(src->texture.handle, CachedSurface::GetFormatType(src->pixel_format), 0,
+                      width, height, src_tuple.format, src_tuple.type, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    GLuint upload_source = reinterpret_buffers[0].handle;
+
+    if (src->pixel_format == PixelFormat::D24S8 || dst->pixel_format == PixelFormat::D24S8) {
+        const bool to_rgba8 = (dst->pixel_format == PixelFormat::RGBA8);
+
+        if (!to_rgba8 &&
+            (reinterpret_uint_width != width || reinterpret_uint_height != height)) {
+            // Stencil can't be written from a shader, so produce the OpenGL D24S8 layout in an
+            // integer texture first and upload the depth-stencil texture from that
+            reinterpret_uint_texture.Release();
+            reinterpret_uint_texture.Create();
+
+            OpenGLState cur_state = OpenGLState::GetCurState();
+            GLuint old_tex = cur_state.texture_units[0].texture_2d;
+            cur_state.texture_units[0].texture_2d = reinterpret_uint_texture.handle;
+            cur_state.Apply();
+            glActiveTexture(GL_TEXTURE0);
+
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER,
+                         GL_UNSIGNED_INT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+            cur_state.texture_units[0].texture_2d = old_tex;
+            cur_state.Apply();
+
+            reinterpret_uint_width = width;
+            reinterpret_uint_height = height;
+        }
+
+        const GLuint target = to_rgba8 ? dst->texture.handle : reinterpret_uint_texture.handle;
+        OpenGLState::ResetTexture(target);
+
+        const OpenGLState prev_state = OpenGLState::GetCurState();
+        OpenGLState state = prev_state;
+
+        SetFullscreenPassState(state);
+        state.draw.draw_framebuffer = transfer_framebuffers[1].handle;
+        state.draw.vertex_array = fullscreen_vertex_array.handle;
+        state.draw.shader_program =
+            to_rgba8 ? d24s8_to_rgba8_program.handle : rgba8_to_d24s8_program.handle;
+        state.Apply();
+
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target,
+                               0);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0,
+                               0);
+
+        glActiveTexture(TextureUnits::SurfaceReinterpretBuffer.Enum());
+        glBindTexture(GL_TEXTURE_BUFFER, reinterpret_buffer_texture.handle);
+        glUniform1i(to_rgba8 ? uniform_d24s8_to_rgba8_width : uniform_rgba8_to_d24s8_width,
+                    width);
+
+        GLint old_viewport[4];
+        glGetIntegerv(GL_VIEWPORT, old_viewport);
+        glViewport(0, 0, width, height);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glViewport(old_viewport[0], old_viewport[1], old_viewport[2], old_viewport[3]);
+
+        prev_state.Apply();
+
+        if (to_rgba8) {
+            // The shader wrote the result straight into the destination
+            return;
+        }
+
+        bind_staging_buffer(1);
+        ReadTexturePixels(reinterpret_uint_texture.handle, SurfaceType::Color, 0, width, height,
+                          GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        upload_source = reinterpret_buffers[1].handle;
+    }
+
+    OpenGLState cur_state = OpenGLState::GetCurState();
+    GLuint old_tex = cur_state.texture_units[0].texture_2d;
+    cur_state.texture_units[0].texture_2d = dst->texture.handle;
+    cur_state.Apply();
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload_source);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, dst_tuple.format, dst_tuple.type,
+                    nullptr);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    cur_state.texture_units[0].texture_2d = old_tex;
+    cur_state.Apply();
+}
+
+/// Whether the memory of a surface is a single range, which its contents can be hashed from.
+/// Strided linear images leave gaps between their rows.
+static bool IsContiguous(const CachedSurface& surface) {
+    return surface.is_tiled || surface.pixel_stride == 0 || surface.pixel_stride == surface.width;
+}
+
+MICROPROFILE_DEFINE(OpenGL_SurfaceUpload, "OpenGL", "Surface Upload", MP_RGB(128, 64, 192));
+CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bool match_res_scale,
+                                                 bool load_if_create) {
+    if (params.addr == 0) {
+        return nullptr;
+    }
+
+    u32 params_size =
+        params.width * params.height * CachedSurface::GetFormatBpp(params.pixel_format) / 8;
+
+    // Check for an exact match in existing surfaces
+    CachedSurface* best_exact_surface = nullptr;
+    float exact_surface_goodness = -1.f;
+
+    lookup_results.clear();
+    GetSurfacesInRegion(params.addr, params_size, lookup_results);
+    for (CachedSurface* surface : lookup_results) {
+        // Check if the request matches the surface exactly
+        if (params.addr == surface->addr && params.width == surface->width &&
+            params.height == surface->height && params.pixel_format == surface->pixel_format) {
+            // Make sure optional param-matching criteria are fulfilled
+            bool tiling_match = (params.is_tiled == surface->is_tiled);
+            bool res_scale_match = (params.res_scale_width == surface->res_scale_width &&
+                                    params.res_scale_height == surface->res_scale_height);
+            if (!match_res_scale || res_scale_match) {
+                // Prioritize same-tiling and highest resolution surfaces
+                float match_goodness =
+                    (float)tiling_match + surface->res_scale_width * surface->res_scale_height;
+                if (match_goodness > exact_surface_goodness || surface->dirty) {
+                    exact_surface_goodness = match_goodness;
+                    best_exact_surface = surface;
+                }
+            }
+        }
+    }
+
+    // Return the best exact surface if found
+    if (best_exact_surface != nullptr) {
+        Core::AddPerfCount(Core::PerfStats::Counter::SurfaceCacheHits);
+        return best_exact_surface;
+    }
+
+    // No matching surfaces found, so create a new one
+    u8* texture_src_data = Memory::GetPhysicalPointer(params.addr);
+    if (texture_src_data == nullptr) {
+        return nullptr;
+    }
+
+    // Data that is only up to date in a surface of a compatible format can be converted on the GPU
+    // instead of being written back to memory and decoded again
+    CachedSurface* reinterpret_source =
+        load_if_create ? FindReinterpretSource(params, match_res_scale) : nullptr;
+
+    // An identical surface may have been invalidated by a write that didn't actually change its
+    // contents, in which case it can be brought back without decoding and uploading it again
+    if (load_if_create && reinterpret_source == nullptr) {
+        CachedSurface* revalidated_surface = TryRevalidateSurface(params, texture_src_data);
+        if (revalidated_surface != nullptr) {
+            Core::AddPerfCount(Core::PerfStats::Counter::SurfaceCacheHits);
+            return revalidated_surface;
+        }
+    }
+
+    Core::AddPerfCount(Core::PerfStats::Counter::SurfaceCacheMisses);
+    MICROPROFILE_SCOPE(OpenGL_SurfaceUpload);
+    GLTimerQueries::ScopedTimer gpu_timer(Core::PerfStats::GPUCategory::SurfaceUpload);
+
+    // Stride only applies to linear images.
+    ASSERT(params.pixel_stride == 0 || !params.is_tiled);
+
+    // Hand the texture back to the pool once the surface is no longer referenced anywhere
+    // Textures with mipmap levels aren't pooled, as the levels would outlive the surface
+    std::shared_ptr<CachedSurface> new_surface(new CachedSurface, [this](CachedSurface* surface) {
+        if (surface->shared_texture != nullptr) {
+            // Only borrowed, the shared texture is pooled once no surface uses it anymore
+            surface->texture.handle = 0;
+        } else if (!surface->is_compressed && surface->mip_levels.empty()) {
+            ReleaseSurfaceTexture(surface->pixel_format, surface->GetScaledWidth(),
+                                  surface->GetScaledHeight(), std::move(surface->texture));
+        }
+        delete surface;
+    });
+
+    new_surface->id = next_surface_id++;
+    new_surface->addr = params.addr;
+    new_surface->size = params_size;
+
+    new_surface->width = params.width;
+    new_surface->height = params.height;
+    new_surface->pixel_stride = params.pixel_stride;
+    new_surface->res_scale_width = params.res_scale_width;
+    new_surface->res_scale_height = params.res_scale_height;
+
+    new_surface->is_tiled = params.is_tiled;
+    new_surface->pixel_format = params.pixel_format;
+    new_surface->dirty = false;
+
+    if (reinterpret_source != nullptr) {
+        new_surface->res_scale_width = reinterpret_source->res_scale_width;
+        new_surface->res_scale_height = reinterpret_source->res_scale_height;
+    }
+
+    // The same data at another resolution scale is resampled on the GPU, rather than flushed and
+    // loaded back at 1x
+    CachedSurface* rescale_source = (load_if_create && reinterpret_source == nullptr)
+                                        ? FindRescaleSource(params)
+                                        : nullptr;
+
+    // A render target that is bound again with more rows takes the rows it had from the surface
+    // holding them on the GPU, so only the new rows go through memory
+    CachedSurface* grow_source =
+        (load_if_create && reinterpret_source == nullptr && rescale_source == nullptr)
+            ? FindGrowSource(params, match_res_scale)
+            : nullptr;
+
+    if (!load_if_create || reinterpret_source != nullptr || rescale_source != nullptr) {
+        // Don't load any data; just allocate the surface's texture
+        new_surface->texture =
+            AcquireSurfaceTexture(new_surface->pixel_format, new_surface->GetScaledWidth(),
+                                  new_surface->GetScaledHeight());
+
+        if (reinterpret_source != nullptr) {
+            ReinterpretSurface(reinterpret_source, new_surface.get());
+        } else if (rescale_source != nullptr) {
+            BlitTextures(rescale_source->texture.handle, new_surface->texture.handle,
+                         CachedSurface::GetFormatType(new_surface->pixel_format),
+                         MathUtil::Rectangle<int>(0, 0, rescale_source->GetScaledWidth(),
+                                                  rescale_source->GetScaledHeight()),
+                         MathUtil::Rectangle<int>(0, 0, new_surface->GetScaledWidth(),
+                                                  new_surface->GetScaledHeight()));
+        }
+    } else if (LoadCompressedSurface(*new_surface, texture_src_data)) {
+        // The GPU decodes the texture whenever it samples it
+    } else if (grow_source == nullptr && AdoptPreloadedSurface(*new_surface, texture_src_data)) {
+        // The preloader already decoded and uploaded the same data
+    } else if (grow_source == nullptr && AdoptSharedTexture(*new_surface, texture_src_data)) {
+        // Another surface already decoded and uploaded the same data
+    } else {
+        // TODO: Consider attempting subrect match in existing surfaces and direct blit here instead
+        // of memory upload below if that's a common scenario in some game
+
+        if (grow_source != nullptr) {
+            // The rows of the source are copied from it below rather than written back
+            FlushRegion(params.addr, params_size, grow_source, false);
+        } else {
+            Memory::RasterizerFlushRegion(params.addr, params_size);
+        }
+
+        new_surface->texture =
+            AcquireSurfaceTexture(new_surface->pixel_format, params.width, params.height);
+
+        const bool untiled_on_gpu =
+            UntileSurfaceOnGPU(params, texture_src_data, new_surface->texture.handle);
+
+        // Load data from memory to the new surface
+        OpenGLState cur_state = OpenGLState::GetCurState();
+
+        GLuint old_tex = cur_state.texture_units[0].texture_2d;
+        cur_state.texture_units[0].texture_2d = new_surface->texture.handle;
+        cur_state.Apply();
+        glActiveTexture(GL_TEXTURE0);
+
+        if (!untiled_on_gpu) {
+            u32 gl_bytes_per_pixel;
+            const FormatTuple tuple = GetUploadFormat(params, gl_bytes_per_pixel);
+            const u32 upload_size = params.width * params.height * gl_bytes_per_pixel;
+
+            // Decode straight into the upload stream buffer when possible, which avoids both a
+            // temporary allocation and a synchronous copy of the data by the driver
+            std::vector<u8> fallback_buffer;
+            u8* upload_data;
+            GLintptr upload_offset;
+            std::tie(upload_data, upload_offset, std::ignore) = upload_buffer.Map(upload_size, 4);
+            if (upload_data == nullptr) {
+                fallback_buffer.resize(upload_size);
+                upload_data = fallback_buffer.data();
+            }
+
+            DecodeSurface(params, texture_src_data, upload_data);
+
+            if (fallback_buffer.empty()) {
+                // Unmapping leaves the stream buffer bound as the pixel unpack buffer
+                upload_buffer.Unmap(upload_size);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, params.width, params.height, tuple.format,
+                                tuple.type, reinterpret_cast<const GLvoid*>(upload_offset));
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            } else {
+                // A failed map may still leave the stream buffer bound, which would make the
+                // pointer read as an offset into it
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, params.width, params.height, tuple.format,
+                                tuple.type, fallback_buffer.data());
+            }
+        }
+
+        // If not 1x scale, blit 1x texture to a new scaled texture and replace texture in surface
+        if (new_surface->res_scale_width != 1.f || new_surface->res_scale_height != 1.f) {
+            OGLTexture scaled_texture =
+                AcquireSurfaceTexture(new_surface->pixel_format, new_surface->GetScaledWidth(),
+                                      new_surface->GetScaledHeight());
+            BlitTextures(new_surface->texture.handle, scaled_texture.handle,
+                         CachedSurface::GetFormatType(new_surface->pixel_format),
+                         MathUtil::Rectangle<int>(0, 0, new_surface->width, new_surface->height),
+                         MathUtil::Rectangle<int>(0, 0, new_surface->GetScaledWidth(),
+                                                  new_surface->GetScaledHeight()));
+
+            ReleaseSurfaceTexture(new_surface->pixel_format, new_surface->width,
+                                  new_surface->height, std::move(new_surface->texture));
+            new_surface->texture = std::move(scaled_texture);
+            cur_state.texture_units[0].texture_2d = new_surface->texture.handle;
+            cur_state.Apply();
+        }
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        cur_state.texture_units[0].texture_2d = old_tex;
+        cur_state.Apply();
+
+        if (share_identical_textures && new_surface->has_source_hash) {
+            ShareSurfaceTexture(*new_surface);
+        }
+    }
+
+    if (grow_source != nullptr) {
+        // Tiled surfaces are flipped vertically in the rasterizer vs. 3DS memory, so the rows the
+        // source holds are at the top of its texture and at the bottom of the new one
+        const int width = static_cast<int>(new_surface->GetScaledWidth());
+        const int height = static_cast<int>(new_surface->GetScaledHeight());
+        const int source_rows =
+            static_cast<int>(grow_source->height * new_surface->res_scale_height);
+        const int source_width = static_cast<int>(grow_source->GetScaledWidth());
+        const int source_height = static_cast<int>(grow_source->GetScaledHeight());
+        if (params.is_tiled) {
+            BlitTextures(grow_source->texture.handle, new_surface->texture.handle,
+                         CachedSurface::GetFormatType(params.pixel_format),
+                         MathUtil::Rectangle<int>(0, source_height, source_width, 0),
+                         MathUtil::Rectangle<int>(0, height, width, height - source_rows));
+        } else {
+            BlitTextures(grow_source->texture.handle, new_surface->texture.handle,
+                         CachedSurface::GetFormatType(params.pixel_format),
+                         MathUtil::Rectangle<int>(0, 0, source_width, source_height),
+                         MathUtil::Rectangle<int>(0, 0, width, source_rows));
+        }
+        if (grow_source->dirty) {
+            MarkSurfaceRowsDirty(new_surface.get(), grow_source->dirty_rows_begin,
+                                 grow_source->dirty_rows_end);
+        }
+    }
+
+    // Remember the source data of surfaces loaded from memory, allowing them to be re-validated
+    // after being invalidated
+    if (load_if_create && reinterpret_source == nullptr && rescale_source == nullptr &&
+        grow_source == nullptr && !new_surface->has_source_hash && IsContiguous(params)) {
+        new_surface->source_hash = Common::ComputeHash64(texture_src_data, params_size);
+        new_surface->has_source_hash = true;
+    }
+
+    Memory::RasterizerMarkRegionCached(new_surface->addr, new_surface->size, 1);
+    CachedSurface* surface = new_surface.get();
+    RegisterSurface(std::move(new_surface));
+
+    // The new surface holds everything the source did, so the source would only ever go stale
+    if (grow_source != nullptr) {
+        Memory::RasterizerMarkRegionCached(grow_source->addr, grow_source->size, -1);
+        UnregisterSurface(grow_source);
+    }
+    return surface;
+}
+
+/// Number of pixels between the starts of two rows of a linear surface
+static u32 GetLinearPitch(const CachedSurface& surface) {
+    return surface.pixel_stride != 0 ? surface.pixel_stride : surface.width;
+}
+
+/**
+ * Whether the memory of a request forms a rectangle within a surface that contains it. Its rows
+ * need to have the same pitch as the surface's, and to start at the beginning of one of the
+ * surface's rows of tiles, or anywhere within a row that leaves room for them if linear.
+ */
+static bool IsSubrectCompatible(const CachedSurface& params, const CachedSurface& surface) {
+    const u32 bits_per_pixel = CachedSurface::GetFormatBpp(surface.pixel_format);
+    const u32 offset_bits = (params.addr - surface.addr) * 8;
+
+    if (surface.is_tiled) {
+        return params.is_tiled && params.width == surface.width &&
+               offset_bits % (surface.width * 8 * bits_per_pixel) == 0;
+    }
+
+    const u32 pitch = GetLinearPitch(surface);
+    return !params.is_tiled && GetLinearPitch(params) == pitch &&
+           offset_bits % bits_per_pixel == 0 &&
+           offset_bits / bits_per_pixel % pitch + params.width <= surface.width;
+}
+
+CachedSurface* RasterizerCacheOpenGL::GetSurfaceRect(const CachedSurface& params,
+                                                     bool match_res_scale, bool load_if_create,
+                                                     MathUtil::Rectangle<int>& out_rect) {
+    if (params.addr == 0) {
+        return nullptr;
+    }
+
+    u32 total_pixels = params.width * params.height;
+    u32 params_size = total_pixels * CachedSurface::GetFormatBpp(params.pixel_format) / 8;
+
+    // Attempt to find encompassing surfaces
+    CachedSurface* best_subrect_surface = nullptr;
+    float subrect_surface_goodness = -1.f;
+
+    lookup_results.clear();
+    GetSurfacesInRegion(params.addr, params_size, lookup_results);
+    for (CachedSurface* surface : lookup_results) {
+        // Check if the request is contained in the surface, as a rectangle of it
+        if (params.addr >= surface->addr &&
+            params.addr + params_size - 1 <= surface->addr + surface->size - 1 &&
+            params.pixel_format == surface->pixel_format &&
+            IsSubrectCompatible(params, *surface)) {
+            // Make sure optional param-matching criteria are fulfilled
+            bool tiling_match = (params.is_tiled == surface->is_tiled);
+            bool res_scale_match = (params.res_scale_width == surface->res_scale_width &&
+                                    params.res_scale_height == surface->res_scale_height);
+            if (!match_res_scale || res_scale_match) {
+                // Prioritize same-tiling and highest resolution surfaces
+                float match_goodness =
+                    (float)tiling_match + surface->res_scale_width * surface->res_scale_height;
+                if (match_goodness > subrect_surface_goodness || surface->dirty) {
+                    subrect_surface_goodness = match_goodness;
+                    best_subrect_surface = surface;
                 }
             }
         }
@@ -471,9 +1481,10 @@ CachedSurface* RasterizerCacheOpenGL::GetSurfaceRect(const CachedSurface& params
         int x0, y0;
 
         if (!params.is_tiled) {
+            const u32 pitch = GetLinearPitch(*best_subrect_surface);
             u32 begin_pixel_index = (params.addr - best_subrect_surface->addr) / bytes_per_pixel;
-            x0 = begin_pixel_index % best_subrect_surface->width;
-            y0 = begin_pixel_index / best_subrect_surface->width;
+            x0 = begin_pixel_index % pitch;
+            y0 = begin_pixel_index / pitch;
 
             out_rect = MathUtil::Rectangle<int>(x0, y0, x0 + params.width, y0 + params.height);
         } else {
@@ -522,7 +1533,73 @@ CachedSurface* RasterizerCacheOpenGL::GetTextureSurface(
     params.height = info.height;
     params.is_tiled = true;
     params.pixel_format = CachedSurface::PixelFormatFromTextureFormat(info.format);
-    return GetSurface(params, false, true);
+
+    CachedSurface* surface = GetSurface(params, false, true);
+    const u32 max_level = config.config.lod.max_level;
+    if (surface != nullptr && max_level > 0 && !surface->is_compressed) {
+        SyncMipLevels(surface, params, max_level);
+    }
+    return surface;
+}
+
+void RasterizerCacheOpenGL::SyncMipLevels(CachedSurface* surface, const CachedSurface& params,
+                                          u32 max_level) {
+    // The levels follow each other in memory, each half as wide and high as the one before. The
+    // PICA works on 8x8 tiles, so no level is smaller than that.
+    const u32 bits_per_pixel = CachedSurface::GetFormatBpp(params.pixel_format);
+    u32 num_levels = 0;
+    while (num_levels < max_level && (params.width >> (num_levels + 1)) >= 8 &&
+           (params.height >> (num_levels + 1)) >= 8) {
+        ++num_levels;
+    }
+    if (num_levels == 0) {
+        return;
+    }
+
+    // The levels are stored in the surface's texture, which other surfaces can't see change
+    UnshareSurfaceTexture(surface);
+
+    const u32 scaled_width = surface->GetScaledWidth();
+    const u32 scaled_height = surface->GetScaledHeight();
+    if (surface->mip_levels.size() < num_levels) {
+        const u32 first_level = static_cast<u32>(surface->mip_levels.size()) + 1;
+        AllocateSurfaceTextureLevels(surface->texture.handle, surface->pixel_format, scaled_width,
+                                     scaled_height, first_level, num_levels);
+        surface->mip_levels.resize(num_levels);
+    }
+
+    CachedSurface level_params;
+    level_params.addr = params.addr;
+    level_params.width = params.width;
+    level_params.height = params.height;
+    level_params.is_tiled = params.is_tiled;
+    level_params.pixel_format = params.pixel_format;
+    for (u32 level = 1; level <= num_levels; ++level) {
+        level_params.addr += level_params.width * level_params.height * bits_per_pixel / 8;
+        level_params.width /= 2;
+        level_params.height /= 2;
+
+        // Looking a level up only flushes other surfaces, which keeps `surface` valid
+        CachedSurface* level_surface = GetSurface(level_params, false, true);
+        if (level_surface == nullptr || level_surface->is_compressed) {
+            break;
+        }
+
+        CachedSurface::MipLevelSource& source = surface->mip_levels[level - 1];
+        if (source.surface_id == level_surface->id &&
+            source.modification_count == level_surface->modification_count) {
+            continue;
+        }
+
+        BlitTextures(level_surface->texture.handle, surface->texture.handle,
+                     CachedSurface::GetFormatType(surface->pixel_format),
+                     MathUtil::Rectangle<int>(0, 0, level_surface->GetScaledWidth(),
+                                              level_surface->GetScaledHeight()),
+                     MathUtil::Rectangle<int>(0, 0, scaled_width >> level, scaled_height >> level),
+                     level);
+        source.surface_id = level_surface->id;
+        source.modification_count = level_surface->modification_count;
+    }
 }
 
 std::tuple<CachedSurface*, CachedSurface*, MathUtil::Rectangle<int>>
@@ -627,67 +1704,230 @@ RasterizerCacheOpenGL::GetFramebufferSurfaces(
         rect = MathUtil::Rectangle<int>(0, 0, 0, 0);
     }
 
+    // Once rendering moves on from a surface that the CPU has read back before, start reading its
+    // contents back already so that a later flush doesn't have to stall on the GPU
+    if (last_color_surface != nullptr && last_color_surface != color_surface &&
+        last_color_surface->flush_count > 0) {
+        BeginSurfaceDownload(last_color_surface);
+    }
+    if (last_depth_surface != nullptr && last_depth_surface != depth_surface &&
+        last_depth_surface->flush_count > 0) {
+        BeginSurfaceDownload(last_depth_surface);
+    }
+    last_color_surface = color_surface;
+    last_depth_surface = depth_surface;
+
+    // The surfaces are about to be rendered to
+    if (color_surface != nullptr) {
+        UnshareSurfaceTexture(color_surface);
+    }
+    if (depth_surface != nullptr) {
+        UnshareSurfaceTexture(depth_surface);
+    }
+
     return std::make_tuple(color_surface, depth_surface, rect);
 }
 
 CachedSurface* RasterizerCacheOpenGL::TryGetFillSurface(const GPU::Regs::MemoryFillConfig& config) {
-    auto surface_interval =
-        boost::icl::interval<PAddr>::right_open(config.GetStartAddress(), config.GetEndAddress());
-    auto range = surface_cache.equal_range(surface_interval);
-    for (auto it = range.first; it != range.second; ++it) {
-        for (auto it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
-            int bits_per_value = 0;
-            if (config.fill_24bit) {
-                bits_per_value = 24;
-            } else if (config.fill_32bit) {
-                bits_per_value = 32;
-            } else {
-                bits_per_value = 16;
+    int bits_per_value = 0;
+    if (config.fill_24bit) {
+        bits_per_value = 24;
+    } else if (config.fill_32bit) {
+        bits_per_value = 32;
+    } else {
+        bits_per_value = 16;
+    }
+
+    lookup_results.clear();
+    GetSurfacesInRegion(config.GetStartAddress(),
+                        config.GetEndAddress() - config.GetStartAddress(), lookup_results);
+    for (CachedSurface* surface : lookup_results) {
+        if (surface->addr == config.GetStartAddress() &&
+            CachedSurface::GetFormatBpp(surface->pixel_format) == bits_per_value &&
+            (surface->width * surface->height *
+             CachedSurface::GetFormatBpp(surface->pixel_format) / 8) ==
+                (config.GetEndAddress() - config.GetStartAddress())) {
+            UnshareSurfaceTexture(surface);
+            return surface;
+        }
+    }
+
+    return nullptr;
+}
+
+CachedSurface* RasterizerCacheOpenGL::TryGetTextureCopySurface(PAddr addr, u32 line_size,
+                                                               u32 line_stride, u32 size,
+                                                               const CachedSurface* match,
+                                                               MathUtil::Rectangle<int>& out_rect) {
+    const u32 num_lines = size / line_size;
+    const u32 extent = (num_lines - 1) * line_stride + line_size;
+
+    CachedSurface* best_surface = nullptr;
+
+    lookup_results.clear();
+    GetSurfacesInRegion(addr, extent, lookup_results);
+    for (CachedSurface* surface : lookup_results) {
+        const u32 bytes_per_pixel = CachedSurface::GetFormatBpp(surface->pixel_format) / 8;
+        if (addr < surface->addr || addr + extent > surface->addr + surface->size ||
+            surface->is_compressed || bytes_per_pixel == 0) {
+            continue;
+        }
+        if (match != nullptr &&
+            (surface->pixel_format != match->pixel_format || surface->is_tiled != match->is_tiled ||
+             surface->res_scale_width != match->res_scale_width ||
+             surface->res_scale_height != match->res_scale_height)) {
+            continue;
+        }
+
+        // Tiled surfaces are copied in units of whole tiles, each line covering a row of them
+        const u32 unit_pixels = surface->is_tiled ? 8 : 1;
+        const u32 unit_size = unit_pixels * unit_pixels * bytes_per_pixel;
+        const u32 row_pixels = (!surface->is_tiled && surface->pixel_stride != 0)
+                                   ? surface->pixel_stride
+                                   : surface->width;
+        const u32 row_size = row_pixels / unit_pixels * unit_size;
+
+        const u32 offset = addr - surface->addr;
+        u32 lines = num_lines;
+        u32 copy_line_size = line_size;
+        if (line_stride == line_size && line_size > row_size) {
+            // Contiguous data spanning several rows of the surface
+            if (line_size % row_size != 0) {
+                continue;
             }
+            lines = size / row_size;
+            copy_line_size = row_size;
+        } else if (lines > 1 && line_stride != row_size) {
+            continue;
+        }
+        if (offset % unit_size != 0 || copy_line_size % unit_size != 0) {
+            continue;
+        }
 
-            CachedSurface* surface = it2->get();
+        const u32 x0 = offset % row_size / unit_size * unit_pixels;
+        const u32 y0 = offset / row_size * unit_pixels;
+        const u32 width = copy_line_size / unit_size * unit_pixels;
+        const u32 height = lines * unit_pixels;
+        if (x0 + width > surface->width || y0 + height > surface->height) {
+            continue;
+        }
 
-            if (surface->addr == config.GetStartAddress() &&
-                CachedSurface::GetFormatBpp(surface->pixel_format) == bits_per_value &&
-                (surface->width * surface->height *
-                 CachedSurface::GetFormatBpp(surface->pixel_format) / 8) ==
-                    (config.GetEndAddress() - config.GetStartAddress())) {
-                return surface;
+        // Prefer the surface holding the most recent data
+        if (best_surface == nullptr || surface->dirty) {
+            best_surface = surface;
+            if (surface->is_tiled) {
+                // Tiled surfaces are flipped vertically in the rasterizer vs. 3DS memory.
+                out_rect = MathUtil::Rectangle<int>(x0, surface->height - y0, x0 + width,
+                                                    surface->height - (y0 + height));
+            } else {
+                out_rect = MathUtil::Rectangle<int>(x0, y0, x0 + width, y0 + height);
             }
         }
     }
 
-    return nullptr;
+    if (best_surface != nullptr) {
+        out_rect.left = (int)(out_rect.left * best_surface->res_scale_width);
+        out_rect.right = (int)(out_rect.right * best_surface->res_scale_width);
+        out_rect.top = (int)(out_rect.top * best_surface->res_scale_height);
+        out_rect.bottom = (int)(out_rect.bottom * best_surface->res_scale_height);
+    }
+    return best_surface;
 }
 
-MICROPROFILE_DEFINE(OpenGL_SurfaceDownload, "OpenGL", "Surface Download", MP_RGB(128, 192, 64));
-void RasterizerCacheOpenGL::FlushSurface(CachedSurface* surface) {
+/// Returns the OpenGL texture rows holding rows [rows_begin, rows_end) of a surface in memory
+static std::pair<u32, u32> GetTextureRows(const CachedSurface& surface, u32 rows_begin,
+                                          u32 rows_end) {
+    // Tiled surfaces are flipped vertically in the rasterizer vs. 3DS memory.
+    if (surface.is_tiled) {
+        return {surface.height - rows_end, surface.height - rows_begin};
+    }
+    return {rows_begin, rows_end};
+}
+
+/// Returns the offset of the given row within a surface's emulated memory
+static u32 GetRowOffset(const CachedSurface& surface, u32 row) {
+    u32 bytes_per_pixel = CachedSurface::GetFormatBpp(surface.pixel_format) / 8;
+    u32 stride = (!surface.is_tiled && surface.pixel_stride != 0) ? surface.pixel_stride
+                                                                  : surface.width;
+    return row * stride * bytes_per_pixel;
+}
+
+/**
+ * Copies the pixel data read back from rows [rows_begin, rows_end) of a surface's texture to the
+ * surface's emulated memory
+ */
+static void WriteSurfaceToMemory(const CachedSurface& surface, u32 rows_begin, u32 rows_end,
+                                 u8* gl_data, u8* dst_buffer) {
     using PixelFormat = CachedSurface::PixelFormat;
-    using SurfaceType = CachedSurface::SurfaceType;
 
-    if (!surface->dirty) {
+    u32 bytes_per_pixel = CachedSurface::GetFormatBpp(surface.pixel_format) / 8;
+    u32 gl_bytes_per_pixel;
+    GetReadbackFormat(surface.pixel_format, gl_bytes_per_pixel);
+
+    if (!surface.is_tiled) {
+        // Linear surfaces are read back tightly packed, so honor the destination stride here
+        u32 line_size = surface.width * bytes_per_pixel;
+        u32 dst_stride =
+            (surface.pixel_stride != 0 ? surface.pixel_stride : surface.width) * bytes_per_pixel;
+        for (u32 y = rows_begin; y < rows_end; ++y) {
+            std::memcpy(dst_buffer + y * dst_stride, gl_data + (y - rows_begin) * line_size,
+                        line_size);
+        }
         return;
     }
 
-    MICROPROFILE_SCOPE(OpenGL_SurfaceDownload);
+    // D24 is read back as GL_UNSIGNED_INT, with the meaningful bytes being the upper three
+    u8* gl_data_ptr = (surface.pixel_format == PixelFormat::D24) ? gl_data + 1 : gl_data;
 
-    u8* dst_buffer = Memory::GetPhysicalPointer(surface->addr);
-    if (dst_buffer == nullptr) {
-        return;
-    }
+    // Directly copy pixels. Internal OpenGL color formats are consistent so no conversion is
+    // necessary.
+    MortonCopyPixels(surface.pixel_format, surface.width, rows_begin, rows_end, bytes_per_pixel,
+                     gl_bytes_per_pixel, dst_buffer, gl_data_ptr, false);
+}
+
+void RasterizerCacheOpenGL::ReadTexturePixels(GLuint texture, CachedSurface::SurfaceType type,
+                                              GLint y, GLsizei width, GLsizei height,
+                                              GLenum format, GLenum pixel_type, GLvoid* pixels) {
+    using SurfaceType = CachedSurface::SurfaceType;
+
+    OpenGLState::ResetTexture(texture);
 
     OpenGLState cur_state = OpenGLState::GetCurState();
-    GLuint old_tex = cur_state.texture_units[0].texture_2d;
+    GLuint old_fb = cur_state.draw.read_framebuffer;
+    cur_state.draw.read_framebuffer = transfer_framebuffers[0].handle;
+    cur_state.Apply();
+
+    if (type == SurfaceType::Depth) {
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture,
+                               0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    } else if (type == SurfaceType::DepthStencil) {
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
+                               texture, 0);
+    } else {
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture,
+                               0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0,
+                               0);
+    }
+
+    glReadPixels(0, y, width, height, format, pixel_type, pixels);
+
+    cur_state.draw.read_framebuffer = old_fb;
+    cur_state.Apply();
+}
 
+void RasterizerCacheOpenGL::ReadSurfaceTexture(CachedSurface* surface, u32 rows_begin,
+                                               u32 rows_end, GLvoid* pixels) {
     OGLTexture unscaled_tex;
     GLuint texture_to_flush = surface->texture.handle;
 
     // If not 1x scale, blit scaled texture to a new 1x texture and use that to flush
     if (surface->res_scale_width != 1.f || surface->res_scale_height != 1.f) {
-        unscaled_tex.Create();
-
-        AllocateSurfaceTexture(unscaled_tex.handle, surface->pixel_format, surface->width,
-                               surface->height);
+        unscaled_tex =
+            AcquireSurfaceTexture(surface->pixel_format, surface->width, surface->height);
         BlitTextures(
             surface->texture.handle, unscaled_tex.handle,
             CachedSurface::GetFormatType(surface->pixel_format),
@@ -697,65 +1937,514 @@ void RasterizerCacheOpenGL::FlushSurface(CachedSurface* surface) {
         texture_to_flush = unscaled_tex.handle;
     }
 
-    cur_state.texture_units[0].texture_2d = texture_to_flush;
-    cur_state.Apply();
-    glActiveTexture(GL_TEXTURE0);
+    // Read through a framebuffer, which unlike glGetTexImage allows reading just the needed rows
+    u32 gl_bytes_per_pixel;
+    const FormatTuple tuple = GetReadbackFormat(surface->pixel_format, gl_bytes_per_pixel);
+    const auto texture_rows = GetTextureRows(*surface, rows_begin, rows_end);
+    ReadTexturePixels(texture_to_flush, CachedSurface::GetFormatType(surface->pixel_format),
+                      texture_rows.first, surface->width, texture_rows.second - texture_rows.first,
+                      tuple.format, tuple.type, pixels);
+
+    if (unscaled_tex.handle != 0) {
+        ReleaseSurfaceTexture(surface->pixel_format, surface->width, surface->height,
+                              std::move(unscaled_tex));
+    }
+}
 
-    if (!surface->is_tiled) {
-        // TODO: Ensure this will always be a color format, not a depth or other format
-        ASSERT((size_t)surface->pixel_format < fb_format_tuples.size());
-        const FormatTuple& tuple = fb_format_tuples[(unsigned int)surface->pixel_format];
+static u32 GetReadbackSize(const CachedSurface& surface, u32 rows_begin, u32 rows_end) {
+    u32 gl_bytes_per_pixel;
+    GetReadbackFormat(surface.pixel_format, gl_bytes_per_pixel);
+    return surface.width * (rows_end - rows_begin) * gl_bytes_per_pixel;
+}
+
+void RasterizerCacheOpenGL::MarkSurfaceRowsDirty(CachedSurface* surface, u32 rows_begin,
+                                                 u32 rows_end) {
+    if (surface->is_tiled) {
+        // Tiles are the smallest unit that's contiguous in memory, so expand to whole tile rows
+        rows_begin &= ~7;
+        rows_end = (rows_end + 7) & ~7;
+    }
+    rows_end = std::min(rows_end, surface->height);
+    if (rows_begin >= rows_end) {
+        return;
+    }
 
-        glPixelStorei(GL_PACK_ROW_LENGTH, (GLint)surface->pixel_stride);
-        glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, dst_buffer);
-        glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    if (surface->dirty) {
+        surface->dirty_rows_begin = std::min(surface->dirty_rows_begin, rows_begin);
+        surface->dirty_rows_end = std::max(surface->dirty_rows_end, rows_end);
     } else {
-        SurfaceType type = CachedSurface::GetFormatType(surface->pixel_format);
-        if (type != SurfaceType::Depth && type != SurfaceType::DepthStencil) {
-            ASSERT((size_t)surface->pixel_format < fb_format_tuples.size());
-            const FormatTuple& tuple = fb_format_tuples[(unsigned int)surface->pixel_format];
+        surface->dirty_rows_begin = rows_begin;
+        surface->dirty_rows_end = rows_end;
+    }
 
-            u32 bytes_per_pixel = CachedSurface::GetFormatBpp(surface->pixel_format) / 8;
+    surface->dirty = true;
+    ++surface->modification_count;
+}
 
-            std::vector<u8> temp_gl_buffer(surface->width * surface->height * bytes_per_pixel);
+void RasterizerCacheOpenGL::MarkSurfaceDirty(CachedSurface* surface) {
+    MarkSurfaceRowsDirty(surface, 0, surface->height);
+}
 
-            glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, temp_gl_buffer.data());
+void RasterizerCacheOpenGL::MarkSurfaceDirty(CachedSurface* surface,
+                                             const MathUtil::Rectangle<int>& rect) {
+    // Convert the vertical extent of the rectangle to unscaled texture rows
+    const float scaled_bottom = static_cast<float>(std::min(rect.top, rect.bottom));
+    const float scaled_top = static_cast<float>(std::max(rect.top, rect.bottom));
+    const int bottom = static_cast<int>(std::floor(scaled_bottom / surface->res_scale_height));
+    const int top = static_cast<int>(std::ceil(scaled_top / surface->res_scale_height));
+
+    const int height = static_cast<int>(surface->height);
+    const u32 texture_rows_begin = static_cast<u32>(MathUtil::Clamp(bottom, 0, height));
+    const u32 texture_rows_end = static_cast<u32>(MathUtil::Clamp(top, 0, height));
+
+    // The mapping between texture and memory rows is its own inverse
+    const auto rows = GetTextureRows(*surface, texture_rows_begin, texture_rows_end);
+    MarkSurfaceRowsDirty(surface, rows.first, rows.second);
+}
 
-            // Directly copy pixels. Internal OpenGL color formats are consistent so no conversion
-            // is necessary.
-            MortonCopyPixels(surface->pixel_format, surface->width, surface->height,
-                             bytes_per_pixel, bytes_per_pixel, dst_buffer, temp_gl_buffer.data(),
-                             false);
-        } else {
-            // Depth/Stencil formats need special treatment since they aren't sampleable using
-            // LookupTexture and can't use RGBA format
-            size_t tuple_idx = (size_t)surface->pixel_format - 14;
-            ASSERT(tuple_idx < depth_format_tuples.size());
-            const FormatTuple& tuple = depth_format_tuples[tuple_idx];
+MICROPROFILE_DEFINE(OpenGL_SurfaceDownloadBegin, "OpenGL", "Surface Download Begin",
+                    MP_RGB(160, 192, 64));
+void RasterizerCacheOpenGL::BeginSurfaceDownload(CachedSurface* surface) {
+    if (!surface->dirty) {
+        return;
+    }
+
+    SurfaceDownload* download = FindSurfaceDownload(surface);
+    if (download != nullptr) {
+        if (download->modification_count == surface->modification_count) {
+            // Already reading back the current contents
+            return;
+        }
+        CancelSurfaceDownload(*download);
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_SurfaceDownloadBegin);
+    GLTimerQueries::ScopedTimer gpu_timer(Core::PerfStats::GPUCategory::SurfaceDownload);
+
+    // Recycle slots in a round-robin fashion, dropping the oldest readback if all are in flight
+    download = &downloads[next_download];
+    next_download = (next_download + 1) % downloads.size();
+    if (download->surface != nullptr) {
+        CancelSurfaceDownload(*download);
+    }
+
+    const u32 readback_size =
+        GetReadbackSize(*surface, surface->dirty_rows_begin, surface->dirty_rows_end);
 
-            u32 bytes_per_pixel = CachedSurface::GetFormatBpp(surface->pixel_format) / 8;
+    download->buffer.Create();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, download->buffer.handle);
+    if (download->buffer_size < readback_size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, readback_size, nullptr, GL_STREAM_READ);
+        download->buffer_size = readback_size;
+    }
+
+    // With a pack buffer bound, this only queues a copy to the buffer instead of stalling
+    ReadSurfaceTexture(surface, surface->dirty_rows_begin, surface->dirty_rows_end, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    download->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    download->surface = surface;
+    download->modification_count = surface->modification_count;
+    download->rows_begin = surface->dirty_rows_begin;
+    download->rows_end = surface->dirty_rows_end;
+    surface->download_pending = true;
+}
 
-            // OpenGL needs 4 bpp alignment for D24 since using GL_UNSIGNED_INT as type
-            bool use_4bpp = (surface->pixel_format == PixelFormat::D24);
+RasterizerCacheOpenGL::SurfaceDownload* RasterizerCacheOpenGL::FindSurfaceDownload(
+    const CachedSurface* surface) {
+    if (!surface->download_pending) {
+        return nullptr;
+    }
 
-            u32 gl_bytes_per_pixel = use_4bpp ? 4 : bytes_per_pixel;
+    auto it = std::find_if(downloads.begin(), downloads.end(),
+                           [surface](const SurfaceDownload& download) {
+                               return download.surface == surface;
+                           });
+    return it != downloads.end() ? &*it : nullptr;
+}
 
-            std::vector<u8> temp_gl_buffer(surface->width * surface->height * gl_bytes_per_pixel);
+void RasterizerCacheOpenGL::CancelSurfaceDownload(SurfaceDownload& download) {
+    if (download.fence != nullptr) {
+        glDeleteSync(download.fence);
+        download.fence = nullptr;
+    }
+    if (download.surface != nullptr) {
+        download.surface->download_pending = false;
+        download.surface = nullptr;
+    }
+}
 
-            glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, temp_gl_buffer.data());
+MICROPROFILE_DEFINE(OpenGL_SurfaceDownloadWait, "OpenGL", "Surface Download Wait",
+                    MP_RGB(96, 160, 48));
+bool RasterizerCacheOpenGL::CompleteSurfaceDownload(CachedSurface* surface, u8* dst_buffer) {
+    SurfaceDownload* download = FindSurfaceDownload(surface);
+    if (download == nullptr) {
+        return false;
+    }
 
-            u8* temp_gl_buffer_ptr = use_4bpp ? temp_gl_buffer.data() + 1 : temp_gl_buffer.data();
+    if (download->modification_count != surface->modification_count) {
+        // The surface was rendered to again after the readback started, so it is stale
+        CancelSurfaceDownload(*download);
+        return false;
+    }
 
-            MortonCopyPixels(surface->pixel_format, surface->width, surface->height,
-                             bytes_per_pixel, gl_bytes_per_pixel, dst_buffer, temp_gl_buffer_ptr,
-                             false);
+    {
+        MICROPROFILE_SCOPE(OpenGL_SurfaceDownloadWait);
+        // The first wait flushes the command stream so that the fence is guaranteed to signal
+        GLenum result = glClientWaitSync(download->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(download->fence, 0, 1000000);
         }
     }
 
+    const u32 readback_size = GetReadbackSize(*surface, download->rows_begin, download->rows_end);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, download->buffer.handle);
+    u8* gl_data =
+        static_cast<u8*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback_size, GL_MAP_READ_BIT));
+    if (gl_data != nullptr) {
+        WriteSurfaceToMemory(*surface, download->rows_begin, download->rows_end, gl_data,
+                             dst_buffer);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    CancelSurfaceDownload(*download);
+    return gl_data != nullptr;
+}
+
+MICROPROFILE_DEFINE(OpenGL_SurfaceDownload, "OpenGL", "Surface Download", MP_RGB(128, 192, 64));
+void RasterizerCacheOpenGL::FlushSurface(CachedSurface* surface) {
+    if (!surface->dirty) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_SurfaceDownload);
+    Core::ScopedPerfTimer perf_timer(Core::PerfStats::Category::SurfaceFlush);
+
+    u8* dst_buffer = Memory::GetPhysicalPointer(surface->addr);
+    if (dst_buffer == nullptr) {
+        return;
+    }
+
+    ++surface->flush_count;
+
+    // Use the result of an earlier asynchronous readback if it's still up to date, falling back
+    // to a synchronous readback otherwise
+    if (!CompleteSurfaceDownload(surface, dst_buffer)) {
+        GLTimerQueries::ScopedTimer gpu_timer(Core::PerfStats::GPUCategory::SurfaceDownload);
+        const u32 rows_begin = surface->dirty_rows_begin;
+        const u32 rows_end = surface->dirty_rows_end;
+        std::vector<u8> temp_gl_buffer(GetReadbackSize(*surface, rows_begin, rows_end));
+        ReadSurfaceTexture(surface, rows_begin, rows_end, temp_gl_buffer.data());
+        WriteSurfaceToMemory(*surface, rows_begin, rows_end, temp_gl_buffer.data(), dst_buffer);
+    }
+
     surface->dirty = false;
+}
 
-    cur_state.texture_units[0].texture_2d = old_tex;
-    cur_state.Apply();
+void RasterizerCacheOpenGL::RetainInvalidatedSurface(CachedSurface* surface) {
+    std::shared_ptr<CachedSurface> surface_ref;
+    if (use_page_index) {
+        surface_ref = page_indexed_surfaces.at(surface);
+    } else {
+        auto range = surface_cache.equal_range(boost::icl::interval<PAddr>::right_open(
+            surface->addr, surface->addr + surface->size));
+        for (auto it = range.first; it != range.second && surface_ref == nullptr; ++it) {
+            for (const auto& candidate : it->second) {
+                if (candidate.get() == surface) {
+                    surface_ref = candidate;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (surface_ref == nullptr) {
+        return;
+    }
+
+    invalidated_surfaces.push_front(std::move(surface_ref));
+    invalidated_surface_lookup.emplace(surface->addr, invalidated_surfaces.begin());
+
+    // Drop the least recently invalidated surfaces once over budget
+    while (invalidated_surfaces.size() > MAX_INVALIDATED_SURFACES) {
+        ForgetInvalidatedSurface(std::prev(invalidated_surfaces.end()));
+    }
+}
+
+void RasterizerCacheOpenGL::ForgetInvalidatedSurface(InvalidatedSurfaceList::iterator it) {
+    auto range = invalidated_surface_lookup.equal_range((*it)->addr);
+    for (auto lookup = range.first; lookup != range.second; ++lookup) {
+        if (lookup->second == it) {
+            invalidated_surface_lookup.erase(lookup);
+            break;
+        }
+    }
+    invalidated_surfaces.erase(it);
+}
+
+MICROPROFILE_DEFINE(OpenGL_SurfaceRevalidate, "OpenGL", "Surface Revalidate",
+                    MP_RGB(64, 128, 192));
+CachedSurface* RasterizerCacheOpenGL::TryRevalidateSurface(const CachedSurface& params,
+                                                           const u8* texture_src_data) {
+    auto range = invalidated_surface_lookup.equal_range(params.addr);
+    for (auto lookup = range.first; lookup != range.second; ++lookup) {
+        auto it = lookup->second;
+        CachedSurface* surface = it->get();
+
+        if (surface->width != params.width || surface->height != params.height ||
+            surface->pixel_format != params.pixel_format || surface->is_tiled != params.is_tiled ||
+            surface->pixel_stride != params.pixel_stride ||
+            surface->res_scale_width != params.res_scale_width ||
+            surface->res_scale_height != params.res_scale_height) {
+            continue;
+        }
+
+        MICROPROFILE_SCOPE(OpenGL_SurfaceRevalidate);
+
+        // Bring memory up to date with any overlapping surfaces before looking at it
+        Memory::RasterizerFlushRegion(surface->addr, surface->size);
+
+        std::shared_ptr<CachedSurface> surface_ref = *it;
+        ForgetInvalidatedSurface(it);
+
+        if (Common::ComputeHash64(texture_src_data, surface->size) != surface->source_hash) {
+            // The data did change, so the surface has to be rebuilt from scratch
+            return nullptr;
+        }
+
+        Memory::RasterizerMarkRegionCached(surface->addr, surface->size, 1);
+        RegisterSurface(std::move(surface_ref));
+        return surface;
+    }
+
+    return nullptr;
+}
+
+MICROPROFILE_DEFINE(OpenGL_SurfaceShare, "OpenGL", "Surface Share", MP_RGB(96, 192, 160));
+bool RasterizerCacheOpenGL::AdoptSharedTexture(CachedSurface& surface,
+                                               const u8* texture_src_data) {
+    if (!share_identical_textures || !IsContiguous(surface)) {
+        return false;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_SurfaceShare);
+
+    // Bring memory up to date with any overlapping surfaces before looking at it. The hash is kept
+    // as the source hash, so that a surface loaded below after all can be shared too.
+    Memory::RasterizerFlushRegion(surface.addr, surface.size);
+    surface.source_hash = Common::ComputeHash64(texture_src_data, surface.size);
+    surface.has_source_hash = true;
+
+    auto range = shared_textures.equal_range(surface.source_hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        std::shared_ptr<SharedSurfaceTexture> shared = it->second.lock();
+        if (shared == nullptr || shared->pixel_format != surface.pixel_format ||
+            shared->width != surface.width || shared->height != surface.height ||
+            shared->is_tiled != surface.is_tiled ||
+            shared->res_scale_width != surface.res_scale_width ||
+            shared->res_scale_height != surface.res_scale_height) {
+            continue;
+        }
+
+        surface.texture.handle = shared->texture.handle;
+        surface.shared_texture = std::move(shared);
+        return true;
+    }
+    return false;
+}
+
+void RasterizerCacheOpenGL::ShareSurfaceTexture(CachedSurface& surface) {
+    // The texture goes back to the pool once the last surface sharing it lets go of it
+    std::shared_ptr<SharedSurfaceTexture> shared(
+        new SharedSurfaceTexture, [this](SharedSurfaceTexture* texture) {
+            auto range = shared_textures.equal_range(texture->data_hash);
+            for (auto it = range.first; it != range.second;) {
+                it = it->second.expired() ? shared_textures.erase(it) : std::next(it);
+            }
+            ReleaseSurfaceTexture(texture->pixel_format,
+                                  static_cast<u32>(texture->width * texture->res_scale_width),
+                                  static_cast<u32>(texture->height * texture->res_scale_height),
+                                  std::move(texture->texture));
+            delete texture;
+        });
+
+    shared->data_hash = surface.source_hash;
+    shared->pixel_format = surface.pixel_format;
+    shared->width = surface.width;
+    shared->height = surface.height;
+    shared->is_tiled = surface.is_tiled;
+    shared->res_scale_width = surface.res_scale_width;
+    shared->res_scale_height = surface.res_scale_height;
+    shared->texture = std::move(surface.texture);
+
+    surface.texture.handle = shared->texture.handle;
+    surface.shared_texture = shared;
+    shared_textures.emplace(surface.source_hash, std::move(shared));
+}
+
+void RasterizerCacheOpenGL::UnshareSurfaceTexture(CachedSurface* surface) {
+    if (surface->shared_texture == nullptr) {
+        return;
+    }
+
+    std::shared_ptr<SharedSurfaceTexture> shared = std::move(surface->shared_texture);
+    surface->texture.handle = 0;
+
+    if (shared.use_count() == 1) {
+        // Nothing else uses the texture anymore, so the surface can simply take it over
+        surface->texture = std::move(shared->texture);
+        return;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_SurfaceShare);
+
+    // Copy on write: the other surfaces keep the shared texture as it is
+    const MathUtil::Rectangle<int> rect(0, 0, surface->GetScaledWidth(),
+                                        surface->GetScaledHeight());
+    surface->texture = AcquireSurfaceTexture(surface->pixel_format, surface->GetScaledWidth(),
+                                             surface->GetScaledHeight());
+    BlitTextures(shared->texture.handle, surface->texture.handle,
+                 CachedSurface::GetFormatType(surface->pixel_format), rect, rect);
+}
+
+void RasterizerCacheOpenGL::CollectPreloadedSurfaces() {
+    for (SurfacePreloader::Result& result : surface_preloader->Collect()) {
+        auto it = std::find_if(preloaded_surfaces.begin(), preloaded_surfaces.end(),
+                               [&](const PreloadedSurface& preloaded) {
+                                   return preloaded.id == result.id;
+                               });
+        // Results of dropped preloads are simply deleted
+        if (it != preloaded_surfaces.end()) {
+            it->texture = std::move(result.texture);
+        }
+    }
+}
+
+MICROPROFILE_DEFINE(OpenGL_SurfacePreloadAdopt, "OpenGL", "Surface Preload Adopt",
+                    MP_RGB(64, 160, 192));
+bool RasterizerCacheOpenGL::AdoptPreloadedSurface(CachedSurface& surface,
+                                                  const u8* texture_src_data) {
+    if (surface_preloader == nullptr || preloaded_surfaces.empty()) {
+        return false;
+    }
+    if (!surface.is_tiled || surface.res_scale_width != 1.f || surface.res_scale_height != 1.f) {
+        return false;
+    }
+
+    CollectPreloadedSurfaces();
+
+    auto it = std::find_if(preloaded_surfaces.begin(), preloaded_surfaces.end(),
+                           [&](const PreloadedSurface& preloaded) {
+                               return preloaded.texture.handle != 0 &&
+                                      preloaded.addr == surface.addr &&
+                                      preloaded.width == surface.width &&
+                                      preloaded.height == surface.height &&
+                                      preloaded.pixel_format == surface.pixel_format;
+                           });
+    if (it == preloaded_surfaces.end()) {
+        return false;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_SurfacePreloadAdopt);
+
+    // Bring memory up to date with any overlapping surfaces before looking at it
+    Memory::RasterizerFlushRegion(surface.addr, surface.size);
+
+    // Memory may have changed again since the snapshot the texture was loaded from
+    const bool data_matches =
+        Common::ComputeHash64(texture_src_data, surface.size) == it->data_hash;
+    if (data_matches) {
+        surface.texture = std::move(it->texture);
+    } else {
+        ReleaseSurfaceTexture(it->pixel_format, it->width, it->height, std::move(it->texture));
+    }
+    preloaded_surfaces.erase(it);
+    return data_matches;
+}
+
+MICROPROFILE_DEFINE(OpenGL_SurfacePreload, "OpenGL", "Surface Preload", MP_RGB(64, 192, 192));
+void RasterizerCacheOpenGL::PreloadRegion(PAddr addr, u32 size) {
+    using SurfaceType = CachedSurface::SurfaceType;
+    using PixelFormat = CachedSurface::PixelFormat;
+
+    if (surface_preloader == nullptr || size == 0) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_SurfacePreload);
+
+    CollectPreloadedSurfaces();
+
+    const PAddr end = addr + size;
+    for (const auto& surface : invalidated_surfaces) {
+        if (surface->addr < addr || surface->addr + surface->size > end) {
+            continue;
+        }
+
+        // Only surfaces loaded the plain way are preloaded: tiled, at 1x, and decoded on the CPU
+        const SurfaceType type = CachedSurface::GetFormatType(surface->pixel_format);
+        if (!surface->has_source_hash || !surface->is_tiled || surface->res_scale_width != 1.f ||
+            surface->res_scale_height != 1.f ||
+            (type != SurfaceType::Color && type != SurfaceType::Texture) ||
+            surface->pixel_format == PixelFormat::ETC1 ||
+            surface->pixel_format == PixelFormat::ETC1A4) {
+            continue;
+        }
+
+        const u8* data = Memory::GetPhysicalPointer(surface->addr);
+        if (data == nullptr) {
+            continue;
+        }
+
+        // Unchanged surfaces are re-validated on lookup without needing a new texture
+        const u64 data_hash = Common::ComputeHash64(data, surface->size);
+        if (data_hash == surface->source_hash) {
+            continue;
+        }
+
+        // A previous preload of the same surface was loaded from older data
+        preloaded_surfaces.remove_if([&](const PreloadedSurface& preloaded) {
+            return preloaded.addr == surface->addr && preloaded.width == surface->width &&
+                   preloaded.height == surface->height &&
+                   preloaded.pixel_format == surface->pixel_format;
+        });
+
+        // Make room by dropping the oldest loaded texture, or stop queueing if all are in flight
+        if (preloaded_surfaces.size() >= MAX_PRELOADED_SURFACES) {
+            auto oldest = std::find_if(
+                preloaded_surfaces.begin(), preloaded_surfaces.end(),
+                [](const PreloadedSurface& preloaded) { return preloaded.texture.handle != 0; });
+            if (oldest == preloaded_surfaces.end()) {
+                break;
+            }
+            ReleaseSurfaceTexture(oldest->pixel_format, oldest->width, oldest->height,
+                                  std::move(oldest->texture));
+            preloaded_surfaces.erase(oldest);
+        }
+
+        const u64 id = next_preload_id++;
+        preloaded_surfaces.push_back(
+            {id, surface->addr, surface->width, surface->height, surface->pixel_format, data_hash,
+             OGLTexture()});
+
+        const PAddr surface_addr = surface->addr;
+        const u32 width = surface->width;
+        const u32 height = surface->height;
+        const PixelFormat pixel_format = surface->pixel_format;
+        surface_preloader->Queue(
+            id, std::vector<u8>(data, data + surface->size),
+            [surface_addr, width, height, pixel_format](GLuint texture, u8* snapshot) {
+                CachedSurface params;
+                params.addr = surface_addr;
+                params.width = width;
+                params.height = height;
+                params.pixel_format = pixel_format;
+                params.is_tiled = true;
+                PreloadSurfaceTexture(params, texture, snapshot);
+            });
+    }
 }
 
 void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, const CachedSurface* skip_surface,
@@ -764,33 +2453,68 @@ void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, const CachedSurfac
         return;
     }
 
-    // Gather up unique surfaces that touch the region
-    std::unordered_set<std::shared_ptr<CachedSurface>> touching_surfaces;
-
-    auto surface_interval = boost::icl::interval<PAddr>::right_open(addr, addr + size);
-    auto cache_upper_bound = surface_cache.upper_bound(surface_interval);
-    for (auto it = surface_cache.lower_bound(surface_interval); it != cache_upper_bound; ++it) {
-        std::copy_if(it->second.begin(), it->second.end(),
-                     std::inserter(touching_surfaces, touching_surfaces.end()),
-                     [skip_surface](std::shared_ptr<CachedSurface> surface) {
-                         return (surface.get() != skip_surface);
-                     });
-    }
+    // Gather up unique surfaces that touch the region. This uses its own scratch list since
+    // flushing may be triggered while the results of another lookup are still in use.
+    flush_results.clear();
+    GetSurfacesInRegion(addr, size, flush_results);
 
     // Flush and invalidate surfaces
-    for (auto surface : touching_surfaces) {
-        FlushSurface(surface.get());
+    for (CachedSurface* surface : flush_results) {
+        if (surface == skip_surface) {
+            continue;
+        }
+
+        // Surfaces that stay cached only need to be written back if the region overlaps the
+        // part of them that was actually modified
+        if (!invalidate && surface->dirty) {
+            const PAddr dirty_begin =
+                surface->addr + GetRowOffset(*surface, surface->dirty_rows_begin);
+            const PAddr dirty_end =
+                surface->addr + GetRowOffset(*surface, surface->dirty_rows_end);
+            if (dirty_end <= addr || addr + size <= dirty_begin) {
+                continue;
+            }
+        }
+
+        FlushSurface(surface);
         if (invalidate) {
             Memory::RasterizerMarkRegionCached(surface->addr, surface->size, -1);
-            surface_cache.subtract(
-                std::make_pair(boost::icl::interval<PAddr>::right_open(
-                                   surface->addr, surface->addr + surface->size),
-                               std::set<std::shared_ptr<CachedSurface>>({surface})));
+            if (surface->has_source_hash && surface->modification_count == 0) {
+                RetainInvalidatedSurface(surface);
+            }
+            UnregisterSurface(surface);
         }
     }
 }
 
+void RasterizerCacheOpenGL::RecordReadBack(PAddr addr, u32 size) {
+    if (size == 0) {
+        return;
+    }
+
+    flush_results.clear();
+    GetSurfacesInRegion(addr, size, flush_results);
+    for (const CachedSurface* surface : flush_results) {
+        if (surface->dirty) {
+            read_back_regions += boost::icl::interval<PAddr>::right_open(
+                surface->addr, surface->addr + surface->size);
+        }
+    }
+}
+
+bool RasterizerCacheOpenGL::IsRegionReadBack(PAddr addr, u32 size) const {
+    return boost::icl::intersects(read_back_regions,
+                                  boost::icl::interval<PAddr>::right_open(addr, addr + size));
+}
+
 void RasterizerCacheOpenGL::FlushAll() {
+    if (use_page_index) {
+        for (auto& surface : page_indexed_surfaces) {
+            FlushSurface(surface.first);
+        }
+        return;
+    }
+
     for (auto& surfaces : surface_cache) {
         for (auto& surface : surfaces.second) {
             FlushSurface(surface.get());
@@ -5,14 +5,19 @@
 #pragma once
 
 #include <array>
+#include <deque>
+#include <list>
 #include <memory>
 #include <set>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-local-typedef"
 #endif
 #include <boost/icl/interval_map.hpp>
+#include <boost/icl/interval_set.hpp>
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
@@ -24,6 +29,8 @@
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
+#include "video_core/renderer_opengl/gl_surface_index.h"
 
 namespace MathUtil {
 template <class T>
@@ -31,6 +38,8 @@ struct Rectangle;
 }
 
 struct CachedSurface;
+struct SharedSurfaceTexture;
+class SurfacePreloader;
 
 using SurfaceCache = boost::icl::interval_map<PAddr, std::set<std::shared_ptr<CachedSurface>>>;
 
@@ -187,6 +196,57 @@ struct CachedSurface {
     bool is_tiled;
     PixelFormat pixel_format;
     bool dirty;
+    /// Rows modified since the surface was last written back, counted top-down as in emulated
+    /// memory. For tiled surfaces these are always aligned to whole rows of 8x8 tiles.
+    u32 dirty_rows_begin = 0;
+    u32 dirty_rows_end = 0;
+
+    /// Last surface lookup that visited this surface, used to deduplicate lookup results
+    u64 index_generation = 0;
+
+    /// Whether the texture holds compressed data, which can't be attached to a framebuffer. Such
+    /// textures don't come from the texture pool.
+    bool is_compressed = false;
+
+    /// Incremented every time the GPU modifies the surface, used to detect stale readbacks
+    u32 modification_count = 0;
+    /// Number of times the surface had to be written back to emulated memory
+    u32 flush_count = 0;
+    /// Whether an asynchronous readback of this surface is in flight
+    bool download_pending = false;
+
+    /// Hash of the emulated memory the surface was loaded from, used for re-validation
+    u64 source_hash = 0;
+    bool has_source_hash = false;
+
+    /// Unique among all surfaces ever created, unlike their addresses
+    u64 id = 0;
+
+    /// Surface a mipmap level was copied from, and its modification count at the time
+    struct MipLevelSource {
+        u64 surface_id = 0;
+        u32 modification_count = 0;
+    };
+    /// Sources of the mipmap levels above the base one the texture has storage for. Each level is
+    /// a surface of its own in the cache, copied into this texture on the GPU.
+    std::vector<MipLevelSource> mip_levels;
+
+    /// Texture shared with other surfaces loaded from the same data, or nullptr if the surface owns
+    /// its texture. `texture` then only borrows the handle, and has to be unshared before the GPU
+    /// writes to it.
+    std::shared_ptr<SharedSurfaceTexture> shared_texture;
+};
+
+/// Texture of surfaces loaded from the same data, in the same format, dimensions and tiling
+struct SharedSurfaceTexture : NonCopyable {
+    u64 data_hash;
+    CachedSurface::PixelFormat pixel_format;
+    u32 width;
+    u32 height;
+    bool is_tiled;
+    float res_scale_width;
+    float res_scale_height;
+    OGLTexture texture;
 };
 
 class RasterizerCacheOpenGL : NonCopyable {
@@ -194,10 +254,10 @@ public:
     RasterizerCacheOpenGL();
     ~RasterizerCacheOpenGL();
 
-    /// Blits one texture to another
+    /// Blits one texture to another, into the given mipmap level of the destination
     void BlitTextures(GLuint src_tex, GLuint dst_tex, CachedSurface::SurfaceType type,
                       const MathUtil::Rectangle<int>& src_rect,
-                      const MathUtil::Rectangle<int>& dst_rect);
+                      const MathUtil::Rectangle<int>& dst_rect, GLint dst_level = 0);
 
     /// Attempt to blit one surface's texture to another
     bool TryBlitSurfaces(CachedSurface* src_surface, const MathUtil::Rectangle<int>& src_rect,
@@ -223,6 +283,33 @@ public:
     /// Attempt to get a surface that exactly matches the fill region and format
     CachedSurface* TryGetFillSurface(const GPU::Regs::MemoryFillConfig& config);
 
+    /**
+     * Looks for a surface holding the data one side of a TextureCopy reads or writes: `size` bytes
+     * starting at `addr`, in lines of `line_size` bytes placed `line_stride` bytes apart. The data
+     * has to form a rectangle of whole tiles (or pixels, for linear surfaces) within the surface.
+     * @param match Surface whose format, tiling and resolution scale the result needs to have, or
+     *              nullptr to accept any
+     * @param out_rect Resolution scaled rectangle of the surface holding the data
+     */
+    CachedSurface* TryGetTextureCopySurface(PAddr addr, u32 line_size, u32 line_stride, u32 size,
+                                            const CachedSurface* match,
+                                            MathUtil::Rectangle<int>& out_rect);
+
+    /// Marks a surface as modified by the GPU, so that it gets written back to memory on flush
+    void MarkSurfaceDirty(CachedSurface* surface);
+
+    /**
+     * Marks part of a surface as modified by the GPU. Only the rows touched by the rectangle are
+     * written back to memory on flush.
+     * @param rect Modified area in (resolution scaled) texture coordinates, as given by
+     *             GetSurfaceRect
+     */
+    void MarkSurfaceDirty(CachedSurface* surface, const MathUtil::Rectangle<int>& rect);
+
+    /// Starts reading a dirty surface back into a pixel buffer object without waiting for the
+    /// result, so that a later FlushSurface can complete without stalling the GPU
+    void BeginSurfaceDownload(CachedSurface* surface);
+
     /// Write the surface back to memory
     void FlushSurface(CachedSurface* surface);
 
@@ -233,7 +320,278 @@ public:
     /// Flush all cached resources tracked by this cache manager
     void FlushAll();
 
+    /**
+     * Remembers the memory of the dirty surfaces overlapping a region that is about to be read
+     * back from emulated memory. Call before flushing the region.
+     */
+    void RecordReadBack(PAddr addr, u32 size);
+
+    /// Whether memory of the region has been read back while a surface there was dirty
+    bool IsRegionReadBack(PAddr addr, u32 size) const;
+
+    /**
+     * Queues background loads of the invalidated surfaces lying in a region the CPU finished
+     * writing, so that a texture is ready if they are looked up again with the new data.
+     */
+    void PreloadRegion(PAddr addr, u32 size);
+
 private:
+    /// In-flight readback of a surface's texture into a pixel buffer object
+    struct SurfaceDownload {
+        OGLBuffer buffer;
+        u32 buffer_size = 0;
+        GLsync fence = nullptr;
+        CachedSurface* surface = nullptr;
+        /// Surface modification count at the time the readback was started
+        u32 modification_count = 0;
+        /// Rows of the surface covered by the readback
+        u32 rows_begin = 0;
+        u32 rows_end = 0;
+    };
+
+    /// Extends the dirty rows of a surface by [rows_begin, rows_end)
+    void MarkSurfaceRowsDirty(CachedSurface* surface, u32 rows_begin, u32 rows_end);
+
+    /// Reads pixels of a texture through a framebuffer, into `pixels` or the bound pack buffer
+    void ReadTexturePixels(GLuint texture, CachedSurface::SurfaceType type, GLint y,
+                           GLsizei width, GLsizei height, GLenum format, GLenum pixel_type,
+                           GLvoid* pixels);
+
+    /**
+     * Reads rows [rows_begin, rows_end) of a surface's texture back at 1x resolution, into
+     * `pixels` or the bound pack buffer
+     */
+    void ReadSurfaceTexture(CachedSurface* surface, u32 rows_begin, u32 rows_end,
+                            GLvoid* pixels);
+
+    /// Returns the in-flight download of a surface, or nullptr if there is none
+    SurfaceDownload* FindSurfaceDownload(const CachedSurface* surface);
+
+    /// Releases a download slot, discarding any readback still in flight
+    void CancelSurfaceDownload(SurfaceDownload& download);
+
+    /**
+     * Writes the result of a surface's pending download back to memory, waiting for it if needed.
+     * @returns false if there was no up to date download for the surface
+     */
+    bool CompleteSurfaceDownload(CachedSurface* surface, u8* dst_buffer);
+
+    /// Released surface texture kept around for reuse
+    struct PooledTexture {
+        CachedSurface::PixelFormat pixel_format;
+        u32 width;
+        u32 height;
+        OGLTexture texture;
+    };
+
+    /// Takes a texture with the given storage from the pool, allocating a new one if there is none
+    OGLTexture AcquireSurfaceTexture(CachedSurface::PixelFormat pixel_format, u32 width,
+                                     u32 height);
+
+    /// Returns a texture to the pool, deleting the oldest pooled texture when over capacity
+    void ReleaseSurfaceTexture(CachedSurface::PixelFormat pixel_format, u32 width, u32 height,
+                               OGLTexture&& texture);
+
+    using InvalidatedSurfaceList = std::list<std::shared_ptr<CachedSurface>>;
+
+    /// Keeps an unmodified surface that is being invalidated around for later re-validation
+    void RetainInvalidatedSurface(CachedSurface* surface);
+
+    /// Stops keeping an invalidated surface around, destroying it if no longer referenced
+    void ForgetInvalidatedSurface(InvalidatedSurfaceList::iterator it);
+
+    /**
+     * Looks for an invalidated surface matching the parameters whose memory contents hash to the
+     * same value as when it was loaded, and makes it active in the cache again if found.
+     * @returns The re-validated surface, or nullptr if there was none
+     */
+    CachedSurface* TryRevalidateSurface(const CachedSurface& params, const u8* texture_src_data);
+
+    /**
+     * Looks for the texture of a surface loaded from the same data memory holds now for a new
+     * surface, and lets the new surface share it if found. Records the hash of the data as the
+     * surface's source hash either way.
+     * @returns false if there was none, in which case the caller has to load the surface
+     */
+    bool AdoptSharedTexture(CachedSurface& surface, const u8* texture_src_data);
+
+    /// Makes the texture a surface was just loaded into available to later identical surfaces
+    void ShareSurfaceTexture(CachedSurface& surface);
+
+    /// Gives a surface sharing its texture one of its own, before the GPU writes to it
+    void UnshareSurfaceTexture(CachedSurface* surface);
+
+    /// Texture of an invalidated surface being loaded by the preloader, or loaded by it
+    struct PreloadedSurface {
+        u64 id;
+        PAddr addr;
+        u32 width;
+        u32 height;
+        CachedSurface::PixelFormat pixel_format;
+        /// Hash of the memory the texture is loaded from
+        u64 data_hash;
+        /// Loaded texture, 0 while the preloader is still working on it
+        OGLTexture texture;
+    };
+
+    /// Takes the textures the preloader finished since the last call
+    void CollectPreloadedSurfaces();
+
+    /**
+     * Looks for a preloaded texture matching a new surface, loaded from the same data memory
+     * holds now, and gives it to the surface if found.
+     * @returns false if there was none, in which case the caller has to load the surface
+     */
+    bool AdoptPreloadedSurface(CachedSurface& surface, const u8* texture_src_data);
+
+    /**
+     * Decodes a tiled color surface into its 1x texture by streaming the raw tiled data to the GPU
+     * and untiling it with a fragment shader reading from a texel buffer.
+     * @returns false if the GPU path isn't available for the surface, in which case the caller
+     *          has to decode it on the CPU
+     */
+    bool UntileSurfaceOnGPU(const CachedSurface& params, const u8* texture_src_data,
+                            GLuint texture);
+
+    /**
+     * Loads an ETC1 surface from memory into a new compressed texture, leaving the decoding to the
+     * GPU. Only 1x surfaces are loaded this way, as scaling needs an attachable texture.
+     * @returns false if the compressed path isn't available for the surface, in which case the
+     *          caller has to load it as usual
+     */
+    bool LoadCompressedSurface(CachedSurface& surface, const u8* texture_src_data);
+
+    /**
+     * Looks for a cached surface covering exactly the same memory as the parameters, but in a
+     * different format whose contents can be reinterpreted as the requested one on the GPU.
+     * @returns The surface to reinterpret, or nullptr if there is none
+     */
+    CachedSurface* FindReinterpretSource(const CachedSurface& params, bool match_res_scale);
+
+    /**
+     * Looks for a cached surface covering exactly the same memory as the parameters in the same
+     * format, but at a different resolution scale, which can be scaled on the GPU instead of
+     * going through memory at 1x.
+     * @returns The surface to scale, or nullptr if there is none
+     */
+    CachedSurface* FindRescaleSource(const CachedSurface& params);
+
+    /**
+     * Looks for a cached render target at the same address as the parameters, with the same row
+     * layout and format but fewer rows, whose contents can be copied into the new surface on the
+     * GPU instead of going through memory.
+     * @returns The surface to copy the first rows from, or nullptr if there is none
+     */
+    CachedSurface* FindGrowSource(const CachedSurface& params, bool match_res_scale);
+
+    /**
+     * Fills the texture of `dst` with the contents of `src` reinterpreted as the format of `dst`,
+     * as if `src` had been written back to memory and `dst` loaded from it. Both surfaces need to
+     * have the same dimensions and resolution scale.
+     */
+    void ReinterpretSurface(CachedSurface* src, CachedSurface* dst);
+
+    /**
+     * Copies the mipmap levels of a texture into the levels of its base level's surface, where
+     * they changed since the last copy. Each level is looked up as a surface of its own, which
+     * keeps them in sync with memory the same way as any other surface.
+     * @param params Parameters the base level's surface was looked up with
+     */
+    void SyncMipLevels(CachedSurface* surface, const CachedSurface& params, u32 max_level);
+
+    /// Appends every unique cached surface overlapping [addr, addr + size) to `out`
+    void GetSurfacesInRegion(PAddr addr, u32 size, std::vector<CachedSurface*>& out);
+
+    /// Adds a newly created surface to the active surface index
+    void RegisterSurface(std::shared_ptr<CachedSurface> surface);
+
+    /// Removes a surface from the active surface index, destroying it if no longer referenced
+    void UnregisterSurface(CachedSurface* surface);
+
+    /// Whether surfaces are tracked by the page-bucketed index rather than the interval map
+    bool use_page_index;
+
+    u64 next_surface_id = 1;
+
     SurfaceCache surface_cache;
+
+    SurfacePageIndex page_index;
+    /// Owning references to the surfaces tracked by page_index
+    std::unordered_map<CachedSurface*, std::shared_ptr<CachedSurface>> page_indexed_surfaces;
+
+    /// Scratch lists reused between lookups to avoid reallocating on every call
+    std::vector<CachedSurface*> lookup_results;
+    std::vector<CachedSurface*> flush_results;
+
+    /// Memory of dirty surfaces that was read back, see RecordReadBack. Pruned when surfaces are
+    /// unregistered.
+    boost::icl::interval_set<PAddr> read_back_regions;
+
+    /// Released textures, least recently released first
+    std::deque<PooledTexture> texture_pool;
+    size_t texture_pool_size;
+
+    /// Maximum number of invalidated surfaces kept around for re-validation
+    static constexpr size_t MAX_INVALIDATED_SURFACES = 256;
+    /// Invalidated surfaces, most recently invalidated first
+    InvalidatedSurfaceList invalidated_surfaces;
+    std::unordered_multimap<PAddr, InvalidatedSurfaceList::iterator> invalidated_surface_lookup;
+
+    /// Whether surfaces loaded from identical data share their texture
+    bool share_identical_textures;
+    /// Textures shared between surfaces, by the hash of the data they were loaded from
+    std::unordered_multimap<u64, std::weak_ptr<SharedSurfaceTexture>> shared_textures;
+
+    /// Loads textures on a shared context, or nullptr if Settings disable it
+    std::unique_ptr<SurfacePreloader> surface_preloader;
+    /// Maximum number of textures being preloaded or waiting to be adopted
+    static constexpr size_t MAX_PRELOADED_SURFACES = 64;
+    /// Preloaded textures, in the order they were queued
+    std::list<PreloadedSurface> preloaded_surfaces;
+    u64 next_preload_id = 1;
+
+    /// Size of the ring buffer that surface data is streamed through on upload
+    static constexpr GLsizeiptr UPLOAD_BUFFER_SIZE = 16 * 1024 * 1024;
+    OGLStreamBuffer upload_buffer;
+
+    /// Largest texel buffer the driver supports, in texels
+    GLint max_texture_buffer_size = 0;
+
+    /// Whether the driver supports GL_COMPRESSED_RGB8_ETC2 textures, used to upload ETC1 surfaces
+    bool etc2_supported = false;
+
+    /// Empty vertex array used for drawing fullscreen triangles generated in the vertex shader
+    OGLVertexArray fullscreen_vertex_array;
+
+    /// Program untiling surfaces from the upload buffer, or 0 if the GPU path is disabled
+    OGLShader untile_program;
+    /// Texel buffer view of upload_buffer that untile_program reads the tiled data from
+    OGLTexture untile_buffer_texture;
+    GLint uniform_untile_word_offset;
+    GLint uniform_untile_width;
+    GLint uniform_untile_height;
+    GLint uniform_untile_pixel_format;
+
+    /// Programs converting between the OpenGL D24S8 layout and the RGBA8 layout of the same data
+    OGLShader d24s8_to_rgba8_program;
+    OGLShader rgba8_to_d24s8_program;
+    GLint uniform_d24s8_to_rgba8_width;
+    GLint uniform_rgba8_to_d24s8_width;
+    /// Staging buffers for reinterpretation, the first also being the source of either program
+    OGLBuffer reinterpret_buffers[2];
+    GLsizeiptr reinterpret_buffer_sizes[2] = {0, 0};
+    OGLTexture reinterpret_buffer_texture;
+    /// Intermediate R32UI target of RGBA8 to D24S8 reinterpretation
+    OGLTexture reinterpret_uint_texture;
+    u32 reinterpret_uint_width = 0;
+    u32 reinterpret_uint_height = 0;
+
+    std::array<SurfaceDownload, 8> downloads;
+    size_t next_download = 0;
+
+    /// Framebuffer surfaces of the previous draw, used to detect when rendering to them finished
+    CachedSurface* last_color_surface = nullptr;
+    CachedSurface* last_depth_surface = nullptr;
+
     OGLFramebuffer transfer_framebuffers[2];
 };
@@ -97,6 +97,13 @@ public:
         handle = GLShader::LoadProgram(vert_shader, frag_shader);
     }
 
+    /// Creates a new internal OpenGL resource with a geometry stage and stores the handle
+    void Create(const char* vert_shader, const char* geo_shader, const char* frag_shader) {
+        if (handle != 0)
+            return;
+        handle = GLShader::LoadProgram(vert_shader, geo_shader, frag_shader);
+    }
+
     /// Deletes the internal OpenGL resource
     void Release() {
         if (handle == 0)
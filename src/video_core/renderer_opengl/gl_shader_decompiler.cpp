@@ -0,0 +1,723 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+#include <nihstro/shader_bytecode.h>
+#include "common/logging/log.h"
+#include "video_core/renderer_opengl/gl_shader_decompiler.h"
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::RegisterType;
+using nihstro::SourceRegister;
+using nihstro::SwizzlePattern;
+
+namespace GLShader {
+
+namespace {
+
+/// Common helpers of the generated code. `uniform_f` and `uniform_b` are declared by the caller.
+constexpr char program_prologue[] = R"(
+vec4 sanitize_mul(vec4 lhs, vec4 rhs) {
+    // The PICA returns 0 for 0 * inf, where IEEE floats give NaN
+    vec4 product = lhs * rhs;
+    return mix(product, mix(mix(vec4(0.0), product, isnan(rhs)), product, isnan(lhs)),
+               isnan(product));
+}
+
+vec4 get_uniform_f(int index) {
+    return (index >= 0 && index < 96) ? uniform_f[index] : vec4(0.0);
+}
+
+bool uniform_bool(uint index) {
+    return (uniform_b & (1u << index)) != 0u;
+}
+
+vec4 reg_tmp[16];
+vec4 reg_out[16];
+bvec2 conditional_code;
+ivec3 address_registers;
+)";
+
+/// Value of the dispatch variable once a block with jumps has run to its end
+constexpr char jump_exit[] = "0xFFFFFFFFu";
+
+/// Accumulates lines of GLSL code, indented by the current scope depth
+class ShaderWriter {
+public:
+    void AddLine(const std::string& text) {
+        if (!text.empty()) {
+            code.append(scope * 4, ' ');
+            code += text;
+        }
+        code += '\n';
+    }
+
+    std::string code;
+    int scope = 0;
+};
+
+class ProgramDecompiler {
+public:
+    ProgramDecompiler(const ProgramCode& program_code, const SwizzleData& swizzle_data,
+                      u32 main_offset, u32 program_length)
+        : program_code(program_code), swizzle_data(swizzle_data), main_offset(main_offset),
+          program_length(program_length) {}
+
+    boost::optional<std::string> Decompile() {
+        const u32 main_end = FindMainEnd();
+        if (main_end == 0) {
+            LOG_DEBUG(Render_OpenGL, "Shader program at 0x%03x has no end", main_offset);
+            return boost::none;
+        }
+
+        const Subroutine main_routine{main_offset, main_end};
+        current_routine = main_routine;
+
+        ShaderWriter main_writer;
+        writer = &main_writer;
+        writer->AddLine("bool exec_shader() {");
+        ++writer->scope;
+        writer->AddLine("for (int i = 0; i < 16; ++i) {");
+        writer->AddLine("    reg_tmp[i] = vec4(0.0);");
+        writer->AddLine("    reg_out[i] = vec4(0.0);");
+        writer->AddLine("}");
+        writer->AddLine("conditional_code = bvec2(false);");
+        writer->AddLine("address_registers = ivec3(0);");
+        writer->AddLine("");
+        if (!EmitBlock(main_offset, main_end, false)) {
+            return boost::none;
+        }
+        writer->AddLine("return true;");
+        --writer->scope;
+        writer->AddLine("}");
+
+        // Subroutines can call further subroutines, so keep going until no new ones show up
+        ShaderWriter subroutine_writer;
+        writer = &subroutine_writer;
+        while (!pending_routines.empty()) {
+            current_routine = pending_routines.back();
+            pending_routines.pop_back();
+
+            writer->AddLine("");
+            writer->AddLine("bool " + GetRoutineName(current_routine) + "() {");
+            ++writer->scope;
+            if (!EmitBlock(current_routine.first, current_routine.second, false)) {
+                return boost::none;
+            }
+            writer->AddLine("return false;");
+            --writer->scope;
+            writer->AddLine("}");
+        }
+
+        // GLSL doesn't allow recursion, which a program could do but hardly ever would
+        std::set<Subroutine> visiting;
+        if (HasRecursion(main_routine, visiting)) {
+            LOG_DEBUG(Render_OpenGL, "Shader program at 0x%03x is recursive", main_offset);
+            return boost::none;
+        }
+
+        std::string out = program_prologue;
+        out += '\n';
+        for (const Subroutine& routine : declared_routines) {
+            out += "bool " + GetRoutineName(routine) + "();\n";
+        }
+        out += '\n';
+        out += main_writer.code;
+        out += subroutine_writer.code;
+        return out;
+    }
+
+private:
+    /// Instruction range [first, second) of a subroutine
+    using Subroutine = std::pair<u32, u32>;
+
+    /// Instructions of a block outside of any of its conditional blocks or loops
+    struct BlockInfo {
+        std::vector<u32> instructions;
+        std::set<u32> jump_targets;
+    };
+
+    Instruction GetInstruction(u32 offset) const {
+        return {program_code[offset]};
+    }
+
+    static std::string GetRoutineName(const Subroutine& routine) {
+        return "sub_" + std::to_string(routine.first) + "_" + std::to_string(routine.second);
+    }
+
+    /// Returns the offset after the END instruction terminating the main program, or 0
+    u32 FindMainEnd() const {
+        u32 furthest_target = main_offset;
+        u32 offset = main_offset;
+        while (offset < program_length) {
+            const Instruction instr = GetInstruction(offset);
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::END:
+                if (offset >= furthest_target) {
+                    return offset + 1;
+                }
+                ++offset;
+                break;
+
+            case OpCode::Id::JMPC:
+            case OpCode::Id::JMPU:
+                furthest_target = std::max<u32>(furthest_target, instr.flow_control.dest_offset);
+                ++offset;
+                break;
+
+            case OpCode::Id::IFU:
+            case OpCode::Id::IFC:
+                offset = std::max<u32>(offset + 1, instr.flow_control.dest_offset +
+                                                       instr.flow_control.num_instructions);
+                break;
+
+            case OpCode::Id::LOOP:
+                offset = std::max<u32>(offset + 1, instr.flow_control.dest_offset + 1);
+                break;
+
+            default:
+                ++offset;
+                break;
+            }
+        }
+        return 0;
+    }
+
+    /// Collects the top level instructions of [begin, end), checking that control flow nests
+    bool AnalyzeBlock(u32 begin, u32 end, BlockInfo& info) const {
+        u32 offset = begin;
+        while (offset < end) {
+            info.instructions.push_back(offset);
+
+            const Instruction instr = GetInstruction(offset);
+            const u32 dest = instr.flow_control.dest_offset;
+            const u32 num = instr.flow_control.num_instructions;
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::IFU:
+            case OpCode::Id::IFC:
+                if (dest <= offset || dest + num > end) {
+                    return false;
+                }
+                offset = dest + num;
+                break;
+
+            case OpCode::Id::LOOP:
+                if (dest < offset || dest + 1 > end) {
+                    return false;
+                }
+                offset = dest + 1;
+                break;
+
+            case OpCode::Id::JMPC:
+            case OpCode::Id::JMPU:
+                if (dest < begin || dest > end) {
+                    return false;
+                }
+                info.jump_targets.insert(dest);
+                ++offset;
+                break;
+
+            case OpCode::Id::CALL:
+            case OpCode::Id::CALLC:
+            case OpCode::Id::CALLU:
+                if (dest + num > program_length) {
+                    return false;
+                }
+                ++offset;
+                break;
+
+            default:
+                ++offset;
+                break;
+            }
+        }
+
+        // Jumping to the end of a block leaves it, anything else has to land on a top level
+        // instruction so that it can be expressed as a case label
+        for (u32 target : info.jump_targets) {
+            if (target != end && !std::binary_search(info.instructions.begin(),
+                                                     info.instructions.end(), target)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool HasRecursion(const Subroutine& routine, std::set<Subroutine>& visiting) const {
+        if (!visiting.insert(routine).second) {
+            return true;
+        }
+        auto callees = calls.find(routine);
+        if (callees != calls.end()) {
+            for (const Subroutine& callee : callees->second) {
+                if (HasRecursion(callee, visiting)) {
+                    return true;
+                }
+            }
+        }
+        visiting.erase(routine);
+        return false;
+    }
+
+    /**
+     * Emits the instructions of [begin, end). Blocks containing jumps are wrapped in a loop
+     * around a switch statement with one case label per jump target.
+     * @param breakable Whether a `break` emitted in this block would leave the innermost loop
+     */
+    bool EmitBlock(u32 begin, u32 end, bool breakable) {
+        BlockInfo info;
+        if (!AnalyzeBlock(begin, end, info)) {
+            LOG_DEBUG(Render_OpenGL, "Unstructured control flow in shader block 0x%03x-0x%03x",
+                      begin, end);
+            return false;
+        }
+
+        const bool dispatch = !info.jump_targets.empty();
+        if (dispatch) {
+            writer->AddLine("{");
+            ++writer->scope;
+            writer->AddLine("uint jmp_to = " + std::to_string(begin) + "u;");
+            writer->AddLine("while (true) {");
+            ++writer->scope;
+            writer->AddLine("switch (jmp_to) {");
+            writer->AddLine("case " + std::to_string(begin) + "u:");
+        }
+
+        for (u32 offset : info.instructions) {
+            if (dispatch && offset != begin && info.jump_targets.count(offset) != 0) {
+                writer->AddLine("case " + std::to_string(offset) + "u:");
+            }
+            if (!EmitInstruction(offset, end, breakable && !dispatch)) {
+                return false;
+            }
+        }
+
+        if (dispatch) {
+            writer->AddLine(std::string("jmp_to = ") + jump_exit + ";");
+            writer->AddLine("}");
+            writer->AddLine(std::string("if (jmp_to == ") + jump_exit + ") {");
+            writer->AddLine("    break;");
+            writer->AddLine("}");
+            --writer->scope;
+            writer->AddLine("}");
+            --writer->scope;
+            writer->AddLine("}");
+        }
+        return true;
+    }
+
+    std::string GetSourceRegister(const SourceRegister& source_reg, u32 address_register_index) {
+        const std::string index = std::to_string(source_reg.GetIndex());
+        switch (source_reg.GetRegisterType()) {
+        case RegisterType::Input:
+        case RegisterType::Temporary:
+            if (address_register_index != 0) {
+                // Only ever seen with uniforms, so don't bother with the flat register file
+                LOG_DEBUG(Render_OpenGL, "Relative addressing of non-uniform register");
+                failed = true;
+            }
+            return (source_reg.GetRegisterType() == RegisterType::Input ? "vs_in_reg" + index
+                                                                        : "reg_tmp[" + index + "]");
+
+        case RegisterType::FloatUniform: {
+            static const char* const address_registers[] = {
+                "address_registers.x", "address_registers.y", "address_registers.z"};
+            if (address_register_index == 0) {
+                return "uniform_f[" + index + "]";
+            }
+            return "get_uniform_f(" + index + " + " +
+                   address_registers[address_register_index - 1] + ")";
+        }
+
+        default:
+            return "vec4(0.0)";
+        }
+    }
+
+    /// Returns the swizzled, possibly negated value of source operand `src_num` (1 to 3)
+    std::string GetSource(const SwizzlePattern& swizzle, int src_num, const SourceRegister& reg,
+                          u32 address_register_index) {
+        using Selector = SwizzlePattern::Selector;
+        const Selector selectors[3][4] = {
+            {swizzle.src1_selector_0, swizzle.src1_selector_1, swizzle.src1_selector_2,
+             swizzle.src1_selector_3},
+            {swizzle.src2_selector_0, swizzle.src2_selector_1, swizzle.src2_selector_2,
+             swizzle.src2_selector_3},
+            {swizzle.src3_selector_0, swizzle.src3_selector_1, swizzle.src3_selector_2,
+             swizzle.src3_selector_3},
+        };
+        const bool negate[3] = {swizzle.negate_src1 != 0, swizzle.negate_src2 != 0,
+                                swizzle.negate_src3 != 0};
+
+        std::string components;
+        for (Selector selector : selectors[src_num - 1]) {
+            components += "xyzw"[static_cast<int>(selector)];
+        }
+
+        std::string value = GetSourceRegister(reg, address_register_index);
+        if (components != "xyzw") {
+            value += "." + components;
+        }
+        return negate[src_num - 1] ? "(-" + value + ")" : value;
+    }
+
+    static std::string GetDestRegister(const DestRegister& dest) {
+        const std::string index = std::to_string(dest.GetIndex());
+        switch (dest.GetRegisterType()) {
+        case RegisterType::Output:
+            return "reg_out[" + index + "]";
+        case RegisterType::Temporary:
+            return "reg_tmp[" + index + "]";
+        default:
+            return "";
+        }
+    }
+
+    /// Writes the vec4 expression `value` to the components of `dest` enabled in the swizzle
+    void SetDest(const SwizzlePattern& swizzle, const std::string& dest, const std::string& value) {
+        std::string mask;
+        for (int i = 0; i < 4; ++i) {
+            if (swizzle.DestComponentEnabled(i)) {
+                mask += "xyzw"[i];
+            }
+        }
+        if (dest.empty() || mask.empty()) {
+            return;
+        }
+
+        if (mask == "xyzw") {
+            writer->AddLine(dest + " = " + value + ";");
+        } else {
+            writer->AddLine(dest + "." + mask + " = (" + value + ")." + mask + ";");
+        }
+    }
+
+    static std::string EvaluateCondition(Instruction::FlowControlType flow_control) {
+        using Op = Instruction::FlowControlType::Op;
+
+        const std::string result_x =
+            flow_control.refx.Value() ? "conditional_code.x" : "!conditional_code.x";
+        const std::string result_y =
+            flow_control.refy.Value() ? "conditional_code.y" : "!conditional_code.y";
+
+        switch (flow_control.op) {
+        case Op::Or:
+            return "(" + result_x + " || " + result_y + ")";
+        case Op::And:
+            return "(" + result_x + " && " + result_y + ")";
+        case Op::JustX:
+            return result_x;
+        case Op::JustY:
+        default:
+            return result_y;
+        }
+    }
+
+    void EmitCall(const Subroutine& routine) {
+        if (routine.first == routine.second) {
+            return;
+        }
+        if (calls[current_routine].insert(routine).second &&
+            declared_routines.insert(routine).second) {
+            pending_routines.push_back(routine);
+        }
+        writer->AddLine("if (" + GetRoutineName(routine) + "()) {");
+        writer->AddLine("    return true;");
+        writer->AddLine("}");
+    }
+
+    bool EmitArithmetic(const Instruction& instr) {
+        const bool is_inverted =
+            (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+        const u32 address_register_index = instr.common.address_register_index;
+        const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+
+        const std::string src1 = GetSource(swizzle, 1, instr.common.GetSrc1(is_inverted),
+                                           is_inverted ? 0 : address_register_index);
+        const std::string src2 = GetSource(swizzle, 2, instr.common.GetSrc2(is_inverted),
+                                           is_inverted ? address_register_index : 0);
+        const std::string dest = GetDestRegister(instr.common.dest.Value());
+
+        switch (instr.opcode.Value().EffectiveOpCode()) {
+        case OpCode::Id::ADD:
+            SetDest(swizzle, dest, src1 + " + " + src2);
+            break;
+
+        case OpCode::Id::MUL:
+            SetDest(swizzle, dest, "sanitize_mul(" + src1 + ", " + src2 + ")");
+            break;
+
+        case OpCode::Id::FLR:
+            SetDest(swizzle, dest, "floor(" + src1 + ")");
+            break;
+
+        // These match the NaN semantics of the hardware, see the interpreter
+        case OpCode::Id::MAX:
+            SetDest(swizzle, dest,
+                    "mix(" + src2 + ", " + src1 + ", greaterThan(" + src1 + ", " + src2 + "))");
+            break;
+
+        case OpCode::Id::MIN:
+            SetDest(swizzle, dest,
+                    "mix(" + src2 + ", " + src1 + ", lessThan(" + src1 + ", " + src2 + "))");
+            break;
+
+        case OpCode::Id::DP3:
+            SetDest(swizzle, dest,
+                    "vec4(dot(vec3(1.0), sanitize_mul(" + src1 + ", " + src2 + ").xyz))");
+            break;
+
+        case OpCode::Id::DP4:
+            SetDest(swizzle, dest,
+                    "vec4(dot(vec4(1.0), sanitize_mul(" + src1 + ", " + src2 + ")))");
+            break;
+
+        case OpCode::Id::DPH:
+        case OpCode::Id::DPHI:
+            SetDest(swizzle, dest, "vec4(dot(vec4(1.0), sanitize_mul(vec4(" + src1 +
+                                       ".xyz, 1.0), " + src2 + ")))");
+            break;
+
+        case OpCode::Id::RCP:
+            SetDest(swizzle, dest, "vec4(1.0 / " + src1 + ".x)");
+            break;
+
+        case OpCode::Id::RSQ:
+            SetDest(swizzle, dest, "vec4(inversesqrt(" + src1 + ".x))");
+            break;
+
+        case OpCode::Id::MOVA:
+            if (swizzle.DestComponentEnabled(0)) {
+                writer->AddLine("address_registers.x = int(" + src1 + ".x);");
+            }
+            if (swizzle.DestComponentEnabled(1)) {
+                writer->AddLine("address_registers.y = int(" + src1 + ".y);");
+            }
+            break;
+
+        case OpCode::Id::MOV:
+            SetDest(swizzle, dest, src1);
+            break;
+
+        case OpCode::Id::SGE:
+        case OpCode::Id::SGEI:
+            SetDest(swizzle, dest, "vec4(greaterThanEqual(" + src1 + ", " + src2 + "))");
+            break;
+
+        case OpCode::Id::SLT:
+        case OpCode::Id::SLTI:
+            SetDest(swizzle, dest, "vec4(lessThan(" + src1 + ", " + src2 + "))");
+            break;
+
+        case OpCode::Id::CMP: {
+            using CompareOp = Instruction::Common::CompareOpType;
+            const CompareOp::Op ops[2] = {instr.common.compare_op.x.Value(),
+                                          instr.common.compare_op.y.Value()};
+            for (int i = 0; i < 2; ++i) {
+                static const char* const operators[] = {"==", "!=", "<", "<=", ">", ">="};
+                if (ops[i] > CompareOp::GreaterEqual) {
+                    LOG_ERROR(HW_GPU, "Unknown compare mode %x", static_cast<int>(ops[i]));
+                    continue;
+                }
+                const std::string component = i == 0 ? "x" : "y";
+                writer->AddLine("conditional_code." + component + " = " + src1 + "." + component +
+                                " " + operators[ops[i]] + " " + src2 + "." + component + ";");
+            }
+            break;
+        }
+
+        case OpCode::Id::EX2:
+            SetDest(swizzle, dest, "vec4(exp2(" + src1 + ".x))");
+            break;
+
+        case OpCode::Id::LG2:
+            SetDest(swizzle, dest, "vec4(log2(" + src1 + ".x))");
+            break;
+
+        default:
+            LOG_DEBUG(Render_OpenGL, "Unhandled arithmetic instruction 0x%02x (%s)",
+                      static_cast<int>(instr.opcode.Value().EffectiveOpCode()),
+                      instr.opcode.Value().GetInfo().name);
+            return false;
+        }
+        return true;
+    }
+
+    bool EmitMultiplyAdd(const Instruction& instr) {
+        const OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+        if (opcode != OpCode::Id::MAD && opcode != OpCode::Id::MADI) {
+            LOG_DEBUG(Render_OpenGL, "Unhandled multiply-add instruction 0x%02x",
+                      static_cast<int>(opcode));
+            return false;
+        }
+
+        const bool is_inverted = (opcode == OpCode::Id::MADI);
+        const u32 address_register_index = instr.mad.address_register_index;
+        const SwizzlePattern swizzle = {swizzle_data[instr.mad.operand_desc_id]};
+
+        const std::string src1 = GetSource(swizzle, 1, instr.mad.GetSrc1(is_inverted), 0);
+        const std::string src2 = GetSource(swizzle, 2, instr.mad.GetSrc2(is_inverted),
+                                           is_inverted ? 0 : address_register_index);
+        const std::string src3 = GetSource(swizzle, 3, instr.mad.GetSrc3(is_inverted),
+                                           is_inverted ? address_register_index : 0);
+
+        SetDest(swizzle, GetDestRegister(instr.mad.dest.Value()),
+                "sanitize_mul(" + src1 + ", " + src2 + ") + " + src3);
+        return true;
+    }
+
+    bool EmitFlowControl(u32 offset, u32 block_end, const Instruction& instr, bool breakable) {
+        const u32 dest = instr.flow_control.dest_offset;
+        const u32 num = instr.flow_control.num_instructions;
+        const std::string bool_uniform =
+            "uniform_bool(" + std::to_string(instr.flow_control.bool_uniform_id) + "u)";
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::NOP:
+            break;
+
+        case OpCode::Id::END:
+            writer->AddLine("return true;");
+            break;
+
+        case OpCode::Id::BREAKC:
+            if (!breakable) {
+                LOG_DEBUG(Render_OpenGL, "BREAKC outside of a loop body");
+                return false;
+            }
+            writer->AddLine("if (" + EvaluateCondition(instr.flow_control) + ") {");
+            writer->AddLine("    break;");
+            writer->AddLine("}");
+            break;
+
+        case OpCode::Id::JMPC:
+        case OpCode::Id::JMPU: {
+            const std::string condition =
+                instr.opcode.Value() == OpCode::Id::JMPC
+                    ? EvaluateCondition(instr.flow_control)
+                    : ((num & 1) ? "!" + bool_uniform : bool_uniform);
+            const std::string target =
+                dest == block_end ? std::string(jump_exit) : std::to_string(dest) + "u";
+            writer->AddLine("if (" + condition + ") {");
+            writer->AddLine("    jmp_to = " + target + ";");
+            writer->AddLine("    break;");
+            writer->AddLine("}");
+            break;
+        }
+
+        case OpCode::Id::CALL:
+            EmitCall({dest, dest + num});
+            break;
+
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU:
+            writer->AddLine("if (" +
+                            (instr.opcode.Value() == OpCode::Id::CALLC
+                                 ? EvaluateCondition(instr.flow_control)
+                                 : bool_uniform) +
+                            ") {");
+            ++writer->scope;
+            EmitCall({dest, dest + num});
+            --writer->scope;
+            writer->AddLine("}");
+            break;
+
+        case OpCode::Id::IFU:
+        case OpCode::Id::IFC:
+            writer->AddLine("if (" +
+                            (instr.opcode.Value() == OpCode::Id::IFC
+                                 ? EvaluateCondition(instr.flow_control)
+                                 : bool_uniform) +
+                            ") {");
+            ++writer->scope;
+            if (!EmitBlock(offset + 1, dest, breakable)) {
+                return false;
+            }
+            --writer->scope;
+            if (num != 0) {
+                writer->AddLine("} else {");
+                ++writer->scope;
+                if (!EmitBlock(dest, dest + num, breakable)) {
+                    return false;
+                }
+                --writer->scope;
+            }
+            writer->AddLine("}");
+            break;
+
+        case OpCode::Id::LOOP: {
+            const std::string int_uniform =
+                "uniform_i[" + std::to_string(instr.flow_control.int_uniform_id) + "]";
+            const std::string counter = "loop" + std::to_string(offset);
+            writer->AddLine("address_registers.z = int(" + int_uniform + ".y);");
+            writer->AddLine("for (uint " + counter + " = 0u; " + counter + " <= " + int_uniform +
+                            ".x; ++" + counter + ") {");
+            ++writer->scope;
+            if (!EmitBlock(offset + 1, dest + 1, true)) {
+                return false;
+            }
+            writer->AddLine("address_registers.z += int(" + int_uniform + ".z);");
+            --writer->scope;
+            writer->AddLine("}");
+            break;
+        }
+
+        default:
+            LOG_DEBUG(Render_OpenGL, "Unhandled instruction 0x%02x (%s)",
+                      static_cast<int>(instr.opcode.Value().EffectiveOpCode()),
+                      instr.opcode.Value().GetInfo().name);
+            return false;
+        }
+        return true;
+    }
+
+    bool EmitInstruction(u32 offset, u32 block_end, bool breakable) {
+        const Instruction instr = GetInstruction(offset);
+
+        bool success;
+        switch (instr.opcode.Value().GetInfo().type) {
+        case OpCode::Type::Arithmetic:
+            success = EmitArithmetic(instr);
+            break;
+        case OpCode::Type::MultiplyAdd:
+            success = EmitMultiplyAdd(instr);
+            break;
+        default:
+            success = EmitFlowControl(offset, block_end, instr, breakable);
+            break;
+        }
+        return success && !failed;
+    }
+
+    const ProgramCode& program_code;
+    const SwizzleData& swizzle_data;
+    const u32 main_offset;
+    const u32 program_length;
+
+    ShaderWriter* writer = nullptr;
+    bool failed = false;
+
+    Subroutine current_routine;
+    std::vector<Subroutine> pending_routines;
+    std::set<Subroutine> declared_routines;
+    std::map<Subroutine, std::set<Subroutine>> calls;
+};
+
+} // Anonymous namespace
+
+boost::optional<std::string> DecompileProgram(const ProgramCode& program_code,
+                                              const SwizzleData& swizzle_data, u32 main_offset,
+                                              u32 program_length) {
+    if (main_offset >= program_length) {
+        return boost::none;
+    }
+    return ProgramDecompiler(program_code, swizzle_data, main_offset, program_length).Decompile();
+}
+
+} // namespace GLShader
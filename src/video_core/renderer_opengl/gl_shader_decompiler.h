@@ -0,0 +1,36 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <boost/optional.hpp>
+#include "common/common_types.h"
+#include "video_core/shader/shader.h"
+
+namespace GLShader {
+
+using ProgramCode = std::array<u32, Pica::Shader::MAX_PROGRAM_CODE_LENGTH>;
+using SwizzleData = std::array<u32, Pica::Shader::MAX_SWIZZLE_DATA_LENGTH>;
+
+/**
+ * Translates a PICA shader program into GLSL. The generated code defines the shader unit's
+ * registers as globals (`reg_tmp`, `reg_out`, `conditional_code`, `address_registers`), reads the
+ * input registers from `vs_in_reg0` to `vs_in_reg15`, the float, integer and boolean uniforms from
+ * `uniform_f`, `uniform_i` and `uniform_b`, and runs the program through `bool exec_shader()`.
+ *
+ * Only structured control flow is translated: conditional blocks, loops and subroutines must not
+ * overlap each other, and jumps may only land on instructions of the block they are issued from.
+ * @param program_code Program code of the shader unit
+ * @param swizzle_data Operand descriptors of the shader unit
+ * @param main_offset Entry point of the program
+ * @param program_length Number of program words that can be part of the program
+ * @returns The GLSL code, or boost::none if the program can't be translated
+ */
+boost::optional<std::string> DecompileProgram(const ProgramCode& program_code,
+                                              const SwizzleData& swizzle_data, u32 main_offset,
+                                              u32 program_length);
+
+} // namespace GLShader
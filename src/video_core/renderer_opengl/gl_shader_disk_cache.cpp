@@ -0,0 +1,123 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
+
+namespace GLShader {
+
+namespace {
+
+/// Collects the entries of a cache file as it is being read
+class BinaryCollector : public LinearDiskCacheReader<PicaShaderConfig::State, u8> {
+public:
+    void Read(const PicaShaderConfig::State& key, const u8* value, u32 value_size) override {
+        // Every value starts with the binary format of the program
+        if (value_size <= sizeof(GLenum)) {
+            return;
+        }
+
+        PicaShaderConfig config;
+        std::memcpy(&config.state, &key, sizeof(PicaShaderConfig::State));
+
+        ProgramBinary binary;
+        std::memcpy(&binary.format, value, sizeof(GLenum));
+        binary.data.assign(value + sizeof(GLenum), value + value_size);
+
+        entries.emplace_back(config, std::move(binary));
+    }
+
+    std::vector<std::pair<PicaShaderConfig, ProgramBinary>> entries;
+};
+
+/// Identifies the driver, as the binaries of one driver can't be loaded by another
+u64 GetDriverHash() {
+    std::string driver;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const GLubyte* value = glGetString(name);
+        if (value != nullptr) {
+            driver += reinterpret_cast<const char*>(value);
+        }
+        driver += '\n';
+    }
+    return Common::ComputeHash64(driver.data(), driver.size());
+}
+
+} // Anonymous namespace
+
+bool ShaderDiskCache::IsSupported() {
+    if (!GLAD_GL_ARB_get_program_binary) {
+        return false;
+    }
+
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    return num_formats > 0;
+}
+
+std::vector<std::pair<PicaShaderConfig, ProgramBinary>> ShaderDiskCache::Open(u64 program_id) {
+    const std::string dir = FileUtil::GetUserPath(D_CACHE_IDX) + "shaders" DIR_SEP;
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(Render_OpenGL, "Failed to create shader cache directory %s", dir.c_str());
+        return {};
+    }
+
+    const std::string filename = dir + Common::StringFromFormat("%016" PRIX64 "_%016" PRIX64 ".bin",
+                                                                program_id, GetDriverHash());
+
+    BinaryCollector collector;
+    file.OpenAndRead(filename.c_str(), collector);
+    is_open = true;
+
+    LOG_INFO(Render_OpenGL, "Loaded %zu programs from shader cache %s", collector.entries.size(),
+             filename.c_str());
+    return std::move(collector.entries);
+}
+
+void ShaderDiskCache::Save(const PicaShaderConfig& config, GLuint program) {
+    if (!is_open) {
+        return;
+    }
+
+    GLint binary_length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    if (binary_length <= 0) {
+        return;
+    }
+
+    std::vector<u8> value(sizeof(GLenum) + binary_length);
+    GLenum format;
+    GLsizei length = 0;
+    glGetProgramBinary(program, binary_length, &length, &format, value.data() + sizeof(GLenum));
+    if (length <= 0) {
+        return;
+    }
+    std::memcpy(value.data(), &format, sizeof(GLenum));
+
+    file.Append(config.state, value.data(), static_cast<u32>(sizeof(GLenum) + length));
+    file.Sync();
+}
+
+GLuint ShaderDiskCache::LoadProgram(const ProgramBinary& binary) {
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, binary.format, binary.data.data(),
+                    static_cast<GLsizei>(binary.data.size()));
+
+    GLint result = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    if (result != GL_TRUE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+} // namespace GLShader
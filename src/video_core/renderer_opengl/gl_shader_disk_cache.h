@@ -0,0 +1,52 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "common/linear_disk_cache.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+
+namespace GLShader {
+
+/// Linked shader program as retrieved from the driver
+struct ProgramBinary {
+    GLenum format;
+    std::vector<u8> data;
+};
+
+/**
+ * Persistent cache of the linked programs of the fragment shader generator, keyed by their
+ * PicaShaderConfig. Program binaries are only valid for the driver that produced them, so there is
+ * one cache file per title and driver. Rebuilding the emulator invalidates the files as well,
+ * since the generated shaders may have changed.
+ */
+class ShaderDiskCache : NonCopyable {
+public:
+    /// Returns whether the driver can save and restore program binaries
+    static bool IsSupported();
+
+    /**
+     * Opens the cache file of the given title for the current driver, creating it if needed
+     * @param program_id Program ID of the running title
+     * @returns The programs stored in the file
+     */
+    std::vector<std::pair<PicaShaderConfig, ProgramBinary>> Open(u64 program_id);
+
+    /// Stores the binary of a program linked for the given configuration
+    void Save(const PicaShaderConfig& config, GLuint program);
+
+    /// Creates a program from a binary read from the cache, returns 0 if the driver rejects it
+    static GLuint LoadProgram(const ProgramBinary& binary);
+
+private:
+    LinearDiskCache<PicaShaderConfig::State, u8> file;
+    bool is_open = false;
+};
+
+} // namespace GLShader
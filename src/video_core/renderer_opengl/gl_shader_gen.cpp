@@ -2,17 +2,23 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
+#include <initializer_list>
 #include "common/assert.h"
 #include "common/bit_field.h"
+#include "common/bit_set.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_lighting.h"
 #include "video_core/regs_rasterizer.h"
 #include "video_core/regs_texturing.h"
+#include "video_core/shader/shader.h"
 #include "video_core/renderer_opengl/gl_rasterizer.h"
+#include "video_core/renderer_opengl/gl_shader_decompiler.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
 #include "video_core/renderer_opengl/gl_shader_util.h"
 
@@ -143,6 +149,55 @@ PicaShaderConfig PicaShaderConfig::BuildFromRegs(const Pica::Regs& regs) {
     return res;
 }
 
+/// Number of program words covered by the hardware vertex shader path (the vertex shader unit's
+/// code memory size)
+constexpr u32 VS_PROGRAM_CODE_LENGTH = 512;
+/// Number of operand descriptors vertex shader instructions can refer to
+constexpr u32 VS_SWIZZLE_DATA_LENGTH = 128;
+
+PicaVSConfig PicaVSConfig::BuildFromRegs(const Pica::Regs& regs,
+                                         const Pica::Shader::ShaderSetup& setup) {
+    PicaVSConfig res;
+
+    auto& state = res.state;
+    std::memset(&state, 0, sizeof(PicaVSConfig::State));
+
+    state.program_hash = Common::ComputeHash64(setup.program_code.data(),
+                                               VS_PROGRAM_CODE_LENGTH * sizeof(u32));
+    state.swizzle_hash = Common::ComputeHash64(setup.swizzle_data.data(),
+                                               VS_SWIZZLE_DATA_LENGTH * sizeof(u32));
+    state.main_offset = regs.vs.main_offset;
+
+    for (u8& source : state.semantic_sources) {
+        source = NO_SEMANTIC_SOURCE;
+    }
+
+    // The shader unit compacts the enabled output registers into consecutive output attributes,
+    // which the rasterizer then maps component-wise to vertex semantics
+    std::array<u32, 16> attribute_registers;
+    u32 num_output_registers = 0;
+    for (unsigned int reg : Common::BitSet<u32>(regs.vs.output_mask)) {
+        attribute_registers[num_output_registers++] = reg;
+    }
+
+    const u32 num_attributes = std::min<u32>(regs.rasterizer.vs_output_total, 7);
+    for (u32 attrib = 0; attrib < num_attributes && attrib < num_output_registers; ++attrib) {
+        const auto& output_register_map = regs.rasterizer.vs_output_attributes[attrib];
+        const RasterizerRegs::VSOutputAttributes::Semantic semantics[4] = {
+            output_register_map.map_x, output_register_map.map_y, output_register_map.map_z,
+            output_register_map.map_w};
+
+        for (u32 comp = 0; comp < 4; ++comp) {
+            if (semantics[comp] < state.semantic_sources.size()) {
+                state.semantic_sources[semantics[comp]] =
+                    static_cast<u8>(attribute_registers[attrib] * 4 + comp);
+            }
+        }
+    }
+
+    return res;
+}
+
 /// Detects if a TEV stage is configured to be skipped (to avoid generating unnecessary code)
 static bool IsPassThroughTevStage(const TevStageConfig& stage) {
     return (stage.color_op == TevStageConfig::Operation::Replace &&
@@ -877,29 +932,27 @@ void AppendProcTexCombineAndMap(std::string& out, ProcTexCombiner combiner,
         combined = "0.0";
         break;
     }
-    out += "ProcTexLookupLUT(" + map_lut + ", " + combined + ")";
+    out += "ProcTexLookupLUT(" + map_lut + ", " + map_lut + "_offset, " + combined + ")";
 }
 
-void AppendProcTexSampler(std::string& out, const PicaShaderConfig& config) {
-    // LUT sampling uitlity
-    // For NoiseLUT/ColorMap/AlphaMap, coord=0.0 is lut[0], coord=127.0/128.0 is lut[127] and
-    // coord=1.0 is lut[127]+lut_diff[127]. For other indices, the result is interpolated using
-    // value entries and difference entries.
-    out += R"(
-float ProcTexLookupLUT(samplerBuffer lut, float coord) {
+/// LUT sampling utility
+/// For NoiseLUT/ColorMap/AlphaMap, coord=0.0 is lut[0], coord=127.0/128.0 is lut[127] and
+/// coord=1.0 is lut[127]+lut_diff[127]. For other indices, the result is interpolated using
+/// value entries and difference entries.
+static const char* PROCTEX_LUT_LOOKUP = R"(
+float ProcTexLookupLUT(samplerBuffer lut, int offset, float coord) {
     coord *= 128;
     float index_i = clamp(floor(coord), 0.0, 127.0);
     float index_f = coord - index_i; // fract() cannot be used here because 128.0 needs to be
                                      // extracted as index_i = 127.0 and index_f = 1.0
-    vec2 entry = texelFetch(lut, int(index_i)).rg;
+    vec2 entry = texelFetch(lut, offset + int(index_i)).rg;
     return clamp(entry.r + entry.g * index_f, 0.0, 1.0);
 }
-    )";
+)";
 
-    // Noise utility
-    if (config.state.proctex.noise_enable) {
-        // See swrasterizer/proctex.cpp for more information about these functions
-        out += R"(
+/// Procedural texture noise functions, see swrasterizer/proctex.cpp for more information about
+/// these functions
+static const char* PROCTEX_NOISE = R"(
 int ProcTexNoiseRand1D(int v) {
     const int table[] = int[](0,4,10,8,4,9,7,12,5,15,13,14,11,15,2,11);
     return ((v % 9 + 2) * 3 & 0xF) ^ table[(v / 9) & 0xF];
@@ -927,13 +980,20 @@ float ProcTexNoiseCoef(vec2 x) {
     float g2 = ProcTexNoiseRand2D(point + vec2(0.0, 1.0)) * (frac.x + frac.y - 1.0);
     float g3 = ProcTexNoiseRand2D(point + vec2(1.0, 1.0)) * (frac.x + frac.y - 2.0);
 
-    float x_noise = ProcTexLookupLUT(proctex_noise_lut, frac.x);
-    float y_noise = ProcTexLookupLUT(proctex_noise_lut, frac.y);
+    float x_noise = ProcTexLookupLUT(proctex_noise_lut, proctex_noise_lut_offset, frac.x);
+    float y_noise = ProcTexLookupLUT(proctex_noise_lut, proctex_noise_lut_offset, frac.y);
     float x0 = mix(g0, g1, x_noise);
     float x1 = mix(g2, g3, x_noise);
     return mix(x0, x1, y_noise);
 }
-        )";
+)";
+
+void AppendProcTexSampler(std::string& out, const PicaShaderConfig& config) {
+    out += PROCTEX_LUT_LOOKUP;
+
+    // Noise utility
+    if (config.state.proctex.noise_enable) {
+        out += PROCTEX_NOISE;
     }
 
     out += "vec4 ProcTex() {\n";
@@ -979,14 +1039,16 @@ float ProcTexNoiseCoef(vec2 x) {
         out += "int lut_index_i = int(lut_coord) + " +
                std::to_string(config.state.proctex.lut_offset) + ";\n";
         out += "float lut_index_f = fract(lut_coord);\n";
-        out += "vec4 final_color = texelFetch(proctex_lut, lut_index_i) + lut_index_f * "
-               "texelFetch(proctex_diff_lut, lut_index_i);\n";
+        out += "vec4 final_color = texelFetch(proctex_lut, proctex_lut_offset + lut_index_i) + "
+               "lut_index_f * texelFetch(proctex_diff_lut, proctex_diff_lut_offset + "
+               "lut_index_i);\n";
         break;
     case ProcTexFilter::Nearest:
     case ProcTexFilter::NearestMipmapLinear:
     case ProcTexFilter::NearestMipmapNearest:
         out += "lut_coord += " + std::to_string(config.state.proctex.lut_offset) + ";\n";
-        out += "vec4 final_color = texelFetch(proctex_lut, int(round(lut_coord)));\n";
+        out += "vec4 final_color = texelFetch(proctex_lut, proctex_lut_offset + "
+               "int(round(lut_coord)));\n";
         break;
     }
 
@@ -1002,13 +1064,12 @@ float ProcTexNoiseCoef(vec2 x) {
     }
 }
 
-std::string GenerateFragmentShader(const PicaShaderConfig& config) {
-    const auto& state = config.state;
-
-    std::string out = R"(
+/// Inputs, uniforms and helper functions shared by all fragment shaders
+static const char* FRAGMENT_SHADER_HEADER = R"(
 #version 330 core
 #define NUM_TEV_STAGES 6
 #define NUM_LIGHTS 8
+#define NUM_LIGHTING_SAMPLERS 24
 
 in vec4 primary_color;
 in vec2 texcoord[3];
@@ -1048,6 +1109,14 @@ layout (std140) uniform shader_data {
     LightSrc light_src[NUM_LIGHTS];
     vec4 const_color[NUM_TEV_STAGES];
     vec4 tev_combiner_buffer_color;
+    // Offsets of the lookup tables within their texel buffers, in texels
+    int fog_lut_offset;
+    int proctex_noise_lut_offset;
+    int proctex_color_map_offset;
+    int proctex_alpha_map_offset;
+    int proctex_lut_offset;
+    int proctex_diff_lut_offset;
+    ivec4 lighting_lut_offset[NUM_LIGHTING_SAMPLERS / 4];
 };
 
 uniform sampler2D tex[3];
@@ -1065,7 +1134,8 @@ vec3 quaternion_rotate(vec4 q, vec3 v) {
 }
 
 float LookupLightingLUT(int lut_index, int index, float delta) {
-    vec2 entry = texelFetch(lighting_lut, lut_index * 256 + index).rg;
+    int offset = lighting_lut_offset[lut_index >> 2][lut_index & 3];
+    vec2 entry = texelFetch(lighting_lut, offset + index).rg;
     return entry.r + entry.g * delta;
 }
 
@@ -1084,6 +1154,11 @@ float LookupLightingLUTSigned(int lut_index, float pos) {
 
 )";
 
+std::string GenerateFragmentShader(const PicaShaderConfig& config) {
+    const auto& state = config.state;
+
+    std::string out = FRAGMENT_SHADER_HEADER;
+
     if (config.state.proctex.enable)
         AppendProcTexSampler(out, config);
 
@@ -1145,7 +1220,7 @@ vec4 secondary_fragment_color = vec4(0.0);
         // Generate clamped fog factor from LUT for given fog index
         out += "float fog_i = clamp(floor(fog_index), 0.0, 127.0);\n";
         out += "float fog_f = fog_index - fog_i;\n";
-        out += "vec2 fog_lut_entry = texelFetch(fog_lut, int(fog_i)).rg;\n";
+        out += "vec2 fog_lut_entry = texelFetch(fog_lut, fog_lut_offset + int(fog_i)).rg;\n";
         out += "float fog_factor = fog_lut_entry.r + fog_lut_entry.g * fog_f;\n";
         out += "fog_factor = clamp(fog_factor, 0.0, 1.0);\n";
 
@@ -1161,6 +1236,555 @@ vec4 secondary_fragment_color = vec4(0.0);
     return out;
 }
 
+UbershaderConfig UbershaderConfig::BuildFromConfig(const PicaShaderConfig& config) {
+    const auto& state = config.state;
+    UbershaderConfig res;
+    std::memset(&res, 0, sizeof(UbershaderConfig));
+
+    res.alpha_test_func = static_cast<s32>(state.alpha_test_func);
+    res.scissor_test_mode = static_cast<s32>(state.scissor_test_mode);
+    res.texture0_type = static_cast<s32>(state.texture0_type);
+    res.texture2_use_coord1 = state.texture2_use_coord1;
+    res.combiner_buffer_input = state.combiner_buffer_input;
+    res.depthmap_enable = static_cast<s32>(state.depthmap_enable);
+    res.fog_mode = static_cast<s32>(state.fog_mode);
+    res.fog_flip = state.fog_flip;
+
+    for (size_t i = 0; i < state.tev_stages.size(); ++i) {
+        const auto& stage = state.tev_stages[i];
+        res.tev_stages[i] = {static_cast<s32>(stage.sources_raw),
+                             static_cast<s32>(stage.modifiers_raw),
+                             static_cast<s32>(stage.ops_raw), static_cast<s32>(stage.scales_raw)};
+    }
+
+    const auto& lighting = state.lighting;
+    res.lighting_enable = lighting.enable;
+    res.lighting_src_num = lighting.src_num;
+    res.lighting_config = static_cast<s32>(lighting.config);
+    res.lighting_fresnel_selector = static_cast<s32>(lighting.fresnel_selector);
+    res.lighting_bump_mode = static_cast<s32>(lighting.bump_mode);
+    res.lighting_bump_selector = lighting.bump_selector;
+    res.lighting_bump_renorm = lighting.bump_renorm;
+    res.lighting_clamp_highlights = lighting.clamp_highlights;
+
+    for (unsigned light_index = 0; light_index < lighting.src_num; ++light_index) {
+        const auto& light = lighting.light[light_index];
+        const s32 flags = (light.dist_atten_enable ? LIGHT_DIST_ATTEN : 0) |
+                          (light.spot_atten_enable ? LIGHT_SPOT_ATTEN : 0) |
+                          (light.geometric_factor_0 ? LIGHT_GEOMETRIC_FACTOR_0 : 0) |
+                          (light.geometric_factor_1 ? LIGHT_GEOMETRIC_FACTOR_1 : 0);
+        res.lighting_lights[light_index] = {static_cast<s32>(light.num), light.directional,
+                                            light.two_sided_diffuse, flags};
+    }
+
+    // Whether a LUT is supported by the lighting configuration is folded into its enable flag
+    using Sampler = LightingRegs::LightingSampler;
+    const auto set_lut = [&](u32 index, const decltype(lighting.lut_d0)& lut, Sampler sampler) {
+        const bool enable =
+            lut.enable && LightingRegs::IsLightingSamplerSupported(lighting.config, sampler);
+        res.lighting_luts[index] = {enable, lut.abs_input, static_cast<s32>(lut.type), 0};
+        res.lighting_lut_scales[index / 4][index % 4] = lut.scale;
+    };
+    set_lut(LUT_D0, lighting.lut_d0, Sampler::Distribution0);
+    set_lut(LUT_D1, lighting.lut_d1, Sampler::Distribution1);
+    set_lut(LUT_SP, lighting.lut_sp, Sampler::SpotlightAttenuation);
+    set_lut(LUT_FR, lighting.lut_fr, Sampler::Fresnel);
+    set_lut(LUT_RR, lighting.lut_rr, Sampler::ReflectRed);
+    set_lut(LUT_RG, lighting.lut_rg, Sampler::ReflectGreen);
+    set_lut(LUT_RB, lighting.lut_rb, Sampler::ReflectBlue);
+
+    const auto& proctex = state.proctex;
+    res.proctex_enable = proctex.enable;
+    res.proctex_coord = proctex.coord;
+    res.proctex_u_clamp = static_cast<s32>(proctex.u_clamp);
+    res.proctex_v_clamp = static_cast<s32>(proctex.v_clamp);
+    res.proctex_color_combiner = static_cast<s32>(proctex.color_combiner);
+    res.proctex_alpha_combiner = static_cast<s32>(proctex.alpha_combiner);
+    res.proctex_separate_alpha = proctex.separate_alpha;
+    res.proctex_noise_enable = proctex.noise_enable;
+    res.proctex_u_shift = static_cast<s32>(proctex.u_shift);
+    res.proctex_v_shift = static_cast<s32>(proctex.v_shift);
+    res.proctex_lut_width = proctex.lut_width;
+    res.proctex_lut_offset = proctex.lut_offset;
+    res.proctex_lut_filter = static_cast<s32>(proctex.lut_filter);
+
+    return res;
+}
+
+/// Configuration block and functions of the fragment ubershader. The numeric constants are the
+/// values of the corresponding register enumerations.
+static const char* UBERSHADER_BODY = R"(
+#define LUT_D0 0
+#define LUT_D1 1
+#define LUT_SP 2
+#define LUT_FR 3
+#define LUT_RR 4
+#define LUT_RG 5
+#define LUT_RB 6
+
+#define LIGHT_DIST_ATTEN 1
+#define LIGHT_SPOT_ATTEN 2
+#define LIGHT_GEOMETRIC_FACTOR_0 4
+#define LIGHT_GEOMETRIC_FACTOR_1 8
+
+layout (std140) uniform ubershader_config {
+    int alpha_test_func;
+    int scissor_test_mode;
+    int texture0_type;
+    int texture2_use_coord1;
+    int combiner_buffer_input;
+    int depthmap_enable;
+    int fog_mode;
+    int fog_flip;
+    // Raw TEV stage registers: sources, modifiers, operations and scales
+    ivec4 tev_stages[NUM_TEV_STAGES];
+    int lighting_enable;
+    int lighting_src_num;
+    int lighting_config;
+    int lighting_fresnel_selector;
+    int lighting_bump_mode;
+    int lighting_bump_selector;
+    int lighting_bump_renorm;
+    int lighting_clamp_highlights;
+    // Light number, directional, two-sided diffuse and LIGHT_* flags of each enabled light
+    ivec4 lighting_lights[NUM_LIGHTS];
+    // Enable, absolute input and input of the LUT_* lookup tables
+    ivec4 lighting_luts[7];
+    vec4 lighting_lut_scales[2];
+    int proctex_enable;
+    int proctex_coord;
+    int proctex_u_clamp;
+    int proctex_v_clamp;
+    int proctex_color_combiner;
+    int proctex_alpha_combiner;
+    int proctex_separate_alpha;
+    int proctex_noise_enable;
+    int proctex_u_shift;
+    int proctex_v_shift;
+    int proctex_lut_width;
+    int proctex_lut_offset;
+    int proctex_lut_filter;
+} cfg;
+
+vec4 primary_fragment_color = vec4(0.0);
+vec4 secondary_fragment_color = vec4(0.0);
+vec4 texture_color[4];
+vec4 combiner_buffer = vec4(0.0);
+vec4 last_tex_env_out = vec4(0.0);
+
+vec3 normal;
+vec3 tangent;
+vec3 light_vector;
+vec3 spot_dir;
+vec3 half_vector;
+
+float ProcTexShiftOffset(float v, int mode, int clamp_mode) {
+    float offset = (clamp_mode == 3) ? 1.0 : 0.5;
+    switch (mode) {
+    case 1: return offset * float((int(v) / 2) % 2);
+    case 2: return offset * float(((int(v) + 1) / 2) % 2);
+    }
+    return 0.0;
+}
+
+float ProcTexClamp(float v, int mode) {
+    switch (mode) {
+    case 0: return v > 1.0 ? 0.0 : v;
+    case 2: return fract(v);
+    case 3: return int(v) % 2 == 0 ? fract(v) : 1.0 - fract(v);
+    case 4: return v > 0.5 ? 1.0 : 0.0;
+    }
+    return min(v, 1.0);
+}
+
+float ProcTexCombine(int combiner, float u, float v) {
+    switch (combiner) {
+    case 0: return u;
+    case 1: return u * u;
+    case 2: return v;
+    case 3: return v * v;
+    case 4: return (u + v) * 0.5;
+    case 5: return (u * u + v * v) * 0.5;
+    case 6: return min(sqrt(u * u + v * v), 1.0);
+    case 7: return min(u, v);
+    case 8: return max(u, v);
+    case 9: return min(((u + v) * 0.5 + sqrt(u * u + v * v)) * 0.5, 1.0);
+    }
+    return 0.0;
+}
+
+vec4 ProcTex() {
+    vec2 uv = abs(cfg.proctex_coord == 0 ? texcoord[0]
+                                         : (cfg.proctex_coord == 1 ? texcoord[1] : texcoord[2]));
+
+    // Get shift offset before noise generation
+    float u_shift = ProcTexShiftOffset(uv.y, cfg.proctex_u_shift, cfg.proctex_u_clamp);
+    float v_shift = ProcTexShiftOffset(uv.x, cfg.proctex_v_shift, cfg.proctex_v_clamp);
+
+    if (cfg.proctex_noise_enable != 0) {
+        uv += proctex_noise_a * ProcTexNoiseCoef(uv);
+        uv = abs(uv);
+    }
+
+    float u = ProcTexClamp(uv.x + u_shift, cfg.proctex_u_clamp);
+    float v = ProcTexClamp(uv.y + v_shift, cfg.proctex_v_clamp);
+
+    // For the color lut, coord=0.0 is lut[offset] and coord=1.0 is lut[offset+width-1]
+    float lut_coord = ProcTexLookupLUT(proctex_color_map, proctex_color_map_offset,
+                                       ProcTexCombine(cfg.proctex_color_combiner, u, v));
+    lut_coord *= float(cfg.proctex_lut_width - 1);
+
+    vec4 final_color;
+    if (cfg.proctex_lut_filter == 1 || cfg.proctex_lut_filter == 3 ||
+        cfg.proctex_lut_filter == 5) {
+        int lut_index_i = int(lut_coord) + cfg.proctex_lut_offset;
+        float lut_index_f = fract(lut_coord);
+        final_color = texelFetch(proctex_lut, proctex_lut_offset + lut_index_i) +
+                      lut_index_f * texelFetch(proctex_diff_lut, proctex_diff_lut_offset +
+                                                                     lut_index_i);
+    } else {
+        lut_coord += float(cfg.proctex_lut_offset);
+        final_color = texelFetch(proctex_lut, proctex_lut_offset + int(round(lut_coord)));
+    }
+
+    if (cfg.proctex_separate_alpha != 0) {
+        return vec4(final_color.xyz,
+                    ProcTexLookupLUT(proctex_alpha_map, proctex_alpha_map_offset,
+                                     ProcTexCombine(cfg.proctex_alpha_combiner, u, v)));
+    }
+    return final_color;
+}
+
+float GetLutIndex(int lut_input) {
+    switch (lut_input) {
+    case 0: return dot(normal, normalize(half_vector));
+    case 1: return dot(normalize(view), normalize(half_vector));
+    case 2: return dot(normal, normalize(view));
+    case 3: return dot(light_vector, normal);
+    case 4: return dot(light_vector, spot_dir);
+    case 5:
+        // CP input is only available with configuration 7
+        if (cfg.lighting_config == 8) {
+            vec3 half_angle_proj = normalize(half_vector) - normal / dot(normal, normal) *
+                                                             dot(normal, normalize(half_vector));
+            return dot(half_angle_proj, tangent);
+        }
+        return 0.0;
+    }
+    return 0.0;
+}
+
+float GetLutValue(int lut, int lut_sampler, bool two_sided) {
+    ivec4 lut_config = cfg.lighting_luts[lut];
+    float index = GetLutIndex(lut_config.z);
+    float value;
+    if (lut_config.y != 0) {
+        // LUT index is in the range of (0.0, 1.0)
+        index = two_sided ? abs(index) : max(index, 0.0);
+        value = LookupLightingLUTUnsigned(lut_sampler, index);
+    } else {
+        // LUT index is in the range of (-1.0, 1.0)
+        value = LookupLightingLUTSigned(lut_sampler, index);
+    }
+    return cfg.lighting_lut_scales[lut >> 2][lut & 3] * value;
+}
+
+void ComputeLighting() {
+    vec4 diffuse_sum = vec4(0.0, 0.0, 0.0, 1.0);
+    vec4 specular_sum = vec4(0.0, 0.0, 0.0, 1.0);
+
+    // Compute fragment normals and tangents
+    vec3 surface_normal = vec3(0.0, 0.0, 1.0);
+    vec3 surface_tangent = vec3(1.0, 0.0, 0.0);
+    vec3 perturbation = 2.0 * texture_color[cfg.lighting_bump_selector].rgb - 1.0;
+    if (cfg.lighting_bump_mode == 1) {
+        surface_normal = perturbation;
+        if (cfg.lighting_bump_renorm != 0) {
+            surface_normal.z = sqrt(max(1.0 - (surface_normal.x * surface_normal.x +
+                                               surface_normal.y * surface_normal.y), 0.0));
+        }
+    } else if (cfg.lighting_bump_mode == 2) {
+        surface_tangent = perturbation;
+    }
+
+    vec4 normalized_normquat = normalize(normquat);
+    normal = quaternion_rotate(normalized_normquat, surface_normal);
+    tangent = quaternion_rotate(normalized_normquat, surface_tangent);
+
+    for (int light_index = 0; light_index < cfg.lighting_src_num; ++light_index) {
+        ivec4 light_config = cfg.lighting_lights[light_index];
+        int num = light_config.x;
+        bool two_sided = light_config.z != 0;
+        int flags = light_config.w;
+
+        if (light_config.y != 0)
+            light_vector = normalize(light_src[num].position);
+        else
+            light_vector = normalize(light_src[num].position + view);
+
+        spot_dir = light_src[num].spot_direction;
+        half_vector = normalize(view) + light_vector;
+
+        float dot_product = two_sided ? abs(dot(light_vector, normal))
+                                      : max(dot(light_vector, normal), 0.0);
+
+        float spot_atten = 1.0;
+        if ((flags & LIGHT_SPOT_ATTEN) != 0 && cfg.lighting_luts[LUT_SP].x != 0)
+            spot_atten = GetLutValue(LUT_SP, 8 + num, two_sided);
+
+        float dist_atten = 1.0;
+        if ((flags & LIGHT_DIST_ATTEN) != 0) {
+            float index = clamp(light_src[num].dist_atten_scale *
+                                length(-view - light_src[num].position) +
+                                light_src[num].dist_atten_bias, 0.0, 1.0);
+            dist_atten = LookupLightingLUTUnsigned(16 + num, index);
+        }
+
+        float clamp_highlights = 1.0;
+        if (cfg.lighting_clamp_highlights != 0 && dot(light_vector, normal) <= 0.0)
+            clamp_highlights = 0.0;
+
+        float geo_factor = 1.0;
+        if ((flags & (LIGHT_GEOMETRIC_FACTOR_0 | LIGHT_GEOMETRIC_FACTOR_1)) != 0) {
+            geo_factor = dot(half_vector, half_vector);
+            geo_factor = geo_factor == 0.0 ? 0.0 : min(dot_product / geo_factor, 1.0);
+        }
+
+        float d0_lut_value = 1.0;
+        if (cfg.lighting_luts[LUT_D0].x != 0)
+            d0_lut_value = GetLutValue(LUT_D0, 0, two_sided);
+        vec3 specular_0 = d0_lut_value * light_src[num].specular_0;
+        if ((flags & LIGHT_GEOMETRIC_FACTOR_0) != 0)
+            specular_0 *= geo_factor;
+
+        vec3 refl_value;
+        refl_value.r = cfg.lighting_luts[LUT_RR].x != 0 ? GetLutValue(LUT_RR, 6, two_sided) : 1.0;
+        refl_value.g = cfg.lighting_luts[LUT_RG].x != 0 ? GetLutValue(LUT_RG, 5, two_sided)
+                                                       : refl_value.r;
+        refl_value.b = cfg.lighting_luts[LUT_RB].x != 0 ? GetLutValue(LUT_RB, 4, two_sided)
+                                                       : refl_value.r;
+
+        float d1_lut_value = 1.0;
+        if (cfg.lighting_luts[LUT_D1].x != 0)
+            d1_lut_value = GetLutValue(LUT_D1, 1, two_sided);
+        vec3 specular_1 = d1_lut_value * refl_value * light_src[num].specular_1;
+        if ((flags & LIGHT_GEOMETRIC_FACTOR_1) != 0)
+            specular_1 *= geo_factor;
+
+        if (cfg.lighting_luts[LUT_FR].x != 0) {
+            float fresnel = GetLutValue(LUT_FR, 3, two_sided);
+            if ((cfg.lighting_fresnel_selector & 1) != 0)
+                diffuse_sum.a *= fresnel;
+            if ((cfg.lighting_fresnel_selector & 2) != 0)
+                specular_sum.a *= fresnel;
+        }
+
+        diffuse_sum.rgb += ((light_src[num].diffuse * dot_product) + light_src[num].ambient) *
+                           dist_atten * spot_atten;
+        specular_sum.rgb += (specular_0 + specular_1) * clamp_highlights * dist_atten * spot_atten;
+    }
+
+    diffuse_sum.rgb += lighting_global_ambient;
+    primary_fragment_color = clamp(diffuse_sum, vec4(0.0), vec4(1.0));
+    secondary_fragment_color = clamp(specular_sum, vec4(0.0), vec4(1.0));
+}
+
+vec4 GetSource(int source, int stage) {
+    switch (source) {
+    case 0: return primary_color;
+    case 1: return primary_fragment_color;
+    case 2: return secondary_fragment_color;
+    case 3: return texture_color[0];
+    case 4: return texture_color[1];
+    case 5: return texture_color[2];
+    case 6: return texture_color[3];
+    case 13: return combiner_buffer;
+    case 14: return const_color[stage];
+    case 15: return last_tex_env_out;
+    }
+    return vec4(0.0);
+}
+
+vec3 GetColorModifier(int modifier, vec4 value) {
+    switch (modifier) {
+    case 0: return value.rgb;
+    case 1: return vec3(1.0) - value.rgb;
+    case 2: return value.aaa;
+    case 3: return vec3(1.0) - value.aaa;
+    case 4: return value.rrr;
+    case 5: return vec3(1.0) - value.rrr;
+    case 8: return value.ggg;
+    case 9: return vec3(1.0) - value.ggg;
+    case 12: return value.bbb;
+    case 13: return vec3(1.0) - value.bbb;
+    }
+    return vec3(0.0);
+}
+
+float GetAlphaModifier(int modifier, vec4 value) {
+    switch (modifier) {
+    case 0: return value.a;
+    case 1: return 1.0 - value.a;
+    case 2: return value.r;
+    case 3: return 1.0 - value.r;
+    case 4: return value.g;
+    case 5: return 1.0 - value.g;
+    case 6: return value.b;
+    case 7: return 1.0 - value.b;
+    }
+    return 0.0;
+}
+
+vec3 CombineColor(int operation, vec3 v[3]) {
+    switch (operation) {
+    case 0: return clamp(v[0], vec3(0.0), vec3(1.0));
+    case 1: return clamp(v[0] * v[1], vec3(0.0), vec3(1.0));
+    case 2: return clamp(v[0] + v[1], vec3(0.0), vec3(1.0));
+    case 3: return clamp(v[0] + v[1] - vec3(0.5), vec3(0.0), vec3(1.0));
+    case 4: return clamp(v[0] * v[2] + v[1] * (vec3(1.0) - v[2]), vec3(0.0), vec3(1.0));
+    case 5: return clamp(v[0] - v[1], vec3(0.0), vec3(1.0));
+    case 6:
+    case 7:
+        return clamp(vec3(dot(v[0] - vec3(0.5), v[1] - vec3(0.5)) * 4.0), vec3(0.0), vec3(1.0));
+    case 8: return clamp(v[0] * v[1] + v[2], vec3(0.0), vec3(1.0));
+    case 9: return clamp(min(v[0] + v[1], vec3(1.0)) * v[2], vec3(0.0), vec3(1.0));
+    }
+    return vec3(0.0);
+}
+
+float CombineAlpha(int operation, float v[3]) {
+    switch (operation) {
+    case 0: return clamp(v[0], 0.0, 1.0);
+    case 1: return clamp(v[0] * v[1], 0.0, 1.0);
+    case 2: return clamp(v[0] + v[1], 0.0, 1.0);
+    case 3: return clamp(v[0] + v[1] - 0.5, 0.0, 1.0);
+    case 4: return clamp(v[0] * v[2] + v[1] * (1.0 - v[2]), 0.0, 1.0);
+    case 5: return clamp(v[0] - v[1], 0.0, 1.0);
+    case 8: return clamp(v[0] * v[1] + v[2], 0.0, 1.0);
+    case 9: return clamp(min(v[0] + v[1], 1.0) * v[2], 0.0, 1.0);
+    }
+    return 0.0;
+}
+
+float GetMultiplier(int scale) {
+    return scale < 3 ? float(1 << scale) : 1.0;
+}
+
+bool AlphaTestFails(int alpha) {
+    switch (cfg.alpha_test_func) {
+    case 0: return true;
+    case 2: return alpha != alphatest_ref;
+    case 3: return alpha == alphatest_ref;
+    case 4: return alpha >= alphatest_ref;
+    case 5: return alpha > alphatest_ref;
+    case 6: return alpha <= alphatest_ref;
+    case 7: return alpha < alphatest_ref;
+    }
+    return false;
+}
+
+void main() {
+    if (cfg.alpha_test_func == 0) {
+        discard;
+    }
+
+    if (cfg.scissor_test_mode != 0) {
+        bool inside = gl_FragCoord.x >= scissor_x1 && gl_FragCoord.y >= scissor_y1 &&
+                      gl_FragCoord.x < scissor_x2 && gl_FragCoord.y < scissor_y2;
+        // Include mode keeps only the pixels inside the scissor box, Exclude those outside
+        if (inside == (cfg.scissor_test_mode == 1)) {
+            discard;
+        }
+    }
+
+    float z_over_w = 1.0 - gl_FragCoord.z * 2.0;
+    float depth = z_over_w * depth_scale + depth_offset;
+    if (cfg.depthmap_enable == 0) {
+        depth /= gl_FragCoord.w;
+    }
+
+    // Texture units are sampled once up front, as any number of sources may refer to them
+    if (cfg.texture0_type == 3)
+        texture_color[0] = textureProj(tex[0], vec3(texcoord[0], texcoord0_w));
+    else
+        texture_color[0] = texture(tex[0], texcoord[0]);
+    texture_color[1] = texture(tex[1], texcoord[1]);
+    texture_color[2] = texture(tex[2], cfg.texture2_use_coord1 != 0 ? texcoord[1] : texcoord[2]);
+    texture_color[3] = cfg.proctex_enable != 0 ? ProcTex() : vec4(0.0);
+
+    if (cfg.lighting_enable != 0)
+        ComputeLighting();
+
+    vec4 next_combiner_buffer = tev_combiner_buffer_color;
+    for (int stage = 0; stage < NUM_TEV_STAGES; ++stage) {
+        ivec4 config = cfg.tev_stages[stage];
+        int sources = config.x;
+        int modifiers = config.y;
+
+        vec3 color_results[3] = vec3[3](
+            GetColorModifier(modifiers & 0xF, GetSource(sources & 0xF, stage)),
+            GetColorModifier((modifiers >> 4) & 0xF, GetSource((sources >> 4) & 0xF, stage)),
+            GetColorModifier((modifiers >> 8) & 0xF, GetSource((sources >> 8) & 0xF, stage)));
+        int color_op = config.z & 0xF;
+        vec3 color_output = CombineColor(color_op, color_results);
+
+        float alpha_output;
+        if (color_op == 7) {
+            // result of Dot3_RGBA operation is also placed to the alpha component
+            alpha_output = color_output[0];
+        } else {
+            float alpha_results[3] = float[3](
+                GetAlphaModifier((modifiers >> 12) & 0x7, GetSource((sources >> 16) & 0xF, stage)),
+                GetAlphaModifier((modifiers >> 16) & 0x7, GetSource((sources >> 20) & 0xF, stage)),
+                GetAlphaModifier((modifiers >> 20) & 0x7, GetSource((sources >> 24) & 0xF, stage)));
+            alpha_output = CombineAlpha((config.z >> 16) & 0xF, alpha_results);
+        }
+
+        last_tex_env_out = vec4(
+            clamp(color_output * GetMultiplier(config.w & 0x3), vec3(0.0), vec3(1.0)),
+            clamp(alpha_output * GetMultiplier((config.w >> 16) & 0x3), 0.0, 1.0));
+
+        combiner_buffer = next_combiner_buffer;
+        if ((cfg.combiner_buffer_input & (1 << stage)) != 0)
+            next_combiner_buffer.rgb = last_tex_env_out.rgb;
+        if ((cfg.combiner_buffer_input & (0x10 << stage)) != 0)
+            next_combiner_buffer.a = last_tex_env_out.a;
+    }
+
+    if (AlphaTestFails(int(last_tex_env_out.a * 255.0))) {
+        discard;
+    }
+
+    if (cfg.fog_mode == 5) {
+        float fog_index = (cfg.fog_flip != 0 ? 1.0 - depth : depth) * 128.0;
+        float fog_i = clamp(floor(fog_index), 0.0, 127.0);
+        float fog_f = fog_index - fog_i;
+        vec2 fog_lut_entry = texelFetch(fog_lut, fog_lut_offset + int(fog_i)).rg;
+        float fog_factor = clamp(fog_lut_entry.r + fog_lut_entry.g * fog_f, 0.0, 1.0);
+        last_tex_env_out.rgb = mix(fog_color.rgb, last_tex_env_out.rgb, fog_factor);
+    }
+
+    gl_FragDepth = depth;
+    color = last_tex_env_out;
+}
+)";
+
+std::string GenerateFragmentUbershader() {
+    std::string out = FRAGMENT_SHADER_HEADER;
+    out += PROCTEX_LUT_LOOKUP;
+    out += PROCTEX_NOISE;
+    out += UBERSHADER_BODY;
+    return out;
+}
+
+/// Uniform block of the vertex stages, with the coefficients of the user clipping plane, which
+/// are all zero while it's disabled
+static const char* CLIP_DATA_BLOCK = R"(
+layout (std140) uniform clip_data {
+    vec4 clip_coef;
+};
+)";
+
 std::string GenerateVertexShader() {
     std::string out = "#version 330 core\n";
 
@@ -1179,6 +1803,7 @@ std::string GenerateVertexShader() {
            ") in vec4 vert_normquat;\n";
     out += "layout(location = " + std::to_string((int)ATTRIBUTE_VIEW) + ") in vec3 vert_view;\n";
 
+    out += CLIP_DATA_BLOCK;
     out += R"(
 out vec4 primary_color;
 out vec2 texcoord[3];
@@ -1195,6 +1820,155 @@ void main() {
     normquat = vert_normquat;
     view = vert_view;
     gl_Position = vec4(vert_position.x, vert_position.y, -vert_position.z, vert_position.w);
+
+    // The PICA keeps z <= 0, while the GL frustum only covers the z >= -w side of it
+    gl_ClipDistance[0] = -vert_position.z;
+    gl_ClipDistance[1] = dot(clip_coef, vert_position);
+}
+)";
+
+    return out;
+}
+
+/// Vertex attributes passed from the hardware vertex shader to the fixed geometry shader
+static const char* VERTEX_DATA_BLOCK = R"(VertexData {
+    vec4 primary_color;
+    vec2 texcoord[3];
+    float texcoord0_w;
+    vec4 normquat;
+    vec3 view;
+})";
+
+boost::optional<std::string> GenerateVertexShader(const Pica::Shader::ShaderSetup& setup,
+                                                  const PicaVSConfig& config) {
+    const auto& state = config.state;
+
+    boost::optional<std::string> program =
+        DecompileProgram(setup.program_code, setup.swizzle_data, state.main_offset,
+                         VS_PROGRAM_CODE_LENGTH);
+    if (!program) {
+        return boost::none;
+    }
+
+    std::string out = "#version 330 core\n";
+
+    for (int i = 0; i < 16; ++i) {
+        out += "layout(location = " + std::to_string(i) + ") in vec4 vs_in_reg" +
+               std::to_string(i) + ";\n";
+    }
+
+    out += "\nout ";
+    out += VERTEX_DATA_BLOCK;
+    out += R"( vs_out;
+
+layout (std140) uniform vs_config {
+    vec4 uniform_f[96];
+    uvec4 uniform_i[4];
+    uint uniform_b;
+};
+
+)";
+
+    out += *program;
+
+    auto semantic = [&state](RasterizerRegs::VSOutputAttributes::Semantic slot) -> std::string {
+        const u8 source = state.semantic_sources[slot];
+        if (source == PicaVSConfig::NO_SEMANTIC_SOURCE) {
+            return "0.0";
+        }
+        return "reg_out[" + std::to_string(source / 4) + "]." + "xyzw"[source % 4];
+    };
+
+    auto vec = [&semantic](std::initializer_list<RasterizerRegs::VSOutputAttributes::Semantic>
+                               slots) -> std::string {
+        std::string out = "vec" + std::to_string(slots.size()) + "(";
+        for (auto slot = slots.begin(); slot != slots.end(); ++slot) {
+            if (slot != slots.begin()) {
+                out += ", ";
+            }
+            out += semantic(*slot);
+        }
+        return out + ")";
+    };
+
+    using Semantic = RasterizerRegs::VSOutputAttributes::Semantic;
+
+    out += R"(
+void main() {
+    exec_shader();
+
+    vec4 vtx_pos = )" +
+           vec({Semantic::POSITION_X, Semantic::POSITION_Y, Semantic::POSITION_Z,
+                Semantic::POSITION_W}) +
+           R"(;
+    gl_Position = vec4(vtx_pos.x, vtx_pos.y, -vtx_pos.z, vtx_pos.w);
+
+    // The hardware takes the absolute and saturates vertex colors like this, *before* doing
+    // interpolation
+    vs_out.primary_color = min(abs()" +
+           vec({Semantic::COLOR_R, Semantic::COLOR_G, Semantic::COLOR_B, Semantic::COLOR_A}) +
+           R"(), vec4(1.0));
+    vs_out.texcoord[0] = )" +
+           vec({Semantic::TEXCOORD0_U, Semantic::TEXCOORD0_V}) + R"(;
+    vs_out.texcoord[1] = )" +
+           vec({Semantic::TEXCOORD1_U, Semantic::TEXCOORD1_V}) + R"(;
+    vs_out.texcoord[2] = )" +
+           vec({Semantic::TEXCOORD2_U, Semantic::TEXCOORD2_V}) + R"(;
+    vs_out.texcoord0_w = )" +
+           semantic(Semantic::TEXCOORD0_W) + R"(;
+    vs_out.normquat = )" +
+           vec({Semantic::QUATERNION_X, Semantic::QUATERNION_Y, Semantic::QUATERNION_Z,
+                Semantic::QUATERNION_W}) +
+           R"(;
+    vs_out.view = )" +
+           vec({Semantic::VIEW_X, Semantic::VIEW_Y, Semantic::VIEW_Z}) + R"(;
+}
+)";
+
+    return out;
+}
+
+std::string GenerateFixedGeometryShader() {
+    std::string out = R"(#version 330 core
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+in )";
+    out += VERTEX_DATA_BLOCK;
+    out += R"( gs_in[];
+)";
+    out += CLIP_DATA_BLOCK;
+    out += R"(
+
+out vec4 primary_color;
+out vec2 texcoord[3];
+out float texcoord0_w;
+out vec4 normquat;
+out vec3 view;
+
+void EmitVtx(int index, bool flip_quaternion) {
+    gl_Position = gl_in[index].gl_Position;
+    // The vertex shader negated z, see GenerateVertexShader for the planes
+    vec4 vtx_pos = vec4(gl_Position.xy, -gl_Position.z, gl_Position.w);
+    gl_ClipDistance[0] = -vtx_pos.z;
+    gl_ClipDistance[1] = dot(clip_coef, vtx_pos);
+    primary_color = gs_in[index].primary_color;
+    texcoord[0] = gs_in[index].texcoord[0];
+    texcoord[1] = gs_in[index].texcoord[1];
+    texcoord[2] = gs_in[index].texcoord[2];
+    texcoord0_w = gs_in[index].texcoord0_w;
+    normquat = flip_quaternion ? -gs_in[index].normquat : gs_in[index].normquat;
+    view = gs_in[index].view;
+    EmitVertex();
+}
+
+void main() {
+    // Quaternions describe the same rotation whether negated or not, but interpolating between
+    // opposite ones doesn't, so orient them towards the first vertex
+    EmitVtx(0, false);
+    EmitVtx(1, dot(gs_in[0].normquat, gs_in[1].normquat) < 0.0);
+    EmitVtx(2, dot(gs_in[0].normquat, gs_in[2].normquat) < 0.0);
+    EndPrimitive();
 }
 )";
 
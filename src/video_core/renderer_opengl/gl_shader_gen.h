@@ -9,8 +9,18 @@
 #include <functional>
 #include <string>
 #include <type_traits>
+#include <boost/optional.hpp>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "common/hash.h"
 #include "video_core/regs.h"
 
+namespace Pica {
+namespace Shader {
+struct ShaderSetup;
+}
+} // namespace Pica
+
 namespace GLShader {
 
 enum Attributes {
@@ -136,12 +146,123 @@ static_assert(std::is_trivially_copyable<PicaShaderConfig::State>::value,
               "PicaShaderConfig::State must be trivially copyable");
 #endif
 
+/**
+ * Uniform block of the fragment ubershader, holding the PicaShaderConfig state that specialized
+ * fragment shaders are generated from. Laid out according to std140, with enumerations stored as
+ * their register values.
+ */
+struct UbershaderConfig {
+    /// Indices of the lighting lookup tables in lighting_luts and lighting_lut_scales
+    enum : u32 { LUT_D0, LUT_D1, LUT_SP, LUT_FR, LUT_RR, LUT_RG, LUT_RB, NUM_LUTS };
+
+    /// Flags of lighting_lights[n][3]
+    enum : s32 {
+        LIGHT_DIST_ATTEN = 1 << 0,
+        LIGHT_SPOT_ATTEN = 1 << 1,
+        LIGHT_GEOMETRIC_FACTOR_0 = 1 << 2,
+        LIGHT_GEOMETRIC_FACTOR_1 = 1 << 3,
+    };
+
+    /// Construct the ubershader configuration emulating the given shader configuration
+    static UbershaderConfig BuildFromConfig(const PicaShaderConfig& config);
+
+    s32 alpha_test_func;
+    s32 scissor_test_mode;
+    s32 texture0_type;
+    s32 texture2_use_coord1;
+    s32 combiner_buffer_input;
+    s32 depthmap_enable;
+    s32 fog_mode;
+    s32 fog_flip;
+    /// Raw sources, modifiers, operations and scales registers of each TEV stage
+    std::array<std::array<s32, 4>, 6> tev_stages;
+    s32 lighting_enable;
+    s32 lighting_src_num;
+    s32 lighting_config;
+    s32 lighting_fresnel_selector;
+    s32 lighting_bump_mode;
+    s32 lighting_bump_selector;
+    s32 lighting_bump_renorm;
+    s32 lighting_clamp_highlights;
+    /// Light number, directional, two-sided diffuse and LIGHT_* flags of each enabled light
+    std::array<std::array<s32, 4>, 8> lighting_lights;
+    /// Enable (only set if the lighting configuration supports the LUT), absolute input and input
+    std::array<std::array<s32, 4>, NUM_LUTS> lighting_luts;
+    std::array<std::array<f32, 4>, 2> lighting_lut_scales;
+    s32 proctex_enable;
+    s32 proctex_coord;
+    s32 proctex_u_clamp;
+    s32 proctex_v_clamp;
+    s32 proctex_color_combiner;
+    s32 proctex_alpha_combiner;
+    s32 proctex_separate_alpha;
+    s32 proctex_noise_enable;
+    s32 proctex_u_shift;
+    s32 proctex_v_shift;
+    s32 proctex_lut_width;
+    s32 proctex_lut_offset;
+    s32 proctex_lut_filter;
+    INSERT_PADDING_WORDS(3);
+};
+
+static_assert(sizeof(UbershaderConfig) == 496,
+              "The size of the UbershaderConfig structure has changed, update the ubershader");
+
+/**
+ * This struct contains all state used to translate the PICA vertex shader into a GLSL vertex shader
+ * for the hardware shader path. Like PicaShaderConfig it is used as a cache key, so the program
+ * itself is only captured through its hashes and the output mapping is resolved to the register
+ * component feeding each vertex semantic.
+ */
+union PicaVSConfig {
+    /// Marks a vertex semantic that isn't written by any output register
+    static constexpr u8 NO_SEMANTIC_SOURCE = 0xFF;
+
+    /// Construct a PicaVSConfig with the given Pica register configuration and shader unit state.
+    static PicaVSConfig BuildFromRegs(const Pica::Regs& regs,
+                                      const Pica::Shader::ShaderSetup& setup);
+
+    bool operator==(const PicaVSConfig& o) const {
+        return std::memcmp(&state, &o.state, sizeof(PicaVSConfig::State)) == 0;
+    };
+
+    struct State {
+        u64 program_hash;
+        u64 swizzle_hash;
+        u32 main_offset;
+
+        /// Output register component of each semantic, as register * 4 + component
+        std::array<u8, 24> semantic_sources;
+    } state;
+};
+#if (__GNUC__ >= 5) || defined(__clang__) || defined(_MSC_VER)
+static_assert(std::is_trivially_copyable<PicaVSConfig::State>::value,
+              "PicaVSConfig::State must be trivially copyable");
+#endif
+
 /**
  * Generates the GLSL vertex shader program source code for the current Pica state
  * @returns String of the shader source code
  */
 std::string GenerateVertexShader();
 
+/**
+ * Generates the GLSL vertex shader running the PICA vertex shader program on the GPU
+ * @param setup Shader unit state holding the program code and operand descriptors
+ * @param config PicaVSConfig object generated for the current Pica state
+ * @returns String of the shader source code, or boost::none if the program can't be translated
+ */
+boost::optional<std::string> GenerateVertexShader(const Pica::Shader::ShaderSetup& setup,
+                                                  const PicaVSConfig& config);
+
+/**
+ * Generates the GLSL geometry shader used along with hardware vertex shaders. It forwards the
+ * vertex attributes to the fragment shader, flipping the quaternions of a triangle towards its
+ * first vertex like the software path does when assembling triangles.
+ * @returns String of the shader source code
+ */
+std::string GenerateFixedGeometryShader();
+
 /**
  * Generates the GLSL fragment shader program source code for the current Pica state
  * @param config ShaderCacheKey object generated for the current Pica state, used for the shader
@@ -150,6 +271,13 @@ std::string GenerateVertexShader();
  */
 std::string GenerateFragmentShader(const PicaShaderConfig& config);
 
+/**
+ * Generates the GLSL fragment shader emulating any Pica fragment pipeline state, configured through
+ * the UbershaderConfig uniform block instead of being specialized to a PicaShaderConfig
+ * @returns String of the shader source code
+ */
+std::string GenerateFragmentUbershader();
+
 } // namespace GLShader
 
 namespace std {
@@ -159,4 +287,11 @@ struct hash<GLShader::PicaShaderConfig> {
         return Common::ComputeHash64(&k.state, sizeof(GLShader::PicaShaderConfig::State));
     }
 };
+
+template <>
+struct hash<GLShader::PicaVSConfig> {
+    size_t operator()(const GLShader::PicaVSConfig& k) const {
+        return Common::ComputeHash64(&k.state, sizeof(GLShader::PicaVSConfig::State));
+    }
+};
 } // namespace std
@@ -6,67 +6,75 @@
 #include <glad/glad.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "core/perf_stats.h"
 #include "video_core/renderer_opengl/gl_shader_util.h"
 
 namespace GLShader {
 
-GLuint LoadProgram(const char* vertex_shader, const char* fragment_shader) {
-
-    // Create the shaders
-    GLuint vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
-    GLuint fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
+/// Compiles a single shader stage, logging the compiler output
+static GLuint CompileShader(GLenum type, const char* source, const char* debug_type) {
+    GLuint shader_id = glCreateShader(type);
 
     GLint result = GL_FALSE;
     int info_log_length;
 
-    // Compile Vertex Shader
-    LOG_DEBUG(Render_OpenGL, "Compiling vertex shader...");
+    LOG_DEBUG(Render_OpenGL, "Compiling %s shader...", debug_type);
 
-    glShaderSource(vertex_shader_id, 1, &vertex_shader, nullptr);
-    glCompileShader(vertex_shader_id);
+    glShaderSource(shader_id, 1, &source, nullptr);
+    glCompileShader(shader_id);
 
-    // Check Vertex Shader
-    glGetShaderiv(vertex_shader_id, GL_COMPILE_STATUS, &result);
-    glGetShaderiv(vertex_shader_id, GL_INFO_LOG_LENGTH, &info_log_length);
+    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &result);
+    glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &info_log_length);
 
     if (info_log_length > 1) {
-        std::vector<char> vertex_shader_error(info_log_length);
-        glGetShaderInfoLog(vertex_shader_id, info_log_length, nullptr, &vertex_shader_error[0]);
+        std::vector<char> shader_error(info_log_length);
+        glGetShaderInfoLog(shader_id, info_log_length, nullptr, &shader_error[0]);
         if (result == GL_TRUE) {
-            LOG_DEBUG(Render_OpenGL, "%s", &vertex_shader_error[0]);
+            LOG_DEBUG(Render_OpenGL, "%s", &shader_error[0]);
         } else {
-            LOG_ERROR(Render_OpenGL, "Error compiling vertex shader:\n%s", &vertex_shader_error[0]);
+            LOG_ERROR(Render_OpenGL, "Error compiling %s shader:\n%s", debug_type,
+                      &shader_error[0]);
         }
     }
 
-    // Compile Fragment Shader
-    LOG_DEBUG(Render_OpenGL, "Compiling fragment shader...");
+    return shader_id;
+}
 
-    glShaderSource(fragment_shader_id, 1, &fragment_shader, nullptr);
-    glCompileShader(fragment_shader_id);
+GLuint LoadProgram(const char* vertex_shader, const char* fragment_shader) {
+    return LoadProgram(vertex_shader, nullptr, fragment_shader);
+}
 
-    // Check Fragment Shader
-    glGetShaderiv(fragment_shader_id, GL_COMPILE_STATUS, &result);
-    glGetShaderiv(fragment_shader_id, GL_INFO_LOG_LENGTH, &info_log_length);
+GLuint LoadProgram(const char* vertex_shader, const char* geometry_shader,
+                   const char* fragment_shader) {
+    Core::ScopedPerfTimer perf_timer(Core::PerfStats::Category::ShaderCompile);
+    Core::AddPerfCount(Core::PerfStats::Counter::ShaderCompiles);
 
-    if (info_log_length > 1) {
-        std::vector<char> fragment_shader_error(info_log_length);
-        glGetShaderInfoLog(fragment_shader_id, info_log_length, nullptr, &fragment_shader_error[0]);
-        if (result == GL_TRUE) {
-            LOG_DEBUG(Render_OpenGL, "%s", &fragment_shader_error[0]);
-        } else {
-            LOG_ERROR(Render_OpenGL, "Error compiling fragment shader:\n%s",
-                      &fragment_shader_error[0]);
-        }
+    // Create and compile the shaders
+    GLuint vertex_shader_id = CompileShader(GL_VERTEX_SHADER, vertex_shader, "vertex");
+    GLuint geometry_shader_id = 0;
+    if (geometry_shader != nullptr) {
+        geometry_shader_id = CompileShader(GL_GEOMETRY_SHADER, geometry_shader, "geometry");
     }
+    GLuint fragment_shader_id = CompileShader(GL_FRAGMENT_SHADER, fragment_shader, "fragment");
+
+    GLint result = GL_FALSE;
+    int info_log_length;
 
     // Link the program
     LOG_DEBUG(Render_OpenGL, "Linking program...");
 
     GLuint program_id = glCreateProgram();
     glAttachShader(program_id, vertex_shader_id);
+    if (geometry_shader_id != 0) {
+        glAttachShader(program_id, geometry_shader_id);
+    }
     glAttachShader(program_id, fragment_shader_id);
 
+    // Keep the binary retrievable for the shader disk cache
+    if (GLAD_GL_ARB_get_program_binary) {
+        glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     glLinkProgram(program_id);
 
     // Check the program
@@ -86,11 +94,17 @@ GLuint LoadProgram(const char* vertex_shader, const char* fragment_shader) {
     // If the program linking failed at least one of the shaders was probably bad
     if (result == GL_FALSE) {
         LOG_ERROR(Render_OpenGL, "Vertex shader:\n%s", vertex_shader);
+        if (geometry_shader != nullptr) {
+            LOG_ERROR(Render_OpenGL, "Geometry shader:\n%s", geometry_shader);
+        }
         LOG_ERROR(Render_OpenGL, "Fragment shader:\n%s", fragment_shader);
     }
     ASSERT_MSG(result == GL_TRUE, "Shader not linked");
 
     glDeleteShader(vertex_shader_id);
+    if (geometry_shader_id != 0) {
+        glDeleteShader(geometry_shader_id);
+    }
     glDeleteShader(fragment_shader_id);
 
     return program_id;
@@ -2,14 +2,28 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
 #include <glad/glad.h>
 #include "common/common_funcs.h"
 #include "common/logging/log.h"
 #include "video_core/renderer_opengl/gl_state.h"
 
-OpenGLState OpenGLState::cur_state;
+thread_local OpenGLState OpenGLState::cur_state;
+
+namespace {
+
+/// Compares groups of state bytewise, padding included, which OpenGLState() zeroes
+template <typename T>
+bool Differs(const T& a, const T& b) {
+    return std::memcmp(&a, &b, sizeof(T)) != 0;
+}
+
+} // Anonymous namespace
 
 OpenGLState::OpenGLState() {
+    // Zeroes the padding as well, so that Differs only sees actual changes
+    std::memset(this, 0, sizeof(*this));
+
     // These all match default OpenGL values
     cull.enabled = false;
     cull.mode = GL_BACK;
@@ -47,6 +61,10 @@ OpenGLState::OpenGLState() {
 
     logic_op = GL_COPY;
 
+    for (bool& enabled : clip_distance) {
+        enabled = false;
+    }
+
     for (auto& texture_unit : texture_units) {
         texture_unit.texture_2d = 0;
         texture_unit.sampler = 0;
@@ -71,7 +89,50 @@ OpenGLState::OpenGLState() {
 }
 
 void OpenGLState::Apply() const {
-    // Culling
+    // Most calls only change a few groups of the state, or none at all. Unchanged groups are
+    // skipped as a whole instead of comparing each of their fields.
+    if (!Differs(*this, cur_state)) {
+        return;
+    }
+
+    if (Differs(cull, cur_state.cull)) {
+        ApplyCulling();
+    }
+    if (Differs(depth, cur_state.depth)) {
+        ApplyDepth();
+    }
+    if (Differs(color_mask, cur_state.color_mask)) {
+        glColorMask(color_mask.red_enabled, color_mask.green_enabled, color_mask.blue_enabled,
+                    color_mask.alpha_enabled);
+    }
+    if (Differs(stencil, cur_state.stencil)) {
+        ApplyStencil();
+    }
+    if (Differs(blend, cur_state.blend) || logic_op != cur_state.logic_op) {
+        ApplyBlending();
+    }
+    if (Differs(clip_distance, cur_state.clip_distance)) {
+        ApplyClipDistances();
+    }
+    if (Differs(texture_units, cur_state.texture_units)) {
+        ApplyTextureUnits();
+    }
+    if (Differs(lighting_lut, cur_state.lighting_lut) || Differs(fog_lut, cur_state.fog_lut) ||
+        Differs(proctex_noise_lut, cur_state.proctex_noise_lut) ||
+        Differs(proctex_color_map, cur_state.proctex_color_map) ||
+        Differs(proctex_alpha_map, cur_state.proctex_alpha_map) ||
+        Differs(proctex_lut, cur_state.proctex_lut) ||
+        Differs(proctex_diff_lut, cur_state.proctex_diff_lut)) {
+        ApplyLUTs();
+    }
+    if (Differs(draw, cur_state.draw)) {
+        ApplyDraw();
+    }
+
+    cur_state = *this;
+}
+
+void OpenGLState::ApplyCulling() const {
     if (cull.enabled != cur_state.cull.enabled) {
         if (cull.enabled) {
             glEnable(GL_CULL_FACE);
@@ -87,7 +148,9 @@ void OpenGLState::Apply() const {
     if (cull.front_face != cur_state.cull.front_face) {
         glFrontFace(cull.front_face);
     }
+}
 
+void OpenGLState::ApplyDepth() const {
     // Depth test
     if (depth.test_enabled != cur_state.depth.test_enabled) {
         if (depth.test_enabled) {
@@ -105,16 +168,9 @@ void OpenGLState::Apply() const {
     if (depth.write_mask != cur_state.depth.write_mask) {
         glDepthMask(depth.write_mask);
     }
+}
 
-    // Color mask
-    if (color_mask.red_enabled != cur_state.color_mask.red_enabled ||
-        color_mask.green_enabled != cur_state.color_mask.green_enabled ||
-        color_mask.blue_enabled != cur_state.color_mask.blue_enabled ||
-        color_mask.alpha_enabled != cur_state.color_mask.alpha_enabled) {
-        glColorMask(color_mask.red_enabled, color_mask.green_enabled, color_mask.blue_enabled,
-                    color_mask.alpha_enabled);
-    }
-
+void OpenGLState::ApplyStencil() const {
     // Stencil test
     if (stencil.test_enabled != cur_state.stencil.test_enabled) {
         if (stencil.test_enabled) {
@@ -141,7 +197,9 @@ void OpenGLState::Apply() const {
     if (stencil.write_mask != cur_state.stencil.write_mask) {
         glStencilMask(stencil.write_mask);
     }
+}
 
+void OpenGLState::ApplyBlending() const {
     // Blending
     if (blend.enabled != cur_state.blend.enabled) {
         if (blend.enabled) {
@@ -179,8 +237,21 @@ void OpenGLState::Apply() const {
     if (logic_op != cur_state.logic_op) {
         glLogicOp(logic_op);
     }
+}
+
+void OpenGLState::ApplyClipDistances() const {
+    for (GLenum i = 0; i < ARRAY_SIZE(clip_distance); ++i) {
+        if (clip_distance[i] != cur_state.clip_distance[i]) {
+            if (clip_distance[i]) {
+                glEnable(GL_CLIP_DISTANCE0 + i);
+            } else {
+                glDisable(GL_CLIP_DISTANCE0 + i);
+            }
+        }
+    }
+}
 
-    // Textures
+void OpenGLState::ApplyTextureUnits() const {
     for (unsigned i = 0; i < ARRAY_SIZE(texture_units); ++i) {
         if (texture_units[i].texture_2d != cur_state.texture_units[i].texture_2d) {
             glActiveTexture(TextureUnits::PicaTexture(i).Enum());
@@ -190,11 +261,13 @@ void OpenGLState::Apply() const {
             glBindSampler(i, texture_units[i].sampler);
         }
     }
+}
 
+void OpenGLState::ApplyLUTs() const {
     // Lighting LUTs
     if (lighting_lut.texture_buffer != cur_state.lighting_lut.texture_buffer) {
         glActiveTexture(TextureUnits::LightingLUT.Enum());
-        glBindTexture(GL_TEXTURE_BUFFER, cur_state.lighting_lut.texture_buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, lighting_lut.texture_buffer);
     }
 
     // Fog LUT
@@ -232,7 +305,9 @@ void OpenGLState::Apply() const {
         glActiveTexture(TextureUnits::ProcTexDiffLUT.Enum());
         glBindTexture(GL_TEXTURE_BUFFER, proctex_diff_lut.texture_buffer);
     }
+}
 
+void OpenGLState::ApplyDraw() const {
     // Framebuffer
     if (draw.read_framebuffer != cur_state.draw.read_framebuffer) {
         glBindFramebuffer(GL_READ_FRAMEBUFFER, draw.read_framebuffer);
@@ -260,8 +335,6 @@ void OpenGLState::Apply() const {
     if (draw.shader_program != cur_state.draw.shader_program) {
         glUseProgram(draw.shader_program);
     }
-
-    cur_state = *this;
 }
 
 void OpenGLState::ResetTexture(GLuint handle) {
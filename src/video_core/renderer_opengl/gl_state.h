@@ -26,6 +26,8 @@ constexpr TextureUnit ProcTexColorMap{6};
 constexpr TextureUnit ProcTexAlphaMap{7};
 constexpr TextureUnit ProcTexLUT{8};
 constexpr TextureUnit ProcTexDiffLUT{9};
+constexpr TextureUnit SurfaceUntileBuffer{10};
+constexpr TextureUnit SurfaceReinterpretBuffer{11};
 
 } // namespace TextureUnits
 
@@ -80,6 +82,9 @@ public:
 
     GLenum logic_op; // GL_LOGIC_OP_MODE
 
+    // Only to be enabled for programs that write gl_ClipDistance, others leave it undefined
+    bool clip_distance[2]; // GL_CLIP_DISTANCE0 + i
+
     // 3 texture units - one for each that is used in PICA fragment shader emulation
     struct {
         GLuint texture_2d; // GL_TEXTURE_BINDING_2D
@@ -142,5 +147,16 @@ public:
     static void ResetFramebuffer(GLuint handle);
 
 private:
-    static OpenGLState cur_state;
+    // Apply the groups of the state that differ from the current one
+    void ApplyCulling() const;
+    void ApplyDepth() const;
+    void ApplyStencil() const;
+    void ApplyBlending() const;
+    void ApplyClipDistances() const;
+    void ApplyTextureUnits() const;
+    void ApplyLUTs() const;
+    void ApplyDraw() const;
+
+    /// Each thread has a context of its own, with its own state
+    static thread_local OpenGLState cur_state;
 };
@@ -0,0 +1,75 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
+
+OGLStreamBuffer::OGLStreamBuffer(GLenum target) : target(target) {}
+
+OGLStreamBuffer::~OGLStreamBuffer() {
+    Release();
+}
+
+void OGLStreamBuffer::Create(GLsizeiptr size) {
+    if (buffer.handle != 0) {
+        return;
+    }
+
+    buffer.Create();
+    glBindBuffer(target, buffer.handle);
+    glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+    buffer_size = size;
+    buffer_pos = 0;
+}
+
+void OGLStreamBuffer::Release() {
+    buffer.Release();
+    buffer_size = 0;
+    buffer_pos = 0;
+}
+
+std::tuple<u8*, GLintptr, bool> OGLStreamBuffer::Map(GLsizeiptr size, GLintptr alignment) {
+    ASSERT_MSG(mapped_size == 0, "Stream buffer is already mapped");
+
+    if (size > buffer_size) {
+        return std::make_tuple(nullptr, 0, false);
+    }
+
+    if (alignment > 0) {
+        buffer_pos = (buffer_pos + alignment - 1) / alignment * alignment;
+    }
+
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    const bool orphaned = buffer_pos + size > buffer_size;
+    if (orphaned) {
+        // Wrap around and let the driver orphan the old storage instead of waiting for the GPU
+        buffer_pos = 0;
+        access |= GL_MAP_INVALIDATE_BUFFER_BIT;
+    } else {
+        access |= GL_MAP_INVALIDATE_RANGE_BIT;
+    }
+
+    glBindBuffer(target, buffer.handle);
+    u8* pointer = static_cast<u8*>(glMapBufferRange(target, buffer_pos, size, access));
+    if (pointer == nullptr) {
+        return std::make_tuple(nullptr, 0, orphaned);
+    }
+
+    mapped_size = size;
+    return std::make_tuple(pointer, buffer_pos, orphaned);
+}
+
+void OGLStreamBuffer::Unmap(GLsizeiptr used_size) {
+    ASSERT_MSG(used_size <= mapped_size, "Committing more data than was mapped");
+
+    // Other code may have bound a different buffer to the target since the mapping was made
+    glBindBuffer(target, buffer.handle);
+    if (used_size > 0) {
+        glFlushMappedBufferRange(target, 0, used_size);
+    }
+    glUnmapBuffer(target);
+
+    buffer_pos += used_size;
+    mapped_size = 0;
+}
@@ -0,0 +1,54 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <tuple>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+/**
+ * Ring buffer for streaming data to the GPU. Each mapping is placed after the previous one without
+ * synchronizing with the GPU; once the end of the buffer is reached, its storage is orphaned so
+ * that the driver can hand out fresh memory while earlier commands are still reading the old one.
+ */
+class OGLStreamBuffer : private NonCopyable {
+public:
+    explicit OGLStreamBuffer(GLenum target);
+    ~OGLStreamBuffer();
+
+    /// Creates the underlying buffer object with the given size in bytes
+    void Create(GLsizeiptr size);
+
+    /// Deletes the underlying buffer object
+    void Release();
+
+    GLuint GetHandle() const {
+        return buffer.handle;
+    }
+
+    GLsizeiptr GetSize() const {
+        return buffer_size;
+    }
+
+    /**
+     * Binds the buffer to its target and maps the next `size` bytes of it for writing.
+     * @param alignment Required alignment of the returned buffer offset
+     * @returns Pointer to the mapped memory and its offset within the buffer, or a null pointer if
+     *          the request doesn't fit in the buffer at all, and whether the buffer storage was
+     *          orphaned, discarding the data of all earlier mappings
+     */
+    std::tuple<u8*, GLintptr, bool> Map(GLsizeiptr size, GLintptr alignment);
+
+    /// Unmaps the buffer, committing the first `used_size` bytes of the last mapping
+    void Unmap(GLsizeiptr used_size);
+
+private:
+    GLenum target;
+    OGLBuffer buffer;
+    GLsizeiptr buffer_size = 0;
+    GLintptr buffer_pos = 0;
+    GLsizeiptr mapped_size = 0;
+};
@@ -0,0 +1,73 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "video_core/renderer_opengl/gl_rasterizer_cache.h"
+#include "video_core/renderer_opengl/gl_surface_index.h"
+
+void SurfacePageIndex::Add(CachedSurface* surface) {
+    if (surface->size == 0) {
+        return;
+    }
+
+    const u32 first_page = surface->addr >> PAGE_BITS;
+    const u32 last_page = (surface->addr + surface->size - 1) >> PAGE_BITS;
+    for (u32 page = first_page; page <= last_page; ++page) {
+        pages[page].push_back(surface);
+    }
+}
+
+void SurfacePageIndex::Remove(CachedSurface* surface) {
+    if (surface->size == 0) {
+        return;
+    }
+
+    const u32 first_page = surface->addr >> PAGE_BITS;
+    const u32 last_page = (surface->addr + surface->size - 1) >> PAGE_BITS;
+    for (u32 page = first_page; page <= last_page; ++page) {
+        auto bucket = pages.find(page);
+        if (bucket == pages.end()) {
+            continue;
+        }
+
+        // Order within a bucket is irrelevant, so swap-and-pop instead of shifting elements. Empty
+        // buckets are kept around so that re-populating a page doesn't allocate again.
+        std::vector<CachedSurface*>& surfaces = bucket->second;
+        auto it = std::find(surfaces.begin(), surfaces.end(), surface);
+        if (it != surfaces.end()) {
+            *it = surfaces.back();
+            surfaces.pop_back();
+        }
+    }
+}
+
+void SurfacePageIndex::GetOverlapping(PAddr addr, u32 size, std::vector<CachedSurface*>& out) {
+    if (size == 0) {
+        return;
+    }
+
+    const u64 lookup_generation = NextGeneration();
+    const PAddr end = addr + size;
+
+    const u32 first_page = addr >> PAGE_BITS;
+    const u32 last_page = (end - 1) >> PAGE_BITS;
+    for (u32 page = first_page; page <= last_page; ++page) {
+        auto bucket = pages.find(page);
+        if (bucket == pages.end()) {
+            continue;
+        }
+
+        for (CachedSurface* surface : bucket->second) {
+            if (surface->index_generation == lookup_generation) {
+                continue;
+            }
+
+            // Page granularity is coarser than the surfaces themselves, so do an exact test too
+            if (surface->addr < end && addr < surface->addr + surface->size) {
+                surface->index_generation = lookup_generation;
+                out.push_back(surface);
+            }
+        }
+    }
+}
@@ -0,0 +1,44 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+
+struct CachedSurface;
+
+/**
+ * Spatial index of cached surfaces, bucketed by 4 KiB physical page. Each page holds a flat list
+ * of the surfaces overlapping it, so looking up the surfaces touching a region only needs to visit
+ * the pages the region spans. A generation counter stamped onto each visited surface removes
+ * duplicates without any temporary set allocation.
+ */
+class SurfacePageIndex : NonCopyable {
+public:
+    static constexpr u32 PAGE_BITS = 12;
+
+    /// Adds a surface to every page its address range overlaps
+    void Add(CachedSurface* surface);
+
+    /// Removes a surface previously registered with Add
+    void Remove(CachedSurface* surface);
+
+    /**
+     * Appends every unique surface overlapping [addr, addr + size) to `out`. The vector is not
+     * cleared beforehand, allowing callers to reuse its storage between lookups.
+     */
+    void GetOverlapping(PAddr addr, u32 size, std::vector<CachedSurface*>& out);
+
+    /// Returns a new generation number to be used for deduplicating a surface lookup
+    u64 NextGeneration() {
+        return ++generation;
+    }
+
+private:
+    std::unordered_map<u32, std::vector<CachedSurface*>> pages;
+    u64 generation = 0;
+};
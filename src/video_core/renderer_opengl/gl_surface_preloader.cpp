@@ -0,0 +1,81 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include "common/microprofile.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_surface_preloader.h"
+
+SurfacePreloader::SurfacePreloader(std::unique_ptr<EmuWindow::GraphicsContext> context)
+    : context(std::move(context)) {
+    worker = std::thread(&SurfacePreloader::WorkerLoop, this);
+}
+
+SurfacePreloader::~SurfacePreloader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    job_available.notify_one();
+    worker.join();
+
+    // The contexts share their objects, so textures nobody collected are freed along with the
+    // results from here
+    results.clear();
+}
+
+void SurfacePreloader::Queue(u64 id, std::vector<u8> data, LoadFunction load) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({id, std::move(data), std::move(load)});
+    }
+    job_available.notify_one();
+}
+
+std::vector<SurfacePreloader::Result> SurfacePreloader::Collect() {
+    std::vector<Result> finished;
+    std::lock_guard<std::mutex> lock(mutex);
+    finished.swap(results);
+    return finished;
+}
+
+void SurfacePreloader::WorkerLoop() {
+    MicroProfileOnThreadCreate("SurfacePreloader");
+    context->MakeCurrent();
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_available.wait(lock, [this] { return stop || !jobs.empty(); });
+            if (stop) {
+                break;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        OGLTexture texture;
+        texture.Create();
+
+        // The state tracker is per thread, so this binding doesn't disturb the rasterizer's
+        OpenGLState state = OpenGLState::GetCurState();
+        state.texture_units[0].texture_2d = texture.handle;
+        state.Apply();
+        glActiveTexture(GL_TEXTURE0);
+
+        job.load(texture.handle, job.data.data());
+
+        state.texture_units[0].texture_2d = 0;
+        state.Apply();
+
+        // Objects only become visible to the other contexts once their commands completed
+        glFinish();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back({job.id, std::move(texture)});
+    }
+
+    context->DoneCurrent();
+}
@@ -0,0 +1,63 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+/**
+ * Loads surface textures on a worker thread, using a context that shares its objects with the
+ * rasterizer's. The data is a snapshot of emulated memory taken when the load was queued, so the
+ * cache has to check that memory still holds the same data before using a finished texture.
+ */
+class SurfacePreloader : NonCopyable {
+public:
+    /// Fills the texture, which is bound to GL_TEXTURE_2D on unit 0, from the snapshot of memory
+    using LoadFunction = std::function<void(GLuint texture, u8* data)>;
+
+    /// Texture handed back by the worker, already filled and ready for use on any shared context
+    struct Result {
+        u64 id;
+        OGLTexture texture;
+    };
+
+    explicit SurfacePreloader(std::unique_ptr<EmuWindow::GraphicsContext> context);
+    ~SurfacePreloader();
+
+    /// Queues a texture to be loaded from the given data, identified by `id` in the results
+    void Queue(u64 id, std::vector<u8> data, LoadFunction load);
+
+    /// Takes the textures finished since the last call
+    std::vector<Result> Collect();
+
+private:
+    struct Job {
+        u64 id;
+        std::vector<u8> data;
+        LoadFunction load;
+    };
+
+    void WorkerLoop();
+
+    std::unique_ptr<EmuWindow::GraphicsContext> context;
+
+    std::mutex mutex;
+    std::condition_variable job_available;
+    std::deque<Job> jobs;
+    std::vector<Result> results;
+    bool stop = false;
+
+    std::thread worker;
+};
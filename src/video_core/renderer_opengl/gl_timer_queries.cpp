@@ -0,0 +1,134 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_timer_queries.h"
+
+namespace GLTimerQueries {
+
+/// Scopes stop being measured while this many wait to be read back, which only happens if the
+/// results somehow stop arriving
+constexpr size_t MAX_PENDING_QUERIES = 16384;
+
+/// Number of shader configurations with the most draw time logged on shutdown
+constexpr size_t NUM_LOGGED_SHADERS = 16;
+
+struct PendingQuery {
+    GLuint begin_query;
+    GLuint end_query;
+    Core::PerfStats::GPUCategory category;
+    u64 shader_hash;
+};
+
+static bool enabled = false;
+/// Queries belong to the context they were made in, so only scopes on this thread are measured
+static std::thread::id owner_thread;
+static std::vector<GLuint> free_queries;
+/// Measured scopes in submission order, which is also the order their results arrive in
+static std::deque<PendingQuery> pending_queries;
+/// Draw time in nanoseconds per hash of the shader configuration
+static std::unordered_map<u64, u64> shader_time_ns;
+
+static GLuint AllocateQuery() {
+    if (free_queries.empty()) {
+        GLuint query;
+        glGenQueries(1, &query);
+        return query;
+    }
+    const GLuint query = free_queries.back();
+    free_queries.pop_back();
+    return query;
+}
+
+static void LogShaderTimes() {
+    std::vector<std::pair<u64, u64>> sorted(shader_time_ns.begin(), shader_time_ns.end());
+    const size_t count = std::min(sorted.size(), NUM_LOGGED_SHADERS);
+    std::partial_sort(sorted.begin(), sorted.begin() + count, sorted.end(),
+                      [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    LOG_INFO(Render_OpenGL, "GPU draw time of the %zu most expensive of %zu shaders:", count,
+             sorted.size());
+    for (size_t i = 0; i < count; ++i) {
+        LOG_INFO(Render_OpenGL, "  %016llX: %.3f ms",
+                 static_cast<unsigned long long>(sorted[i].first), sorted[i].second / 1e6);
+    }
+}
+
+void Init() {
+    enabled = Settings::values.use_gpu_timer_queries;
+    owner_thread = std::this_thread::get_id();
+}
+
+void Shutdown() {
+    if (enabled && !shader_time_ns.empty())
+        LogShaderTimes();
+
+    for (const PendingQuery& query : pending_queries) {
+        free_queries.push_back(query.begin_query);
+        free_queries.push_back(query.end_query);
+    }
+    if (!free_queries.empty())
+        glDeleteQueries(static_cast<GLsizei>(free_queries.size()), free_queries.data());
+
+    enabled = false;
+    free_queries.clear();
+    pending_queries.clear();
+    shader_time_ns.clear();
+}
+
+void Collect() {
+    auto& perf_stats = Core::System::GetInstance().perf_stats;
+
+    while (!pending_queries.empty()) {
+        const PendingQuery& query = pending_queries.front();
+
+        GLint available;
+        glGetQueryObjectiv(query.end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+            break;
+
+        GLuint64 begin;
+        GLuint64 end;
+        glGetQueryObjectui64v(query.begin_query, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(query.end_query, GL_QUERY_RESULT, &end);
+        const u64 time_ns = end > begin ? end - begin : 0;
+
+        perf_stats.AddGPUCategoryTime(query.category, time_ns);
+        if (query.shader_hash != 0)
+            shader_time_ns[query.shader_hash] += time_ns;
+
+        free_queries.push_back(query.begin_query);
+        free_queries.push_back(query.end_query);
+        pending_queries.pop_front();
+    }
+}
+
+ScopedTimer::ScopedTimer(Core::PerfStats::GPUCategory category, u64 shader_hash)
+    : category(category), shader_hash(shader_hash), begin_query(0) {
+    if (!enabled || std::this_thread::get_id() != owner_thread ||
+        pending_queries.size() >= MAX_PENDING_QUERIES)
+        return;
+
+    begin_query = AllocateQuery();
+    glQueryCounter(begin_query, GL_TIMESTAMP);
+}
+
+ScopedTimer::~ScopedTimer() {
+    if (begin_query == 0)
+        return;
+
+    const GLuint end_query = AllocateQuery();
+    glQueryCounter(end_query, GL_TIMESTAMP);
+    pending_queries.push_back({begin_query, end_query, category, shader_hash});
+}
+
+} // namespace GLTimerQueries
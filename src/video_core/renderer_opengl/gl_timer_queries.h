@@ -0,0 +1,52 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <glad/glad.h>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "core/perf_stats.h"
+
+/**
+ * GPU time measurement with timestamp queries, enabled by Settings. Scopes write a timestamp
+ * before and after the GL commands they enclose, and the results are read back once per frame
+ * without waiting, usually a few frames later, into the GPU categories of the system's PerfStats.
+ * The time of draws is also attributed to the fragment shader configuration they used, which is
+ * logged on shutdown.
+ *
+ * Timestamps rather than GL_TIME_ELAPSED queries are used, as only one of the latter can be
+ * active at a time, while surface uploads and blits happen within draws.
+ *
+ * Queries aren't shared between contexts, so only scopes on the thread that called Init are
+ * measured. When the OpenGL rasterizer lives on the GPU thread, that leaves presentation.
+ */
+namespace GLTimerQueries {
+
+/// Starts measuring if Settings enable it. Requires the renderer's context to be current.
+void Init();
+
+/// Logs the draw time per shader configuration, if measuring, and deletes the queries
+void Shutdown();
+
+/// Adds the results that are available to the stats, to be called once per frame
+void Collect();
+
+/// Measures the GPU time of the GL commands issued within its scope
+class ScopedTimer : NonCopyable {
+public:
+    /**
+     * @param shader_hash Hash of the shader configuration to attribute the time to, 0 for none
+     */
+    explicit ScopedTimer(Core::PerfStats::GPUCategory category, u64 shader_hash = 0);
+    ~ScopedTimer();
+
+private:
+    Core::PerfStats::GPUCategory category;
+    u64 shader_hash;
+    /// Query of the timestamp at the start of the scope, 0 if not measured
+    GLuint begin_query;
+};
+
+} // namespace GLTimerQueries
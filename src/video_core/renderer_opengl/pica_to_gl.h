@@ -50,6 +50,18 @@ inline GLenum TextureFilterMode(Pica::TexturingRegs::TextureConfig::TextureFilte
     return gl_mode;
 }
 
+/// Minification filter of a mipmapped texture, filtering within and between levels as given
+inline GLenum TextureMipFilterMode(Pica::TexturingRegs::TextureConfig::TextureFilter min_filter,
+                                   Pica::TexturingRegs::TextureConfig::TextureFilter mip_filter) {
+    using TextureFilter = Pica::TexturingRegs::TextureConfig::TextureFilter;
+    if (min_filter == TextureFilter::Linear) {
+        return mip_filter == TextureFilter::Linear ? GL_LINEAR_MIPMAP_LINEAR
+                                                   : GL_LINEAR_MIPMAP_NEAREST;
+    }
+    return mip_filter == TextureFilter::Linear ? GL_NEAREST_MIPMAP_LINEAR
+                                               : GL_NEAREST_MIPMAP_NEAREST;
+}
+
 inline GLenum WrapMode(Pica::TexturingRegs::TextureConfig::WrapMode mode) {
     static const GLenum wrap_mode_table[] = {
         GL_CLAMP_TO_EDGE,   // WrapMode::ClampToEdge
@@ -5,11 +5,14 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <tuple>
 #include <glad/glad.h>
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/logging/log.h"
+#include "core/3ds.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/frontend/emu_window.h"
@@ -20,7 +23,9 @@
 #include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_opengl/gl_timer_queries.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
 
@@ -94,68 +99,155 @@ static std::array<GLfloat, 3 * 2> MakeOrthographicMatrix(const float width, cons
     return matrix;
 }
 
-RendererOpenGL::RendererOpenGL() = default;
+/// Size of the framebuffer upload ring, enough for a few frames of both screens in RGBA8
+constexpr GLsizeiptr SCREEN_UPLOAD_BUFFER_SIZE = 4 * 1024 * 1024;
+
+RendererOpenGL::RendererOpenGL() : screen_upload_buffer(GL_PIXEL_UNPACK_BUFFER) {}
 RendererOpenGL::~RendererOpenGL() = default;
 
 /// Swap buffers (render frame)
 void RendererOpenGL::SwapBuffers() {
+    // The last draws of the frame may still be queued
+    RunOnRasterizerThread([this] { rasterizer->DrawTriangles(); });
+
+    const auto present_start = Core::PerfStats::Clock::now();
+
     // Maintain the rasterizer's state as a priority
     OpenGLState prev_state = OpenGLState::GetCurState();
     state.Apply();
 
-    for (int i : {0, 1}) {
-        const auto& framebuffer = GPU::g_regs.framebuffer_config[i];
-
-        // Main LCD (0): 0x1ED02204, Sub LCD (1): 0x1ED02A04
-        u32 lcd_color_addr =
-            (i == 0) ? LCD_REG_INDEX(color_fill_top) : LCD_REG_INDEX(color_fill_bottom);
-        lcd_color_addr = HW::VADDR_LCD + 4 * lcd_color_addr;
-        LCD::Regs::ColorFill color_fill = {0};
-        LCD::Read(color_fill.raw, lcd_color_addr);
-
-        if (color_fill.is_enabled) {
-            LoadColorToActiveGLTexture(color_fill.color_r, color_fill.color_g, color_fill.color_b,
-                                       screen_infos[i].texture);
+    // Frames skipped by frame skipping or turbo mode are neither read from emulated memory nor
+    // drawn
+    const int turbo_frame_skip =
+        Settings::values.turbo ? std::max(Settings::values.turbo_frame_skip, 1) : 1;
+    turbo_frame_counter = (turbo_frame_counter + 1) % turbo_frame_skip;
+    const bool present = !frame_skipped && turbo_frame_counter == 0;
+
+    if (present) {
+        GLTimerQueries::ScopedTimer gpu_timer(Core::PerfStats::GPUCategory::Present);
+
+        for (int i : {0, 1}) {
+            const auto& framebuffer = GPU::g_regs.framebuffer_config[i];
+
+            // Main LCD (0): 0x1ED02204, Sub LCD (1): 0x1ED02A04
+            u32 lcd_color_addr =
+                (i == 0) ? LCD_REG_INDEX(color_fill_top) : LCD_REG_INDEX(color_fill_bottom);
+            lcd_color_addr = HW::VADDR_LCD + 4 * lcd_color_addr;
+            LCD::Regs::ColorFill color_fill = {0};
+            LCD::Read(color_fill.raw, lcd_color_addr);
+
+            if (color_fill.is_enabled) {
+                LoadColorToActiveGLTexture(color_fill.color_r, color_fill.color_g,
+                                           color_fill.color_b, screen_infos[i].texture);
+
+                // Resize the texture in case the framebuffer size has changed
+                screen_infos[i].texture.width = 1;
+                screen_infos[i].texture.height = 1;
+            } else {
+                if (screen_infos[i].texture.width != (GLsizei)framebuffer.width ||
+                    screen_infos[i].texture.height != (GLsizei)framebuffer.height ||
+                    screen_infos[i].texture.format != framebuffer.color_format) {
+                    // Reallocate texture if the framebuffer size has changed.
+                    // This is expected to not happen very often and hence should not be a
+                    // performance problem.
+                    ConfigureFramebufferTexture(screen_infos[i].texture, framebuffer);
+                }
+                LoadFBToScreenInfo(framebuffer, screen_infos[i]);
+
+                // Resize the texture in case the framebuffer size has changed
+                screen_infos[i].texture.width = framebuffer.width;
+                screen_infos[i].texture.height = framebuffer.height;
+            }
+        }
 
-            // Resize the texture in case the framebuffer size has changed
-            screen_infos[i].texture.width = 1;
-            screen_infos[i].texture.height = 1;
+        if (presenter) {
+            // Draw into an offscreen frame for the presentation thread, which waits for vsync
+            // instead
+            const auto layout = render_window->GetFramebufferLayout();
+            auto& frame = presenter->GetRenderFrame(layout.width, layout.height);
+            state.draw.draw_framebuffer = frame.render_framebuffer.handle;
+            state.Apply();
+            DrawScreens(layout);
+            state.draw.draw_framebuffer = 0;
+            state.Apply();
+            presenter->PostFrame(frame);
         } else {
-            if (screen_infos[i].texture.width != (GLsizei)framebuffer.width ||
-                screen_infos[i].texture.height != (GLsizei)framebuffer.height ||
-                screen_infos[i].texture.format != framebuffer.color_format) {
-                // Reallocate texture if the framebuffer size has changed.
-                // This is expected to not happen very often and hence should not be a
-                // performance problem.
-                ConfigureFramebufferTexture(screen_infos[i].texture, framebuffer);
-            }
-            LoadFBToScreenInfo(framebuffer, screen_infos[i]);
+            state.draw.draw_framebuffer = render_window->GetDrawFramebuffer();
+            state.Apply();
+            DrawScreens(render_window->GetFramebufferLayout());
+            state.draw.draw_framebuffer = 0;
+            state.Apply();
+        }
 
-            // Resize the texture in case the framebuffer size has changed
-            screen_infos[i].texture.width = framebuffer.width;
-            screen_infos[i].texture.height = framebuffer.height;
+        if (frame_dumper) {
+            state.draw.draw_framebuffer = frame_dumper->GetFramebuffer();
+            state.Apply();
+            DrawScreens(Layout::DefaultFrameLayout(frame_dumper->GetWidth(),
+                                                   frame_dumper->GetHeight(), false));
+            state.draw.draw_framebuffer = 0;
+            state.Apply();
         }
+        m_current_frame++;
     }
 
-    DrawScreens();
+    // Skipped frames repeat the previous one in the dump, which keeps it in step with the audio
+    if (frame_dumper) {
+        frame_dumper->DumpFrame();
+    }
 
     Core::System::GetInstance().perf_stats.EndSystemFrame();
 
     // Swap buffers
-    render_window->PollEvents();
-    render_window->SwapBuffers();
+    if (present && !presenter) {
+        render_window->SwapBuffers();
+    }
+    GLTimerQueries::Collect();
+
+    Core::System::GetInstance().perf_stats.AddCategoryTime(
+        Core::PerfStats::Category::Present, Core::PerfStats::Clock::now() - present_start);
 
     Core::System::GetInstance().frame_limiter.DoFrameLimiting(CoreTiming::GetGlobalTimeUs());
+    // Input that arrived while the frame limiter waited is then seen by the next frame
+    render_window->PollEvents();
     Core::System::GetInstance().perf_stats.BeginSystemFrame();
 
     prev_state.Apply();
     RefreshRasterizerSetting();
 
+    // Skip the next frame if emulation has fallen behind, but not too many in a row so that the
+    // picture keeps updating
+    const bool behind = Core::System::GetInstance().frame_limiter.IsBehind();
+    frame_skipped = behind && frames_skipped_in_row < Settings::values.frame_skip;
+    frames_skipped_in_row = frame_skipped ? frames_skipped_in_row + 1 : 0;
+    RunOnRasterizerThread([this] { rasterizer->SetFrameSkipped(frame_skipped); });
+
     if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
         Pica::g_debug_context->recorder->FrameFinished();
     }
 }
 
+void RendererOpenGL::RunOnRasterizerThread(const std::function<void()>& work) {
+    const bool other_context = VideoCore::g_gpu_thread != nullptr &&
+                               VideoCore::g_gpu_thread->HasContext() &&
+                               !VideoCore::g_gpu_thread->IsGPUThread();
+    if (!other_context) {
+        VideoCore::RunOnRasterizerThread(work);
+        return;
+    }
+
+    // Surfaces drawn in the GPU thread's context are only safe to sample here once the commands
+    // drawing them have run, which the GPU waits for without blocking either thread
+    GLsync sync = nullptr;
+    VideoCore::RunOnRasterizerThread([&work, &sync] {
+        work();
+        sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // Another context can only wait for a fence that has been flushed
+        glFlush();
+    });
+    glWaitSync(sync, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(sync);
+}
+
 /**
  * Loads framebuffer from emulated memory into the active OpenGL texture.
  */
@@ -179,8 +271,12 @@ void RendererOpenGL::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& fram
     // only allows rows to have a memory alignement of 4.
     ASSERT(pixel_stride % 4 == 0);
 
-    if (!Rasterizer()->AccelerateDisplay(framebuffer, framebuffer_addr,
-                                         static_cast<u32>(pixel_stride), screen_info)) {
+    bool accelerated = false;
+    RunOnRasterizerThread([&] {
+        accelerated = rasterizer->AccelerateDisplay(framebuffer, framebuffer_addr,
+                                                    static_cast<u32>(pixel_stride), screen_info);
+    });
+    if (!accelerated) {
         // Reset the screen info's display texture to its own permanent texture
         screen_info.display_texture = screen_info.texture.resource.handle;
         screen_info.display_texcoords = MathUtil::Rectangle<float>(0.f, 0.f, 1.f, 1.f);
@@ -189,6 +285,22 @@ void RendererOpenGL::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& fram
 
         const u8* framebuffer_data = Memory::GetPhysicalPointer(framebuffer_addr);
 
+        // Stage the framebuffer in the upload ring, so the texture upload is queued instead of
+        // the driver copying from emulated memory, possibly waiting for the GPU first
+        const GLsizeiptr upload_size =
+            framebuffer.stride * (framebuffer.height - 1) + framebuffer.width * bpp;
+        u8* upload_data;
+        GLintptr upload_offset;
+        std::tie(upload_data, upload_offset, std::ignore) =
+            screen_upload_buffer.Map(upload_size, 4);
+        if (upload_data != nullptr) {
+            std::memcpy(upload_data, framebuffer_data, upload_size);
+            screen_upload_buffer.Unmap(upload_size);
+            framebuffer_data = reinterpret_cast<const u8*>(upload_offset);
+        } else {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
         state.texture_units[0].texture_2d = screen_info.texture.resource.handle;
         state.Apply();
 
@@ -205,6 +317,7 @@ void RendererOpenGL::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& fram
                         framebuffer_data);
 
         glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
         state.texture_units[0].texture_2d = 0;
         state.Apply();
@@ -266,6 +379,9 @@ void RendererOpenGL::InitOpenGLObjects() {
     glEnableVertexAttribArray(attrib_position);
     glEnableVertexAttribArray(attrib_tex_coord);
 
+    screen_upload_buffer.Create(SCREEN_UPLOAD_BUFFER_SIZE);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
     // Allocate textures for each screen
     for (auto& screen_info : screen_infos) {
         screen_info.texture.resource.Create();
@@ -377,8 +493,7 @@ void RendererOpenGL::DrawSingleScreenRotated(const ScreenInfo& screen_info, floa
 /**
  * Draws the emulated screens to the emulator window.
  */
-void RendererOpenGL::DrawScreens() {
-    auto layout = render_window->GetFramebufferLayout();
+void RendererOpenGL::DrawScreens(const Layout::FramebufferLayout& layout) {
     const auto& top_screen = layout.top_screen;
     const auto& bottom_screen = layout.bottom_screen;
 
@@ -403,8 +518,6 @@ void RendererOpenGL::DrawScreens() {
                                 (float)bottom_screen.top, (float)bottom_screen.GetWidth(),
                                 (float)bottom_screen.GetHeight());
     }
-
-    m_current_frame++;
 }
 
 /// Updates the framerate
@@ -498,6 +611,24 @@ bool RendererOpenGL::Init() {
     }
 
     InitOpenGLObjects();
+    GLTimerQueries::Init();
+
+    if (Settings::values.use_presentation_thread) {
+        auto context = render_window->CreatePresentationContext();
+        if (context != nullptr) {
+            presenter = std::make_unique<FramePresenterOpenGL>(std::move(context), *render_window);
+        } else {
+            LOG_WARNING(Render_OpenGL, "Frontend can't present from another thread, presenting "
+                                       "from the emulation thread");
+        }
+    }
+
+    if (!Settings::values.frame_dump_path.empty()) {
+        // Both screens at their native resolution, one above the other
+        frame_dumper = std::make_unique<FrameDumperOpenGL>(
+            Settings::values.frame_dump_path, Core::kScreenTopWidth,
+            Core::kScreenTopHeight + Core::kScreenBottomHeight);
+    }
 
     RefreshRasterizerSetting();
 
@@ -505,4 +636,8 @@ bool RendererOpenGL::Init() {
 }
 
 /// Shutdown the renderer
-void RendererOpenGL::ShutDown() {}
+void RendererOpenGL::ShutDown() {
+    GLTimerQueries::Shutdown();
+    presenter.reset();
+    frame_dumper.reset();
+}
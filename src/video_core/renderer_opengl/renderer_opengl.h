@@ -5,13 +5,18 @@
 #pragma once
 
 #include <array>
+#include <functional>
+#include <memory>
 #include <glad/glad.h>
 #include "common/common_types.h"
 #include "common/math_util.h"
 #include "core/hw/gpu.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_opengl/gl_frame_dumper.h"
+#include "video_core/renderer_opengl/gl_frame_presenter.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
 #include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
 
 class EmuWindow;
 
@@ -56,10 +61,14 @@ private:
     void InitOpenGLObjects();
     void ConfigureFramebufferTexture(TextureInfo& texture,
                                      const GPU::Regs::FramebufferConfig& framebuffer);
-    void DrawScreens();
+    void DrawScreens(const Layout::FramebufferLayout& layout);
     void DrawSingleScreenRotated(const ScreenInfo& screen_info, float x, float y, float w, float h);
     void UpdateFramerate();
 
+    // Runs work that uses the rasterizer on its thread, making the renderer's context wait for the
+    // GL commands it issued
+    void RunOnRasterizerThread(const std::function<void()>& work);
+
     // Loads framebuffer from emulated memory into the display information structure
     void LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& framebuffer,
                             ScreenInfo& screen_info);
@@ -74,10 +83,25 @@ private:
     OGLVertexArray vertex_array;
     OGLBuffer vertex_buffer;
     OGLShader shader;
+    /// Ring of pixel buffers that framebuffers read from emulated memory are uploaded through
+    OGLStreamBuffer screen_upload_buffer;
 
     /// Display information for top and bottom screens respectively
     std::array<ScreenInfo, 2> screen_infos;
 
+    /// Presents frames on another thread, or nullptr if this thread swaps the window's buffers
+    std::unique_ptr<FramePresenterOpenGL> presenter;
+    /// Writes the frames to the file set in the settings, or nullptr if they aren't dumped
+    std::unique_ptr<FrameDumperOpenGL> frame_dumper;
+
+    /// Frames since the last presented one in turbo mode
+    int turbo_frame_counter = 0;
+
+    /// Whether the rasterizer drops the draws of the current frame, and how many frames in a row
+    /// have been skipped
+    bool frame_skipped = false;
+    int frames_skipped_in_row = 0;
+
     // Shader uniform location indices
     GLuint uniform_modelview_matrix;
     GLuint uniform_color_texture;
@@ -4,9 +4,13 @@
 
 #include <cmath>
 #include <cstring>
+#include <utility>
 #include "common/bit_set.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "core/core.h"
+#include "core/loader/loader.h"
+#include "core/settings.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs_rasterizer.h"
 #include "video_core/regs_shader.h"
@@ -14,7 +18,9 @@
 #include "video_core/shader/shader_interpreter.h"
 #ifdef ARCHITECTURE_x86_64
 #include "video_core/shader/shader_jit_x64.h"
-#endif // ARCHITECTURE_x86_64
+#elif defined(ARCHITECTURE_ARM64)
+#include "video_core/shader/shader_jit_a64.h"
+#endif
 #include "video_core/video_core.h"
 
 namespace Pica {
@@ -66,6 +72,8 @@ OutputVertex OutputVertex::FromAttributeBuffer(const RasterizerRegs& regs, Attri
     return ret;
 }
 
+UnitState::UnitState(GSEmitter* emitter) : emitter_ptr(emitter) {}
+
 void UnitState::LoadInput(const ShaderRegs& config, const AttributeBuffer& input) {
     const unsigned max_attribute = config.max_input_attribute_index;
 
@@ -82,11 +90,61 @@ void UnitState::WriteOutput(const ShaderRegs& config, AttributeBuffer& output) {
     }
 }
 
+GSEmitter::GSEmitter() {
+    handlers = new Handlers;
+}
+
+GSEmitter::~GSEmitter() {
+    delete handlers;
+}
+
+void GSEmitter::Emit(Math::Vec4<float24> (&output_regs)[16]) {
+    ASSERT(vertex_id < 3);
+
+    unsigned int output_i = 0;
+    for (unsigned int reg : Common::BitSet<u32>(output_mask)) {
+        buffer[vertex_id].attr[output_i++] = output_regs[reg];
+    }
+
+    if (prim_emit) {
+        if (winding) {
+            handlers->winding_setter();
+        }
+        for (const AttributeBuffer& vertex : buffer) {
+            handlers->vertex_handler(vertex);
+        }
+    }
+}
+
+GSUnitState::GSUnitState() : UnitState(&emitter) {}
+
+void GSUnitState::SetVertexHandler(VertexHandler vertex_handler, WindingSetter winding_setter) {
+    emitter.handlers->vertex_handler = std::move(vertex_handler);
+    emitter.handlers->winding_setter = std::move(winding_setter);
+}
+
+void GSUnitState::ConfigOutput(const ShaderRegs& config) {
+    emitter.output_mask = config.output_mask;
+}
+
+void ShaderEngine::RunBatch(const ShaderSetup& setup, const ShaderRegs& config,
+                           const AttributeBuffer* inputs, AttributeBuffer* outputs,
+                           size_t count) const {
+    UnitState state;
+    for (size_t i = 0; i < count; ++i) {
+        state.LoadInput(config, inputs[i]);
+        Run(setup, state);
+        state.WriteOutput(config, outputs[i]);
+    }
+}
+
 MICROPROFILE_DEFINE(GPU_Shader, "GPU", "Shader", MP_RGB(50, 50, 240));
 
 #ifdef ARCHITECTURE_x86_64
 static std::unique_ptr<JitX64Engine> jit_engine;
-#endif // ARCHITECTURE_x86_64
+#elif defined(ARCHITECTURE_ARM64)
+static std::unique_ptr<JitA64Engine> jit_engine;
+#endif
 static InterpreterEngine interpreter_engine;
 
 ShaderEngine* GetEngine() {
@@ -98,17 +156,38 @@ ShaderEngine* GetEngine() {
         }
         return jit_engine.get();
     }
-#endif // ARCHITECTURE_x86_64
+#elif defined(ARCHITECTURE_ARM64)
+    if (VideoCore::g_shader_jit_enabled) {
+        if (jit_engine == nullptr) {
+            jit_engine = std::make_unique<JitA64Engine>();
+        }
+        return jit_engine.get();
+    }
+#endif
 
     return &interpreter_engine;
 }
 
-void Shutdown() {
+void Init() {
 #ifdef ARCHITECTURE_x86_64
-    jit_engine = nullptr;
+    // Start compiling the programs the title used before while it boots
+    if (VideoCore::g_shader_jit_enabled && Settings::values.use_disk_shader_cache) {
+        u64 program_id;
+        if (Core::System::GetInstance().GetAppLoader().ReadProgramId(program_id) ==
+            Loader::ResultStatus::Success) {
+            jit_engine = std::make_unique<JitX64Engine>();
+            jit_engine->LoadDiskCache(program_id);
+        }
+    }
 #endif // ARCHITECTURE_x86_64
 }
 
+void Shutdown() {
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+    jit_engine = nullptr;
+#endif
+}
+
 } // namespace Shader
 
 } // namespace Pica
@@ -6,6 +6,7 @@
 
 #include <array>
 #include <cstddef>
+#include <functional>
 #include <type_traits>
 #include <nihstro/shader_bytecode.h>
 #include "common/assert.h"
@@ -58,6 +59,49 @@ ASSERT_POS(view, RasterizerRegs::VSOutputAttributes::VIEW_X);
 ASSERT_POS(tc2, RasterizerRegs::VSOutputAttributes::TEXCOORD2_U);
 #undef ASSERT_POS
 static_assert(std::is_pod<OutputVertex>::value, "Structure is not POD");
+
+/// Handler type for receiving the vertices emitted by a geometry shader
+using VertexHandler = std::function<void(const AttributeBuffer&)>;
+/// Handler type for signaling that the vertex order of the next triangle is inverted
+using WindingSetter = std::function<void()>;
+
+/// Fields of the `SETEMIT` instruction
+union SetEmitInstruction {
+    u32 hex;
+
+    /// Whether the primitive emitted with this vertex has an inverted vertex order
+    BitField<22, 1, u32> winding;
+    /// Whether `EMIT` completes a primitive with this vertex
+    BitField<23, 1, u32> prim_emit;
+    /// Index of the vertex buffer slot written by the next `EMIT`
+    BitField<24, 2, u32> vertex_id;
+};
+
+/**
+ * Primitive emitting state of the geometry shader unit. `SETEMIT` selects the vertex slot the
+ * following `EMIT` stores the output registers into, and whether that vertex completes a primitive.
+ */
+struct GSEmitter {
+    std::array<AttributeBuffer, 3> buffer;
+    u8 vertex_id;
+    bool prim_emit;
+    bool winding;
+    u32 output_mask;
+
+    // The function objects are kept behind a pointer so that this structure stays standard layout,
+    // which the JIT relies on to access the members with offsetof
+    struct Handlers {
+        VertexHandler vertex_handler;
+        WindingSetter winding_setter;
+    } * handlers;
+
+    GSEmitter();
+    ~GSEmitter();
+
+    /// Implements `EMIT`: stores the output registers to the selected vertex slot
+    void Emit(Math::Vec4<float24> (&output_regs)[16]);
+};
+static_assert(std::is_standard_layout<GSEmitter>::value, "GSEmitter is not standard layout type");
 static_assert(sizeof(OutputVertex) == 24 * sizeof(float), "OutputVertex has invalid size");
 
 /**
@@ -67,6 +111,8 @@ static_assert(sizeof(OutputVertex) == 24 * sizeof(float), "OutputVertex has inva
  * here will make it easier for us to parallelize the shader processing later.
  */
 struct UnitState {
+    explicit UnitState(GSEmitter* emitter = nullptr);
+
     struct Registers {
         // The registers are accessed by the shader JIT using SSE instructions, and are therefore
         // required to be 16-byte aligned.
@@ -82,6 +128,9 @@ struct UnitState {
     // TODO: How many bits do these actually have?
     s32 address_registers[3];
 
+    /// Emitting state of the geometry shader, nullptr when running a vertex shader
+    GSEmitter* emitter_ptr;
+
     static size_t InputOffset(const SourceRegister& reg) {
         switch (reg.GetRegisterType()) {
         case RegisterType::Input:
@@ -125,6 +174,16 @@ struct UnitState {
     void WriteOutput(const ShaderRegs& config, AttributeBuffer& output);
 };
 
+/// State of the shader unit running the geometry shader, which is able to emit primitives
+struct GSUnitState : public UnitState {
+    GSUnitState();
+
+    void SetVertexHandler(VertexHandler vertex_handler, WindingSetter winding_setter);
+    void ConfigOutput(const ShaderRegs& config);
+
+    GSEmitter emitter;
+};
+
 struct ShaderSetup {
     struct {
         // The float uniforms are accessed by the shader JIT using SSE instructions, and are
@@ -153,8 +212,12 @@ struct ShaderSetup {
     /// Data private to ShaderEngines
     struct EngineData {
         unsigned int entry_point;
-        /// Used by the JIT, points to a compiled shader object.
+        /// Used by the JIT, points to a compiled shader object. The interpreter stores its decoded
+        /// program here.
         const void* cached_shader = nullptr;
+        /// Used by the JIT, points to the compiled shader object running several units at once,
+        /// or nullptr if the program at the entry point can't be compiled that way.
+        const void* cached_batch_shader = nullptr;
     } engine_data;
 };
 
@@ -165,8 +228,12 @@ public:
     /**
      * Performs any shader unit setup that only needs to happen once per shader (as opposed to once
      * per vertex, which would happen within the `Run` function).
+     *
+     * @param setup Shader engine state holding the program and uniforms of the following draws.
+     * @param entry_point Offset of the first instruction to execute.
+     * @param output_mask Output registers making up the output vertex, see ShaderRegs.
      */
-    virtual void SetupBatch(ShaderSetup& setup, unsigned int entry_point) = 0;
+    virtual void SetupBatch(ShaderSetup& setup, unsigned int entry_point, u32 output_mask) = 0;
 
     /**
      * Runs the currently setup shader.
@@ -175,10 +242,26 @@ public:
      * @param state Shader unit state, must be setup with input data before each shader invocation.
      */
     virtual void Run(const ShaderSetup& setup, UnitState& state) const = 0;
+
+    /**
+     * Runs the currently setup shader for several vertices. Engines that can shade more than one
+     * vertex per invocation override this, the default implementation runs the vertices one after
+     * another.
+     *
+     * @param setup Shader engine state, must be setup with SetupBatch on each shader change.
+     * @param config Shader configuration registers, used to map attributes to registers.
+     * @param inputs `count` attribute buffers holding the input vertices.
+     * @param outputs `count` attribute buffers receiving the output vertices.
+     * @param count Number of vertices to shade.
+     */
+    virtual void RunBatch(const ShaderSetup& setup, const ShaderRegs& config,
+                          const AttributeBuffer* inputs, AttributeBuffer* outputs,
+                          size_t count) const;
 };
 
 // TODO(yuriks): Remove and make it non-global state somewhere
 ShaderEngine* GetEngine();
+void Init();
 void Shutdown();
 
 } // namespace Shader
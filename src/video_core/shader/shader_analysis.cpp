@@ -0,0 +1,509 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <functional>
+#include <nihstro/shader_bytecode.h>
+#include "video_core/shader/shader_analysis.h"
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::RegisterType;
+using nihstro::SourceRegister;
+using nihstro::SwizzlePattern;
+
+namespace Pica {
+namespace Shader {
+
+namespace {
+
+/// Set of temporary register components, bit `4 * index + component` standing for each of them
+using TemporarySet = u64;
+
+constexpr TemporarySet ALL_TEMPORARIES = ~TemporarySet(0);
+
+/// Offsets execution continues at when the code of a block falls through
+using Positions = std::vector<unsigned>;
+
+/// Where execution continues after an instruction, given the layout of the compiled program
+struct InstructionLayout {
+    /// Instruction completing without branching
+    Positions fallthrough;
+    /// Condition of an IF being true, or a LOOP starting its body
+    Positions block_entry;
+    /// Condition of an IF being false
+    Positions else_entry;
+};
+
+/**
+ * Walks a block the way JitShader::Compile_Block does, returning the offset compiling stops at.
+ * The offsets at which the IF and LOOP instructions encountered stop are stored to `block_ends`.
+ */
+unsigned FindBlockEnds(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code, unsigned pc,
+                       unsigned end, std::vector<unsigned>& block_ends) {
+    while (pc < end) {
+        const unsigned offset = pc++;
+        const Instruction instr = {program_code[offset]};
+        const unsigned dest = instr.flow_control.dest_offset;
+        const unsigned num_instructions = instr.flow_control.num_instructions;
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::IFU:
+        case OpCode::Id::IFC:
+            pc = FindBlockEnds(program_code, pc, dest, block_ends);
+            if (num_instructions != 0) {
+                pc = FindBlockEnds(program_code, pc, dest + num_instructions, block_ends);
+            }
+            block_ends[offset] = pc;
+            break;
+
+        case OpCode::Id::LOOP:
+            pc = FindBlockEnds(program_code, pc, dest + 1, block_ends);
+            block_ends[offset] = pc;
+            break;
+
+        default:
+            break;
+        }
+    }
+    return pc;
+}
+
+/**
+ * Determines where execution continues after each instruction of a block in the compiled code.
+ * @param exits Where execution continues after falling out of the block
+ */
+unsigned LayoutBlock(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code, unsigned pc,
+                     unsigned end, const Positions& exits, const std::vector<unsigned>& block_ends,
+                     std::vector<InstructionLayout>& layout) {
+    auto continue_at = [&](unsigned offset) { return offset < end ? Positions{offset} : exits; };
+
+    while (pc < end) {
+        const unsigned offset = pc++;
+        const Instruction instr = {program_code[offset]};
+        const unsigned dest = instr.flow_control.dest_offset;
+        const unsigned num_instructions = instr.flow_control.num_instructions;
+        InstructionLayout& entry = layout[offset];
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::IFU:
+        case OpCode::Id::IFC: {
+            // Both branches continue after the ELSE block
+            const Positions after = continue_at(block_ends[offset]);
+            entry.block_entry = pc < dest ? Positions{pc} : after;
+            pc = LayoutBlock(program_code, pc, dest, after, block_ends, layout);
+            if (num_instructions != 0) {
+                const unsigned else_end = dest + num_instructions;
+                entry.else_entry = pc < else_end ? Positions{pc} : after;
+                pc = LayoutBlock(program_code, pc, else_end, after, block_ends, layout);
+            } else {
+                entry.else_entry = after;
+            }
+            break;
+        }
+
+        case OpCode::Id::LOOP: {
+            // The end of the body either restarts it or leaves the loop
+            const Positions after = continue_at(block_ends[offset]);
+            if (pc < dest + 1) {
+                Positions body_exits = after;
+                body_exits.push_back(pc);
+                entry.block_entry = {pc};
+                pc = LayoutBlock(program_code, pc, dest + 1, body_exits, block_ends, layout);
+            } else {
+                entry.block_entry = after;
+            }
+            break;
+        }
+
+        default:
+            entry.fallthrough = continue_at(pc);
+            break;
+        }
+    }
+    return pc;
+}
+
+/**
+ * Builds the control flow graph of the code reachable from the entry point of the specialization,
+ * following the layout JitShader compiles the program in. Branches on boolean uniforms the program
+ * isn't specialized for are assumed to go both ways.
+ */
+void BuildControlFlow(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code,
+                      const ShaderSpecialization& specialization,
+                      std::vector<std::vector<unsigned>>& successors,
+                      std::bitset<MAX_PROGRAM_CODE_LENGTH>& reachable) {
+    std::vector<unsigned> block_ends(MAX_PROGRAM_CODE_LENGTH);
+    FindBlockEnds(program_code, 0, MAX_PROGRAM_CODE_LENGTH, block_ends);
+
+    std::vector<InstructionLayout> layout(MAX_PROGRAM_CODE_LENGTH);
+    LayoutBlock(program_code, 0, MAX_PROGRAM_CODE_LENGTH, {}, block_ends, layout);
+
+    successors.assign(MAX_PROGRAM_CODE_LENGTH, std::vector<unsigned>());
+    reachable.reset();
+
+    std::vector<unsigned> pending{specialization.entry_point};
+
+    // Execution reaching an offset without jumping passes the return check placed in front of the
+    // instruction, so it may continue after any CALL returning there as well
+    std::vector<Positions> return_sites(MAX_PROGRAM_CODE_LENGTH);
+    std::vector<std::vector<unsigned>> flows_into(MAX_PROGRAM_CODE_LENGTH);
+
+    auto add_jump = [&](unsigned from, unsigned to) {
+        if (to >= MAX_PROGRAM_CODE_LENGTH) {
+            return;
+        }
+        std::vector<unsigned>& edges = successors[from];
+        if (std::find(edges.begin(), edges.end(), to) == edges.end()) {
+            edges.push_back(to);
+            pending.push_back(to);
+        }
+    };
+
+    std::function<void(unsigned, const Positions&)> add_flow = [&](unsigned from,
+                                                                  const Positions& targets) {
+        for (unsigned to : targets) {
+            if (to >= MAX_PROGRAM_CODE_LENGTH) {
+                continue;
+            }
+            std::vector<unsigned>& sources = flows_into[to];
+            if (std::find(sources.begin(), sources.end(), from) != sources.end()) {
+                continue;
+            }
+            sources.push_back(from);
+            add_jump(from, to);
+            add_flow(from, return_sites[to]);
+        }
+    };
+
+    auto add_call = [&](unsigned from, unsigned dest, unsigned return_offset) {
+        add_jump(from, dest);
+        if (return_offset >= MAX_PROGRAM_CODE_LENGTH) {
+            return;
+        }
+        for (unsigned site : layout[from].fallthrough) {
+            Positions& sites = return_sites[return_offset];
+            if (std::find(sites.begin(), sites.end(), site) != sites.end()) {
+                continue;
+            }
+            sites.push_back(site);
+            const std::vector<unsigned> returning = flows_into[return_offset];
+            for (unsigned offset : returning) {
+                add_flow(offset, {site});
+            }
+        }
+    };
+
+    while (!pending.empty()) {
+        const unsigned offset = pending.back();
+        pending.pop_back();
+        if (reachable[offset]) {
+            continue;
+        }
+        reachable[offset] = true;
+
+        const Instruction instr = {program_code[offset]};
+        const InstructionLayout& entry = layout[offset];
+        const unsigned dest = instr.flow_control.dest_offset;
+        const unsigned return_offset = dest + instr.flow_control.num_instructions;
+
+        // Returns whether the boolean uniform of the instruction may have the given value
+        auto uniform_may_be = [&](bool value) {
+            const unsigned index = instr.flow_control.bool_uniform_id;
+            return !specialization.IsBoolUniformKnown(index) ||
+                   specialization.GetBoolUniform(index) == value;
+        };
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::END:
+            break;
+
+        case OpCode::Id::JMPC:
+            add_jump(offset, dest);
+            add_flow(offset, entry.fallthrough);
+            break;
+
+        case OpCode::Id::JMPU: {
+            // The lowest bit of num_instructions inverts the condition
+            const bool inverted = instr.flow_control.num_instructions & 1;
+            if (uniform_may_be(!inverted)) {
+                add_jump(offset, dest);
+            }
+            if (uniform_may_be(inverted)) {
+                add_flow(offset, entry.fallthrough);
+            }
+            break;
+        }
+
+        case OpCode::Id::CALL:
+            add_call(offset, dest, return_offset);
+            break;
+
+        case OpCode::Id::CALLC:
+            add_call(offset, dest, return_offset);
+            add_flow(offset, entry.fallthrough);
+            break;
+
+        case OpCode::Id::CALLU:
+            if (uniform_may_be(true)) {
+                add_call(offset, dest, return_offset);
+            }
+            if (uniform_may_be(false)) {
+                add_flow(offset, entry.fallthrough);
+            }
+            break;
+
+        case OpCode::Id::IFU:
+        case OpCode::Id::IFC: {
+            const bool is_ifu = instr.opcode.Value() == OpCode::Id::IFU;
+            if (!is_ifu || uniform_may_be(true)) {
+                add_flow(offset, entry.block_entry);
+            }
+            if (!is_ifu || uniform_may_be(false)) {
+                add_flow(offset, entry.else_entry);
+            }
+            break;
+        }
+
+        case OpCode::Id::LOOP:
+            add_flow(offset, entry.block_entry);
+            break;
+
+        default:
+            // This includes BREAK and BREAKC, which the JIT doesn't implement
+            add_flow(offset, entry.fallthrough);
+            break;
+        }
+    }
+}
+
+bool IsMad(Instruction instr) {
+    return instr.opcode.Value().GetInfo().type == OpCode::Type::MultiplyAdd;
+}
+
+/// Returns whether each destination component of the operation only reads the same source component
+bool IsComponentWise(OpCode::Id opcode) {
+    switch (opcode) {
+    case OpCode::Id::ADD:
+    case OpCode::Id::MUL:
+    case OpCode::Id::SGE:
+    case OpCode::Id::SGEI:
+    case OpCode::Id::SLT:
+    case OpCode::Id::SLTI:
+    case OpCode::Id::FLR:
+    case OpCode::Id::MAX:
+    case OpCode::Id::MIN:
+    case OpCode::Id::MOV:
+    case OpCode::Id::MAD:
+    case OpCode::Id::MADI:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// Returns whether the operation has no effect other than writing its destination register
+bool OnlyWritesDest(OpCode::Id opcode) {
+    return opcode != OpCode::Id::MOVA && opcode != OpCode::Id::CMP;
+}
+
+/// Returns whether the arithmetic operation reads its second source register
+bool ReadsSrc2(OpCode::Id opcode) {
+    switch (opcode) {
+    case OpCode::Id::EX2:
+    case OpCode::Id::LG2:
+    case OpCode::Id::FLR:
+    case OpCode::Id::RCP:
+    case OpCode::Id::RSQ:
+    case OpCode::Id::MOVA:
+    case OpCode::Id::MOV:
+        return false;
+    default:
+        return true;
+    }
+}
+
+/**
+ * Returns the temporary register components read through a source operand.
+ * @param src_num Number of the source operand (1 = src1, 2 = src2, 3 = src3)
+ * @param components Mask of the operand components the instruction uses
+ * @param relative Whether the operand is addressed relative to an address register
+ */
+TemporarySet ReadTemporaries(SourceRegister src_reg, const SwizzlePattern& swizzle,
+                             unsigned src_num, unsigned components, bool relative) {
+    // The JIT applies address offsets to the register file the operand points into, so only
+    // uniforms are known to stay out of the temporaries
+    if (relative && src_reg.GetRegisterType() != RegisterType::FloatUniform) {
+        return ALL_TEMPORARIES;
+    }
+    if (src_reg.GetRegisterType() != RegisterType::Temporary) {
+        return 0;
+    }
+
+    TemporarySet read = 0;
+    for (unsigned component = 0; component < 4; ++component) {
+        if (((components >> component) & 1) == 0) {
+            continue;
+        }
+        const SwizzlePattern::Selector selector =
+            src_num == 1 ? swizzle.GetSelectorSrc1(component)
+                         : src_num == 2 ? swizzle.GetSelectorSrc2(component)
+                                        : swizzle.GetSelectorSrc3(component);
+        read |= TemporarySet(1) << static_cast<unsigned>(selector);
+    }
+    return read << (4 * src_reg.GetIndex());
+}
+
+/// Register accesses of a single instruction, as far as the liveness analysis is concerned
+struct InstructionEffects {
+    /// Temporary register components read by the instruction
+    TemporarySet reads = 0;
+    /// Temporary register components overwritten by the instruction
+    TemporarySet writes = 0;
+    /// Whether the instruction can be dropped if none of `writes` is read later on
+    bool removable = false;
+    /// Whether the instruction can be dropped regardless, because it only writes unused outputs
+    bool always_dead = false;
+};
+
+InstructionEffects GetEffects(Instruction instr,
+                              const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data,
+                              u32 output_mask) {
+    InstructionEffects effects;
+
+    const OpCode::Type type = instr.opcode.Value().GetInfo().type;
+    if (type != OpCode::Type::Arithmetic && type != OpCode::Type::MultiplyAdd) {
+        return effects;
+    }
+
+    const bool is_mad = IsMad(instr);
+    const OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+    const unsigned operand_desc_id =
+        is_mad ? instr.mad.operand_desc_id.Value() : instr.common.operand_desc_id.Value();
+    const SwizzlePattern swizzle = {swizzle_data[operand_desc_id]};
+
+    unsigned dest_components = 0;
+    for (unsigned component = 0; component < 4; ++component) {
+        if (swizzle.DestComponentEnabled(component)) {
+            dest_components |= 1 << component;
+        }
+    }
+    const unsigned src_components = IsComponentWise(opcode) ? dest_components : 0xF;
+
+    if (is_mad) {
+        const bool is_inverted = opcode == OpCode::Id::MADI;
+        const bool relative = instr.mad.address_register_index != 0;
+        effects.reads =
+            ReadTemporaries(instr.mad.GetSrc1(is_inverted), swizzle, 1, src_components, false) |
+            ReadTemporaries(instr.mad.GetSrc2(is_inverted), swizzle, 2, src_components,
+                            relative && !is_inverted) |
+            ReadTemporaries(instr.mad.GetSrc3(is_inverted), swizzle, 3, src_components,
+                            relative && is_inverted);
+    } else {
+        const bool is_inverted =
+            0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed);
+        const bool relative = instr.common.address_register_index != 0;
+        effects.reads = ReadTemporaries(instr.common.GetSrc1(is_inverted), swizzle, 1,
+                                        src_components, relative && !is_inverted);
+        if (ReadsSrc2(opcode)) {
+            effects.reads |= ReadTemporaries(instr.common.GetSrc2(is_inverted), swizzle, 2,
+                                             src_components, relative && is_inverted);
+        }
+    }
+
+    if (!OnlyWritesDest(opcode)) {
+        return effects;
+    }
+
+    const DestRegister dest = is_mad ? instr.mad.dest.Value() : instr.common.dest.Value();
+    if (dest.GetRegisterType() == RegisterType::Temporary) {
+        effects.writes = TemporarySet(dest_components) << (4 * dest.GetIndex());
+        effects.removable = true;
+    } else if (dest.GetRegisterType() == RegisterType::Output) {
+        effects.always_dead = ((output_mask >> dest.GetIndex()) & 1) == 0;
+        effects.removable = effects.always_dead;
+    }
+    return effects;
+}
+
+} // Anonymous namespace
+
+BranchUniforms FindBranchUniforms(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code,
+                                  unsigned entry_point) {
+    ShaderSpecialization unspecialized{};
+    unspecialized.entry_point = entry_point;
+
+    std::vector<std::vector<unsigned>> successors;
+    std::bitset<MAX_PROGRAM_CODE_LENGTH> reachable;
+    BuildControlFlow(program_code, unspecialized, successors, reachable);
+
+    BranchUniforms uniforms{};
+    for (unsigned offset = 0; offset < MAX_PROGRAM_CODE_LENGTH; ++offset) {
+        if (!reachable[offset]) {
+            continue;
+        }
+
+        const Instruction instr = {program_code[offset]};
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::IFU:
+        case OpCode::Id::CALLU:
+        case OpCode::Id::JMPU:
+            uniforms.bool_uniform_mask |= 1u << instr.flow_control.bool_uniform_id;
+            break;
+        case OpCode::Id::LOOP:
+            uniforms.int_uniform_mask |= 1u << instr.flow_control.int_uniform_id;
+            break;
+        default:
+            break;
+        }
+    }
+    return uniforms;
+}
+
+ProgramAnalysis::ProgramAnalysis(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code,
+                                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data,
+                                 const ShaderSpecialization& specialization) {
+    BuildControlFlow(program_code, specialization, successors, reachable);
+
+    std::vector<unsigned> offsets;
+    std::vector<InstructionEffects> effects(MAX_PROGRAM_CODE_LENGTH);
+    for (unsigned offset = 0; offset < MAX_PROGRAM_CODE_LENGTH; ++offset) {
+        if (reachable[offset]) {
+            offsets.push_back(offset);
+            effects[offset] =
+                GetEffects({program_code[offset]}, swizzle_data, specialization.output_mask);
+        }
+    }
+
+    // Backwards liveness analysis of the temporaries, iterated until nothing changes anymore.
+    // Dead instructions don't make their sources live, so chains of dead writes are found too.
+    std::vector<TemporarySet> live_in(MAX_PROGRAM_CODE_LENGTH, 0);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = offsets.rbegin(); it != offsets.rend(); ++it) {
+            const unsigned offset = *it;
+            const InstructionEffects& effect = effects[offset];
+
+            TemporarySet live_out = 0;
+            for (unsigned successor : successors[offset]) {
+                live_out |= live_in[successor];
+            }
+
+            const bool is_dead =
+                effect.removable && (effect.always_dead || (effect.writes & live_out) == 0);
+            dead[offset] = is_dead;
+
+            const TemporarySet live =
+                is_dead ? live_out : effect.reads | (live_out & ~effect.writes);
+            if (live != live_in[offset]) {
+                live_in[offset] = live;
+                changed = true;
+            }
+        }
+    }
+}
+
+} // namespace Shader
+} // namespace Pica
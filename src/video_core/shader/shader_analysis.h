@@ -0,0 +1,107 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica {
+namespace Shader {
+
+/**
+ * Draw state a program is compiled for. Branches on the boolean uniforms in `bool_uniform_mask`
+ * are resolved and loops over the integer uniforms in `int_uniform_mask` get their iteration
+ * counts at compile time, while writes to the output registers missing from `output_mask` are
+ * dropped. The compiled code may therefore only be run while this state is current.
+ */
+struct ShaderSpecialization {
+    u32 entry_point;
+    /// Output registers written to the output vertex, see ShaderRegs::output_mask
+    u32 output_mask;
+    /// Boolean uniforms the program is specialized for
+    u32 bool_uniform_mask;
+    /// Values of the boolean uniforms in `bool_uniform_mask`, one bit per uniform
+    u32 bool_uniforms;
+    /// Integer uniforms the program is specialized for
+    u32 int_uniform_mask;
+    /// Values of the integer uniforms in `int_uniform_mask`, in the layout of the uniform memory
+    std::array<u32, 4> int_uniforms;
+
+    /// Returns whether the program is specialized for the given boolean uniform
+    bool IsBoolUniformKnown(unsigned index) const {
+        return (bool_uniform_mask >> index) & 1;
+    }
+
+    /// Returns the value of the given boolean uniform, only meaningful if it is known
+    bool GetBoolUniform(unsigned index) const {
+        return (bool_uniforms >> index) & 1;
+    }
+
+    /// Returns whether the program is specialized for the given integer uniform
+    bool IsIntUniformKnown(unsigned index) const {
+        return (int_uniform_mask >> index) & 1;
+    }
+
+    /// Returns the value of the given integer uniform, only meaningful if it is known
+    u32 GetIntUniform(unsigned index) const {
+        return int_uniforms[index];
+    }
+};
+
+/// Uniforms the control flow of a program depends on, one bit per uniform
+struct BranchUniforms {
+    u32 bool_uniform_mask;
+    u32 int_uniform_mask;
+};
+
+/**
+ * Returns the boolean uniforms tested by the `IFU`, `CALLU` and `JMPU` instructions, and the
+ * integer uniforms controlling the `LOOP` instructions, reachable from the entry point. These are
+ * the uniforms a program needs to be specialized for to resolve all of its uniform control flow.
+ */
+BranchUniforms FindBranchUniforms(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code,
+                                  unsigned entry_point);
+
+/**
+ * Control flow and liveness analysis of a specialized shader program. The control flow graph
+ * follows uniform branches the way the specialization resolves them, and models the layout
+ * JitShader compiles blocks in, so it only describes the behavior of that backend. On top of it,
+ * every instruction writing nothing but temporary components overwritten before they are read, or
+ * output registers that aren't part of the output vertex, is marked as dead.
+ */
+class ProgramAnalysis {
+public:
+    ProgramAnalysis(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code,
+                    const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data,
+                    const ShaderSpecialization& specialization);
+
+    /// Returns whether the instruction at the given offset can be executed at all
+    bool IsReachable(unsigned offset) const {
+        return reachable[offset];
+    }
+
+    /// Returns whether the instruction at the given offset can be left out without any effect
+    bool IsDead(unsigned offset) const {
+        return dead[offset];
+    }
+
+    /// Returns the number of instructions that can be executed
+    unsigned NumReachable() const {
+        return static_cast<unsigned>(reachable.count());
+    }
+
+private:
+    /// Offsets execution can continue at after each reachable instruction
+    std::vector<std::vector<unsigned>> successors;
+
+    std::bitset<MAX_PROGRAM_CODE_LENGTH> reachable;
+    std::bitset<MAX_PROGRAM_CODE_LENGTH> dead;
+};
+
+} // namespace Shader
+} // namespace Pica
@@ -5,12 +5,14 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <memory>
 #include <numeric>
 #include <boost/container/static_vector.hpp>
 #include <boost/range/algorithm/fill.hpp>
 #include <nihstro/shader_bytecode.h>
 #include "common/assert.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/vector_math.h"
@@ -20,6 +22,7 @@
 #include "video_core/shader/shader_interpreter.h"
 
 using nihstro::OpCode;
+using nihstro::DestRegister;
 using nihstro::Instruction;
 using nihstro::RegisterType;
 using nihstro::SourceRegister;
@@ -38,9 +41,177 @@ struct CallStackElement {
     u32 loop_address;   // The address where we'll return to after each loop iteration
 };
 
+/// Register file a source operand of a decoded instruction is read from
+enum class SourceFile : u8 {
+    Input,
+    Temporary,
+    FloatUniform,
+    Dummy, ///< Placeholder for invalid source registers
+};
+
+/// Register file a decoded instruction writes its result to
+enum class DestFile : u8 {
+    Output,
+    Temporary,
+    Dummy, ///< Placeholder for invalid destination registers
+};
+
+struct DecodedSource {
+    /// Register as encoded in the instruction, only looked up at runtime if the operand is
+    /// addressed relative to an address register
+    SourceRegister reg;
+    bool relative;
+    bool negate;
+    SourceFile file;
+    u8 index;
+    std::array<u8, 4> selector;
+};
+
+/// Shader instruction with its operands and swizzle pattern already resolved
+struct DecodedInstruction {
+    Instruction instr;
+    OpCode::Type type;
+    /// Effective opcode of arithmetic and multiply-add instructions, raw opcode otherwise
+    OpCode::Id opcode;
+    /// Bit i is set if component i of the destination is written
+    u8 dest_mask;
+    u8 address_register_index;
+    DestFile dest_file;
+    u8 dest_index;
+    std::array<DecodedSource, 3> src;
+};
+
+/**
+ * Shader program translated once for the interpreter, so that running it doesn't need to decode
+ * instruction and swizzle bitfields for every vertex.
+ */
+struct DecodedProgram {
+    std::array<DecodedInstruction, MAX_PROGRAM_CODE_LENGTH> code;
+};
+
+static DecodedSource DecodeSource(SourceRegister reg, bool relative, const SwizzlePattern& swizzle,
+                                  unsigned src_num) {
+    DecodedSource source;
+    source.reg = reg;
+    source.relative = relative;
+
+    switch (reg.GetRegisterType()) {
+    case RegisterType::Input:
+        source.file = SourceFile::Input;
+        source.index = static_cast<u8>(reg.GetIndex());
+        break;
+    case RegisterType::Temporary:
+        source.file = SourceFile::Temporary;
+        source.index = static_cast<u8>(reg.GetIndex());
+        break;
+    case RegisterType::FloatUniform:
+        source.file = SourceFile::FloatUniform;
+        source.index = static_cast<u8>(reg.GetIndex());
+        break;
+    default:
+        source.file = SourceFile::Dummy;
+        source.index = 0;
+        break;
+    }
+
+    switch (src_num) {
+    case 1:
+        source.negate = swizzle.negate_src1 != 0;
+        for (int i = 0; i < 4; ++i)
+            source.selector[i] = static_cast<u8>(swizzle.GetSelectorSrc1(i));
+        break;
+    case 2:
+        source.negate = swizzle.negate_src2 != 0;
+        for (int i = 0; i < 4; ++i)
+            source.selector[i] = static_cast<u8>(swizzle.GetSelectorSrc2(i));
+        break;
+    default:
+        source.negate = swizzle.negate_src3 != 0;
+        for (int i = 0; i < 4; ++i)
+            source.selector[i] = static_cast<u8>(swizzle.GetSelectorSrc3(i));
+        break;
+    }
+    return source;
+}
+
+static void DecodeDest(DestRegister reg, DecodedInstruction& decoded) {
+    if (reg < 0x10) {
+        decoded.dest_file = DestFile::Output;
+        decoded.dest_index = static_cast<u8>(reg.GetIndex());
+    } else if (reg < 0x20) {
+        decoded.dest_file = DestFile::Temporary;
+        decoded.dest_index = static_cast<u8>(reg.GetIndex());
+    } else {
+        decoded.dest_file = DestFile::Dummy;
+        decoded.dest_index = 0;
+    }
+}
+
+static DecodedInstruction DecodeInstruction(
+    Instruction instr, const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data) {
+    DecodedInstruction decoded = {};
+    decoded.instr = instr;
+    decoded.type = instr.opcode.Value().GetInfo().type;
+    decoded.opcode = instr.opcode.Value();
+
+    switch (decoded.type) {
+    case OpCode::Type::Arithmetic: {
+        const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+        const bool is_inverted =
+            (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+        const bool relative = instr.common.address_register_index != 0;
+
+        decoded.opcode = instr.opcode.Value().EffectiveOpCode();
+        decoded.address_register_index = instr.common.address_register_index;
+        decoded.src[0] =
+            DecodeSource(instr.common.GetSrc1(is_inverted), relative && !is_inverted, swizzle, 1);
+        decoded.src[1] =
+            DecodeSource(instr.common.GetSrc2(is_inverted), relative && is_inverted, swizzle, 2);
+        DecodeDest(instr.common.dest.Value(), decoded);
+        for (int i = 0; i < 4; ++i) {
+            if (swizzle.DestComponentEnabled(i))
+                decoded.dest_mask |= 1 << i;
+        }
+        break;
+    }
+
+    case OpCode::Type::MultiplyAdd: {
+        const SwizzlePattern swizzle = {swizzle_data[instr.mad.operand_desc_id]};
+        const bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
+        const bool relative = instr.mad.address_register_index != 0;
+
+        decoded.opcode = instr.opcode.Value().EffectiveOpCode();
+        decoded.address_register_index = instr.mad.address_register_index;
+        decoded.src[0] = DecodeSource(instr.mad.GetSrc1(is_inverted), false, swizzle, 1);
+        decoded.src[1] =
+            DecodeSource(instr.mad.GetSrc2(is_inverted), relative && !is_inverted, swizzle, 2);
+        decoded.src[2] =
+            DecodeSource(instr.mad.GetSrc3(is_inverted), relative && is_inverted, swizzle, 3);
+        DecodeDest(instr.mad.dest.Value(), decoded);
+        for (int i = 0; i < 4; ++i) {
+            if (swizzle.DestComponentEnabled(i))
+                decoded.dest_mask |= 1 << i;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+    return decoded;
+}
+
+static std::unique_ptr<DecodedProgram> DecodeProgram(const ShaderSetup& setup) {
+    auto program = std::make_unique<DecodedProgram>();
+    for (unsigned i = 0; i < MAX_PROGRAM_CODE_LENGTH; ++i) {
+        program->code[i] = DecodeInstruction({setup.program_code[i]}, setup.swizzle_data);
+    }
+    return program;
+}
+
 template <bool Debug>
-static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData<Debug>& debug_data,
-                           unsigned offset) {
+static void RunInterpreter(const ShaderSetup& setup, const DecodedProgram& program,
+                           UnitState& state, DebugData<Debug>& debug_data, unsigned offset) {
     // TODO: Is there a maximal size for this?
     boost::container::static_vector<CallStackElement, 16> call_stack;
     u32 program_counter = offset;
@@ -79,11 +250,46 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     };
 
     const auto& uniforms = setup.uniforms;
-    const auto& swizzle_data = setup.swizzle_data;
-    const auto& program_code = setup.program_code;
 
     // Placeholder for invalid inputs
-    static float24 dummy_vec4_float24[4];
+    static Math::Vec4<float24> dummy_register;
+
+    const Math::Vec4<float24>* const source_files[] = {
+        state.registers.input, state.registers.temporary, uniforms.f, &dummy_register,
+    };
+    Math::Vec4<float24>* const dest_files[] = {
+        state.registers.output, state.registers.temporary, &dummy_register,
+    };
+
+    auto LookupSourceRegister = [&](const SourceRegister& source_reg) -> const float24* {
+        switch (source_reg.GetRegisterType()) {
+        case RegisterType::Input:
+            return &state.registers.input[source_reg.GetIndex()].x;
+
+        case RegisterType::Temporary:
+            return &state.registers.temporary[source_reg.GetIndex()].x;
+
+        case RegisterType::FloatUniform:
+            return &uniforms.f[source_reg.GetIndex()].x;
+
+        default:
+            return &dummy_register.x;
+        }
+    };
+
+    auto LoadSource = [&](const DecodedSource& source, int address_offset, float24(&value)[4]) {
+        const float24* reg =
+            source.relative ? LookupSourceRegister(source.reg + address_offset)
+                            : &source_files[static_cast<size_t>(source.file)][source.index].x;
+        for (int i = 0; i < 4; ++i) {
+            value[i] = reg[source.selector[i]];
+        }
+        if (source.negate) {
+            for (int i = 0; i < 4; ++i) {
+                value[i] = -value[i];
+            }
+        }
+    };
 
     unsigned iteration = 0;
     bool exit_loop = false;
@@ -105,8 +311,8 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
             }
         }
 
-        const Instruction instr = {program_code[program_counter]};
-        const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+        const DecodedInstruction& op = program.code[program_counter];
+        const Instruction instr = op.instr;
 
         Record<DebugDataRecord::CUR_INSTR>(debug_data, iteration, program_counter);
         if (iteration > 0)
@@ -114,82 +320,31 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
 
         debug_data.max_offset = std::max<u32>(debug_data.max_offset, 1 + program_counter);
 
-        auto LookupSourceRegister = [&](const SourceRegister& source_reg) -> const float24* {
-            switch (source_reg.GetRegisterType()) {
-            case RegisterType::Input:
-                return &state.registers.input[source_reg.GetIndex()].x;
-
-            case RegisterType::Temporary:
-                return &state.registers.temporary[source_reg.GetIndex()].x;
-
-            case RegisterType::FloatUniform:
-                return &uniforms.f[source_reg.GetIndex()].x;
+        auto DestComponentEnabled = [&op](int i) { return ((op.dest_mask >> i) & 1) != 0; };
 
-            default:
-                return dummy_vec4_float24;
-            }
-        };
-
-        switch (instr.opcode.Value().GetInfo().type) {
+        switch (op.type) {
         case OpCode::Type::Arithmetic: {
-            const bool is_inverted =
-                (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
-
-            const int address_offset =
-                (instr.common.address_register_index == 0)
-                    ? 0
-                    : state.address_registers[instr.common.address_register_index - 1];
-
-            const float24* src1_ = LookupSourceRegister(instr.common.GetSrc1(is_inverted) +
-                                                        (is_inverted ? 0 : address_offset));
-            const float24* src2_ = LookupSourceRegister(instr.common.GetSrc2(is_inverted) +
-                                                        (is_inverted ? address_offset : 0));
-
-            const bool negate_src1 = ((bool)swizzle.negate_src1 != false);
-            const bool negate_src2 = ((bool)swizzle.negate_src2 != false);
-
-            float24 src1[4] = {
-                src1_[(int)swizzle.src1_selector_0.Value()],
-                src1_[(int)swizzle.src1_selector_1.Value()],
-                src1_[(int)swizzle.src1_selector_2.Value()],
-                src1_[(int)swizzle.src1_selector_3.Value()],
-            };
-            if (negate_src1) {
-                src1[0] = -src1[0];
-                src1[1] = -src1[1];
-                src1[2] = -src1[2];
-                src1[3] = -src1[3];
-            }
-            float24 src2[4] = {
-                src2_[(int)swizzle.src2_selector_0.Value()],
-                src2_[(int)swizzle.src2_selector_1.Value()],
-                src2_[(int)swizzle.src2_selector_2.Value()],
-                src2_[(int)swizzle.src2_selector_3.Value()],
-            };
-            if (negate_src2) {
-                src2[0] = -src2[0];
-                src2[1] = -src2[1];
-                src2[2] = -src2[2];
-                src2[3] = -src2[3];
-            }
+            const int address_offset = (op.address_register_index == 0)
+                                           ? 0
+                                           : state.address_registers[op.address_register_index - 1];
+
+            float24 src1[4];
+            float24 src2[4];
+            LoadSource(op.src[0], address_offset, src1);
+            LoadSource(op.src[1], address_offset, src2);
 
-            float24* dest =
-                (instr.common.dest.Value() < 0x10)
-                    ? &state.registers.output[instr.common.dest.Value().GetIndex()][0]
-                    : (instr.common.dest.Value() < 0x20)
-                          ? &state.registers.temporary[instr.common.dest.Value().GetIndex()][0]
-                          : dummy_vec4_float24;
+            float24* dest = &dest_files[static_cast<size_t>(op.dest_file)][op.dest_index].x;
 
             debug_data.max_opdesc_id =
                 std::max<u32>(debug_data.max_opdesc_id, 1 + instr.common.operand_desc_id);
 
-            switch (instr.opcode.Value().EffectiveOpCode()) {
+            switch (op.opcode) {
             case OpCode::Id::ADD: {
                 Record<DebugDataRecord::SRC1>(debug_data, iteration, src1);
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = src1[i] + src2[i];
@@ -203,7 +358,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = src1[i] * src2[i];
@@ -216,7 +371,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC1>(debug_data, iteration, src1);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = float24::FromFloat32(std::floor(src1[i].ToFloat32()));
@@ -229,7 +384,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     // NOTE: Exact form required to match NaN semantics to hardware:
@@ -245,7 +400,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     // NOTE: Exact form required to match NaN semantics to hardware:
@@ -264,16 +419,15 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
 
-                OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
-                if (opcode == OpCode::Id::DPH || opcode == OpCode::Id::DPHI)
+                if (op.opcode == OpCode::Id::DPH || op.opcode == OpCode::Id::DPHI)
                     src1[3] = float24::FromFloat32(1.0f);
 
-                int num_components = (opcode == OpCode::Id::DP3) ? 3 : 4;
+                int num_components = (op.opcode == OpCode::Id::DP3) ? 3 : 4;
                 float24 dot = std::inner_product(src1, src1 + num_components, src2,
                                                  float24::FromFloat32(0.f));
 
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = dot;
@@ -288,7 +442,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 float24 rcp_res = float24::FromFloat32(1.0f / src1[0].ToFloat32());
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = rcp_res;
@@ -303,7 +457,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 float24 rsq_res = float24::FromFloat32(1.0f / std::sqrt(src1[0].ToFloat32()));
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = rsq_res;
@@ -315,7 +469,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
             case OpCode::Id::MOVA: {
                 Record<DebugDataRecord::SRC1>(debug_data, iteration, src1);
                 for (int i = 0; i < 2; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     // TODO: Figure out how the rounding is done on hardware
@@ -330,7 +484,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC1>(debug_data, iteration, src1);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = src1[i];
@@ -345,7 +499,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = (src1[i] >= src2[i]) ? float24::FromFloat32(1.0f)
@@ -360,7 +514,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = (src1[i] < src2[i]) ? float24::FromFloat32(1.0f)
@@ -418,7 +572,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 // EX2 only takes first component exp2 and writes it to all dest components
                 float24 ex2_res = float24::FromFloat32(std::exp2(src1[0].ToFloat32()));
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = ex2_res;
@@ -435,7 +589,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 // LG2 only takes the first component log2 and writes it to all dest components
                 float24 lg2_res = float24::FromFloat32(std::log2(src1[0].ToFloat32()));
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = lg2_res;
@@ -457,78 +611,27 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
         }
 
         case OpCode::Type::MultiplyAdd: {
-            if ((instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD) ||
-                (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI)) {
-                const SwizzlePattern& swizzle = *reinterpret_cast<const SwizzlePattern*>(
-                    &swizzle_data[instr.mad.operand_desc_id]);
-
-                bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
-
+            if ((op.opcode == OpCode::Id::MAD) || (op.opcode == OpCode::Id::MADI)) {
                 const int address_offset =
-                    (instr.mad.address_register_index == 0)
+                    (op.address_register_index == 0)
                         ? 0
-                        : state.address_registers[instr.mad.address_register_index - 1];
-
-                const float24* src1_ = LookupSourceRegister(instr.mad.GetSrc1(is_inverted));
-                const float24* src2_ = LookupSourceRegister(instr.mad.GetSrc2(is_inverted) +
-                                                            (!is_inverted * address_offset));
-                const float24* src3_ = LookupSourceRegister(instr.mad.GetSrc3(is_inverted) +
-                                                            (is_inverted * address_offset));
-
-                const bool negate_src1 = ((bool)swizzle.negate_src1 != false);
-                const bool negate_src2 = ((bool)swizzle.negate_src2 != false);
-                const bool negate_src3 = ((bool)swizzle.negate_src3 != false);
-
-                float24 src1[4] = {
-                    src1_[(int)swizzle.src1_selector_0.Value()],
-                    src1_[(int)swizzle.src1_selector_1.Value()],
-                    src1_[(int)swizzle.src1_selector_2.Value()],
-                    src1_[(int)swizzle.src1_selector_3.Value()],
-                };
-                if (negate_src1) {
-                    src1[0] = -src1[0];
-                    src1[1] = -src1[1];
-                    src1[2] = -src1[2];
-                    src1[3] = -src1[3];
-                }
-                float24 src2[4] = {
-                    src2_[(int)swizzle.src2_selector_0.Value()],
-                    src2_[(int)swizzle.src2_selector_1.Value()],
-                    src2_[(int)swizzle.src2_selector_2.Value()],
-                    src2_[(int)swizzle.src2_selector_3.Value()],
-                };
-                if (negate_src2) {
-                    src2[0] = -src2[0];
-                    src2[1] = -src2[1];
-                    src2[2] = -src2[2];
-                    src2[3] = -src2[3];
-                }
-                float24 src3[4] = {
-                    src3_[(int)swizzle.src3_selector_0.Value()],
-                    src3_[(int)swizzle.src3_selector_1.Value()],
-                    src3_[(int)swizzle.src3_selector_2.Value()],
-                    src3_[(int)swizzle.src3_selector_3.Value()],
-                };
-                if (negate_src3) {
-                    src3[0] = -src3[0];
-                    src3[1] = -src3[1];
-                    src3[2] = -src3[2];
-                    src3[3] = -src3[3];
-                }
+                        : state.address_registers[op.address_register_index - 1];
 
-                float24* dest =
-                    (instr.mad.dest.Value() < 0x10)
-                        ? &state.registers.output[instr.mad.dest.Value().GetIndex()][0]
-                        : (instr.mad.dest.Value() < 0x20)
-                              ? &state.registers.temporary[instr.mad.dest.Value().GetIndex()][0]
-                              : dummy_vec4_float24;
+                float24 src1[4];
+                float24 src2[4];
+                float24 src3[4];
+                LoadSource(op.src[0], address_offset, src1);
+                LoadSource(op.src[1], address_offset, src2);
+                LoadSource(op.src[2], address_offset, src3);
+
+                float24* dest = &dest_files[static_cast<size_t>(op.dest_file)][op.dest_index].x;
 
                 Record<DebugDataRecord::SRC1>(debug_data, iteration, src1);
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::SRC3>(debug_data, iteration, src3);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!DestComponentEnabled(i))
                         continue;
 
                     dest[i] = src1[i] * src2[i] + src3[i];
@@ -544,7 +647,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
 
         default: {
             // Handle each instruction on its own
-            switch (instr.opcode.Value()) {
+            switch (op.opcode) {
             case OpCode::Id::END:
                 exit_loop = true;
                 break;
@@ -636,6 +739,23 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 break;
             }
 
+            case OpCode::Id::EMIT: {
+                GSEmitter* emitter = state.emitter_ptr;
+                ASSERT_MSG(emitter, "Execute EMIT on VS");
+                emitter->Emit(state.registers.output);
+                break;
+            }
+
+            case OpCode::Id::SETEMIT: {
+                GSEmitter* emitter = state.emitter_ptr;
+                ASSERT_MSG(emitter, "Execute SETEMIT on VS");
+                const SetEmitInstruction setemit = {instr.hex};
+                emitter->vertex_id = setemit.vertex_id;
+                emitter->prim_emit = setemit.prim_emit != 0;
+                emitter->winding = setemit.winding != 0;
+                break;
+            }
+
             default:
                 LOG_ERROR(HW_GPU, "Unhandled instruction: 0x%02x (%s): 0x%08x",
                           (int)instr.opcode.Value().EffectiveOpCode(),
@@ -652,19 +772,39 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     }
 }
 
-void InterpreterEngine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
+InterpreterEngine::InterpreterEngine() = default;
+InterpreterEngine::~InterpreterEngine() = default;
+
+void InterpreterEngine::SetupBatch(ShaderSetup& setup, unsigned int entry_point,
+                                   u32 output_mask) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
+
+    u64 code_hash = Common::ComputeHash64(&setup.program_code, sizeof(setup.program_code));
+    u64 swizzle_hash = Common::ComputeHash64(&setup.swizzle_data, sizeof(setup.swizzle_data));
+
+    u64 cache_key = code_hash ^ swizzle_hash;
+    auto iter = cache.find(cache_key);
+    if (iter != cache.end()) {
+        setup.engine_data.cached_shader = iter->second.get();
+    } else {
+        auto program = DecodeProgram(setup);
+        setup.engine_data.cached_shader = program.get();
+        cache.emplace_hint(iter, cache_key, std::move(program));
+    }
 }
 
 MICROPROFILE_DECLARE(GPU_Shader);
 
 void InterpreterEngine::Run(const ShaderSetup& setup, UnitState& state) const {
+    ASSERT(setup.engine_data.cached_shader != nullptr);
 
     MICROPROFILE_SCOPE(GPU_Shader);
 
+    const DecodedProgram* program =
+        static_cast<const DecodedProgram*>(setup.engine_data.cached_shader);
     DebugData<false> dummy_debug_data;
-    RunInterpreter(setup, state, dummy_debug_data, setup.engine_data.entry_point);
+    RunInterpreter(setup, *program, state, dummy_debug_data, setup.engine_data.entry_point);
 }
 
 DebugData<true> InterpreterEngine::ProduceDebugInfo(const ShaderSetup& setup,
@@ -676,7 +816,8 @@ DebugData<true> InterpreterEngine::ProduceDebugInfo(const ShaderSetup& setup,
     // Setup input register table
     boost::fill(state.registers.input, Math::Vec4<float24>::AssignToAll(float24::Zero()));
     state.LoadInput(config, input);
-    RunInterpreter(setup, state, debug_data, setup.engine_data.entry_point);
+    auto program = DecodeProgram(setup);
+    RunInterpreter(setup, *program, state, debug_data, setup.engine_data.entry_point);
     return debug_data;
 }
 
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <memory>
+#include <unordered_map>
+#include "common/common_types.h"
 #include "video_core/shader/debug_data.h"
 #include "video_core/shader/shader.h"
 
@@ -11,9 +14,14 @@ namespace Pica {
 
 namespace Shader {
 
+struct DecodedProgram;
+
 class InterpreterEngine final : public ShaderEngine {
 public:
-    void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
+    InterpreterEngine();
+    ~InterpreterEngine() override;
+
+    void SetupBatch(ShaderSetup& setup, unsigned int entry_point, u32 output_mask) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
 
     /**
@@ -25,6 +33,10 @@ public:
      */
     DebugData<true> ProduceDebugInfo(const ShaderSetup& setup, const AttributeBuffer& input,
                                      const ShaderRegs& config) const;
+
+private:
+    /// Programs decoded by SetupBatch, keyed by the hash of their code and swizzle data
+    std::unordered_map<u64, std::unique_ptr<DecodedProgram>> cache;
 };
 
 } // namespace
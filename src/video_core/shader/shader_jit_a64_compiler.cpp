@@ -0,0 +1,880 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <nihstro/shader_bytecode.h>
+#include "common/aarch64/a64_emitter.h"
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/vector_math.h"
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_jit_a64_compiler.h"
+
+using namespace Common::A64;
+
+namespace Pica {
+
+namespace Shader {
+
+typedef void (JitA64Shader::*JitFunction)(Instruction instr);
+
+const JitFunction instr_table[64] = {
+    &JitA64Shader::Compile_ADD,   // add
+    &JitA64Shader::Compile_DP3,   // dp3
+    &JitA64Shader::Compile_DP4,   // dp4
+    &JitA64Shader::Compile_DPH,   // dph
+    nullptr,                      // unknown
+    &JitA64Shader::Compile_EX2,   // ex2
+    &JitA64Shader::Compile_LG2,   // lg2
+    nullptr,                      // unknown
+    &JitA64Shader::Compile_MUL,   // mul
+    &JitA64Shader::Compile_SGE,   // sge
+    &JitA64Shader::Compile_SLT,   // slt
+    &JitA64Shader::Compile_FLR,   // flr
+    &JitA64Shader::Compile_MAX,   // max
+    &JitA64Shader::Compile_MIN,   // min
+    &JitA64Shader::Compile_RCP,   // rcp
+    &JitA64Shader::Compile_RSQ,   // rsq
+    nullptr,                      // unknown
+    nullptr,                      // unknown
+    &JitA64Shader::Compile_MOVA,  // mova
+    &JitA64Shader::Compile_MOV,   // mov
+    nullptr,                      // unknown
+    nullptr,                      // unknown
+    nullptr,                      // unknown
+    nullptr,                      // unknown
+    &JitA64Shader::Compile_DPH,   // dphi
+    nullptr,                      // unknown
+    &JitA64Shader::Compile_SGE,   // sgei
+    &JitA64Shader::Compile_SLT,   // slti
+    nullptr,                      // unknown
+    nullptr,                      // unknown
+    nullptr,                      // unknown
+    nullptr,                      // unknown
+    nullptr,                      // unknown
+    &JitA64Shader::Compile_NOP,   // nop
+    &JitA64Shader::Compile_END,   // end
+    nullptr,                      // break
+    &JitA64Shader::Compile_CALL,  // call
+    &JitA64Shader::Compile_CALLC, // callc
+    &JitA64Shader::Compile_CALLU, // callu
+    &JitA64Shader::Compile_IF,    // ifu
+    &JitA64Shader::Compile_IF,    // ifc
+    &JitA64Shader::Compile_LOOP,  // loop
+    &JitA64Shader::Compile_EMIT,  // emit
+    &JitA64Shader::Compile_SETE,  // sete
+    &JitA64Shader::Compile_JMP,   // jmpc
+    &JitA64Shader::Compile_JMP,   // jmpu
+    &JitA64Shader::Compile_CMP,   // cmp
+    &JitA64Shader::Compile_CMP,   // cmp
+    &JitA64Shader::Compile_MAD,   // madi
+    &JitA64Shader::Compile_MAD,   // madi
+    &JitA64Shader::Compile_MAD,   // madi
+    &JitA64Shader::Compile_MAD,   // madi
+    &JitA64Shader::Compile_MAD,   // madi
+    &JitA64Shader::Compile_MAD,   // madi
+    &JitA64Shader::Compile_MAD,   // madi
+    &JitA64Shader::Compile_MAD,   // madi
+    &JitA64Shader::Compile_MAD,   // mad
+    &JitA64Shader::Compile_MAD,   // mad
+    &JitA64Shader::Compile_MAD,   // mad
+    &JitA64Shader::Compile_MAD,   // mad
+    &JitA64Shader::Compile_MAD,   // mad
+    &JitA64Shader::Compile_MAD,   // mad
+    &JitA64Shader::Compile_MAD,   // mad
+    &JitA64Shader::Compile_MAD,   // mad
+};
+
+// The following is used to alias some commonly used registers. IP0, IP1 and V0-V5 can be used as
+// scratch registers within a compiler function. The state of the shader unit lives in callee saved
+// registers, so that it survives calls to host functions:
+
+/// Pointer to the uniform memory
+static const XReg SETUP{19};
+/// Pointer to the UnitState instance for the current VS unit
+static const XReg STATE{20};
+/// The two 32-bit VS address offset registers set by the MOVA instruction (Multiplied by 16)
+static const XReg ADDROFFS_REG_0{21};
+static const XReg ADDROFFS_REG_1{22};
+/// VS loop count register (Multiplied by 16)
+static const WReg LOOPCOUNT_REG{23};
+/// Current VS loop iteration number (we could probably use LOOPCOUNT_REG, but this quicker)
+static const WReg LOOPCOUNT{24};
+/// Number to increment LOOPCOUNT_REG by on each loop iteration (Multiplied by 16)
+static const WReg LOOPINC{25};
+/// Result of the previous CMP instruction for the X-component comparison
+static const WReg COND0{26};
+/// Result of the previous CMP instruction for the Y-component comparison
+static const WReg COND1{27};
+/// Stack pointer at the entry of the main routine, used to return from within subroutines
+static const XReg STACK_BASE{28};
+/// SIMD scratch register
+static const VReg SCRATCH{0};
+/// Loaded with the first swizzled source register, otherwise can be used as a scratch register
+static const VReg SRC1{1};
+/// Loaded with the second swizzled source register, otherwise can be used as a scratch register
+static const VReg SRC2{2};
+/// Loaded with the third swizzled source register, otherwise can be used as a scratch register
+static const VReg SRC3{3};
+/// Additional scratch register
+static const VReg SCRATCH2{4};
+/// Holds the unswizzled source while swizzling a source register
+static const VReg SWIZZLE_SRC{5};
+/// Constant vector of [1.0f, 1.0f, 1.0f, 1.0f], used to efficiently set a vector to one
+static const VReg ONE{31};
+
+/// Raw constant for the source register selector that indicates no swizzling is performed
+static const u8 NO_SRC_REG_SWIZZLE = 0x1b;
+/// Raw constant for the destination register enable mask that indicates all components are enabled
+static const u8 NO_DEST_REG_MASK = 0xf;
+
+/// Size of the stack frame holding the callee saved registers
+static const s32 FRAME_SIZE = 96;
+/// Value of the return offset in the stack slot below the main routine, which no return matches
+static const u32 NO_RETURN_OFFSET = 0xFFFFFFFF;
+
+static void LogCritical(const char* msg) {
+    LOG_CRITICAL(HW_GPU, "%s", msg);
+}
+
+template <typename FunctionPtr>
+void JitA64Shader::Compile_CallFunction(FunctionPtr function) {
+    CallFunction(function);
+    FMOV(ONE, 1.0f);
+}
+
+void JitA64Shader::Compile_Assert(bool condition, const char* msg) {
+    if (!condition) {
+        MOVI64(ABI_PARAM1, reinterpret_cast<u64>(msg));
+        Compile_CallFunction(LogCritical);
+    }
+}
+
+/**
+ * Loads and swizzles a source register into the specified SIMD register.
+ * @param instr VS instruction, used for determining how to load the source register
+ * @param src_num Number indicating which source register to load (1 = src1, 2 = src2, 3 = src3)
+ * @param src_reg SourceRegister object corresponding to the source register to load
+ * @param dest Destination SIMD register to store the loaded, swizzled source register
+ */
+void JitA64Shader::Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRegister src_reg,
+                                      VReg dest) {
+    XReg src_ptr = STATE;
+    size_t src_offset;
+
+    if (src_reg.GetRegisterType() == RegisterType::FloatUniform) {
+        src_ptr = SETUP;
+        src_offset = ShaderSetup::GetFloatUniformOffset(src_reg.GetIndex());
+    } else {
+        src_offset = UnitState::InputOffset(src_reg);
+    }
+
+    unsigned operand_desc_id;
+
+    const bool is_inverted =
+        (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+    unsigned address_register_index;
+    unsigned offset_src;
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        operand_desc_id = instr.mad.operand_desc_id;
+        offset_src = is_inverted ? 3 : 2;
+        address_register_index = instr.mad.address_register_index;
+    } else {
+        operand_desc_id = instr.common.operand_desc_id;
+        offset_src = is_inverted ? 2 : 1;
+        address_register_index = instr.common.address_register_index;
+    }
+
+    if (src_num == offset_src && address_register_index != 0) {
+        switch (address_register_index) {
+        case 1: // address offset 1
+            ADD(IP0, src_ptr, ADDROFFS_REG_0);
+            break;
+        case 2: // address offset 2
+            ADD(IP0, src_ptr, ADDROFFS_REG_1);
+            break;
+        case 3: // address offset 3
+            ADD(IP0, src_ptr, ToX(LOOPCOUNT_REG));
+            break;
+        default:
+            UNREACHABLE();
+            break;
+        }
+        LDRQ(dest, IP0, static_cast<u32>(src_offset));
+    } else {
+        // Load the source
+        LDRQ(dest, src_ptr, static_cast<u32>(src_offset));
+    }
+
+    SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
+
+    // Generate instructions for source register swizzling as needed
+    const u8 sel = swiz.GetRawSelector(src_num);
+    if (sel != NO_SRC_REG_SWIZZLE) {
+        // The selector of the X component is stored in the topmost bits
+        unsigned selectors[4];
+        for (unsigned i = 0; i < 4; ++i) {
+            selectors[i] = (sel >> (6 - 2 * i)) & 3;
+        }
+
+        if (selectors[0] == selectors[1] && selectors[0] == selectors[2] &&
+            selectors[0] == selectors[3]) {
+            DUP(dest, dest, selectors[0]);
+        } else {
+            MOV(SWIZZLE_SRC, dest);
+            for (unsigned i = 0; i < 4; ++i) {
+                if (selectors[i] != i) {
+                    INS(dest, i, SWIZZLE_SRC, selectors[i]);
+                }
+            }
+        }
+    }
+
+    const bool negate[] = {swiz.negate_src1, swiz.negate_src2, swiz.negate_src3};
+    if (negate[src_num - 1]) {
+        FNEG(dest, dest);
+    }
+}
+
+void JitA64Shader::Compile_DestEnable(Instruction instr, VReg src) {
+    DestRegister dest;
+    unsigned operand_desc_id;
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        operand_desc_id = instr.mad.operand_desc_id;
+        dest = instr.mad.dest.Value();
+    } else {
+        operand_desc_id = instr.common.operand_desc_id;
+        dest = instr.common.dest.Value();
+    }
+
+    SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
+
+    const u32 dest_offset = static_cast<u32>(UnitState::OutputOffset(dest));
+
+    // If all components are enabled, write the result to the destination register
+    if (swiz.dest_mask == NO_DEST_REG_MASK) {
+        // Store dest back to memory
+        STRQ(src, STATE, dest_offset);
+
+    } else {
+        // Not all components are enabled, so merge the enabled ones into the destination register
+        LDRQ(SCRATCH, STATE, dest_offset);
+        for (unsigned i = 0; i < 4; ++i) {
+            if (swiz.DestComponentEnabled(i)) {
+                INS(SCRATCH, i, src, i);
+            }
+        }
+
+        // Store dest back to memory
+        STRQ(SCRATCH, STATE, dest_offset);
+    }
+}
+
+void JitA64Shader::Compile_SanitizedMul(VReg src1, VReg src2, VReg scratch) {
+    // 0 * inf and inf * 0 in the PICA should return 0 instead of NaN. This can be implemented by
+    // checking for NaNs before and after the multiplication.  If the multiplication result is NaN
+    // where neither source was, this NaN was generated by a 0 * inf multiplication, and so the
+    // result should be transformed to 0 to match PICA fp rules.
+
+    // Set scratch to mask of (src1 != NaN and src2 != NaN)
+    FCMEQ(scratch, src1, src1);
+    FCMEQ(SCRATCH2, src2, src2);
+    AND(scratch, scratch, SCRATCH2);
+
+    FMUL(src1, src1, src2);
+
+    // Set src2 to mask of (result != NaN or either source was NaN)
+    FCMEQ(src2, src1, src1);
+    ORN(src2, src2, scratch);
+
+    // Clear components where the result is NaN while neither source was NaN
+    AND(src1, src1, src2);
+}
+
+void JitA64Shader::Compile_EvaluateCondition(Instruction instr) {
+    // Each condition flag is 0 or 1, so inverting its lowest bit checks it against a 0 reference
+    const auto load_flag = [this](WReg dest, WReg flag, u32 reference) {
+        if (reference) {
+            MOV(dest, flag);
+        } else {
+            EORLowBits(dest, flag, 1);
+        }
+    };
+
+    switch (instr.flow_control.op) {
+    case Instruction::FlowControlType::Or:
+        load_flag(ToW(IP0), COND0, instr.flow_control.refx.Value());
+        load_flag(ToW(IP1), COND1, instr.flow_control.refy.Value());
+        ORR(ToW(IP0), ToW(IP0), ToW(IP1));
+        break;
+
+    case Instruction::FlowControlType::And:
+        load_flag(ToW(IP0), COND0, instr.flow_control.refx.Value());
+        load_flag(ToW(IP1), COND1, instr.flow_control.refy.Value());
+        AND(ToW(IP0), ToW(IP0), ToW(IP1));
+        break;
+
+    case Instruction::FlowControlType::JustX:
+        load_flag(ToW(IP0), COND0, instr.flow_control.refx.Value());
+        break;
+
+    case Instruction::FlowControlType::JustY:
+        load_flag(ToW(IP0), COND1, instr.flow_control.refy.Value());
+        break;
+    }
+}
+
+void JitA64Shader::Compile_UniformCondition(Instruction instr) {
+    size_t offset = ShaderSetup::GetBoolUniformOffset(instr.flow_control.bool_uniform_id);
+    LDRB(ToW(IP0), SETUP, static_cast<u32>(offset));
+}
+
+void JitA64Shader::Compile_ADD(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    FADD(SRC1, SRC1, SRC2);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_DP3(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+
+    // Leave the W component out of the sum
+    INS(SRC1, 3, WZR);
+    FADDP(SRC1, SRC1, SRC1); // XYZ0 -> (X+Y)(Z+0)(X+Y)(Z+0)
+    FADDP(SRC1, SRC1, SRC1); // Sum in all components
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_DP4(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+
+    FADDP(SRC1, SRC1, SRC1); // XYZW -> (X+Y)(Z+W)(X+Y)(Z+W)
+    FADDP(SRC1, SRC1, SRC1); // Sum in all components
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_DPH(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::DPHI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    // Set 4th component to 1.0
+    INS(SRC1, 3, ONE, 0);
+
+    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+
+    FADDP(SRC1, SRC1, SRC1); // XYZW -> (X+Y)(Z+W)(X+Y)(Z+W)
+    FADDP(SRC1, SRC1, SRC1); // Sum in all components
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_EX2(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    MOV(VReg(0), SRC1); // ABI_PARAM1 is the X component
+    Compile_CallFunction(exp2f);
+    DUP(SRC1, VReg(0), 0); // ABI_RETURN
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_LG2(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    MOV(VReg(0), SRC1); // ABI_PARAM1 is the X component
+    Compile_CallFunction(log2f);
+    DUP(SRC1, VReg(0), 0); // ABI_RETURN
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_MUL(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_SGE(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SGEI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    FCMGE(SRC2, SRC1, SRC2);
+    AND(SRC2, SRC2, ONE);
+
+    Compile_DestEnable(instr, SRC2);
+}
+
+void JitA64Shader::Compile_SLT(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SLTI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    FCMGT(SRC1, SRC2, SRC1);
+    AND(SRC1, SRC1, ONE);
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_FLR(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    FRINTM(SRC1, SRC1);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_MAX(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    // FMAX propagates NaNs, while the PICA200 returns SRC2 in that case, so select explicitly
+    FCMGT(SRC3, SRC1, SRC2);
+    BSL(SRC3, SRC1, SRC2);
+    Compile_DestEnable(instr, SRC3);
+}
+
+void JitA64Shader::Compile_MIN(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    // FMIN propagates NaNs, while the PICA200 returns SRC2 in that case, so select explicitly
+    FCMGT(SRC3, SRC2, SRC1);
+    BSL(SRC3, SRC1, SRC2);
+    Compile_DestEnable(instr, SRC3);
+}
+
+void JitA64Shader::Compile_MOVA(Instruction instr) {
+    SwizzlePattern swiz = {(*swizzle_data)[instr.common.operand_desc_id]};
+
+    if (!swiz.DestComponentEnabled(0) && !swiz.DestComponentEnabled(1)) {
+        return; // NoOp
+    }
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // Convert floats to integers using truncation (only care about X and Y components)
+    FCVTZS(SRC1, SRC1);
+
+    // Sign-extend the components and multiply them by 16 to be used as an offset later
+    if (swiz.DestComponentEnabled(0)) {
+        UMOV(ToW(IP0), SRC1, 0);
+        SBFIZ(ADDROFFS_REG_0, IP0, 4, 32);
+    }
+    if (swiz.DestComponentEnabled(1)) {
+        UMOV(ToW(IP0), SRC1, 1);
+        SBFIZ(ADDROFFS_REG_1, IP0, 4, 32);
+    }
+}
+
+void JitA64Shader::Compile_MOV(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_RCP(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // FRECPE only gives 8 bits of precision, so divide instead
+    FDIV_S(SRC1, ONE, SRC1);
+    DUP(SRC1, SRC1, 0); // XYWZ -> XXXX
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_RSQ(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // FRSQRTE only gives 8 bits of precision, so take the square root and divide instead
+    FSQRT_S(SRC1, SRC1);
+    FDIV_S(SRC1, ONE, SRC1);
+    DUP(SRC1, SRC1, 0); // XYWZ -> XXXX
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_NOP(Instruction instr) {}
+
+void JitA64Shader::Compile_END(Instruction instr) {
+    // Drop the return addresses of any subroutine `END` is reached in
+    MOV(SP, STACK_BASE);
+    ADD(SP, SP, 16);
+
+    LDP(XReg(19), XReg(20), SP, 16);
+    LDP(XReg(21), XReg(22), SP, 32);
+    LDP(XReg(23), XReg(24), SP, 48);
+    LDP(XReg(25), XReg(26), SP, 64);
+    LDP(XReg(27), XReg(28), SP, 80);
+    LDPPost(XReg(29), LR, SP, FRAME_SIZE);
+    RET();
+}
+
+void JitA64Shader::Compile_CALL(Instruction instr) {
+    Label l_return;
+
+    // Push offset of the return and the address to continue at
+    MOVZ(ToW(IP0), instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+    ADR(IP1, l_return);
+    STPPre(IP0, IP1, SP, -16);
+
+    // Call the subroutine
+    B(instruction_labels[instr.flow_control.dest_offset]);
+
+    L(l_return);
+}
+
+void JitA64Shader::Compile_CALLC(Instruction instr) {
+    Compile_EvaluateCondition(instr);
+    Label b;
+    CBZ(ToW(IP0), b);
+    Compile_CALL(instr);
+    L(b);
+}
+
+void JitA64Shader::Compile_CALLU(Instruction instr) {
+    Compile_UniformCondition(instr);
+    Label b;
+    CBZ(ToW(IP0), b);
+    Compile_CALL(instr);
+    L(b);
+}
+
+void JitA64Shader::Compile_Compare(Instruction::Common::CompareOpType::Op op, VReg dest) {
+    using Op = Instruction::Common::CompareOpType::Op;
+    switch (op) {
+    case Op::Equal:
+        FCMEQ(dest, SRC1, SRC2);
+        break;
+    case Op::NotEqual:
+        // Like the PICA200, this is true if either source is NaN
+        FCMEQ(dest, SRC1, SRC2);
+        NOT(dest, dest);
+        break;
+    case Op::LessThan:
+        FCMGT(dest, SRC2, SRC1);
+        break;
+    case Op::LessEqual:
+        FCMGE(dest, SRC2, SRC1);
+        break;
+    case Op::GreaterThan:
+        FCMGT(dest, SRC1, SRC2);
+        break;
+    case Op::GreaterEqual:
+        FCMGE(dest, SRC1, SRC2);
+        break;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown compare mode %x", static_cast<int>(op));
+        FCMEQ(dest, SRC1, SRC2);
+        break;
+    }
+}
+
+void JitA64Shader::Compile_CMP(Instruction instr) {
+    using Op = Instruction::Common::CompareOpType::Op;
+    Op op_x = instr.common.compare_op.x;
+    Op op_y = instr.common.compare_op.y;
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    Compile_Compare(op_x, SCRATCH);
+    UMOV(COND0, SCRATCH, 0);
+
+    if (op_x == op_y) {
+        // Compare X-component and Y-component together
+        UMOV(COND1, SCRATCH, 1);
+    } else {
+        Compile_Compare(op_y, SCRATCH2);
+        UMOV(COND1, SCRATCH2, 1);
+    }
+
+    LSR(COND0, COND0, 31);
+    LSR(COND1, COND1, 31);
+}
+
+void JitA64Shader::Compile_MAD(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.mad.src1, SRC1);
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        Compile_SwizzleSrc(instr, 2, instr.mad.src2i, SRC2);
+        Compile_SwizzleSrc(instr, 3, instr.mad.src3i, SRC3);
+    } else {
+        Compile_SwizzleSrc(instr, 2, instr.mad.src2, SRC2);
+        Compile_SwizzleSrc(instr, 3, instr.mad.src3, SRC3);
+    }
+
+    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+    FADD(SRC1, SRC1, SRC3);
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitA64Shader::Compile_IF(Instruction instr) {
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter,
+                   "Backwards if-statements not supported");
+    Label l_else, l_endif;
+
+    // Evaluate the "IF" condition
+    if (instr.opcode.Value() == OpCode::Id::IFU) {
+        Compile_UniformCondition(instr);
+    } else if (instr.opcode.Value() == OpCode::Id::IFC) {
+        Compile_EvaluateCondition(instr);
+    }
+    CBZ(ToW(IP0), l_else);
+
+    // Compile the code that corresponds to the condition evaluating as true
+    Compile_Block(instr.flow_control.dest_offset);
+
+    // If there isn't an "ELSE" condition, we are done here
+    if (instr.flow_control.num_instructions == 0) {
+        L(l_else);
+        return;
+    }
+
+    B(l_endif);
+
+    L(l_else);
+    // This code corresponds to the "ELSE" condition
+    // Comple the code that corresponds to the condition evaluating as false
+    Compile_Block(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+
+    L(l_endif);
+}
+
+void JitA64Shader::Compile_LOOP(Instruction instr) {
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter,
+                   "Backwards loops not supported");
+    Compile_Assert(!looping, "Nested loops not supported");
+
+    looping = true;
+
+    // This decodes the fields from the integer uniform at index instr.flow_control.int_uniform_id.
+    // The Y (LOOPCOUNT_REG) and Z (LOOPINC) component are kept multiplied by 16 (Left shifted by
+    // 4 bits) to be used as an offset into the 16-byte vector registers later
+    size_t offset = ShaderSetup::GetIntUniformOffset(instr.flow_control.int_uniform_id);
+    LDR(LOOPCOUNT, SETUP, static_cast<u32>(offset));
+    UBFX(LOOPCOUNT_REG, LOOPCOUNT, 8, 8); // Y-component is the start
+    LSL(LOOPCOUNT_REG, LOOPCOUNT_REG, 4);
+    UBFX(LOOPINC, LOOPCOUNT, 16, 8); // Z-component is the incrementer
+    LSL(LOOPINC, LOOPINC, 4);
+    ANDLowBits(LOOPCOUNT, LOOPCOUNT, 8); // X-component is iteration count
+    ADD(LOOPCOUNT, LOOPCOUNT, 1);        // Iteration count is X-component + 1
+
+    Label l_loop_start;
+    L(l_loop_start);
+
+    Compile_Block(instr.flow_control.dest_offset + 1);
+
+    ADD(LOOPCOUNT_REG, LOOPCOUNT_REG, LOOPINC); // Increment LOOPCOUNT_REG by Z-component
+    SUBS(LOOPCOUNT, LOOPCOUNT, 1);              // Decrement the remaining iterations by 1
+    B(Cond::NE, l_loop_start);                  // Loop if not equal
+
+    looping = false;
+}
+
+void JitA64Shader::Compile_JMP(Instruction instr) {
+    if (instr.opcode.Value() == OpCode::Id::JMPC)
+        Compile_EvaluateCondition(instr);
+    else if (instr.opcode.Value() == OpCode::Id::JMPU)
+        Compile_UniformCondition(instr);
+    else
+        UNREACHABLE();
+
+    bool inverted_condition =
+        (instr.opcode.Value() == OpCode::Id::JMPU) && (instr.flow_control.num_instructions & 1);
+
+    Label& b = instruction_labels[instr.flow_control.dest_offset];
+    if (inverted_condition) {
+        CBZ(ToW(IP0), b);
+    } else {
+        CBNZ(ToW(IP0), b);
+    }
+}
+
+static void EmitVertex(GSEmitter* emitter, Math::Vec4<float24> (*output)[16]) {
+    emitter->Emit(*output);
+}
+
+void JitA64Shader::Compile_EMIT(Instruction instr) {
+    Label have_emitter, end;
+    LDR(ABI_PARAM1, STATE, offsetof(UnitState, emitter_ptr));
+    CBNZ(ABI_PARAM1, have_emitter);
+
+    MOVI64(ABI_PARAM1, reinterpret_cast<u64>("Execute EMIT on VS"));
+    Compile_CallFunction(LogCritical);
+    B(end);
+
+    L(have_emitter);
+    ADD(ABI_PARAM2, STATE, offsetof(UnitState, registers.output));
+    Compile_CallFunction(EmitVertex);
+    L(end);
+}
+
+void JitA64Shader::Compile_SETE(Instruction instr) {
+    const SetEmitInstruction setemit = {instr.hex};
+
+    Label have_emitter, end;
+    LDR(IP0, STATE, offsetof(UnitState, emitter_ptr));
+    CBNZ(IP0, have_emitter);
+
+    MOVI64(ABI_PARAM1, reinterpret_cast<u64>("Execute SETEMIT on VS"));
+    Compile_CallFunction(LogCritical);
+    B(end);
+
+    L(have_emitter);
+    MOVZ(ToW(IP1), setemit.vertex_id.Value());
+    STRB(ToW(IP1), IP0, offsetof(GSEmitter, vertex_id));
+    MOVZ(ToW(IP1), setemit.prim_emit.Value());
+    STRB(ToW(IP1), IP0, offsetof(GSEmitter, prim_emit));
+    MOVZ(ToW(IP1), setemit.winding.Value());
+    STRB(ToW(IP1), IP0, offsetof(GSEmitter, winding));
+    L(end);
+}
+
+void JitA64Shader::Compile_Block(unsigned end) {
+    while (program_counter < end) {
+        Compile_NextInstr();
+    }
+}
+
+void JitA64Shader::Compile_Return() {
+    // Peek return offset on the stack and check if we're at that offset
+    Label b;
+    LDR(ToW(IP0), SP, 0);
+    CMP(ToW(IP0), program_counter);
+    B(Cond::NE, b);
+
+    // If so, pop the return offset and address and jump back to after the CALL
+    LDPPost(IP0, IP1, SP, 16);
+    BR(IP1);
+    L(b);
+}
+
+void JitA64Shader::Compile_NextInstr() {
+    if (std::binary_search(return_offsets.begin(), return_offsets.end(), program_counter)) {
+        Compile_Return();
+    }
+
+    L(instruction_labels[program_counter]);
+
+    Instruction instr = {(*program_code)[program_counter++]};
+
+    OpCode::Id opcode = instr.opcode.Value();
+    auto instr_func = instr_table[static_cast<unsigned>(opcode)];
+
+    if (instr_func) {
+        // JIT the instruction!
+        ((*this).*instr_func)(instr);
+    } else {
+        // Unhandled instruction
+        LOG_CRITICAL(HW_GPU, "Unhandled instruction: 0x%02x (0x%08x)",
+                     instr.opcode.Value().EffectiveOpCode(), instr.hex);
+    }
+}
+
+void JitA64Shader::FindReturnOffsets() {
+    return_offsets.clear();
+
+    for (size_t offset = 0; offset < program_code->size(); ++offset) {
+        Instruction instr = {(*program_code)[offset]};
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::CALL:
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU:
+            return_offsets.push_back(instr.flow_control.dest_offset +
+                                     instr.flow_control.num_instructions);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Sort for efficient binary search later
+    std::sort(return_offsets.begin(), return_offsets.end());
+}
+
+void JitA64Shader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
+                           const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_) {
+    program_code = program_code_;
+    swizzle_data = swizzle_data_;
+
+    // Reset flow control state
+    program = (CompiledShader*)GetCurrent();
+    program_counter = 0;
+    looping = false;
+
+    // Find all `CALL` instructions and identify return locations
+    FindReturnOffsets();
+
+    // Save the frame record and the callee saved registers holding the unit state
+    STPPre(XReg(29), LR, SP, -FRAME_SIZE);
+    STP(XReg(19), XReg(20), SP, 16);
+    STP(XReg(21), XReg(22), SP, 32);
+    STP(XReg(23), XReg(24), SP, 48);
+    STP(XReg(25), XReg(26), SP, 64);
+    STP(XReg(27), XReg(28), SP, 80);
+
+    // Push a return record no return check matches, to catch any potential return checks (see
+    // Compile_Return) that happen in shader main routine
+    MOVI64(IP0, NO_RETURN_OFFSET);
+    STPPre(IP0, XZR, SP, -16);
+    MOV(STACK_BASE, SP);
+
+    MOV(SETUP, ABI_PARAM1);
+    MOV(STATE, ABI_PARAM2);
+
+    // Zero address/loop  registers
+    MOVZ(ADDROFFS_REG_0, 0);
+    MOVZ(ADDROFFS_REG_1, 0);
+    MOVZ(LOOPCOUNT_REG, 0);
+
+    // Used to set a register to one
+    FMOV(ONE, 1.0f);
+
+    // Jump to start of the shader program
+    BR(ABI_PARAM3);
+
+    // Compile entire program
+    Compile_Block(static_cast<unsigned>(program_code->size()));
+
+    // Free memory that's no longer needed
+    program_code = nullptr;
+    swizzle_data = nullptr;
+    return_offsets.clear();
+    return_offsets.shrink_to_fit();
+
+    Ready();
+
+    LOG_DEBUG(HW_GPU, "Compiled shader size=%zu", GetSize());
+}
+
+JitA64Shader::JitA64Shader() : Common::A64::CodeGenerator(MAX_A64_SHADER_SIZE) {}
+
+} // namespace Shader
+
+} // namespace Pica
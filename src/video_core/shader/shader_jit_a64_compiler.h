@@ -0,0 +1,137 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include <nihstro/shader_bytecode.h>
+#include "common/aarch64/a64_emitter.h"
+#include "common/common_types.h"
+#include "video_core/shader/shader.h"
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::SwizzlePattern;
+
+namespace Pica {
+
+namespace Shader {
+
+/// Memory allocated for each compiled shader, small enough for conditional branches to reach
+/// across all of it
+constexpr size_t MAX_A64_SHADER_SIZE = MAX_PROGRAM_CODE_LENGTH * 128;
+
+/**
+ * This class implements the shader JIT compiler for AArch64 hosts. It recompiles a Pica shader
+ * program into AArch64 code using NEON instructions, following the design of the x86_64 JitShader.
+ */
+class JitA64Shader : public Common::A64::CodeGenerator {
+public:
+    JitA64Shader();
+
+    void Run(const ShaderSetup& setup, UnitState& state, unsigned offset) const {
+        program(&setup, &state, GetAddress(instruction_labels[offset]));
+    }
+
+    void Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code,
+                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data);
+
+    void Compile_ADD(Instruction instr);
+    void Compile_DP3(Instruction instr);
+    void Compile_DP4(Instruction instr);
+    void Compile_DPH(Instruction instr);
+    void Compile_EX2(Instruction instr);
+    void Compile_LG2(Instruction instr);
+    void Compile_MUL(Instruction instr);
+    void Compile_SGE(Instruction instr);
+    void Compile_SLT(Instruction instr);
+    void Compile_FLR(Instruction instr);
+    void Compile_MAX(Instruction instr);
+    void Compile_MIN(Instruction instr);
+    void Compile_RCP(Instruction instr);
+    void Compile_RSQ(Instruction instr);
+    void Compile_MOVA(Instruction instr);
+    void Compile_MOV(Instruction instr);
+    void Compile_NOP(Instruction instr);
+    void Compile_END(Instruction instr);
+    void Compile_CALL(Instruction instr);
+    void Compile_CALLC(Instruction instr);
+    void Compile_CALLU(Instruction instr);
+    void Compile_IF(Instruction instr);
+    void Compile_LOOP(Instruction instr);
+    void Compile_JMP(Instruction instr);
+    void Compile_EMIT(Instruction instr);
+    void Compile_SETE(Instruction instr);
+    void Compile_CMP(Instruction instr);
+    void Compile_MAD(Instruction instr);
+
+private:
+    void Compile_Block(unsigned end);
+    void Compile_NextInstr();
+
+    void Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRegister src_reg,
+                            Common::A64::VReg dest);
+    void Compile_DestEnable(Instruction instr, Common::A64::VReg dest);
+
+    /**
+     * Compiles a `MUL src1, src2` operation, properly handling the PICA semantics when multiplying
+     * zero by inf. Clobbers `src2`, `scratch` and SCRATCH2.
+     */
+    void Compile_SanitizedMul(Common::A64::VReg src1, Common::A64::VReg src2,
+                              Common::A64::VReg scratch);
+
+    /// Compiles the comparison of SRC1 and SRC2 used by `CMP`, setting `dest` to a lane mask
+    void Compile_Compare(Instruction::Common::CompareOpType::Op op, Common::A64::VReg dest);
+
+    /// Evaluates the condition of a flow control instruction into IP0, nonzero meaning true
+    void Compile_EvaluateCondition(Instruction instr);
+    /// Loads the boolean uniform tested by a flow control instruction into IP0
+    void Compile_UniformCondition(Instruction instr);
+
+    /**
+     * Emits the code to conditionally return from a subroutine envoked by the `CALL` instruction.
+     */
+    void Compile_Return();
+
+    /**
+     * Calls a host function. The SIMD registers used by the JIT aren't preserved across calls, so
+     * ONE is reloaded afterwards.
+     */
+    template <typename FunctionPtr>
+    void Compile_CallFunction(FunctionPtr function);
+
+    /**
+     * Assertion evaluated at compile-time, but only triggered if executed at runtime.
+     * @param condition Condition to be evaluated.
+     * @param msg       Message to be logged if the assertion fails.
+     */
+    void Compile_Assert(bool condition, const char* msg);
+
+    /**
+     * Analyzes the entire shader program for `CALL` instructions before emitting any code,
+     * identifying the locations where a return needs to be inserted.
+     */
+    void FindReturnOffsets();
+
+    const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code = nullptr;
+    const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data = nullptr;
+
+    /// Mapping of Pica VS instructions to locations in the emitted code
+    std::array<Common::A64::Label, MAX_PROGRAM_CODE_LENGTH> instruction_labels;
+
+    /// Offsets in code where a return needs to be inserted
+    std::vector<unsigned> return_offsets;
+
+    unsigned program_counter = 0; ///< Offset of the next instruction to decode
+    bool looping = false;         ///< True if compiling a loop, used to check for nested loops
+
+    using CompiledShader = void(const void* setup, void* state, const u8* start_addr);
+    CompiledShader* program = nullptr;
+};
+
+} // Shader
+
+} // Pica
@@ -2,8 +2,20 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "common/common_paths.h"
+#include "common/file_util.h"
 #include "common/hash.h"
+#include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/string_util.h"
+#include "common/thread.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_jit_x64.h"
 #include "video_core/shader/shader_jit_x64_compiler.h"
@@ -11,25 +23,96 @@
 namespace Pica {
 namespace Shader {
 
+namespace {
+
+/// Collects the programs of a cache file as it is being read
+class ProgramCollector : public LinearDiskCacheReader<u64, u32> {
+public:
+    explicit ProgramCollector(u32 program_source_length)
+        : program_source_length(program_source_length) {}
+
+    void Read(const u64& key, const u32* value, u32 value_size) override {
+        if (value_size != program_source_length) {
+            return;
+        }
+        programs.emplace_back(key, std::vector<u32>(value, value + value_size));
+    }
+
+    const u32 program_source_length;
+    std::vector<std::pair<u64, std::vector<u32>>> programs;
+};
+
+} // Anonymous namespace
+
 JitX64Engine::JitX64Engine() = default;
-JitX64Engine::~JitX64Engine() = default;
 
-void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
+JitX64Engine::~JitX64Engine() {
+    if (precompile_thread.joinable()) {
+        stop_precompiling = true;
+        precompile_thread.join();
+    }
+}
+
+void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point, u32 output_mask) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
 
-    u64 code_hash = Common::ComputeHash64(&setup.program_code, sizeof(setup.program_code));
-    u64 swizzle_hash = Common::ComputeHash64(&setup.swizzle_data, sizeof(setup.swizzle_data));
+    // Hashed in one pass rather than combining separate hashes of the pieces
+    const u64 entry_point_data = entry_point;
+    Common::HashState64 entry_hash;
+    entry_hash.Update(setup.program_code.data(), sizeof(setup.program_code));
+    entry_hash.Update(setup.swizzle_data.data(), sizeof(setup.swizzle_data));
+    entry_hash.Update(&entry_point_data, sizeof(entry_point_data));
+    const u64 entry_key = entry_hash.Digest();
 
-    u64 cache_key = code_hash ^ swizzle_hash;
-    auto iter = cache.find(cache_key);
-    if (iter != cache.end()) {
-        setup.engine_data.cached_shader = iter->second.get();
-    } else {
-        auto shader = std::make_unique<JitShader>();
-        shader->Compile(&setup.program_code, &setup.swizzle_data);
-        setup.engine_data.cached_shader = shader.get();
-        cache.emplace_hint(iter, cache_key, std::move(shader));
+    SetupBatchShader(setup, entry_key);
+
+    // Shaders are specialized for the uniforms their control flow depends on, the values of the
+    // others don't matter to the compiled code
+    const BranchUniforms uniforms = GetBranchUniforms(setup, entry_key);
+    ShaderSpecialization specialization{};
+    specialization.entry_point = entry_point;
+    specialization.output_mask = output_mask;
+    specialization.bool_uniform_mask = uniforms.bool_uniform_mask;
+    specialization.int_uniform_mask = uniforms.int_uniform_mask;
+    for (unsigned i = 0; i < setup.uniforms.b.size(); ++i) {
+        if (specialization.IsBoolUniformKnown(i) && setup.uniforms.b[i]) {
+            specialization.bool_uniforms |= 1u << i;
+        }
+    }
+    for (unsigned i = 0; i < setup.uniforms.i.size(); ++i) {
+        if (specialization.IsIntUniformKnown(i)) {
+            const Math::Vec4<u8>& value = setup.uniforms.i[i];
+            specialization.int_uniforms[i] = value.x | (value.y << 8) | (value.z << 16) |
+                                             (static_cast<u32>(value.w) << 24);
+        }
+    }
+
+    const u64 cache_key =
+        entry_key ^ Common::ComputeHash64(&specialization, sizeof(specialization));
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto iter = cache.find(cache_key);
+        if (iter != cache.end()) {
+            lru_order.splice(lru_order.begin(), lru_order, iter->second.lru_position);
+            setup.engine_data.cached_shader = iter->second.shader.get();
+            return;
+        }
+    }
+
+    auto shader = std::make_unique<JitShader>();
+    shader->Compile(&setup.program_code, &setup.swizzle_data, specialization);
+    setup.engine_data.cached_shader = InsertShader(cache_key, std::move(shader), true);
+
+    if (disk_cache_open && disk_cache_keys.insert(cache_key).second) {
+        std::vector<u32> source(PROGRAM_SOURCE_LENGTH);
+        std::copy(setup.program_code.begin(), setup.program_code.end(), source.begin());
+        std::copy(setup.swizzle_data.begin(), setup.swizzle_data.end(),
+                  source.begin() + MAX_PROGRAM_CODE_LENGTH);
+        std::memcpy(source.data() + MAX_PROGRAM_CODE_LENGTH + MAX_SWIZZLE_DATA_LENGTH,
+                    &specialization, sizeof(specialization));
+        disk_cache.Append(cache_key, source.data(), PROGRAM_SOURCE_LENGTH);
+        disk_cache.Sync();
     }
 }
 
@@ -44,5 +127,140 @@ void JitX64Engine::Run(const ShaderSetup& setup, UnitState& state) const {
     shader->Run(setup, state, setup.engine_data.entry_point);
 }
 
+void JitX64Engine::RunBatch(const ShaderSetup& setup, const ShaderRegs& config,
+                            const AttributeBuffer* inputs, AttributeBuffer* outputs,
+                            size_t count) const {
+    const JitBatchShader* shader =
+        static_cast<const JitBatchShader*>(setup.engine_data.cached_batch_shader);
+    if (shader == nullptr) {
+        ShaderEngine::RunBatch(setup, config, inputs, outputs, count);
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_Shader);
+
+    BatchUnitState state;
+    for (size_t first = 0; first < count; first += BATCH_SIZE) {
+        const size_t units = std::min(BATCH_SIZE, count - first);
+        state.LoadInputs(config, inputs + first, units);
+        shader->Run(setup, state, setup.engine_data.entry_point);
+        state.WriteOutputs(config, outputs + first, units);
+    }
+}
+
+BranchUniforms JitX64Engine::GetBranchUniforms(const ShaderSetup& setup, u64 entry_key) {
+    auto iter = branch_uniforms.find(entry_key);
+    if (iter == branch_uniforms.end()) {
+        const BranchUniforms uniforms =
+            FindBranchUniforms(setup.program_code, setup.engine_data.entry_point);
+        iter = branch_uniforms.emplace_hint(iter, entry_key, uniforms);
+    }
+    return iter->second;
+}
+
+void JitX64Engine::SetupBatchShader(ShaderSetup& setup, u64 entry_key) {
+    // Batch shaders only contain the code reachable from their entry point
+    auto iter = batch_cache.find(entry_key);
+    if (iter == batch_cache.end()) {
+        std::unique_ptr<JitBatchShader> shader;
+        const auto reachable =
+            JitBatchShader::FindReachableCode(setup.program_code, setup.engine_data.entry_point);
+        if (reachable) {
+            shader = std::make_unique<JitBatchShader>(reachable->count());
+            shader->Compile(&setup.program_code, &setup.swizzle_data, *reachable);
+        }
+        iter = batch_cache.emplace_hint(iter, entry_key, std::move(shader));
+    }
+    setup.engine_data.cached_batch_shader = iter->second.get();
+}
+
+void JitX64Engine::LoadDiskCache(u64 program_id) {
+    const std::string dir = FileUtil::GetUserPath(D_CACHE_IDX) + "shaders" DIR_SEP;
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(HW_GPU, "Failed to create shader cache directory %s", dir.c_str());
+        return;
+    }
+
+    const std::string filename =
+        dir + Common::StringFromFormat("%016" PRIX64 "_pica.bin", program_id);
+
+    ProgramCollector collector(PROGRAM_SOURCE_LENGTH);
+    disk_cache.OpenAndRead(filename.c_str(), collector);
+    disk_cache_open = true;
+
+    for (const auto& program : collector.programs) {
+        disk_cache_keys.insert(program.first);
+    }
+
+    LOG_INFO(HW_GPU, "Loaded %zu PICA shader programs from %s", collector.programs.size(),
+             filename.c_str());
+    if (!collector.programs.empty()) {
+        precompile_thread =
+            std::thread(&JitX64Engine::PrecompileShaders, this, std::move(collector.programs));
+    }
+}
+
+JitShader* JitX64Engine::InsertShader(u64 cache_key, std::unique_ptr<JitShader> shader,
+                                      bool in_use) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto iter = cache.find(cache_key);
+    if (iter == cache.end()) {
+        const auto position = lru_order.insert(in_use ? lru_order.begin() : lru_order.end(),
+                                               cache_key);
+        iter = cache.emplace(cache_key, CacheEntry{std::move(shader), position}).first;
+    } else if (in_use) {
+        lru_order.splice(lru_order.begin(), lru_order, iter->second.lru_position);
+    }
+
+    // Only shaders in use evict others: being the most recently used one, they can't evict
+    // themselves, and the shaders set up before them are done running
+    while (in_use && cache.size() > MAX_CACHED_SHADERS) {
+        cache.erase(lru_order.back());
+        lru_order.pop_back();
+    }
+    return iter->second.shader.get();
+}
+
+void JitX64Engine::PrecompileShaders(std::vector<std::pair<u64, std::vector<u32>>> programs) {
+    Common::SetCurrentThreadName("ShaderPrecompiler");
+
+    auto program_code = std::make_unique<std::array<u32, MAX_PROGRAM_CODE_LENGTH>>();
+    auto swizzle_data = std::make_unique<std::array<u32, MAX_SWIZZLE_DATA_LENGTH>>();
+    ShaderSpecialization specialization;
+    size_t num_compiled = 0;
+
+    for (const auto& program : programs) {
+        if (stop_precompiling) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            if (cache.size() >= MAX_CACHED_SHADERS) {
+                break;
+            }
+            if (cache.count(program.first) != 0) {
+                continue;
+            }
+        }
+
+        const std::vector<u32>& source = program.second;
+        std::copy(source.begin(), source.begin() + MAX_PROGRAM_CODE_LENGTH, program_code->begin());
+        std::copy(source.begin() + MAX_PROGRAM_CODE_LENGTH,
+                  source.begin() + MAX_PROGRAM_CODE_LENGTH + MAX_SWIZZLE_DATA_LENGTH,
+                  swizzle_data->begin());
+        std::memcpy(&specialization,
+                    source.data() + MAX_PROGRAM_CODE_LENGTH + MAX_SWIZZLE_DATA_LENGTH,
+                    sizeof(specialization));
+
+        auto shader = std::make_unique<JitShader>();
+        shader->Compile(program_code.get(), swizzle_data.get(), specialization);
+        InsertShader(program.first, std::move(shader), false);
+        ++num_compiled;
+    }
+
+    LOG_DEBUG(HW_GPU, "Precompiled %zu PICA shader programs", num_compiled);
+}
+
 } // namespace Shader
 } // namespace Pica
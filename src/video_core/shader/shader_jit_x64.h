@@ -4,14 +4,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include "common/common_types.h"
+#include "common/linear_disk_cache.h"
 #include "video_core/shader/shader.h"
+#include "video_core/shader/shader_analysis.h"
 
 namespace Pica {
 namespace Shader {
 
+class JitBatchShader;
 class JitShader;
 
 class JitX64Engine final : public ShaderEngine {
@@ -19,11 +29,70 @@ public:
     JitX64Engine();
     ~JitX64Engine() override;
 
-    void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
+    void SetupBatch(ShaderSetup& setup, unsigned int entry_point, u32 output_mask) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
+    void RunBatch(const ShaderSetup& setup, const ShaderRegs& config, const AttributeBuffer* inputs,
+                  AttributeBuffer* outputs, size_t count) const override;
+
+    /**
+     * Opens the shader cache file of the given title and compiles the programs stored in it on a
+     * background thread, so that they are ready by the time the title first uses them. Programs
+     * compiled afterwards are added to the file.
+     * @param program_id Program ID of the running title
+     */
+    void LoadDiskCache(u64 program_id);
 
 private:
-    std::unordered_map<u64, std::unique_ptr<JitShader>> cache;
+    /// Program code, swizzle data and specialization, the form programs are stored in on disk
+    static constexpr u32 PROGRAM_SOURCE_LENGTH = MAX_PROGRAM_CODE_LENGTH + MAX_SWIZZLE_DATA_LENGTH +
+                                                 sizeof(ShaderSpecialization) / sizeof(u32);
+
+    /// Upper bound of compiled shaders kept around, as each of them reserves MAX_SHADER_SIZE bytes
+    static constexpr size_t MAX_CACHED_SHADERS = 256;
+
+    /**
+     * Inserts a compiled shader unless another thread compiled it first, returns the cached one.
+     * @param in_use Whether the shader is about to be run. Shaders in use are marked as the most
+     *               recently used one and may evict the least recently used shader, precompiled
+     *               shaders are marked as the least recently used one instead.
+     */
+    JitShader* InsertShader(u64 cache_key, std::unique_ptr<JitShader> shader, bool in_use);
+
+    /// Returns the uniforms the control flow of the program and entry point in `setup` depends on
+    BranchUniforms GetBranchUniforms(const ShaderSetup& setup, u64 entry_key);
+
+    /// Looks up or compiles the batch shader of the program and entry point set up in `setup`
+    void SetupBatchShader(ShaderSetup& setup, u64 entry_key);
+
+    /// Compiles the programs read from the disk cache, stopping early on shutdown
+    void PrecompileShaders(std::vector<std::pair<u64, std::vector<u32>>> programs);
+
+    struct CacheEntry {
+        std::unique_ptr<JitShader> shader;
+        /// Position of the shader in `lru_order`
+        std::list<u64>::iterator lru_position;
+    };
+
+    /// Guards `cache` and `lru_order` against the precompilation thread
+    std::mutex cache_mutex;
+    /// Shaders by program and specialization
+    std::unordered_map<u64, CacheEntry> cache;
+    /// Keys of `cache`, from the most to the least recently used shader
+    std::list<u64> lru_order;
+
+    /// Uniforms branched on by program and entry point, see FindBranchUniforms
+    std::unordered_map<u64, BranchUniforms> branch_uniforms;
+
+    /// Batch shaders by program and entry point, nullptr for programs that can't be batched
+    std::unordered_map<u64, std::unique_ptr<JitBatchShader>> batch_cache;
+
+    LinearDiskCache<u64, u32> disk_cache;
+    bool disk_cache_open = false;
+    /// Keys of the programs already stored in the disk cache
+    std::unordered_set<u64> disk_cache_keys;
+
+    std::thread precompile_thread;
+    std::atomic<bool> stop_precompiling{false};
 };
 
 } // namespace Shader
@@ -75,8 +75,8 @@ const JitFunction instr_table[64] = {
     &JitShader::Compile_IF,    // ifu
     &JitShader::Compile_IF,    // ifc
     &JitShader::Compile_LOOP,  // loop
-    nullptr,                   // emit
-    nullptr,                   // sete
+    &JitShader::Compile_EMIT,  // emit
+    &JitShader::Compile_SETE,  // sete
     &JitShader::Compile_JMP,   // jmpc
     &JitShader::Compile_JMP,   // jmpu
     &JitShader::Compile_CMP,   // cmp
@@ -621,6 +621,14 @@ void JitShader::Compile_CALLC(Instruction instr) {
 }
 
 void JitShader::Compile_CALLU(Instruction instr) {
+    const unsigned bool_uniform_id = instr.flow_control.bool_uniform_id;
+    if (specialization.IsBoolUniformKnown(bool_uniform_id)) {
+        if (specialization.GetBoolUniform(bool_uniform_id)) {
+            Compile_CALL(instr);
+        }
+        return;
+    }
+
     Compile_UniformCondition(instr);
     Label b;
     jz(b);
@@ -693,13 +701,21 @@ void JitShader::Compile_IF(Instruction instr) {
                    "Backwards if-statements not supported");
     Label l_else, l_endif;
 
-    // Evaluate the "IF" condition
-    if (instr.opcode.Value() == OpCode::Id::IFU) {
-        Compile_UniformCondition(instr);
-    } else if (instr.opcode.Value() == OpCode::Id::IFC) {
-        Compile_EvaluateCondition(instr);
+    // Evaluate the "IF" condition, uniform conditions the program is specialized for are known
+    const unsigned bool_uniform_id = instr.flow_control.bool_uniform_id;
+    if (instr.opcode.Value() == OpCode::Id::IFU &&
+        specialization.IsBoolUniformKnown(bool_uniform_id)) {
+        if (!specialization.GetBoolUniform(bool_uniform_id)) {
+            jmp(l_else, T_NEAR);
+        }
+    } else {
+        if (instr.opcode.Value() == OpCode::Id::IFU) {
+            Compile_UniformCondition(instr);
+        } else if (instr.opcode.Value() == OpCode::Id::IFC) {
+            Compile_EvaluateCondition(instr);
+        }
+        jz(l_else, T_NEAR);
     }
-    jz(l_else, T_NEAR);
 
     // Compile the code that corresponds to the condition evaluating as true
     Compile_Block(instr.flow_control.dest_offset);
@@ -727,19 +743,46 @@ void JitShader::Compile_LOOP(Instruction instr) {
 
     looping = true;
 
-    // This decodes the fields from the integer uniform at index instr.flow_control.int_uniform_id.
-    // The Y (LOOPCOUNT_REG) and Z (LOOPINC) component are kept multiplied by 16 (Left shifted by
-    // 4 bits) to be used as an offset into the 16-byte vector registers later
-    size_t offset = ShaderSetup::GetIntUniformOffset(instr.flow_control.int_uniform_id);
-    mov(LOOPCOUNT, dword[SETUP + offset]);
-    mov(LOOPCOUNT_REG, LOOPCOUNT);
-    shr(LOOPCOUNT_REG, 4);
-    and_(LOOPCOUNT_REG, 0xFF0); // Y-component is the start
-    mov(LOOPINC, LOOPCOUNT);
-    shr(LOOPINC, 12);
-    and_(LOOPINC, 0xFF0);               // Z-component is the incrementer
-    movzx(LOOPCOUNT, LOOPCOUNT.cvt8()); // X-component is iteration count
-    add(LOOPCOUNT, 1);                  // Iteration count is X-component + 1
+    const unsigned int_uniform_id = instr.flow_control.int_uniform_id;
+    if (specialization.IsIntUniformKnown(int_uniform_id)) {
+        // The loop parameters are known, so they are set up with immediates instead. Short loops
+        // are unrolled, only leaving the updates of the loop counter register in between.
+        const u32 value = specialization.GetIntUniform(int_uniform_id);
+        const unsigned iterations = (value & 0xFF) + 1;
+        const u32 start = ((value >> 8) & 0xFF) * 16;
+        const u32 increment = ((value >> 16) & 0xFF) * 16;
+
+        mov(LOOPCOUNT_REG, start);
+        if (CanUnrollLoop(instr, iterations)) {
+            const unsigned body_start = program_counter;
+            for (unsigned iteration = 0; iteration < iterations; ++iteration) {
+                unrolled_copy = iteration != 0;
+                program_counter = body_start;
+                Compile_Block(instr.flow_control.dest_offset + 1);
+                add(LOOPCOUNT_REG, increment);
+            }
+            unrolled_copy = false;
+            looping = false;
+            return;
+        }
+
+        mov(LOOPCOUNT, iterations);
+        mov(LOOPINC, increment);
+    } else {
+        // This decodes the fields from the integer uniform at index int_uniform_id. The Y
+        // (LOOPCOUNT_REG) and Z (LOOPINC) component are kept multiplied by 16 (Left shifted by 4
+        // bits) to be used as an offset into the 16-byte vector registers later
+        size_t offset = ShaderSetup::GetIntUniformOffset(int_uniform_id);
+        mov(LOOPCOUNT, dword[SETUP + offset]);
+        mov(LOOPCOUNT_REG, LOOPCOUNT);
+        shr(LOOPCOUNT_REG, 4);
+        and_(LOOPCOUNT_REG, 0xFF0); // Y-component is the start
+        mov(LOOPINC, LOOPCOUNT);
+        shr(LOOPINC, 12);
+        and_(LOOPINC, 0xFF0);               // Z-component is the incrementer
+        movzx(LOOPCOUNT, LOOPCOUNT.cvt8()); // X-component is iteration count
+        add(LOOPCOUNT, 1);                  // Iteration count is X-component + 1
+    }
 
     Label l_loop_start;
     L(l_loop_start);
@@ -753,7 +796,72 @@ void JitShader::Compile_LOOP(Instruction instr) {
     looping = false;
 }
 
+bool JitShader::CanUnrollLoop(Instruction instr, unsigned iterations) {
+    const unsigned body_start = program_counter;
+    const unsigned body_end = instr.flow_control.dest_offset + 1;
+    if (body_end <= body_start || body_end > MAX_PROGRAM_CODE_LENGTH) {
+        return false;
+    }
+
+    unsigned body_length = 0;
+    for (unsigned offset = body_start; offset < body_end; ++offset) {
+        const Instruction body_instr = {(*program_code)[offset]};
+        if (body_instr.opcode.Value() == OpCode::Id::LOOP) {
+            return false;
+        }
+        if (analysis->IsReachable(offset) && !analysis->IsDead(offset)) {
+            ++body_length;
+        }
+    }
+    if ((iterations - 1) * body_length > unroll_budget) {
+        return false;
+    }
+
+    // Only the first copy of the body has the instruction labels, so nothing may jump into it
+    auto in_body = [&](unsigned offset) { return offset >= body_start && offset < body_end; };
+    if (in_body(specialization.entry_point)) {
+        return false;
+    }
+    for (unsigned offset = 0; offset < MAX_PROGRAM_CODE_LENGTH; ++offset) {
+        if (!analysis->IsReachable(offset)) {
+            continue;
+        }
+
+        const Instruction other = {(*program_code)[offset]};
+        switch (other.opcode.Value()) {
+        case OpCode::Id::JMPC:
+        case OpCode::Id::JMPU:
+        case OpCode::Id::CALL:
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU:
+            if (in_body(other.flow_control.dest_offset)) {
+                return false;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    unroll_budget -= (iterations - 1) * body_length;
+    return true;
+}
+
 void JitShader::Compile_JMP(Instruction instr) {
+    bool inverted_condition =
+        (instr.opcode.Value() == OpCode::Id::JMPU) && (instr.flow_control.num_instructions & 1);
+
+    Label& b = instruction_labels[instr.flow_control.dest_offset];
+
+    const unsigned bool_uniform_id = instr.flow_control.bool_uniform_id;
+    if (instr.opcode.Value() == OpCode::Id::JMPU &&
+        specialization.IsBoolUniformKnown(bool_uniform_id)) {
+        if (specialization.GetBoolUniform(bool_uniform_id) != inverted_condition) {
+            jmp(b, T_NEAR);
+        }
+        return;
+    }
+
     if (instr.opcode.Value() == OpCode::Id::JMPC)
         Compile_EvaluateCondition(instr);
     else if (instr.opcode.Value() == OpCode::Id::JMPU)
@@ -761,10 +869,6 @@ void JitShader::Compile_JMP(Instruction instr) {
     else
         UNREACHABLE();
 
-    bool inverted_condition =
-        (instr.opcode.Value() == OpCode::Id::JMPU) && (instr.flow_control.num_instructions & 1);
-
-    Label& b = instruction_labels[instr.flow_control.dest_offset];
     if (inverted_condition) {
         jz(b, T_NEAR);
     } else {
@@ -772,6 +876,52 @@ void JitShader::Compile_JMP(Instruction instr) {
     }
 }
 
+static void Emit(GSEmitter* emitter, Math::Vec4<float24> (*output)[16]) {
+    emitter->Emit(*output);
+}
+
+void JitShader::Compile_EMIT(Instruction instr) {
+    Label have_emitter, end;
+    mov(rax, qword[STATE + offsetof(UnitState, emitter_ptr)]);
+    test(rax, rax);
+    jnz(have_emitter);
+
+    ABI_PushRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
+    mov(ABI_PARAM1, reinterpret_cast<size_t>("Execute EMIT on VS"));
+    CallFarFunction(*this, LogCritical);
+    ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
+    jmp(end);
+
+    L(have_emitter);
+    ABI_PushRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
+    mov(ABI_PARAM1, rax);
+    lea(ABI_PARAM2, ptr[STATE + offsetof(UnitState, registers.output)]);
+    CallFarFunction(*this, Emit);
+    ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
+    L(end);
+}
+
+void JitShader::Compile_SETE(Instruction instr) {
+    const SetEmitInstruction setemit = {instr.hex};
+
+    Label have_emitter, end;
+    mov(rax, qword[STATE + offsetof(UnitState, emitter_ptr)]);
+    test(rax, rax);
+    jnz(have_emitter);
+
+    ABI_PushRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
+    mov(ABI_PARAM1, reinterpret_cast<size_t>("Execute SETEMIT on VS"));
+    CallFarFunction(*this, LogCritical);
+    ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
+    jmp(end);
+
+    L(have_emitter);
+    mov(byte[rax + offsetof(GSEmitter, vertex_id)], setemit.vertex_id.Value());
+    mov(byte[rax + offsetof(GSEmitter, prim_emit)], setemit.prim_emit.Value());
+    mov(byte[rax + offsetof(GSEmitter, winding)], setemit.winding.Value());
+    L(end);
+}
+
 void JitShader::Compile_Block(unsigned end) {
     while (program_counter < end) {
         Compile_NextInstr();
@@ -795,13 +945,25 @@ void JitShader::Compile_NextInstr() {
         Compile_Return();
     }
 
-    L(instruction_labels[program_counter]);
+    if (!unrolled_copy) {
+        L(instruction_labels[program_counter]);
+    }
 
     Instruction instr = {(*program_code)[program_counter++]};
 
     OpCode::Id opcode = instr.opcode.Value();
     auto instr_func = instr_table[static_cast<unsigned>(opcode)];
 
+    // Code that can't be executed under the specialization and writes that are never read don't
+    // need to be compiled. IF and LOOP are kept, since the analysis assumes the layout their blocks
+    // are compiled in.
+    const unsigned offset = program_counter - 1;
+    const bool is_block = opcode == OpCode::Id::IFU || opcode == OpCode::Id::IFC ||
+                          opcode == OpCode::Id::LOOP;
+    if ((!analysis->IsReachable(offset) && !is_block) || analysis->IsDead(offset)) {
+        return;
+    }
+
     if (instr_func) {
         // JIT the instruction!
         ((*this).*instr_func)(instr);
@@ -835,9 +997,18 @@ void JitShader::FindReturnOffsets() {
 }
 
 void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
-                        const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_) {
+                        const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_,
+                        const ShaderSpecialization& specialization_) {
     program_code = program_code_;
     swizzle_data = swizzle_data_;
+    specialization = specialization_;
+
+    const ProgramAnalysis program_analysis(*program_code, *swizzle_data, specialization);
+    analysis = &program_analysis;
+
+    // Unrolled loops may add as many instructions as are left out, MAX_SHADER_SIZE suffices then
+    unroll_budget = MAX_PROGRAM_CODE_LENGTH - analysis->NumReachable();
+    unrolled_copy = false;
 
     // Reset flow control state
     program = (CompiledShader*)getCurr();
@@ -881,6 +1052,7 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
     // Free memory that's no longer needed
     program_code = nullptr;
     swizzle_data = nullptr;
+    analysis = nullptr;
     return_offsets.clear();
     return_offsets.shrink_to_fit();
 
@@ -892,6 +1064,684 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
 
 JitShader::JitShader() : Xbyak::CodeGenerator(MAX_SHADER_SIZE) {}
 
+void BatchUnitState::LoadInputs(const ShaderRegs& config, const AttributeBuffer* inputs,
+                                size_t count) {
+    const unsigned max_attribute = config.max_input_attribute_index;
+
+    for (unsigned attr = 0; attr <= max_attribute; ++attr) {
+        Register& reg = registers.input[config.GetRegisterForAttribute(attr)];
+        for (size_t unit = 0; unit < BATCH_SIZE; ++unit) {
+            const Math::Vec4<float24>& value = inputs[unit < count ? unit : 0].attr[attr];
+            for (unsigned comp = 0; comp < 4; ++comp) {
+                reg[comp][unit] = value[comp].ToFloat32();
+            }
+        }
+    }
+}
+
+void BatchUnitState::WriteOutputs(const ShaderRegs& config, AttributeBuffer* outputs,
+                                  size_t count) const {
+    unsigned int output_i = 0;
+    for (unsigned int reg : Common::BitSet<u32>(config.output_mask)) {
+        const Register& value = registers.output[reg];
+        for (size_t unit = 0; unit < count; ++unit) {
+            for (unsigned comp = 0; comp < 4; ++comp) {
+                outputs[unit].attr[output_i][comp] = float24::FromFloat32(value[comp][unit]);
+            }
+        }
+        ++output_i;
+    }
+}
+
+typedef void (JitBatchShader::*JitBatchFunction)(Instruction instr);
+
+// Instructions left out here depend on state that differs between the shader units
+const JitBatchFunction batch_instr_table[64] = {
+    &JitBatchShader::Compile_ADD,   // add
+    &JitBatchShader::Compile_DP3,   // dp3
+    &JitBatchShader::Compile_DP4,   // dp4
+    &JitBatchShader::Compile_DPH,   // dph
+    nullptr,                        // unknown
+    &JitBatchShader::Compile_EX2,   // ex2
+    &JitBatchShader::Compile_LG2,   // lg2
+    nullptr,                        // unknown
+    &JitBatchShader::Compile_MUL,   // mul
+    &JitBatchShader::Compile_SGE,   // sge
+    &JitBatchShader::Compile_SLT,   // slt
+    &JitBatchShader::Compile_FLR,   // flr
+    &JitBatchShader::Compile_MAX,   // max
+    &JitBatchShader::Compile_MIN,   // min
+    &JitBatchShader::Compile_RCP,   // rcp
+    &JitBatchShader::Compile_RSQ,   // rsq
+    nullptr,                        // unknown
+    nullptr,                        // unknown
+    &JitBatchShader::Compile_MOVA,  // mova
+    &JitBatchShader::Compile_MOV,   // mov
+    nullptr,                        // unknown
+    nullptr,                        // unknown
+    nullptr,                        // unknown
+    nullptr,                        // unknown
+    &JitBatchShader::Compile_DPH,   // dphi
+    nullptr,                        // unknown
+    &JitBatchShader::Compile_SGE,   // sgei
+    &JitBatchShader::Compile_SLT,   // slti
+    nullptr,                        // unknown
+    nullptr,                        // unknown
+    nullptr,                        // unknown
+    nullptr,                        // unknown
+    nullptr,                        // unknown
+    &JitBatchShader::Compile_NOP,   // nop
+    &JitBatchShader::Compile_END,   // end
+    nullptr,                        // break
+    &JitBatchShader::Compile_CALL,  // call
+    nullptr,                        // callc
+    &JitBatchShader::Compile_CALLU, // callu
+    &JitBatchShader::Compile_IF,    // ifu
+    nullptr,                        // ifc
+    &JitBatchShader::Compile_LOOP,  // loop
+    nullptr,                        // emit
+    nullptr,                        // sete
+    nullptr,                        // jmpc
+    &JitBatchShader::Compile_JMP,   // jmpu
+    &JitBatchShader::Compile_CMP,   // cmp
+    &JitBatchShader::Compile_CMP,   // cmp
+    &JitBatchShader::Compile_MAD,   // madi
+    &JitBatchShader::Compile_MAD,   // madi
+    &JitBatchShader::Compile_MAD,   // madi
+    &JitBatchShader::Compile_MAD,   // madi
+    &JitBatchShader::Compile_MAD,   // madi
+    &JitBatchShader::Compile_MAD,   // madi
+    &JitBatchShader::Compile_MAD,   // madi
+    &JitBatchShader::Compile_MAD,   // madi
+    &JitBatchShader::Compile_MAD,   // mad
+    &JitBatchShader::Compile_MAD,   // mad
+    &JitBatchShader::Compile_MAD,   // mad
+    &JitBatchShader::Compile_MAD,   // mad
+    &JitBatchShader::Compile_MAD,   // mad
+    &JitBatchShader::Compile_MAD,   // mad
+    &JitBatchShader::Compile_MAD,   // mad
+    &JitBatchShader::Compile_MAD,   // mad
+};
+
+/// Results of the components of a batch shader instruction, before they are stored
+static const Xmm RESULT[] = {xmm8, xmm9, xmm10, xmm11};
+
+static bool IsMad(Instruction instr) {
+    return instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+           instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI;
+}
+
+/// Returns the number of the source that an instruction offsets by an address register
+static unsigned GetOffsetSource(Instruction instr) {
+    const bool is_inverted =
+        (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+    if (IsMad(instr)) {
+        return is_inverted ? 3 : 2;
+    }
+    return is_inverted ? 2 : 1;
+}
+
+static unsigned GetAddressRegisterIndex(Instruction instr) {
+    return IsMad(instr) ? instr.mad.address_register_index : instr.common.address_register_index;
+}
+
+/**
+ * Returns whether an arithmetic instruction reads its sources the same way for every unit. The
+ * address registers set by `MOVA` differ between units, the loop counter doesn't but is only
+ * supported for offsetting uniforms, which are shared by all units.
+ */
+static bool HasUniformAddressing(Instruction instr) {
+    const unsigned address_register_index = GetAddressRegisterIndex(instr);
+    if (address_register_index == 0) {
+        return true;
+    }
+    if (address_register_index != 3) {
+        return false;
+    }
+
+    const bool is_inverted =
+        (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+    SourceRegister offset_src;
+    if (IsMad(instr)) {
+        offset_src = is_inverted ? instr.mad.src3i.Value() : instr.mad.src2.Value();
+    } else {
+        offset_src = is_inverted ? instr.common.src2i.Value() : instr.common.src1.Value();
+    }
+    return offset_src.GetRegisterType() == RegisterType::FloatUniform;
+}
+
+boost::optional<std::bitset<MAX_PROGRAM_CODE_LENGTH>> JitBatchShader::FindReachableCode(
+    const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code, unsigned entry_point) {
+    std::bitset<MAX_PROGRAM_CODE_LENGTH> reachable;
+    std::vector<unsigned> pending{entry_point};
+
+    while (!pending.empty()) {
+        const unsigned offset = pending.back();
+        pending.pop_back();
+        if (offset >= MAX_PROGRAM_CODE_LENGTH || reachable[offset]) {
+            continue;
+        }
+        reachable[offset] = true;
+
+        const Instruction instr = {program_code[offset]};
+        const OpCode::Id opcode = instr.opcode.Value();
+        if (!batch_instr_table[static_cast<unsigned>(opcode)]) {
+            return boost::none;
+        }
+
+        switch (opcode) {
+        case OpCode::Id::END:
+            continue;
+
+        case OpCode::Id::CALL:
+        case OpCode::Id::CALLU:
+        case OpCode::Id::JMPU:
+            pending.push_back(instr.flow_control.dest_offset);
+            break;
+
+        case OpCode::Id::IFU:
+            // Only forward blocks are supported, the ELSE block starts at the destination
+            if (instr.flow_control.dest_offset < offset) {
+                return boost::none;
+            }
+            pending.push_back(instr.flow_control.dest_offset);
+            break;
+
+        case OpCode::Id::LOOP: {
+            // The loop body follows the instruction. Only forward, non-nested loops are supported.
+            const unsigned end = instr.flow_control.dest_offset;
+            if (end < offset || end >= MAX_PROGRAM_CODE_LENGTH) {
+                return boost::none;
+            }
+            for (unsigned body = offset + 1; body <= end; ++body) {
+                if (Instruction{program_code[body]}.opcode.Value() == OpCode::Id::LOOP) {
+                    return boost::none;
+                }
+            }
+            break;
+        }
+
+        case OpCode::Id::NOP:
+            break;
+
+        default:
+            if (!HasUniformAddressing(instr)) {
+                return boost::none;
+            }
+            break;
+        }
+
+        pending.push_back(offset + 1);
+    }
+
+    return reachable;
+}
+
+void JitBatchShader::Compile_SwizzleSrc(Instruction instr, unsigned src_num,
+                                        SourceRegister src_reg, unsigned component, Xmm dest) {
+    const unsigned operand_desc_id =
+        IsMad(instr) ? instr.mad.operand_desc_id : instr.common.operand_desc_id;
+    SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
+
+    // The raw selector holds the source component of the X component in its top bits
+    const unsigned selected = (swiz.GetRawSelector(src_num) >> (6 - 2 * component)) & 3;
+
+    if (src_reg.GetRegisterType() == RegisterType::FloatUniform) {
+        const size_t src_offset = ShaderSetup::GetFloatUniformOffset(src_reg.GetIndex()) +
+                                  selected * sizeof(float24);
+        const int src_offset_disp = (int)src_offset;
+        ASSERT_MSG(src_offset == src_offset_disp, "Source register offset too large for int type");
+
+        // Uniforms are shared by all units, so load the component once and broadcast it
+        if (src_num == GetOffsetSource(instr) && GetAddressRegisterIndex(instr) == 3) {
+            movss(dest, dword[SETUP + LOOPCOUNT_REG.cvt64() + src_offset_disp]);
+        } else {
+            movss(dest, dword[SETUP + src_offset_disp]);
+        }
+        shufps(dest, dest, _MM_SHUFFLE(0, 0, 0, 0));
+    } else {
+        const size_t src_offset =
+            BatchUnitState::InputOffset(src_reg) + selected * sizeof(BatchUnitState::Component);
+        movaps(dest, xword[STATE + src_offset]);
+    }
+
+    // If the source register should be negated, flip the negative bit using XOR
+    const bool negate[] = {swiz.negate_src1, swiz.negate_src2, swiz.negate_src3};
+    if (negate[src_num - 1]) {
+        xorps(dest, NEGBIT);
+    }
+}
+
+void JitBatchShader::Compile_DestEnable(Instruction instr, bool scalar_result) {
+    const unsigned operand_desc_id =
+        IsMad(instr) ? instr.mad.operand_desc_id : instr.common.operand_desc_id;
+    const DestRegister dest = IsMad(instr) ? instr.mad.dest.Value() : instr.common.dest.Value();
+    SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
+
+    const size_t dest_offset = BatchUnitState::OutputOffset(dest);
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        if (swiz.DestComponentEnabled(comp)) {
+            movaps(xword[STATE + dest_offset + comp * sizeof(BatchUnitState::Component)],
+                   RESULT[scalar_result ? 0 : comp]);
+        }
+    }
+}
+
+void JitBatchShader::Compile_SanitizedMul(Xmm src1, Xmm src2, Xmm scratch) {
+    movaps(scratch, src1);
+    cmpordps(scratch, src2);
+
+    mulps(src1, src2);
+
+    movaps(src2, src1);
+    cmpunordps(src2, src2);
+
+    xorps(scratch, src2);
+    andps(src1, scratch);
+}
+
+void JitBatchShader::Compile_DotProduct(Instruction instr, SourceRegister src1,
+                                        SourceRegister src2, unsigned num_components,
+                                        bool homogeneous) {
+    for (unsigned comp = 0; comp < num_components; ++comp) {
+        if (homogeneous && comp == 3) {
+            movaps(RESULT[comp], ONE);
+        } else {
+            Compile_SwizzleSrc(instr, 1, src1, comp, RESULT[comp]);
+        }
+        Compile_SwizzleSrc(instr, 2, src2, comp, SRC2);
+        Compile_SanitizedMul(RESULT[comp], SRC2, SCRATCH);
+    }
+
+    // Sum in the same order as JitShader, (x + y) + z and (x + y) + (z + w), so that both backends
+    // round alike
+    addps(RESULT[0], RESULT[1]);
+    if (num_components == 3) {
+        addps(RESULT[0], RESULT[2]);
+    } else {
+        addps(RESULT[2], RESULT[3]);
+        addps(RESULT[0], RESULT[2]);
+    }
+
+    Compile_DestEnable(instr, true);
+}
+
+static void Exp2ForEachUnit(float* values) {
+    for (size_t unit = 0; unit < BATCH_SIZE; ++unit) {
+        values[unit] = exp2f(values[unit]);
+    }
+}
+
+static void Log2ForEachUnit(float* values) {
+    for (size_t unit = 0; unit < BATCH_SIZE; ++unit) {
+        values[unit] = log2f(values[unit]);
+    }
+}
+
+void JitBatchShader::Compile_CallForEachUnit(Instruction instr, void (*func)(float* values)) {
+    const size_t operand_offset = offsetof(BatchUnitState, call_operand);
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0, SRC1);
+    movaps(xword[STATE + operand_offset], SRC1);
+
+    ABI_PushRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
+    lea(ABI_PARAM1, ptr[STATE + operand_offset]);
+    CallFarFunction(*this, func);
+    ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
+
+    movaps(RESULT[0], xword[STATE + operand_offset]);
+    Compile_DestEnable(instr, true);
+}
+
+void JitBatchShader::Compile_UniformCondition(Instruction instr) {
+    size_t offset = ShaderSetup::GetBoolUniformOffset(instr.flow_control.bool_uniform_id);
+    cmp(byte[SETUP + offset], 0);
+}
+
+BitSet32 JitBatchShader::PersistentCallerSavedRegs() {
+    return persistent_regs & ABI_ALL_CALLER_SAVED;
+}
+
+void JitBatchShader::Compile_ADD(Instruction instr) {
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, comp, RESULT[comp]);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, comp, SRC2);
+        addps(RESULT[comp], SRC2);
+    }
+    Compile_DestEnable(instr, false);
+}
+
+void JitBatchShader::Compile_DP3(Instruction instr) {
+    Compile_DotProduct(instr, instr.common.src1, instr.common.src2, 3, false);
+}
+
+void JitBatchShader::Compile_DP4(Instruction instr) {
+    Compile_DotProduct(instr, instr.common.src1, instr.common.src2, 4, false);
+}
+
+void JitBatchShader::Compile_DPH(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::DPHI) {
+        Compile_DotProduct(instr, instr.common.src1i, instr.common.src2i, 4, true);
+    } else {
+        Compile_DotProduct(instr, instr.common.src1, instr.common.src2, 4, true);
+    }
+}
+
+void JitBatchShader::Compile_EX2(Instruction instr) {
+    Compile_CallForEachUnit(instr, Exp2ForEachUnit);
+}
+
+void JitBatchShader::Compile_LG2(Instruction instr) {
+    Compile_CallForEachUnit(instr, Log2ForEachUnit);
+}
+
+void JitBatchShader::Compile_MUL(Instruction instr) {
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, comp, RESULT[comp]);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, comp, SRC2);
+        Compile_SanitizedMul(RESULT[comp], SRC2, SCRATCH);
+    }
+    Compile_DestEnable(instr, false);
+}
+
+void JitBatchShader::Compile_SGE(Instruction instr) {
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SGEI;
+    const SourceRegister src1 =
+        is_inverted ? instr.common.src1i.Value() : instr.common.src1.Value();
+    const SourceRegister src2 =
+        is_inverted ? instr.common.src2i.Value() : instr.common.src2.Value();
+
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        Compile_SwizzleSrc(instr, 1, src1, comp, SRC1);
+        Compile_SwizzleSrc(instr, 2, src2, comp, RESULT[comp]);
+        cmpleps(RESULT[comp], SRC1);
+        andps(RESULT[comp], ONE);
+    }
+    Compile_DestEnable(instr, false);
+}
+
+void JitBatchShader::Compile_SLT(Instruction instr) {
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SLTI;
+    const SourceRegister src1 =
+        is_inverted ? instr.common.src1i.Value() : instr.common.src1.Value();
+    const SourceRegister src2 =
+        is_inverted ? instr.common.src2i.Value() : instr.common.src2.Value();
+
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        Compile_SwizzleSrc(instr, 1, src1, comp, RESULT[comp]);
+        Compile_SwizzleSrc(instr, 2, src2, comp, SRC2);
+        cmpltps(RESULT[comp], SRC2);
+        andps(RESULT[comp], ONE);
+    }
+    Compile_DestEnable(instr, false);
+}
+
+void JitBatchShader::Compile_FLR(Instruction instr) {
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, comp, RESULT[comp]);
+        if (Common::GetCPUCaps().sse4_1) {
+            roundps(RESULT[comp], RESULT[comp], _MM_FROUND_FLOOR);
+        } else {
+            cvttps2dq(RESULT[comp], RESULT[comp]);
+            cvtdq2ps(RESULT[comp], RESULT[comp]);
+        }
+    }
+    Compile_DestEnable(instr, false);
+}
+
+void JitBatchShader::Compile_MAX(Instruction instr) {
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, comp, RESULT[comp]);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, comp, SRC2);
+        // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
+        maxps(RESULT[comp], SRC2);
+    }
+    Compile_DestEnable(instr, false);
+}
+
+void JitBatchShader::Compile_MIN(Instruction instr) {
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, comp, RESULT[comp]);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, comp, SRC2);
+        // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
+        minps(RESULT[comp], SRC2);
+    }
+    Compile_DestEnable(instr, false);
+}
+
+void JitBatchShader::Compile_RCP(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0, SRC1);
+    // Gives the same approximation as the RCPSS used by JitShader
+    rcpps(RESULT[0], SRC1);
+    Compile_DestEnable(instr, true);
+}
+
+void JitBatchShader::Compile_RSQ(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0, SRC1);
+    // Gives the same approximation as the RSQRTSS used by JitShader
+    rsqrtps(RESULT[0], SRC1);
+    Compile_DestEnable(instr, true);
+}
+
+void JitBatchShader::Compile_MOVA(Instruction instr) {
+    // Programs with reachable code reading the address registers aren't batched
+}
+
+void JitBatchShader::Compile_MOV(Instruction instr) {
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, comp, RESULT[comp]);
+    }
+    Compile_DestEnable(instr, false);
+}
+
+void JitBatchShader::Compile_NOP(Instruction instr) {}
+
+void JitBatchShader::Compile_END(Instruction instr) {
+    ABI_PopRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 16);
+    ret();
+}
+
+void JitBatchShader::Compile_CALL(Instruction instr) {
+    // Push offset of the return
+    push(qword, (instr.flow_control.dest_offset + instr.flow_control.num_instructions));
+
+    // Call the subroutine
+    call(instruction_labels[instr.flow_control.dest_offset]);
+
+    // Skip over the return offset that's on the stack
+    add(rsp, 8);
+}
+
+void JitBatchShader::Compile_CALLU(Instruction instr) {
+    Compile_UniformCondition(instr);
+    Label b;
+    jz(b);
+    Compile_CALL(instr);
+    L(b);
+}
+
+void JitBatchShader::Compile_CMP(Instruction instr) {
+    // Programs with reachable code reading the conditional codes aren't batched
+}
+
+void JitBatchShader::Compile_MAD(Instruction instr) {
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI;
+    const SourceRegister src2 = is_inverted ? instr.mad.src2i.Value() : instr.mad.src2.Value();
+    const SourceRegister src3 = is_inverted ? instr.mad.src3i.Value() : instr.mad.src3.Value();
+
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        Compile_SwizzleSrc(instr, 1, instr.mad.src1, comp, RESULT[comp]);
+        Compile_SwizzleSrc(instr, 2, src2, comp, SRC2);
+        Compile_SwizzleSrc(instr, 3, src3, comp, SRC3);
+        Compile_SanitizedMul(RESULT[comp], SRC2, SCRATCH);
+        addps(RESULT[comp], SRC3);
+    }
+    Compile_DestEnable(instr, false);
+}
+
+void JitBatchShader::Compile_IF(Instruction instr) {
+    Label l_else, l_endif;
+
+    Compile_UniformCondition(instr);
+    jz(l_else, T_NEAR);
+
+    // Compile the code that corresponds to the condition evaluating as true
+    Compile_Block(instr.flow_control.dest_offset);
+
+    // If there isn't an "ELSE" condition, we are done here
+    if (instr.flow_control.num_instructions == 0) {
+        L(l_else);
+        return;
+    }
+
+    jmp(l_endif, T_NEAR);
+
+    L(l_else);
+    // Compile the code that corresponds to the condition evaluating as false
+    Compile_Block(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+
+    L(l_endif);
+}
+
+void JitBatchShader::Compile_LOOP(Instruction instr) {
+    looping = true;
+
+    // Same decoding as JitShader::Compile_LOOP, the loop counter is shared by all units
+    size_t offset = ShaderSetup::GetIntUniformOffset(instr.flow_control.int_uniform_id);
+    mov(LOOPCOUNT, dword[SETUP + offset]);
+    mov(LOOPCOUNT_REG, LOOPCOUNT);
+    shr(LOOPCOUNT_REG, 4);
+    and_(LOOPCOUNT_REG, 0xFF0); // Y-component is the start
+    mov(LOOPINC, LOOPCOUNT);
+    shr(LOOPINC, 12);
+    and_(LOOPINC, 0xFF0);               // Z-component is the incrementer
+    movzx(LOOPCOUNT, LOOPCOUNT.cvt8()); // X-component is iteration count
+    add(LOOPCOUNT, 1);                  // Iteration count is X-component + 1
+
+    Label l_loop_start;
+    L(l_loop_start);
+
+    Compile_Block(instr.flow_control.dest_offset + 1);
+
+    add(LOOPCOUNT_REG, LOOPINC); // Increment LOOPCOUNT_REG by Z-component
+    sub(LOOPCOUNT, 1);           // Increment loop count by 1
+    jnz(l_loop_start);           // Loop if not equal
+
+    looping = false;
+}
+
+void JitBatchShader::Compile_JMP(Instruction instr) {
+    Compile_UniformCondition(instr);
+
+    bool inverted_condition = (instr.flow_control.num_instructions & 1);
+
+    Label& b = instruction_labels[instr.flow_control.dest_offset];
+    if (inverted_condition) {
+        jz(b, T_NEAR);
+    } else {
+        jnz(b, T_NEAR);
+    }
+}
+
+void JitBatchShader::Compile_Block(unsigned end) {
+    while (program_counter < end) {
+        Compile_NextInstr();
+    }
+}
+
+void JitBatchShader::Compile_Return() {
+    // Peek return offset on the stack and check if we're at that offset
+    mov(rax, qword[rsp + 8]);
+    cmp(eax, (program_counter));
+
+    // If so, jump back to before CALL
+    Label b;
+    jnz(b);
+    ret();
+    L(b);
+}
+
+void JitBatchShader::Compile_NextInstr() {
+    if (std::binary_search(return_offsets.begin(), return_offsets.end(), program_counter)) {
+        Compile_Return();
+    }
+
+    L(instruction_labels[program_counter]);
+
+    const bool is_reachable = reachable[program_counter];
+    Instruction instr = {(*program_code)[program_counter++]};
+
+    // Unreachable instructions can't be jumped to, so no code is needed for them. FindReachableCode
+    // made sure that the reachable ones are all supported.
+    if (is_reachable) {
+        const OpCode::Id opcode = instr.opcode.Value();
+        auto instr_func = batch_instr_table[static_cast<unsigned>(opcode)];
+        ((*this).*instr_func)(instr);
+    }
+}
+
+void JitBatchShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
+                             const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_,
+                             const std::bitset<MAX_PROGRAM_CODE_LENGTH>& reachable_) {
+    program_code = program_code_;
+    swizzle_data = swizzle_data_;
+    reachable = reachable_;
+
+    // Reset flow control state
+    program = (CompiledShader*)getCurr();
+    program_counter = 0;
+    looping = false;
+    instruction_labels.fill(Xbyak::Label());
+
+    // Identify the return locations of the reachable `CALL` instructions
+    return_offsets.clear();
+    for (size_t offset = 0; offset < program_code->size(); ++offset) {
+        Instruction instr = {(*program_code)[offset]};
+        if (reachable[offset] && (instr.opcode.Value() == OpCode::Id::CALL ||
+                                  instr.opcode.Value() == OpCode::Id::CALLU)) {
+            return_offsets.push_back(instr.flow_control.dest_offset +
+                                     instr.flow_control.num_instructions);
+        }
+    }
+    std::sort(return_offsets.begin(), return_offsets.end());
+
+    // Same frame as JitShader, including the dummy return offset
+    ABI_PushRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 16);
+    mov(qword[rsp + 8], 0xFFFFFFFFFFFFFFFFULL);
+
+    mov(SETUP, ABI_PARAM1);
+    mov(STATE, ABI_PARAM2);
+
+    xor_(LOOPCOUNT_REG, LOOPCOUNT_REG);
+
+    static const __m128 one = {1.f, 1.f, 1.f, 1.f};
+    mov(rax, reinterpret_cast<size_t>(&one));
+    movaps(ONE, xword[rax]);
+
+    static const __m128 neg = {-0.f, -0.f, -0.f, -0.f};
+    mov(rax, reinterpret_cast<size_t>(&neg));
+    movaps(NEGBIT, xword[rax]);
+
+    // Jump to start of the shader program
+    jmp(ABI_PARAM3);
+
+    // Compile entire program
+    Compile_Block(static_cast<unsigned>(program_code->size()));
+
+    // Free memory that's no longer needed
+    program_code = nullptr;
+    swizzle_data = nullptr;
+    return_offsets.clear();
+    return_offsets.shrink_to_fit();
+
+    ready();
+
+    LOG_DEBUG(HW_GPU, "Compiled batch shader size=%lu", getSize());
+}
+
+JitBatchShader::JitBatchShader(size_t num_instructions)
+    : Xbyak::CodeGenerator(num_instructions * MAX_BATCH_INSTRUCTION_SIZE + 4096) {}
+
 } // namespace Shader
 
 } // namespace Pica
@@ -5,14 +5,17 @@
 #pragma once
 
 #include <array>
+#include <bitset>
 #include <cstddef>
 #include <utility>
 #include <vector>
+#include <boost/optional.hpp>
 #include <nihstro/shader_bytecode.h>
 #include <xbyak.h>
 #include "common/bit_set.h"
 #include "common/common_types.h"
 #include "video_core/shader/shader.h"
+#include "video_core/shader/shader_analysis.h"
 
 using nihstro::Instruction;
 using nihstro::OpCode;
@@ -37,8 +40,13 @@ public:
         program(&setup, &state, instruction_labels[offset].getAddress());
     }
 
+    /**
+     * Compiles the code reachable from the entry point of the specialization, leaving out the
+     * instructions found to be dead. The result may only be run with the specialization's state.
+     */
     void Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code,
-                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data);
+                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data,
+                 const ShaderSpecialization& specialization);
 
     void Compile_ADD(Instruction instr);
     void Compile_DP3(Instruction instr);
@@ -64,6 +72,8 @@ public:
     void Compile_IF(Instruction instr);
     void Compile_LOOP(Instruction instr);
     void Compile_JMP(Instruction instr);
+    void Compile_EMIT(Instruction instr);
+    void Compile_SETE(Instruction instr);
     void Compile_CMP(Instruction instr);
     void Compile_MAD(Instruction instr);
 
@@ -89,6 +99,12 @@ private:
      */
     void Compile_Return();
 
+    /**
+     * Checks whether the body of a loop with a known iteration count can be compiled once per
+     * iteration, taking the unrolled instructions from `unroll_budget` if so.
+     */
+    bool CanUnrollLoop(Instruction instr, unsigned iterations);
+
     BitSet32 PersistentCallerSavedRegs();
 
     /**
@@ -107,9 +123,184 @@ private:
     const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code = nullptr;
     const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data = nullptr;
 
+    /// State the program is compiled for and the analysis of the program under it
+    ShaderSpecialization specialization{};
+    const ProgramAnalysis* analysis = nullptr;
+
+    /// Mapping of Pica VS instructions to pointers in the emitted code
+    std::array<Xbyak::Label, MAX_PROGRAM_CODE_LENGTH> instruction_labels;
+
+    /// Offsets in code where a return needs to be inserted
+    std::vector<unsigned> return_offsets;
+
+    unsigned program_counter = 0; ///< Offset of the next instruction to decode
+    bool looping = false;         ///< True if compiling a loop, used to check for nested loops
+
+    /// True while compiling the second and later copies of an unrolled loop body, which don't
+    /// get instruction labels
+    bool unrolled_copy = false;
+    /// Number of instructions loop unrolling may still add to the compiled code
+    unsigned unroll_budget = 0;
+
+    using CompiledShader = void(const void* setup, void* state, const u8* start_addr);
+    CompiledShader* program = nullptr;
+};
+
+/// Number of shader units a JitBatchShader runs per invocation
+constexpr size_t BATCH_SIZE = 4;
+
+/// Memory allocated for each instruction of a batch shader, the components are handled one by one
+constexpr size_t MAX_BATCH_INSTRUCTION_SIZE = 512;
+
+/**
+ * Registers of BATCH_SIZE shader units in structure-of-arrays layout. Each component of each
+ * register is a vector holding that component for all of the units, so compiled code can process
+ * every unit with the same instructions and swizzles don't need any shuffling.
+ */
+struct BatchUnitState {
+    /// One component of a register, for each of the units
+    using Component = std::array<float, BATCH_SIZE>;
+    using Register = std::array<Component, 4>;
+
+    struct Registers {
+        alignas(16) std::array<Register, 16> input;
+        alignas(16) std::array<Register, 16> temporary;
+        alignas(16) std::array<Register, 16> output;
+    } registers;
+
+    /// Operand of library functions called for each of the units, for example exp2f
+    alignas(16) Component call_operand;
+
+    static size_t InputOffset(const SourceRegister& reg) {
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Input:
+            return offsetof(BatchUnitState, registers.input) + reg.GetIndex() * sizeof(Register);
+
+        case RegisterType::Temporary:
+            return offsetof(BatchUnitState, registers.temporary) +
+                   reg.GetIndex() * sizeof(Register);
+
+        default:
+            UNREACHABLE();
+            return 0;
+        }
+    }
+
+    static size_t OutputOffset(const DestRegister& reg) {
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Output:
+            return offsetof(BatchUnitState, registers.output) + reg.GetIndex() * sizeof(Register);
+
+        case RegisterType::Temporary:
+            return offsetof(BatchUnitState, registers.temporary) +
+                   reg.GetIndex() * sizeof(Register);
+
+        default:
+            UNREACHABLE();
+            return 0;
+        }
+    }
+
+    /**
+     * Loads the input registers of the first `count` units with the given vertices. The remaining
+     * units are loaded with the first vertex, so that they don't compute on garbage.
+     */
+    void LoadInputs(const ShaderRegs& config, const AttributeBuffer* inputs, size_t count);
+
+    /// Writes the output registers of the first `count` units to the given vertices
+    void WriteOutputs(const ShaderRegs& config, AttributeBuffer* outputs, size_t count) const;
+};
+
+/**
+ * This class implements a second backend of the shader JIT compiler, which runs a Pica shader
+ * program for BATCH_SIZE shader units at once. All units share one instruction stream, so only
+ * programs whose control flow and relative addressing are the same for every unit are supported:
+ * the part of the program reachable from the entry point must not branch on the conditional codes,
+ * nor index registers with an address register set by `MOVA`.
+ */
+class JitBatchShader : public Xbyak::CodeGenerator {
+public:
+    /// Returns the instructions reachable from `entry_point`, or boost::none if any is unsupported
+    static boost::optional<std::bitset<MAX_PROGRAM_CODE_LENGTH>> FindReachableCode(
+        const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code, unsigned entry_point);
+
+    /// Allocates memory for compiling `num_instructions` instructions
+    explicit JitBatchShader(size_t num_instructions);
+
+    void Run(const ShaderSetup& setup, BatchUnitState& state, unsigned offset) const {
+        program(&setup, &state, instruction_labels[offset].getAddress());
+    }
+
+    /// Compiles the instructions of the program set in `reachable`, others are left out
+    void Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code,
+                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data,
+                 const std::bitset<MAX_PROGRAM_CODE_LENGTH>& reachable);
+
+    void Compile_ADD(Instruction instr);
+    void Compile_DP3(Instruction instr);
+    void Compile_DP4(Instruction instr);
+    void Compile_DPH(Instruction instr);
+    void Compile_EX2(Instruction instr);
+    void Compile_LG2(Instruction instr);
+    void Compile_MUL(Instruction instr);
+    void Compile_SGE(Instruction instr);
+    void Compile_SLT(Instruction instr);
+    void Compile_FLR(Instruction instr);
+    void Compile_MAX(Instruction instr);
+    void Compile_MIN(Instruction instr);
+    void Compile_RCP(Instruction instr);
+    void Compile_RSQ(Instruction instr);
+    void Compile_MOVA(Instruction instr);
+    void Compile_MOV(Instruction instr);
+    void Compile_NOP(Instruction instr);
+    void Compile_END(Instruction instr);
+    void Compile_CALL(Instruction instr);
+    void Compile_CALLU(Instruction instr);
+    void Compile_IF(Instruction instr);
+    void Compile_LOOP(Instruction instr);
+    void Compile_JMP(Instruction instr);
+    void Compile_CMP(Instruction instr);
+    void Compile_MAD(Instruction instr);
+
+private:
+    void Compile_Block(unsigned end);
+    void Compile_NextInstr();
+
+    /// Loads one component of a swizzled source register, for all units, into `dest`
+    void Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRegister src_reg,
+                            unsigned component, Xbyak::Xmm dest);
+
+    /**
+     * Stores the results of an instruction to the enabled components of its destination register.
+     * Instructions with a scalar result have it in the first result register, which is stored to
+     * all enabled components.
+     */
+    void Compile_DestEnable(Instruction instr, bool scalar_result);
+
+    /// See JitShader::Compile_SanitizedMul
+    void Compile_SanitizedMul(Xbyak::Xmm src1, Xbyak::Xmm src2, Xbyak::Xmm scratch);
+
+    /// Computes the dot product of the first `num_components` components of two sources
+    void Compile_DotProduct(Instruction instr, SourceRegister src1, SourceRegister src2,
+                            unsigned num_components, bool homogeneous);
+
+    /// Calls `func` on the first component of the first source for each unit
+    void Compile_CallForEachUnit(Instruction instr, void (*func)(float* values));
+
+    void Compile_UniformCondition(Instruction instr);
+    void Compile_Return();
+
+    BitSet32 PersistentCallerSavedRegs();
+
+    const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code = nullptr;
+    const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data = nullptr;
+
     /// Mapping of Pica VS instructions to pointers in the emitted code
     std::array<Xbyak::Label, MAX_PROGRAM_CODE_LENGTH> instruction_labels;
 
+    /// Instructions reachable from the entry point, only these are compiled
+    std::bitset<MAX_PROGRAM_CODE_LENGTH> reachable;
+
     /// Offsets in code where a return needs to be inserted
     std::vector<unsigned> return_offsets;
 
@@ -0,0 +1,99 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include "common/math_util.h"
+#include "common/microprofile.h"
+#include "common/thread_pool.h"
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/binner.h"
+
+namespace Pica {
+namespace Rasterizer {
+
+/// Number of queued triangles after which the queue is flushed, bounding its memory use
+constexpr size_t MAX_QUEUED_TRIANGLES = 16384;
+
+MICROPROFILE_DEFINE(GPU_Binning, "GPU", "Tile Binning", MP_RGB(50, 50, 240));
+
+TileBinner::TileBinner(size_t num_threads)
+    : pool(std::make_unique<Common::ThreadPool>(num_threads > 1 ? num_threads - 1 : 0)) {}
+
+TileBinner::~TileBinner() = default;
+
+void TileBinner::AddTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
+    if (triangles.size() >= MAX_QUEUED_TRIANGLES)
+        Flush();
+
+    if (triangles.empty()) {
+        const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
+        width = framebuffer.GetWidth();
+        height = framebuffer.GetHeight();
+        tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+        tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+        bins.resize(tiles_x * tiles_y);
+    }
+
+    // Pixels outside the framebuffer aren't drawn. The bounds are widened by a pixel to be safe
+    // from rounding, covering a tile too many only costs some time.
+    const float min_x = std::min({v0.screenpos.x, v1.screenpos.x, v2.screenpos.x}).ToFloat32();
+    const float min_y = std::min({v0.screenpos.y, v1.screenpos.y, v2.screenpos.y}).ToFloat32();
+    const float max_x = std::max({v0.screenpos.x, v1.screenpos.x, v2.screenpos.x}).ToFloat32();
+    const float max_y = std::max({v0.screenpos.y, v1.screenpos.y, v2.screenpos.y}).ToFloat32();
+    const int x0 = std::max(static_cast<int>(std::floor(min_x)) - 1, 0);
+    const int y0 = std::max(static_cast<int>(std::floor(min_y)) - 1, 0);
+    const int x1 = std::min(static_cast<int>(std::ceil(max_x)) + 1, static_cast<int>(width));
+    const int y1 = std::min(static_cast<int>(std::ceil(max_y)) + 1, static_cast<int>(height));
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    const u32 index = static_cast<u32>(triangles.size());
+    triangles.push_back({v0, v1, v2});
+
+    const unsigned tile_x0 = x0 / TILE_SIZE;
+    const unsigned tile_y0 = y0 / TILE_SIZE;
+    const unsigned tile_x1 = (x1 - 1) / TILE_SIZE;
+    const unsigned tile_y1 = (y1 - 1) / TILE_SIZE;
+    for (unsigned tile_y = tile_y0; tile_y <= tile_y1; ++tile_y) {
+        for (unsigned tile_x = tile_x0; tile_x <= tile_x1; ++tile_x) {
+            const u32 bin = tile_y * tiles_x + tile_x;
+            if (bins[bin].empty())
+                used_bins.push_back(bin);
+            bins[bin].push_back(index);
+        }
+    }
+}
+
+void TileBinner::Flush() {
+    if (triangles.empty())
+        return;
+
+    MICROPROFILE_SCOPE(GPU_Binning);
+
+    pool->ParallelFor(used_bins.size(), 1, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const u32 bin = used_bins[i];
+            const unsigned tile_x = bin % tiles_x;
+            const unsigned tile_y = bin / tiles_x;
+            const MathUtil::Rectangle<u16> clip(
+                static_cast<u16>(tile_x * TILE_SIZE), static_cast<u16>(tile_y * TILE_SIZE),
+                static_cast<u16>(std::min((tile_x + 1) * TILE_SIZE, width)),
+                static_cast<u16>(std::min((tile_y + 1) * TILE_SIZE, height)));
+
+            for (u32 index : bins[bin]) {
+                const Triangle& triangle = triangles[index];
+                ProcessTriangle(triangle.v0, triangle.v1, triangle.v2, clip);
+            }
+        }
+    });
+
+    for (u32 bin : used_bins)
+        bins[bin].clear();
+    used_bins.clear();
+    triangles.clear();
+}
+
+} // namespace Rasterizer
+} // namespace Pica
@@ -0,0 +1,67 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "video_core/swrasterizer/rasterizer.h"
+
+namespace Common {
+class ThreadPool;
+}
+
+namespace Pica {
+namespace Rasterizer {
+
+/**
+ * Queues triangles, sorts them into screen tiles and rasterizes the tiles across a pool of
+ * threads. Each tile draws the triangles overlapping it in the order they were queued, and no two
+ * threads touch the same pixel, so depth testing and blending give the same results as rasterizing
+ * serially.
+ *
+ * Queued triangles are drawn with the Pica state that is current when they are flushed, so the
+ * queue has to be flushed before that state changes.
+ */
+class TileBinner : NonCopyable {
+public:
+    /// Width and height of a tile in pixels
+    static constexpr unsigned TILE_SIZE = 32;
+
+    explicit TileBinner(size_t num_threads);
+    ~TileBinner();
+
+    void AddTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+
+    /// Rasterizes all queued triangles, returning once they are written to the framebuffer
+    void Flush();
+
+private:
+    struct Triangle {
+        Vertex v0;
+        Vertex v1;
+        Vertex v2;
+    };
+
+    std::unique_ptr<Common::ThreadPool> pool;
+
+    std::vector<Triangle> triangles;
+    /// Indices of the queued triangles overlapping each tile, row by row
+    std::vector<std::vector<u32>> bins;
+    /// Tiles that have at least one triangle queued
+    std::vector<u32> used_bins;
+
+    /// Framebuffer dimensions in tiles, as of the first queued triangle
+    unsigned tiles_x = 0;
+    unsigned tiles_y = 0;
+    /// Framebuffer dimensions in pixels, as of the first queued triangle
+    unsigned width = 0;
+    unsigned height = 0;
+};
+
+} // namespace Rasterizer
+} // namespace Pica
@@ -15,6 +15,7 @@
 #include "video_core/pica_types.h"
 #include "video_core/shader/shader.h"
 #include "video_core/swrasterizer/clipper.h"
+#include "video_core/swrasterizer/float24x4.h"
 #include "video_core/swrasterizer/rasterizer.h"
 
 using Pica::Rasterizer::Vertex;
@@ -28,10 +29,10 @@ public:
     ClippingEdge(Math::Vec4<float24> coeffs, Math::Vec4<float24> bias = Math::Vec4<float24>(
                                                  float24::FromFloat32(0), float24::FromFloat32(0),
                                                  float24::FromFloat32(0), float24::FromFloat32(0)))
-        : coeffs(coeffs), bias(bias) {}
+        : coeffs(Float24x4::Load(coeffs)), bias(Float24x4::Load(bias)) {}
 
     bool IsInside(const Vertex& vertex) const {
-        return Math::Dot(vertex.pos + bias, coeffs) <= float24::FromFloat32(0);
+        return GetDistance(vertex) <= float24::FromFloat32(0);
     }
 
     bool IsOutSide(const Vertex& vertex) const {
@@ -39,17 +40,21 @@ public:
     }
 
     Vertex GetIntersection(const Vertex& v0, const Vertex& v1) const {
-        float24 dp = Math::Dot(v0.pos + bias, coeffs);
-        float24 dp_prev = Math::Dot(v1.pos + bias, coeffs);
+        float24 dp = GetDistance(v0);
+        float24 dp_prev = GetDistance(v1);
         float24 factor = dp_prev / (dp_prev - dp);
 
         return Vertex::Lerp(factor, v0, v1);
     }
 
 private:
-    float24 pos;
-    Math::Vec4<float24> coeffs;
-    Math::Vec4<float24> bias;
+    /// Signed distance of the vertex to the edge, positive outside of it
+    float24 GetDistance(const Vertex& vertex) const {
+        return (Float24x4::Load(vertex.pos) + bias).Dot(coeffs);
+    }
+
+    Float24x4 coeffs;
+    Float24x4 bias;
 };
 
 static void InitScreenCoordinates(Vertex& vtx) {
@@ -70,13 +75,15 @@ static void InitScreenCoordinates(Vertex& vtx) {
 
     float24 inv_w = float24::FromFloat32(1.f) / vtx.pos.w;
     vtx.pos.w = inv_w;
-    vtx.quat *= inv_w;
-    vtx.color *= inv_w;
-    vtx.tc0 *= inv_w;
-    vtx.tc1 *= inv_w;
-    vtx.tc0_w *= inv_w;
-    vtx.view *= inv_w;
-    vtx.tc2 *= inv_w;
+
+    // Everything after the position is divided by w, four words at a time: quat, color, tc0 and
+    // tc1, tc0_w to view.y, and view.z to tc2. The padding words are multiplied along.
+    constexpr size_t num_words = sizeof(Shader::OutputVertex) / sizeof(float24) - 4;
+    const Float24x4 inv_w_lanes = Float24x4::Splat(inv_w);
+    float24* attributes = &vtx.quat.x;
+    for (size_t i = 0; i < num_words; i += 4) {
+        (Float24x4::Load(attributes + i) * inv_w_lanes).Store(attributes + i);
+    }
 
     vtx.screenpos[0] =
         (vtx.pos.x * inv_w + float24::FromFloat32(1.0)) * viewport.halfsize_x + viewport.offset_x;
@@ -85,7 +92,8 @@ static void InitScreenCoordinates(Vertex& vtx) {
     vtx.screenpos[2] = vtx.pos.z * inv_w;
 }
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     const TriangleHandler& triangle_handler) {
     using boost::container::static_vector;
 
     // Clipping a planar n-gon against a plane will remove at least 1 vertex and introduces 2 at
@@ -129,9 +137,28 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
     //       drop the whole primitive instead of clipping the primitive properly. We should test if
     //       this happens on the 3DS, too.
 
+    // Outcodes of the vertices, with bit i set if the vertex is outside clipping edge i
+    std::array<u32, 3> outcodes{};
+    for (size_t v = 0; v < outcodes.size(); ++v) {
+        for (size_t i = 0; i < clipping_edges.size(); ++i) {
+            if (clipping_edges[i].IsOutSide(buffer_a[v]))
+                outcodes[v] |= 1 << i;
+        }
+    }
+
+    // Nothing is left of a triangle with all of its vertices outside the same edge
+    if ((outcodes[0] & outcodes[1] & outcodes[2]) != 0)
+        return;
+
+    // Edges with all vertices inside leave the triangle as it is. Most triangles are entirely
+    // inside and skip the clipping loop altogether.
+    const u32 crossed_edges = outcodes[0] | outcodes[1] | outcodes[2];
+
     // Simple implementation of the Sutherland-Hodgman clipping algorithm.
-    // TODO: Make this less inefficient (currently lots of useless buffering overhead happens here)
-    for (auto edge : clipping_edges) {
+    for (size_t i = 0; i < clipping_edges.size(); ++i) {
+        if ((crossed_edges & (1 << i)) == 0)
+            continue;
+        const ClippingEdge& edge = clipping_edges[i];
 
         std::swap(input_list, output_list);
         output_list->clear();
@@ -181,7 +208,7 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
                   vtx1.screenpos.z.ToFloat32(), vtx2.screenpos.x.ToFloat32(),
                   vtx2.screenpos.y.ToFloat32(), vtx2.screenpos.z.ToFloat32());
 
-        Rasterizer::ProcessTriangle(vtx0, vtx1, vtx2);
+        triangle_handler(vtx0, vtx1, vtx2);
     }
 }
 
@@ -4,17 +4,29 @@
 
 #pragma once
 
+#include <functional>
+
 namespace Pica {
 
 namespace Shader {
 struct OutputVertex;
 }
 
+namespace Rasterizer {
+struct Vertex;
+}
+
 namespace Clipper {
 
 using Shader::OutputVertex;
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
+/// Receives the triangles in screen coordinates that a clipped primitive is split into
+using TriangleHandler = std::function<void(const Rasterizer::Vertex& v0,
+                                           const Rasterizer::Vertex& v1,
+                                           const Rasterizer::Vertex& v2)>;
+
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     const TriangleHandler& triangle_handler);
 
 } // namespace
 
@@ -0,0 +1,49 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "video_core/swrasterizer/coverage.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+namespace Pica {
+namespace Rasterizer {
+
+u16 GetBlockCoverage(const std::array<int, 3>& w_origin, const std::array<int, 3>& w_step_x,
+                     const std::array<int, 3>& w_step_y) {
+    u16 coverage = 0;
+#ifdef ARCHITECTURE_x86_64
+    // Evaluate a row of the block at once
+    __m128i w[3];
+    __m128i step_y[3];
+    for (int i = 0; i < 3; ++i) {
+        w[i] = _mm_add_epi32(_mm_set1_epi32(w_origin[i]),
+                             _mm_setr_epi32(0, w_step_x[i], 2 * w_step_x[i], 3 * w_step_x[i]));
+        step_y[i] = _mm_set1_epi32(w_step_y[i]);
+    }
+    for (int row = 0; row < BLOCK_SIZE; ++row) {
+        // The sign bit of the combined coordinates is set if any of them is negative
+        const __m128i any_negative = _mm_or_si128(_mm_or_si128(w[0], w[1]), w[2]);
+        const int uncovered = _mm_movemask_ps(_mm_castsi128_ps(any_negative));
+        coverage |= (~uncovered & 0xF) << (BLOCK_SIZE * row);
+        for (int i = 0; i < 3; ++i)
+            w[i] = _mm_add_epi32(w[i], step_y[i]);
+    }
+#else
+    for (int row = 0; row < BLOCK_SIZE; ++row) {
+        for (int column = 0; column < BLOCK_SIZE; ++column) {
+            const int w0 = w_origin[0] + column * w_step_x[0] + row * w_step_y[0];
+            const int w1 = w_origin[1] + column * w_step_x[1] + row * w_step_y[1];
+            const int w2 = w_origin[2] + column * w_step_x[2] + row * w_step_y[2];
+            if ((w0 | w1 | w2) >= 0)
+                coverage |= 1 << (BLOCK_SIZE * row + column);
+        }
+    }
+#endif
+    return coverage;
+}
+
+} // namespace Rasterizer
+} // namespace Pica
@@ -0,0 +1,112 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+namespace Pica {
+namespace Rasterizer {
+
+/// Width and height of the blocks of pixels triangles are rasterized in
+constexpr int BLOCK_SIZE = 4;
+/// Coverage mask of a block with all of its pixels covered
+constexpr u16 FULL_BLOCK_COVERAGE = 0xFFFF;
+
+/**
+ * Returns which pixels of a block are covered by a triangle, as a mask with bit 4 * row + column
+ * set for each covered pixel. Pixels are covered unless one of their barycentric coordinates is
+ * negative.
+ * @param w_origin Barycentric coordinates of the topleft pixel of the block
+ * @param w_step_x Change of the coordinates from one pixel to the next one in the row
+ * @param w_step_y Change of the coordinates from one pixel to the next one in the column
+ */
+u16 GetBlockCoverage(const std::array<int, 3>& w_origin, const std::array<int, 3>& w_step_x,
+                     const std::array<int, 3>& w_step_y);
+
+/**
+ * Calls `process_pixel(x, y, w0, w1, w2)` for each pixel of the bounding box covered by a
+ * triangle, passing the center of the pixel and its barycentric coordinates. All positions are
+ * given in 12.4 fixed point rasterizer coordinates.
+ *
+ * The barycentric coordinates are affine functions of the pixel position, so they change by a
+ * constant amount from one pixel to the next. The bounding box is walked in blocks of 4x4 pixels:
+ * Blocks lying entirely outside of an edge are skipped, blocks lying entirely inside of all edges
+ * are processed without testing each pixel, and the pixels of the others are tested a row at a
+ * time.
+ *
+ * @param vtxpos Positions of the vertices, wound counter-clockwise
+ * @param bias Values added to the barycentric coordinates to implement the filling rules
+ * @param min_x, min_y Topleft corner of the bounding box, at a pixel boundary
+ * @param max_x, max_y Bottomright corner of the bounding box, at a pixel boundary
+ */
+template <typename ProcessPixel>
+void ForEachCoveredPixel(const std::array<Math::Vec2<int>, 3>& vtxpos,
+                         const std::array<int, 3>& bias, unsigned min_x, unsigned min_y,
+                         unsigned max_x, unsigned max_y, ProcessPixel&& process_pixel) {
+    const Math::Vec2<int> edges[3][2] = {
+        {vtxpos[1], vtxpos[2]}, {vtxpos[2], vtxpos[0]}, {vtxpos[0], vtxpos[1]}};
+    std::array<int, 3> w_step_x;
+    std::array<int, 3> w_step_y;
+    for (int i = 0; i < 3; ++i) {
+        w_step_x[i] = -0x10 * (edges[i][1].y - edges[i][0].y);
+        w_step_y[i] = 0x10 * (edges[i][1].x - edges[i][0].x);
+    }
+
+    for (unsigned block_y = min_y; block_y < max_y; block_y += BLOCK_SIZE * 0x10) {
+        for (unsigned block_x = min_x; block_x < max_x; block_x += BLOCK_SIZE * 0x10) {
+            // Start at the center of the topleft pixel of the block
+            const int x0 = static_cast<int>(block_x + 8);
+            const int y0 = static_cast<int>(block_y + 8);
+
+            std::array<int, 3> w_origin;
+            bool outside = false;
+            bool inside = true;
+            for (int i = 0; i < 3; ++i) {
+                // Signed area of the triangle spanned by the edge and the pixel center
+                const Math::Vec2<int> edge = edges[i][1] - edges[i][0];
+                w_origin[i] = bias[i] + edge.x * (y0 - edges[i][0].y) -
+                              edge.y * (x0 - edges[i][0].x);
+
+                // The extremes over the block are found at its corners
+                const int dx = (BLOCK_SIZE - 1) * w_step_x[i];
+                const int dy = (BLOCK_SIZE - 1) * w_step_y[i];
+                outside |= w_origin[i] + std::max(dx, 0) + std::max(dy, 0) < 0;
+                inside &= w_origin[i] + std::min(dx, 0) + std::min(dy, 0) >= 0;
+            }
+            if (outside)
+                continue;
+
+            u16 coverage =
+                inside ? FULL_BLOCK_COVERAGE : GetBlockCoverage(w_origin, w_step_x, w_step_y);
+
+            // Drop the pixels past the right and bottom edges of the bounding box
+            const int columns = std::min(BLOCK_SIZE, (static_cast<int>(max_x) - x0 + 0xF) / 0x10);
+            const int rows = std::min(BLOCK_SIZE, (static_cast<int>(max_y) - y0 + 0xF) / 0x10);
+            u16 bounds = 0;
+            for (int row = 0; row < rows; ++row)
+                bounds |= ((1 << columns) - 1) << (BLOCK_SIZE * row);
+            coverage &= bounds;
+
+            for (int row = 0; row < BLOCK_SIZE; ++row) {
+                for (int column = 0; column < BLOCK_SIZE; ++column) {
+                    if (!(coverage & (1 << (BLOCK_SIZE * row + column))))
+                        continue;
+
+                    const int w0 = w_origin[0] + column * w_step_x[0] + row * w_step_y[0];
+                    const int w1 = w_origin[1] + column * w_step_x[1] + row * w_step_y[1];
+                    const int w2 = w_origin[2] + column * w_step_x[2] + row * w_step_y[2];
+                    process_pixel(static_cast<u16>(x0 + 0x10 * column),
+                                  static_cast<u16>(y0 + 0x10 * row), w0, w1, w2);
+                }
+            }
+        }
+    }
+}
+
+} // namespace Rasterizer
+} // namespace Pica
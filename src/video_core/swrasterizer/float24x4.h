@@ -0,0 +1,145 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/vector_math.h"
+#include "video_core/pica_types.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <xmmintrin.h>
+#endif
+
+namespace Pica {
+
+/**
+ * Four float24 values operated on at once. Every lane gives exactly the result of the same
+ * float24 operation, including multiplications by zero yielding zero even for infinite factors,
+ * so code using this computes the same values as with Math::Vec4<float24>.
+ */
+class Float24x4 {
+public:
+    Float24x4() = default;
+
+    /// Loads four consecutive values, which don't need to be aligned
+    static Float24x4 Load(const float24* values) {
+        Float24x4 ret;
+#ifdef ARCHITECTURE_x86_64
+        ret.lanes = _mm_loadu_ps(reinterpret_cast<const float*>(values));
+#else
+        for (size_t i = 0; i < 4; ++i)
+            ret.lanes[i] = values[i];
+#endif
+        return ret;
+    }
+
+    static Float24x4 Load(const Math::Vec4<float24>& vec) {
+        return Load(&vec.x);
+    }
+
+    /// Sets all four lanes to the same value
+    static Float24x4 Splat(float24 value) {
+        Float24x4 ret;
+#ifdef ARCHITECTURE_x86_64
+        ret.lanes = _mm_set1_ps(value.ToFloat32());
+#else
+        for (size_t i = 0; i < 4; ++i)
+            ret.lanes[i] = value;
+#endif
+        return ret;
+    }
+
+    /// Stores the four lanes to consecutive values, which don't need to be aligned
+    void Store(float24* values) const {
+#ifdef ARCHITECTURE_x86_64
+        _mm_storeu_ps(reinterpret_cast<float*>(values), lanes);
+#else
+        for (size_t i = 0; i < 4; ++i)
+            values[i] = lanes[i];
+#endif
+    }
+
+    void Store(Math::Vec4<float24>& vec) const {
+        Store(&vec.x);
+    }
+
+    float24 operator[](size_t lane) const {
+#ifdef ARCHITECTURE_x86_64
+        alignas(16) float values[4];
+        _mm_store_ps(values, lanes);
+        return float24::FromFloat32(values[lane]);
+#else
+        return lanes[lane];
+#endif
+    }
+
+    Float24x4 operator+(const Float24x4& other) const {
+        Float24x4 ret;
+#ifdef ARCHITECTURE_x86_64
+        ret.lanes = _mm_add_ps(lanes, other.lanes);
+#else
+        for (size_t i = 0; i < 4; ++i)
+            ret.lanes[i] = lanes[i] + other.lanes[i];
+#endif
+        return ret;
+    }
+
+    Float24x4 operator-(const Float24x4& other) const {
+        Float24x4 ret;
+#ifdef ARCHITECTURE_x86_64
+        ret.lanes = _mm_sub_ps(lanes, other.lanes);
+#else
+        for (size_t i = 0; i < 4; ++i)
+            ret.lanes[i] = lanes[i] - other.lanes[i];
+#endif
+        return ret;
+    }
+
+    Float24x4 operator*(const Float24x4& other) const {
+        Float24x4 ret;
+#ifdef ARCHITECTURE_x86_64
+        // PICA gives 0 instead of NaN when multiplying by inf, so lanes where either factor is
+        // zero and the other one isn't NaN are cleared
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 clear =
+            _mm_or_ps(_mm_and_ps(_mm_cmpeq_ps(lanes, zero), _mm_cmpord_ps(other.lanes, zero)),
+                      _mm_and_ps(_mm_cmpeq_ps(other.lanes, zero), _mm_cmpord_ps(lanes, zero)));
+        ret.lanes = _mm_andnot_ps(clear, _mm_mul_ps(lanes, other.lanes));
+#else
+        for (size_t i = 0; i < 4; ++i)
+            ret.lanes[i] = lanes[i] * other.lanes[i];
+#endif
+        return ret;
+    }
+
+    /**
+     * Returns the dot product of the first `N` lanes with those of `other`, adding up the
+     * products in the same order as Math::Dot
+     */
+    template <size_t N = 4>
+    float24 Dot(const Float24x4& other) const {
+        static_assert(N >= 1 && N <= 4, "Invalid number of lanes");
+        float24 products[4];
+        (*this * other).Store(products);
+        float24 sum = products[0];
+        for (size_t i = 1; i < N; ++i)
+            sum = sum + products[i];
+        return sum;
+    }
+
+    /// Returns a * factor + b * (1 - factor), as Rasterizer::Vertex::Lerp interpolates
+    static Float24x4 Lerp(const Float24x4& factor, const Float24x4& a, const Float24x4& b) {
+        return a * factor + b * (Splat(float24::FromFloat32(1.f)) - factor);
+    }
+
+private:
+#ifdef ARCHITECTURE_x86_64
+    __m128 lanes;
+#else
+    float24 lanes[4];
+#endif
+};
+
+} // namespace Pica
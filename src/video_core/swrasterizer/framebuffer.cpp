@@ -256,6 +256,55 @@ u8 PerformStencilAction(FramebufferRegs::StencilAction action, u8 old_stencil, u
     }
 }
 
+namespace {
+
+template <FramebufferRegs::CompareFunc func>
+bool Compare(u32 a, u32 b) {
+    switch (func) {
+    case FramebufferRegs::CompareFunc::Always:
+        return true;
+    case FramebufferRegs::CompareFunc::Equal:
+        return a == b;
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return a != b;
+    case FramebufferRegs::CompareFunc::LessThan:
+        return a < b;
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return a <= b;
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return a > b;
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return a >= b;
+    case FramebufferRegs::CompareFunc::Never:
+    default:
+        return false;
+    }
+}
+
+} // Anonymous namespace
+
+CompareFunction GetCompareFunction(FramebufferRegs::CompareFunc func) {
+    switch (func) {
+    case FramebufferRegs::CompareFunc::Always:
+        return &Compare<FramebufferRegs::CompareFunc::Always>;
+    case FramebufferRegs::CompareFunc::Equal:
+        return &Compare<FramebufferRegs::CompareFunc::Equal>;
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return &Compare<FramebufferRegs::CompareFunc::NotEqual>;
+    case FramebufferRegs::CompareFunc::LessThan:
+        return &Compare<FramebufferRegs::CompareFunc::LessThan>;
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return &Compare<FramebufferRegs::CompareFunc::LessThanOrEqual>;
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return &Compare<FramebufferRegs::CompareFunc::GreaterThan>;
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return &Compare<FramebufferRegs::CompareFunc::GreaterThanOrEqual>;
+    case FramebufferRegs::CompareFunc::Never:
+    default:
+        return &Compare<FramebufferRegs::CompareFunc::Never>;
+    }
+}
+
 Math::Vec4<u8> EvaluateBlendEquation(const Math::Vec4<u8>& src, const Math::Vec4<u8>& srcfactor,
                                      const Math::Vec4<u8>& dest, const Math::Vec4<u8>& destfactor,
                                      FramebufferRegs::BlendEquation equation) {
@@ -19,6 +19,10 @@ void SetDepth(int x, int y, u32 value);
 void SetStencil(int x, int y, u8 value);
 u8 PerformStencilAction(FramebufferRegs::StencilAction action, u8 old_stencil, u8 ref);
 
+/// Evaluates the comparison `a <func> b` of the alpha, stencil and depth tests
+using CompareFunction = bool (*)(u32 a, u32 b);
+CompareFunction GetCompareFunction(FramebufferRegs::CompareFunc func);
+
 Math::Vec4<u8> EvaluateBlendEquation(const Math::Vec4<u8>& src, const Math::Vec4<u8>& srcfactor,
                                      const Math::Vec4<u8>& dest, const Math::Vec4<u8>& destfactor,
                                      FramebufferRegs::BlendEquation equation);
@@ -7,78 +7,132 @@
 
 namespace Pica {
 
-static float LookupLightingLut(const Pica::State::Lighting& lighting, size_t lut_index, u8 index,
-                               float delta) {
-    ASSERT_MSG(lut_index < lighting.luts.size(), "Out of range lut");
-    ASSERT_MSG(index < lighting.luts[lut_index].size(), "Out of range index");
+void LightingLuts::Update(const State::Lighting& lighting) {
+    for (size_t lut_index = 0; lut_index < luts.size(); ++lut_index) {
+        for (size_t index = 0; index < luts[lut_index].size(); ++index) {
+            const auto& entry = lighting.luts[lut_index][index];
+            luts[lut_index][index] = {entry.ToFloat(), entry.DiffToFloat()};
+        }
+    }
+}
 
-    const auto& lut = lighting.luts[lut_index][index];
+static float LookupLightingLut(const LightingLuts::Lut& lut, u8 index, float delta) {
+    const auto& entry = lut[index];
+    return entry.value + entry.difference * delta;
+}
 
-    float lut_value = lut.ToFloat();
-    float lut_diff = lut.DiffToFloat();
+LightingSetup::LightingSetup(const LightingRegs& regs, const LightingLuts& luts) {
+    if (regs.config0.bump_mode != LightingRegs::LightingBumpMode::None) {
+        LOG_CRITICAL(HW_GPU, "unimplemented bump mapping");
+        UNIMPLEMENTED();
+    }
 
-    return lut_value + lut_diff * delta;
+    auto MakeSampler = [&](bool disabled, LightingRegs::LightingSampler sampler,
+                           LightingRegs::LightingLutInput input, bool abs_disabled,
+                           LightingRegs::LightingScale scale) {
+        LutSampler result;
+        result.lut = nullptr;
+        if (!disabled && LightingRegs::IsLightingSamplerSupported(regs.config0.config, sampler))
+            result.lut = &luts.luts[static_cast<size_t>(sampler)];
+        result.input = input;
+        result.abs = !abs_disabled;
+        result.scale = regs.lut_scale.GetScale(scale);
+        return result;
+    };
+
+    using Sampler = LightingRegs::LightingSampler;
+    d0 = MakeSampler(regs.config1.disable_lut_d0, Sampler::Distribution0, regs.lut_input.d0,
+                     regs.abs_lut_input.disable_d0, regs.lut_scale.d0);
+    d1 = MakeSampler(regs.config1.disable_lut_d1, Sampler::Distribution1, regs.lut_input.d1,
+                     regs.abs_lut_input.disable_d1, regs.lut_scale.d1);
+    rr = MakeSampler(regs.config1.disable_lut_rr, Sampler::ReflectRed, regs.lut_input.rr,
+                     regs.abs_lut_input.disable_rr, regs.lut_scale.rr);
+    rg = MakeSampler(regs.config1.disable_lut_rg, Sampler::ReflectGreen, regs.lut_input.rg,
+                     regs.abs_lut_input.disable_rg, regs.lut_scale.rg);
+    rb = MakeSampler(regs.config1.disable_lut_rb, Sampler::ReflectBlue, regs.lut_input.rb,
+                     regs.abs_lut_input.disable_rb, regs.lut_scale.rb);
+    fr = MakeSampler(regs.config1.disable_lut_fr, Sampler::Fresnel, regs.lut_input.fr,
+                     regs.abs_lut_input.disable_fr, regs.lut_scale.fr);
+
+    using FresnelSelector = LightingRegs::LightingFresnelSelector;
+    fresnel_primary_alpha = regs.config0.fresnel_selector == FresnelSelector::PrimaryAlpha ||
+                            regs.config0.fresnel_selector == FresnelSelector::Both;
+    fresnel_secondary_alpha = regs.config0.fresnel_selector == FresnelSelector::SecondaryAlpha ||
+                              regs.config0.fresnel_selector == FresnelSelector::Both;
+    clamp_highlights = regs.config0.clamp_highlights != 0;
+    global_ambient = regs.global_ambient.ToVec3f();
+
+    num_lights = regs.max_light_index + 1;
+    for (unsigned light_index = 0; light_index < num_lights; ++light_index) {
+        const unsigned num = regs.light_enable.GetNum(light_index);
+        const auto& light_config = regs.light[num];
+        Light& light = lights[light_index];
+
+        light.position = {float16::FromRaw(light_config.x).ToFloat32(),
+                          float16::FromRaw(light_config.y).ToFloat32(),
+                          float16::FromRaw(light_config.z).ToFloat32()};
+        light.directional = light_config.config.directional != 0;
+        light.two_sided_diffuse = light_config.config.two_sided_diffuse != 0;
+
+        light.dist_atten_lut = nullptr;
+        if (!regs.IsDistAttenDisabled(num)) {
+            light.dist_atten_lut =
+                &luts.luts[static_cast<size_t>(Sampler::DistanceAttenuation) + num];
+        }
+        light.dist_atten_scale = Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
+        light.dist_atten_bias = Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
+
+        light.specular_0 = light_config.specular_0.ToVec3f();
+        light.specular_1 = light_config.specular_1.ToVec3f();
+        light.diffuse = light_config.diffuse.ToVec3f();
+        light.ambient = light_config.ambient.ToVec3f();
+    }
 }
 
-std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
-    const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view) {
+std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> LightingSetup::ComputeFragmentsColors(
+    const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view) const {
 
     // TODO(Subv): Bump mapping
     Math::Vec3<float> surface_normal = {0.0f, 0.0f, 1.0f};
 
-    if (lighting.config0.bump_mode != LightingRegs::LightingBumpMode::None) {
-        LOG_CRITICAL(HW_GPU, "unimplemented bump mapping");
-        UNIMPLEMENTED();
-    }
-
     // Use the normalized the quaternion when performing the rotation
     auto normal = Math::QuaternionRotate(normquat, surface_normal);
+    const Math::Vec3<float> norm_view = view.Normalized();
 
     Math::Vec4<float> diffuse_sum = {0.0f, 0.0f, 0.0f, 1.0f};
     Math::Vec4<float> specular_sum = {0.0f, 0.0f, 0.0f, 1.0f};
 
-    for (unsigned light_index = 0; light_index <= lighting.max_light_index; ++light_index) {
-        unsigned num = lighting.light_enable.GetNum(light_index);
-        const auto& light_config = lighting.light[num];
+    for (unsigned light_index = 0; light_index < num_lights; ++light_index) {
+        const Light& light = lights[light_index];
 
         Math::Vec3<float> refl_value = {};
-        Math::Vec3<float> position = {float16::FromRaw(light_config.x).ToFloat32(),
-                                      float16::FromRaw(light_config.y).ToFloat32(),
-                                      float16::FromRaw(light_config.z).ToFloat32()};
         Math::Vec3<float> light_vector;
 
-        if (light_config.config.directional)
-            light_vector = position;
+        if (light.directional)
+            light_vector = light.position;
         else
-            light_vector = position + view;
+            light_vector = light.position + view;
 
         light_vector.Normalize();
 
         float dist_atten = 1.0f;
-        if (!lighting.IsDistAttenDisabled(num)) {
-            auto distance = (-view - position).Length();
-            float scale = Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
-            float bias = Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
-            size_t lut =
-                static_cast<size_t>(LightingRegs::LightingSampler::DistanceAttenuation) + num;
-
-            float sample_loc = MathUtil::Clamp(scale * distance + bias, 0.0f, 1.0f);
+        if (light.dist_atten_lut != nullptr) {
+            auto distance = (-view - light.position).Length();
+            float sample_loc = MathUtil::Clamp(
+                light.dist_atten_scale * distance + light.dist_atten_bias, 0.0f, 1.0f);
 
             u8 lutindex =
                 static_cast<u8>(MathUtil::Clamp(std::floor(sample_loc * 256.0f), 0.0f, 255.0f));
             float delta = sample_loc * 256 - lutindex;
-            dist_atten = LookupLightingLut(lighting_state, lut, lutindex, delta);
+            dist_atten = LookupLightingLut(*light.dist_atten_lut, lutindex, delta);
         }
 
-        auto GetLutValue = [&](LightingRegs::LightingLutInput input, bool abs,
-                               LightingRegs::LightingScale scale_enum,
-                               LightingRegs::LightingSampler sampler) {
-            Math::Vec3<float> norm_view = view.Normalized();
-            Math::Vec3<float> half_angle = (norm_view + light_vector).Normalized();
+        const Math::Vec3<float> half_angle = (norm_view + light_vector).Normalized();
+
+        auto GetLutValue = [&](const LutSampler& sampler) {
             float result = 0.0f;
 
-            switch (input) {
+            switch (sampler.input) {
             case LightingRegs::LightingLutInput::NH:
                 result = Math::Dot(normal, half_angle);
                 break;
@@ -96,7 +150,8 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
                 break;
 
             default:
-                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input %u\n", static_cast<u32>(input));
+                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input %u\n",
+                             static_cast<u32>(sampler.input));
                 UNIMPLEMENTED();
                 result = 0.0f;
             }
@@ -104,8 +159,8 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
             u8 index;
             float delta;
 
-            if (abs) {
-                if (light_config.config.two_sided_diffuse)
+            if (sampler.abs) {
+                if (light.two_sided_diffuse)
                     result = std::abs(result);
                 else
                     result = std::max(result, 0.0f);
@@ -120,119 +175,66 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
                 index = static_cast<u8>(signed_index);
             }
 
-            float scale = lighting.lut_scale.GetScale(scale_enum);
-            return scale *
-                   LookupLightingLut(lighting_state, static_cast<size_t>(sampler), index, delta);
+            return sampler.scale * LookupLightingLut(*sampler.lut, index, delta);
         };
 
         // Specular 0 component
         float d0_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d0 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution0)) {
-            d0_lut_value =
-                GetLutValue(lighting.lut_input.d0, lighting.abs_lut_input.disable_d0 == 0,
-                            lighting.lut_scale.d0, LightingRegs::LightingSampler::Distribution0);
-        }
+        if (d0.lut != nullptr)
+            d0_lut_value = GetLutValue(d0);
 
-        Math::Vec3<float> specular_0 = d0_lut_value * light_config.specular_0.ToVec3f();
+        Math::Vec3<float> specular_0 = d0_lut_value * light.specular_0;
 
         // If enabled, lookup ReflectRed value, otherwise, 1.0 is used
-        if (lighting.config1.disable_lut_rr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectRed)) {
-            refl_value.x =
-                GetLutValue(lighting.lut_input.rr, lighting.abs_lut_input.disable_rr == 0,
-                            lighting.lut_scale.rr, LightingRegs::LightingSampler::ReflectRed);
-        } else {
-            refl_value.x = 1.0f;
-        }
+        refl_value.x = rr.lut != nullptr ? GetLutValue(rr) : 1.0f;
 
         // If enabled, lookup ReflectGreen value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rg == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectGreen)) {
-            refl_value.y =
-                GetLutValue(lighting.lut_input.rg, lighting.abs_lut_input.disable_rg == 0,
-                            lighting.lut_scale.rg, LightingRegs::LightingSampler::ReflectGreen);
-        } else {
-            refl_value.y = refl_value.x;
-        }
+        refl_value.y = rg.lut != nullptr ? GetLutValue(rg) : refl_value.x;
 
         // If enabled, lookup ReflectBlue value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rb == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectBlue)) {
-            refl_value.z =
-                GetLutValue(lighting.lut_input.rb, lighting.abs_lut_input.disable_rb == 0,
-                            lighting.lut_scale.rb, LightingRegs::LightingSampler::ReflectBlue);
-        } else {
-            refl_value.z = refl_value.x;
-        }
+        refl_value.z = rb.lut != nullptr ? GetLutValue(rb) : refl_value.x;
 
         // Specular 1 component
         float d1_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d1 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution1)) {
-            d1_lut_value =
-                GetLutValue(lighting.lut_input.d1, lighting.abs_lut_input.disable_d1 == 0,
-                            lighting.lut_scale.d1, LightingRegs::LightingSampler::Distribution1);
-        }
+        if (d1.lut != nullptr)
+            d1_lut_value = GetLutValue(d1);
 
-        Math::Vec3<float> specular_1 =
-            d1_lut_value * refl_value * light_config.specular_1.ToVec3f();
+        Math::Vec3<float> specular_1 = d1_lut_value * refl_value * light.specular_1;
 
         // Fresnel
-        if (lighting.config1.disable_lut_fr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::Fresnel)) {
-
-            float lut_value =
-                GetLutValue(lighting.lut_input.fr, lighting.abs_lut_input.disable_fr == 0,
-                            lighting.lut_scale.fr, LightingRegs::LightingSampler::Fresnel);
+        if (fr.lut != nullptr) {
+            float lut_value = GetLutValue(fr);
 
             // Enabled for diffuse lighting alpha component
-            if (lighting.config0.fresnel_selector ==
-                    LightingRegs::LightingFresnelSelector::PrimaryAlpha ||
-                lighting.config0.fresnel_selector == LightingRegs::LightingFresnelSelector::Both) {
+            if (fresnel_primary_alpha)
                 diffuse_sum.a() *= lut_value;
-            }
 
             // Enabled for the specular lighting alpha component
-            if (lighting.config0.fresnel_selector ==
-                    LightingRegs::LightingFresnelSelector::SecondaryAlpha ||
-                lighting.config0.fresnel_selector == LightingRegs::LightingFresnelSelector::Both) {
+            if (fresnel_secondary_alpha)
                 specular_sum.a() *= lut_value;
-            }
         }
 
         auto dot_product = Math::Dot(light_vector, normal);
 
         // Calculate clamp highlights before applying the two-sided diffuse configuration to the dot
         // product.
-        float clamp_highlights = 1.0f;
-        if (lighting.config0.clamp_highlights) {
-            if (dot_product <= 0.0f)
-                clamp_highlights = 0.0f;
-            else
-                clamp_highlights = 1.0f;
-        }
+        float clamp_highlights_factor = 1.0f;
+        if (clamp_highlights && dot_product <= 0.0f)
+            clamp_highlights_factor = 0.0f;
 
-        if (light_config.config.two_sided_diffuse)
+        if (light.two_sided_diffuse)
             dot_product = std::abs(dot_product);
         else
             dot_product = std::max(dot_product, 0.0f);
 
-        auto diffuse =
-            light_config.diffuse.ToVec3f() * dot_product + light_config.ambient.ToVec3f();
+        auto diffuse = light.diffuse * dot_product + light.ambient;
         diffuse_sum += Math::MakeVec(diffuse * dist_atten, 0.0f);
 
         specular_sum +=
-            Math::MakeVec((specular_0 + specular_1) * clamp_highlights * dist_atten, 0.0f);
+            Math::MakeVec((specular_0 + specular_1) * clamp_highlights_factor * dist_atten, 0.0f);
     }
 
-    diffuse_sum += Math::MakeVec(lighting.global_ambient.ToVec3f(), 0.0f);
+    diffuse_sum += Math::MakeVec(global_ambient, 0.0f);
 
     auto diffuse = Math::MakeVec<float>(MathUtil::Clamp(diffuse_sum.x, 0.0f, 1.0f) * 255,
                                         MathUtil::Clamp(diffuse_sum.y, 0.0f, 1.0f) * 255,
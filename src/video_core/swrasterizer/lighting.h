@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <tuple>
 #include "common/quaternion.h"
 #include "common/vector_math.h"
@@ -11,8 +12,70 @@
 
 namespace Pica {
 
-std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
-    const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view);
+/// The lighting LUTs converted to floats, the form they are sampled in
+struct LightingLuts {
+    struct Entry {
+        float value;
+        /// Difference to the next entry, scaled by the position between them when sampling
+        float difference;
+    };
+
+    using Lut = std::array<Entry, 256>;
+
+    std::array<Lut, 24> luts;
+
+    /// Converts all LUTs of the given lighting state
+    void Update(const State::Lighting& lighting);
+};
+
+/**
+ * The fragment lighting configuration, decoded from the registers once so that lighting a fragment
+ * only has to evaluate the parts that are enabled.
+ */
+class LightingSetup {
+public:
+    LightingSetup(const LightingRegs& regs, const LightingLuts& luts);
+
+    /// Computes the primary and secondary fragment colors of a fragment
+    std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
+        const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view) const;
+
+private:
+    struct LutSampler {
+        /// nullptr if the LUT is disabled or not supported by the lighting configuration
+        const LightingLuts::Lut* lut;
+        LightingRegs::LightingLutInput input;
+        bool abs;
+        float scale;
+    };
+
+    struct Light {
+        Math::Vec3<float> position;
+        bool directional;
+        bool two_sided_diffuse;
+        /// nullptr if distance attenuation is disabled
+        const LightingLuts::Lut* dist_atten_lut;
+        float dist_atten_scale;
+        float dist_atten_bias;
+        Math::Vec3<float> specular_0;
+        Math::Vec3<float> specular_1;
+        Math::Vec3<float> diffuse;
+        Math::Vec3<float> ambient;
+    };
+
+    std::array<Light, 8> lights;
+    unsigned num_lights;
+
+    LutSampler d0;
+    LutSampler d1;
+    LutSampler rr;
+    LutSampler rg;
+    LutSampler rb;
+    LutSampler fr;
+    bool fresnel_primary_alpha;
+    bool fresnel_secondary_alpha;
+    bool clamp_highlights;
+    Math::Vec3<float> global_ambient;
+};
 
 } // namespace Pica
@@ -6,6 +6,7 @@
 #include <array>
 #include <cmath>
 #include <tuple>
+#include <boost/optional.hpp>
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/color.h"
@@ -24,10 +25,13 @@
 #include "video_core/regs_rasterizer.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/shader/shader.h"
+#include "video_core/swrasterizer/coverage.h"
+#include "video_core/swrasterizer/float24x4.h"
 #include "video_core/swrasterizer/framebuffer.h"
 #include "video_core/swrasterizer/lighting.h"
 #include "video_core/swrasterizer/proctex.h"
 #include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/swrasterizer/texture_cache.h"
 #include "video_core/swrasterizer/texturing.h"
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
@@ -35,6 +39,28 @@
 namespace Pica {
 namespace Rasterizer {
 
+static TextureCache texture_cache;
+static LightingLuts lighting_luts;
+
+/// Number of float24 words of the output attributes, padding included
+constexpr size_t OUTPUT_VERTEX_WORDS = sizeof(Shader::OutputVertex) / sizeof(float24);
+static_assert(OUTPUT_VERTEX_WORDS % 4 == 0, "Output attributes don't fill whole vectors");
+
+void Vertex::Lerp(float24 factor, const Vertex& vtx) {
+    // TODO: Should perform perspective correct interpolation here...
+    // The output attributes are interpolated four at a time, the padding words along with them
+    float24* attributes = &pos.x;
+    const float24* other_attributes = &vtx.pos.x;
+    const Float24x4 factors = Float24x4::Splat(factor);
+    for (size_t i = 0; i < OUTPUT_VERTEX_WORDS; i += 4) {
+        Float24x4::Lerp(factors, Float24x4::Load(attributes + i),
+                        Float24x4::Load(other_attributes + i))
+            .Store(attributes + i);
+    }
+
+    screenpos = screenpos * factor + vtx.screenpos * (float24::FromFloat32(1) - factor);
+}
+
 // NOTE: Assuming that rasterizer coordinates are 12.4 fixed-point values
 struct Fix12P4 {
     Fix12P4() {}
@@ -123,7 +149,7 @@ MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 24
  * culling via recursion.
  */
 static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Vertex& v2,
-                                    bool reversed = false) {
+                                    const MathUtil::Rectangle<u16>& clip, bool reversed = false) {
     const auto& regs = g_state.regs;
     MICROPROFILE_SCOPE(GPU_Rasterization);
 
@@ -144,13 +170,13 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     if (regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepAll) {
         // Make sure we always end up with a triangle wound counter-clockwise
         if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, clip, true);
             return;
         }
     } else {
         if (!reversed && regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepClockWise) {
             // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, clip, true);
             return;
         }
 
@@ -184,6 +210,12 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
     max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
 
+    // Only cover the pixels inside the clip rectangle
+    min_x = static_cast<u16>(std::max<u32>(min_x, clip.left * 16u));
+    min_y = static_cast<u16>(std::max<u32>(min_y, clip.top * 16u));
+    max_x = static_cast<u16>(std::min<u32>(max_x, clip.right * 16u));
+    max_y = static_cast<u16>(std::min<u32>(max_y, clip.bottom * 16u));
+
     // Triangle filling rules: Pixels on the right-sided edge or on flat bottom edges are not
     // drawn. Pixels on any other triangle border are drawn. This is implemented with three bias
     // values which are added to the barycentric coordinates w0, w1 and w2, respectively.
@@ -212,640 +244,476 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     auto w_inverse = Math::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
 
     auto textures = regs.texturing.GetTextures();
-    auto tev_stages = regs.texturing.GetTevStages();
+
+    // Cube maps sample a different face depending on the pixel, so they are decoded per texel
+    std::array<TextureCache::Texture*, 3> cached_textures{};
+    for (unsigned i = 0; i < 3; ++i) {
+        const auto& texture = textures[i];
+        if (texture.enabled &&
+            !(i == 0 && texture.config.type == TexturingRegs::TextureConfig::TextureCube)) {
+            cached_textures[i] = &texture_cache.Get(
+                Texture::TextureInfo::FromPicaRegister(texture.config, texture.format));
+        }
+    }
 
     bool stencil_action_enable =
         g_state.regs.framebuffer.output_merger.stencil_test.enable &&
         g_state.regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
     const auto stencil_test = g_state.regs.framebuffer.output_merger.stencil_test;
 
-    // Enter rasterization loop, starting at the center of the topleft bounding box corner.
-    // TODO: Not sure if looping through x first might be faster
-    for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
-
-            // Do not process the pixel if it's inside the scissor box and the scissor mode is set
-            // to Exclude
-            if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
-                if (x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 && y < scissor_y2)
-                    continue;
-            }
+    // Decode the lighting, the texture environment and the per-fragment tests once for the whole
+    // triangle
+    boost::optional<LightingSetup> lighting_setup;
+    if (!g_state.regs.lighting.disable)
+        lighting_setup.emplace(g_state.regs.lighting, lighting_luts);
+    const TevPipeline tev_pipeline(regs.texturing);
+    const auto& output_merger = regs.framebuffer.output_merger;
+    const CompareFunction alpha_test_func = GetCompareFunction(output_merger.alpha_test.func);
+    const CompareFunction stencil_test_func = GetCompareFunction(stencil_test.func);
+    const CompareFunction depth_test_func = GetCompareFunction(output_merger.depth_test_func);
+
+    // Shades the pixel whose center is at (x, y), given its barycentric coordinates w0, w1 and w2
+    auto ProcessPixel = [&](u16 x, u16 y, int w0, int w1, int w2) {
+        // Do not process the pixel if it's inside the scissor box and the scissor mode is set to
+        // Exclude
+        if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
+            if (x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 && y < scissor_y2)
+                return;
+        }
 
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
-            int wsum = w0 + w1 + w2;
+        int wsum = w0 + w1 + w2;
+
+        auto baricentric_coordinates =
+            Math::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
+                          float24::FromFloat32(static_cast<float>(w1)),
+                          float24::FromFloat32(static_cast<float>(w2)));
+        float24 interpolated_w_inverse =
+            float24::FromFloat32(1.0f) / Math::Dot(w_inverse, baricentric_coordinates);
+
+        // interpolated_z = z / w
+        float interpolated_z_over_w =
+            (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
+             v2.screenpos[2].ToFloat32() * w2) /
+            wsum;
+
+        // Not fully accurate. About 3 bits in precision are missing.
+        // Z-Buffer (z / w * scale + offset)
+        float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
+        float depth_offset =
+            float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
+        float depth = interpolated_z_over_w * depth_scale + depth_offset;
+
+        // Potentially switch to W-Buffer
+        if (regs.rasterizer.depthmap_enable ==
+            Pica::RasterizerRegs::DepthBuffering::WBuffering) {
+            // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
+            depth *= interpolated_w_inverse.ToFloat32() * wsum;
+        }
 
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
+        // Clamp the result
+        depth = MathUtil::Clamp(depth, 0.0f, 1.0f);
+
+        // Perspective correct attribute interpolation:
+        // Attribute values cannot be calculated by simple linear interpolation since
+        // they are not linear in screen space. For example, when interpolating a
+        // texture coordinate across two vertices, something simple like
+        //     u = (u0*w0 + u1*w1)/(w0+w1)
+        // will not work. However, the attribute value divided by the
+        // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
+        // in screenspace. Hence, we can linearly interpolate these two independently and
+        // calculate the interpolated attribute by dividing the results.
+        // I.e.
+        //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
+        //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
+        //     u = u_over_w / one_over_w
+        //
+        // The generalization to three vertices is straightforward in baricentric coordinates.
+        //
+        // The attributes are interpolated four at a time, starting from the given word of the
+        // output vertices. Each lane gives the same result as interpolating it on its own.
+        const Float24x4 baricentric_w0 = Float24x4::Splat(baricentric_coordinates.x);
+        const Float24x4 baricentric_w1 = Float24x4::Splat(baricentric_coordinates.y);
+        const Float24x4 baricentric_w2 = Float24x4::Splat(baricentric_coordinates.z);
+        const Float24x4 w_inverse_lanes = Float24x4::Splat(interpolated_w_inverse);
+        auto GetInterpolatedAttributes = [&](const float24& attr0, const float24& attr1,
+                                             const float24& attr2) {
+            const Float24x4 interpolated_attr_over_w = Float24x4::Load(&attr0) * baricentric_w0 +
+                                                       Float24x4::Load(&attr1) * baricentric_w1 +
+                                                       Float24x4::Load(&attr2) * baricentric_w2;
+            Math::Vec4<float24> result;
+            (interpolated_attr_over_w * w_inverse_lanes).Store(result);
+            return result;
+        };
+
+        const Math::Vec4<float24> color = GetInterpolatedAttributes(v0.color.r(), v1.color.r(),
+                                                                    v2.color.r());
+        Math::Vec4<u8> primary_color{
+            (u8)(color.r().ToFloat32() * 255), (u8)(color.g().ToFloat32() * 255),
+            (u8)(color.b().ToFloat32() * 255), (u8)(color.a().ToFloat32() * 255),
+        };
+
+        // tc0, tc1 / tc0_w, padding, view.xy / view.z, padding, tc2
+        const Math::Vec4<float24> tc0_tc1 =
+            GetInterpolatedAttributes(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
+        const Math::Vec4<float24> tc0_w_view =
+            GetInterpolatedAttributes(v0.tc0_w, v1.tc0_w, v2.tc0_w);
+        const Math::Vec4<float24> view_tc2 =
+            GetInterpolatedAttributes(v0.view.z, v1.view.z, v2.view.z);
+
+        Math::Vec2<float24> uv[3];
+        uv[0] = tc0_tc1.xy();
+        uv[1] = tc0_tc1.zw();
+        uv[2] = view_tc2.zw();
+
+        Math::Vec4<u8> texture_color[4]{};
+        for (int i = 0; i < 3; ++i) {
+            const auto& texture = textures[i];
+            if (!texture.enabled)
                 continue;
 
-            auto baricentric_coordinates =
-                Math::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
-                              float24::FromFloat32(static_cast<float>(w1)),
-                              float24::FromFloat32(static_cast<float>(w2)));
-            float24 interpolated_w_inverse =
-                float24::FromFloat32(1.0f) / Math::Dot(w_inverse, baricentric_coordinates);
-
-            // interpolated_z = z / w
-            float interpolated_z_over_w =
-                (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
-                 v2.screenpos[2].ToFloat32() * w2) /
-                wsum;
-
-            // Not fully accurate. About 3 bits in precision are missing.
-            // Z-Buffer (z / w * scale + offset)
-            float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
-            float depth_offset =
-                float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
-            float depth = interpolated_z_over_w * depth_scale + depth_offset;
-
-            // Potentially switch to W-Buffer
-            if (regs.rasterizer.depthmap_enable ==
-                Pica::RasterizerRegs::DepthBuffering::WBuffering) {
-                // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
-                depth *= interpolated_w_inverse.ToFloat32() * wsum;
-            }
+            DEBUG_ASSERT(0 != texture.config.address);
 
-            // Clamp the result
-            depth = MathUtil::Clamp(depth, 0.0f, 1.0f);
-
-            // Perspective correct attribute interpolation:
-            // Attribute values cannot be calculated by simple linear interpolation since
-            // they are not linear in screen space. For example, when interpolating a
-            // texture coordinate across two vertices, something simple like
-            //     u = (u0*w0 + u1*w1)/(w0+w1)
-            // will not work. However, the attribute value divided by the
-            // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
-            // in screenspace. Hence, we can linearly interpolate these two independently and
-            // calculate the interpolated attribute by dividing the results.
-            // I.e.
-            //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
-            //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
-            //     u = u_over_w / one_over_w
-            //
-            // The generalization to three vertices is straightforward in baricentric coordinates.
-            auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
-                auto attr_over_w = Math::MakeVec(attr0, attr1, attr2);
-                float24 interpolated_attr_over_w = Math::Dot(attr_over_w, baricentric_coordinates);
-                return interpolated_attr_over_w * interpolated_w_inverse;
-            };
+            int coordinate_i =
+                (i == 2 && regs.texturing.main_config.texture2_use_coord1) ? 1 : i;
+            float24 u = uv[coordinate_i].u();
+            float24 v = uv[coordinate_i].v();
 
-            Math::Vec4<u8> primary_color{
-                (u8)(
-                    GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() *
-                    255),
-                (u8)(
-                    GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() *
-                    255),
-                (u8)(
-                    GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() *
-                    255),
-                (u8)(
-                    GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() *
-                    255),
-            };
-
-            Math::Vec2<float24> uv[3];
-            uv[0].u() = GetInterpolatedAttribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
-            uv[0].v() = GetInterpolatedAttribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
-            uv[1].u() = GetInterpolatedAttribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
-            uv[1].v() = GetInterpolatedAttribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
-            uv[2].u() = GetInterpolatedAttribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
-            uv[2].v() = GetInterpolatedAttribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
-
-            Math::Vec4<u8> texture_color[4]{};
-            for (int i = 0; i < 3; ++i) {
-                const auto& texture = textures[i];
-                if (!texture.enabled)
-                    continue;
-
-                DEBUG_ASSERT(0 != texture.config.address);
-
-                int coordinate_i =
-                    (i == 2 && regs.texturing.main_config.texture2_use_coord1) ? 1 : i;
-                float24 u = uv[coordinate_i].u();
-                float24 v = uv[coordinate_i].v();
-
-                // Only unit 0 respects the texturing type (according to 3DBrew)
-                // TODO: Refactor so cubemaps and shadowmaps can be handled
-                PAddr texture_address = texture.config.GetPhysicalAddress();
-                if (i == 0) {
-                    switch (texture.config.type) {
-                    case TexturingRegs::TextureConfig::Texture2D:
-                        break;
-                    case TexturingRegs::TextureConfig::TextureCube: {
-                        auto w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
-                        std::tie(u, v, texture_address) = ConvertCubeCoord(u, v, w, regs.texturing);
-                        break;
-                    }
-                    case TexturingRegs::TextureConfig::Projection2D: {
-                        auto tc0_w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
-                        u /= tc0_w;
-                        v /= tc0_w;
-                        break;
-                    }
-                    default:
-                        // TODO: Change to LOG_ERROR when more types are handled.
-                        LOG_DEBUG(HW_GPU, "Unhandled texture type %x", (int)texture.config.type);
-                        UNIMPLEMENTED();
-                        break;
-                    }
+            // Only unit 0 respects the texturing type (according to 3DBrew)
+            // TODO: Refactor so cubemaps and shadowmaps can be handled
+            PAddr texture_address = texture.config.GetPhysicalAddress();
+            if (i == 0) {
+                switch (texture.config.type) {
+                case TexturingRegs::TextureConfig::Texture2D:
+                    break;
+                case TexturingRegs::TextureConfig::TextureCube: {
+                    const float24 w = tc0_w_view.x;
+                    std::tie(u, v, texture_address) = ConvertCubeCoord(u, v, w, regs.texturing);
+                    break;
+                }
+                case TexturingRegs::TextureConfig::Projection2D: {
+                    const float24 tc0_w = tc0_w_view.x;
+                    u /= tc0_w;
+                    v /= tc0_w;
+                    break;
+                }
+                default:
+                    // TODO: Change to LOG_ERROR when more types are handled.
+                    LOG_DEBUG(HW_GPU, "Unhandled texture type %x", (int)texture.config.type);
+                    UNIMPLEMENTED();
+                    break;
                 }
+            }
 
-                int s = (int)(u * float24::FromFloat32(static_cast<float>(texture.config.width)))
-                            .ToFloat32();
-                int t = (int)(v * float24::FromFloat32(static_cast<float>(texture.config.height)))
-                            .ToFloat32();
+            int s = (int)(u * float24::FromFloat32(static_cast<float>(texture.config.width)))
+                        .ToFloat32();
+            int t = (int)(v * float24::FromFloat32(static_cast<float>(texture.config.height)))
+                        .ToFloat32();
 
-                bool use_border_s = false;
-                bool use_border_t = false;
+            bool use_border_s = false;
+            bool use_border_t = false;
 
-                if (texture.config.wrap_s == TexturingRegs::TextureConfig::ClampToBorder) {
-                    use_border_s = s < 0 || s >= static_cast<int>(texture.config.width);
-                } else if (texture.config.wrap_s == TexturingRegs::TextureConfig::ClampToBorder2) {
-                    use_border_s = s >= static_cast<int>(texture.config.width);
-                }
+            if (texture.config.wrap_s == TexturingRegs::TextureConfig::ClampToBorder) {
+                use_border_s = s < 0 || s >= static_cast<int>(texture.config.width);
+            } else if (texture.config.wrap_s == TexturingRegs::TextureConfig::ClampToBorder2) {
+                use_border_s = s >= static_cast<int>(texture.config.width);
+            }
 
-                if (texture.config.wrap_t == TexturingRegs::TextureConfig::ClampToBorder) {
-                    use_border_t = t < 0 || t >= static_cast<int>(texture.config.height);
-                } else if (texture.config.wrap_t == TexturingRegs::TextureConfig::ClampToBorder2) {
-                    use_border_t = t >= static_cast<int>(texture.config.height);
-                }
+            if (texture.config.wrap_t == TexturingRegs::TextureConfig::ClampToBorder) {
+                use_border_t = t < 0 || t >= static_cast<int>(texture.config.height);
+            } else if (texture.config.wrap_t == TexturingRegs::TextureConfig::ClampToBorder2) {
+                use_border_t = t >= static_cast<int>(texture.config.height);
+            }
 
-                if (use_border_s || use_border_t) {
-                    auto border_color = texture.config.border_color;
-                    texture_color[i] = {border_color.r, border_color.g, border_color.b,
-                                        border_color.a};
+            if (use_border_s || use_border_t) {
+                auto border_color = texture.config.border_color;
+                texture_color[i] = {border_color.r, border_color.g, border_color.b,
+                                    border_color.a};
+            } else {
+                // Textures are laid out from bottom to top, hence we invert the t coordinate.
+                // NOTE: This may not be the right place for the inversion.
+                // TODO: Check if this applies to ETC textures, too.
+                s = GetWrappedTexCoord(texture.config.wrap_s, s, texture.config.width);
+                t = texture.config.height - 1 -
+                    GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
+
+                // TODO: Apply the min and mag filters to the texture
+                if (cached_textures[i] != nullptr) {
+                    texture_color[i] = cached_textures[i]->LookupTexel(s, t);
                 } else {
-                    // Textures are laid out from bottom to top, hence we invert the t coordinate.
-                    // NOTE: This may not be the right place for the inversion.
-                    // TODO: Check if this applies to ETC textures, too.
-                    s = GetWrappedTexCoord(texture.config.wrap_s, s, texture.config.width);
-                    t = texture.config.height - 1 -
-                        GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
-
                     const u8* texture_data = Memory::GetPhysicalPointer(texture_address);
                     auto info =
                         Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
-
-                    // TODO: Apply the min and mag filters to the texture
                     texture_color[i] = Texture::LookupTexture(texture_data, s, t, info);
+                }
 #if PICA_DUMP_TEXTURES
-                    DebugUtils::DumpTexture(texture.config, texture_data);
+                DebugUtils::DumpTexture(texture.config,
+                                        Memory::GetPhysicalPointer(texture_address));
 #endif
-                }
             }
+        }
 
-            // sample procedural texture
-            if (regs.texturing.main_config.texture3_enable) {
-                const auto& proctex_uv = uv[regs.texturing.main_config.texture3_coordinates];
-                texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
-                                           g_state.regs.texturing, g_state.proctex);
-            }
+        // sample procedural texture
+        if (regs.texturing.main_config.texture3_enable) {
+            const auto& proctex_uv = uv[regs.texturing.main_config.texture3_coordinates];
+            texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
+                                       g_state.regs.texturing, g_state.proctex);
+        }
 
-            // Texture environment - consists of 6 stages of color and alpha combining.
-            //
-            // Color combiners take three input color values from some source (e.g. interpolated
-            // vertex color, texture color, previous stage, etc), perform some very simple
-            // operations on each of them (e.g. inversion) and then calculate the output color
-            // with some basic arithmetic. Alpha combiners can be configured separately but work
-            // analogously.
-            Math::Vec4<u8> combiner_output;
-            Math::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
-            Math::Vec4<u8> next_combiner_buffer = {
-                regs.texturing.tev_combiner_buffer_color.r,
-                regs.texturing.tev_combiner_buffer_color.g,
-                regs.texturing.tev_combiner_buffer_color.b,
-                regs.texturing.tev_combiner_buffer_color.a,
+        Math::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
+        Math::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
+
+        if (lighting_setup) {
+            const Math::Vec4<float24> quat =
+                GetInterpolatedAttributes(v0.quat.x, v1.quat.x, v2.quat.x);
+            Math::Quaternion<float> normquat = Math::Quaternion<float>{
+                {quat.x.ToFloat32(), quat.y.ToFloat32(), quat.z.ToFloat32()},
+                quat.w.ToFloat32(),
+            }.Normalized();
+
+            Math::Vec3<float> view{
+                tc0_w_view.z.ToFloat32(),
+                tc0_w_view.w.ToFloat32(),
+                view_tc2.x.ToFloat32(),
             };
+            std::tie(primary_fragment_color, secondary_fragment_color) =
+                lighting_setup->ComputeFragmentsColors(normquat, view);
+        }
 
-            Math::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
-            Math::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
-
-            if (!g_state.regs.lighting.disable) {
-                Math::Quaternion<float> normquat = Math::Quaternion<float>{
-                    {GetInterpolatedAttribute(v0.quat.x, v1.quat.x, v2.quat.x).ToFloat32(),
-                     GetInterpolatedAttribute(v0.quat.y, v1.quat.y, v2.quat.y).ToFloat32(),
-                     GetInterpolatedAttribute(v0.quat.z, v1.quat.z, v2.quat.z).ToFloat32()},
-                    GetInterpolatedAttribute(v0.quat.w, v1.quat.w, v2.quat.w).ToFloat32(),
-                }.Normalized();
-
-                Math::Vec3<float> view{
-                    GetInterpolatedAttribute(v0.view.x, v1.view.x, v2.view.x).ToFloat32(),
-                    GetInterpolatedAttribute(v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
-                    GetInterpolatedAttribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
-                };
-                std::tie(primary_fragment_color, secondary_fragment_color) =
-                    ComputeFragmentsColors(g_state.regs.lighting, g_state.lighting, normquat, view);
-            }
-
-            for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size();
-                 ++tev_stage_index) {
-                const auto& tev_stage = tev_stages[tev_stage_index];
-                using Source = TexturingRegs::TevStageConfig::Source;
-
-                auto GetSource = [&](Source source) -> Math::Vec4<u8> {
-                    switch (source) {
-                    case Source::PrimaryColor:
-                        return primary_color;
-
-                    case Source::PrimaryFragmentColor:
-                        return primary_fragment_color;
-
-                    case Source::SecondaryFragmentColor:
-                        return secondary_fragment_color;
-
-                    case Source::Texture0:
-                        return texture_color[0];
-
-                    case Source::Texture1:
-                        return texture_color[1];
-
-                    case Source::Texture2:
-                        return texture_color[2];
-
-                    case Source::Texture3:
-                        return texture_color[3];
-
-                    case Source::PreviousBuffer:
-                        return combiner_buffer;
-
-                    case Source::Constant:
-                        return {tev_stage.const_r, tev_stage.const_g, tev_stage.const_b,
-                                tev_stage.const_a};
-
-                    case Source::Previous:
-                        return combiner_output;
-
-                    default:
-                        LOG_ERROR(HW_GPU, "Unknown color combiner source %d", (int)source);
-                        UNIMPLEMENTED();
-                        return {0, 0, 0, 0};
-                    }
-                };
-
-                // color combiner
-                // NOTE: Not sure if the alpha combiner might use the color output of the previous
-                //       stage as input. Hence, we currently don't directly write the result to
-                //       combiner_output.rgb(), but instead store it in a temporary variable until
-                //       alpha combining has been done.
-                Math::Vec3<u8> color_result[3] = {
-                    GetColorModifier(tev_stage.color_modifier1, GetSource(tev_stage.color_source1)),
-                    GetColorModifier(tev_stage.color_modifier2, GetSource(tev_stage.color_source2)),
-                    GetColorModifier(tev_stage.color_modifier3, GetSource(tev_stage.color_source3)),
-                };
-                auto color_output = ColorCombine(tev_stage.color_op, color_result);
-
-                u8 alpha_output;
-                if (tev_stage.color_op == TexturingRegs::TevStageConfig::Operation::Dot3_RGBA) {
-                    // result of Dot3_RGBA operation is also placed to the alpha component
-                    alpha_output = color_output.x;
-                } else {
-                    // alpha combiner
-                    std::array<u8, 3> alpha_result = {{
-                        GetAlphaModifier(tev_stage.alpha_modifier1,
-                                         GetSource(tev_stage.alpha_source1)),
-                        GetAlphaModifier(tev_stage.alpha_modifier2,
-                                         GetSource(tev_stage.alpha_source2)),
-                        GetAlphaModifier(tev_stage.alpha_modifier3,
-                                         GetSource(tev_stage.alpha_source3)),
-                    }};
-                    alpha_output = AlphaCombine(tev_stage.alpha_op, alpha_result);
-                }
+        // Texture environment - consists of 6 stages of color and alpha combining.
+        //
+        // Color combiners take three input color values from some source (e.g. interpolated
+        // vertex color, texture color, previous stage, etc), perform some very simple
+        // operations on each of them (e.g. inversion) and then calculate the output color
+        // with some basic arithmetic. Alpha combiners can be configured separately but work
+        // analogously.
+        TevPipeline::Inputs tev_inputs;
+        tev_inputs[TevPipeline::PrimaryColor] = primary_color;
+        tev_inputs[TevPipeline::PrimaryFragmentColor] = primary_fragment_color;
+        tev_inputs[TevPipeline::SecondaryFragmentColor] = secondary_fragment_color;
+        tev_inputs[TevPipeline::Texture0] = texture_color[0];
+        tev_inputs[TevPipeline::Texture1] = texture_color[1];
+        tev_inputs[TevPipeline::Texture2] = texture_color[2];
+        tev_inputs[TevPipeline::Texture3] = texture_color[3];
+        Math::Vec4<u8> combiner_output = tev_pipeline.Combine(tev_inputs);
+
+        // TODO: Does alpha testing happen before or after stencil?
+        if (output_merger.alpha_test.enable &&
+            !alpha_test_func(combiner_output.a(), output_merger.alpha_test.ref)) {
+            return;
+        }
 
-                combiner_output[0] =
-                    std::min((unsigned)255, color_output.r() * tev_stage.GetColorMultiplier());
-                combiner_output[1] =
-                    std::min((unsigned)255, color_output.g() * tev_stage.GetColorMultiplier());
-                combiner_output[2] =
-                    std::min((unsigned)255, color_output.b() * tev_stage.GetColorMultiplier());
-                combiner_output[3] =
-                    std::min((unsigned)255, alpha_output * tev_stage.GetAlphaMultiplier());
-
-                combiner_buffer = next_combiner_buffer;
-
-                if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(
-                        tev_stage_index)) {
-                    next_combiner_buffer.r() = combiner_output.r();
-                    next_combiner_buffer.g() = combiner_output.g();
-                    next_combiner_buffer.b() = combiner_output.b();
-                }
+        // Apply fog combiner
+        // Not fully accurate. We'd have to know what data type is used to
+        // store the depth etc. Using float for now until we know more
+        // about Pica datatypes
+        if (regs.texturing.fog_mode == TexturingRegs::FogMode::Fog) {
+            const Math::Vec3<u8> fog_color = {
+                static_cast<u8>(regs.texturing.fog_color.r.Value()),
+                static_cast<u8>(regs.texturing.fog_color.g.Value()),
+                static_cast<u8>(regs.texturing.fog_color.b.Value()),
+            };
 
-                if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(
-                        tev_stage_index)) {
-                    next_combiner_buffer.a() = combiner_output.a();
-                }
+            // Get index into fog LUT
+            float fog_index;
+            if (g_state.regs.texturing.fog_flip) {
+                fog_index = (1.0f - depth) * 128.0f;
+            } else {
+                fog_index = depth * 128.0f;
             }
 
-            const auto& output_merger = regs.framebuffer.output_merger;
-            // TODO: Does alpha testing happen before or after stencil?
-            if (output_merger.alpha_test.enable) {
-                bool pass = false;
-
-                switch (output_merger.alpha_test.func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = combiner_output.a() == output_merger.alpha_test.ref;
-                    break;
-
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = combiner_output.a() != output_merger.alpha_test.ref;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = combiner_output.a() < output_merger.alpha_test.ref;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = combiner_output.a() <= output_merger.alpha_test.ref;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = combiner_output.a() > output_merger.alpha_test.ref;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = combiner_output.a() >= output_merger.alpha_test.ref;
-                    break;
-                }
+            // Generate clamped fog factor from LUT for given fog index
+            float fog_i = MathUtil::Clamp(floorf(fog_index), 0.0f, 127.0f);
+            float fog_f = fog_index - fog_i;
+            const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
+            float fog_factor = fog_lut_entry.ToFloat() + fog_lut_entry.DiffToFloat() * fog_f;
+            fog_factor = MathUtil::Clamp(fog_factor, 0.0f, 1.0f);
+
+            // Blend the fog
+            for (unsigned i = 0; i < 3; i++) {
+                combiner_output[i] = static_cast<u8>(fog_factor * combiner_output[i] +
+                                                     (1.0f - fog_factor) * fog_color[i]);
+            }
+        }
 
-                if (!pass)
-                    continue;
+        u8 old_stencil = 0;
+
+        auto UpdateStencil = [stencil_test, x, y,
+                              &old_stencil](Pica::FramebufferRegs::StencilAction action) {
+            u8 new_stencil =
+                PerformStencilAction(action, old_stencil, stencil_test.reference_value);
+            if (g_state.regs.framebuffer.framebuffer.allow_depth_stencil_write != 0)
+                SetStencil(x >> 4, y >> 4, (new_stencil & stencil_test.write_mask) |
+                                               (old_stencil & ~stencil_test.write_mask));
+        };
+
+        if (stencil_action_enable) {
+            old_stencil = GetStencil(x >> 4, y >> 4);
+            u8 dest = old_stencil & stencil_test.input_mask;
+            u8 ref = stencil_test.reference_value & stencil_test.input_mask;
+
+            if (!stencil_test_func(ref, dest)) {
+                UpdateStencil(stencil_test.action_stencil_fail);
+                return;
             }
+        }
 
-            // Apply fog combiner
-            // Not fully accurate. We'd have to know what data type is used to
-            // store the depth etc. Using float for now until we know more
-            // about Pica datatypes
-            if (regs.texturing.fog_mode == TexturingRegs::FogMode::Fog) {
-                const Math::Vec3<u8> fog_color = {
-                    static_cast<u8>(regs.texturing.fog_color.r.Value()),
-                    static_cast<u8>(regs.texturing.fog_color.g.Value()),
-                    static_cast<u8>(regs.texturing.fog_color.b.Value()),
-                };
+        // Convert float to integer
+        unsigned num_bits =
+            FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
+        u32 z = (u32)(depth * ((1 << num_bits) - 1));
 
-                // Get index into fog LUT
-                float fog_index;
-                if (g_state.regs.texturing.fog_flip) {
-                    fog_index = (1.0f - depth) * 128.0f;
-                } else {
-                    fog_index = depth * 128.0f;
-                }
+        if (output_merger.depth_test_enable) {
+            u32 ref_z = GetDepth(x >> 4, y >> 4);
 
-                // Generate clamped fog factor from LUT for given fog index
-                float fog_i = MathUtil::Clamp(floorf(fog_index), 0.0f, 127.0f);
-                float fog_f = fog_index - fog_i;
-                const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
-                float fog_factor = fog_lut_entry.ToFloat() + fog_lut_entry.DiffToFloat() * fog_f;
-                fog_factor = MathUtil::Clamp(fog_factor, 0.0f, 1.0f);
-
-                // Blend the fog
-                for (unsigned i = 0; i < 3; i++) {
-                    combiner_output[i] = static_cast<u8>(fog_factor * combiner_output[i] +
-                                                         (1.0f - fog_factor) * fog_color[i]);
-                }
+            if (!depth_test_func(z, ref_z)) {
+                if (stencil_action_enable)
+                    UpdateStencil(stencil_test.action_depth_fail);
+                return;
             }
+        }
 
-            u8 old_stencil = 0;
+        if (regs.framebuffer.framebuffer.allow_depth_stencil_write != 0 &&
+            output_merger.depth_write_enable) {
 
-            auto UpdateStencil = [stencil_test, x, y,
-                                  &old_stencil](Pica::FramebufferRegs::StencilAction action) {
-                u8 new_stencil =
-                    PerformStencilAction(action, old_stencil, stencil_test.reference_value);
-                if (g_state.regs.framebuffer.framebuffer.allow_depth_stencil_write != 0)
-                    SetStencil(x >> 4, y >> 4, (new_stencil & stencil_test.write_mask) |
-                                                   (old_stencil & ~stencil_test.write_mask));
-            };
+            SetDepth(x >> 4, y >> 4, z);
+        }
 
-            if (stencil_action_enable) {
-                old_stencil = GetStencil(x >> 4, y >> 4);
-                u8 dest = old_stencil & stencil_test.input_mask;
-                u8 ref = stencil_test.reference_value & stencil_test.input_mask;
+        // The stencil depth_pass action is executed even if depth testing is disabled
+        if (stencil_action_enable)
+            UpdateStencil(stencil_test.action_depth_pass);
 
-                bool pass = false;
-                switch (stencil_test.func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
+        auto dest = GetPixel(x >> 4, y >> 4);
+        Math::Vec4<u8> blend_output = combiner_output;
 
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
+        if (output_merger.alphablend_enable) {
+            auto params = output_merger.alpha_blending;
 
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = (ref == dest);
-                    break;
+            auto LookupFactor = [&](unsigned channel,
+                                    FramebufferRegs::BlendFactor factor) -> u8 {
+                DEBUG_ASSERT(channel < 4);
 
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = (ref != dest);
-                    break;
+                const Math::Vec4<u8> blend_const = {
+                    static_cast<u8>(output_merger.blend_const.r),
+                    static_cast<u8>(output_merger.blend_const.g),
+                    static_cast<u8>(output_merger.blend_const.b),
+                    static_cast<u8>(output_merger.blend_const.a),
+                };
 
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = (ref < dest);
-                    break;
+                switch (factor) {
+                case FramebufferRegs::BlendFactor::Zero:
+                    return 0;
 
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = (ref <= dest);
-                    break;
+                case FramebufferRegs::BlendFactor::One:
+                    return 255;
 
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = (ref > dest);
-                    break;
+                case FramebufferRegs::BlendFactor::SourceColor:
+                    return combiner_output[channel];
 
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = (ref >= dest);
-                    break;
-                }
+                case FramebufferRegs::BlendFactor::OneMinusSourceColor:
+                    return 255 - combiner_output[channel];
 
-                if (!pass) {
-                    UpdateStencil(stencil_test.action_stencil_fail);
-                    continue;
-                }
-            }
+                case FramebufferRegs::BlendFactor::DestColor:
+                    return dest[channel];
 
-            // Convert float to integer
-            unsigned num_bits =
-                FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
-            u32 z = (u32)(depth * ((1 << num_bits) - 1));
+                case FramebufferRegs::BlendFactor::OneMinusDestColor:
+                    return 255 - dest[channel];
 
-            if (output_merger.depth_test_enable) {
-                u32 ref_z = GetDepth(x >> 4, y >> 4);
+                case FramebufferRegs::BlendFactor::SourceAlpha:
+                    return combiner_output.a();
 
-                bool pass = false;
+                case FramebufferRegs::BlendFactor::OneMinusSourceAlpha:
+                    return 255 - combiner_output.a();
 
-                switch (output_merger.depth_test_func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
+                case FramebufferRegs::BlendFactor::DestAlpha:
+                    return dest.a();
 
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
+                case FramebufferRegs::BlendFactor::OneMinusDestAlpha:
+                    return 255 - dest.a();
 
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = z == ref_z;
-                    break;
+                case FramebufferRegs::BlendFactor::ConstantColor:
+                    return blend_const[channel];
 
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = z != ref_z;
-                    break;
+                case FramebufferRegs::BlendFactor::OneMinusConstantColor:
+                    return 255 - blend_const[channel];
 
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = z < ref_z;
-                    break;
+                case FramebufferRegs::BlendFactor::ConstantAlpha:
+                    return blend_const.a();
 
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = z <= ref_z;
-                    break;
+                case FramebufferRegs::BlendFactor::OneMinusConstantAlpha:
+                    return 255 - blend_const.a();
 
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = z > ref_z;
-                    break;
+                case FramebufferRegs::BlendFactor::SourceAlphaSaturate:
+                    // Returns 1.0 for the alpha channel
+                    if (channel == 3)
+                        return 255;
+                    return std::min(combiner_output.a(), static_cast<u8>(255 - dest.a()));
 
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = z >= ref_z;
+                default:
+                    LOG_CRITICAL(HW_GPU, "Unknown blend factor %x", factor);
+                    UNIMPLEMENTED();
                     break;
                 }
 
-                if (!pass) {
-                    if (stencil_action_enable)
-                        UpdateStencil(stencil_test.action_depth_fail);
-                    continue;
-                }
-            }
-
-            if (regs.framebuffer.framebuffer.allow_depth_stencil_write != 0 &&
-                output_merger.depth_write_enable) {
-
-                SetDepth(x >> 4, y >> 4, z);
-            }
-
-            // The stencil depth_pass action is executed even if depth testing is disabled
-            if (stencil_action_enable)
-                UpdateStencil(stencil_test.action_depth_pass);
-
-            auto dest = GetPixel(x >> 4, y >> 4);
-            Math::Vec4<u8> blend_output = combiner_output;
-
-            if (output_merger.alphablend_enable) {
-                auto params = output_merger.alpha_blending;
-
-                auto LookupFactor = [&](unsigned channel,
-                                        FramebufferRegs::BlendFactor factor) -> u8 {
-                    DEBUG_ASSERT(channel < 4);
-
-                    const Math::Vec4<u8> blend_const = {
-                        static_cast<u8>(output_merger.blend_const.r),
-                        static_cast<u8>(output_merger.blend_const.g),
-                        static_cast<u8>(output_merger.blend_const.b),
-                        static_cast<u8>(output_merger.blend_const.a),
-                    };
-
-                    switch (factor) {
-                    case FramebufferRegs::BlendFactor::Zero:
-                        return 0;
-
-                    case FramebufferRegs::BlendFactor::One:
-                        return 255;
-
-                    case FramebufferRegs::BlendFactor::SourceColor:
-                        return combiner_output[channel];
-
-                    case FramebufferRegs::BlendFactor::OneMinusSourceColor:
-                        return 255 - combiner_output[channel];
-
-                    case FramebufferRegs::BlendFactor::DestColor:
-                        return dest[channel];
-
-                    case FramebufferRegs::BlendFactor::OneMinusDestColor:
-                        return 255 - dest[channel];
-
-                    case FramebufferRegs::BlendFactor::SourceAlpha:
-                        return combiner_output.a();
-
-                    case FramebufferRegs::BlendFactor::OneMinusSourceAlpha:
-                        return 255 - combiner_output.a();
-
-                    case FramebufferRegs::BlendFactor::DestAlpha:
-                        return dest.a();
-
-                    case FramebufferRegs::BlendFactor::OneMinusDestAlpha:
-                        return 255 - dest.a();
-
-                    case FramebufferRegs::BlendFactor::ConstantColor:
-                        return blend_const[channel];
-
-                    case FramebufferRegs::BlendFactor::OneMinusConstantColor:
-                        return 255 - blend_const[channel];
-
-                    case FramebufferRegs::BlendFactor::ConstantAlpha:
-                        return blend_const.a();
-
-                    case FramebufferRegs::BlendFactor::OneMinusConstantAlpha:
-                        return 255 - blend_const.a();
+                return combiner_output[channel];
+            };
 
-                    case FramebufferRegs::BlendFactor::SourceAlphaSaturate:
-                        // Returns 1.0 for the alpha channel
-                        if (channel == 3)
-                            return 255;
-                        return std::min(combiner_output.a(), static_cast<u8>(255 - dest.a()));
+            auto srcfactor = Math::MakeVec(LookupFactor(0, params.factor_source_rgb),
+                                           LookupFactor(1, params.factor_source_rgb),
+                                           LookupFactor(2, params.factor_source_rgb),
+                                           LookupFactor(3, params.factor_source_a));
+
+            auto dstfactor = Math::MakeVec(LookupFactor(0, params.factor_dest_rgb),
+                                           LookupFactor(1, params.factor_dest_rgb),
+                                           LookupFactor(2, params.factor_dest_rgb),
+                                           LookupFactor(3, params.factor_dest_a));
+
+            blend_output = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor,
+                                                 params.blend_equation_rgb);
+            blend_output.a() = EvaluateBlendEquation(combiner_output, srcfactor, dest,
+                                                     dstfactor, params.blend_equation_a)
+                                   .a();
+        } else {
+            blend_output =
+                Math::MakeVec(LogicOp(combiner_output.r(), dest.r(), output_merger.logic_op),
+                              LogicOp(combiner_output.g(), dest.g(), output_merger.logic_op),
+                              LogicOp(combiner_output.b(), dest.b(), output_merger.logic_op),
+                              LogicOp(combiner_output.a(), dest.a(), output_merger.logic_op));
+        }
 
-                    default:
-                        LOG_CRITICAL(HW_GPU, "Unknown blend factor %x", factor);
-                        UNIMPLEMENTED();
-                        break;
-                    }
+        const Math::Vec4<u8> result = {
+            output_merger.red_enable ? blend_output.r() : dest.r(),
+            output_merger.green_enable ? blend_output.g() : dest.g(),
+            output_merger.blue_enable ? blend_output.b() : dest.b(),
+            output_merger.alpha_enable ? blend_output.a() : dest.a(),
+        };
 
-                    return combiner_output[channel];
-                };
+        if (regs.framebuffer.framebuffer.allow_color_write != 0)
+            DrawPixel(x >> 4, y >> 4, result);
+    };
 
-                auto srcfactor = Math::MakeVec(LookupFactor(0, params.factor_source_rgb),
-                                               LookupFactor(1, params.factor_source_rgb),
-                                               LookupFactor(2, params.factor_source_rgb),
-                                               LookupFactor(3, params.factor_source_a));
-
-                auto dstfactor = Math::MakeVec(LookupFactor(0, params.factor_dest_rgb),
-                                               LookupFactor(1, params.factor_dest_rgb),
-                                               LookupFactor(2, params.factor_dest_rgb),
-                                               LookupFactor(3, params.factor_dest_a));
-
-                blend_output = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor,
-                                                     params.blend_equation_rgb);
-                blend_output.a() = EvaluateBlendEquation(combiner_output, srcfactor, dest,
-                                                         dstfactor, params.blend_equation_a)
-                                       .a();
-            } else {
-                blend_output =
-                    Math::MakeVec(LogicOp(combiner_output.r(), dest.r(), output_merger.logic_op),
-                                  LogicOp(combiner_output.g(), dest.g(), output_merger.logic_op),
-                                  LogicOp(combiner_output.b(), dest.b(), output_merger.logic_op),
-                                  LogicOp(combiner_output.a(), dest.a(), output_merger.logic_op));
-            }
+    ForEachCoveredPixel({Math::MakeVec<int>(vtxpos[0].x, vtxpos[0].y),
+                         Math::MakeVec<int>(vtxpos[1].x, vtxpos[1].y),
+                         Math::MakeVec<int>(vtxpos[2].x, vtxpos[2].y)},
+                        {bias0, bias1, bias2}, min_x, min_y, max_x, max_y, ProcessPixel);
+}
 
-            const Math::Vec4<u8> result = {
-                output_merger.red_enable ? blend_output.r() : dest.r(),
-                output_merger.green_enable ? blend_output.g() : dest.g(),
-                output_merger.blue_enable ? blend_output.b() : dest.b(),
-                output_merger.alpha_enable ? blend_output.a() : dest.a(),
-            };
+void UpdateLightingLuts() {
+    lighting_luts.Update(g_state.lighting);
+}
 
-            if (regs.framebuffer.framebuffer.allow_color_write != 0)
-                DrawPixel(x >> 4, y >> 4, result);
-        }
-    }
+void InvalidateTextureCache() {
+    texture_cache.Invalidate();
 }
 
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
-    ProcessTriangleInternal(v0, v1, v2);
+    // Covers the whole range of rasterizer coordinates
+    static const MathUtil::Rectangle<u16> no_clip(0, 0, 0x1000, 0x1000);
+    ProcessTriangleInternal(v0, v1, v2, no_clip);
+}
+
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     const MathUtil::Rectangle<u16>& clip) {
+    ProcessTriangleInternal(v0, v1, v2, clip);
 }
 
 } // namespace Rasterizer
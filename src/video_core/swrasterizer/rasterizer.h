@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "common/common_types.h"
+#include "common/math_util.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica {
@@ -19,20 +21,7 @@ struct Vertex : Shader::OutputVertex {
 
     // Linear interpolation
     // factor: 0=this, 1=vtx
-    void Lerp(float24 factor, const Vertex& vtx) {
-        pos = pos * factor + vtx.pos * (float24::FromFloat32(1) - factor);
-
-        // TODO: Should perform perspective correct interpolation here...
-        quat = quat * factor + vtx.quat * (float24::FromFloat32(1) - factor);
-        color = color * factor + vtx.color * (float24::FromFloat32(1) - factor);
-        tc0 = tc0 * factor + vtx.tc0 * (float24::FromFloat32(1) - factor);
-        tc1 = tc1 * factor + vtx.tc1 * (float24::FromFloat32(1) - factor);
-        tc0_w = tc0_w * factor + vtx.tc0_w * (float24::FromFloat32(1) - factor);
-        view = view * factor + vtx.view * (float24::FromFloat32(1) - factor);
-        tc2 = tc2 * factor + vtx.tc2 * (float24::FromFloat32(1) - factor);
-
-        screenpos = screenpos * factor + vtx.screenpos * (float24::FromFloat32(1) - factor);
-    }
+    void Lerp(float24 factor, const Vertex& vtx);
 
     // Linear interpolation
     // factor: 0=v0, 1=v1
@@ -45,6 +34,25 @@ struct Vertex : Shader::OutputVertex {
 
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
 
+/**
+ * Rasterizes the part of the triangle inside the given rectangle of pixels. The left and top edges
+ * belong to the rectangle, the right and bottom edges don't.
+ */
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     const MathUtil::Rectangle<u16>& clip);
+
+/**
+ * Converts the lighting LUTs for rasterizing. Has to be called after they are written, before
+ * rasterizing the next triangle.
+ */
+void UpdateLightingLuts();
+
+/**
+ * Discards the textures decoded for rasterizing. Has to be called whenever texture memory may have
+ * been written, and not while triangles are being rasterized.
+ */
+void InvalidateTextureCache();
+
 } // namespace Rasterizer
 
 } // namespace Pica
@@ -2,14 +2,81 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <thread>
+#include "core/settings.h"
+#include "video_core/regs.h"
+#include "video_core/swrasterizer/binner.h"
 #include "video_core/swrasterizer/clipper.h"
+#include "video_core/swrasterizer/rasterizer.h"
 #include "video_core/swrasterizer/swrasterizer.h"
 
 namespace VideoCore {
 
+SWRasterizer::SWRasterizer() {
+    const unsigned num_threads = std::thread::hardware_concurrency();
+    if (Settings::values.use_multithreaded_sw_rasterizer && num_threads > 1) {
+        binner = std::make_unique<Pica::Rasterizer::TileBinner>(num_threads);
+    }
+}
+
+SWRasterizer::~SWRasterizer() = default;
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                const Pica::Shader::OutputVertex& v1,
                                const Pica::Shader::OutputVertex& v2) {
-    Pica::Clipper::ProcessTriangle(v0, v1, v2);
+    using Pica::Rasterizer::Vertex;
+    if (lighting_luts_dirty) {
+        Pica::Rasterizer::UpdateLightingLuts();
+        lighting_luts_dirty = false;
+    }
+
+    if (binner) {
+        Pica::Clipper::ProcessTriangle(
+            v0, v1, v2, [this](const Vertex& v0, const Vertex& v1, const Vertex& v2) {
+                binner->AddTriangle(v0, v1, v2);
+            });
+    } else {
+        Pica::Clipper::ProcessTriangle(v0, v1, v2,
+                                       [](const Vertex& v0, const Vertex& v1, const Vertex& v2) {
+                                           Pica::Rasterizer::ProcessTriangle(v0, v1, v2);
+                                       });
+    }
+}
+
+void SWRasterizer::DrawTriangles() {
+    if (binner)
+        binner->Flush();
+}
+
+void SWRasterizer::NotifyPicaRegisterChanged(u32 id) {
+    // Queued triangles are drawn with the current registers. The draw triggers are notified
+    // right after their triangles are queued, so each draw is rasterized with its own state.
+    if (binner)
+        binner->Flush();
+
+    if (id >= PICA_REG_INDEX_WORKAROUND(lighting.lut_data[0], 0x1c8) &&
+        id <= PICA_REG_INDEX_WORKAROUND(lighting.lut_data[7], 0x1cf)) {
+        lighting_luts_dirty = true;
+    }
+
+    // Texture memory isn't tracked, it may be written by the CPU or the GPU between any two
+    // draws. Decoded textures are thus only reused within one draw.
+    Pica::Rasterizer::InvalidateTextureCache();
+}
+
+void SWRasterizer::FlushAll() {
+    if (binner)
+        binner->Flush();
+}
+
+void SWRasterizer::FlushRegion(PAddr addr, u32 size) {
+    if (binner)
+        binner->Flush();
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    if (binner)
+        binner->Flush();
+    Pica::Rasterizer::InvalidateTextureCache();
 }
 }
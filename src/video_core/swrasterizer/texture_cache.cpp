@@ -0,0 +1,76 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "core/memory.h"
+#include "video_core/swrasterizer/texture_cache.h"
+
+namespace Pica {
+namespace Rasterizer {
+
+/// Number of textures kept around across invalidations, to reuse their memory in the next draws
+constexpr size_t MAX_CACHED_TEXTURES = 32;
+
+TextureCache::Texture::Texture(const Pica::Texture::TextureInfo& info)
+    : info(info), tiles_x((info.width + 7) / 8), num_tiles(tiles_x * ((info.height + 7) / 8)),
+      generation(0) {
+    tiles = std::make_unique<Tile[]>(num_tiles);
+    tile_states = std::make_unique<std::atomic<TileState>[]>(num_tiles);
+    for (size_t i = 0; i < num_tiles; ++i)
+        tile_states[i].store(TileState::Empty, std::memory_order_relaxed);
+}
+
+Math::Vec4<u8> TextureCache::Texture::DecodeTile(unsigned tile, unsigned x, unsigned y) {
+    const u8* source = Memory::GetPhysicalPointer(info.physical_address) +
+                       (tile / tiles_x) * info.stride +
+                       (tile % tiles_x) * Pica::Texture::CalculateTileSize(info.format);
+
+    TileState state = TileState::Empty;
+    if (!tile_states[tile].compare_exchange_strong(state, TileState::Decoding,
+                                                   std::memory_order_acquire)) {
+        if (state == TileState::Decoded)
+            return tiles[tile][y * 8 + x];
+        // Another thread is decoding the tile, rather than waiting for it decode the texel alone
+        return Pica::Texture::LookupTexelInTile(source, x, y, info, false);
+    }
+
+    Tile& decoded = tiles[tile];
+    Pica::Texture::DecodeTile(source, info, decoded.data());
+    tile_states[tile].store(TileState::Decoded, std::memory_order_release);
+    return decoded[y * 8 + x];
+}
+
+TextureCache::Texture& TextureCache::Get(const Pica::Texture::TextureInfo& info) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = std::find_if(textures.begin(), textures.end(), [&info](const auto& texture) {
+        const auto& cached = texture->info;
+        return cached.physical_address == info.physical_address && cached.width == info.width &&
+               cached.height == info.height && cached.stride == info.stride &&
+               cached.format == info.format;
+    });
+
+    if (it == textures.end()) {
+        textures.push_back(std::make_unique<Texture>(info));
+        it = textures.end() - 1;
+    }
+
+    Texture& texture = **it;
+    if (texture.generation != generation) {
+        for (size_t i = 0; i < texture.num_tiles; ++i)
+            texture.tile_states[i].store(Texture::TileState::Empty, std::memory_order_relaxed);
+        texture.generation = generation;
+    }
+    return texture;
+}
+
+void TextureCache::Invalidate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++generation;
+    if (textures.size() > MAX_CACHED_TEXTURES)
+        textures.clear();
+}
+
+} // namespace Rasterizer
+} // namespace Pica
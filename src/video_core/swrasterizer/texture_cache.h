@@ -0,0 +1,81 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/texture/texture_decode.h"
+
+namespace Pica {
+namespace Rasterizer {
+
+/**
+ * Decoded copies of the textures sampled by the software rasterizer. A texture is decoded one 8x8
+ * tile at a time, when a texel of the tile is first looked up, so that a draw sampling a small part
+ * of a large texture only decodes that part.
+ *
+ * Decoded texels are reused until Invalidate is called, which has to happen whenever texture
+ * memory may have been written.
+ */
+class TextureCache : NonCopyable {
+public:
+    class Texture : NonCopyable {
+    public:
+        explicit Texture(const Pica::Texture::TextureInfo& info);
+
+        /// Looks up the texel at the given coordinates, which must be inside the texture
+        Math::Vec4<u8> LookupTexel(unsigned x, unsigned y) {
+            const unsigned tile = (y / 8) * tiles_x + x / 8;
+            if (tile_states[tile].load(std::memory_order_acquire) != TileState::Decoded)
+                return DecodeTile(tile, x % 8, y % 8);
+            return tiles[tile][(y % 8) * 8 + x % 8];
+        }
+
+    private:
+        friend class TextureCache;
+
+        enum TileState : u8 {
+            Empty,
+            Decoding,
+            Decoded,
+        };
+
+        using Tile = std::array<Math::Vec4<u8>, 64>;
+
+        /// Decodes a tile, returning the texel at the given in-tile coordinates
+        Math::Vec4<u8> DecodeTile(unsigned tile, unsigned x, unsigned y);
+
+        Pica::Texture::TextureInfo info;
+        unsigned tiles_x;
+        std::unique_ptr<Tile[]> tiles;
+        std::unique_ptr<std::atomic<TileState>[]> tile_states;
+        size_t num_tiles;
+        /// Value of TextureCache::generation the decoded tiles are valid for
+        u64 generation;
+    };
+
+    /**
+     * Returns the decoded texture described by `info`. May be called from multiple threads, the
+     * texture stays valid until the next call to Invalidate.
+     */
+    Texture& Get(const Pica::Texture::TextureInfo& info);
+
+    /// Discards all decoded texels. Must not be called while textures are sampled.
+    void Invalidate();
+
+private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Texture>> textures;
+    u64 generation = 0;
+};
+
+} // namespace Rasterizer
+} // namespace Pica
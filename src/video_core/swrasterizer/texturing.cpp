@@ -6,6 +6,7 @@
 
 #include "common/assert.h"
 #include "common/common_types.h"
+#include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
@@ -236,5 +237,270 @@ u8 AlphaCombine(TevStageConfig::Operation op, const std::array<u8, 3>& input) {
     }
 };
 
+namespace {
+
+using ColorModifier = TevStageConfig::ColorModifier;
+using AlphaModifier = TevStageConfig::AlphaModifier;
+using Operation = TevStageConfig::Operation;
+using Source = TevStageConfig::Source;
+
+// Instantiating these on a constant configuration lets the compiler fold the switches in
+// GetColorModifier etc., leaving only the arithmetic of one case.
+
+template <ColorModifier factor>
+Math::Vec3<u8> ColorModifierFor(const Math::Vec4<u8>& values) {
+    return GetColorModifier(factor, values);
+}
+
+template <AlphaModifier factor>
+u8 AlphaModifierFor(const Math::Vec4<u8>& values) {
+    return GetAlphaModifier(factor, values);
+}
+
+template <Operation op>
+Math::Vec3<u8> ColorCombineFor(const Math::Vec3<u8> input[3]) {
+    return ColorCombine(op, input);
+}
+
+template <Operation op>
+u8 AlphaCombineFor(const std::array<u8, 3>& input) {
+    return AlphaCombine(op, input);
+}
+
+Math::Vec3<u8> ColorModifierUnknown(const Math::Vec4<u8>& values) {
+    return {0, 0, 0};
+}
+
+u8 AlphaModifierUnknown(const Math::Vec4<u8>& values) {
+    return 0;
+}
+
+Math::Vec3<u8> ColorCombineUnknown(const Math::Vec3<u8> input[3]) {
+    return {0, 0, 0};
+}
+
+u8 AlphaCombineUnknown(const std::array<u8, 3>& input) {
+    return 0;
+}
+
+auto LookupColorModifier(ColorModifier factor) -> Math::Vec3<u8> (*)(const Math::Vec4<u8>&) {
+    switch (factor) {
+#define CASE(name)                                                                                 \
+    case ColorModifier::name:                                                                      \
+        return &ColorModifierFor<ColorModifier::name>;
+        CASE(SourceColor)
+        CASE(OneMinusSourceColor)
+        CASE(SourceAlpha)
+        CASE(OneMinusSourceAlpha)
+        CASE(SourceRed)
+        CASE(OneMinusSourceRed)
+        CASE(SourceGreen)
+        CASE(OneMinusSourceGreen)
+        CASE(SourceBlue)
+        CASE(OneMinusSourceBlue)
+#undef CASE
+    default:
+        LOG_ERROR(HW_GPU, "Unknown color modifier %d", (int)factor);
+        UNIMPLEMENTED();
+        return &ColorModifierUnknown;
+    }
+}
+
+auto LookupAlphaModifier(AlphaModifier factor) -> u8 (*)(const Math::Vec4<u8>&) {
+    switch (factor) {
+#define CASE(name)                                                                                 \
+    case AlphaModifier::name:                                                                      \
+        return &AlphaModifierFor<AlphaModifier::name>;
+        CASE(SourceAlpha)
+        CASE(OneMinusSourceAlpha)
+        CASE(SourceRed)
+        CASE(OneMinusSourceRed)
+        CASE(SourceGreen)
+        CASE(OneMinusSourceGreen)
+        CASE(SourceBlue)
+        CASE(OneMinusSourceBlue)
+#undef CASE
+    default:
+        LOG_ERROR(HW_GPU, "Unknown alpha modifier %d", (int)factor);
+        UNIMPLEMENTED();
+        return &AlphaModifierUnknown;
+    }
+}
+
+auto LookupColorCombine(Operation op) -> Math::Vec3<u8> (*)(const Math::Vec3<u8>[3]) {
+    switch (op) {
+#define CASE(name)                                                                                 \
+    case Operation::name:                                                                          \
+        return &ColorCombineFor<Operation::name>;
+        CASE(Replace)
+        CASE(Modulate)
+        CASE(Add)
+        CASE(AddSigned)
+        CASE(Lerp)
+        CASE(Subtract)
+        CASE(Dot3_RGB)
+        CASE(Dot3_RGBA)
+        CASE(MultiplyThenAdd)
+        CASE(AddThenMultiply)
+#undef CASE
+    default:
+        LOG_ERROR(HW_GPU, "Unknown color combiner operation %d", (int)op);
+        UNIMPLEMENTED();
+        return &ColorCombineUnknown;
+    }
+}
+
+auto LookupAlphaCombine(Operation op) -> u8 (*)(const std::array<u8, 3>&) {
+    switch (op) {
+#define CASE(name)                                                                                 \
+    case Operation::name:                                                                          \
+        return &AlphaCombineFor<Operation::name>;
+        CASE(Replace)
+        CASE(Modulate)
+        CASE(Add)
+        CASE(AddSigned)
+        CASE(Lerp)
+        CASE(Subtract)
+        CASE(MultiplyThenAdd)
+        CASE(AddThenMultiply)
+#undef CASE
+    default:
+        LOG_ERROR(HW_GPU, "Unknown alpha combiner operation %d", (int)op);
+        UNIMPLEMENTED();
+        return &AlphaCombineUnknown;
+    }
+}
+
+TevPipeline::Input MapSource(Source source) {
+    switch (source) {
+    case Source::PrimaryColor:
+        return TevPipeline::PrimaryColor;
+    case Source::PrimaryFragmentColor:
+        return TevPipeline::PrimaryFragmentColor;
+    case Source::SecondaryFragmentColor:
+        return TevPipeline::SecondaryFragmentColor;
+    case Source::Texture0:
+        return TevPipeline::Texture0;
+    case Source::Texture1:
+        return TevPipeline::Texture1;
+    case Source::Texture2:
+        return TevPipeline::Texture2;
+    case Source::Texture3:
+        return TevPipeline::Texture3;
+    case Source::PreviousBuffer:
+        return TevPipeline::PreviousBuffer;
+    case Source::Constant:
+        return TevPipeline::Constant;
+    case Source::Previous:
+        return TevPipeline::Previous;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown color combiner source %d", (int)source);
+        UNIMPLEMENTED();
+        return TevPipeline::Unknown;
+    }
+}
+
+} // Anonymous namespace
+
+TevPipeline::TevPipeline(const TexturingRegs& regs) {
+    const auto tev_stages = regs.GetTevStages();
+    for (unsigned index = 0; index < tev_stages.size(); ++index) {
+        const auto& config = tev_stages[index];
+        Stage& stage = stages[index];
+
+        stage.passthrough =
+            config.color_op == Operation::Replace && config.alpha_op == Operation::Replace &&
+            config.color_source1 == Source::Previous && config.alpha_source1 == Source::Previous &&
+            config.color_modifier1 == ColorModifier::SourceColor &&
+            config.alpha_modifier1 == AlphaModifier::SourceAlpha &&
+            config.GetColorMultiplier() == 1 && config.GetAlphaMultiplier() == 1;
+
+        stage.color_sources = {{MapSource(config.color_source1), MapSource(config.color_source2),
+                                MapSource(config.color_source3)}};
+        stage.alpha_sources = {{MapSource(config.alpha_source1), MapSource(config.alpha_source2),
+                                MapSource(config.alpha_source3)}};
+        stage.color_modifiers = {{LookupColorModifier(config.color_modifier1),
+                                  LookupColorModifier(config.color_modifier2),
+                                  LookupColorModifier(config.color_modifier3)}};
+        stage.alpha_modifiers = {{LookupAlphaModifier(config.alpha_modifier1),
+                                  LookupAlphaModifier(config.alpha_modifier2),
+                                  LookupAlphaModifier(config.alpha_modifier3)}};
+        stage.color_combine = LookupColorCombine(config.color_op);
+        stage.alpha_combine = config.color_op == Operation::Dot3_RGBA
+                                  ? nullptr
+                                  : LookupAlphaCombine(config.alpha_op);
+        stage.color_multiplier = config.GetColorMultiplier();
+        stage.alpha_multiplier = config.GetAlphaMultiplier();
+        stage.constant = {static_cast<u8>(config.const_r), static_cast<u8>(config.const_g),
+                          static_cast<u8>(config.const_b), static_cast<u8>(config.const_a)};
+        stage.updates_buffer_color =
+            regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(index);
+        stage.updates_buffer_alpha =
+            regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(index);
+    }
+
+    initial_buffer = {
+        static_cast<u8>(regs.tev_combiner_buffer_color.r),
+        static_cast<u8>(regs.tev_combiner_buffer_color.g),
+        static_cast<u8>(regs.tev_combiner_buffer_color.b),
+        static_cast<u8>(regs.tev_combiner_buffer_color.a),
+    };
+}
+
+Math::Vec4<u8> TevPipeline::Combine(Inputs& inputs) const {
+    inputs[PreviousBuffer] = {0, 0, 0, 0};
+    inputs[Previous] = {0, 0, 0, 0};
+    inputs[Unknown] = {0, 0, 0, 0};
+    Math::Vec4<u8> next_buffer = initial_buffer;
+
+    for (const Stage& stage : stages) {
+        Math::Vec4<u8>& output = inputs[Previous];
+
+        if (!stage.passthrough) {
+            inputs[Constant] = stage.constant;
+
+            // NOTE: Not sure if the alpha combiner might use the color output of the previous
+            //       stage as input. Hence, the output is only written once both are combined.
+            const Math::Vec3<u8> color_result[3] = {
+                stage.color_modifiers[0](inputs[stage.color_sources[0]]),
+                stage.color_modifiers[1](inputs[stage.color_sources[1]]),
+                stage.color_modifiers[2](inputs[stage.color_sources[2]]),
+            };
+            const Math::Vec3<u8> color_output = stage.color_combine(color_result);
+
+            u8 alpha_output;
+            if (stage.alpha_combine == nullptr) {
+                alpha_output = color_output.x;
+            } else {
+                const std::array<u8, 3> alpha_result = {{
+                    stage.alpha_modifiers[0](inputs[stage.alpha_sources[0]]),
+                    stage.alpha_modifiers[1](inputs[stage.alpha_sources[1]]),
+                    stage.alpha_modifiers[2](inputs[stage.alpha_sources[2]]),
+                }};
+                alpha_output = stage.alpha_combine(alpha_result);
+            }
+
+            output[0] = std::min((unsigned)255, color_output.r() * stage.color_multiplier);
+            output[1] = std::min((unsigned)255, color_output.g() * stage.color_multiplier);
+            output[2] = std::min((unsigned)255, color_output.b() * stage.color_multiplier);
+            output[3] = std::min((unsigned)255, alpha_output * stage.alpha_multiplier);
+        }
+
+        inputs[PreviousBuffer] = next_buffer;
+
+        if (stage.updates_buffer_color) {
+            next_buffer.r() = output.r();
+            next_buffer.g() = output.g();
+            next_buffer.b() = output.b();
+        }
+
+        if (stage.updates_buffer_alpha) {
+            next_buffer.a() = output.a();
+        }
+    }
+
+    return inputs[Previous];
+}
+
 } // namespace Rasterizer
 } // namespace Pica
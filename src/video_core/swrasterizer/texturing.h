@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
@@ -24,5 +25,68 @@ Math::Vec3<u8> ColorCombine(TexturingRegs::TevStageConfig::Operation op,
 
 u8 AlphaCombine(TexturingRegs::TevStageConfig::Operation op, const std::array<u8, 3>& input);
 
+/**
+ * The texture environment configuration, translated into functions specialized on each stage's
+ * modifiers and operations. It is built once per triangle, so that combining a fragment doesn't
+ * need to decode the TEV registers again.
+ */
+class TevPipeline {
+public:
+    /// Per-fragment values the TEV stages can read from, indexing TevPipeline::Inputs
+    enum Input : u8 {
+        PrimaryColor,
+        PrimaryFragmentColor,
+        SecondaryFragmentColor,
+        Texture0,
+        Texture1,
+        Texture2,
+        Texture3,
+        PreviousBuffer,
+        Constant,
+        Previous,
+        /// Read by sources of unknown type, always zero
+        Unknown,
+        NumInputs,
+    };
+
+    using Inputs = std::array<Math::Vec4<u8>, NumInputs>;
+
+    explicit TevPipeline(const TexturingRegs& regs);
+
+    /**
+     * Runs all TEV stages on a fragment.
+     * @param inputs Fragment inputs. The entries from PrimaryColor up to Texture3 have to be
+     *               filled in, the others are used as scratch space.
+     * @return The output of the last stage
+     */
+    Math::Vec4<u8> Combine(Inputs& inputs) const;
+
+private:
+    using ColorModifierFunction = Math::Vec3<u8> (*)(const Math::Vec4<u8>& values);
+    using AlphaModifierFunction = u8 (*)(const Math::Vec4<u8>& values);
+    using ColorCombineFunction = Math::Vec3<u8> (*)(const Math::Vec3<u8> input[3]);
+    using AlphaCombineFunction = u8 (*)(const std::array<u8, 3>& input);
+
+    struct Stage {
+        /// True if the stage outputs the previous stage's output unchanged
+        bool passthrough;
+        std::array<Input, 3> color_sources;
+        std::array<Input, 3> alpha_sources;
+        std::array<ColorModifierFunction, 3> color_modifiers;
+        std::array<AlphaModifierFunction, 3> alpha_modifiers;
+        ColorCombineFunction color_combine;
+        /// nullptr for Dot3_RGBA, which writes the color result to the alpha component
+        AlphaCombineFunction alpha_combine;
+        unsigned color_multiplier;
+        unsigned alpha_multiplier;
+        Math::Vec4<u8> constant;
+        bool updates_buffer_color;
+        bool updates_buffer_alpha;
+    };
+
+    std::array<Stage, 6> stages;
+    Math::Vec4<u8> initial_buffer;
+};
+
 } // namespace Rasterizer
 } // namespace Pica
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <memory>
 #include "common/bit_field.h"
 #include "common/color.h"
 #include "common/common_types.h"
@@ -109,8 +110,73 @@ union ETC1Tile {
 
         return ret.Cast<u8>();
     }
+
+    /// Decodes all texels, computing the base color of each half of the subtile only once
+    void DecodeAll(std::array<Math::Vec3<u8>, 16>& dest) const {
+        std::array<Math::Vec3<int>, 2> base;
+        if (differential_mode) {
+            const Math::Vec3<int> base1 = {static_cast<int>(differential.r),
+                                           static_cast<int>(differential.g),
+                                           static_cast<int>(differential.b)};
+            const Math::Vec3<int> base2 = {base1.r() + static_cast<int>(differential.dr),
+                                           base1.g() + static_cast<int>(differential.dg),
+                                           base1.b() + static_cast<int>(differential.db)};
+            for (unsigned half = 0; half < 2; ++half) {
+                const Math::Vec3<int>& color = half ? base2 : base1;
+                base[half] = {Color::Convert5To8(color.r()), Color::Convert5To8(color.g()),
+                              Color::Convert5To8(color.b())};
+            }
+        } else {
+            base[0] = {Color::Convert4To8(static_cast<u8>(separate.r1)),
+                       Color::Convert4To8(static_cast<u8>(separate.g1)),
+                       Color::Convert4To8(static_cast<u8>(separate.b1))};
+            base[1] = {Color::Convert4To8(static_cast<u8>(separate.r2)),
+                       Color::Convert4To8(static_cast<u8>(separate.g2)),
+                       Color::Convert4To8(static_cast<u8>(separate.b2))};
+        }
+        const std::array<unsigned, 2> table_index = {
+            {static_cast<unsigned>(table_index_1.Value()),
+             static_cast<unsigned>(table_index_2.Value())}};
+
+        for (unsigned y = 0; y < 4; ++y) {
+            for (unsigned x = 0; x < 4; ++x) {
+                const unsigned texel = 4 * x + y;
+                const unsigned half = (flip ? y : x) >= 2 ? 1 : 0;
+
+                int modifier = etc1_modifier_table[table_index[half]][GetTableSubIndex(texel)];
+                if (GetNegationFlag(texel))
+                    modifier *= -1;
+
+                dest[y * 4 + x] = {
+                    static_cast<u8>(MathUtil::Clamp(base[half].r() + modifier, 0, 255)),
+                    static_cast<u8>(MathUtil::Clamp(base[half].g() + modifier, 0, 255)),
+                    static_cast<u8>(MathUtil::Clamp(base[half].b() + modifier, 0, 255)),
+                };
+            }
+        }
+    }
 };
 
+/// Recently decoded subtiles, direct-mapped by a hash of their data
+struct DecodedSubtileCache {
+    static constexpr size_t NUM_ENTRIES = 1024;
+
+    std::array<u64, NUM_ENTRIES> keys;
+    std::array<bool, NUM_ENTRIES> valid{};
+    std::array<std::array<Math::Vec3<u8>, 16>, NUM_ENTRIES> texels;
+
+    static size_t Index(u64 value) {
+        return static_cast<size_t>((value * 0x9E3779B97F4A7C15ull) >> 54);
+    }
+};
+
+/// Reverses the order of the four texels in each column of both planes of pixel indices
+u64 FlipIndexColumns(u64 indices) {
+    indices = ((indices & 0x55555555) << 1) | ((indices >> 1) & 0x55555555);
+    indices = ((indices & 0x33333333) << 2) | ((indices >> 2) & 0x33333333);
+    return indices;
+}
+
 } // anonymous namespace
 
 Math::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y) {
@@ -118,5 +184,76 @@ Math::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y) {
     return tile.GetRGB(x, y);
 }
 
+void DecodeETC1Subtile(u64 value, std::array<Math::Vec3<u8>, 16>& dest) {
+    thread_local std::unique_ptr<DecodedSubtileCache> cache;
+    if (!cache)
+        cache = std::make_unique<DecodedSubtileCache>();
+
+    const size_t index = DecodedSubtileCache::Index(value);
+    if (cache->valid[index] && cache->keys[index] == value) {
+        dest = cache->texels[index];
+        return;
+    }
+
+    ETC1Tile{value}.DecodeAll(dest);
+    cache->keys[index] = value;
+    cache->valid[index] = true;
+    cache->texels[index] = dest;
+}
+
+bool ConvertETC1SubtileToETC2(u64 value, bool flip_vertically, std::array<u8, 8>& dest) {
+    ETC1Tile tile{value};
+
+    // Flipping a block split into top and bottom halves swaps the halves
+    const bool swap_halves = flip_vertically && tile.flip;
+
+    if (tile.differential_mode) {
+        const int dr = static_cast<int>(tile.differential.dr);
+        const int dg = static_cast<int>(tile.differential.dg);
+        const int db = static_cast<int>(tile.differential.db);
+        const int r2 = static_cast<int>(tile.differential.r) + dr;
+        const int g2 = static_cast<int>(tile.differential.g) + dg;
+        const int b2 = static_cast<int>(tile.differential.b) + db;
+
+        // ETC2 gives blocks whose second base color overflows a different meaning
+        if (r2 < 0 || r2 > 31 || g2 < 0 || g2 > 31 || b2 < 0 || b2 > 31)
+            return false;
+
+        if (swap_halves) {
+            // The smallest delta has no positive counterpart
+            if (dr == -4 || dg == -4 || db == -4)
+                return false;
+            tile.differential.r.Assign(r2);
+            tile.differential.g.Assign(g2);
+            tile.differential.b.Assign(b2);
+            tile.differential.dr.Assign(-dr);
+            tile.differential.dg.Assign(-dg);
+            tile.differential.db.Assign(-db);
+        }
+    } else if (swap_halves) {
+        const u64 r1 = tile.separate.r1, g1 = tile.separate.g1, b1 = tile.separate.b1;
+        tile.separate.r1.Assign(tile.separate.r2);
+        tile.separate.g1.Assign(tile.separate.g2);
+        tile.separate.b1.Assign(tile.separate.b2);
+        tile.separate.r2.Assign(r1);
+        tile.separate.g2.Assign(g1);
+        tile.separate.b2.Assign(b1);
+    }
+
+    if (swap_halves) {
+        const u64 table_index_1 = tile.table_index_1;
+        tile.table_index_1.Assign(tile.table_index_2);
+        tile.table_index_2.Assign(table_index_1);
+    }
+
+    if (flip_vertically)
+        tile.raw = (tile.raw & ~0xFFFFFFFFull) | FlipIndexColumns(tile.raw & 0xFFFFFFFF);
+
+    // The standard format stores the same bit layout in big endian byte order
+    for (unsigned i = 0; i < 8; ++i)
+        dest[i] = static_cast<u8>(tile.raw >> (56 - 8 * i));
+    return true;
+}
+
 } // namespace Texture
 } // namespace Pica
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 
@@ -12,5 +13,19 @@ namespace Texture {
 
 Math::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y);
 
+/**
+ * Decodes all texels of a 4x4 ETC1 subtile, the texel at (x, y) being written to dest[y * 4 + x].
+ * Recently decoded subtiles are remembered per thread, so that repeated blocks, common in texture
+ * atlases, are only decoded once.
+ */
+void DecodeETC1Subtile(u64 value, std::array<Math::Vec3<u8>, 16>& dest);
+
+/**
+ * Converts an ETC1 subtile to a block of the standard ETC1 encoding, which ETC2 decoders accept
+ * as well, optionally flipping it upside down.
+ * @returns false if no such block decodes to the same colors as the subtile
+ */
+bool ConvertETC1SubtileToETC2(u64 value, bool flip_vertically, std::array<u8, 8>& dest);
+
 } // namespace Texture
 } // namespace Pica
@@ -2,17 +2,26 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/swap.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/texture/etc1.h"
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 using TextureFormat = Pica::TexturingRegs::TextureFormat;
 
 namespace Pica {
@@ -212,6 +221,303 @@ Math::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int
     }
 }
 
+namespace {
+
+/// Index of each texel of a tile in the row by row order DecodeTile writes, by Morton offset
+const std::array<u8, TILE_SIZE> morton_to_linear = [] {
+    std::array<u8, TILE_SIZE> table{};
+    for (unsigned y = 0; y < 8; ++y) {
+        for (unsigned x = 0; x < 8; ++x)
+            table[VideoCore::MortonInterleave(x, y)] = static_cast<u8>(y * 8 + x);
+    }
+    return table;
+}();
+
+/// Textures with at least this many texels are decoded across threads
+constexpr size_t PARALLEL_DECODE_TEXELS = 256 * 256;
+/// Same for ETC1 textures, which take several times longer to decode than uncompressed ones
+constexpr size_t PARALLEL_DECODE_ETC1_TEXELS = 128 * 128;
+
+template <TextureFormat format>
+Math::Vec4<u8> Decode16BitTexel(u16_le pixel, bool disable_alpha) {
+    Math::Vec4<u8> res;
+    switch (format) {
+    case TextureFormat::RGB5A1:
+        res = Color::DecodeRGB5A1(reinterpret_cast<const u8*>(&pixel));
+        break;
+    case TextureFormat::RGB565:
+        res = Color::DecodeRGB565(reinterpret_cast<const u8*>(&pixel));
+        break;
+    case TextureFormat::RGBA4:
+    default:
+        res = Color::DecodeRGBA4(reinterpret_cast<const u8*>(&pixel));
+        break;
+    }
+    if (disable_alpha)
+        res.a() = 255;
+    return res;
+}
+
+#ifdef ARCHITECTURE_x86_64
+/// Expands the low `bits` bits of each 16-bit lane to 8 bits by bit replication
+template <int bits>
+__m128i ExpandTo8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 8 - bits), _mm_srli_epi16(value, 2 * bits - 8));
+}
+
+/// Interleaves the 8-bit channel values held in the 16-bit lanes of r, g, b and a to 8 texels
+void StoreTexels(__m128i r, __m128i g, __m128i b, __m128i a, Math::Vec4<u8>* dest) {
+    const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+    const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi16(rg, ba));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4), _mm_unpackhi_epi16(rg, ba));
+}
+#endif
+
+/// Decodes the 16-bit texels of a tile to `dest`, in the order they are stored in
+template <TextureFormat format>
+void Decode16BitTile(const u8* source, Math::Vec4<u8>* dest, bool disable_alpha) {
+#ifdef ARCHITECTURE_x86_64
+    const __m128i mask4 = _mm_set1_epi16(0xF);
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    const __m128i mask6 = _mm_set1_epi16(0x3F);
+    const __m128i opaque = _mm_set1_epi16(0xFF);
+
+    for (unsigned i = 0; i < TILE_SIZE; i += 8) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        __m128i r, g, b, a;
+        switch (format) {
+        case TextureFormat::RGB5A1:
+            r = ExpandTo8<5>(_mm_srli_epi16(pixels, 11));
+            g = ExpandTo8<5>(_mm_and_si128(_mm_srli_epi16(pixels, 6), mask5));
+            b = ExpandTo8<5>(_mm_and_si128(_mm_srli_epi16(pixels, 1), mask5));
+            a = _mm_mullo_epi16(_mm_and_si128(pixels, _mm_set1_epi16(1)), opaque);
+            break;
+        case TextureFormat::RGB565:
+            r = ExpandTo8<5>(_mm_srli_epi16(pixels, 11));
+            g = ExpandTo8<6>(_mm_and_si128(_mm_srli_epi16(pixels, 5), mask6));
+            b = ExpandTo8<5>(_mm_and_si128(pixels, mask5));
+            a = opaque;
+            break;
+        case TextureFormat::RGBA4:
+        default:
+            r = ExpandTo8<4>(_mm_srli_epi16(pixels, 12));
+            g = ExpandTo8<4>(_mm_and_si128(_mm_srli_epi16(pixels, 8), mask4));
+            b = ExpandTo8<4>(_mm_and_si128(_mm_srli_epi16(pixels, 4), mask4));
+            a = ExpandTo8<4>(_mm_and_si128(pixels, mask4));
+            break;
+        }
+        StoreTexels(r, g, b, disable_alpha ? opaque : a, dest + i);
+    }
+#else
+    for (unsigned i = 0; i < TILE_SIZE; ++i) {
+        u16_le pixel;
+        std::memcpy(&pixel, source + i * 2, sizeof(pixel));
+        dest[i] = Decode16BitTexel<format>(pixel, disable_alpha);
+    }
+#endif
+}
+
+} // Anonymous namespace
+
+void DecodeTile(const u8* source, const TextureInfo& info, Math::Vec4<u8>* dest,
+                bool disable_alpha) {
+    // Texels in the order they are stored in
+    std::array<Math::Vec4<u8>, TILE_SIZE> texels;
+
+    switch (info.format) {
+    case TextureFormat::RGBA8:
+        for (unsigned i = 0; i < TILE_SIZE; ++i) {
+            const u8* texel = source + i * 4;
+            texels[i] = {texel[3], texel[2], texel[1], disable_alpha ? (u8)255 : texel[0]};
+        }
+        break;
+
+    case TextureFormat::RGB8:
+        for (unsigned i = 0; i < TILE_SIZE; ++i)
+            texels[i] = Color::DecodeRGB8(source + i * 3);
+        break;
+
+    case TextureFormat::RGB5A1:
+        Decode16BitTile<TextureFormat::RGB5A1>(source, texels.data(), disable_alpha);
+        break;
+
+    case TextureFormat::RGB565:
+        Decode16BitTile<TextureFormat::RGB565>(source, texels.data(), disable_alpha);
+        break;
+
+    case TextureFormat::RGBA4:
+        Decode16BitTile<TextureFormat::RGBA4>(source, texels.data(), disable_alpha);
+        break;
+
+    case TextureFormat::IA8:
+        for (unsigned i = 0; i < TILE_SIZE; ++i) {
+            const u8* texel = source + i * 2;
+            if (disable_alpha) {
+                texels[i] = {texel[1], texel[0], 0, 255};
+            } else {
+                texels[i] = {texel[1], texel[1], texel[1], texel[0]};
+            }
+        }
+        break;
+
+    case TextureFormat::RG8:
+        for (unsigned i = 0; i < TILE_SIZE; ++i)
+            texels[i] = Color::DecodeRG8(source + i * 2);
+        break;
+
+    case TextureFormat::I8:
+        for (unsigned i = 0; i < TILE_SIZE; ++i)
+            texels[i] = {source[i], source[i], source[i], 255};
+        break;
+
+    case TextureFormat::A8:
+        for (unsigned i = 0; i < TILE_SIZE; ++i) {
+            if (disable_alpha) {
+                texels[i] = {source[i], source[i], source[i], 255};
+            } else {
+                texels[i] = {0, 0, 0, source[i]};
+            }
+        }
+        break;
+
+    case TextureFormat::IA4:
+        for (unsigned i = 0; i < TILE_SIZE; ++i) {
+            const u8 intensity = Color::Convert4To8(source[i] >> 4);
+            const u8 alpha = Color::Convert4To8(source[i] & 0xF);
+            if (disable_alpha) {
+                texels[i] = {intensity, alpha, 0, 255};
+            } else {
+                texels[i] = {intensity, intensity, intensity, alpha};
+            }
+        }
+        break;
+
+    case TextureFormat::I4:
+    case TextureFormat::A4:
+        for (unsigned i = 0; i < TILE_SIZE; ++i) {
+            const u8 nibble = (i % 2) ? (source[i / 2] >> 4) : (source[i / 2] & 0xF);
+            const u8 value = Color::Convert4To8(nibble);
+            if (info.format == TextureFormat::I4 || disable_alpha) {
+                texels[i] = {value, value, value, 255};
+            } else {
+                texels[i] = {0, 0, 0, value};
+            }
+        }
+        break;
+
+    case TextureFormat::ETC1:
+    case TextureFormat::ETC1A4: {
+        // ETC1 further subdivides each 8x8 tile into four 4x4 subtiles, stored row by row
+        const bool has_alpha = (info.format == TextureFormat::ETC1A4);
+        const size_t subtile_size = has_alpha ? 16 : 8;
+
+        std::array<Math::Vec3<u8>, 16> colors;
+        for (unsigned subtile = 0; subtile < ETC1_SUBTILES; ++subtile) {
+            const u8* subtile_ptr = source + subtile * subtile_size;
+
+            u64_le packed_alpha = 0;
+            if (has_alpha) {
+                memcpy(&packed_alpha, subtile_ptr, sizeof(u64));
+                subtile_ptr += sizeof(u64);
+            }
+
+            u64_le subtile_data;
+            memcpy(&subtile_data, subtile_ptr, sizeof(u64));
+            DecodeETC1Subtile(subtile_data, colors);
+
+            Math::Vec4<u8>* subtile_dest = dest + (subtile / 2) * 4 * 8 + (subtile % 2) * 4;
+            for (unsigned y = 0; y < 4; ++y) {
+                for (unsigned x = 0; x < 4; ++x) {
+                    u8 alpha = 255;
+                    if (has_alpha && !disable_alpha)
+                        alpha = Color::Convert4To8((packed_alpha >> (4 * (x * 4 + y))) & 0xF);
+                    subtile_dest[y * 8 + x] = Math::MakeVec(colors[y * 4 + x], alpha);
+                }
+            }
+        }
+        return;
+    }
+
+    default:
+        for (unsigned y = 0; y < 8; ++y) {
+            for (unsigned x = 0; x < 8; ++x)
+                dest[y * 8 + x] = LookupTexelInTile(source, x, y, info, disable_alpha);
+        }
+        return;
+    }
+
+    for (unsigned i = 0; i < TILE_SIZE; ++i)
+        dest[morton_to_linear[i]] = texels[i];
+}
+
+void DecodeTexture(const u8* source, const TextureInfo& info, Math::Vec4<u8>* dest,
+                   ptrdiff_t dest_stride, bool disable_alpha) {
+    const unsigned tiles_x = (info.width + 7) / 8;
+    const unsigned tiles_y = (info.height + 7) / 8;
+    const size_t tile_size = CalculateTileSize(info.format);
+
+    auto DecodeTileRows = [&](size_t begin, size_t end) {
+        std::array<Math::Vec4<u8>, TILE_SIZE> tile;
+        for (size_t tile_y = begin; tile_y < end; ++tile_y) {
+            const u8* line = source + tile_y * info.stride;
+            const unsigned rows = std::min(8u, info.height - static_cast<unsigned>(tile_y) * 8);
+            for (unsigned tile_x = 0; tile_x < tiles_x; ++tile_x) {
+                DecodeTile(line + tile_x * tile_size, info, tile.data(), disable_alpha);
+
+                const unsigned columns = std::min(8u, info.width - tile_x * 8);
+                Math::Vec4<u8>* tile_dest =
+                    dest + static_cast<ptrdiff_t>(tile_y) * 8 * dest_stride + tile_x * 8;
+                for (unsigned y = 0; y < rows; ++y) {
+                    std::memcpy(tile_dest + y * dest_stride, &tile[y * 8],
+                                columns * sizeof(Math::Vec4<u8>));
+                }
+            }
+        }
+    };
+
+    const bool is_etc1 =
+        info.format == TextureFormat::ETC1 || info.format == TextureFormat::ETC1A4;
+    const size_t parallel_texels = is_etc1 ? PARALLEL_DECODE_ETC1_TEXELS : PARALLEL_DECODE_TEXELS;
+    if (static_cast<size_t>(info.width) * info.height >= parallel_texels) {
+        Common::ThreadPool& pool = Common::GetSharedThreadPool();
+        if (pool.NumThreads() > 1) {
+            pool.ParallelFor(tiles_y, 1, DecodeTileRows);
+            return;
+        }
+    }
+
+    DecodeTileRows(0, tiles_y);
+}
+
+bool ConvertETC1TextureToETC2(const u8* source, const TextureInfo& info, u8* dest) {
+    ASSERT(info.format == TextureFormat::ETC1);
+    ASSERT(info.width % 8 == 0 && info.height % 8 == 0);
+
+    const unsigned blocks_x = info.width / 4;
+    const unsigned blocks_y = info.height / 4;
+    const size_t tile_size = CalculateTileSize(info.format);
+
+    std::array<u8, 8> block;
+    for (unsigned tile_y = 0; tile_y < info.height / 8; ++tile_y) {
+        const u8* line = source + tile_y * info.stride;
+        for (unsigned tile_x = 0; tile_x < info.width / 8; ++tile_x) {
+            for (unsigned subtile = 0; subtile < ETC1_SUBTILES; ++subtile) {
+                u64_le value;
+                std::memcpy(&value, line + tile_x * tile_size + subtile * 8, sizeof(u64));
+                if (!ConvertETC1SubtileToETC2(value, true, block))
+                    return false;
+
+                const unsigned block_x = tile_x * 2 + subtile % 2;
+                const unsigned block_y = blocks_y - 1 - (tile_y * 2 + subtile / 2);
+                std::memcpy(dest + (block_y * blocks_x + block_x) * block.size(), block.data(),
+                            block.size());
+            }
+        }
+    }
+    return true;
+}
+
 TextureInfo TextureInfo::FromPicaRegister(const TexturingRegs::TextureConfig& config,
                                           const TexturingRegs::TextureFormat& format) {
     TextureInfo info;
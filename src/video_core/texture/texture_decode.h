@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
@@ -56,5 +57,43 @@ Math::Vec4<u8> LookupTexture(const u8* source, unsigned int x, unsigned int y,
 Math::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int y,
                                  const TextureInfo& info, bool disable_alpha);
 
+/**
+ * Decodes all texels of a single 8x8 texture tile, giving the same results as LookupTexelInTile.
+ *
+ * @param source Pointer to the beginning of the tile.
+ * @param info TextureInfo describing the texture format.
+ * @param dest Destination of the 64 texels, the texel at in-tile coordinates (x, y) being written
+ *             to dest[y * 8 + x].
+ * @param disable_alpha See LookupTexelInTile.
+ */
+void DecodeTile(const u8* source, const TextureInfo& info, Math::Vec4<u8>* dest,
+                bool disable_alpha = false);
+
+/**
+ * Decodes a whole texture, giving the same results as calling LookupTexture for every texel.
+ * Large textures are decoded across multiple threads.
+ *
+ * @param source Source pointer to read data from
+ * @param info TextureInfo object describing the texture setup
+ * @param dest Destination of the texels, the texel at (x, y) being written to
+ *             dest[y * dest_stride + x]
+ * @param dest_stride Distance between the rows of dest in texels. May be negative to write the
+ *                    texture upside down.
+ * @param disable_alpha See LookupTexture.
+ */
+void DecodeTexture(const u8* source, const TextureInfo& info, Math::Vec4<u8>* dest,
+                   ptrdiff_t dest_stride, bool disable_alpha = false);
+
+/**
+ * Re-encodes an ETC1 texture as standard ETC1 blocks that ETC2 decoders accept, upside down as
+ * OpenGL expects texture data. The texture dimensions have to be multiples of 8.
+ *
+ * @param source Source pointer to read data from
+ * @param info TextureInfo object describing the texture setup
+ * @param dest Destination of the width * height / 2 bytes of compressed data
+ * @returns false if the texture can't be represented that way, see ConvertETC1SubtileToETC2
+ */
+bool ConvertETC1TextureToETC2(const u8* source, const TextureInfo& info, u8* dest);
+
 } // namespace Texture
 } // namespace Pica
@@ -1,4 +1,6 @@
+#include <cstring>
 #include <memory>
+#include <unordered_map>
 #include <boost/range/algorithm/fill.hpp>
 #include "common/alignment.h"
 #include "common/assert.h"
@@ -7,6 +9,7 @@
 #include "common/logging/log.h"
 #include "common/vector_math.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
@@ -14,8 +17,114 @@
 #include "video_core/shader/shader.h"
 #include "video_core/vertex_loader.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#include "video_core/vertex_loader_jit_x64.h"
+#endif // ARCHITECTURE_x86_64
+
 namespace Pica {
 
+#ifdef ARCHITECTURE_x86_64
+/// Compiled loaders, keyed by the hash of the attribute layout they were compiled for
+static std::unordered_map<u64, std::unique_ptr<VertexLoaderJit>> jit_loader_cache;
+#endif // ARCHITECTURE_x86_64
+
+/**
+ * Converts an attribute of `N` elements of type `T`. Components the array doesn't provide are set
+ * to (0, 0, 0, 1); these are *not* taken from the default attribute settings even if they're
+ * enabled for this attribute.
+ */
+template <typename T, unsigned N>
+static void LoadAttribute(const u8* source, Math::Vec4<float24>& attribute) {
+    T elements[N];
+    std::memcpy(elements, source, sizeof(elements));
+
+    float values[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    for (unsigned comp = 0; comp < N; ++comp) {
+        values[comp] = static_cast<float>(elements[comp]);
+    }
+
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        attribute[comp] = float24::FromFloat32(values[comp]);
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+// float24 is stored as a host float, so full four-component attributes convert in a few SSE2
+// instructions
+
+static void StoreAttribute(__m128 values, Math::Vec4<float24>& attribute) {
+    static_assert(sizeof(Math::Vec4<float24>) == sizeof(__m128), "Unexpected attribute layout");
+    _mm_storeu_ps(reinterpret_cast<float*>(&attribute), values);
+}
+
+template <>
+void LoadAttribute<s8, 4>(const u8* source, Math::Vec4<float24>& attribute) {
+    s32 packed;
+    std::memcpy(&packed, source, sizeof(packed));
+    __m128i values = _mm_cvtsi32_si128(packed);
+    // Move each byte into the top of its 32-bit lane, then sign extend it downwards
+    values = _mm_unpacklo_epi8(values, values);
+    values = _mm_unpacklo_epi16(values, values);
+    StoreAttribute(_mm_cvtepi32_ps(_mm_srai_epi32(values, 24)), attribute);
+}
+
+template <>
+void LoadAttribute<u8, 4>(const u8* source, Math::Vec4<float24>& attribute) {
+    s32 packed;
+    std::memcpy(&packed, source, sizeof(packed));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i values = _mm_cvtsi32_si128(packed);
+    values = _mm_unpacklo_epi8(values, zero);
+    values = _mm_unpacklo_epi16(values, zero);
+    StoreAttribute(_mm_cvtepi32_ps(values), attribute);
+}
+
+template <>
+void LoadAttribute<s16, 4>(const u8* source, Math::Vec4<float24>& attribute) {
+    __m128i values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source));
+    values = _mm_unpacklo_epi16(values, values);
+    StoreAttribute(_mm_cvtepi32_ps(_mm_srai_epi32(values, 16)), attribute);
+}
+
+template <>
+void LoadAttribute<float, 4>(const u8* source, Math::Vec4<float24>& attribute) {
+    StoreAttribute(_mm_loadu_ps(reinterpret_cast<const float*>(source)), attribute);
+}
+#endif // ARCHITECTURE_x86_64
+
+template <typename T>
+static VertexLoader::AttributeLoadFunction GetAttributeLoadFunction(u32 elements) {
+    switch (elements) {
+    case 1:
+        return LoadAttribute<T, 1>;
+    case 2:
+        return LoadAttribute<T, 2>;
+    case 3:
+        return LoadAttribute<T, 3>;
+    case 4:
+        return LoadAttribute<T, 4>;
+    }
+    UNREACHABLE();
+    return nullptr;
+}
+
+static VertexLoader::AttributeLoadFunction GetAttributeLoadFunction(
+    PipelineRegs::VertexAttributeFormat format, u32 elements) {
+    switch (format) {
+    case PipelineRegs::VertexAttributeFormat::BYTE:
+        return GetAttributeLoadFunction<s8>(elements);
+    case PipelineRegs::VertexAttributeFormat::UBYTE:
+        return GetAttributeLoadFunction<u8>(elements);
+    case PipelineRegs::VertexAttributeFormat::SHORT:
+        return GetAttributeLoadFunction<s16>(elements);
+    case PipelineRegs::VertexAttributeFormat::FLOAT:
+        return GetAttributeLoadFunction<float>(elements);
+    }
+    UNREACHABLE();
+    return nullptr;
+}
+
 void VertexLoader::Setup(const PipelineRegs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -54,6 +163,9 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
                     attribute_config.GetFormat(attribute_index);
                 vertex_attribute_elements[attribute_index] =
                     attribute_config.GetNumElements(attribute_index);
+                vertex_attribute_loaders[attribute_index] = GetAttributeLoadFunction(
+                    vertex_attribute_formats[attribute_index],
+                    vertex_attribute_elements[attribute_index]);
                 offset += attribute_config.GetStride(attribute_index);
             } else if (attribute_index < 16) {
                 // Attribute ids 12, 13, 14 and 15 signify 4, 8, 12 and 16-byte paddings,
@@ -68,6 +180,21 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
     }
 
     is_setup = true;
+
+#ifdef ARCHITECTURE_x86_64
+    if (Settings::values.use_vertex_loader_jit) {
+        const u64 cache_key = VertexLoaderJit::GetLayoutHash(*this);
+        auto iter = jit_loader_cache.find(cache_key);
+        if (iter != jit_loader_cache.end()) {
+            jit_loader = iter->second.get();
+        } else {
+            auto compiled_loader = std::make_unique<VertexLoaderJit>();
+            compiled_loader->Compile(*this);
+            jit_loader = compiled_loader.get();
+            jit_loader_cache.emplace_hint(iter, cache_key, std::move(compiled_loader));
+        }
+    }
+#endif // ARCHITECTURE_x86_64
 }
 
 void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
@@ -93,48 +220,8 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                                    : 1));
             }
 
-            switch (vertex_attribute_formats[i]) {
-            case PipelineRegs::VertexAttributeFormat::BYTE: {
-                const s8* srcdata =
-                    reinterpret_cast<const s8*>(Memory::GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::UBYTE: {
-                const u8* srcdata =
-                    reinterpret_cast<const u8*>(Memory::GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::SHORT: {
-                const s16* srcdata =
-                    reinterpret_cast<const s16*>(Memory::GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::FLOAT: {
-                const float* srcdata =
-                    reinterpret_cast<const float*>(Memory::GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            }
-
-            // Default attribute values set if array elements have < 4 components. This
-            // is *not* carried over from the default attribute settings even if they're
-            // enabled for this attribute.
-            for (unsigned int comp = vertex_attribute_elements[i]; comp < 4; ++comp) {
-                input.attr[i][comp] =
-                    comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
-            }
+            vertex_attribute_loaders[i](Memory::GetPhysicalPointer(source_addr),
+                                        input.attr[i]);
 
             LOG_TRACE(HW_GPU, "Loaded %d components of attribute %x for vertex %x (index %x) from "
                               "0x%08x + 0x%08x + 0x%04x: %f %f %f %f",
@@ -157,4 +244,39 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
     }
 }
 
+void VertexLoader::LoadVertices(u32 base_address, const u32* vertices, size_t count,
+                                Shader::AttributeBuffer* inputs) {
+    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
+
+#ifdef ARCHITECTURE_x86_64
+    if (jit_loader) {
+        // Attribute arrays don't cross memory regions, so each can be addressed from one pointer
+        std::array<const u8*, 16> attribute_bases{};
+        for (int i = 0; i < num_total_attributes; ++i) {
+            if (vertex_attribute_elements[i] != 0) {
+                attribute_bases[i] =
+                    Memory::GetPhysicalPointer(base_address + vertex_attribute_sources[i]);
+            }
+        }
+        jit_loader->LoadVertices(attribute_bases.data(), vertices, count, inputs);
+        return;
+    }
+#endif // ARCHITECTURE_x86_64
+
+    for (int i = 0; i < num_total_attributes; ++i) {
+        if (vertex_attribute_elements[i] != 0) {
+            const AttributeLoadFunction load = vertex_attribute_loaders[i];
+            const u32 source = base_address + vertex_attribute_sources[i];
+            const u32 stride = vertex_attribute_strides[i];
+            for (size_t v = 0; v < count; ++v) {
+                load(Memory::GetPhysicalPointer(source + stride * vertices[v]), inputs[v].attr[i]);
+            }
+        } else if (vertex_attribute_is_default[i]) {
+            for (size_t v = 0; v < count; ++v) {
+                inputs[v].attr[i] = g_state.input_default_attributes.attr[i];
+            }
+        }
+    }
+}
+
 } // namespace Pica
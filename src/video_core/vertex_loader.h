@@ -1,7 +1,10 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/pica_types.h"
 #include "video_core/regs_pipeline.h"
 
 namespace Pica {
@@ -14,8 +17,13 @@ namespace Shader {
 struct AttributeBuffer;
 }
 
+class VertexLoaderJit;
+
 class VertexLoader {
 public:
+    /// Converts one attribute array element, filling in the components the array doesn't provide
+    using AttributeLoadFunction = void (*)(const u8* source, Math::Vec4<float24>& attribute);
+
     VertexLoader() = default;
     explicit VertexLoader(const PipelineRegs& regs) {
         Setup(regs);
@@ -25,11 +33,28 @@ public:
     void LoadVertex(u32 base_address, int index, int vertex, Shader::AttributeBuffer& input,
                     DebugUtils::MemoryAccessTracker& memory_accesses);
 
+    /**
+     * Loads `count` vertices at once, going through the vertices attribute by attribute so that
+     * each attribute's conversion routine is only looked up once. Uses the compiled loader of the
+     * attribute layout if there is one. Memory accesses aren't tracked.
+     * @param base_address Base address of the vertex arrays
+     * @param vertices Vertex numbers of the vertices to load
+     * @param count Number of vertices to load
+     * @param inputs Array of `count` attribute buffers receiving the vertices
+     */
+    void LoadVertices(u32 base_address, const u32* vertices, size_t count,
+                      Shader::AttributeBuffer* inputs);
+
     int GetNumTotalAttributes() const {
         return num_total_attributes;
     }
 
 private:
+    friend class VertexLoaderJit;
+
+    /// Compiled loader of the attribute layout, or nullptr if vertices are loaded without one
+    const VertexLoaderJit* jit_loader = nullptr;
+    std::array<AttributeLoadFunction, 16> vertex_attribute_loaders{};
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
@@ -0,0 +1,217 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <xmmintrin.h>
+#include "common/assert.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/x64/xbyak_abi.h"
+#include "video_core/pica_state.h"
+#include "video_core/regs_pipeline.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/vertex_loader_jit_x64.h"
+
+using namespace Common::X64;
+using namespace Xbyak::util;
+using Xbyak::Label;
+using Xbyak::Reg32;
+using Xbyak::Reg64;
+using Xbyak::Xmm;
+
+namespace Pica {
+
+// The compiled loader only uses registers that are caller-saved in both the Windows and the
+// System V ABI, so it doesn't need to save any
+
+/// Pointer to the array of attribute base pointers
+static const Reg64 BASES = ABI_PARAM1.cvt64();
+/// Pointer to the vertex number of the current vertex
+static const Reg64 VERTICES = ABI_PARAM2.cvt64();
+/// Number of vertices left to load
+static const Reg64 COUNT = ABI_PARAM3.cvt64();
+/// Pointer to the attribute buffer of the current vertex
+static const Reg64 INPUTS = ABI_PARAM4.cvt64();
+/// Vertex number of the current vertex
+static const Reg32 VERTEX = eax;
+/// Address of the attribute element being loaded
+static const Reg64 ADDRESS = r10;
+/// Scratch register
+static const Reg64 SCRATCH = r11;
+/// Converted attribute
+static const Xmm ATTRIBUTE = xmm0;
+/// SIMD scratch register
+static const Xmm SCRATCH2 = xmm1;
+/// Constant vector of [0.f, 0.f, 0.f, 1.f], used to fill in the w component of short attributes
+static const Xmm W_ONE = xmm3;
+
+u64 VertexLoaderJit::GetLayoutHash(const VertexLoader& loader) {
+    // Attribute array offsets are applied by the caller, the rest of the layout is compiled in
+    struct {
+        u32 num_total_attributes;
+        std::array<u32, 16> formats;
+        std::array<u32, 16> elements;
+        std::array<u32, 16> strides;
+        std::array<u32, 16> is_default;
+    } layout;
+    std::memset(&layout, 0, sizeof(layout));
+
+    layout.num_total_attributes = loader.num_total_attributes;
+    for (int i = 0; i < loader.num_total_attributes; ++i) {
+        layout.elements[i] = loader.vertex_attribute_elements[i];
+        layout.is_default[i] = loader.vertex_attribute_is_default[i];
+        // The format of attributes not loaded from an array is left uninitialized
+        if (layout.elements[i] != 0) {
+            layout.formats[i] = static_cast<u32>(loader.vertex_attribute_formats[i]);
+            layout.strides[i] = loader.vertex_attribute_strides[i];
+        }
+    }
+    return Common::ComputeHash64(&layout, sizeof(layout));
+}
+
+void VertexLoaderJit::Compile_LoadAttribute(const VertexLoader& loader, int attribute) {
+    const auto format = loader.vertex_attribute_formats[attribute];
+    const u32 elements = loader.vertex_attribute_elements[attribute];
+    const u32 stride = loader.vertex_attribute_strides[attribute];
+
+    mov(ADDRESS, qword[BASES + attribute * sizeof(const u8*)]);
+    if (stride != 0) {
+        mov(SCRATCH.cvt32(), VERTEX);
+        imul(SCRATCH, SCRATCH, stride);
+        add(ADDRESS, SCRATCH);
+    }
+
+    // Load the elements into the low lanes of ATTRIBUTE, zeroing the lanes without one
+    switch (format) {
+    case PipelineRegs::VertexAttributeFormat::BYTE:
+    case PipelineRegs::VertexAttributeFormat::UBYTE:
+        switch (elements) {
+        case 1:
+            movzx(SCRATCH.cvt32(), byte[ADDRESS]);
+            movd(ATTRIBUTE, SCRATCH.cvt32());
+            break;
+        case 2:
+            movzx(SCRATCH.cvt32(), word[ADDRESS]);
+            movd(ATTRIBUTE, SCRATCH.cvt32());
+            break;
+        case 3:
+            movzx(SCRATCH.cvt32(), byte[ADDRESS + 2]);
+            shl(SCRATCH.cvt32(), 16);
+            or_(SCRATCH.cvt16(), word[ADDRESS]);
+            movd(ATTRIBUTE, SCRATCH.cvt32());
+            break;
+        case 4:
+            movd(ATTRIBUTE, dword[ADDRESS]);
+            break;
+        }
+
+        if (format == PipelineRegs::VertexAttributeFormat::BYTE) {
+            // Move each byte into the top of its 32-bit lane, then sign extend it downwards
+            punpcklbw(ATTRIBUTE, ATTRIBUTE);
+            punpcklwd(ATTRIBUTE, ATTRIBUTE);
+            psrad(ATTRIBUTE, 24);
+        } else {
+            pxor(SCRATCH2, SCRATCH2);
+            punpcklbw(ATTRIBUTE, SCRATCH2);
+            punpcklwd(ATTRIBUTE, SCRATCH2);
+        }
+        cvtdq2ps(ATTRIBUTE, ATTRIBUTE);
+        break;
+
+    case PipelineRegs::VertexAttributeFormat::SHORT:
+        switch (elements) {
+        case 1:
+            movzx(SCRATCH.cvt32(), word[ADDRESS]);
+            movd(ATTRIBUTE, SCRATCH.cvt32());
+            break;
+        case 2:
+            movd(ATTRIBUTE, dword[ADDRESS]);
+            break;
+        case 3:
+            movd(ATTRIBUTE, dword[ADDRESS]);
+            pinsrw(ATTRIBUTE, word[ADDRESS + 4], 2);
+            break;
+        case 4:
+            movq(ATTRIBUTE, qword[ADDRESS]);
+            break;
+        }
+
+        punpcklwd(ATTRIBUTE, ATTRIBUTE);
+        psrad(ATTRIBUTE, 16);
+        cvtdq2ps(ATTRIBUTE, ATTRIBUTE);
+        break;
+
+    case PipelineRegs::VertexAttributeFormat::FLOAT:
+        switch (elements) {
+        case 1:
+            movss(ATTRIBUTE, dword[ADDRESS]);
+            break;
+        case 2:
+            movsd(ATTRIBUTE, qword[ADDRESS]);
+            break;
+        case 3:
+            movsd(ATTRIBUTE, qword[ADDRESS]);
+            movss(SCRATCH2, dword[ADDRESS + 8]);
+            movlhps(ATTRIBUTE, SCRATCH2);
+            break;
+        case 4:
+            movups(ATTRIBUTE, xword[ADDRESS]);
+            break;
+        }
+        break;
+    }
+
+    // Attributes with less than four elements have w set to 1. The lane is zero at this point, so
+    // OR-ing in the bits of 1.0 sets it without touching the other lanes.
+    if (elements < 4) {
+        orps(ATTRIBUTE, W_ONE);
+    }
+
+    movaps(xword[INPUTS + attribute * sizeof(Math::Vec4<float24>)], ATTRIBUTE);
+}
+
+void VertexLoaderJit::Compile(const VertexLoader& loader) {
+    program = (CompiledLoader*)getCurr();
+
+    static const __m128 w_one = {0.f, 0.f, 0.f, 1.f};
+    mov(ADDRESS, reinterpret_cast<size_t>(&w_one));
+    movaps(W_ONE, xword[ADDRESS]);
+
+    Label end, loop;
+    test(COUNT, COUNT);
+    jz(end);
+
+    L(loop);
+    mov(VERTEX, dword[VERTICES]);
+
+    for (int i = 0; i < loader.num_total_attributes; ++i) {
+        if (loader.vertex_attribute_elements[i] != 0) {
+            Compile_LoadAttribute(loader, i);
+        } else if (loader.vertex_attribute_is_default[i]) {
+            mov(ADDRESS, reinterpret_cast<size_t>(&g_state.input_default_attributes.attr[i]));
+            movaps(ATTRIBUTE, xword[ADDRESS]);
+            movaps(xword[INPUTS + i * sizeof(Math::Vec4<float24>)], ATTRIBUTE);
+        }
+    }
+
+    add(VERTICES, sizeof(u32));
+    add(INPUTS, sizeof(Shader::AttributeBuffer));
+    dec(COUNT);
+    jnz(loop);
+
+    L(end);
+    ret();
+
+    ready();
+
+    ASSERT_MSG(getSize() <= MAX_VERTEX_LOADER_SIZE,
+               "Compiled a vertex loader that exceeds the allocated size!");
+    LOG_DEBUG(HW_GPU, "Compiled vertex loader size=%lu", getSize());
+}
+
+VertexLoaderJit::VertexLoaderJit() : Xbyak::CodeGenerator(MAX_VERTEX_LOADER_SIZE) {}
+
+} // namespace Pica
@@ -0,0 +1,55 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <xbyak.h>
+#include "common/common_types.h"
+
+namespace Pica {
+
+namespace Shader {
+struct AttributeBuffer;
+}
+
+class VertexLoader;
+
+/// Memory allocated for each compiled vertex loader
+constexpr size_t MAX_VERTEX_LOADER_SIZE = 4096;
+
+/**
+ * This class compiles the attribute layout of a vertex loader into x86_64 code, which fetches and
+ * converts the attributes of each vertex in a straight line of loads, conversions and stores.
+ */
+class VertexLoaderJit : public Xbyak::CodeGenerator {
+public:
+    VertexLoaderJit();
+
+    /**
+     * Loads `count` vertices.
+     * @param attribute_bases Host pointers to the first element of each attribute array
+     * @param vertices Vertex numbers of the vertices to load
+     * @param count Number of vertices to load
+     * @param inputs Array of `count` attribute buffers receiving the vertices
+     */
+    void LoadVertices(const u8* const* attribute_bases, const u32* vertices, size_t count,
+                      Shader::AttributeBuffer* inputs) const {
+        program(attribute_bases, vertices, count, inputs);
+    }
+
+    void Compile(const VertexLoader& loader);
+
+    /// Returns a key identifying the attribute layouts that compile to the same code
+    static u64 GetLayoutHash(const VertexLoader& loader);
+
+private:
+    void Compile_LoadAttribute(const VertexLoader& loader, int attribute);
+
+    using CompiledLoader = void(const u8* const* attribute_bases, const u32* vertices,
+                                size_t count, Shader::AttributeBuffer* inputs);
+    CompiledLoader* program = nullptr;
+};
+
+} // namespace Pica
@@ -4,6 +4,8 @@
 
 #include <memory>
 #include "common/logging/log.h"
+#include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
@@ -19,14 +21,23 @@ std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
+std::atomic<bool> g_hw_shader_enabled;
 std::atomic<bool> g_vsync_enabled;
 std::atomic<bool> g_toggle_framelimit_enabled;
+std::atomic<u32> g_pending_shader_compiles;
 
 /// Initialize the video core
 bool Init(EmuWindow* emu_window) {
     Pica::Init();
 
     g_emu_window = emu_window;
+
+    if (Settings::values.use_gpu_thread) {
+        // Created before the renderer, so that the OpenGL rasterizer is created on it if it gets a
+        // context. Without one, the OpenGL rasterizer stays on the emulation thread.
+        g_gpu_thread = std::make_unique<GPUThread>(emu_window->CreateSharedContext());
+    }
+
     g_renderer = std::make_unique<RendererOpenGL>();
     g_renderer->SetWindow(g_emu_window);
     if (g_renderer->Init()) {
@@ -40,6 +51,11 @@ bool Init(EmuWindow* emu_window) {
 
 /// Shutdown the video core
 void Shutdown() {
+    // Queued GPU work still uses the Pica state and the renderer, and the rasterizer may use the GPU
+    // thread's context
+    g_renderer->DestroyRasterizer();
+    g_gpu_thread.reset();
+
     Pica::Shutdown();
 
     g_renderer.reset();
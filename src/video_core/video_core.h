@@ -22,7 +22,10 @@ extern EmuWindow* g_emu_window;                  ///< Emu window
 // qt ui)
 extern std::atomic<bool> g_hw_renderer_enabled;
 extern std::atomic<bool> g_shader_jit_enabled;
+extern std::atomic<bool> g_hw_shader_enabled;
 extern std::atomic<bool> g_toggle_framelimit_enabled;
+/// Number of shader programs the renderer is building in the background
+extern std::atomic<u32> g_pending_shader_compiles;
 
 /// Start the video core
 void Start();
@@ -2,9 +2,23 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <cpr/cpr.h>
+#include <cryptopp/gzip.h>
 #include <stdlib.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/string_util.h"
 #include "web_service/web_backend.h"
 
 namespace WebService {
@@ -13,6 +27,17 @@ static constexpr char API_VERSION[]{"1"};
 static constexpr char ENV_VAR_USERNAME[]{"CITRA_WEB_SERVICES_USERNAME"};
 static constexpr char ENV_VAR_TOKEN[]{"CITRA_WEB_SERVICES_TOKEN"};
 
+/// Longest time a single POST may take before it counts as failed
+static constexpr std::chrono::milliseconds REQUEST_TIMEOUT{10000};
+/// Number of times a POST is attempted before its data is spooled to disk
+static constexpr int MAX_ATTEMPTS = 3;
+/// Wait before the first retry, doubled for each further one
+static constexpr std::chrono::seconds FIRST_RETRY_DELAY{2};
+/// Longest time Shutdown waits for the request in flight, which is spooled beforehand
+static constexpr std::chrono::milliseconds SHUTDOWN_TIMEOUT{1000};
+/// Maximum number of submissions kept on disk, the oldest ones are dropped beyond that
+static constexpr size_t MAX_SPOOLED_SUBMISSIONS = 16;
+
 static std::string GetEnvironmentVariable(const char* name) {
     const char* value{getenv(name)};
     if (value) {
@@ -31,6 +56,252 @@ const std::string& GetToken() {
     return token;
 }
 
+namespace {
+
+struct Submission {
+    std::string url;
+    std::string data;
+};
+
+/**
+ * Posts submissions on a background thread, so that callers never wait for the network. Failed
+ * posts are retried with a growing delay, and submissions that still fail, or are left when the
+ * queue is stopped, are kept in a small gzip-compressed spool on disk and sent again on the next
+ * run.
+ */
+class SubmissionQueue : public std::enable_shared_from_this<SubmissionQueue> {
+public:
+    /// Starts the worker, which keeps the queue alive for as long as it runs
+    void Start() {
+        worker = std::thread([self = shared_from_this()] { self->WorkerLoop(); });
+    }
+
+    /**
+     * Spools the pending submissions, including the one in flight, and stops the worker. Waits at
+     * most SHUTDOWN_TIMEOUT for the request in flight, after which the worker is left to finish
+     * it in the background.
+     */
+    void Stop() {
+        {
+            // Stopping and spooling at once, so that the worker can't drop the submission it
+            // has in flight in between
+            std::lock_guard<std::mutex> spool_lock(spool_mutex);
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+            if (in_flight != nullptr)
+                in_flight_spool_path = Spool(*in_flight);
+            for (const Submission& submission : queue)
+                Spool(submission);
+            queue.clear();
+        }
+        cv.notify_all();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (cv.wait_for(lock, SHUTDOWN_TIMEOUT, [this] { return worker_exited; })) {
+            lock.unlock();
+            worker.join();
+        } else {
+            lock.unlock();
+            LOG_WARNING(WebService, "Not waiting for the POST in flight, it was spooled");
+            worker.detach();
+        }
+    }
+
+    void Push(Submission submission) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(submission));
+        }
+        cv.notify_all();
+    }
+
+private:
+    void WorkerLoop() {
+        LoadSpool();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv.wait(lock, [this] { return stop || !queue.empty(); });
+            if (stop)
+                break;
+            Submission submission = std::move(queue.front());
+            queue.pop_front();
+
+            auto retry_delay = std::chrono::duration_cast<std::chrono::milliseconds>(
+                FIRST_RETRY_DELAY);
+            for (int attempt = 1;; ++attempt) {
+                in_flight = &submission;
+                lock.unlock();
+                const bool posted = Post(submission);
+                lock.lock();
+                in_flight = nullptr;
+                if (stop) {
+                    // Stop spooled the submission while it was in flight
+                    if (posted && !in_flight_spool_path.empty())
+                        FileUtil::Delete(in_flight_spool_path);
+                    break;
+                }
+                if (posted)
+                    break;
+                const bool out_of_attempts = attempt == MAX_ATTEMPTS;
+                if (out_of_attempts || cv.wait_for(lock, retry_delay, [this] { return stop; })) {
+                    // Out of attempts, or stopping: keep it for the next run
+                    lock.unlock();
+                    {
+                        std::lock_guard<std::mutex> spool_lock(spool_mutex);
+                        Spool(submission);
+                    }
+                    lock.lock();
+                    break;
+                }
+                retry_delay *= 2;
+            }
+        }
+        worker_exited = true;
+        cv.notify_all();
+    }
+
+    static bool Post(const Submission& submission) {
+        const cpr::Response response =
+            cpr::Post(cpr::Url{submission.url}, cpr::Body{submission.data},
+                      cpr::Header{{"Content-Type", "application/json"},
+                                  {"x-username", GetUsername()},
+                                  {"x-token", GetToken()},
+                                  {"api-version", API_VERSION}},
+                      cpr::Timeout{REQUEST_TIMEOUT});
+        if (response.status_code >= 200 && response.status_code < 300)
+            return true;
+
+        LOG_WARNING(WebService, "POST to %s failed with status %d: %s", submission.url.c_str(),
+                    static_cast<int>(response.status_code), response.error.message.c_str());
+        return false;
+    }
+
+    static std::string GetSpoolDirectory() {
+        return FileUtil::GetUserPath(D_CACHE_IDX) + "telemetry" DIR_SEP;
+    }
+
+    /// Returns the names of the spooled submissions, oldest first
+    static std::vector<std::string> GetSpooledFiles() {
+        std::vector<std::string> files;
+        FileUtil::ForeachDirectoryEntry(
+            nullptr, GetSpoolDirectory(),
+            [&files](unsigned*, const std::string& directory, const std::string& name) {
+                if (!FileUtil::IsDirectory(directory + DIR_SEP + name))
+                    files.push_back(name);
+                return true;
+            });
+        // The names start with a fixed width timestamp
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    /**
+     * Writes a submission to the spool, dropping the oldest ones if it is full. Must be called
+     * with spool_mutex held.
+     * @returns Path of the spooled submission, empty if it couldn't be written
+     */
+    std::string Spool(const Submission& submission) {
+        const std::string directory = GetSpoolDirectory();
+        if (!FileUtil::CreateFullPath(directory))
+            return {};
+
+        std::vector<std::string> files = GetSpooledFiles();
+        for (size_t i = 0; i + MAX_SPOOLED_SUBMISSIONS <= files.size(); ++i)
+            FileUtil::Delete(directory + files[i]);
+
+        std::string compressed;
+        try {
+            CryptoPP::StringSource(submission.url + '\n' + submission.data, true,
+                                   new CryptoPP::Gzip(new CryptoPP::StringSink(compressed)));
+        } catch (const CryptoPP::Exception& e) {
+            LOG_ERROR(WebService, "Could not compress a submission: %s", e.what());
+            return {};
+        }
+
+        const auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch())
+                                   .count();
+        const std::string path =
+            directory + Common::StringFromFormat("%016llx-%u.json.gz",
+                                                 static_cast<unsigned long long>(timestamp),
+                                                 spool_counter++);
+        if (FileUtil::WriteStringToFile(false, compressed, path.c_str()) != compressed.size())
+            return {};
+        return path;
+    }
+
+    /// Queues the spooled submissions of previous runs and removes them from the spool
+    void LoadSpool() {
+        std::lock_guard<std::mutex> spool_lock(spool_mutex);
+        const std::string directory = GetSpoolDirectory();
+        for (const std::string& name : GetSpooledFiles()) {
+            const std::string path = directory + name;
+            std::string compressed;
+            FileUtil::ReadFileToString(false, path.c_str(), compressed);
+
+            std::string contents;
+            try {
+                CryptoPP::StringSource(compressed, true,
+                                       new CryptoPP::Gunzip(new CryptoPP::StringSink(contents)));
+            } catch (const CryptoPP::Exception& e) {
+                LOG_ERROR(WebService, "Dropping spooled submission %s: %s", name.c_str(),
+                          e.what());
+                FileUtil::Delete(path);
+                continue;
+            }
+
+            const size_t separator = contents.find('\n');
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                // Once stopped, whatever is left stays in the spool for the next run
+                if (stop)
+                    return;
+                if (separator != std::string::npos) {
+                    queue.push_back(
+                        {contents.substr(0, separator), contents.substr(separator + 1)});
+                }
+            }
+            FileUtil::Delete(path);
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Submission> queue;           ///< Guarded by mutex
+    bool stop = false;                      ///< Guarded by mutex
+    bool worker_exited = false;             ///< Guarded by mutex
+    const Submission* in_flight = nullptr;  ///< Guarded by mutex, owned by the worker
+    std::string in_flight_spool_path;       ///< Guarded by mutex
+    std::mutex spool_mutex;                 ///< Serializes access to the spool directory
+    unsigned spool_counter = 0;             ///< Guarded by spool_mutex
+    std::thread worker;
+};
+
+std::mutex submission_queue_mutex;
+std::shared_ptr<SubmissionQueue> submission_queue; ///< Guarded by submission_queue_mutex
+
+} // Anonymous namespace
+
+void Init() {
+    std::lock_guard<std::mutex> lock(submission_queue_mutex);
+    if (submission_queue != nullptr)
+        return;
+    submission_queue = std::make_shared<SubmissionQueue>();
+    submission_queue->Start();
+}
+
+void Shutdown() {
+    std::shared_ptr<SubmissionQueue> queue;
+    {
+        std::lock_guard<std::mutex> lock(submission_queue_mutex);
+        queue = std::move(submission_queue);
+        submission_queue = nullptr;
+    }
+    if (queue != nullptr)
+        queue->Stop();
+}
+
 void PostJson(const std::string& url, const std::string& data) {
     if (url.empty()) {
         LOG_ERROR(WebService, "URL is invalid");
@@ -43,10 +314,12 @@ void PostJson(const std::string& url, const std::string& data) {
         return;
     }
 
-    cpr::PostAsync(cpr::Url{url}, cpr::Body{data}, cpr::Header{{"Content-Type", "application/json"},
-                                                               {"x-username", GetUsername()},
-                                                               {"x-token", GetToken()},
-                                                               {"api-version", API_VERSION}});
+    std::lock_guard<std::mutex> lock(submission_queue_mutex);
+    if (submission_queue == nullptr) {
+        LOG_ERROR(WebService, "Web service isn't running, dropping the POST to %s", url.c_str());
+        return;
+    }
+    submission_queue->Push({url, data});
 }
 
 } // namespace WebService
@@ -21,8 +21,20 @@ const std::string& GetUsername();
  */
 const std::string& GetToken();
 
+/// Starts the background thread that sends the posted data, and resends data kept from earlier
+/// runs.
+void Init();
+
+/**
+ * Stops the background thread. Data that hasn't been sent yet, including the post in flight, is
+ * kept on disk for the next run, and the post in flight is only waited for briefly.
+ */
+void Shutdown();
+
 /**
- * Posts JSON to services.citra-emu.org.
+ * Posts JSON to services.citra-emu.org. Returns right away: the data is sent by a background
+ * thread, which retries failed posts and keeps the data on disk for the next run if they still
+ * fail. Data posted while the web service isn't initialized is dropped.
  * @param url URL of the services.citra-emu.org endpoint to post data to.
  * @param data String of JSON data to use for the body of the POST request.
  */